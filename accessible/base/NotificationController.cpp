@@ -397,12 +397,26 @@ NotificationController::WillRefresh(mozilla::TimeStamp aTime)
   // events causes script to run.
   mObservingState = eRefreshProcessing;
 
+  // Mutation and queued events fired below are sent to the parent process
+  // together, if event batching is enabled.
+  if (DocAccessibleChild* ipcDoc = mDocument->IPCDoc()) {
+    ipcDoc->BeginEventBatch();
+  }
+
   RefPtr<DocAccessible> deathGrip(mDocument);
   mEventTree.Process(deathGrip);
   deathGrip = nullptr;
 
   ProcessEventQueue();
 
+  // The document may have been shut down while firing events, in which case
+  // Shutdown() has already sent anything that was queued.
+  if (mDocument) {
+    if (DocAccessibleChild* ipcDoc = mDocument->IPCDoc()) {
+      ipcDoc->EndEventBatch();
+    }
+  }
+
   if (IPCAccessibilityActive()) {
     size_t newDocCount = newChildDocs.Length();
     for (size_t i = 0; i < newDocCount; i++) {
@@ -838,53 +838,57 @@ Accessible::HandleAccEvent(AccEvent* aEvent)
       uint64_t id = aEvent->GetAccessible()->IsDoc() ? 0 :
         reinterpret_cast<uintptr_t>(aEvent->GetAccessible());
 
-      switch(aEvent->GetEventType()) {
-        case nsIAccessibleEvent::EVENT_SHOW:
-          ipcDoc->ShowEvent(downcast_accEvent(aEvent));
-          break;
+      // Batched events are sent to the parent with the rest of this
+      // refresh's events.
+      if (!ipcDoc->MaybeBatchEvent(aEvent, id)) {
+        switch(aEvent->GetEventType()) {
+          case nsIAccessibleEvent::EVENT_SHOW:
+            ipcDoc->ShowEvent(downcast_accEvent(aEvent));
+            break;
 
-        case nsIAccessibleEvent::EVENT_HIDE:
-          ipcDoc->SendHideEvent(id, aEvent->IsFromUserInput());
-          break;
+          case nsIAccessibleEvent::EVENT_HIDE:
+            ipcDoc->SendHideEvent(id, aEvent->IsFromUserInput());
+            break;
 
-        case nsIAccessibleEvent::EVENT_REORDER:
-          // reorder events on the application acc aren't necessary to tell the parent
-          // about new top level documents.
-          if (!aEvent->GetAccessible()->IsApplication())
+          case nsIAccessibleEvent::EVENT_REORDER:
+            // reorder events on the application acc aren't necessary to tell the parent
+            // about new top level documents.
+            if (!aEvent->GetAccessible()->IsApplication())
+              ipcDoc->SendEvent(id, aEvent->GetEventType());
+            break;
+          case nsIAccessibleEvent::EVENT_STATE_CHANGE: {
+            AccStateChangeEvent* event = downcast_accEvent(aEvent);
+            ipcDoc->SendStateChangeEvent(id, event->GetState(),
+                                         event->IsStateEnabled());
+            break;
+          }
+          case nsIAccessibleEvent::EVENT_TEXT_CARET_MOVED: {
+            AccCaretMoveEvent* event = downcast_accEvent(aEvent);
+            ipcDoc->SendCaretMoveEvent(id, event->GetCaretOffset());
+            break;
+          }
+          case nsIAccessibleEvent::EVENT_TEXT_INSERTED:
+          case nsIAccessibleEvent::EVENT_TEXT_REMOVED: {
+            AccTextChangeEvent* event = downcast_accEvent(aEvent);
+            ipcDoc->SendTextChangeEvent(id, event->ModifiedText(),
+                                        event->GetStartOffset(),
+                                        event->GetLength(),
+                                        event->IsTextInserted(),
+                                        event->IsFromUserInput());
+            break;
+          }
+          case nsIAccessibleEvent::EVENT_SELECTION:
+          case nsIAccessibleEvent::EVENT_SELECTION_ADD:
+          case nsIAccessibleEvent::EVENT_SELECTION_REMOVE: {
+            AccSelChangeEvent* selEvent = downcast_accEvent(aEvent);
+            uint64_t widgetID = selEvent->Widget()->IsDoc() ? 0 :
+              reinterpret_cast<uintptr_t>(selEvent->Widget());
+            ipcDoc->SendSelectionEvent(id, widgetID, aEvent->GetEventType());
+            break;
+          }
+          default:
             ipcDoc->SendEvent(id, aEvent->GetEventType());
-          break;
-        case nsIAccessibleEvent::EVENT_STATE_CHANGE: {
-          AccStateChangeEvent* event = downcast_accEvent(aEvent);
-          ipcDoc->SendStateChangeEvent(id, event->GetState(),
-                                       event->IsStateEnabled());
-          break;
-        }
-        case nsIAccessibleEvent::EVENT_TEXT_CARET_MOVED: {
-          AccCaretMoveEvent* event = downcast_accEvent(aEvent);
-          ipcDoc->SendCaretMoveEvent(id, event->GetCaretOffset());
-          break;
-        }
-        case nsIAccessibleEvent::EVENT_TEXT_INSERTED:
-        case nsIAccessibleEvent::EVENT_TEXT_REMOVED: {
-          AccTextChangeEvent* event = downcast_accEvent(aEvent);
-          ipcDoc->SendTextChangeEvent(id, event->ModifiedText(),
-                                      event->GetStartOffset(),
-                                      event->GetLength(),
-                                      event->IsTextInserted(),
-                                      event->IsFromUserInput());
-          break;
-        }
-        case nsIAccessibleEvent::EVENT_SELECTION:
-        case nsIAccessibleEvent::EVENT_SELECTION_ADD:
-        case nsIAccessibleEvent::EVENT_SELECTION_REMOVE: {
-          AccSelChangeEvent* selEvent = downcast_accEvent(aEvent);
-          uint64_t widgetID = selEvent->Widget()->IsDoc() ? 0 :
-            reinterpret_cast<uintptr_t>(selEvent->Widget());
-          ipcDoc->SendSelectionEvent(id, widgetID, aEvent->GetEventType());
-          break;
         }
-        default:
-          ipcDoc->SendEvent(id, aEvent->GetEventType());
       }
     }
   }
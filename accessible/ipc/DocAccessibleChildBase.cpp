@@ -8,6 +8,8 @@
 #include "mozilla/a11y/ProxyAccessible.h"
 
 #include "Accessible-inl.h"
+#include "AccEvent.h"
+#include "mozilla/Preferences.h"
 
 namespace mozilla {
 namespace a11y {
@@ -105,15 +107,21 @@ DocAccessibleChildBase::SetMsaaIds(Accessible* aRoot,
 }
 #endif // defined(XP_WIN)
 
+/* static */ void
+DocAccessibleChildBase::SerializeShowEvent(AccShowEvent* aShowEvent,
+                                           ShowEventData& aData)
+{
+  Accessible* parent = aShowEvent->Parent();
+  aData.ID() = parent->IsDoc() ? 0 : reinterpret_cast<uint64_t>(parent->UniqueID());
+  aData.Idx() = aShowEvent->InsertionIndex();
+  SerializeTree(aShowEvent->GetAccessible(), aData.NewTree());
+}
+
 void
 DocAccessibleChildBase::ShowEvent(AccShowEvent* aShowEvent)
 {
-  Accessible* parent = aShowEvent->Parent();
-  uint64_t parentID = parent->IsDoc() ? 0 : reinterpret_cast<uint64_t>(parent->UniqueID());
-  uint32_t idxInParent = aShowEvent->InsertionIndex();
-  nsTArray<AccessibleData> shownTree;
-  ShowEventData data(parentID, idxInParent, shownTree);
-  SerializeTree(aShowEvent->GetAccessible(), data.NewTree());
+  ShowEventData data;
+  SerializeShowEvent(aShowEvent, data);
 #if defined(XP_WIN)
   nsTArray<MsaaMapping> newMsaaIds;
   SendShowEventInfo(data, &newMsaaIds);
@@ -132,6 +140,111 @@ DocAccessibleChildBase::ShowEvent(AccShowEvent* aShowEvent)
 #endif // defined(XP_WIN)
 }
 
+void
+DocAccessibleChildBase::BeginEventBatch()
+{
+#if !defined(XP_WIN)
+  MOZ_ASSERT(!mBatchingEvents);
+  mBatchingEvents = Preferences::GetBool("accessibility.ipc.batch_events");
+#endif
+}
+
+void
+DocAccessibleChildBase::EndEventBatch()
+{
+  if (!mBatchingEvents) {
+    return;
+  }
+
+  mBatchingEvents = false;
+#if !defined(XP_WIN)
+  if (!mBatchedEvents.IsEmpty()) {
+    nsTArray<BatchedEventData> events;
+    events.SwapElements(mBatchedEvents);
+    SendEvents(events);
+  }
+#endif
+}
+
+bool
+DocAccessibleChildBase::MaybeBatchEvent(AccEvent* aEvent, uint64_t aID)
+{
+#if defined(XP_WIN)
+  return false;
+#else
+  if (!mBatchingEvents) {
+    return false;
+  }
+
+  // This mirrors the individual messages sent by Accessible::HandleAccEvent.
+  switch (aEvent->GetEventType()) {
+    case nsIAccessibleEvent::EVENT_SHOW: {
+      AccShowEvent* event = downcast_accEvent(aEvent);
+      BatchedShowEvent batched;
+      SerializeShowEvent(event, batched.Data());
+      batched.FromUser() = event->IsFromUserInput();
+      mBatchedEvents.AppendElement(Move(batched));
+      break;
+    }
+
+    case nsIAccessibleEvent::EVENT_HIDE:
+      mBatchedEvents.AppendElement(
+        BatchedHideEvent(aID, aEvent->IsFromUserInput()));
+      break;
+
+    case nsIAccessibleEvent::EVENT_REORDER:
+      if (!aEvent->GetAccessible()->IsApplication()) {
+        mBatchedEvents.AppendElement(
+          BatchedGenericEvent(aID, aEvent->GetEventType()));
+      }
+      break;
+
+    case nsIAccessibleEvent::EVENT_STATE_CHANGE: {
+      AccStateChangeEvent* event = downcast_accEvent(aEvent);
+      mBatchedEvents.AppendElement(
+        BatchedStateChangeEvent(aID, event->GetState(),
+                                event->IsStateEnabled()));
+      break;
+    }
+
+    case nsIAccessibleEvent::EVENT_TEXT_CARET_MOVED: {
+      AccCaretMoveEvent* event = downcast_accEvent(aEvent);
+      mBatchedEvents.AppendElement(
+        BatchedCaretMoveEvent(aID, event->GetCaretOffset()));
+      break;
+    }
+
+    case nsIAccessibleEvent::EVENT_TEXT_INSERTED:
+    case nsIAccessibleEvent::EVENT_TEXT_REMOVED: {
+      AccTextChangeEvent* event = downcast_accEvent(aEvent);
+      mBatchedEvents.AppendElement(
+        BatchedTextChangeEvent(aID, event->ModifiedText(),
+                               event->GetStartOffset(),
+                               event->GetLength(), event->IsTextInserted(),
+                               event->IsFromUserInput()));
+      break;
+    }
+
+    case nsIAccessibleEvent::EVENT_SELECTION:
+    case nsIAccessibleEvent::EVENT_SELECTION_ADD:
+    case nsIAccessibleEvent::EVENT_SELECTION_REMOVE: {
+      AccSelChangeEvent* event = downcast_accEvent(aEvent);
+      uint64_t widgetID = event->Widget()->IsDoc() ? 0 :
+        reinterpret_cast<uintptr_t>(event->Widget());
+      mBatchedEvents.AppendElement(
+        BatchedSelectionEvent(aID, widgetID, aEvent->GetEventType()));
+      break;
+    }
+
+    default:
+      mBatchedEvents.AppendElement(
+        BatchedGenericEvent(aID, aEvent->GetEventType()));
+  }
+
+  return true;
+#endif // defined(XP_WIN)
+}
+
 } // namespace a11y
 } // namespace mozilla
 
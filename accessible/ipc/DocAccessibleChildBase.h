@@ -15,6 +15,7 @@ namespace mozilla {
 namespace a11y {
 
 class Accessible;
+class AccEvent;
 class AccShowEvent;
 
 class DocAccessibleChildBase : public PDocAccessibleChild
@@ -22,6 +23,7 @@ class DocAccessibleChildBase : public PDocAccessibleChild
 public:
   explicit DocAccessibleChildBase(DocAccessible* aDoc)
     : mDoc(aDoc)
+    , mBatchingEvents(false)
   {
     MOZ_COUNT_CTOR(DocAccessibleChildBase);
   }
@@ -40,6 +42,8 @@ public:
 
   void Shutdown()
   {
+    // The parent needs any queued events before it tears the document down.
+    EndEventBatch();
     mDoc->SetIPCDoc(nullptr);
     mDoc = nullptr;
     SendShutdown();
@@ -47,6 +51,22 @@ public:
 
   void ShowEvent(AccShowEvent* aShowEvent);
 
+  /*
+   * While a batch is open, events are queued by MaybeBatchEvent instead of
+   * being sent one message each, and EndEventBatch sends them to the parent
+   * in a single message. Batching only happens when the
+   * accessibility.ipc.batch_events pref is set, and never on Windows, where
+   * show events need a synchronous reply.
+   */
+  void BeginEventBatch();
+  void EndEventBatch();
+
+  /*
+   * Queue the given event if a batch is open. Returns false if the caller
+   * should send it right away.
+   */
+  bool MaybeBatchEvent(AccEvent* aEvent, uint64_t aID);
+
   virtual void ActorDestroy(ActorDestroyReason) override
   {
     if (!mDoc) {
@@ -60,12 +80,18 @@ public:
 protected:
   static uint32_t InterfacesFor(Accessible* aAcc);
   static void SerializeTree(Accessible* aRoot, nsTArray<AccessibleData>& aTree);
+  static void SerializeShowEvent(AccShowEvent* aShowEvent,
+                                 ShowEventData& aData);
 #if defined(XP_WIN)
   static void SetMsaaIds(Accessible* aRoot, uint32_t& aMsaaIdIndex,
                          const nsTArray<MsaaMapping>& aNewMsaaIds);
 #endif
 
   DocAccessible*  mDoc;
+  bool mBatchingEvents;
+#if !defined(XP_WIN)
+  nsTArray<BatchedEventData> mBatchedEvents;
+#endif
 };
 
 } // namespace a11y
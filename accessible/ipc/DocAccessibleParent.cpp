@@ -371,6 +371,63 @@ DocAccessibleParent::RecvSelectionEvent(const uint64_t& aID,
   return true;
 }
 
+#if !defined(XP_WIN)
+bool
+DocAccessibleParent::RecvEvents(nsTArray<BatchedEventData>&& aEvents)
+{
+  for (const BatchedEventData& data : aEvents) {
+    bool ok = true;
+    switch (data.type()) {
+      case BatchedEventData::TBatchedGenericEvent: {
+        const BatchedGenericEvent& ev = data.get_BatchedGenericEvent();
+        ok = RecvEvent(ev.ID(), ev.Type());
+        break;
+      }
+      case BatchedEventData::TBatchedShowEvent: {
+        const BatchedShowEvent& ev = data.get_BatchedShowEvent();
+        ok = RecvShowEvent(ev.Data(), ev.FromUser());
+        break;
+      }
+      case BatchedEventData::TBatchedHideEvent: {
+        const BatchedHideEvent& ev = data.get_BatchedHideEvent();
+        ok = RecvHideEvent(ev.RootID(), ev.FromUser());
+        break;
+      }
+      case BatchedEventData::TBatchedStateChangeEvent: {
+        const BatchedStateChangeEvent& ev = data.get_BatchedStateChangeEvent();
+        ok = RecvStateChangeEvent(ev.ID(), ev.State(), ev.Enabled());
+        break;
+      }
+      case BatchedEventData::TBatchedCaretMoveEvent: {
+        const BatchedCaretMoveEvent& ev = data.get_BatchedCaretMoveEvent();
+        ok = RecvCaretMoveEvent(ev.ID(), ev.Offset());
+        break;
+      }
+      case BatchedEventData::TBatchedTextChangeEvent: {
+        const BatchedTextChangeEvent& ev = data.get_BatchedTextChangeEvent();
+        ok = RecvTextChangeEvent(ev.ID(), ev.Str(), ev.Start(), ev.Len(),
+                                 ev.IsInsert(), ev.FromUser());
+        break;
+      }
+      case BatchedEventData::TBatchedSelectionEvent: {
+        const BatchedSelectionEvent& ev = data.get_BatchedSelectionEvent();
+        ok = RecvSelectionEvent(ev.ID(), ev.WidgetID(), ev.Type());
+        break;
+      }
+      default:
+        NS_ERROR("child sent unknown batched event");
+        return false;
+    }
+
+    if (!ok) {
+      return false;
+    }
+  }
+
+  return true;
+}
+#endif // !defined(XP_WIN)
+
 bool
 DocAccessibleParent::RecvRoleChangedEvent(const uint32_t& aRole)
 {
@@ -77,6 +77,14 @@ public:
 
   virtual bool RecvRoleChangedEvent(const uint32_t& aRole) override final;
 
+#if !defined(XP_WIN)
+  /*
+   * Handle a batch of events queued by the child during a refresh tick, in
+   * the order they were fired.
+   */
+  virtual bool RecvEvents(nsTArray<BatchedEventData>&& aEvents) override;
+#endif // !defined(XP_WIN)
+
   virtual bool RecvBindChildDoc(PDocAccessibleParent* aChildDoc, const uint64_t& aID) override;
   void Unbind()
   {
@@ -708,6 +708,8 @@ pref("gonk.systemMemoryPressureRecoveryPollMS", 5000);
 pref("dom.ipc.processPrelaunch.enabled", true);
 // Wait this long before pre-launching a new subprocess.
 pref("dom.ipc.processPrelaunch.delayMs", 5000);
+// Number of pre-launched subprocesses to keep around.
+pref("dom.ipc.processPrelaunch.poolSize", 1);
 
 pref("dom.ipc.reuse_parent_app", false);
 
@@ -78,6 +78,7 @@
 #include "nsITimedChannel.h"
 #include "nsIPrivacyTransitionObserver.h"
 #include "nsIReflowObserver.h"
+#include "nsIRequestContext.h"
 #include "nsIScrollObserver.h"
 #include "nsIDocShellTreeItem.h"
 #include "nsIChannel.h"
@@ -6202,6 +6203,20 @@ nsDocShell::SetIsActive(bool aIsActive)
     }
   }
 
+  // Tell the network scheduler whether our loads belong to a background tab.
+  if (mLoadGroup) {
+    nsID rcid;
+    nsCOMPtr<nsIRequestContextService> rcsvc =
+      do_GetService("@mozilla.org/network/request-context-service;1");
+    nsCOMPtr<nsIRequestContext> rc;
+    if (rcsvc && NS_SUCCEEDED(mLoadGroup->GetRequestContextID(&rcid))) {
+      rcsvc->GetRequestContext(rcid, getter_AddRefs(rc));
+    }
+    if (rc) {
+      rc->SetInBackground(!aIsActive);
+    }
+  }
+
   // Recursively tell all of our children, but don't tell <iframe mozbrowser>
   // children; they handle their state separately.
   nsTObserverArray<nsDocLoader*>::ForwardIterator iter(mChildList);
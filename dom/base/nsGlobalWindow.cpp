@@ -7,6 +7,7 @@
 #include "nsGlobalWindow.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "mozilla/MemoryReporting.h"
 
@@ -304,14 +305,36 @@ int32_t gTimeoutCnt                                    = 0;
 #define DEFAULT_MIN_BACKGROUND_TIMEOUT_VALUE 1000 // 1000ms
 static int32_t gMinTimeoutValue;
 static int32_t gMinBackgroundTimeoutValue;
-inline int32_t
-nsGlobalWindow::DOMMinTimeoutValue() const {
+inline bool
+nsGlobalWindow::IsBackgroundForTimeouts() const {
   // Don't use the background timeout value when there are audio contexts
   // present, so that baackground audio can keep running smoothly. (bug 1181073)
-  bool isBackground = mAudioContexts.IsEmpty() &&
+  return mAudioContexts.IsEmpty() &&
     (!mOuterWindow || mOuterWindow->IsBackground());
-  return
-    std::max(isBackground ? gMinBackgroundTimeoutValue : gMinTimeoutValue, 0);
+}
+inline int32_t
+nsGlobalWindow::DOMMinTimeoutValue() const {
+  return std::max(IsBackgroundForTimeouts() ? gMinBackgroundTimeoutValue :
+                                              gMinTimeoutValue, 0);
+}
+
+// Budget-based throttling of background timeouts.  Running timeouts in a
+// background window uses up its execution budget, which regenerates by 1ms
+// every gBackgroundBudgetRegenerationFactor ms up to
+// gBackgroundThrottlingMaxBudget ms.  While the budget is negative, timeouts
+// are delayed until it would be back to zero.  Background timeouts also fire
+// on multiples of BACKGROUND_TIMEOUT_ALIGNMENT ms after a process-wide base
+// time, so that the timeouts of all background windows share wakeups.
+#define DEFAULT_BACKGROUND_BUDGET_REGENERATION_FACTOR 100 // 1ms per 100ms
+#define DEFAULT_BACKGROUND_THROTTLING_MAX_BUDGET 50 // 50ms
+#define BACKGROUND_TIMEOUT_ALIGNMENT 1000 // 1000ms
+static bool gEnableBudgetTimeoutThrottling;
+static int32_t gBackgroundBudgetRegenerationFactor;
+static int32_t gBackgroundThrottlingMaxBudget;
+static TimeStamp gBackgroundTimeoutAlignmentBase;
+inline bool
+nsGlobalWindow::IsBudgetThrottled() const {
+  return gEnableBudgetTimeoutThrottling && IsBackgroundForTimeouts();
 }
 
 // The number of nested timeouts before we start clamping. HTML5 says 1, WebKit
@@ -1282,6 +1305,15 @@ nsGlobalWindow::nsGlobalWindow(nsGlobalWindow *aOuterWindow)
     Preferences::AddIntVarCache(&gMinBackgroundTimeoutValue,
                                 "dom.min_background_timeout_value",
                                 DEFAULT_MIN_BACKGROUND_TIMEOUT_VALUE);
+    Preferences::AddBoolVarCache(&gEnableBudgetTimeoutThrottling,
+                                 "dom.timeout.enable_budget_timer_throttling",
+                                 false);
+    Preferences::AddIntVarCache(&gBackgroundBudgetRegenerationFactor,
+                                "dom.timeout.background_budget_regeneration_rate",
+                                DEFAULT_BACKGROUND_BUDGET_REGENERATION_FACTOR);
+    Preferences::AddIntVarCache(&gBackgroundThrottlingMaxBudget,
+                                "dom.timeout.background_throttling_max_budget",
+                                DEFAULT_BACKGROUND_THROTTLING_MAX_BUDGET);
     Preferences::AddBoolVarCache(&sIdleObserversAPIFuzzTimeDisabled,
                                  "dom.idle-observers-api.fuzz_time.disabled",
                                  false);
@@ -12123,7 +12155,12 @@ nsGlobalWindow::SetTimeoutOrInterval(nsIScriptTimeoutHandler *aHandler,
     // actual firing time of the timer (i.e., now + delta). We also actually
     // create a timer and fire it off.
 
-    timeout->mWhen = TimeStamp::Now() + delta;
+    TimeStamp now = TimeStamp::Now();
+    if (IsBudgetThrottled()) {
+      delta = ThrottleBackgroundTimeoutDelay(delta, now);
+      realInterval = uint32_t(delta.ToMilliseconds());
+    }
+    timeout->mWhen = now + delta;
 
     nsresult rv;
     timeout->mTimer = do_CreateInstance("@mozilla.org/timer;1", &rv);
@@ -12401,6 +12438,10 @@ nsGlobalWindow::RescheduleTimeout(nsTimeout* aTimeout, const TimeStamp& now,
     return true;
   }
 
+  if (IsBudgetThrottled()) {
+    delay = ThrottleBackgroundTimeoutDelay(delay, currentNow);
+  }
+
   aTimeout->mWhen = currentNow + delay;
 
   // Reschedule the OS timer. Don't bother returning any error codes if
@@ -12429,6 +12470,51 @@ nsGlobalWindow::RescheduleTimeout(nsTimeout* aTimeout, const TimeStamp& now,
   return true;
 }
 
+void
+nsGlobalWindow::UpdateBackgroundTimeoutBudget(const TimeStamp& aNow)
+{
+  MOZ_ASSERT(IsInnerWindow());
+
+  TimeDuration maxBudget =
+    TimeDuration::FromMilliseconds(gBackgroundThrottlingMaxBudget);
+  if (mBackgroundTimeoutBudgetUpdate.IsNull()) {
+    mBackgroundTimeoutBudget = maxBudget;
+  } else if (aNow > mBackgroundTimeoutBudgetUpdate) {
+    mBackgroundTimeoutBudget +=
+      (aNow - mBackgroundTimeoutBudgetUpdate) /
+      int64_t(std::max(gBackgroundBudgetRegenerationFactor, 1));
+    if (mBackgroundTimeoutBudget > maxBudget) {
+      mBackgroundTimeoutBudget = maxBudget;
+    }
+  }
+  mBackgroundTimeoutBudgetUpdate = aNow;
+}
+
+TimeDuration
+nsGlobalWindow::ThrottleBackgroundTimeoutDelay(TimeDuration aDelay,
+                                               const TimeStamp& aNow)
+{
+  MOZ_ASSERT(IsBudgetThrottled());
+
+  UpdateBackgroundTimeoutBudget(aNow);
+  if (mBackgroundTimeoutBudget < TimeDuration(0)) {
+    // Wait until the budget has regenerated back to zero.
+    TimeDuration regeneration =
+      -mBackgroundTimeoutBudget *
+      int64_t(std::max(gBackgroundBudgetRegenerationFactor, 1));
+    aDelay = std::max(aDelay, regeneration);
+  }
+
+  if (gBackgroundTimeoutAlignmentBase.IsNull()) {
+    gBackgroundTimeoutAlignmentBase = aNow;
+  }
+  TimeDuration alignment =
+    TimeDuration::FromMilliseconds(BACKGROUND_TIMEOUT_ALIGNMENT);
+  TimeDuration sinceBase = aNow + aDelay - gBackgroundTimeoutAlignmentBase;
+  int64_t periods = int64_t(std::ceil(sinceBase / alignment));
+  return gBackgroundTimeoutAlignmentBase + alignment * periods - aNow;
+}
+
 void
 nsGlobalWindow::RunTimeout(nsTimeout *aTimeout)
 {
@@ -12547,6 +12633,13 @@ nsGlobalWindow::RunTimeout(nsTimeout *aTimeout)
     }
 
     // This timeout is good to run
+    bool budgetThrottled = IsBudgetThrottled();
+    TimeStamp handlerStart;
+    if (budgetThrottled) {
+      handlerStart = TimeStamp::Now();
+      UpdateBackgroundTimeoutBudget(handlerStart);
+    }
+
     bool timeout_was_cleared = RunTimeoutHandler(timeout, scx);
 
     if (timeout_was_cleared) {
@@ -12562,6 +12655,12 @@ nsGlobalWindow::RunTimeout(nsTimeout *aTimeout)
       return;
     }
 
+    if (budgetThrottled) {
+      TimeStamp handlerEnd = TimeStamp::Now();
+      mBackgroundTimeoutBudget -= handlerEnd - handlerStart;
+      mBackgroundTimeoutBudgetUpdate = handlerEnd;
+    }
+
     // If we have a regular interval timer, we re-schedule the
     // timeout, accounting for clock drift.
     bool needsReinsertion = RescheduleTimeout(timeout, now, !aTimeout);
@@ -12651,7 +12750,10 @@ nsresult nsGlobalWindow::ResetTimersForNonBackgroundWindow()
       continue;
     }
 
-    if (timeout->mWhen - now >
+    // Budget throttling can delay timeouts by any amount, so they all need
+    // to be looked at then.
+    if (!gEnableBudgetTimeoutThrottling &&
+        timeout->mWhen - now >
         TimeDuration::FromMilliseconds(gMinBackgroundTimeoutValue)) {
       // No need to loop further.  Timeouts are sorted in mWhen order
       // and the ones after this point were all set up for at least
@@ -1519,6 +1519,14 @@ public:
   // Return true if |aTimeout| needs to be reinserted into the timeout list.
   bool RescheduleTimeout(nsTimeout* aTimeout, const TimeStamp& now,
                          bool aRunningPendingTimeouts);
+  // Return how long a timeout that is due in aDelay should actually wait,
+  // once budget throttling and alignment of background timeouts (see
+  // dom.timeout.enable_budget_timer_throttling) have been applied.
+  TimeDuration ThrottleBackgroundTimeoutDelay(TimeDuration aDelay,
+                                              const TimeStamp& aNow);
+  // Add the budget regenerated since it was last updated to
+  // mBackgroundTimeoutBudget.
+  void UpdateBackgroundTimeoutBudget(const TimeStamp& aNow);
 
   void ClearAllTimeouts();
   // Insert aTimeout into the list, before all timeouts that would
@@ -1661,6 +1669,8 @@ protected:
   virtual void UpdateParentTarget() override;
 
   inline int32_t DOMMinTimeoutValue() const;
+  inline bool IsBackgroundForTimeouts() const;
+  inline bool IsBudgetThrottled() const;
 
   void InitializeShowFocusRings();
 
@@ -1884,6 +1894,10 @@ protected:
   nsTimeout*                    mTimeoutInsertionPoint;
   uint32_t                      mTimeoutPublicIdCounter;
   uint32_t                      mTimeoutFiringDepth;
+  // The execution time that timeouts may still use while this window is in
+  // the background.  Running timeouts uses it up; it regenerates over time.
+  TimeDuration                  mBackgroundTimeoutBudget;
+  TimeStamp                     mBackgroundTimeoutBudgetUpdate;
   RefPtr<mozilla::dom::Location> mLocation;
   RefPtr<nsHistory>           mHistory;
   RefPtr<mozilla::dom::CustomElementsRegistry> mCustomElements;
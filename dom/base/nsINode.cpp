@@ -2871,10 +2871,56 @@ FindMatchingElements(nsINode* aRoot, nsCSSSelectorList* aSelectorList, T &aList,
     return;
   }
 
+  // Likewise, selectors whose rightmost compound has a class only need to
+  // look at the elements with that class.  getElementsByClassName's list is
+  // cached and kept up to date across DOM mutations, so repeated queries don't
+  // walk the whole subtree again.  Its matching (including quirks mode case
+  // insensitivity) is the same as the selector's, so every match is in it and
+  // it's already in document order.
+  nsCSSSelector* rightmost = aSelectorList->mSelectors;
+  if (!aSelectorList->mNext && rightmost->mClassList) {
+    nsIAtom* className = rightmost->mClassList->mAtom;
+    RefPtr<nsContentList> candidates =
+      nsContentUtils::GetElementsByClassName(aRoot,
+                                             nsDependentAtomString(className));
+    const uint32_t length = candidates->Length(false);
+    if (!onlyFirstMatch) {
+      aList.SetCapacity(length);
+    }
+    for (uint32_t i = 0; i < length; ++i) {
+      Element* element = candidates->Item(i, false)->AsElement();
+      if (nsCSSRuleProcessor::SelectorListMatches(element, matchingContext,
+                                                  aSelectorList)) {
+        aList.AppendElement(element);
+        if (onlyFirstMatch) {
+          return;
+        }
+      }
+    }
+    return;
+  }
+
+  // Otherwise skip elements whose local name can't match the rightmost tag
+  // without going through the full selector matching.  HTML elements are
+  // matched against mLowercaseTag and others against mCasedTag, so an element
+  // whose name is neither can't match.
+  nsIAtom* lowercaseTag = nullptr;
+  nsIAtom* casedTag = nullptr;
+  if (!aSelectorList->mNext && rightmost->mCasedTag) {
+    lowercaseTag = rightmost->mLowercaseTag;
+    casedTag = rightmost->mCasedTag;
+  }
+
   Collector results;
   for (nsIContent* cur = aRoot->GetFirstChild();
        cur;
        cur = cur->GetNextNode(aRoot)) {
+    if (casedTag) {
+      nsIAtom* name = cur->NodeInfo()->NameAtom();
+      if (name != lowercaseTag && name != casedTag) {
+        continue;
+      }
+    }
     if (cur->IsElement() &&
         nsCSSRuleProcessor::SelectorListMatches(cur->AsElement(),
                                                 matchingContext,
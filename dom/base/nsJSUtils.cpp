@@ -267,6 +267,103 @@ nsJSUtils::EvaluateString(JSContext* aCx,
                         options, &unused, aOffThreadToken);
 }
 
+static nsresult
+EvaluationExceptionResult(JSContext* aCx)
+{
+  return JS_IsExceptionPending(aCx) ?
+         NS_SUCCESS_DOM_SCRIPT_EVALUATION_THREW :
+         NS_SUCCESS_DOM_SCRIPT_EVALUATION_THREW_UNCATCHABLE;
+}
+
+nsresult
+nsJSUtils::EvaluateStringAndEncode(JSContext* aCx,
+                                   JS::SourceBufferHolder& aSrcBuf,
+                                   JS::Handle<JSObject*> aEvaluationGlobal,
+                                   JS::CompileOptions& aCompileOptions,
+                                   void **aOffThreadToken,
+                                   mozilla::Vector<uint8_t>& aBytecode)
+{
+  PROFILER_LABEL("nsJSUtils", "EvaluateStringAndEncode",
+    js::ProfileEntry::Category::JS);
+
+  MOZ_ASSERT(aCx == nsContentUtils::GetCurrentJSContext());
+  MOZ_ASSERT(js::GetGlobalForObjectCrossCompartment(aEvaluationGlobal) ==
+             aEvaluationGlobal);
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(nsContentUtils::IsInMicroTask());
+
+  aCompileOptions.setNoScriptRval(true);
+
+  NS_ENSURE_TRUE(xpc::Scriptability::Get(aEvaluationGlobal).Allowed(), NS_OK);
+
+  JSAutoCompartment ac(aCx, aEvaluationGlobal);
+
+  JS::Rooted<JSScript*> script(aCx);
+  if (aOffThreadToken) {
+    script = JS::FinishOffThreadScript(aCx, *aOffThreadToken);
+    *aOffThreadToken = nullptr; // Mark the token as having been finished.
+    if (!script) {
+      return EvaluationExceptionResult(aCx);
+    }
+  } else if (!JS::Compile(aCx, aCompileOptions, aSrcBuf, &script)) {
+    return EvaluationExceptionResult(aCx);
+  }
+
+  uint32_t length;
+  void* data = JS_EncodeScript(aCx, script, &length);
+  if (data) {
+    if (!aBytecode.append(static_cast<uint8_t*>(data), length)) {
+      aBytecode.clear();
+    }
+    js_free(data);
+  } else {
+    // JS_EncodeScript may have set a pending exception.
+    JS_ClearPendingException(aCx);
+  }
+
+  if (!JS_ExecuteScript(aCx, script)) {
+    return EvaluationExceptionResult(aCx);
+  }
+  return NS_OK;
+}
+
+nsresult
+nsJSUtils::DecodeAndEvaluate(JSContext* aCx,
+                             const mozilla::Vector<uint8_t>& aBytecode,
+                             JS::Handle<JSObject*> aEvaluationGlobal,
+                             void **aOffThreadToken)
+{
+  PROFILER_LABEL("nsJSUtils", "DecodeAndEvaluate",
+    js::ProfileEntry::Category::JS);
+
+  MOZ_ASSERT(aCx == nsContentUtils::GetCurrentJSContext());
+  MOZ_ASSERT(js::GetGlobalForObjectCrossCompartment(aEvaluationGlobal) ==
+             aEvaluationGlobal);
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(nsContentUtils::IsInMicroTask());
+
+  NS_ENSURE_TRUE(xpc::Scriptability::Get(aEvaluationGlobal).Allowed(), NS_OK);
+
+  JSAutoCompartment ac(aCx, aEvaluationGlobal);
+
+  JS::Rooted<JSScript*> script(aCx);
+  if (aOffThreadToken) {
+    script = JS::FinishOffThreadScriptDecoder(aCx, *aOffThreadToken);
+    *aOffThreadToken = nullptr; // Mark the token as having been finished.
+  } else {
+    script = JS_DecodeScript(aCx, aBytecode.begin(), aBytecode.length());
+  }
+  if (!script) {
+    JS_ClearPendingException(aCx);
+    return NS_ERROR_FAILURE;
+  }
+
+  if (!JS_ExecuteScript(aCx, script)) {
+    return EvaluationExceptionResult(aCx);
+  }
+  return NS_OK;
+}
+
 nsresult
 nsJSUtils::CompileModule(JSContext* aCx,
                        JS::SourceBufferHolder& aSrcBuf,
@@ -15,6 +15,7 @@
  */
 
 #include "mozilla/Assertions.h"
+#include "mozilla/Vector.h"
 
 #include "jsapi.h"
 #include "jsfriendapi.h"
@@ -103,6 +104,25 @@ public:
                                  JS::CompileOptions &aCompileOptions,
                                  void **aOffThreadToken);
 
+  // Like the EvaluateString overload above, but XDR-encodes the compiled
+  // script into aBytecode before executing it, so that the bytecode does not
+  // capture any state from the execution.  If the script cannot be encoded,
+  // aBytecode is left empty and the script is executed all the same.
+  static nsresult EvaluateStringAndEncode(JSContext* aCx,
+                                          JS::SourceBufferHolder& aSrcBuf,
+                                          JS::Handle<JSObject*> aEvaluationGlobal,
+                                          JS::CompileOptions &aCompileOptions,
+                                          void **aOffThreadToken,
+                                          mozilla::Vector<uint8_t>& aBytecode);
+
+  // Decode a script from XDR bytecode, or finish decoding it off-thread if
+  // aOffThreadToken is non-null, and execute it.  Returns NS_ERROR_FAILURE,
+  // without any pending exception, if the bytecode cannot be decoded.
+  static nsresult DecodeAndEvaluate(JSContext* aCx,
+                                    const mozilla::Vector<uint8_t>& aBytecode,
+                                    JS::Handle<JSObject*> aEvaluationGlobal,
+                                    void **aOffThreadToken);
+
   static nsresult CompileModule(JSContext* aCx,
                                 JS::SourceBufferHolder& aSrcBuf,
                                 JS::Handle<JSObject*> aEvaluationGlobal,
@@ -53,6 +53,12 @@
 #include "ImportManager.h"
 #include "mozilla/dom/EncodingUtils.h"
 #include "mozilla/ConsoleReportCollector.h"
+#include "mozilla/ClearOnShutdown.h"
+#include "mozilla/CycleCollectedJSContext.h"
+#include "mozilla/Preferences.h"
+#include "mozilla/StaticPtr.h"
+#include "nsDataHashtable.h"
+#include "nsIOutputStream.h"
 
 #include "mozilla/Attributes.h"
 #include "mozilla/Unused.h"
@@ -65,6 +71,97 @@ using JS::SourceBufferHolder;
 
 static LazyLogModule gCspPRLog("CSP");
 
+//////////////////////////////////////////////////////////////
+// Bytecode cache
+//////////////////////////////////////////////////////////////
+
+// When enabled, the bytecode of classic scripts that have already been run
+// from source a few times in this process is saved in the alternative data of
+// their HTTP cache entry, and loaded instead of the source the next time.
+
+static bool
+IsBytecodeCacheEnabled()
+{
+  return Preferences::GetBool("dom.script_loader.bytecode_cache.enabled",
+                              false);
+}
+
+// The alternative data type of saved bytecode.  It includes the build ID, so
+// that we never request bytecode saved by another build.
+static void
+GetBytecodeMimeType(nsACString& aType)
+{
+  aType.AssignLiteral("javascript/moz-bytecode-");
+  JS::BuildIdCharVector buildId;
+  if (GetBuildId(&buildId)) {
+    aType.Append(buildId.begin(), buildId.length());
+  }
+}
+
+// Number of times each script has been run from source in this process,
+// keyed by URL.
+static StaticAutoPtr<nsDataHashtable<nsCStringHashKey, uint32_t>>
+  sScriptExecutionCounts;
+
+// Don't let the execution counts grow without bound.
+static const uint32_t kMaxScriptExecutionCounts = 4096;
+
+static uint32_t
+GetScriptExecutionCount(nsIURI* aURI)
+{
+  nsAutoCString spec;
+  if (!sScriptExecutionCounts || NS_FAILED(aURI->GetSpec(spec))) {
+    return 0;
+  }
+  return sScriptExecutionCounts->Get(spec);
+}
+
+static void
+NoteScriptExecuted(nsIURI* aURI)
+{
+  nsAutoCString spec;
+  if (NS_FAILED(aURI->GetSpec(spec))) {
+    return;
+  }
+
+  if (!sScriptExecutionCounts) {
+    sScriptExecutionCounts = new nsDataHashtable<nsCStringHashKey, uint32_t>();
+    ClearOnShutdown(&sScriptExecutionCounts);
+  } else if (sScriptExecutionCounts->Count() >= kMaxScriptExecutionCounts) {
+    sScriptExecutionCounts->Clear();
+  }
+
+  sScriptExecutionCounts->Put(spec, sScriptExecutionCounts->Get(spec) + 1);
+}
+
+// Save |aLength| bytes as the alternative data of |aCacheInfo|'s entry,
+// replacing any previous alternative data.
+static void
+WriteAlternativeData(nsICacheInfoChannel* aCacheInfo, const nsACString& aType,
+                     const uint8_t* aData, uint32_t aLength)
+{
+  nsCOMPtr<nsIOutputStream> output;
+  nsresult rv = aCacheInfo->OpenAlternativeOutputStream(aType,
+                                                        getter_AddRefs(output));
+  if (NS_FAILED(rv)) {
+    return;
+  }
+
+  while (aLength > 0) {
+    uint32_t written;
+    rv = output->Write(reinterpret_cast<const char*>(aData), aLength, &written);
+    if (NS_FAILED(rv) || written == 0) {
+      // Partially written bytecode fails to decode and gets invalidated by
+      // the next load.
+      break;
+    }
+    aData += written;
+    aLength -= written;
+  }
+
+  output->Close();
+}
+
 void
 ImplCycleCollectionUnlink(nsScriptLoadRequestList& aField);
 
@@ -122,7 +219,11 @@ nsScriptLoadRequest::MaybeCancelOffThreadScript()
   }
 
   JSContext* cx = danger::GetJSContext();
-  JS::CancelOffThreadScript(cx, mOffThreadToken);
+  if (mIsBytecode) {
+    JS::CancelOffThreadScriptDecoder(cx, mOffThreadToken);
+  } else {
+    JS::CancelOffThreadScript(cx, mOffThreadToken);
+  }
   mOffThreadToken = nullptr;
 }
 
@@ -1258,6 +1359,18 @@ nsScriptLoader::StartLoad(nsScriptLoadRequest *aRequest, const nsAString &aType,
 
   NS_ENSURE_SUCCESS(rv, rv);
 
+  // Ask for the bytecode of classic scripts if a previous load saved it in
+  // the cache.  Integrity metadata can only be checked against the source.
+  if (!aRequest->IsModuleRequest() && aRequest->mIntegrity.IsEmpty() &&
+      !aRequest->mBytecodeRejected && IsBytecodeCacheEnabled()) {
+    nsCOMPtr<nsICacheInfoChannel> cacheInfo(do_QueryInterface(channel));
+    if (cacheInfo) {
+      nsAutoCString bytecodeType;
+      GetBytecodeMimeType(bytecodeType);
+      cacheInfo->PreferAlternativeDataType(bytecodeType);
+    }
+  }
+
   nsIScriptElement *script = aRequest->mElement;
   nsCOMPtr<nsIClassOfService> cos(do_QueryInterface(channel));
 
@@ -1318,6 +1431,23 @@ nsScriptLoader::StartLoad(nsScriptLoadRequest *aRequest, const nsAString &aType,
   return channel->AsyncOpen2(loader);
 }
 
+nsresult
+nsScriptLoader::RestartLoadWithoutBytecode(nsScriptLoadRequest *aRequest)
+{
+  MOZ_ASSERT(aRequest->mIsBytecode);
+  MOZ_ASSERT(!aRequest->mOffThreadToken);
+
+  aRequest->mIsBytecode = false;
+  aRequest->mBytecodeRejected = true;
+  aRequest->mScriptBytecode.clearAndFree();
+  aRequest->mOriginPrincipal = nullptr;
+  aRequest->mHasSourceMapURL = false;
+  aRequest->mSourceMapURL.Truncate();
+
+  return StartLoad(aRequest, NS_LITERAL_STRING("text/javascript"),
+                   /* aScriptFromHead = */ false);
+}
+
 bool
 nsScriptLoader::PreloadURIComparator::Equals(const PreloadInfo &aPi,
                                              nsIURI * const &aURI) const
@@ -1852,14 +1982,28 @@ nsScriptLoader::AttemptAsyncScriptCompile(nsScriptLoadRequest* aRequest)
     return rv;
   }
 
-  if (!JS::CanCompileOffThread(cx, options, aRequest->mScriptTextLength)) {
+  if (aRequest->mIsBytecode) {
+    if (!JS::CanDecodeOffThread(cx, options,
+                                aRequest->mScriptBytecode.length())) {
+      return NS_ERROR_FAILURE;
+    }
+  } else if (!JS::CanCompileOffThread(cx, options,
+                                      aRequest->mScriptTextLength)) {
     return NS_ERROR_FAILURE;
   }
 
   RefPtr<NotifyOffThreadScriptLoadCompletedRunnable> runnable =
     new NotifyOffThreadScriptLoadCompletedRunnable(aRequest, this);
 
-  if (aRequest->IsModuleRequest()) {
+  if (aRequest->mIsBytecode) {
+    if (!JS::DecodeOffThreadScript(cx, options,
+                                   aRequest->mScriptBytecode.begin(),
+                                   aRequest->mScriptBytecode.length(),
+                                   OffThreadScriptLoaderCallback,
+                                   static_cast<void*>(runnable))) {
+      return NS_ERROR_OUT_OF_MEMORY;
+    }
+  } else if (aRequest->IsModuleRequest()) {
     if (!JS::CompileOffThreadModule(cx, options,
                                     aRequest->mScriptTextBuf, aRequest->mScriptTextLength,
                                     OffThreadScriptLoaderCallback,
@@ -2017,6 +2161,8 @@ nsScriptLoader::ProcessRequest(nsScriptLoadRequest* aRequest)
   free(aRequest->mScriptTextBuf);
   aRequest->mScriptTextBuf = nullptr;
   aRequest->mScriptTextLength = 0;
+  aRequest->mScriptBytecode.clearAndFree();
+  aRequest->mCacheInfo = nullptr;
 
   return rv;
 }
@@ -2090,7 +2236,8 @@ nsScriptLoader::FillCompileOptionsForRequest(const AutoJSAPI&jsapi,
                                                 : "importedModule");
   aOptions->setFileAndLine(aRequest->mURL.get(), aRequest->mLineNo);
   aOptions->setVersion(JSVersion(aRequest->mJSVersion));
-  aOptions->setIsRunOnce(true);
+  // Run-once scripts are compiled in a way that cannot be encoded.
+  aOptions->setIsRunOnce(!aRequest->mCacheInfo || aRequest->mIsBytecode);
   // We only need the setNoScriptRval bit when compiling off-thread here, since
   // otherwise nsJSUtils::EvaluateString will set it up for us.
   aOptions->setNoScriptRval(true);
@@ -2196,11 +2343,41 @@ nsScriptLoader::EvaluateScript(nsScriptLoadRequest* aRequest)
       JS::CompileOptions options(aes.cx());
       rv = FillCompileOptionsForRequest(aes, aRequest, global, &options);
 
-      if (NS_SUCCEEDED(rv)) {
+      if (NS_SUCCEEDED(rv) && aRequest->mIsBytecode) {
+        rv = nsJSUtils::DecodeAndEvaluate(aes.cx(), aRequest->mScriptBytecode,
+                                          global,
+                                          aRequest->OffThreadTokenPtr());
+        if (rv == NS_ERROR_FAILURE && aRequest->mCacheInfo) {
+          // The saved bytecode is unusable.  Replace it with data of another
+          // type, so that the next load gets the source again.
+          nsAutoCString invalidType;
+          GetBytecodeMimeType(invalidType);
+          invalidType.AppendLiteral("-invalid");
+          WriteAlternativeData(aRequest->mCacheInfo, invalidType, nullptr, 0);
+        }
+      } else if (NS_SUCCEEDED(rv)) {
         nsAutoString inlineData;
         SourceBufferHolder srcBuf = GetScriptSource(aRequest, inlineData);
-        rv = nsJSUtils::EvaluateString(aes.cx(), srcBuf, global, options,
-                                       aRequest->OffThreadTokenPtr());
+        if (aRequest->mCacheInfo) {
+          rv = nsJSUtils::EvaluateStringAndEncode(aes.cx(), srcBuf, global,
+                                                  options,
+                                                  aRequest->OffThreadTokenPtr(),
+                                                  aRequest->mScriptBytecode);
+          if (rv == NS_OK && !aRequest->mScriptBytecode.empty()) {
+            nsAutoCString bytecodeType;
+            GetBytecodeMimeType(bytecodeType);
+            WriteAlternativeData(aRequest->mCacheInfo, bytecodeType,
+                                 aRequest->mScriptBytecode.begin(),
+                                 aRequest->mScriptBytecode.length());
+          }
+        } else {
+          rv = nsJSUtils::EvaluateString(aes.cx(), srcBuf, global, options,
+                                         aRequest->OffThreadTokenPtr());
+        }
+
+        if (rv == NS_OK && !aRequest->mIsInline && IsBytecodeCacheEnabled()) {
+          NoteScriptExecuted(aRequest->mURI);
+        }
       }
     }
   }
@@ -2661,6 +2838,29 @@ nsScriptLoader::PrepareLoadedRequest(nsScriptLoadRequest* aRequest,
     aRequest->mScriptTextBuf = aString.extractOrCopyRawBuffer();
   }
 
+  // Keep the cache entry of bytecode we loaded, in case it turns out to be
+  // unusable, and of scripts that have been run from source often enough for
+  // their bytecode to be worth saving.
+  //
+  // Bytecode does not remember whether the script's errors are muted, so it
+  // is only saved and used for scripts whose errors are not.
+  bool mutedErrors = aRequest->mOriginPrincipal &&
+    !mDocument->MasterDocument()->NodePrincipal()->
+      Subsumes(aRequest->mOriginPrincipal);
+  if (aRequest->mIsBytecode) {
+    if (mutedErrors) {
+      // We got here through a cross-origin redirect.
+      return RestartLoadWithoutBytecode(aRequest);
+    }
+    aRequest->mCacheInfo = do_QueryInterface(req);
+  } else if (!aRequest->IsModuleRequest() && !mutedErrors &&
+             aRequest->mIntegrity.IsEmpty() && IsBytecodeCacheEnabled() &&
+             GetScriptExecutionCount(aRequest->mURI) >=
+               Preferences::GetUint("dom.script_loader.bytecode_cache.min_executions",
+                                    1)) {
+    aRequest->mCacheInfo = do_QueryInterface(req);
+  }
+
   // This assertion could fire errorously if we ran out of memory when
   // inserting the request in the array. However it's an unlikely case
   // so if you see this assertion it is likely something else that is
@@ -2837,7 +3037,8 @@ nsScriptLoadHandler::nsScriptLoadHandler(nsScriptLoader *aScriptLoader,
     mSRIDataVerifier(aSRIDataVerifier),
     mSRIStatus(NS_OK),
     mDecoder(),
-    mBuffer()
+    mBuffer(),
+    mCheckedDataType(false)
 {}
 
 nsScriptLoadHandler::~nsScriptLoadHandler()
@@ -2858,6 +3059,16 @@ nsScriptLoadHandler::OnIncrementalData(nsIIncrementalStreamLoader* aLoader,
     return NS_OK;
   }
 
+  CheckDataType(aLoader);
+  if (mRequest->mIsBytecode) {
+    // Bytecode is kept as is, and decoded once it has been fully loaded.
+    *aConsumedLength = aDataLength;
+    if (!mRequest->mScriptBytecode.append(aData, aDataLength)) {
+      return NS_ERROR_OUT_OF_MEMORY;
+    }
+    return NS_OK;
+  }
+
   if (!EnsureDecoder(aLoader, aData, aDataLength,
                      /* aEndOfStream = */ false)) {
     return NS_OK;
@@ -2999,6 +3210,36 @@ nsScriptLoadHandler::EnsureDecoder(nsIIncrementalStreamLoader *aLoader,
   return true;
 }
 
+void
+nsScriptLoadHandler::CheckDataType(nsIIncrementalStreamLoader *aLoader)
+{
+  if (mCheckedDataType) {
+    return;
+  }
+  mCheckedDataType = true;
+
+  nsCOMPtr<nsIRequest> req;
+  nsresult rv = aLoader->GetRequest(getter_AddRefs(req));
+  NS_ENSURE_SUCCESS_VOID(rv);
+
+  nsCOMPtr<nsICacheInfoChannel> cacheInfo = do_QueryInterface(req);
+  if (!cacheInfo) {
+    return;
+  }
+
+  // The alternative data type is empty unless the cache entry holds data of
+  // the type we asked for in StartLoad.
+  nsAutoCString altDataType;
+  if (NS_FAILED(cacheInfo->GetAlternativeDataType(altDataType)) ||
+      altDataType.IsEmpty()) {
+    return;
+  }
+
+  nsAutoCString bytecodeType;
+  GetBytecodeMimeType(bytecodeType);
+  mRequest->mIsBytecode = altDataType.Equals(bytecodeType);
+}
+
 NS_IMETHODIMP
 nsScriptLoadHandler::OnStreamComplete(nsIIncrementalStreamLoader* aLoader,
                                       nsISupports* aContext,
@@ -3007,6 +3248,15 @@ nsScriptLoadHandler::OnStreamComplete(nsIIncrementalStreamLoader* aLoader,
                                       const uint8_t* aData)
 {
   if (!mRequest->IsCanceled()) {
+    CheckDataType(aLoader);
+  }
+
+  if (!mRequest->IsCanceled() && mRequest->mIsBytecode) {
+    if (!mRequest->mScriptBytecode.append(aData, aDataLength) &&
+        NS_SUCCEEDED(aStatus)) {
+      aStatus = NS_ERROR_OUT_OF_MEMORY;
+    }
+  } else if (!mRequest->IsCanceled()) {
     DebugOnly<bool> encoderSet =
       EnsureDecoder(aLoader, aData, aDataLength, /* aEndOfStream = */ true);
     MOZ_ASSERT(encoderSet);
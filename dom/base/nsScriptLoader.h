@@ -20,6 +20,7 @@
 #include "nsTArray.h"
 #include "nsAutoPtr.h"
 #include "nsIDocument.h"
+#include "nsICacheInfoChannel.h"
 #include "nsIIncrementalStreamLoader.h"
 #include "nsURIHashKey.h"
 #include "mozilla/CORSMode.h"
@@ -83,6 +84,8 @@ public:
       mIsXSLT(false),
       mIsCanceled(false),
       mWasCompiledOMT(false),
+      mIsBytecode(false),
+      mBytecodeRejected(false),
       mOffThreadToken(nullptr),
       mScriptTextBuf(nullptr),
       mScriptTextLength(0),
@@ -165,10 +168,16 @@ public:
   bool mIsXSLT;           // True if we live in mXSLTRequests.
   bool mIsCanceled;       // True if we have been explicitly canceled.
   bool mWasCompiledOMT;   // True if the script has been compiled off main thread.
-  void* mOffThreadToken;  // Off-thread parsing token.
+  bool mIsBytecode;       // True if we loaded bytecode from the cache instead of source.
+  bool mBytecodeRejected; // True if the source was reloaded because the bytecode could not be used.
+  void* mOffThreadToken;  // Off-thread parsing or decoding token.
   nsString mSourceMapURL; // Holds source map url for loaded scripts
   char16_t* mScriptTextBuf; // Holds script text for non-inline scripts. Don't
   size_t mScriptTextLength; // use nsString so we can give ownership to jsapi.
+  mozilla::Vector<uint8_t> mScriptBytecode; // Bytecode read from or saved to the cache.
+  // The cache entry of the script, set only if its bytecode should be saved
+  // once it has run, or if the bytecode we loaded turns out to be unusable.
+  nsCOMPtr<nsICacheInfoChannel> mCacheInfo;
   uint32_t mJSVersion;
   nsCOMPtr<nsIURI> mURI;
   nsCOMPtr<nsIPrincipal> mOriginPrincipal;
@@ -505,6 +514,11 @@ private:
   nsresult StartLoad(nsScriptLoadRequest *aRequest, const nsAString &aType,
                      bool aScriptFromHead);
 
+  /**
+   * Drop the bytecode loaded for aRequest and load its source instead.
+   */
+  nsresult RestartLoadWithoutBytecode(nsScriptLoadRequest *aRequest);
+
   /**
    * Process any pending requests asynchronously (i.e. off an event) if there
    * are any. Note that this is a no-op if there aren't any currently pending
@@ -670,6 +684,12 @@ private:
                      const uint8_t* aData, uint32_t aDataLength,
                      bool aEndOfStream);
 
+  /*
+   * Check whether the channel delivers the script's bytecode, saved in the
+   * cache by a previous load, rather than its source.
+   */
+  void CheckDataType(nsIIncrementalStreamLoader *aLoader);
+
   // ScriptLoader which will handle the parsed script.
   RefPtr<nsScriptLoader>        mScriptLoader;
 
@@ -687,6 +707,9 @@ private:
 
   // Accumulated decoded char buffer.
   mozilla::Vector<char16_t>     mBuffer;
+
+  // True once CheckDataType has been called.
+  bool                          mCheckedDataType;
 };
 
 class nsAutoScriptLoaderDisabler
@@ -20,6 +20,10 @@
 #include "mozilla/CheckedInt.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/SSE.h"
+#ifdef BUILD_ARM_NEON
+#include "mozilla/arm.h"
+#endif
+#include "nsStringBuffer.h"
 #include "nsTextFragmentImpl.h"
 #include <algorithm>
 
@@ -33,6 +37,70 @@ static char sSingleCharSharedString[256];
 
 using mozilla::CheckedUint32;
 
+// Text that isn't one of the static strings above lives in an
+// nsStringBuffer, so that copies of a fragment, and strings made from 2-byte
+// text, share it rather than copy it. The text is followed by a null
+// terminator, as nsStringBuffer::ToString requires. A shared buffer is
+// readonly, and is copied before it is modified.
+
+// Returns the data of a new buffer for aLength characters, with the
+// terminator already written, or null if it can't be allocated.
+template<typename CharT>
+static CharT*
+AllocText(uint32_t aLength)
+{
+  CheckedUint32 size = aLength;
+  size += 1;
+  size *= sizeof(CharT);
+  if (!size.isValid()) {
+    return nullptr;
+  }
+
+  RefPtr<nsStringBuffer> buffer = nsStringBuffer::Alloc(size.value());
+  if (!buffer) {
+    return nullptr;
+  }
+
+  CharT* data = static_cast<CharT*>(buffer.forget().take()->Data());
+  data[aLength] = 0;
+  return data;
+}
+
+// Resizes the buffer holding aData, which has aOldLength characters, to hold
+// aNewLength characters. Returns the (possibly moved) data, or null if the
+// buffer couldn't be resized, in which case aData is left alone.
+template<typename CharT>
+static CharT*
+ReallocText(CharT* aData, uint32_t aOldLength, uint32_t aNewLength)
+{
+  nsStringBuffer* buffer = nsStringBuffer::FromData(aData);
+  if (buffer->IsReadonly()) {
+    CharT* data = AllocText<CharT>(aNewLength);
+    if (!data) {
+      return nullptr;
+    }
+    memcpy(data, aData, std::min(aOldLength, aNewLength) * sizeof(CharT));
+    buffer->Release();
+    return data;
+  }
+
+  CheckedUint32 size = aNewLength;
+  size += 1;
+  size *= sizeof(CharT);
+  if (!size.isValid()) {
+    return nullptr;
+  }
+
+  buffer = nsStringBuffer::Realloc(buffer, size.value());
+  if (!buffer) {
+    return nullptr;
+  }
+
+  CharT* data = static_cast<CharT*>(buffer->Data());
+  data[aNewLength] = 0;
+  return data;
+}
+
 // static
 nsresult
 nsTextFragment::Init()
@@ -86,7 +154,8 @@ void
 nsTextFragment::ReleaseText()
 {
   if (mState.mLength && m1b && mState.mInHeap) {
-    free(m2b); // m1b == m2b as far as free is concerned
+    // m1b == m2b as far as the buffer is concerned
+    nsStringBuffer::FromData(m2b)->Release();
   }
 
   m1b = nullptr;
@@ -99,35 +168,19 @@ nsTextFragment::ReleaseText()
 nsTextFragment&
 nsTextFragment::operator=(const nsTextFragment& aOther)
 {
+  if (this == &aOther) {
+    return *this;
+  }
+
   ReleaseText();
 
   if (aOther.mState.mLength) {
-    if (!aOther.mState.mInHeap) {
-      m1b = aOther.m1b; // This will work even if aOther is using m2b
-    }
-    else {
-      CheckedUint32 m2bSize = aOther.mState.mLength;
-      m2bSize *= (aOther.mState.mIs2b ? sizeof(char16_t) : sizeof(char));
-      m2b = nullptr;
-      if (m2bSize.isValid()) {
-        m2b = static_cast<char16_t*>(malloc(m2bSize.value()));
-      }
-
-      if (m2b) {
-        memcpy(m2b, aOther.m2b, m2bSize.value());
-      } else {
-        // allocate a buffer for a single REPLACEMENT CHARACTER
-        m2b = static_cast<char16_t*>(moz_xmalloc(sizeof(char16_t)));
-        m2b[0] = 0xFFFD; // REPLACEMENT CHARACTER
-        mState.mIs2b = true;
-        mState.mInHeap = true;
-        mState.mLength = 1;
-      }
-    }
-
-    if (m1b) {
-      mAllBits = aOther.mAllBits;
+    // Share the other fragment's buffer, if it has one.
+    m1b = aOther.m1b; // This will work even if aOther is using m2b
+    if (aOther.mState.mInHeap) {
+      nsStringBuffer::FromData(m2b)->AddRef();
     }
+    mAllBits = aOther.mAllBits;
   }
 
   return *this;
@@ -176,6 +229,22 @@ namespace mozilla {
 } // namespace mozilla
 #endif
 
+#ifdef MOZILLA_MAY_SUPPORT_AVX2
+namespace mozilla {
+  namespace AVX2 {
+    int32_t FirstNon8Bit(const char16_t *str, const char16_t *end);
+  } // namespace AVX2
+} // namespace mozilla
+#endif
+
+#ifdef BUILD_ARM_NEON
+namespace mozilla {
+  namespace NEON {
+    int32_t FirstNon8Bit(const char16_t *str, const char16_t *end);
+  } // namespace NEON
+} // namespace mozilla
+#endif
+
 /*
  * This function returns -1 if all characters in str are 8 bit characters.
  * Otherwise, it returns a value less than or equal to the index of the first
@@ -186,12 +255,24 @@ namespace mozilla {
 static inline int32_t
 FirstNon8Bit(const char16_t *str, const char16_t *end)
 {
+#ifdef MOZILLA_MAY_SUPPORT_AVX2
+  if (mozilla::supports_avx2()) {
+    return mozilla::AVX2::FirstNon8Bit(str, end);
+  }
+#endif
+
 #ifdef MOZILLA_MAY_SUPPORT_SSE2
   if (mozilla::supports_sse2()) {
     return mozilla::SSE2::FirstNon8Bit(str, end);
   }
 #endif
 
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    return mozilla::NEON::FirstNon8Bit(str, end);
+  }
+#endif
+
   return FirstNon8BitUnvectorized(str, end);
 }
 
@@ -259,17 +340,11 @@ nsTextFragment::SetTo(const char16_t* aBuffer, int32_t aLength, bool aUpdateBidi
 
   if (first16bit != -1) { // aBuffer contains no non-8bit character
     // Use ucs2 storage because we have to
-    CheckedUint32 m2bSize = aLength;
-    m2bSize *= sizeof(char16_t);
-    if (!m2bSize.isValid()) {
-      return false;
-    }
-
-    m2b = static_cast<char16_t*>(malloc(m2bSize.value()));
+    m2b = AllocText<char16_t>(aLength);
     if (!m2b) {
       return false;
     }
-    memcpy(m2b, aBuffer, m2bSize.value());
+    memcpy(m2b, aBuffer, aLength * sizeof(char16_t));
 
     mState.mIs2b = true;
     if (aUpdateBidi) {
@@ -278,7 +353,7 @@ nsTextFragment::SetTo(const char16_t* aBuffer, int32_t aLength, bool aUpdateBidi
 
   } else {
     // Use 1 byte storage because we can
-    char* buff = static_cast<char*>(malloc(aLength));
+    char* buff = AllocText<char>(aLength);
     if (!buff) {
       return false;
     }
@@ -342,13 +417,8 @@ nsTextFragment::Append(const char16_t* aBuffer, uint32_t aLength, bool aUpdateBi
   }
 
   if (mState.mIs2b) {
-    length *= sizeof(char16_t);
-    if (!length.isValid()) {
-      return false;
-    }
-
     // Already a 2-byte string so the result will be too
-    char16_t* buff = static_cast<char16_t*>(realloc(m2b, length.value()));
+    char16_t* buff = ReallocText(m2b, mState.mLength, length.value());
     if (!buff) {
       return false;
     }
@@ -368,14 +438,9 @@ nsTextFragment::Append(const char16_t* aBuffer, uint32_t aLength, bool aUpdateBi
   int32_t first16bit = FirstNon8Bit(aBuffer, aBuffer + aLength);
 
   if (first16bit != -1) { // aBuffer contains no non-8bit character
-    length *= sizeof(char16_t);
-    if (!length.isValid()) {
-      return false;
-    }
-
     // The old data was 1-byte, but the new is not so we have to expand it
     // all to 2-byte
-    char16_t* buff = static_cast<char16_t*>(malloc(length.value()));
+    char16_t* buff = AllocText<char16_t>(length.value());
     if (!buff) {
       return false;
     }
@@ -389,7 +454,7 @@ nsTextFragment::Append(const char16_t* aBuffer, uint32_t aLength, bool aUpdateBi
     mState.mIs2b = true;
 
     if (mState.mInHeap) {
-      free(m2b);
+      nsStringBuffer::FromData(m2b)->Release();
     }
     m2b = buff;
 
@@ -405,13 +470,13 @@ nsTextFragment::Append(const char16_t* aBuffer, uint32_t aLength, bool aUpdateBi
   // The new and the old data is all 1-byte
   char* buff;
   if (mState.mInHeap) {
-    buff = static_cast<char*>(realloc(const_cast<char*>(m1b), length.value()));
+    buff = ReallocText(const_cast<char*>(m1b), mState.mLength, length.value());
     if (!buff) {
       return false;
     }
   }
   else {
-    buff = static_cast<char*>(malloc(length.value()));
+    buff = AllocText<char>(length.value());
     if (!buff) {
       return false;
     }
@@ -433,12 +498,10 @@ nsTextFragment::Append(const char16_t* aBuffer, uint32_t aLength, bool aUpdateBi
 /* virtual */ size_t
 nsTextFragment::SizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf) const
 {
-  if (Is2b()) {
-    return aMallocSizeOf(m2b);
-  }
-
+  // A buffer shared with other fragments or strings is counted by none of
+  // them, as in nsStringBuffer.
   if (mState.mInHeap) {
-    return aMallocSizeOf(m1b);
+    return nsStringBuffer::FromData(m2b)->SizeOfIncludingThisIfUnshared(aMallocSizeOf);
   }
 
   return 0;
@@ -17,6 +17,7 @@
 #include "mozilla/MemoryReporting.h"
 
 #include "nsString.h"
+#include "nsStringBuffer.h"
 #include "nsReadableUtils.h"
 #include "nsISupportsImpl.h"
 
@@ -32,6 +33,11 @@ class nsString;
  * of data represents a single ucs2 character with the high byte being
  * zero.
  *
+ * Text in the heap is kept in a refcounted nsStringBuffer, which copies of
+ * the fragment share, and which 2-byte text also shares with the strings it
+ * is appended to when they are empty. It is copied when a fragment sharing
+ * it is appended to.
+ *
  * This class does not have a virtual destructor therefore it is not
  * meant to be subclassed.
  */
@@ -53,8 +59,8 @@ public:
   ~nsTextFragment();
 
   /**
-   * Change the contents of this fragment to be a copy of the
-   * the argument fragment, or to "" if unable to allocate enough memory.
+   * Change the contents of this fragment to be the same as the argument
+   * fragment's, sharing its buffer rather than copying it.
    */
   nsTextFragment& operator=(const nsTextFragment& aOther);
 
@@ -139,6 +145,12 @@ public:
   bool AppendTo(nsAString& aString,
                 const mozilla::fallible_t& aFallible) const {
     if (mState.mIs2b) {
+      if (aString.IsEmpty() && mState.mInHeap) {
+        // Let the string share our buffer instead of copying it.
+        nsStringBuffer::FromData(m2b)->ToString(mState.mLength, aString);
+        return true;
+      }
+
       bool ok = aString.Append(m2b, mState.mLength, aFallible);
       if (!ok) {
         return false;
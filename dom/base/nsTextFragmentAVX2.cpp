@@ -0,0 +1,59 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// This file should only be compiled if you're on x86 or x86_64, with the
+// flags that enable AVX2.
+
+#include <immintrin.h>
+#include <string.h>
+#include "nscore.h"
+#include "nsTextFragmentImpl.h"
+
+namespace mozilla {
+namespace AVX2 {
+
+int32_t
+FirstNon8Bit(const char16_t *str, const char16_t *end)
+{
+  const uint32_t numUnicharsPerVector = 16;
+  typedef Non8BitParameters<sizeof(size_t)> p;
+  const size_t mask = p::mask();
+  const uint32_t numUnicharsPerWord = p::numUnicharsPerWord();
+  const int32_t len = end - str;
+  int32_t i = 0;
+
+  // Check one YMM register (32 bytes) at a time. Unaligned loads are as fast
+  // as aligned ones on the CPUs that have AVX2.
+  const int32_t vectWalkEnd = (len / numUnicharsPerVector) * numUnicharsPerVector;
+  const __m256i vectmask = _mm256_set1_epi16(static_cast<int16_t>(0xff00));
+  for (; i < vectWalkEnd; i += numUnicharsPerVector) {
+    const __m256i vect =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+    if (!_mm256_testz_si256(vect, vectmask))
+      return i;
+  }
+
+  // Check one word at a time.
+  const int32_t wordWalkEnd = i + ((len - i) / numUnicharsPerWord) * numUnicharsPerWord;
+  for (; i < wordWalkEnd; i += numUnicharsPerWord) {
+    size_t word;
+    memcpy(&word, str + i, sizeof(word));
+    if (word & mask)
+      return i;
+  }
+
+  // Take care of the remainder one character at a time.
+  for (; i < len; i++) {
+    if (str[i] > 255) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+} // namespace AVX2
+} // namespace mozilla
@@ -0,0 +1,45 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// This file should only be compiled if you're on ARM, with the flags that
+// enable NEON.
+
+#include <arm_neon.h>
+#include "nscore.h"
+
+namespace mozilla {
+namespace NEON {
+
+int32_t
+FirstNon8Bit(const char16_t *str, const char16_t *end)
+{
+  const uint32_t numUnicharsPerVector = 8;
+  const int32_t len = end - str;
+  int32_t i = 0;
+
+  // Check one Q register (16 bytes) at a time.
+  const int32_t vectWalkEnd = (len / numUnicharsPerVector) * numUnicharsPerVector;
+  const uint16x8_t vectmask = vdupq_n_u16(0xff00);
+  for (; i < vectWalkEnd; i += numUnicharsPerVector) {
+    const uint16x8_t vect =
+      vandq_u16(vld1q_u16(reinterpret_cast<const uint16_t*>(str + i)), vectmask);
+    const uint16x4_t folded = vorr_u16(vget_low_u16(vect), vget_high_u16(vect));
+    if (vget_lane_u64(vreinterpret_u64_u16(folded), 0))
+      return i;
+  }
+
+  // Take care of the remainder one character at a time.
+  for (; i < len; i++) {
+    if (str[i] > 255) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+} // namespace NEON
+} // namespace mozilla
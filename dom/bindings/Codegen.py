@@ -8888,8 +8888,10 @@ class CGMemberJITInfo(CGThing):
         aliasSet is a JSJitInfo::AliasSet value, without the "JSJitInfo::" bit.
 
         args is None if we don't want to output argTypes for some
-        reason (e.g. we have overloads or we're not a method) and
-        otherwise an iterable of the arguments for this method.
+        reason (e.g. we're not a method or we're effectful) and
+        otherwise a list with, for each argument position, the list of
+        IDL types an argument at that position can have across our
+        overloads.
         """
         assert(not movable or aliasSet != "AliasEverything")  # Can't move write-aliasing things
         assert(not alwaysInSlot or movable)  # Things always in slots had better be movable
@@ -8939,7 +8941,8 @@ class CGMemberJITInfo(CGThing):
             classReservedSlots=INSTANCE_RESERVED_SLOTS + self.descriptor.interface.totalMembersInSlots)
         if args is not None:
             argTypes = "%s_argTypes" % infoName
-            args = [CGMemberJITInfo.getJSArgType(arg.type) for arg in args]
+            args = [CGMemberJITInfo.getArgTypeForPosition(types)
+                    for types in args]
             args.append("JSJitInfo::ArgTypeListEnd")
             argTypesDecl = (
                 "static const JSJitInfo::ArgType %s[] = { %s };\n" %
@@ -9031,23 +9034,20 @@ class CGMemberJITInfo(CGThing):
             # to unwrap, and have a return type that's infallible to wrap up for
             # return.
             sigs = self.member.signatures()
+            # For methods that affect nothing, it's OK to set movable to our
+            # notion of infallible on the C++ side, without considering
+            # argument conversions, since argument conversions that can
+            # reliably throw would be effectful anyway and the jit doesn't
+            # move effectful things.
+            hasInfallibleImpl = "infallible" in self.descriptor.getExtendedAttributes(self.member)
+            movable = self.mayBeMovable() and hasInfallibleImpl
+            eliminatable = self.mayBeEliminatable() and hasInfallibleImpl
             if len(sigs) != 1:
-                # Don't handle overloading.  If there's more than one signature,
-                # one of them must take arguments.
+                # If there's more than one signature, one of them must take
+                # arguments, so unwrapping them can fail.
                 methodInfal = False
-                args = None
-                movable = False
-                eliminatable = False
             else:
                 sig = sigs[0]
-                # For methods that affect nothing, it's OK to set movable to our
-                # notion of infallible on the C++ side, without considering
-                # argument conversions, since argument conversions that can
-                # reliably throw would be effectful anyway and the jit doesn't
-                # move effectful things.
-                hasInfallibleImpl = "infallible" in self.descriptor.getExtendedAttributes(self.member)
-                movable = self.mayBeMovable() and hasInfallibleImpl
-                eliminatable = self.mayBeEliminatable() and hasInfallibleImpl
                 # XXXbz can we move the smarts about fallibility due to arg
                 # conversions into the JIT, using our new args stuff?
                 if (len(sig[1]) != 0 or
@@ -9056,11 +9056,15 @@ class CGMemberJITInfo(CGThing):
                     methodInfal = False
                 else:
                     methodInfal = hasInfallibleImpl
-                # For now, only bother to output args if we're side-effect-free.
-                if self.member.affects == "Nothing":
-                    args = sig[1]
-                else:
-                    args = None
+            # For now, only bother to output args if we're side-effect-free.
+            # With overloads, each position gets the union of the types the
+            # overloads accept there, which is enough for the JIT to tell that
+            # primitive arguments can't run effectful conversions whichever
+            # overload we end up in.
+            if self.member.affects == "Nothing":
+                args = CGMemberJITInfo.getArgTypesByPosition(sigs)
+            else:
+                args = None
 
             aliasSet = self.aliasSet()
             result = self.defineJitInfo(methodinfo, method, "Method",
@@ -9258,6 +9262,32 @@ class CGMemberJITInfo(CGThing):
         # uint32 is sometimes int and sometimes double.
         return "JSJitInfo::Double"
 
+    @staticmethod
+    def getArgTypesByPosition(sigs):
+        """
+        Returns a list with, for each argument position, the list of IDL
+        types the signatures in sigs accept at that position.  A trailing
+        variadic argument covers all the positions after it.
+        """
+        length = max(len(arguments) for retType, arguments in sigs)
+        positions = []
+        for i in range(length):
+            types = []
+            for retType, arguments in sigs:
+                if i < len(arguments):
+                    types.append(arguments[i].type)
+                elif len(arguments) != 0 and arguments[-1].variadic:
+                    types.append(arguments[-1].type)
+            positions.append(types)
+        return positions
+
+    @staticmethod
+    def getArgTypeForPosition(types):
+        argType = reduce(CGMemberJITInfo.getSingleArgType, types, "")
+        if len(types) == 1:
+            return argType
+        return "JSJitInfo::ArgType(%s)" % argType
+
     @staticmethod
     def getSingleArgType(existingType, t):
         type = CGMemberJITInfo.getJSArgType(t)
@@ -69,6 +69,13 @@ Connection::AsyncClone(bool, mozIStorageCompletionCallback*)
   return NS_ERROR_NOT_IMPLEMENTED;
 }
 
+NS_IMETHODIMP
+Connection::EnableReaderPool(uint32_t)
+{
+  // async methods are not supported
+  return NS_ERROR_NOT_IMPLEMENTED;
+}
+
 NS_IMETHODIMP
 Connection::GetDatabaseFile(nsIFile** aFileOut)
 {
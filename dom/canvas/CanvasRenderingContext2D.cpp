@@ -93,6 +93,8 @@
 #include "mozilla/ipc/DocumentRendererParent.h"
 #include "mozilla/ipc/PDocumentRendererParent.h"
 #include "mozilla/layers/PersistentBufferProvider.h"
+#include "mozilla/SharedThreadPool.h"
+#include "mozilla/TaskQueue.h"
 #include "mozilla/MathAlgorithms.h"
 #include "mozilla/Preferences.h"
 #include "mozilla/Telemetry.h"
@@ -565,6 +567,12 @@ public:
   explicit AdjustedTarget(CanvasRenderingContext2D* aCtx,
                           const gfx::Rect *aBounds = nullptr)
   {
+    // Capture draw targets can't draw shadows, and the filter code may need
+    // to snapshot the final target, so draw those into the real target.
+    if (aCtx->NeedToDrawShadow() || aCtx->NeedToApplyFilter()) {
+      aCtx->StopDeferredRecording();
+    }
+
     mTarget = aCtx->mTarget;
 
     // All rects in this function are in the device space of ctx->mTarget.
@@ -1154,6 +1162,8 @@ CanvasRenderingContext2D::Reset()
     gCanvasAzureMemoryUsed -= mWidth * mHeight * 4;
   }
 
+  FinishDeferredRasterization();
+
   bool forceReset = true;
   ReturnTarget(forceReset);
   mTarget = nullptr;
@@ -1327,6 +1337,7 @@ bool CanvasRenderingContext2D::SwitchRenderingMode(RenderingMode aRenderingMode)
     return false;
   }
 
+  FinishDeferredRasterization();
   MOZ_ASSERT(mBufferProvider);
 
 #ifdef USE_SKIA_GPU
@@ -1497,7 +1508,8 @@ CanvasRenderingContext2D::OnStableState()
     return;
   }
 
-  ReturnTarget();
+  bool rasterizeOffMainThread = true;
+  ReturnTarget(/* aForceReset = */ false, rasterizeOffMainThread);
 
   mHasPendingStableStateCallback = false;
 }
@@ -1548,6 +1560,8 @@ CanvasRenderingContext2D::EnsureTarget(const gfx::Rect* aCoveredRect,
     return mRenderingMode;
   }
 
+  FinishDeferredRasterization();
+
   // Check that the dimensions are sane
   if (mWidth > gfxPrefs::MaxCanvasSize() ||
       mHeight > gfxPrefs::MaxCanvasSize() ||
@@ -1586,6 +1600,7 @@ CanvasRenderingContext2D::EnsureTarget(const gfx::Rect* aCoveredRect,
     mTarget = mBufferProvider->BorrowDrawTarget(persistedRect);
 
     if (mTarget && !mBufferProvider->PreservesDrawingState()) {
+      StartDeferredRecording();
       RestoreClipsAndTransformToTarget();
     }
 
@@ -1625,6 +1640,9 @@ CanvasRenderingContext2D::EnsureTarget(const gfx::Rect* aCoveredRect,
     mTarget->ClearRect(canvasRect);
   }
 
+  if (!mBufferProvider->PreservesDrawingState()) {
+    StartDeferredRecording();
+  }
   RestoreClipsAndTransformToTarget();
 
   // Force a full layer transaction since we didn't have a layer before
@@ -1659,6 +1677,8 @@ CanvasRenderingContext2D::SetInitialState()
 void
 CanvasRenderingContext2D::SetErrorState()
 {
+  FinishDeferredRasterization();
+  mDeferredTarget = nullptr;
   EnsureErrorTarget();
 
   if (mTarget && mTarget != sErrorTarget) {
@@ -1880,8 +1900,11 @@ CanvasRenderingContext2D::ClearTarget(bool aRetainBuffer)
 }
 
 void
-CanvasRenderingContext2D::ReturnTarget(bool aForceReset)
+CanvasRenderingContext2D::ReturnTarget(bool aForceReset,
+                                       bool aRasterizeOffMainThread)
 {
+  FinishDeferredRasterization();
+
   if (mTarget && mBufferProvider && mTarget != sErrorTarget) {
     CurrentState().transform = mTarget->GetTransform();
     if (aForceReset || !mBufferProvider->PreservesDrawingState()) {
@@ -1902,10 +1925,95 @@ CanvasRenderingContext2D::ReturnTarget(bool aForceReset)
       mTarget->SetTransform(Matrix());
     }
 
+    if (mDeferredTarget) {
+      if (aRasterizeOffMainThread) {
+        RasterizeDeferredCommandsOffMainThread();
+        return;
+      }
+      StopDeferredRecording();
+    }
+
     mBufferProvider->ReturnDrawTarget(mTarget.forget());
   }
 }
 
+void
+CanvasRenderingContext2D::StartDeferredRecording()
+{
+  MOZ_ASSERT(mTarget && mTarget != sErrorTarget);
+  MOZ_ASSERT(!mDeferredTarget && !mRasterizingTarget);
+
+  // Only software Skia targets can be drawn to from another thread.
+  if (!gfxPrefs::CanvasDeferredRasterization() ||
+      mTarget->GetBackendType() != gfx::BackendType::SKIA ||
+      mTarget->GetType() != DrawTargetType::SOFTWARE_RASTER) {
+    return;
+  }
+
+  RefPtr<DrawTargetCapture> capture =
+    mTarget->CreateCaptureDT(mTarget->GetSize());
+  if (!capture) {
+    return;
+  }
+
+  mDeferredTarget = mTarget.forget();
+  mTarget = capture.forget();
+}
+
+void
+CanvasRenderingContext2D::StopDeferredRecording()
+{
+  if (!mDeferredTarget) {
+    return;
+  }
+
+  // Replaying leaves the real target with the clips and transform that were
+  // recorded, so we can keep drawing into it from here.
+  RefPtr<DrawTargetCapture> capture =
+    static_cast<DrawTargetCapture*>(mTarget.get());
+  mDeferredTarget->DrawCapturedDT(capture, Matrix());
+  mTarget = mDeferredTarget.forget();
+}
+
+void
+CanvasRenderingContext2D::RasterizeDeferredCommandsOffMainThread()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(mDeferredTarget && !mRasterizingTarget);
+
+  if (!mRasterQueue) {
+    mRasterQueue =
+      new TaskQueue(SharedThreadPool::Get(NS_LITERAL_CSTRING("CanvasRaster"), 1));
+  }
+
+  mRasterizingCapture =
+    dont_AddRef(static_cast<DrawTargetCapture*>(mTarget.forget().take()));
+  mRasterizingTarget = mDeferredTarget.forget();
+
+  // Only raw pointers cross threads, see mRasterizingTarget.
+  DrawTarget* target = mRasterizingTarget;
+  DrawTargetCapture* capture = mRasterizingCapture;
+  mRasterQueue->Dispatch(NS_NewRunnableFunction([target, capture] () {
+    target->DrawCapturedDT(capture, Matrix());
+  }));
+}
+
+void
+CanvasRenderingContext2D::FinishDeferredRasterization()
+{
+  if (!mRasterizingTarget) {
+    return;
+  }
+
+  mRasterQueue->AwaitIdle();
+  mRasterizingCapture = nullptr;
+
+  RefPtr<DrawTarget> target = mRasterizingTarget.forget();
+  if (mBufferProvider) {
+    mBufferProvider->ReturnDrawTarget(target.forget());
+  }
+}
+
 NS_IMETHODIMP
 CanvasRenderingContext2D::InitializeWithDrawTarget(nsIDocShell* aShell,
                                                    NotNull<gfx::DrawTarget*> aTarget)
@@ -1917,6 +2025,7 @@ CanvasRenderingContext2D::InitializeWithDrawTarget(nsIDocShell* aShell,
   IntSize size = aTarget->GetSize();
   SetDimensions(size.width, size.height);
 
+  FinishDeferredRasterization();
   mTarget = aTarget;
   mBufferProvider = new PersistentBufferProviderBasic(aTarget);
 
@@ -1993,6 +2102,9 @@ CanvasRenderingContext2D::GetImageBuffer(int32_t* aFormat)
 
   *aFormat = 0;
 
+  FinishDeferredRasterization();
+  StopDeferredRecording();
+
   RefPtr<SourceSurface> snapshot;
   if (mTarget) {
     snapshot = mTarget->Snapshot();
@@ -5537,6 +5649,9 @@ CanvasRenderingContext2D::GetImageDataArray(JSContext* aCx,
   RefPtr<DataSourceSurface> readback;
   DataSourceSurface::MappedSurface rawData;
   if (!srcReadRect.IsEmpty()) {
+    FinishDeferredRasterization();
+    StopDeferredRecording();
+
     RefPtr<SourceSurface> snapshot;
     if (!mTarget && mBufferProvider) {
       snapshot = mBufferProvider->BorrowSnapshot();
@@ -5935,6 +6050,9 @@ CanvasRenderingContext2D::GetCanvasLayer(nsDisplayListBuilder* aBuilder,
   // we have nothing to paint and there is no need to create a surface just
   // to paint nothing. Also, EnsureTarget() can cause creation of a persistent
   // layer manager which must NOT happen during a paint.
+  FinishDeferredRasterization();
+  StopDeferredRecording();
+
   if ((!mBufferProvider && !mTarget) || !IsTargetValid()) {
     // No DidTransactionCallback will be received, so mark the context clean
     // now so future invalidations will be dispatched.
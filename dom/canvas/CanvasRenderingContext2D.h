@@ -33,6 +33,8 @@ class nsGlobalWindow;
 class nsXULElement;
 
 namespace mozilla {
+class TaskQueue;
+
 namespace gl {
 class SourceSurface;
 } // namespace gl
@@ -455,6 +457,7 @@ public:
   already_AddRefed<mozilla::gfx::SourceSurface> GetSurfaceSnapshot(bool* aPremultAlpha = nullptr) override
   {
     EnsureTarget();
+    StopDeferredRecording();
     if (aPremultAlpha) {
       *aPremultAlpha = true;
     }
@@ -682,7 +685,26 @@ protected:
    * Returns the target to the buffer provider. i.e. this will queue a frame for
    * rendering.
    */
-  void ReturnTarget(bool aForceReset = false);
+  void ReturnTarget(bool aForceReset = false,
+                    bool aRasterizeOffMainThread = false);
+
+  /**
+   * Deferred rasterization (gfx.canvas.deferred-rasterization).
+   *
+   * With it, EnsureTarget hands out a capture draw target that records the
+   * drawing commands of the current frame. When the target is returned from
+   * the stable state callback, the commands are replayed into the real target
+   * on a raster thread, which is handed back to the buffer provider once that
+   * is done. Anything that needs the real target's pixels synchronizes first.
+   */
+  void StartDeferredRecording();
+  // Replay the commands recorded so far into the real target, on this thread,
+  // and keep drawing into the real target directly until it is returned.
+  void StopDeferredRecording();
+  void RasterizeDeferredCommandsOffMainThread();
+  // Wait for pending off-main-thread rasterization, and return its target to
+  // the buffer provider. Must be called before using mBufferProvider.
+  void FinishDeferredRasterization();
 
   /**
    * Check if the target is valid after calling EnsureTarget.
@@ -774,6 +796,16 @@ protected:
 
   RefPtr<mozilla::layers::PersistentBufferProvider> mBufferProvider;
 
+  // While recording for deferred rasterization, mTarget is a capture draw
+  // target and this is the target borrowed from mBufferProvider.
+  RefPtr<mozilla::gfx::DrawTarget> mDeferredTarget;
+  // The target and recorded commands being rasterized on mRasterQueue. Moz2D
+  // paths, fonts and draw targets aren't refcounted thread-safely, so these
+  // are only ever released on the main thread.
+  RefPtr<mozilla::gfx::DrawTarget> mRasterizingTarget;
+  RefPtr<mozilla::gfx::DrawTargetCapture> mRasterizingCapture;
+  RefPtr<mozilla::TaskQueue> mRasterQueue;
+
   uint32_t SkiaGLTex() const;
 
   // This observes our draw calls at the beginning of the canvas
@@ -116,7 +116,6 @@ WebGLBuffer::BufferData(GLenum target, size_t size, const void* data, GLenum usa
     const auto& gl = mContext->gl;
     gl->MakeCurrent();
     const ScopedLazyBind lazyBind(gl, target, this);
-    mContext->InvalidateBufferFetching();
 
 #ifdef XP_MACOSX
     // bug 790879
@@ -143,6 +142,7 @@ WebGLBuffer::BufferData(GLenum target, size_t size, const void* data, GLenum usa
         gl->fBufferData(target, size, data, usage);
     }
 
+    const size_t oldByteLength = mByteLength;
     mUsage = usage;
     mByteLength = size;
 
@@ -151,6 +151,12 @@ WebGLBuffer::BufferData(GLenum target, size_t size, const void* data, GLenum usa
         mByteLength = 0;
         mContext->ErrorOutOfMemory("%s: Failed update index buffer cache.", funcName);
     }
+
+    // Buffer fetching only depends on the size of the buffer, so respecifying
+    // a buffer's data with the same size (e.g. for streaming) keeps it valid.
+    if (mByteLength != oldByteLength) {
+        mContext->InvalidateBufferFetchingCaches();
+    }
 }
 
 ////////////////////////////////////////
@@ -119,6 +119,7 @@ WebGLContext::WebGLContext()
     , mBufferFetchingHasPerVertex(false)
     , mMaxFetchedVertices(0)
     , mMaxFetchedInstances(0)
+    , mBufferFetchingGeneration(0)
     , mLayerIsMirror(false)
     , mBypassShaderValidation(false)
     , mContextLossHandler(this)
@@ -200,7 +201,7 @@ WebGLContext::WebGLContext()
 
     mLastUseIndex = 0;
 
-    InvalidateBufferFetching();
+    InvalidateBufferFetchingCaches();
 
     mBackbufferNeedsClear = true;
 
@@ -1054,6 +1054,12 @@ private:
     uint32_t mMaxFetchedInstances;
     bool mBufferFetch_IsAttrib0Active;
 
+    // Bumped whenever vertex attrib state or the size of a buffer changes.
+    // Results of ValidateBufferFetching cached on a vertex array (for the
+    // program that was active then) stay valid while this doesn't change, so
+    // switching programs or vertex arrays doesn't force revalidation.
+    uint64_t mBufferFetchingGeneration;
+
     bool DrawArrays_check(const char* funcName, GLenum mode, GLint first,
                           GLsizei vertCount, GLsizei instanceCount);
     bool DrawElements_check(const char* funcName, GLenum mode, GLsizei vertCount,
@@ -1089,6 +1095,15 @@ protected:
         mMaxFetchedInstances = 0;
     }
 
+    // Unlike InvalidateBufferFetching, which is enough when a different
+    // program or vertex array is bound, this also drops the results cached on
+    // vertex arrays.
+    inline void InvalidateBufferFetchingCaches()
+    {
+        ++mBufferFetchingGeneration;
+        InvalidateBufferFetching();
+    }
+
     CheckedUint32 mGeneration;
 
     WebGLContextOptions mOptions;
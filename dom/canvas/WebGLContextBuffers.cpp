@@ -536,6 +536,7 @@ WebGLContext::DeleteBuffer(WebGLBuffer* buffer)
             fnClearIfBuffer(mBoundVertexArray->mAttribs[i].mBuf);
         }
     }
+    InvalidateBufferFetchingCaches();
 
     ////
 
@@ -809,6 +809,18 @@ WebGLContext::ValidateBufferFetching(const char* info)
     if (mBufferFetchingIsVerified)
         return true;
 
+    WebGLVertexArray* vao = mBoundVertexArray;
+    if (vao->mFetchCheckProgram == mActiveProgramLinkInfo &&
+        vao->mFetchCheckGeneration == mBufferFetchingGeneration)
+    {
+        mBufferFetchingIsVerified = true;
+        mBufferFetchingHasPerVertex = vao->mFetchCheckHasPerVertex;
+        mBufferFetch_IsAttrib0Active = vao->mFetchCheckIsAttrib0Active;
+        mMaxFetchedVertices = vao->mFetchCheckMaxVertices;
+        mMaxFetchedInstances = vao->mFetchCheckMaxInstances;
+        return true;
+    }
+
     bool hasPerVertex = false;
     uint32_t maxVertices = UINT32_MAX;
     uint32_t maxInstances = UINT32_MAX;
@@ -884,6 +896,13 @@ WebGLContext::ValidateBufferFetching(const char* info)
     mMaxFetchedVertices = maxVertices;
     mMaxFetchedInstances = maxInstances;
 
+    vao->mFetchCheckProgram = mActiveProgramLinkInfo;
+    vao->mFetchCheckGeneration = mBufferFetchingGeneration;
+    vao->mFetchCheckHasPerVertex = hasPerVertex;
+    vao->mFetchCheckIsAttrib0Active = mBufferFetch_IsAttrib0Active;
+    vao->mFetchCheckMaxVertices = maxVertices;
+    vao->mFetchCheckMaxInstances = maxInstances;
+
     return true;
 }
 
@@ -294,7 +294,7 @@ WebGLContext::EnableVertexAttribArray(GLuint index)
         return;
 
     MakeContextCurrent();
-    InvalidateBufferFetching();
+    InvalidateBufferFetchingCaches();
 
     gl->fEnableVertexAttribArray(index);
 
@@ -313,7 +313,7 @@ WebGLContext::DisableVertexAttribArray(GLuint index)
         return;
 
     MakeContextCurrent();
-    InvalidateBufferFetching();
+    InvalidateBufferFetchingCaches();
 
     if (index || gl->IsGLES()) {
         gl->fDisableVertexAttribArray(index);
@@ -438,7 +438,7 @@ WebGLContext::VertexAttribPointer(GLuint index, GLint size, GLenum type,
     MOZ_ASSERT(mBoundVertexArray);
     mBoundVertexArray->EnsureAttrib(index);
 
-    InvalidateBufferFetching();
+    InvalidateBufferFetchingCaches();
 
     /* XXX make work with bufferSubData & heterogeneous types
      if (type != mBoundArrayBuffer->GLType())
@@ -470,7 +470,7 @@ WebGLContext::VertexAttribDivisor(GLuint index, GLuint divisor)
     WebGLVertexAttribData& vd = mBoundVertexArray->mAttribs[index];
     vd.mDivisor = divisor;
 
-    InvalidateBufferFetching();
+    InvalidateBufferFetchingCaches();
 
     MakeContextCurrent();
 
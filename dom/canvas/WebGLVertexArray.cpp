@@ -9,6 +9,7 @@
 #include "mozilla/dom/WebGLRenderingContextBinding.h"
 #include "WebGLBuffer.h"
 #include "WebGLContext.h"
+#include "WebGLProgram.h"
 #include "WebGLVertexArrayGL.h"
 #include "WebGLVertexArrayFake.h"
 
@@ -23,10 +24,20 @@ WebGLVertexArray::WrapObject(JSContext* cx, JS::Handle<JSObject*> givenProto)
 WebGLVertexArray::WebGLVertexArray(WebGLContext* webgl)
     : WebGLContextBoundObject(webgl)
     , mGLName(0)
+    , mFetchCheckGeneration(0)
+    , mFetchCheckHasPerVertex(false)
+    , mFetchCheckIsAttrib0Active(false)
+    , mFetchCheckMaxVertices(0)
+    , mFetchCheckMaxInstances(0)
 {
     mContext->mVertexArrays.insertBack(this);
 }
 
+WebGLVertexArray::~WebGLVertexArray()
+{
+    MOZ_ASSERT(IsDeleted());
+}
+
 WebGLVertexArray*
 WebGLVertexArray::Create(WebGLContext* webgl)
 {
@@ -8,6 +8,7 @@
 
 #include "nsTArray.h"
 #include "mozilla/LinkedList.h"
+#include "mozilla/RefPtr.h"
 #include "nsWrapperCache.h"
 
 #include "WebGLBuffer.h"
@@ -18,6 +19,9 @@
 namespace mozilla {
 
 class WebGLVertexArrayFake;
+namespace webgl {
+struct LinkedProgramInfo;
+} // namespace webgl
 
 class WebGLVertexArray
     : public nsWrapperCache
@@ -60,9 +64,7 @@ public:
 protected:
     explicit WebGLVertexArray(WebGLContext* webgl);
 
-    virtual ~WebGLVertexArray() {
-        MOZ_ASSERT(IsDeleted());
-    }
+    virtual ~WebGLVertexArray();
 
     virtual void GenVertexArray() = 0;
     virtual void BindVertexArrayImpl() = 0;
@@ -73,6 +75,17 @@ protected:
     nsTArray<WebGLVertexAttribData> mAttribs;
     WebGLRefPtr<WebGLBuffer> mElementArrayBuffer;
 
+    // The last result of WebGLContext::ValidateBufferFetching with this
+    // vertex array bound. Valid while mFetchCheckProgram is the active
+    // program's link info and mFetchCheckGeneration matches the context's
+    // mBufferFetchingGeneration.
+    RefPtr<const webgl::LinkedProgramInfo> mFetchCheckProgram;
+    uint64_t mFetchCheckGeneration;
+    bool mFetchCheckHasPerVertex;
+    bool mFetchCheckIsAttrib0Active;
+    uint32_t mFetchCheckMaxVertices;
+    uint32_t mFetchCheckMaxInstances;
+
     friend class WebGLContext;
     friend class WebGLVertexArrayFake;
     friend class WebGL2Context;
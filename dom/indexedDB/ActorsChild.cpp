@@ -2485,6 +2485,10 @@ BackgroundRequestChild::Recv__delete__(const RequestResponse& aResponse)
         HandleResponse(aResponse.get_ObjectStorePutResponse().key());
         break;
 
+      case RequestResponse::TObjectStorePutAllResponse:
+        HandleResponse(aResponse.get_ObjectStorePutAllResponse().keys());
+        break;
+
       case RequestResponse::TObjectStoreGetResponse:
         HandleResponse(aResponse.get_ObjectStoreGetResponse().cloneInfo());
         break;
@@ -2592,6 +2596,7 @@ BackgroundCursorChild::BackgroundCursorChild(IDBRequest* aRequest,
   , mIndex(nullptr)
   , mCursor(nullptr)
   , mStrongRequest(aRequest)
+  , mCachedWriteRequestCount(0)
   , mDirection(aDirection)
 {
   MOZ_ASSERT(aObjectStore);
@@ -2615,6 +2620,7 @@ BackgroundCursorChild::BackgroundCursorChild(IDBRequest* aRequest,
   , mIndex(aIndex)
   , mCursor(nullptr)
   , mStrongRequest(aRequest)
+  , mCachedWriteRequestCount(0)
   , mDirection(aDirection)
 {
   MOZ_ASSERT(aIndex);
@@ -2645,7 +2651,8 @@ BackgroundCursorChild::AssertIsOnOwningThread() const
 #endif // DEBUG
 
 void
-BackgroundCursorChild::SendContinueInternal(const CursorRequestParams& aParams)
+BackgroundCursorChild::SendContinueInternal(const CursorRequestParams& aParams,
+                                            const Key& aCurrentKey)
 {
   AssertIsOnOwningThread();
   MOZ_ASSERT(mRequest);
@@ -2662,7 +2669,68 @@ BackgroundCursorChild::SendContinueInternal(const CursorRequestParams& aParams)
 
   mTransaction->OnNewRequest();
 
-  MOZ_ALWAYS_TRUE(PBackgroundIDBCursorChild::SendContinue(aParams));
+  if (!mCachedResponses.empty()) {
+    // Only continue() without a key and advance() can be answered from the
+    // prefetched records, and only if nothing was written since they were
+    // read.
+    uint32_t skipCount = 0;
+    switch (aParams.type()) {
+      case CursorRequestParams::TContinueParams:
+        if (aParams.get_ContinueParams().key().IsUnset()) {
+          skipCount = 1;
+        }
+        break;
+
+      case CursorRequestParams::TAdvanceParams:
+        skipCount = aParams.get_AdvanceParams().count();
+        break;
+
+      default:
+        break;
+    }
+
+    if (skipCount &&
+        skipCount <= mCachedResponses.size() &&
+        mCachedWriteRequestCount == mTransaction->WriteRequestCount()) {
+      mCachedResponses.erase(mCachedResponses.begin(),
+                             mCachedResponses.begin() + (skipCount - 1));
+
+      nsCOMPtr<nsIRunnable> continueRunnable = new DelayedActionRunnable(
+        this, &BackgroundCursorChild::CompleteContinueRequestFromCache);
+      MOZ_ALWAYS_SUCCEEDS(NS_DispatchToCurrentThread(continueRunnable));
+      return;
+    }
+
+    mCachedResponses.clear();
+  }
+
+  mCachedWriteRequestCount = mTransaction->WriteRequestCount();
+
+  MOZ_ALWAYS_TRUE(PBackgroundIDBCursorChild::SendContinue(aParams,
+                                                          aCurrentKey));
+}
+
+void
+BackgroundCursorChild::CompleteContinueRequestFromCache()
+{
+  AssertIsOnOwningThread();
+  MOZ_ASSERT(mRequest);
+  MOZ_ASSERT(mTransaction);
+  MOZ_ASSERT(mCursor);
+  MOZ_ASSERT(mStrongCursor);
+  MOZ_ASSERT(!mCachedResponses.empty());
+
+  RefPtr<IDBCursor> cursor;
+  mStrongCursor.swap(cursor);
+
+  CachedResponse& item = mCachedResponses.front();
+  mCursor->Reset(Move(item.mKey), Move(item.mCloneInfo));
+  mCachedResponses.pop_front();
+
+  ResultHelper helper(mRequest, mTransaction, mCursor);
+  DispatchSuccessEvent(&helper);
+
+  mTransaction->OnRequestFinished(/* aActorDestroyedNormally */ true);
 }
 
 void
@@ -2676,6 +2744,7 @@ BackgroundCursorChild::SendDeleteMeInternal()
   mTransaction = nullptr;
   mObjectStore = nullptr;
   mIndex = nullptr;
+  mCachedResponses.clear();
 
   if (mCursor) {
     mCursor->ClearBackgroundActor();
@@ -2733,12 +2802,15 @@ BackgroundCursorChild::HandleResponse(
   MOZ_ASSERT(!mStrongRequest);
   MOZ_ASSERT(!mStrongCursor);
 
-  MOZ_ASSERT(aResponses.Length() == 1);
+  MOZ_ASSERT(!aResponses.IsEmpty());
+  MOZ_ASSERT(mCachedResponses.empty());
 
   // XXX Fix this somehow...
   auto& responses =
     const_cast<nsTArray<ObjectStoreCursorResponse>&>(aResponses);
 
+  RefPtr<IDBCursor> newCursor;
+
   for (ObjectStoreCursorResponse& response : responses) {
     StructuredCloneReadInfo cloneReadInfo(Move(response.cloneInfo()));
     cloneReadInfo.mDatabase = mTransaction->Database();
@@ -2747,9 +2819,12 @@ BackgroundCursorChild::HandleResponse(
                          response.cloneInfo(),
                          cloneReadInfo.mFiles);
 
-    RefPtr<IDBCursor> newCursor;
-
-    if (mCursor) {
+    // The first record is the result of this request, the rest were
+    // prefetched for the following continue() calls.
+    if (&response != &responses[0]) {
+      mCachedResponses.emplace_back(Move(response.key()),
+                                    Move(cloneReadInfo));
+    } else if (mCursor) {
       mCursor->Reset(Move(response.key()), Move(cloneReadInfo));
     } else {
       newCursor = IDBCursor::Create(this,
@@ -2875,6 +2950,8 @@ BackgroundCursorChild::ActorDestroy(ActorDestroyReason aWhy)
                                     aWhy == Deletion);
   }
 
+  mCachedResponses.clear();
+
   if (mCursor) {
     mCursor->ClearBackgroundActor();
 #ifdef DEBUG
@@ -10,6 +10,9 @@
 #include "IDBTransaction.h"
 #include "js/RootingAPI.h"
 #include "mozilla/Attributes.h"
+#include "mozilla/Move.h"
+#include "mozilla/dom/IndexedDatabase.h"
+#include "mozilla/dom/indexedDB/Key.h"
 #include "mozilla/dom/filehandle/ActorsChild.h"
 #include "mozilla/dom/indexedDB/PBackgroundIDBCursorChild.h"
 #include "mozilla/dom/indexedDB/PBackgroundIDBDatabaseChild.h"
@@ -25,6 +28,8 @@
 #include "nsCOMPtr.h"
 #include "nsTArray.h"
 
+#include <deque>
+
 class nsIEventTarget;
 struct nsID;
 struct PRThread;
@@ -688,6 +693,17 @@ class BackgroundCursorChild final
 
   class DelayedActionRunnable;
 
+  struct CachedResponse
+  {
+    Key mKey;
+    StructuredCloneReadInfo mCloneInfo;
+
+    CachedResponse(Key&& aKey, StructuredCloneReadInfo&& aCloneInfo)
+      : mKey(Move(aKey))
+      , mCloneInfo(Move(aCloneInfo))
+    { }
+  };
+
   IDBRequest* mRequest;
   IDBTransaction* mTransaction;
   IDBObjectStore* mObjectStore;
@@ -698,6 +714,13 @@ class BackgroundCursorChild final
   RefPtr<IDBRequest> mStrongRequest;
   RefPtr<IDBCursor> mStrongCursor;
 
+  // Records the parent prefetched after the one the cursor is positioned on,
+  // in cursor order. They are dropped as soon as the transaction issues a
+  // write, i.e. when mTransaction->WriteRequestCount() no longer matches
+  // mCachedWriteRequestCount.
+  std::deque<CachedResponse> mCachedResponses;
+  uint32_t mCachedWriteRequestCount;
+
   Direction mDirection;
 
 #ifdef DEBUG
@@ -722,7 +745,8 @@ public:
 #endif
 
   void
-  SendContinueInternal(const CursorRequestParams& aParams);
+  SendContinueInternal(const CursorRequestParams& aParams,
+                       const Key& aCurrentKey);
 
   void
   SendDeleteMeInternal();
@@ -764,6 +788,9 @@ private:
   // BackgroundVersionChangeTransactionChild.
   ~BackgroundCursorChild();
 
+  void
+  CompleteContinueRequestFromCache();
+
   void
   HandleResponse(nsresult aResponse);
 
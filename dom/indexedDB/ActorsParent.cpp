@@ -26,6 +26,8 @@
 #include "mozilla/Maybe.h"
 #include "mozilla/Preferences.h"
 #include "mozilla/Services.h"
+#include "mozilla/SnappyCompressOutputStream.h"
+#include "mozilla/SnappyUncompressInputStream.h"
 #include "mozilla/StaticPtr.h"
 #include "mozilla/storage.h"
 #include "mozilla/Unused.h"
@@ -89,6 +91,7 @@
 #include "nsQueryObject.h"
 #include "nsRefPtrHashtable.h"
 #include "nsString.h"
+#include "nsStringStream.h"
 #include "nsThreadPool.h"
 #include "nsThreadUtils.h"
 #include "nsXPCOMCID.h"
@@ -153,7 +156,7 @@ static_assert(JS_STRUCTURED_CLONE_VERSION == 7,
               "Need to update the major schema version.");
 
 // Major schema version. Bump for almost everything.
-const uint32_t kMajorSchemaVersion = 24;
+const uint32_t kMajorSchemaVersion = 25;
 
 // Minor schema version. Should almost always be 0 (maybe bump on release
 // branches if we have to).
@@ -226,6 +229,15 @@ const uint32_t kConnectionThreadIdleMS = 30 * 1000; // 30 seconds
 
 #define SAVEPOINT_CLAUSE "SAVEPOINT sp;"
 
+// The number of extra records an object store cursor reads ahead on continue().
+// It starts at the minimum, doubles every time the child used up the previous
+// batch and halves every time the child had to throw records away.
+const uint32_t kCursorMinPrefetchCount = 4;
+const uint32_t kCursorMaxPrefetchCount = 256;
+
+// Stop reading ahead once the prefetched values take this many bytes.
+const size_t kCursorMaxPrefetchBytes = 1024 * 1024;
+
 const uint32_t kFileCopyBufferSize = 32768;
 
 #define JOURNAL_DIRECTORY_NAME "journals"
@@ -4114,6 +4126,19 @@ UpgradeSchemaFrom23_0To24_0(mozIStorageConnection* aConnection)
   return NS_OK;
 }
 
+nsresult
+UpgradeSchemaFrom24_0To25_0(mozIStorageConnection* aConnection)
+{
+  // The only change between 24 and 25 was that large values may be stored in
+  // files, with the file id in the data column, but it's backwards-compatible.
+  nsresult rv = aConnection->SetSchemaVersion(MakeSchemaVersion(25, 0));
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    return rv;
+  }
+
+  return NS_OK;
+}
+
 nsresult
 GetDatabaseFileURL(nsIFile* aDatabaseFile,
                    PersistenceType aPersistenceType,
@@ -4666,6 +4691,8 @@ CreateStorageConnection(nsIFile* aDBFile,
           rv = UpgradeSchemaFrom22_0To23_0(connection, aOrigin);
         } else if (schemaVersion == MakeSchemaVersion(23, 0)) {
           rv = UpgradeSchemaFrom23_0To24_0(connection);
+        } else if (schemaVersion == MakeSchemaVersion(24, 0)) {
+          rv = UpgradeSchemaFrom24_0To25_0(connection);
         } else {
           IDB_WARNING("Unable to open IndexedDB database, no upgrade path is "
                       "available!");
@@ -5993,6 +6020,18 @@ private:
                                      FileManager* aFileManager,
                                      StructuredCloneReadInfo* aInfo);
 
+  static nsresult
+  GetStructuredCloneReadInfoFromExternalBlob(int64_t aDataFileId,
+                                             const nsAString& aFileIds,
+                                             FileManager* aFileManager,
+                                             StructuredCloneReadInfo* aInfo);
+
+  static nsresult
+  GetStructuredCloneFilesFromFileIds(const nsAString& aFileIds,
+                                     FileManager* aFileManager,
+                                     StructuredCloneReadInfo* aInfo,
+                                     int64_t* aDataFileId);
+
   // Not to be overridden by subclasses.
   NS_DECL_MOZISTORAGEPROGRESSHANDLER
 };
@@ -8115,23 +8154,24 @@ class ObjectStoreAddOrPutRequestOp final
   typedef mozilla::dom::quota::PersistenceType PersistenceType;
 
   struct StoredFileInfo;
+  struct Record;
 
-  const ObjectStoreAddPutParams mParams;
+  // A single record for add() and put(), one per value for putAll().
+  nsTArray<UniquePtr<Record>> mRecords;
+  int64_t mObjectStoreId;
   Maybe<UniqueIndexTable> mUniqueIndexTable;
 
   // This must be non-const so that we can update the mNextAutoIncrementId field
   // if we are modifying an autoIncrement objectStore.
   RefPtr<FullObjectStoreMetadata> mMetadata;
 
-  FallibleTArray<StoredFileInfo> mStoredFileInfos;
-
   RefPtr<FileManager> mFileManager;
 
-  Key mResponse;
   const nsCString mGroup;
   const nsCString mOrigin;
   const PersistenceType mPersistenceType;
   const bool mOverwrite;
+  const bool mPutAll;
   bool mObjectStoreMayHaveIndexes;
 
 private:
@@ -8142,12 +8182,32 @@ private:
   ~ObjectStoreAddOrPutRequestOp()
   { }
 
+  bool
+  InitRecord(TransactionBase* aTransaction, Record& aRecord);
+
   nsresult
-  RemoveOldIndexDataValues(DatabaseConnection* aConnection);
+  RemoveOldIndexDataValues(DatabaseConnection* aConnection, const Key& aKey);
 
   nsresult
   CopyFileData(nsIInputStream* aInputStream, nsIOutputStream* aOutputStream);
 
+  nsresult
+  StoreDataInFile(const nsCString& aData,
+                  int64_t aId,
+                  nsIFile* aFileDirectory,
+                  nsIFile* aJournalDirectory);
+
+  void
+  RemoveFailedFile(nsIFile* aDiskFile, nsIFile* aJournalFile);
+
+  nsresult
+  StoreRecord(DatabaseConnection* aConnection,
+              Record& aRecord,
+              bool aObjectStoreHasIndexes,
+              nsIFile* aFileDirectory,
+              nsIFile* aJournalDirectory,
+              int64_t& aNextAutoIncrementId);
+
   virtual bool
   Init(TransactionBase* aTransaction) override;
 
@@ -8186,6 +8246,22 @@ struct ObjectStoreAddOrPutRequestOp::StoredFileInfo final
   }
 };
 
+struct ObjectStoreAddOrPutRequestOp::Record final
+{
+  ObjectStoreAddPutParams mParams;
+  FallibleTArray<StoredFileInfo> mStoredFileInfos;
+
+  // Only set if the value is stored in a file rather than in the database.
+  RefPtr<FileInfo> mDataFileInfo;
+
+  // The key the value was stored with.
+  Key mKey;
+
+  explicit Record(const ObjectStoreAddPutParams& aParams)
+    : mParams(aParams)
+  { }
+};
+
 class ObjectStoreGetRequestOp final
   : public NormalTransactionOp
 {
@@ -8471,6 +8547,9 @@ private:
 
   CursorOpBase* mCurrentlyRunningOp;
 
+  // Only touched on the connection thread.
+  uint32_t mPrefetchCount;
+
   const Type mType;
   const Direction mDirection;
 
@@ -8519,7 +8598,8 @@ private:
   RecvDeleteMe() override;
 
   virtual bool
-  RecvContinue(const CursorRequestParams& aParams) override;
+  RecvContinue(const CursorRequestParams& aParams,
+               const Key& aCurrentKey) override;
 
   bool
   IsLocaleAware() const {
@@ -8615,12 +8695,18 @@ class Cursor::ContinueOp final
 
   const CursorRequestParams mParams;
 
+  // The key of the record the child cursor is positioned on, which is behind
+  // mCursor->mKey if the child did not use all the prefetched records.
+  const Key mCurrentKey;
+
 private:
   // Only created by Cursor.
   ContinueOp(Cursor* aCursor,
-             const CursorRequestParams& aParams)
+             const CursorRequestParams& aParams,
+             const Key& aCurrentKey)
     : CursorOpBase(aCursor)
     , mParams(aParams)
+    , mCurrentKey(aCurrentKey)
   {
     MOZ_ASSERT(aParams.type() != CursorRequestParams::T__None);
   }
@@ -9497,9 +9583,13 @@ TokenizerIgnoreNothing(char16_t /* aChar */)
   return false;
 }
 
+// The file holding a value that is stored outside the database is listed
+// with a '.' prefix. Its id is returned in aDataFileId if the caller passes
+// one, and in aResult with the other files otherwise.
 nsresult
 ConvertFileIdsToArray(const nsAString& aFileIds,
-                      nsTArray<int64_t>& aResult)
+                      nsTArray<int64_t>& aResult,
+                      int64_t* aDataFileId = nullptr)
 {
   nsCharSeparatedTokenizerTemplate<TokenizerIgnoreNothing>
     tokenizer(aFileIds, ' ');
@@ -9511,12 +9601,21 @@ ConvertFileIdsToArray(const nsAString& aFileIds,
     token = tokenizer.nextToken();
     MOZ_ASSERT(!token.IsEmpty());
 
+    const bool isDataFile = token.First() == '.';
+    if (isDataFile) {
+      token.Cut(0, 1);
+    }
+
     int32_t id = token.ToInteger(&rv);
     if (NS_WARN_IF(NS_FAILED(rv))) {
       return rv;
     }
 
-    aResult.AppendElement(id);
+    if (isDataFile && aDataFileId) {
+      *aDataFileId = id;
+    } else {
+      aResult.AppendElement(id);
+    }
   }
 
   return NS_OK;
@@ -14551,6 +14650,28 @@ TransactionBase::VerifyRequestParams(const RequestParams& aParams) const
       break;
     }
 
+    case RequestParams::TObjectStorePutAllParams: {
+      const ObjectStorePutAllParams& params =
+        aParams.get_ObjectStorePutAllParams();
+      const nsTArray<ObjectStoreAddPutParams>& records = params.records();
+      if (NS_WARN_IF(records.IsEmpty())) {
+        ASSERT_UNLESS_FUZZING();
+        return false;
+      }
+      for (uint32_t index = 0; index < records.Length(); index++) {
+        if (NS_WARN_IF(records[index].objectStoreId() !=
+                         params.objectStoreId())) {
+          ASSERT_UNLESS_FUZZING();
+          return false;
+        }
+        if (NS_WARN_IF(!VerifyRequestParams(records[index]))) {
+          ASSERT_UNLESS_FUZZING();
+          return false;
+        }
+      }
+      break;
+    }
+
     case RequestParams::TObjectStoreGetParams: {
       const ObjectStoreGetParams& params = aParams.get_ObjectStoreGetParams();
       const RefPtr<FullObjectStoreMetadata> objectStoreMetadata =
@@ -15031,6 +15152,7 @@ TransactionBase::AllocRequest(const RequestParams& aParams, bool aTrustParams)
   switch (aParams.type()) {
     case RequestParams::TObjectStoreAddParams:
     case RequestParams::TObjectStorePutParams:
+    case RequestParams::TObjectStorePutAllParams:
       actor = new ObjectStoreAddOrPutRequestOp(this, aParams);
       break;
 
@@ -16111,6 +16233,7 @@ Cursor::Cursor(TransactionBase* aTransaction,
   , mObjectStoreId(aObjectStoreMetadata->mCommonMetadata.id())
   , mIndexId(aIndexMetadata ? aIndexMetadata->mCommonMetadata.id() : 0)
   , mCurrentlyRunningOp(nullptr)
+  , mPrefetchCount(kCursorMinPrefetchCount)
   , mType(aType)
   , mDirection(aDirection)
   , mUniqueIndex(aIndexMetadata ?
@@ -16407,7 +16530,8 @@ Cursor::RecvDeleteMe()
 }
 
 bool
-Cursor::RecvContinue(const CursorRequestParams& aParams)
+Cursor::RecvContinue(const CursorRequestParams& aParams,
+                     const Key& aCurrentKey)
 {
   AssertIsOnBackgroundThread();
   MOZ_ASSERT(aParams.type() != CursorRequestParams::T__None);
@@ -16441,7 +16565,7 @@ Cursor::RecvContinue(const CursorRequestParams& aParams)
     return false;
   }
 
-  RefPtr<ContinueOp> continueOp = new ContinueOp(this, aParams);
+  RefPtr<ContinueOp> continueOp = new ContinueOp(this, aParams, aCurrentKey);
   if (NS_WARN_IF(!continueOp->Init(mTransaction))) {
     continueOp->Cleanup();
     return false;
@@ -18983,21 +19107,15 @@ DatabaseOperationBase::GetStructuredCloneReadInfoFromSource(
   MOZ_ASSERT(aFileManager);
   MOZ_ASSERT(aInfo);
 
-#ifdef DEBUG
-  {
-    int32_t columnType;
-    MOZ_ASSERT(NS_SUCCEEDED(aSource->GetTypeOfIndex(aDataIndex, &columnType)));
-    MOZ_ASSERT(columnType == mozIStorageStatement::VALUE_TYPE_BLOB);
-  }
-#endif
-
-  const uint8_t* blobData;
-  uint32_t blobDataLength;
-  nsresult rv = aSource->GetSharedBlob(aDataIndex, &blobDataLength, &blobData);
+  int32_t columnType;
+  nsresult rv = aSource->GetTypeOfIndex(aDataIndex, &columnType);
   if (NS_WARN_IF(NS_FAILED(rv))) {
     return rv;
   }
 
+  MOZ_ASSERT(columnType == mozIStorageStatement::VALUE_TYPE_BLOB ||
+             columnType == mozIStorageStatement::VALUE_TYPE_INTEGER);
+
   bool isNull;
   rv = aSource->GetIsNull(aFileIdsIndex, &isNull);
   if (NS_WARN_IF(NS_FAILED(rv))) {
@@ -19015,6 +19133,32 @@ DatabaseOperationBase::GetStructuredCloneReadInfoFromSource(
     }
   }
 
+  // Large values are stored in a file and the data column holds its id.
+  if (columnType == mozIStorageStatement::VALUE_TYPE_INTEGER) {
+    int64_t dataFileId;
+    rv = aSource->GetInt64(aDataIndex, &dataFileId);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      return rv;
+    }
+
+    rv = GetStructuredCloneReadInfoFromExternalBlob(dataFileId,
+                                                    fileIds,
+                                                    aFileManager,
+                                                    aInfo);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      return rv;
+    }
+
+    return NS_OK;
+  }
+
+  const uint8_t* blobData;
+  uint32_t blobDataLength;
+  rv = aSource->GetSharedBlob(aDataIndex, &blobDataLength, &blobData);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    return rv;
+  }
+
   rv = GetStructuredCloneReadInfoFromBlob(blobData,
                                           blobDataLength,
                                           fileIds,
@@ -19069,29 +19213,135 @@ DatabaseOperationBase::GetStructuredCloneReadInfoFromBlob(
     return NS_ERROR_OUT_OF_MEMORY;
   }
 
-  if (!aFileIds.IsVoid()) {
-    AutoTArray<int64_t, 10> array;
-    nsresult rv = ConvertFileIdsToArray(aFileIds, array);
+  int64_t dataFileId = 0;
+  nsresult rv = GetStructuredCloneFilesFromFileIds(aFileIds,
+                                                   aFileManager,
+                                                   aInfo,
+                                                   &dataFileId);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    return rv;
+  }
+
+  MOZ_ASSERT(!dataFileId);
+
+  return NS_OK;
+}
+
+// static
+nsresult
+DatabaseOperationBase::GetStructuredCloneReadInfoFromExternalBlob(
+                                                 int64_t aDataFileId,
+                                                 const nsAString& aFileIds,
+                                                 FileManager* aFileManager,
+                                                 StructuredCloneReadInfo* aInfo)
+{
+  MOZ_ASSERT(!IsOnBackgroundThread());
+  MOZ_ASSERT(aFileManager);
+  MOZ_ASSERT(aInfo);
+
+  PROFILER_LABEL("IndexedDB",
+                 "DatabaseOperationBase::"
+                 "GetStructuredCloneReadInfoFromExternalBlob",
+                 js::ProfileEntry::Category::STORAGE);
+
+  int64_t dataFileId = 0;
+  nsresult rv = GetStructuredCloneFilesFromFileIds(aFileIds,
+                                                   aFileManager,
+                                                   aInfo,
+                                                   &dataFileId);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    return rv;
+  }
+
+  if (NS_WARN_IF(aDataFileId <= 0 || dataFileId != aDataFileId)) {
+    return NS_ERROR_FILE_CORRUPTED;
+  }
+
+  nsCOMPtr<nsIFile> directory = aFileManager->GetDirectory();
+  if (NS_WARN_IF(!directory)) {
+    IDB_REPORT_INTERNAL_ERR();
+    return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+  }
+
+  nsCOMPtr<nsIFile> file = aFileManager->GetFileForId(directory, aDataFileId);
+  if (NS_WARN_IF(!file)) {
+    IDB_REPORT_INTERNAL_ERR();
+    return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+  }
+
+  RefPtr<FileInputStream> fileInputStream =
+    FileInputStream::Create(aFileManager->Type(),
+                            aFileManager->Group(),
+                            aFileManager->Origin(),
+                            file);
+  if (NS_WARN_IF(!fileInputStream)) {
+    return NS_ERROR_FILE_CORRUPTED;
+  }
+
+  // The file is read and uncompressed a buffer at a time rather than all at
+  // once.
+  RefPtr<SnappyUncompressInputStream> snappyInputStream =
+    new SnappyUncompressInputStream(fileInputStream);
+
+  char buffer[kFileCopyBufferSize];
+
+  while (true) {
+    uint32_t numRead;
+    rv = snappyInputStream->Read(buffer, sizeof(buffer), &numRead);
     if (NS_WARN_IF(NS_FAILED(rv))) {
       return rv;
     }
 
-    for (uint32_t count = array.Length(), index = 0; index < count; index++) {
-      int64_t id = array[index];
-      MOZ_ASSERT(id != 0);
-
-      RefPtr<FileInfo> fileInfo = aFileManager->GetFileInfo(Abs(id));
-      MOZ_ASSERT(fileInfo);
+    if (!numRead) {
+      break;
+    }
 
-      StructuredCloneFile* file = aInfo->mFiles.AppendElement();
-      file->mFileInfo.swap(fileInfo);
-      file->mMutable = id < 0;
+    if (NS_WARN_IF(!aInfo->mData.WriteBytes(buffer, numRead))) {
+      return NS_ERROR_OUT_OF_MEMORY;
     }
   }
 
   return NS_OK;
 }
 
+// static
+nsresult
+DatabaseOperationBase::GetStructuredCloneFilesFromFileIds(
+                                                 const nsAString& aFileIds,
+                                                 FileManager* aFileManager,
+                                                 StructuredCloneReadInfo* aInfo,
+                                                 int64_t* aDataFileId)
+{
+  MOZ_ASSERT(!IsOnBackgroundThread());
+  MOZ_ASSERT(aFileManager);
+  MOZ_ASSERT(aInfo);
+  MOZ_ASSERT(aDataFileId);
+
+  if (aFileIds.IsVoid()) {
+    return NS_OK;
+  }
+
+  AutoTArray<int64_t, 10> array;
+  nsresult rv = ConvertFileIdsToArray(aFileIds, array, aDataFileId);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    return rv;
+  }
+
+  for (uint32_t count = array.Length(), index = 0; index < count; index++) {
+    int64_t id = array[index];
+    MOZ_ASSERT(id != 0);
+
+    RefPtr<FileInfo> fileInfo = aFileManager->GetFileInfo(Abs(id));
+    MOZ_ASSERT(fileInfo);
+
+    StructuredCloneFile* file = aInfo->mFiles.AppendElement();
+    file->mFileInfo.swap(fileInfo);
+    file->mMutable = id < 0;
+  }
+
+  return NS_OK;
+}
+
 // static
 nsresult
 DatabaseOperationBase::BindKeyRangeToStatement(
@@ -25102,20 +25352,48 @@ ObjectStoreAddOrPutRequestOp::ObjectStoreAddOrPutRequestOp(
                                                   TransactionBase* aTransaction,
                                                   const RequestParams& aParams)
   : NormalTransactionOp(aTransaction)
-  , mParams(aParams.type() == RequestParams::TObjectStoreAddParams ?
-              aParams.get_ObjectStoreAddParams().commonParams() :
-              aParams.get_ObjectStorePutParams().commonParams())
+  , mObjectStoreId(0)
   , mGroup(aTransaction->GetDatabase()->Group())
   , mOrigin(aTransaction->GetDatabase()->Origin())
   , mPersistenceType(aTransaction->GetDatabase()->Type())
-  , mOverwrite(aParams.type() == RequestParams::TObjectStorePutParams)
+  , mOverwrite(aParams.type() != RequestParams::TObjectStoreAddParams)
+  , mPutAll(aParams.type() == RequestParams::TObjectStorePutAllParams)
   , mObjectStoreMayHaveIndexes(false)
 {
   MOZ_ASSERT(aParams.type() == RequestParams::TObjectStoreAddParams ||
-             aParams.type() == RequestParams::TObjectStorePutParams);
+             aParams.type() == RequestParams::TObjectStorePutParams ||
+             aParams.type() == RequestParams::TObjectStorePutAllParams);
 
-  mMetadata =
-    aTransaction->GetMetadataForObjectStoreId(mParams.objectStoreId());
+  switch (aParams.type()) {
+    case RequestParams::TObjectStoreAddParams:
+      mRecords.AppendElement(
+        MakeUnique<Record>(aParams.get_ObjectStoreAddParams().commonParams()));
+      mObjectStoreId = mRecords[0]->mParams.objectStoreId();
+      break;
+
+    case RequestParams::TObjectStorePutParams:
+      mRecords.AppendElement(
+        MakeUnique<Record>(aParams.get_ObjectStorePutParams().commonParams()));
+      mObjectStoreId = mRecords[0]->mParams.objectStoreId();
+      break;
+
+    case RequestParams::TObjectStorePutAllParams: {
+      const ObjectStorePutAllParams& params =
+        aParams.get_ObjectStorePutAllParams();
+      const nsTArray<ObjectStoreAddPutParams>& records = params.records();
+      mObjectStoreId = params.objectStoreId();
+      mRecords.SetCapacity(records.Length());
+      for (uint32_t index = 0; index < records.Length(); index++) {
+        mRecords.AppendElement(MakeUnique<Record>(records[index]));
+      }
+      break;
+    }
+
+    default:
+      MOZ_CRASH("Should never get here!");
+  }
+
+  mMetadata = aTransaction->GetMetadataForObjectStoreId(mObjectStoreId);
   MOZ_ASSERT(mMetadata);
 
   mObjectStoreMayHaveIndexes = mMetadata->HasLiveIndexes();
@@ -25123,19 +25401,20 @@ ObjectStoreAddOrPutRequestOp::ObjectStoreAddOrPutRequestOp(
 
 nsresult
 ObjectStoreAddOrPutRequestOp::RemoveOldIndexDataValues(
-                                                DatabaseConnection* aConnection)
+                                                DatabaseConnection* aConnection,
+                                                const Key& aKey)
 {
   AssertIsOnConnectionThread();
   MOZ_ASSERT(aConnection);
   MOZ_ASSERT(mOverwrite);
-  MOZ_ASSERT(!mResponse.IsUnset());
+  MOZ_ASSERT(!aKey.IsUnset());
 
 #ifdef DEBUG
   {
     bool hasIndexes = false;
     MOZ_ASSERT(NS_SUCCEEDED(
       DatabaseOperationBase::ObjectStoreHasIndexes(aConnection,
-                                                   mParams.objectStoreId(),
+                                                   mObjectStoreId,
                                                    &hasIndexes)));
     MOZ_ASSERT(hasIndexes,
                "Don't use this slow method if there are no indexes!");
@@ -25154,12 +25433,12 @@ ObjectStoreAddOrPutRequestOp::RemoveOldIndexDataValues(
   }
 
   rv = indexValuesStmt->BindInt64ByName(NS_LITERAL_CSTRING("object_store_id"),
-                                        mParams.objectStoreId());
+                                        mObjectStoreId);
   if (NS_WARN_IF(NS_FAILED(rv))) {
     return rv;
   }
 
-  rv = mResponse.BindToStatement(indexValuesStmt, NS_LITERAL_CSTRING("key"));
+  rv = aKey.BindToStatement(indexValuesStmt, NS_LITERAL_CSTRING("key"));
   if (NS_WARN_IF(NS_FAILED(rv))) {
     return rv;
   }
@@ -25179,7 +25458,7 @@ ObjectStoreAddOrPutRequestOp::RemoveOldIndexDataValues(
       return rv;
     }
 
-    rv = DeleteIndexDataTableRows(aConnection, mResponse, existingIndexValues);
+    rv = DeleteIndexDataTableRows(aConnection, aKey, existingIndexValues);
     if (NS_WARN_IF(NS_FAILED(rv))) {
       return rv;
     }
@@ -25245,18 +25524,160 @@ ObjectStoreAddOrPutRequestOp::CopyFileData(nsIInputStream* aInputStream,
   return rv;
 }
 
+nsresult
+ObjectStoreAddOrPutRequestOp::StoreDataInFile(const nsCString& aData,
+                                              int64_t aId,
+                                              nsIFile* aFileDirectory,
+                                              nsIFile* aJournalDirectory)
+{
+  AssertIsOnConnectionThread();
+  MOZ_ASSERT(mFileManager);
+  MOZ_ASSERT(aId > 0);
+  MOZ_ASSERT(aFileDirectory);
+  MOZ_ASSERT(aJournalDirectory);
+
+  PROFILER_LABEL("IndexedDB",
+                 "ObjectStoreAddOrPutRequestOp::StoreDataInFile",
+                 js::ProfileEntry::Category::STORAGE);
+
+  nsCOMPtr<nsIFile> diskFile = mFileManager->GetFileForId(aFileDirectory, aId);
+  if (NS_WARN_IF(!diskFile)) {
+    IDB_REPORT_INTERNAL_ERR();
+    return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+  }
+
+  // Create a journal file first.
+  nsCOMPtr<nsIFile> journalFile =
+    mFileManager->GetFileForId(aJournalDirectory, aId);
+  if (NS_WARN_IF(!journalFile)) {
+    IDB_REPORT_INTERNAL_ERR();
+    return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+  }
+
+  nsresult rv = journalFile->Create(nsIFile::NORMAL_FILE_TYPE, 0644);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    IDB_REPORT_INTERNAL_ERR();
+    return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+  }
+
+  {
+    nsCOMPtr<nsIInputStream> inputStream;
+    rv = NS_NewByteInputStream(getter_AddRefs(inputStream),
+                               aData.BeginReading(),
+                               aData.Length(),
+                               NS_ASSIGNMENT_DEPEND);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      IDB_REPORT_INTERNAL_ERR();
+      rv = NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+    }
+
+    if (NS_SUCCEEDED(rv)) {
+      RefPtr<FileOutputStream> fileOutputStream =
+        FileOutputStream::Create(mPersistenceType, mGroup, mOrigin, diskFile);
+      if (NS_WARN_IF(!fileOutputStream)) {
+        IDB_REPORT_INTERNAL_ERR();
+        rv = NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+      } else {
+        RefPtr<SnappyCompressOutputStream> snappyOutputStream =
+          new SnappyCompressOutputStream(fileOutputStream);
+
+        rv = CopyFileData(inputStream, snappyOutputStream);
+        if (NS_FAILED(rv) &&
+            NS_ERROR_GET_MODULE(rv) != NS_ERROR_MODULE_DOM_INDEXEDDB) {
+          IDB_REPORT_INTERNAL_ERR();
+          rv = NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+        }
+      }
+    }
+  }
+
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    RemoveFailedFile(diskFile, journalFile);
+    return rv;
+  }
+
+  return NS_OK;
+}
+
+void
+ObjectStoreAddOrPutRequestOp::RemoveFailedFile(nsIFile* aDiskFile,
+                                               nsIFile* aJournalFile)
+{
+  AssertIsOnConnectionThread();
+  MOZ_ASSERT(mFileManager);
+  MOZ_ASSERT(aDiskFile);
+  MOZ_ASSERT(aJournalFile);
+
+  nsresult rv;
+  int64_t fileSize;
+
+  if (mFileManager->EnforcingQuota()) {
+    rv = aDiskFile->GetFileSize(&fileSize);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      return;
+    }
+  }
+
+  rv = aDiskFile->Remove(false);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    return;
+  }
+
+  rv = aJournalFile->Remove(false);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    return;
+  }
+
+  if (mFileManager->EnforcingQuota()) {
+    QuotaManager* quotaManager = QuotaManager::Get();
+    MOZ_ASSERT(quotaManager);
+
+    quotaManager->DecreaseUsageForOrigin(mFileManager->Type(),
+                                         mFileManager->Group(),
+                                         mFileManager->Origin(),
+                                         fileSize);
+  }
+}
+
 bool
 ObjectStoreAddOrPutRequestOp::Init(TransactionBase* aTransaction)
 {
   AssertIsOnOwningThread();
 
+  for (uint32_t index = 0; index < mRecords.Length(); index++) {
+    if (NS_WARN_IF(!InitRecord(aTransaction, *mRecords[index]))) {
+      return false;
+    }
+  }
+
+  if (mUniqueIndexTable.isNothing() && mOverwrite) {
+    mUniqueIndexTable.emplace();
+  }
+
+#ifdef DEBUG
+  if (mUniqueIndexTable.isSome()) {
+    mUniqueIndexTable.ref().MarkImmutable();
+  }
+#endif
+
+  return true;
+}
+
+bool
+ObjectStoreAddOrPutRequestOp::InitRecord(TransactionBase* aTransaction,
+                                         Record& aRecord)
+{
+  AssertIsOnOwningThread();
+
   const nsTArray<IndexUpdateInfo>& indexUpdateInfos =
-    mParams.indexUpdateInfos();
+    aRecord.mParams.indexUpdateInfos();
 
   if (!indexUpdateInfos.IsEmpty()) {
     const uint32_t count = indexUpdateInfos.Length();
 
-    mUniqueIndexTable.emplace();
+    if (mUniqueIndexTable.isNothing()) {
+      mUniqueIndexTable.emplace();
+    }
 
     for (uint32_t index = 0; index < count; index++) {
       const IndexUpdateInfo& updateInfo = indexUpdateInfos[index];
@@ -25271,29 +25692,27 @@ ObjectStoreAddOrPutRequestOp::Init(TransactionBase* aTransaction)
       const bool& unique = indexMetadata->mCommonMetadata.unique();
 
       MOZ_ASSERT(indexId == updateInfo.indexId());
-      MOZ_ASSERT_IF(!indexMetadata->mCommonMetadata.multiEntry(),
-                    !mUniqueIndexTable.ref().Get(indexId));
+
+      // Every record of a putAll() updates the same indexes.
+      bool existingUnique;
+      if (mUniqueIndexTable.ref().Get(indexId, &existingUnique)) {
+        MOZ_ASSERT(mPutAll || indexMetadata->mCommonMetadata.multiEntry());
+        MOZ_ASSERT(existingUnique == unique);
+        continue;
+      }
 
       if (NS_WARN_IF(!mUniqueIndexTable.ref().Put(indexId, unique, fallible))) {
         return false;
       }
     }
-  } else if (mOverwrite) {
-    mUniqueIndexTable.emplace();
-  }
-
-#ifdef DEBUG
-  if (mUniqueIndexTable.isSome()) {
-    mUniqueIndexTable.ref().MarkImmutable();
   }
-#endif
 
-  const nsTArray<DatabaseOrMutableFile>& files = mParams.files();
+  const nsTArray<DatabaseOrMutableFile>& files = aRecord.mParams.files();
 
   if (!files.IsEmpty()) {
     const uint32_t count = files.Length();
 
-    if (NS_WARN_IF(!mStoredFileInfos.SetCapacity(count, fallible))) {
+    if (NS_WARN_IF(!aRecord.mStoredFileInfos.SetCapacity(count, fallible))) {
       return false;
     }
 
@@ -25308,7 +25727,8 @@ ObjectStoreAddOrPutRequestOp::Init(TransactionBase* aTransaction)
                  file.type() ==
                    DatabaseOrMutableFile::TPBackgroundMutableFileParent);
 
-      StoredFileInfo* storedFileInfo = mStoredFileInfos.AppendElement(fallible);
+      StoredFileInfo* storedFileInfo =
+        aRecord.mStoredFileInfos.AppendElement(fallible);
       MOZ_ASSERT(storedFileInfo);
 
       switch (file.type()) {
@@ -25349,6 +25769,24 @@ ObjectStoreAddOrPutRequestOp::Init(TransactionBase* aTransaction)
     }
   }
 
+  // Large values are stored compressed in a file of their own, like blobs, so
+  // they don't bloat the database file and its WAL.
+  if (aRecord.mParams.cloneInfo().data().data.Size() >
+        IndexedDatabaseManager::DataThreshold()) {
+    RefPtr<FileManager> fileManager =
+      aTransaction->GetDatabase()->GetFileManager();
+    MOZ_ASSERT(fileManager);
+
+    aRecord.mDataFileInfo = fileManager->GetNewFileInfo();
+    if (NS_WARN_IF(!aRecord.mDataFileInfo)) {
+      return false;
+    }
+
+    if (!mFileManager) {
+      mFileManager = fileManager;
+    }
+  }
+
   return true;
 }
 
@@ -25358,7 +25796,6 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
   MOZ_ASSERT(aConnection);
   aConnection->AssertIsOnConnectionThread();
   MOZ_ASSERT(aConnection->GetStorageConnection());
-  MOZ_ASSERT_IF(mFileManager, !mStoredFileInfos.IsEmpty());
 
   PROFILER_LABEL("IndexedDB",
                  "ObjectStoreAddOrPutRequestOp::DoDatabaseWork",
@@ -25377,25 +25814,97 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
   bool objectStoreHasIndexes;
   rv = ObjectStoreHasIndexes(this,
                              aConnection,
-                             mParams.objectStoreId(),
+                             mObjectStoreId,
                              mObjectStoreMayHaveIndexes,
                              &objectStoreHasIndexes);
   if (NS_WARN_IF(NS_FAILED(rv))) {
     return rv;
   }
 
+  nsCOMPtr<nsIFile> fileDirectory;
+  nsCOMPtr<nsIFile> journalDirectory;
+
+  if (mFileManager) {
+    fileDirectory = mFileManager->GetDirectory();
+    if (NS_WARN_IF(!fileDirectory)) {
+      IDB_REPORT_INTERNAL_ERR();
+      return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+    }
+
+    journalDirectory = mFileManager->EnsureJournalDirectory();
+    if (NS_WARN_IF(!journalDirectory)) {
+      IDB_REPORT_INTERNAL_ERR();
+      return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
+    }
+
+    DebugOnly<bool> exists;
+    MOZ_ASSERT(NS_SUCCEEDED(fileDirectory->Exists(&exists)));
+    MOZ_ASSERT(exists);
+
+    DebugOnly<bool> isDirectory;
+    MOZ_ASSERT(NS_SUCCEEDED(fileDirectory->IsDirectory(&isDirectory)));
+    MOZ_ASSERT(isDirectory);
+
+    MOZ_ASSERT(NS_SUCCEEDED(journalDirectory->Exists(&exists)));
+    MOZ_ASSERT(exists);
+
+    MOZ_ASSERT(NS_SUCCEEDED(journalDirectory->IsDirectory(&isDirectory)));
+    MOZ_ASSERT(isDirectory);
+  }
+
+  int64_t nextAutoIncrementId = mMetadata->mNextAutoIncrementId;
+
+  for (uint32_t index = 0; index < mRecords.Length(); index++) {
+    rv = StoreRecord(aConnection,
+                     *mRecords[index],
+                     objectStoreHasIndexes,
+                     fileDirectory,
+                     journalDirectory,
+                     nextAutoIncrementId);
+    if (NS_FAILED(rv)) {
+      return rv;
+    }
+  }
+
+  rv = autoSave.Commit();
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    return rv;
+  }
+
+  if (nextAutoIncrementId != mMetadata->mNextAutoIncrementId) {
+    mMetadata->mNextAutoIncrementId = nextAutoIncrementId;
+    Transaction()->NoteModifiedAutoIncrementObjectStore(mMetadata);
+  }
+
+  return NS_OK;
+}
+
+nsresult
+ObjectStoreAddOrPutRequestOp::StoreRecord(DatabaseConnection* aConnection,
+                                          Record& aRecord,
+                                          bool aObjectStoreHasIndexes,
+                                          nsIFile* aFileDirectory,
+                                          nsIFile* aJournalDirectory,
+                                          int64_t& aNextAutoIncrementId)
+{
+  AssertIsOnConnectionThread();
+  MOZ_ASSERT(aConnection);
+  MOZ_ASSERT_IF(aFileDirectory, aJournalDirectory);
+
+  nsresult rv;
+
   // This will be the final key we use.
-  Key& key = mResponse;
-  key = mParams.key();
+  Key& key = aRecord.mKey;
+  key = aRecord.mParams.key();
 
   const bool keyUnset = key.IsUnset();
-  const int64_t osid = mParams.objectStoreId();
+  const int64_t osid = mObjectStoreId;
   const KeyPath& keyPath = mMetadata->mCommonMetadata.keyPath();
 
   // First delete old index_data_values if we're overwriting something and we
   // have indexes.
-  if (mOverwrite && !keyUnset && objectStoreHasIndexes) {
-    rv = RemoveOldIndexDataValues(aConnection);
+  if (mOverwrite && !keyUnset && aObjectStoreHasIndexes) {
+    rv = RemoveOldIndexDataValues(aConnection, key);
     if (NS_WARN_IF(NS_FAILED(rv))) {
       return rv;
     }
@@ -25431,7 +25940,7 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
   MOZ_ASSERT(!keyUnset || mMetadata->mCommonMetadata.autoIncrement(),
              "Should have key unless autoIncrement");
 
-  const JSStructuredCloneData& data = mParams.cloneInfo().data().data;
+  const JSStructuredCloneData& data = aRecord.mParams.cloneInfo().data().data;
   size_t cloneDataSize = data.Size();
   nsCString cloneData;
   cloneData.SetLength(cloneDataSize);
@@ -25442,7 +25951,7 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
 
   if (mMetadata->mCommonMetadata.autoIncrement()) {
     if (keyUnset) {
-      autoIncrementNum = mMetadata->mNextAutoIncrementId;
+      autoIncrementNum = aNextAutoIncrementId;
 
       MOZ_ASSERT(autoIncrementNum > 0);
 
@@ -25452,12 +25961,13 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
 
       key.SetFromInteger(autoIncrementNum);
     } else if (key.IsFloat() &&
-               key.ToFloat() >= mMetadata->mNextAutoIncrementId) {
+               key.ToFloat() >= aNextAutoIncrementId) {
       autoIncrementNum = floor(key.ToFloat());
     }
 
     if (keyUnset && keyPath.IsValid()) {
-      const SerializedStructuredCloneWriteInfo& cloneInfo = mParams.cloneInfo();
+      const SerializedStructuredCloneWriteInfo& cloneInfo =
+        aRecord.mParams.cloneInfo();
       MOZ_ASSERT(cloneInfo.offsetToKeyProp());
       MOZ_ASSERT(cloneDataSize > sizeof(uint64_t));
       MOZ_ASSERT(cloneInfo.offsetToKeyProp() <=
@@ -25476,13 +25986,28 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
 
   key.BindToStatement(stmt, NS_LITERAL_CSTRING("key"));
 
-  // Compress the bytes before adding into the database.
-  const char* uncompressed = cloneData.BeginReading();
-  size_t uncompressedLength = cloneDataSize;
+  if (aRecord.mDataFileInfo) {
+    MOZ_ASSERT(aFileDirectory);
+    MOZ_ASSERT(aJournalDirectory);
 
-  // We don't have a smart pointer class that calls free, so we need to
-  // manage | compressed | manually.
-  {
+    const int64_t id = aRecord.mDataFileInfo->Id();
+
+    rv = StoreDataInFile(cloneData, id, aFileDirectory, aJournalDirectory);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      return rv;
+    }
+
+    rv = stmt->BindInt64ByName(NS_LITERAL_CSTRING("data"), id);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      return rv;
+    }
+  } else {
+    // Compress the bytes before adding into the database.
+    const char* uncompressed = cloneData.BeginReading();
+    size_t uncompressedLength = cloneDataSize;
+
+    // We don't have a smart pointer class that calls free, so we need to
+    // manage | compressed | manually.
     size_t compressedLength = snappy::MaxCompressedLength(uncompressedLength);
 
     char* compressed = static_cast<char*>(malloc(compressedLength));
@@ -25503,44 +26028,13 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
     }
   }
 
-  nsCOMPtr<nsIFile> fileDirectory;
-  nsCOMPtr<nsIFile> journalDirectory;
-
-  if (mFileManager) {
-    fileDirectory = mFileManager->GetDirectory();
-    if (NS_WARN_IF(!fileDirectory)) {
-      IDB_REPORT_INTERNAL_ERR();
-      return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
-    }
-
-    journalDirectory = mFileManager->EnsureJournalDirectory();
-    if (NS_WARN_IF(!journalDirectory)) {
-      IDB_REPORT_INTERNAL_ERR();
-      return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
-    }
-
-    DebugOnly<bool> exists;
-    MOZ_ASSERT(NS_SUCCEEDED(fileDirectory->Exists(&exists)));
-    MOZ_ASSERT(exists);
-
-    DebugOnly<bool> isDirectory;
-    MOZ_ASSERT(NS_SUCCEEDED(fileDirectory->IsDirectory(&isDirectory)));
-    MOZ_ASSERT(isDirectory);
-
-    MOZ_ASSERT(NS_SUCCEEDED(journalDirectory->Exists(&exists)));
-    MOZ_ASSERT(exists);
-
-    MOZ_ASSERT(NS_SUCCEEDED(journalDirectory->IsDirectory(&isDirectory)));
-    MOZ_ASSERT(isDirectory);
-  }
-
-  if (!mStoredFileInfos.IsEmpty()) {
-    nsAutoString fileIds;
+  nsAutoString fileIds;
 
-    for (uint32_t count = mStoredFileInfos.Length(), index = 0;
+  if (!aRecord.mStoredFileInfos.IsEmpty()) {
+    for (uint32_t count = aRecord.mStoredFileInfos.Length(), index = 0;
          index < count;
          index++) {
-      StoredFileInfo& storedFileInfo = mStoredFileInfos[index];
+      StoredFileInfo& storedFileInfo = aRecord.mStoredFileInfos[index];
       MOZ_ASSERT(storedFileInfo.mFileInfo);
 
       const int64_t id = storedFileInfo.mFileInfo->Id();
@@ -25549,11 +26043,11 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
       storedFileInfo.mInputStream.swap(inputStream);
 
       if (inputStream) {
-        MOZ_ASSERT(fileDirectory);
-        MOZ_ASSERT(journalDirectory);
+        MOZ_ASSERT(aFileDirectory);
+        MOZ_ASSERT(aJournalDirectory);
 
         nsCOMPtr<nsIFile> diskFile =
-          mFileManager->GetFileForId(fileDirectory, id);
+          mFileManager->GetFileForId(aFileDirectory, id);
         if (NS_WARN_IF(!diskFile)) {
           IDB_REPORT_INTERNAL_ERR();
           return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
@@ -25605,7 +26099,7 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
         } else {
           // Create a journal file first.
           nsCOMPtr<nsIFile> journalFile =
-            mFileManager->GetFileForId(journalDirectory, id);
+            mFileManager->GetFileForId(aJournalDirectory, id);
           if (NS_WARN_IF(!journalFile)) {
             IDB_REPORT_INTERNAL_ERR();
             return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
@@ -25636,36 +26130,7 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
           }
           if (NS_WARN_IF(NS_FAILED(rv))) {
             // Try to remove the file if the copy failed.
-            nsresult rv2;
-            int64_t fileSize;
-
-            if (mFileManager->EnforcingQuota()) {
-              rv2 = diskFile->GetFileSize(&fileSize);
-              if (NS_WARN_IF(NS_FAILED(rv2))) {
-                return rv;
-              }
-            }
-
-            rv2 = diskFile->Remove(false);
-            if (NS_WARN_IF(NS_FAILED(rv2))) {
-              return rv;
-            }
-
-            rv2 = journalFile->Remove(false);
-            if (NS_WARN_IF(NS_FAILED(rv2))) {
-              return rv;
-            }
-
-            if (mFileManager->EnforcingQuota()) {
-              QuotaManager* quotaManager = QuotaManager::Get();
-              MOZ_ASSERT(quotaManager);
-
-              quotaManager->DecreaseUsageForOrigin(mFileManager->Type(),
-                                                   mFileManager->Group(),
-                                                   mFileManager->Origin(),
-                                                   fileSize);
-            }
-
+            RemoveFailedFile(diskFile, journalFile);
             return rv;
           }
 
@@ -25678,7 +26143,19 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
       }
       fileIds.AppendInt(storedFileInfo.mMutable ? -id : id);
     }
+  }
 
+  // The file holding the value itself is marked so that it isn't mistaken
+  // for one of the value's blobs, see ConvertFileIdsToArray.
+  if (aRecord.mDataFileInfo) {
+    if (!fileIds.IsEmpty()) {
+      fileIds.Append(' ');
+    }
+    fileIds.Append('.');
+    fileIds.AppendInt(aRecord.mDataFileInfo->Id());
+  }
+
+  if (!fileIds.IsEmpty()) {
     rv = stmt->BindStringByName(NS_LITERAL_CSTRING("file_ids"), fileIds);
     if (NS_WARN_IF(NS_FAILED(rv))) {
       return rv;
@@ -25701,12 +26178,12 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
   }
 
   // Update our indexes if needed.
-  if (!mParams.indexUpdateInfos().IsEmpty()) {
+  if (!aRecord.mParams.indexUpdateInfos().IsEmpty()) {
     MOZ_ASSERT(mUniqueIndexTable.isSome());
 
     // Write the index_data_values column.
     AutoTArray<IndexDataValue, 32> indexValues;
-    rv = IndexDataValuesFromUpdateInfos(mParams.indexUpdateInfos(),
+    rv = IndexDataValuesFromUpdateInfos(aRecord.mParams.indexUpdateInfos(),
                                         mUniqueIndexTable.ref(),
                                         indexValues);
     if (NS_WARN_IF(NS_FAILED(rv))) {
@@ -25724,14 +26201,8 @@ ObjectStoreAddOrPutRequestOp::DoDatabaseWork(DatabaseConnection* aConnection)
     }
   }
 
-  rv = autoSave.Commit();
-  if (NS_WARN_IF(NS_FAILED(rv))) {
-    return rv;
-  }
-
   if (autoIncrementNum) {
-    mMetadata->mNextAutoIncrementId = autoIncrementNum + 1;
-    Transaction()->NoteModifiedAutoIncrementObjectStore(mMetadata);
+    aNextAutoIncrementId = autoIncrementNum + 1;
   }
 
   return NS_OK;
@@ -25742,10 +26213,17 @@ ObjectStoreAddOrPutRequestOp::GetResponse(RequestResponse& aResponse)
 {
   AssertIsOnOwningThread();
 
-  if (mOverwrite) {
-    aResponse = ObjectStorePutResponse(mResponse);
+  if (mPutAll) {
+    nsTArray<Key> keys;
+    keys.SetCapacity(mRecords.Length());
+    for (uint32_t index = 0; index < mRecords.Length(); index++) {
+      keys.AppendElement(mRecords[index]->mKey);
+    }
+    aResponse = ObjectStorePutAllResponse(keys);
+  } else if (mOverwrite) {
+    aResponse = ObjectStorePutResponse(mRecords[0]->mKey);
   } else {
-    aResponse = ObjectStoreAddResponse(mResponse);
+    aResponse = ObjectStoreAddResponse(mRecords[0]->mKey);
   }
 }
 
@@ -25754,11 +26232,16 @@ ObjectStoreAddOrPutRequestOp::Cleanup()
 {
   AssertIsOnOwningThread();
 
-  if (!mStoredFileInfos.IsEmpty()) {
-    for (uint32_t count = mStoredFileInfos.Length(), index = 0;
+  for (uint32_t recordIndex = 0;
+       recordIndex < mRecords.Length();
+       recordIndex++) {
+    FallibleTArray<StoredFileInfo>& storedFileInfos =
+      mRecords[recordIndex]->mStoredFileInfos;
+
+    for (uint32_t count = storedFileInfos.Length(), index = 0;
          index < count;
          index++) {
-      StoredFileInfo& storedFileInfo = mStoredFileInfos[index];
+      StoredFileInfo& storedFileInfo = storedFileInfos[index];
       RefPtr<DatabaseFile>& fileActor = storedFileInfo.mFileActor;
 
       MOZ_ASSERT_IF(!fileActor, !storedFileInfo.mCopiedSuccessfully);
@@ -25768,7 +26251,7 @@ ObjectStoreAddOrPutRequestOp::Cleanup()
       }
     }
 
-    mStoredFileInfos.Clear();
+    storedFileInfos.Clear();
   }
 
   NormalTransactionOp::Cleanup();
@@ -26852,7 +27335,8 @@ CursorOpBase::PopulateResponseFromStatement(
     bool aInitializeResponse)
 {
   Transaction()->AssertIsOnConnectionThread();
-  MOZ_ASSERT(mResponse.type() == CursorResponse::T__None);
+  MOZ_ASSERT_IF(aInitializeResponse,
+                mResponse.type() == CursorResponse::T__None);
   MOZ_ASSERT_IF(mFiles.IsEmpty(), aInitializeResponse);
 
   nsresult rv = mCursor->mKey.SetFromStatement(aStmt, 0);
@@ -27893,6 +28377,23 @@ ContinueOp::DoDatabaseWork(DatabaseConnection* aConnection)
                  "Cursor::ContinueOp::DoDatabaseWork",
                  js::ProfileEntry::Category::STORAGE);
 
+  // Object store cursors read ahead, so the child may be positioned before
+  // mCursor->mKey. Start from the child's record and read ahead further if it
+  // used up the last batch, less far if it had to drop part of it.
+  uint32_t prefetchCount = 0;
+  if (mCursor->mType == OpenCursorParams::TObjectStoreOpenCursorParams &&
+      !mCurrentKey.IsUnset()) {
+    if (mCurrentKey == mCursor->mKey) {
+      mCursor->mPrefetchCount =
+        std::min(mCursor->mPrefetchCount * 2, kCursorMaxPrefetchCount);
+    } else {
+      mCursor->mPrefetchCount =
+        std::max(mCursor->mPrefetchCount / 2, kCursorMinPrefetchCount);
+      mCursor->mKey = mCurrentKey;
+    }
+    prefetchCount = mCursor->mPrefetchCount;
+  }
+
   // We need to pick a query based on whether or not a key was passed to the
   // continue function. If not we'll grab the the next item in the database that
   // is greater than (or less than, if we're running a PREV cursor) the current
@@ -27936,7 +28437,7 @@ ContinueOp::DoDatabaseWork(DatabaseConnection* aConnection)
 
   MOZ_ASSERT(advanceCount > 0);
   nsAutoCString countString;
-  countString.AppendInt(advanceCount);
+  countString.AppendInt(uint64_t(advanceCount) + prefetchCount);
 
   nsCString query = continueQuery + countString;
 
@@ -28017,6 +28518,31 @@ ContinueOp::DoDatabaseWork(DatabaseConnection* aConnection)
     return rv;
   }
 
+  size_t prefetchedBytes = 0;
+  for (uint32_t index = 0; index < prefetchCount; index++) {
+    const nsTArray<ObjectStoreCursorResponse>& responses =
+      mResponse.get_ArrayOfObjectStoreCursorResponse();
+
+    prefetchedBytes += responses.LastElement().cloneInfo().data().data.Size();
+    if (prefetchedBytes >= kCursorMaxPrefetchBytes) {
+      break;
+    }
+
+    rv = stmt->ExecuteStep(&hasResult);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      return rv;
+    }
+
+    if (!hasResult) {
+      break;
+    }
+
+    rv = PopulateResponseFromStatement(stmt, false);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      return rv;
+    }
+  }
+
   return NS_OK;
 }
 
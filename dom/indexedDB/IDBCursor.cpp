@@ -510,7 +510,7 @@ IDBCursor::Continue(JSContext* aCx,
                  IDB_LOG_STRINGIFY(key));
   }
 
-  mBackgroundActor->SendContinueInternal(ContinueParams(key));
+  mBackgroundActor->SendContinueInternal(ContinueParams(key), mKey);
 
   mContinueCalled = true;
 }
@@ -620,7 +620,8 @@ IDBCursor::ContinuePrimaryKey(JSContext* aCx,
                IDB_LOG_STRINGIFY(key),
                IDB_LOG_STRINGIFY(primaryKey));
 
-  mBackgroundActor->SendContinueInternal(ContinuePrimaryKeyParams(key, primaryKey));
+  mBackgroundActor->SendContinueInternal(ContinuePrimaryKeyParams(key, primaryKey),
+                                         mKey);
 
   mContinueCalled = true;
 }
@@ -678,7 +679,7 @@ IDBCursor::Advance(uint32_t aCount, ErrorResult &aRv)
                  aCount);
   }
 
-  mBackgroundActor->SendContinueInternal(AdvanceParams(aCount));
+  mBackgroundActor->SendContinueInternal(AdvanceParams(aCount), mKey);
 
   mContinueCalled = true;
 }
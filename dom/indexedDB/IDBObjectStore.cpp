@@ -1233,50 +1233,30 @@ IDBObjectStore::GetAddInfo(JSContext* aCx,
   return rv;
 }
 
-already_AddRefed<IDBRequest>
-IDBObjectStore::AddOrPut(JSContext* aCx,
-                         JS::Handle<JS::Value> aValue,
-                         JS::Handle<JS::Value> aKey,
-                         bool aOverwrite,
-                         bool aFromCursor,
-                         ErrorResult& aRv)
+nsresult
+IDBObjectStore::GetAddPutParams(JSContext* aCx,
+                                JS::Handle<JS::Value> aValue,
+                                JS::Handle<JS::Value> aKey,
+                                ObjectStoreAddPutParams& aParams)
 {
   AssertIsOnOwningThread();
   MOZ_ASSERT(aCx);
-  MOZ_ASSERT_IF(aFromCursor, aOverwrite);
-
-  if (mTransaction->GetMode() == IDBTransaction::CLEANUP ||
-      mDeletedSpec) {
-    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_NOT_ALLOWED_ERR);
-    return nullptr;
-  }
-
-  if (!mTransaction->IsOpen()) {
-    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_TRANSACTION_INACTIVE_ERR);
-    return nullptr;
-  }
-
-  if (!mTransaction->IsWriteAllowed()) {
-    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_READ_ONLY_ERR);
-    return nullptr;
-  }
 
   JS::Rooted<JS::Value> value(aCx, aValue);
   Key key;
   StructuredCloneWriteInfo cloneWriteInfo(mTransaction->Database());
   nsTArray<IndexUpdateInfo> updateInfo;
 
-  aRv = GetAddInfo(aCx, value, aKey, cloneWriteInfo, key, updateInfo);
-  if (aRv.Failed()) {
-    return nullptr;
+  nsresult rv = GetAddInfo(aCx, value, aKey, cloneWriteInfo, key, updateInfo);
+  if (NS_FAILED(rv)) {
+    return rv;
   }
 
-  ObjectStoreAddPutParams commonParams;
-  commonParams.objectStoreId() = Id();
-  commonParams.cloneInfo().data().data = Move(cloneWriteInfo.mCloneBuffer.data());
-  commonParams.cloneInfo().offsetToKeyProp() = cloneWriteInfo.mOffsetToKeyProp;
-  commonParams.key() = key;
-  commonParams.indexUpdateInfos().SwapElements(updateInfo);
+  aParams.objectStoreId() = Id();
+  aParams.cloneInfo().data().data = Move(cloneWriteInfo.mCloneBuffer.data());
+  aParams.cloneInfo().offsetToKeyProp() = cloneWriteInfo.mOffsetToKeyProp;
+  aParams.key() = key;
+  aParams.indexUpdateInfos().SwapElements(updateInfo);
 
   // Convert any blobs or mutable files into DatabaseOrMutableFile.
   nsTArray<StructuredCloneWriteInfo::BlobOrMutableFile>& blobOrMutableFiles =
@@ -1287,8 +1267,7 @@ IDBObjectStore::AddOrPut(JSContext* aCx,
 
     FallibleTArray<DatabaseOrMutableFile> fileOrMutableFileActors;
     if (NS_WARN_IF(!fileOrMutableFileActors.SetCapacity(count, fallible))) {
-      aRv = NS_ERROR_OUT_OF_MEMORY;
-      return nullptr;
+      return NS_ERROR_OUT_OF_MEMORY;
     }
 
     IDBDatabase* database = mTransaction->Database();
@@ -1304,8 +1283,7 @@ IDBObjectStore::AddOrPut(JSContext* aCx,
           database->GetOrCreateFileActorForBlob(blobOrMutableFile.mBlob);
         if (NS_WARN_IF(!fileActor)) {
           IDB_REPORT_INTERNAL_ERR();
-          aRv = NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
-          return nullptr;
+          return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
         }
 
         MOZ_ALWAYS_TRUE(fileOrMutableFileActors.AppendElement(fileActor,
@@ -1315,8 +1293,7 @@ IDBObjectStore::AddOrPut(JSContext* aCx,
           blobOrMutableFile.mMutableFile->GetBackgroundActor();
         if (NS_WARN_IF(!mutableFileActor)) {
           IDB_REPORT_INTERNAL_ERR();
-          aRv = NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
-          return nullptr;
+          return NS_ERROR_DOM_INDEXEDDB_UNKNOWN_ERR;
         }
 
         MOZ_ALWAYS_TRUE(fileOrMutableFileActors.AppendElement(mutableFileActor,
@@ -1324,9 +1301,48 @@ IDBObjectStore::AddOrPut(JSContext* aCx,
       }
     }
 
-    commonParams.files().SwapElements(fileOrMutableFileActors);
+    aParams.files().SwapElements(fileOrMutableFileActors);
   }
 
+  return NS_OK;
+}
+
+already_AddRefed<IDBRequest>
+IDBObjectStore::AddOrPut(JSContext* aCx,
+                         JS::Handle<JS::Value> aValue,
+                         JS::Handle<JS::Value> aKey,
+                         bool aOverwrite,
+                         bool aFromCursor,
+                         ErrorResult& aRv)
+{
+  AssertIsOnOwningThread();
+  MOZ_ASSERT(aCx);
+  MOZ_ASSERT_IF(aFromCursor, aOverwrite);
+
+  if (mTransaction->GetMode() == IDBTransaction::CLEANUP ||
+      mDeletedSpec) {
+    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_NOT_ALLOWED_ERR);
+    return nullptr;
+  }
+
+  if (!mTransaction->IsOpen()) {
+    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_TRANSACTION_INACTIVE_ERR);
+    return nullptr;
+  }
+
+  if (!mTransaction->IsWriteAllowed()) {
+    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_READ_ONLY_ERR);
+    return nullptr;
+  }
+
+  ObjectStoreAddPutParams commonParams;
+  aRv = GetAddPutParams(aCx, aValue, aKey, commonParams);
+  if (aRv.Failed()) {
+    return nullptr;
+  }
+
+  const Key& key = commonParams.key();
+
   RequestParams params;
   if (aOverwrite) {
     params = ObjectStorePutParams(commonParams);
@@ -1368,6 +1384,69 @@ IDBObjectStore::AddOrPut(JSContext* aCx,
   return request.forget();
 }
 
+already_AddRefed<IDBRequest>
+IDBObjectStore::PutAll(JSContext* aCx,
+                       const JS::HandleValueArray& aValues,
+                       ErrorResult& aRv)
+{
+  AssertIsOnOwningThread();
+  MOZ_ASSERT(aCx);
+
+  if (mTransaction->GetMode() == IDBTransaction::CLEANUP ||
+      mDeletedSpec) {
+    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_NOT_ALLOWED_ERR);
+    return nullptr;
+  }
+
+  if (!mTransaction->IsOpen()) {
+    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_TRANSACTION_INACTIVE_ERR);
+    return nullptr;
+  }
+
+  if (!mTransaction->IsWriteAllowed()) {
+    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_READ_ONLY_ERR);
+    return nullptr;
+  }
+
+  if (aValues.length() == 0) {
+    aRv.Throw(NS_ERROR_DOM_INDEXEDDB_DATA_ERR);
+    return nullptr;
+  }
+
+  ObjectStorePutAllParams params;
+  params.objectStoreId() = Id();
+
+  nsTArray<ObjectStoreAddPutParams>& records = params.records();
+  records.SetCapacity(aValues.length());
+
+  for (size_t index = 0; index < aValues.length(); index++) {
+    ObjectStoreAddPutParams* record = records.AppendElement();
+    aRv = GetAddPutParams(aCx, aValues[index], JS::UndefinedHandleValue,
+                          *record);
+    if (aRv.Failed()) {
+      return nullptr;
+    }
+  }
+
+  RefPtr<IDBRequest> request = GenerateRequest(aCx, this);
+  MOZ_ASSERT(request);
+
+  IDB_LOG_MARK("IndexedDB %s: Child  Transaction[%lld] Request[%llu]: "
+                 "database(%s).transaction(%s).objectStore(%s).putAll(%u)",
+               "IndexedDB %s: C T[%lld] R[%llu]: IDBObjectStore.putAll()",
+               IDB_LOG_ID_STRING(),
+               mTransaction->LoggingSerialNumber(),
+               request->LoggingSerialNumber(),
+               IDB_LOG_STRINGIFY(mTransaction->Database()),
+               IDB_LOG_STRINGIFY(mTransaction),
+               IDB_LOG_STRINGIFY(this),
+               uint32_t(aValues.length()));
+
+  mTransaction->StartRequest(request, params);
+
+  return request.forget();
+}
+
 already_AddRefed<IDBRequest>
 IDBObjectStore::GetAllInternal(bool aKeysOnly,
                                JSContext* aCx,
@@ -37,6 +37,7 @@ namespace indexedDB {
 class Key;
 class KeyPath;
 class IndexUpdateInfo;
+class ObjectStoreAddPutParams;
 class ObjectStoreSpec;
 struct StructuredCloneReadInfo;
 } // namespace indexedDB
@@ -48,6 +49,7 @@ class IDBObjectStore final
   typedef indexedDB::IndexUpdateInfo IndexUpdateInfo;
   typedef indexedDB::Key Key;
   typedef indexedDB::KeyPath KeyPath;
+  typedef indexedDB::ObjectStoreAddPutParams ObjectStoreAddPutParams;
   typedef indexedDB::ObjectStoreSpec ObjectStoreSpec;
   typedef indexedDB::StructuredCloneReadInfo StructuredCloneReadInfo;
 
@@ -193,6 +195,14 @@ public:
     return AddOrPut(aCx, aValue, aKey, true, /* aFromCursor */ false, aRv);
   }
 
+  // Non-standard, stores all of aValues in a single request.  The keys come
+  // from the object store's key path or key generator; the request's result
+  // is the array of keys in the order of aValues.
+  already_AddRefed<IDBRequest>
+  PutAll(JSContext* aCx,
+         const JS::HandleValueArray& aValues,
+         ErrorResult& aRv);
+
   already_AddRefed<IDBRequest>
   Delete(JSContext* aCx,
          JS::Handle<JS::Value> aKey,
@@ -337,6 +347,12 @@ private:
              Key& aKey,
              nsTArray<IndexUpdateInfo>& aUpdateInfoArray);
 
+  nsresult
+  GetAddPutParams(JSContext* aCx,
+                  JS::Handle<JS::Value> aValue,
+                  JS::Handle<JS::Value> aKey,
+                  ObjectStoreAddPutParams& aParams);
+
   already_AddRefed<IDBRequest>
   AddOrPut(JSContext* aCx,
            JS::Handle<JS::Value> aValue,
@@ -99,6 +99,10 @@ private:
   nsresult mAbortCode;
   uint32_t mPendingRequestCount;
 
+  // Incremented for every request that modifies records, so that cursors can
+  // tell whether the records they prefetched may be stale.
+  uint32_t mWriteRequestCount;
+
   nsString mFilename;
   uint32_t mLineNo;
   uint32_t mColumn;
@@ -161,6 +165,13 @@ public:
   OpenCursor(indexedDB::BackgroundCursorChild* aBackgroundActor,
              const indexedDB::OpenCursorParams& aParams);
 
+  uint32_t
+  WriteRequestCount() const
+  {
+    AssertIsOnOwningThread();
+    return mWriteRequestCount;
+  }
+
   void
   RefreshSpec(bool aMayDelete);
 
@@ -131,6 +131,11 @@ public:
   static bool
   IsFileHandleEnabled();
 
+  // Values whose structured clone data is larger than this are stored in a
+  // file of their own rather than in the database.
+  static uint32_t
+  DataThreshold();
+
   void
   ClearBackgroundActor();
 
@@ -78,6 +78,7 @@
 #include "mozilla/ipc/BackgroundParent.h"
 #include "mozilla/ipc/FileDescriptorUtils.h"
 #include "mozilla/ipc/PSendStreamParent.h"
+#include "mozilla/ipc/SharedMemoryBasic.h"
 #include "mozilla/ipc/TestShellParent.h"
 #include "mozilla/ipc/InputStreamUtils.h"
 #include "mozilla/jsipc/CrossProcessObjectWrappers.h"
@@ -168,6 +169,7 @@
 #include "ProcessPriorityManager.h"
 #include "SandboxHal.h"
 #include "ScreenManagerParent.h"
+#include "SharedSurfaceCache.h"
 #include "SourceSurfaceRawData.h"
 #include "TabParent.h"
 #include "URIUtils.h"
@@ -2360,6 +2362,23 @@ ContentParent::Pid() const
   return base::GetProcId(mSubprocess->GetChildProcessHandle());
 }
 
+bool
+ContentParent::RecvReadPrefsSnapshot(ipc::SharedMemoryBasic::Handle* aSnapshot,
+                                     uint32_t* aSize)
+{
+  *aSnapshot = ipc::SharedMemoryBasic::NULLHandle();
+  *aSize = 0;
+
+  // On failure the child falls back to ReadPrefsArray.
+  uint32_t size;
+  RefPtr<ipc::SharedMemoryBasic> snapshot =
+    Preferences::GetPreferencesSnapshot(&size);
+  if (snapshot && snapshot->ShareToProcess(OtherPid(), aSnapshot)) {
+    *aSize = size;
+  }
+  return true;
+}
+
 bool
 ContentParent::RecvReadPrefsArray(InfallibleTArray<PrefSetting>* aPrefs)
 {
@@ -2367,6 +2386,43 @@ ContentParent::RecvReadPrefsArray(InfallibleTArray<PrefSetting>* aPrefs)
   return true;
 }
 
+bool
+ContentParent::RecvLookupSharedImage(const nsCString& aDigest,
+                                     const int32_t& aWidth,
+                                     const int32_t& aHeight,
+                                     const uint32_t& aSurfaceFlags,
+                                     ipc::SharedMemoryBasic::Handle* aSurface,
+                                     int32_t* aStride,
+                                     uint8_t* aFormat)
+{
+  *aSurface = ipc::SharedMemoryBasic::NULLHandle();
+  *aStride = 0;
+  *aFormat = 0;
+
+  // On a miss the child decodes the image itself.
+  image::SharedSurfaceCache::LookupForProcess(OtherPid(), aDigest,
+                                              gfx::IntSize(aWidth, aHeight),
+                                              aSurfaceFlags, aSurface,
+                                              aStride, aFormat);
+  return true;
+}
+
+bool
+ContentParent::RecvStoreSharedImage(const nsCString& aDigest,
+                                    const int32_t& aWidth,
+                                    const int32_t& aHeight,
+                                    const uint32_t& aSurfaceFlags,
+                                    const ipc::SharedMemoryBasic::Handle& aSurface,
+                                    const int32_t& aStride,
+                                    const uint8_t& aFormat)
+{
+  image::SharedSurfaceCache::StoreFromProcess(aDigest,
+                                              gfx::IntSize(aWidth, aHeight),
+                                              aSurfaceFlags, aSurface,
+                                              aStride, aFormat);
+  return true;
+}
+
 bool
 ContentParent::RecvGetGfxVars(InfallibleTArray<GfxVarUpdate>* aVars)
 {
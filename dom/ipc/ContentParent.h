@@ -915,7 +915,27 @@ private:
   virtual bool
   DeallocPWebBrowserPersistDocumentParent(PWebBrowserPersistDocumentParent* aActor) override;
 
+  virtual bool RecvReadPrefsSnapshot(mozilla::ipc::SharedMemoryBasic::Handle* aSnapshot,
+                                     uint32_t* aSize) override;
+
   virtual bool RecvReadPrefsArray(InfallibleTArray<PrefSetting>* aPrefs) override;
+
+  virtual bool RecvLookupSharedImage(const nsCString& aDigest,
+                                     const int32_t& aWidth,
+                                     const int32_t& aHeight,
+                                     const uint32_t& aSurfaceFlags,
+                                     mozilla::ipc::SharedMemoryBasic::Handle* aSurface,
+                                     int32_t* aStride,
+                                     uint8_t* aFormat) override;
+
+  virtual bool RecvStoreSharedImage(const nsCString& aDigest,
+                                    const int32_t& aWidth,
+                                    const int32_t& aHeight,
+                                    const uint32_t& aSurfaceFlags,
+                                    const mozilla::ipc::SharedMemoryBasic::Handle& aSurface,
+                                    const int32_t& aStride,
+                                    const uint8_t& aFormat) override;
+
   virtual bool RecvGetGfxVars(InfallibleTArray<GfxVarUpdate>* aVars) override;
 
   virtual bool RecvReadFontList(InfallibleTArray<FontListEntry>* retValue) override;
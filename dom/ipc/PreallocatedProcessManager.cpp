@@ -13,12 +13,18 @@
 #include "nsIPropertyBag2.h"
 #include "ProcessPriorityManager.h"
 #include "nsServiceManagerUtils.h"
+#include "nsTArray.h"
+
+#include <algorithm>
 
 // This number is fairly arbitrary ... the intention is to put off
 // launching another app process until the last one has finished
 // loading its content, to reduce CPU/memory/IO contention.
 #define DEFAULT_ALLOCATE_DELAY 1000
 
+// By default, keep a single preallocated process around.
+#define DEFAULT_POOL_SIZE 1
+
 using namespace mozilla;
 using namespace mozilla::hal;
 using namespace mozilla::dom;
@@ -59,9 +65,17 @@ private:
 
   void ObserveProcessShutdown(nsISupports* aSubject);
 
+  bool IsPoolFull() const
+  {
+    return mPreallocatedAppProcesses.Length() >= mPoolSize;
+  }
+
+  void ShrinkPool();
+
   bool mEnabled;
   bool mShutdown;
-  RefPtr<ContentParent> mPreallocatedAppProcess;
+  uint32_t mPoolSize;
+  nsTArray<RefPtr<ContentParent>> mPreallocatedAppProcesses;
 };
 
 /* static */ StaticRefPtr<PreallocatedProcessManagerImpl>
@@ -85,12 +99,14 @@ PreallocatedProcessManagerImpl::PreallocatedProcessManagerImpl()
   :
     mEnabled(false)
   , mShutdown(false)
+  , mPoolSize(DEFAULT_POOL_SIZE)
 {}
 
 void
 PreallocatedProcessManagerImpl::Init()
 {
   Preferences::AddStrongObserver(this, "dom.ipc.processPrelaunch.enabled");
+  Preferences::AddStrongObserver(this, "dom.ipc.processPrelaunch.poolSize");
   nsCOMPtr<nsIObserverService> os = services::GetObserverService();
   if (os) {
     os->AddObserver(this, "ipc:content-shutdown",
@@ -111,7 +127,7 @@ PreallocatedProcessManagerImpl::Observe(nsISupports* aSubject,
   if (!strcmp("ipc:content-shutdown", aTopic)) {
     ObserveProcessShutdown(aSubject);
   } else if (!strcmp("nsPref:changed", aTopic)) {
-    // The only other observer we registered was for our prefs.
+    // The only other observers we registered were for our prefs.
     RereadPrefs();
   } else if (!strcmp(NS_XPCOM_SHUTDOWN_OBSERVER_ID, aTopic)) {
     mShutdown = true;
@@ -125,8 +141,19 @@ PreallocatedProcessManagerImpl::Observe(nsISupports* aSubject,
 void
 PreallocatedProcessManagerImpl::RereadPrefs()
 {
+  bool wasEnabled = mEnabled;
+  uint32_t oldPoolSize = mPoolSize;
+  mPoolSize = std::max(1u,
+    Preferences::GetUint("dom.ipc.processPrelaunch.poolSize",
+                         DEFAULT_POOL_SIZE));
+
   if (Preferences::GetBool("dom.ipc.processPrelaunch.enabled")) {
     Enable();
+    if (mPoolSize < oldPoolSize) {
+      ShrinkPool();
+    } else if (wasEnabled && mPoolSize > oldPoolSize) {
+      AllocateAfterDelay();
+    }
   } else {
     Disable();
   }
@@ -135,7 +162,25 @@ PreallocatedProcessManagerImpl::RereadPrefs()
 already_AddRefed<ContentParent>
 PreallocatedProcessManagerImpl::Take()
 {
-  return mPreallocatedAppProcess.forget();
+  if (mPreallocatedAppProcesses.IsEmpty()) {
+    return nullptr;
+  }
+
+  RefPtr<ContentParent> process = mPreallocatedAppProcesses[0];
+  mPreallocatedAppProcesses.RemoveElementAt(0);
+  return process.forget();
+}
+
+void
+PreallocatedProcessManagerImpl::ShrinkPool()
+{
+  // Kill the most recently launched processes first; the older ones are
+  // more likely to be done starting up.
+  while (mPreallocatedAppProcesses.Length() > mPoolSize) {
+    mPreallocatedAppProcesses.LastElement()->Close();
+    mPreallocatedAppProcesses.RemoveElementAt(
+      mPreallocatedAppProcesses.Length() - 1);
+  }
 }
 
 void
@@ -152,7 +197,7 @@ PreallocatedProcessManagerImpl::Enable()
 void
 PreallocatedProcessManagerImpl::AllocateAfterDelay()
 {
-  if (!mEnabled || mPreallocatedAppProcess) {
+  if (!mEnabled || IsPoolFull()) {
     return;
   }
 
@@ -165,7 +210,7 @@ PreallocatedProcessManagerImpl::AllocateAfterDelay()
 void
 PreallocatedProcessManagerImpl::AllocateOnIdle()
 {
-  if (!mEnabled || mPreallocatedAppProcess) {
+  if (!mEnabled || IsPoolFull()) {
     return;
   }
 
@@ -175,11 +220,19 @@ PreallocatedProcessManagerImpl::AllocateOnIdle()
 void
 PreallocatedProcessManagerImpl::AllocateNow()
 {
-  if (!mEnabled || mPreallocatedAppProcess) {
+  if (!mEnabled || IsPoolFull()) {
     return;
   }
 
-  mPreallocatedAppProcess = ContentParent::PreallocateAppProcess();
+  RefPtr<ContentParent> process = ContentParent::PreallocateAppProcess();
+  if (!process) {
+    return;
+  }
+  mPreallocatedAppProcesses.AppendElement(process);
+
+  // Preallocated processes don't send FirstIdle until they are used, so keep
+  // filling the pool from here, one delayed launch at a time.
+  AllocateAfterDelay();
 }
 
 void
@@ -191,16 +244,16 @@ PreallocatedProcessManagerImpl::Disable()
 
   mEnabled = false;
 
-  if (mPreallocatedAppProcess) {
-    mPreallocatedAppProcess->Close();
-    mPreallocatedAppProcess = nullptr;
+  for (uint32_t i = 0; i < mPreallocatedAppProcesses.Length(); i++) {
+    mPreallocatedAppProcesses[i]->Close();
   }
+  mPreallocatedAppProcesses.Clear();
 }
 
 void
 PreallocatedProcessManagerImpl::ObserveProcessShutdown(nsISupports* aSubject)
 {
-  if (!mPreallocatedAppProcess) {
+  if (mPreallocatedAppProcesses.IsEmpty()) {
     return;
   }
 
@@ -211,8 +264,11 @@ PreallocatedProcessManagerImpl::ObserveProcessShutdown(nsISupports* aSubject)
   props->GetPropertyAsUint64(NS_LITERAL_STRING("childID"), &childID);
   NS_ENSURE_TRUE_VOID(childID != CONTENT_PROCESS_ID_UNKNOWN);
 
-  if (childID == mPreallocatedAppProcess->ChildID()) {
-    mPreallocatedAppProcess = nullptr;
+  for (uint32_t i = 0; i < mPreallocatedAppProcesses.Length(); i++) {
+    if (childID == mPreallocatedAppProcesses[i]->ChildID()) {
+      mPreallocatedAppProcesses.RemoveElementAt(i);
+      return;
+    }
   }
 }
 
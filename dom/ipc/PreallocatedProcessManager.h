@@ -17,14 +17,20 @@ class ContentParent;
 } // namespace dom
 
 /**
- * This class manages a ContentParent that it starts up ahead of any particular
- * need.  You can then call Take() to get this process and use it.  Since we
- * already started it up, it should be ready for use faster than if you'd
- * created the process when you needed it.
+ * This class manages a pool of ContentParents that it starts up ahead of any
+ * particular need.  You can then call Take() to get one of these processes and
+ * use it.  Since we already started it up, it should be ready for use faster
+ * than if you'd created the process when you needed it.
  *
  * This class watches the dom.ipc.processPrelaunch.enabled pref.  If it changes
  * from false to true, it preallocates a process.  If it changes from true to
- * false, it kills the preallocated process, if any.
+ * false, it kills the preallocated processes, if any.
+ *
+ * The dom.ipc.processPrelaunch.poolSize pref (default 1) sets how many
+ * preallocated processes we keep around, so that opening several tabs in
+ * quick succession doesn't exhaust the pool after the first one.  Processes
+ * are launched one at a time, each after the usual delay and idle wait, so
+ * that filling the pool doesn't compete with content loading.
  *
  * We don't expect this pref to flip between true and false in production, but
  * flipping the pref is important for tests.
@@ -44,37 +50,34 @@ public:
    * by the dom.ipc.processPrelaunch.delayMs pref), then wait for this process
    * to go idle, then allocate the new process.
    *
-   * If the dom.ipc.processPrelaunch.enabled pref is false, or if we already
-   * have a preallocated process, this function does nothing.
+   * If the dom.ipc.processPrelaunch.enabled pref is false, or if the pool of
+   * preallocated processes is already full, this function does nothing.
    */
   static void AllocateAfterDelay();
 
   /**
    * Create a process once this process goes idle.
    *
-   * If the dom.ipc.processPrelaunch.enabled pref is false, or if we already
-   * have a preallocated process, this function does nothing.
+   * If the dom.ipc.processPrelaunch.enabled pref is false, or if the pool of
+   * preallocated processes is already full, this function does nothing.
    */
   static void AllocateOnIdle();
 
   /**
    * Create a process right now.
    *
-   * If the dom.ipc.processPrelaunch.enabled pref is false, or if we already
-   * have a preallocated process, this function does nothing.
+   * If the dom.ipc.processPrelaunch.enabled pref is false, or if the pool of
+   * preallocated processes is already full, this function does nothing.
    */
   static void AllocateNow();
 
   /**
-   * Take the preallocated process, if we have one.  If we don't have one, this
-   * returns null.
-   *
-   * If you call Take() twice in a row, the second call is guaranteed to return
-   * null.
+   * Take a preallocated process, if we have one.  If we don't have one, this
+   * returns null.  The oldest process of the pool is returned first.
    *
-   * After you Take() the preallocated process, you need to call one of the
-   * Allocate* functions (or change the dom.ipc.processPrelaunch pref from
-   * false to true) before we'll create a new process.
+   * Once the pool is empty, further calls to Take() return null until one of
+   * the Allocate* functions is called (or the dom.ipc.processPrelaunch pref
+   * changes from false to true).
    */
   static already_AddRefed<ContentParent> Take();
 
@@ -5,6 +5,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "AudioConverter.h"
+#include "AudioSampleKernels.h"
 #include <string.h>
 #include <speex/speex_resampler.h>
 #include <cmath>
@@ -216,15 +217,10 @@ AudioConverter::DownmixAudio(void* aOut, const void* aIn, size_t aFrames) const
   }
 
   if (mOut.Channels() == 1) {
+    MOZ_ASSERT(channels == 2);
     if (mIn.Format() == AudioConfig::FORMAT_FLT) {
-      const float* in = static_cast<const float*>(aIn);
-      float* out = static_cast<float*>(aOut);
-      for (size_t fIdx = 0; fIdx < aFrames; ++fIdx) {
-        float sample = 0.0;
-        // The sample of the buffer would be interleaved.
-        sample = (in[fIdx*channels] + in[fIdx*channels + 1]) * 0.5;
-        *out++ = sample;
-      }
+      AudioSamplesDownmixStereoToMono(static_cast<const float*>(aIn),
+                                      static_cast<float*>(aOut), aFrames);
     } else if (mIn.Format() == AudioConfig::FORMAT_S16) {
       const int16_t* in = static_cast<const int16_t*>(aIn);
       int16_t* out = static_cast<int16_t*>(aOut);
@@ -335,13 +331,9 @@ AudioConverter::UpmixAudio(void* aOut, const void* aIn, size_t aFrames) const
   if (mIn.Format() == AudioConfig::FORMAT_FLT) {
     const float m3db = std::sqrt(0.5); // -3dB = sqrt(1/2)
     const float* in = static_cast<const float*>(aIn);
-    float* out = static_cast<float*>(aOut);
-    for (size_t fIdx = 0; fIdx < aFrames; ++fIdx) {
-      float sample = in[fIdx] * m3db;
-      // The samples of the buffer would be interleaved.
-      *out++ = sample;
-      *out++ = sample;
-    }
+    const float* channels[2] = { in, in };
+    AudioSamplesInterleave(channels, 2, aFrames, m3db,
+                           static_cast<float*>(aOut));
   } else if (mIn.Format() == AudioConfig::FORMAT_S16) {
     const int16_t* in = static_cast<const int16_t*>(aIn);
     int16_t* out = static_cast<int16_t*>(aOut);
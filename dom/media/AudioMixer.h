@@ -7,6 +7,9 @@
 #define MOZILLA_AUDIOMIXER_H_
 
 #include "AudioSampleFormat.h"
+#ifdef MOZILLA_INTERNAL_API
+#include "AudioSampleKernels.h"
+#endif
 #include "nsTArray.h"
 #include "mozilla/PodOperations.h"
 #include "mozilla/LinkedList.h"
@@ -89,9 +92,13 @@ public:
     MOZ_ASSERT(aChannels == mChannels);
     MOZ_ASSERT(aSampleRate == mSampleRate);
 
+#ifdef MOZILLA_INTERNAL_API
+    AudioSamplesAdd(aSamples, mMixedAudio.Elements(), aFrames * aChannels);
+#else
     for (uint32_t i = 0; i < aFrames * aChannels; i++) {
       mMixedAudio[i] += aSamples[i];
     }
+#endif
   }
 
   void AddCallback(MixerCallbackReceiver* aReceiver) {
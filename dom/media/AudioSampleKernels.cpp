@@ -0,0 +1,308 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim:set ts=2 sw=2 sts=2 et cindent: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "AudioSampleKernels.h"
+
+#include "AudioSampleFormat.h"
+#include "AudioSampleKernelsSIMD.h"
+#include "mozilla/PodOperations.h"
+#ifdef BUILD_ARM_NEON
+#include "mozilla/arm.h"
+#endif
+#if defined(USE_SSE2) || defined(USE_AVX2)
+#include "mozilla/SSE.h"
+#endif
+
+namespace mozilla {
+
+// Each function below hands as much of the buffer as it can to the widest
+// kernel the CPU supports, then to the narrower ones, and does the rest with
+// scalar code.
+
+void
+AudioSamplesAdd(const float* aInput, float* aOutput, uint32_t aCount)
+{
+  uint32_t i = 0;
+#ifdef USE_AVX2
+  if (mozilla::supports_avx2()) {
+    i += AudioSamplesAdd_AVX2(aInput, aOutput, aCount);
+  }
+#endif
+#ifdef USE_SSE2
+  if (mozilla::supports_sse2()) {
+    i += AudioSamplesAdd_SSE2(aInput + i, aOutput + i, aCount - i);
+  }
+#endif
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    i += AudioSamplesAdd_NEON(aInput, aOutput, aCount);
+  }
+#endif
+  for (; i < aCount; ++i) {
+    aOutput[i] += aInput[i];
+  }
+}
+
+void
+AudioSamplesAdd(const int16_t* aInput, int16_t* aOutput, uint32_t aCount)
+{
+  uint32_t i = 0;
+#ifdef USE_AVX2
+  if (mozilla::supports_avx2()) {
+    i += AudioSamplesAdd_AVX2(aInput, aOutput, aCount);
+  }
+#endif
+#ifdef USE_SSE2
+  if (mozilla::supports_sse2()) {
+    i += AudioSamplesAdd_SSE2(aInput + i, aOutput + i, aCount - i);
+  }
+#endif
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    i += AudioSamplesAdd_NEON(aInput, aOutput, aCount);
+  }
+#endif
+  for (; i < aCount; ++i) {
+    aOutput[i] += aInput[i];
+  }
+}
+
+void
+AudioSamplesScale(float* aBuffer, uint32_t aCount, float aScale)
+{
+  uint32_t i = 0;
+#ifdef USE_AVX2
+  if (mozilla::supports_avx2()) {
+    i += AudioSamplesScale_AVX2(aBuffer, aCount, aScale);
+  }
+#endif
+#ifdef USE_SSE2
+  if (mozilla::supports_sse2()) {
+    i += AudioSamplesScale_SSE2(aBuffer + i, aCount - i, aScale);
+  }
+#endif
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    i += AudioSamplesScale_NEON(aBuffer, aCount, aScale);
+  }
+#endif
+  for (; i < aCount; ++i) {
+    aBuffer[i] *= aScale;
+  }
+}
+
+void
+AudioSamplesConvert(const float* aInput, int16_t* aOutput, uint32_t aCount,
+                    float aScale)
+{
+  uint32_t i = 0;
+#ifdef USE_AVX2
+  if (mozilla::supports_avx2()) {
+    i += AudioSamplesConvert_AVX2(aInput, aOutput, aCount, aScale);
+  }
+#endif
+#ifdef USE_SSE2
+  if (mozilla::supports_sse2()) {
+    i += AudioSamplesConvert_SSE2(aInput + i, aOutput + i, aCount - i, aScale);
+  }
+#endif
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    i += AudioSamplesConvert_NEON(aInput, aOutput, aCount, aScale);
+  }
+#endif
+  for (; i < aCount; ++i) {
+    aOutput[i] = FloatToAudioSample<int16_t>(aInput[i] * aScale);
+  }
+}
+
+void
+AudioSamplesConvert(const int16_t* aInput, float* aOutput, uint32_t aCount,
+                    float aScale)
+{
+  uint32_t i = 0;
+#ifdef USE_AVX2
+  if (mozilla::supports_avx2()) {
+    i += AudioSamplesConvert_AVX2(aInput, aOutput, aCount, aScale);
+  }
+#endif
+#ifdef USE_SSE2
+  if (mozilla::supports_sse2()) {
+    i += AudioSamplesConvert_SSE2(aInput + i, aOutput + i, aCount - i, aScale);
+  }
+#endif
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    i += AudioSamplesConvert_NEON(aInput, aOutput, aCount, aScale);
+  }
+#endif
+  for (; i < aCount; ++i) {
+    aOutput[i] = AudioSampleToFloat(aInput[i]) * aScale;
+  }
+}
+
+static uint32_t
+InterleaveStereo(const float* aLeft, const float* aRight, uint32_t aFrames,
+                 float aVolume, float* aOutput)
+{
+  uint32_t i = 0;
+#ifdef USE_AVX2
+  if (mozilla::supports_avx2()) {
+    i += AudioSamplesInterleaveStereo_AVX2(aLeft, aRight, aFrames, aVolume,
+                                           aOutput);
+  }
+#endif
+#ifdef USE_SSE2
+  if (mozilla::supports_sse2()) {
+    i += AudioSamplesInterleaveStereo_SSE2(aLeft + i, aRight + i, aFrames - i,
+                                           aVolume, aOutput + 2 * i);
+  }
+#endif
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    i += AudioSamplesInterleaveStereo_NEON(aLeft, aRight, aFrames, aVolume,
+                                           aOutput);
+  }
+#endif
+  return i;
+}
+
+static uint32_t
+InterleaveStereo(const float* aLeft, const float* aRight, uint32_t aFrames,
+                 float aVolume, int16_t* aOutput)
+{
+  uint32_t i = 0;
+#ifdef USE_AVX2
+  if (mozilla::supports_avx2()) {
+    i += AudioSamplesInterleaveStereo_AVX2(aLeft, aRight, aFrames, aVolume,
+                                           aOutput);
+  }
+#endif
+#ifdef USE_SSE2
+  if (mozilla::supports_sse2()) {
+    i += AudioSamplesInterleaveStereo_SSE2(aLeft + i, aRight + i, aFrames - i,
+                                           aVolume, aOutput + 2 * i);
+  }
+#endif
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    i += AudioSamplesInterleaveStereo_NEON(aLeft, aRight, aFrames, aVolume,
+                                           aOutput);
+  }
+#endif
+  return i;
+}
+
+void
+AudioSamplesInterleave(const float* const* aInput, uint32_t aChannels,
+                       uint32_t aFrames, float aVolume, float* aOutput)
+{
+  if (aChannels == 1) {
+    PodCopy(aOutput, aInput[0], aFrames);
+    if (aVolume != 1.0f) {
+      AudioSamplesScale(aOutput, aFrames, aVolume);
+    }
+    return;
+  }
+
+  uint32_t i = 0;
+  if (aChannels == 2) {
+    i = InterleaveStereo(aInput[0], aInput[1], aFrames, aVolume, aOutput);
+  }
+  float* output = aOutput + i * aChannels;
+  for (; i < aFrames; ++i) {
+    for (uint32_t channel = 0; channel < aChannels; ++channel) {
+      *output++ = aInput[channel][i] * aVolume;
+    }
+  }
+}
+
+void
+AudioSamplesInterleave(const float* const* aInput, uint32_t aChannels,
+                       uint32_t aFrames, float aVolume, int16_t* aOutput)
+{
+  if (aChannels == 1) {
+    AudioSamplesConvert(aInput[0], aOutput, aFrames, aVolume);
+    return;
+  }
+
+  uint32_t i = 0;
+  if (aChannels == 2) {
+    i = InterleaveStereo(aInput[0], aInput[1], aFrames, aVolume, aOutput);
+  }
+  int16_t* output = aOutput + i * aChannels;
+  for (; i < aFrames; ++i) {
+    for (uint32_t channel = 0; channel < aChannels; ++channel) {
+      *output++ = FloatToAudioSample<int16_t>(aInput[channel][i] * aVolume);
+    }
+  }
+}
+
+void
+AudioSamplesDeinterleave(const float* aInput, uint32_t aChannels,
+                         uint32_t aFrames, float* const* aOutput)
+{
+  if (aChannels == 1) {
+    PodCopy(aOutput[0], aInput, aFrames);
+    return;
+  }
+
+  uint32_t i = 0;
+  if (aChannels == 2) {
+#ifdef USE_AVX2
+    if (mozilla::supports_avx2()) {
+      i += AudioSamplesDeinterleaveStereo_AVX2(aInput, aFrames,
+                                               aOutput[0], aOutput[1]);
+    }
+#endif
+#ifdef USE_SSE2
+    if (mozilla::supports_sse2()) {
+      i += AudioSamplesDeinterleaveStereo_SSE2(aInput + 2 * i, aFrames - i,
+                                               aOutput[0] + i, aOutput[1] + i);
+    }
+#endif
+#ifdef BUILD_ARM_NEON
+    if (mozilla::supports_neon()) {
+      i += AudioSamplesDeinterleaveStereo_NEON(aInput, aFrames,
+                                               aOutput[0], aOutput[1]);
+    }
+#endif
+  }
+  const float* input = aInput + i * aChannels;
+  for (; i < aFrames; ++i) {
+    for (uint32_t channel = 0; channel < aChannels; ++channel) {
+      aOutput[channel][i] = *input++;
+    }
+  }
+}
+
+void
+AudioSamplesDownmixStereoToMono(const float* aInput, float* aOutput,
+                                uint32_t aFrames)
+{
+  uint32_t i = 0;
+#ifdef USE_AVX2
+  if (mozilla::supports_avx2()) {
+    i += AudioSamplesDownmixStereoToMono_AVX2(aInput, aOutput, aFrames);
+  }
+#endif
+#ifdef USE_SSE2
+  if (mozilla::supports_sse2()) {
+    i += AudioSamplesDownmixStereoToMono_SSE2(aInput + 2 * i, aOutput + i,
+                                              aFrames - i);
+  }
+#endif
+#ifdef BUILD_ARM_NEON
+  if (mozilla::supports_neon()) {
+    i += AudioSamplesDownmixStereoToMono_NEON(aInput, aOutput, aFrames);
+  }
+#endif
+  for (; i < aFrames; ++i) {
+    aOutput[i] = (aInput[2 * i] + aInput[2 * i + 1]) * 0.5f;
+  }
+}
+
+} // namespace mozilla
@@ -0,0 +1,68 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim:set ts=2 sw=2 sts=2 et cindent: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef MOZILLA_AUDIOSAMPLEKERNELS_H_
+#define MOZILLA_AUDIOSAMPLEKERNELS_H_
+
+#include <stdint.h>
+
+namespace mozilla {
+
+/**
+ * Sample processing kernels shared by AudioSegment, AudioMixer and
+ * AudioConverter. Each of these picks the widest of the AVX2, SSE2 and NEON
+ * implementations the CPU supports at runtime, and falls back to scalar code
+ * for the remaining samples. None of them require aligned buffers.
+ *
+ * The results are identical to those of the scalar conversions in
+ * AudioSampleFormat.h, except for NaN inputs.
+ */
+
+/**
+ * aOutput[i] += aInput[i]. int16_t samples wrap around on overflow, like the
+ * scalar mixing code always did.
+ */
+void AudioSamplesAdd(const float* aInput, float* aOutput, uint32_t aCount);
+void AudioSamplesAdd(const int16_t* aInput, int16_t* aOutput, uint32_t aCount);
+
+/**
+ * aBuffer[i] *= aScale.
+ */
+void AudioSamplesScale(float* aBuffer, uint32_t aCount, float aScale);
+
+/**
+ * Converts between float and int16_t samples, applying aScale on the way.
+ */
+void AudioSamplesConvert(const float* aInput, int16_t* aOutput,
+                         uint32_t aCount, float aScale = 1.0f);
+void AudioSamplesConvert(const int16_t* aInput, float* aOutput,
+                         uint32_t aCount, float aScale = 1.0f);
+
+/**
+ * Interleaves aChannels planar channels of aFrames frames each into aOutput,
+ * applying aVolume. Mono and stereo have vectorized paths.
+ */
+void AudioSamplesInterleave(const float* const* aInput, uint32_t aChannels,
+                            uint32_t aFrames, float aVolume, float* aOutput);
+void AudioSamplesInterleave(const float* const* aInput, uint32_t aChannels,
+                            uint32_t aFrames, float aVolume, int16_t* aOutput);
+
+/**
+ * Splits aFrames interleaved frames of aChannels channels into planar
+ * channels. Stereo has a vectorized path.
+ */
+void AudioSamplesDeinterleave(const float* aInput, uint32_t aChannels,
+                              uint32_t aFrames, float* const* aOutput);
+
+/**
+ * Averages the two channels of aFrames interleaved stereo frames into
+ * aOutput, which may be the same buffer as aInput.
+ */
+void AudioSamplesDownmixStereoToMono(const float* aInput, float* aOutput,
+                                     uint32_t aFrames);
+
+} // namespace mozilla
+
+#endif /* MOZILLA_AUDIOSAMPLEKERNELS_H_ */
@@ -0,0 +1,184 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim:set ts=2 sw=2 sts=2 et cindent: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "AudioSampleKernelsSIMD.h"
+#include <immintrin.h>
+
+#ifndef USE_AVX2
+static_assert(false, "If this file is built, AudioSampleKernels.cpp should know about it!");
+#endif
+
+namespace mozilla {
+
+// See FloatToInt16 in AudioSampleKernelsSSE2.cpp. 256-bit packs work on each
+// 128-bit lane separately, so the 64-bit quarters need to be put back in order
+// afterwards.
+static inline __m256i
+FloatToInt16(__m256 aLow, __m256 aHigh, __m256 aScale)
+{
+  const __m256 max = _mm256_set1_ps(32767.0f);
+  const __m256 min = _mm256_set1_ps(-32768.0f);
+  aLow = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(aLow, aScale), max), min);
+  aHigh = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(aHigh, aScale), max), min);
+  __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(aLow),
+                                      _mm256_cvttps_epi32(aHigh));
+  return _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+// Interleaves eight frames into two vectors of four stereo frames each.
+static inline void
+Interleave(__m256 aLeft, __m256 aRight, __m256* aOut0, __m256* aOut1)
+{
+  __m256 low = _mm256_unpacklo_ps(aLeft, aRight);
+  __m256 high = _mm256_unpackhi_ps(aLeft, aRight);
+  *aOut0 = _mm256_permute2f128_ps(low, high, 0x20);
+  *aOut1 = _mm256_permute2f128_ps(low, high, 0x31);
+}
+
+// The reverse of Interleave.
+static inline void
+Deinterleave(__m256 aIn0, __m256 aIn1, __m256* aLeft, __m256* aRight)
+{
+  __m256d left = _mm256_castps_pd(
+    _mm256_shuffle_ps(aIn0, aIn1, _MM_SHUFFLE(2, 0, 2, 0)));
+  __m256d right = _mm256_castps_pd(
+    _mm256_shuffle_ps(aIn0, aIn1, _MM_SHUFFLE(3, 1, 3, 1)));
+  *aLeft = _mm256_castpd_ps(_mm256_permute4x64_pd(left, _MM_SHUFFLE(3, 1, 2, 0)));
+  *aRight = _mm256_castpd_ps(_mm256_permute4x64_pd(right, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+uint32_t
+AudioSamplesAdd_AVX2(const float* aInput, float* aOutput, uint32_t aCount)
+{
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    _mm256_storeu_ps(&aOutput[i], _mm256_add_ps(_mm256_loadu_ps(&aOutput[i]),
+                                                _mm256_loadu_ps(&aInput[i])));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesAdd_AVX2(const int16_t* aInput, int16_t* aOutput, uint32_t aCount)
+{
+  uint32_t count = aCount & ~15;
+  for (uint32_t i = 0; i < count; i += 16) {
+    __m256i in =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&aInput[i]));
+    __m256i out = _mm256_loadu_si256(reinterpret_cast<__m256i*>(&aOutput[i]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&aOutput[i]),
+                        _mm256_add_epi16(out, in));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesScale_AVX2(float* aBuffer, uint32_t aCount, float aScale)
+{
+  __m256 scale = _mm256_set1_ps(aScale);
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    _mm256_storeu_ps(&aBuffer[i],
+                     _mm256_mul_ps(_mm256_loadu_ps(&aBuffer[i]), scale));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesConvert_AVX2(const float* aInput, int16_t* aOutput,
+                         uint32_t aCount, float aScale)
+{
+  __m256 scale = _mm256_set1_ps(aScale * 32768.0f);
+  uint32_t count = aCount & ~15;
+  for (uint32_t i = 0; i < count; i += 16) {
+    __m256i out = FloatToInt16(_mm256_loadu_ps(&aInput[i]),
+                               _mm256_loadu_ps(&aInput[i + 8]), scale);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&aOutput[i]), out);
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesConvert_AVX2(const int16_t* aInput, float* aOutput,
+                         uint32_t aCount, float aScale)
+{
+  __m256 scale = _mm256_set1_ps(aScale / 32768.0f);
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&aInput[i]));
+    __m256 samples = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(in));
+    _mm256_storeu_ps(&aOutput[i], _mm256_mul_ps(samples, scale));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesInterleaveStereo_AVX2(const float* aLeft, const float* aRight,
+                                  uint32_t aFrames, float aVolume,
+                                  float* aOutput)
+{
+  __m256 volume = _mm256_set1_ps(aVolume);
+  uint32_t frames = aFrames & ~7;
+  for (uint32_t i = 0; i < frames; i += 8) {
+    __m256 out0, out1;
+    Interleave(_mm256_mul_ps(_mm256_loadu_ps(&aLeft[i]), volume),
+               _mm256_mul_ps(_mm256_loadu_ps(&aRight[i]), volume),
+               &out0, &out1);
+    _mm256_storeu_ps(&aOutput[2 * i], out0);
+    _mm256_storeu_ps(&aOutput[2 * i + 8], out1);
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesInterleaveStereo_AVX2(const float* aLeft, const float* aRight,
+                                  uint32_t aFrames, float aVolume,
+                                  int16_t* aOutput)
+{
+  __m256 scale = _mm256_set1_ps(aVolume * 32768.0f);
+  uint32_t frames = aFrames & ~7;
+  for (uint32_t i = 0; i < frames; i += 8) {
+    __m256 out0, out1;
+    Interleave(_mm256_loadu_ps(&aLeft[i]), _mm256_loadu_ps(&aRight[i]),
+               &out0, &out1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&aOutput[2 * i]),
+                        FloatToInt16(out0, out1, scale));
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesDeinterleaveStereo_AVX2(const float* aInput, uint32_t aFrames,
+                                    float* aLeft, float* aRight)
+{
+  uint32_t frames = aFrames & ~7;
+  for (uint32_t i = 0; i < frames; i += 8) {
+    __m256 left, right;
+    Deinterleave(_mm256_loadu_ps(&aInput[2 * i]),
+                 _mm256_loadu_ps(&aInput[2 * i + 8]), &left, &right);
+    _mm256_storeu_ps(&aLeft[i], left);
+    _mm256_storeu_ps(&aRight[i], right);
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesDownmixStereoToMono_AVX2(const float* aInput, float* aOutput,
+                                     uint32_t aFrames)
+{
+  const __m256 half = _mm256_set1_ps(0.5f);
+  uint32_t frames = aFrames & ~7;
+  for (uint32_t i = 0; i < frames; i += 8) {
+    // Load everything before storing, aOutput may alias aInput.
+    __m256 left, right;
+    Deinterleave(_mm256_loadu_ps(&aInput[2 * i]),
+                 _mm256_loadu_ps(&aInput[2 * i + 8]), &left, &right);
+    _mm256_storeu_ps(&aOutput[i], _mm256_mul_ps(_mm256_add_ps(left, right), half));
+  }
+  return frames;
+}
+
+} // namespace mozilla
@@ -0,0 +1,146 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim:set ts=2 sw=2 sts=2 et cindent: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "AudioSampleKernelsSIMD.h"
+#include <arm_neon.h>
+
+namespace mozilla {
+
+// Scales four float samples by aScale, which includes the factor of 32768,
+// and converts them to int16_t, clamping before truncating like
+// FloatToAudioSample<int16_t>.
+static inline int16x4_t
+FloatToInt16(float32x4_t aIn, float32x4_t aScale)
+{
+  float32x4_t v = vmulq_f32(aIn, aScale);
+  v = vmaxq_f32(vminq_f32(v, vdupq_n_f32(32767.0f)), vdupq_n_f32(-32768.0f));
+  return vqmovn_s32(vcvtq_s32_f32(v));
+}
+
+uint32_t
+AudioSamplesAdd_NEON(const float* aInput, float* aOutput, uint32_t aCount)
+{
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    float32x4_t out0 = vaddq_f32(vld1q_f32(&aOutput[i]), vld1q_f32(&aInput[i]));
+    float32x4_t out1 = vaddq_f32(vld1q_f32(&aOutput[i + 4]),
+                                 vld1q_f32(&aInput[i + 4]));
+    vst1q_f32(&aOutput[i], out0);
+    vst1q_f32(&aOutput[i + 4], out1);
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesAdd_NEON(const int16_t* aInput, int16_t* aOutput, uint32_t aCount)
+{
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    vst1q_s16(&aOutput[i], vaddq_s16(vld1q_s16(&aOutput[i]),
+                                     vld1q_s16(&aInput[i])));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesScale_NEON(float* aBuffer, uint32_t aCount, float aScale)
+{
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    vst1q_f32(&aBuffer[i], vmulq_n_f32(vld1q_f32(&aBuffer[i]), aScale));
+    vst1q_f32(&aBuffer[i + 4], vmulq_n_f32(vld1q_f32(&aBuffer[i + 4]), aScale));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesConvert_NEON(const float* aInput, int16_t* aOutput,
+                         uint32_t aCount, float aScale)
+{
+  float32x4_t scale = vdupq_n_f32(aScale * 32768.0f);
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    vst1q_s16(&aOutput[i],
+              vcombine_s16(FloatToInt16(vld1q_f32(&aInput[i]), scale),
+                           FloatToInt16(vld1q_f32(&aInput[i + 4]), scale)));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesConvert_NEON(const int16_t* aInput, float* aOutput,
+                         uint32_t aCount, float aScale)
+{
+  float scale = aScale / 32768.0f;
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    int16x8_t in = vld1q_s16(&aInput[i]);
+    float32x4_t low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(in)));
+    float32x4_t high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(in)));
+    vst1q_f32(&aOutput[i], vmulq_n_f32(low, scale));
+    vst1q_f32(&aOutput[i + 4], vmulq_n_f32(high, scale));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesInterleaveStereo_NEON(const float* aLeft, const float* aRight,
+                                  uint32_t aFrames, float aVolume,
+                                  float* aOutput)
+{
+  uint32_t frames = aFrames & ~3;
+  for (uint32_t i = 0; i < frames; i += 4) {
+    float32x4x2_t out;
+    out.val[0] = vmulq_n_f32(vld1q_f32(&aLeft[i]), aVolume);
+    out.val[1] = vmulq_n_f32(vld1q_f32(&aRight[i]), aVolume);
+    vst2q_f32(&aOutput[2 * i], out);
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesInterleaveStereo_NEON(const float* aLeft, const float* aRight,
+                                  uint32_t aFrames, float aVolume,
+                                  int16_t* aOutput)
+{
+  float32x4_t scale = vdupq_n_f32(aVolume * 32768.0f);
+  uint32_t frames = aFrames & ~3;
+  for (uint32_t i = 0; i < frames; i += 4) {
+    int16x4x2_t out;
+    out.val[0] = FloatToInt16(vld1q_f32(&aLeft[i]), scale);
+    out.val[1] = FloatToInt16(vld1q_f32(&aRight[i]), scale);
+    vst2_s16(&aOutput[2 * i], out);
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesDeinterleaveStereo_NEON(const float* aInput, uint32_t aFrames,
+                                    float* aLeft, float* aRight)
+{
+  uint32_t frames = aFrames & ~3;
+  for (uint32_t i = 0; i < frames; i += 4) {
+    float32x4x2_t in = vld2q_f32(&aInput[2 * i]);
+    vst1q_f32(&aLeft[i], in.val[0]);
+    vst1q_f32(&aRight[i], in.val[1]);
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesDownmixStereoToMono_NEON(const float* aInput, float* aOutput,
+                                     uint32_t aFrames)
+{
+  uint32_t frames = aFrames & ~3;
+  for (uint32_t i = 0; i < frames; i += 4) {
+    // vld2q_f32 loads everything before we store, aOutput may alias aInput.
+    float32x4x2_t in = vld2q_f32(&aInput[2 * i]);
+    vst1q_f32(&aOutput[i], vmulq_n_f32(vaddq_f32(in.val[0], in.val[1]), 0.5f));
+  }
+  return frames;
+}
+
+} // namespace mozilla
@@ -0,0 +1,102 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim:set ts=2 sw=2 sts=2 et cindent: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef MOZILLA_AUDIOSAMPLEKERNELSSIMD_H_
+#define MOZILLA_AUDIOSAMPLEKERNELSSIMD_H_
+
+#include <stdint.h>
+
+namespace mozilla {
+
+/**
+ * The vectorized parts of the AudioSampleKernels.h functions. Only call these
+ * after checking that the CPU supports the instruction set.
+ *
+ * Each of them processes as many samples (or, for the stereo functions,
+ * frames) as fit in whole vectors, and returns how many that was. The caller
+ * takes care of the rest.
+ */
+
+#ifdef USE_SSE2
+uint32_t AudioSamplesAdd_SSE2(const float* aInput, float* aOutput,
+                              uint32_t aCount);
+uint32_t AudioSamplesAdd_SSE2(const int16_t* aInput, int16_t* aOutput,
+                              uint32_t aCount);
+uint32_t AudioSamplesScale_SSE2(float* aBuffer, uint32_t aCount, float aScale);
+uint32_t AudioSamplesConvert_SSE2(const float* aInput, int16_t* aOutput,
+                                  uint32_t aCount, float aScale);
+uint32_t AudioSamplesConvert_SSE2(const int16_t* aInput, float* aOutput,
+                                  uint32_t aCount, float aScale);
+uint32_t AudioSamplesInterleaveStereo_SSE2(const float* aLeft,
+                                           const float* aRight,
+                                           uint32_t aFrames, float aVolume,
+                                           float* aOutput);
+uint32_t AudioSamplesInterleaveStereo_SSE2(const float* aLeft,
+                                           const float* aRight,
+                                           uint32_t aFrames, float aVolume,
+                                           int16_t* aOutput);
+uint32_t AudioSamplesDeinterleaveStereo_SSE2(const float* aInput,
+                                             uint32_t aFrames,
+                                             float* aLeft, float* aRight);
+uint32_t AudioSamplesDownmixStereoToMono_SSE2(const float* aInput,
+                                              float* aOutput,
+                                              uint32_t aFrames);
+#endif
+
+#ifdef USE_AVX2
+uint32_t AudioSamplesAdd_AVX2(const float* aInput, float* aOutput,
+                              uint32_t aCount);
+uint32_t AudioSamplesAdd_AVX2(const int16_t* aInput, int16_t* aOutput,
+                              uint32_t aCount);
+uint32_t AudioSamplesScale_AVX2(float* aBuffer, uint32_t aCount, float aScale);
+uint32_t AudioSamplesConvert_AVX2(const float* aInput, int16_t* aOutput,
+                                  uint32_t aCount, float aScale);
+uint32_t AudioSamplesConvert_AVX2(const int16_t* aInput, float* aOutput,
+                                  uint32_t aCount, float aScale);
+uint32_t AudioSamplesInterleaveStereo_AVX2(const float* aLeft,
+                                           const float* aRight,
+                                           uint32_t aFrames, float aVolume,
+                                           float* aOutput);
+uint32_t AudioSamplesInterleaveStereo_AVX2(const float* aLeft,
+                                           const float* aRight,
+                                           uint32_t aFrames, float aVolume,
+                                           int16_t* aOutput);
+uint32_t AudioSamplesDeinterleaveStereo_AVX2(const float* aInput,
+                                             uint32_t aFrames,
+                                             float* aLeft, float* aRight);
+uint32_t AudioSamplesDownmixStereoToMono_AVX2(const float* aInput,
+                                              float* aOutput,
+                                              uint32_t aFrames);
+#endif
+
+#ifdef BUILD_ARM_NEON
+uint32_t AudioSamplesAdd_NEON(const float* aInput, float* aOutput,
+                              uint32_t aCount);
+uint32_t AudioSamplesAdd_NEON(const int16_t* aInput, int16_t* aOutput,
+                              uint32_t aCount);
+uint32_t AudioSamplesScale_NEON(float* aBuffer, uint32_t aCount, float aScale);
+uint32_t AudioSamplesConvert_NEON(const float* aInput, int16_t* aOutput,
+                                  uint32_t aCount, float aScale);
+uint32_t AudioSamplesConvert_NEON(const int16_t* aInput, float* aOutput,
+                                  uint32_t aCount, float aScale);
+uint32_t AudioSamplesInterleaveStereo_NEON(const float* aLeft,
+                                           const float* aRight,
+                                           uint32_t aFrames, float aVolume,
+                                           float* aOutput);
+uint32_t AudioSamplesInterleaveStereo_NEON(const float* aLeft,
+                                           const float* aRight,
+                                           uint32_t aFrames, float aVolume,
+                                           int16_t* aOutput);
+uint32_t AudioSamplesDeinterleaveStereo_NEON(const float* aInput,
+                                             uint32_t aFrames,
+                                             float* aLeft, float* aRight);
+uint32_t AudioSamplesDownmixStereoToMono_NEON(const float* aInput,
+                                              float* aOutput,
+                                              uint32_t aFrames);
+#endif
+
+} // namespace mozilla
+
+#endif /* MOZILLA_AUDIOSAMPLEKERNELSSIMD_H_ */
@@ -0,0 +1,162 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim:set ts=2 sw=2 sts=2 et cindent: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "AudioSampleKernelsSIMD.h"
+#include <emmintrin.h>
+
+namespace mozilla {
+
+// Scales two vectors of float samples by aScale, which includes the factor of
+// 32768, and converts them to eight int16_t samples. This clamps before
+// truncating, like FloatToAudioSample<int16_t>.
+static inline __m128i
+FloatToInt16(__m128 aLow, __m128 aHigh, __m128 aScale)
+{
+  const __m128 max = _mm_set1_ps(32767.0f);
+  const __m128 min = _mm_set1_ps(-32768.0f);
+  aLow = _mm_max_ps(_mm_min_ps(_mm_mul_ps(aLow, aScale), max), min);
+  aHigh = _mm_max_ps(_mm_min_ps(_mm_mul_ps(aHigh, aScale), max), min);
+  return _mm_packs_epi32(_mm_cvttps_epi32(aLow), _mm_cvttps_epi32(aHigh));
+}
+
+uint32_t
+AudioSamplesAdd_SSE2(const float* aInput, float* aOutput, uint32_t aCount)
+{
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    __m128 out0 = _mm_add_ps(_mm_loadu_ps(&aOutput[i]),
+                             _mm_loadu_ps(&aInput[i]));
+    __m128 out1 = _mm_add_ps(_mm_loadu_ps(&aOutput[i + 4]),
+                             _mm_loadu_ps(&aInput[i + 4]));
+    _mm_storeu_ps(&aOutput[i], out0);
+    _mm_storeu_ps(&aOutput[i + 4], out1);
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesAdd_SSE2(const int16_t* aInput, int16_t* aOutput, uint32_t aCount)
+{
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&aInput[i]));
+    __m128i out = _mm_loadu_si128(reinterpret_cast<__m128i*>(&aOutput[i]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&aOutput[i]),
+                     _mm_add_epi16(out, in));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesScale_SSE2(float* aBuffer, uint32_t aCount, float aScale)
+{
+  __m128 scale = _mm_set1_ps(aScale);
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    _mm_storeu_ps(&aBuffer[i], _mm_mul_ps(_mm_loadu_ps(&aBuffer[i]), scale));
+    _mm_storeu_ps(&aBuffer[i + 4],
+                  _mm_mul_ps(_mm_loadu_ps(&aBuffer[i + 4]), scale));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesConvert_SSE2(const float* aInput, int16_t* aOutput,
+                         uint32_t aCount, float aScale)
+{
+  __m128 scale = _mm_set1_ps(aScale * 32768.0f);
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    __m128i out = FloatToInt16(_mm_loadu_ps(&aInput[i]),
+                               _mm_loadu_ps(&aInput[i + 4]), scale);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&aOutput[i]), out);
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesConvert_SSE2(const int16_t* aInput, float* aOutput,
+                         uint32_t aCount, float aScale)
+{
+  __m128 scale = _mm_set1_ps(aScale / 32768.0f);
+  uint32_t count = aCount & ~7;
+  for (uint32_t i = 0; i < count; i += 8) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&aInput[i]));
+    // Sign extend to 32 bits by unpacking into the high halves and shifting
+    // back down.
+    __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+    __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+    _mm_storeu_ps(&aOutput[i], _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+    _mm_storeu_ps(&aOutput[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+  }
+  return count;
+}
+
+uint32_t
+AudioSamplesInterleaveStereo_SSE2(const float* aLeft, const float* aRight,
+                                  uint32_t aFrames, float aVolume,
+                                  float* aOutput)
+{
+  __m128 volume = _mm_set1_ps(aVolume);
+  uint32_t frames = aFrames & ~3;
+  for (uint32_t i = 0; i < frames; i += 4) {
+    __m128 left = _mm_mul_ps(_mm_loadu_ps(&aLeft[i]), volume);
+    __m128 right = _mm_mul_ps(_mm_loadu_ps(&aRight[i]), volume);
+    _mm_storeu_ps(&aOutput[2 * i], _mm_unpacklo_ps(left, right));
+    _mm_storeu_ps(&aOutput[2 * i + 4], _mm_unpackhi_ps(left, right));
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesInterleaveStereo_SSE2(const float* aLeft, const float* aRight,
+                                  uint32_t aFrames, float aVolume,
+                                  int16_t* aOutput)
+{
+  __m128 scale = _mm_set1_ps(aVolume * 32768.0f);
+  uint32_t frames = aFrames & ~3;
+  for (uint32_t i = 0; i < frames; i += 4) {
+    __m128 left = _mm_loadu_ps(&aLeft[i]);
+    __m128 right = _mm_loadu_ps(&aRight[i]);
+    __m128i out = FloatToInt16(_mm_unpacklo_ps(left, right),
+                               _mm_unpackhi_ps(left, right), scale);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&aOutput[2 * i]), out);
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesDeinterleaveStereo_SSE2(const float* aInput, uint32_t aFrames,
+                                    float* aLeft, float* aRight)
+{
+  uint32_t frames = aFrames & ~3;
+  for (uint32_t i = 0; i < frames; i += 4) {
+    __m128 in0 = _mm_loadu_ps(&aInput[2 * i]);
+    __m128 in1 = _mm_loadu_ps(&aInput[2 * i + 4]);
+    _mm_storeu_ps(&aLeft[i], _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(&aRight[i], _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  return frames;
+}
+
+uint32_t
+AudioSamplesDownmixStereoToMono_SSE2(const float* aInput, float* aOutput,
+                                     uint32_t aFrames)
+{
+  const __m128 half = _mm_set1_ps(0.5f);
+  uint32_t frames = aFrames & ~3;
+  for (uint32_t i = 0; i < frames; i += 4) {
+    // Load everything before storing, aOutput may alias aInput.
+    __m128 in0 = _mm_loadu_ps(&aInput[2 * i]);
+    __m128 in1 = _mm_loadu_ps(&aInput[2 * i + 4]);
+    __m128 left = _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 right = _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(&aOutput[i], _mm_mul_ps(_mm_add_ps(left, right), half));
+  }
+  return frames;
+}
+
+} // namespace mozilla
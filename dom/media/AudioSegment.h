@@ -12,6 +12,7 @@
 #include "SharedBuffer.h"
 #include "WebAudioUtils.h"
 #ifdef MOZILLA_INTERNAL_API
+#include "AudioSampleKernels.h"
 #include "mozilla/TimeStamp.h"
 #endif
 #include <float.h>
@@ -90,6 +91,38 @@ DeinterleaveAndConvertBuffer(const SrcT* aSourceBuffer,
   }
 }
 
+#ifdef MOZILLA_INTERNAL_API
+// Float sources, by far the most common case, use the vectorized kernels.
+// These have to be declared before the templates below that call them.
+inline void
+InterleaveAndConvertBuffer(const float* const* aSourceChannels,
+                           uint32_t aLength, float aVolume,
+                           uint32_t aChannels,
+                           float* aOutput)
+{
+  AudioSamplesInterleave(aSourceChannels, aChannels, aLength, aVolume,
+                         aOutput);
+}
+
+inline void
+InterleaveAndConvertBuffer(const float* const* aSourceChannels,
+                           uint32_t aLength, float aVolume,
+                           uint32_t aChannels,
+                           int16_t* aOutput)
+{
+  AudioSamplesInterleave(aSourceChannels, aChannels, aLength, aVolume,
+                         aOutput);
+}
+
+inline void
+DeinterleaveAndConvertBuffer(const float* aSourceBuffer,
+                             uint32_t aFrames, uint32_t aChannels,
+                             float** aOutput)
+{
+  AudioSamplesDeinterleave(aSourceBuffer, aChannels, aFrames, aOutput);
+}
+#endif
+
 class SilentChannel
 {
 public:
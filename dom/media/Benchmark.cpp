@@ -6,6 +6,8 @@
 
 #include "Benchmark.h"
 #include "BufferMediaResource.h"
+#include "DecoderTraits.h"
+#include "ImageContainer.h"
 #include "MediaData.h"
 #include "MediaPrefs.h"
 #include "PDMFactory.h"
@@ -13,6 +15,8 @@
 #include "mozilla/Preferences.h"
 #include "mozilla/Telemetry.h"
 #include "mozilla/dom/ContentChild.h"
+#include "nsIFile.h"
+#include "nsNetUtil.h"
 
 #ifndef MOZ_WIDGET_ANDROID
 #include "WebMSample.h"
@@ -57,18 +61,19 @@ VP9Benchmark::IsVP9DecodeFast()
                     });
     estimiser->Run()->Then(
       AbstractThread::MainThread(), __func__,
-      [](uint32_t aDecodeFps) {
+      [](const Benchmark::Result& aResult) {
+        uint32_t decodeFps = aResult.mDecodeFps;
         if (XRE_IsContentProcess()) {
           dom::ContentChild* contentChild = dom::ContentChild::GetSingleton();
           if (contentChild) {
             contentChild->SendNotifyBenchmarkResult(NS_LITERAL_STRING("VP9"),
-                                                    aDecodeFps);
+                                                    decodeFps);
           }
         } else {
-          Preferences::SetUint(sBenchmarkFpsPref, aDecodeFps);
+          Preferences::SetUint(sBenchmarkFpsPref, decodeFps);
           Preferences::SetUint(sBenchmarkFpsVersionCheck, sBenchmarkVersionID);
         }
-        Telemetry::Accumulate(Telemetry::ID::VIDEO_VP9_BENCHMARK_FPS, aDecodeFps);
+        Telemetry::Accumulate(Telemetry::ID::VIDEO_VP9_BENCHMARK_FPS, decodeFps);
       },
       []() { });
   }
@@ -113,11 +118,11 @@ Benchmark::Run()
 }
 
 void
-Benchmark::ReturnResult(uint32_t aDecodeFps)
+Benchmark::ReturnResult(const Result& aResult)
 {
   MOZ_ASSERT(OnThread());
 
-  mPromise.ResolveIfExists(aDecodeFps, __func__);
+  mPromise.ResolveIfExists(aResult, __func__);
 }
 
 void
@@ -147,6 +152,9 @@ BenchmarkPlayback::BenchmarkPlayback(Benchmark* aMainThreadState,
   , mSampleIndex(0)
   , mFrameCount(0)
   , mFinished(false)
+  , mImageCopyCount(0)
+  , mOutputBytes(0)
+  , mIsHardwareAccelerated(false)
 {
   MOZ_ASSERT(static_cast<Benchmark*>(mMainThreadState)->OnThread());
 }
@@ -162,7 +170,7 @@ BenchmarkPlayback::DemuxSamples()
     [this, ref](nsresult aResult) {
       MOZ_ASSERT(OnThread());
       mTrackDemuxer =
-        mDemuxer->GetTrackDemuxer(TrackInfo::kVideoTrack, 0);
+        mDemuxer->GetTrackDemuxer(ref->mParameters.mTrackType, 0);
       if (!mTrackDemuxer) {
         MainThreadShutdown();
         return;
@@ -206,16 +214,32 @@ BenchmarkPlayback::InitDecoder(TrackInfo&& aInfo)
 {
   MOZ_ASSERT(OnThread());
 
+  RefPtr<Benchmark> ref(mMainThreadState);
+  if (ref->mParameters.mMeasureImageCopy) {
+    mImageContainer =
+      new layers::ImageContainer(layers::ImageContainer::SYNCHRONOUS);
+  }
+
   RefPtr<PDMFactory> platform = new PDMFactory();
-  mDecoder = platform->CreateDecoder({ aInfo, mDecoderTaskQueue, reinterpret_cast<MediaDataDecoderCallback*>(this) });
+  CreateDecoderParams params(aInfo, mDecoderTaskQueue,
+                             reinterpret_cast<MediaDataDecoderCallback*>(this));
+  params.mImageContainer = mImageContainer;
+  if (ref->mParameters.mDecoderName.IsEmpty()) {
+    mDecoder = platform->CreateDecoder(params);
+  } else {
+    mDecoder =
+      platform->CreateDecoderNamed(params, ref->mParameters.mDecoderName);
+  }
   if (!mDecoder) {
     MainThreadShutdown();
     return;
   }
-  RefPtr<Benchmark> ref(mMainThreadState);
   mDecoder->Init()->Then(
     Thread(), __func__,
     [this, ref](TrackInfo::TrackType aTrackType) {
+      mDecoderName = mDecoder->GetDescriptionName();
+      nsAutoCString failureReason;
+      mIsHardwareAccelerated = mDecoder->IsHardwareAccelerated(failureReason);
       InputExhausted();
     },
     [this, ref](MediaResult aError) {
@@ -257,25 +281,132 @@ BenchmarkPlayback::MainThreadShutdown()
     []() { MOZ_CRASH("not reached"); });
 }
 
+MOZ_DEFINE_MALLOC_SIZE_OF(BenchmarkMallocSizeOf)
+
+void
+BenchmarkPlayback::InputSample(MediaRawData* aSample)
+{
+  MOZ_ASSERT(OnThread());
+
+  // Don't grow forever if the decoder doesn't keep the sample times.
+  static const size_t kMaxPendingInputs = 64;
+  if (mPendingInputs.Length() >= kMaxPendingInputs) {
+    mPendingInputs.RemoveElementAt(0);
+  }
+  mPendingInputs.AppendElement(MakePair(aSample->mTime, TimeStamp::Now()));
+  mDecoder->Input(aSample);
+}
+
+void
+BenchmarkPlayback::MeasureOutput(MediaData* aData)
+{
+  MOZ_ASSERT(OnThread());
+
+  // Decoders may reorder frames, so look for the input with the same time.
+  TimeDuration latency;
+  bool foundInput = false;
+  for (size_t i = 0; i < mPendingInputs.Length(); i++) {
+    if (mPendingInputs[i].first() == aData->mTime) {
+      latency = TimeStamp::Now() - mPendingInputs[i].second();
+      mPendingInputs.RemoveElementAt(i);
+      foundInput = true;
+      break;
+    }
+  }
+
+  RefPtr<Benchmark> ref(mMainThreadState);
+  if (mFrameCount <= ref->mParameters.mStartupFrame) {
+    return;
+  }
+
+  if (foundInput) {
+    mLatencies.AppendElement(latency);
+  }
+
+  if (aData->mType == MediaData::VIDEO_DATA) {
+    VideoData* video = static_cast<VideoData*>(aData);
+    mOutputBytes += video->SizeOfIncludingThis(BenchmarkMallocSizeOf);
+
+    layers::PlanarYCbCrImage* image =
+      video->mImage ? video->mImage->AsPlanarYCbCrImage() : nullptr;
+    if (mImageContainer && image && image->GetData()) {
+      // Do the same copy that the decoders do for each frame they output.
+      TimeStamp start = TimeStamp::Now();
+      RefPtr<layers::PlanarYCbCrImage> copy =
+        mImageContainer->CreatePlanarYCbCrImage();
+      if (copy && copy->CopyData(*image->GetData())) {
+        mImageCopyTime += TimeStamp::Now() - start;
+        mImageCopyCount++;
+      }
+    }
+  } else if (aData->mType == MediaData::AUDIO_DATA) {
+    AudioData* audio = static_cast<AudioData*>(aData);
+    mOutputBytes += audio->SizeOfIncludingThis(BenchmarkMallocSizeOf);
+  }
+}
+
+static TimeDuration
+Percentile(const nsTArray<TimeDuration>& aSorted, double aPercentile)
+{
+  if (aSorted.IsEmpty()) {
+    return TimeDuration();
+  }
+  size_t index = std::min(size_t(aSorted.Length() * aPercentile),
+                          aSorted.Length() - 1);
+  return aSorted[index];
+}
+
+void
+BenchmarkPlayback::FinishBenchmark()
+{
+  MOZ_ASSERT(OnThread());
+
+  RefPtr<Benchmark> ref(mMainThreadState);
+  int32_t frames = mFrameCount - ref->mParameters.mStartupFrame;
+  TimeDuration elapsedTime = TimeStamp::Now() - mDecodeStartTime;
+
+  Benchmark::Result result;
+  result.mDecodeFps = frames / elapsedTime.ToSeconds();
+  result.mFrames = std::max(frames, 0);
+  mLatencies.Sort();
+  result.mLatencyMedian = Percentile(mLatencies, 0.5);
+  result.mLatency90 = Percentile(mLatencies, 0.9);
+  result.mLatency99 = Percentile(mLatencies, 0.99);
+  result.mLatencyMax = Percentile(mLatencies, 1.0);
+  if (mImageCopyCount) {
+    result.mImageCopyTime = mImageCopyTime / int64_t(mImageCopyCount);
+  }
+  if (result.mFrames) {
+    result.mBytesPerFrame = mOutputBytes / result.mFrames;
+  }
+  result.mDecoderName = mDecoderName;
+  result.mIsHardwareAccelerated = mIsHardwareAccelerated;
+
+  MainThreadShutdown();
+  ref->Dispatch(NS_NewRunnableFunction([ref, result]() {
+    ref->ReturnResult(result);
+  }));
+}
+
 void
 BenchmarkPlayback::Output(MediaData* aData)
 {
   RefPtr<Benchmark> ref(mMainThreadState);
-  Dispatch(NS_NewRunnableFunction([this, ref]() {
+  RefPtr<MediaData> data(aData);
+  Dispatch(NS_NewRunnableFunction([this, ref, data]() {
     mFrameCount++;
     if (mFrameCount == ref->mParameters.mStartupFrame) {
       mDecodeStartTime = TimeStamp::Now();
     }
+    if (!mFinished) {
+      MeasureOutput(data);
+    }
     int32_t frames = mFrameCount - ref->mParameters.mStartupFrame;
     TimeDuration elapsedTime = TimeStamp::Now() - mDecodeStartTime;
     if (!mFinished &&
         (frames == ref->mParameters.mFramesToMeasure ||
          elapsedTime >= ref->mParameters.mTimeout)) {
-      uint32_t decodeFps = frames / elapsedTime.ToSeconds();
-      MainThreadShutdown();
-      ref->Dispatch(NS_NewRunnableFunction([ref, decodeFps]() {
-        ref->ReturnResult(decodeFps);
-      }));
+      FinishBenchmark();
     }
   }));
 }
@@ -296,7 +427,7 @@ BenchmarkPlayback::InputExhausted()
     if (mFinished || mSampleIndex >= mSamples.Length()) {
       return;
     }
-    mDecoder->Input(mSamples[mSampleIndex]);
+    InputSample(mSamples[mSampleIndex]);
     mSampleIndex++;
     if (mSampleIndex == mSamples.Length()) {
       if (ref->mParameters.mStopAtFrame) {
@@ -313,13 +444,9 @@ BenchmarkPlayback::DrainComplete()
 {
   RefPtr<Benchmark> ref(mMainThreadState);
   Dispatch(NS_NewRunnableFunction([this, ref]() {
-    int32_t frames = mFrameCount - ref->mParameters.mStartupFrame;
-    TimeDuration elapsedTime = TimeStamp::Now() - mDecodeStartTime;
-    uint32_t decodeFps = frames / elapsedTime.ToSeconds();
-    MainThreadShutdown();
-    ref->Dispatch(NS_NewRunnableFunction([ref, decodeFps]() {
-      ref->ReturnResult(decodeFps);
-    }));
+    if (!mFinished) {
+      FinishBenchmark();
+    }
   }));
 }
 
@@ -329,4 +456,148 @@ BenchmarkPlayback::OnReaderTaskQueue()
   return OnThread();
 }
 
+class MediaDecodeBenchmarkResult final : public nsIMediaDecodeBenchmarkResult
+{
+public:
+  NS_DECL_ISUPPORTS
+
+  explicit MediaDecodeBenchmarkResult(const Benchmark::Result& aResult)
+    : mResult(aResult)
+  {}
+
+  NS_IMETHOD GetDecoderName(nsACString& aName) override
+  {
+    aName = mResult.mDecoderName;
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetHardwareAccelerated(bool* aHardwareAccelerated) override
+  {
+    *aHardwareAccelerated = mResult.mIsHardwareAccelerated;
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetFrames(uint32_t* aFrames) override
+  {
+    *aFrames = mResult.mFrames;
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetFramesPerSecond(uint32_t* aFramesPerSecond) override
+  {
+    *aFramesPerSecond = mResult.mDecodeFps;
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetLatencyMedianMs(double* aLatency) override
+  {
+    *aLatency = mResult.mLatencyMedian.ToMilliseconds();
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetLatency90Ms(double* aLatency) override
+  {
+    *aLatency = mResult.mLatency90.ToMilliseconds();
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetLatency99Ms(double* aLatency) override
+  {
+    *aLatency = mResult.mLatency99.ToMilliseconds();
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetLatencyMaxMs(double* aLatency) override
+  {
+    *aLatency = mResult.mLatencyMax.ToMilliseconds();
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetImageCopyMs(double* aImageCopyMs) override
+  {
+    *aImageCopyMs = mResult.mImageCopyTime.ToMilliseconds();
+    return NS_OK;
+  }
+
+  NS_IMETHOD GetBytesPerFrame(uint64_t* aBytesPerFrame) override
+  {
+    *aBytesPerFrame = mResult.mBytesPerFrame;
+    return NS_OK;
+  }
+
+private:
+  ~MediaDecodeBenchmarkResult() {}
+
+  const Benchmark::Result mResult;
+};
+
+NS_IMPL_ISUPPORTS(MediaDecodeBenchmarkResult, nsIMediaDecodeBenchmarkResult)
+
+NS_IMPL_ISUPPORTS(MediaDecodeBenchmark, nsIMediaDecodeBenchmark)
+
+NS_IMETHODIMP
+MediaDecodeBenchmark::Run(nsIFile* aFile,
+                          const nsACString& aContentType,
+                          bool aAudio,
+                          const nsACString& aDecoderName,
+                          uint32_t aFrames,
+                          uint32_t aTimeoutMs,
+                          nsIMediaDecodeBenchmarkCallback* aCallback)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  NS_ENSURE_ARG(aFile);
+  NS_ENSURE_ARG(aCallback);
+
+  int64_t fileSize;
+  nsresult rv = aFile->GetFileSize(&fileSize);
+  NS_ENSURE_SUCCESS(rv, rv);
+  if (fileSize < 0 || fileSize > UINT32_MAX) {
+    return NS_ERROR_FILE_TOO_BIG;
+  }
+
+  nsCOMPtr<nsIInputStream> stream;
+  rv = NS_NewLocalFileInputStream(getter_AddRefs(stream), aFile);
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  // BufferMediaResource doesn't own its buffer, so the callbacks below hold
+  // on to it until the benchmark is done with it.
+  nsCString data;
+  rv = NS_ReadInputStreamToString(stream, data, uint32_t(fileSize));
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  RefPtr<MediaResource> resource =
+    new BufferMediaResource(reinterpret_cast<const uint8_t*>(data.get()),
+                            data.Length(), nullptr, aContentType);
+  RefPtr<MediaDataDemuxer> demuxer =
+    DecoderTraits::CreateDemuxer(aContentType, resource);
+  if (!demuxer) {
+    return NS_ERROR_DOM_MEDIA_FATAL_ERR;
+  }
+
+  Benchmark::Init();
+  Benchmark::Parameters parameters(
+    aFrames ? int32_t(std::min(aFrames, uint32_t(INT32_MAX))) : -1,
+    1, // start measuring after decoding this frame.
+    aTimeoutMs ? TimeDuration::FromMilliseconds(aTimeoutMs)
+               : TimeDuration::Forever());
+  parameters.mTrackType =
+    aAudio ? TrackInfo::kAudioTrack : TrackInfo::kVideoTrack;
+  parameters.mDecoderName = aDecoderName;
+  parameters.mMeasureImageCopy = true;
+
+  nsCOMPtr<nsIMediaDecodeBenchmarkCallback> callback = aCallback;
+  RefPtr<Benchmark> benchmark = new Benchmark(demuxer, parameters);
+  benchmark->Run()->Then(
+    AbstractThread::MainThread(), __func__,
+    [callback, data](const Benchmark::Result& aResult) {
+      nsCOMPtr<nsIMediaDecodeBenchmarkResult> result =
+        new MediaDecodeBenchmarkResult(aResult);
+      callback->OnComplete(result);
+    },
+    [callback, data]() {
+      callback->OnComplete(nullptr);
+    });
+  return NS_OK;
+}
+
 }
@@ -10,13 +10,20 @@
 #include "MediaDataDemuxer.h"
 #include "QueueObject.h"
 #include "PlatformDecoderModule.h"
+#include "mozilla/Pair.h"
 #include "mozilla/RefPtr.h"
 #include "mozilla/TaskQueue.h"
 #include "mozilla/TimeStamp.h"
 #include "nsCOMPtr.h"
+#include "nsIMediaDecodeBenchmark.h"
+#include "nsString.h"
 
 namespace mozilla {
 
+namespace layers {
+class ImageContainer;
+} // namespace layers
+
 class TaskQueue;
 class Benchmark;
 
@@ -28,6 +35,9 @@ class BenchmarkPlayback : public QueueObject, private MediaDataDecoderCallback
   void DemuxNextSample();
   void MainThreadShutdown();
   void InitDecoder(TrackInfo&& aInfo);
+  void InputSample(MediaRawData* aSample);
+  void MeasureOutput(MediaData* aData);
+  void FinishBenchmark();
 
   // MediaDataDecoderCallback
   // Those methods are called on the MediaDataDecoder's task queue.
@@ -50,6 +60,18 @@ class BenchmarkPlayback : public QueueObject, private MediaDataDecoderCallback
   TimeStamp mDecodeStartTime;
   uint32_t mFrameCount;
   bool mFinished;
+
+  // Detailed measurements, also only accessed on Thread().
+  RefPtr<layers::ImageContainer> mImageContainer;
+  // The samples handed to the decoder which haven't come out yet, as pairs of
+  // sample time and input time.
+  nsTArray<Pair<int64_t, TimeStamp>> mPendingInputs;
+  nsTArray<TimeDuration> mLatencies;
+  TimeDuration mImageCopyTime;
+  uint32_t mImageCopyCount;
+  uint64_t mOutputBytes;
+  nsCString mDecoderName;
+  bool mIsHardwareAccelerated;
 };
 
 // Init() must have been called at least once prior on the
@@ -66,6 +88,13 @@ public:
       , mStartupFrame(1)
       , mTimeout(TimeDuration::Forever()) {}
 
+    Parameters(int32_t aFramesToMeasure,
+               uint32_t aStartupFrame,
+               const TimeDuration& aTimeout)
+      : mFramesToMeasure(aFramesToMeasure)
+      , mStartupFrame(aStartupFrame)
+      , mTimeout(aTimeout) {}
+
     Parameters(int32_t aFramesToMeasure,
                uint32_t aStartupFrame,
                int32_t aStopAtFrame,
@@ -79,9 +108,37 @@ public:
     const uint32_t mStartupFrame;
     const Maybe<int32_t> mStopAtFrame;
     const TimeDuration mTimeout;
+
+    // The track to decode.
+    TrackInfo::TrackType mTrackType = TrackInfo::kVideoTrack;
+    // If not empty, only decoders whose description contains this are used.
+    nsCString mDecoderName;
+    // Whether to time copying each decoded frame into a new image. This runs
+    // alongside the decoder, so it can lower the measured frame rate.
+    bool mMeasureImageCopy = false;
   };
 
-  typedef MozPromise<uint32_t, bool, /* IsExclusive = */ true> BenchmarkPromise;
+  struct Result
+  {
+    // Frames per second decoded after the startup frames.
+    uint32_t mDecodeFps = 0;
+    // The number of frames that mDecodeFps is based on.
+    uint32_t mFrames = 0;
+    // Percentiles of the time between a sample going into the decoder and
+    // the corresponding frame coming out.
+    TimeDuration mLatencyMedian;
+    TimeDuration mLatency90;
+    TimeDuration mLatency99;
+    TimeDuration mLatencyMax;
+    // Mean time to copy a frame into a new PlanarYCbCrImage, if measured.
+    TimeDuration mImageCopyTime;
+    // Mean heap memory held by each output frame.
+    uint64_t mBytesPerFrame = 0;
+    nsCString mDecoderName;
+    bool mIsHardwareAccelerated = false;
+  };
+
+  typedef MozPromise<Result, bool, /* IsExclusive = */ true> BenchmarkPromise;
 
   explicit Benchmark(MediaDataDemuxer* aDemuxer, const Parameters& aParameters = Parameters());
   RefPtr<BenchmarkPromise> Run();
@@ -91,7 +148,7 @@ public:
 private:
   friend class BenchmarkPlayback;
   virtual ~Benchmark();
-  void ReturnResult(uint32_t aDecodeFps);
+  void ReturnResult(const Result& aResult);
   void Dispose();
   const Parameters mParameters;
   RefPtr<Benchmark> mKeepAliveUntilComplete;
@@ -108,6 +165,20 @@ public:
   static const uint32_t sBenchmarkVersionID;
   static bool sHasRunTest;
 };
+
+/**
+ * Chrome-only XPCOM entry point to Benchmark, for comparing decoders on
+ * arbitrary files. See nsIMediaDecodeBenchmark.idl.
+ */
+class MediaDecodeBenchmark final : public nsIMediaDecodeBenchmark
+{
+public:
+  NS_DECL_ISUPPORTS
+  NS_DECL_NSIMEDIADECODEBENCHMARK
+
+private:
+  ~MediaDecodeBenchmark() {}
+};
 }
 
 #endif
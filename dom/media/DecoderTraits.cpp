@@ -648,6 +648,40 @@ MediaDecoderReader* DecoderTraits::CreateReader(const nsACString& aType, Abstrac
   return decoderReader;
 }
 
+/* static */
+already_AddRefed<MediaDataDemuxer>
+DecoderTraits::CreateDemuxer(const nsACString& aType, MediaResource* aResource)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  RefPtr<MediaDataDemuxer> demuxer;
+
+#ifdef MOZ_FMP4
+  if (IsMP4SupportedType(aType, /* DecoderDoctorDiagnostics* */ nullptr)) {
+    demuxer = new MP4Demuxer(aResource);
+  } else
+#endif
+  if (IsMP3SupportedType(aType)) {
+    demuxer = new mp3::MP3Demuxer(aResource);
+  } else
+  if (IsAACSupportedType(aType)) {
+    demuxer = new ADTSDemuxer(aResource);
+  } else
+  if (IsWAVSupportedType(aType)) {
+    demuxer = new WAVDemuxer(aResource);
+  } else
+  if (IsFlacSupportedType(aType)) {
+    demuxer = new FlacDemuxer(aResource);
+  } else
+  if (IsOggSupportedType(aType)) {
+    demuxer = new OggDemuxer(aResource);
+  } else
+  if (IsWebMSupportedType(aType)) {
+    demuxer = new WebMDemuxer(aResource);
+  }
+
+  return demuxer.forget();
+}
+
 /* static */
 bool DecoderTraits::IsSupportedInVideoDocument(const nsACString& aType)
 {
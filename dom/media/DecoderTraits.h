@@ -18,7 +18,9 @@ class AbstractMediaDecoder;
 class DecoderDoctorDiagnostics;
 class MediaDecoder;
 class MediaDecoderOwner;
+class MediaDataDemuxer;
 class MediaDecoderReader;
+class MediaResource;
 
 enum CanPlayStatus {
   CANPLAY_NO,
@@ -66,6 +68,11 @@ public:
   static MediaDecoderReader* CreateReader(const nsACString& aType,
                                           AbstractMediaDecoder* aDecoder);
 
+  // Create a demuxer for the given MIME type aType, reading from aResource.
+  // Returns null if none of the MediaDataDemuxers handles the type.
+  static already_AddRefed<MediaDataDemuxer> CreateDemuxer(const nsACString& aType,
+                                                          MediaResource* aResource);
+
   // Returns true if MIME type aType is supported in video documents,
   // or false otherwise. Not all platforms support all MIME types, and
   // vice versa.
@@ -4,8 +4,10 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this file,
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include "mozilla/FileUtils.h"
 #include "mozilla/SharedThreadPool.h"
 #include "FileBlockCache.h"
+#include "MediaPrefs.h"
 #include "VideoUtils.h"
 #include "prio.h"
 #include <algorithm>
@@ -26,6 +28,8 @@ nsresult FileBlockCache::Open(PRFileDesc* aFD)
                                 nullptr,
                                 SharedThreadPool::kStackSize);
     mIsOpen = NS_SUCCEEDED(res);
+    // Fall back to regular file IO if we can't map the file.
+    mIsMapped = MediaPrefs::MediaCacheMmapEnabled() && MapNextRegion();
     return res;
   }
 }
@@ -36,7 +40,8 @@ FileBlockCache::FileBlockCache()
     mFDCurrentPos(0),
     mDataMonitor("MediaCache.Writer.Data.Monitor"),
     mIsWriteScheduled(false),
-    mIsOpen(false)
+    mIsOpen(false),
+    mIsMapped(false)
 {
   MOZ_COUNT_CTOR(FileBlockCache);
 }
@@ -44,6 +49,15 @@ FileBlockCache::FileBlockCache()
 FileBlockCache::~FileBlockCache()
 {
   NS_ASSERTION(!mIsOpen, "Should Close() FileBlockCache before destroying");
+  {
+    // mThread is shut down by now, so nothing uses the map anymore.
+    MonitorAutoLock mon(mDataMonitor);
+    for (const MappedRegion& region : mRegions) {
+      PR_MemUnmap(region.mData, MAPPED_REGION_SIZE);
+      PR_CloseFileMap(region.mMap);
+    }
+    mRegions.Clear();
+  }
   {
     // Note, mThread will be shutdown by the time this runs, so we won't
     // block while taking mFileMonitor.
@@ -96,6 +110,57 @@ ContainerContains(const Container& aContainer, const Value& value)
          != aContainer.end();
 }
 
+bool FileBlockCache::MapNextRegion()
+{
+  mDataMonitor.AssertCurrentThreadOwns();
+
+  if (!mFD) {
+    return false;
+  }
+
+  // Allocate the disk space up front, so that writing to the map can't fail
+  // with the disk full later on.
+  int64_t offset = static_cast<int64_t>(mRegions.Length()) * MAPPED_REGION_SIZE;
+  if (!mozilla::fallocate(mFD, offset + MAPPED_REGION_SIZE)) {
+    NS_WARNING("Failed to extend media cache file");
+    return false;
+  }
+
+  PRFileMap* map = PR_CreateFileMap(mFD, 0, PR_PROT_READWRITE);
+  if (!map) {
+    NS_WARNING("Failed to map media cache file");
+    return false;
+  }
+
+  void* data = PR_MemMap(map, offset, MAPPED_REGION_SIZE);
+  if (!data) {
+    NS_WARNING("Failed to map media cache file");
+    PR_CloseFileMap(map);
+    return false;
+  }
+
+  MappedRegion* region = mRegions.AppendElement();
+  region->mMap = map;
+  region->mData = static_cast<uint8_t*>(data);
+  return true;
+}
+
+uint8_t* FileBlockCache::GetMappedBlock(int32_t aBlockIndex)
+{
+  mDataMonitor.AssertCurrentThreadOwns();
+  MOZ_ASSERT(mIsMapped);
+
+  uint32_t regionIndex = aBlockIndex / BLOCKS_PER_MAPPED_REGION;
+  while (regionIndex >= mRegions.Length()) {
+    if (!MapNextRegion()) {
+      return nullptr;
+    }
+  }
+
+  return mRegions[regionIndex].mData +
+         (aBlockIndex % BLOCKS_PER_MAPPED_REGION) * BLOCK_SIZE;
+}
+
 nsresult FileBlockCache::WriteBlock(uint32_t aBlockIndex, const uint8_t* aData)
 {
   MonitorAutoLock mon(mDataMonitor);
@@ -103,6 +168,20 @@ nsresult FileBlockCache::WriteBlock(uint32_t aBlockIndex, const uint8_t* aData)
   if (!mIsOpen)
     return NS_ERROR_FAILURE;
 
+  if (mIsMapped && aBlockIndex <= INT32_MAX && !mIsWriteScheduled) {
+    // Nothing is pending, so no move can still need the block's old
+    // contents, and the thread isn't touching the map. Write straight into
+    // the map and let the OS write it back.
+    MOZ_ASSERT(mChangeIndexList.empty());
+    mBlockChanges.EnsureLengthAtLeast(aBlockIndex + 1);
+    uint8_t* block = GetMappedBlock(aBlockIndex);
+    if (!block) {
+      return NS_ERROR_FAILURE;
+    }
+    memcpy(block, aData, BLOCK_SIZE);
+    return NS_OK;
+  }
+
   // Check if we've already got a pending write scheduled for this block.
   mBlockChanges.EnsureLengthAtLeast(aBlockIndex + 1);
   bool blockAlreadyHadPendingChange = mBlockChanges[aBlockIndex] != nullptr;
@@ -232,7 +311,22 @@ nsresult FileBlockCache::Run()
     MOZ_ASSERT(change,
                "Change index list should only contain entries for blocks "
                "with changes");
-    {
+    if (mIsMapped) {
+      // Resolve the blocks while we hold mDataMonitor; the pointers stay
+      // valid once we drop it. Pending changes keep Read() and WriteBlock()
+      // away from the destination block, and moves are resolved before any
+      // later write to their source, so nothing else touches these blocks.
+      uint8_t* dest = GetMappedBlock(blockIndex);
+      const uint8_t* source = change->IsWrite()
+                            ? change->mData.get()
+                            : GetMappedBlock(change->mSourceBlockIndex);
+      if (dest && source) {
+        MonitorAutoUnlock unlock(mDataMonitor);
+        memcpy(dest, source, BLOCK_SIZE);
+      } else {
+        NS_WARNING("Failed to map media cache block!");
+      }
+    } else {
       MonitorAutoUnlock unlock(mDataMonitor);
       MonitorAutoLock lock(mFileMonitor);
       if (change->IsWrite()) {
@@ -294,16 +388,25 @@ nsresult FileBlockCache::Read(int64_t aOffset,
       // Block has been written to file, either as the source block of a move,
       // or as a stable (all changes made) block. Read the data directly
       // from file.
-      nsresult res;
-      {
-        MonitorAutoUnlock unlock(mDataMonitor);
-        MonitorAutoLock lock(mFileMonitor);
-        res = ReadFromFile(BlockIndexToOffset(blockIndex) + start,
-                           dst,
-                           amount,
-                           bytesRead);
+      if (mIsMapped) {
+        if (blockIndex / BLOCKS_PER_MAPPED_REGION >= int32_t(mRegions.Length())) {
+          // Nothing was ever written this far into the file.
+          return NS_ERROR_FAILURE;
+        }
+        memcpy(dst, GetMappedBlock(blockIndex) + start, amount);
+        bytesRead = amount;
+      } else {
+        nsresult res;
+        {
+          MonitorAutoUnlock unlock(mDataMonitor);
+          MonitorAutoLock lock(mFileMonitor);
+          res = ReadFromFile(BlockIndexToOffset(blockIndex) + start,
+                             dst,
+                             amount,
+                             bytesRead);
+        }
+        NS_ENSURE_SUCCESS(res,res);
       }
-      NS_ENSURE_SUCCESS(res,res);
     }
     dst += bytesRead;
     offset += bytesRead;
@@ -17,6 +17,7 @@
 #include <deque>
 
 struct PRFileDesc;
+struct PRFileMap;
 
 namespace mozilla {
 
@@ -50,6 +51,13 @@ namespace mozilla {
 // changes listed in mBlockChanges to file. Read() checks mBlockChanges and
 // determines the current data to return, reading from file or from
 // mBlockChanges as necessary.
+//
+// If the media.cache.mmap.enabled pref is set, the file is instead memory
+// mapped, a region at a time. While no changes are pending, WriteBlock()
+// copies the block straight into the map, and Read() always reads from the
+// map; the OS takes care of writing the data back to disk. The change list
+// is still used for moves, and for writes that have to be ordered after
+// pending moves.
 class FileBlockCache : public Runnable {
 public:
   enum {
@@ -130,6 +138,17 @@ private:
     return static_cast<int64_t>(aBlockIndex) * BLOCK_SIZE;
   }
 
+  // The cache file is mapped in regions of this size.
+  enum {
+    MAPPED_REGION_SIZE = 16 * 1024 * 1024,
+    BLOCKS_PER_MAPPED_REGION = MAPPED_REGION_SIZE / BLOCK_SIZE
+  };
+
+  struct MappedRegion {
+    PRFileMap* mMap;
+    uint8_t* mData;
+  };
+
   // Monitor which controls access to mFD and mFDCurrentPos. Don't hold
   // mDataMonitor while holding mFileMonitor! mFileMonitor must be owned
   // while accessing any of the following data fields or methods.
@@ -160,6 +179,18 @@ private:
   // has been dispatched to preform the IO.
   // mDataMonitor must be owned while calling this.
   void EnsureWriteScheduled();
+  // Returns the block's data in the mapped file, extending the file and
+  // mapping more regions as needed, or null if that fails. The returned
+  // pointer stays valid until the cache is destroyed.
+  // mDataMonitor must be owned while calling this.
+  uint8_t* GetMappedBlock(int32_t aBlockIndex);
+  // Extends the file and maps one more region at its end.
+  // mDataMonitor must be owned while calling this.
+  bool MapNextRegion();
+  // Regions of the file mapped so far, in file order. Only used if mIsMapped.
+  nsTArray<MappedRegion> mRegions;
+  // True if the file is accessed through mRegions rather than mFD.
+  bool mIsMapped;
   // Array of block changes to made. If mBlockChanges[offset/BLOCK_SIZE] == nullptr,
   // then the block has no pending changes to be written, but if
   // mBlockChanges[offset/BLOCK_SIZE] != nullptr, then either there's a block
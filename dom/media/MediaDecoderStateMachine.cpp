@@ -11,6 +11,7 @@
 #endif
 
 #include <algorithm>
+#include <cmath>
 #include <stdint.h>
 
 #include "gfx2DGlue.h"
@@ -27,6 +28,7 @@
 #include "mozilla/Preferences.h"
 #include "mozilla/SharedThreadPool.h"
 #include "mozilla/TaskQueue.h"
+#include "mozilla/Telemetry.h"
 
 #include "nsComponentManagerUtils.h"
 #include "nsContentUtils.h"
@@ -36,6 +38,7 @@
 #include "nsTArray.h"
 #include "nsDeque.h"
 #include "prenv.h"
+#include "prsystem.h"
 
 #include "AccurateSeekTask.h"
 #include "AudioSegment.h"
@@ -159,6 +162,18 @@ static uint32_t sVideoQueueDefaultSize = MAX_VIDEO_QUEUE_SIZE;
 static uint32_t sVideoQueueHWAccelSize = HW_VIDEO_QUEUE_SIZE;
 static uint32_t sVideoQueueSendToCompositorSize = VIDEO_QUEUE_SEND_TO_COMPOSITOR_SIZE;
 
+// When the video queue is sized from the measured decode time, it can grow up
+// to this many times the configured size, except on devices with no more than
+// LOW_MEMORY_BYTES of physical memory, where the configured size is the cap.
+static const uint32_t ADAPTIVE_VIDEO_QUEUE_GROWTH = 2;
+static const uint64_t LOW_MEMORY_BYTES = 1024 * 1024 * 1024;
+static uint32_t sVideoQueueMaxGrowth = ADAPTIVE_VIDEO_QUEUE_GROWTH;
+
+// Number of decoded video frames to measure before the adaptive video queue
+// size replaces the configured one, and the weight each new measurement gets.
+static const uint32_t MIN_DECODE_TIME_SAMPLES = 10;
+static const double DECODE_TIME_SMOOTHING = 1.0 / 16;
+
 static void InitVideoQueuePrefs() {
   MOZ_ASSERT(NS_IsMainThread());
   static bool sPrefInit = false;
@@ -170,6 +185,10 @@ static void InitVideoQueuePrefs() {
       "media.video-queue.hw-accel-size", HW_VIDEO_QUEUE_SIZE);
     sVideoQueueSendToCompositorSize = Preferences::GetUint(
       "media.video-queue.send-to-compositor-size", VIDEO_QUEUE_SEND_TO_COMPOSITOR_SIZE);
+    uint64_t memory = PR_GetPhysicalMemorySize();
+    if (memory && memory <= LOW_MEMORY_BYTES) {
+      sVideoQueueMaxGrowth = 1;
+    }
   }
 }
 
@@ -1226,6 +1245,11 @@ MediaDecoderStateMachine::OnVideoDecoded(MediaData* aVideoSample,
       Push(video, MediaData::VIDEO_DATA);
       MaybeStopPrerolling();
 
+      TimeDuration decodeTime = TimeStamp::Now() - aDecodeStartTime;
+      if (!mVideoSkippingToKeyframe) {
+        UpdateVideoDecodeTime(decodeTime, video->mDuration);
+      }
+
       // For non async readers, if the requested video sample was slow to
       // arrive, increase the amount of audio we buffer to ensure that we
       // don't run out of audio. This is unnecessary for async readers,
@@ -1234,7 +1258,6 @@ MediaDecoderStateMachine::OnVideoDecoded(MediaData* aVideoSample,
       if (mReader->IsAsync()) {
         return;
       }
-      TimeDuration decodeTime = TimeStamp::Now() - aDecodeStartTime;
       if (THRESHOLD_FACTOR * DurationToUsecs(decodeTime) > mLowAudioThresholdUsecs &&
           !HasLowBufferedData())
       {
@@ -1463,10 +1486,31 @@ MediaDecoderStateMachine::MaybeStartBuffering()
                    (OutOfDecodedVideo() && mReader->IsWaitingVideoData());
   }
   if (shouldBuffer) {
+    if (OutOfDecodedAudio()) {
+      ReportQueueUnderflow(QueueUnderflow::Audio);
+    }
+    if (OutOfDecodedVideo()) {
+      ReportQueueUnderflow(QueueUnderflow::Video);
+    }
     SetState(DECODER_STATE_BUFFERING);
   }
 }
 
+void
+MediaDecoderStateMachine::ReportQueueUnderflow(QueueUnderflow aKind)
+{
+  MOZ_ASSERT(OnTaskQueue());
+  DECODER_LOG("Queue underflow kind=%d ampleVideoFrames=%u decodeTime=%.0fus+/-%.0fus",
+              static_cast<int>(aKind), GetAmpleVideoFrames(),
+              mVideoDecodeTimeMean, sqrt(mVideoDecodeTimeVariance));
+  Telemetry::Accumulate(Telemetry::MEDIA_DECODER_QUEUE_UNDERFLOW,
+                        static_cast<uint32_t>(aKind));
+  if (aKind != QueueUnderflow::Audio) {
+    Telemetry::Accumulate(Telemetry::MEDIA_DECODER_AMPLE_VIDEO_FRAMES_AT_UNDERFLOW,
+                          GetAmpleVideoFrames());
+  }
+}
+
 void MediaDecoderStateMachine::UpdatePlaybackPositionInternal(int64_t aTime)
 {
   MOZ_ASSERT(OnTaskQueue());
@@ -2232,6 +2276,12 @@ MediaDecoderStateMachine::RequestVideoData()
   MOZ_ASSERT(mState != DECODER_STATE_SEEKING);
 
   bool skipToNextKeyFrame = NeedToSkipToNextKeyframe();
+  if (skipToNextKeyFrame) {
+    ReportQueueUnderflow(QueueUnderflow::VideoSkipToKeyframe);
+  }
+  // Decoding up to the next keyframe says nothing about how long a single
+  // frame takes, so don't let it skew the adaptive video queue size.
+  mVideoSkippingToKeyframe = skipToNextKeyFrame;
 
   media::TimeUnit currentTime = media::TimeUnit::FromMicroseconds(GetMediaTime());
 
@@ -2921,12 +2971,49 @@ MediaDecoderStateMachine::SetAudioCaptured(bool aCaptured)
   MaybeStopPrerolling();
 }
 
+void
+MediaDecoderStateMachine::UpdateVideoDecodeTime(const TimeDuration& aDecodeTime,
+                                                int64_t aFrameDuration)
+{
+  MOZ_ASSERT(OnTaskQueue());
+  double decodeTime = DurationToUsecs(aDecodeTime);
+  if (mVideoDecodeTimeSamples++ == 0) {
+    mVideoDecodeTimeMean = decodeTime;
+  } else {
+    // Exponentially weighted moving average and variance, so that the queue
+    // follows changes in decode cost, e.g. after a resolution switch.
+    double delta = decodeTime - mVideoDecodeTimeMean;
+    mVideoDecodeTimeMean += DECODE_TIME_SMOOTHING * delta;
+    mVideoDecodeTimeVariance = (1 - DECODE_TIME_SMOOTHING) *
+      (mVideoDecodeTimeVariance + DECODE_TIME_SMOOTHING * delta * delta);
+  }
+  if (aFrameDuration > 0) {
+    mVideoFrameDuration = aFrameDuration;
+  }
+}
+
 uint32_t MediaDecoderStateMachine::GetAmpleVideoFrames() const
 {
   MOZ_ASSERT(OnTaskQueue());
-  return (mReader->IsAsync() && mReader->VideoIsHardwareAccelerated())
+  uint32_t configured =
+    (mReader->IsAsync() && mReader->VideoIsHardwareAccelerated())
     ? std::max<uint32_t>(sVideoQueueHWAccelSize, MIN_VIDEO_QUEUE_SIZE)
     : std::max<uint32_t>(sVideoQueueDefaultSize, MIN_VIDEO_QUEUE_SIZE);
+  if (!MediaPrefs::MDSMAdaptiveVideoQueue() ||
+      mVideoDecodeTimeSamples < MIN_DECODE_TIME_SAMPLES ||
+      mVideoFrameDuration <= 0) {
+    return configured;
+  }
+
+  // Keep enough frames queued to play through THRESHOLD_FACTOR slow decodes,
+  // where a slow decode is two standard deviations above the mean. Callers
+  // scale this by the playback rate.
+  double slowDecodeTime =
+    mVideoDecodeTimeMean + 2 * sqrt(mVideoDecodeTimeVariance);
+  double frames = ceil(THRESHOLD_FACTOR * slowDecodeTime / mVideoFrameDuration);
+  uint32_t maxFrames = configured * sVideoQueueMaxGrowth;
+  return std::max(MIN_VIDEO_QUEUE_SIZE,
+                  uint32_t(std::min<double>(frames, maxFrames)));
 }
 
 void
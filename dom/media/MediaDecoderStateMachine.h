@@ -675,10 +675,35 @@ private:
 
   // If we've got more than this number of decoded video frames waiting in
   // the video queue, we will not decode any more video frames until some have
-  // been consumed by the play state machine thread.
+  // been consumed by the play state machine thread. Once a few frames have
+  // been decoded, and unless media.video-queue.adaptive is false, this is
+  // sized from the measured decode time rather than the configured size.
   // Must hold monitor.
   uint32_t GetAmpleVideoFrames() const;
 
+  // Folds the time taken to decode a video frame into the statistics
+  // GetAmpleVideoFrames() uses.
+  void UpdateVideoDecodeTime(const TimeDuration& aDecodeTime,
+                             int64_t aFrameDuration);
+
+  // Smoothed time between requesting a video frame and receiving it, and its
+  // variance, in usecs and usecs squared.
+  double mVideoDecodeTimeMean = 0;
+  double mVideoDecodeTimeVariance = 0;
+  uint32_t mVideoDecodeTimeSamples = 0;
+  // Duration of the last decoded video frame, in usecs.
+  int64_t mVideoFrameDuration = 0;
+  // True while the pending video request skips to the next keyframe.
+  bool mVideoSkippingToKeyframe = false;
+
+  // Values of the MEDIA_DECODER_QUEUE_UNDERFLOW histogram.
+  enum class QueueUnderflow : uint32_t {
+    Audio = 0,
+    Video = 1,
+    VideoSkipToKeyframe = 2
+  };
+  void ReportQueueUnderflow(QueueUnderflow aKind);
+
   // Low audio threshold. If we've decoded less than this much audio we
   // consider our audio decode "behind", and we may skip video decoding
   // in order to allow our audio decoding to catch up. We favour audio
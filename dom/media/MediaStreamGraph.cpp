@@ -5,6 +5,7 @@
 
 #include "MediaStreamGraphImpl.h"
 #include "mozilla/MathAlgorithms.h"
+#include "mozilla/SharedThreadPool.h"
 #include "mozilla/Unused.h"
 
 #include "AudioSegment.h"
@@ -22,6 +23,7 @@
 #include "AudioChannelService.h"
 #include "AudioNodeStream.h"
 #include "AudioNodeExternalInputStream.h"
+#include "MediaPrefs.h"
 #include "MediaStreamListener.h"
 #include "MediaStreamVideoSink.h"
 #include "mozilla/dom/AudioContextBinding.h"
@@ -85,6 +87,7 @@ MediaStreamGraphImpl::~MediaStreamGraphImpl()
 void
 MediaStreamGraphImpl::FinishStream(MediaStream* aStream)
 {
+  MutexAutoLock lock(mParallelProcessingMutex);
   if (aStream->mFinished)
     return;
   STREAM_LOG(LogLevel::Debug, ("MediaStream %p will finish", aStream));
@@ -753,6 +756,95 @@ MediaStreamGraphImpl::UpdateStreamOrder()
   }
 
   MOZ_ASSERT(orderedStreamCount == mFirstCycleBreaker);
+
+  UpdateParallelComponents();
+}
+
+void
+MediaStreamGraphImpl::UpdateParallelComponents()
+{
+  mParallelComponents.Clear();
+  mInParallelComponent.Clear();
+
+  if (!mProcessingPool) {
+    return;
+  }
+
+  // Find the connected components with a union-find over indices in
+  // mStreams. Suspended streams aren't in mStreams, and don't connect
+  // anything.
+  nsDataHashtable<nsPtrHashKey<MediaStream>, uint32_t> indices(mStreams.Length());
+  nsTArray<uint32_t> parents(mStreams.Length());
+  for (uint32_t i = 0; i < mStreams.Length(); ++i) {
+    indices.Put(mStreams[i], i);
+    parents.AppendElement(i);
+  }
+
+  auto findRoot = [&parents](uint32_t aIndex) {
+    while (parents[aIndex] != aIndex) {
+      parents[aIndex] = parents[parents[aIndex]];
+      aIndex = parents[aIndex];
+    }
+    return aIndex;
+  };
+
+  for (uint32_t i = 0; i < mStreams.Length(); ++i) {
+    ProcessedMediaStream* ps = mStreams[i]->AsProcessedStream();
+    if (!ps) {
+      continue;
+    }
+    for (MediaInputPort* port : ps->mInputs) {
+      uint32_t source;
+      if (indices.Get(port->GetSource(), &source)) {
+        parents[findRoot(source)] = findRoot(i);
+      }
+    }
+  }
+
+  // Other processed streams, like TrackUnionStreams, notify listeners which
+  // expect to run on the graph thread, so their components stay there.
+  nsTArray<bool> eligible;
+  eligible.SetLength(mStreams.Length());
+  for (uint32_t i = 0; i < mStreams.Length(); ++i) {
+    eligible[i] = true;
+  }
+  for (uint32_t i = 0; i < mStreams.Length(); ++i) {
+    if (mStreams[i]->AsProcessedStream() && !mStreams[i]->AsAudioNodeStream()) {
+      eligible[findRoot(i)] = false;
+    }
+  }
+
+  nsTArray<int32_t> componentIndices;
+  componentIndices.SetLength(mStreams.Length());
+  mInParallelComponent.SetLength(mStreams.Length());
+  for (uint32_t i = 0; i < mStreams.Length(); ++i) {
+    componentIndices[i] = -1;
+    mInParallelComponent[i] = false;
+  }
+
+  for (uint32_t i = 0; i < mStreams.Length(); ++i) {
+    uint32_t root = findRoot(i);
+    AudioNodeStream* ns = mStreams[i]->AsAudioNodeStream();
+    if (!eligible[root] || !ns) {
+      continue;
+    }
+    if (componentIndices[root] < 0) {
+      componentIndices[root] = mParallelComponents.Length();
+      mParallelComponents.AppendElement();
+    }
+    StreamComponent& component = mParallelComponents[componentIndices[root]];
+    component.mStreams.AppendElement(ns);
+    if (i >= mFirstCycleBreaker) {
+      component.mCycleBreakers.AppendElement(ns);
+    }
+    mInParallelComponent[i] = true;
+  }
+
+  if (mParallelComponents.Length() < 2) {
+    // Nothing to parallelize.
+    mParallelComponents.Clear();
+    mInParallelComponent.Clear();
+  }
 }
 
 void
@@ -1086,7 +1178,7 @@ MediaStreamGraph::AssertOnGraphThreadOrNotRunning() const
   MediaStreamGraphImpl const * graph =
     static_cast<MediaStreamGraphImpl const *>(this);
   // if all the safety checks fail, assert we own the monitor
-  if (!graph->mDriver->OnThread()) {
+  if (!graph->mDriver->OnThread() && !graph->OnProcessingThread()) {
     if (!(graph->mDetectedNotRunning &&
           graph->mLifecycleState > MediaStreamGraphImpl::LIFECYCLE_RUNNING &&
           NS_IsMainThread())) {
@@ -1188,11 +1280,17 @@ MediaStreamGraphImpl::ProduceDataForStreamsBlockByBlock(uint32_t aStreamIndex,
   while (t < mStateComputedTime) {
     GraphTime next = RoundUpToNextAudioBlock(t);
     for (uint32_t i = mFirstCycleBreaker; i < mStreams.Length(); ++i) {
+      if (IsInParallelComponent(i)) {
+        continue;
+      }
       auto ns = static_cast<AudioNodeStream*>(mStreams[i]);
       MOZ_ASSERT(ns->AsAudioNodeStream());
       ns->ProduceOutputBeforeInput(t);
     }
     for (uint32_t i = aStreamIndex; i < mStreams.Length(); ++i) {
+      if (IsInParallelComponent(i)) {
+        continue;
+      }
       ProcessedMediaStream* ps = mStreams[i]->AsProcessedStream();
       if (ps) {
         ps->ProcessInput(t, next,
@@ -1205,6 +1303,121 @@ MediaStreamGraphImpl::ProduceDataForStreamsBlockByBlock(uint32_t aStreamIndex,
                "Something went wrong with rounding to block boundaries");
 }
 
+/**
+ * Hands out the components of a graph to the threads processing them, and
+ * lets the graph thread wait until all of them are done.
+ */
+class ParallelProcessingJob final
+{
+public:
+  NS_INLINE_DECL_THREADSAFE_REFCOUNTING(ParallelProcessingJob)
+
+  ParallelProcessingJob(MediaStreamGraphImpl* aGraph, uint32_t aCount)
+    : mMonitor("ParallelProcessingJob::mMonitor")
+    , mGraph(aGraph)
+    , mCount(aCount)
+    , mNext(0)
+    , mDone(0)
+  {
+  }
+
+  // Processes components until there are none left. Workers which start
+  // after that never touch mGraph, which might be gone by then.
+  void Run()
+  {
+    uint32_t index;
+    while ((index = mNext++) < mCount) {
+      mGraph->ProduceDataForParallelComponent(index);
+      MonitorAutoLock lock(mMonitor);
+      if (++mDone == mCount) {
+        lock.Notify();
+      }
+    }
+  }
+
+  void WaitUntilDone()
+  {
+    MonitorAutoLock lock(mMonitor);
+    while (mDone < mCount) {
+      lock.Wait();
+    }
+  }
+
+private:
+  ~ParallelProcessingJob() {}
+
+  Monitor mMonitor;
+  MediaStreamGraphImpl* const mGraph;
+  const uint32_t mCount;
+  Atomic<uint32_t> mNext;
+  // Guarded by mMonitor.
+  uint32_t mDone;
+};
+
+void
+MediaStreamGraphImpl::ProduceDataForParallelComponents()
+{
+  MOZ_ASSERT(mParallelComponents.Length() >= 2);
+
+  // Listeners expect to be notified on the graph thread, so if a listener
+  // was added to one of the streams since the order was last updated, do
+  // all the work here.
+  bool haveListeners = false;
+  for (const StreamComponent& component : mParallelComponents) {
+    for (AudioNodeStream* ns : component.mStreams) {
+      haveListeners = haveListeners || !ns->mListeners.IsEmpty();
+    }
+  }
+
+  uint32_t count = mParallelComponents.Length();
+  if (haveListeners) {
+    for (uint32_t i = 0; i < count; ++i) {
+      ProduceDataForParallelComponent(i);
+    }
+    return;
+  }
+
+  RefPtr<ParallelProcessingJob> job = new ParallelProcessingJob(this, count);
+  uint32_t workers = std::min(count - 1, mProcessingThreadCount);
+  for (uint32_t i = 0; i < workers; ++i) {
+    RefPtr<ParallelProcessingJob> workerJob = job;
+    mProcessingPool->Dispatch(NS_NewRunnableFunction([workerJob]() -> void {
+      workerJob->Run();
+    }), NS_DISPATCH_NORMAL);
+  }
+
+  // The graph thread does its share, then waits for the workers.
+  job->Run();
+  job->WaitUntilDone();
+}
+
+void
+MediaStreamGraphImpl::ProduceDataForParallelComponent(uint32_t aIndex)
+{
+  const StreamComponent& component = mParallelComponents[aIndex];
+  GraphTime t = mProcessedTime;
+  while (t < mStateComputedTime) {
+    GraphTime next = RoundUpToNextAudioBlock(t);
+    for (AudioNodeStream* ns : component.mCycleBreakers) {
+      ns->ProduceOutputBeforeInput(t);
+    }
+    for (AudioNodeStream* ns : component.mStreams) {
+      ns->ProcessInput(t, next,
+          (next == mStateComputedTime) ? ProcessedMediaStream::ALLOW_FINISH : 0);
+    }
+    t = next;
+  }
+}
+
+bool
+MediaStreamGraphImpl::OnProcessingThread() const
+{
+  bool onThread = false;
+  return mProcessingPool &&
+         NS_SUCCEEDED(mProcessingPool->IsOnCurrentThread(&onThread)) &&
+         onThread;
+}
+
 bool
 MediaStreamGraphImpl::AllFinishedStreamsNotified()
 {
@@ -1219,7 +1432,9 @@ MediaStreamGraphImpl::AllFinishedStreamsNotified()
 void
 MediaStreamGraphImpl::RunMessageAfterProcessing(UniquePtr<ControlMessage> aMessage)
 {
-  MOZ_ASSERT(CurrentDriver()->OnThread());
+  MOZ_ASSERT(CurrentDriver()->OnThread() || OnProcessingThread());
+
+  MutexAutoLock lock(mParallelProcessingMutex);
 
   if (mFrontMessageQueue.IsEmpty()) {
     mFrontMessageQueue.AppendElement();
@@ -1230,6 +1445,13 @@ MediaStreamGraphImpl::RunMessageAfterProcessing(UniquePtr<ControlMessage> aMessa
   mFrontMessageQueue[0].mMessages.AppendElement(Move(aMessage));
 }
 
+void
+MediaStreamGraphImpl::DispatchToMainThreadAfterStreamStateUpdate(already_AddRefed<nsIRunnable> aRunnable)
+{
+  MutexAutoLock lock(mParallelProcessingMutex);
+  MediaStreamGraph::DispatchToMainThreadAfterStreamStateUpdate(Move(aRunnable));
+}
+
 void
 MediaStreamGraphImpl::RunMessagesInQueue()
 {
@@ -1315,10 +1537,16 @@ MediaStreamGraphImpl::Process()
 
   mMixer.StartMixing();
 
+  // Components that don't depend on each other can be processed in parallel,
+  // before the other streams are processed and anything is played.
+  if (!mParallelComponents.IsEmpty()) {
+    ProduceDataForParallelComponents();
+  }
+
   // Figure out what each stream wants to do
   for (uint32_t i = 0; i < mStreams.Length(); ++i) {
     MediaStream* stream = mStreams[i];
-    if (!doneAllProducing) {
+    if (!doneAllProducing && !IsInParallelComponent(i)) {
       ProcessedMediaStream* ps = stream->AsProcessedStream();
       if (ps) {
         AudioNodeStream* n = stream->AsAudioNodeStream();
@@ -3298,6 +3526,8 @@ MediaStreamGraphImpl::MediaStreamGraphImpl(GraphDriverType aDriverRequested,
                                            TrackRate aSampleRate,
                                            dom::AudioChannel aChannel)
   : MediaStreamGraph(aSampleRate)
+  , mProcessingThreadCount(0)
+  , mParallelProcessingMutex("MediaStreamGraphImpl::mParallelProcessingMutex")
   , mPortCount(0)
   , mInputWanted(false)
   , mInputDeviceID(-1)
@@ -3338,6 +3568,14 @@ MediaStreamGraphImpl::MediaStreamGraphImpl(GraphDriverType aDriverRequested,
 
   mLastMainThreadUpdate = TimeStamp::Now();
 
+  MediaPrefs::GetSingleton();
+  mProcessingThreadCount = MediaPrefs::MediaGraphParallelProcessingThreads();
+  if (mProcessingThreadCount > 0) {
+    mProcessingPool =
+      SharedThreadPool::Get(NS_LITERAL_CSTRING("MediaStreamGraph"),
+                            mProcessingThreadCount);
+  }
+
   RegisterWeakAsyncMemoryReporter(this);
 }
 
@@ -12,6 +12,7 @@
 
 #include "nsITimer.h"
 #include "mozilla/Monitor.h"
+#include "mozilla/Mutex.h"
 #include "mozilla/TimeStamp.h"
 #include "nsIMemoryReporter.h"
 #include "nsIThread.h"
@@ -30,6 +31,7 @@ template <typename T>
 class LinkedList;
 #ifdef MOZ_WEBRTC
 class AudioOutputObserver;
+class SharedThreadPool;
 #endif
 
 /**
@@ -310,6 +312,8 @@ public:
    */
   void RunMessageAfterProcessing(UniquePtr<ControlMessage> aMessage);
 
+  void DispatchToMainThreadAfterStreamStateUpdate(already_AddRefed<nsIRunnable> aRunnable) override;
+
   /**
    * Called when a suspend/resume/close operation has been completed, on the
    * graph thread.
@@ -371,6 +375,38 @@ public:
    */
   void ProduceDataForStreamsBlockByBlock(uint32_t aStreamIndex,
                                          TrackRate aSampleRate);
+  /**
+   * Group mStreams into connected components, and record in
+   * mParallelComponents the components made up only of AudioNodeStreams.
+   * Those don't touch any state outside of the component while processing,
+   * so they can be processed in parallel with each other.
+   * Called by UpdateStreamOrder when the order changes.
+   */
+  void UpdateParallelComponents();
+  /**
+   * Produce data for all the streams in mParallelComponents, spreading the
+   * components over mProcessingPool and the graph thread. Returns once all of
+   * them have been processed.
+   */
+  void ProduceDataForParallelComponents();
+  /**
+   * Produce data for the streams of mParallelComponents[aIndex], block by
+   * block. Can be called on a worker thread of mProcessingPool.
+   */
+  void ProduceDataForParallelComponent(uint32_t aIndex);
+  /**
+   * True if mStreams[aStreamIndex] is processed as part of
+   * mParallelComponents rather than by the graph thread.
+   */
+  bool IsInParallelComponent(uint32_t aStreamIndex) const
+  {
+    return aStreamIndex < mInParallelComponent.Length() &&
+           mInParallelComponent[aStreamIndex];
+  }
+  /**
+   * True on the threads of mProcessingPool.
+   */
+  bool OnProcessingThread() const;
   /**
    * If aStream will underrun between aTime, and aEndBlockingDecisions, returns
    * the time at which the underrun will start. Otherwise return
@@ -619,6 +655,39 @@ public:
    * cycles.
    */
   uint32_t mFirstCycleBreaker;
+  /**
+   * A set of streams which have no inputs from, and no outputs to, streams
+   * outside of the set.
+   */
+  struct StreamComponent
+  {
+    // All the streams of the component, in mStreams order.
+    nsTArray<AudioNodeStream*> mStreams;
+    // The streams of the component at or after mFirstCycleBreaker.
+    nsTArray<AudioNodeStream*> mCycleBreakers;
+  };
+  /**
+   * Components of mStreams which can be processed in parallel. Only set if
+   * there are at least two of them.
+   */
+  nsTArray<StreamComponent> mParallelComponents;
+  /**
+   * Whether each stream in mStreams is part of mParallelComponents.
+   */
+  nsTArray<bool> mInParallelComponent;
+  /**
+   * Worker threads for processing mParallelComponents, if the
+   * media.graph.parallel-processing.threads pref is set.
+   */
+  RefPtr<SharedThreadPool> mProcessingPool;
+  uint32_t mProcessingThreadCount;
+  /**
+   * Guards the graph state which streams may modify while they are processed
+   * in parallel: the messages queued by RunMessageAfterProcessing(), the
+   * runnables queued by DispatchToMainThreadAfterStreamStateUpdate(), and the
+   * state changed by FinishStream().
+   */
+  Mutex mParallelProcessingMutex;
   /**
    * Blocking decisions have been computed up to this time.
    * Between each iteration, this is the same as mProcessedTime.
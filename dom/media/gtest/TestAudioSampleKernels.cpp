@@ -0,0 +1,137 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "gtest/gtest.h"
+#include "AudioSampleFormat.h"
+#include "AudioSampleKernels.h"
+#include "nsTArray.h"
+
+using namespace mozilla;
+
+// Lengths that exercise every combination of AVX2, SSE2 and NEON blocks, plus
+// a scalar tail.
+static const uint32_t kMaxFrames = 41;
+
+static float
+TestSample(uint32_t aIndex)
+{
+  // Includes values outside of [-1, 1] to exercise clamping.
+  return float(int32_t((aIndex * 7919) % 301) - 150) / 100.0f;
+}
+
+TEST(AudioSampleKernels, Convert)
+{
+  for (uint32_t count = 0; count <= kMaxFrames; ++count) {
+    nsTArray<float> floats;
+    nsTArray<int16_t> shorts;
+    for (uint32_t i = 0; i < count; ++i) {
+      floats.AppendElement(TestSample(i));
+      shorts.AppendElement(int16_t(i * 1597));
+    }
+
+    nsTArray<int16_t> toShorts;
+    toShorts.SetLength(count);
+    AudioSamplesConvert(floats.Elements(), toShorts.Elements(), count, 0.5f);
+    nsTArray<float> toFloats;
+    toFloats.SetLength(count);
+    AudioSamplesConvert(shorts.Elements(), toFloats.Elements(), count, 0.5f);
+
+    for (uint32_t i = 0; i < count; ++i) {
+      EXPECT_EQ(FloatToAudioSample<int16_t>(floats[i] * 0.5f), toShorts[i]);
+      EXPECT_EQ(AudioSampleToFloat(shorts[i]) * 0.5f, toFloats[i]);
+    }
+  }
+}
+
+TEST(AudioSampleKernels, Add)
+{
+  for (uint32_t count = 0; count <= kMaxFrames; ++count) {
+    nsTArray<float> input;
+    nsTArray<float> output;
+    nsTArray<int16_t> shortInput;
+    nsTArray<int16_t> shortOutput;
+    for (uint32_t i = 0; i < count; ++i) {
+      input.AppendElement(TestSample(i));
+      output.AppendElement(TestSample(i + 1));
+      shortInput.AppendElement(int16_t(i * 1597));
+      shortOutput.AppendElement(int16_t(i * 4099));
+    }
+
+    AudioSamplesAdd(input.Elements(), output.Elements(), count);
+    AudioSamplesAdd(shortInput.Elements(), shortOutput.Elements(), count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+      EXPECT_EQ(TestSample(i) + TestSample(i + 1), output[i]);
+      EXPECT_EQ(int16_t(int16_t(i * 1597) + int16_t(i * 4099)), shortOutput[i]);
+    }
+  }
+}
+
+TEST(AudioSampleKernels, InterleaveAndDeinterleave)
+{
+  for (uint32_t channels = 1; channels <= 3; ++channels) {
+    for (uint32_t frames = 0; frames <= kMaxFrames; ++frames) {
+      nsTArray<nsTArray<float>> planar;
+      nsTArray<const float*> planarPtrs;
+      planar.SetLength(channels);
+      for (uint32_t c = 0; c < channels; ++c) {
+        for (uint32_t i = 0; i < frames; ++i) {
+          planar[c].AppendElement(TestSample(i * channels + c));
+        }
+        planarPtrs.AppendElement(planar[c].Elements());
+      }
+
+      nsTArray<float> interleaved;
+      interleaved.SetLength(frames * channels);
+      AudioSamplesInterleave(planarPtrs.Elements(), channels, frames, 0.5f,
+                             interleaved.Elements());
+      nsTArray<int16_t> interleavedShorts;
+      interleavedShorts.SetLength(frames * channels);
+      AudioSamplesInterleave(planarPtrs.Elements(), channels, frames, 0.5f,
+                             interleavedShorts.Elements());
+
+      for (uint32_t i = 0; i < frames; ++i) {
+        for (uint32_t c = 0; c < channels; ++c) {
+          EXPECT_EQ(planar[c][i] * 0.5f, interleaved[i * channels + c]);
+          EXPECT_EQ(FloatToAudioSample<int16_t>(planar[c][i] * 0.5f),
+                    interleavedShorts[i * channels + c]);
+        }
+      }
+
+      nsTArray<nsTArray<float>> deinterleaved;
+      nsTArray<float*> deinterleavedPtrs;
+      deinterleaved.SetLength(channels);
+      for (uint32_t c = 0; c < channels; ++c) {
+        deinterleaved[c].SetLength(frames);
+        deinterleavedPtrs.AppendElement(deinterleaved[c].Elements());
+      }
+      AudioSamplesDeinterleave(interleaved.Elements(), channels, frames,
+                               deinterleavedPtrs.Elements());
+
+      for (uint32_t c = 0; c < channels; ++c) {
+        for (uint32_t i = 0; i < frames; ++i) {
+          EXPECT_EQ(planar[c][i] * 0.5f, deinterleaved[c][i]);
+        }
+      }
+    }
+  }
+}
+
+TEST(AudioSampleKernels, DownmixStereoToMonoInPlace)
+{
+  for (uint32_t frames = 0; frames <= kMaxFrames; ++frames) {
+    nsTArray<float> buffer;
+    for (uint32_t i = 0; i < frames * 2; ++i) {
+      buffer.AppendElement(TestSample(i));
+    }
+
+    AudioSamplesDownmixStereoToMono(buffer.Elements(), buffer.Elements(),
+                                    frames);
+
+    for (uint32_t i = 0; i < frames; ++i) {
+      EXPECT_EQ((TestSample(2 * i) + TestSample(2 * i + 1)) * 0.5f, buffer[i]);
+    }
+  }
+}
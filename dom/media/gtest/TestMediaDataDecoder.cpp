@@ -18,15 +18,15 @@ public:
   explicit BenchmarkRunner(Benchmark* aBenchmark)
     : mBenchmark(aBenchmark) {}
 
-  uint32_t Run()
+  Benchmark::Result Run()
   {
     bool done = false;
-    uint32_t result = 0;
+    Benchmark::Result result;
 
     mBenchmark->Init();
     mBenchmark->Run()->Then(
       AbstractThread::MainThread(), __func__,
-      [&](uint32_t aDecodeFps) { result = aDecodeFps; done = true; },
+      [&](const Benchmark::Result& aResult) { result = aResult; done = true; },
       [&]() { done = true; });
 
     // Wait until benchmark completes.
@@ -52,7 +52,7 @@ TEST(MediaDataDecoder, H264)
     EXPECT_TRUE(NS_SUCCEEDED(rv));
 
     BenchmarkRunner runner(new Benchmark(new MP4Demuxer(resource)));
-    EXPECT_GT(runner.Run(), 0u);
+    EXPECT_GT(runner.Run().mDecodeFps, 0u);
   }
 }
 
@@ -67,6 +67,30 @@ TEST(MediaDataDecoder, VP9)
     EXPECT_TRUE(NS_SUCCEEDED(rv));
 
     BenchmarkRunner runner(new Benchmark(new WebMDemuxer(resource)));
-    EXPECT_GT(runner.Run(), 0u);
+    EXPECT_GT(runner.Run().mDecodeFps, 0u);
+  }
+}
+
+TEST(MediaDataDecoder, VP9Metrics)
+{
+  if (!DecoderTraits::IsWebMTypeAndEnabled(NS_LITERAL_CSTRING("video/webm"))) {
+    EXPECT_TRUE(true);
+  } else {
+    RefPtr<MediaResource> resource =
+      new MockMediaResource("vp9cake.webm", NS_LITERAL_CSTRING("video/webm"));
+    nsresult rv = resource->Open(nullptr);
+    EXPECT_TRUE(NS_SUCCEEDED(rv));
+
+    Benchmark::Parameters parameters(10, 1, TimeDuration::FromSeconds(10));
+    parameters.mMeasureImageCopy = true;
+    BenchmarkRunner runner(new Benchmark(new WebMDemuxer(resource),
+                                         parameters));
+    Benchmark::Result result = runner.Run();
+    EXPECT_GT(result.mFrames, 0u);
+    EXPECT_FALSE(result.mDecoderName.IsEmpty());
+    EXPECT_LE(result.mLatencyMedian, result.mLatency90);
+    EXPECT_LE(result.mLatency90, result.mLatency99);
+    EXPECT_LE(result.mLatency99, result.mLatencyMax);
+    EXPECT_GT(result.mBytesPerFrame, 0u);
   }
 }
@@ -254,4 +254,29 @@ TEST(MozPromise, Chaining)
   });
 }
 
+TEST(MozPromise, SynchronousTaskDispatch)
+{
+  AutoTaskQueue atq;
+  RefPtr<TaskQueue> queue = atq.Queue();
+  RunOnTaskQueue(queue, [queue] () -> void {
+    RefPtr<TestPromise::Private> p = new TestPromise::Private(__func__);
+    p->UseSynchronousTaskDispatch(__func__);
+    int order = 0;
+    p->Then(queue, __func__,
+      [&order] (int aResolveValue) -> void { EXPECT_EQ(aResolveValue, 42); EXPECT_EQ(order++, 0); },
+      DO_FAIL);
+    p->Then(queue, __func__,
+      [&order] (int aResolveValue) -> void { EXPECT_EQ(aResolveValue, 42); EXPECT_EQ(order++, 1); },
+      DO_FAIL);
+    p->Resolve(42, __func__);
+    // Both callbacks ran before Resolve() returned.
+    EXPECT_EQ(order, 2);
+
+    // Then() on a settled promise still goes through the event loop.
+    p->Then(queue, __func__,
+      [queue] (int aResolveValue) -> void { EXPECT_EQ(aResolveValue, 42); queue->BeginShutdown(); },
+      DO_FAIL);
+  });
+}
+
 #undef DO_FAIL
@@ -0,0 +1,68 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include "gtest/gtest.h"
+#include "FFTConvolver.h"
+#include "nsTArray.h"
+
+using namespace mozilla;
+
+static float
+ConvolverTestSample(uint32_t aIndex)
+{
+  return float(int32_t((aIndex * 7919) % 201) - 100) / 100.0f;
+}
+
+static void
+CheckAgainstDirectConvolution(uint32_t aFFTSize, uint32_t aResponseLength)
+{
+  nsTArray<float> response;
+  for (uint32_t i = 0; i < aResponseLength; ++i) {
+    response.AppendElement(ConvolverTestSample(i + 17) / aResponseLength);
+  }
+
+  WebCore::PartitionedFFTConvolver convolver(response.Elements(),
+                                             aResponseLength, aFFTSize);
+  EXPECT_EQ((aResponseLength + aFFTSize / 2 - 1) / (aFFTSize / 2),
+            convolver.partitionCount());
+  size_t latency = convolver.latencyFrames();
+
+  const uint32_t blocks = 3 * aResponseLength / WEBAUDIO_BLOCK_SIZE;
+  nsTArray<float> input;
+  for (uint32_t i = 0; i < blocks * WEBAUDIO_BLOCK_SIZE; ++i) {
+    input.AppendElement(ConvolverTestSample(i));
+  }
+
+  for (uint32_t block = 0; block < blocks; ++block) {
+    const float* output =
+      convolver.process(input.Elements() + block * WEBAUDIO_BLOCK_SIZE);
+    for (uint32_t i = 0; i < WEBAUDIO_BLOCK_SIZE; ++i) {
+      size_t frame = block * WEBAUDIO_BLOCK_SIZE + i;
+      float expected = 0.0f;
+      if (frame >= latency) {
+        size_t t = frame - latency;
+        for (size_t k = 0; k < aResponseLength && k <= t; ++k) {
+          expected += response[k] * input[t - k];
+        }
+      }
+      ASSERT_NEAR(expected, output[i], 1e-4f) << "at frame " << frame;
+    }
+  }
+}
+
+TEST(PartitionedFFTConvolver, OnePartition)
+{
+  CheckAgainstDirectConvolution(512, 200);
+}
+
+TEST(PartitionedFFTConvolver, PartialLastPartition)
+{
+  CheckAgainstDirectConvolution(512, 1000);
+}
+
+TEST(PartitionedFFTConvolver, WholePartitions)
+{
+  CheckAgainstDirectConvolution(1024, 4096);
+}
@@ -219,6 +219,33 @@ PDMFactory::CreateDecoder(const CreateDecoderParams& aParams)
   return nullptr;
 }
 
+already_AddRefed<MediaDataDecoder>
+PDMFactory::CreateDecoderNamed(const CreateDecoderParams& aParams,
+                               const nsACString& aDecoderName)
+{
+  const TrackInfo& config = aParams.mConfig;
+  nsTArray<RefPtr<PlatformDecoderModule>> pdms(mCurrentPDMs);
+  if (mBlankPDM) {
+    pdms.AppendElement(mBlankPDM);
+  }
+
+  for (auto& current : pdms) {
+    if (!current->SupportsMimeType(config.mMimeType, nullptr)) {
+      continue;
+    }
+    RefPtr<MediaDataDecoder> m = CreateDecoderWithPDM(current, aParams);
+    if (!m) {
+      continue;
+    }
+    if (nsDependentCString(m->GetDescriptionName()).Find(aDecoderName) !=
+        kNotFound) {
+      return m.forget();
+    }
+    m->Shutdown();
+  }
+  return nullptr;
+}
+
 already_AddRefed<MediaDataDecoder>
 PDMFactory::CreateDecoderWithPDM(PlatformDecoderModule* aPDM,
                                  const CreateDecoderParams& aParams)
@@ -33,6 +33,13 @@ public:
   already_AddRefed<MediaDataDecoder>
   CreateDecoder(const CreateDecoderParams& aParams);
 
+  // Like CreateDecoder, but only returns a decoder whose description contains
+  // aDecoderName, trying every PDM that supports the track. Lets benchmarks
+  // compare the decoders of different PDMs. Doesn't handle encrypted tracks.
+  already_AddRefed<MediaDataDecoder>
+  CreateDecoderNamed(const CreateDecoderParams& aParams,
+                     const nsACString& aDecoderName);
+
   bool SupportsMimeType(const nsACString& aMimeType,
                         DecoderDoctorDiagnostics* aDiagnostics) const;
 
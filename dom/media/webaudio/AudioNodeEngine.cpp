@@ -181,6 +181,30 @@ BufferComplexMultiply(const float* aInput,
   }
 }
 
+void
+BufferComplexMultiplyAccumulate(const float* aInput,
+                                const float* aScale,
+                                float* aOutput,
+                                uint32_t aSize)
+{
+
+#ifdef USE_SSE2
+  if (mozilla::supports_sse()) {
+    BufferComplexMultiplyAccumulate_SSE(aInput, aScale, aOutput, aSize);
+    return;
+  }
+#endif
+
+  for (uint32_t i = 0; i < aSize * 2; i += 2) {
+    float real1 = aInput[i];
+    float imag1 = aInput[i + 1];
+    float real2 = aScale[i];
+    float imag2 = aScale[i + 1];
+    aOutput[i] += real1 * real2 - imag1 * imag2;
+    aOutput[i + 1] += real1 * imag2 + imag1 * real2;
+  }
+}
+
 float
 AudioBufferPeakValue(const float *aInput, uint32_t aSize)
 {
@@ -184,6 +184,15 @@ void BufferComplexMultiply(const float* aInput,
                            float* aOutput,
                            uint32_t aSize);
 
+/**
+ * Vector complex multiply-accumulate on arbitrary sized buffers:
+ * aOutput += aInput * aScale.
+ */
+void BufferComplexMultiplyAccumulate(const float* aInput,
+                                     const float* aScale,
+                                     float* aOutput,
+                                     uint32_t aSize);
+
 /**
  * Vector maximum element magnitude ( max(abs(aInput)) ).
  */
@@ -270,6 +270,47 @@ void BufferComplexMultiply_SSE(const float* aInput,
   }
 }
 
+void
+BufferComplexMultiplyAccumulate_SSE(const float* aInput,
+                                    const float* aScale,
+                                    float* aOutput,
+                                    uint32_t aSize)
+{
+  unsigned i;
+  __m128 in0, in1, in2, in3,
+         real0, real1, imag0, imag1,
+         outreal, outimag;
+
+  ASSERT_ALIGNED16(aInput);
+  ASSERT_ALIGNED16(aScale);
+  ASSERT_ALIGNED16(aOutput);
+  ASSERT_MULTIPLE16(aSize);
+
+  for (i = 0; i < aSize * 2; i += 8) {
+    in0 = _mm_load_ps(&aInput[i]);
+    in1 = _mm_load_ps(&aInput[i + 4]);
+    in2 = _mm_load_ps(&aScale[i]);
+    in3 = _mm_load_ps(&aScale[i + 4]);
+
+    real0 = _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(2, 0, 2, 0));
+    imag0 = _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(3, 1, 3, 1));
+    real1 = _mm_shuffle_ps(in2, in3, _MM_SHUFFLE(2, 0, 2, 0));
+    imag1 = _mm_shuffle_ps(in2, in3, _MM_SHUFFLE(3, 1, 3, 1));
+
+    outreal = _mm_sub_ps(_mm_mul_ps(real0, real1), _mm_mul_ps(imag0, imag1));
+    outimag = _mm_add_ps(_mm_mul_ps(real0, imag1), _mm_mul_ps(imag0, real1));
+
+    // Interleave the products and add them to what is already there.
+    in0 = _mm_add_ps(_mm_load_ps(&aOutput[i]),
+                     _mm_unpacklo_ps(outreal, outimag));
+    in1 = _mm_add_ps(_mm_load_ps(&aOutput[i + 4]),
+                     _mm_unpackhi_ps(outreal, outimag));
+
+    _mm_store_ps(&aOutput[i], in0);
+    _mm_store_ps(&aOutput[i + 4], in1);
+  }
+}
+
 float
 AudioBufferSumOfSquares_SSE(const float* aInput, uint32_t aLength)
 {
@@ -42,4 +42,10 @@ BufferComplexMultiply_SSE(const float* aInput,
                           const float* aScale,
                           float* aOutput,
                           uint32_t aSize);
+
+void
+BufferComplexMultiplyAccumulate_SSE(const float* aInput,
+                                    const float* aScale,
+                                    float* aOutput,
+                                    uint32_t aSize);
 }
@@ -146,6 +146,35 @@ public:
     mOutputBuffer[0].i = 0.0f;
   }
 
+  // The frequency data is FFTSize() / 2 + 1 interleaved complex values, so
+  // SpectrumLength() floats.  Copies of it, made with CopySpectrumTo(), can
+  // be kept without holding an FFTBlock and its FFT setup for each one.
+  uint32_t SpectrumLength() const
+  {
+    return mFFTSize + 2;
+  }
+  void CopySpectrumTo(float* aSpectrumOut) const
+  {
+    PodCopy(aSpectrumOut, mOutputBuffer.Elements()->f, SpectrumLength());
+  }
+  void ZeroSpectrum()
+  {
+    PodZero(mOutputBuffer.Elements(), mFFTSize / 2 + 1);
+  }
+
+  // Add the product of two copied spectra to the frequency data.  aSpectrum
+  // and aKernel must be 16-byte aligned.
+  void MultiplyAccumulate(const float* aSpectrum, const float* aKernel)
+  {
+    uint32_t halfSize = mFFTSize / 2;
+    BufferComplexMultiplyAccumulate(aSpectrum, aKernel,
+                                    mOutputBuffer.Elements()->f, halfSize);
+    // The Nyquist component is real.
+    mOutputBuffer[halfSize].r += aSpectrum[mFFTSize] * aKernel[mFFTSize];
+    // This would have been set to NaN if either real component was NaN.
+    mOutputBuffer[0].i = 0.0f;
+  }
+
   // Perform a forward FFT on |aData|, assuming zeros after dataSize samples,
   // and pre-scale the generated internal frequency domain coefficients so
   // that GetInverseWithoutScaling() can be used to transform to the time
@@ -116,4 +116,104 @@ size_t FFTConvolver::latencyFrames() const
         WEBAUDIO_BLOCK_SIZE;
 }
 
+PartitionedFFTConvolver::PartitionedFFTConvolver(const float* impulseResponse,
+                                                 size_t impulseResponseLength,
+                                                 size_t fftSize,
+                                                 size_t renderPhase)
+    : m_frame(fftSize)
+    , m_inputSpectrumIndex(0)
+    , m_readWriteIndex(renderPhase % (fftSize / 2))
+{
+    MOZ_ASSERT(fftSize >= 2 * WEBAUDIO_BLOCK_SIZE);
+    MOZ_ASSERT(impulseResponseLength > 0);
+
+    size_t halfSize = fftSize / 2;
+    m_partitionCount = (impulseResponseLength + halfSize - 1) / halfSize;
+    m_spectrumStride = (m_frame.SpectrumLength() + 3) & ~size_t(3);
+
+    m_kernelSpectra.SetLength(m_partitionCount * m_spectrumStride);
+    PodZero(m_kernelSpectra.Elements(), m_kernelSpectra.Length());
+    for (size_t i = 0; i < m_partitionCount; ++i) {
+        size_t offset = i * halfSize;
+        size_t length = std::min(halfSize, impulseResponseLength - offset);
+        m_frame.PadAndMakeScaledDFT(impulseResponse + offset, length);
+        m_frame.CopySpectrumTo(m_kernelSpectra.Elements() + i * m_spectrumStride);
+    }
+
+    m_inputSpectra.SetLength(m_partitionCount * m_spectrumStride);
+    PodZero(m_inputSpectra.Elements(), m_inputSpectra.Length());
+
+    m_inputBuffer.SetLength(fftSize);
+    PodZero(m_inputBuffer.Elements(), fftSize);
+    m_outputBuffer.SetLength(fftSize);
+    PodZero(m_outputBuffer.Elements(), fftSize);
+    m_lastOverlapBuffer.SetLength(halfSize);
+    PodZero(m_lastOverlapBuffer.Elements(), halfSize);
+}
+
+size_t PartitionedFFTConvolver::sizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf) const
+{
+    size_t amount = 0;
+    amount += m_frame.SizeOfExcludingThis(aMallocSizeOf);
+    amount += m_kernelSpectra.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    amount += m_inputSpectra.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    amount += m_inputBuffer.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    amount += m_outputBuffer.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    amount += m_lastOverlapBuffer.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    return amount;
+}
+
+size_t PartitionedFFTConvolver::sizeOfIncludingThis(mozilla::MallocSizeOf aMallocSizeOf) const
+{
+    return aMallocSizeOf(this) + sizeOfExcludingThis(aMallocSizeOf);
+}
+
+const float* PartitionedFFTConvolver::process(const float* sourceP)
+{
+    size_t halfSize = fftSize() / 2;
+    MOZ_ASSERT(halfSize % WEBAUDIO_BLOCK_SIZE == 0);
+    MOZ_ASSERT(sourceP && m_readWriteIndex + WEBAUDIO_BLOCK_SIZE <= halfSize);
+
+    memcpy(m_inputBuffer.Elements() + m_readWriteIndex, sourceP,
+           sizeof(float) * WEBAUDIO_BLOCK_SIZE);
+    m_readWriteIndex += WEBAUDIO_BLOCK_SIZE;
+
+    if (m_readWriteIndex == halfSize) {
+        // The second half of the input buffer is always zero, so the result
+        // of each partition fits in fftSize frames.
+        m_frame.PerformFFT(m_inputBuffer.Elements());
+        m_frame.CopySpectrumTo(m_inputSpectra.Elements() +
+                               m_inputSpectrumIndex * m_spectrumStride);
+
+        // Input that arrived i buffers ago is delayed by partition i.
+        m_frame.ZeroSpectrum();
+        size_t inputIndex = m_inputSpectrumIndex;
+        for (size_t i = 0; i < m_partitionCount; ++i) {
+            m_frame.MultiplyAccumulate(m_inputSpectra.Elements() +
+                                         inputIndex * m_spectrumStride,
+                                       m_kernelSpectra.Elements() +
+                                         i * m_spectrumStride);
+            inputIndex = inputIndex ? inputIndex - 1 : m_partitionCount - 1;
+        }
+        m_inputSpectrumIndex = (m_inputSpectrumIndex + 1) % m_partitionCount;
+
+        m_frame.GetInverseWithoutScaling(m_outputBuffer.Elements());
+
+        AudioBufferAddWithScale(m_lastOverlapBuffer.Elements(), 1.0f,
+                                m_outputBuffer.Elements(), halfSize);
+        memcpy(m_lastOverlapBuffer.Elements(),
+               m_outputBuffer.Elements() + halfSize, sizeof(float) * halfSize);
+
+        m_readWriteIndex = 0;
+    }
+
+    return m_outputBuffer.Elements() + m_readWriteIndex;
+}
+
+size_t PartitionedFFTConvolver::latencyFrames() const
+{
+    return std::max<size_t>(fftSize()/2, WEBAUDIO_BLOCK_SIZE) -
+        WEBAUDIO_BLOCK_SIZE;
+}
+
 } // namespace WebCore
@@ -80,6 +80,56 @@ private:
     AlignedAudioFloatArray m_lastOverlapBuffer;
 };
 
+// Convolves with an impulse response split into uniform partitions of
+// fftSize / 2 frames.  Each fftSize / 2 frames of input is transformed once,
+// and the spectra of recent input are kept, so that the output spectrum is
+// the sum of their products with the spectra of the partitions.  This costs
+// one forward and one inverse FFT per fftSize / 2 frames however long the
+// impulse response is, instead of one of each for every FFTConvolver.
+class PartitionedFFTConvolver {
+public:
+    // |fftSize| must be a power of two.  |impulseResponse| is copied, and
+    // needs no scaling.  |renderPhase| is as for FFTConvolver.
+    PartitionedFFTConvolver(const float* impulseResponse,
+                            size_t impulseResponseLength,
+                            size_t fftSize, size_t renderPhase = 0);
+
+    // Process WEBAUDIO_BLOCK_SIZE elements of array |sourceP| and return a
+    // pointer to an output array of the same size.
+    const float* process(const float* sourceP);
+
+    size_t fftSize() const { return m_frame.FFTSize(); }
+    size_t partitionCount() const { return m_partitionCount; }
+
+    // The same as for an FFTConvolver of the same size.
+    size_t latencyFrames() const;
+
+    size_t sizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf) const;
+    size_t sizeOfIncludingThis(mozilla::MallocSizeOf aMallocSizeOf) const;
+
+private:
+    FFTBlock m_frame;
+
+    size_t m_partitionCount;
+    // Floats between consecutive spectra, rounded up from
+    // FFTBlock::SpectrumLength() to keep each one 16-byte aligned.
+    size_t m_spectrumStride;
+
+    // The pre-scaled spectra of the partitions, in order.
+    AlignedAudioFloatArray m_kernelSpectra;
+
+    // A ring of the spectra of the last m_partitionCount input buffers.
+    // m_inputSpectrumIndex is where the next one goes.
+    AlignedAudioFloatArray m_inputSpectra;
+    size_t m_inputSpectrumIndex;
+
+    // These are used as in FFTConvolver.
+    size_t m_readWriteIndex;
+    AlignedAudioFloatArray m_inputBuffer;
+    AlignedAudioFloatArray m_outputBuffer;
+    AlignedAudioFloatArray m_lastOverlapBuffer;
+};
+
 } // namespace WebCore
 
 #endif // FFTConvolver_h
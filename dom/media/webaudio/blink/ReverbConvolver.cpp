@@ -85,9 +85,17 @@ ReverbConvolver::ReverbConvolver(const float* impulseResponseData,
     while (stageOffset < totalResponseLength) {
         size_t stageSize = fftSize / 2;
 
-        // For the last stage, it's possible that stageOffset is such that we're straddling the end
-        // of the impulse response buffer (if we use stageSize), so reduce the last stage's length...
-        if (stageSize + stageOffset > totalResponseLength) {
+        bool isBackgroundStage =
+            this->useBackgroundThreads() && stageOffset > RealtimeFrameLimit;
+
+        if (isBackgroundStage && fftSize == maxFFTSize) {
+            // The rest of the response would be in stages of the same size,
+            // so convolve it in one stage of uniform partitions.  This
+            // shares the forward and inverse FFTs between the partitions.
+            stageSize = totalResponseLength - stageOffset;
+        } else if (stageSize + stageOffset > totalResponseLength) {
+            // For the last stage, it's possible that stageOffset is such that we're straddling the end
+            // of the impulse response buffer (if we use stageSize), so reduce the last stage's length...
             stageSize = totalResponseLength - stageOffset;
             // Use smallest FFT that is large enough to cover the last stage.
             fftSize = MinFFTSize;
@@ -105,11 +113,8 @@ ReverbConvolver::ReverbConvolver(const float* impulseResponseData,
                                     fftSize, renderPhase,
                                     &m_accumulationBuffer));
 
-        bool isBackgroundStage = false;
-
-        if (this->useBackgroundThreads() && stageOffset > RealtimeFrameLimit) {
+        if (isBackgroundStage) {
             m_backgroundStages.AppendElement(stage.forget());
-            isBackgroundStage = true;
         } else
             m_stages.AppendElement(stage.forget());
 
@@ -50,15 +50,23 @@ ReverbConvolverStage::ReverbConvolverStage(const float* impulseResponse, size_t,
     MOZ_ASSERT(impulseResponse);
     MOZ_ASSERT(accumulationBuffer);
 
-    m_fftKernel = new FFTBlock(fftSize);
-    m_fftKernel->PadAndMakeScaledDFT(impulseResponse + stageOffset, stageLength);
-    m_fftConvolver = new FFTConvolver(fftSize, renderPhase);
+    size_t fftLatency;
+    if (stageLength > fftSize / 2) {
+        m_partitionedConvolver =
+            new PartitionedFFTConvolver(impulseResponse + stageOffset,
+                                        stageLength, fftSize, renderPhase);
+        fftLatency = m_partitionedConvolver->latencyFrames();
+    } else {
+        m_fftKernel = new FFTBlock(fftSize);
+        m_fftKernel->PadAndMakeScaledDFT(impulseResponse + stageOffset, stageLength);
+        m_fftConvolver = new FFTConvolver(fftSize, renderPhase);
+        fftLatency = m_fftConvolver->latencyFrames();
+    }
 
     // The convolution stage at offset stageOffset needs to have a corresponding delay to cancel out the offset.
     size_t totalDelay = stageOffset + reverbTotalLatency;
 
     // But, the FFT convolution itself incurs latency, so subtract this out...
-    size_t fftLatency = m_fftConvolver->latencyFrames();
     MOZ_ASSERT(totalDelay >= fftLatency);
     totalDelay -= fftLatency;
 
@@ -77,6 +85,10 @@ size_t ReverbConvolverStage::sizeOfIncludingThis(mozilla::MallocSizeOf aMallocSi
         amount += m_fftConvolver->sizeOfIncludingThis(aMallocSizeOf);
     }
 
+    if (m_partitionedConvolver) {
+        amount += m_partitionedConvolver->sizeOfIncludingThis(aMallocSizeOf);
+    }
+
     return amount;
 }
 
@@ -96,7 +108,9 @@ void ReverbConvolverStage::process(const float* source)
     
     // Now, run the convolution (into the delay buffer).
     // An expensive FFT will happen every fftSize / 2 frames.
-    const float* output = m_fftConvolver->process(m_fftKernel, source);
+    const float* output = m_partitionedConvolver ?
+        m_partitionedConvolver->process(source) :
+        m_fftConvolver->process(m_fftKernel, source);
 
     // Now accumulate into reverb's accumulation buffer.
     m_accumulationBuffer->accumulate(output, WEBAUDIO_BLOCK_SIZE,
@@ -45,6 +45,7 @@ class ReverbConvolver;
 
 // A ReverbConvolverStage represents the convolution associated with a sub-section of a large impulse response.
 // It incorporates a delay line to account for the offset of the sub-section within the larger impulse response.
+// A stage longer than fftSize / 2 is convolved in uniform partitions of that size.
 class ReverbConvolverStage {
 public:
     // renderPhase is useful to know so that we can manipulate the pre versus post delay so that stages will perform
@@ -64,6 +65,7 @@ public:
 private:
     nsAutoPtr<FFTBlock> m_fftKernel;
     nsAutoPtr<FFTConvolver> m_fftConvolver;
+    nsAutoPtr<PartitionedFFTConvolver> m_partitionedConvolver;
 
     ReverbAccumulationBuffer* m_accumulationBuffer;
     int m_accumulationReadIndex;
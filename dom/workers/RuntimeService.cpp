@@ -60,6 +60,7 @@
 #include "xpcpublic.h"
 
 #include "Principal.h"
+#include "ScriptLoader.h"
 #include "SharedWorker.h"
 #include "WorkerDebuggerManager.h"
 #include "WorkerPrivate.h"
@@ -2076,6 +2077,8 @@ RuntimeService::Init()
                         MAX_HARDWARE_CONCURRENCY);
   gMaxHardwareConcurrency = std::max(0, maxHardwareConcurrency);
 
+  scriptloader::InitScriptCache();
+
   rv = InitOSFileConstants();
   if (NS_FAILED(rv)) {
     return rv;
@@ -2255,6 +2258,7 @@ RuntimeService::Cleanup()
     }
   }
 
+  scriptloader::ClearScriptCache();
   CleanupOSFileConstants();
   nsLayoutStatics::Release();
 }
@@ -2688,6 +2692,7 @@ RuntimeService::Observe(nsISupports* aSubject, const char* aTopic,
     return NS_OK;
   }
   if (!strcmp(aTopic, MEMORY_PRESSURE_OBSERVER_TOPIC)) {
+    scriptloader::ClearScriptCache();
     GarbageCollectAllWorkers(/* shrinking = */ true);
     CycleCollectAllWorkers();
     MemoryPressureAllWorkers();
@@ -45,6 +45,10 @@
 #include "mozilla/Assertions.h"
 #include "mozilla/LoadContext.h"
 #include "mozilla/Maybe.h"
+#include "mozilla/Preferences.h"
+#include "mozilla/SHA1.h"
+#include "mozilla/StaticMutex.h"
+#include "mozilla/StaticPtr.h"
 #include "mozilla/ipc/BackgroundUtils.h"
 #include "mozilla/dom/CacheBinding.h"
 #include "mozilla/dom/cache/CacheTypes.h"
@@ -68,6 +72,8 @@
 
 #define MAX_CONCURRENT_SCRIPTS 1000
 
+#define PREF_WORKERS_SCRIPT_CACHE_MAX_KB "dom.workers.script_cache.max_kb"
+
 USING_WORKERS_NAMESPACE
 
 using namespace mozilla;
@@ -1888,6 +1894,141 @@ ScriptExecutorRunnable::PreRun(WorkerPrivate* aWorkerPrivate)
   return true;
 }
 
+// The bytecode of a worker script, cached so that workers that load the same
+// script don't each have to compile it.  Entries are keyed by URL and the
+// SHA-1 of the source, so a script that changed is never run from a stale
+// entry.  The cache is shared by all worker threads and holds at most
+// dom.workers.script_cache.max_kb kilobytes of bytecode; 0 (the default)
+// disables it.
+class CachedScriptBytecode final
+{
+public:
+  NS_INLINE_DECL_THREADSAFE_REFCOUNTING(CachedScriptBytecode)
+
+  CachedScriptBytecode(const nsAString& aURL, const SHA1Sum::Hash& aHash,
+                       const void* aBytecode, uint32_t aLength)
+    : mURL(aURL)
+  {
+    memcpy(mSourceHash, aHash, sizeof(mSourceHash));
+    mBytecode.AppendElements(static_cast<const uint8_t*>(aBytecode), aLength);
+  }
+
+  bool Matches(const nsAString& aURL, const SHA1Sum::Hash& aHash) const
+  {
+    return mURL.Equals(aURL) &&
+           !memcmp(mSourceHash, aHash, sizeof(mSourceHash));
+  }
+
+  const nsString mURL;
+  SHA1Sum::Hash mSourceHash;
+  nsTArray<uint8_t> mBytecode;
+
+private:
+  ~CachedScriptBytecode() {}
+};
+
+StaticMutex gScriptCacheMutex;
+// Ordered from least to most recently used.  Protected by gScriptCacheMutex.
+StaticAutoPtr<nsTArray<RefPtr<CachedScriptBytecode>>> gScriptCache;
+size_t gScriptCacheSize = 0;
+Atomic<uint32_t, Relaxed> gScriptCacheMaxKB(0);
+
+already_AddRefed<CachedScriptBytecode>
+LookupCachedScript(const nsAString& aURL, const SHA1Sum::Hash& aHash)
+{
+  StaticMutexAutoLock lock(gScriptCacheMutex);
+  if (!gScriptCache) {
+    return nullptr;
+  }
+
+  for (size_t i = gScriptCache->Length(); i > 0; i--) {
+    RefPtr<CachedScriptBytecode> entry = (*gScriptCache)[i - 1];
+    if (entry->Matches(aURL, aHash)) {
+      gScriptCache->RemoveElementAt(i - 1);
+      gScriptCache->AppendElement(entry);
+      return entry.forget();
+    }
+  }
+  return nullptr;
+}
+
+void
+StoreCachedScript(const nsAString& aURL, const SHA1Sum::Hash& aHash,
+                  const void* aBytecode, uint32_t aLength)
+{
+  size_t maxSize = size_t(gScriptCacheMaxKB) * 1024;
+  if (aLength > maxSize) {
+    return;
+  }
+
+  RefPtr<CachedScriptBytecode> entry =
+    new CachedScriptBytecode(aURL, aHash, aBytecode, aLength);
+
+  StaticMutexAutoLock lock(gScriptCacheMutex);
+  if (!gScriptCache) {
+    gScriptCache = new nsTArray<RefPtr<CachedScriptBytecode>>();
+  }
+
+  // Drop any older version of the script, then the least recently used
+  // entries until the new one fits.
+  for (size_t i = gScriptCache->Length(); i > 0; i--) {
+    if ((*gScriptCache)[i - 1]->mURL.Equals(aURL)) {
+      gScriptCacheSize -= (*gScriptCache)[i - 1]->mBytecode.Length();
+      gScriptCache->RemoveElementAt(i - 1);
+    }
+  }
+  while (!gScriptCache->IsEmpty() && gScriptCacheSize + aLength > maxSize) {
+    gScriptCacheSize -= (*gScriptCache)[0]->mBytecode.Length();
+    gScriptCache->RemoveElementAt(0);
+  }
+
+  gScriptCache->AppendElement(entry.forget());
+  gScriptCacheSize += aLength;
+}
+
+// Like JS::Evaluate, but runs the script from the bytecode cache if it has
+// been compiled before, and caches its bytecode otherwise.
+bool
+EvaluateWithScriptCache(JSContext* aCx, const JS::CompileOptions& aOptions,
+                        const nsAString& aURL,
+                        JS::SourceBufferHolder& aSrcBuf)
+{
+  SHA1Sum sha1;
+  sha1.update(aSrcBuf.get(), aSrcBuf.length() * sizeof(char16_t));
+  SHA1Sum::Hash hash;
+  sha1.finish(hash);
+
+  JS::Rooted<JSScript*> script(aCx);
+  RefPtr<CachedScriptBytecode> cached = LookupCachedScript(aURL, hash);
+  if (cached) {
+    script = JS_DecodeScript(aCx, cached->mBytecode.Elements(),
+                             cached->mBytecode.Length());
+    if (!script) {
+      // Fall back to compiling the source.
+      JS_ClearPendingException(aCx);
+    }
+  }
+
+  if (!script) {
+    if (!JS::Compile(aCx, aOptions, aSrcBuf, &script)) {
+      return false;
+    }
+
+    uint32_t length;
+    void* data = JS_EncodeScript(aCx, script, &length);
+    if (data) {
+      StoreCachedScript(aURL, hash, data, length);
+      js_free(data);
+    } else {
+      // JS_EncodeScript may have set a pending exception.
+      JS_ClearPendingException(aCx);
+    }
+  }
+
+  JS::Rooted<JS::Value> unused(aCx);
+  return JS_ExecuteScript(aCx, script, &unused);
+}
+
 bool
 ScriptExecutorRunnable::WorkerRun(JSContext* aCx, WorkerPrivate* aWorkerPrivate)
 {
@@ -1955,8 +2096,15 @@ ScriptExecutorRunnable::WorkerRun(JSContext* aCx, WorkerPrivate* aWorkerPrivate)
 
     // Our ErrorResult still shouldn't be a failure.
     MOZ_ASSERT(!mScriptLoader.mRv.Failed(), "Who failed it and why?");
+    // Only same-origin worker scripts are cached; debugger scripts and
+    // scripts whose errors are muted are always compiled from source.
+    bool useCache = gScriptCacheMaxKB &&
+                    mScriptLoader.mWorkerScriptType == WorkerScript &&
+                    !options.mutedErrors();
     JS::Rooted<JS::Value> unused(aCx);
-    if (!JS::Evaluate(aCx, options, srcBuf, &unused)) {
+    if (useCache ?
+          !EvaluateWithScriptCache(aCx, options, loadInfo.mURL, srcBuf) :
+          !JS::Evaluate(aCx, options, srcBuf, &unused)) {
       mScriptLoader.mRv.StealExceptionFromJSContext(aCx);
       return true;
     }
@@ -2255,6 +2403,23 @@ Load(WorkerPrivate* aWorkerPrivate,
   LoadAllScripts(aWorkerPrivate, loadInfos, false, aWorkerScriptType, aRv);
 }
 
+void
+InitScriptCache()
+{
+  AssertIsOnMainThread();
+
+  Preferences::AddAtomicUintVarCache(&gScriptCacheMaxKB,
+                                     PREF_WORKERS_SCRIPT_CACHE_MAX_KB, 0);
+}
+
+void
+ClearScriptCache()
+{
+  StaticMutexAutoLock lock(gScriptCacheMutex);
+  gScriptCache = nullptr;
+  gScriptCacheSize = 0;
+}
+
 } // namespace scriptloader
 
 END_WORKERS_NAMESPACE
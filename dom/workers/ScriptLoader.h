@@ -61,6 +61,12 @@ void Load(WorkerPrivate* aWorkerPrivate,
           WorkerScriptType aWorkerScriptType,
           mozilla::ErrorResult& aRv);
 
+// Sets up the worker script bytecode cache.  Main thread only.
+void InitScriptCache();
+
+// Drops every entry of the worker script bytecode cache.
+void ClearScriptCache();
+
 } // namespace scriptloader
 
 END_WORKERS_NAMESPACE
@@ -43,6 +43,7 @@
 #include "mozilla/dom/TypedArray.h"
 #include "mozilla/dom/Response.h"
 #include "mozilla/dom/WorkerScope.h"
+#include "mozilla/dom/cache/ReadStream.h"
 #include "mozilla/dom/workers/bindings/ServiceWorker.h"
 
 #include "js/Conversions.h"
@@ -670,6 +671,20 @@ RespondWithHandler::ResolvedCallback(JSContext* aCx, JS::Handle<JS::Value> aValu
     }
 
     const uint32_t kCopySegmentSize = 4096;
+    const uint32_t kCacheCopySegmentSize = 64 * 1024;
+
+    uint32_t copySegmentSize = kCopySegmentSize;
+    nsAsyncCopyMode copyMode = NS_ASYNCCOPY_VIA_WRITESEGMENTS;
+
+    // Bodies read from the Cache API are read straight from the file
+    // descriptor the parent handed over and uncompressed a snappy block at a
+    // time.  Their ReadSegments() exposes that block directly, so copy from it
+    // a whole block at a time instead of through another buffer.
+    nsCOMPtr<cache::ReadStream> cacheBody = do_QueryInterface(body);
+    if (cacheBody) {
+      copySegmentSize = kCacheCopySegmentSize;
+      copyMode = NS_ASYNCCOPY_VIA_READSEGMENTS;
+    }
 
     // Depending on how the Response passed to .respondWith() was created, we may
     // get a non-buffered input stream.  In addition, in some configurations the
@@ -678,7 +693,7 @@ RespondWithHandler::ResolvedCallback(JSContext* aCx, JS::Handle<JS::Value> aValu
     // provides the most consistent operation since there are fewer stream types
     // we are writing to.  The input stream can be a wide variety of concrete
     // objects which may or many not play well with NS_InputStreamIsBuffered().
-    if (!NS_OutputStreamIsBuffered(responseBody)) {
+    if (!cacheBody && !NS_OutputStreamIsBuffered(responseBody)) {
       nsCOMPtr<nsIOutputStream> buffered;
       rv = NS_NewBufferedOutputStream(getter_AddRefs(buffered), responseBody,
            kCopySegmentSize);
@@ -695,8 +710,8 @@ RespondWithHandler::ResolvedCallback(JSContext* aCx, JS::Handle<JS::Value> aValu
 
     // XXXnsm, Fix for Bug 1141332 means that if we decide to make this
     // streaming at some point, we'll need a different solution to that bug.
-    rv = NS_AsyncCopy(body, responseBody, stsThread, NS_ASYNCCOPY_VIA_WRITESEGMENTS,
-                      kCopySegmentSize, RespondWithCopyComplete, closure.forget());
+    rv = NS_AsyncCopy(body, responseBody, stsThread, copyMode,
+                      copySegmentSize, RespondWithCopyComplete, closure.forget());
     if (NS_WARN_IF(NS_FAILED(rv))) {
       return;
     }
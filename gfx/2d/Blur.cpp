@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "mozilla/CheckedInt.h"
+#include "mozilla/SSE.h"
 
 #include "2D.h"
 #include "DataSurfaceHelpers.h"
@@ -551,6 +552,16 @@ AlphaBoxBlur::Blur(uint8_t* aData)
         return;
       }
 
+#ifdef USE_AVX2
+      if (mozilla::supports_avx2()) {
+        BoxBlur_AVX2(aData, horizontalLobes[0][0], horizontalLobes[0][1], verticalLobes[0][0],
+                     verticalLobes[0][1], integralImage, integralImageStride);
+        BoxBlur_AVX2(aData, horizontalLobes[1][0], horizontalLobes[1][1], verticalLobes[1][0],
+                     verticalLobes[1][1], integralImage, integralImageStride);
+        BoxBlur_AVX2(aData, horizontalLobes[2][0], horizontalLobes[2][1], verticalLobes[2][0],
+                     verticalLobes[2][1], integralImage, integralImageStride);
+      } else
+#endif
 #ifdef USE_SSE2
       if (Factory::HasSSE2()) {
         BoxBlur_SSE2(aData, horizontalLobes[0][0], horizontalLobes[0][1], verticalLobes[0][0],
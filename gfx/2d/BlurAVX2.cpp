@@ -0,0 +1,271 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Blur.h"
+
+#include <algorithm>
+#include <immintrin.h>
+#include <string.h>
+
+namespace mozilla {
+namespace gfx {
+
+MOZ_ALWAYS_INLINE
+__m256i Divide(__m256i aValues, __m256i aDivisor)
+{
+  const __m256i mask = _mm256_setr_epi32(0x0, 0xffffffff, 0x0, 0xffffffff,
+                                         0x0, 0xffffffff, 0x0, 0xffffffff);
+  const __m256i roundingAddition = _mm256_set1_epi64x(int64_t(1) << 31);
+
+  __m256i multiplied31 = _mm256_mul_epu32(aValues, aDivisor);
+  __m256i multiplied42 = _mm256_mul_epu32(_mm256_srli_epi64(aValues, 32), aDivisor);
+
+  // Add 1 << 31 before shifting or masking the lower 32 bits away, so that the
+  // result is rounded.
+  __m256i p_3_1 = _mm256_srli_epi64(_mm256_add_epi64(multiplied31, roundingAddition), 32);
+  __m256i p4_2_ = _mm256_and_si256(_mm256_add_epi64(multiplied42, roundingAddition), mask);
+  return _mm256_or_si256(p_3_1, p4_2_);
+}
+
+MOZ_ALWAYS_INLINE
+__m256i BlurEightPixels(const uint32_t* aTopLeft, const uint32_t* aTopRight,
+                        const uint32_t* aBottomRight, const uint32_t* aBottomLeft,
+                        const __m256i& aDivisor)
+{
+  __m256i topLeft = _mm256_loadu_si256((const __m256i*)aTopLeft);
+  __m256i topRight = _mm256_loadu_si256((const __m256i*)aTopRight);
+  __m256i bottomRight = _mm256_loadu_si256((const __m256i*)aBottomRight);
+  __m256i bottomLeft = _mm256_loadu_si256((const __m256i*)aBottomLeft);
+  __m256i values = _mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(bottomRight, topRight), bottomLeft), topLeft);
+  return Divide(values, aDivisor);
+}
+
+// Returns the running sums of the eight pixel values in aPixels, added to
+// aRowSum, whose lanes must all hold the sum of the pixels before them.
+// aRowSum is updated to the sum including the last of the eight pixels.
+MOZ_ALWAYS_INLINE
+__m256i AccumulatePixelSums(__m256i aPixels, __m256i& aRowSum)
+{
+  // Prefix sums within each 128-bit lane...
+  __m256i sums = _mm256_add_epi32(aPixels, _mm256_slli_si256(aPixels, 4));
+  sums = _mm256_add_epi32(sums, _mm256_slli_si256(sums, 8));
+  // ...then carry the total of the low lane into the high lane.
+  __m256i lowTotal = _mm256_shuffle_epi32(_mm256_permute2x128_si256(sums, sums, 0x08),
+                                          _MM_SHUFFLE(3, 3, 3, 3));
+  sums = _mm256_add_epi32(_mm256_add_epi32(sums, lowTotal), aRowSum);
+  aRowSum = _mm256_permutevar8x32_epi32(sums, _mm256_set1_epi32(7));
+  return sums;
+}
+
+MOZ_ALWAYS_INLINE
+void StoreIntegralPixels(uint32_t* aDest, const uint32_t* aPreviousRow,
+                         __m256i aSums)
+{
+  __m256i previous = _mm256_loadu_si256((const __m256i*)aPreviousRow);
+  _mm256_storeu_si256((__m256i*)aDest, _mm256_add_epi32(aSums, previous));
+}
+
+// Fills aCount entries of an integral image row for pixels that all have the
+// value aPixel, starting from a row sum of aRowSum. Returns the new row sum.
+MOZ_ALWAYS_INLINE
+uint32_t AccumulateConstant(uint32_t* aDest, const uint32_t* aPreviousRow,
+                            uint8_t aPixel, int32_t aCount, uint32_t aRowSum)
+{
+  int32_t x = 0;
+  if (aCount >= 8) {
+    __m256i pixels = _mm256_set1_epi32(aPixel);
+    __m256i rowSum = _mm256_set1_epi32(aRowSum);
+    for (; x <= aCount - 8; x += 8) {
+      StoreIntegralPixels(aDest + x, aPreviousRow + x,
+                          AccumulatePixelSums(pixels, rowSum));
+    }
+    aRowSum = _mm_cvtsi128_si32(_mm256_castsi256_si128(rowSum));
+  }
+  for (; x < aCount; x++) {
+    aRowSum += aPixel;
+    aDest[x] = aPreviousRow[x] + aRowSum;
+  }
+  return aRowSum;
+}
+
+// Like AccumulateConstant, but for aCount pixels read from aSource.
+MOZ_ALWAYS_INLINE
+uint32_t AccumulateSource(uint32_t* aDest, const uint32_t* aPreviousRow,
+                          const uint8_t* aSource, int32_t aCount,
+                          uint32_t aRowSum)
+{
+  int32_t x = 0;
+  if (aCount >= 8) {
+    __m256i rowSum = _mm256_set1_epi32(aRowSum);
+    for (; x <= aCount - 8; x += 8) {
+      __m256i pixels = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(aSource + x)));
+      StoreIntegralPixels(aDest + x, aPreviousRow + x,
+                          AccumulatePixelSums(pixels, rowSum));
+    }
+    aRowSum = _mm_cvtsi128_si32(_mm256_castsi256_si128(rowSum));
+  }
+  for (; x < aCount; x++) {
+    aRowSum += aSource[x];
+    aDest[x] = aPreviousRow[x] + aRowSum;
+  }
+  return aRowSum;
+}
+
+/**
+ * Computes one row of the integral image from a row of the source, inflated
+ * on the left and right by repeating its edge pixels.
+ */
+MOZ_ALWAYS_INLINE void
+GenerateIntegralRow_AVX2(uint32_t* aDest, const uint32_t* aPreviousRow,
+                         const uint8_t* aSource, int32_t aSourceWidth,
+                         int32_t aLeftInflation, int32_t aRightInflation)
+{
+  uint32_t rowSum = AccumulateConstant(aDest, aPreviousRow, aSource[0],
+                                       aLeftInflation, 0);
+  aDest += aLeftInflation;
+  aPreviousRow += aLeftInflation;
+  rowSum = AccumulateSource(aDest, aPreviousRow, aSource, aSourceWidth, rowSum);
+  aDest += aSourceWidth;
+  aPreviousRow += aSourceWidth;
+  AccumulateConstant(aDest, aPreviousRow, aSource[aSourceWidth - 1],
+                     aRightInflation, rowSum);
+}
+
+/**
+ * Attempt to do an in-place box blur using an integral image.
+ *
+ * Unlike the other implementations, this doesn't compute the whole integral
+ * image up front. Row y of the output only depends on rows of the integral
+ * image up to y + aTopLobe + aBottomLobe, which in turn only depend on source
+ * rows up to y + aBottomLobe, so each row of the integral image is generated
+ * just before the first output row that needs it. The rows being read and
+ * written then stay in the cache, instead of the integral image making a
+ * round trip through memory between two separate passes.
+ */
+void
+AlphaBoxBlur::BoxBlur_AVX2(uint8_t* aData,
+                           int32_t aLeftLobe,
+                           int32_t aRightLobe,
+                           int32_t aTopLobe,
+                           int32_t aBottomLobe,
+                           uint32_t *aIntegralImage,
+                           size_t aIntegralImageStride)
+{
+  IntSize size = GetSize();
+
+  MOZ_ASSERT(size.height > 0);
+
+  // Our 'left' or 'top' lobe will include the current pixel. i.e. when
+  // looking at an integral image the value of a pixel at 'x,y' is calculated
+  // using the value of the integral image values above/below that.
+  aLeftLobe++;
+  aTopLobe++;
+  int32_t boxSize = (aLeftLobe + aRightLobe) * (aTopLobe + aBottomLobe);
+
+  MOZ_ASSERT(boxSize > 0);
+
+  if (boxSize == 1) {
+      return;
+  }
+
+  uint32_t reciprocal = uint32_t((uint64_t(1) << 32) / boxSize);
+
+  ptrdiff_t stride32bit = aIntegralImageStride / 4;
+  int32_t leftInflation = RoundUpToMultipleOf4(aLeftLobe).value();
+
+  __m256i divisor = _mm256_set1_epi32(reciprocal);
+  const __m256i packOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+  // The first row of the integral image is accumulated onto a zeroed row.
+  memset(aIntegralImage, 0, aIntegralImageStride);
+
+  // This points to the start of the rectangle within the IntegralImage that overlaps
+  // the surface being blurred.
+  uint32_t *innerIntegral = aIntegralImage + (aTopLobe * stride32bit) + leftInflation;
+
+  IntRect skipRect = mSkipRect;
+  int32_t stride = mStride;
+  uint8_t *data = aData;
+  int32_t integralRows = size.height + aTopLobe + aBottomLobe;
+  int32_t generatedRows = 0;
+  for (int32_t y = 0; y < size.height; y++) {
+    // Generate the integral image rows needed for this output row. The source
+    // rows they read have not been overwritten yet.
+    for (; generatedRows <= y + aTopLobe + aBottomLobe &&
+           generatedRows < integralRows; generatedRows++) {
+      int32_t sourceRow = std::min(std::max(generatedRows - aTopLobe, 0),
+                                   size.height - 1);
+      uint32_t *intRow = aIntegralImage + generatedRows * stride32bit;
+      uint32_t *intPrevRow = generatedRows ? intRow - stride32bit : intRow;
+      GenerateIntegralRow_AVX2(intRow, intPrevRow, data + stride * sourceRow,
+                               size.width, leftInflation, aRightLobe);
+    }
+
+    bool inSkipRectY = y > skipRect.y && y < skipRect.YMost();
+
+    uint32_t *topLeftBase = innerIntegral + ((y - aTopLobe) * stride32bit - aLeftLobe);
+    uint32_t *topRightBase = innerIntegral + ((y - aTopLobe) * stride32bit + aRightLobe);
+    uint32_t *bottomRightBase = innerIntegral + ((y + aBottomLobe) * stride32bit + aRightLobe);
+    uint32_t *bottomLeftBase = innerIntegral + ((y + aBottomLobe) * stride32bit - aLeftLobe);
+
+    int32_t x = 0;
+    // Process 32 pixels at a time for as long as possible.
+    for (; x <= size.width - 32; x += 32) {
+      if (inSkipRectY && x > skipRect.x && x < skipRect.XMost()) {
+        // Stay a multiple of 4 pixels, so that the stores below never run
+        // into the next row, which may not have been read yet.
+        x = (skipRect.XMost() & ~3) - 32;
+        // Trigger early jump on coming loop iterations, this will be reset
+        // next line anyway.
+        inSkipRectY = false;
+        continue;
+      }
+
+      __m256i result1 = BlurEightPixels(topLeftBase + x, topRightBase + x,
+                                        bottomRightBase + x, bottomLeftBase + x,
+                                        divisor);
+      __m256i result2 = BlurEightPixels(topLeftBase + x + 8, topRightBase + x + 8,
+                                        bottomRightBase + x + 8, bottomLeftBase + x + 8,
+                                        divisor);
+      __m256i result3 = BlurEightPixels(topLeftBase + x + 16, topRightBase + x + 16,
+                                        bottomRightBase + x + 16, bottomLeftBase + x + 16,
+                                        divisor);
+      __m256i result4 = BlurEightPixels(topLeftBase + x + 24, topRightBase + x + 24,
+                                        bottomRightBase + x + 24, bottomLeftBase + x + 24,
+                                        divisor);
+
+      // Packing works within 128-bit lanes, so each group of four bytes ends
+      // up interleaved with the others; put them back in order.
+      __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(result1, result2),
+                                           _mm256_packs_epi32(result3, result4));
+      __m256i final = _mm256_permutevar8x32_epi32(packed, packOrder);
+
+      _mm256_storeu_si256((__m256i*)(data + stride * y + x), final);
+    }
+
+    // Process the remaining pixels 4 bytes at a time.
+    for (; x < size.width; x += 4) {
+      if (inSkipRectY && x > skipRect.x && x < skipRect.XMost()) {
+        x = (skipRect.XMost() & ~3) - 4;
+        // Trigger early jump on coming loop iterations, this will be reset
+        // next line anyway.
+        inSkipRectY = false;
+        continue;
+      }
+      __m128i topLeft = _mm_loadu_si128((__m128i*)(topLeftBase + x));
+      __m128i topRight = _mm_loadu_si128((__m128i*)(topRightBase + x));
+      __m128i bottomRight = _mm_loadu_si128((__m128i*)(bottomRightBase + x));
+      __m128i bottomLeft = _mm_loadu_si128((__m128i*)(bottomLeftBase + x));
+
+      __m128i values = _mm_add_epi32(_mm_sub_epi32(_mm_sub_epi32(bottomRight, topRight), bottomLeft), topLeft);
+      __m128i result = _mm256_castsi256_si128(Divide(_mm256_castsi128_si256(values), divisor));
+      __m128i final = _mm_packus_epi16(_mm_packs_epi32(result, _mm_setzero_si128()), _mm_setzero_si128());
+
+      *(uint32_t*)(data + stride * y + x) = _mm_cvtsi128_si32(final);
+    }
+  }
+}
+
+} // namespace gfx
+} // namespace mozilla
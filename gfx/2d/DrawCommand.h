@@ -10,6 +10,7 @@
 
 #include "2D.h"
 #include "Filters.h"
+#include "Tools.h"
 #include <vector>
 
 namespace mozilla {
@@ -44,6 +45,8 @@ public:
 
   virtual void ExecuteOnDT(DrawTarget* aDT, const Matrix* aTransform = nullptr) const = 0;
 
+  /// Returns false if the command may touch pixels anywhere inside the
+  /// current clip, otherwise sets aDeviceRect to the bounds of what it draws.
   virtual bool GetAffectedRect(Rect& aDeviceRect, const Matrix& aTransform) const { return false; }
 
 protected:
@@ -239,6 +242,9 @@ public:
 
   bool GetAffectedRect(Rect& aDeviceRect, const Matrix& aTransform) const
   {
+    if (!IsOperatorBoundByMask(mOptions.mCompositionOp)) {
+      return false;
+    }
     aDeviceRect = aTransform.TransformBounds(mRect);
     return true;
   }
@@ -332,6 +338,9 @@ public:
 
   bool GetAffectedRect(Rect& aDeviceRect, const Matrix& aTransform) const
   {
+    if (!IsOperatorBoundByMask(mOptions.mCompositionOp)) {
+      return false;
+    }
     aDeviceRect = mPath->GetBounds(aTransform);
     return true;
   }
@@ -404,6 +413,9 @@ public:
 
   bool GetAffectedRect(Rect& aDeviceRect, const Matrix& aTransform) const
   {
+    if (!IsOperatorBoundByMask(mOptions.mCompositionOp)) {
+      return false;
+    }
     aDeviceRect = PathExtentsToMaxStrokeExtents(mStrokeOptions, mPath->GetBounds(aTransform), aTransform);
     return true;
   }
@@ -70,6 +70,7 @@ DrawTargetCaptureImpl::DrawFilter(FilterNode *aNode,
 {
   // @todo XXX - this won't work properly long term yet due to filternodes not
   // being immutable.
+  mHasFilters = true;
   AppendCommand(DrawFilterCommand)(aNode, aSourceRect, aDestPoint, aOptions);
 }
 
@@ -182,17 +183,31 @@ void
 DrawTargetCaptureImpl::SetTransform(const Matrix& aTransform)
 {
   AppendCommand(SetTransformCommand)(aTransform);
+
+  // Keep GetTransform() in sync for the code drawing into us.
+  DrawTarget::SetTransform(aTransform);
 }
 
 void
 DrawTargetCaptureImpl::ReplayToDrawTarget(DrawTarget* aDT, const Matrix& aTransform)
 {
+  if (mDrawCommandStorage.empty()) {
+    return;
+  }
+
   uint8_t* start = &mDrawCommandStorage.front();
 
   uint8_t* current = start;
 
+  Rect targetRect(IntRect(IntPoint(), aDT->GetSize()));
+
   while (current < start + mDrawCommandStorage.size()) {
-    reinterpret_cast<DrawingCommand*>(current + sizeof(uint32_t))->ExecuteOnDT(aDT, &aTransform);
+    DrawingCommand* command = reinterpret_cast<DrawingCommand*>(current + sizeof(uint32_t));
+    Rect affectedRect;
+    if (!command->GetAffectedRect(affectedRect, aDT->GetTransform()) ||
+        affectedRect.Intersects(targetRect)) {
+      command->ExecuteOnDT(aDT, &aTransform);
+    }
     current += *(uint32_t*)current;
   }
 }
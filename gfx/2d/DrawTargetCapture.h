@@ -20,6 +20,7 @@ class DrawTargetCaptureImpl : public DrawTargetCapture
 {
 public:
   DrawTargetCaptureImpl()
+    : mHasFilters(false)
   {}
 
   bool Init(const IntSize& aSize, DrawTarget* aRefDT);
@@ -134,8 +135,15 @@ public:
     return mRefDT->CreateFilter(aType);
   }
 
+  /// Replays the recorded commands, skipping the ones that draw entirely
+  /// outside of aDT.
   void ReplayToDrawTarget(DrawTarget* aDT, const Matrix& aTransform);
 
+  /// Whether several threads may replay this capture at the same time, each
+  /// into its own draw target. FilterNodes keep state while they are drawn,
+  /// so captures containing filters can't.
+  bool CanReplayInParallel() const { return !mHasFilters; }
+
 protected:
   ~DrawTargetCaptureImpl();
 
@@ -158,6 +166,8 @@ private:
   IntSize mSize;
 
   std::vector<uint8_t> mDrawCommandStorage;
+
+  bool mHasFilters;
 };
 
 } // namespace gfx
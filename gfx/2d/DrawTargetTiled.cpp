@@ -4,6 +4,8 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "DrawTargetTiled.h"
+#include "DrawTargetCapture.h"
+#include "JobScheduler.h"
 #include "Logging.h"
 #include "PathHelpers.h"
 
@@ -333,5 +335,86 @@ DrawTargetTiled::PopLayer()
   }
 }
 
+/// Replays a capture into a single tile.
+///
+/// The tile and the capture are kept alive by the thread that submitted the
+/// job until the job's completion is signaled, they are not refcounted here
+/// because DrawTargets aren't thread-safe refcounted.
+class ReplayCaptureJob : public Job
+{
+public:
+  ReplayCaptureJob(DrawTarget* aTarget, DrawTargetCaptureImpl* aCapture,
+                   const Matrix& aTransform, SyncObject* aCompletion)
+    : Job(nullptr, aCompletion)
+    , mTarget(aTarget)
+    , mCapture(aCapture)
+    , mTransform(aTransform)
+  {}
+
+  virtual JobStatus Run() override
+  {
+    mCapture->ReplayToDrawTarget(mTarget, mTransform);
+    return JobStatus::Complete;
+  }
+
+private:
+  DrawTarget* mTarget;
+  DrawTargetCaptureImpl* mCapture;
+  Matrix mTransform;
+};
+
+void
+DrawTargetTiled::DrawCapturedDT(DrawTargetCapture *aCaptureDT,
+                                const Matrix& aTransform)
+{
+  DrawTargetCaptureImpl* capture = static_cast<DrawTargetCaptureImpl*>(aCaptureDT);
+
+  uint32_t tileCount = 0;
+  for (size_t i = 0; i < mTiles.size(); i++) {
+    if (!mTiles[i].mClippedOut) {
+      tileCount++;
+    }
+  }
+
+  if (!JobScheduler::IsEnabled() || tileCount < 2 ||
+      !capture->CanReplayInParallel()) {
+    DrawTarget::DrawCapturedDT(aCaptureDT, aTransform);
+    return;
+  }
+
+  if (aTransform.HasNonIntegerTranslation()) {
+    gfxWarning() << "Non integer translations are not supported for DrawCaptureDT at this time!";
+    return;
+  }
+
+  // Each tile skips the commands that don't intersect it, see
+  // DrawTargetCaptureImpl::ReplayToDrawTarget.
+  RefPtr<SyncObject> completion = new SyncObject(tileCount);
+  for (size_t i = 0; i < mTiles.size(); i++) {
+    if (mTiles[i].mClippedOut) {
+      continue;
+    }
+    Matrix tileTransform = aTransform;
+    tileTransform.PostTranslate(Float(-mTiles[i].mTileOrigin.x),
+                                Float(-mTiles[i].mTileOrigin.y));
+    JobScheduler::SubmitJob(new ReplayCaptureJob(mTiles[i].mDrawTarget, capture,
+                                                 tileTransform, completion));
+  }
+  completion->FreezePrerequisites();
+  JobScheduler::Join(completion);
+
+  // The capture changed the transform of the tiles, bring them back in sync
+  // the way a sequential replay would have left them.
+  for (size_t i = 0; i < mTiles.size(); i++) {
+    if (!mTiles[i].mClippedOut) {
+      Matrix transform = mTiles[i].mDrawTarget->GetTransform();
+      transform.PostTranslate(Float(mTiles[i].mTileOrigin.x),
+                              Float(mTiles[i].mTileOrigin.y));
+      SetTransform(transform);
+      break;
+    }
+  }
+}
+
 } // namespace gfx
 } // namespace mozilla
@@ -111,6 +111,12 @@ public:
                          bool aCopyBackground = false) override;
   virtual void PopLayer() override;
 
+  /**
+   * When the JobScheduler is running, this replays the capture into all the
+   * tiles at once, one job per tile.
+   */
+  virtual void DrawCapturedDT(DrawTargetCapture *aCaptureDT,
+                              const Matrix& aTransform) override;
 
   virtual void SetTransform(const Matrix &aTransform) override;
 
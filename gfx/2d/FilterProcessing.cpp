@@ -5,10 +5,19 @@
 
 #include "FilterProcessing.h"
 #include "Logging.h"
+#include "mozilla/SSE.h"
 
 namespace mozilla {
 namespace gfx {
 
+#ifdef USE_AVX2
+/* static */ bool
+FilterProcessing::CanProcessWithAVX2(int32_t aStride, int32_t aXMost)
+{
+  return mozilla::supports_avx2() && aStride >= 4 * ((aXMost + 7) & ~7);
+}
+#endif
+
 already_AddRefed<DataSourceSurface>
 FilterProcessing::ExtractAlpha(DataSourceSurface* aSource)
 {
@@ -55,6 +64,13 @@ already_AddRefed<DataSourceSurface>
 FilterProcessing::ApplyBlending(DataSourceSurface* aInput1, DataSourceSurface* aInput2,
                                 BlendMode aBlendMode)
 {
+#ifdef USE_AVX2
+  int32_t width = aInput1->GetSize().width;
+  if (CanProcessWithAVX2(aInput1->Stride(), width) &&
+      CanProcessWithAVX2(aInput2->Stride(), width)) {
+    return ApplyBlending_AVX2(aInput1, aInput2, aBlendMode);
+  }
+#endif
   if (Factory::HasSSE2()) {
 #ifdef USE_SSE2
     return ApplyBlending_SSE2(aInput1, aInput2, aBlendMode);
@@ -86,6 +102,16 @@ FilterProcessing::ApplyMorphologyVertical(uint8_t* aSourceData, int32_t aSourceS
                                             const IntRect& aDestRect, int32_t aRadius,
                                             MorphologyOperator aOp)
 {
+#ifdef USE_AVX2
+  // The vectors are read and written starting at aDestRect.x.
+  int32_t xMost = aDestRect.x + ((aDestRect.width + 7) & ~7);
+  if (CanProcessWithAVX2(aSourceStride, xMost) &&
+      CanProcessWithAVX2(aDestStride, xMost)) {
+    ApplyMorphologyVertical_AVX2(
+      aSourceData, aSourceStride, aDestData, aDestStride, aDestRect, aRadius, aOp);
+    return;
+  }
+#endif
   if (Factory::HasSSE2()) {
 #ifdef USE_SSE2
     ApplyMorphologyVertical_SSE2(
@@ -100,6 +126,11 @@ FilterProcessing::ApplyMorphologyVertical(uint8_t* aSourceData, int32_t aSourceS
 already_AddRefed<DataSourceSurface>
 FilterProcessing::ApplyColorMatrix(DataSourceSurface* aInput, const Matrix5x4 &aMatrix)
 {
+#ifdef USE_AVX2
+  if (CanProcessWithAVX2(aInput->Stride(), aInput->GetSize().width)) {
+    return ApplyColorMatrix_AVX2(aInput, aMatrix);
+  }
+#endif
   if (Factory::HasSSE2()) {
 #ifdef USE_SSE2
     return ApplyColorMatrix_SSE2(aInput, aMatrix);
@@ -112,6 +143,14 @@ void
 FilterProcessing::ApplyComposition(DataSourceSurface* aSource, DataSourceSurface* aDest,
                                    CompositeOperator aOperator)
 {
+#ifdef USE_AVX2
+  int32_t width = aDest->GetSize().width;
+  if (CanProcessWithAVX2(aSource->Stride(), width) &&
+      CanProcessWithAVX2(aDest->Stride(), width)) {
+    ApplyComposition_AVX2(aSource, aDest, aOperator);
+    return;
+  }
+#endif
   if (Factory::HasSSE2()) {
 #ifdef USE_SSE2
     ApplyComposition_SSE2(aSource, aDest, aOperator);
@@ -120,6 +120,18 @@ protected:
   static already_AddRefed<DataSourceSurface>
     ApplyArithmeticCombine_SSE2(DataSourceSurface* aInput1, DataSourceSurface* aInput2, Float aK1, Float aK2, Float aK3, Float aK4);
 #endif
+
+#ifdef USE_AVX2
+  // Rows need to be long enough to hold a whole number of 8 pixel vectors.
+  static bool CanProcessWithAVX2(int32_t aStride, int32_t aXMost);
+  static already_AddRefed<DataSourceSurface> ApplyBlending_AVX2(DataSourceSurface* aInput1, DataSourceSurface* aInput2, BlendMode aBlendMode);
+  static void ApplyMorphologyVertical_AVX2(uint8_t* aSourceData, int32_t aSourceStride,
+                                           uint8_t* aDestData, int32_t aDestStride,
+                                           const IntRect& aDestRect, int32_t aRadius,
+                                           MorphologyOperator aOperator);
+  static already_AddRefed<DataSourceSurface> ApplyColorMatrix_AVX2(DataSourceSurface* aInput, const Matrix5x4 &aMatrix);
+  static void ApplyComposition_AVX2(DataSourceSurface* aSource, DataSourceSurface* aDest, CompositeOperator aOperator);
+#endif
 };
 
 // Constant-time max and min functions for unsigned arguments
@@ -0,0 +1,52 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#define SIMD_COMPILE_SSE2
+#define SIMD_COMPILE_AVX2
+
+#include "FilterProcessingSIMD-inl.h"
+
+#ifndef USE_AVX2
+static_assert(false, "If this file is built, FilterProcessing.h should know about it!");
+#endif
+
+namespace mozilla {
+namespace gfx {
+
+// These process eight pixels per iteration. The callers in FilterProcessing.cpp
+// make sure that the rows of the surfaces they pass in are long enough for that.
+
+already_AddRefed<DataSourceSurface>
+FilterProcessing::ApplyBlending_AVX2(DataSourceSurface* aInput1, DataSourceSurface* aInput2,
+                                     BlendMode aBlendMode)
+{
+  return ApplyBlending_SIMD<__m256i,__m256i,__m256i>(aInput1, aInput2, aBlendMode);
+}
+
+void
+FilterProcessing::ApplyMorphologyVertical_AVX2(uint8_t* aSourceData, int32_t aSourceStride,
+                                               uint8_t* aDestData, int32_t aDestStride,
+                                               const IntRect& aDestRect, int32_t aRadius,
+                                               MorphologyOperator aOp)
+{
+  ApplyMorphologyVertical_SIMD<__m256i,__m256i>(
+    aSourceData, aSourceStride, aDestData, aDestStride, aDestRect, aRadius, aOp);
+}
+
+already_AddRefed<DataSourceSurface>
+FilterProcessing::ApplyColorMatrix_AVX2(DataSourceSurface* aInput, const Matrix5x4 &aMatrix)
+{
+  return ApplyColorMatrix_SIMD<__m256i,__m256i,__m256i>(aInput, aMatrix);
+}
+
+void
+FilterProcessing::ApplyComposition_AVX2(DataSourceSurface* aSource, DataSourceSurface* aDest,
+                                        CompositeOperator aOperator)
+{
+  return ApplyComposition_SIMD<__m256i,__m256i,__m256i>(aSource, aDest, aOperator);
+}
+
+} // namespace gfx
+} // namespace mozilla
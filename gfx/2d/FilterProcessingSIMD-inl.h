@@ -7,6 +7,7 @@
 
 #include "SIMD.h"
 #include "SVGTurbulenceRenderer-inl.h"
+#include "Tools.h"
 
 namespace mozilla {
 namespace gfx {
@@ -289,7 +290,8 @@ ApplyBlending_SIMD(DataSourceSurface* aInput1, DataSourceSurface* aInput2)
 {
   IntSize size = aInput1->GetSize();
   RefPtr<DataSourceSurface> target =
-    Factory::CreateDataSourceSurface(size, SurfaceFormat::B8G8R8A8);
+    Factory::CreateDataSourceSurfaceWithStride(size, SurfaceFormat::B8G8R8A8,
+                                               GetAlignedStride<sizeof(u8x16_t)>(size.width, 4));
   if (!target) {
     return nullptr;
   }
@@ -301,8 +303,11 @@ ApplyBlending_SIMD(DataSourceSurface* aInput1, DataSourceSurface* aInput2)
   int32_t source1Stride = aInput1->Stride();
   int32_t source2Stride = aInput2->Stride();
 
+  // Each vector holds four pixels per 128 bit lane.
+  const int32_t pixelsPerVector = sizeof(u8x16_t) / 4;
+
   for (int32_t y = 0; y < size.height; y++) {
-    for (int32_t x = 0; x < size.width; x += 4) {
+    for (int32_t x = 0; x < size.width; x += pixelsPerVector) {
       int32_t targetIndex = y * targetStride + 4 * x;
       int32_t source1Index = y * source1Stride + 4 * x;
       int32_t source2Index = y * source2Stride + 4 * x;
@@ -448,10 +453,12 @@ static void ApplyMorphologyVertical_SIMD(uint8_t* aSourceData, int32_t aSourceSt
                 op == MORPHOLOGY_OPERATOR_DILATE,
                 "unexpected morphology operator");
 
+  const int32_t pixelsPerVector = sizeof(u8x16_t) / 4;
+
   int32_t startY = aDestRect.y - aRadius;
   int32_t endY = aDestRect.y + aRadius;
   for (int32_t y = aDestRect.y; y < aDestRect.YMost(); y++, startY++, endY++) {
-    for (int32_t x = aDestRect.x; x < aDestRect.XMost(); x += 4) {
+    for (int32_t x = aDestRect.x; x < aDestRect.XMost(); x += pixelsPerVector) {
       int32_t sourceIndex = startY * aSourceStride + 4 * x;
       u8x16_t u = simd::Load8<u8x16_t>(&aSourceData[sourceIndex]);
       sourceIndex += aSourceStride;
@@ -514,7 +521,8 @@ ApplyColorMatrix_SIMD(DataSourceSurface* aInput, const Matrix5x4 &aMatrix)
 {
   IntSize size = aInput->GetSize();
   RefPtr<DataSourceSurface> target =
-    Factory::CreateDataSourceSurface(size, SurfaceFormat::B8G8R8A8);
+    Factory::CreateDataSourceSurfaceWithStride(size, SurfaceFormat::B8G8R8A8,
+                                               GetAlignedStride<sizeof(u8x16_t)>(size.width, 4));
   if (!target) {
     return nullptr;
   }
@@ -576,10 +584,12 @@ ApplyColorMatrix_SIMD(DataSourceSurface* aInput, const Matrix5x4 &aMatrix)
   i32x4_t rowsBias_v =
     simd::From32<i32x4_t>(rowBias[0], rowBias[1], rowBias[2], rowBias[3]);
 
+  const int32_t pixelsPerVector = sizeof(u8x16_t) / 4;
+
   for (int32_t y = 0; y < size.height; y++) {
-    for (int32_t x = 0; x < size.width; x += 4) {
-      MOZ_ASSERT(sourceStride >= 4 * (x + 4), "need to be able to read 4 pixels at this position");
-      MOZ_ASSERT(targetStride >= 4 * (x + 4), "need to be able to write 4 pixels at this position");
+    for (int32_t x = 0; x < size.width; x += pixelsPerVector) {
+      MOZ_ASSERT(sourceStride >= 4 * (x + pixelsPerVector), "need to be able to read a whole vector of pixels at this position");
+      MOZ_ASSERT(targetStride >= 4 * (x + pixelsPerVector), "need to be able to write a whole vector of pixels at this position");
       int32_t sourceIndex = y * sourceStride + 4 * x;
       int32_t targetIndex = y * targetStride + 4 * x;
 
@@ -705,9 +715,10 @@ ApplyComposition(DataSourceSurface* aSource, DataSourceSurface* aDest)
   uint8_t* destData = aDest->GetData();
   uint32_t sourceStride = aSource->Stride();
   uint32_t destStride = aDest->Stride();
+  const int32_t pixelsPerVector = sizeof(u8x16_t) / 4;
 
   for (int32_t y = 0; y < size.height; y++) {
-    for (int32_t x = 0; x < size.width; x += 4) {
+    for (int32_t x = 0; x < size.width; x += pixelsPerVector) {
       uint32_t sourceIndex = y * sourceStride + 4 * x;
       uint32_t destIndex = y * destStride + 4 * x;
 
@@ -10,9 +10,149 @@
 #include "HelpersSkia.h"
 #include "PathHelpers.h"
 
+#include <algorithm>
+
 namespace mozilla {
 namespace gfx {
 
+/**
+ * The edges of a path made only of lines, bucketed into horizontal bands, so
+ * that testing whether a point is inside only has to look at the edges that
+ * cross the band of the point rather than at the whole path. Paths with curves
+ * are left to SkPath::contains, which handles them exactly.
+ */
+class SkPathEdgeGrid
+{
+public:
+  static UniquePtr<SkPathEdgeGrid> Create(const SkPath& aPath);
+
+  bool Contains(SkScalar aX, SkScalar aY) const;
+
+private:
+  struct Edge {
+    // mY0 <= mY1.
+    SkScalar mX0, mY0, mX1, mY1;
+    // 1 or -1, depending on the direction of the edge. 0 for horizontal
+    // edges, which only matter for points right on them.
+    int mWinding;
+  };
+
+  // Paths with fewer points than this are fast enough to test directly.
+  static const int kMinPoints = 32;
+  // The average number of edges we aim for in each band.
+  static const size_t kEdgesPerBand = 4;
+  static const size_t kMaxBands = 1024;
+
+  int BandForY(SkScalar aY) const
+  {
+    int band = int((aY - mBounds.fTop) / mBandHeight);
+    return std::min(std::max(band, 0), int(mBandStarts.size()) - 2);
+  }
+
+  SkRect mBounds;
+  SkScalar mBandHeight;
+  bool mEvenOdd;
+  std::vector<Edge> mEdges;
+  // The edges crossing band i are mBandEdges[mBandStarts[i]] to
+  // mBandEdges[mBandStarts[i + 1] - 1].
+  std::vector<uint32_t> mBandStarts;
+  std::vector<uint32_t> mBandEdges;
+};
+
+/* static */ UniquePtr<SkPathEdgeGrid>
+SkPathEdgeGrid::Create(const SkPath& aPath)
+{
+  if (aPath.countPoints() < kMinPoints ||
+      aPath.getSegmentMasks() != SkPath::kLine_SegmentMask ||
+      aPath.isInverseFillType() || aPath.getBounds().isEmpty()) {
+    return nullptr;
+  }
+
+  UniquePtr<SkPathEdgeGrid> grid(new SkPathEdgeGrid());
+  grid->mBounds = aPath.getBounds();
+  grid->mEvenOdd = aPath.getFillType() == SkPath::kEvenOdd_FillType;
+
+  // Filling closes the contours, so does the iterator.
+  SkPath::Iter iter(aPath, true);
+  SkPoint points[4];
+  SkPath::Verb verb;
+  while ((verb = iter.next(points, false)) != SkPath::kDone_Verb) {
+    if (verb != SkPath::kLine_Verb) {
+      continue;
+    }
+    Edge edge = { points[0].fX, points[0].fY, points[1].fX, points[1].fY, 1 };
+    if (edge.mY0 > edge.mY1) {
+      std::swap(edge.mX0, edge.mX1);
+      std::swap(edge.mY0, edge.mY1);
+      edge.mWinding = -1;
+    } else if (edge.mY0 == edge.mY1) {
+      edge.mWinding = 0;
+    }
+    grid->mEdges.push_back(edge);
+  }
+
+  size_t bandCount =
+    std::min(std::max(grid->mEdges.size() / kEdgesPerBand, size_t(1)), kMaxBands);
+  grid->mBandHeight = grid->mBounds.height() / bandCount;
+
+  // Count the edges of each band, then turn the counts into offsets.
+  grid->mBandStarts.resize(bandCount + 1, 0);
+  for (const Edge& edge : grid->mEdges) {
+    for (int band = grid->BandForY(edge.mY0); band <= grid->BandForY(edge.mY1); band++) {
+      grid->mBandStarts[band + 1]++;
+    }
+  }
+  for (size_t band = 0; band < bandCount; band++) {
+    grid->mBandStarts[band + 1] += grid->mBandStarts[band];
+  }
+  grid->mBandEdges.resize(grid->mBandStarts[bandCount]);
+  std::vector<uint32_t> fill(grid->mBandStarts.begin(), grid->mBandStarts.end() - 1);
+  for (uint32_t i = 0; i < grid->mEdges.size(); i++) {
+    const Edge& edge = grid->mEdges[i];
+    for (int band = grid->BandForY(edge.mY0); band <= grid->BandForY(edge.mY1); band++) {
+      grid->mBandEdges[fill[band]++] = i;
+    }
+  }
+
+  return grid;
+}
+
+bool
+SkPathEdgeGrid::Contains(SkScalar aX, SkScalar aY) const
+{
+  // Same as SkPath::contains.
+  if (!mBounds.contains(aX, aY)) {
+    return false;
+  }
+
+  // Count the edges crossed by a ray going from the point towards +x.
+  int band = BandForY(aY);
+  int winding = 0;
+  for (uint32_t i = mBandStarts[band]; i < mBandStarts[band + 1]; i++) {
+    const Edge& edge = mEdges[mBandEdges[i]];
+    if (!edge.mWinding) {
+      if (aY == edge.mY0 &&
+          aX >= std::min(edge.mX0, edge.mX1) && aX <= std::max(edge.mX0, edge.mX1)) {
+        return true;
+      }
+      continue;
+    }
+    if (aY < edge.mY0 || aY >= edge.mY1) {
+      continue;
+    }
+    SkScalar x = edge.mX0 + (aY - edge.mY0) * (edge.mX1 - edge.mX0) / (edge.mY1 - edge.mY0);
+    if (x == aX) {
+      // Points on the outline are inside, as for SkPath::contains.
+      return true;
+    }
+    if (x > aX) {
+      winding += edge.mWinding;
+    }
+  }
+
+  return mEvenOdd ? (winding & 1) : winding != 0;
+}
+
 PathBuilderSkia::PathBuilderSkia(const Matrix& aTransform, const SkPath& aPath, FillRule aFillRule)
   : mPath(aPath)
 {
@@ -127,7 +267,8 @@ PathSkia::TransformedCopyToBuilder(const Matrix &aTransform, FillRule aFillRule)
 }
 
 static bool
-SkPathContainsPoint(const SkPath& aPath, const Point& aPoint, const Matrix& aTransform)
+SkPathContainsPoint(const SkPath& aPath, const SkPathEdgeGrid* aEdgeGrid,
+                    const Point& aPoint, const Matrix& aTransform)
 {
   Matrix inverse = aTransform;
   if (!inverse.Invert()) {
@@ -135,9 +276,24 @@ SkPathContainsPoint(const SkPath& aPath, const Point& aPoint, const Matrix& aTra
   }
 
   SkPoint point = PointToSkPoint(inverse.TransformPoint(aPoint));
+  if (aEdgeGrid) {
+    return aEdgeGrid->Contains(point.fX, point.fY);
+  }
   return aPath.contains(point.fX, point.fY);
 }
 
+PathSkia::PathSkia(SkPath& aPath, FillRule aFillRule)
+  : mFillRule(aFillRule)
+  , mEdgeGridBuilt(false)
+  , mStrokeOutlineEmpty(false)
+{
+  mPath.swap(aPath);
+}
+
+PathSkia::~PathSkia()
+{
+}
+
 bool
 PathSkia::ContainsPoint(const Point &aPoint, const Matrix &aTransform) const
 {
@@ -145,7 +301,53 @@ PathSkia::ContainsPoint(const Point &aPoint, const Matrix &aTransform) const
     return false;
   }
 
-  return SkPathContainsPoint(mPath, aPoint, aTransform);
+  if (!mEdgeGridBuilt) {
+    mEdgeGrid = SkPathEdgeGrid::Create(mPath);
+    mEdgeGridBuilt = true;
+  }
+
+  return SkPathContainsPoint(mPath, mEdgeGrid.get(), aPoint, aTransform);
+}
+
+static bool
+StrokeOptionsEqual(const StrokeOptions& aOptions,
+                   const StrokeOptions& aOther, const std::vector<Float>& aOtherDashes)
+{
+  return aOptions.mLineWidth == aOther.mLineWidth &&
+         aOptions.mMiterLimit == aOther.mMiterLimit &&
+         aOptions.mLineJoin == aOther.mLineJoin &&
+         aOptions.mLineCap == aOther.mLineCap &&
+         aOptions.mDashOffset == aOther.mDashOffset &&
+         aOptions.mDashLength == aOtherDashes.size() &&
+         std::equal(aOptions.mDashPattern, aOptions.mDashPattern + aOptions.mDashLength,
+                    aOtherDashes.begin());
+}
+
+const SkPath*
+PathSkia::GetStrokeOutline(const StrokeOptions &aStrokeOptions) const
+{
+  if (mStrokeOptions &&
+      StrokeOptionsEqual(aStrokeOptions, *mStrokeOptions, mStrokeDashes)) {
+    return mStrokeOutlineEmpty ? nullptr : &mStrokeOutline;
+  }
+
+  // The cached options must not point at the caller's dash array.
+  mStrokeDashes.assign(aStrokeOptions.mDashPattern,
+                       aStrokeOptions.mDashPattern + aStrokeOptions.mDashLength);
+  mStrokeOptions = MakeUnique<StrokeOptions>(aStrokeOptions);
+  mStrokeOptions->mDashPattern = nullptr;
+  mStrokeOutline.reset();
+  mStrokeEdgeGrid = nullptr;
+
+  SkPaint paint;
+  mStrokeOutlineEmpty = !StrokeOptionsToPaint(paint, aStrokeOptions);
+  if (mStrokeOutlineEmpty) {
+    return nullptr;
+  }
+
+  paint.getFillPath(mPath, &mStrokeOutline);
+  mStrokeEdgeGrid = SkPathEdgeGrid::Create(mStrokeOutline);
+  return &mStrokeOutline;
 }
 
 bool
@@ -157,15 +359,12 @@ PathSkia::StrokeContainsPoint(const StrokeOptions &aStrokeOptions,
     return false;
   }
 
-  SkPaint paint;
-  if (!StrokeOptionsToPaint(paint, aStrokeOptions)) {
+  const SkPath* strokePath = GetStrokeOutline(aStrokeOptions);
+  if (!strokePath) {
     return false;
   }
 
-  SkPath strokePath;
-  paint.getFillPath(mPath, &strokePath);
-
-  return SkPathContainsPoint(strokePath, aPoint, aTransform);
+  return SkPathContainsPoint(*strokePath, mStrokeEdgeGrid.get(), aPoint, aTransform);
 }
 
 Rect
@@ -187,15 +386,12 @@ PathSkia::GetStrokedBounds(const StrokeOptions &aStrokeOptions,
     return Rect();
   }
 
-  SkPaint paint;
-  if (!StrokeOptionsToPaint(paint, aStrokeOptions)) {
+  const SkPath* strokePath = GetStrokeOutline(aStrokeOptions);
+  if (!strokePath) {
     return Rect();
   }
 
-  SkPath result;
-  paint.getFillPath(mPath, &result);
-
-  Rect bounds = SkRectToRect(result.getBounds());
+  Rect bounds = SkRectToRect(strokePath->getBounds());
   return aTransform.TransformBounds(bounds);
 }
 
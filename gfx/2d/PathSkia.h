@@ -7,12 +7,16 @@
 #define MOZILLA_GFX_PATH_SKIA_H_
 
 #include "2D.h"
+#include "mozilla/UniquePtr.h"
 #include "skia/include/core/SkPath.h"
 
+#include <vector>
+
 namespace mozilla {
 namespace gfx {
 
 class PathSkia;
+class SkPathEdgeGrid;
 
 class PathBuilderSkia : public PathBuilder
 {
@@ -50,12 +54,9 @@ class PathSkia : public Path
 {
 public:
   MOZ_DECLARE_REFCOUNTED_VIRTUAL_TYPENAME(PathSkia)
-  PathSkia(SkPath& aPath, FillRule aFillRule)
-    : mFillRule(aFillRule)
-  {
-    mPath.swap(aPath);
-  }
-  
+  PathSkia(SkPath& aPath, FillRule aFillRule);
+  virtual ~PathSkia();
+
   virtual BackendType GetBackendType() const { return BackendType::SKIA; }
 
   virtual already_AddRefed<PathBuilder> CopyToBuilder(FillRule aFillRule) const;
@@ -81,9 +82,28 @@ public:
 
 private:
   friend class DrawTargetSkia;
-  
+
+  /**
+   * Returns the outline of the stroke of this path, or null if nothing would
+   * be drawn. The outline of the last StrokeOptions asked for is kept, since
+   * hit testing asks for the same one over and over.
+   */
+  const SkPath* GetStrokeOutline(const StrokeOptions &aStrokeOptions) const;
+
   SkPath mPath;
   FillRule mFillRule;
+
+  // Hit testing acceleration, built lazily. A PathSkia never changes once
+  // built, so these never need to be invalidated, except the stroke outline
+  // when the StrokeOptions change.
+  mutable UniquePtr<SkPathEdgeGrid> mEdgeGrid;
+  mutable bool mEdgeGridBuilt;
+
+  mutable SkPath mStrokeOutline;
+  mutable UniquePtr<SkPathEdgeGrid> mStrokeEdgeGrid;
+  mutable UniquePtr<StrokeOptions> mStrokeOptions;
+  mutable std::vector<Float> mStrokeDashes;
+  mutable bool mStrokeOutlineEmpty;
 };
 
 } // namespace gfx
@@ -8,13 +8,18 @@
 
 /**
  * Consumers of this file need to #define SIMD_COMPILE_SSE2 before including it
- * if they want access to the SSE2 functions.
+ * if they want access to the SSE2 functions, and SIMD_COMPILE_AVX2 if they
+ * want access to the AVX2 functions.
  */
 
 #ifdef SIMD_COMPILE_SSE2
 #include <xmmintrin.h>
 #endif
 
+#ifdef SIMD_COMPILE_AVX2
+#include <immintrin.h>
+#endif
+
 namespace mozilla {
 namespace gfx {
 
@@ -1172,6 +1177,253 @@ inline __m128i F32ToI32(__m128 m)
 
 #endif // SIMD_COMPILE_SSE2
 
+#ifdef SIMD_COMPILE_AVX2
+
+// AVX2
+//
+// An __m256i is treated as two independent 128 bit lanes that each behave
+// like the SSE2 __m128i above, so that the SIMD filter kernels process eight
+// pixels at a time without changing how they shuffle within a vector. All
+// constants are replicated into both lanes. Only the operations that the
+// per-pixel kernels need are provided.
+
+template<>
+inline __m256i
+Load8<__m256i>(const uint8_t* aSource)
+{
+  return _mm256_loadu_si256((const __m256i*)aSource);
+}
+
+inline void Store8(uint8_t* aTarget, __m256i aM)
+{
+  _mm256_storeu_si256((__m256i*)aTarget, aM);
+}
+
+template<>
+inline __m256i FromI16<__m256i>(int16_t a, int16_t b, int16_t c, int16_t d, int16_t e, int16_t f, int16_t g, int16_t h)
+{
+  return _mm256_setr_epi16(a, b, c, d, e, f, g, h, a, b, c, d, e, f, g, h);
+}
+
+template<>
+inline __m256i FromU16<__m256i>(uint16_t a, uint16_t b, uint16_t c, uint16_t d, uint16_t e, uint16_t f, uint16_t g, uint16_t h)
+{
+  return _mm256_setr_epi16(a, b, c, d, e, f, g, h, a, b, c, d, e, f, g, h);
+}
+
+template<>
+inline __m256i FromI16<__m256i>(int16_t a)
+{
+  return _mm256_set1_epi16(a);
+}
+
+template<>
+inline __m256i FromU16<__m256i>(uint16_t a)
+{
+  return _mm256_set1_epi16((int16_t)a);
+}
+
+template<>
+inline __m256i From32<__m256i>(int32_t a, int32_t b, int32_t c, int32_t d)
+{
+  return _mm256_setr_epi32(a, b, c, d, a, b, c, d);
+}
+
+template<>
+inline __m256i From32<__m256i>(int32_t a)
+{
+  return _mm256_set1_epi32(a);
+}
+
+template<int32_t aNumberOfBits>
+inline __m256i ShiftRight32(__m256i aM)
+{
+  return _mm256_srai_epi32(aM, aNumberOfBits);
+}
+
+inline __m256i Add16(__m256i aM1, __m256i aM2)
+{
+  return _mm256_add_epi16(aM1, aM2);
+}
+
+inline __m256i Add32(__m256i aM1, __m256i aM2)
+{
+  return _mm256_add_epi32(aM1, aM2);
+}
+
+inline __m256i Sub16(__m256i aM1, __m256i aM2)
+{
+  return _mm256_sub_epi16(aM1, aM2);
+}
+
+inline __m256i Min8(__m256i aM1, __m256i aM2)
+{
+  return _mm256_min_epu8(aM1, aM2);
+}
+
+inline __m256i Max8(__m256i aM1, __m256i aM2)
+{
+  return _mm256_max_epu8(aM1, aM2);
+}
+
+inline __m256i Min32(__m256i aM1, __m256i aM2)
+{
+  return _mm256_min_epi32(aM1, aM2);
+}
+
+inline __m256i Max32(__m256i aM1, __m256i aM2)
+{
+  return _mm256_max_epi32(aM1, aM2);
+}
+
+inline __m256i Mul16(__m256i aM1, __m256i aM2)
+{
+  return _mm256_mullo_epi16(aM1, aM2);
+}
+
+inline __m256i MulAdd16x8x2To32x4(__m256i aFactorsA,
+                                  __m256i aFactorsB)
+{
+  return _mm256_madd_epi16(aFactorsA, aFactorsB);
+}
+
+template<int8_t i0, int8_t i1, int8_t i2, int8_t i3>
+inline __m256i Shuffle32(__m256i aM)
+{
+  AssertIndex<i0>();
+  AssertIndex<i1>();
+  AssertIndex<i2>();
+  AssertIndex<i3>();
+  return _mm256_shuffle_epi32(aM, _MM_SHUFFLE(i0, i1, i2, i3));
+}
+
+template<int8_t i0, int8_t i1, int8_t i2, int8_t i3>
+inline __m256i ShuffleLo16(__m256i aM)
+{
+  AssertIndex<i0>();
+  AssertIndex<i1>();
+  AssertIndex<i2>();
+  AssertIndex<i3>();
+  return _mm256_shufflelo_epi16(aM, _MM_SHUFFLE(i0, i1, i2, i3));
+}
+
+template<int8_t i0, int8_t i1, int8_t i2, int8_t i3>
+inline __m256i ShuffleHi16(__m256i aM)
+{
+  AssertIndex<i0>();
+  AssertIndex<i1>();
+  AssertIndex<i2>();
+  AssertIndex<i3>();
+  return _mm256_shufflehi_epi16(aM, _MM_SHUFFLE(i0, i1, i2, i3));
+}
+
+template<int8_t aIndex>
+inline __m256i Splat32On8(__m256i aM)
+{
+  return Shuffle32<aIndex,aIndex,aIndex,aIndex>(aM);
+}
+
+template<int8_t aIndexLo, int8_t aIndexHi>
+inline __m256i Splat16(__m256i aM)
+{
+  AssertIndex<aIndexLo>();
+  AssertIndex<aIndexHi>();
+  return ShuffleHi16<aIndexHi,aIndexHi,aIndexHi,aIndexHi>(
+           ShuffleLo16<aIndexLo,aIndexLo,aIndexLo,aIndexLo>(aM));
+}
+
+inline __m256i
+UnpackLo8x8ToI16x8(__m256i m)
+{
+  __m256i zero = _mm256_setzero_si256();
+  return _mm256_unpacklo_epi8(m, zero);
+}
+
+inline __m256i
+UnpackHi8x8ToI16x8(__m256i m)
+{
+  __m256i zero = _mm256_setzero_si256();
+  return _mm256_unpackhi_epi8(m, zero);
+}
+
+inline __m256i
+UnpackLo8x8ToU16x8(__m256i m)
+{
+  __m256i zero = _mm256_setzero_si256();
+  return _mm256_unpacklo_epi8(m, zero);
+}
+
+inline __m256i
+UnpackHi8x8ToU16x8(__m256i m)
+{
+  __m256i zero = _mm256_setzero_si256();
+  return _mm256_unpackhi_epi8(m, zero);
+}
+
+inline __m256i
+InterleaveLo16(__m256i m1, __m256i m2)
+{
+  return _mm256_unpacklo_epi16(m1, m2);
+}
+
+inline __m256i
+InterleaveHi16(__m256i m1, __m256i m2)
+{
+  return _mm256_unpackhi_epi16(m1, m2);
+}
+
+inline __m256i
+PackAndSaturate32To16(__m256i m1, __m256i m2)
+{
+  return _mm256_packs_epi32(m1, m2);
+}
+
+inline __m256i
+PackAndSaturate32ToU16(__m256i m1, __m256i m2)
+{
+  return _mm256_packs_epi32(m1, m2);
+}
+
+inline __m256i
+PackAndSaturate32To8(__m256i m1, __m256i m2, __m256i m3, const __m256i& m4)
+{
+  // Pack into 2x8 16bit signed integers (saturating).
+  __m256i m12 = _mm256_packs_epi32(m1, m2);
+  __m256i m34 = _mm256_packs_epi32(m3, m4);
+
+  // Pack into 2x16 8bit unsigned integers (saturating).
+  return _mm256_packus_epi16(m12, m34);
+}
+
+inline __m256i
+PackAndSaturate16To8(__m256i m1, __m256i m2)
+{
+  // Pack into 2x16 8bit unsigned integers (saturating).
+  return _mm256_packus_epi16(m1, m2);
+}
+
+inline __m256i
+FastDivideBy255(__m256i m)
+{
+  // v = m << 8
+  __m256i v = _mm256_slli_epi32(m, 8);
+  // v = v + (m + (255,255,255,255))
+  v = _mm256_add_epi32(v, _mm256_add_epi32(m, _mm256_set1_epi32(255)));
+  // v = v >> 16
+  return _mm256_srai_epi32(v, 16);
+}
+
+inline __m256i
+FastDivideBy255_16(__m256i m)
+{
+  __m256i zero = _mm256_setzero_si256();
+  __m256i lo = _mm256_unpacklo_epi16(m, zero);
+  __m256i hi = _mm256_unpackhi_epi16(m, zero);
+  return _mm256_packs_epi32(FastDivideBy255(lo), FastDivideBy255(hi));
+}
+
+#endif // SIMD_COMPILE_AVX2
+
 } // namespace simd
 
 } // namespace gfx
@@ -38,6 +38,11 @@
 #include "convolverSSE2.h"
 #endif
 
+#if defined(USE_AVX2)
+#include "convolverAVX2.h"
+#include "mozilla/SSE.h"
+#endif
+
 #if defined(_MIPS_ARCH_LOONGSON3A)
 #include "convolverLS3.h"
 #endif
@@ -292,6 +297,14 @@ void ConvolveVertically(const ConvolutionFilter1D::Fixed* filter_values,
                         int pixel_width, unsigned char* out_row,
                         bool has_alpha, bool use_simd) {
 
+#if defined(USE_AVX2)
+  if (use_simd && mozilla::supports_avx2()) {
+    ConvolveVertically_AVX2(filter_values, filter_length,
+                            source_data_rows,
+                            pixel_width,
+                            out_row, has_alpha);
+  } else
+#endif
 #if defined(USE_SSE2) || defined(_MIPS_ARCH_LOONGSON3A)
   // If the binary was not built with SSE2 support, we had to fallback to C version.
   if (use_simd) {
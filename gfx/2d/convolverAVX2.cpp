@@ -0,0 +1,110 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "convolverAVX2.h"
+#include "convolverSSE2.h"
+
+#include <immintrin.h>
+
+namespace skia {
+
+// The 256-bit unpack and pack instructions work on each 128-bit lane
+// separately, so every step below is the same as in the SSE2 version, done
+// on pixels 0-3 in the low lane and on pixels 4-7 in the high lane.
+template<bool has_alpha>
+void ConvolveVertically_AVX2_impl(const ConvolutionFilter1D::Fixed* filter_values,
+                                  int filter_length,
+                                  unsigned char* const* source_data_rows,
+                                  int pixel_width,
+                                  unsigned char* out_row) {
+  int width = pixel_width & ~7;
+
+  __m256i zero = _mm256_setzero_si256();
+  // Output eight pixels per iteration (32 bytes).
+  for (int out_x = 0; out_x < width; out_x += 8) {
+
+    // Accumulated result for each pixel. 32 bits per RGBA channel.
+    __m256i accum0 = _mm256_setzero_si256();
+    __m256i accum1 = _mm256_setzero_si256();
+    __m256i accum2 = _mm256_setzero_si256();
+    __m256i accum3 = _mm256_setzero_si256();
+
+    // Convolve with one filter coefficient per iteration.
+    for (int filter_y = 0; filter_y < filter_length; filter_y++) {
+      __m256i coeff16 = _mm256_set1_epi16(filter_values[filter_y]);
+
+      // [8] a7 .. r4 | a3 .. r0
+      __m256i src8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+          &source_data_rows[filter_y][out_x << 2]));
+
+      // [16] a5 b5 g5 r5 a4 b4 g4 r4 | a1 b1 g1 r1 a0 b0 g0 r0
+      __m256i src16 = _mm256_unpacklo_epi8(src8, zero);
+      __m256i mul_hi = _mm256_mulhi_epi16(src16, coeff16);
+      __m256i mul_lo = _mm256_mullo_epi16(src16, coeff16);
+      // [32] a4 b4 g4 r4 | a0 b0 g0 r0
+      accum0 = _mm256_add_epi32(accum0, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+      // [32] a5 b5 g5 r5 | a1 b1 g1 r1
+      accum1 = _mm256_add_epi32(accum1, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+
+      // [16] a7 b7 g7 r7 a6 b6 g6 r6 | a3 b3 g3 r3 a2 b2 g2 r2
+      src16 = _mm256_unpackhi_epi8(src8, zero);
+      mul_hi = _mm256_mulhi_epi16(src16, coeff16);
+      mul_lo = _mm256_mullo_epi16(src16, coeff16);
+      // [32] a6 b6 g6 r6 | a2 b2 g2 r2
+      accum2 = _mm256_add_epi32(accum2, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+      // [32] a7 b7 g7 r7 | a3 b3 g3 r3
+      accum3 = _mm256_add_epi32(accum3, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+    }
+
+    // Shift right for fixed point implementation.
+    accum0 = _mm256_srai_epi32(accum0, ConvolutionFilter1D::kShiftBits);
+    accum1 = _mm256_srai_epi32(accum1, ConvolutionFilter1D::kShiftBits);
+    accum2 = _mm256_srai_epi32(accum2, ConvolutionFilter1D::kShiftBits);
+    accum3 = _mm256_srai_epi32(accum3, ConvolutionFilter1D::kShiftBits);
+
+    // Pack to 16 then 8 bits per channel, which puts the pixels back in
+    // order within each lane.
+    // [8] a7 .. r4 | a3 .. r0
+    accum0 = _mm256_packus_epi16(_mm256_packs_epi32(accum0, accum1),
+                                 _mm256_packs_epi32(accum2, accum3));
+
+    if (has_alpha) {
+      // Make sure the value of alpha channel is always larger than maximum
+      // value of color channels.
+      __m256i b = _mm256_max_epu8(_mm256_srli_epi32(accum0, 8), accum0);
+      b = _mm256_max_epu8(_mm256_srli_epi32(accum0, 16), b);
+      accum0 = _mm256_max_epu8(_mm256_slli_epi32(b, 24), accum0);
+    } else {
+      // Set value of alpha channels to 0xFF.
+      accum0 = _mm256_or_si256(accum0, _mm256_set1_epi32(0xff000000));
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out_row), accum0);
+    out_row += 32;
+  }
+
+  // Finish the row four pixels at a time, so that we don't read further past
+  // the end of the source rows than the SSE2 version does.
+  if (width < pixel_width) {
+    ConvolveVertically_SSE2(filter_values, filter_length, source_data_rows,
+                            pixel_width, out_row - (width << 2), has_alpha,
+                            width);
+  }
+}
+
+void ConvolveVertically_AVX2(const ConvolutionFilter1D::Fixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row, bool has_alpha) {
+  if (has_alpha) {
+    ConvolveVertically_AVX2_impl<true>(filter_values, filter_length,
+                                       source_data_rows, pixel_width, out_row);
+  } else {
+    ConvolveVertically_AVX2_impl<false>(filter_values, filter_length,
+                                        source_data_rows, pixel_width, out_row);
+  }
+}
+
+}  // namespace skia
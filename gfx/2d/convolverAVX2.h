@@ -0,0 +1,23 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef SKIA_EXT_CONVOLVER_AVX2_H_
+#define SKIA_EXT_CONVOLVER_AVX2_H_
+
+#include "convolver.h"
+
+namespace skia {
+
+// AVX2 version of ConvolveVertically_SSE2, producing eight pixels per
+// iteration. Like the SSE2 version, it never reads more than 12 bytes past
+// the end of a source row.
+void ConvolveVertically_AVX2(const ConvolutionFilter1D::Fixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row, bool has_alpha);
+
+}  // namespace skia
+
+#endif  // SKIA_EXT_CONVOLVER_AVX2_H_
@@ -291,14 +291,16 @@ void ConvolveVertically_SSE2_impl(const ConvolutionFilter1D::Fixed* filter_value
                                   int filter_length,
                                   unsigned char* const* source_data_rows,
                                   int pixel_width,
-                                  unsigned char* out_row) {
+                                  unsigned char* out_row,
+                                  int begin_x) {
   int width = pixel_width & ~3;
+  out_row += begin_x << 2;
 
   __m128i zero = _mm_setzero_si128();
   __m128i accum0, accum1, accum2, accum3, coeff16;
   const __m128i* src;
   // Output four pixels per iteration (16 bytes).
-  for (int out_x = 0; out_x < width; out_x += 4) {
+  for (int out_x = begin_x; out_x < width; out_x += 4) {
 
     // Accumulated result for each pixel. 32 bits per RGBA channel.
     accum0 = _mm_setzero_si128();
@@ -458,13 +460,16 @@ void ConvolveVertically_SSE2(const ConvolutionFilter1D::Fixed* filter_values,
                              int filter_length,
                              unsigned char* const* source_data_rows,
                              int pixel_width,
-                             unsigned char* out_row, bool has_alpha) {
+                             unsigned char* out_row, bool has_alpha,
+                             int begin_x) {
   if (has_alpha) {
     ConvolveVertically_SSE2_impl<true>(filter_values, filter_length,
-                                       source_data_rows, pixel_width, out_row);
+                                       source_data_rows, pixel_width, out_row,
+                                       begin_x);
   } else {
     ConvolveVertically_SSE2_impl<false>(filter_values, filter_length,
-                                       source_data_rows, pixel_width, out_row);
+                                       source_data_rows, pixel_width, out_row,
+                                       begin_x);
   }
 }
 
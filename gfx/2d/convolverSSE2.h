@@ -57,11 +57,14 @@ void ConvolveHorizontally4_SSE2(const unsigned char* src_data[4],
 // being |pixel_width| wide.
 //
 // The output must have room for |pixel_width * 4| bytes.
+//
+// Pixels before |begin_x|, which must be a multiple of 4, are left untouched.
 void ConvolveVertically_SSE2(const ConvolutionFilter1D::Fixed* filter_values,
                              int filter_length,
                              unsigned char* const* source_data_rows,
                              int pixel_width,
-                             unsigned char* out_row, bool has_alpha);
+                             unsigned char* out_row, bool has_alpha,
+                             int begin_x = 0);
 
 }  // namespace skia
 
@@ -36,6 +36,7 @@
 
 #include "base/stack_container.h"
 #include "convolver.h"
+#include "mozilla/StaticMutex.h"
 #include "skia/include/core/SkColorPriv.h"
 #include "skia/include/core/SkBitmap.h"
 #include "skia/include/core/SkRect.h"
@@ -45,6 +46,69 @@ namespace skia {
 
 namespace resize {
 
+namespace {
+
+// Downscales by more than this factor get their source box filtered first, so
+// that the remaining scale is between this factor and twice it.
+const int kMaxFilteredDownscale = 2;
+
+struct CachedFilter {
+  ImageOperations::ResizeMethod method;
+  int src_size;
+  int dst_size;
+  int dest_subset_lo;
+  int dest_subset_size;
+  ConvolutionFilter1D filter;
+};
+
+// Most recently used first. The entries are never freed.
+const size_t kFilterCacheSize = 8;
+CachedFilter* sFilterCache[kFilterCacheSize];
+mozilla::StaticMutex sFilterCacheMutex;
+
+void ComputeFiltersUncached(ImageOperations::ResizeMethod method,
+                            int src_size, int dst_size,
+                            int dest_subset_lo, int dest_subset_size,
+                            ConvolutionFilter1D* output);
+
+} // namespace
+
+void ComputeFilters(ImageOperations::ResizeMethod method,
+                    int src_size, int dst_size,
+                    int dest_subset_lo, int dest_subset_size,
+                    ConvolutionFilter1D* output) {
+  {
+    mozilla::StaticMutexAutoLock lock(sFilterCacheMutex);
+    for (size_t i = 0; i < kFilterCacheSize && sFilterCache[i]; i++) {
+      CachedFilter* entry = sFilterCache[i];
+      if (entry->method == method &&
+          entry->src_size == src_size &&
+          entry->dst_size == dst_size &&
+          entry->dest_subset_lo == dest_subset_lo &&
+          entry->dest_subset_size == dest_subset_size) {
+        *output = entry->filter;
+        std::rotate(&sFilterCache[0], &sFilterCache[i], &sFilterCache[i + 1]);
+        return;
+      }
+    }
+  }
+
+  CachedFilter* entry = new CachedFilter{ method, src_size, dst_size,
+                                          dest_subset_lo, dest_subset_size,
+                                          ConvolutionFilter1D() };
+  ComputeFiltersUncached(method, src_size, dst_size,
+                         dest_subset_lo, dest_subset_size, &entry->filter);
+  *output = entry->filter;
+
+  mozilla::StaticMutexAutoLock lock(sFilterCacheMutex);
+  delete sFilterCache[kFilterCacheSize - 1];
+  std::copy_backward(&sFilterCache[0], &sFilterCache[kFilterCacheSize - 1],
+                     &sFilterCache[kFilterCacheSize]);
+  sFilterCache[0] = entry;
+}
+
+namespace {
+
 // TODO(egouriou): Take advantage of periods in the convolution.
 // Practical resizing filters are periodic outside of the border area.
 // For Lanczos, a scaling by a (reduced) factor of p/q (q pixels in the
@@ -56,10 +120,10 @@ namespace resize {
 // Small periods reduce computational load and improve cache usage if
 // the coefficients can be shared. For periods of 1 we can consider
 // loading the factors only once outside the borders.
-void ComputeFilters(ImageOperations::ResizeMethod method,
-                    int src_size, int dst_size,
-                    int dest_subset_lo, int dest_subset_size,
-                    ConvolutionFilter1D* output) {
+void ComputeFiltersUncached(ImageOperations::ResizeMethod method,
+                            int src_size, int dst_size,
+                            int dest_subset_lo, int dest_subset_size,
+                            ConvolutionFilter1D* output) {
   // method_ will only ever refer to an "algorithm method".
   SkASSERT((ImageOperations::RESIZE_FIRST_ALGORITHM_METHOD <= method) &&
            (method <= ImageOperations::RESIZE_LAST_ALGORITHM_METHOD));
@@ -154,6 +218,8 @@ void ComputeFilters(ImageOperations::ResizeMethod method,
   output->PaddingForSIMD(8);
 }
 
+} // namespace
+
 } // namespace resize
 
 ImageOperations::ResizeMethod ResizeMethodToAlgorithmMethod(
@@ -334,6 +400,20 @@ SkBitmap ImageOperations::ResizeBasic(const SkBitmap& source,
   SkASSERT((ImageOperations::RESIZE_FIRST_ALGORITHM_METHOD <= method) &&
            (method <= ImageOperations::RESIZE_LAST_ALGORITHM_METHOD));
 
+  // The filters of extreme downscales span a huge number of source pixels.
+  // Averaging blocks of source pixels first gives almost the same result for
+  // a fraction of the work.
+  int factor_x = source.width() / (dest_width * resize::kMaxFilteredDownscale);
+  int factor_y = source.height() / (dest_height * resize::kMaxFilteredDownscale);
+  if (method != RESIZE_BOX && (factor_x > 1 || factor_y > 1)) {
+    SkBitmap prefiltered = BoxPrefilter(source, std::max(factor_x, 1),
+                                        std::max(factor_y, 1));
+    if (!prefiltered.isNull()) {
+      return ResizeBasic(prefiltered, method, dest_width, dest_height,
+                         dest_subset, dest_pixels);
+    }
+  }
+
   SkAutoLockPixels locker(source);
   if (!source.readyToDraw())
       return SkBitmap();
@@ -377,6 +457,58 @@ SkBitmap ImageOperations::ResizeBasic(const SkBitmap& source,
   return result;
 }
 
+// static
+SkBitmap ImageOperations::BoxPrefilter(const SkBitmap& source,
+                                       int factor_x, int factor_y) {
+  SkAutoLockPixels locker(source);
+  if (!source.readyToDraw())
+    return SkBitmap();
+
+  // The last row and column of blocks may be partial, they are averaged over
+  // the pixels they actually have.
+  int width = (source.width() + factor_x - 1) / factor_x;
+  int height = (source.height() + factor_y - 1) / factor_y;
+
+  SkBitmap result;
+  SkImageInfo info = SkImageInfo::Make(width, height,
+                                       kBGRA_8888_SkColorType,
+                                       source.alphaType());
+  result.allocPixels(info);
+  if (!result.readyToDraw())
+    return SkBitmap();
+
+  std::vector<uint32_t> sums(width * 4);
+  for (int y = 0; y < height; y++) {
+    std::fill(sums.begin(), sums.end(), 0);
+    int src_y_begin = y * factor_y;
+    int src_y_end = std::min(src_y_begin + factor_y, source.height());
+    for (int src_y = src_y_begin; src_y < src_y_end; src_y++) {
+      const uint8_t* src_row =
+        static_cast<const uint8_t*>(source.getAddr(0, src_y));
+      for (int src_x = 0; src_x < source.width(); src_x++) {
+        uint32_t* sum = &sums[(src_x / factor_x) * 4];
+        const uint8_t* pixel = &src_row[src_x * 4];
+        sum[0] += pixel[0];
+        sum[1] += pixel[1];
+        sum[2] += pixel[2];
+        sum[3] += pixel[3];
+      }
+    }
+
+    uint8_t* dst_row = static_cast<uint8_t*>(result.getAddr(0, y));
+    int rows = src_y_end - src_y_begin;
+    for (int x = 0; x < width; x++) {
+      int columns = std::min(factor_x, source.width() - x * factor_x);
+      uint32_t count = rows * columns;
+      for (int c = 0; c < 4; c++) {
+        dst_row[x * 4 + c] = (sums[x * 4 + c] + count / 2) / count;
+      }
+    }
+  }
+
+  return result;
+}
+
 // static
 SkBitmap ImageOperations::Resize(const SkBitmap& source,
                                  ResizeMethod method,
@@ -148,6 +148,11 @@ class ImageOperations {
                               const SkIRect& dest_subset,
                               void* dest_pixels = nullptr);
 
+  // Averages blocks of |factor_x| by |factor_y| pixels of |source|. Used to
+  // shrink the source of extreme downscales before running the real filter.
+  static SkBitmap BoxPrefilter(const SkBitmap& source,
+                               int factor_x, int factor_y);
+
   // Subpixel renderer.
   static SkBitmap ResizeSubpixel(const SkBitmap& source,
                                  int dest_width, int dest_height,
@@ -258,6 +263,9 @@ namespace resize {
   //
   // Likewise, the range of destination values to compute and the scale factor
   // for the transform is also specified.
+  //
+  // The last few filters computed are cached, since callers tend to ask for
+  // the same sizes over and over.
   void ComputeFilters(ImageOperations::ResizeMethod method,
                       int src_size, int dst_size,
                       int dest_subset_lo, int dest_subset_size,
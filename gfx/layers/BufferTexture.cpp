@@ -577,7 +577,9 @@ ShmemTextureData::CreateSimilar(LayersIPCChannel* aAllocator,
 void
 ShmemTextureData::Deallocate(LayersIPCChannel* aAllocator)
 {
-  aAllocator->DeallocShmem(mShmem);
+  // Nothing on the compositor side uses the shmem anymore, so the allocator
+  // may hand it out again.
+  aAllocator->RecycleShmem(mShmem);
 }
 
 } // namespace
@@ -493,6 +493,13 @@ public:
 
   virtual void FinishPendingComposite() {}
 
+  /**
+   * Block until the GPU has finished all the work submitted so far. This is
+   * only meant for measuring how long frames take on the GPU, e.g. in
+   * CompositorBench.
+   */
+  virtual void WaitForGPU() {}
+
   widget::CompositorWidget* GetWidget() const { return mWidget; }
 
   virtual bool HasImageHostOverlays() { return false; }
@@ -530,6 +537,7 @@ public:
   }
   void SetCompositionTime(TimeStamp aTimeStamp) {
     mCompositionTime = aTimeStamp;
+    mTileUploadTime = TimeDuration();
     if (!mCompositionTime.IsNull() && !mCompositeUntilTime.IsNull() &&
         mCompositionTime >= mCompositeUntilTime) {
       mCompositeUntilTime = TimeStamp();
@@ -546,6 +554,17 @@ public:
     return mCompositeUntilTime;
   }
 
+  /**
+   * Time spent uploading tile textures during the current composition, which
+   * tiled layers share as one upload budget.
+   */
+  TimeDuration GetTileUploadTime() const {
+    return mTileUploadTime;
+  }
+  void AddTileUploadTime(TimeDuration aDuration) {
+    mTileUploadTime += aDuration;
+  }
+
   // A stale Compositor has no CompositorBridgeParent; it will not process
   // frames and should not be used.
   void SetInvalid();
@@ -624,6 +643,10 @@ protected:
    * on every vsync until this time occurs (this is the latest such time).
    */
   TimeStamp mCompositeUntilTime;
+  /**
+   * Time spent uploading tile textures during the current composition.
+   */
+  TimeDuration mTileUploadTime;
 
   uint32_t mCompositorID;
   DiagnosticTypes mDiagnosticTypes;
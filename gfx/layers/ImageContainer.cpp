@@ -5,13 +5,17 @@
 
 
 #include "ImageContainer.h"
+#include <algorithm>                    // for std::max
 #include <string.h>                     // for memcpy, memset
 #include "GLImages.h"                   // for SurfaceTextureImage
 #include "gfx2DGlue.h"
 #include "gfxPlatform.h"                // for gfxPlatform
 #include "gfxUtils.h"                   // for gfxUtils
 #include "libyuv.h"
+#include "mozilla/MathAlgorithms.h"    // for FloorLog2
 #include "mozilla/RefPtr.h"             // for already_AddRefed
+#include "mozilla/StaticMutex.h"        // for StaticMutex
+#include "mozilla/StaticPtr.h"          // for StaticRefPtr
 #include "mozilla/ipc/CrossProcessMutex.h"  // for CrossProcessMutex, etc
 #include "mozilla/layers/CompositorTypes.h"
 #include "mozilla/layers/ImageBridgeChild.h"  // for ImageBridgeChild
@@ -59,13 +63,29 @@ ImageFactory::CreatePlanarYCbCrImage(const gfx::IntSize& aScaleHint, BufferRecyc
   return new RecyclingPlanarYCbCrImage(aRecycleBin);
 }
 
-BufferRecycleBin::BufferRecycleBin()
+static StaticMutex sSharedRecycleBinLock;
+static StaticRefPtr<BufferRecycleBin> sSharedRecycleBin;
+
+BufferRecycleBin::BufferRecycleBin(size_t aMaxBytes)
   : mLock("mozilla.layers.BufferRecycleBin.mLock")
-  // This member is only valid when the bin is not empty and will be properly
-  // initialized in RecycleBuffer, but initializing it here avoids static analysis
-  // noise.
-  , mRecycledBufferSize(0)
+  , mRecycledBytes(0)
+  , mMaxBytes(aMaxBytes)
+{
+}
+
+/* static */ uint32_t
+BufferRecycleBin::SizeClass(uint32_t aSize)
 {
+  // Round up to the next multiple of an eighth of the largest power of two
+  // not above aSize, or of a page for small buffers, so large buffers are at
+  // most 12.5% larger than requested.
+  const uint32_t kMinGranularity = 4096;
+  uint32_t granularity =
+    std::max(kMinGranularity, aSize ? (uint32_t(1) << FloorLog2(aSize)) / 8 : 0);
+  if (aSize > UINT32_MAX - granularity) {
+    return aSize;
+  }
+  return (aSize + granularity - 1) / granularity * granularity;
 }
 
 void
@@ -73,11 +93,37 @@ BufferRecycleBin::RecycleBuffer(UniquePtr<uint8_t[]> aBuffer, uint32_t aSize)
 {
   MutexAutoLock lock(mLock);
 
-  if (!mRecycledBuffers.IsEmpty() && aSize != mRecycledBufferSize) {
-    mRecycledBuffers.Clear();
+  uint32_t sizeClass = SizeClass(aSize);
+  if (mMaxBytes && sizeClass > mMaxBytes) {
+    return;
+  }
+
+  // Move the size class to the end of the list, as the most recently used.
+  SizeClassBuffers buffers;
+  for (size_t i = 0; i < mSizeClasses.Length(); i++) {
+    if (mSizeClasses[i].mSize == sizeClass) {
+      buffers.mBuffers.SwapElements(mSizeClasses[i].mBuffers);
+      mSizeClasses.RemoveElementAt(i);
+      break;
+    }
+  }
+  buffers.mSize = sizeClass;
+  buffers.mBuffers.AppendElement(Move(aBuffer));
+  mSizeClasses.AppendElement(Move(buffers));
+  mRecycledBytes += sizeClass;
+
+  // Drop the least recently used buffers. Without a limit, that is every
+  // other size class.
+  while (mSizeClasses.Length() > 1 &&
+         (!mMaxBytes || mRecycledBytes > mMaxBytes)) {
+    mRecycledBytes -= mSizeClasses[0].mSize * mSizeClasses[0].mBuffers.Length();
+    mSizeClasses.RemoveElementAt(0);
+  }
+  SizeClassBuffers& last = mSizeClasses.LastElement();
+  while (mMaxBytes && mRecycledBytes > mMaxBytes) {
+    last.mBuffers.RemoveElementAt(0);
+    mRecycledBytes -= last.mSize;
   }
-  mRecycledBufferSize = aSize;
-  mRecycledBuffers.AppendElement(Move(aBuffer));
 }
 
 UniquePtr<uint8_t[]>
@@ -85,23 +131,62 @@ BufferRecycleBin::GetBuffer(uint32_t aSize)
 {
   MutexAutoLock lock(mLock);
 
-  if (mRecycledBuffers.IsEmpty() || mRecycledBufferSize != aSize)
-    return MakeUnique<uint8_t[]>(aSize);
+  uint32_t sizeClass = SizeClass(aSize);
+  for (size_t i = 0; i < mSizeClasses.Length(); i++) {
+    nsTArray<UniquePtr<uint8_t[]>>& buffers = mSizeClasses[i].mBuffers;
+    if (mSizeClasses[i].mSize != sizeClass || buffers.IsEmpty()) {
+      continue;
+    }
+    uint32_t last = buffers.Length() - 1;
+    UniquePtr<uint8_t[]> result = Move(buffers[last]);
+    buffers.RemoveElementAt(last);
+    mRecycledBytes -= sizeClass;
+    return result;
+  }
 
-  uint32_t last = mRecycledBuffers.Length() - 1;
-  UniquePtr<uint8_t[]> result = Move(mRecycledBuffers[last]);
-  mRecycledBuffers.RemoveElementAt(last);
-  return result;
+  return MakeUnique<uint8_t[]>(sizeClass);
 }
 
 void
 BufferRecycleBin::ClearRecycledBuffers()
 {
   MutexAutoLock lock(mLock);
-  if (!mRecycledBuffers.IsEmpty()) {
-    mRecycledBuffers.Clear();
+  mSizeClasses.Clear();
+  mRecycledBytes = 0;
+}
+
+/* static */ already_AddRefed<BufferRecycleBin>
+BufferRecycleBin::GetShared()
+{
+  StaticMutexAutoLock lock(sSharedRecycleBinLock);
+  RefPtr<BufferRecycleBin> bin = sSharedRecycleBin.get();
+  return bin.forget();
+}
+
+/* static */ void
+BufferRecycleBin::InitShared(size_t aMaxBytes)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  StaticMutexAutoLock lock(sSharedRecycleBinLock);
+  MOZ_ASSERT(!sSharedRecycleBin);
+  sSharedRecycleBin = new BufferRecycleBin(aMaxBytes);
+}
+
+/* static */ void
+BufferRecycleBin::ShutdownShared()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  StaticMutexAutoLock lock(sSharedRecycleBinLock);
+  sSharedRecycleBin = nullptr;
+}
+
+/* static */ void
+BufferRecycleBin::PurgeShared()
+{
+  RefPtr<BufferRecycleBin> bin = GetShared();
+  if (bin) {
+    bin->ClearRecycledBuffers();
   }
-  mRecycledBufferSize = 0;
 }
 
 void
@@ -128,9 +213,12 @@ ImageContainer::ImageContainer(Mode flag)
   mPaintCount(0),
   mDroppedImageCount(0),
   mImageFactory(new ImageFactory()),
-  mRecycleBin(new BufferRecycleBin()),
+  mRecycleBin(BufferRecycleBin::GetShared()),
   mCurrentProducerID(-1)
 {
+  if (!mRecycleBin) {
+    mRecycleBin = new BufferRecycleBin();
+  }
   if (flag == ASYNCHRONOUS) {
     EnsureImageClient(true);
   } else {
@@ -310,6 +398,12 @@ ImageContainer::ClearCachedResources()
     mImageClient->GetTextureClientRecycler()->ShrinkToMinimumSize();
     return;
   }
+  // The shared bin holds buffers for other containers too, it is purged on
+  // memory pressure instead.
+  RefPtr<BufferRecycleBin> sharedBin = BufferRecycleBin::GetShared();
+  if (mRecycleBin == sharedBin) {
+    return;
+  }
   return mRecycleBin->ClearRecycledBuffers();
 }
 
@@ -271,6 +271,15 @@ protected:
  * ImageContainer because images need to store a strong ref to their RecycleBin
  * and we must avoid creating a reference loop between an ImageContainer and
  * its active image.
+ *
+ * Buffers are allocated in size classes a little larger than requested, so a
+ * buffer can be reused for a frame whose size or stride changed slightly,
+ * e.g. 1080 rows padded to 1088 by a decoder.
+ *
+ * When layers.video-frame-pool.max-mb is set, all the ImageContainers of the
+ * process share a single bin, which holds buffers of several size classes up
+ * to that much memory. That way players switching resolutions, or several
+ * players on a page, reuse each other's buffers.
  */
 class BufferRecycleBin final {
   NS_INLINE_DECL_THREADSAFE_REFCOUNTING(BufferRecycleBin)
@@ -278,12 +287,25 @@ class BufferRecycleBin final {
   //typedef mozilla::gl::GLContext GLContext;
 
 public:
-  BufferRecycleBin();
+  // If aMaxBytes is 0, only buffers of the most recently recycled size class
+  // are kept. Otherwise buffers of any size class are kept, and the least
+  // recently recycled size classes are dropped to stay under aMaxBytes.
+  explicit BufferRecycleBin(size_t aMaxBytes = 0);
 
   void RecycleBuffer(mozilla::UniquePtr<uint8_t[]> aBuffer, uint32_t aSize);
-  // Returns a recycled buffer of the right size, or allocates a new buffer.
+  // Returns a recycled buffer of at least aSize bytes, or allocates a new
+  // buffer. aSize must be the size that is later passed to RecycleBuffer.
   mozilla::UniquePtr<uint8_t[]> GetBuffer(uint32_t aSize);
   virtual void ClearRecycledBuffers();
+
+  // The bin shared by all the ImageContainers of the process, or null if
+  // there isn't one.
+  static already_AddRefed<BufferRecycleBin> GetShared();
+  // Must be called on the main thread.
+  static void InitShared(size_t aMaxBytes);
+  static void ShutdownShared();
+  static void PurgeShared();
+
 private:
   typedef mozilla::Mutex Mutex;
 
@@ -292,15 +314,22 @@ private:
   {
   }
 
-  // This protects mRecycledBuffers, mRecycledBufferSize, mRecycledTextures
-  // and mRecycledTextureSizes
+  static uint32_t SizeClass(uint32_t aSize);
+
+  struct SizeClassBuffers {
+    uint32_t mSize;
+    nsTArray<mozilla::UniquePtr<uint8_t[]>> mBuffers;
+  };
+
+  // This protects mSizeClasses and mRecycledBytes.
   Mutex mLock;
 
   // We should probably do something to prune this list on a timer so we don't
   // eat excess memory while video is paused...
-  nsTArray<mozilla::UniquePtr<uint8_t[]>> mRecycledBuffers;
-  // This is only valid if mRecycledBuffers is non-empty
-  uint32_t mRecycledBufferSize;
+  // Ordered from the least to the most recently recycled.
+  nsTArray<SizeClassBuffers> mSizeClasses;
+  size_t mRecycledBytes;
+  const size_t mMaxBytes;
 };
 
 /**
@@ -23,6 +23,9 @@ ImageLayer::~ImageLayer()
 
 void ImageLayer::SetContainer(ImageContainer* aContainer) 
 {
+  if (mContainer != aContainer) {
+    MarkMutated();
+  }
   mContainer = aContainer;
 }
 
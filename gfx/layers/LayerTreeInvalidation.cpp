@@ -110,6 +110,7 @@ NotifySubdocumentInvalidation(Layer* aLayer, NotifySubDocInvalidationFunc aCallb
       [aCallback] (Layer* layer)
       {
         layer->ClearInvalidRect();
+        layer->ClearMutated();
         if (layer->GetMaskLayer()) {
           NotifySubdocumentInvalidation(layer->GetMaskLayer(), aCallback);
         }
@@ -137,6 +138,7 @@ struct LayerPropertiesBase : public LayerProperties
     , mPostYScale(aLayer->GetPostYScale())
     , mOpacity(aLayer->GetLocalOpacity())
     , mUseClipRect(!!aLayer->GetLocalClipRect())
+    , mSubtreeHasMasks(aLayer->GetMaskLayer() || aLayer->GetAncestorMaskLayerCount())
   {
     MOZ_COUNT_CTOR(LayerPropertiesBase);
     if (aLayer->GetMaskLayer()) {
@@ -154,6 +156,7 @@ struct LayerPropertiesBase : public LayerProperties
   LayerPropertiesBase()
     : mLayer(nullptr)
     , mMaskLayer(nullptr)
+    , mSubtreeHasMasks(false)
   {
     MOZ_COUNT_CTOR(LayerPropertiesBase);
   }
@@ -173,6 +176,22 @@ public:
 
   virtual void MoveBy(const IntPoint& aOffset);
 
+  /**
+   * Returns false if ComputeChange is known to return an empty region,
+   * because nothing in the subtree of mLayer has been mutated since it was
+   * last diffed. Mask layers aren't part of that subtree, so we always look
+   * at subtrees that have them. Composite layers also change when the
+   * compositor samples animations or receives new frames, which doesn't mark
+   * them as mutated.
+   */
+  bool MayHaveChanged()
+  {
+    return !mLayer ||
+           mSubtreeHasMasks ||
+           mLayer->AsLayerComposite() ||
+           mLayer->IsSubtreeMutated();
+  }
+
   nsIntRegion ComputeChange(NotifySubDocInvalidationFunc aCallback,
                             bool& aGeometryChanged)
   {
@@ -211,7 +230,7 @@ public:
     AddRegion(result, ComputeChangeInternal(aCallback, aGeometryChanged));
     AddTransformedRegion(result, mLayer->GetInvalidRegion().GetRegion(), mTransform);
 
-    if (mMaskLayer && otherMask) {
+    if (mMaskLayer && otherMask && mMaskLayer->MayHaveChanged()) {
       AddTransformedRegion(result, mMaskLayer->ComputeChange(aCallback, aGeometryChanged),
                            mTransform);
     }
@@ -220,6 +239,9 @@ public:
          i < std::min(mAncestorMaskLayers.Length(), mLayer->GetAncestorMaskLayerCount());
          i++)
     {
+      if (!mAncestorMaskLayers[i]->MayHaveChanged()) {
+        continue;
+      }
       AddTransformedRegion(result,
                            mAncestorMaskLayers[i]->ComputeChange(aCallback, aGeometryChanged),
                            mTransform);
@@ -235,6 +257,7 @@ public:
     }
 
     mLayer->ClearInvalidRect();
+    mLayer->ClearMutated();
     return result;
   }
 
@@ -271,6 +294,9 @@ public:
   float mOpacity;
   ParentLayerIntRect mClipRect;
   bool mUseClipRect;
+  // Whether mLayer or any of its descendants had mask layers when we were
+  // cloned.
+  bool mSubtreeHasMasks;
   mozilla::CorruptionCanary mCanary;
 };
 
@@ -280,10 +306,12 @@ struct ContainerLayerProperties : public LayerPropertiesBase
     : LayerPropertiesBase(aLayer)
     , mPreXScale(aLayer->GetPreXScale())
     , mPreYScale(aLayer->GetPreYScale())
+    , mExtend3DContext(aLayer->Extend3DContext())
   {
     for (Layer* child = aLayer->GetFirstChild(); child; child = child->GetNextSibling()) {
       child->CheckCanary();
       mChildren.AppendElement(Move(CloneLayerTreePropertiesInternal(child)));
+      mSubtreeHasMasks |= mChildren.LastElement()->mSubtreeHasMasks;
     }
   }
 
@@ -305,6 +333,10 @@ public:
 
     bool childrenChanged = false;
 
+    // The transforms of children that combine theirs with ours have to be
+    // recomputed even if the children themselves haven't changed.
+    bool diffAllChildren = mExtend3DContext || container->Extend3DContext();
+
     if (mPreXScale != container->GetPreXScale() ||
         mPreYScale != container->GetPreYScale()) {
       aGeometryChanged = true;
@@ -350,11 +382,14 @@ public:
               MOZ_CRASH("Out of bounds");
             }
             // Invalidate any regions of the child that have changed:
-            nsIntRegion region = mChildren[childsOldIndex]->ComputeChange(aCallback, aGeometryChanged);
+            LayerPropertiesBase* oldChild = mChildren[childsOldIndex].get();
             i = childsOldIndex + 1;
-            if (!region.IsEmpty()) {
-              AddRegion(result, region);
-              childrenChanged |= true;
+            if (diffAllChildren || oldChild->MayHaveChanged()) {
+              nsIntRegion region = oldChild->ComputeChange(aCallback, aGeometryChanged);
+              if (!region.IsEmpty()) {
+                AddRegion(result, region);
+                childrenChanged |= true;
+              }
             }
           } else {
             // We've already seen this child in mChildren (which means it must
@@ -439,6 +474,7 @@ public:
   nsTArray<UniquePtr<LayerPropertiesBase>> mChildren;
   float mPreXScale;
   float mPreYScale;
+  bool mExtend3DContext;
 };
 
 struct ColorLayerProperties : public LayerPropertiesBase
@@ -630,6 +666,7 @@ LayerProperties::ClearInvalidations(Layer *aLayer)
         [] (Layer* layer)
         {
           layer->ClearInvalidRect();
+          layer->ClearMutated();
           if (layer->GetMaskLayer()) {
             ClearInvalidations(layer->GetMaskLayer());
           }
@@ -661,7 +698,10 @@ LayerPropertiesBase::ComputeDifferences(Layer* aRoot, NotifySubDocInvalidationFu
     return result;
   } else {
     bool geometryChanged = (aGeometryChanged != nullptr) ? *aGeometryChanged : false;
-    nsIntRegion invalid = ComputeChange(aCallback, geometryChanged);
+    nsIntRegion invalid;
+    if (MayHaveChanged()) {
+      invalid = ComputeChange(aCallback, geometryChanged);
+    }
     if (aGeometryChanged != nullptr) {
       *aGeometryChanged = geometryChanged;
     }
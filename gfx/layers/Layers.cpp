@@ -274,6 +274,8 @@ Layer::Layer(LayerManager* aManager, void* aImplData) :
   mScrollbarDirection(ScrollDirection::NONE),
   mScrollbarThumbRatio(0.0f),
   mIsScrollbarContainer(false),
+  mMutated(true),
+  mDescendantMutated(false),
 #ifdef DEBUG
   mDebugColorIndex(0),
 #endif
@@ -287,6 +289,17 @@ Layer::~Layer()
   MOZ_COUNT_DTOR(Layer);
 }
 
+void
+Layer::MarkMutated()
+{
+  mMutated = true;
+  for (Layer* layer = GetParent();
+       layer && !layer->mDescendantMutated;
+       layer = layer->GetParent()) {
+    layer->mDescendantMutated = true;
+  }
+}
+
 Animation*
 Layer::AddAnimation()
 {
@@ -1274,6 +1287,7 @@ ContainerLayer::RepositionChild(Layer* aChild, Layer* aAfter)
     // aChild is already in the correct position, nothing to do.
     return true;
   }
+  MarkMutated();
   if (prev) {
     prev->SetNextSibling(next);
   } else {
@@ -1568,6 +1582,7 @@ ContainerLayer::HasOpaqueAncestorLayer(Layer* aLayer)
 void
 ContainerLayer::DidRemoveChild(Layer* aLayer)
 {
+  MarkMutated();
   PaintedLayer* tl = aLayer->AsPaintedLayer();
   if (tl && tl->UsedForReadback()) {
     for (Layer* l = mFirstChild; l; l = l->GetNextSibling()) {
@@ -1584,6 +1599,7 @@ ContainerLayer::DidRemoveChild(Layer* aLayer)
 void
 ContainerLayer::DidInsertChild(Layer* aLayer)
 {
+  MarkMutated();
   if (aLayer->GetType() == TYPE_READBACK) {
     mMayHaveReadbackChild = true;
   }
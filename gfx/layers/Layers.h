@@ -1723,6 +1723,7 @@ public:
   const virtual gfx::TiledIntRegion& GetInvalidRegion() { return mInvalidRegion; }
   void AddInvalidRegion(const nsIntRegion& aRegion) {
     mInvalidRegion.Add(aRegion);
+    MarkMutated();
   }
 
   /**
@@ -1732,12 +1733,17 @@ public:
   {
     mInvalidRegion.SetEmpty();
     mInvalidRegion.Add(GetVisibleRegion().ToUnknownRegion());
+    MarkMutated();
   }
 
   /**
    * Adds to the current invalid rect.
    */
-  void AddInvalidRect(const gfx::IntRect& aRect) { mInvalidRegion.Add(aRect); }
+  void AddInvalidRect(const gfx::IntRect& aRect)
+  {
+    mInvalidRegion.Add(aRect);
+    MarkMutated();
+  }
 
   /**
    * Clear the invalid rect, marking the layer as being identical to what is currently
@@ -1769,9 +1775,35 @@ public:
 
   void Mutated()
   {
+    MarkMutated();
     mManager->Mutated(this);
   }
 
+  /**
+   * Record that this layer has changed in a way that LayerProperties has to
+   * look at, without notifying the layer manager. This also marks the
+   * ancestors of this layer, so that ComputeDifferences can skip the
+   * subtrees that haven't changed.
+   */
+  void MarkMutated();
+
+  /**
+   * Returns true if this layer, or any of its descendants, has been marked
+   * as mutated since the mutation flags were last cleared. Mask layers
+   * aren't part of the subtree and have to be checked separately.
+   */
+  bool IsSubtreeMutated() const { return mMutated || mDescendantMutated; }
+
+  /**
+   * Only call this once the mutations of all the descendants of this layer
+   * have been taken into account too.
+   */
+  void ClearMutated()
+  {
+    mMutated = false;
+    mDescendantMutated = false;
+  }
+
   virtual int32_t GetMaxLayerSize() { return Manager()->GetMaxTextureSize(); }
 
   /**
@@ -1909,6 +1941,11 @@ protected:
   // CSS pixels of the scrollframe's space).
   float mScrollbarThumbRatio;
   bool mIsScrollbarContainer;
+  // Set by MarkMutated on this layer and on its ancestors respectively, and
+  // cleared once LayerProperties has diffed (or dropped the invalidations of)
+  // this subtree.
+  bool mMutated;
+  bool mDescendantMutated;
 #ifdef DEBUG
   uint32_t mDebugColorIndex;
 #endif
@@ -0,0 +1,161 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=99: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "PaintThread.h"
+
+#include "GeckoProfiler.h"
+#include "gfxPrefs.h"
+#include "mozilla/gfx/2D.h"
+#include "mozilla/gfx/Logging.h"
+#include "mozilla/StaticPtr.h"
+#include "mozilla/SyncRunnable.h"
+#include "mozilla/UniquePtr.h"
+#include "nsThreadUtils.h"
+
+namespace mozilla {
+namespace layers {
+
+using namespace gfx;
+
+static StaticAutoPtr<PaintThread> sPaintThread;
+
+CapturedPaintState::CapturedPaintState(DrawTargetCapture* aCapture,
+                                       DrawTarget* aTarget)
+  : mCapture(aCapture)
+  , mTarget(aTarget)
+{
+}
+
+CapturedPaintState::~CapturedPaintState()
+{
+}
+
+PaintThread::PaintThread()
+{
+}
+
+PaintThread::~PaintThread()
+{
+  MOZ_ASSERT(mInFlight.IsEmpty());
+}
+
+bool
+PaintThread::Init()
+{
+  nsresult rv = NS_NewNamedThread("PaintThread", getter_AddRefs(mThread));
+  return NS_SUCCEEDED(rv);
+}
+
+/* static */ void
+PaintThread::Start()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(!sPaintThread);
+
+  if (!gfxPrefs::OMTPEnabled()) {
+    return;
+  }
+
+  UniquePtr<PaintThread> paintThread(new PaintThread());
+  if (!paintThread->Init()) {
+    gfxCriticalNote << "Failed to start the paint thread";
+    return;
+  }
+  sPaintThread = paintThread.release();
+}
+
+/* static */ void
+PaintThread::Shutdown()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!sPaintThread) {
+    return;
+  }
+
+  sPaintThread->WaitForPaints();
+  sPaintThread->mThread->Shutdown();
+  sPaintThread = nullptr;
+}
+
+/* static */ PaintThread*
+PaintThread::Get()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  return sPaintThread.get();
+}
+
+/* static */ bool
+PaintThread::IsOnPaintThread()
+{
+  bool on = false;
+  return sPaintThread &&
+         NS_SUCCEEDED(sPaintThread->mThread->IsOnCurrentThread(&on)) &&
+         on;
+}
+
+void
+PaintThread::PaintContents(nsTArray<RefPtr<CapturedPaintState>>&& aStates)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (aStates.IsEmpty()) {
+    return;
+  }
+
+  // The paint thread only gets raw pointers, so that the states are always
+  // destroyed on the main thread, by WaitForPaints.
+  nsTArray<CapturedPaintState*> states(aStates.Length());
+  for (const RefPtr<CapturedPaintState>& state : aStates) {
+    states.AppendElement(state.get());
+    mInFlight.AppendElement(state);
+  }
+  aStates.Clear();
+
+  RefPtr<Runnable> task = NS_NewRunnableFunction([states]() -> void {
+    PaintContentsOnPaintThread(states);
+  });
+  mThread->Dispatch(task.forget(), NS_DISPATCH_NORMAL);
+}
+
+/* static */ void
+PaintThread::PaintContentsOnPaintThread(const nsTArray<CapturedPaintState*>& aStates)
+{
+  MOZ_ASSERT(IsOnPaintThread());
+  PROFILER_LABEL("PaintThread", "PaintContents",
+    js::ProfileEntry::Category::GRAPHICS);
+
+  for (CapturedPaintState* state : aStates) {
+    DrawTarget* target = state->mTarget;
+    // The capture starts by setting the transform the target had when it was
+    // borrowed, so replay it without any additional transform.
+    Matrix oldTransform = target->GetTransform();
+    target->SetPermitSubpixelAA(state->mCapture->GetPermitSubpixelAA());
+    target->DrawCapturedDT(state->mCapture, Matrix());
+    target->SetTransform(oldTransform);
+  }
+}
+
+void
+PaintThread::WaitForPaints()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (mInFlight.IsEmpty()) {
+    return;
+  }
+
+  PROFILER_LABEL("PaintThread", "WaitForPaints",
+    js::ProfileEntry::Category::GRAPHICS);
+
+  // The paint thread runs its tasks in order, so all the paints are done once
+  // an empty task has run.
+  SyncRunnable::DispatchToThread(mThread, NS_NewRunnableFunction([]() -> void {}));
+  mInFlight.Clear();
+}
+
+} // namespace layers
+} // namespace mozilla
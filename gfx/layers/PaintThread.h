@@ -0,0 +1,98 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=99: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef MOZILLA_LAYERS_PAINTTHREAD_H
+#define MOZILLA_LAYERS_PAINTTHREAD_H
+
+#include "mozilla/RefPtr.h"
+#include "mozilla/gfx/Matrix.h"
+#include "nsISupportsImpl.h"
+#include "nsTArray.h"
+
+class nsIThread;
+
+namespace mozilla {
+namespace gfx {
+class DrawTarget;
+class DrawTargetCapture;
+} // namespace gfx
+
+namespace layers {
+
+/**
+ * The drawing commands recorded for one quadrant of a ClientPaintedLayer's
+ * buffer, and the buffer draw target they have to be replayed into.
+ */
+class CapturedPaintState final
+{
+  NS_INLINE_DECL_REFCOUNTING(CapturedPaintState)
+
+public:
+  CapturedPaintState(gfx::DrawTargetCapture* aCapture,
+                     gfx::DrawTarget* aTarget);
+
+  RefPtr<gfx::DrawTargetCapture> mCapture;
+  RefPtr<gfx::DrawTarget> mTarget;
+
+private:
+  ~CapturedPaintState();
+};
+
+/**
+ * A thread that rasterizes the contents of ClientPaintedLayers, so that the
+ * main thread only has to record the drawing commands.
+ *
+ * The main thread hands over the captured commands of a layer after it is
+ * done touching the layer's buffer, and must not touch the buffer again, or
+ * unlock its textures, until WaitForPaints returns. The captures (and the
+ * fonts, paths and surfaces they reference) are only ever released on the
+ * main thread.
+ */
+class PaintThread final
+{
+public:
+  /**
+   * Starts the paint thread if off main thread painting is enabled.
+   */
+  static void Start();
+  static void Shutdown();
+
+  /**
+   * Returns the paint thread, or null if off main thread painting is
+   * disabled. Main thread only.
+   */
+  static PaintThread* Get();
+
+  static bool IsOnPaintThread();
+
+  /**
+   * Replays aStates, in order, into their draw targets on the paint thread.
+   */
+  void PaintContents(nsTArray<RefPtr<CapturedPaintState>>&& aStates);
+
+  /**
+   * Blocks until all the contents passed to PaintContents have been painted.
+   */
+  void WaitForPaints();
+
+  ~PaintThread();
+
+private:
+  PaintThread();
+
+  bool Init();
+
+  static void PaintContentsOnPaintThread(const nsTArray<CapturedPaintState*>& aStates);
+
+  RefPtr<nsIThread> mThread;
+  // States that the paint thread may still be using.
+  nsTArray<RefPtr<CapturedPaintState>> mInFlight;
+};
+
+} // namespace layers
+} // namespace mozilla
+
+#endif // MOZILLA_LAYERS_PAINTTHREAD_H
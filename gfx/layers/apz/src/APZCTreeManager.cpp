@@ -192,6 +192,14 @@ APZCTreeManager::UpdateHitTestingTree(CompositorBridgeParent* aCompositor,
   // We do not support tree structures where the root node has siblings.
   MOZ_ASSERT(!(mRootNode && mRootNode->GetPrevSibling()));
 
+  // Bound the subtrees, so that hit testing can skip the ones that are
+  // nowhere near the point without untransforming it.
+  ForEachNodePostOrder<ReverseIterator>(mRootNode.get(),
+      [] (HitTestingTreeNode* aNode)
+      {
+        aNode->UpdateSubtreeBounds();
+      });
+
   for (size_t i = 0; i < state.mNodesToDestroy.Length(); i++) {
     APZCTM_LOG("Destroying node at %p with APZC %p\n",
         state.mNodesToDestroy[i].get(),
@@ -1680,6 +1688,10 @@ APZCTreeManager::GetAPZCAtPoint(HitTestingTreeNode* aNode,
 
   ForEachNode<ReverseIterator>(root,
       [&hitTestPoints](HitTestingTreeNode* aNode) {
+        if (!aNode->MayHitSubtree(hitTestPoints.top())) {
+          // Nothing in this subtree is anywhere near the point.
+          return TraversalFlag::Skip;
+        }
         if (aNode->IsOutsideClip(hitTestPoints.top())) {
           // If the point being tested is outside the clip region for this node
           // then we don't need to test against this node or any of its children.
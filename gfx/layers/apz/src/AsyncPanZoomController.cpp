@@ -3223,6 +3223,10 @@ AsyncPanZoomController::ReportCheckerboard(const TimeStamp& aSampleTime)
       mCheckerboardEvent->GetPeak());
     mozilla::Telemetry::Accumulate(mozilla::Telemetry::CHECKERBOARD_DURATION,
       (uint32_t)mCheckerboardEvent->GetDuration().ToMilliseconds());
+    mozilla::Telemetry::Accumulate(mozilla::Telemetry::CHECKERBOARD_DEFERRED_TILE_UPLOADS,
+      mCheckerboardEvent->GetDeferredTileUploads());
+    mozilla::Telemetry::Accumulate(mozilla::Telemetry::CHECKERBOARD_MISSED_TILE_UPLOADS,
+      mCheckerboardEvent->GetMissedTileUploads());
 
     mPotentialCheckerboardTracker.CheckerboardDone();
 
@@ -3238,6 +3242,15 @@ AsyncPanZoomController::ReportCheckerboard(const TimeStamp& aSampleTime)
   }
 }
 
+void
+AsyncPanZoomController::ReportTileUploads(uint32_t aDeferred, uint32_t aMissed)
+{
+  MutexAutoLock lock(mCheckerboardEventLock);
+  if (mCheckerboardEvent) {
+    mCheckerboardEvent->RecordTileUploads(aDeferred, aMissed);
+  }
+}
+
 bool AsyncPanZoomController::IsCurrentlyCheckerboarding() const {
   ReentrantMonitorAutoEnter lock(mMonitor);
 
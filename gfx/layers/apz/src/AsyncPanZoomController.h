@@ -234,6 +234,13 @@ public:
    */
   void ReportCheckerboard(const TimeStamp& aSampleTime);
 
+  /**
+   * Report the number of tile uploads of this APZC's content that the
+   * compositor deferred, or had to do over its upload time budget, during
+   * the current composite. These are only recorded while checkerboarding.
+   */
+  void ReportTileUploads(uint32_t aDeferred, uint32_t aMissed);
+
   /**
    * Returns whether or not the APZC is currently in a state of checkerboarding.
    * This is a simple computation based on the last-painted content and whether
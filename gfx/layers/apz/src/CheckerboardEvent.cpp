@@ -40,6 +40,8 @@ CheckerboardEvent::CheckerboardEvent(bool aRecordTrace)
   , mFrameCount(0)
   , mTotalPixelMs(0)
   , mPeakPixels(0)
+  , mDeferredTileUploads(0)
+  , mMissedTileUploads(0)
   , mRendertraceLock("Rendertrace")
 {
 }
@@ -63,6 +65,18 @@ CheckerboardEvent::GetDuration()
   return mEndTime - mStartTime;
 }
 
+uint32_t
+CheckerboardEvent::GetDeferredTileUploads()
+{
+  return mDeferredTileUploads;
+}
+
+uint32_t
+CheckerboardEvent::GetMissedTileUploads()
+{
+  return mMissedTileUploads;
+}
+
 std::string
 CheckerboardEvent::GetLog()
 {
@@ -147,6 +161,16 @@ CheckerboardEvent::RecordFrameInfo(uint32_t aCssPixelsCheckerboarded)
   return eventEnding;
 }
 
+void
+CheckerboardEvent::RecordTileUploads(uint32_t aDeferred, uint32_t aMissed)
+{
+  if (!mCheckerboardingActive) {
+    return;
+  }
+  mDeferredTileUploads += aDeferred;
+  mMissedTileUploads += aMissed;
+}
+
 void
 CheckerboardEvent::StartEvent()
 {
@@ -184,7 +208,9 @@ CheckerboardEvent::StopEvent()
   }
   mRendertraceInfo << "Checkerboarded for " << mFrameCount << " frames ("
     << (mEndTime - mStartTime).ToMilliseconds() << " ms), "
-    << mPeakPixels << " peak, " << GetSeverity() << " severity." << std::endl;
+    << mPeakPixels << " peak, " << GetSeverity() << " severity, "
+    << mDeferredTileUploads << " deferred and " << mMissedTileUploads
+    << " missed tile uploads." << std::endl;
 }
 
 bool
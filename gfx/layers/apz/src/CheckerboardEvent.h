@@ -60,6 +60,20 @@ public:
    */
   TimeDuration GetDuration();
 
+  /**
+   * Gets the number of tile uploads that were deferred to a later composite
+   * during the checkerboard event, because the compositor ran out of upload
+   * time.
+   */
+  uint32_t GetDeferredTileUploads();
+
+  /**
+   * Gets the number of tile uploads that had to be done over the upload time
+   * budget during the checkerboard event, because there was no stale content
+   * to draw in their place.
+   */
+  uint32_t GetMissedTileUploads();
+
   /**
    * Gets the raw log of the checkerboard event. This can be called any time,
    * although it really only makes sense to pull once the event is done, after
@@ -89,6 +103,12 @@ public:
    */
   bool RecordFrameInfo(uint32_t aCssPixelsCheckerboarded);
 
+  /**
+   * Provide the number of deferred and missed tile uploads of a composite.
+   * These are only counted while a checkerboard event is occurring.
+   */
+  void RecordTileUploads(uint32_t aDeferred, uint32_t aMissed);
+
 private:
   /**
    * Helper method to do stuff when checkeboarding starts.
@@ -196,6 +216,14 @@ private:
    * during any one frame, during this checkerboarding event.
    */
   uint32_t mPeakPixels;
+  /**
+   * The number of deferred tile uploads during this checkerboarding event.
+   */
+  uint32_t mDeferredTileUploads;
+  /**
+   * The number of missed tile uploads during this checkerboarding event.
+   */
+  uint32_t mMissedTileUploads;
 
   /**
    * Monitor that needs to be acquired before touching mBufferedProperties
@@ -239,6 +239,52 @@ HitTestingTreeNode::IsOutsideClip(const ParentLayerPoint& aPoint) const
   return (mClipRegion.isSome() && !mClipRegion->Contains(aPoint.x, aPoint.y));
 }
 
+void
+HitTestingTreeNode::UpdateSubtreeBounds()
+{
+  // The hit test rounds or truncates points to test them against the integer
+  // regions, so pad all the bounds by a pixel to stay conservative.
+  Maybe<gfx::Rect> clipBounds;
+  if (mClipRegion) {
+    gfx::Rect clip(mClipRegion->GetBounds().ToUnknownRect());
+    clip.Inflate(1);
+    clipBounds = Some(clip);
+  }
+
+  // The async transform of a scrollable node isn't known until the hit test,
+  // and it can be anything, so only the clip bounds the subtree then.
+  bool bounded = !mApzc && mTransform.Is2D();
+  gfx::Rect contentBounds(mEventRegions.mHitRegion.GetBounds().ToUnknownRect());
+  for (HitTestingTreeNode* child = GetLastChild(); bounded && child;
+       child = child->GetPrevSibling()) {
+    if (!child->mSubtreeBounds) {
+      bounded = false;
+    } else {
+      contentBounds = contentBounds.Union(child->mSubtreeBounds->ToUnknownRect());
+    }
+  }
+
+  if (!bounded) {
+    mSubtreeBounds = clipBounds
+                   ? Some(ParentLayerRect::FromUnknownRect(clipBounds.ref()))
+                   : Nothing();
+    return;
+  }
+
+  contentBounds.Inflate(1);
+  gfx::Rect bounds = mTransform.ToUnknownMatrix().TransformBounds(contentBounds);
+  if (clipBounds) {
+    bounds = bounds.Intersect(clipBounds.ref());
+  }
+  mSubtreeBounds = Some(ParentLayerRect::FromUnknownRect(bounds));
+}
+
+bool
+HitTestingTreeNode::MayHitSubtree(const ParentLayerPoint& aPoint) const
+{
+  return !mSubtreeBounds || mSubtreeBounds->Contains(aPoint);
+}
+
 Maybe<LayerPoint>
 HitTestingTreeNode::Untransform(const ParentLayerPoint& aPoint) const
 {
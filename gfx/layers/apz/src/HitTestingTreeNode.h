@@ -88,6 +88,13 @@ public:
                       const Maybe<ParentLayerIntRegion>& aClipRegion,
                       const EventRegionsOverride& aOverride);
   bool IsOutsideClip(const ParentLayerPoint& aPoint) const;
+  /* Recompute the bounds of this node's subtree from the hit test data and
+   * the subtree bounds of the children, which have to be up to date. */
+  void UpdateSubtreeBounds();
+  /* Returns false if no node of this subtree can be hit at aPoint, which is
+   * in this node's ParentLayerPixels. This is a cheap, conservative test that
+   * lets hit testing skip the subtree before doing any untransforms. */
+  bool MayHitSubtree(const ParentLayerPoint& aPoint) const;
 
   /* Scrollbar info */
 
@@ -155,6 +162,12 @@ private:
    * present. This value is in L's ParentLayerPixels. */
   Maybe<ParentLayerIntRegion> mClipRegion;
 
+  /* The bounds, in L's ParentLayerPixels, of everything in this subtree that
+   * can be hit. These don't move with async scrolling, so the async transform
+   * of a scrollable node makes its subtree unbounded unless it has a clip.
+   * Nothing means unbounded. */
+  Maybe<ParentLayerRect> mSubtreeBounds;
+
   /* Indicates whether or not the event regions on this node need to be
    * overridden in a certain way. */
   EventRegionsOverride mOverride;
@@ -576,3 +576,37 @@ TEST_F(APZHitTestingTester, HitTestingRespectsScrollClip_Bug1257288) {
   // Test that the subframe hasn't scrolled.
   EXPECT_EQ(CSSPoint(0,0), ApzcOf(layers[2], 0)->GetFrameMetrics().GetScrollOffset());
 }
+
+// Hit testing skips the subtrees whose bounds don't contain the point. Make
+// sure that the bounds follow the transforms of unscrollable containers, and
+// the clips of scrollable ones.
+TEST_F(APZHitTestingTester, HitTestingSubtreeBounds) {
+  const char* layerTreeSyntax = "c(c(t)c(t))";
+  // LayerID                     0 1 2 3 4
+  nsIntRegion layerVisibleRegion[] = {
+    nsIntRegion(IntRect(0,0,200,100)),
+    nsIntRegion(IntRect(0,0,100,100)),
+    nsIntRegion(IntRect(0,0,100,100)),
+    nsIntRegion(IntRect(0,0,100,100)),
+    nsIntRegion(IntRect(0,0,100,100)),
+  };
+  Matrix4x4 transforms[] = {
+    Matrix4x4(),
+    Matrix4x4(),
+    Matrix4x4(),
+    Matrix4x4::Translation(100, 0, 0),
+    Matrix4x4(),
+  };
+  root = CreateLayerTree(layerTreeSyntax, layerVisibleRegion, transforms, lm, layers);
+  SetScrollableFrameMetrics(root, FrameMetrics::START_SCROLL_ID, CSSRect(0, 0, 200, 100));
+  SetScrollableFrameMetrics(layers[2], FrameMetrics::START_SCROLL_ID + 1, CSSRect(0, 0, 100, 200));
+  SetScrollableFrameMetrics(layers[4], FrameMetrics::START_SCROLL_ID + 2, CSSRect(0, 0, 100, 200));
+
+  ScopedLayerTreeRegistration registration(manager, 0, root, mcc);
+  manager->UpdateHitTestingTree(nullptr, root, false, 0, 0);
+
+  RefPtr<AsyncPanZoomController> hit = GetTargetAPZC(ScreenPoint(50, 50));
+  EXPECT_EQ(ApzcOf(layers[2]), hit.get());
+  hit = GetTargetAPZC(ScreenPoint(150, 50));
+  EXPECT_EQ(ApzcOf(layers[4]), hit.get());
+}
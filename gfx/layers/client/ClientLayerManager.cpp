@@ -20,6 +20,7 @@
 #include "mozilla/layers/LayersSurfaces.h"  // for SurfaceDescriptor
 #include "mozilla/layers/PLayerChild.h"  // for PLayerChild
 #include "mozilla/layers/LayerTransactionChild.h"
+#include "mozilla/layers/PaintThread.h"
 #include "mozilla/layers/ShadowLayerChild.h"
 #include "mozilla/layers/PersistentBufferProvider.h"
 #include "ClientReadbackLayer.h"        // for ClientReadbackLayer
@@ -124,6 +125,7 @@ ClientLayerManager::~ClientLayerManager()
   // CompositorBridgeChild::Destroy(), the destructor can not handle it correctly.
   // See Bug 1000525.
   mForwarder->StopReceiveAsyncParentMessge();
+  mForwarder->DestroySharedTextureClientRecycler();
   mRoot = nullptr;
 
   MOZ_COUNT_DTOR(ClientLayerManager);
@@ -317,6 +319,10 @@ ClientLayerManager::EndTransactionInternal(DrawPaintedLayerCallback aCallback,
     gfxCriticalNote << "LayerManager::EndTransaction skip RenderLayer().";
   }
 
+  // The textures painted on the paint thread must be unlocked before they are
+  // forwarded.
+  FlushAsyncPaints();
+
   if (!mRepeatTransaction && !GetRoot()->GetInvalidRegion().IsEmpty()) {
     GetRoot()->Mutated();
   }
@@ -723,6 +729,29 @@ ClientLayerManager::Hold(Layer* aLayer)
   return shadowable;
 }
 
+void
+ClientLayerManager::AddPendingEndPaint(ContentClient* aContentClient)
+{
+  MOZ_ASSERT(InDrawing());
+  mPendingEndPaints.AppendElement(aContentClient);
+}
+
+void
+ClientLayerManager::FlushAsyncPaints()
+{
+  if (mPendingEndPaints.IsEmpty()) {
+    return;
+  }
+
+  PaintThread::Get()->WaitForPaints();
+
+  nsTArray<ReadbackProcessor::Update> readbackUpdates;
+  for (ContentClient* contentClient : mPendingEndPaints) {
+    contentClient->EndPaint(&readbackUpdates);
+  }
+  mPendingEndPaints.Clear();
+}
+
 bool
 ClientLayerManager::IsCompositingCheap()
 {
@@ -31,6 +31,7 @@ namespace layers {
 
 class ClientPaintedLayer;
 class CompositorBridgeChild;
+class ContentClient;
 class ImageLayer;
 class PLayerChild;
 class FrameUniformityData;
@@ -107,6 +108,13 @@ public:
 
   ShadowableLayer* Hold(Layer* aLayer);
 
+  /**
+   * Called by painted layers whose contents are being painted on the paint
+   * thread. EndPaint is called on aContentClient once those paints are done,
+   * before the transaction is forwarded.
+   */
+  void AddPendingEndPaint(ContentClient* aContentClient);
+
   bool HasShadowManager() const { return mForwarder->HasShadowManager(); }
 
   virtual bool IsCompositingCheap() override;
@@ -286,8 +294,16 @@ private:
 
   bool DependsOnStaleDevice() const;
 
+  /**
+   * Waits for the paint thread to finish the paints of this transaction and
+   * ends the paints of the content clients that were waiting for them.
+   */
+  void FlushAsyncPaints();
+
   LayerRefArray mKeepAlive;
 
+  nsTArray<RefPtr<ContentClient>> mPendingEndPaints;
+
   nsIWidget* mWidget;
 
   /* PaintedLayer callbacks; valid at the end of a transaciton,
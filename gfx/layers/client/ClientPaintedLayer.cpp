@@ -22,6 +22,7 @@
 #include "nsISupportsImpl.h"            // for Layer::AddRef, etc
 #include "nsRect.h"                     // for mozilla::gfx::IntRect
 #include "gfx2DGlue.h"
+#include "PaintThread.h"
 #include "ReadbackProcessor.h"
 
 namespace mozilla {
@@ -30,7 +31,7 @@ namespace layers {
 using namespace mozilla::gfx;
 
 void
-ClientPaintedLayer::PaintThebes()
+ClientPaintedLayer::PaintThebes(nsTArray<RefPtr<CapturedPaintState>>* aCapturedStates)
 {
   PROFILER_LABEL("ClientPaintedLayer", "PaintThebes",
     js::ProfileEntry::Category::GRAPHICS);
@@ -65,6 +66,14 @@ ClientPaintedLayer::PaintThebes()
   state.mRegionToInvalidate.And(state.mRegionToInvalidate,
                                 GetLocalVisibleRegion().ToUnknownRegion());
 
+  // Component alpha painting copies the background of the buffer into
+  // groups, which a capture can't provide, and native layers can't be
+  // recorded.
+  if (state.mMode == SurfaceMode::SURFACE_COMPONENT_ALPHA ||
+      gfxPrefs::UseNativePushLayer()) {
+    aCapturedStates = nullptr;
+  }
+
   bool didUpdate = false;
   RotatedContentBuffer::DrawIterator iter;
   while (DrawTarget* target = mContentClient->BorrowDrawTargetForPainting(state, &iter)) {
@@ -77,7 +86,20 @@ ClientPaintedLayer::PaintThebes()
     
     SetAntialiasingFlags(this, target);
 
-    RefPtr<gfxContext> ctx = gfxContext::CreatePreservingTransformOrNull(target);
+    RefPtr<DrawTarget> paintTarget = target;
+    if (aCapturedStates) {
+      RefPtr<DrawTargetCapture> capture = target->CreateCaptureDT(target->GetSize());
+      if (capture) {
+        // Record the transform the buffer set up for this quadrant, so that
+        // the replay doesn't depend on the state of the target.
+        capture->SetTransform(target->GetTransform());
+        capture->SetPermitSubpixelAA(target->GetPermitSubpixelAA());
+        aCapturedStates->AppendElement(new CapturedPaintState(capture, target));
+        paintTarget = capture;
+      }
+    }
+
+    RefPtr<gfxContext> ctx = gfxContext::CreatePreservingTransformOrNull(paintTarget);
     MOZ_ASSERT(ctx); // already checked the target above
 
     ClientManager()->GetPaintedLayerCallback()(this,
@@ -134,7 +156,23 @@ ClientPaintedLayer::RenderLayerWithReadback(ReadbackProcessor *aReadback)
 
   IntPoint origin(mVisibleRegion.GetBounds().x, mVisibleRegion.GetBounds().y);
   mContentClient->BeginPaint();
-  PaintThebes();
+
+  // Readback needs the painted contents when EndPaint unlocks the buffer.
+  PaintThread* paintThread = readbackUpdates.IsEmpty() ? PaintThread::Get() : nullptr;
+  if (paintThread) {
+    nsTArray<RefPtr<CapturedPaintState>> capturedStates;
+    PaintThebes(&capturedStates);
+    if (!capturedStates.IsEmpty()) {
+      // The paint thread owns our buffer until the layer manager has waited
+      // for it, so ending the paint, which unlocks our textures, has to wait
+      // until then as well.
+      paintThread->PaintContents(Move(capturedStates));
+      ClientManager()->AddPendingEndPaint(mContentClient);
+      return;
+    }
+  } else {
+    PaintThebes(nullptr);
+  }
   mContentClient->EndPaint(&readbackUpdates);
 }
 
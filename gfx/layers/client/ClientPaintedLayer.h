@@ -21,6 +21,7 @@
 namespace mozilla {
 namespace layers {
 
+class CapturedPaintState;
 class CompositableClient;
 class ShadowableLayer;
 class SpecificLayerAttributes;
@@ -60,7 +61,7 @@ public:
   {
     NS_ASSERTION(ClientManager()->InConstruction(),
                  "Can only set properties in construction phase");
-    mInvalidRegion.Add(aRegion);
+    AddInvalidRegion(aRegion);
     mValidRegion.Sub(mValidRegion, mInvalidRegion.GetRegion());
   }
 
@@ -109,7 +110,12 @@ public:
   }
 
 protected:
-  void PaintThebes();
+  /**
+   * Paints the invalid parts of the layer into its buffer. If aCapturedStates
+   * is non-null, the drawing is recorded into capture draw targets that are
+   * appended to it for the paint thread to replay, when the buffer allows it.
+   */
+  void PaintThebes(nsTArray<RefPtr<CapturedPaintState>>* aCapturedStates);
 
   virtual void PrintInfo(std::stringstream& aStream, const char* aPrefix) override;
 
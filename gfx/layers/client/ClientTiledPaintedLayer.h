@@ -54,7 +54,7 @@ public:
   // PaintedLayer
   virtual Layer* AsLayer() override { return this; }
   virtual void InvalidateRegion(const nsIntRegion& aRegion) override {
-    mInvalidRegion.Add(aRegion);
+    AddInvalidRegion(aRegion);
     nsIntRegion invalidRegion = mInvalidRegion.GetRegion();
     mValidRegion.Sub(mValidRegion, invalidRegion);
     mLowPrecisionValidRegion.Sub(mLowPrecisionValidRegion, invalidRegion);
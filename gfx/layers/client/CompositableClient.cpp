@@ -6,6 +6,7 @@
 #include "mozilla/layers/CompositableClient.h"
 #include <stdint.h>                     // for uint64_t, uint32_t
 #include "gfxPlatform.h"                // for gfxPlatform
+#include "gfxPrefs.h"                   // for gfxPrefs
 #include "mozilla/layers/CompositableChild.h"
 #include "mozilla/layers/CompositableForwarder.h"
 #include "mozilla/layers/ImageBridgeChild.h"
@@ -122,7 +123,8 @@ CompositableClient::Destroy()
     return;
   }
 
-  if (mTextureClientRecycler) {
+  // The shared recycler is destroyed by the forwarder.
+  if (mTextureClientRecycler && !mTextureClientRecycler->IsShared()) {
     mTextureClientRecycler->Destroy();
   }
 
@@ -223,6 +225,11 @@ CompositableClient::GetTextureClientRecycler()
     return nullptr;
   }
 
+  if (gfxPrefs::LayersSharedTextureRecyclerEnabled()) {
+    mTextureClientRecycler = mForwarder->GetSharedTextureClientRecycler();
+    return mTextureClientRecycler;
+  }
+
   if(!mForwarder->GetTextureForwarder()->UsesImageBridge()) {
     MOZ_ASSERT(NS_IsMainThread());
     mTextureClientRecycler = new layers::TextureClientRecycleAllocator(mForwarder);
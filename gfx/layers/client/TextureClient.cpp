@@ -1679,6 +1679,17 @@ UpdateYCbCrTextureClient(TextureClient* aTexture, const PlanarYCbCrData& aData)
     return false;
   }
 
+  // Textures allocated for a size class can be larger than the data, which
+  // then goes into their top-left corner.
+  if (mapped.y.size.width >= aData.mYSize.width &&
+      mapped.y.size.height >= aData.mYSize.height &&
+      mapped.cb.size.width >= aData.mCbCrSize.width &&
+      mapped.cb.size.height >= aData.mCbCrSize.height) {
+    mapped.y.size = aData.mYSize;
+    mapped.cb.size = aData.mCbCrSize;
+    mapped.cr.size = aData.mCbCrSize;
+  }
+
   MappedYCbCrTextureData srcData;
   srcData.y.data = aData.mYChannel;
   srcData.y.size = aData.mYSize;
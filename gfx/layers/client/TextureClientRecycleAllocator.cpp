@@ -3,11 +3,13 @@
 * License, v. 2.0. If a copy of the MPL was not distributed with this
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <iterator>
 #include "gfxPlatform.h"
 #include "ImageContainer.h"
 #include "mozilla/layers/BufferTexture.h"
 #include "mozilla/layers/ISurfaceAllocator.h"
 #include "mozilla/layers/TextureForwarder.h"
+#include "mozilla/TimeStamp.h"
 #include "TextureClientRecycleAllocator.h"
 
 namespace mozilla {
@@ -41,8 +43,12 @@ public:
   }
 
   void ClearTextureClient() { mTextureClient = nullptr; }
+
+  const TimeStamp& GetPooledTime() const { return mPooledTime; }
+  void SetPooledTime(const TimeStamp& aTime) { mPooledTime = aTime; }
 protected:
   RefPtr<TextureClient> mTextureClient;
+  TimeStamp mPooledTime;
   bool mWillRecycle;
 };
 
@@ -86,14 +92,25 @@ protected:
 };
 
 YCbCrTextureClientAllocationHelper::YCbCrTextureClientAllocationHelper(const PlanarYCbCrData& aData,
-                                                                       TextureFlags aTextureFlags)
+                                                                       TextureFlags aTextureFlags,
+                                                                       bool aUseSizeClasses)
   : ITextureClientAllocationHelper(gfx::SurfaceFormat::YUV,
-                                   aData.mYSize,
+                                   aUseSizeClasses
+                                   ? TextureClientRecycleAllocator::RoundUpToSizeClass(aData.mYSize)
+                                   : aData.mYSize,
                                    BackendSelector::Content,
                                    aTextureFlags,
                                    ALLOC_DEFAULT)
   , mData(aData)
+  , mCbCrSize(aData.mCbCrSize)
 {
+  if (aUseSizeClasses) {
+    // Keep the chroma subsampling of the data. The size classes are even, so
+    // this covers the rounded up chroma planes of odd sizes as well.
+    int32_t xShift = aData.mCbCrSize.width < aData.mYSize.width ? 1 : 0;
+    int32_t yShift = aData.mCbCrSize.height < aData.mYSize.height ? 1 : 0;
+    mCbCrSize = gfx::IntSize(mSize.width >> xShift, mSize.height >> yShift);
+  }
 }
 
 bool
@@ -103,9 +120,9 @@ YCbCrTextureClientAllocationHelper::IsCompatible(TextureClient* aTextureClient)
 
   BufferTextureData* bufferData = aTextureClient->GetInternalData()->AsBufferTextureData();
   if (!bufferData ||
-      aTextureClient->GetSize() != mData.mYSize ||
+      aTextureClient->GetSize() != mSize ||
       bufferData->GetCbCrSize().isNothing() ||
-      bufferData->GetCbCrSize().ref() != mData.mCbCrSize ||
+      bufferData->GetCbCrSize().ref() != mCbCrSize ||
       bufferData->GetStereoMode().isNothing() ||
       bufferData->GetStereoMode().ref() != mData.mStereoMode) {
     return false;
@@ -117,14 +134,16 @@ already_AddRefed<TextureClient>
 YCbCrTextureClientAllocationHelper::Allocate(KnowsCompositor* aAllocator)
 {
   return TextureClient::CreateForYCbCr(aAllocator,
-                                       mData.mYSize, mData.mCbCrSize,
+                                       mSize, mCbCrSize,
                                        mData.mStereoMode,
                                        mTextureFlags);
 }
 
-TextureClientRecycleAllocator::TextureClientRecycleAllocator(KnowsCompositor* aAllocator)
+TextureClientRecycleAllocator::TextureClientRecycleAllocator(KnowsCompositor* aAllocator,
+                                                             bool aShared)
   : mSurfaceAllocator(aAllocator)
-  , mMaxPooledSize(kMaxPooledSized)
+  , mMaxPooledSize(aShared ? kMaxSharedPooledSize : kMaxPooledSized)
+  , mShared(aShared)
   , mLock("TextureClientRecycleAllocatorImp.mLock")
   , mIsDestroyed(false)
 {
@@ -133,9 +152,7 @@ TextureClientRecycleAllocator::TextureClientRecycleAllocator(KnowsCompositor* aA
 TextureClientRecycleAllocator::~TextureClientRecycleAllocator()
 {
   MutexAutoLock lock(mLock);
-  while (!mPooledClients.empty()) {
-    mPooledClients.pop();
-  }
+  mPooledClients.clear();
   MOZ_ASSERT(mInUseClients.empty());
 }
 
@@ -145,6 +162,36 @@ TextureClientRecycleAllocator::SetMaxPoolSize(uint32_t aMax)
   mMaxPooledSize = aMax;
 }
 
+/* static */ gfx::IntSize
+TextureClientRecycleAllocator::RoundUpToSizeClass(const gfx::IntSize& aSize)
+{
+  auto roundUp = [](int32_t aLength) -> int32_t {
+    return (aLength + kSizeClassGranularity - 1) / kSizeClassGranularity *
+           kSizeClassGranularity;
+  };
+  return gfx::IntSize(roundUp(aSize.width), roundUp(aSize.height));
+}
+
+void
+TextureClientRecycleAllocator::ReleaseTextureClient(TextureClientHolder* aHolder)
+{
+  RefPtr<Runnable> task = new TextureClientReleaseTask(aHolder->GetTextureClient());
+  aHolder->ClearTextureClient();
+  mSurfaceAllocator->GetTextureForwarder()->GetMessageLoop()->PostTask(task.forget());
+}
+
+void
+TextureClientRecycleAllocator::ExpirePooledClients(const MutexAutoLock& aProofOfLock)
+{
+  TimeStamp expiry = TimeStamp::Now() -
+    TimeDuration::FromMilliseconds(kMaxSharedPooledAgeMs);
+  while (!mPooledClients.empty() &&
+         mPooledClients.front()->GetPooledTime() < expiry) {
+    ReleaseTextureClient(mPooledClients.front());
+    mPooledClients.pop_front();
+  }
+}
+
 already_AddRefed<TextureClient>
 TextureClientRecycleAllocator::CreateOrRecycle(gfx::SurfaceFormat aFormat,
                                                gfx::IntSize aSize,
@@ -180,16 +227,26 @@ TextureClientRecycleAllocator::CreateOrRecycle(ITextureClientAllocationHelper& a
     if (mIsDestroyed) {
       return nullptr;
     }
-    if (!mPooledClients.empty()) {
-      textureHolder = mPooledClients.top();
-      mPooledClients.pop();
+    if (mShared) {
+      ExpirePooledClients(lock);
+      // Other compositables may want the incompatible clients, so only take
+      // the most recently pooled compatible one.
+      for (auto it = mPooledClients.rbegin(); it != mPooledClients.rend(); ++it) {
+        if (aHelper.IsCompatible((*it)->GetTextureClient())) {
+          textureHolder = *it;
+          mPooledClients.erase(std::next(it).base());
+          textureHolder->GetTextureClient()->RecycleTexture(aHelper.mTextureFlags);
+          break;
+        }
+      }
+    } else if (!mPooledClients.empty()) {
+      textureHolder = mPooledClients.back();
+      mPooledClients.pop_back();
       // If a pooled TextureClient is not compatible, release it.
       if (!aHelper.IsCompatible(textureHolder->GetTextureClient())) {
         // Release TextureClient.
-        RefPtr<Runnable> task = new TextureClientReleaseTask(textureHolder->GetTextureClient());
-        textureHolder->ClearTextureClient();
+        ReleaseTextureClient(textureHolder);
         textureHolder = nullptr;
-        mSurfaceAllocator->GetTextureForwarder()->GetMessageLoop()->PostTask(task.forget());
       } else {
         textureHolder->GetTextureClient()->RecycleTexture(aHelper.mTextureFlags);
       }
@@ -234,8 +291,11 @@ void
 TextureClientRecycleAllocator::ShrinkToMinimumSize()
 {
   MutexAutoLock lock(mLock);
-  while (!mPooledClients.empty()) {
-    mPooledClients.pop();
+  mPooledClients.clear();
+  if (mShared) {
+    // The clients in use belong to other compositables as well, which may
+    // still want to recycle them.
+    return;
   }
   // We can not clear using TextureClients safely.
   // Just clear WillRecycle here.
@@ -250,9 +310,7 @@ void
 TextureClientRecycleAllocator::Destroy()
 {
   MutexAutoLock lock(mLock);
-  while (!mPooledClients.empty()) {
-    mPooledClients.pop();
-  }
+  mPooledClients.clear();
   mIsDestroyed = true;
 }
 
@@ -269,9 +327,19 @@ TextureClientRecycleAllocator::RecycleTextureClient(TextureClient* aClient)
     MutexAutoLock lock(mLock);
     if (mInUseClients.find(aClient) != mInUseClients.end()) {
       textureHolder = mInUseClients[aClient]; // Keep reference count of TextureClientHolder within lock.
+      if (mShared && !mIsDestroyed) {
+        ExpirePooledClients(lock);
+        if (textureHolder->WillRecycle() && !mPooledClients.empty() &&
+            mPooledClients.size() >= mMaxPooledSize) {
+          // Make room by dropping the least recently pooled client.
+          ReleaseTextureClient(mPooledClients.front());
+          mPooledClients.pop_front();
+        }
+      }
       if (textureHolder->WillRecycle() &&
           !mIsDestroyed && mPooledClients.size() < mMaxPooledSize) {
-        mPooledClients.push(textureHolder);
+        textureHolder->SetPooledTime(TimeStamp::Now());
+        mPooledClients.push_back(textureHolder);
       }
       mInUseClients.erase(aClient);
     }
@@ -6,8 +6,8 @@
 #ifndef MOZILLA_GFX_TEXTURECLIENT_RECYCLE_ALLOCATOR_H
 #define MOZILLA_GFX_TEXTURECLIENT_RECYCLE_ALLOCATOR_H
 
+#include <deque>
 #include <map>
-#include <stack>
 #include "mozilla/gfx/Types.h"
 #include "mozilla/layers/TextureForwarder.h"
 #include "mozilla/RefPtr.h"
@@ -58,11 +58,19 @@ public:
   const TextureAllocationFlags mAllocationFlags;
 };
 
+/**
+ * Allocates YCbCr TextureClients for aData. With aUseSizeClasses, the planes
+ * are rounded up to the size classes of
+ * TextureClientRecycleAllocator::RoundUpToSizeClass, so that the clients can
+ * be recycled across small size changes. The data then only covers the
+ * top-left part of the planes, and the picture rect selects it.
+ */
 class YCbCrTextureClientAllocationHelper : public ITextureClientAllocationHelper
 {
 public:
   YCbCrTextureClientAllocationHelper(const PlanarYCbCrData& aData,
-                                     TextureFlags aTextureFlags);
+                                     TextureFlags aTextureFlags,
+                                     bool aUseSizeClasses = false);
 
   bool IsCompatible(TextureClient* aTextureClient) override;
 
@@ -70,6 +78,7 @@ public:
 
 protected:
   const PlanarYCbCrData& mData;
+  gfx::IntSize mCbCrSize;
 };
 
 
@@ -79,6 +88,12 @@ protected:
  * attributres. If a recycled TextureClient is different from
  * requested one, the recycled one is dropped and new TextureClient is allocated.
  *
+ * A shared allocator, see CompositableForwarder::GetSharedTextureClientRecycler,
+ * serves the compositables of a whole forwarder instead, so it has to expect
+ * different sizes: it keeps the pooled TextureClients that don't match a
+ * request for others, and drops them once they have been pooled for too long,
+ * or on memory pressure.
+ *
  * By default this uses TextureClient::CreateForDrawing to allocate new texture
  * clients.
  */
@@ -88,10 +103,19 @@ protected:
   virtual ~TextureClientRecycleAllocator();
 
 public:
-  explicit TextureClientRecycleAllocator(KnowsCompositor* aAllocator);
+  explicit TextureClientRecycleAllocator(KnowsCompositor* aAllocator,
+                                         bool aShared = false);
 
   void SetMaxPoolSize(uint32_t aMax);
 
+  bool IsShared() const { return mShared; }
+
+  /**
+   * Rounds aSize up to the granularity that shared allocators recycle
+   * TextureClients at.
+   */
+  static gfx::IntSize RoundUpToSizeClass(const gfx::IntSize& aSize);
+
   // Creates and allocates a TextureClient.
   already_AddRefed<TextureClient>
   CreateOrRecycle(gfx::SurfaceFormat aFormat,
@@ -120,16 +144,29 @@ protected:
   friend class DefaultTextureClientAllocationHelper;
   void RecycleTextureClient(TextureClient* aClient) override;
 
+  // Releases the TextureClient of aHolder on the forwarder's thread.
+  void ReleaseTextureClient(TextureClientHolder* aHolder);
+
+  // Drops the pooled clients of a shared allocator that have not been used
+  // for kMaxSharedPooledAgeMs.
+  void ExpirePooledClients(const MutexAutoLock& aProofOfLock);
+
   static const uint32_t kMaxPooledSized = 2;
+  static const uint32_t kMaxSharedPooledSize = 16;
+  static const uint32_t kMaxSharedPooledAgeMs = 1000;
+  static const int32_t kSizeClassGranularity = 64;
   uint32_t mMaxPooledSize;
+  const bool mShared;
 
   std::map<TextureClient*, RefPtr<TextureClientHolder> > mInUseClients;
 
   // On b2g gonk, std::queue might be a better choice.
   // On ICS, fence wait happens implicitly before drawing.
   // Since JB, fence wait happens explicitly when fetching a client from the pool.
-  // stack is good from Graphics cache usage point of view.
-  std::stack<RefPtr<TextureClientHolder> > mPooledClients;
+  // stack is good from Graphics cache usage point of view, so this is used as
+  // one, with the most recently pooled client at the back. Shared allocators
+  // expire the oldest ones from the front.
+  std::deque<RefPtr<TextureClientHolder> > mPooledClients;
   Mutex mLock;
   bool mIsDestroyed;
 };
@@ -14,6 +14,7 @@
 #include "gfxPrefs.h"                   // for gfxPrefs
 #include "gfxRect.h"                    // for gfxRect
 #include "mozilla/MathAlgorithms.h"     // for Abs
+#include "mozilla/gfx/JobScheduler.h"   // for JobScheduler
 #include "mozilla/gfx/Point.h"          // for IntSize
 #include "mozilla/gfx/Rect.h"           // for Rect
 #include "mozilla/gfx/Tools.h"          // for BytesPerPixel
@@ -983,13 +984,27 @@ void ClientMultiTiledLayerBuffer::Update(const nsIntRegion& newValidRegion,
       }
       drawTarget->SetTransform(Matrix());
 
-      RefPtr<gfxContext> ctx = gfxContext::CreateOrNull(drawTarget);
+      // With several tiles to paint and the JobScheduler running, record the
+      // layer once and let the worker threads rasterize the tiles.
+      RefPtr<DrawTargetCapture> capture;
+      if (mMoz2DTiles.size() > 1 && JobScheduler::IsEnabled() &&
+          !gfxPrefs::UseNativePushLayer()) {
+        capture = drawTarget->CreateCaptureDT(drawTarget->GetSize());
+      }
+      DrawTarget* paintTarget = capture ? capture.get() : drawTarget.get();
+
+      RefPtr<gfxContext> ctx = gfxContext::CreateOrNull(paintTarget);
       MOZ_ASSERT(ctx); // already checked the draw target above
       ctx->SetMatrix(
         ctx->CurrentMatrix().Scale(mResolution, mResolution).Translate(ThebesPoint(-mTilingOrigin)));
 
       mCallback(&mPaintedLayer, ctx, aPaintRegion, aDirtyRegion,
                 DrawRegionClip::DRAW, nsIntRegion(), mCallbackData);
+      ctx = nullptr;
+
+      if (capture) {
+        drawTarget->DrawCapturedDT(capture, Matrix());
+      }
       mMoz2DTiles.clear();
       // Reset:
       mTilingOrigin = IntPoint(std::numeric_limits<int32_t>::max(),
@@ -800,6 +800,12 @@ BufferTextureHost::GetFormat() const
   return mFormat;
 }
 
+bool
+BufferTextureHost::HasPendingUpload() const
+{
+  return !mFirstSource || mFirstSource->GetUpdateSerial() != mUpdateSerial;
+}
+
 bool
 BufferTextureHost::MaybeUpload(nsIntRegion *aRegion)
 {
@@ -570,6 +570,12 @@ public:
    */
   virtual bool HasIntermediateBuffer() const { return false; }
 
+  /**
+   * Returns true if locking the TextureHost will upload new content to its
+   * texture source, so that callers can decide when to pay for the upload.
+   */
+  virtual bool HasPendingUpload() const { return false; }
+
   void AddCompositableRef() { ++mCompositableCount; }
 
   void ReleaseCompositableRef()
@@ -707,6 +713,8 @@ public:
 
   virtual bool HasIntermediateBuffer() const override { return mHasIntermediateBuffer; }
 
+  virtual bool HasPendingUpload() const override;
+
   virtual BufferTextureHost* AsBufferTextureHost() override { return this; }
 
   const BufferDescriptor& GetBufferDescriptor() const { return mDescriptor; }
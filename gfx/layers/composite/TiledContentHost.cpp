@@ -4,6 +4,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "TiledContentHost.h"
+#include "apz/src/AsyncPanZoomController.h"  // for AsyncPanZoomController
 #include "gfxPrefs.h"                   // for gfxPrefs
 #include "PaintedLayerComposite.h"      // for PaintedLayerComposite
 #include "mozilla/gfx/BaseSize.h"       // for BaseSize
@@ -16,9 +17,11 @@
 #include "mozilla/layers/TextureHostOGL.h"  // for TextureHostOGL
 #include "nsAString.h"
 #include "nsDebug.h"                    // for NS_WARNING
+#include "nsHashKeys.h"                 // for nsPtrHashKey
 #include "nsPoint.h"                    // for IntPoint
 #include "nsPrintfCString.h"            // for nsPrintfCString
 #include "nsRect.h"                     // for IntRect
+#include "nsTHashtable.h"               // for nsTHashtable
 #include "mozilla/layers/TextureClient.h"
 
 namespace mozilla {
@@ -73,9 +76,10 @@ void
 TiledLayerBufferComposite::AddAnimationInvalidation(nsIntRegion& aRegion)
 {
   // We need to invalidate rects where we have a tile that is in the
-  // process of fading in.
+  // process of fading in, or that still shows its stale contents.
   for (size_t i = 0; i < mRetainedTiles.Length(); i++) {
-    if (!mRetainedTiles[i].mFadeStart.IsNull()) {
+    if (!mRetainedTiles[i].mFadeStart.IsNull() ||
+        mRetainedTiles[i].mStaleTextureHost) {
       TileIntPoint position = mTiles.TilePosition(i);
       IntPoint offset = GetTileOffset(position);
       nsIntRegion tileRegion = IntRect(offset, GetScaledTileSize());
@@ -241,6 +245,31 @@ public:
     }
   }
 
+  // Keeps the previous contents of the tile that used to be at aOldIndex
+  // around in aTile, so that they can be drawn until aTile's new contents
+  // are uploaded. This only works if the old contents are uploaded, and if
+  // no tile in the new set uses the old texture host.
+  void RecycleStaleTexture(size_t aOldIndex, TileHost& aTile,
+                           const nsTHashtable<nsPtrHashKey<TextureHost>>& aUsedHosts) {
+    TileHost& oldTile = mTiles[aOldIndex];
+    if (oldTile.IsPlaceholderTile() || oldTile.mTextureHostOnWhite) {
+      return;
+    }
+
+    if (oldTile.mTextureSource &&
+        !oldTile.mTextureHost->HasPendingUpload() &&
+        !aUsedHosts.Contains(oldTile.mTextureHost)) {
+      aTile.mStaleTextureHost = oldTile.mTextureHost;
+      aTile.mStaleTextureSource = Move(oldTile.mTextureSource);
+    } else if (oldTile.mStaleTextureHost &&
+               !aUsedHosts.Contains(oldTile.mStaleTextureHost)) {
+      // The old tile was still waiting for its upload, carry its stale
+      // contents over.
+      aTile.mStaleTextureHost = oldTile.mStaleTextureHost;
+      aTile.mStaleTextureSource = Move(oldTile.mStaleTextureSource);
+    }
+  }
+
   void RecycleTileFading(TileHost& aTile) {
     for (size_t i = 0; i < mTiles.Length(); i++) {
       if (mTiles[i].mTextureHost == aTile.mTextureHost) {
@@ -338,6 +367,40 @@ TiledLayerBufferComposite::UseTiles(const SurfaceDescriptorTiles& aTiles,
     }
   }
 
+  // Step 1b, when tile uploads are budgeted, keep the old contents of updated
+  // tiles around so that they can be drawn until the new contents are
+  // uploaded. This has to happen before step 2 recycles the old texture
+  // sources.
+  if (gfxPrefs::LayersTilesUploadBudgetMs() > 0 &&
+      aTiles.tileOrigin() == mTileOrigin) {
+    nsTHashtable<nsPtrHashKey<TextureHost>> usedHosts(mRetainedTiles.Length());
+    for (const TileHost& tile : mRetainedTiles) {
+      if (tile.mTextureHost) {
+        usedHosts.PutEntry(tile.mTextureHost);
+      }
+    }
+
+    for (size_t i = 0; i < mRetainedTiles.Length(); i++) {
+      TileHost& tile = mRetainedTiles[i];
+      if (!tile.mTextureHost || tile.mTextureHostOnWhite) {
+        continue;
+      }
+
+      const TexturedTileDescriptor& texturedDesc =
+        tileDescriptors[i].get_TexturedTileDescriptor();
+      if (texturedDesc.updateRect().IsEmpty() &&
+          !tile.mTextureHost->HasPendingUpload()) {
+        continue;
+      }
+
+      // mTiles still describes the old tile set at this point.
+      if (mTiles.HasTile(tile.mTilePosition)) {
+        oldRetainedTiles.RecycleStaleTexture(mTiles.TileIndex(tile.mTilePosition),
+                                             tile, usedHosts);
+      }
+    }
+  }
+
   // Step 2, attempt to recycle unused texture sources from the old tile set into new tiles.
   //
   // For gralloc, binding a new TextureHost to the existing TextureSource is the fastest way
@@ -371,6 +434,11 @@ TiledLayerBufferComposite::UseTiles(const SurfaceDescriptorTiles& aTiles,
                      texturedDesc.updateRect(),
                      aCompositor);
     }
+
+    if (tile.mStaleTextureHost && !tile.mTextureHost->HasPendingUpload()) {
+      // Nothing to wait for, e.g. the texture host doesn't need uploads.
+      tile.ClearStaleTexture();
+    }
   }
 
   mTiles = newTiles;
@@ -442,6 +510,10 @@ TiledContentHost::Composite(LayerComposite* aLayer,
   }
 #endif
 
+  if (gfxPrefs::LayersTilesUploadBudgetMs() > 0) {
+    UploadTiles(aTransform, aClipRect, *renderRegion);
+  }
+
   // Render the low and high precision buffers.
   RenderLayerBuffer(mLowPrecisionTiledBuffer,
                     lowPrecisionOpacityReduction < 1.0f ? &backgroundColor : nullptr,
@@ -452,6 +524,120 @@ TiledContentHost::Composite(LayerComposite* aLayer,
 }
 
 
+void
+TiledContentHost::UploadTiles(const gfx::Matrix4x4& aTransform,
+                              const gfx::IntRect& aClipRect,
+                              const nsIntRegion& aVisibleRegion)
+{
+  // The part of the layer that is on screen. For scrolled content, the clip
+  // is the composition bounds of the scroll frame.
+  Rect visibleRect(aVisibleRegion.GetBounds());
+  Matrix4x4 inverse = aTransform;
+  if (inverse.Invert()) {
+    visibleRect = inverse.ProjectRectBounds(Rect(aClipRect), visibleRect);
+  }
+
+  AsyncPanZoomController* apzc = nullptr;
+  for (LayerMetricsWrapper ancestor(GetLayer(), LayerMetricsWrapper::StartAt::BOTTOM); ancestor; ancestor = ancestor.GetParent()) {
+    if (ancestor.Metrics().IsScrollable()) {
+      CSSPoint scrollOffset = ancestor.Metrics().GetScrollOffset();
+      CSSPoint delta = scrollOffset - mLastScrollOffset;
+      if (delta != CSSPoint()) {
+        mScrollDirection = Point(delta.x > 0 ? 1 : (delta.x < 0 ? -1 : 0),
+                                 delta.y > 0 ? 1 : (delta.y < 0 ? -1 : 0));
+      }
+      mLastScrollOffset = scrollOffset;
+      apzc = ancestor.GetApzc();
+      break;
+    }
+  }
+
+  // The content that is scrolled into view next comes in at this point.
+  Point leadingEdge = visibleRect.Center() +
+    Point(mScrollDirection.x * visibleRect.width / 2,
+          mScrollDirection.y * visibleRect.height / 2);
+
+  uint32_t deferredUploads = 0;
+  uint32_t missedUploads = 0;
+  UploadLayerBufferTiles(mTiledBuffer, visibleRect, leadingEdge,
+                         deferredUploads, missedUploads);
+  UploadLayerBufferTiles(mLowPrecisionTiledBuffer, visibleRect, leadingEdge,
+                         deferredUploads, missedUploads);
+
+  if (deferredUploads) {
+    // Make sure that there is a next composition to upload the rest.
+    mCompositor->CompositeUntil(TimeStamp::Now());
+  }
+  if (apzc && (deferredUploads || missedUploads)) {
+    apzc->ReportTileUploads(deferredUploads, missedUploads);
+  }
+}
+
+void
+TiledContentHost::UploadLayerBufferTiles(TiledLayerBufferComposite& aLayerBuffer,
+                                         const gfx::Rect& aVisibleRect,
+                                         const gfx::Point& aLeadingEdge,
+                                         uint32_t& aDeferredUploads,
+                                         uint32_t& aMissedUploads)
+{
+  struct PendingUpload {
+    size_t mIndex;
+    bool mVisible;
+    float mDistance;
+  };
+
+  nsTArray<PendingUpload> pendingUploads;
+  for (size_t i = 0; i < aLayerBuffer.GetTileCount(); ++i) {
+    TileHost& tile = aLayerBuffer.GetTile(i);
+    if (tile.IsPlaceholderTile() ||
+        !(tile.mTextureHost->HasPendingUpload() ||
+          (tile.mTextureHostOnWhite && tile.mTextureHostOnWhite->HasPendingUpload()))) {
+      continue;
+    }
+
+    IntPoint tileOffset = aLayerBuffer.GetTileOffset(tile.mTilePosition);
+    Rect tileRect(IntRect(tileOffset, aLayerBuffer.GetScaledTileSize()));
+    Point toLeadingEdge = tileRect.Center() - aLeadingEdge;
+    PendingUpload upload = { i, tileRect.Intersects(aVisibleRect),
+                             toLeadingEdge.x * toLeadingEdge.x +
+                             toLeadingEdge.y * toLeadingEdge.y };
+    pendingUploads.AppendElement(upload);
+  }
+
+  // Visible tiles first, then the ones closest to where the content is
+  // scrolling in from.
+  std::sort(pendingUploads.begin(), pendingUploads.end(),
+            [](const PendingUpload& aA, const PendingUpload& aB) {
+    if (aA.mVisible != aB.mVisible) {
+      return aA.mVisible;
+    }
+    return aA.mDistance < aB.mDistance;
+  });
+
+  TimeDuration budget =
+    TimeDuration::FromMilliseconds(gfxPrefs::LayersTilesUploadBudgetMs());
+  for (const PendingUpload& upload : pendingUploads) {
+    TileHost& tile = aLayerBuffer.GetTile(upload.mIndex);
+    if (mCompositor->GetTileUploadTime() >= budget) {
+      if (tile.mStaleTextureHost) {
+        aDeferredUploads++;
+        continue;
+      }
+      // There is nothing else to draw for this tile.
+      aMissedUploads++;
+    }
+
+    TimeStamp start = TimeStamp::Now();
+    {
+      // Locking the texture hosts does the upload.
+      AutoLockTextureHost autoLock(tile.mTextureHost);
+      AutoLockTextureHost autoLockOnWhite(tile.mTextureHostOnWhite);
+    }
+    mCompositor->AddTileUploadTime(TimeStamp::Now() - start);
+    tile.ClearStaleTexture();
+  }
+}
+
 void
 TiledContentHost::RenderTile(TileHost& aTile,
                              EffectChain& aEffectChain,
@@ -466,7 +652,20 @@ TiledContentHost::RenderTile(TileHost& aTile,
 {
   MOZ_ASSERT(!aTile.IsPlaceholderTile());
 
-  AutoLockTextureHost autoLock(aTile.mTextureHost);
+  if (aTile.mStaleTextureHost &&
+      (!aTile.mTextureHost->HasPendingUpload() ||
+       gfxPrefs::LayersTilesUploadBudgetMs() == 0)) {
+    aTile.ClearStaleTexture();
+  }
+
+  // While its upload is deferred, draw the previous contents of the tile
+  // instead, as locking the texture host would upload it.
+  CompositableTextureHostRef& textureHost =
+    aTile.mStaleTextureHost ? aTile.mStaleTextureHost : aTile.mTextureHost;
+  CompositableTextureSourceRef& textureSource =
+    aTile.mStaleTextureHost ? aTile.mStaleTextureSource : aTile.mTextureSource;
+
+  AutoLockTextureHost autoLock(textureHost);
   AutoLockTextureHost autoLockOnWhite(aTile.mTextureHostOnWhite);
   if (autoLock.Failed() ||
       autoLockOnWhite.Failed()) {
@@ -474,7 +673,7 @@ TiledContentHost::RenderTile(TileHost& aTile,
     return;
   }
 
-  if (!aTile.mTextureHost->BindTextureSource(aTile.mTextureSource)) {
+  if (!textureHost->BindTextureSource(textureSource)) {
     return;
   }
 
@@ -483,11 +682,11 @@ TiledContentHost::RenderTile(TileHost& aTile,
   }
 
   RefPtr<TexturedEffect> effect =
-    CreateTexturedEffect(aTile.mTextureSource,
+    CreateTexturedEffect(textureSource,
                          aTile.mTextureSourceOnWhite,
                          aSamplingFilter,
                          true,
-                         aTile.mTextureHost->GetRenderState());
+                         textureHost->GetRenderState());
   if (!effect) {
     return;
   }
@@ -70,6 +70,8 @@ public:
     mTextureHostOnWhite = o.mTextureHostOnWhite;
     mTextureSource = o.mTextureSource;
     mTextureSourceOnWhite = o.mTextureSourceOnWhite;
+    mStaleTextureHost = o.mStaleTextureHost;
+    mStaleTextureSource = o.mStaleTextureSource;
     mTilePosition = o.mTilePosition;
   }
   TileHost& operator=(const TileHost& o) {
@@ -80,6 +82,8 @@ public:
     mTextureHostOnWhite = o.mTextureHostOnWhite;
     mTextureSource = o.mTextureSource;
     mTextureSourceOnWhite = o.mTextureSourceOnWhite;
+    mStaleTextureHost = o.mStaleTextureHost;
+    mStaleTextureSource = o.mStaleTextureSource;
     mTilePosition = o.mTilePosition;
     return *this;
   }
@@ -110,10 +114,21 @@ public:
    */
   float GetFadeInOpacity(float aOpacity);
 
+  void ClearStaleTexture() {
+    mStaleTextureHost = nullptr;
+    mStaleTextureSource = nullptr;
+  }
+
   CompositableTextureHostRef mTextureHost;
   CompositableTextureHostRef mTextureHostOnWhite;
   mutable CompositableTextureSourceRef mTextureSource;
   mutable CompositableTextureSourceRef mTextureSourceOnWhite;
+  // The previous contents of this tile, which are drawn instead of
+  // mTextureHost while its upload is deferred by the tile upload budget (see
+  // 'layers.tiles.upload-budget-ms'). The stale texture host is never used by
+  // another tile of the same buffer, so its texture source is left untouched.
+  CompositableTextureHostRef mStaleTextureHost;
+  mutable CompositableTextureSourceRef mStaleTextureSource;
   // This is not strictly necessary but makes debugging whole lot easier.
   TileIntPoint mTilePosition;
   TimeStamp mFadeStart;
@@ -263,6 +278,20 @@ public:
 
 private:
 
+  // Uploads the pending tile textures of both buffers, most important tiles
+  // first, until the compositor's tile upload budget for this composition is
+  // spent. Tiles that still have their previous contents around are left to
+  // a later composition after that.
+  void UploadTiles(const gfx::Matrix4x4& aTransform,
+                   const gfx::IntRect& aClipRect,
+                   const nsIntRegion& aVisibleRegion);
+
+  void UploadLayerBufferTiles(TiledLayerBufferComposite& aLayerBuffer,
+                              const gfx::Rect& aVisibleRect,
+                              const gfx::Point& aLeadingEdge,
+                              uint32_t& aDeferredUploads,
+                              uint32_t& aMissedUploads);
+
   void RenderLayerBuffer(TiledLayerBufferComposite& aLayerBuffer,
                          const gfx::Color* aBackgroundColor,
                          EffectChain& aEffectChain,
@@ -288,6 +317,11 @@ private:
 
   TiledLayerBufferComposite    mTiledBuffer;
   TiledLayerBufferComposite    mLowPrecisionTiledBuffer;
+  // The scroll offset of the nearest scrollable ancestor at the last
+  // composition, and the direction it last moved in, to upload the tiles
+  // that are about to be scrolled into view first.
+  CSSPoint                     mLastScrollOffset;
+  gfx::Point                   mScrollDirection;
 };
 
 } // namespace layers
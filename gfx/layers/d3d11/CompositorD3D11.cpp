@@ -1184,6 +1184,30 @@ CompositorD3D11::ForcePresent()
   }
 }
 
+void
+CompositorD3D11::WaitForGPU()
+{
+  RefPtr<ID3D11Query> query;
+  CD3D11_QUERY_DESC desc(D3D11_QUERY_EVENT);
+  mDevice->CreateQuery(&desc, getter_AddRefs(query));
+  if (!query) {
+    return;
+  }
+  mContext->End(query);
+
+  TimeStamp start = TimeStamp::Now();
+  BOOL result;
+  while (mContext->GetData(query, &result, sizeof(BOOL), 0) != S_OK) {
+    if (mDevice->GetDeviceRemovedReason() != S_OK) {
+      break;
+    }
+    if ((TimeStamp::Now() - start) > TimeDuration::FromSeconds(2)) {
+      break;
+    }
+    Sleep(0);
+  }
+}
+
 void
 CompositorD3D11::PrepareViewport(const gfx::IntSize& aSize,
                                  const gfx::Matrix4x4& aProjection,
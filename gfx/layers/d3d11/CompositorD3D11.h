@@ -140,6 +140,8 @@ public:
 
   virtual void ForcePresent();
 
+  virtual void WaitForGPU() override;
+
   ID3D11Device* GetDevice() { return mDevice; }
 
   ID3D11DeviceContext* GetDC() { return mContext; }
@@ -6,10 +6,16 @@
 
 #include "CompositableForwarder.h"
 #include "mozilla/layers/CompositableChild.h"
+#include "mozilla/layers/TextureClientRecycleAllocator.h"
 
 namespace mozilla {
 namespace layers {
 
+CompositableForwarder::CompositableForwarder()
+  : mSharedTextureClientRecyclerLock("CompositableForwarder.mSharedTextureClientRecyclerLock")
+{
+}
+
 void
 CompositableForwarder::Destroy(CompositableChild* aCompositable)
 {
@@ -24,5 +30,29 @@ CompositableForwarder::Destroy(CompositableChild* aCompositable)
   }
 }
 
+TextureClientRecycleAllocator*
+CompositableForwarder::GetSharedTextureClientRecycler()
+{
+  MutexAutoLock lock(mSharedTextureClientRecyclerLock);
+  if (!mSharedTextureClientRecycler) {
+    mSharedTextureClientRecycler =
+      new TextureClientRecycleAllocator(this, /* aShared = */ true);
+  }
+  return mSharedTextureClientRecycler;
+}
+
+void
+CompositableForwarder::DestroySharedTextureClientRecycler()
+{
+  RefPtr<TextureClientRecycleAllocator> recycler;
+  {
+    MutexAutoLock lock(mSharedTextureClientRecyclerLock);
+    recycler = mSharedTextureClientRecycler.forget();
+  }
+  if (recycler) {
+    recycler->Destroy();
+  }
+}
+
 } // namespace layers
 } // namespace mozilla
@@ -10,6 +10,7 @@
 #include <stdint.h>                     // for int32_t, uint64_t
 #include "gfxTypes.h"
 #include "mozilla/Attributes.h"         // for override
+#include "mozilla/Mutex.h"              // for Mutex
 #include "mozilla/UniquePtr.h"
 #include "mozilla/layers/CompositableClient.h"  // for CompositableClient
 #include "mozilla/layers/CompositorTypes.h"
@@ -32,6 +33,7 @@ class SurfaceDescriptor;
 class SurfaceDescriptorTiles;
 class ThebesBufferData;
 class PTextureChild;
+class TextureClientRecycleAllocator;
 
 /**
  * A transaction is a set of changes that happenned on the content side, that
@@ -50,6 +52,8 @@ class PTextureChild;
 class CompositableForwarder : public KnowsCompositor
 {
 public:
+  CompositableForwarder();
+
   /**
    * Setup the IPDL actor for aCompositable to be part of layers
    * transactions.
@@ -136,9 +140,28 @@ public:
     MOZ_ASSERT(InForwarderThread());
   }
 
+  /**
+   * Returns the TextureClientRecycleAllocator that all the compositables of
+   * this forwarder recycle their TextureClients with when
+   * layers.shared-texture-recycler.enabled is set, creating it if needed.
+   * Can be called from any thread.
+   */
+  TextureClientRecycleAllocator* GetSharedTextureClientRecycler();
+
+  /**
+   * Drops the pooled TextureClients of the shared recycler, and the
+   * reference between the recycler and this forwarder. Must be called when
+   * the forwarder shuts down.
+   */
+  void DestroySharedTextureClientRecycler();
+
 protected:
   nsTArray<RefPtr<TextureClient> > mTexturesToRemove;
   nsTArray<RefPtr<CompositableClient>> mCompositableClientsToRemove;
+
+private:
+  Mutex mSharedTextureClientRecyclerLock;
+  RefPtr<TextureClientRecycleAllocator> mSharedTextureClientRecycler;
 };
 
 } // namespace layers
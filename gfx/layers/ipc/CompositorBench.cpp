@@ -7,12 +7,19 @@
 
 #ifdef MOZ_COMPOSITOR_BENCH
 #include "mozilla/gfx/2D.h"
+#include "mozilla/gfx/Tools.h"
 #include "mozilla/layers/Compositor.h"
 #include "mozilla/layers/Effects.h"
+#include "mozilla/JSONWriter.h"
 #include "mozilla/TimeStamp.h"
 #include "gfxPrefs.h"
+#include <algorithm>
 #include <math.h>
+#include <stdio.h>
+#include <vector>
 #include "GeckoProfiler.h"
+#include "nsString.h"
+#include "prenv.h"
 
 #ifdef MOZ_WIDGET_GONK
 #include "mozilla/layers/GrallocTextureHost.h"
@@ -21,6 +28,7 @@
 #define TEST_STEPS 1000
 #define DURATION_THRESHOLD 30
 #define THRESHOLD_ABORT_COUNT 5
+#define SCENE_STEPS 300
 
 namespace mozilla {
 namespace layers {
@@ -34,28 +42,33 @@ static float SimplePseudoRandom(int aStep, int aCount) {
 
 class BenchTest {
 public:
-  BenchTest(const char* aTestName)
+  explicit BenchTest(const nsACString& aTestName)
     : mTestName(aTestName)
   {}
 
   virtual ~BenchTest() {}
 
-  virtual void Setup(Compositor* aCompositor, size_t aStep) {}
+  // Returns false if the test can't run on aCompositor.
+  virtual bool Setup(Compositor* aCompositor) { return true; }
   virtual void Teardown(Compositor* aCompositor) {}
-  virtual void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) = 0;
+  virtual void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) = 0;
 
-  const char* ToString() { return mTestName; }
+  // Tests that ramp up their load with every step stop once their frames
+  // take too long. The others draw the same frame SCENE_STEPS times.
+  virtual bool RampsUp() { return true; }
+
+  const char* ToString() { return mTestName.get(); }
 private:
-  const char* mTestName;
+  nsCString mTestName;
 };
 
 static void
-DrawFrameTrivialQuad(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep, const EffectChain& effects) {
+DrawFrameTrivialQuad(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep, const EffectChain& effects) {
   for (size_t i = 0; i < aStep * 10; i++) {
-    const gfx::Rect& rect = gfx::Rect(i % (int)aScreenRect.width,
+    const gfx::Rect& rect = gfx::Rect(i % aScreenRect.width,
                                       (int)(i / aScreenRect.height),
                                       1, 1);
-    const gfx::Rect& clipRect = aScreenRect;
+    const gfx::IntRect& clipRect = aScreenRect;
 
     float opacity = 1.f;
 
@@ -68,14 +81,14 @@ DrawFrameTrivialQuad(Compositor* aCompositor, const gfx::Rect& aScreenRect, size
 }
 
 static void
-DrawFrameStressQuad(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep, const EffectChain& effects)
+DrawFrameStressQuad(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep, const EffectChain& effects)
 {
   for (size_t i = 0; i < aStep * 10; i++) {
     const gfx::Rect& rect = gfx::Rect(aScreenRect.width * SimplePseudoRandom(i, 0),
                                       aScreenRect.height * SimplePseudoRandom(i, 1),
                                       aScreenRect.width * SimplePseudoRandom(i, 2),
                                       aScreenRect.height * SimplePseudoRandom(i, 3));
-    const gfx::Rect& clipRect = aScreenRect;
+    const gfx::IntRect& clipRect = aScreenRect;
 
     float opacity = 1.f;
 
@@ -91,18 +104,18 @@ DrawFrameStressQuad(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_
 class EffectSolidColorBench : public BenchTest {
 public:
   EffectSolidColorBench()
-    : BenchTest("EffectSolidColorBench (clear frame with EffectSolidColor)")
+    : BenchTest(NS_LITERAL_CSTRING("EffectSolidColorBench (clear frame with EffectSolidColor)"))
   {}
 
-  void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) {
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) {
     float tmp;
     float red = modff(aStep * 0.03f, &tmp);
     EffectChain effects;
     effects.mPrimaryEffect =
         new EffectSolidColor(gfx::Color(red, 0.4f, 0.4f, 1.0f));
 
-    const gfx::Rect& rect = aScreenRect;
-    const gfx::Rect& clipRect = aScreenRect;
+    const gfx::Rect& rect = IntRectToRect(aScreenRect);
+    const gfx::IntRect& clipRect = aScreenRect;
 
     float opacity = 1.f;
 
@@ -114,10 +127,10 @@ public:
 class EffectSolidColorTrivialBench : public BenchTest {
 public:
   EffectSolidColorTrivialBench()
-    : BenchTest("EffectSolidColorTrivialBench (10s 1x1 EffectSolidColor)")
+    : BenchTest(NS_LITERAL_CSTRING("EffectSolidColorTrivialBench (10s 1x1 EffectSolidColor)"))
   {}
 
-  void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) {
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) {
     EffectChain effects;
     effects.mPrimaryEffect = CreateEffect(aStep);
 
@@ -135,10 +148,10 @@ public:
 class EffectSolidColorStressBench : public BenchTest {
 public:
   EffectSolidColorStressBench()
-    : BenchTest("EffectSolidColorStressBench (10s various EffectSolidColor)")
+    : BenchTest(NS_LITERAL_CSTRING("EffectSolidColorStressBench (10s various EffectSolidColor)"))
   {}
 
-  void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) {
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) {
     EffectChain effects;
     effects.mPrimaryEffect = CreateEffect(aStep);
 
@@ -156,14 +169,14 @@ public:
 class UploadBench : public BenchTest {
 public:
   UploadBench()
-    : BenchTest("Upload Bench (10s 256x256 upload)")
+    : BenchTest(NS_LITERAL_CSTRING("Upload Bench (10s 256x256 upload)"))
   {}
 
   uint32_t* mBuf;
   RefPtr<DataSourceSurface> mSurface;
   RefPtr<DataTextureSource> mTexture;
 
-  virtual void Setup(Compositor* aCompositor, size_t aStep) {
+  virtual bool Setup(Compositor* aCompositor) {
     int bytesPerPixel = 4;
     int w = 256;
     int h = 256;
@@ -172,6 +185,7 @@ public:
     mSurface = Factory::CreateWrappingDataSourceSurface(
       reinterpret_cast<uint8_t*>(mBuf), w * bytesPerPixel, IntSize(w, h), SurfaceFormat::B8G8R8A8);
     mTexture = aCompositor->CreateDataTextureSource();
+    return true;
   }
 
   virtual void Teardown(Compositor* aCompositor) {
@@ -180,7 +194,7 @@ public:
     free(mBuf);
   }
 
-  void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) {
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) {
     for (size_t i = 0; i < aStep * 10; i++) {
       mTexture->Update(mSurface);
     }
@@ -190,14 +204,14 @@ public:
 class TrivialTexturedQuadBench : public BenchTest {
 public:
   TrivialTexturedQuadBench()
-    : BenchTest("Trvial Textured Quad (10s 256x256 quads)")
+    : BenchTest(NS_LITERAL_CSTRING("Trvial Textured Quad (10s 256x256 quads)"))
   {}
 
   uint32_t* mBuf;
   RefPtr<DataSourceSurface> mSurface;
   RefPtr<DataTextureSource> mTexture;
 
-  virtual void Setup(Compositor* aCompositor, size_t aStep) {
+  virtual bool Setup(Compositor* aCompositor) {
     int bytesPerPixel = 4;
     size_t w = 256;
     size_t h = 256;
@@ -210,9 +224,10 @@ public:
       reinterpret_cast<uint8_t*>(mBuf), w * bytesPerPixel, IntSize(w, h), SurfaceFormat::B8G8R8A8);
     mTexture = aCompositor->CreateDataTextureSource();
     mTexture->Update(mSurface);
+    return true;
   }
 
-  void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) {
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) {
     EffectChain effects;
     effects.mPrimaryEffect = CreateEffect(aStep);
 
@@ -234,14 +249,14 @@ public:
 class StressTexturedQuadBench : public BenchTest {
 public:
   StressTexturedQuadBench()
-    : BenchTest("Stress Textured Quad (10s 256x256 quads)")
+    : BenchTest(NS_LITERAL_CSTRING("Stress Textured Quad (10s 256x256 quads)"))
   {}
 
   uint32_t* mBuf;
   RefPtr<DataSourceSurface> mSurface;
   RefPtr<DataTextureSource> mTexture;
 
-  virtual void Setup(Compositor* aCompositor, size_t aStep) {
+  virtual bool Setup(Compositor* aCompositor) {
     int bytesPerPixel = 4;
     size_t w = 256;
     size_t h = 256;
@@ -254,9 +269,10 @@ public:
       reinterpret_cast<uint8_t*>(mBuf), w * bytesPerPixel, IntSize(w, h), SurfaceFormat::B8G8R8A8);
     mTexture = aCompositor->CreateDataTextureSource();
     mTexture->Update(mSurface);
+    return true;
   }
 
-  void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) {
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) {
     EffectChain effects;
     effects.mPrimaryEffect = CreateEffect(aStep);
 
@@ -279,14 +295,14 @@ public:
 class TrivialGrallocQuadBench : public BenchTest {
 public:
   TrivialGrallocQuadBench()
-    : BenchTest("Travial Gralloc Quad (10s 256x256 quads)")
+    : BenchTest(NS_LITERAL_CSTRING("Travial Gralloc Quad (10s 256x256 quads)"))
   {}
 
   uint32_t* mBuf;
   android::sp<android::GraphicBuffer> mGralloc;
   RefPtr<TextureSource> mTexture;
 
-  virtual void Setup(Compositor* aCompositor, size_t aStep) {
+  virtual bool Setup(Compositor* aCompositor) {
     mBuf = nullptr;
     int w = 256;
     int h = 256;
@@ -297,9 +313,10 @@ public:
                                  android::GraphicBuffer::USAGE_SW_WRITE_OFTEN |
                                  android::GraphicBuffer::USAGE_HW_TEXTURE);
     mTexture = new mozilla::layers::GrallocTextureSourceOGL((CompositorOGL*)aCompositor, mGralloc.get(), SurfaceFormat::B8G8R8A8);
+    return true;
   }
 
-  void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) {
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) {
     EffectChain effects;
     effects.mPrimaryEffect = CreateEffect(aStep);
 
@@ -321,14 +338,14 @@ public:
 class StressGrallocQuadBench : public BenchTest {
 public:
   StressGrallocQuadBench()
-    : BenchTest("Stress Gralloc Quad (10s 256x256 quads)")
+    : BenchTest(NS_LITERAL_CSTRING("Stress Gralloc Quad (10s 256x256 quads)"))
   {}
 
   uint32_t* mBuf;
   android::sp<android::GraphicBuffer> mGralloc;
   RefPtr<TextureSource> mTexture;
 
-  virtual void Setup(Compositor* aCompositor, size_t aStep) {
+  virtual bool Setup(Compositor* aCompositor) {
     mBuf = nullptr;
     int w = 256;
     int h = 256;
@@ -339,9 +356,10 @@ public:
                                  android::GraphicBuffer::USAGE_SW_WRITE_OFTEN |
                                  android::GraphicBuffer::USAGE_HW_TEXTURE);
     mTexture = new mozilla::layers::GrallocTextureSourceOGL((CompositorOGL*)aCompositor, mGralloc.get(), SurfaceFormat::B8G8R8A8);
+    return true;
   }
 
-  void DrawFrame(Compositor* aCompositor, const gfx::Rect& aScreenRect, size_t aStep) {
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) {
     EffectChain effects;
     effects.mPrimaryEffect = CreateEffect(aStep);
 
@@ -361,7 +379,327 @@ public:
 };
 #endif
 
-static void RunCompositorBench(Compositor* aCompositor, const gfx::Rect& aScreenRect)
+static already_AddRefed<DataTextureSource>
+CreatePatternTexture(Compositor* aCompositor, const IntSize& aSize,
+                     SurfaceFormat aFormat, uint32_t aSeed)
+{
+  RefPtr<DataSourceSurface> surface =
+    Factory::CreateDataSourceSurface(aSize, aFormat);
+  if (!surface) {
+    return nullptr;
+  }
+  DataSourceSurface::ScopedMap map(surface, DataSourceSurface::WRITE);
+  if (!map.IsMapped()) {
+    return nullptr;
+  }
+  int32_t bpp = BytesPerPixel(aFormat);
+  for (int32_t y = 0; y < aSize.height; y++) {
+    uint8_t* row = map.GetData() + y * map.GetStride();
+    for (int32_t x = 0; x < aSize.width * bpp; x++) {
+      row[x] = (x / bpp + y + aSeed) & 0xff;
+    }
+    if (aFormat == SurfaceFormat::B8G8R8A8) {
+      // Keep the pixels valid premultiplied ones.
+      for (int32_t x = 0; x < aSize.width; x++) {
+        row[4 * x + 3] = 0xff;
+      }
+    }
+  }
+
+  RefPtr<DataTextureSource> texture = aCompositor->CreateDataTextureSource();
+  if (!texture || !texture->Update(surface)) {
+    return nullptr;
+  }
+  return texture.forget();
+}
+
+/**
+ * The parameters of a SceneBench, which draws a frame that is made of a
+ * number of layers of one kind, like the ones LayerManagerComposite would
+ * draw for them.
+ */
+struct BenchScene
+{
+  enum class Content {
+    // 256x256 textures laid out in a grid, wrapping around the screen.
+    Tiles,
+    // Textures of various sizes and positions, with some opacity.
+    Images,
+    // 640x360 YCbCr frames scaled to a quarter of the screen.
+    Video
+  };
+
+  Content mContent;
+  size_t mLayerCount;
+  bool mMask;
+  gfx::CompositionOp mBlendMode;
+  bool m3DTransform;
+
+  nsCString ToString() const
+  {
+    nsCString name;
+    switch (mContent) {
+      case Content::Tiles: name.AppendPrintf("%u tiles", uint32_t(mLayerCount)); break;
+      case Content::Images: name.AppendPrintf("%u images", uint32_t(mLayerCount)); break;
+      case Content::Video: name.AppendPrintf("%u videos", uint32_t(mLayerCount)); break;
+    }
+    if (mMask) {
+      name.AppendLiteral(", masked");
+    }
+    if (mBlendMode != gfx::CompositionOp::OP_OVER) {
+      name.AppendPrintf(", blend mode %d", int(mBlendMode));
+    }
+    if (m3DTransform) {
+      name.AppendLiteral(", 3D transform");
+    }
+    return name;
+  }
+};
+
+static const IntSize kTileSize(256, 256);
+static const IntSize kVideoSize(640, 360);
+static const IntSize kMaskSize(256, 256);
+
+class SceneBench : public BenchTest {
+public:
+  explicit SceneBench(const BenchScene& aScene)
+    : BenchTest(aScene.ToString())
+    , mScene(aScene)
+  {}
+
+  virtual bool Setup(Compositor* aCompositor) override {
+    if (mScene.mContent == BenchScene::Content::Video) {
+      if (!aCompositor->SupportsEffect(EffectTypes::YCBCR)) {
+        return false;
+      }
+      IntSize cbCrSize(kVideoSize.width / 2, kVideoSize.height / 2);
+      mTexture = CreatePatternTexture(aCompositor, kVideoSize, SurfaceFormat::A8, 0);
+      RefPtr<DataTextureSource> cb =
+        CreatePatternTexture(aCompositor, cbCrSize, SurfaceFormat::A8, 64);
+      RefPtr<DataTextureSource> cr =
+        CreatePatternTexture(aCompositor, cbCrSize, SurfaceFormat::A8, 128);
+      if (!mTexture || !cb || !cr) {
+        return false;
+      }
+      mTexture->SetNextSibling(cb);
+      cb->SetNextSibling(cr);
+    } else {
+      mTexture = CreatePatternTexture(aCompositor, kTileSize, SurfaceFormat::B8G8R8A8, 0);
+      if (!mTexture) {
+        return false;
+      }
+    }
+    if (mScene.mMask) {
+      mMaskTexture = CreatePatternTexture(aCompositor, kMaskSize, SurfaceFormat::A8, 0);
+      if (!mMaskTexture) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  virtual void Teardown(Compositor* aCompositor) override {
+    if (mTexture) {
+      mTexture->SetNextSibling(nullptr);
+    }
+    mTexture = nullptr;
+    mMaskTexture = nullptr;
+  }
+
+  virtual bool RampsUp() override { return false; }
+
+  void DrawFrame(Compositor* aCompositor, const gfx::IntRect& aScreenRect, size_t aStep) override {
+    for (size_t i = 0; i < mScene.mLayerCount; i++) {
+      gfx::Rect rect = LayerRect(aScreenRect, i);
+
+      EffectChain effects;
+      if (mScene.mContent == BenchScene::Content::Video) {
+        effects.mPrimaryEffect = new EffectYCbCr(mTexture, SamplingFilter::LINEAR);
+      } else {
+        effects.mPrimaryEffect = CreateTexturedEffect(SurfaceFormat::B8G8R8A8, mTexture,
+                                                      SamplingFilter::LINEAR, true);
+      }
+      if (mScene.mMask) {
+        gfx::Matrix4x4 maskTransform =
+          gfx::Matrix4x4::Scaling(rect.width / kMaskSize.width,
+                                  rect.height / kMaskSize.height, 1.f);
+        maskTransform.PostTranslate(rect.x, rect.y, 0);
+        effects.mSecondaryEffects[EffectTypes::MASK] =
+          new EffectMask(mMaskTexture, kMaskSize, maskTransform);
+      }
+      if (mScene.mBlendMode != gfx::CompositionOp::OP_OVER) {
+        effects.mSecondaryEffects[EffectTypes::BLEND_MODE] =
+          new EffectBlendMode(mScene.mBlendMode);
+      }
+
+      gfx::Matrix4x4 transform;
+      if (mScene.m3DTransform) {
+        transform.RotateY(0.6 * sin(aStep * 0.05 + i));
+        gfx::Matrix4x4 perspective;
+        perspective.Perspective(1000.f);
+        transform = transform * perspective;
+        transform.ChangeBasis(rect.Center().x, rect.Center().y, 0);
+      }
+
+      float opacity = mScene.mContent == BenchScene::Content::Images ? 0.8f : 1.f;
+      aCompositor->DrawQuad(rect, aScreenRect, effects, opacity, transform);
+    }
+  }
+
+private:
+  gfx::Rect LayerRect(const gfx::IntRect& aScreenRect, size_t aIndex) {
+    switch (mScene.mContent) {
+      case BenchScene::Content::Tiles: {
+        int32_t columns = std::max(1, (aScreenRect.width + kTileSize.width - 1) / kTileSize.width);
+        int32_t rows = std::max(1, (aScreenRect.height + kTileSize.height - 1) / kTileSize.height);
+        int32_t tile = aIndex % (columns * rows);
+        return gfx::Rect(aScreenRect.x + (tile % columns) * kTileSize.width,
+                         aScreenRect.y + (tile / columns) * kTileSize.height,
+                         kTileSize.width, kTileSize.height);
+      }
+      case BenchScene::Content::Images:
+        return gfx::Rect(aScreenRect.x + aScreenRect.width * SimplePseudoRandom(aIndex, 0) * 0.75f,
+                         aScreenRect.y + aScreenRect.height * SimplePseudoRandom(aIndex, 1) * 0.75f,
+                         aScreenRect.width * (0.05f + SimplePseudoRandom(aIndex, 2) * 0.2f),
+                         aScreenRect.height * (0.05f + SimplePseudoRandom(aIndex, 3) * 0.2f));
+      case BenchScene::Content::Video:
+        return gfx::Rect(aScreenRect.x + (aIndex % 2) * aScreenRect.width / 2,
+                         aScreenRect.y + ((aIndex / 2) % 2) * aScreenRect.height / 2,
+                         aScreenRect.width / 2, aScreenRect.height / 2);
+    }
+    return gfx::Rect();
+  }
+
+  BenchScene mScene;
+  RefPtr<DataTextureSource> mTexture;
+  RefPtr<DataTextureSource> mMaskTexture;
+};
+
+static void
+AddSceneBenches(std::vector<BenchTest*>& aTests)
+{
+  typedef BenchScene::Content Content;
+  const gfx::CompositionOp over = gfx::CompositionOp::OP_OVER;
+
+  for (size_t count : { 16, 64, 256 }) {
+    aTests.push_back(new SceneBench({ Content::Tiles, count, false, over, false }));
+  }
+  for (size_t count : { 10, 50, 200 }) {
+    aTests.push_back(new SceneBench({ Content::Images, count, false, over, false }));
+  }
+  aTests.push_back(new SceneBench({ Content::Images, 50, true, over, false }));
+  for (gfx::CompositionOp blendMode : { gfx::CompositionOp::OP_MULTIPLY,
+                                        gfx::CompositionOp::OP_SCREEN,
+                                        gfx::CompositionOp::OP_OVERLAY,
+                                        gfx::CompositionOp::OP_DIFFERENCE }) {
+    aTests.push_back(new SceneBench({ Content::Images, 50, false, blendMode, false }));
+  }
+  aTests.push_back(new SceneBench({ Content::Tiles, 64, false, over, true }));
+  aTests.push_back(new SceneBench({ Content::Images, 50, true, over, true }));
+  for (size_t count : { 1, 4 }) {
+    aTests.push_back(new SceneBench({ Content::Video, count, false, over, false }));
+  }
+}
+
+struct BenchResult
+{
+  nsCString mName;
+  bool mSkipped;
+  bool mAborted;
+  // The time it took to record and submit each frame, and the time we then
+  // had to wait for the GPU to finish it.
+  std::vector<double> mCPUTimes;
+  std::vector<double> mGPUTimes;
+};
+
+// Nearest-rank percentile of aSortedValues.
+static double
+Percentile(const std::vector<double>& aSortedValues, double aPercentile)
+{
+  if (aSortedValues.empty()) {
+    return 0;
+  }
+  size_t rank = size_t(ceil(aPercentile / 100 * aSortedValues.size()));
+  return aSortedValues[std::min(std::max(rank, size_t(1)), aSortedValues.size()) - 1];
+}
+
+static void
+WriteTimes(JSONWriter& aWriter, const char* aName, std::vector<double> aTimes)
+{
+  std::sort(aTimes.begin(), aTimes.end());
+  aWriter.StartObjectProperty(aName, JSONWriter::SingleLineStyle);
+  aWriter.DoubleProperty("p50", Percentile(aTimes, 50));
+  aWriter.DoubleProperty("p90", Percentile(aTimes, 90));
+  aWriter.DoubleProperty("p95", Percentile(aTimes, 95));
+  aWriter.DoubleProperty("p99", Percentile(aTimes, 99));
+  aWriter.DoubleProperty("max", aTimes.empty() ? 0 : aTimes.back());
+  aWriter.EndObject();
+}
+
+static const char*
+BackendName(LayersBackend aBackend)
+{
+  switch (aBackend) {
+    case LayersBackend::LAYERS_BASIC: return "basic";
+    case LayersBackend::LAYERS_OPENGL: return "opengl";
+    case LayersBackend::LAYERS_D3D9: return "d3d9";
+    case LayersBackend::LAYERS_D3D11: return "d3d11";
+    default: return "unknown";
+  }
+}
+
+class FileWriteFunc : public JSONWriteFunc
+{
+public:
+  explicit FileWriteFunc(FILE* aFile) : mFile(aFile) {}
+  void Write(const char* aStr) override { fputs(aStr, mFile); }
+private:
+  FILE* mFile;
+};
+
+// Writes the results to the file named by the MOZ_COMPOSITOR_BENCH_OUTPUT
+// environment variable, if it is set, so that they can be compared across
+// drivers and hardware.
+static void
+WriteResults(Compositor* aCompositor, const gfx::IntRect& aScreenRect,
+             const std::vector<BenchResult>& aResults)
+{
+  const char* path = PR_GetEnv("MOZ_COMPOSITOR_BENCH_OUTPUT");
+  if (!path || !*path) {
+    return;
+  }
+  FILE* file = fopen(path, "w");
+  if (!file) {
+    printf_stderr("CompositorBench: can't open %s\n", path);
+    return;
+  }
+
+  JSONWriter writer(MakeUnique<FileWriteFunc>(file));
+  writer.Start();
+  writer.StringProperty("backend", BackendName(aCompositor->GetBackendType()));
+  writer.IntProperty("width", aScreenRect.width);
+  writer.IntProperty("height", aScreenRect.height);
+  writer.StartArrayProperty("tests");
+  for (const BenchResult& result : aResults) {
+    writer.StartObjectElement();
+    writer.StringProperty("name", result.mName.get());
+    writer.IntProperty("frames", result.mCPUTimes.size());
+    if (result.mSkipped) {
+      writer.BoolProperty("skipped", true);
+    } else {
+      writer.BoolProperty("aborted", result.mAborted);
+      WriteTimes(writer, "cpu_ms", result.mCPUTimes);
+      WriteTimes(writer, "gpu_ms", result.mGPUTimes);
+    }
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.End();
+
+  fclose(file);
+}
+
+static void RunCompositorBench(Compositor* aCompositor, const gfx::IntRect& aScreenRect)
 {
   std::vector<BenchTest*> tests;
 
@@ -375,48 +713,63 @@ static void RunCompositorBench(Compositor* aCompositor, const gfx::Rect& aScreen
   tests.push_back(new TrivialGrallocQuadBench());
   tests.push_back(new StressGrallocQuadBench());
 #endif
+  AddSceneBenches(tests);
 
+  std::vector<BenchResult> results(tests.size());
   for (size_t i = 0; i < tests.size(); i++) {
     BenchTest* test = tests[i];
-    std::vector<TimeDuration> results;
+    BenchResult& result = results[i];
+    result.mName = test->ToString();
+    result.mAborted = false;
+    result.mSkipped = !test->Setup(aCompositor);
+    if (result.mSkipped) {
+      test->Teardown(aCompositor);
+      printf_stderr("%s: not supported by this compositor\n\n", test->ToString());
+      continue;
+    }
+
     int testsOverThreshold = 0;
+    size_t steps = test->RampsUp() ? TEST_STEPS : SCENE_STEPS;
     PROFILER_MARKER(test->ToString());
-    for (size_t j = 0; j < TEST_STEPS; j++) {
-      test->Setup(aCompositor, j);
-
+    for (size_t j = 0; j < steps; j++) {
       TimeStamp start = TimeStamp::Now();
-      IntRect screenRect(aScreenRect.x, aScreenRect.y,
-                           aScreenRect.width, aScreenRect.height);
-      aCompositor->BeginFrame(
-        IntRect(screenRect.x, screenRect.y,
-                  screenRect.width, screenRect.height),
-        nullptr, aScreenRect, nullptr, nullptr);
+      aCompositor->BeginFrame(nsIntRegion(aScreenRect), nullptr, aScreenRect, nsIntRegion());
 
       test->DrawFrame(aCompositor, aScreenRect, j);
 
       aCompositor->EndFrame();
-      results.push_back(TimeStamp::Now() - start);
+      TimeStamp submitted = TimeStamp::Now();
+      aCompositor->WaitForGPU();
+      TimeStamp end = TimeStamp::Now();
+
+      result.mCPUTimes.push_back((submitted - start).ToMilliseconds());
+      result.mGPUTimes.push_back((end - submitted).ToMilliseconds());
 
-      if (results[j].ToMilliseconds() > DURATION_THRESHOLD) {
+      if (!test->RampsUp()) {
+        continue;
+      }
+      if ((end - start).ToMilliseconds() > DURATION_THRESHOLD) {
         testsOverThreshold++;
         if (testsOverThreshold == THRESHOLD_ABORT_COUNT) {
-          test->Teardown(aCompositor);
+          result.mAborted = true;
           break;
         }
       } else {
         testsOverThreshold = 0;
       }
-      test->Teardown(aCompositor);
     }
+    test->Teardown(aCompositor);
 
     printf_stderr("%s\n", test->ToString());
-    printf_stderr("Run step, Time (ms)\n");
-    for (size_t j = 0; j < results.size(); j++) {
-      printf_stderr("%i,%f\n", j, (float)results[j].ToMilliseconds());
+    printf_stderr("Run step, CPU time (ms), GPU time (ms)\n");
+    for (size_t j = 0; j < result.mCPUTimes.size(); j++) {
+      printf_stderr("%i,%f,%f\n", int(j), result.mCPUTimes[j], result.mGPUTimes[j]);
     }
-    printf_stderr("\n", test->ToString());
+    printf_stderr("\n");
   }
 
+  WriteResults(aCompositor, aScreenRect, results);
+
   for (size_t i = 0; i < tests.size(); i++) {
     delete tests[i];
   }
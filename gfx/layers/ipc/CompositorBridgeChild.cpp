@@ -125,6 +125,8 @@ CompositorBridgeChild::Destroy()
     mSectionAllocator = nullptr;
   }
 
+  mShmemRecycleBin.Clear(this);
+
   // Destroying the layer manager may cause all sorts of things to happen, so
   // let's make sure there is still a reference to keep this alive whatever
   // happens.
@@ -586,6 +588,9 @@ CompositorBridgeChild::ActorDestroy(ActorDestroyReason aWhy)
     gfxCriticalNote << "Receive IPC close with reason=AbnormalShutdown";
   }
 
+  // The recycled shmems went away with the channel.
+  mShmemRecycleBin.Clear(nullptr);
+
   if (mProcessToken && XRE_IsParentProcess()) {
     GPUProcessManager::Get()->NotifyRemoteActorDestroyed(mProcessToken);
   }
@@ -1003,6 +1008,7 @@ CompositorBridgeChild::HandleMemoryPressure()
   for (size_t i = 0; i < mTexturePools.Length(); i++) {
     mTexturePools[i]->Clear();
   }
+  mShmemRecycleBin.Clear(mCanSend ? this : nullptr);
 }
 
 void
@@ -1042,6 +1048,10 @@ CompositorBridgeChild::AllocUnsafeShmem(size_t aSize,
                                    ipc::SharedMemory::SharedMemoryType aType,
                                    ipc::Shmem* aShmem)
 {
+  // Recycled shmems don't add to the compositor's backlog of new segments.
+  if (mShmemRecycleBin.GetShmem(aSize, aShmem)) {
+    return true;
+  }
   ShmemAllocated(this);
   return PCompositorBridgeChild::AllocUnsafeShmem(aSize, aType, aShmem);
 }
@@ -1061,6 +1071,14 @@ CompositorBridgeChild::DeallocShmem(ipc::Shmem& aShmem)
     PCompositorBridgeChild::DeallocShmem(aShmem);
 }
 
+void
+CompositorBridgeChild::RecycleShmem(ipc::Shmem& aShmem)
+{
+  if (!mCanSend || !mShmemRecycleBin.RecycleShmem(aShmem, this)) {
+    DeallocShmem(aShmem);
+  }
+}
+
 widget::PCompositorWidgetChild*
 CompositorBridgeChild::AllocPCompositorWidgetChild(const CompositorWidgetInitData& aInitData)
 {
@@ -7,6 +7,8 @@
 
 #include "ISurfaceAllocator.h"
 
+#include <string.h>                     // for memset
+
 #include "gfxPrefs.h"
 #include "mozilla/layers/ImageBridgeParent.h" // for ImageBridgeParent
 #include "mozilla/layers/TextureHost.h"       // for TextureHost
@@ -253,6 +255,67 @@ FixedSizeSmallShmemSectionAllocator::ShrinkShmemSectionHeap()
   }
 }
 
+ShmemRecycleBin::ShmemRecycleBin()
+  : mBytes(0)
+{
+}
+
+ShmemRecycleBin::~ShmemRecycleBin()
+{
+  MOZ_ASSERT(mShmems.empty(), "Clear should have been called");
+}
+
+bool
+ShmemRecycleBin::GetShmem(size_t aSize, ipc::Shmem* aShmem)
+{
+  // Most requests are for the size of a tile, which was likely recycled
+  // last, so search from the end.
+  for (size_t i = mShmems.size(); i > 0; i--) {
+    ipc::Shmem& shmem = mShmems[i - 1];
+    if (shmem.Size<uint8_t>() != aSize) {
+      continue;
+    }
+    *aShmem = shmem;
+    mShmems.erase(mShmems.begin() + (i - 1));
+    mBytes -= aSize;
+    memset(aShmem->get<uint8_t>(), 0, aSize);
+    return true;
+  }
+  return false;
+}
+
+bool
+ShmemRecycleBin::RecycleShmem(ipc::Shmem& aShmem, ShmemAllocator* aAllocator)
+{
+  size_t maxBytes = size_t(gfxPrefs::LayersShmemRecycleBinMaxKB()) * 1024;
+  size_t size = aShmem.Size<uint8_t>();
+  if (!aShmem.IsWritable() || size > maxBytes) {
+    return false;
+  }
+
+  mShmems.push_back(aShmem);
+  mBytes += size;
+
+  while (mBytes > maxBytes) {
+    mBytes -= mShmems.front().Size<uint8_t>();
+    aAllocator->DeallocShmem(mShmems.front());
+    mShmems.erase(mShmems.begin());
+  }
+  return true;
+}
+
+void
+ShmemRecycleBin::Clear(ShmemAllocator* aAllocator)
+{
+  if (aAllocator) {
+    for (size_t i = 0; i < mShmems.size(); i++) {
+      aAllocator->DeallocShmem(mShmems[i]);
+    }
+  }
+  mShmems.clear();
+  mBytes = 0;
+}
+
 int32_t
 ClientIPCAllocator::GetMaxTextureSize() const
 {
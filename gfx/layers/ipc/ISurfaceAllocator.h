@@ -181,6 +181,11 @@ public:
                                 mozilla::ipc::SharedMemory::SharedMemoryType aShmType,
                                 mozilla::ipc::Shmem* aShmem) = 0;
   virtual void DeallocShmem(mozilla::ipc::Shmem& aShmem) = 0;
+
+  /// Like DeallocShmem, for an unsafe shmem that nothing on either side uses
+  /// anymore. Allocators with a ShmemRecycleBin keep it to serve a later
+  /// allocation of the same size.
+  virtual void RecycleShmem(mozilla::ipc::Shmem& aShmem) { DeallocShmem(aShmem); }
 };
 
 /// An allocator that can group allocations in bigger chunks of shared memory.
@@ -319,6 +324,39 @@ protected:
   LayersIPCChannel* mShmProvider;
 };
 
+/// Keeps unsafe shmems that were released with RecycleShmem, so that
+/// allocations of the same size can reuse them instead of creating a new
+/// segment, which needs a message to the other side and a new mapping there.
+/// The other side keeps its mapping of a recycled shmem, since it never hears
+/// that the shmem was released.
+///
+/// Holds at most layers.shmem-recycle-bin.max-kb of shmems (none by default),
+/// dropping the least recently recycled ones first. Must only be used on the
+/// channel's IPDL thread.
+class ShmemRecycleBin final
+{
+public:
+  ShmemRecycleBin();
+  ~ShmemRecycleBin();
+
+  /// Takes a recycled shmem of exactly aSize bytes, cleared to zero as a new
+  /// shmem would be. Returns false if there is none.
+  bool GetShmem(size_t aSize, mozilla::ipc::Shmem* aShmem);
+
+  /// Returns false if the shmem wasn't kept, in which case the caller must
+  /// deallocate it.
+  bool RecycleShmem(mozilla::ipc::Shmem& aShmem, ShmemAllocator* aAllocator);
+
+  /// Deallocates the recycled shmems through aAllocator, or just forgets
+  /// them if aAllocator is null because the channel is closed.
+  void Clear(ShmemAllocator* aAllocator);
+
+private:
+  // Ordered from the least to the most recently recycled.
+  std::vector<mozilla::ipc::Shmem> mShmems;
+  size_t mBytes;
+};
+
 } // namespace layers
 } // namespace mozilla
 
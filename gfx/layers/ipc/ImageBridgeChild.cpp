@@ -434,6 +434,8 @@ ImageBridgeChild::ShutdownStep1(SynchronousTask* aTask)
 
   MediaSystemResourceManager::Shutdown();
 
+  DestroySharedTextureClientRecycler();
+
   // Force all managed protocols to shut themselves down cleanly
   InfallibleTArray<PCompositableChild*> compositables;
   ManagedPCompositableChild(compositables);
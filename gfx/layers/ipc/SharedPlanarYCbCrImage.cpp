@@ -181,14 +181,19 @@ SharedPlanarYCbCrImage::Allocate(PlanarYCbCrData& aData)
              "This image already has allocated data");
   static const uint32_t MAX_POOLED_VIDEO_COUNT = 5;
 
-  if (!mCompositable->HasTextureClientRecycler()) {
+  bool initRecycler = !mCompositable->HasTextureClientRecycler();
+  TextureClientRecycleAllocator* recycler = mCompositable->GetTextureClientRecycler();
+  if (initRecycler && !recycler->IsShared()) {
     // Initialize TextureClientRecycler
-    mCompositable->GetTextureClientRecycler()->SetMaxPoolSize(MAX_POOLED_VIDEO_COUNT);
+    recycler->SetMaxPoolSize(MAX_POOLED_VIDEO_COUNT);
   }
 
   {
-    YCbCrTextureClientAllocationHelper helper(aData, mCompositable->GetTextureFlags());
-    mTextureClient = mCompositable->GetTextureClientRecycler()->CreateOrRecycle(helper);
+    // The shared recycler serves several video sizes, so let it recycle
+    // clients that are slightly larger than the frame.
+    YCbCrTextureClientAllocationHelper helper(aData, mCompositable->GetTextureFlags(),
+                                              recycler->IsShared());
+    mTextureClient = recycler->CreateOrRecycle(helper);
   }
 
   if (!mTextureClient) {
@@ -224,13 +229,15 @@ SharedPlanarYCbCrImage::Allocate(PlanarYCbCrData& aData)
   mData.mYSkip = 0;
   mData.mCbSkip = 0;
   mData.mCrSkip = 0;
-  mData.mYStride = mData.mYSize.width;
-  mData.mCbCrStride = mData.mCbCrSize.width;
+  // The planes may be larger than the data, see
+  // YCbCrTextureClientAllocationHelper.
+  mData.mYStride = mapped.y.stride;
+  mData.mCbCrStride = mapped.cb.stride;
 
   // do not set mBuffer like in PlanarYCbCrImage because the later
   // will try to manage this memory without knowing it belongs to a
   // shmem.
-  mBufferSize = ImageDataSerializer::ComputeYCbCrBufferSize(mData.mYSize, mData.mCbCrSize);
+  mBufferSize = ImageDataSerializer::ComputeYCbCrBufferSize(mapped.y.size, mapped.cb.size);
   mSize = mData.mPicSize;
   mOrigin = gfx::IntPoint(aData.mPicX, aData.mPicY);
 
@@ -93,6 +93,11 @@ CompositorOGL::CompositorOGL(CompositorBridgeParent* aParent,
   , mDestroyed(false)
   , mViewportSize(0, 0)
   , mCurrentProgram(nullptr)
+  , mBatchProgram(nullptr)
+  , mBatchSamplingFilter(gfx::SamplingFilter::GOOD)
+  , mBatchPremultiplied(true)
+  , mBatchOpacity(1.0f)
+  , mBatchVBO(0)
 {
   MOZ_COUNT_CTOR(CompositorOGL);
 }
@@ -188,6 +193,10 @@ CompositorOGL::CleanupResources()
   if (!ctx->MakeCurrent()) {
     // Leak resources!
     mQuadVBO = 0;
+    mBatchVBO = 0;
+    mBatchVertices.Clear();
+    mBatchProgram = nullptr;
+    mBatchTexture = nullptr;
     mGLContext = nullptr;
     mPrograms.clear();
     return;
@@ -207,6 +216,14 @@ CompositorOGL::CleanupResources()
     mQuadVBO = 0;
   }
 
+  if (mBatchVBO) {
+    ctx->fDeleteBuffers(1, &mBatchVBO);
+    mBatchVBO = 0;
+  }
+  mBatchVertices.Clear();
+  mBatchProgram = nullptr;
+  mBatchTexture = nullptr;
+
   mGLContext->MakeCurrent();
 
   mBlitTextureImageHelper = nullptr;
@@ -399,6 +416,9 @@ CompositorOGL::Initialize(nsCString* const out_failureReason)
                           LOCAL_GL_STATIC_DRAW);
   mGLContext->fBindBuffer(LOCAL_GL_ARRAY_BUFFER, 0);
 
+  // The quad batch VBO is filled with new vertices for every batch.
+  mGLContext->fGenBuffers(1, &mBatchVBO);
+
   nsCOMPtr<nsIConsoleService>
     console(do_GetService(NS_CONSOLESERVICE_CONTRACTID));
 
@@ -442,6 +462,27 @@ CalculatePOTSize(const IntSize& aSize, GLContext* gl)
   return IntSize(RoundUpPow2(aSize.width), RoundUpPow2(aSize.height));
 }
 
+// If the OpenGL setup does not support non-power-of-two textures then the
+// texture's width and height will have been increased to the next
+// power-of-two (unless already a power of two). In that case we must scale
+// the texture coordinates to account for that.
+static Rect
+ScaleTexCoordRectForPOT(const Rect& aTexCoordRect, TextureSource* aTexture,
+                        GLContext* gl)
+{
+  Rect scaledTexCoordRect = aTexCoordRect;
+  if (!CanUploadNonPowerOfTwo(gl)) {
+    const IntSize& textureSize = aTexture->GetSize();
+    const IntSize potSize = CalculatePOTSize(textureSize, gl);
+    if (potSize != textureSize) {
+      const float xScale = (float)textureSize.width / (float)potSize.width;
+      const float yScale = (float)textureSize.height / (float)potSize.height;
+      scaledTexCoordRect.Scale(xScale, yScale);
+    }
+  }
+  return scaledTexCoordRect;
+}
+
 // |aRect| is the rectangle we want to draw to. We will draw it with
 // up to 4 draw commands if necessary to avoid wrapping.
 // |aTexCoordRect| is the rectangle from the texture that we want to
@@ -454,21 +495,8 @@ CompositorOGL::BindAndDrawQuadWithTextureRect(ShaderProgramOGL *aProg,
                                               const Rect& aTexCoordRect,
                                               TextureSource *aTexture)
 {
-  Rect scaledTexCoordRect = aTexCoordRect;
-
-  // If the OpenGL setup does not support non-power-of-two textures then the
-  // texture's width and height will have been increased to the next
-  // power-of-two (unless already a power of two). In that case we must scale
-  // the texture coordinates to account for that.
-  if (!CanUploadNonPowerOfTwo(mGLContext)) {
-    const IntSize& textureSize = aTexture->GetSize();
-    const IntSize potSize = CalculatePOTSize(textureSize, mGLContext);
-    if (potSize != textureSize) {
-      const float xScale = (float)textureSize.width / (float)potSize.width;
-      const float yScale = (float)textureSize.height / (float)potSize.height;
-      scaledTexCoordRect.Scale(xScale, yScale);
-    }
-  }
+  Rect scaledTexCoordRect =
+    ScaleTexCoordRectForPOT(aTexCoordRect, aTexture, mGLContext);
 
   Rect layerRects[4];
   Rect textureRects[4];
@@ -596,6 +624,7 @@ CompositorOGL::SetRenderTarget(CompositingRenderTarget *aSurface)
   MOZ_ASSERT(aSurface);
   CompositingRenderTargetOGL* surface
     = static_cast<CompositingRenderTargetOGL*>(aSurface);
+  FlushQuadBatch();
   if (mCurrentRenderTarget != surface) {
     mCurrentRenderTarget = surface;
     if (mCurrentRenderTarget) {
@@ -628,6 +657,8 @@ GetFrameBufferInternalFormat(GLContext* gl,
 void
 CompositorOGL::ClearRect(const gfx::Rect& aRect)
 {
+  FlushQuadBatch();
+
   // Map aRect to OGL coordinates, origin:bottom-left
   GLint y = mViewportSize.height - (aRect.y + aRect.height);
 
@@ -732,6 +763,8 @@ CompositorOGL::CreateTexture(const IntRect& aRect, bool aCopyFromSource, GLuint
   // of just clamping the framebuffer's size to the max supported size.
   // This gives us a lower resolution rendering of the intermediate surface (children layers).
   // See bug 827170 for a discussion.
+  FlushQuadBatch();
+
   IntRect clampedRect = aRect;
   int32_t maxTexSize = GetMaxTextureSize();
   clampedRect.width = std::min(clampedRect.width, maxTexSize);
@@ -914,6 +947,7 @@ CompositorOGL::ActivateProgram(ShaderProgramOGL* aProg)
 void
 CompositorOGL::ResetProgram()
 {
+  FlushQuadBatch();
   mCurrentProgram = nullptr;
 }
 
@@ -1023,6 +1057,11 @@ CompositorOGL::DrawQuad(const Rect& aRect,
     return;
   }
 
+  if (BatchQuad(aRect, aClipRect, aEffectChain, aOpacity, aTransform)) {
+    return;
+  }
+  FlushQuadBatch();
+
   LayerScope::DrawBegin();
 
   IntRect clipRect = aClipRect;
@@ -1439,6 +1478,238 @@ CompositorOGL::DrawQuad(const Rect& aRect,
   LayerScope::DrawEnd(mGLContext, aEffectChain, aRect.width, aRect.height);
 }
 
+// The number of quads after which the quad batch is flushed even if more
+// quads could go in it, to keep the vertex buffer uploads reasonably small.
+static const size_t kMaxBatchedQuads = 1024;
+
+bool
+CompositorOGL::BatchQuad(const Rect& aRect,
+                         const IntRect& aClipRect,
+                         const EffectChain& aEffectChain,
+                         Float aOpacity,
+                         const gfx::Matrix4x4& aTransform)
+{
+  // LayerScope wants to see every quad as its own draw call.
+  if (!gfxPrefs::LayersBatchQuadsEnabled() || gfxPrefs::LayerScopeEnabled()) {
+    return false;
+  }
+
+  for (const RefPtr<Effect>& effect : aEffectChain.mSecondaryEffects) {
+    if (effect) {
+      return false;
+    }
+  }
+
+  // Batched quads are clipped on the CPU instead of with the scissor rect,
+  // which is only exact if the transform keeps rectangles rectangles. This
+  // still covers the scale and translation transforms of most layers.
+  Matrix transform;
+  if (!aTransform.Is2D(&transform) ||
+      !transform.PreservesAxisAlignedRectangles() ||
+      (gfxPrefs::LayersDEAAEnabled() && !aTransform.Is2DIntegerTranslation())) {
+    return false;
+  }
+  Matrix inverse = transform;
+  if (!inverse.Invert()) {
+    return false;
+  }
+
+  Effect* primaryEffect = aEffectChain.mPrimaryEffect;
+  TextureSource* source = nullptr;
+  gfx::SamplingFilter samplingFilter = gfx::SamplingFilter::GOOD;
+  bool premultiplied = true;
+  Rect texCoordRect;
+  Color color;
+  switch (primaryEffect->mType) {
+  case EffectTypes::SOLID_COLOR: {
+    // Fold the opacity into the color, as DrawQuad does.
+    color = static_cast<EffectSolidColor*>(primaryEffect)->mColor;
+    Float opacity = aOpacity * color.a;
+    color.r *= opacity;
+    color.g *= opacity;
+    color.b *= opacity;
+    color.a = opacity;
+    aOpacity = 1.f;
+    break;
+  }
+  case EffectTypes::RGB: {
+    TexturedEffect* texturedEffect = static_cast<TexturedEffect*>(primaryEffect);
+    source = texturedEffect->mTexture;
+    // Data texture sources own their textures, so those can't be changed
+    // under us before the batch is flushed. Big images bind a different
+    // texture for each of their tiles, though.
+    BigImageIterator* bigImage = source->AsBigImageIterator();
+    if (!source->AsDataTextureSource() ||
+        (bigImage && bigImage->GetTileCount() > 1)) {
+      return false;
+    }
+    samplingFilter = texturedEffect->mSamplingFilter;
+    premultiplied = texturedEffect->mPremultiplied;
+    texCoordRect = texturedEffect->mTextureCoords;
+    break;
+  }
+  default:
+    return false;
+  }
+
+  ShaderConfigOGL config = GetShaderConfigFor(primaryEffect);
+  if (config.mFeatures & ENABLE_TEXTURE_RECT) {
+    return false;
+  }
+  config.SetOpacity(aOpacity != 1.f);
+  config.SetQuadBatch(true);
+  ShaderProgramOGL* program = GetShaderProgramFor(config);
+  if (!program) {
+    return false;
+  }
+
+  if (!mBatchVertices.IsEmpty() &&
+      (program != mBatchProgram ||
+       source != mBatchTexture ||
+       samplingFilter != mBatchSamplingFilter ||
+       premultiplied != mBatchPremultiplied ||
+       aOpacity != mBatchOpacity ||
+       mBatchVertices.Length() >= kMaxBatchedQuads * 6)) {
+    FlushQuadBatch();
+  }
+  mBatchProgram = program;
+  mBatchTexture = source;
+  mBatchSamplingFilter = samplingFilter;
+  mBatchPremultiplied = premultiplied;
+  mBatchOpacity = aOpacity;
+
+  // aClipRect is relative to the render target, aTransform isn't.
+  IntPoint offset = mCurrentRenderTarget->GetOrigin();
+  Rect clipRect(aClipRect);
+  clipRect.MoveBy(offset.x, offset.y);
+  Rect layerClipRect = inverse.TransformBounds(clipRect);
+
+  if (!source) {
+    AppendBatchedQuad(aRect, aRect, layerClipRect, transform, Matrix4x4(), color);
+    return true;
+  }
+
+  Rect layerRects[4];
+  Rect textureRects[4];
+  size_t rects = DecomposeIntoNoRepeatRects(aRect,
+                                            ScaleTexCoordRectForPOT(texCoordRect, source, mGLContext),
+                                            &layerRects,
+                                            &textureRects);
+  Matrix4x4 textureTransform = source->AsSourceOGL()->GetTextureTransform();
+  for (size_t i = 0; i < rects; i++) {
+    AppendBatchedQuad(layerRects[i], textureRects[i], layerClipRect,
+                      transform, textureTransform, color);
+  }
+  return true;
+}
+
+void
+CompositorOGL::AppendBatchedQuad(const Rect& aRect,
+                                 const Rect& aTexCoordRect,
+                                 const Rect& aClipRect,
+                                 const Matrix& aTransform,
+                                 const Matrix4x4& aTextureTransform,
+                                 const Color& aColor)
+{
+  Rect rect = aRect.Intersect(aClipRect);
+  if (rect.IsEmpty()) {
+    return;
+  }
+
+  // The transform keeps rectangles rectangles, so interpolating the texture
+  // coordinates over the clipped rect gives the same result as clipping the
+  // whole quad with the scissor rect.
+  Float xScale = aTexCoordRect.width / aRect.width;
+  Float yScale = aTexCoordRect.height / aRect.height;
+  const Point corners[4] = {
+    rect.TopLeft(), rect.TopRight(), rect.BottomLeft(), rect.BottomRight()
+  };
+  BatchVertex vertices[4];
+  for (size_t i = 0; i < 4; i++) {
+    Point position = aTransform.TransformPoint(corners[i]);
+    Point texCoord(aTexCoordRect.x + (corners[i].x - aRect.x) * xScale,
+                   aTexCoordRect.y + (corners[i].y - aRect.y) * yScale);
+    texCoord = aTextureTransform.TransformPoint(texCoord);
+    vertices[i] = { position.x, position.y, texCoord.x, texCoord.y,
+                    aColor.r, aColor.g, aColor.b, aColor.a };
+  }
+
+  // The same two triangles as in mQuadVBO.
+  static const size_t kQuadIndices[6] = { 0, 1, 2, 1, 2, 3 };
+  for (size_t index : kQuadIndices) {
+    mBatchVertices.AppendElement(vertices[index]);
+  }
+}
+
+void
+CompositorOGL::FlushQuadBatch()
+{
+  if (mBatchVertices.IsEmpty()) {
+    return;
+  }
+
+  PROFILER_LABEL("CompositorOGL", "FlushQuadBatch",
+    js::ProfileEntry::Category::GRAPHICS);
+
+  ShaderProgramOGL* program = mBatchProgram;
+  ActivateProgram(program);
+  program->SetProjectionMatrix(mProjMatrix);
+  IntPoint offset = mCurrentRenderTarget->GetOrigin();
+  program->SetRenderOffset(offset.x, offset.y);
+
+  GLuint attribIndex;
+  if (mBatchTexture) {
+    mBatchTexture->AsSourceOGL()->BindTexture(LOCAL_GL_TEXTURE0, mBatchSamplingFilter);
+    program->SetTextureUnit(0);
+    if (mBatchOpacity != 1.f) {
+      program->SetLayerOpacity(mBatchOpacity);
+    }
+    attribIndex = ShaderProgramOGL::kTexCoordAttribIndex;
+  } else {
+    attribIndex = ShaderProgramOGL::kColorAttribIndex;
+  }
+  bool didSetBlendMode =
+    SetBlendMode(gl(), gfx::CompositionOp::OP_OVER, mBatchPremultiplied);
+
+  // The quads have already been clipped.
+  ScopedGLState scopedScissorTestState(mGLContext, LOCAL_GL_SCISSOR_TEST, false);
+
+  const GLsizei stride = sizeof(BatchVertex);
+  mGLContext->fBindBuffer(LOCAL_GL_ARRAY_BUFFER, mBatchVBO);
+  mGLContext->fBufferData(LOCAL_GL_ARRAY_BUFFER,
+                          mBatchVertices.Length() * stride,
+                          mBatchVertices.Elements(),
+                          LOCAL_GL_STREAM_DRAW);
+  mGLContext->fVertexAttribPointer(ShaderProgramOGL::kCoordAttribIndex, 2,
+                                   LOCAL_GL_FLOAT, LOCAL_GL_FALSE, stride,
+                                   (GLvoid*) offsetof(BatchVertex, mX));
+  mGLContext->fEnableVertexAttribArray(ShaderProgramOGL::kCoordAttribIndex);
+  if (mBatchTexture) {
+    mGLContext->fVertexAttribPointer(attribIndex, 2,
+                                     LOCAL_GL_FLOAT, LOCAL_GL_FALSE, stride,
+                                     (GLvoid*) offsetof(BatchVertex, mU));
+  } else {
+    mGLContext->fVertexAttribPointer(attribIndex, 4,
+                                     LOCAL_GL_FLOAT, LOCAL_GL_FALSE, stride,
+                                     (GLvoid*) offsetof(BatchVertex, mR));
+  }
+  mGLContext->fEnableVertexAttribArray(attribIndex);
+
+  mGLContext->fDrawArrays(LOCAL_GL_TRIANGLES, 0, GLsizei(mBatchVertices.Length()));
+
+  // Only the batch programs read this attribute.
+  mGLContext->fDisableVertexAttribArray(attribIndex);
+
+  if (didSetBlendMode) {
+    gl()->fBlendFuncSeparate(LOCAL_GL_ONE, LOCAL_GL_ONE_MINUS_SRC_ALPHA,
+                             LOCAL_GL_ONE, LOCAL_GL_ONE_MINUS_SRC_ALPHA);
+  }
+
+  mBatchVertices.SetLengthAndRetainStorage(0);
+  mBatchProgram = nullptr;
+  mBatchTexture = nullptr;
+}
+
 void
 CompositorOGL::EndFrame()
 {
@@ -1447,6 +1718,8 @@ CompositorOGL::EndFrame()
 
   MOZ_ASSERT(mCurrentRenderTarget == mWindowRenderTarget, "Rendering target not properly restored");
 
+  FlushQuadBatch();
+
 #ifdef MOZ_DUMP_PAINTING
   if (gfxEnv::DumpCompositorTextures()) {
     LayoutDeviceIntSize size;
@@ -1500,11 +1773,21 @@ void
 CompositorOGL::EndFrameForExternalComposition(const gfx::Matrix& aTransform)
 {
   MOZ_ASSERT(!mTarget);
+  FlushQuadBatch();
   if (mTexturePool) {
     mTexturePool->EndFrame();
   }
 }
 
+void
+CompositorOGL::WaitForGPU()
+{
+  if (!mGLContext || !mGLContext->MakeCurrent()) {
+    return;
+  }
+  mGLContext->fFinish();
+}
+
 void
 CompositorOGL::SetDestinationSurfaceSize(const IntSize& aSize)
 {
@@ -214,6 +214,8 @@ public:
   virtual void EndFrame() override;
   virtual void EndFrameForExternalComposition(const gfx::Matrix& aTransform) override;
 
+  virtual void WaitForGPU() override;
+
   virtual bool SupportsPartialTextureUpdate() override;
 
   virtual bool CanUseCanvasLayerForSize(const gfx::IntSize &aSize) override
@@ -275,7 +277,8 @@ public:
   GLContext* gl() const { return mGLContext; }
   /**
    * Clear the program state. This must be called
-   * before operating on the GLContext directly. */
+   * before operating on the GLContext directly. This also draws any quads
+   * that are still waiting in the quad batch. */
   void ResetProgram();
 
   gfx::SurfaceFormat GetFBOFormat() const {
@@ -409,6 +412,29 @@ private:
   void ActivateProgram(ShaderProgramOGL *aProg);
   void CleanupResources();
 
+  /**
+   * Adds the quad to the quad batch if it can be drawn by one of the quad
+   * batch programs, flushing the batch first if the quad needs different GL
+   * state than the quads already in it. Returns false if the quad has to be
+   * drawn on its own.
+   */
+  bool BatchQuad(const gfx::Rect& aRect,
+                 const gfx::IntRect& aClipRect,
+                 const EffectChain& aEffectChain,
+                 gfx::Float aOpacity,
+                 const gfx::Matrix4x4& aTransform);
+  void AppendBatchedQuad(const gfx::Rect& aRect,
+                         const gfx::Rect& aTexCoordRect,
+                         const gfx::Rect& aClipRect,
+                         const gfx::Matrix& aTransform,
+                         const gfx::Matrix4x4& aTextureTransform,
+                         const gfx::Color& aColor);
+  /**
+   * Draws the quads in the quad batch. This has to be called before anything
+   * else touches the current render target or the GL state.
+   */
+  void FlushQuadBatch();
+
   /**
    * Bind the texture behind the current render target as the backdrop for a
    * mix-blend shader.
@@ -446,6 +472,27 @@ private:
 
   ShaderProgramOGL *mCurrentProgram;
 
+  /**
+   * Quads that share their program, texture and opacity are not drawn right
+   * away but collected in the quad batch, as triangles that are already
+   * transformed and clipped to their clip rect, so that they can be drawn
+   * with a single draw call. Solid color quads keep their color in the
+   * vertices, so consecutive color layers of any color end up in the same
+   * batch.
+   */
+  struct BatchVertex {
+    GLfloat mX, mY;
+    GLfloat mU, mV;
+    GLfloat mR, mG, mB, mA;
+  };
+  nsTArray<BatchVertex> mBatchVertices;
+  ShaderProgramOGL* mBatchProgram;
+  RefPtr<TextureSource> mBatchTexture;
+  gfx::SamplingFilter mBatchSamplingFilter;
+  bool mBatchPremultiplied;
+  gfx::Float mBatchOpacity;
+  GLuint mBatchVBO;
+
 #if defined(MOZ_WIDGET_GONK) && ANDROID_VERSION >= 21
   nsTHashtable<nsPtrHashKey<ImageHostOverlay> > mImageHostOverlays;
 #endif
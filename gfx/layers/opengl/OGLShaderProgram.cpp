@@ -155,6 +155,13 @@ ShaderConfigOGL::SetDEAA(bool aEnabled)
   SetFeature(ENABLE_DEAA, aEnabled);
 }
 
+void
+ShaderConfigOGL::SetQuadBatch(bool aEnabled)
+{
+  SetFeature(ENABLE_QUAD_BATCH, aEnabled);
+  MOZ_ASSERT(!(mFeatures & (ENABLE_MASK | ENABLE_DEAA)));
+}
+
 void
 ShaderConfigOGL::SetCompositionOp(gfx::CompositionOp aOp)
 {
@@ -187,6 +194,16 @@ ProgramProfileOGL::GetProfileFor(ShaderConfigOGL aConfig)
   }
   vs << "uniform vec2 uRenderTargetOffset;" << endl;
   vs << "attribute vec4 aCoord;" << endl;
+  if (aConfig.mFeatures & ENABLE_QUAD_BATCH) {
+    // Batched quads come in as triangles that are already transformed and
+    // clipped, with their texture coordinates or color in the vertices.
+    if (aConfig.mFeatures & ENABLE_RENDER_COLOR) {
+      vs << "attribute vec4 aColor;" << endl;
+      vs << "varying vec4 vColor;" << endl;
+    } else {
+      vs << "attribute vec2 aTexCoord;" << endl;
+    }
+  }
 
   if (!(aConfig.mFeatures & ENABLE_RENDER_COLOR)) {
     vs << "uniform mat4 uTextureTransform;" << endl;
@@ -205,10 +222,19 @@ ProgramProfileOGL::GetProfileFor(ShaderConfigOGL aConfig)
   }
 
   vs << "void main() {" << endl;
-  vs << "  int vertexID = int(aCoord.w);" << endl;
-  vs << "  vec4 layerRect = uLayerRects[vertexID];" << endl;
-  vs << "  vec4 finalPosition = vec4(aCoord.xy * layerRect.zw + layerRect.xy, 0.0, 1.0);" << endl;
-  vs << "  finalPosition = uLayerTransform * finalPosition;" << endl;
+  if (aConfig.mFeatures & ENABLE_QUAD_BATCH) {
+    vs << "  vec4 finalPosition = vec4(aCoord.xy, 0.0, 1.0);" << endl;
+    if (aConfig.mFeatures & ENABLE_RENDER_COLOR) {
+      vs << "  vColor = aColor;" << endl;
+    } else {
+      vs << "  vTexCoord = aTexCoord;" << endl;
+    }
+  } else {
+    vs << "  int vertexID = int(aCoord.w);" << endl;
+    vs << "  vec4 layerRect = uLayerRects[vertexID];" << endl;
+    vs << "  vec4 finalPosition = vec4(aCoord.xy * layerRect.zw + layerRect.xy, 0.0, 1.0);" << endl;
+    vs << "  finalPosition = uLayerTransform * finalPosition;" << endl;
+  }
 
   if (aConfig.mFeatures & ENABLE_DEAA) {
     // XXX kip - The DEAA shader could be made simpler if we switch to
@@ -264,7 +290,7 @@ ProgramProfileOGL::GetProfileFor(ShaderConfigOGL aConfig)
       vs << "  vTexCoord = (uTextureTransform * vec4(texCoord, 0.0, 1.0)).xy;" << endl;
     }
 
-  } else if (!(aConfig.mFeatures & ENABLE_RENDER_COLOR)) {
+  } else if (!(aConfig.mFeatures & (ENABLE_RENDER_COLOR | ENABLE_QUAD_BATCH))) {
     vs << "  vec4 textureRect = uTextureRects[vertexID];" << endl;
     vs << "  vec2 texCoord = aCoord.xy * textureRect.zw + textureRect.xy;" << endl;
     vs << "  vTexCoord = (uTextureTransform * vec4(texCoord, 0.0, 1.0)).xy;" << endl;
@@ -303,7 +329,11 @@ ProgramProfileOGL::GetProfileFor(ShaderConfigOGL aConfig)
   fs << "#define EDGE_PRECISION" << endl;
   fs << "#endif" << endl;
   if (aConfig.mFeatures & ENABLE_RENDER_COLOR) {
-    fs << "uniform COLOR_PRECISION vec4 uRenderColor;" << endl;
+    if (aConfig.mFeatures & ENABLE_QUAD_BATCH) {
+      fs << "varying vec4 vColor;" << endl;
+    } else {
+      fs << "uniform COLOR_PRECISION vec4 uRenderColor;" << endl;
+    }
   } else {
     // for tiling, texcoord can be greater than the lowfp range
     fs << "varying vec2 vTexCoord;" << endl;
@@ -476,7 +506,11 @@ For [0,1] instead of [0,255], and to 5 places:
   }
   fs << "void main() {" << endl;
   if (aConfig.mFeatures & ENABLE_RENDER_COLOR) {
-    fs << "  vec4 color = uRenderColor;" << endl;
+    if (aConfig.mFeatures & ENABLE_QUAD_BATCH) {
+      fs << "  vec4 color = vColor;" << endl;
+    } else {
+      fs << "  vec4 color = uRenderColor;" << endl;
+    }
   } else {
     fs << "  vec4 color = sample(vTexCoord);" << endl;
     if (aConfig.mFeatures & ENABLE_BLUR) {
@@ -862,6 +896,10 @@ ShaderProgramOGL::CreateProgram(const char *aVertexShaderString,
   mGL->fAttachShader(result, vertexShader);
   mGL->fAttachShader(result, fragmentShader);
 
+  mGL->fBindAttribLocation(result, kCoordAttribIndex, "aCoord");
+  mGL->fBindAttribLocation(result, kTexCoordAttribIndex, "aTexCoord");
+  mGL->fBindAttribLocation(result, kColorAttribIndex, "aColor");
+
   mGL->fLinkProgram(result);
 
   GLint success, len;
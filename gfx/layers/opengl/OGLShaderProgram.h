@@ -39,7 +39,8 @@ enum ShaderFeatures {
   ENABLE_COLOR_MATRIX=0x400,
   ENABLE_MASK=0x800,
   ENABLE_NO_PREMUL_ALPHA=0x1000,
-  ENABLE_DEAA=0x2000
+  ENABLE_DEAA=0x2000,
+  ENABLE_QUAD_BATCH=0x4000
 };
 
 class KnownUniform {
@@ -224,6 +225,7 @@ public:
   void SetBlur(bool aEnabled);
   void SetMask(bool aEnabled);
   void SetDEAA(bool aEnabled);
+  void SetQuadBatch(bool aEnabled);
   void SetCompositionOp(gfx::CompositionOp aOp);
   void SetNoPremultipliedAlpha();
 
@@ -313,6 +315,12 @@ class ShaderProgramOGL
 public:
   typedef mozilla::gl::GLContext GLContext;
 
+  // The locations the vertex attributes of our shaders are bound to. Only
+  // the quad batch shaders use more than aCoord.
+  static const GLuint kCoordAttribIndex = 0;
+  static const GLuint kTexCoordAttribIndex = 1;
+  static const GLuint kColorAttribIndex = 2;
+
   ShaderProgramOGL(GLContext* aGL, const ProgramProfileOGL& aProfile);
 
   ~ShaderProgramOGL();
@@ -0,0 +1,114 @@
+#include <arm_neon.h>
+
+#include "qcmsint.h"
+
+/* Same output table scaling and clamping as the SSE2 path. */
+#define FLOATSCALE  (float)(PRECACHE_OUTPUT_SIZE)
+#define CLAMPMAXVAL ( ((float) (PRECACHE_OUTPUT_SIZE - 1)) / PRECACHE_OUTPUT_SIZE )
+
+/* Transforms a single pixel and returns the four output table indices.
+ * vcvtq_u32_f32 truncates, so 0.5 is added first to match the rounding of
+ * _mm_cvtps_epi32 closely enough; the clamp keeps every index below
+ * PRECACHE_OUTPUT_SIZE either way. */
+static inline uint32x4_t
+transform_pixel_neon(float r, float g, float b,
+                     float32x4_t mat0, float32x4_t mat1, float32x4_t mat2,
+                     float32x4_t min, float32x4_t max,
+                     float32x4_t scale, float32x4_t half)
+{
+    float32x4_t vec_r = vmulq_n_f32(mat0, r);
+    vec_r = vmlaq_n_f32(vec_r, mat1, g);
+    vec_r = vmlaq_n_f32(vec_r, mat2, b);
+    vec_r = vmaxq_f32(min, vec_r);
+    vec_r = vminq_f32(max, vec_r);
+    return vcvtq_u32_f32(vmlaq_f32(half, vec_r, scale));
+}
+
+void qcms_transform_data_rgb_out_lut_neon(qcms_transform *transform,
+                                          unsigned char *src,
+                                          unsigned char *dest,
+                                          size_t length)
+{
+    size_t i;
+    float (*mat)[4] = transform->matrix;
+    uint32_t output[4];
+
+    /* deref *transform now to avoid it in loop */
+    const float *igtbl_r = transform->input_gamma_table_r;
+    const float *igtbl_g = transform->input_gamma_table_g;
+    const float *igtbl_b = transform->input_gamma_table_b;
+
+    const uint8_t *otdata_r = &transform->output_table_r->data[0];
+    const uint8_t *otdata_g = &transform->output_table_g->data[0];
+    const uint8_t *otdata_b = &transform->output_table_b->data[0];
+
+    /* input matrix values never change */
+    const float32x4_t mat0 = vld1q_f32(mat[0]);
+    const float32x4_t mat1 = vld1q_f32(mat[1]);
+    const float32x4_t mat2 = vld1q_f32(mat[2]);
+
+    /* these values don't change, either */
+    const float32x4_t max   = vdupq_n_f32(CLAMPMAXVAL);
+    const float32x4_t min   = vdupq_n_f32(0.0f);
+    const float32x4_t scale = vdupq_n_f32(FLOATSCALE);
+    const float32x4_t half  = vdupq_n_f32(0.5f);
+
+    for (i = 0; i < length; i++) {
+        vst1q_u32(output,
+                  transform_pixel_neon(igtbl_r[src[0]], igtbl_g[src[1]],
+                                       igtbl_b[src[2]], mat0, mat1, mat2,
+                                       min, max, scale, half));
+        src += 3;
+
+        dest[OUTPUT_R_INDEX] = otdata_r[output[0]];
+        dest[OUTPUT_G_INDEX] = otdata_g[output[1]];
+        dest[OUTPUT_B_INDEX] = otdata_b[output[2]];
+        dest += RGB_OUTPUT_COMPONENTS;
+    }
+}
+
+void qcms_transform_data_rgba_out_lut_neon(qcms_transform *transform,
+                                           unsigned char *src,
+                                           unsigned char *dest,
+                                           size_t length)
+{
+    size_t i;
+    float (*mat)[4] = transform->matrix;
+    uint32_t output[4];
+
+    /* deref *transform now to avoid it in loop */
+    const float *igtbl_r = transform->input_gamma_table_r;
+    const float *igtbl_g = transform->input_gamma_table_g;
+    const float *igtbl_b = transform->input_gamma_table_b;
+
+    const uint8_t *otdata_r = &transform->output_table_r->data[0];
+    const uint8_t *otdata_g = &transform->output_table_g->data[0];
+    const uint8_t *otdata_b = &transform->output_table_b->data[0];
+
+    /* input matrix values never change */
+    const float32x4_t mat0 = vld1q_f32(mat[0]);
+    const float32x4_t mat1 = vld1q_f32(mat[1]);
+    const float32x4_t mat2 = vld1q_f32(mat[2]);
+
+    /* these values don't change, either */
+    const float32x4_t max   = vdupq_n_f32(CLAMPMAXVAL);
+    const float32x4_t min   = vdupq_n_f32(0.0f);
+    const float32x4_t scale = vdupq_n_f32(FLOATSCALE);
+    const float32x4_t half  = vdupq_n_f32(0.5f);
+
+    for (i = 0; i < length; i++) {
+        unsigned char alpha = src[3];
+
+        vst1q_u32(output,
+                  transform_pixel_neon(igtbl_r[src[0]], igtbl_g[src[1]],
+                                       igtbl_b[src[2]], mat0, mat1, mat2,
+                                       min, max, scale, half));
+        src += 4;
+
+        dest[OUTPUT_R_INDEX] = otdata_r[output[0]];
+        dest[OUTPUT_G_INDEX] = otdata_g[output[1]];
+        dest[OUTPUT_B_INDEX] = otdata_b[output[2]];
+        dest[OUTPUT_A_INDEX] = alpha;
+        dest += RGBA_OUTPUT_COMPONENTS;
+    }
+}
@@ -1303,6 +1303,16 @@ qcms_transform* qcms_transform_create(
 			    else
 				    transform->transform_fn = qcms_transform_data_rgba_out_lut_altivec;
 		    } else
+#endif
+#ifdef QCMS_HAVE_NEON
+		    /* Only built when NEON is part of the target baseline, so
+		     * no runtime check is needed. */
+		    if (1) {
+			    if (in_type == QCMS_DATA_RGB_8)
+				    transform->transform_fn = qcms_transform_data_rgb_out_lut_neon;
+			    else
+				    transform->transform_fn = qcms_transform_data_rgba_out_lut_neon;
+		    } else
 #endif
 			{
 				if (in_type == QCMS_DATA_RGB_8)
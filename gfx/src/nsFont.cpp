@@ -288,7 +288,7 @@ void nsFont::AddFontFeaturesToStyle(gfxFontStyle *aStyle) const
     (variantPosition == NS_FONT_VARIANT_POSITION_NORMAL);
 
   // add in features from font-feature-settings
-  aStyle->featureSettings.AppendElements(fontFeatureSettings);
+  aStyle->featureSettings.AppendElements(fontFeatureSettings.Array());
 
   // enable grayscale antialiasing for text
   if (smoothing == NS_FONT_SMOOTHING_GRAYSCALE) {
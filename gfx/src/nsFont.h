@@ -12,6 +12,7 @@
 #include "gfxFontFeatures.h"
 #include "mozilla/RefPtr.h"             // for RefPtr
 #include "nsCoord.h"                    // for nscoord
+#include "nsCopyOnWriteArray.h"         // for nsCopyOnWriteArray
 #include "nsStringFwd.h"                // for nsSubstring
 #include "nsString.h"               // for nsString
 #include "nsTArray.h"                   // for nsTArray
@@ -98,8 +99,10 @@ struct nsFont {
   // -- object used to look these up once the font is matched
   RefPtr<gfxFontFeatureValueSet> featureValueLookup;
 
-  // Font features from CSS font-feature-settings
-  nsTArray<gfxFontFeature> fontFeatureSettings;
+  // Font features from CSS font-feature-settings. These are inherited by
+  // every element and copied into each transformed character's style, so
+  // copies share them.
+  nsCopyOnWriteArray<gfxFontFeature> fontFeatureSettings;
 
   // Language system tag, to override document language;
   // this is an OpenType "language system" tag represented as a 32-bit integer
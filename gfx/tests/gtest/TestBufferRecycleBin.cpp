@@ -0,0 +1,45 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "gtest/gtest.h"
+
+#include "ImageContainer.h"
+
+using namespace mozilla;
+using namespace mozilla::layers;
+
+// The size of a 1920x1080 I420 frame, and of the same frame padded to 1088
+// rows, as some decoders output it.
+static const uint32_t k1080Size = 1920 * 1080 * 3 / 2;
+static const uint32_t k1088Size = 1920 * 1088 * 3 / 2;
+
+TEST(Layers, BufferRecycleBinReusesCloseSizes)
+{
+  RefPtr<BufferRecycleBin> bin = new BufferRecycleBin();
+  UniquePtr<uint8_t[]> buffer = bin->GetBuffer(k1080Size);
+  uint8_t* data = buffer.get();
+  bin->RecycleBuffer(Move(buffer), k1080Size);
+
+  buffer = bin->GetBuffer(k1088Size);
+  EXPECT_EQ(data, buffer.get());
+  // The buffer must be large enough for the padded frame.
+  buffer[k1088Size - 1] = 0;
+}
+
+TEST(Layers, BufferRecycleBinKeepsSeveralSizeClassesUpToLimit)
+{
+  RefPtr<BufferRecycleBin> bin = new BufferRecycleBin(2 * k1088Size);
+  UniquePtr<uint8_t[]> small = bin->GetBuffer(640 * 480);
+  UniquePtr<uint8_t[]> large = bin->GetBuffer(k1080Size);
+  uint8_t* smallData = small.get();
+  uint8_t* largeData = large.get();
+  bin->RecycleBuffer(Move(small), 640 * 480);
+  bin->RecycleBuffer(Move(large), k1080Size);
+
+  small = bin->GetBuffer(640 * 480);
+  large = bin->GetBuffer(k1080Size);
+  EXPECT_EQ(smallData, small.get());
+  EXPECT_EQ(largeData, large.get());
+}
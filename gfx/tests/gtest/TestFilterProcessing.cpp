@@ -0,0 +1,120 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "gtest/gtest.h"
+#include "gtest/MozGTestBench.h"
+
+#include "FilterProcessing.h"
+
+using namespace mozilla;
+using namespace mozilla::gfx;
+
+static already_AddRefed<DataSourceSurface>
+CreateTestSurface(const IntSize& aSize, uint32_t aSeed)
+{
+  RefPtr<DataSourceSurface> surface =
+    Factory::CreateDataSourceSurface(aSize, SurfaceFormat::B8G8R8A8);
+  if (!surface) {
+    return nullptr;
+  }
+  uint8_t* data = surface->GetData();
+  int32_t stride = surface->Stride();
+  for (int32_t y = 0; y < aSize.height; y++) {
+    for (int32_t x = 0; x < aSize.width; x++) {
+      aSeed = aSeed * 1103515245 + 12345;
+      uint8_t alpha = aSeed >> 24;
+      uint8_t* pixel = &data[y * stride + 4 * x];
+      pixel[B8G8R8A8_COMPONENT_BYTEOFFSET_B] = ((aSeed >> 16) & 0xff) * alpha / 255;
+      pixel[B8G8R8A8_COMPONENT_BYTEOFFSET_G] = ((aSeed >> 8) & 0xff) * alpha / 255;
+      pixel[B8G8R8A8_COMPONENT_BYTEOFFSET_R] = (aSeed & 0xff) * alpha / 255;
+      pixel[B8G8R8A8_COMPONENT_BYTEOFFSET_A] = alpha;
+    }
+  }
+  return surface.forget();
+}
+
+static bool
+SurfacesEqual(DataSourceSurface* aA, DataSourceSurface* aB)
+{
+  IntSize size = aA->GetSize();
+  for (int32_t y = 0; y < size.height; y++) {
+    if (memcmp(aA->GetData() + y * aA->Stride(),
+               aB->GetData() + y * aB->Stride(), size.width * 4)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Widths that leave a partial vector at the end of every row, so that
+// whichever SIMD path we end up on has to deal with the row padding.
+TEST(FilterProcessing, ColorMatrixIdentity) {
+  for (int32_t width = 1; width <= 19; width++) {
+    RefPtr<DataSourceSurface> input = CreateTestSurface(IntSize(width, 3), width);
+    ASSERT_TRUE(input);
+    Matrix5x4 identity;
+    RefPtr<DataSourceSurface> result =
+      FilterProcessing::ApplyColorMatrix(input, identity);
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(SurfacesEqual(input, result));
+  }
+}
+
+TEST(FilterProcessing, CompositionOverTransparent) {
+  for (int32_t width = 1; width <= 19; width++) {
+    IntSize size(width, 3);
+    RefPtr<DataSourceSurface> dest = CreateTestSurface(size, width);
+    RefPtr<DataSourceSurface> expected = CreateTestSurface(size, width);
+    RefPtr<DataSourceSurface> source =
+      Factory::CreateDataSourceSurface(size, SurfaceFormat::B8G8R8A8, true);
+    ASSERT_TRUE(dest && expected && source);
+    FilterProcessing::ApplyComposition(source, dest, COMPOSITE_OPERATOR_OVER);
+    EXPECT_TRUE(SurfacesEqual(expected, dest));
+  }
+}
+
+static const IntSize kBenchmarkSize(1024, 1024);
+
+static void
+FilterProcessing_BlendingPerformance()
+{
+  RefPtr<DataSourceSurface> input1 = CreateTestSurface(kBenchmarkSize, 1);
+  RefPtr<DataSourceSurface> input2 = CreateTestSurface(kBenchmarkSize, 2);
+  for (int i = 0; i < 10; i++) {
+    RefPtr<DataSourceSurface> result =
+      FilterProcessing::ApplyBlending(input1, input2, BLEND_MODE_SCREEN);
+    ASSERT_TRUE(result);
+  }
+}
+
+MOZ_GTEST_BENCH(FilterProcessing, BlendingPerformance, &FilterProcessing_BlendingPerformance);
+
+static void
+FilterProcessing_ColorMatrixPerformance()
+{
+  RefPtr<DataSourceSurface> input = CreateTestSurface(kBenchmarkSize, 1);
+  Matrix5x4 matrix;
+  matrix._12 = 0.5f;
+  matrix._54 = 0.25f;
+  for (int i = 0; i < 10; i++) {
+    RefPtr<DataSourceSurface> result =
+      FilterProcessing::ApplyColorMatrix(input, matrix);
+    ASSERT_TRUE(result);
+  }
+}
+
+MOZ_GTEST_BENCH(FilterProcessing, ColorMatrixPerformance, &FilterProcessing_ColorMatrixPerformance);
+
+static void
+FilterProcessing_CompositionPerformance()
+{
+  RefPtr<DataSourceSurface> source = CreateTestSurface(kBenchmarkSize, 1);
+  RefPtr<DataSourceSurface> dest = CreateTestSurface(kBenchmarkSize, 2);
+  for (int i = 0; i < 10; i++) {
+    FilterProcessing::ApplyComposition(source, dest, COMPOSITE_OPERATOR_OVER);
+  }
+}
+
+MOZ_GTEST_BENCH(FilterProcessing, CompositionPerformance, &FilterProcessing_CompositionPerformance);
@@ -7,6 +7,7 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 #include "LayerUserData.h"
+#include "LayerTreeInvalidation.h"
 #include "mozilla/layers/LayerMetricsWrapper.h"
 #include "mozilla/layers/CompositorBridgeParent.h"
 
@@ -352,6 +353,52 @@ TEST(Layers, RepositionChild) {
   ASSERT_EQ(nullptr, layers[1]->GetNextSibling());
 }
 
+TEST(Layers, MutatedSubtrees) {
+  const char* layerTreeSyntax = "c(c(tt)c(t))";
+  nsIntRegion layerVisibleRegion[] = {
+    nsIntRegion(IntRect(0,0,100,100)),
+    nsIntRegion(IntRect(0,0,50,100)),
+    nsIntRegion(IntRect(0,0,50,50)),
+    nsIntRegion(IntRect(0,50,50,50)),
+    nsIntRegion(IntRect(50,0,50,100)),
+    nsIntRegion(IntRect(50,0,50,100)),
+  };
+  nsTArray<RefPtr<Layer> > layers;
+  RefPtr<LayerManager> lm;
+  RefPtr<Layer> root = CreateLayerTree(layerTreeSyntax, layerVisibleRegion, nullptr, lm, layers);
+
+  LayerProperties::ClearInvalidations(root);
+  for (uint32_t i = 0; i < layers.Length(); i++) {
+    ASSERT_FALSE(layers[i]->IsSubtreeMutated());
+  }
+
+  UniquePtr<LayerProperties> props = LayerProperties::CloneFrom(root);
+  layers[5]->SetOpacity(0.5f);
+  EXPECT_TRUE(layers[5]->IsSubtreeMutated());
+  EXPECT_TRUE(layers[4]->IsSubtreeMutated());
+  EXPECT_TRUE(root->IsSubtreeMutated());
+  EXPECT_FALSE(layers[1]->IsSubtreeMutated());
+  EXPECT_FALSE(layers[2]->IsSubtreeMutated());
+
+  nsIntRegion invalid = props->ComputeDifferences(root, nullptr);
+  EXPECT_TRUE(invalid.IsEqual(nsIntRegion(IntRect(50,0,50,100))));
+  for (uint32_t i = 0; i < layers.Length(); i++) {
+    EXPECT_FALSE(layers[i]->IsSubtreeMutated());
+  }
+
+  // Invalidating the contents of a layer marks it too.
+  props = LayerProperties::CloneFrom(root);
+  layers[3]->AddInvalidRect(IntRect(0,50,10,10));
+  EXPECT_TRUE(layers[1]->IsSubtreeMutated());
+  invalid = props->ComputeDifferences(root, nullptr);
+  EXPECT_TRUE(invalid.IsEqual(nsIntRegion(IntRect(0,50,10,10))));
+
+  // Nothing has changed since the last diff.
+  props = LayerProperties::CloneFrom(root);
+  invalid = props->ComputeDifferences(root, nullptr);
+  EXPECT_TRUE(invalid.IsEmpty());
+}
+
 class LayerMetricsWrapperTester : public ::testing::Test {
 protected:
   virtual void SetUp() {
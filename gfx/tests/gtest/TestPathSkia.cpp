@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "gtest/gtest.h"
+
+#include "mozilla/gfx/2D.h"
+
+#include <math.h>
+
+using namespace mozilla;
+using namespace mozilla::gfx;
+
+static const Float kRingPi = 3.14159265f;
+static const Point kRingCenter(150, 150);
+// Enough vertices for PathSkia to build its hit testing edge grid.
+static const int kRingVertexCount = 64;
+
+static Point
+PointOnCircle(Float aRadius, Float aAngle)
+{
+  return kRingCenter + Point(aRadius * cos(aAngle), aRadius * sin(aAngle));
+}
+
+static void
+AppendPolygon(PathBuilder* aBuilder, Float aRadius, bool aClockwise)
+{
+  for (int i = 0; i < kRingVertexCount; i++) {
+    Float angle = 2 * kRingPi * i / kRingVertexCount;
+    Point vertex = PointOnCircle(aRadius, aClockwise ? angle : -angle);
+    if (i == 0) {
+      aBuilder->MoveTo(vertex);
+    } else {
+      aBuilder->LineTo(vertex);
+    }
+  }
+  aBuilder->Close();
+}
+
+// Two concentric polygons, with radii 100 and 50.
+static already_AddRefed<Path>
+CreateRingPath(FillRule aFillRule, bool aSameDirection)
+{
+  RefPtr<DrawTarget> dt =
+    Factory::CreateDrawTarget(BackendType::SKIA, IntSize(1, 1), SurfaceFormat::B8G8R8A8);
+  if (!dt) {
+    return nullptr;
+  }
+  RefPtr<PathBuilder> builder = dt->CreatePathBuilder(aFillRule);
+  AppendPolygon(builder, 100, true);
+  AppendPolygon(builder, 50, aSameDirection);
+  return builder->Finish();
+}
+
+static void
+CheckFill(Path* aPath, bool aInnerFilled)
+{
+  for (int i = 0; i < 32; i++) {
+    // Stay away from the vertices.
+    Float angle = 2 * kRingPi * (i + 0.5f) / 32;
+    EXPECT_EQ(aInnerFilled, aPath->ContainsPoint(PointOnCircle(25, angle), Matrix()));
+    EXPECT_TRUE(aPath->ContainsPoint(PointOnCircle(75, angle), Matrix()));
+    EXPECT_FALSE(aPath->ContainsPoint(PointOnCircle(125, angle), Matrix()));
+  }
+  EXPECT_FALSE(aPath->ContainsPoint(Point(0, 0), Matrix()));
+  EXPECT_TRUE(aPath->ContainsPoint(Point(0, 0), Matrix::Translation(-75, -150)));
+}
+
+TEST(PathSkia, ContainsPoint) {
+  RefPtr<Path> path = CreateRingPath(FillRule::FILL_WINDING, true);
+  if (!path) {
+    return; // No Skia.
+  }
+  CheckFill(path, true);
+
+  path = CreateRingPath(FillRule::FILL_WINDING, false);
+  CheckFill(path, false);
+
+  path = CreateRingPath(FillRule::FILL_EVEN_ODD, true);
+  CheckFill(path, false);
+}
+
+TEST(PathSkia, StrokeContainsPoint) {
+  RefPtr<Path> path = CreateRingPath(FillRule::FILL_WINDING, true);
+  if (!path) {
+    return; // No Skia.
+  }
+  Float angle = kRingPi / kRingVertexCount;
+  StrokeOptions thin(10);
+  EXPECT_TRUE(path->StrokeContainsPoint(thin, PointOnCircle(96, angle), Matrix()));
+  EXPECT_FALSE(path->StrokeContainsPoint(thin, PointOnCircle(108, angle), Matrix()));
+
+  // The stroke outline is cached, make sure a different width isn't served
+  // from the cache.
+  StrokeOptions thick(20);
+  EXPECT_TRUE(path->StrokeContainsPoint(thick, PointOnCircle(108, angle), Matrix()));
+  EXPECT_FALSE(path->StrokeContainsPoint(thin, PointOnCircle(108, angle), Matrix()));
+
+  Float dashes[] = { 1, 1000 };
+  StrokeOptions dashed(10, JoinStyle::MITER_OR_BEVEL, CapStyle::BUTT, 10, 2, dashes);
+  EXPECT_FALSE(path->StrokeContainsPoint(dashed, PointOnCircle(96, angle), Matrix()));
+
+  Rect bounds = path->GetStrokedBounds(thick);
+  EXPECT_TRUE(bounds.Contains(Rect(45, 45, 210, 210)));
+}
@@ -12,6 +12,7 @@
 #include "gfxFT2Utils.h"
 #include "gfxPlatform.h"
 #include "mozilla/ArrayUtils.h"
+#include "mozilla/HashFunctions.h"
 #include "mozilla/Preferences.h"
 #include "mozilla/Sprintf.h"
 #include "mozilla/TimeStamp.h"
@@ -25,8 +26,10 @@
 #include "nsCharSeparatedTokenizer.h"
 
 #include "mozilla/gfx/HelpersCairo.h"
+#include "mozilla/scache/StartupCache.h"
 
 #include <fontconfig/fcfreetype.h>
+#include <sys/stat.h>
 
 #ifdef MOZ_WIDGET_GTK
 #include <gdk/gdk.h>
@@ -345,6 +348,10 @@ gfxFontconfigFontEntry::ReadCMAP(FontInfoData *aFontInfoData)
                                                         mUVSOffset,
                                                         symbolFont))) {
         rv = NS_OK;
+    } else if (!mIsDataUserFont &&
+               (charmap = gfxFcPlatformFontList::PlatformFontList()->
+                              GetCachedCmap(mFontPattern, mUVSOffset))) {
+        rv = NS_OK;
     } else {
         uint32_t kCMAP = TRUETYPE_TAG('c','m','a','p');
         charmap = new gfxCharacterMap();
@@ -939,6 +946,8 @@ gfxFcPlatformFontList::gfxFcPlatformFontList()
     , mGenericMappings(32)
     , mFcSubstituteCache(64)
     , mLastConfig(nullptr)
+    , mCmapCacheLength(0)
+    , mCmapCacheFound(false)
     , mAlwaysUseFontconfigGenerics(true)
 {
     // if the rescan interval is set, start the timer
@@ -1067,6 +1076,7 @@ gfxFcPlatformFontList::InitFontListForPlatform()
 
     mLocalNames.Clear();
     mFcSubstituteCache.Clear();
+    InitCmapCache();
 
     // iterate over available fonts
     FcFontSet* systemFonts = FcConfigGetFonts(nullptr, FcSetSystem);
@@ -1084,6 +1094,238 @@ gfxFcPlatformFontList::InitFontListForPlatform()
     return NS_OK;
 }
 
+// Bump this when the format of the cmap cache changes.
+#define CMAP_CACHE_VERSION 1
+#define CMAP_CACHE_KEY_PREFIX "font.cached-cmaps-"
+
+static void
+AppendUint16(nsTArray<uint8_t>& aBuf, uint16_t aValue)
+{
+    aBuf.AppendElement(uint8_t(aValue >> 8));
+    aBuf.AppendElement(uint8_t(aValue & 0xff));
+}
+
+static void
+AppendUint32(nsTArray<uint8_t>& aBuf, uint32_t aValue)
+{
+    AppendUint16(aBuf, uint16_t(aValue >> 16));
+    AppendUint16(aBuf, uint16_t(aValue & 0xffff));
+}
+
+static uint32_t
+ReadUint16(const uint8_t* aData)
+{
+    return (aData[0] << 8) | aData[1];
+}
+
+static uint32_t
+ReadUint32(const uint8_t* aData)
+{
+    return (ReadUint16(aData) << 16) | ReadUint16(aData + 2);
+}
+
+// The key of a face in the cmap cache is its file path and face index.
+static bool
+GetCmapCacheFaceKey(FcPattern* aPattern, nsACString& aKey)
+{
+    FcChar8* filename;
+    if (FcPatternGetString(aPattern, FC_FILE, 0, &filename) != FcResultMatch) {
+        return false;
+    }
+    int index;
+    if (FcPatternGetInteger(aPattern, FC_INDEX, 0, &index) != FcResultMatch) {
+        index = 0;
+    }
+    aKey.Assign(ToCharPtr(filename));
+    aKey.Append(':');
+    aKey.AppendInt(index);
+    return true;
+}
+
+// Fontconfig lists every directory it scanned for fonts, and as with its own
+// caches, a font being added or removed changes the modification time of its
+// directory. So the paths and modification times of all the directories
+// identify the set of installed fonts.
+static void
+GetCmapCacheId(nsACString& aId)
+{
+    uint32_t hash = CMAP_CACHE_VERSION;
+    FcStrList* dirs = FcConfigGetFontDirs(nullptr);
+    if (dirs) {
+        FcChar8* dir;
+        while ((dir = FcStrListNext(dirs))) {
+            hash = AddToHash(hash, HashString(ToCharPtr(dir)));
+            struct stat info;
+            if (stat(ToCharPtr(dir), &info) == 0) {
+                hash = AddToHash(hash, uint64_t(info.st_mtime));
+            }
+        }
+        FcStrListDone(dirs);
+    }
+    aId.AssignLiteral(CMAP_CACHE_KEY_PREFIX);
+    aId.AppendPrintf("%08x", hash);
+}
+
+void
+gfxFcPlatformFontList::InitCmapCache()
+{
+    mCmapCacheId.Truncate();
+    mCmapCacheData = nullptr;
+    mCmapCacheLength = 0;
+    mCmapCacheOffsets.Clear();
+    mCmapCacheFound = false;
+
+    scache::StartupCache* cache = scache::StartupCache::GetSingleton();
+    if (!cache) {
+        return;
+    }
+
+    GetCmapCacheId(mCmapCacheId);
+    if (NS_FAILED(cache->GetBuffer(mCmapCacheId.get(), &mCmapCacheData,
+                                   &mCmapCacheLength))) {
+        mCmapCacheLength = 0;
+        return;
+    }
+    mCmapCacheFound = true;
+
+    // Index the entries, each of which is the face key, then the length of
+    // the UVS offset and serialized cmap that follow it.
+    const uint8_t* data = reinterpret_cast<uint8_t*>(mCmapCacheData.get());
+    const uint8_t* end = data + mCmapCacheLength;
+    const uint8_t* p = data;
+    if (end - p < 4 || ReadUint32(p) != CMAP_CACHE_VERSION) {
+        NS_WARNING("unexpected cmap cache version");
+        mCmapCacheData = nullptr;
+        mCmapCacheLength = 0;
+        return;
+    }
+    p += 4;
+    while (end - p >= 2) {
+        uint32_t keyLength = ReadUint16(p);
+        p += 2;
+        if (uint32_t(end - p) < keyLength + 4) {
+            break;
+        }
+        nsDependentCSubstring key(reinterpret_cast<const char*>(p), keyLength);
+        p += keyLength;
+        uint32_t length = ReadUint32(p);
+        p += 4;
+        if (uint32_t(end - p) < length) {
+            break;
+        }
+        mCmapCacheOffsets.Put(key, p - data);
+        p += length;
+    }
+
+    LOG_FONTLIST(("(fontlist-cmap) read %u cached cmaps (%u bytes) from %s\n",
+                  mCmapCacheOffsets.Count(), mCmapCacheLength,
+                  mCmapCacheId.get()));
+}
+
+already_AddRefed<gfxCharacterMap>
+gfxFcPlatformFontList::GetCachedCmap(FcPattern* aPattern, uint32_t& aUVSOffset)
+{
+    if (!mCmapCacheData) {
+        return nullptr;
+    }
+
+    nsAutoCString key;
+    uint32_t offset;
+    if (!GetCmapCacheFaceKey(aPattern, key) ||
+        !mCmapCacheOffsets.Get(key, &offset)) {
+        return nullptr;
+    }
+
+    const uint8_t* data = reinterpret_cast<uint8_t*>(mCmapCacheData.get());
+    const uint8_t* p = data + offset;
+    const uint8_t* end = p + ReadUint32(p - 4);
+    if (end - p < 4) {
+        return nullptr;
+    }
+    uint32_t uvsOffset = ReadUint32(p);
+    p += 4;
+
+    RefPtr<gfxCharacterMap> charmap = new gfxCharacterMap();
+    if (!charmap->Deserialize(p, end)) {
+        NS_WARNING("malformed entry in cmap cache");
+        return nullptr;
+    }
+    aUVSOffset = uvsOffset;
+    return charmap.forget();
+}
+
+void
+gfxFcPlatformFontList::WriteCmapCache()
+{
+    scache::StartupCache* cache = scache::StartupCache::GetSingleton();
+    if (!cache || mCmapCacheId.IsEmpty()) {
+        return;
+    }
+
+    nsTArray<uint8_t> buf;
+    AppendUint32(buf, CMAP_CACHE_VERSION);
+
+    nsTHashtable<nsCStringHashKey> written;
+    nsAutoCString key;
+    uint32_t count = 0;
+    for (auto f = mFontFamilies.Iter(); !f.Done(); f.Next()) {
+        nsTArray<RefPtr<gfxFontEntry>>& faces = f.Data()->GetFontList();
+        for (uint32_t i = 0; i < faces.Length(); i++) {
+            gfxFontconfigFontEntry* fe =
+                static_cast<gfxFontconfigFontEntry*>(faces[i].get());
+            if (!fe->mCharacterMap || !fe->mHasCmapTable ||
+                !GetCmapCacheFaceKey(fe->GetPattern(), key) ||
+                key.Length() > UINT16_MAX || written.Contains(key)) {
+                continue;
+            }
+            written.PutEntry(key);
+
+            AppendUint16(buf, key.Length());
+            buf.AppendElements(reinterpret_cast<const uint8_t*>(key.get()),
+                               key.Length());
+            uint32_t lengthOffset = buf.Length();
+            AppendUint32(buf, 0);
+            AppendUint32(buf, fe->mUVSOffset);
+            fe->mCharacterMap->Serialize(buf);
+
+            uint32_t length = buf.Length() - lengthOffset - 4;
+            buf[lengthOffset] = uint8_t(length >> 24);
+            buf[lengthOffset + 1] = uint8_t((length >> 16) & 0xff);
+            buf[lengthOffset + 2] = uint8_t((length >> 8) & 0xff);
+            buf[lengthOffset + 3] = uint8_t(length & 0xff);
+            count++;
+        }
+    }
+
+    cache->PutBuffer(mCmapCacheId.get(),
+                     reinterpret_cast<const char*>(buf.Elements()),
+                     buf.Length());
+
+    LOG_FONTLIST(("(fontlist-cmap) wrote %u cmaps (%u bytes) to %s\n",
+                  count, uint32_t(buf.Length()), mCmapCacheId.get()));
+}
+
+void
+gfxFcPlatformFontList::CleanupLoader()
+{
+    // The loader has read in the cmaps of all faces only if it ran to
+    // completion rather than being cancelled.
+    if (mNumFamilies && mStartIndex >= mNumFamilies) {
+        // Entries are written once per set of font directories, since the
+        // startup cache can't replace an entry; a partially loaded set is
+        // not written at all, so the next session will try again.
+        if (!mCmapCacheFound) {
+            WriteCmapCache();
+            mCmapCacheFound = true;
+        }
+        mCmapCacheData = nullptr;
+        mCmapCacheLength = 0;
+        mCmapCacheOffsets.Clear();
+    }
+
+    gfxPlatformFontList::CleanupLoader();
+}
+
 // For displaying the fontlist in UI, use explicit call to FcFontList. Using
 // FcFontList results in the list containing the localized names as dictated
 // by system defaults.
@@ -260,9 +260,24 @@ public:
 
     static FT_Library GetFTLibrary();
 
+    // Look up the cmap of the face in aPattern in the cmap cache that was
+    // read from the startup cache when the font list was initialized.
+    // Returns null if the face is not in the cache.
+    already_AddRefed<gfxCharacterMap>
+    GetCachedCmap(FcPattern* aPattern, uint32_t& aUVSOffset);
+
 protected:
     virtual ~gfxFcPlatformFontList();
 
+    // once all cmaps have been loaded, persist them for the next startup
+    void CleanupLoader() override;
+
+    // Read the cmap cache for the current set of font directories, if any.
+    void InitCmapCache();
+
+    // Write the cmaps of all faces to the cmap cache.
+    void WriteCmapCache();
+
     // Add all the font families found in a font set.
     // aAppFonts indicates whether this is the system or application fontset.
     void AddFontSetFamilies(FcFontSet* aFontSet, bool aAppFonts);
@@ -308,6 +323,18 @@ protected:
     nsCOMPtr<nsITimer> mCheckFontUpdatesTimer;
     nsCountedRef<FcConfig> mLastConfig;
 
+    // The cmaps of system faces are cached across sessions in the startup
+    // cache, keyed by a fingerprint of the font directories, as reading the
+    // cmap table of every installed font is one of the most expensive parts
+    // of building the font list. mCmapCacheData holds the cache as read, and
+    // mCmapCacheOffsets maps a "file:index" face key to the offset of its
+    // entry, so that entries are only decoded when the face is used.
+    nsCString mCmapCacheId;
+    mozilla::UniquePtr<char[]> mCmapCacheData;
+    uint32_t mCmapCacheLength;
+    nsDataHashtable<nsCStringHashKey, uint32_t> mCmapCacheOffsets;
+    bool mCmapCacheFound;
+
     // By default, font prefs under Linux are set to simply lookup
     // via fontconfig the appropriate font for serif/sans-serif/monospace.
     // Rather than check each time a font pref is used, check them all at startup
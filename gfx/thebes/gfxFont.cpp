@@ -165,9 +165,39 @@ gfxFontCache::Shutdown()
 #endif
 }
 
+// Shaped-word caches of expired fonts are kept until they would take more
+// than this much memory, or until there are this many of them.
+static const size_t kRetiredWordCacheMaxSize = 2 * 1024 * 1024;
+static const uint32_t kRetiredWordCacheMaxCount = 32;
+
+struct gfxFontCache::RetiredWordCache {
+    explicit RetiredWordCache(gfxFont *aFont)
+        : mFontEntry(aFont->GetFontEntry())
+        , mStyle(*aFont->GetStyle())
+        , mAntialiasOption(aFont->mAntialiasOption)
+        , mWords(Move(aFont->mWordCache))
+        , mSize(mWords->SizeOfIncludingThis(FontCacheMallocSizeOf))
+        , mAge(0)
+    {}
+
+    bool Matches(gfxFont *aFont) const {
+        return mFontEntry == aFont->GetFontEntry() &&
+               mAntialiasOption == aFont->mAntialiasOption &&
+               mStyle.Equals(*aFont->GetStyle());
+    }
+
+    RefPtr<gfxFontEntry> mFontEntry;
+    gfxFontStyle mStyle;
+    gfxFont::AntialiasOption mAntialiasOption;
+    UniquePtr<nsTHashtable<gfxFont::CacheHashEntry>> mWords;
+    size_t mSize;
+    uint32_t mAge;
+};
+
 gfxFontCache::gfxFontCache()
     : nsExpirationTracker<gfxFont,3>(FONT_TIMEOUT_SECONDS * 1000,
                                      "gfxFontCache")
+    , mRetiredWordCacheSize(0)
 {
     nsCOMPtr<nsIObserverService> obs = GetObserverService();
     if (obs) {
@@ -201,6 +231,10 @@ gfxFontCache::~gfxFontCache()
 
     // Expire everything that has a zero refcount, so we don't leak them.
     AgeAllGenerations();
+    // Expired fonts leave their word caches behind; drop them, along with
+    // their references to font entries.
+    mRetiredWordCaches.Clear();
+    mRetiredWordCacheSize = 0;
     // All fonts should be gone.
     NS_WARNING_ASSERTION(mFonts.Count() == 0,
                          "Fonts still alive while shutting down gfxFontCache");
@@ -277,7 +311,7 @@ gfxFontCache::NotifyReleased(gfxFont *aFont)
 void
 gfxFontCache::NotifyExpired(gfxFont *aFont)
 {
-    aFont->ClearCachedWords();
+    RetireWordCache(aFont);
     RemoveObject(aFont);
     DestroyFont(aFont);
 }
@@ -296,6 +330,70 @@ gfxFontCache::DestroyFont(gfxFont *aFont)
     delete aFont;
 }
 
+void
+gfxFontCache::Flush()
+{
+    mFonts.Clear();
+    AgeAllGenerations();
+    // The font entries may be going away too, so don't keep the word caches
+    // of the fonts that just expired.
+    mRetiredWordCaches.Clear();
+    mRetiredWordCacheSize = 0;
+}
+
+void
+gfxFontCache::RetireWordCache(gfxFont *aFont)
+{
+    if (!aFont->mWordCache || aFont->mWordCache->Count() == 0) {
+        return;
+    }
+
+    // If another instance of the same font was retired earlier, this one
+    // has the more recently used words.
+    for (uint32_t i = 0; i < mRetiredWordCaches.Length(); ++i) {
+        if (mRetiredWordCaches[i]->Matches(aFont)) {
+            mRetiredWordCacheSize -= mRetiredWordCaches[i]->mSize;
+            mRetiredWordCaches.RemoveElementAt(i);
+            break;
+        }
+    }
+
+    auto retired = MakeUnique<RetiredWordCache>(aFont);
+    mRetiredWordCacheSize += retired->mSize;
+    mRetiredWordCaches.AppendElement(Move(retired));
+    EvictRetiredWordCaches();
+}
+
+void
+gfxFontCache::EvictRetiredWordCaches()
+{
+    uint32_t evict = 0;
+    while (evict < mRetiredWordCaches.Length() &&
+           (mRetiredWordCacheSize > kRetiredWordCacheMaxSize ||
+            mRetiredWordCaches.Length() - evict > kRetiredWordCacheMaxCount)) {
+        mRetiredWordCacheSize -= mRetiredWordCaches[evict]->mSize;
+        ++evict;
+    }
+    mRetiredWordCaches.RemoveElementsAt(0, evict);
+}
+
+void
+gfxFontCache::AdoptRetiredWordCache(gfxFont *aFont)
+{
+    if (aFont->mWordCache) {
+        return;
+    }
+    for (uint32_t i = 0; i < mRetiredWordCaches.Length(); ++i) {
+        RetiredWordCache* retired = mRetiredWordCaches[i].get();
+        if (retired->Matches(aFont)) {
+            aFont->mWordCache = Move(retired->mWords);
+            mRetiredWordCacheSize -= retired->mSize;
+            mRetiredWordCaches.RemoveElementAt(i);
+            return;
+        }
+    }
+}
+
 /*static*/
 void
 gfxFontCache::WordCacheExpirationTimerCallback(nsITimer* aTimer, void* aCache)
@@ -304,6 +402,16 @@ gfxFontCache::WordCacheExpirationTimerCallback(nsITimer* aTimer, void* aCache)
     for (auto it = cache->mFonts.Iter(); !it.Done(); it.Next()) {
         it.Get()->mFont->AgeCachedWords();
     }
+
+    // Nobody uses the words of a retired cache, so they would all expire
+    // together anyway.
+    nsTArray<UniquePtr<RetiredWordCache>>& retired = cache->mRetiredWordCaches;
+    for (uint32_t i = retired.Length(); i > 0; --i) {
+        if (++retired[i - 1]->mAge == gfxFont::kShapedWordCacheMaxAge) {
+            cache->mRetiredWordCacheSize -= retired[i - 1]->mSize;
+            retired.RemoveElementAt(i - 1);
+        }
+    }
 }
 
 void
@@ -312,6 +420,8 @@ gfxFontCache::FlushShapedWordCaches()
     for (auto it = mFonts.Iter(); !it.Done(); it.Next()) {
         it.Get()->mFont->ClearCachedWords();
     }
+    mRetiredWordCaches.Clear();
+    mRetiredWordCacheSize = 0;
 }
 
 void
@@ -324,6 +434,14 @@ gfxFontCache::AddSizeOfExcludingThis(MallocSizeOf aMallocSizeOf,
     for (auto iter = mFonts.ConstIter(); !iter.Done(); iter.Next()) {
         iter.Get()->mFont->AddSizeOfExcludingThis(aMallocSizeOf, aSizes);
     }
+
+    aSizes->mShapedWords +=
+        mRetiredWordCaches.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    for (uint32_t i = 0; i < mRetiredWordCaches.Length(); ++i) {
+        const RetiredWordCache* retired = mRetiredWordCaches[i].get();
+        aSizes->mShapedWords += aMallocSizeOf(retired) +
+            retired->mWords->SizeOfIncludingThis(aMallocSizeOf);
+    }
 }
 
 void
@@ -323,13 +323,15 @@ public:
     // Cleans out the hashtable and removes expired fonts waiting for cleanup.
     // Other gfxFont objects may be still in use but they will be pushed
     // into the expiration queues and removed.
-    void Flush() {
-        mFonts.Clear();
-        AgeAllGenerations();
-    }
+    void Flush();
 
     void FlushShapedWordCaches();
 
+    // Give aFont the shaped-word cache of an expired font with the same face,
+    // style and antialiasing, if we kept one, so that words shaped for an
+    // earlier document don't have to be shaped again.
+    void AdoptRetiredWordCache(gfxFont *aFont);
+
     void AddSizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf,
                                 FontCacheSizes* aSizes) const;
     void AddSizeOfIncludingThis(mozilla::MallocSizeOf aMallocSizeOf,
@@ -356,6 +358,11 @@ protected:
 
     void DestroyFont(gfxFont *aFont);
 
+    // Keep the shaped-word cache of aFont, which is about to be destroyed,
+    // for a later instance of the same font.
+    void RetireWordCache(gfxFont *aFont);
+    void EvictRetiredWordCaches();
+
     static gfxFontCache *gGlobalCache;
 
     struct Key {
@@ -393,6 +400,11 @@ protected:
 
     nsTHashtable<HashEntry> mFonts;
 
+    // Word caches of expired fonts, oldest first; defined in gfxFont.cpp.
+    struct RetiredWordCache;
+    nsTArray<mozilla::UniquePtr<RetiredWordCache>> mRetiredWordCaches;
+    size_t mRetiredWordCacheSize;
+
     static void WordCacheExpirationTimerCallback(nsITimer* aTimer, void* aCache);
     nsCOMPtr<nsITimer>      mWordCacheExpirationTimer;
 };
@@ -1331,6 +1343,7 @@ class gfxFont {
 
     friend class gfxHarfBuzzShaper;
     friend class gfxGraphiteShaper;
+    friend class gfxFontCache;
 
 protected:
     typedef mozilla::gfx::DrawTarget DrawTarget;
@@ -1764,6 +1777,9 @@ public:
     // Ensure the ShapedWord cache is initialized. This MUST be called before
     // any attempt to use GetShapedWord().
     void InitWordCache() {
+        if (!mWordCache) {
+            gfxFontCache::GetCache()->AdoptRetiredWordCache(this);
+        }
         if (!mWordCache) {
             mWordCache = mozilla::MakeUnique<nsTHashtable<CacheHashEntry>>();
         }
@@ -90,6 +90,94 @@ gfxSparseBitSet::Dump(const char* aPrefix, eGfxLog aWhichLog) const
     }
 }
 
+// Serialized blocks are a 16-bit block index followed by one of these kinds;
+// partial blocks are followed by their BLOCK_SIZE bytes of bits.
+enum {
+    kSerializedBlockFull = 0,
+    kSerializedBlockPartial = 1
+};
+
+void
+gfxSparseBitSet::Serialize(nsTArray<uint8_t>& aBuf) const
+{
+    static const uint8_t kFullBits[BLOCK_SIZE] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+    };
+
+    uint32_t numBlocks = mBlocks.Length();
+    uint16_t present = 0;
+    for (uint32_t b = 0; b < numBlocks; b++) {
+        if (mBlocks[b]) {
+            present++;
+        }
+    }
+    aBuf.AppendElement(uint8_t(present >> 8));
+    aBuf.AppendElement(uint8_t(present & 0xff));
+
+    for (uint32_t b = 0; b < numBlocks; b++) {
+        const Block *block = mBlocks[b].get();
+        if (!block) {
+            continue;
+        }
+        aBuf.AppendElement(uint8_t(b >> 8));
+        aBuf.AppendElement(uint8_t(b & 0xff));
+        if (memcmp(block->mBits, kFullBits, BLOCK_SIZE) == 0) {
+            aBuf.AppendElement(uint8_t(kSerializedBlockFull));
+        } else {
+            aBuf.AppendElement(uint8_t(kSerializedBlockPartial));
+            aBuf.AppendElements(block->mBits, BLOCK_SIZE);
+        }
+    }
+}
+
+bool
+gfxSparseBitSet::Deserialize(const uint8_t*& aData, const uint8_t* aEnd)
+{
+    mBlocks.Clear();
+
+    const uint8_t *p = aData;
+    if (aEnd - p < 2) {
+        return false;
+    }
+    uint32_t present = (p[0] << 8) | p[1];
+    p += 2;
+
+    // Cmaps can't extend beyond U+10FFFF, so this bounds the array length.
+    const uint32_t kMaxBlocks = (0x10FFFF >> BLOCK_INDEX_SHIFT) + 1;
+    for (uint32_t i = 0; i < present; i++) {
+        if (aEnd - p < 3) {
+            mBlocks.Clear();
+            return false;
+        }
+        uint32_t b = (p[0] << 8) | p[1];
+        uint8_t kind = p[2];
+        p += 3;
+        if (b >= kMaxBlocks ||
+            (b < mBlocks.Length() && mBlocks[b]) ||
+            (kind != kSerializedBlockFull &&
+             (kind != kSerializedBlockPartial || aEnd - p < BLOCK_SIZE))) {
+            mBlocks.Clear();
+            return false;
+        }
+        if (b >= mBlocks.Length()) {
+            mBlocks.AppendElements(b + 1 - mBlocks.Length());
+        }
+        if (kind == kSerializedBlockFull) {
+            mBlocks[b] = mozilla::MakeUnique<Block>(0xFF);
+        } else {
+            mBlocks[b] = mozilla::MakeUnique<Block>();
+            memcpy(mBlocks[b]->mBits, p, BLOCK_SIZE);
+            p += BLOCK_SIZE;
+        }
+    }
+
+    aData = p;
+    return true;
+}
+
 nsresult
 gfxFontUtils::ReadCMAPTableFormat10(const uint8_t *aBuf, uint32_t aLength,
                                     gfxSparseBitSet& aCharacterMap)
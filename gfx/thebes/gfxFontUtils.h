@@ -87,6 +87,16 @@ public:
     // dump out contents of bitmap
     void Dump(const char* aPrefix, eGfxLog aWhichLog) const;
 
+    // Append a compact serialization of the bitset to aBuf, for persisting
+    // cmaps across sessions. Only the blocks that are present are written,
+    // and blocks with all bits set take a single byte.
+    void Serialize(nsTArray<uint8_t>& aBuf) const;
+
+    // Replace the contents of the bitset with data written by Serialize,
+    // advancing aData past it. Returns false (leaving the bitset empty) if
+    // the data between aData and aEnd is truncated or malformed.
+    bool Deserialize(const uint8_t*& aData, const uint8_t* aEnd);
+
     bool TestRange(uint32_t aStart, uint32_t aEnd) {
         uint32_t startBlock, endBlock, blockLen;
         
@@ -6,11 +6,14 @@
 #include "mozilla/layers/CompositorBridgeChild.h"
 #include "mozilla/layers/CompositorThread.h"
 #include "mozilla/layers/ImageBridgeChild.h"
+#include "mozilla/layers/PaintThread.h"
 #include "mozilla/layers/SharedBufferManagerChild.h"
 #include "mozilla/layers/ISurfaceAllocator.h"     // for GfxMemoryImageReporter
+#include "ImageContainer.h"                        // for BufferRecycleBin
 #include "mozilla/gfx/gfxVars.h"
 #include "mozilla/gfx/GPUProcessManager.h"
 #include "mozilla/gfx/GraphicsMessages.h"
+#include "mozilla/gfx/JobScheduler.h"
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/Telemetry.h"
 #include "mozilla/TimeStamp.h"
@@ -475,6 +478,7 @@ MemoryPressureObserver::Observe(nsISupports *aSubject,
 
     gfxPlatform::PurgeSkiaFontCache();
     gfxPlatform::GetPlatform()->PurgeSkiaGPUCache();
+    layers::BufferRecycleBin::PurgeShared();
     return NS_OK;
 }
 
@@ -743,6 +747,10 @@ gfxPlatform::Init()
 
     CreateCMSOutputProfile();
 
+    if (uint32_t framePoolMB = gfxPrefs::LayersVideoFramePoolMaxMB()) {
+      layers::BufferRecycleBin::InitShared(size_t(framePoolMB) * 1024 * 1024);
+    }
+
     // Listen to memory pressure event so we can purge DrawTarget caches
     nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
     if (obs) {
@@ -832,6 +840,8 @@ gfxPlatform::Shutdown()
     gPlatform->mMemoryPressureObserver = nullptr;
     gPlatform->mSkiaGlue = nullptr;
 
+    layers::BufferRecycleBin::ShutdownShared();
+
     if (XRE_IsParentProcess()) {
       gPlatform->mVsyncSource->Shutdown();
     }
@@ -897,6 +907,16 @@ gfxPlatform::InitLayersIPC()
         SharedBufferManagerChild::StartUp();
 #endif
     }
+    layers::PaintThread::Start();
+
+    if (gfxPrefs::LayersTilesParallelPaintEnabled() ||
+        gfxPrefs::YCbCrParallelConversionMinPixels()) {
+      // The painting thread blocks while the workers rasterize its tiles, and
+      // YCbCr conversions block while the workers convert their bands, so use
+      // one worker per core.
+      uint32_t workers = std::max(PR_GetNumberOfProcessors(), 1);
+      gfx::JobScheduler::Init(workers, 1);
+    }
 }
 
 /* static */ void
@@ -907,6 +927,11 @@ gfxPlatform::ShutdownLayersIPC()
     }
     sLayersIPCIsUp = false;
 
+    layers::PaintThread::Shutdown();
+    if (gfx::JobScheduler::IsEnabled()) {
+      gfx::JobScheduler::ShutDown();
+    }
+
     if (XRE_IsContentProcess()) {
         gfx::VRManagerChild::ShutDown();
         // cf bug 1215265.
@@ -17,9 +17,11 @@
 #include "gfxFontConstants.h"
 #include "mozilla/Preferences.h"
 #include "mozilla/Services.h"
+#include "mozilla/SharedThreadPool.h"
 #include "mozilla/Telemetry.h"
 #include "mozilla/gfx/2D.h"
 #include "gfxPlatformFontList.h"
+#include "nsProxyRelease.h"
 
 #include "opentype-sanitiser.h"
 #include "ots-memory-stream.h"
@@ -175,8 +177,12 @@ gfxUserFontEntry::CreateFontInstance(const gfxFontStyle* aFontStyle, bool aNeeds
 
 class gfxOTSContext : public ots::OTSContext {
 public:
-    explicit gfxOTSContext(gfxUserFontEntry* aUserFontEntry)
-        : mUserFontEntry(aUserFontEntry) {}
+    // If aDeferredMessages is non-null, messages are collected there instead
+    // of being logged, so that the context can be used off the main thread.
+    gfxOTSContext(gfxUserFontEntry* aUserFontEntry,
+                  nsTArray<nsCString>* aDeferredMessages)
+        : mUserFontEntry(aUserFontEntry)
+        , mDeferredMessages(aDeferredMessages) {}
 
     virtual ots::TableAction GetTableAction(uint32_t aTag) override {
         // Preserve Graphite, color glyph and SVG tables
@@ -219,11 +225,16 @@ public:
             mWarningsIssued.PutEntry(msg);
         }
 
+        if (mDeferredMessages) {
+            mDeferredMessages->AppendElement(msg);
+            return;
+        }
         mUserFontEntry->mFontSet->LogMessage(mUserFontEntry, msg.get());
     }
 
 private:
     gfxUserFontEntry* mUserFontEntry;
+    nsTArray<nsCString>* mDeferredMessages;
     nsTHashtable<nsCStringHashKey> mWarningsIssued;
 };
 
@@ -233,7 +244,8 @@ const uint8_t*
 gfxUserFontEntry::SanitizeOpenTypeData(const uint8_t* aData,
                                        uint32_t       aLength,
                                        uint32_t&      aSaneLength,
-                                       gfxUserFontType aFontType)
+                                       gfxUserFontType aFontType,
+                                       nsTArray<nsCString>* aDeferredMessages)
 {
     if (aFontType == GFX_USERFONT_UNKNOWN) {
         aSaneLength = 0;
@@ -250,7 +262,7 @@ gfxUserFontEntry::SanitizeOpenTypeData(const uint8_t* aData,
     // limit output/expansion to 256MB
     ExpandingMemoryStream output(lengthHint, 1024 * 1024 * 256);
 
-    gfxOTSContext otsContext(this);
+    gfxOTSContext otsContext(this, aDeferredMessages);
     if (!otsContext.Process(&output, aData, aLength)) {
         // Failed to decode/sanitize the font, so discard it.
         aSaneLength = 0;
@@ -613,8 +625,6 @@ gfxUserFontEntry::LoadPlatformFont(const uint8_t* aFontData, uint32_t& aLength)
                  mFontDataLoadingState < LOADING_FAILED,
                  "attempting to load a font that has either completed or failed");
 
-    gfxFontEntry* fe = nullptr;
-
     gfxUserFontType fontType =
         gfxFontUtils::DetermineFontDataType(aFontData, aLength);
     Telemetry::Accumulate(Telemetry::WEBFONT_FONTTYPE, uint32_t(fontType));
@@ -622,18 +632,35 @@ gfxUserFontEntry::LoadPlatformFont(const uint8_t* aFontData, uint32_t& aLength)
     // Unwrap/decompress/sanitize or otherwise munge the downloaded data
     // to make a usable sfnt structure.
 
+    // Call the OTS sanitizer; this will also decode WOFF to sfnt
+    // if necessary. The original data in aFontData is left unchanged.
+    uint32_t saneLen;
+    const uint8_t* saneData =
+        SanitizeOpenTypeData(aFontData, aLength, saneLen, fontType);
+
+    return LoadPlatformFontFromSanitizedData(aFontData, aLength, fontType,
+                                             saneData, saneLen);
+}
+
+bool
+gfxUserFontEntry::LoadPlatformFontFromSanitizedData(const uint8_t* aFontData,
+                                                    uint32_t aLength,
+                                                    gfxUserFontType aFontType,
+                                                    const uint8_t* aSaneData,
+                                                    uint32_t aSaneLength)
+{
+    gfxFontEntry* fe = nullptr;
+    gfxUserFontType fontType = aFontType;
+    const uint8_t* saneData = aSaneData;
+    uint32_t saneLen = aSaneLength;
+
     // Because platform font activation code may replace the name table
     // in the font with a synthetic one, we save the original name so that
     // it can be reported via the nsIDOMFontFace API.
     nsAutoString originalFullName;
 
-    // Call the OTS sanitizer; this will also decode WOFF to sfnt
-    // if necessary. The original data in aFontData is left unchanged.
-    uint32_t saneLen;
     uint32_t fontCompressionRatio = 0;
     size_t computedSize = 0;
-    const uint8_t* saneData =
-        SanitizeOpenTypeData(aFontData, aLength, saneLen, fontType);
     if (!saneData) {
         mFontSet->LogMessage(this, "rejected by sanitizer");
     }
@@ -764,6 +791,15 @@ gfxUserFontEntry::FontDataDownloadComplete(const uint8_t* aFontData,
     // download successful, make platform font using font data
     if (NS_SUCCEEDED(aDownloadStatus) &&
         mFontDataLoadingState != LOADING_TIMED_OUT) {
+        if (Preferences::GetBool(
+                "gfx.downloadable_fonts.sanitize_off_main_thread") &&
+            LoadPlatformFontAsync(aFontData, aLength)) {
+            // The font set is told about the result when the load finishes
+            // in FinishAsyncPlatformFontLoad, so there's nothing to update
+            // yet.
+            return false;
+        }
+
         bool loaded = LoadPlatformFont(aFontData, aLength);
         aFontData = nullptr;
 
@@ -798,6 +834,137 @@ gfxUserFontEntry::FontDataDownloadComplete(const uint8_t* aFontData,
     return true;
 }
 
+// Sanitizes downloaded font data on a background thread, then finishes the
+// load back on the main thread. The entry and its font set are only touched
+// on the main thread; the worker just reads the (immutable) font data.
+class gfxUserFontSanitizeRunnable final : public Runnable
+{
+public:
+    gfxUserFontSanitizeRunnable(gfxUserFontEntry* aUserFontEntry,
+                                const uint8_t* aFontData,
+                                uint32_t aLength,
+                                gfxUserFontType aFontType)
+        : mUserFontEntry(new nsMainThreadPtrHolder<gfxUserFontEntry>(
+                             aUserFontEntry))
+        , mSanitizingEntry(aUserFontEntry)
+        , mUserFontSet(new nsMainThreadPtrHolder<gfxUserFontSet>(
+                           aUserFontEntry->mFontSet))
+        , mFontData(aFontData)
+        , mLength(aLength)
+        , mFontType(aFontType)
+        , mSaneData(nullptr)
+        , mSaneLength(0)
+        , mSanitized(false)
+    {
+    }
+
+    NS_IMETHOD Run() override
+    {
+        if (!mSanitized) {
+            MOZ_ASSERT(!NS_IsMainThread());
+            mSaneData =
+                mSanitizingEntry->SanitizeOpenTypeData(mFontData, mLength,
+                                                       mSaneLength, mFontType,
+                                                       &mMessages);
+            mSanitized = true;
+            return NS_DispatchToMainThread(this);
+        }
+
+        MOZ_ASSERT(NS_IsMainThread());
+        mUserFontEntry->FinishAsyncPlatformFontLoad(mFontData, mLength,
+                                                    mFontType,
+                                                    mSaneData, mSaneLength,
+                                                    mMessages);
+        return NS_OK;
+    }
+
+private:
+    ~gfxUserFontSanitizeRunnable() {}
+
+    nsMainThreadPtrHandle<gfxUserFontEntry> mUserFontEntry;
+    // Used off the main thread only to call SanitizeOpenTypeData, which
+    // doesn't touch the entry when its messages are deferred. Kept alive by
+    // mUserFontEntry.
+    gfxUserFontEntry* MOZ_NON_OWNING_REF mSanitizingEntry;
+    // Keeps the entry's font set alive until the load finishes.
+    nsMainThreadPtrHandle<gfxUserFontSet> mUserFontSet;
+    const uint8_t* mFontData;
+    uint32_t mLength;
+    gfxUserFontType mFontType;
+    const uint8_t* mSaneData;
+    uint32_t mSaneLength;
+    nsTArray<nsCString> mMessages;
+    bool mSanitized;
+};
+
+bool
+gfxUserFontEntry::LoadPlatformFontAsync(const uint8_t* aFontData,
+                                        uint32_t aLength)
+{
+    MOZ_ASSERT(NS_IsMainThread());
+
+    gfxUserFontType fontType =
+        gfxFontUtils::DetermineFontDataType(aFontData, aLength);
+    if (fontType == GFX_USERFONT_UNKNOWN) {
+        // Nothing to sanitize; let the synchronous path reject it.
+        return false;
+    }
+
+    RefPtr<SharedThreadPool> pool =
+        SharedThreadPool::Get(NS_LITERAL_CSTRING("FontSanitizer"));
+    if (!pool) {
+        return false;
+    }
+
+    Telemetry::Accumulate(Telemetry::WEBFONT_FONTTYPE, uint32_t(fontType));
+
+    nsCOMPtr<nsIRunnable> runnable =
+        new gfxUserFontSanitizeRunnable(this, aFontData, aLength, fontType);
+    if (NS_FAILED(pool->Dispatch(runnable, NS_DISPATCH_NORMAL))) {
+        return false;
+    }
+
+    if (LOG_ENABLED()) {
+        LOG(("userfonts (%p) [src %d] sanitizing off main thread (%s)\n",
+             mFontSet, mSrcIndex,
+             mSrcList[mSrcIndex].mURI->GetSpecOrDefault().get()));
+    }
+    return true;
+}
+
+void
+gfxUserFontEntry::FinishAsyncPlatformFontLoad(const uint8_t* aFontData,
+                                              uint32_t aLength,
+                                              gfxUserFontType aFontType,
+                                              const uint8_t* aSaneData,
+                                              uint32_t aSaneLength,
+                                              const nsTArray<nsCString>& aMessages)
+{
+    MOZ_ASSERT(NS_IsMainThread());
+
+    for (const nsCString& message : aMessages) {
+        mFontSet->LogMessage(this, message.get());
+    }
+
+    // Takes ownership of both aFontData and aSaneData.
+    bool loaded = LoadPlatformFontFromSanitizedData(aFontData, aLength,
+                                                    aFontType, aSaneData,
+                                                    aSaneLength);
+    if (!loaded && mFontDataLoadingState != LOADING_TIMED_OUT) {
+        LoadNextSrc();
+    }
+
+    // As in FontDataDownloadComplete, the generation is bumped whether or
+    // not the load succeeded, so that fallback text gets reflowed.
+    IncrementGeneration();
+
+    nsTArray<gfxUserFontSet*> fontSets;
+    GetUserFontSets(fontSets);
+    for (gfxUserFontSet* fontSet : fontSets) {
+        fontSet->UserFontEntryLoadedAsync(this);
+    }
+}
+
 void
 gfxUserFontEntry::GetUserFontSets(nsTArray<gfxUserFontSet*>& aResult)
 {
@@ -493,6 +493,11 @@ public:
     virtual void RecordFontLoadDone(uint32_t aFontSize,
                                     mozilla::TimeStamp aDoneTime) {}
 
+    // called when a font whose data was sanitized off the main thread has
+    // finished loading (or failed and moved on to its next source), so
+    // that text using it can be reflowed
+    virtual void UserFontEntryLoadedAsync(gfxUserFontEntry* aUserFontEntry) {}
+
     void GetLoadStatistics(uint32_t& aLoadCount, uint64_t& aLoadSize) const {
         aLoadCount = mDownloadCount;
         aLoadSize = mDownloadSize;
@@ -560,6 +565,7 @@ class gfxUserFontEntry : public gfxFontEntry {
     friend class nsUserFontSet;
     friend class nsFontFaceLoader;
     friend class gfxOTSContext;
+    friend class gfxUserFontSanitizeRunnable;
 
 public:
     enum UserFontLoadState {
@@ -634,10 +640,14 @@ public:
                                        nsACString& aURI);
 
 protected:
+    // If aDeferredMessages is non-null, sanitizer messages are appended to
+    // it rather than logged, and the entry itself isn't touched, so this can
+    // be called off the main thread.
     const uint8_t* SanitizeOpenTypeData(const uint8_t* aData,
                                         uint32_t aLength,
                                         uint32_t& aSaneLength,
-                                        gfxUserFontType aFontType);
+                                        gfxUserFontType aFontType,
+                                        nsTArray<nsCString>* aDeferredMessages = nullptr);
 
     // attempt to load the next resource in the src list.
     void LoadNextSrc();
@@ -660,6 +670,28 @@ protected:
     // ensure that it is eventually deleted with free().
     bool LoadPlatformFont(const uint8_t* aFontData, uint32_t& aLength);
 
+    // second half of LoadPlatformFont, once the data has been sanitized;
+    // takes ownership of both aFontData and aSaneData (which may be null
+    // if sanitization failed)
+    bool LoadPlatformFontFromSanitizedData(const uint8_t* aFontData,
+                                           uint32_t aLength,
+                                           gfxUserFontType aFontType,
+                                           const uint8_t* aSaneData,
+                                           uint32_t aSaneLength);
+
+    // start sanitizing aFontData on a background thread; the load is
+    // finished by FinishAsyncPlatformFontLoad on the main thread
+    // returns false (leaving ownership of aFontData with the caller) if
+    // the work couldn't be dispatched
+    bool LoadPlatformFontAsync(const uint8_t* aFontData, uint32_t aLength);
+
+    void FinishAsyncPlatformFontLoad(const uint8_t* aFontData,
+                                     uint32_t aLength,
+                                     gfxUserFontType aFontType,
+                                     const uint8_t* aSaneData,
+                                     uint32_t aSaneLength,
+                                     const nsTArray<nsCString>& aMessages);
+
     // store metadata and src details for current src into aFontEntry
     void StoreUserFontData(gfxFontEntry*      aFontEntry,
                            bool               aPrivate,
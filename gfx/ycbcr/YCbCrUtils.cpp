@@ -3,7 +3,12 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
+
 #include "gfx2DGlue.h"
+#include "gfxPrefs.h"
+#include "mozilla/gfx/JobScheduler.h"
+#include "prsystem.h"
 
 #include "YCbCrUtils.h"
 #include "yuv_convert.h"
@@ -12,6 +17,98 @@
 namespace mozilla {
 namespace gfx {
 
+// Bands converted in parallel are at least this many rows high, so that the
+// cost of scheduling a job stays small next to the conversion itself.
+static const int kMinParallelBandHeight = 64;
+
+// Converts a horizontal band of a picture to RGB32 on a JobScheduler worker.
+//
+// The buffers are kept alive by the thread that submitted the job until the
+// job's completion is signaled.
+class ConvertYCbCrBandJob : public Job
+{
+public:
+  ConvertYCbCrBandJob(const layers::PlanarYCbCrData& aData,
+                      YUVType aYUVType,
+                      int aBandY,
+                      int aBandHeight,
+                      unsigned char* aDestBuffer,
+                      int32_t aStride,
+                      SyncObject* aCompletion)
+    : Job(nullptr, aCompletion)
+    , mData(aData)
+    , mYUVType(aYUVType)
+    , mBandY(aBandY)
+    , mBandHeight(aBandHeight)
+    , mDestBuffer(aDestBuffer)
+    , mStride(aStride)
+  {}
+
+  virtual JobStatus Run() override
+  {
+    ConvertYCbCrToRGB32(mData.mYChannel,
+                        mData.mCbChannel,
+                        mData.mCrChannel,
+                        mDestBuffer + mBandY * mStride,
+                        mData.mPicX,
+                        mData.mPicY + mBandY,
+                        mData.mPicSize.width,
+                        mBandHeight,
+                        mData.mYStride,
+                        mData.mCbCrStride,
+                        mStride,
+                        mYUVType);
+    return JobStatus::Complete;
+  }
+
+private:
+  layers::PlanarYCbCrData mData;
+  YUVType mYUVType;
+  int mBandY;
+  int mBandHeight;
+  unsigned char* mDestBuffer;
+  int32_t mStride;
+};
+
+// Splits the conversion of large pictures into horizontal bands converted on
+// the JobScheduler workers, and blocks until they are all done. Returns false
+// if the picture should be converted on this thread instead.
+static bool
+ConvertYCbCrToRGB32InParallel(const layers::PlanarYCbCrData& aData,
+                              YUVType aYUVType,
+                              unsigned char* aDestBuffer,
+                              int32_t aStride)
+{
+  uint32_t minPixels = gfxPrefs::YCbCrParallelConversionMinPixels();
+  if (!minPixels || !JobScheduler::IsEnabled() ||
+      uint64_t(aData.mPicSize.width) * aData.mPicSize.height < minPixels) {
+    return false;
+  }
+
+  int bandCount = std::min(PR_GetNumberOfProcessors(),
+                           aData.mPicSize.height / kMinParallelBandHeight);
+  if (bandCount < 2) {
+    return false;
+  }
+
+  // Chroma rows are shared by pairs of luma rows in 4:2:0, so bands start on
+  // even rows to convert exactly like a single pass would.
+  int bandHeight = (aData.mPicSize.height / bandCount + 1) & ~1;
+  bandCount = (aData.mPicSize.height + bandHeight - 1) / bandHeight;
+
+  RefPtr<SyncObject> completion = new SyncObject(bandCount);
+  for (int bandY = 0; bandY < aData.mPicSize.height; bandY += bandHeight) {
+    JobScheduler::SubmitJob(
+      new ConvertYCbCrBandJob(aData, aYUVType, bandY,
+                              std::min(bandHeight,
+                                       aData.mPicSize.height - bandY),
+                              aDestBuffer, aStride, completion));
+  }
+  completion->FreezePrerequisites();
+  JobScheduler::Join(completion);
+  return true;
+}
+
 void
 GetYCbCrToRGBDestFormatAndSize(const layers::PlanarYCbCrData& aData,
                                SurfaceFormat& aSuggestedFormat,
@@ -136,6 +233,7 @@ ConvertYCbCrToRGB(const layers::PlanarYCbCrData& aData,
                            yuvtype);
     } else // aDestFormat != SurfaceFormat::R5G6B5_UINT16
 #endif
+    if (!ConvertYCbCrToRGB32InParallel(aData, yuvtype, aDestBuffer, aStride))
       ConvertYCbCrToRGB32(aData.mYChannel, //
                           aData.mCbChannel,
                           aData.mCrChannel,
@@ -5,9 +5,12 @@
 
 #include "AnimationSurfaceProvider.h"
 
+#include <algorithm>
+
 #include "gfxPrefs.h"
 #include "nsProxyRelease.h"
 
+#include "DecodePool.h"
 #include "Decoder.h"
 
 using namespace mozilla::gfx;
@@ -17,13 +20,29 @@ namespace image {
 
 AnimationSurfaceProvider::AnimationSurfaceProvider(NotNull<RasterImage*> aImage,
                                                    const SurfaceKey& aSurfaceKey,
-                                                   NotNull<Decoder*> aDecoder)
+                                                   NotNull<Decoder*> aDecoder,
+                                                   DecoderType aDecoderType,
+                                                   NotNull<SourceBuffer*> aSourceBuffer)
   : ISurfaceProvider(ImageKey(aImage.get()), aSurfaceKey,
                      AvailabilityState::StartAsPlaceholder())
   , mImage(aImage.get())
   , mDecodingMutex("AnimationSurfaceProvider::mDecoder")
   , mDecoder(aDecoder.get())
+  , mDecoderType(aDecoderType)
+  , mSourceBuffer(aSourceBuffer)
+  , mDecoderFlags(aDecoder->GetDecoderFlags())
+  , mSurfaceFlags(aDecoder->GetSurfaceFlags())
   , mFramesMutex("AnimationSurfaceProvider::mFrames")
+  , mNextFrameIndex(0)
+  , mLastDecodedFrame(nullptr)
+  , mCurrentFrame(0)
+  // We need at least the current frame and the next one in the window.
+  , mWindowSize(std::max<size_t>(gfxPrefs::ImageAnimatedDecodeOnDemandBatchSize(), 2))
+  , mStreamingThresholdBytes(
+      size_t(gfxPrefs::ImageAnimatedDecodeOnDemandThresholdKB()) * 1024)
+  , mStreaming(false)
+  , mPaused(false)
+  , mRedecodeFailed(false)
 {
   MOZ_ASSERT(!mDecoder->IsMetadataDecode(),
              "Use MetadataDecodingTask for metadata decodes");
@@ -68,13 +87,14 @@ AnimationSurfaceProvider::DrawableRef(size_t aFrame)
     return DrawableFrameRef();
   }
 
-  // If we don't have that frame, return an empty frame ref.
-  if (aFrame >= mFrames.Length()) {
+  // If we don't have that frame (either because we haven't decoded it yet, or
+  // because we're streaming and it's outside the window), return an empty
+  // frame ref.
+  if (aFrame >= mFrames.Length() || !mFrames[aFrame]) {
     return DrawableFrameRef();
   }
 
   // We've got the requested frame. Return it.
-  MOZ_ASSERT(mFrames[aFrame]);
   return mFrames[aFrame]->DrawableRef();
 }
 
@@ -93,7 +113,8 @@ AnimationSurfaceProvider::IsFinished() const
     return false;
   }
 
-  // As long as we have at least one finished frame, we're finished.
+  // As long as we have at least one finished frame, we're finished. (We never
+  // discard the first frame, even when streaming.)
   return mFrames[0]->IsFinished();
 }
 
@@ -126,21 +147,137 @@ AnimationSurfaceProvider::AddSizeOfExcludingThis(MallocSizeOf aMallocSizeOf,
   MutexAutoLock lock(mFramesMutex);
 
   for (const RawAccessFrameRef& frame : mFrames) {
-    frame->AddSizeOfExcludingThis(aMallocSizeOf, aHeapSizeOut, aNonHeapSizeOut);
+    if (frame) {
+      frame->AddSizeOfExcludingThis(aMallocSizeOf, aHeapSizeOut, aNonHeapSizeOut);
+    }
   }
 }
 
 void
-AnimationSurfaceProvider::Run()
+AnimationSurfaceProvider::Advance(size_t aFrame)
 {
-  MutexAutoLock lock(mDecodingMutex);
+  bool resume = false;
+
+  {
+    MutexAutoLock lock(mFramesMutex);
+
+    mCurrentFrame = aFrame;
+    if (!mStreaming) {
+      return;  // We're keeping all the frames; nothing to do.
+    }
+
+    DiscardFramesOutsideWindow();
+
+    // If we paused decoding because the window was full, and the window has
+    // moved on, pick up where we left off.
+    if (mPaused && ChooseNextDecodeStep() != NextDecodeStep::PAUSE) {
+      mPaused = false;
+      resume = true;
+    }
+  }
+
+  if (resume) {
+    DecodePool::Singleton()->AsyncRun(this);
+  }
+}
+
+bool
+AnimationSurfaceProvider::IsInWindow(size_t aFrame) const
+{
+  mFramesMutex.AssertCurrentThreadOwns();
+
+  if (!mFrameCount) {
+    // We don't know where the animation wraps around yet, and we never decode
+    // past the end of the window during the first decode, so everything from
+    // the current frame on is in the window.
+    return aFrame >= mCurrentFrame;
+  }
+
+  const size_t frameCount = *mFrameCount;
+  if (aFrame >= frameCount || mCurrentFrame >= frameCount) {
+    return false;
+  }
 
-  if (!mDecoder || !mImage) {
-    MOZ_ASSERT_UNREACHABLE("Running after decoding finished?");
-    return;
+  // The window wraps around to the start of the animation.
+  return (aFrame + frameCount - mCurrentFrame) % frameCount < mWindowSize;
+}
+
+void
+AnimationSurfaceProvider::DiscardFramesOutsideWindow()
+{
+  mFramesMutex.AssertCurrentThreadOwns();
+  MOZ_ASSERT(mStreaming);
+
+  // Never discard the first frame; it's cheap to keep, it's what gets drawn
+  // when there's no better frame available, and it makes looping seamless.
+  for (size_t i = 1; i < mFrames.Length(); ++i) {
+    if (mFrames[i] && !IsInWindow(i)) {
+      mFrames[i] = RawAccessFrameRef();
+    }
+  }
+}
+
+AnimationSurfaceProvider::NextDecodeStep
+AnimationSurfaceProvider::ChooseNextDecodeStep() const
+{
+  mFramesMutex.AssertCurrentThreadOwns();
+
+  if (!mStreaming) {
+    return NextDecodeStep::CONTINUE;
+  }
+
+  if (mRedecodeFailed) {
+    return NextDecodeStep::PAUSE;
   }
 
+  if (!mFrameCount) {
+    // During the first decode, we just stop when we reach the end of the
+    // window.
+    return mNextFrameIndex < mCurrentFrame + mWindowSize
+         ? NextDecodeStep::CONTINUE
+         : NextDecodeStep::PAUSE;
+  }
+
+  // Find the first frame in the window that we're missing. If the decoder
+  // hasn't reached it yet, keep going; otherwise we need to start over.
+  const size_t frameCount = *mFrameCount;
+  for (size_t i = 0; i < std::min(mWindowSize, frameCount); ++i) {
+    const size_t frame = (mCurrentFrame + i) % frameCount;
+    if (frame >= mFrames.Length() || !mFrames[frame]) {
+      return frame >= mNextFrameIndex ? NextDecodeStep::CONTINUE
+                                      : NextDecodeStep::RESTART;
+    }
+  }
+
+  return NextDecodeStep::PAUSE;
+}
+
+void
+AnimationSurfaceProvider::Run()
+{
+  MutexAutoLock lock(mDecodingMutex);
+
   while (true) {
+    NextDecodeStep step;
+    {
+      MutexAutoLock framesLock(mFramesMutex);
+      step = ChooseNextDecodeStep();
+      if (step == NextDecodeStep::PAUSE) {
+        // The window is full. Advance() will resume us when it moves.
+        mPaused = true;
+        return;
+      }
+    }
+
+    if (step == NextDecodeStep::RESTART && !RestartDecoder()) {
+      return;
+    }
+
+    if (!mDecoder) {
+      MOZ_ASSERT_UNREACHABLE("Running after decoding finished?");
+      return;
+    }
+
     // Run the decoder.
     LexerResult result = mDecoder->Decode(WrapNotNull(this));
 
@@ -152,13 +289,20 @@ AnimationSurfaceProvider::Run()
       // possibilities.
       CheckForNewFrameAtTerminalState();
 
-      // We're done!
+      // We're done! Unless we're streaming, in which case we may need to start
+      // over for frames we've discarded.
       FinishDecoding();
-      return;
+
+      MutexAutoLock framesLock(mFramesMutex);
+      if (!mStreaming) {
+        return;
+      }
+      continue;
     }
 
-    // Notify for the progress we've made so far.
-    if (mDecoder->HasProgress()) {
+    // Notify for the progress we've made so far. If we're decoding the
+    // animation again, the image already knows all about it.
+    if (mImage && mDecoder->HasProgress()) {
       NotifyProgress(WrapNotNull(mImage), WrapNotNull(mDecoder));
     }
 
@@ -193,15 +337,9 @@ AnimationSurfaceProvider::CheckForNewFrameAtYield()
     }
 
     // We should've gotten a different frame than last time.
-    MOZ_ASSERT_IF(!mFrames.IsEmpty(),
-                  mFrames.LastElement().get() != frame.get());
-
-    // Append the new frame to the list.
-    mFrames.AppendElement(Move(frame));
+    MOZ_ASSERT(mLastDecodedFrame != frame.get());
 
-    if (mFrames.Length() == 1) {
-      justGotFirstFrame = true;
-    }
+    justGotFirstFrame = AddFrame(Move(frame));
   }
 
   if (justGotFirstFrame) {
@@ -225,16 +363,11 @@ AnimationSurfaceProvider::CheckForNewFrameAtTerminalState()
       return;
     }
 
-    if (!mFrames.IsEmpty() && mFrames.LastElement().get() == frame.get()) {
+    if (mLastDecodedFrame == frame.get()) {
       return;  // We already have this one.
     }
 
-    // Append the new frame to the list.
-    mFrames.AppendElement(Move(frame));
-
-    if (mFrames.Length() == 1) {
-      justGotFirstFrame = true;
-    }
+    justGotFirstFrame = AddFrame(Move(frame));
   }
 
   if (justGotFirstFrame) {
@@ -242,6 +375,67 @@ AnimationSurfaceProvider::CheckForNewFrameAtTerminalState()
   }
 }
 
+bool
+AnimationSurfaceProvider::AddFrame(RawAccessFrameRef&& aFrame)
+{
+  mFramesMutex.AssertCurrentThreadOwns();
+
+  const size_t index = mNextFrameIndex++;
+  mLastDecodedFrame = aFrame.get();
+
+  if (mFrameCount) {
+    // We're decoding the animation again; only keep the frames we're missing
+    // from the window.
+    if (index < mFrames.Length() && !mFrames[index] && IsInWindow(index)) {
+      mFrames[index] = Move(aFrame);
+    }
+    return false;
+  }
+
+  // This is the first decode, so frames arrive in order and all of them are
+  // wanted. (ChooseNextDecodeStep() stops us at the end of the window.)
+  MOZ_ASSERT(index == mFrames.Length());
+  mFrames.AppendElement(Move(aFrame));
+
+  // If keeping every frame would take too much memory, start streaming.
+  if (!mStreaming && mStreamingThresholdBytes > 0) {
+    IntSize size = GetSurfaceKey().Size();
+    size_t frameBytes = size_t(size.width) * size.height * sizeof(uint32_t);
+    if (mFrames.Length() * frameBytes > mStreamingThresholdBytes) {
+      mStreaming = true;
+      DiscardFramesOutsideWindow();
+    }
+  }
+
+  return mFrames.Length() == 1;
+}
+
+bool
+AnimationSurfaceProvider::RestartDecoder()
+{
+  mDecodingMutex.AssertCurrentThreadOwns();
+
+  RefPtr<Decoder> decoder =
+    DecoderFactory::CreateAnonymousAnimationDecoder(mDecoderType,
+                                                    mSourceBuffer,
+                                                    mDecoderFlags,
+                                                    mSurfaceFlags);
+
+  MutexAutoLock lock(mFramesMutex);
+
+  if (!decoder) {
+    // Without a decoder, the frames we've discarded are gone for good. The
+    // animation will stop at the first one it can't get.
+    mRedecodeFailed = true;
+    return false;
+  }
+
+  mDecoder = decoder.forget();
+  mNextFrameIndex = 0;
+  mLastDecodedFrame = nullptr;
+  return true;
+}
+
 void
 AnimationSurfaceProvider::AnnounceSurfaceAvailable()
 {
@@ -260,11 +454,27 @@ void
 AnimationSurfaceProvider::FinishDecoding()
 {
   mDecodingMutex.AssertCurrentThreadOwns();
-  MOZ_ASSERT(mImage);
   MOZ_ASSERT(mDecoder);
 
-  // Send notifications.
-  NotifyDecodeComplete(WrapNotNull(mImage), WrapNotNull(mDecoder));
+  {
+    MutexAutoLock lock(mFramesMutex);
+
+    if (!mFrameCount) {
+      // Now we know how many frames there are.
+      mFrameCount = Some(mNextFrameIndex);
+    } else if (mNextFrameIndex < *mFrameCount) {
+      // Decoding the animation again came up short. Don't keep trying.
+      mRedecodeFailed = true;
+    }
+
+    mLastDecodedFrame = nullptr;
+  }
+
+  // Send notifications, unless this was a redecode of an animation we've
+  // already told the image all about.
+  if (mImage) {
+    NotifyDecodeComplete(WrapNotNull(mImage), WrapNotNull(mDecoder));
+  }
 
   // Destroy our decoder; we don't need it anymore.
   mDecoder = nullptr;
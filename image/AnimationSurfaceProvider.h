@@ -10,6 +10,7 @@
 #ifndef mozilla_image_AnimationSurfaceProvider_h
 #define mozilla_image_AnimationSurfaceProvider_h
 
+#include "DecoderFactory.h"
 #include "FrameAnimator.h"
 #include "IDecodingTask.h"
 #include "ISurfaceProvider.h"
@@ -21,6 +22,15 @@ namespace image {
  * An ISurfaceProvider that manages the decoding of animated images and
  * dynamically generates surfaces for the current playback state of the
  * animation.
+ *
+ * Normally all of the frames of the animation are kept once they're decoded.
+ * If that would take more memory than the image.animated.decode-on-demand
+ * threshold, the provider switches to streaming: it only keeps the first frame
+ * and a small window of frames starting at the one FrameAnimator is currently
+ * showing, pauses decoding when the window is full, and decodes the animation
+ * again from the start of its SourceBuffer when it loops. FrameAnimator keeps
+ * the composited result of the frames it has blended so far, so the blend and
+ * dispose state survives the raw frames being discarded.
  */
 class AnimationSurfaceProvider final
   : public ISurfaceProvider
@@ -31,7 +41,9 @@ public:
 
   AnimationSurfaceProvider(NotNull<RasterImage*> aImage,
                            const SurfaceKey& aSurfaceKey,
-                           NotNull<Decoder*> aDecoder);
+                           NotNull<Decoder*> aDecoder,
+                           DecoderType aDecoderType,
+                           NotNull<SourceBuffer*> aSourceBuffer);
 
 
   //////////////////////////////////////////////////////////////////////////////
@@ -48,6 +60,7 @@ public:
   void AddSizeOfExcludingThis(MallocSizeOf aMallocSizeOf,
                               size_t& aHeapSizeOut,
                               size_t& aNonHeapSizeOut) override;
+  void Advance(size_t aFrame) override;
 
 protected:
   DrawableFrameRef DrawableRef(size_t aFrame) override;
@@ -72,15 +85,30 @@ public:
   // Full decodes are low priority compared to metadata decodes because they
   // don't block layout or page load.
   TaskPriority Priority() const override { return TaskPriority::eLow; }
+  size_t DecodedSizeHint() const override { return LogicalSizeInBytes(); }
 
 private:
   virtual ~AnimationSurfaceProvider();
 
+  /// What Run() should do next when streaming.
+  enum class NextDecodeStep
+  {
+    CONTINUE,  // Keep decoding with the current decoder.
+    PAUSE,     // We have all the frames we want for now.
+    RESTART    // We need frames the current decoder is already past.
+  };
+
   void DropImageReference();
   void CheckForNewFrameAtYield();
   void CheckForNewFrameAtTerminalState();
+  bool AddFrame(RawAccessFrameRef&& aFrame);
   void AnnounceSurfaceAvailable();
   void FinishDecoding();
+  bool RestartDecoder();
+
+  bool IsInWindow(size_t aFrame) const;
+  void DiscardFramesOutsideWindow();
+  NextDecodeStep ChooseNextDecodeStep() const;
 
   /// The image associated with our decoder.
   RefPtr<RasterImage> mImage;
@@ -88,14 +116,47 @@ private:
   /// A mutex to protect mDecoder. Always taken before mFramesMutex.
   mutable Mutex mDecodingMutex;
 
-  /// The decoder used to decode this animation.
+  /// The decoder used to decode this animation. If we're streaming, this may
+  /// be replaced by a new decoder that starts over from the beginning.
   RefPtr<Decoder> mDecoder;
 
-  /// A mutex to protect mFrames. Always taken after mDecodingMutex.
+  /// What we need to create a new decoder when we're streaming.
+  const DecoderType mDecoderType;
+  const NotNull<RefPtr<SourceBuffer>> mSourceBuffer;
+  const DecoderFlags mDecoderFlags;
+  const SurfaceFlags mSurfaceFlags;
+
+  /// A mutex to protect mFrames and the streaming state below. Always taken
+  /// after mDecodingMutex.
   mutable Mutex mFramesMutex;
 
-  /// The frames of this animation, in order.
+  /// The frames of this animation, in order. When streaming, frames outside of
+  /// the window are discarded and their entries are left empty.
   nsTArray<RawAccessFrameRef> mFrames;
+
+  /// The number of frames in the animation, once the first decode finishes.
+  Maybe<size_t> mFrameCount;
+
+  /// The index of the frame the decoder will produce next.
+  size_t mNextFrameIndex;
+
+  /// The last frame the decoder produced. Only used for comparisons; the
+  /// decoder keeps it alive.
+  imgFrame* mLastDecodedFrame;
+
+  /// The frame FrameAnimator is currently showing, which starts the window.
+  size_t mCurrentFrame;
+
+  /// The number of frames in the window, and the memory use above which we
+  /// start streaming.
+  const size_t mWindowSize;
+  const size_t mStreamingThresholdBytes;
+
+  /// Whether we're streaming, whether decoding is paused because the window
+  /// is full, and whether decoding the animation again failed.
+  bool mStreaming;
+  bool mPaused;
+  bool mRedecodeFailed;
 };
 
 } // namespace image
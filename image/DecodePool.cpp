@@ -56,9 +56,26 @@ public:
 
   DecodePoolImpl()
     : mMonitor("DecodePoolImpl")
+    , mMaxLowPriorityTasks(1)
+    , mActiveLowPriorityTasks(0)
     , mShuttingDown(false)
   { }
 
+  /**
+   * Sets the number of decode pool threads. Must be called before any of the
+   * threads start running.
+   *
+   * With three or more threads, one thread is reserved for high priority work,
+   * so that metadata decodes, which block layout and page load, never have to
+   * wait behind a backlog of full decodes. With fewer threads we can't afford
+   * to leave a thread idle, so all of them may run low priority work.
+   */
+  void SetThreadCount(uint32_t aCount)
+  {
+    MonitorAutoLock lock(mMonitor);
+    mMaxLowPriorityTasks = aCount >= 3 ? aCount - 1 : max<uint32_t>(aCount, 1);
+  }
+
   /// Initialize the current thread for use by the decode pool.
   void InitCurrentThread()
   {
@@ -119,10 +136,14 @@ public:
         return PopWorkFromQueue(mHighPriorityQueue);
       }
 
-      if (!mLowPriorityQueue.IsEmpty()) {
-        return PopWorkFromQueue(mLowPriorityQueue);
+      if (!mLowPriorityQueue.IsEmpty() &&
+          mActiveLowPriorityTasks < mMaxLowPriorityTasks) {
+        mActiveLowPriorityTasks++;
+        return PopBestWorkFromQueue(mLowPriorityQueue);
       }
 
+      // If we're shutting down, any low priority work that's left will be
+      // picked up by the threads that are currently running low priority work.
       if (mShuttingDown) {
         Work work;
         work.mType = Work::Type::SHUTDOWN;
@@ -134,6 +155,24 @@ public:
     } while (true);
   }
 
+  /// Called by a decode pool thread when it's done with a work item that it
+  /// got from PopWork().
+  void WorkFinished(const Work& aWork)
+  {
+    MOZ_ASSERT(aWork.mType == Work::Type::TASK);
+
+    if (aWork.mTask->Priority() != TaskPriority::eLow) {
+      return;
+    }
+
+    MonitorAutoLock lock(mMonitor);
+    MOZ_ASSERT(mActiveLowPriorityTasks > 0);
+    mActiveLowPriorityTasks--;
+
+    // The calling thread will ask for more work right away, so there's no need
+    // to wake up any other thread for the queued low priority work.
+  }
+
 private:
   ~DecodePoolImpl() { }
 
@@ -147,12 +186,53 @@ private:
     return work;
   }
 
+  /**
+   * Pops the work item from @aQueue that will put the most pixels on the
+   * screen the soonest: tasks for visible images go first, and among those,
+   * the ones with the smallest decoded size. Ties go to the most recently
+   * queued task, as in PopWorkFromQueue().
+   *
+   * This is a linear scan, but the queue is rarely more than a few dozen items
+   * long, and popping is cheap compared to the decode that follows.
+   */
+  Work PopBestWorkFromQueue(nsTArray<RefPtr<IDecodingTask>>& aQueue)
+  {
+    size_t best = aQueue.Length() - 1;
+    bool bestVisible = aQueue[best]->IsForVisibleImage();
+    size_t bestSize = aQueue[best]->DecodedSizeHint();
+
+    for (size_t i = best; i-- > 0; ) {
+      bool visible = aQueue[i]->IsForVisibleImage();
+      if (visible != bestVisible) {
+        if (!visible) {
+          continue;
+        }
+      } else if (aQueue[i]->DecodedSizeHint() >= bestSize) {
+        continue;
+      }
+
+      best = i;
+      bestVisible = visible;
+      bestSize = aQueue[i]->DecodedSizeHint();
+    }
+
+    Work work;
+    work.mType = Work::Type::TASK;
+    work.mTask = aQueue[best].forget();
+    aQueue.RemoveElementAt(best);
+
+    return work;
+  }
+
   nsThreadPoolNaming mThreadNaming;
 
-  // mMonitor guards the queues and mShuttingDown.
+  // mMonitor guards the queues, the low priority task counts, and
+  // mShuttingDown.
   Monitor mMonitor;
   nsTArray<RefPtr<IDecodingTask>> mHighPriorityQueue;
   nsTArray<RefPtr<IDecodingTask>> mLowPriorityQueue;
+  uint32_t mMaxLowPriorityTasks;
+  uint32_t mActiveLowPriorityTasks;
   bool mShuttingDown;
 };
 
@@ -174,7 +254,14 @@ public:
       Work work = mImpl->PopWork();
       switch (work.mType) {
         case Work::Type::TASK:
-          work.mTask->Run();
+          // Tasks may have become useless while they sat in the queue (e.g.
+          // because their image scrolled away); give them a chance to bail
+          // out. This happens outside of the monitor, since tasks may need to
+          // take their own locks to do it.
+          if (!work.mTask->CancelIfUnneeded()) {
+            work.mTask->Run();
+          }
+          mImpl->WorkFinished(work);
           break;
 
         case Work::Type::SHUTDOWN:
@@ -246,6 +333,8 @@ DecodePool::DecodePool()
     limit = 32;
   }
 
+  mImpl->SetThreadCount(limit);
+
   // Initialize the thread pool.
   for (uint32_t i = 0 ; i < limit ; ++i) {
     nsCOMPtr<nsIRunnable> worker = new DecodePoolWorker(mImpl);
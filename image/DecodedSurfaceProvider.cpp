@@ -23,6 +23,7 @@ DecodedSurfaceProvider::DecodedSurfaceProvider(NotNull<RasterImage*> aImage,
   , mImage(aImage.get())
   , mMutex("mozilla::image::DecodedSurfaceProvider")
   , mDecoder(aDecoder.get())
+  , mImageWasLocked(aImage->HasLocks())
 {
   MOZ_ASSERT(!mDecoder->IsMetadataDecode(),
              "Use MetadataDecodingTask for metadata decodes");
@@ -214,6 +215,48 @@ DecodedSurfaceProvider::FinishDecoding()
   DropImageReference();
 }
 
+bool
+DecodedSurfaceProvider::IsForVisibleImage() const
+{
+  // |mImage| is only cleared when we finish decoding or get canceled, and
+  // neither can happen while we're waiting in the DecodePool queue, which is
+  // the only time this gets called. That makes it safe to read without
+  // holding |mMutex|.
+  return !mImageWasLocked || !mImage || mImage->HasLocks();
+}
+
+bool
+DecodedSurfaceProvider::CancelIfUnneeded()
+{
+  MutexAutoLock lock(mMutex);
+
+  if (!mDecoder) {
+    // We've already been canceled, and the decoder's SourceBuffer resumed us
+    // anyway. There's nothing left to do.
+    return true;
+  }
+
+  if (mSurface) {
+    // We've already started producing a surface and told the surface cache
+    // about it; finish the job rather than throw away the work we've done.
+    return false;
+  }
+
+  if (!mImageWasLocked || mImage->HasLocks()) {
+    return false;  // The image is still (or may still be) in use.
+  }
+
+  // The image was unlocked while we sat in the queue, which means it's no
+  // longer approximately visible (e.g. it was scrolled away). Give up, and
+  // remove our placeholder from the surface cache so that if the image is ever
+  // drawn again it'll get a fresh decode. We hold |mMutex| while we do this,
+  // which is the same lock order as CheckForNewSurface().
+  SurfaceCache::RemovePlaceholder(WrapNotNull(this));
+  mDecoder = nullptr;
+  DropImageReference();
+  return true;
+}
+
 bool
 DecodedSurfaceProvider::ShouldPreferSyncRun() const
 {
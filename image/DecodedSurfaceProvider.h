@@ -59,6 +59,10 @@ public:
   // don't block layout or page load.
   TaskPriority Priority() const override { return TaskPriority::eLow; }
 
+  bool IsForVisibleImage() const override;
+  size_t DecodedSizeHint() const override { return LogicalSizeInBytes(); }
+  bool CancelIfUnneeded() override;
+
 
 private:
   virtual ~DecodedSurfaceProvider();
@@ -81,6 +85,11 @@ private:
 
   /// A drawable reference to our service; used for locking.
   DrawableFrameRef mLockRef;
+
+  /// Whether our image was locked when we were created. Images that were never
+  /// locked (e.g. ones that are only drawn into a canvas) don't tell us
+  /// anything about their visibility by being unlocked.
+  const bool mImageWasLocked;
 };
 
 } // namespace image
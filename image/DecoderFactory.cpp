@@ -171,21 +171,12 @@ DecoderFactory::CreateAnimationDecoder(DecoderType aType,
     return nullptr;
   }
 
-  MOZ_ASSERT(aType == DecoderType::GIF || aType == DecoderType::PNG,
-             "Calling CreateAnimationDecoder for non-animating DecoderType");
-
   // Create an anonymous decoder. Interaction with the SurfaceCache and the
   // owning RasterImage will be mediated by AnimationSurfaceProvider.
-  RefPtr<Decoder> decoder = GetDecoder(aType, nullptr, /* aIsRedecode = */ true);
-  MOZ_ASSERT(decoder, "Should have a decoder now");
-
-  // Initialize the decoder.
-  decoder->SetMetadataDecode(false);
-  decoder->SetIterator(aSourceBuffer->Iterator());
-  decoder->SetDecoderFlags(aDecoderFlags | DecoderFlags::IS_REDECODE);
-  decoder->SetSurfaceFlags(aSurfaceFlags);
-
-  if (NS_FAILED(decoder->Init())) {
+  RefPtr<Decoder> decoder =
+    CreateAnonymousAnimationDecoder(aType, aSourceBuffer,
+                                    aDecoderFlags, aSurfaceFlags);
+  if (!decoder) {
     return nullptr;
   }
 
@@ -196,7 +187,9 @@ DecoderFactory::CreateAnimationDecoder(DecoderType aType,
   NotNull<RefPtr<AnimationSurfaceProvider>> provider =
     WrapNotNull(new AnimationSurfaceProvider(aImage,
                                              surfaceKey,
-                                             WrapNotNull(decoder)));
+                                             WrapNotNull(decoder),
+                                             aType,
+                                             aSourceBuffer));
 
   // Attempt to insert the surface provider into the surface cache right away so
   // we won't trigger any more decoders with the same parameters.
@@ -209,6 +202,31 @@ DecoderFactory::CreateAnimationDecoder(DecoderType aType,
   return task.forget();
 }
 
+/* static */ already_AddRefed<Decoder>
+DecoderFactory::CreateAnonymousAnimationDecoder(DecoderType aType,
+                                                NotNull<SourceBuffer*> aSourceBuffer,
+                                                DecoderFlags aDecoderFlags,
+                                                SurfaceFlags aSurfaceFlags)
+{
+  MOZ_ASSERT(aType == DecoderType::GIF || aType == DecoderType::PNG,
+             "Calling CreateAnimationDecoder for non-animating DecoderType");
+
+  RefPtr<Decoder> decoder = GetDecoder(aType, nullptr, /* aIsRedecode = */ true);
+  MOZ_ASSERT(decoder, "Should have a decoder now");
+
+  // Initialize the decoder.
+  decoder->SetMetadataDecode(false);
+  decoder->SetIterator(aSourceBuffer->Iterator());
+  decoder->SetDecoderFlags(aDecoderFlags | DecoderFlags::IS_REDECODE);
+  decoder->SetSurfaceFlags(aSurfaceFlags);
+
+  if (NS_FAILED(decoder->Init())) {
+    return nullptr;
+  }
+
+  return decoder.forget();
+}
+
 /* static */ already_AddRefed<IDecodingTask>
 DecoderFactory::CreateMetadataDecoder(DecoderType aType,
                                       NotNull<RasterImage*> aImage,
@@ -99,6 +99,25 @@ public:
                          DecoderFlags aDecoderFlags,
                          SurfaceFlags aSurfaceFlags);
 
+  /**
+   * Creates and initializes an anonymous decoder for animated images of type
+   * @aType, which starts decoding at the beginning of @aSourceBuffer. This is
+   * used by AnimationSurfaceProvider to decode an animation again when it
+   * needs frames it has already discarded; the decoder sends no notifications.
+   *
+   * @param aType Which type of decoder to create - GIF or PNG.
+   * @param aSourceBuffer The SourceBuffer which the decoder will read its data
+   *                      from.
+   * @param aDecoderFlags Flags specifying the behavior of this decoder.
+   * @param aSurfaceFlags Flags specifying the type of output this decoder
+   *                      should produce.
+   */
+  static already_AddRefed<Decoder>
+  CreateAnonymousAnimationDecoder(DecoderType aType,
+                                  NotNull<SourceBuffer*> aSourceBuffer,
+                                  DecoderFlags aDecoderFlags,
+                                  SurfaceFlags aSurfaceFlags);
+
   /**
    * Creates and initializes a metadata decoder of type @aType. This decoder
    * will only decode the image's header, extracting metadata like the size of
@@ -177,6 +177,11 @@ FrameAnimator::AdvanceFrame(AnimationState& aState, TimeStamp aTime)
     }
   }
 
+  // Let the surface provider know which frame we're on, so that if it's
+  // streaming the animation it can drop the frames we're done with and decode
+  // the ones we're about to need.
+  AdvanceSurfaceProvider(currentFrameIndex);
+
   if (nextFrameIndex >= aState.KnownFrameCount()) {
     // We've already advanced to the last decoded frame, nothing more we can do.
     // We're blocked by network/decoding from displaying the animation at the
@@ -381,6 +386,19 @@ FrameAnimator::CollectSizeOfCompositingSurfaces(
   }
 }
 
+void
+FrameAnimator::AdvanceSurfaceProvider(uint32_t aFrameNum) const
+{
+  LookupResult result =
+    SurfaceCache::Lookup(ImageKey(mImage),
+                         RasterSurfaceKey(mSize,
+                                          DefaultSurfaceFlags(),
+                                          PlaybackType::eAnimated));
+  if (result) {
+    result.Surface().Advance(aFrameNum);
+  }
+}
+
 RawAccessFrameRef
 FrameAnimator::GetRawFrame(uint32_t aFrameNum) const
 {
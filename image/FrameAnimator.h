@@ -229,6 +229,12 @@ private: // methods
    */
   RefreshResult AdvanceFrame(AnimationState& aState, TimeStamp aTime);
 
+  /**
+   * Tell the surface provider for our frames that we're showing frame
+   * @aFrameNum, so it can manage which frames it keeps decoded.
+   */
+  void AdvanceSurfaceProvider(uint32_t aFrameNum) const;
+
   /**
    * Get the @aIndex-th frame in the frame index, ignoring results of blending.
    */
@@ -72,12 +72,13 @@ IDecodingTask::NotifyDecodeComplete(NotNull<RasterImage*> aImage,
   Maybe<uint32_t> frameCount = aDecoder->TakeCompleteFrameCount();
   DecoderFlags decoderFlags = aDecoder->GetDecoderFlags();
   SurfaceFlags surfaceFlags = aDecoder->GetSurfaceFlags();
+  Maybe<IntSize> outputSize = aDecoder->ExplicitOutputSize();
 
   // Synchronously notify if we can.
   if (NS_IsMainThread() && !(decoderFlags & DecoderFlags::ASYNC_NOTIFY)) {
     aImage->NotifyDecodeComplete(finalStatus, metadata, telemetry, progress,
                                  invalidRect, frameCount, decoderFlags,
-                                 surfaceFlags);
+                                 surfaceFlags, outputSize);
     return;
   }
 
@@ -86,7 +87,7 @@ IDecodingTask::NotifyDecodeComplete(NotNull<RasterImage*> aImage,
   NS_DispatchToMainThread(NS_NewRunnableFunction([=]() -> void {
     image->NotifyDecodeComplete(finalStatus, metadata, telemetry, progress,
                                 invalidRect, frameCount, decoderFlags,
-                                surfaceFlags);
+                                surfaceFlags, outputSize);
   }));
 }
 
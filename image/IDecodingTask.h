@@ -45,6 +45,24 @@ public:
   /// @return a priority hint that DecodePool can use when scheduling this task.
   virtual TaskPriority Priority() const = 0;
 
+  /// @return true if the image this task is decoding is currently in use (i.e.,
+  /// it's locked, which layout does for approximately visible images).
+  /// DecodePool runs these tasks ahead of other tasks with the same priority.
+  /// May be called with DecodePool's monitor held, so it must be cheap and
+  /// must not take any locks.
+  virtual bool IsForVisibleImage() const { return true; }
+
+  /// @return a hint for how much memory this task will decode into. Among
+  /// tasks with the same priority and visibility, DecodePool runs smaller ones
+  /// first, since they'll put more images on the screen sooner. The same
+  /// restrictions as for IsForVisibleImage() apply.
+  virtual size_t DecodedSizeHint() const { return 0; }
+
+  /// Called on the decoding thread right before Run(). If the result of this
+  /// task isn't needed anymore, the task should release its resources and
+  /// return true, in which case Run() won't be called.
+  virtual bool CancelIfUnneeded() { return false; }
+
   /// A default implementation of IResumable which resubmits the task to the
   /// DecodePool. Subclasses can override this if they need different behavior.
   void Resume() override;
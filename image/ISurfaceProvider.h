@@ -75,6 +75,11 @@ public:
     ref->AddSizeOfExcludingThis(aMallocSizeOf, aHeapSizeOut, aNonHeapSizeOut);
   }
 
+  /// Hint that an animation has advanced to frame @aFrame, so that surfaces
+  /// for earlier frames may be released and later ones prepared. Only
+  /// meaningful for ISurfaceProviders for animated images.
+  virtual void Advance(size_t aFrame) { }
+
   /// @return the availability state of this ISurfaceProvider, which indicates
   /// whether DrawableRef() could successfully return a surface. Should only be
   /// called from SurfaceCache code as it relies on SurfaceCache for
@@ -189,6 +194,21 @@ public:
     return mDrawableRef ? NS_OK : NS_ERROR_FAILURE;
   }
 
+  /**
+   * If this DrawableSurface is dynamically generated from an animation, let
+   * the ISurfaceProvider know that the animation is now showing frame @aFrame.
+   * (@see ISurfaceProvider::Advance())
+   */
+  void Advance(size_t aFrame)
+  {
+    if (!mProvider) {
+      MOZ_ASSERT_UNREACHABLE("Trying to advance a static DrawableSurface?");
+      return;
+    }
+
+    mProvider->Advance(aFrame);
+  }
+
   explicit operator bool() const { return mHaveSurface; }
   imgFrame* operator->() { return DrawableRef().get(); }
 
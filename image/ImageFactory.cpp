@@ -23,6 +23,8 @@
 #include "nsMediaFragmentURIParser.h"
 #include "nsContentUtils.h"
 #include "nsIScriptSecurityManager.h"
+#include "nsNetUtil.h"
+#include "nsXULAppAPI.h"
 
 #include "gfxPrefs.h"
 
@@ -34,7 +36,8 @@ ImageFactory::Initialize()
 { }
 
 static uint32_t
-ComputeImageFlags(ImageURL* uri, const nsCString& aMimeType, bool isMultiPart)
+ComputeImageFlags(nsIRequest* aRequest, ImageURL* uri,
+                  const nsCString& aMimeType, bool isMultiPart)
 {
   nsresult rv;
 
@@ -63,6 +66,22 @@ ComputeImageFlags(ImageURL* uri, const nsCString& aMimeType, bool isMultiPart)
     isDiscardable = false;
   }
 
+  // Only share the decoded surfaces of images which any process loading the
+  // same bytes could see anyway: no private browsing, and nothing the server
+  // asked us not to store.
+  bool isShareable = XRE_IsContentProcess() && !isMultiPart &&
+                     gfxPrefs::ImageMemSharedSurfaceCacheEnabled();
+  nsCOMPtr<nsIChannel> channel = do_QueryInterface(aRequest);
+  if (isShareable && (!channel || NS_UsePrivateBrowsing(channel))) {
+    isShareable = false;
+  }
+  nsCOMPtr<nsIHttpChannel> httpChannel = do_QueryInterface(aRequest);
+  bool isNoStore = false;
+  if (isShareable && httpChannel &&
+      (NS_FAILED(httpChannel->IsNoStoreResponse(&isNoStore)) || isNoStore)) {
+    isShareable = false;
+  }
+
   // We have all the information we need.
   uint32_t imageFlags = Image::INIT_FLAG_NONE;
   if (isDiscardable) {
@@ -74,6 +93,9 @@ ComputeImageFlags(ImageURL* uri, const nsCString& aMimeType, bool isMultiPart)
   if (isMultiPart) {
     imageFlags |= Image::INIT_FLAG_TRANSIENT;
   }
+  if (isShareable) {
+    imageFlags |= Image::INIT_FLAG_SHAREABLE;
+  }
 
   return imageFlags;
 }
@@ -90,7 +112,8 @@ ImageFactory::CreateImage(nsIRequest* aRequest,
              "Pref observers should have been initialized already");
 
   // Compute the image's initialization flags.
-  uint32_t imageFlags = ComputeImageFlags(aURI, aMimeType, aIsMultiPart);
+  uint32_t imageFlags =
+    ComputeImageFlags(aRequest, aURI, aMimeType, aIsMultiPart);
 
   // Select the type of image to create based on MIME type.
   if (aMimeType.EqualsLiteral(IMAGE_SVG_XML)) {
@@ -25,6 +25,7 @@
 #include "nsIScriptError.h"
 #include "nsISupportsPrimitives.h"
 #include "nsPresContext.h"
+#include "SharedSurfaceCache.h"
 #include "SourceBuffer.h"
 #include "SurfaceCache.h"
 #include "FrameAnimator.h"
@@ -36,6 +37,7 @@
 #include "mozilla/Likely.h"
 #include "mozilla/RefPtr.h"
 #include "mozilla/Move.h"
+#include "mozilla/SHA1.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/Services.h"
 #include <stdint.h>
@@ -87,6 +89,7 @@ RasterImage::RasterImage(ImageURL* aURI /* = nullptr */) :
   mDiscardable(false),
   mHasSourceData(false),
   mHasBeenDecoded(false),
+  mShareable(false),
   mPendingAnimation(false),
   mAnimationFinished(false),
   mWantFullDecode(false)
@@ -132,6 +135,7 @@ RasterImage::Init(const char* aMimeType,
   mWantFullDecode = !!(aFlags & INIT_FLAG_DECODE_IMMEDIATELY);
   mTransient = !!(aFlags & INIT_FLAG_TRANSIENT);
   mSyncLoad = !!(aFlags & INIT_FLAG_SYNC_LOAD);
+  mShareable = !!(aFlags & INIT_FLAG_SHAREABLE);
 
   // Use the MIME type to select a decoder type, and make sure there *is* a
   // decoder for this MIME type.
@@ -1158,6 +1162,11 @@ RasterImage::Decode(const IntSize& aSize,
     surfaceFlags &= ~SurfaceFlags::NO_PREMULTIPLY_ALPHA;
   }
 
+  // If another process already decoded this surface, use its copy.
+  if (!mAnimationState && DecodeFromSharedSurface(aSize, surfaceFlags)) {
+    return NS_OK;
+  }
+
   // Create a decoder.
   RefPtr<IDecodingTask> task;
   if (mAnimationState && aPlaybackType == PlaybackType::eAnimated) {
@@ -1246,6 +1255,83 @@ HaveSkia()
 #endif
 }
 
+bool
+RasterImage::EnsureSourceDigest()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!mShareable || !mHasSourceData || mError) {
+    return false;
+  }
+
+  if (!mSourceDigest.IsEmpty()) {
+    return true;
+  }
+
+  // The source buffer is complete, so the iterator never has to wait.
+  SHA1Sum sum;
+  SourceBufferIterator iterator = mSourceBuffer->Iterator();
+  while (iterator.Advance(SIZE_MAX) == SourceBufferIterator::READY) {
+    sum.update(iterator.Data(), iterator.Length());
+  }
+
+  SHA1Sum::Hash hash;
+  sum.finish(hash);
+  mSourceDigest.Assign(reinterpret_cast<const char*>(hash), sizeof(hash));
+  return true;
+}
+
+bool
+RasterImage::DecodeFromSharedSurface(const IntSize& aSize,
+                                     SurfaceFlags aSurfaceFlags)
+{
+  if (!SharedSurfaceCache::ShouldShare(aSize) || !EnsureSourceDigest()) {
+    return false;
+  }
+
+  RefPtr<imgFrame> frame =
+    SharedSurfaceCache::Lookup(mSourceDigest, aSize, uint32_t(aSurfaceFlags));
+  if (!frame) {
+    return false;
+  }
+
+  SurfaceKey surfaceKey =
+    RasterSurfaceKey(aSize, aSurfaceFlags, PlaybackType::eStatic);
+  NotNull<RefPtr<ISurfaceProvider>> provider =
+    WrapNotNull(new SimpleSurfaceProvider(ImageKey(this), surfaceKey,
+                                          WrapNotNull(frame)));
+  if (SurfaceCache::Insert(provider) != InsertOutcome::SUCCESS) {
+    return false;
+  }
+
+  // Send the notifications a decoder would have sent.
+  mHasBeenDecoded = true;
+  NotifyProgress(FLAG_FRAME_COMPLETE | FLAG_DECODE_COMPLETE,
+                 IntRect(IntPoint(0, 0), mSize), Nothing(),
+                 DefaultDecoderFlags(), aSurfaceFlags);
+  return true;
+}
+
+void
+RasterImage::ShareDecodedSurface(const IntSize& aSize,
+                                 SurfaceFlags aSurfaceFlags)
+{
+  if (!SharedSurfaceCache::ShouldShare(aSize) || !EnsureSourceDigest()) {
+    return;
+  }
+
+  LookupResult result =
+    SurfaceCache::Lookup(ImageKey(this),
+                         RasterSurfaceKey(aSize, aSurfaceFlags,
+                                          PlaybackType::eStatic));
+  if (!result) {
+    return;
+  }
+
+  RefPtr<SourceSurface> surface = result.Surface()->GetSourceSurface();
+  SharedSurfaceCache::Store(mSourceDigest, uint32_t(aSurfaceFlags), surface);
+}
+
 bool
 RasterImage::CanDownscaleDuringDecode(const IntSize& aSize, uint32_t aFlags)
 {
@@ -1578,7 +1664,8 @@ RasterImage::NotifyDecodeComplete(const DecoderFinalStatus& aStatus,
                                   const IntRect& aInvalidRect,
                                   const Maybe<uint32_t>& aFrameCount,
                                   DecoderFlags aDecoderFlags,
-                                  SurfaceFlags aSurfaceFlags)
+                                  SurfaceFlags aSurfaceFlags,
+                                  const Maybe<IntSize>& aOutputSize)
 {
   MOZ_ASSERT(NS_IsMainThread());
 
@@ -1604,6 +1691,11 @@ RasterImage::NotifyDecodeComplete(const DecoderFinalStatus& aStatus,
   if (!aStatus.mWasMetadataDecode && aStatus.mFinished && !aStatus.mWasAborted) {
     // Flag that we've been decoded before.
     mHasBeenDecoded = true;
+
+    // Let other processes use what we decoded.
+    if (!aStatus.mHadError && !mAnimationState && aOutputSize) {
+      ShareDecodedSurface(*aOutputSize, aSurfaceFlags);
+    }
   }
 
   // Send out any final notifications.
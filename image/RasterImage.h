@@ -31,6 +31,7 @@
 #include "ISurfaceProvider.h"
 #include "Orientation.h"
 #include "nsIObserver.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/Attributes.h"
 #include "mozilla/Maybe.h"
 #include "mozilla/MemoryReporting.h"
@@ -174,6 +175,14 @@ public:
   /* Triggers discarding. */
   void Discard();
 
+  /**
+   * @return true if this image is locked. Layout locks the images it considers
+   * approximately visible, so this is a cheap proxy for whether the image is on
+   * or near the screen. May be called from any thread; the result is only a
+   * hint, since the lock count may change right after it's read.
+   */
+  bool HasLocks() const { return mLockCount > 0; }
+
 
   //////////////////////////////////////////////////////////////////////////////
   // Decoder callbacks.
@@ -221,6 +230,7 @@ public:
    *                      frames this image has.
    * @param aDecoderFlags The decoder flags used by the decoder.
    * @param aSurfaceFlags The surface flags used by the decoder.
+   * @param aOutputSize   The size the decoder decoded at, if it was given one.
    */
   void NotifyDecodeComplete(const DecoderFinalStatus& aStatus,
                             const ImageMetadata& aMetadata,
@@ -229,7 +239,8 @@ public:
                             const gfx::IntRect& aInvalidRect,
                             const Maybe<uint32_t>& aFrameCount,
                             DecoderFlags aDecoderFlags,
-                            SurfaceFlags aSurfaceFlags);
+                            SurfaceFlags aSurfaceFlags,
+                            const Maybe<gfx::IntSize>& aOutputSize);
 
   // Helper method for NotifyDecodeComplete.
   void ReportDecoderError();
@@ -396,8 +407,9 @@ private: // data
   /// Animation timeline and other state for animation images.
   Maybe<AnimationState> mAnimationState;
 
-  // Image locking.
-  uint32_t                   mLockCount;
+  // Image locking. Only modified on the main thread, but read by the decoding
+  // threads through HasLocks().
+  Atomic<uint32_t, Relaxed>  mLockCount;
 
   // The type of decoder this image needs. Computed from the MIME type in Init().
   DecoderType                mDecoderType;
@@ -427,6 +439,10 @@ private: // data
   // The source data for this image.
   NotNull<RefPtr<SourceBuffer>>  mSourceBuffer;
 
+  // The SHA-1 digest of our complete source data, which keys our surfaces in
+  // the SharedSurfaceCache. Computed lazily; empty until then.
+  nsCString                      mSourceDigest;
+
   // Boolean flags (clustered together to conserve space):
   bool                       mHasSize:1;       // Has SetSize() been called?
   bool                       mTransient:1;     // Is the image short-lived?
@@ -434,6 +450,7 @@ private: // data
   bool                       mDiscardable:1;   // Is container discardable?
   bool                       mHasSourceData:1; // Do we have source data?
   bool                       mHasBeenDecoded:1; // Decoded at least once?
+  bool                       mShareable:1;     // May share decoded surfaces?
 
   // Whether we're waiting to start animation. If we get a StartAnimation() call
   // but we don't yet have more than one frame, mPendingAnimation is set so that
@@ -460,6 +477,25 @@ private: // data
   bool CanDownscaleDuringDecode(const nsIntSize& aSize, uint32_t aFlags);
 
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Sharing decoded surfaces with other processes.
+  //////////////////////////////////////////////////////////////////////////////
+
+  // Computes mSourceDigest if needed. Returns false if we can't share yet.
+  bool EnsureSourceDigest();
+
+  // Inserts a surface decoded by another process at the given size and flags
+  // into the SurfaceCache, if there is one. Returns true if we did, in which
+  // case there's no need to decode.
+  bool DecodeFromSharedSurface(const gfx::IntSize& aSize,
+                               SurfaceFlags aSurfaceFlags);
+
+  // Makes the surface we just decoded at the given size and flags available to
+  // other processes.
+  void ShareDecodedSurface(const gfx::IntSize& aSize,
+                           SurfaceFlags aSurfaceFlags);
+
+
   // Error handling.
   void DoError();
 
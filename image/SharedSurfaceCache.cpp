@@ -0,0 +1,343 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "SharedSurfaceCache.h"
+
+#include "gfxPrefs.h"
+#include "imgFrame.h"
+#include "mozilla/CheckedInt.h"
+#include "mozilla/ClearOnShutdown.h"
+#include "mozilla/SHA1.h"
+#include "mozilla/StaticPtr.h"
+#include "mozilla/Unused.h"
+#include "mozilla/dom/ContentChild.h"
+#include "mozilla/gfx/2D.h"
+#include "nsClassHashtable.h"
+#include "nsHashKeys.h"
+#include "nsXULAppAPI.h"
+
+namespace mozilla {
+
+using namespace gfx;
+using ipc::SharedMemoryBasic;
+
+namespace image {
+
+static bool
+IsSharedFormat(SurfaceFormat aFormat)
+{
+  return aFormat == SurfaceFormat::B8G8R8A8 ||
+         aFormat == SurfaceFormat::B8G8R8X8;
+}
+
+/**
+ * Computes the number of bytes a shared surface with the given layout needs.
+ *
+ * @return false if the layout isn't valid.
+ */
+static bool
+GetSharedLength(const IntSize& aSize, int32_t aStride, size_t* aLength)
+{
+  CheckedInt<int32_t> minStride = CheckedInt<int32_t>(aSize.width) * 4;
+  if (aSize.width <= 0 || aSize.height <= 0 || !minStride.isValid() ||
+      aStride < minStride.value()) {
+    return false;
+  }
+
+  CheckedInt<size_t> length = CheckedInt<size_t>(aStride) * aSize.height;
+  if (!length.isValid()) {
+    return false;
+  }
+
+  *aLength = length.value();
+  return true;
+}
+
+/* static */ bool
+SharedSurfaceCache::ShouldShare(const IntSize& aSize)
+{
+  if (!gfxPrefs::ImageMemSharedSurfaceCacheEnabled()) {
+    return false;
+  }
+
+  // Very small surfaces are cheaper to decode again than to look up.
+  CheckedInt<size_t> length = CheckedInt<size_t>(aSize.width) * aSize.height * 4;
+  return length.isValid() &&
+         length.value() >= gfxPrefs::ImageMemSharedSurfaceCacheMinSurfaceKB() * 1024 &&
+         length.value() <= gfxPrefs::ImageMemSharedSurfaceCacheMaxSizeKB() * 1024;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Content process implementation.
+///////////////////////////////////////////////////////////////////////////////
+
+static void
+ReleaseSharedMemory(void* aClosure)
+{
+  RefPtr<SharedMemoryBasic> shmem =
+    dont_AddRef(static_cast<SharedMemoryBasic*>(aClosure));
+}
+
+/* static */ already_AddRefed<imgFrame>
+SharedSurfaceCache::Lookup(const nsACString& aDigest,
+                           const IntSize& aSize,
+                           uint32_t aSurfaceFlags)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!XRE_IsContentProcess() || !ShouldShare(aSize)) {
+    return nullptr;
+  }
+
+  dom::ContentChild* child = dom::ContentChild::GetSingleton();
+  if (!child) {
+    return nullptr;
+  }
+
+  Handle handle = SharedMemoryBasic::NULLHandle();
+  int32_t stride = 0;
+  uint8_t format = 0;
+  if (!child->SendLookupSharedImage(nsCString(aDigest), aSize.width,
+                                    aSize.height, aSurfaceFlags,
+                                    &handle, &stride, &format)) {
+    return nullptr;
+  }
+
+  RefPtr<SharedMemoryBasic> shmem = new SharedMemoryBasic();
+  if (!shmem->IsHandleValid(handle)) {
+    return nullptr;  // Nobody has decoded this surface yet.
+  }
+
+  size_t length;
+  SurfaceFormat surfaceFormat = SurfaceFormat(format);
+  if (!GetSharedLength(aSize, stride, &length) ||
+      !IsSharedFormat(surfaceFormat) ||
+      !shmem->SetHandle(handle) || !shmem->Map(length)) {
+    NS_WARNING("Couldn't map a shared surface");
+    return nullptr;
+  }
+
+  // The wrapping surface keeps the shared memory mapped for as long as it's
+  // alive.
+  uint8_t* data = static_cast<uint8_t*>(shmem->memory());
+  RefPtr<DataSourceSurface> surface =
+    Factory::CreateWrappingDataSourceSurface(data, stride, aSize, surfaceFormat,
+                                             &ReleaseSharedMemory, shmem.get());
+  if (!surface) {
+    return nullptr;
+  }
+  Unused << shmem.forget().take();
+
+  RefPtr<imgFrame> frame = new imgFrame();
+  if (NS_FAILED(frame->InitForSharedSurface(surface))) {
+    return nullptr;
+  }
+
+  return frame.forget();
+}
+
+/* static */ void
+SharedSurfaceCache::Store(const nsACString& aDigest,
+                          uint32_t aSurfaceFlags,
+                          SourceSurface* aSurface)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!XRE_IsContentProcess() || !aSurface ||
+      !ShouldShare(aSurface->GetSize())) {
+    return;
+  }
+
+  dom::ContentChild* child = dom::ContentChild::GetSingleton();
+  if (!child) {
+    return;
+  }
+
+  RefPtr<DataSourceSurface> data = aSurface->GetDataSurface();
+  if (!data || !IsSharedFormat(data->GetFormat())) {
+    return;
+  }
+
+  DataSourceSurface::ScopedMap map(data, DataSourceSurface::READ);
+  if (!map.IsMapped()) {
+    return;
+  }
+
+  const IntSize size = data->GetSize();
+  const int32_t stride = size.width * 4;
+  size_t length;
+  if (!GetSharedLength(size, stride, &length)) {
+    return;
+  }
+
+  RefPtr<SharedMemoryBasic> shmem = new SharedMemoryBasic();
+  if (!shmem->Create(length) || !shmem->Map(length)) {
+    return;
+  }
+
+  uint8_t* dest = static_cast<uint8_t*>(shmem->memory());
+  for (int32_t y = 0; y < size.height; ++y) {
+    memcpy(dest + y * stride, map.GetData() + y * map.GetStride(), stride);
+  }
+
+  Handle handle = SharedMemoryBasic::NULLHandle();
+  if (!shmem->ShareToProcess(child->OtherPid(), &handle)) {
+    return;
+  }
+
+  child->SendStoreSharedImage(nsCString(aDigest), size.width, size.height,
+                              aSurfaceFlags, handle, stride,
+                              uint8_t(data->GetFormat()));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parent process implementation.
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A surface stored by a content process. The parent never maps the memory;
+ * it only holds on to it and shares it with other content processes.
+ */
+struct SharedSurface
+{
+  RefPtr<SharedMemoryBasic> mMemory;
+  size_t mLength;
+  int32_t mStride;
+  uint8_t mFormat;
+  uint64_t mLastUse;
+};
+
+typedef nsClassHashtable<nsCStringHashKey, SharedSurface> SharedSurfaceTable;
+
+static StaticAutoPtr<SharedSurfaceTable> sSharedSurfaces;
+static size_t sSharedSurfacesLength = 0;
+static uint64_t sSharedSurfacesUseCount = 0;
+
+static void
+MakeSharedSurfaceKey(const nsACString& aDigest,
+                     const IntSize& aSize,
+                     uint32_t aSurfaceFlags,
+                     nsACString& aKey)
+{
+  // The digest has a fixed length, so this is unambiguous.
+  aKey.Assign(aDigest);
+  aKey.AppendInt(aSize.width);
+  aKey.Append('x');
+  aKey.AppendInt(aSize.height);
+  aKey.Append(':');
+  aKey.AppendInt(aSurfaceFlags);
+}
+
+static void
+EvictSharedSurfaces(size_t aMaxLength)
+{
+  // Evict the least recently used surfaces. Processes which have mapped them
+  // keep them alive for as long as they need them.
+  while (sSharedSurfacesLength > aMaxLength) {
+    nsCString oldestKey;
+    const SharedSurface* oldest = nullptr;
+    for (auto iter = sSharedSurfaces->Iter(); !iter.Done(); iter.Next()) {
+      if (!oldest || iter.Data()->mLastUse < oldest->mLastUse) {
+        oldest = iter.Data();
+        oldestKey = iter.Key();
+      }
+    }
+
+    MOZ_ASSERT(oldest, "Lost track of the total length");
+    if (!oldest) {
+      sSharedSurfacesLength = 0;
+      return;
+    }
+
+    sSharedSurfacesLength -= oldest->mLength;
+    sSharedSurfaces->Remove(oldestKey);
+  }
+}
+
+/* static */ bool
+SharedSurfaceCache::LookupForProcess(base::ProcessId aProcessId,
+                                     const nsACString& aDigest,
+                                     const IntSize& aSize,
+                                     uint32_t aSurfaceFlags,
+                                     Handle* aHandle,
+                                     int32_t* aStride,
+                                     uint8_t* aFormat)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(XRE_IsParentProcess());
+
+  if (!sSharedSurfaces || !ShouldShare(aSize)) {
+    return false;
+  }
+
+  nsAutoCString key;
+  MakeSharedSurfaceKey(aDigest, aSize, aSurfaceFlags, key);
+  SharedSurface* surface = sSharedSurfaces->Get(key);
+  if (!surface || !surface->mMemory->ShareToProcess(aProcessId, aHandle)) {
+    return false;
+  }
+
+  surface->mLastUse = ++sSharedSurfacesUseCount;
+  *aStride = surface->mStride;
+  *aFormat = surface->mFormat;
+  return true;
+}
+
+/* static */ void
+SharedSurfaceCache::StoreFromProcess(const nsACString& aDigest,
+                                     const IntSize& aSize,
+                                     uint32_t aSurfaceFlags,
+                                     const Handle& aHandle,
+                                     int32_t aStride,
+                                     uint8_t aFormat)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(XRE_IsParentProcess());
+
+  // Take ownership of the handle right away, so that we close it even if we
+  // end up dropping the surface.
+  RefPtr<SharedMemoryBasic> shmem = new SharedMemoryBasic();
+  if (!shmem->IsHandleValid(aHandle) || !shmem->SetHandle(aHandle)) {
+    return;
+  }
+
+  size_t length;
+  if (aDigest.Length() != SHA1Sum::kHashSize ||
+      !GetSharedLength(aSize, aStride, &length) ||
+      !IsSharedFormat(SurfaceFormat(aFormat)) || !ShouldShare(aSize)) {
+    return;
+  }
+
+  const size_t maxLength =
+    size_t(gfxPrefs::ImageMemSharedSurfaceCacheMaxSizeKB()) * 1024;
+  if (length > maxLength) {
+    return;
+  }
+
+  if (!sSharedSurfaces) {
+    sSharedSurfaces = new SharedSurfaceTable();
+    ClearOnShutdown(&sSharedSurfaces);
+  }
+
+  nsAutoCString key;
+  MakeSharedSurfaceKey(aDigest, aSize, aSurfaceFlags, key);
+  if (sSharedSurfaces->Contains(key)) {
+    return;  // Another process beat this one to it.
+  }
+
+  EvictSharedSurfaces(maxLength - length);
+
+  SharedSurface* surface = new SharedSurface();
+  surface->mMemory = shmem.forget();
+  surface->mLength = length;
+  surface->mStride = aStride;
+  surface->mFormat = aFormat;
+  surface->mLastUse = ++sSharedSurfacesUseCount;
+  sSharedSurfaces->Put(key, surface);
+  sSharedSurfacesLength += length;
+}
+
+} // namespace image
+} // namespace mozilla
@@ -0,0 +1,114 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/**
+ * SharedSurfaceCache lets content processes share the decoded surfaces of
+ * static images with each other, so that an image which is displayed in
+ * several processes at once only has to be decoded once.
+ *
+ * The parent process owns the cache. Content processes store the surfaces they
+ * decode in shared memory and hand them to the parent, and look up surfaces
+ * decoded by other processes before starting a decode of their own.
+ *
+ * Surfaces are keyed by the SHA-1 of the image's complete source data, together
+ * with the size and the SurfaceFlags they were decoded with. Since only a
+ * process that already has the source data can compute the digest, sharing a
+ * surface never reveals an image to a process which couldn't have decoded it
+ * itself.
+ */
+
+#ifndef mozilla_image_SharedSurfaceCache_h
+#define mozilla_image_SharedSurfaceCache_h
+
+#include "mozilla/AlreadyAddRefed.h"
+#include "mozilla/gfx/Point.h"
+#include "mozilla/ipc/SharedMemoryBasic.h"
+#include "base/process.h"
+#include "nsString.h"
+
+namespace mozilla {
+
+namespace gfx {
+class SourceSurface;
+} // namespace gfx
+
+namespace image {
+
+class imgFrame;
+
+class SharedSurfaceCache
+{
+public:
+  typedef ipc::SharedMemoryBasic::Handle Handle;
+
+  /**
+   * @return true if surfaces of @aSize are worth sharing. This is false
+   * everywhere if the image.mem.shared_surface_cache.enabled pref is off.
+   */
+  static bool ShouldShare(const gfx::IntSize& aSize);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Content process API. Main thread only.
+  //////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * Looks up a surface decoded by some content process.
+   *
+   * @param aDigest        The SHA-1 digest of the image's source data.
+   * @param aSize          The size the surface was decoded at.
+   * @param aSurfaceFlags  The SurfaceFlags the surface was decoded with.
+   *
+   * @return a finished imgFrame backed by shared memory, or null if there's no
+   *         such surface.
+   */
+  static already_AddRefed<imgFrame> Lookup(const nsACString& aDigest,
+                                           const gfx::IntSize& aSize,
+                                           uint32_t aSurfaceFlags);
+
+  /**
+   * Makes a copy of @aSurface, which we just finished decoding, available to
+   * other content processes.
+   */
+  static void Store(const nsACString& aDigest,
+                    uint32_t aSurfaceFlags,
+                    gfx::SourceSurface* aSurface);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Parent process API. Called by ContentParent on the main thread.
+  //////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * Shares the surface with the given key, if we have one, with the process
+   * @aProcessId.
+   *
+   * @return true and fills in the out parameters if we found the surface.
+   */
+  static bool LookupForProcess(base::ProcessId aProcessId,
+                               const nsACString& aDigest,
+                               const gfx::IntSize& aSize,
+                               uint32_t aSurfaceFlags,
+                               Handle* aHandle,
+                               int32_t* aStride,
+                               uint8_t* aFormat);
+
+  /**
+   * Takes ownership of a surface stored by a content process. Surfaces which
+   * are malformed, already present, or don't fit in the cache are dropped.
+   */
+  static void StoreFromProcess(const nsACString& aDigest,
+                               const gfx::IntSize& aSize,
+                               uint32_t aSurfaceFlags,
+                               const Handle& aHandle,
+                               int32_t aStride,
+                               uint8_t aFormat);
+
+private:
+  virtual ~SharedSurfaceCache() = 0;  // Forbid instantiation.
+};
+
+} // namespace image
+} // namespace mozilla
+
+#endif // mozilla_image_SharedSurfaceCache_h
@@ -9,7 +9,11 @@
 #include <cmath>
 #include <cstring>
 #include "mozilla/Likely.h"
+#include "nsCOMPtr.h"
 #include "nsIInputStream.h"
+#include "nsISeekableStream.h"
+#include "nsISupportsPrimitives.h"
+#include "nsStringBuffer.h"
 #include "MainThreadUtils.h"
 #include "SurfaceCache.h"
 
@@ -144,6 +148,18 @@ SourceBuffer::AppendChunk(Maybe<Chunk>&& aChunk)
   return NS_OK;
 }
 
+size_t
+SourceBuffer::Chunk::SizeOfExcludingThis(MallocSizeOf aMallocSizeOf) const
+{
+  // The network code drops its references to a shared segment once it has
+  // handed it over, so the SourceBuffer is effectively its owner.
+  if (IsShared()) {
+    return mSegment.SizeOfExcludingThisEvenIfShared(aMallocSizeOf);
+  }
+
+  return aMallocSizeOf(mData.get());
+}
+
 Maybe<SourceBuffer::Chunk>
 SourceBuffer::CreateChunk(size_t aCapacity, bool aRoundUp /* = true */)
 {
@@ -191,6 +207,14 @@ SourceBuffer::Compact()
     return NS_OK;
   }
 
+  // Shared chunks have no slack space, and copying them would defeat the
+  // point of sharing them. StreamingLexer handles discontiguous data fine.
+  for (uint32_t i = 0 ; i < mChunks.Length() ; ++i) {
+    if (mChunks[i].IsShared()) {
+      return NS_OK;
+    }
+  }
+
   // We can compact our buffer. Determine the total length.
   size_t length = 0;
   for (uint32_t i = 0 ; i < mChunks.Length() ; ++i) {
@@ -419,6 +443,48 @@ SourceBuffer::Append(const char* aData, size_t aLength)
   return NS_OK;
 }
 
+nsresult
+SourceBuffer::AppendSegment(const nsACString& aSegment)
+{
+  // Small segments aren't worth a chunk of their own, and segments which
+  // don't live in a refcounted buffer can't be shared.
+  if (aSegment.Length() < MIN_CHUNK_CAPACITY ||
+      !nsStringBuffer::FromString(aSegment)) {
+    return aSegment.IsEmpty()
+         ? NS_OK
+         : Append(aSegment.BeginReading(), aSegment.Length());
+  }
+
+  MutexAutoLock lock(mMutex);
+
+  if (MOZ_UNLIKELY(mStatus)) {
+    // This SourceBuffer is already complete; ignore further data.
+    return NS_ERROR_FAILURE;
+  }
+
+  if (!mChunks.IsEmpty()) {
+    Chunk& lastChunk = mChunks.LastElement();
+    if (lastChunk.Length() == 0) {
+      // This is the chunk ExpectLength() preallocated. Nothing can have read
+      // from it yet, so the shared chunk can take its place.
+      mChunks.RemoveElementAt(mChunks.Length() - 1);
+    } else {
+      // Consumers move on to the next chunk once they've read a chunk's
+      // whole capacity, so drop the slack space in the current chunk.
+      lastChunk.Seal();
+    }
+  }
+
+  if (MOZ_UNLIKELY(NS_FAILED(AppendChunk(Some(Chunk(aSegment)))))) {
+    return HandleError(NS_ERROR_OUT_OF_MEMORY);
+  }
+
+  // Resume any waiting readers now that there's new data.
+  ResumeWaitingConsumers();
+
+  return NS_OK;
+}
+
 static nsresult
 AppendToSourceBuffer(nsIInputStream*,
                      void* aClosure,
@@ -444,10 +510,47 @@ AppendToSourceBuffer(nsIInputStream*,
   return NS_OK;
 }
 
+/**
+ * If @aInputStream just wraps a refcounted string which holds exactly the
+ * @aCount bytes that are available, consumes the stream and returns the string
+ * in @aSegment, sharing its buffer. This is the case for the streams the
+ * network code creates for data that arrives over IPC.
+ */
+static bool
+TakeSegmentFromInputStream(nsIInputStream* aInputStream,
+                           uint32_t aCount,
+                           nsACString& aSegment)
+{
+  nsCOMPtr<nsISupportsCString> string = do_QueryInterface(aInputStream);
+  nsCOMPtr<nsISeekableStream> seekable = do_QueryInterface(aInputStream);
+  if (!string || !seekable) {
+    return false;
+  }
+
+  // If anything was read from the stream already, the string holds more than
+  // what's available.
+  uint64_t available = 0;
+  if (NS_FAILED(aInputStream->Available(&available)) || available != aCount ||
+      NS_FAILED(string->GetData(aSegment)) || aSegment.Length() != aCount ||
+      !nsStringBuffer::FromString(aSegment)) {
+    return false;
+  }
+
+  return NS_SUCCEEDED(seekable->Seek(nsISeekableStream::NS_SEEK_END, 0));
+}
+
 nsresult
 SourceBuffer::AppendFromInputStream(nsIInputStream* aInputStream,
                                     uint32_t aCount)
 {
+  nsCString segment;
+  if (aCount >= MIN_CHUNK_CAPACITY &&
+      TakeSegmentFromInputStream(aInputStream, aCount, segment)) {
+    // As in AppendToSourceBuffer, only report OOM to the caller.
+    nsresult rv = AppendSegment(segment);
+    return rv == NS_ERROR_OUT_OF_MEMORY ? rv : NS_OK;
+  }
+
   uint32_t bytesRead;
   nsresult rv = aInputStream->ReadSegments(AppendToSourceBuffer, this,
                                            aCount, &bytesRead);
@@ -505,7 +608,7 @@ SourceBuffer::SizeOfIncludingThisWithComputedFallback(MallocSizeOf
   n += mChunks.ShallowSizeOfExcludingThis(aMallocSizeOf);
 
   for (uint32_t i = 0 ; i < mChunks.Length() ; ++i) {
-    size_t chunkSize = aMallocSizeOf(mChunks[i].Data());
+    size_t chunkSize = mChunks[i].SizeOfExcludingThis(aMallocSizeOf);
 
     if (chunkSize == 0) {
       // We're on a platform where moz_malloc_size_of always returns 0.
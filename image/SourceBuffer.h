@@ -21,6 +21,7 @@
 #include "mozilla/RefCounted.h"
 #include "mozilla/UniquePtr.h"
 #include "mozilla/RefPtr.h"
+#include "nsString.h"
 #include "nsTArray.h"
 
 class nsIInputStream;
@@ -300,7 +301,17 @@ public:
   /// Append the provided data to the buffer.
   nsresult Append(const char* aData, size_t aLength);
 
-  /// Append the data available on the provided nsIInputStream to the buffer.
+  /**
+   * Append @aSegment to the buffer. If its data lives in a refcounted string
+   * buffer, the SourceBuffer shares that buffer instead of copying the data.
+   */
+  nsresult AppendSegment(const nsACString& aSegment);
+
+  /**
+   * Append the data available on the provided nsIInputStream to the buffer.
+   * Streams which just wrap a refcounted string (like the ones the network
+   * code creates for data received over IPC) are shared, not copied.
+   */
   nsresult AppendFromInputStream(nsIInputStream* aInputStream, uint32_t aCount);
 
   /**
@@ -356,13 +367,24 @@ private:
       mData.reset(new (fallible) char[mCapacity]);
     }
 
+    /// Creates a full chunk which shares @aSegment's buffer.
+    explicit Chunk(const nsACString& aSegment)
+      : mCapacity(aSegment.Length())
+      , mLength(aSegment.Length())
+      , mSegment(aSegment)
+    {
+      MOZ_ASSERT(mCapacity > 0, "Creating zero-capacity chunk");
+    }
+
     Chunk(Chunk&& aOther)
       : mCapacity(aOther.mCapacity)
       , mLength(aOther.mLength)
       , mData(Move(aOther.mData))
+      , mSegment(Move(aOther.mSegment))
     {
       aOther.mCapacity = aOther.mLength = 0;
       aOther.mData = nullptr;
+      aOther.mSegment.Truncate();
     }
 
     Chunk& operator=(Chunk&& aOther)
@@ -370,17 +392,25 @@ private:
       mCapacity = aOther.mCapacity;
       mLength = aOther.mLength;
       mData = Move(aOther.mData);
+      mSegment = Move(aOther.mSegment);
       aOther.mCapacity = aOther.mLength = 0;
       aOther.mData = nullptr;
+      aOther.mSegment.Truncate();
       return *this;
     }
 
-    bool AllocationFailed() const { return !mData; }
+    bool AllocationFailed() const { return !mData && !IsShared(); }
     size_t Capacity() const { return mCapacity; }
     size_t Length() const { return mLength; }
 
+    /// Shared chunks are always full, so nothing is ever written to them.
+    bool IsShared() const { return !mSegment.IsEmpty(); }
+
     char* Data() const
     {
+      if (IsShared()) {
+        return const_cast<char*>(mSegment.BeginReading());
+      }
       MOZ_ASSERT(mData, "Allocation failed but nobody checked for it");
       return mData.get();
     }
@@ -391,6 +421,11 @@ private:
       mLength += aAdditionalLength;
     }
 
+    /// Drops the chunk's slack space, so that no more data goes into it.
+    void Seal() { mCapacity = mLength; }
+
+    size_t SizeOfExcludingThis(MallocSizeOf aMallocSizeOf) const;
+
   private:
     Chunk(const Chunk&) = delete;
     Chunk& operator=(const Chunk&) = delete;
@@ -398,6 +433,7 @@ private:
     size_t mCapacity;
     size_t mLength;
     UniquePtr<char[]> mData;
+    nsCString mSegment;
   };
 
   nsresult AppendChunk(Maybe<Chunk>&& aChunk);
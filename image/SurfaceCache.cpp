@@ -14,6 +14,7 @@
 #include "mozilla/Attributes.h"
 #include "mozilla/DebugOnly.h"
 #include "mozilla/Likely.h"
+#include "mozilla/MemoryPressureCoordinator.h"
 #include "mozilla/Move.h"
 #include "mozilla/Mutex.h"
 #include "mozilla/Pair.h"
@@ -32,6 +33,7 @@
 #include "nsHashKeys.h"
 #include "nsRefPtrHashtable.h"
 #include "nsSize.h"
+#include "nsString.h"
 #include "nsTArray.h"
 #include "prsystem.h"
 #include "ShutdownTracker.h"
@@ -159,6 +161,10 @@ public:
   }
 
   bool IsPlaceholder() const { return mProvider->Availability().IsPlaceholder(); }
+  bool HasProvider(ISurfaceProvider* aProvider) const
+  {
+    return mProvider.get() == aProvider;
+  }
   bool IsDecoded() const { return !IsPlaceholder() && mProvider->IsFinished(); }
 
   ImageKey GetImageKey() const { return mProvider->GetImageKey(); }
@@ -231,7 +237,7 @@ class ImageSurfaceCache
 {
   ~ImageSurfaceCache() { }
 public:
-  ImageSurfaceCache() : mLocked(false) { }
+  ImageSurfaceCache() : mCost(0), mLocked(false) { }
 
   MOZ_DECLARE_REFCOUNTED_TYPENAME(ImageSurfaceCache)
   NS_INLINE_DECL_THREADSAFE_REFCOUNTING(ImageSurfaceCache)
@@ -246,6 +252,7 @@ public:
     MOZ_ASSERT(!mLocked || aSurface->IsPlaceholder() || aSurface->IsLocked(),
                "Inserting an unlocked surface for a locked image");
     mSurfaces.Put(aSurface->GetSurfaceKey(), aSurface);
+    mCost += aSurface->GetCostEntry().GetCost();
   }
 
   void Remove(NotNull<CachedSurface*> aSurface)
@@ -254,6 +261,9 @@ public:
         "Should not be removing a surface we don't have");
 
     mSurfaces.Remove(aSurface->GetSurfaceKey());
+    MOZ_ASSERT(mCost >= aSurface->GetCostEntry().GetCost(),
+               "Costs don't balance");
+    mCost -= aSurface->GetCostEntry().GetCost();
   }
 
   already_AddRefed<CachedSurface> Lookup(const SurfaceKey& aSurfaceKey)
@@ -366,11 +376,55 @@ public:
     return mSurfaces.ConstIter();
   }
 
+  /**
+   * @return true if another decoded surface of this image, at least as large
+   * as @aSurface, could be substituted for it by LookupBestMatch(). Such a
+   * surface is redundant: if we discard it, the image keeps drawing with the
+   * larger one until it gets redecoded at the size it needs.
+   */
+  bool IsRedundant(NotNull<CachedSurface*> aSurface) const
+  {
+    if (aSurface->IsPlaceholder()) {
+      return false;
+    }
+
+    const SurfaceKey& key = aSurface->GetSurfaceKey();
+    const int64_t area = AreaOfIntSize(key.Size());
+    for (auto iter = ConstIter(); !iter.Done(); iter.Next()) {
+      CachedSurface* current = iter.UserData();
+      if (current == aSurface || current->IsPlaceholder() ||
+          !current->IsDecoded()) {
+        continue;
+      }
+
+      const SurfaceKey& currentKey = current->GetSurfaceKey();
+      if (currentKey.Playback() != key.Playback() ||
+          currentKey.SVGContext() != key.SVGContext() ||
+          currentKey.Flags() != key.Flags()) {
+        continue;
+      }
+
+      // Break ties between equally sized surfaces arbitrarily, so that one of
+      // them is never redundant.
+      const int64_t currentArea = AreaOfIntSize(currentKey.Size());
+      if (currentArea > area ||
+          (currentArea == area && current > aSurface.get())) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// @return the total cost of this image's surfaces, locked or not.
+  Cost GetCost() const { return mCost; }
+
   void SetLocked(bool aLocked) { mLocked = aLocked; }
   bool IsLocked() const { return mLocked; }
 
 private:
   SurfaceTable mSurfaces;
+  Cost         mCost;
   bool         mLocked;
 };
 
@@ -382,21 +436,27 @@ private:
  * cache's implementation.
  */
 class SurfaceCacheImpl final : public nsIMemoryReporter
+                             , public MemoryReclaimer
 {
 public:
   NS_DECL_ISUPPORTS
 
   SurfaceCacheImpl(uint32_t aSurfaceCacheExpirationTimeMS,
                    uint32_t aSurfaceCacheDiscardFactor,
+                   uint32_t aSurfaceCacheImageBudgetFactor,
                    uint32_t aSurfaceCacheSize)
     : mExpirationTracker(aSurfaceCacheExpirationTimeMS)
     , mMemoryPressureObserver(new MemoryPressureObserver)
     , mMutex("SurfaceCache")
     , mDiscardFactor(aSurfaceCacheDiscardFactor)
+    , mImageBudget(aSurfaceCacheImageBudgetFactor > 0
+                     ? aSurfaceCacheSize / aSurfaceCacheImageBudgetFactor
+                     : aSurfaceCacheSize)
     , mMaxCost(aSurfaceCacheSize)
     , mAvailableCost(aSurfaceCacheSize)
     , mLockedCost(0)
     , mOverflowCount(0)
+    , mReclaimerRegistered(false)
   {
     nsCOMPtr<nsIObserverService> os = services::GetObserverService();
     if (os) {
@@ -412,12 +472,60 @@ private:
       os->RemoveObserver(mMemoryPressureObserver, "memory-pressure");
     }
 
+    MOZ_ASSERT(!mReclaimerRegistered, "Should have unregistered reclaimer");
     UnregisterWeakMemoryReporter(this);
   }
 
 public:
   void InitMemoryReporter() { RegisterWeakMemoryReporter(this); }
 
+  void InitReclaimer()
+  {
+    MOZ_ASSERT(NS_IsMainThread());
+    MemoryPressureCoordinator::RegisterReclaimer(this);
+    mReclaimerRegistered = true;
+  }
+
+  void ShutdownReclaimer()
+  {
+    MOZ_ASSERT(NS_IsMainThread());
+    if (mReclaimerRegistered) {
+      MemoryPressureCoordinator::UnregisterReclaimer(this);
+      mReclaimerRegistered = false;
+    }
+  }
+
+  bool IsReclaimerRegistered() const { return mReclaimerRegistered; }
+
+  const char* ReclaimerName() override { return "SurfaceCache"; }
+
+  size_t ReclaimableBytes() override
+  {
+    MutexAutoLock lock(mMutex);
+    return (mMaxCost - mAvailableCost) - mLockedCost;
+  }
+
+  uint32_t RebuildCost() override
+  {
+    // Discarded surfaces can be redecoded from the source data.
+    return kRebuildCostRecompute;
+  }
+
+  size_t Reclaim(size_t aBytes) override
+  {
+    MutexAutoLock lock(mMutex);
+    const Cost startingAvailableCost = mAvailableCost;
+
+    // Redundant surfaces go first, since nothing is lost by dropping them.
+    DiscardRedundantSurfaces(/* aIncludeLocked = */ false);
+    while (mAvailableCost - startingAvailableCost < aBytes &&
+           !mCosts.IsEmpty()) {
+      Remove(ChooseSurfaceToEvict());
+    }
+
+    return mAvailableCost - startingAvailableCost;
+  }
+
   Mutex& GetMutex() { return mMutex; }
 
   InsertOutcome Insert(NotNull<ISurfaceProvider*> aProvider,
@@ -449,17 +557,26 @@ public:
       return InsertOutcome::FAILURE;
     }
 
-    // Remove elements in order of cost until we can fit this in the cache. Note
-    // that locked surfaces aren't in mCosts, so we never remove them here.
+    // If this image is already using more than its share of the cache, make
+    // room by discarding its own surfaces before anyone else's. This keeps a
+    // single page full of huge images from flushing every other image.
+    RefPtr<ImageSurfaceCache> cache = GetImageCache(aProvider->GetImageKey());
+    if (cache) {
+      TrimToImageBudget(WrapNotNull(cache), cost);
+    }
+
+    // Remove elements until we can fit this in the cache. Note that locked
+    // surfaces aren't in mCosts, so we never remove them here.
     while (cost > mAvailableCost) {
       MOZ_ASSERT(!mCosts.IsEmpty(),
                  "Removed everything and it still won't fit");
-      Remove(mCosts.LastElement().Surface());
+      Remove(ChooseSurfaceToEvict());
     }
 
-    // Locate the appropriate per-image cache. If there's not an existing cache
-    // for this image, create it.
-    RefPtr<ImageSurfaceCache> cache = GetImageCache(aProvider->GetImageKey());
+    // Locate the appropriate per-image cache again, since removing surfaces may
+    // have removed it. If there's not an existing cache for this image, create
+    // it.
+    cache = GetImageCache(aProvider->GetImageKey());
     if (!cache) {
       cache = new ImageSurfaceCache;
       mImageCaches.Put(aProvider->GetImageKey(), cache);
@@ -674,6 +791,26 @@ public:
     Insert(aProvider, /* aSetAvailable = */ true);
   }
 
+  void RemovePlaceholder(NotNull<ISurfaceProvider*> aProvider)
+  {
+    if (!aProvider->Availability().IsPlaceholder()) {
+      MOZ_ASSERT_UNREACHABLE("Calling RemovePlaceholder on non-placeholder");
+      return;
+    }
+
+    RefPtr<ImageSurfaceCache> cache = GetImageCache(aProvider->GetImageKey());
+    if (!cache) {
+      return;  // No cached surfaces for this image.
+    }
+
+    RefPtr<CachedSurface> surface = cache->Lookup(aProvider->GetSurfaceKey());
+    if (!surface || !surface->HasProvider(aProvider)) {
+      return;  // We've already been evicted, or replaced.
+    }
+
+    Remove(WrapNotNull(surface));
+  }
+
   void LockImage(const ImageKey aImageKey)
   {
     RefPtr<ImageSurfaceCache> cache = GetImageCache(aImageKey);
@@ -742,7 +879,40 @@ public:
     }
   }
 
-  void DiscardForMemoryPressure()
+  /**
+   * Memory pressure tiers, in order of increasing severity. Each tier discards
+   * everything the tiers below it would have discarded.
+   */
+  enum class MemoryPressure
+  {
+    // Pressure is ongoing, but nothing new has happened. Discard redundant
+    // surfaces, then (1 / mDiscardFactor) of whatever else is discardable.
+    ONGOING,
+
+    // We're low on memory. Discard every unlocked surface.
+    LOW,
+
+    // We're asked to free as much as we possibly can. Also discard redundant
+    // locked surfaces; locked images keep their largest surfaces, so they can
+    // still be drawn.
+    MINIMIZE
+  };
+
+  void DiscardForMemoryPressure(MemoryPressure aPressure)
+  {
+    if (aPressure >= MemoryPressure::LOW) {
+      DiscardAll();
+      if (aPressure == MemoryPressure::MINIMIZE) {
+        DiscardRedundantSurfaces(/* aIncludeLocked = */ true);
+      }
+      return;
+    }
+
+    DiscardRedundantSurfaces(/* aIncludeLocked = */ false);
+    DiscardFractionForMemoryPressure();
+  }
+
+  void DiscardFractionForMemoryPressure()
   {
     // Compute our discardable cost. Since locked surfaces aren't discardable,
     // we exclude them.
@@ -764,7 +934,30 @@ public:
     // Discard surfaces until we've reduced our cost to our target cost.
     while (mAvailableCost < targetCost) {
       MOZ_ASSERT(!mCosts.IsEmpty(), "Removed everything and still not done");
-      Remove(mCosts.LastElement().Surface());
+      Remove(ChooseSurfaceToEvict());
+    }
+  }
+
+  void DiscardRedundantSurfaces(bool aIncludeLocked)
+  {
+    // Collect the surfaces first, since removing them may remove their
+    // per-image caches out from under us.
+    nsTArray<RefPtr<CachedSurface>> redundant;
+    for (auto iter = mImageCaches.ConstIter(); !iter.Done(); iter.Next()) {
+      ImageSurfaceCache* cache = iter.UserData();
+      for (auto surfIter = cache->ConstIter(); !surfIter.Done(); surfIter.Next()) {
+        NotNull<CachedSurface*> surface = WrapNotNull(surfIter.UserData());
+        if ((aIncludeLocked || !surface->IsLocked()) &&
+            cache->IsRedundant(surface)) {
+          redundant.AppendElement(surface.get());
+        }
+      }
+    }
+
+    // Redundancy is decided against the surfaces we keep: the largest decoded
+    // surface of each image is never redundant, so it survives this loop.
+    for (const RefPtr<CachedSurface>& surface : redundant) {
+      Remove(WrapNotNull(surface));
     }
   }
 
@@ -844,6 +1037,58 @@ private:
     return aCost <= mMaxCost - mLockedCost;
   }
 
+  /**
+   * Discards @aCache's unlocked surfaces, largest first, until @aCost more
+   * bytes fit within the per-image budget or there is nothing left to discard.
+   */
+  void TrimToImageBudget(NotNull<ImageSurfaceCache*> aCache, const Cost aCost)
+  {
+    while (aCache->GetCost() + aCost > mImageBudget) {
+      CachedSurface* largest = nullptr;
+      for (auto iter = aCache->ConstIter(); !iter.Done(); iter.Next()) {
+        CachedSurface* surface = iter.UserData();
+        if (surface->IsPlaceholder() || surface->IsLocked()) {
+          continue;
+        }
+        if (!largest || surface->GetCostEntry().GetCost() >
+                        largest->GetCostEntry().GetCost()) {
+          largest = surface;
+        }
+      }
+
+      if (!largest) {
+        return;  // The budget is soft; everything left is locked or pending.
+      }
+
+      Remove(WrapNotNull(largest));
+    }
+  }
+
+  /**
+   * Chooses the unlocked surface to discard next when we need space. We prefer
+   * the largest redundant surface, since losing it doesn't leave its image
+   * without anything to draw; otherwise we take the largest surface overall.
+   * Only the largest few candidates are considered, to keep this cheap.
+   */
+  NotNull<CachedSurface*> ChooseSurfaceToEvict()
+  {
+    MOZ_ASSERT(!mCosts.IsEmpty(), "Nothing to evict");
+
+    const size_t kMaxCandidates = 16;
+    const size_t end = mCosts.Length() > kMaxCandidates
+                     ? mCosts.Length() - kMaxCandidates
+                     : 0;
+    for (size_t i = mCosts.Length(); i > end; --i) {
+      NotNull<CachedSurface*> surface = mCosts[i - 1].Surface();
+      RefPtr<ImageSurfaceCache> cache = GetImageCache(surface->GetImageKey());
+      if (cache && cache->IsRedundant(surface)) {
+        return surface;
+      }
+    }
+
+    return mCosts.LastElement().Surface();
+  }
+
   void MarkUsed(NotNull<CachedSurface*> aSurface,
                 NotNull<ImageSurfaceCache*> aCache)
   {
@@ -907,11 +1152,27 @@ private:
 
     NS_IMETHOD Observe(nsISupports*,
                        const char* aTopic,
-                       const char16_t*) override
+                       const char16_t* aData) override
     {
       if (sInstance && strcmp(aTopic, "memory-pressure") == 0) {
+        // See nsIMemory.idl for the meaning of the notification data.
+        MemoryPressure pressure = MemoryPressure::LOW;
+        if (aData && NS_LITERAL_STRING("heap-minimize").Equals(aData)) {
+          pressure = MemoryPressure::MINIMIZE;
+        } else if (aData &&
+                   NS_LITERAL_STRING("low-memory-ongoing").Equals(aData)) {
+          pressure = MemoryPressure::ONGOING;
+        }
+
+        // Ongoing pressure is handled by the MemoryPressureCoordinator, which
+        // only asks us for as much as it still needs after cheaper caches.
+        if (pressure == MemoryPressure::ONGOING &&
+            sInstance->IsReclaimerRegistered()) {
+          return NS_OK;
+        }
+
         MutexAutoLock lock(sInstance->GetMutex());
-        sInstance->DiscardForMemoryPressure();
+        sInstance->DiscardForMemoryPressure(pressure);
       }
       return NS_OK;
     }
@@ -927,10 +1188,12 @@ private:
   RefPtr<MemoryPressureObserver>        mMemoryPressureObserver;
   Mutex                                   mMutex;
   const uint32_t                          mDiscardFactor;
+  const Cost                              mImageBudget;
   const Cost                              mMaxCost;
   Cost                                    mAvailableCost;
   Cost                                    mLockedCost;
   size_t                                  mOverflowCount;
+  bool                                    mReclaimerRegistered;
 };
 
 NS_IMPL_ISUPPORTS(SurfaceCacheImpl, nsIMemoryReporter)
@@ -961,6 +1224,13 @@ SurfaceCache::Initialize()
   uint32_t surfaceCacheDiscardFactor =
     max(gfxPrefs::ImageMemSurfaceCacheDiscardFactor(), 1u);
 
+  // What fraction of the surface cache a single image may use before it has
+  // to discard its own surfaces to make room for new ones, rather than evicting
+  // other images' surfaces. This value is interpreted as 1/N; 0 disables the
+  // per-image budget.
+  uint32_t surfaceCacheImageBudgetFactor =
+    gfxPrefs::ImageMemSurfaceCacheImageBudgetFactor();
+
   // Maximum size of the surface cache, in kilobytes.
   uint64_t surfaceCacheMaxSizeKB = gfxPrefs::ImageMemSurfaceCacheMaxSizeKB();
 
@@ -992,8 +1262,12 @@ SurfaceCache::Initialize()
   // actually allocate any storage for surfaces at this time.
   sInstance = new SurfaceCacheImpl(surfaceCacheExpirationTimeMS,
                                    surfaceCacheDiscardFactor,
+                                   surfaceCacheImageBudgetFactor,
                                    finalSurfaceCacheSizeBytes);
   sInstance->InitMemoryReporter();
+  if (MemoryPressureCoordinator::IsEnabled()) {
+    sInstance->InitReclaimer();
+  }
 }
 
 /* static */ void
@@ -1001,6 +1275,7 @@ SurfaceCache::Shutdown()
 {
   MOZ_ASSERT(NS_IsMainThread());
   MOZ_ASSERT(sInstance, "No singleton - was Shutdown() called twice?");
+  sInstance->ShutdownReclaimer();
   sInstance = nullptr;
 }
 
@@ -1071,6 +1346,17 @@ SurfaceCache::SurfaceAvailable(NotNull<ISurfaceProvider*> aProvider)
   sInstance->SurfaceAvailable(aProvider);
 }
 
+/* static */ void
+SurfaceCache::RemovePlaceholder(NotNull<ISurfaceProvider*> aProvider)
+{
+  if (!sInstance) {
+    return;
+  }
+
+  MutexAutoLock lock(sInstance->GetMutex());
+  sInstance->RemovePlaceholder(aProvider);
+}
+
 /* static */ void
 SurfaceCache::LockImage(const ImageKey aImageKey)
 {
@@ -296,6 +296,20 @@ struct SurfaceCache
    */
   static void SurfaceAvailable(NotNull<ISurfaceProvider*> aProvider);
 
+  /**
+   * Removes the placeholder cache entry @aProvider from the cache. This is used
+   * by ISurfaceProviders that give up before producing a surface, so that a
+   * later request for the same surface starts a new decode instead of waiting
+   * on the placeholder forever.
+   *
+   * If the cache entry containing @aProvider has already been evicted from the
+   * surface cache, or has been replaced by another ISurfaceProvider, this
+   * function has no effect.
+   *
+   * @param aProvider       The placeholder cache entry to remove.
+   */
+  static void RemovePlaceholder(NotNull<ISurfaceProvider*> aProvider);
+
   /**
    * Checks if a surface of a given size could possibly be stored in the cache.
    * If CanHold() returns false, Insert() will always fail to insert the
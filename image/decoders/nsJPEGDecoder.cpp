@@ -78,6 +78,7 @@ nsJPEGDecoder::nsJPEGDecoder(RasterImage* aImage,
           Transition::TerminateSuccess())
  , mDecodeStyle(aDecodeStyle)
  , mSampleSize(0)
+ , mDCTScale(1)
 {
   mState = JPEG_HEADER;
   mReading = true;
@@ -266,6 +267,8 @@ nsJPEGDecoder::ReadJPEGData(const char* aData, size_t aLength)
       }
 
       // We're doing a full decode.
+      ChooseDCTScale();
+
       if (mCMSMode != eCMSMode_Off &&
           (mInProfile = GetICCProfile(mInfo)) != nullptr) {
         uint32_t profileSpace = qcms_profile_get_color_space(mInProfile);
@@ -400,7 +403,9 @@ nsJPEGDecoder::ReadJPEGData(const char* aData, size_t aLength)
     MOZ_ASSERT(mImageData, "Should have a buffer now");
 
     if (mDownscaler) {
-      nsresult rv = mDownscaler->BeginFrame(Size(), Nothing(),
+      nsresult rv = mDownscaler->BeginFrame(gfx::IntSize(mInfo.output_width,
+                                                         mInfo.output_height),
+                                            Nothing(),
                                             mImageData,
                                             /* aHasAlpha = */ false);
       if (NS_FAILED(rv)) {
@@ -728,14 +733,78 @@ nsJPEGDecoder::OutputScanlines(bool* suspend)
 
   if (mDownscaler && mDownscaler->HasInvalidation()) {
     DownscalerInvalidRect invalidRect = mDownscaler->TakeInvalidRect();
-    PostInvalidation(invalidRect.mOriginalSizeRect,
+    PostInvalidation(ToImageRect(invalidRect.mOriginalSizeRect),
                      Some(invalidRect.mTargetSizeRect));
     MOZ_ASSERT(!mDownscaler->HasInvalidation());
   } else if (!mDownscaler && top != mInfo.output_scanline) {
-    PostInvalidation(nsIntRect(0, top,
-                               mInfo.output_width,
-                               mInfo.output_scanline - top));
+    nsIntRect rect(0, top, mInfo.output_width, mInfo.output_scanline - top);
+    PostInvalidation(ToImageRect(rect), Some(rect));
+  }
+}
+
+void
+nsJPEGDecoder::ChooseDCTScale()
+{
+  // If we're going to downscale, let libjpeg do as much of the work as it can
+  // while decoding, by scaling the IDCT down by a power of two. That's far
+  // cheaper than decoding at full size and then downscaling, both in time and
+  // in memory, which matters a lot when showing big photos as thumbnails. We
+  // never scale below the output size, so the Downscaler still gets the final
+  // say on quality.
+  //
+  // -moz-sample-size also uses libjpeg's scaling, but it changes the size of
+  // the image, so we leave that case alone.
+  if (!mDownscaler || mSampleSize > 0) {
+    return;
+  }
+
+  const gfx::IntSize outputSize = OutputSize();
+  uint32_t scale = 1;
+  while (scale < 8) {
+    // libjpeg rounds scaled dimensions up.
+    uint32_t next = scale * 2;
+    if ((mInfo.image_width + next - 1) / next < uint32_t(outputSize.width) ||
+        (mInfo.image_height + next - 1) / next < uint32_t(outputSize.height)) {
+      break;
+    }
+    scale = next;
+  }
+
+  if (scale == 1) {
+    return;
+  }
+
+  mInfo.scale_num = 1;
+  mInfo.scale_denom = scale;
+  jpeg_calc_output_dimensions(&mInfo);
+  mDCTScale = scale;
+
+  // If libjpeg gets us exactly to the output size, we don't need to downscale
+  // at all.
+  if (gfx::IntSize(mInfo.output_width, mInfo.output_height) == outputSize) {
+    mDownscaler.reset();
   }
+
+  MOZ_LOG(sJPEGDecoderAccountingLog, LogLevel::Debug,
+         ("        JPEGDecoderAccounting: nsJPEGDecoder::ChooseDCTScale -- "
+          "decoding at 1/%u scale (%ux%u) for %dx%d output",
+          scale, mInfo.output_width, mInfo.output_height,
+          outputSize.width, outputSize.height));
+}
+
+nsIntRect
+nsJPEGDecoder::ToImageRect(const nsIntRect& aDecodedRect) const
+{
+  // Rects in the decoded image are in the coordinate space of libjpeg's
+  // output, which is smaller than the image if we're using DCT scaling.
+  if (mDCTScale == 1) {
+    return aDecodedRect;
+  }
+
+  nsIntRect rect(aDecodedRect.x * mDCTScale, aDecodedRect.y * mDCTScale,
+                 aDecodedRect.width * mDCTScale,
+                 aDecodedRect.height * mDCTScale);
+  return rect.Intersect(nsIntRect(nsIntPoint(), Size()));
 }
 
 // Override the standard error method in the IJG JPEG decoder code.
@@ -69,6 +69,8 @@ protected:
 
 protected:
   Orientation ReadOrientationFromEXIF();
+  void ChooseDCTScale();
+  nsIntRect ToImageRect(const nsIntRect& aDecodedRect) const;
   void OutputScanlines(bool* suspend);
 
 private:
@@ -117,6 +119,10 @@ public:
   uint32_t mCMSMode;
 
   int mSampleSize;
+
+  // If we're downscaling, the power-of-two factor that libjpeg scales the
+  // image down by while decoding it, before the Downscaler (if any) takes over.
+  uint32_t mDCTScale;
 };
 
 } // namespace image
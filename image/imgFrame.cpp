@@ -399,6 +399,34 @@ imgFrame::CanOptimizeOpaqueImage()
          (gfxPlatform::GetPlatform()->GetDefaultContentBackend() != BackendType::SKIA);
 }
 
+nsresult
+imgFrame::InitForSharedSurface(DataSourceSurface* aSurface)
+{
+  MOZ_ASSERT(aSurface);
+  MOZ_ASSERT(!mImageSurface, "Called imgFrame::InitForSharedSurface() twice?");
+
+  IntSize size = aSurface->GetSize();
+  if (!AllowedImageSize(size.width, size.height)) {
+    NS_WARNING("Should have legal image size");
+    mAborted = true;
+    return NS_ERROR_FAILURE;
+  }
+
+  mImageSize = size;
+  mFrameRect = IntRect(IntPoint(0, 0), size);
+  mFormat = aSurface->GetFormat();
+  mPaletteDepth = 0;
+  mHasNoAlpha = mFormat == SurfaceFormat::B8G8R8X8;
+
+  // We don't have a volatile buffer; the surface itself keeps the shared
+  // memory alive. Since mOptimizable is never set, it stays that way.
+  mImageSurface = aSurface;
+  mDecoded = mFrameRect;
+  mFinished = true;
+
+  return NS_OK;
+}
+
 nsresult
 imgFrame::Optimize(DrawTarget* aTarget)
 {
@@ -241,6 +241,13 @@ public:
                             uint32_t aImageFlags,
                             gfx::BackendType aBackend);
 
+  /**
+   * Initialize this imgFrame with a surface that was decoded elsewhere and is
+   * shared with other processes (see SharedSurfaceCache). The imgFrame is
+   * finished right away, and is never optimized or written to.
+   */
+  nsresult InitForSharedSurface(DataSourceSurface* aSurface);
+
   DrawableFrameRef DrawableRef();
   RawAccessFrameRef RawAccessRef();
 
@@ -255,6 +255,24 @@ TEST_F(ImageDecoders, JPGDownscaleDuringDecode)
   CheckDownscaleDuringDecode(DownscaledJPGTestCase());
 }
 
+TEST_F(ImageDecoders, JPGDownscaleDuringDecodeToDCTScale)
+{
+  // 25x25 is exactly what libjpeg produces when scaling this image's IDCT by
+  // 1/4, so the JPEG decoder shouldn't need a Downscaler at all here.
+  ImageTestCase testCase("downscaled.jpg", "image/jpeg", IntSize(100, 100),
+                         IntSize(25, 25));
+
+  WithSingleChunkDecode(testCase, Some(testCase.mOutputSize), [&](Decoder* aDecoder) {
+    RefPtr<SourceSurface> surface = CheckDecoderState(testCase, aDecoder);
+    EXPECT_TRUE(surface != nullptr);
+
+    EXPECT_TRUE(RowsAreSolidColor(surface, 0, 5, BGRAColor::Green(), /* aFuzz = */ 47));
+    EXPECT_TRUE(RowsAreSolidColor(surface, 8, 3, BGRAColor::Red(), /* aFuzz = */ 27));
+    EXPECT_TRUE(RowsAreSolidColor(surface, 14, 3, BGRAColor::Green(), /* aFuzz = */ 47));
+    EXPECT_TRUE(RowsAreSolidColor(surface, 21, 4, BGRAColor::Red(), /* aFuzz = */ 27));
+  });
+}
+
 TEST_F(ImageDecoders, BMPSingleChunk)
 {
   CheckDecoderSingleChunk(GreenBMPTestCase());
@@ -8,6 +8,7 @@
 #include <cstdint>
 
 #include "mozilla/Move.h"
+#include "nsStringStream.h"
 #include "SourceBuffer.h"
 #include "SurfaceCache.h"
 
@@ -528,6 +529,63 @@ TEST_F(ImageSourceBuffer, CompactionHappensWhenBufferIsComplete)
   }
 }
 
+TEST_F(ImageSourceBuffer, SharedSegmentsAreNotCopiedOrCompacted)
+{
+  constexpr size_t chunkLength = SourceBuffer::MIN_CHUNK_CAPACITY;
+  constexpr size_t totalLength = 1 + 2 * chunkLength;
+
+  // Start with a partially filled chunk, then append two segments which live
+  // in refcounted string buffers.
+  CheckedAppendToBuffer(mData, 1);
+  nsCString segments[2];
+  for (size_t i = 0; i < 2; ++i) {
+    segments[i].SetLength(chunkLength);
+    GenerateData(segments[i].BeginWriting(), 1 + i * chunkLength, chunkLength);
+    EXPECT_TRUE(NS_SUCCEEDED(mSourceBuffer->AppendSegment(segments[i])));
+  }
+
+  // Complete the buffer, which would normally trigger compaction.
+  CheckedCompleteBuffer();
+
+  // Verify that the iterator reads straight out of the segments.
+  SourceBufferIterator iterator = mSourceBuffer->Iterator();
+  CheckedAdvanceIterator(iterator, 1);
+  CheckedAdvanceIterator(iterator, chunkLength, 2, 1 + chunkLength);
+  EXPECT_EQ(segments[0].BeginReading(), iterator.Data());
+  CheckedAdvanceIterator(iterator, chunkLength, 3, totalLength);
+  EXPECT_EQ(segments[1].BeginReading(), iterator.Data());
+  CheckIteratorIsComplete(iterator, 3, totalLength);
+}
+
+TEST_F(ImageSourceBuffer, AppendFromStringInputStreamSharesSegment)
+{
+  constexpr size_t length = SourceBuffer::MIN_CHUNK_CAPACITY;
+
+  // ExpectLength() preallocates a chunk, which the segment should replace.
+  EXPECT_TRUE(NS_SUCCEEDED(mSourceBuffer->ExpectLength(length)));
+
+  nsCString segment;
+  segment.SetLength(length);
+  GenerateData(segment.BeginWriting(), length);
+  nsCOMPtr<nsIInputStream> inputStream;
+  ASSERT_TRUE(NS_SUCCEEDED(NS_NewCStringInputStream(getter_AddRefs(inputStream),
+                                                    segment)));
+
+  EXPECT_TRUE(NS_SUCCEEDED(mSourceBuffer->AppendFromInputStream(inputStream,
+                                                                length)));
+  CheckedCompleteBuffer();
+
+  // The stream should have been consumed.
+  uint64_t available;
+  ASSERT_TRUE(NS_SUCCEEDED(inputStream->Available(&available)));
+  EXPECT_EQ(0u, available);
+
+  SourceBufferIterator iterator = mSourceBuffer->Iterator();
+  CheckedAdvanceIterator(iterator, length);
+  EXPECT_EQ(segment.BeginReading(), iterator.Data());
+  CheckIteratorIsComplete(iterator, length);
+}
+
 TEST_F(ImageSourceBuffer, CompactionIsDelayedWhileIteratorsExist)
 {
   constexpr size_t chunkLength = SourceBuffer::MIN_CHUNK_CAPACITY;
@@ -193,6 +193,8 @@ void Channel::ChannelImpl::Init(Mode mode, Listener* listener) {
   mode_ = mode;
   is_blocked_on_write_ = false;
   partial_write_iter_.reset();
+  input_buf_ = mozilla::MakeUnique<char[]>(Channel::kReadBufferSize);
+  input_buf_size_ = Channel::kReadBufferSize;
   input_buf_offset_ = 0;
   server_listen_pipe_ = -1;
   pipe_ = -1;
@@ -308,8 +310,8 @@ bool Channel::ChannelImpl::ProcessIncomingMessages() {
 
     // In some cases the beginning of a message will be stored in input_buf_. We
     // don't want to overwrite that, so we store the new data after it.
-    iov.iov_base = input_buf_ + input_buf_offset_;
-    iov.iov_len = Channel::kReadBufferSize - input_buf_offset_;
+    iov.iov_base = input_buf_.get() + input_buf_offset_;
+    iov.iov_len = input_buf_size_ - input_buf_offset_;
 
     // Read from pipe.
     // recvmsg() returns 0 if the connection has closed or EAGAIN if no data
@@ -379,9 +381,12 @@ bool Channel::ChannelImpl::ProcessIncomingMessages() {
       }
     }
 
+    // If this read filled the buffer, more data is likely waiting.
+    const bool filled_buffer = size_t(bytes_read) == iov.iov_len;
+
     // Process messages from input buffer.
-    const char *p = input_buf_;
-    const char *end = input_buf_ + input_buf_offset_ + bytes_read;
+    const char *p = input_buf_.get();
+    const char *end = input_buf_.get() + input_buf_offset_ + bytes_read;
 
     // A pointer to an array of |num_fds| file descriptors which includes any
     // fds that have spilled over from a previous read.
@@ -422,7 +427,7 @@ bool Channel::ChannelImpl::ProcessIncomingMessages() {
         // Move everything we have to the start of the buffer. We'll finish
         // reading this message when we get more data. For now we leave it in
         // input_buf_.
-        memmove(input_buf_, p, end - p);
+        memmove(input_buf_.get(), p, end - p);
         input_buf_offset_ = end - p;
 
         break;
@@ -549,11 +554,31 @@ bool Channel::ChannelImpl::ProcessIncomingMessages() {
       // We close these descriptors in Close()
       return false;
     }
+
+    // Grow the buffer while reads fill it, and give the memory back once the
+    // channel is quiet again.
+    if (filled_buffer && input_buf_size_ < kMaxReadBufferSize) {
+      ResizeInputBuffer(std::min(input_buf_size_ * 2,
+                                 size_t(kMaxReadBufferSize)));
+    } else if (!filled_buffer &&
+               size_t(bytes_read) < Channel::kReadBufferSize &&
+               input_buf_size_ > Channel::kReadBufferSize) {
+      ResizeInputBuffer(Channel::kReadBufferSize);
+    }
   }
 
   return true;
 }
 
+void Channel::ChannelImpl::ResizeInputBuffer(size_t size) {
+  // Only a partial message header is ever left in the buffer.
+  DCHECK(input_buf_offset_ < size);
+  mozilla::UniquePtr<char[]> buf = mozilla::MakeUnique<char[]>(size);
+  memcpy(buf.get(), input_buf_.get(), input_buf_offset_);
+  input_buf_ = mozilla::Move(buf);
+  input_buf_size_ = size;
+}
+
 bool Channel::ChannelImpl::ProcessOutgoingMessages() {
   DCHECK(!waiting_connect_);  // Why are we trying to send messages if there's
                               // no connection?
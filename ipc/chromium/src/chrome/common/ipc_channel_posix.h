@@ -23,6 +23,7 @@
 #include "nsAutoPtr.h"
 
 #include "mozilla/Maybe.h"
+#include "mozilla/UniquePtr.h"
 
 namespace IPC {
 
@@ -63,6 +64,7 @@ class Channel::ChannelImpl : public MessageLoopForIO::Watcher {
 
   bool ProcessIncomingMessages();
   bool ProcessOutgoingMessages();
+  void ResizeInputBuffer(size_t size);
 
   // MessageLoopForIO::Watcher implementation.
   virtual void OnFileCanReadWithoutBlocking(int fd);
@@ -104,8 +106,22 @@ class Channel::ChannelImpl : public MessageLoopForIO::Watcher {
   // Messages to be sent are queued here.
   std::queue<Message*> output_queue_;
 
-  // We read from the pipe into this buffer
-  char input_buf_[Channel::kReadBufferSize];
+  enum {
+#if defined(OS_LINUX)
+    // The input buffer grows up to this size while reads keep filling it, so
+    // that a busy channel needs fewer recvmsg() calls. Linux never returns
+    // the descriptors of more than one sendmsg() from a recvmsg(), so
+    // input_cmsg_buf_ is big enough for reads of any size.
+    kMaxReadBufferSize = 128 * 1024
+#else
+    kMaxReadBufferSize = Channel::kReadBufferSize
+#endif
+  };
+
+  // We read from the pipe into this buffer. It is input_buf_size_ bytes long,
+  // between Channel::kReadBufferSize and kMaxReadBufferSize.
+  mozilla::UniquePtr<char[]> input_buf_;
+  size_t input_buf_size_;
   size_t input_buf_offset_;
 
   // We want input_cmsg_buf_ to be big enough to hold
@@ -37,6 +37,7 @@ Message::Message()
 #if defined(OS_POSIX)
   header()->num_fds = 0;
 #endif
+  header()->coalesce_key = 0;
 #ifdef MOZ_TASK_TRACER
   header()->source_event_id = 0;
   header()->parent_task_id = 0;
@@ -62,6 +63,7 @@ Message::Message(int32_t routing_id, msgid_t type, PriorityValue priority,
   header()->interrupt_remote_stack_depth_guess = static_cast<uint32_t>(-1);
   header()->interrupt_local_stack_depth = static_cast<uint32_t>(-1);
   header()->seqno = 0;
+  header()->coalesce_key = 0;
 #if defined(OS_MACOSX)
   header()->cookie = 0;
 #endif
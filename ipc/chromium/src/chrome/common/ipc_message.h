@@ -95,6 +95,26 @@ class Message : public Pickle {
                    COMPRESSION_NONE;
   }
 
+  // Marks an async message as coalescable: while it is pending on the
+  // receiving side, a newer message with the same type, routing id and key
+  // replaces it. Unlike compression, which only looks at the type and routing
+  // id, this lets a protocol collapse stale updates per object (a progress
+  // notification per request, say) without dropping those of other objects.
+  void set_coalesce_key(uint32_t key) {
+    DCHECK(!is_sync() && !is_interrupt());
+    header()->flags |= COALESCE_BIT;
+    header()->coalesce_key = key;
+  }
+
+  bool is_coalescable() const {
+    return (header()->flags & COALESCE_BIT) != 0;
+  }
+
+  uint32_t coalesce_key() const {
+    DCHECK(is_coalescable());
+    return header()->coalesce_key;
+  }
+
   // Set this on a reply to a synchronous message.
   void set_reply() {
     header()->flags |= REPLY_BIT;
@@ -279,6 +299,7 @@ class Message : public Pickle {
     INTERRUPT_BIT   = 0x0100,
     COMPRESS_BIT    = 0x0200,
     COMPRESSALL_BIT = 0x0400,
+    COALESCE_BIT    = 0x0800,
   };
 
   struct Header : Pickle::Header {
@@ -302,6 +323,10 @@ class Message : public Pickle {
     uint32_t interrupt_local_stack_depth;
     // Sequence number
     int32_t seqno;
+    // For coalescable async messages, the key they're coalesced by. This
+    // can't share the union above, as the transaction ID of async messages is
+    // still looked at.
+    uint32_t coalesce_key;
 #ifdef MOZ_TASK_TRACER
     uint64_t source_event_id;
     uint64_t parent_task_id;
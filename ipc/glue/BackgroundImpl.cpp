@@ -18,6 +18,7 @@
 #include "mozilla/Atomics.h"
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/DebugOnly.h"
+#include "mozilla/Preferences.h"
 #include "mozilla/Services.h"
 #include "mozilla/StaticPtr.h"
 #include "mozilla/Unused.h"
@@ -91,6 +92,46 @@ AssertIsOnMainThread()
   THREADSAFETY_ASSERT(NS_IsMainThread());
 }
 
+// Whether a message received by a parent actor belongs to a protocol doing
+// bulk storage work, which interactive protocols (e.g. service worker
+// management) may overtake. This must list the managees of every protocol it
+// lists, see MessageChannel::SetBulkMessageFilter.
+bool
+IsBulkBackgroundMessage(const IPC::Message& aMsg)
+{
+  switch (IPCMessageStart(aMsg.type() >> 16)) {
+    case PBackgroundIDBFactoryMsgStart:
+    case PBackgroundIDBFactoryRequestMsgStart:
+    case PBackgroundIDBDatabaseMsgStart:
+    case PBackgroundIDBDatabaseFileMsgStart:
+    case PBackgroundIDBDatabaseRequestMsgStart:
+    case PBackgroundIDBTransactionMsgStart:
+    case PBackgroundIDBVersionChangeTransactionMsgStart:
+    case PBackgroundIDBCursorMsgStart:
+    case PBackgroundIDBRequestMsgStart:
+    case PBackgroundMutableFileMsgStart:
+    case PBackgroundFileHandleMsgStart:
+    case PBackgroundFileRequestMsgStart:
+    case PCacheStorageMsgStart:
+    case PCacheMsgStart:
+    case PCacheOpMsgStart:
+    case PCacheStreamControlMsgStart:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void
+MaybePrioritizeInteractiveMessages(MessageChannel* aChannel)
+{
+  AssertIsOnMainThread();
+
+  if (Preferences::GetBool("ipc.background.prioritize_interactive", false)) {
+    aChannel->SetBulkMessageFilter(IsBulkBackgroundMessage);
+  }
+}
+
 // -----------------------------------------------------------------------------
 // ParentImpl Declaration
 // -----------------------------------------------------------------------------
@@ -237,6 +278,8 @@ private:
   {
     AssertIsInMainProcess();
     AssertIsOnMainThread();
+
+    MaybePrioritizeInteractiveMessages(GetIPCChannel());
   }
 
   // For other-process actors.
@@ -247,6 +290,8 @@ private:
     AssertIsInMainProcess();
     AssertIsOnMainThread();
     MOZ_ASSERT(aContent);
+
+    MaybePrioritizeInteractiveMessages(GetIPCChannel());
   }
 
   ~ParentImpl()
@@ -5,8 +5,21 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "IPCMessageUtils.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/CheckedInt.h"
 
+#include <string.h>
+
+#if defined(OS_POSIX)
+#include <algorithm>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/shared_memory.h"
+#include "chrome/common/file_descriptor_set_posix.h"
+#endif
+
 namespace IPC {
 
 bool
@@ -20,4 +33,141 @@ ByteLengthIsValid(uint32_t aNumElements, size_t aElementSize, int* aByteLength)
   return true;
 }
 
+#if defined(OS_POSIX)
+
+// UINT32_MAX until MOZ_IPC_SHMEM_THRESHOLD has been read. Racing threads all
+// compute the same value, so this doesn't need a lock.
+static mozilla::Atomic<uint32_t, mozilla::Relaxed> sSharedBytesThreshold(UINT32_MAX);
+
+static uint32_t
+SharedBytesThreshold()
+{
+  uint32_t threshold = sSharedBytesThreshold;
+  if (threshold == UINT32_MAX) {
+    threshold = 0;
+    const char* env = getenv("MOZ_IPC_SHMEM_THRESHOLD");
+    if (env) {
+      unsigned long value = strtoul(env, nullptr, 10);
+      if (value > 0) {
+        threshold = value < kMinSharedBytesLength
+                    ? kMinSharedBytesLength
+                    : uint32_t(std::min<unsigned long>(value, UINT32_MAX - 1));
+      }
+    }
+    sSharedBytesThreshold = threshold;
+  }
+  return threshold;
+}
+
+#endif  // defined(OS_POSIX)
+
+bool
+WriteSharedBytes(Message* aMsg, uint32_t aLength,
+                 SharedBytesCopier aCopy, const void* aClosure)
+{
+#if defined(OS_POSIX)
+  uint32_t threshold = SharedBytesThreshold();
+  if (!threshold || aLength < threshold ||
+      aMsg->num_fds() >= FileDescriptorSet::MAX_DESCRIPTORS_PER_MESSAGE) {
+    return false;
+  }
+
+  base::SharedMemory shmem;
+  if (!shmem.Create("", false, false, aLength) || !shmem.Map(aLength)) {
+    return false;
+  }
+  aCopy(shmem.memory(), aLength, aClosure);
+
+  // The receiver maps the segment read-only, and this process drops its own
+  // mapping when |shmem| goes away.
+  base::FileDescriptor descriptor;
+  if (!shmem.ShareToProcess(base::GetCurrentProcId(), &descriptor) ||
+      descriptor.fd < 0) {
+    return false;
+  }
+
+  aMsg->WriteBool(true);
+  MOZ_ALWAYS_TRUE(aMsg->WriteFileDescriptor(descriptor));
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool
+ReadSharedBytes(const Message* aMsg, PickleIterator* aIter,
+                void* aData, uint32_t aLength)
+{
+#if defined(OS_POSIX)
+  base::FileDescriptor descriptor;
+  if (!aMsg->ReadFileDescriptor(aIter, &descriptor)) {
+    return false;
+  }
+
+  // Received descriptors belong to whoever reads them; |shmem| closes this
+  // one.
+  base::SharedMemory shmem;
+  if (!shmem.SetHandle(descriptor, /* read_only */ true)) {
+    close(descriptor.fd);
+    return false;
+  }
+
+  // Mapping past the end of the file would fault when the data is read.
+  struct stat st;
+  if (fstat(descriptor.fd, &st) != 0 || uint64_t(st.st_size) < aLength) {
+    return false;
+  }
+
+  if (!shmem.Map(aLength)) {
+    return false;
+  }
+  memcpy(aData, shmem.memory(), aLength);
+  return true;
+#else
+  return false;
+#endif
+}
+
+static void
+CopyContiguousBytes(void* aDest, uint32_t aLength, const void* aClosure)
+{
+  memcpy(aDest, aClosure, aLength);
+}
+
+void
+WriteBytesMaybeShared(Message* aMsg, const void* aData, uint32_t aLength)
+{
+  if (aLength < kMinSharedBytesLength) {
+    aMsg->WriteBytes(aData, aLength);
+    return;
+  }
+
+  if (WriteSharedBytes(aMsg, aLength, CopyContiguousBytes, aData)) {
+    return;
+  }
+
+  aMsg->WriteBool(false);
+  aMsg->WriteBytes(aData, aLength);
+}
+
+bool
+ReadBytesMaybeShared(const Message* aMsg, PickleIterator* aIter,
+                     void* aData, uint32_t aLength)
+{
+  if (aLength < kMinSharedBytesLength) {
+    return aMsg->ReadBytesInto(aIter, aData, aLength);
+  }
+
+  bool shared;
+  if (!aMsg->ReadBool(aIter, &shared)) {
+    return false;
+  }
+
+  if (shared) {
+    return ReadSharedBytes(aMsg, aIter, aData, aLength);
+  }
+
+  return aMsg->ReadBytesInto(aIter, aData, aLength);
+}
+
 } // namespace IPC
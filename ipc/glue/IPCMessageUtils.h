@@ -278,6 +278,46 @@ struct ParamTraits<base::FileDescriptor>
 };
 #endif  // !defined(OS_POSIX)
 
+// Pickle::ReadBytes and ::WriteBytes take the length in ints, so we must
+// ensure there is no overflow. This returns |false| if it would overflow.
+// Otherwise, it returns |true| and places the byte length in |aByteLength|.
+bool ByteLengthIsValid(uint32_t aNumElements, size_t aElementSize, int* aByteLength);
+
+// Byte runs shorter than this are always pickled inline, and are read and
+// written exactly as by ReadBytesInto and WriteBytes.
+static const uint32_t kMinSharedBytesLength = 64 * 1024;
+
+// Writes |aLength| bytes of string or array data. When the run is at least
+// as long as the threshold set by the MOZ_IPC_SHMEM_THRESHOLD environment
+// variable (in bytes; unset or zero disables this), the data is copied into
+// a fresh shared memory segment and only its descriptor is pickled, which
+// saves copying it through the channel's socket. This is only implemented
+// where descriptors can be sent along with messages; elsewhere, and if the
+// segment can't be created, the data is pickled inline.
+void WriteBytesMaybeShared(Message* aMsg, const void* aData, uint32_t aLength);
+
+// Reads data written by WriteBytesMaybeShared into |aData|, mapping the
+// shared memory segment read-only if the writer used one.
+bool ReadBytesMaybeShared(const Message* aMsg, PickleIterator* aIter,
+                          void* aData, uint32_t aLength);
+
+// Copies |aLength| bytes of the data described by |aClosure| to |aDest|.
+typedef void (*SharedBytesCopier)(void* aDest, uint32_t aLength,
+                                  const void* aClosure);
+
+// The shared memory half of WriteBytesMaybeShared, for data that isn't
+// contiguous in memory. If a run of |aLength| bytes should go through shared
+// memory, creates the segment, has |aCopy| fill it, pickles true and the
+// segment's descriptor, and returns true. Otherwise pickles nothing and
+// returns false; the caller then pickles false followed by the data.
+bool WriteSharedBytes(Message* aMsg, uint32_t aLength,
+                      SharedBytesCopier aCopy, const void* aClosure);
+
+// Reads the descriptor pickled by WriteSharedBytes, once its flag has been
+// read, and copies the segment's contents into |aData|.
+bool ReadSharedBytes(const Message* aMsg, PickleIterator* aIter,
+                     void* aData, uint32_t aLength);
+
 template <>
 struct ParamTraits<nsACString>
 {
@@ -294,7 +334,7 @@ struct ParamTraits<nsACString>
 
     uint32_t length = aParam.Length();
     WriteParam(aMsg, length);
-    aMsg->WriteBytes(aParam.BeginReading(), length);
+    WriteBytesMaybeShared(aMsg, aParam.BeginReading(), length);
   }
 
   static bool Read(const Message* aMsg, PickleIterator* aIter, paramType* aResult)
@@ -314,7 +354,7 @@ struct ParamTraits<nsACString>
     }
     aResult->SetLength(length);
 
-    return aMsg->ReadBytesInto(aIter, aResult->BeginWriting(), length);
+    return ReadBytesMaybeShared(aMsg, aIter, aResult->BeginWriting(), length);
   }
 
   static void Log(const paramType& aParam, std::wstring* aLog)
@@ -341,8 +381,10 @@ struct ParamTraits<nsAString>
       return;
 
     uint32_t length = aParam.Length();
+    int byteLength = 0;
+    MOZ_RELEASE_ASSERT(ByteLengthIsValid(length, sizeof(char16_t), &byteLength));
     WriteParam(aMsg, length);
-    aMsg->WriteBytes(aParam.BeginReading(), length * sizeof(char16_t));
+    WriteBytesMaybeShared(aMsg, aParam.BeginReading(), byteLength);
   }
 
   static bool Read(const Message* aMsg, PickleIterator* aIter, paramType* aResult)
@@ -360,9 +402,13 @@ struct ParamTraits<nsAString>
     if (!ReadParam(aMsg, aIter, &length)) {
       return false;
     }
+    int byteLength = 0;
+    if (!ByteLengthIsValid(length, sizeof(char16_t), &byteLength)) {
+      return false;
+    }
     aResult->SetLength(length);
 
-    return aMsg->ReadBytesInto(aIter, aResult->BeginWriting(), length * sizeof(char16_t));
+    return ReadBytesMaybeShared(aMsg, aIter, aResult->BeginWriting(), byteLength);
   }
 
   static void Log(const paramType& aParam, std::wstring* aLog)
@@ -416,10 +462,6 @@ struct ParamTraits<nsLiteralString> : ParamTraits<nsAString>
   typedef nsLiteralString paramType;
 };
 
-// Pickle::ReadBytes and ::WriteBytes take the length in ints, so we must
-// ensure there is no overflow. This returns |false| if it would overflow.
-// Otherwise, it returns |true| and places the byte length in |aByteLength|.
-bool ByteLengthIsValid(uint32_t aNumElements, size_t aElementSize, int* aByteLength);
 
 // Note: IPDL will sometimes codegen specialized implementations of
 // nsTArray serialization and deserialization code in
@@ -446,7 +488,7 @@ struct ParamTraits<nsTArray<E>>
     if (sUseWriteBytes) {
       int pickledLength = 0;
       MOZ_RELEASE_ASSERT(ByteLengthIsValid(length, sizeof(E), &pickledLength));
-      aMsg->WriteBytes(aParam.Elements(), pickledLength);
+      WriteBytesMaybeShared(aMsg, aParam.Elements(), pickledLength);
     } else {
       const E* elems = aParam.Elements();
       for (uint32_t index = 0; index < length; index++) {
@@ -471,7 +513,7 @@ struct ParamTraits<nsTArray<E>>
       }
 
       E* elements = aResult->AppendElements(length);
-      return aMsg->ReadBytesInto(aIter, elements, pickledLength);
+      return ReadBytesMaybeShared(aMsg, aIter, elements, pickledLength);
     } else {
       aResult->SetCapacity(length);
 
@@ -723,6 +765,15 @@ struct ParamTraits<JSStructuredCloneData>
   {
     MOZ_ASSERT(!(aParam.Size() % sizeof(uint64_t)));
     WriteParam(aMsg, aParam.Size());
+    // Large clone buffers, e.g. ones holding big ArrayBuffers, can go
+    // through a shared memory segment; see WriteBytesMaybeShared.
+    if (IsShareable(aParam.Size())) {
+      if (WriteSharedBytes(aMsg, uint32_t(aParam.Size()), CopySegments,
+                           &aParam)) {
+        return;
+      }
+      aMsg->WriteBool(false);
+    }
     auto iter = aParam.Iter();
     while (!iter.Done()) {
       aMsg->WriteBytes(iter.Data(), iter.RemainingInSegment(), sizeof(uint64_t));
@@ -738,6 +789,23 @@ struct ParamTraits<JSStructuredCloneData>
     }
     MOZ_ASSERT(!(length % sizeof(uint64_t)));
 
+    if (IsShareable(length)) {
+      bool shared;
+      if (!aMsg->ReadBool(aIter, &shared)) {
+        return false;
+      }
+      if (shared) {
+        // A single segment, so the data is read straight into it.
+        mozilla::BufferList<js::SystemAllocPolicy> out(length, length, 4096);
+        if (out.Size() != length ||
+            !ReadSharedBytes(aMsg, aIter, out.Iter().Data(), length)) {
+          return false;
+        }
+        *aResult = JSStructuredCloneData(Move(out));
+        return true;
+      }
+    }
+
     mozilla::BufferList<InfallibleAllocPolicy> buffers(0, 0, 4096);
 
     // Borrowing is not suitable to use for IPC to hand out data
@@ -761,6 +829,19 @@ struct ParamTraits<JSStructuredCloneData>
 
     return true;
   }
+
+private:
+  static bool IsShareable(size_t aLength)
+  {
+    return aLength >= kMinSharedBytesLength && aLength <= UINT32_MAX;
+  }
+
+  static void CopySegments(void* aDest, uint32_t aLength, const void* aClosure)
+  {
+    const paramType& data = *static_cast<const paramType*>(aClosure);
+    auto iter = data.Iter();
+    MOZ_ALWAYS_TRUE(data.ReadBytes(iter, static_cast<char*>(aDest), aLength));
+  }
 };
 
 template <>
@@ -16,6 +16,7 @@
 #include "mozilla/SizePrintfMacros.h"
 #include "mozilla/Sprintf.h"
 #include "mozilla/Telemetry.h"
+#include "mozilla/TimeStamp.h"
 #include "mozilla/Logging.h"
 #include "nsAutoPtr.h"
 #include "nsDebug.h"
@@ -118,6 +119,14 @@ namespace ipc {
 
 static const uint32_t kMinTelemetryMessageSize = 8192;
 
+// How long a DequeueTask may dispatch pending messages before it yields to
+// the rest of the event loop.
+static const double kDequeueBatchBudgetMs = 4.0;
+
+// How many bulk messages DequeueOne looks past for an interactive message.
+// This bounds the cost of a dequeue when only bulk messages are pending.
+static const size_t kMaxBulkMessagesOvertaken = 256;
+
 const int32_t MessageChannel::kNoTimeout = INT32_MIN;
 
 // static
@@ -475,6 +484,8 @@ MessageChannel::MessageChannel(MessageListener *aListener)
     mWorkerLoop(nullptr),
     mChannelErrorTask(nullptr),
     mWorkerLoopID(-1),
+    mDequeueTaskPosted(false),
+    mBulkMessageFilter(nullptr),
     mTimeoutMs(kNoTimeout),
     mInTimeoutSecondHalf(false),
     mNextSeqno(0),
@@ -504,8 +515,8 @@ MessageChannel::MessageChannel(MessageListener *aListener)
 #endif
 
     RefPtr<CancelableRunnable> runnable =
-        NewNonOwningCancelableRunnableMethod(this, &MessageChannel::OnMaybeDequeueOne);
-    mDequeueOneTask = new RefCountedTask(runnable.forget());
+        NewNonOwningCancelableRunnableMethod(this, &MessageChannel::OnMaybeDequeueBatch);
+    mDequeueTask = new RefCountedTask(runnable.forget());
 
     runnable = NewNonOwningCancelableRunnableMethod(this, &MessageChannel::DispatchOnChannelConnected);
     mOnChannelConnectedTask = new RefCountedTask(runnable.forget());
@@ -630,7 +641,7 @@ MessageChannel::Clear()
         gParentProcessBlocker = nullptr;
     }
 
-    mDequeueOneTask->Cancel();
+    mDequeueTask->Cancel();
 
     mWorkerLoop = nullptr;
     delete mLink;
@@ -888,6 +899,22 @@ public:
     }
 };
 
+// Predicate that is true for the pending message a coalescable message replaces.
+class MatchingCoalesceKeys {
+    typedef IPC::Message Message;
+    Message::msgid_t mType;
+    int32_t mRoutingId;
+    uint32_t mKey;
+public:
+    explicit MatchingCoalesceKeys(const Message& aMsg) :
+        mType(aMsg.type()), mRoutingId(aMsg.routing_id()),
+        mKey(aMsg.coalesce_key()) {}
+    bool operator()(const Message &msg) {
+        return msg.type() == mType && msg.routing_id() == mRoutingId &&
+               msg.is_coalescable() && msg.coalesce_key() == mKey;
+    }
+};
+
 void
 MessageChannel::OnMessageReceivedFromLink(Message&& aMsg)
 {
@@ -917,8 +944,9 @@ MessageChannel::OnMessageReceivedFromLink(Message&& aMsg)
         return;
     }
 
-    // Prioritized messages cannot be compressed.
-    MOZ_RELEASE_ASSERT(aMsg.compress_type() == IPC::Message::COMPRESSION_NONE ||
+    // Prioritized messages cannot be compressed or coalesced.
+    MOZ_RELEASE_ASSERT((aMsg.compress_type() == IPC::Message::COMPRESSION_NONE &&
+                        !aMsg.is_coalescable()) ||
                        aMsg.priority() == IPC::Message::PRIORITY_NORMAL);
 
     bool compress = false;
@@ -947,6 +975,16 @@ MessageChannel::OnMessageReceivedFromLink(Message&& aMsg)
             MOZ_RELEASE_ASSERT((*it).compress_type() == IPC::Message::COMPRESSION_ALL);
             mPending.erase((++it).base());
         }
+    } else if (aMsg.is_coalescable()) {
+        // Like COMPRESSION_ALL, but only a message with the same key is stale.
+        // The newer message goes to the back of the queue, so that it is still
+        // ordered after whatever was sent between the two.
+        auto it = std::find_if(mPending.rbegin(), mPending.rend(),
+                               MatchingCoalesceKeys(aMsg));
+        if (it != mPending.rend()) {
+            compress = true;
+            mPending.erase((++it).base());
+        }
     }
 
     bool wakeUpSyncSend = AwaitingSyncReply() && !ShouldDeferMessage(aMsg);
@@ -993,12 +1031,8 @@ MessageChannel::OnMessageReceivedFromLink(Message&& aMsg)
     }
 
     if (shouldPostTask) {
-        if (!compress) {
-            // If we compressed away the previous message, we'll re-use
-            // its pending task.
-            RefPtr<DequeueTask> task = new DequeueTask(mDequeueOneTask);
-            mWorkerLoop->PostTask(task.forget());
-        }
+        // If a task is already posted, it will dispatch this message as well.
+        PostDequeueTask();
     }
 }
 
@@ -1546,11 +1580,82 @@ MessageChannel::DequeueOne(Message *recvd)
     if (mPending.empty())
         return false;
 
-    *recvd = Move(mPending.front());
-    mPending.pop_front();
+    MessageQueue::iterator next = mPending.begin();
+    if (mBulkMessageFilter) {
+        // Look past plain async bulk messages for an interactive one. Any
+        // other message ends the search, since it has to be dispatched in
+        // order.
+        size_t overtaken = 0;
+        for (MessageQueue::iterator it = mPending.begin();
+             it != mPending.end() && overtaken < kMaxBulkMessagesOvertaken;
+             it++, overtaken++)
+        {
+            Message &msg = *it;
+            bool plainAsync = !msg.is_sync() && !msg.is_interrupt() &&
+                              msg.priority() == IPC::Message::PRIORITY_NORMAL;
+            if (plainAsync && mBulkMessageFilter(msg)) {
+                continue;
+            }
+            if (plainAsync) {
+                next = it;
+            }
+            break;
+        }
+    }
+
+    *recvd = Move(*next);
+    mPending.erase(next);
     return true;
 }
 
+void
+MessageChannel::PostDequeueTask()
+{
+    mMonitor->AssertCurrentThreadOwns();
+
+    if (mDequeueTaskPosted) {
+        return;
+    }
+    mDequeueTaskPosted = true;
+
+    RefPtr<DequeueTask> task = new DequeueTask(mDequeueTask);
+    mWorkerLoop->PostTask(task.forget());
+}
+
+void
+MessageChannel::OnMaybeDequeueBatch()
+{
+    AssertWorkerThread();
+    mMonitor->AssertNotCurrentThreadOwns();
+
+    {
+        MonitorAutoLock lock(*mMonitor);
+        // Messages that arrive from now on post a new task. That way, if a
+        // message dispatched below spins a nested event loop, the messages
+        // that arrive meanwhile are still dispatched from it.
+        mDequeueTaskPosted = false;
+    }
+
+    TimeStamp deadline =
+        TimeStamp::Now() + TimeDuration::FromMilliseconds(kDequeueBatchBudgetMs);
+    bool outOfBudget = false;
+    while (OnMaybeDequeueOne()) {
+        if (TimeStamp::Now() >= deadline) {
+            outOfBudget = true;
+            break;
+        }
+    }
+
+    // Post another task for whatever is left. If OnMaybeDequeueOne stopped
+    // because the remaining messages are held back by a timed out message,
+    // EndTimeout posts the task instead.
+    MonitorAutoLock lock(*mMonitor);
+    if (Connected() && (!mPending.empty() || !mDeferred.empty()) &&
+        (outOfBudget || !mTimedOutMessageSeqno)) {
+        PostDequeueTask();
+    }
+}
+
 bool
 MessageChannel::OnMaybeDequeueOne()
 {
@@ -1821,17 +1926,8 @@ MessageChannel::EnqueuePendingMessages()
 
     MaybeUndeferIncall();
 
-    for (size_t i = 0; i < mDeferred.size(); ++i) {
-        RefPtr<DequeueTask> task = new DequeueTask(mDequeueOneTask);
-        mWorkerLoop->PostTask(task.forget());
-    }
-
-    // XXX performance tuning knob: could process all or k pending
-    // messages here, rather than enqueuing for later processing
-
-    for (size_t i = 0; i < mPending.size(); ++i) {
-        RefPtr<DequeueTask> task = new DequeueTask(mDequeueOneTask);
-        mWorkerLoop->PostTask(task.forget());
+    if (!mDeferred.empty() || !mPending.empty()) {
+        PostDequeueTask();
     }
 }
 
@@ -2340,13 +2436,12 @@ MessageChannel::EndTimeout()
     mTimedOutMessageSeqno = 0;
     mTimedOutMessagePriority = 0;
 
-    for (size_t i = 0; i < mPending.size(); i++) {
+    if (!mPending.empty()) {
         // There may be messages in the queue that we expected to process from
         // OnMaybeDequeueOne. But during the timeout, that function will skip
-        // some messages. Now they're ready to be processed, so we enqueue more
-        // tasks.
-        RefPtr<DequeueTask> task = new DequeueTask(mDequeueOneTask);
-        mWorkerLoop->PostTask(task.forget());
+        // some messages. Now they're ready to be processed, so we enqueue a
+        // task.
+        PostDequeueTask();
     }
 }
 
@@ -136,6 +136,21 @@ class MessageChannel : HasResultCodes
     void SetChannelFlags(ChannelFlags aFlags) { mFlags = aFlags; }
     ChannelFlags GetChannelFlags() { return mFlags; }
 
+    // Classifies received messages as bulk (true) or interactive (false).
+    typedef bool (*BulkMessageFilter)(const Message& aMsg);
+
+    // Lets pending interactive async messages overtake the bulk async
+    // messages queued ahead of them, so that a burst of bulk work doesn't
+    // delay latency-sensitive protocols. Messages to the same actor are
+    // still dispatched in order, provided the filter classifies all the
+    // messages of a protocol alike and classifies the managees of bulk
+    // protocols as bulk: a message then never overtakes the constructor of
+    // its actor. Must be called on the worker thread or before the channel is
+    // opened.
+    void SetBulkMessageFilter(BulkMessageFilter aFilter) {
+        mBulkMessageFilter = aFilter;
+    }
+
     // Asynchronously send a message to the other side of the channel
     bool Send(Message* aMsg);
 
@@ -276,6 +291,14 @@ class MessageChannel : HasResultCodes
     void MaybeUndeferIncall();
     void EnqueuePendingMessages();
 
+    // Executed on the worker thread. Dispatches the pending messages until
+    // none are left or the batch has run for kDequeueBatchBudgetMs.
+    void OnMaybeDequeueBatch();
+
+    // Posts a task running OnMaybeDequeueBatch, unless one is already
+    // posted and hasn't started yet.
+    void PostDequeueTask();
+
     // Executed on the worker thread. Dequeues one pending message.
     bool OnMaybeDequeueOne();
     bool DequeueOne(Message *recvd);
@@ -584,8 +607,17 @@ class MessageChannel : HasResultCodes
     // during channel shutdown.
     int mWorkerLoopID;
 
-    // A task encapsulating dequeuing one pending message.
-    RefPtr<RefCountedTask> mDequeueOneTask;
+    // A task encapsulating dequeuing a batch of pending messages.
+    RefPtr<RefCountedTask> mDequeueTask;
+
+    // Whether a DequeueTask has been posted and hasn't started running. All
+    // the pending messages will be dispatched by that task, so incoming
+    // messages don't need to post another one. Protected by mMonitor.
+    bool mDequeueTaskPosted;
+
+    // See SetBulkMessageFilter. Null if all messages are dispatched in the
+    // order they were received.
+    BulkMessageFilter mBulkMessageFilter;
 
     // Timeout periods are broken up in two to prevent system suspension from
     // triggering an abort. This method (called by WaitForEvent with a 'did
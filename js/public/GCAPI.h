@@ -203,6 +203,13 @@ SkipZoneForGC(Zone* zone);
 extern JS_PUBLIC_API(void)
 GCForReason(JSContext* cx, JSGCInvocationKind gckind, gcreason::Reason reason);
 
+/**
+ * Performs a shrinking collection, which compacts the heap where possible
+ * and releases memory held by caches.
+ */
+extern JS_PUBLIC_API(void)
+ShrinkGCBuffers(JSContext* cx);
+
 /*
  * Incremental GC:
  *
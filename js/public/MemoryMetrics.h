@@ -514,6 +514,7 @@ struct RuntimeSizes
     macro(_, MallocHeap, mathCache) \
     macro(_, MallocHeap, sharedImmutableStringsCache) \
     macro(_, MallocHeap, uncompressedSourceCache) \
+    macro(_, MallocHeap, regExpCodeCache) \
     macro(_, MallocHeap, scriptData)
 
     RuntimeSizes()
@@ -80,9 +80,14 @@ class JS_PUBLIC_API(JSTracer)
         // General-purpose traversal that invokes a callback on each cell.
         // Traversing children is the responsibility of the callback.
         Callback,
-        OMR_SCAN
+        OMR_SCAN,
+
+        // Rewrites edges to cells moved by the OMR compactor. Edges are
+        // visited in place, so this cannot be a callback tracer.
+        OMR_COMPACT
     };
 	bool isOmrMarkingTracer() const { return tag_ == TracerKindTag::OMR_SCAN; }
+	bool isOmrCompactingTracer() const { return tag_ == TracerKindTag::OMR_COMPACT; }
     bool isMarkingTracer() const { return tag_ == TracerKindTag::Marking || tag_ == TracerKindTag::WeakMarking; }
     bool isWeakMarkingTracer() const { return tag_ == TracerKindTag::WeakMarking; }
     bool isTenuringTracer() const { return tag_ == TracerKindTag::Tenuring; }
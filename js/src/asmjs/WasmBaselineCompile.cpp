@@ -1922,6 +1922,16 @@ class BaseCompiler
             for (int32_t i = varLow_ ; i < varHigh_ ; i+=4)
                 storeToFrameI32(scratch, i+4);
         }
+
+        // In tiered mode, count the entry so that Instance can find the hot
+        // functions to recompile with Ion.
+
+        if (mg_.entryCountersOffset) {
+            ScratchI32 scratch(*this);
+            uint32_t counterOffset = mg_.entryCountersOffset + func_.defIndex() * sizeof(uint32_t);
+            masm.loadPtr(Address(WasmTlsReg, offsetof(TlsData, globalData)), scratch);
+            masm.add32(Imm32(1), Address(scratch, counterOffset));
+        }
     }
 
     bool endFunction() {
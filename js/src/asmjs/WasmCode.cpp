@@ -104,6 +104,11 @@ StaticallyLink(CodeSegment& cs, const LinkData& linkData, ExclusiveContext* cx)
 
     *(double*)(cs.globalData() + NaN64GlobalDataOffset) = GenericNaN();
     *(float*)(cs.globalData() + NaN32GlobalDataOffset) = GenericNaN();
+
+#ifdef JS_CODEGEN_X64
+    for (auto imm : MakeEnumeratedRange(SymbolicAddress::Limit))
+        *(void**)(cs.globalData() + SymbolicAddressGlobalDataOffset(imm)) = AddressOf(imm, cx);
+#endif
 }
 
 static void
@@ -418,6 +418,11 @@ class MetadataCacheablePod
 
     uint32_t              startFuncIndex_;
 
+    // In tiered mode, the global data offset of an array of uint32_t entry
+    // counters, indexed by function definition index. Zero otherwise, since
+    // no global datum lives below InitialGlobalDataBytes.
+    uint32_t              entryCountersOffset_;
+
   public:
     ModuleKind            kind;
     MemoryUsage           memoryUsage;
@@ -442,6 +447,19 @@ class MetadataCacheablePod
         MOZ_ASSERT(hasStartFunction());
         return startFuncIndex_;
     }
+
+    bool hasEntryCounters() const {
+        return entryCountersOffset_ != 0;
+    }
+    void initEntryCountersOffset(uint32_t offset) {
+        MOZ_ASSERT(!hasEntryCounters());
+        entryCountersOffset_ = offset;
+        MOZ_ASSERT(hasEntryCounters());
+    }
+    uint32_t entryCountersOffset() const {
+        MOZ_ASSERT(hasEntryCounters());
+        return entryCountersOffset_;
+    }
 };
 
 struct Metadata : ShareableBase<Metadata>, MetadataCacheablePod
@@ -523,6 +541,7 @@ class Code
     CodeSegment& segment() { return *segment_; }
     const CodeSegment& segment() const { return *segment_; }
     const Metadata& metadata() const { return *metadata_; }
+    const ShareableBytes* maybeBytecode() const { return maybeBytecode_.get(); }
 
     // Frame iterator support:
 
@@ -103,6 +103,28 @@ Compartment::unregisterInstance(Instance& instance)
     instances_.erase(instances_.begin() + index);
 }
 
+void
+Compartment::replaceCode(Instance& instance, UniqueCode newCode)
+{
+    MOZ_ASSERT(!hasActivations());
+
+    size_t index;
+    if (!BinarySearchIf(instances_, 0, instances_.length(), InstanceComparator(instance), &index))
+        MOZ_CRASH("unregistered instance");
+
+    AutoMutateInstances guard(*this);
+    instances_.erase(instances_.begin() + index);
+
+    // Only destroy the old code once the instance is out of instances_.
+    instance.code_ = Move(newCode);
+
+    MOZ_ALWAYS_FALSE(BinarySearchIf(instances_, 0, instances_.length(),
+                                    InstanceComparator(instance), &index));
+
+    // The element just erased left enough capacity for this insertion.
+    MOZ_ALWAYS_TRUE(instances_.insert(instances_.begin() + index, &instance));
+}
+
 struct PCComparator
 {
     const void* pc;
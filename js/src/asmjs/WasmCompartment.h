@@ -28,6 +28,7 @@ class WasmActivation;
 namespace wasm {
 
 class Code;
+typedef UniquePtr<Code> UniqueCode;
 typedef Vector<Instance*, 0, SystemAllocPolicy> InstanceVector;
 
 // wasm::Compartment lives in JSCompartment and contains the wasm-related
@@ -89,6 +90,16 @@ class Compartment
 
     Instance* lookupInstanceDeprecated(const void* pc) const;
 
+    // Whether any wasm code of this compartment is on the stack. Code may only
+    // be patched or replaced when it is not.
+
+    bool hasActivations() const { return activationCount_ > 0; }
+
+    // Replace the code of an instance that has tiered up, keeping instances_
+    // sorted by code address.
+
+    void replaceCode(Instance& instance, UniqueCode newCode);
+
     // To ensure profiling is enabled (so that wasm frames are not lost in
     // profiling callstacks), ensureProfilingState must be called before calling
     // the first wasm function in a compartment.
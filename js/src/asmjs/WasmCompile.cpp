@@ -1325,6 +1325,7 @@ bool
 CompileArgs::initFromContext(ExclusiveContext* cx, ScriptedCaller&& scriptedCaller)
 {
     alwaysBaseline = cx->options().wasmAlwaysBaseline();
+    tiering = cx->options().wasmTiering() && !alwaysBaseline;
     this->scriptedCaller = Move(scriptedCaller);
     return assumptions.initBuildIdFromContext(cx);
 }
@@ -1393,3 +1394,9 @@ wasm::Compile(const ShareableBytes& bytecode, const CompileArgs& args, UniqueCha
 
     return mg.finish(bytecode);
 }
+
+void
+TierUpTask::execute()
+{
+    module_ = Compile(*bytecode_, args_, &error_);
+}
@@ -42,10 +42,18 @@ struct CompileArgs
     ScriptedCaller scriptedCaller;
     MOZ_INIT_OUTSIDE_CTOR bool alwaysBaseline;
 
+    // In tiered mode, functions are compiled with the baseline compiler (when
+    // it can compile them) and count their entries so that hot functions can
+    // later be recompiled with Ion. A tier-up recompilation lists, in
+    // increasing order, the function definitions to compile with Ion.
+    MOZ_INIT_OUTSIDE_CTOR bool tiering;
+    Uint32Vector ionFuncDefs;
+
     CompileArgs(Assumptions&& assumptions, ScriptedCaller&& scriptedCaller)
       : assumptions(Move(assumptions)),
         scriptedCaller(Move(scriptedCaller)),
-        alwaysBaseline(false)
+        alwaysBaseline(false),
+        tiering(false)
     {}
 
     // If CompileArgs is constructed without arguments, initFromContext() must
@@ -63,6 +71,44 @@ struct CompileArgs
 SharedModule
 Compile(const ShareableBytes& bytecode, const CompileArgs& args, UniqueChars* error);
 
+// A TierUpTask recompiles the bytecode of a tiered module on a helper thread
+// for Tiering::startTierUp. The task owns a private copy of the bytecode since
+// the refcounts of the Tiering's data may only be touched by the main thread.
+// If the Tiering is destroyed while the task runs, the task is orphaned and
+// deleted by the helper thread when it finishes.
+
+class TierUpTask
+{
+    MutableBytes              bytecode_;
+    CompileArgs               args_;
+    SharedModule              module_;
+    UniqueChars               error_;
+
+    // Both are only written with the helper thread state lock held.
+    mozilla::Atomic<bool>     finished_;
+    bool                      orphaned_;
+
+  public:
+    TierUpTask(MutableBytes bytecode, CompileArgs&& args)
+      : bytecode_(Move(bytecode)),
+        args_(Move(args)),
+        finished_(false),
+        orphaned_(false)
+    {}
+
+    void execute();
+
+    bool finished() const { return finished_; }
+    void setFinished() { finished_ = true; }
+    bool orphaned() const { return orphaned_; }
+    void setOrphaned() { orphaned_ = true; }
+
+    // After the task has finished, its result is null if recompilation failed.
+
+    SharedModule takeModule() { return Move(module_); }
+    Uint32Vector& ionFuncDefs() { return args_.ionFuncDefs; }
+};
+
 }  // namespace wasm
 }  // namespace js
 
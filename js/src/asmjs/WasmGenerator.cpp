@@ -18,6 +18,7 @@
 
 #include "asmjs/WasmGenerator.h"
 
+#include "mozilla/BinarySearch.h"
 #include "mozilla/CheckedInt.h"
 #include "mozilla/EnumeratedRange.h"
 
@@ -33,6 +34,7 @@ using namespace js;
 using namespace js::jit;
 using namespace js::wasm;
 
+using mozilla::BinarySearch;
 using mozilla::CheckedInt;
 using mozilla::MakeEnumeratedRange;
 
@@ -44,6 +46,7 @@ static const unsigned COMPILATION_LIFO_DEFAULT_CHUNK_SIZE = 64 * 1024;
 
 ModuleGenerator::ModuleGenerator(ImportVector&& imports)
   : alwaysBaseline_(false),
+    tiering_(false),
     imports_(Move(imports)),
     numSigs_(0),
     numTables_(0),
@@ -186,6 +189,20 @@ ModuleGenerator::init(UniqueModuleGeneratorData shared, const CompileArgs& args,
             if (!allocateGlobal(&global))
                 return false;
         }
+
+        // The entry counters are allocated last and at every tier so that all
+        // tiers of a module share one global data layout.
+        if (args.tiering && numFuncDefs() > 0) {
+            tiering_ = true;
+            if (!ionFuncDefs_.appendAll(args.ionFuncDefs))
+                return false;
+
+            uint32_t bytes = numFuncDefs() * sizeof(uint32_t);
+            if (!allocateGlobalBytes(bytes, sizeof(uint32_t), &shared_->entryCountersOffset))
+                return false;
+
+            metadata_->initEntryCountersOffset(shared_->entryCountersOffset);
+        }
     } else {
         MOZ_ASSERT(shared_->sigs.length() == MaxSigs);
         MOZ_ASSERT(shared_->tables.length() == MaxTables);
@@ -245,6 +262,13 @@ ModuleGenerator::funcIsDefined(uint32_t funcDefIndex) const
            funcDefIndexToCodeRange_[funcDefIndex] != BadCodeRange;
 }
 
+bool
+ModuleGenerator::funcDefIsTieredUp(uint32_t funcDefIndex) const
+{
+    size_t match;
+    return BinarySearch(ionFuncDefs_, 0, ionFuncDefs_.length(), funcDefIndex, &match);
+}
+
 const CodeRange&
 ModuleGenerator::funcDefCodeRange(uint32_t funcDefIndex) const
 {
@@ -540,7 +564,11 @@ ModuleGenerator::finishLinkData(Bytes& code)
     // page size (as required by the allocator functions).
     linkData_.globalDataLength = AlignBytes(linkData_.globalDataLength, gc::SystemPageSize());
 
-    // Add links to absolute addresses identified symbolically.
+    // Add links to absolute addresses identified symbolically. x64 loads
+    // these from global data instead (see SymbolicAddressTableOffset).
+#ifdef JS_CODEGEN_X64
+    MOZ_ASSERT(masm_.numAsmJSAbsoluteAddresses() == 0);
+#endif
     for (size_t i = 0; i < masm_.numAsmJSAbsoluteAddresses(); i++) {
         AsmJSAbsoluteAddress src = masm_.asmJSAbsoluteAddress(i);
         if (!linkData_.symbolicLinks[src.target].append(src.patchAt.offset()))
@@ -932,7 +960,8 @@ ModuleGenerator::finishFuncDef(uint32_t funcDefIndex, FunctionGenerator* fg)
     if (!func)
         return false;
 
-    auto mode = alwaysBaseline_ && BaselineCanCompile(fg)
+    bool baseline = alwaysBaseline_ || (tiering_ && !funcDefIsTieredUp(funcDefIndex));
+    auto mode = baseline && BaselineCanCompile(fg)
                 ? IonCompileTask::CompileMode::Baseline
                 : IonCompileTask::CompileMode::Ion;
 
@@ -1122,6 +1151,16 @@ ModuleGenerator::finish(const ShareableBytes& bytecode)
     if (!finishLinkData(code))
         return nullptr;
 
+    // The first tier of a tiered module owns the Tiering. Recompiled tiers are
+    // only reachable from the Tiering, which therefore must not be owned by
+    // them too.
+    SharedTiering tiering;
+    if (tiering_ && ionFuncDefs_.empty()) {
+        tiering = js_new<Tiering>(bytecode, *metadata_, numFuncDefs());
+        if (!tiering)
+            return nullptr;
+    }
+
     return SharedModule(js_new<Module>(Move(code),
                                        Move(linkData_),
                                        Move(imports_),
@@ -1129,5 +1168,6 @@ ModuleGenerator::finish(const ShareableBytes& bytecode)
                                        Move(dataSegments_),
                                        Move(elemSegments_),
                                        *metadata_,
-                                       bytecode));
+                                       bytecode,
+                                       tiering));
 }
@@ -54,6 +54,7 @@ struct ModuleGeneratorData
     mozilla::Atomic<uint32_t> minMemoryLength;
     Maybe<uint32_t>           maxMemoryLength;
     uint32_t                  firstFuncDefIndex;
+    uint32_t                  entryCountersOffset;
 
     SigWithIdVector           sigs;
     SigWithIdPtrVector        funcDefSigs;
@@ -66,7 +67,8 @@ struct ModuleGeneratorData
       : kind(kind),
         memoryUsage(MemoryUsage::None),
         minMemoryLength(0),
-        firstFuncDefIndex(0)
+        firstFuncDefIndex(0),
+        entryCountersOffset(0)
     {}
 
     bool isAsmJS() const {
@@ -90,6 +92,8 @@ class MOZ_STACK_CLASS ModuleGenerator
 
     // Constant parameters
     bool                            alwaysBaseline_;
+    bool                            tiering_;
+    Uint32Vector                    ionFuncDefs_;
 
     // Data that is moved into the result of finish()
     LinkData                        linkData_;
@@ -128,6 +132,7 @@ class MOZ_STACK_CLASS ModuleGenerator
     bool funcIndexIsDef(uint32_t funcIndex) const;
     uint32_t funcIndexToDef(uint32_t funcIndex) const;
     bool funcIsDefined(uint32_t funcDefIndex) const;
+    bool funcDefIsTieredUp(uint32_t funcDefIndex) const;
     const CodeRange& funcDefCodeRange(uint32_t funcDefIndex) const;
     MOZ_MUST_USE bool convertOutOfRangeBranchesToThunks();
     MOZ_MUST_USE bool finishTask(IonCompileTask* task);
@@ -34,6 +34,10 @@ using mozilla::BitwiseCast;
 using mozilla::IsNaN;
 using mozilla::Swap;
 
+// The number of calls into an instance between two scans of its entry counters
+// for hot functions.
+static const uint32_t TierUpCheckInterval = 64;
+
 class SigIdSet
 {
     typedef HashMap<const Sig*, uint32_t, SigHashPolicy, SystemAllocPolicy> Map;
@@ -310,12 +314,16 @@ Instance::Instance(JSContext* cx,
                    HandleWasmMemoryObject memory,
                    SharedTableVector&& tables,
                    Handle<FunctionVector> funcImports,
-                   const ValVector& globalImports)
+                   const ValVector& globalImports,
+                   Tiering* maybeTiering)
   : compartment_(cx->compartment()),
     object_(object),
     code_(Move(code)),
     memory_(memory),
-    tables_(Move(tables))
+    tables_(Move(tables)),
+    tiering_(maybeTiering),
+    tierGeneration_(maybeTiering ? maybeTiering->generation() : 0),
+    tierUpCheckCountdown_(TierUpCheckInterval)
 {
     MOZ_ASSERT(funcImports.length() == metadata().funcImports.length());
     MOZ_ASSERT(tables_.length() == metadata().tables.length());
@@ -524,6 +532,9 @@ Instance::callExport(JSContext* cx, uint32_t funcDefIndex, CallArgs args)
     if (!cx->compartment()->wasm.ensureProfilingState(cx))
         return false;
 
+    if (tiering_ && !maybeTierUp(cx))
+        return false;
+
     const FuncDefExport& func = metadata().lookupFuncDefExport(funcDefIndex);
 
     // The calling convention for an external call into wasm is to pass an
@@ -820,6 +831,209 @@ Instance::ensureProfilingState(JSContext* cx, bool newProfilingEnabled)
     return true;
 }
 
+void
+Instance::noteTableElem(Table& table)
+{
+    if (!tiering_)
+        return;
+
+    for (const SharedTable& t : tables_) {
+        if (t == &table)
+            return;
+    }
+    for (const SharedTable& t : foreignTables_) {
+        if (t == &table)
+            return;
+    }
+
+    // Without a complete list of the tables referring to this instance's code,
+    // the code can never be replaced.
+    if (!foreignTables_.append(&table))
+        tiering_ = nullptr;
+}
+
+bool
+Instance::maybeTierUp(JSContext* cx)
+{
+    MOZ_ASSERT(tiering_);
+
+    // Like profiling mode, the code can only be replaced when it isn't on the
+    // stack. Since instances in a compartment call each other directly, wait
+    // until no wasm is running in the compartment at all.
+    if (compartment_->wasm.hasActivations())
+        return true;
+
+    tiering_->finishTierUp();
+    if (tiering_->generation() != tierGeneration_)
+        return tierUp(cx);
+
+    if (--tierUpCheckCountdown_ > 0)
+        return true;
+    tierUpCheckCountdown_ = TierUpCheckInterval;
+
+    if (!tiering_->canTierUp())
+        return true;
+
+    MOZ_ASSERT(metadata().hasEntryCounters());
+    const uint32_t* entryCounts =
+        (const uint32_t*)(tlsData_.globalData + metadata().entryCountersOffset());
+
+    Uint32Vector hotFuncDefs;
+    for (uint32_t funcDefIndex = 0; funcDefIndex < tiering_->numFuncDefs(); funcDefIndex++) {
+        if (entryCounts[funcDefIndex] < Tiering::HotEntryCount)
+            continue;
+        if (tiering_->isTieredUp(funcDefIndex))
+            continue;
+        if (!hotFuncDefs.append(funcDefIndex)) {
+            ReportOutOfMemory(cx);
+            return false;
+        }
+    }
+
+    if (hotFuncDefs.empty())
+        return true;
+
+    return tiering_->startTierUp(cx, hotFuncDefs);
+}
+
+// Maps function entry points of the code being replaced to the same entry
+// points of the same functions in the replacement.
+class EntryRemapper
+{
+    const Code&  from_;
+    const Code&  to_;
+    Uint32Vector codeRangeIndices_;
+
+  public:
+    EntryRemapper(const Code& from, const Code& to)
+      : from_(from), to_(to)
+    {}
+
+    bool init(uint32_t numFuncDefs) {
+        if (!codeRangeIndices_.appendN(UINT32_MAX, numFuncDefs))
+            return false;
+
+        const CodeRangeVector& codeRanges = to_.metadata().codeRanges;
+        for (size_t i = 0; i < codeRanges.length(); i++) {
+            if (codeRanges[i].isFunction())
+                codeRangeIndices_[codeRanges[i].funcDefIndex()] = i;
+        }
+        return true;
+    }
+
+    bool covers(const void* entry) const {
+        return from_.segment().containsFunctionPC(entry);
+    }
+
+    void* remap(void* entry) const {
+        MOZ_ASSERT(covers(entry));
+
+        const CodeRange& fromRange = *from_.lookupRange(entry);
+        uint32_t offset = (uint8_t*)entry - from_.segment().base();
+
+        uint32_t index = codeRangeIndices_[fromRange.funcDefIndex()];
+        MOZ_RELEASE_ASSERT(index != UINT32_MAX);
+        const CodeRange& toRange = to_.metadata().codeRanges[index];
+
+        uint32_t toOffset;
+        if (offset == fromRange.funcTableEntry())
+            toOffset = toRange.funcTableEntry();
+        else if (offset == fromRange.funcProfilingEntry())
+            toOffset = toRange.funcProfilingEntry();
+        else if (offset == fromRange.funcNonProfilingEntry())
+            toOffset = toRange.funcNonProfilingEntry();
+        else
+            MOZ_CRASH("not a function entry");
+
+        return to_.segment().base() + toOffset;
+    }
+};
+
+bool
+Instance::tierUp(JSContext* cx)
+{
+    MOZ_ASSERT(!compartment_->wasm.hasActivations());
+
+    const Module& module = *tiering_->bestModule();
+    UniqueCode newCode = module.createCode(cx, memory_, code_->maybeBytecode());
+    if (!newCode)
+        return false;
+
+    if (!newCode->ensureProfilingState(cx, code_->profilingEnabled()))
+        return false;
+
+    EntryRemapper remapper(*code_, *newCode);
+    if (!remapper.init(tiering_->numFuncDefs())) {
+        ReportOutOfMemory(cx);
+        return false;
+    }
+
+    // Nothing can fail from here on. Both tiers were compiled from the same
+    // bytecode with the same global data layout, so the instance's global
+    // state (including import and table TLS, signature ids and entry counts)
+    // carries over as-is.
+
+    const CodeSegment& oldSegment = code_->segment();
+    const CodeSegment& newSegment = newCode->segment();
+    MOZ_RELEASE_ASSERT(oldSegment.globalDataLength() == newSegment.globalDataLength());
+    memcpy(newSegment.globalData(), oldSegment.globalData(), oldSegment.globalDataLength());
+
+    const Metadata& newMetadata = newCode->metadata();
+    for (size_t i = 0; i < newMetadata.funcImports.length(); i++) {
+        const FuncImport& oldImport = metadata().funcImports[i];
+        const FuncImport& newImport = newMetadata.funcImports[i];
+        FuncImportTls& import = *(FuncImportTls*)(newSegment.globalData() + newImport.tlsDataOffset());
+        if (import.tls != &tlsData_)
+            continue;
+
+        uint8_t* oldCode = (uint8_t*)import.code;
+        if (oldCode == oldSegment.base() + oldImport.jitExitCodeOffset())
+            import.code = newSegment.base() + newImport.jitExitCodeOffset();
+        else
+            import.code = newSegment.base() + newImport.interpExitCodeOffset();
+    }
+
+    // Other instances in the compartment may call this instance's functions
+    // directly as imports.
+    for (Instance* instance : compartment_->wasm.instances()) {
+        if (instance == this)
+            continue;
+
+        for (const FuncImport& fi : instance->metadata().funcImports) {
+            FuncImportTls& import = instance->funcImportTls(fi);
+            if (import.tls == &tlsData_ && remapper.covers(import.code))
+                import.code = remapper.remap(import.code);
+        }
+    }
+
+    auto remapTable = [&](Table& table) {
+        if (table.external()) {
+            ExternalTableElem* array = table.externalArray();
+            for (uint32_t i = 0; i < table.length(); i++) {
+                if (array[i].tls == &tlsData_ && remapper.covers(array[i].code))
+                    array[i].code = remapper.remap(array[i].code);
+            }
+        } else {
+            void** array = table.internalArray();
+            for (uint32_t i = 0; i < table.length(); i++) {
+                if (array[i] && remapper.covers(array[i]))
+                    array[i] = remapper.remap(array[i]);
+            }
+        }
+    };
+
+    for (const SharedTable& table : tables_)
+        remapTable(*table);
+    for (const SharedTable& table : foreignTables_)
+        remapTable(*table);
+
+    tlsData_.globalData = newSegment.globalData();
+    tierGeneration_ = tiering_->generation();
+
+    compartment_->wasm.replaceCode(*this, Move(newCode));
+    return true;
+}
+
 void
 Instance::addSizeOfMisc(MallocSizeOf mallocSizeOf,
                         Metadata::SeenSet* seenMetadata,
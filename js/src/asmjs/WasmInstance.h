@@ -20,6 +20,7 @@
 #define wasm_instance_h
 
 #include "asmjs/WasmCode.h"
+#include "asmjs/WasmModule.h"
 #include "asmjs/WasmTable.h"
 #include "gc/Barrier.h"
 
@@ -40,15 +41,25 @@ class Instance
 {
     JSCompartment* const                 compartment_;
     ReadBarrieredWasmInstanceObject      object_;
-    const UniqueCode                     code_;
+    UniqueCode                           code_;
     GCPtrWasmMemoryObject                memory_;
     SharedTableVector                    tables_;
     TlsData                              tlsData_;
 
+    // Tiered compilation state (see Tiering). Tables other than tables_ that
+    // hold this instance's functions are tracked so that their elements can be
+    // switched over to the new code when the instance tiers up.
+    SharedTiering                        tiering_;
+    uint32_t                             tierGeneration_;
+    uint32_t                             tierUpCheckCountdown_;
+    SharedTableVector                    foreignTables_;
+
     // Internal helpers:
     const void** addressOfSigId(const SigIdDesc& sigId) const;
     FuncImportTls& funcImportTls(const FuncImport& fi);
     TableTls& tableTls(const TableDesc& td) const;
+    MOZ_MUST_USE bool maybeTierUp(JSContext* cx);
+    MOZ_MUST_USE bool tierUp(JSContext* cx);
 
     // Import call slow paths which are called directly from wasm code.
     friend void* AddressOf(SymbolicAddress, ExclusiveContext*);
@@ -65,6 +76,10 @@ class Instance
     friend class js::WasmInstanceObject;
     void tracePrivate(JSTracer* trc);
 
+    // Compartment keeps instances sorted by code address and so replaces the
+    // code of an instance that tiers up.
+    friend class Compartment;
+
   public:
     Instance(JSContext* cx,
              HandleWasmInstanceObject object,
@@ -72,7 +87,8 @@ class Instance
              HandleWasmMemoryObject memory,
              SharedTableVector&& tables,
              Handle<FunctionVector> funcImports,
-             const ValVector& globalImports);
+             const ValVector& globalImports,
+             Tiering* maybeTiering);
     ~Instance();
     bool init(JSContext* cx);
     void trace(JSTracer* trc);
@@ -123,6 +139,10 @@ class Instance
     void onMovingGrowMemory(uint8_t* prevMemoryBase);
     void onMovingGrowTable();
 
+    // Called by Table when one of this instance's functions is stored into an
+    // external table.
+    void noteTableElem(Table& table);
+
     // See Code::ensureProfilingState comment.
 
     MOZ_MUST_USE bool ensureProfilingState(JSContext* cx, bool enabled);
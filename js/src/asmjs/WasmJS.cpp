@@ -20,6 +20,7 @@
 
 #include "mozilla/CheckedInt.h"
 #include "mozilla/Maybe.h"
+#include "mozilla/SHA1.h"
 
 #include "jsprf.h"
 
@@ -39,9 +40,12 @@ using namespace js;
 using namespace js::jit;
 using namespace js::wasm;
 using mozilla::CheckedInt;
+using mozilla::DebugOnly;
 using mozilla::IsNaN;
 using mozilla::IsSame;
 using mozilla::Nothing;
+using mozilla::PodEqual;
+using mozilla::SHA1Sum;
 
 bool
 wasm::HasCompilerSupport(ExclusiveContext* cx)
@@ -581,6 +585,125 @@ GetCompileArgs(JSContext* cx, CallArgs callArgs, const char* name, MutableBytes*
     return true;
 }
 
+// The embedding may cache compiled modules, keyed by a hash of their bytecode
+// (see JS::WasmCacheOps). An entry is a serialized Module, which includes the
+// Assumptions it was compiled under as well as its bytecode, both of which must
+// match before the entry is used.
+
+static_assert(sizeof(SHA1Sum::Hash) == JS::WasmCacheKeyLength, "cache key is a SHA1 hash");
+
+static void
+ComputeCacheKey(const ShareableBytes& bytecode, SHA1Sum::Hash& key)
+{
+    SHA1Sum sha1;
+    sha1.update(bytecode.begin(), bytecode.length());
+    sha1.finish(key);
+}
+
+namespace {
+
+struct ScopedWasmCacheEntryForRead
+{
+    JSContext* cx;
+    size_t serializedSize;
+    const uint8_t* memory;
+    intptr_t handle;
+
+    explicit ScopedWasmCacheEntryForRead(JSContext* cx)
+      : cx(cx), serializedSize(0), memory(nullptr), handle(0)
+    {}
+
+    ~ScopedWasmCacheEntryForRead() {
+        if (memory)
+            cx->runtime()->wasmCacheOps.closeEntryForRead(serializedSize, memory, handle);
+    }
+};
+
+} // unnamed namespace
+
+// Return the cached module compiled from the given bytecode, or null. Since the
+// cache is only an optimization, any failure (including OOM while
+// deserializing) is treated as a miss.
+static SharedModule
+LookupModuleInCache(JSContext* cx, const ShareableBytes& bytecode, const CompileArgs& compileArgs)
+{
+    // Cached code is always fully optimized.
+    if (compileArgs.alwaysBaseline)
+        return nullptr;
+
+    JS::OpenWasmCacheEntryForReadOp open = cx->runtime()->wasmCacheOps.openEntryForRead;
+    if (!open)
+        return nullptr;
+
+    SHA1Sum::Hash key;
+    ComputeCacheKey(bytecode, key);
+
+    ScopedWasmCacheEntryForRead entry(cx);
+    if (!open(cx->global(), key, &entry.serializedSize, &entry.memory, &entry.handle))
+        return nullptr;
+
+    SharedModule module;
+    const uint8_t* cursor = Module::deserialize(entry.memory, &module);
+    if (!cursor || cursor != entry.memory + entry.serializedSize)
+        return nullptr;
+
+    if (module->metadata().assumptions != compileArgs.assumptions)
+        return nullptr;
+
+    const ShareableBytes& cachedBytecode = module->bytecode();
+    if (cachedBytecode.length() != bytecode.length() ||
+        !PodEqual(cachedBytecode.begin(), bytecode.begin(), bytecode.length()))
+    {
+        return nullptr;
+    }
+
+    return module;
+}
+
+static void
+StoreModuleInCache(JSContext* cx, const CompileArgs& compileArgs, const Module& module)
+{
+    // Only store fully optimized code: baseline code is quick to regenerate and
+    // tiered code would never tier up once deserialized.
+    if (compileArgs.alwaysBaseline || compileArgs.tiering)
+        return;
+
+    JS::OpenWasmCacheEntryForWriteOp open = cx->runtime()->wasmCacheOps.openEntryForWrite;
+    if (!open)
+        return;
+
+    SHA1Sum::Hash key;
+    ComputeCacheKey(module.bytecode(), key);
+
+    size_t serializedSize = module.serializedSize();
+
+    uint8_t* memory;
+    intptr_t handle;
+    if (!open(cx->global(), key, serializedSize, &memory, &handle))
+        return;
+
+    DebugOnly<uint8_t*> cursor = module.serialize(memory);
+    MOZ_ASSERT(cursor == memory + serializedSize);
+
+    cx->runtime()->wasmCacheOps.closeEntryForWrite(serializedSize, memory, handle);
+}
+
+// Compile through the embedding's cache, when it has one.
+static SharedModule
+CompileWithCache(JSContext* cx, const ShareableBytes& bytecode, const CompileArgs& compileArgs,
+                 UniqueChars* error)
+{
+    SharedModule module = LookupModuleInCache(cx, bytecode, compileArgs);
+    if (module)
+        return module;
+
+    module = Compile(bytecode, compileArgs, error);
+    if (module)
+        StoreModuleInCache(cx, compileArgs, *module);
+
+    return module;
+}
+
 /* static */ bool
 WasmModuleObject::construct(JSContext* cx, unsigned argc, Value* vp)
 {
@@ -595,7 +718,7 @@ WasmModuleObject::construct(JSContext* cx, unsigned argc, Value* vp)
         return false;
 
     UniqueChars error;
-    SharedModule module = Compile(*bytecode, compileArgs, &error);
+    SharedModule module = CompileWithCache(cx, *bytecode, compileArgs, &error);
     if (!module) {
         if (error) {
             JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_WASM_COMPILE_ERROR,
@@ -685,7 +808,8 @@ WasmInstanceObject::create(JSContext* cx,
                            SharedTableVector&& tables,
                            Handle<FunctionVector> funcImports,
                            const ValVector& globalImports,
-                           HandleObject proto)
+                           HandleObject proto,
+                           Tiering* maybeTiering)
 {
     UniquePtr<WeakExportMap> exports = js::MakeUnique<WeakExportMap>(cx->zone(), ExportMap());
     if (!exports || !exports->init()) {
@@ -710,7 +834,8 @@ WasmInstanceObject::create(JSContext* cx,
                                         memory,
                                         Move(tables),
                                         funcImports,
-                                        globalImports);
+                                        globalImports,
+                                        maybeTiering);
     if (!instance)
         return nullptr;
 
@@ -1502,9 +1627,11 @@ struct CompileTask : PromiseTask
     }
 
     bool finishPromise(JSContext* cx, Handle<PromiseObject*> promise) override {
-        return module
-               ? Resolve(cx, *module, promise)
-               : Reject(cx, compileArgs, Move(error), promise);
+        if (!module)
+            return Reject(cx, compileArgs, Move(error), promise);
+
+        StoreModuleInCache(cx, compileArgs, *module);
+        return Resolve(cx, *module, promise);
     }
 };
 
@@ -1545,6 +1672,14 @@ WebAssembly_compile(JSContext* cx, unsigned argc, Value* vp)
         return true;
     }
 
+    if (SharedModule cached = LookupModuleInCache(cx, *task->bytecode, task->compileArgs)) {
+        if (!Resolve(cx, *cached, promise))
+            return false;
+
+        callArgs.rval().setObject(*promise);
+        return true;
+    }
+
     if (CanUseExtraThreads()) {
         if (!StartPromiseTask(cx, Move(task)))
             return false;
@@ -174,7 +174,8 @@ class WasmInstanceObject : public NativeObject
                                       Vector<RefPtr<wasm::Table>, 0, SystemAllocPolicy>&& tables,
                                       Handle<FunctionVector> funcImports,
                                       const wasm::ValVector& globalImports,
-                                      HandleObject proto);
+                                      HandleObject proto,
+                                      wasm::Tiering* maybeTiering);
     wasm::Instance& instance() const;
 
     static bool getExportedFunction(JSContext* cx,
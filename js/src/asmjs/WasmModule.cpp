@@ -18,10 +18,16 @@
 
 #include "asmjs/WasmModule.h"
 
+#include "mozilla/BinarySearch.h"
+
+#include <algorithm>
+
+#include "asmjs/WasmCompile.h"
 #include "asmjs/WasmInstance.h"
 #include "asmjs/WasmJS.h"
 #include "asmjs/WasmSerialize.h"
 #include "jit/JitOptions.h"
+#include "vm/HelperThreads.h"
 
 #include "jsatominlines.h"
 
@@ -32,6 +38,7 @@ using namespace js;
 using namespace js::jit;
 using namespace js::wasm;
 
+using mozilla::BinarySearch;
 using mozilla::IsNaN;
 
 const char wasm::InstanceExportField[] = "exports";
@@ -257,6 +264,118 @@ ElemSegment::sizeOfExcludingThis(MallocSizeOf mallocSizeOf) const
            elemCodeRangeIndices.sizeOfExcludingThis(mallocSizeOf);
 }
 
+Tiering::Tiering(const ShareableBytes& bytecode, const Metadata& metadata, uint32_t numFuncDefs)
+  : bytecode_(&bytecode),
+    metadata_(&metadata),
+    numFuncDefs_(numFuncDefs),
+    generation_(0),
+    task_(nullptr),
+    failed_(false)
+{}
+
+Tiering::~Tiering()
+{
+    if (task_)
+        CancelOffThreadWasmTierUp(task_);
+}
+
+bool
+Tiering::isTieredUp(uint32_t funcDefIndex) const
+{
+    size_t match;
+    return BinarySearch(ionFuncDefs_, 0, ionFuncDefs_.length(), funcDefIndex, &match);
+}
+
+bool
+Tiering::startTierUp(JSContext* cx, const Uint32Vector& hotFuncDefs)
+{
+    MOZ_ASSERT(canTierUp());
+    MOZ_ASSERT(!hotFuncDefs.empty());
+
+    // Recompiling on the main thread would stall the caller for the whole
+    // module, so only tier up when there are helper threads to do it.
+    if (!CanUseExtraThreads()) {
+        failed_ = true;
+        return true;
+    }
+
+    Uint32Vector ionFuncDefs;
+    if (!ionFuncDefs.appendAll(ionFuncDefs_) || !ionFuncDefs.appendAll(hotFuncDefs)) {
+        ReportOutOfMemory(cx);
+        return false;
+    }
+    std::sort(ionFuncDefs.begin(), ionFuncDefs.end());
+
+    MutableBytes bytecode = cx->new_<ShareableBytes>();
+    if (!bytecode)
+        return false;
+    if (!bytecode->append(bytecode_->begin(), bytecode_->length())) {
+        ReportOutOfMemory(cx);
+        return false;
+    }
+
+    ScriptedCaller scriptedCaller;
+    scriptedCaller.line = scriptedCaller.column = 0;
+    if (metadata_->filename) {
+        scriptedCaller.filename = DuplicateString(cx, metadata_->filename.get());
+        if (!scriptedCaller.filename)
+            return false;
+    }
+
+    Assumptions assumptions;
+    if (!assumptions.clone(metadata_->assumptions)) {
+        ReportOutOfMemory(cx);
+        return false;
+    }
+
+    CompileArgs args(Move(assumptions), Move(scriptedCaller));
+    args.tiering = true;
+    args.ionFuncDefs = Move(ionFuncDefs);
+
+    auto task = cx->make_unique<TierUpTask>(Move(bytecode), Move(args));
+    if (!task)
+        return false;
+
+    if (!StartOffThreadWasmTierUp(task.get())) {
+        ReportOutOfMemory(cx);
+        return false;
+    }
+
+    task_ = task.release();
+    return true;
+}
+
+void
+Tiering::finishTierUp()
+{
+    if (!task_ || !task_->finished())
+        return;
+
+    UniquePtr<TierUpTask> task(task_);
+    task_ = nullptr;
+
+    // A failed recompilation (most likely OOM) leaves the module at its
+    // current tier for good.
+    SharedModule module = task->takeModule();
+    if (!module) {
+        failed_ = true;
+        return;
+    }
+
+    MOZ_RELEASE_ASSERT(module->metadata().entryCountersOffset() ==
+                       metadata_->entryCountersOffset());
+
+    best_ = Move(module);
+    ionFuncDefs_ = Move(task->ionFuncDefs());
+    generation_++;
+}
+
+size_t
+Tiering::sizeOfExcludingThis(MallocSizeOf mallocSizeOf) const
+{
+    return ionFuncDefs_.sizeOfExcludingThis(mallocSizeOf);
+}
+
 size_t
 Module::serializedSize() const
 {
@@ -367,6 +486,12 @@ Module::addSizeOfMisc(MallocSizeOf mallocSizeOf,
              SizeOfVectorExcludingThis(elemSegments_, mallocSizeOf) +
              metadata_->sizeOfIncludingThisIfNotSeen(mallocSizeOf, seenMetadata) +
              bytecode_->sizeOfIncludingThisIfNotSeen(mallocSizeOf, seenBytes);
+
+    if (tiering_) {
+        *data += tiering_->sizeOfExcludingThis(mallocSizeOf);
+        if (const Module* best = tiering_->bestModule())
+            best->addSizeOfMisc(mallocSizeOf, seenMetadata, seenBytes, code, data);
+    }
 }
 
 static uint32_t
@@ -761,6 +886,17 @@ CreateExportObject(JSContext* cx,
     return true;
 }
 
+UniqueCode
+Module::createCode(JSContext* cx, HandleWasmMemoryObject memory,
+                   const ShareableBytes* maybeBytecode) const
+{
+    auto codeSegment = CodeSegment::create(cx, code_, linkData_, *metadata_, memory);
+    if (!codeSegment)
+        return nullptr;
+
+    return cx->make_unique<Code>(Move(codeSegment), *metadata_, maybeBytecode);
+}
+
 bool
 Module::instantiate(JSContext* cx,
                     Handle<FunctionVector> funcImports,
@@ -769,6 +905,29 @@ Module::instantiate(JSContext* cx,
                     const ValVector& globalImports,
                     HandleObject instanceProto,
                     MutableHandleWasmInstanceObject instance) const
+{
+    if (!tiering_) {
+        return instantiateTier(cx, funcImports, tableImport, memoryImport, globalImports,
+                               instanceProto, nullptr, instance);
+    }
+
+    // All tiers are compiled from the same bytecode, so the best one can stand
+    // in for this Module.
+    tiering_->finishTierUp();
+    const Module* tier = tiering_->bestModule() ? tiering_->bestModule() : this;
+    return tier->instantiateTier(cx, funcImports, tableImport, memoryImport, globalImports,
+                                 instanceProto, tiering_, instance);
+}
+
+bool
+Module::instantiateTier(JSContext* cx,
+                        Handle<FunctionVector> funcImports,
+                        HandleWasmTableObject tableImport,
+                        HandleWasmMemoryObject memoryImport,
+                        const ValVector& globalImports,
+                        HandleObject instanceProto,
+                        Tiering* maybeTiering,
+                        MutableHandleWasmInstanceObject instance) const
 {
     if (!instantiateFunctions(cx, funcImports))
         return false;
@@ -793,11 +952,7 @@ Module::instantiate(JSContext* cx,
     if (cx->compartment()->isDebuggee() || !metadata_->funcNames.empty())
         maybeBytecode = bytecode_.get();
 
-    auto codeSegment = CodeSegment::create(cx, code_, linkData_, *metadata_, memory);
-    if (!codeSegment)
-        return false;
-
-    auto code = cx->make_unique<Code>(Move(codeSegment), *metadata_, maybeBytecode);
+    UniqueCode code = createCode(cx, memory, maybeBytecode);
     if (!code)
         return false;
 
@@ -807,7 +962,8 @@ Module::instantiate(JSContext* cx,
                                             Move(tables),
                                             funcImports,
                                             globalImports,
-                                            instanceProto));
+                                            instanceProto,
+                                            maybeTiering));
     if (!instance)
         return false;
 
@@ -163,6 +163,62 @@ struct ElemSegment
 
 typedef Vector<ElemSegment, 0, SystemAllocPolicy> ElemSegmentVector;
 
+class Module;
+class TierUpTask;
+
+// A Tiering is created for a module compiled in tiered mode (see
+// CompileArgs::tiering) and is shared by that Module and all the Instances
+// instantiated from it. Instances report functions whose baseline code has
+// become hot, and Tiering recompiles the module on a helper thread, compiling
+// the hot functions with Ion. The resulting Module, the best tier so far, is
+// used for all subsequent instantiations, and Instances switch their existing
+// code over to it (see Instance::tierUp). At most one recompilation runs at a
+// time and, like Module, a Tiering is only used on its runtime's thread.
+
+class Tiering : public ShareableBase<Tiering>
+{
+    const SharedBytes    bytecode_;
+    const SharedMetadata metadata_;
+    const uint32_t       numFuncDefs_;
+    RefPtr<Module>       best_;
+    Uint32Vector         ionFuncDefs_;
+    uint32_t             generation_;
+    TierUpTask*          task_;
+    bool                 failed_;
+
+  public:
+    // The number of entries after which a baseline function is hot.
+    static const uint32_t HotEntryCount = 10000;
+
+    Tiering(const ShareableBytes& bytecode, const Metadata& metadata, uint32_t numFuncDefs);
+    ~Tiering();
+
+    uint32_t numFuncDefs() const { return numFuncDefs_; }
+
+    // The generation is bumped each time a recompilation finishes. Until the
+    // first one does, there is no best Module other than the original.
+
+    uint32_t generation() const { return generation_; }
+    const Module* bestModule() const { return best_; }
+    bool isTieredUp(uint32_t funcDefIndex) const;
+
+    // Start recompiling with Ion the given functions, sorted by index, in
+    // addition to those already tiered up. Tier-up is skipped, and true
+    // returned, when a recompilation is already running, a previous one has
+    // failed or there are no helper threads.
+
+    bool canTierUp() const { return !task_ && !failed_; }
+    MOZ_MUST_USE bool startTierUp(JSContext* cx, const Uint32Vector& hotFuncDefs);
+
+    // Adopt the result of a finished recompilation, if any.
+
+    void finishTierUp();
+
+    size_t sizeOfExcludingThis(MallocSizeOf mallocSizeOf) const;
+};
+
+typedef RefPtr<Tiering> SharedTiering;
+
 // Module represents a compiled wasm module and primarily provides two
 // operations: instantiation and serialization. A Module can be instantiated any
 // number of times to produce new Instance objects. A Module can be serialized
@@ -185,6 +241,7 @@ class Module : public RefCounted<Module>
     const ElemSegmentVector elemSegments_;
     const SharedMetadata    metadata_;
     const SharedBytes       bytecode_;
+    const SharedTiering     tiering_;
 
     bool instantiateFunctions(JSContext* cx, Handle<FunctionVector> funcImports) const;
     bool instantiateMemory(JSContext* cx, MutableHandleWasmMemoryObject memory) const;
@@ -196,6 +253,14 @@ class Module : public RefCounted<Module>
                       Handle<FunctionVector> funcImports,
                       HandleWasmMemoryObject memory,
                       const ValVector& globalImports) const;
+    bool instantiateTier(JSContext* cx,
+                         Handle<FunctionVector> funcImports,
+                         HandleWasmTableObject tableImport,
+                         HandleWasmMemoryObject memoryImport,
+                         const ValVector& globalImports,
+                         HandleObject instanceProto,
+                         Tiering* maybeTiering,
+                         MutableHandleWasmInstanceObject instanceObj) const;
 
   public:
     Module(Bytes&& code,
@@ -205,7 +270,8 @@ class Module : public RefCounted<Module>
            DataSegmentVector&& dataSegments,
            ElemSegmentVector&& elemSegments,
            const Metadata& metadata,
-           const ShareableBytes& bytecode)
+           const ShareableBytes& bytecode,
+           Tiering* maybeTiering = nullptr)
       : code_(Move(code)),
         linkData_(Move(linkData)),
         imports_(Move(imports)),
@@ -213,11 +279,18 @@ class Module : public RefCounted<Module>
         dataSegments_(Move(dataSegments)),
         elemSegments_(Move(elemSegments)),
         metadata_(&metadata),
-        bytecode_(&bytecode)
+        bytecode_(&bytecode),
+        tiering_(maybeTiering)
     {}
 
     const Metadata& metadata() const { return *metadata_; }
     const ImportVector& imports() const { return imports_; }
+    const ShareableBytes& bytecode() const { return *bytecode_; }
+
+    // Link a new copy of this module's code, specialized to the given memory.
+
+    UniqueCode createCode(JSContext* cx, HandleWasmMemoryObject memory,
+                          const ShareableBytes* maybeBytecode) const;
 
     // Instantiate this module with the given imports:
 
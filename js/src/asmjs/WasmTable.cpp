@@ -119,6 +119,7 @@ Table::set(uint32_t index, void* code, Instance& instance)
 
         elem.code = code;
         elem.tls = &instance.tlsData();
+        instance.noteTableElem(*this);
 
         //MOZ_ASSERT(elem.tls->instance->objectUnbarriered()->isTenured(), "no writeBarrierPost");
     } else {
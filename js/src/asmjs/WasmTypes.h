@@ -89,6 +89,7 @@ class Memory;
 class Module;
 class Instance;
 class Table;
+class Tiering;
 
 // To call Vector::podResizeToFit, a type must specialize mozilla::IsPod
 // which is pretty verbose to do within js::wasm, so factor that process out
@@ -1340,7 +1341,22 @@ WASM_DECLARE_POD_VECTOR(BoundsCheck, BoundsCheckVector)
 
 static const unsigned NaN64GlobalDataOffset       = 0;
 static const unsigned NaN32GlobalDataOffset       = NaN64GlobalDataOffset + sizeof(double);
+#ifdef JS_CODEGEN_X64
+// On x64, code loads SymbolicAddresses rip-relative from a table in global
+// data instead of having them patched into the code when it is linked.
+static const unsigned SymbolicAddressTableOffset  = NaN32GlobalDataOffset + sizeof(double);
+static const unsigned InitialGlobalDataBytes      = SymbolicAddressTableOffset +
+                                                    unsigned(SymbolicAddress::Limit) * sizeof(void*);
+static_assert(SymbolicAddressTableOffset % sizeof(void*) == 0, "table is aligned");
+
+static inline unsigned
+SymbolicAddressGlobalDataOffset(SymbolicAddress imm)
+{
+    return SymbolicAddressTableOffset + unsigned(imm) * sizeof(void*);
+}
+#else
 static const unsigned InitialGlobalDataBytes      = NaN32GlobalDataOffset + sizeof(float);
+#endif
 
 static const unsigned MaxSigs                     =        4 * 1024;
 static const unsigned MaxFuncs                    =      512 * 1024;
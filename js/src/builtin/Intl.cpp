@@ -11,6 +11,7 @@
 
 #include "builtin/Intl.h"
 
+#include "mozilla/PodOperations.h"
 #include "mozilla/Range.h"
 #include "mozilla/ScopeExit.h"
 
@@ -273,6 +274,12 @@ unum_close(UNumberFormat* fmt)
     MOZ_CRASH("unum_close: Intl API disabled");
 }
 
+static UNumberFormat*
+unum_clone(const UNumberFormat* fmt, UErrorCode* status)
+{
+    MOZ_CRASH("unum_clone: Intl API disabled");
+}
+
 static void
 unum_setTextAttribute(UNumberFormat* fmt, UNumberFormatTextAttribute tag, const UChar* newValue,
                       int32_t newValueLength, UErrorCode* status)
@@ -520,6 +527,12 @@ udat_close(UDateFormat* format)
     MOZ_CRASH("udat_close: Intl API disabled");
 }
 
+static UDateFormat*
+udat_clone(const UDateFormat* fmt, UErrorCode* status)
+{
+    MOZ_CRASH("udat_clone: Intl API disabled");
+}
+
 #endif
 
 
@@ -1165,6 +1178,110 @@ js::intl_CompareStrings(JSContext* cx, unsigned argc, Value* vp)
 }
 
 
+/******************** IntlFormatterCache ********************/
+
+static void*
+CloneFormatter(IntlFormatterCache::Kind kind, const void* formatter)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    void* clone;
+    if (kind == IntlFormatterCache::Kind::DateTime)
+        clone = udat_clone(static_cast<const UDateFormat*>(formatter), &status);
+    else
+        clone = unum_clone(static_cast<const UNumberFormat*>(formatter), &status);
+    if (U_FAILURE(status))
+        return nullptr;
+    return clone;
+}
+
+static void
+CloseFormatter(IntlFormatterCache::Kind kind, void* formatter)
+{
+    if (kind == IntlFormatterCache::Kind::DateTime)
+        udat_close(static_cast<UDateFormat*>(formatter));
+    else
+        unum_close(static_cast<UNumberFormat*>(formatter));
+}
+
+void*
+IntlFormatterCache::lookupClone(Kind kind, const Key& key)
+{
+    for (size_t i = 0; i < entries_.length(); i++) {
+        Entry& entry = entries_[i];
+        if (entry.kind != kind || entry.key.length() != key.length() ||
+            !mozilla::PodEqual(entry.key.begin(), key.begin(), key.length()))
+        {
+            continue;
+        }
+
+        void* clone = CloneFormatter(kind, entry.formatter);
+
+        // Move the entry to the front. This can't fail, as the vector
+        // doesn't grow.
+        if (i > 0) {
+            Entry hit = mozilla::Move(entry);
+            entries_.erase(&entry);
+            MOZ_ALWAYS_TRUE(entries_.insert(entries_.begin(), mozilla::Move(hit)));
+        }
+        return clone;
+    }
+    return nullptr;
+}
+
+void
+IntlFormatterCache::add(Kind kind, Key&& key, const void* formatter)
+{
+    void* clone = CloneFormatter(kind, formatter);
+    if (!clone)
+        return;
+
+    if (entries_.length() == Capacity) {
+        CloseFormatter(entries_.back().kind, entries_.back().formatter);
+        entries_.popBack();
+    }
+
+    Entry entry = { kind, mozilla::Move(key), clone };
+    if (!entries_.insert(entries_.begin(), mozilla::Move(entry)))
+        CloseFormatter(kind, clone);
+}
+
+void
+IntlFormatterCache::purge()
+{
+    for (Entry& entry : entries_)
+        CloseFormatter(entry.kind, entry.formatter);
+    entries_.clear();
+}
+
+static MOZ_MUST_USE bool
+AppendToFormatterCacheKey(IntlFormatterCache::Key& key, const char* str)
+{
+    // Separate the key's components, so that different combinations can't
+    // produce the same key.
+    for (; *str; str++) {
+        if (!key.append(char16_t(static_cast<unsigned char>(*str))))
+            return false;
+    }
+    return key.append(char16_t(0));
+}
+
+static MOZ_MUST_USE bool
+AppendToFormatterCacheKey(IntlFormatterCache::Key& key, const UChar* str, size_t length)
+{
+    return key.append(reinterpret_cast<const char16_t*>(str), length) && key.append(char16_t(0));
+}
+
+template <typename T>
+static MOZ_MUST_USE bool
+AppendToFormatterCacheKey(IntlFormatterCache::Key& key, T value)
+{
+    static_assert(sizeof(T) % sizeof(char16_t) == 0, "must append whole chars");
+    char16_t chars[sizeof(T) / sizeof(char16_t)];
+    memcpy(chars, &value, sizeof(T));
+    return key.append(chars, sizeof(T) / sizeof(char16_t));
+}
+
+
 /******************** NumberFormat ********************/
 
 static void numberFormat_finalize(FreeOp* fop, JSObject* obj);
@@ -1524,6 +1641,27 @@ NewUNumberFormat(JSContext* cx, HandleObject numberFormat)
         return nullptr;
     uUseGrouping = value.toBoolean();
 
+    // The cache key covers everything passed to ICU below.
+    IntlFormatterCache& cache = cx->runtime()->intlFormatterCache;
+    IntlFormatterCache::Key key;
+    if (!AppendToFormatterCacheKey(key, locale.ptr()) ||
+        !AppendToFormatterCacheKey(key, int32_t(uStyle)) ||
+        !(uCurrency
+          ? AppendToFormatterCacheKey(key, uCurrency, 3)
+          : key.append(char16_t(0))) ||
+        !AppendToFormatterCacheKey(key, uMinimumIntegerDigits) ||
+        !AppendToFormatterCacheKey(key, uMinimumFractionDigits) ||
+        !AppendToFormatterCacheKey(key, uMaximumFractionDigits) ||
+        !AppendToFormatterCacheKey(key, uMinimumSignificantDigits) ||
+        !AppendToFormatterCacheKey(key, uMaximumSignificantDigits) ||
+        !AppendToFormatterCacheKey(key, int32_t(uUseGrouping)))
+    {
+        ReportOutOfMemory(cx);
+        return nullptr;
+    }
+    if (void* cached = cache.lookupClone(IntlFormatterCache::Kind::Number, key))
+        return static_cast<UNumberFormat*>(cached);
+
     UErrorCode status = U_ZERO_ERROR;
     UNumberFormat* nf = unum_open(uStyle, nullptr, 0, icuLocale(locale.ptr()), nullptr, &status);
     if (U_FAILURE(status)) {
@@ -1551,6 +1689,8 @@ NewUNumberFormat(JSContext* cx, HandleObject numberFormat)
     unum_setAttribute(nf, UNUM_GROUPING_USED, uUseGrouping);
     unum_setAttribute(nf, UNUM_ROUNDING_MODE, UNUM_ROUND_HALFUP);
 
+    cache.add(IntlFormatterCache::Kind::Number, mozilla::Move(key), nf);
+
     return toClose.forget();
 }
 
@@ -2058,6 +2198,24 @@ NewUDateFormat(JSContext* cx, HandleObject dateTimeFormat)
         js::ResyncICUDefaultTimeZone();
     }
 
+    // The cache key covers everything passed to ICU below. Formatters using
+    // the default time zone are keyed by the local time zone adjustment, so
+    // they aren't reused after a time zone change (as in Date.js's
+    // GetCachedFormat).
+    IntlFormatterCache& cache = cx->runtime()->intlFormatterCache;
+    IntlFormatterCache::Key key;
+    if (!AppendToFormatterCacheKey(key, locale.ptr()) ||
+        !AppendToFormatterCacheKey(key, uPattern, uPatternLength) ||
+        !(uTimeZone
+          ? AppendToFormatterCacheKey(key, uTimeZone, uTimeZoneLength)
+          : AppendToFormatterCacheKey(key, DateTimeInfo::localTZA())))
+    {
+        ReportOutOfMemory(cx);
+        return nullptr;
+    }
+    if (void* cached = cache.lookupClone(IntlFormatterCache::Kind::DateTime, key))
+        return static_cast<UDateFormat*>(cached);
+
     // If building with ICU headers before 50.1, use UDAT_IGNORE instead of
     // UDAT_PATTERN.
     UDateFormat* df =
@@ -2075,6 +2233,8 @@ NewUDateFormat(JSContext* cx, HandleObject dateTimeFormat)
 
     // An error here means the calendar is not Gregorian, so we don't care.
 
+    cache.add(IntlFormatterCache::Kind::DateTime, mozilla::Move(key), df);
+
     return df;
 }
 
@@ -7,7 +7,11 @@
 #ifndef builtin_Intl_h
 #define builtin_Intl_h
 
+#include "jsalloc.h"
 #include "NamespaceImports.h"
+
+#include "js/Vector.h"
+
 #if ENABLE_INTL_API
 #include "unicode/utypes.h"
 #endif
@@ -26,6 +30,53 @@ namespace js {
 extern JSObject*
 InitIntlClass(JSContext* cx, HandleObject obj);
 
+/**
+ * A per-runtime cache of the most recently created ICU date and number
+ * formatters, keyed by everything the formatters were created from. Creating
+ * an ICU formatter is far more expensive than cloning one, so Intl objects
+ * (including the ones created by the toLocale*String builtins) with the same
+ * resolved locale and options get clones of a cached formatter.
+ *
+ * The cache owns its formatters; callers own the clones it hands out and
+ * close them as usual.
+ */
+class IntlFormatterCache
+{
+  public:
+    typedef Vector<char16_t, 64, SystemAllocPolicy> Key;
+
+    enum class Kind : uint8_t {
+        DateTime,
+        Number
+    };
+
+    IntlFormatterCache() {}
+    ~IntlFormatterCache() { purge(); }
+
+    // Returns a clone of the formatter cached for |kind| and |key|, or
+    // nullptr if there is none (or cloning it failed).
+    void* lookupClone(Kind kind, const Key& key);
+
+    // Caches a clone of |formatter|, evicting the least recently used entry
+    // if the cache is full. Failure to do so is silently ignored.
+    void add(Kind kind, Key&& key, const void* formatter);
+
+    void purge();
+
+  private:
+    static const size_t Capacity = 8;
+
+    struct Entry
+    {
+        Kind kind;
+        Key key;
+        void* formatter;
+    };
+
+    // Ordered from the most to the least recently used.
+    Vector<Entry, Capacity, SystemAllocPolicy> entries_;
+};
+
 /*
  * The following functions are for use by self-hosted code.
  */
@@ -55,8 +55,8 @@ TriggerPromiseReactions(JSContext* cx, HandleValue reactionsVal, JS::PromiseStat
     // Each reaction is an internally-created object with the structure:
     // {
     //   promise: [the promise this reaction resolves],
-    //   resolve: [the `resolve` callback content code provided],
-    //   reject:  [the `reject` callback content code provided],
+    //   resolve: [the `resolve` callback content code provided, or null]
+    //   reject:  [the `reject` callback content code provided, or null]
     //   fulfillHandler: [the internal handler that fulfills the promise]
     //   rejectHandler: [the internal handler that rejects the promise]
     //   incumbentGlobal: [an object from the global that was incumbent when
@@ -95,15 +95,17 @@ TriggerPromiseReactions(JSContext* cx, HandleValue reactionsVal, JS::PromiseStat
         }
 #endif
 
+        // The resolve and reject hooks are null if the reaction's promise
+        // has default resolving functions.
         if (!GetProperty(cx, reaction, reaction, cx->names().resolve, &val))
             return false;
-        resolve = &val.toObject();
-        MOZ_ASSERT(IsCallable(resolve));
+        resolve = val.toObjectOrNull();
+        MOZ_ASSERT_IF(resolve, IsCallable(resolve));
 
         if (!GetProperty(cx, reaction, reaction, cx->names().reject, &val))
             return false;
-        reject = &val.toObject();
-        MOZ_ASSERT(IsCallable(reject));
+        reject = val.toObjectOrNull();
+        MOZ_ASSERT_IF(reject, IsCallable(reject));
 
         if (!GetProperty(cx, reaction, reaction, cx->names().incumbentGlobal, &val))
             return false;
@@ -360,6 +362,81 @@ ResolvePromiseFunction(JSContext* cx, unsigned argc, Value* vp)
     return status;
 }
 
+/**
+ * Promises created by PromiseObject::createSkippingExecutor don't have
+ * resolving functions. Instead, the "already resolved" record those would
+ * share is kept in the Promise's flags, and the functions below implement
+ * their steps directly.
+ *
+ * Returns false and reports an error if |promiseObj| is a dead wrapper.
+ * Otherwise, sets |alreadyResolved| to the previous state of the record
+ * and marks the Promise as resolved.
+ */
+static MOZ_MUST_USE bool
+SetDefaultResolvingFunctionsAlreadyResolved(JSContext* cx, HandleObject promiseObj,
+                                            bool* alreadyResolved)
+{
+    if (IsProxy(promiseObj) && JS_IsDeadWrapper(promiseObj)) {
+        JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_DEAD_OBJECT);
+        return false;
+    }
+
+    PromiseObject* promise = &UncheckedUnwrap(promiseObj)->as<PromiseObject>();
+    MOZ_ASSERT(promise->hasDefaultResolvingFunctions());
+
+    int32_t flags = promise->getFixedSlot(PROMISE_FLAGS_SLOT).toInt32();
+    *alreadyResolved = flags & PROMISE_FLAG_DEFAULT_RESOLVING_FUNCTIONS_ALREADY_RESOLVED;
+    flags |= PROMISE_FLAG_DEFAULT_RESOLVING_FUNCTIONS_ALREADY_RESOLVED;
+    promise->setFixedSlot(PROMISE_FLAGS_SLOT, Int32Value(flags));
+    return true;
+}
+
+// ES2016, 25.4.1.3.2, for Promises without resolving functions.
+static MOZ_MUST_USE bool
+ResolveWithDefaultResolvingFunctions(JSContext* cx, HandleObject promise,
+                                     HandleValue resolutionVal)
+{
+    // Steps 1-5.
+    bool alreadyResolved;
+    if (!SetDefaultResolvingFunctionsAlreadyResolved(cx, promise, &alreadyResolved))
+        return false;
+    if (alreadyResolved)
+        return true;
+
+    // Step 6.
+    if (resolutionVal.isObject() &&
+        UncheckedUnwrap(&resolutionVal.toObject()) == UncheckedUnwrap(promise))
+    {
+        // Step 6.a.
+        JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
+                                  JSMSG_CANNOT_RESOLVE_PROMISE_WITH_ITSELF);
+        RootedValue selfResolutionError(cx);
+        bool status = GetAndClearException(cx, &selfResolutionError);
+        MOZ_ASSERT(status);
+
+        // Step 6.b.
+        return RejectMaybeWrappedPromise(cx, promise, selfResolutionError);
+    }
+
+    // Steps 7-13.
+    return ResolvePromiseInternal(cx, promise, resolutionVal);
+}
+
+// ES2016, 25.4.1.3.1, for Promises without resolving functions.
+static MOZ_MUST_USE bool
+RejectWithDefaultResolvingFunctions(JSContext* cx, HandleObject promise, HandleValue reasonVal)
+{
+    // Steps 1-5.
+    bool alreadyResolved;
+    if (!SetDefaultResolvingFunctionsAlreadyResolved(cx, promise, &alreadyResolved))
+        return false;
+    if (alreadyResolved)
+        return true;
+
+    // Step 6.
+    return RejectMaybeWrappedPromise(cx, promise, reasonVal);
+}
+
 // ES2016, 25.4.1.3.
 static MOZ_MUST_USE bool
 CreateResolvingFunctions(JSContext* cx, HandleValue promise,
@@ -436,6 +513,21 @@ CreatePromiseObjectInternal(JSContext* cx, HandleObject proto, bool protoIsWrapp
     return promise;
 }
 
+/* static */ PromiseObject*
+PromiseObject::createSkippingExecutor(JSContext* cx)
+{
+    Rooted<PromiseObject*> promise(cx, CreatePromiseObjectInternal(cx, nullptr, false));
+    if (!promise)
+        return nullptr;
+
+    promise->setFixedSlot(PROMISE_FLAGS_SLOT, Int32Value(PROMISE_FLAG_DEFAULT_RESOLVING_FUNCTIONS));
+
+    // Let the Debugger know about this Promise.
+    JS::dbg::onNewPromise(cx, promise);
+
+    return promise;
+}
+
 /**
  * Unforgeable version of ES2016, 25.4.4.4, Promise.reject.
  */
@@ -951,6 +1043,11 @@ PromiseObject::resolve(JSContext* cx, HandleValue resolutionValue)
     if (state() != JS::PromiseState::Pending)
         return true;
 
+    if (hasDefaultResolvingFunctions()) {
+        RootedObject promise(cx, this);
+        return ResolveWithDefaultResolvingFunctions(cx, promise, resolutionValue);
+    }
+
     RootedValue funVal(cx, this->getReservedSlot(PROMISE_RESOLVE_FUNCTION_SLOT));
     // TODO: ensure that this holds for xray'd promises. (It probably doesn't)
     MOZ_ASSERT(funVal.toObject().is<JSFunction>());
@@ -969,6 +1066,11 @@ PromiseObject::reject(JSContext* cx, HandleValue rejectionValue)
     if (state() != JS::PromiseState::Pending)
         return true;
 
+    if (hasDefaultResolvingFunctions()) {
+        RootedObject promise(cx, this);
+        return RejectWithDefaultResolvingFunctions(cx, promise, rejectionValue);
+    }
+
     RootedValue resolveVal(cx, this->getReservedSlot(PROMISE_RESOLVE_FUNCTION_SLOT));
     RootedFunction resolve(cx, &resolveVal.toObject().as<JSFunction>());
     RootedValue funVal(cx, resolve->getExtendedSlot(ResolutionFunctionSlot_OtherFunction));
@@ -1011,6 +1113,7 @@ enum ReactionJobDataSlots {
     ReactionJobDataSlot_HandlerArg = 0,
     ReactionJobDataSlot_ResolveHook,
     ReactionJobDataSlot_RejectHook,
+    ReactionJobDataSlot_Promise,
     ReactionJobDataSlotsCount,
 };
 
@@ -1047,6 +1150,10 @@ enum ReactionJobDataSlots {
  *                                  handler is PROMISE_HANDLER_THROWER or if
  *                                  execution of a callable handler aborts
  *                                  abnormally.
+ *     ReactionJobDataSlot_Promise: The Promise to resolve directly if the
+ *                                  hooks are null, because the Promise has
+ *                                  default resolving functions. Undefined
+ *                                  otherwise.
  */
 static bool
 PromiseReactionJob(JSContext* cx, unsigned argc, Value* vp)
@@ -1114,6 +1221,16 @@ PromiseReactionJob(JSContext* cx, unsigned argc, Value* vp)
     size_t hookSlot = shouldReject
                       ? ReactionJobDataSlot_RejectHook
                       : ReactionJobDataSlot_ResolveHook;
+    if (jobData->getDenseElement(hookSlot).isNull()) {
+        // The Promise was created without resolving functions, so resolve it
+        // directly instead of calling them.
+        RootedObject promise(cx, &jobData->getDenseElement(ReactionJobDataSlot_Promise).toObject());
+        bool result = shouldReject
+                      ? RejectWithDefaultResolvingFunctions(cx, promise, handlerResult)
+                      : ResolveWithDefaultResolvingFunctions(cx, promise, handlerResult);
+        args.rval().setUndefined();
+        return result;
+    }
     RootedObject callee(cx, &jobData->getDenseElement(hookSlot).toObject());
 
     FixedInvokeArgs<1> args2(cx);
@@ -1144,10 +1261,20 @@ EnqueuePromiseReactionJob(JSContext* cx, HandleValue handler_, HandleValue handl
     data->setDenseElement(ReactionJobDataSlot_HandlerArg, handlerArg);
 
     // Store the resolve hook.
-    data->setDenseElement(ReactionJobDataSlot_ResolveHook, ObjectValue(*resolve));
+    data->setDenseElement(ReactionJobDataSlot_ResolveHook, ObjectOrNullValue(resolve));
 
     // Store the reject hook.
-    data->setDenseElement(ReactionJobDataSlot_RejectHook, ObjectValue(*reject));
+    data->setDenseElement(ReactionJobDataSlot_RejectHook, ObjectOrNullValue(reject));
+
+    // Without hooks, the job resolves the Promise itself.
+    MOZ_ASSERT(!resolve == !reject);
+    if (resolve) {
+        data->setDenseElement(ReactionJobDataSlot_Promise, UndefinedValue());
+    } else {
+        MOZ_ASSERT(promise_ && promise_->is<PromiseObject>());
+        MOZ_ASSERT(promise_->as<PromiseObject>().hasDefaultResolvingFunctions());
+        data->setDenseElement(ReactionJobDataSlot_Promise, ObjectValue(*promise_));
+    }
 
     RootedValue dataVal(cx, ObjectValue(*data));
 
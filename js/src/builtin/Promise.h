@@ -23,6 +23,12 @@ class PromiseObject : public NativeObject
     static PromiseObject* create(JSContext* cx, HandleObject executor,
                                  HandleObject proto = nullptr);
 
+    // Creates a Promise with the current global's Promise.prototype that
+    // doesn't get resolving functions. Such a Promise can only be resolved by
+    // the engine, through PromiseObject::resolve/reject or by a reaction job
+    // without resolve/reject hooks.
+    static PromiseObject* createSkippingExecutor(JSContext* cx);
+
     static JSObject* unforgeableResolve(JSContext* cx, HandleValue value);
     static JSObject* unforgeableReject(JSContext* cx, HandleValue value);
 
@@ -50,6 +56,11 @@ class PromiseObject : public NativeObject
 
     void onSettled(JSContext* cx);
 
+    bool hasDefaultResolvingFunctions() {
+        return getFixedSlot(PROMISE_FLAGS_SLOT).toInt32() &
+               PROMISE_FLAG_DEFAULT_RESOLVING_FUNCTIONS;
+    }
+
     double allocationTime() { return getFixedSlot(PROMISE_ALLOCATION_TIME_SLOT).toNumber(); }
     double resolutionTime() { return getFixedSlot(PROMISE_RESOLUTION_TIME_SLOT).toNumber(); }
     JSObject* allocationSite() {
@@ -82,9 +93,10 @@ class PromiseObject : public NativeObject
  * reaction handler - The callback to invoke for this job.
    argument - The first and only argument to pass to the handler.
    resolve - The Promise cabability's resolve hook, called upon normal
-             completion of the handler.
+             completion of the handler. Null if |promise| has default
+             resolving functions, in which case it's resolved directly.
    reject -  The Promise cabability's reject hook, called if the handler
-             throws.
+             throws. Null iff |resolve| is null.
    promise - The associated Promise, or null for some internal uses.
    objectFromIncumbentGlobal - An object from the global that was the
                                incumbent global when the Promise reaction job
@@ -530,7 +530,22 @@ function Promise_then(onFulfilled, onRejected) {
     let C = SpeciesConstructor(promise, GetBuiltinConstructor('Promise'));
 
     // Steps 5-6.
-    let resultCapability = NewPromiseCapability(C);
+    // If the result is created by the original Promise constructor, content
+    // can't observe its resolving functions. Skip creating them, along with
+    // the capabilities executor, and let the reaction job resolve the result
+    // directly. Wrapped promises need real functions to call across
+    // compartments, see UnwrappedPerformPromiseThen.
+    let resultCapability;
+    if (C === GetBuiltinConstructor('Promise') && !isWrappedPromise) {
+        resultCapability = {
+            __proto__: PromiseCapabilityRecordProto,
+            promise: CreatePromiseSkippingExecutor(),
+            resolve: null,
+            reject: null
+        };
+    } else {
+        resultCapability = NewPromiseCapability(C);
+    }
 
     // Step 7.
     if (isWrappedPromise) {
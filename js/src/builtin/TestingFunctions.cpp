@@ -346,6 +346,43 @@ MinorGC(JSContext* cx, unsigned argc, Value* vp)
     return true;
 }
 
+static bool
+FrequentObjects(JSContext* cx, unsigned argc, Value* vp)
+{
+    CallArgs args = CallArgsFromVp(argc, vp);
+
+    // Copied first, as allocating below may collect and replace them.
+    Vector<gc::GCRuntime::FrequentObjectsEntry, 0, SystemAllocPolicy> entries;
+    if (!entries.appendAll(cx->runtime()->gc.frequentObjects)) {
+        ReportOutOfMemory(cx);
+        return false;
+    }
+
+    RootedObject array(cx, NewDenseEmptyArray(cx));
+    if (!array)
+        return false;
+
+    RootedObject entry(cx);
+    RootedString name(cx);
+    for (size_t i = 0; i < entries.length(); i++) {
+        entry = JS_NewPlainObject(cx);
+        if (!entry)
+            return false;
+        name = JS_NewStringCopyZ(cx, entries[i].name);
+        if (!name)
+            return false;
+        if (!JS_DefineProperty(cx, entry, "name", name, JSPROP_ENUMERATE) ||
+            !JS_DefineProperty(cx, entry, "bytes", double(entries[i].bytes), JSPROP_ENUMERATE) ||
+            !JS_DefineElement(cx, array, i, entry, JSPROP_ENUMERATE))
+        {
+            return false;
+        }
+    }
+
+    args.rval().setObject(*array);
+    return true;
+}
+
 #define FOR_EACH_GC_PARAM(_)                                                    \
     _("maxBytes",                   JSGC_MAX_BYTES,                      true)  \
     _("maxMallocBytes",             JSGC_MAX_MALLOC_BYTES,               true)  \
@@ -368,7 +405,9 @@ MinorGC(JSContext* cx, unsigned argc, Value* vp)
     _("minEmptyChunkCount",         JSGC_MIN_EMPTY_CHUNK_COUNT,          true)  \
     _("maxEmptyChunkCount",         JSGC_MAX_EMPTY_CHUNK_COUNT,          true)  \
     _("compactingEnabled",          JSGC_COMPACTING_ENABLED,             true)  \
-    _("refreshFrameSlicesEnabled",  JSGC_REFRESH_FRAME_SLICES_ENABLED,   true)
+    _("refreshFrameSlicesEnabled",  JSGC_REFRESH_FRAME_SLICES_ENABLED,   true)  \
+    _("concurrentMarkEnabled",      JSGC_CONCURRENT_MARK_ENABLED,        true)  \
+    _("frequentObjectsEnabled",     JSGC_FREQUENT_OBJECTS_ENABLED,       true)
 
 static const struct ParamInfo {
     const char*     name;
@@ -3564,6 +3603,12 @@ static const JSFunctionSpecWithHelp TestingFunctions[] = {
 "gcparam(name [, value])",
 "  Wrapper for JS_[GS]etGCParameter. The name is one of:" GC_PARAMETER_ARGS_LIST),
 
+    JS_FN_HELP("frequentObjects", FrequentObjects, 0, 0,
+"frequentObjects()",
+"  Return the classes and alloc kinds of the cells holding the most live bytes\n"
+"  at the last global GC, as an array of {name, bytes} objects with the\n"
+"  largest first. Empty unless gcparam('frequentObjectsEnabled', 1) was set."),
+
     JS_FN_HELP("relazifyFunctions", RelazifyFunctions, 0, 0,
 "relazifyFunctions(...)",
 "  Perform a GC and allow relazification of functions. Accepts the same\n"
@@ -1051,6 +1051,10 @@ function TypedArraySort(comparefn) {
     }
 
     if (comparefn === undefined) {
+        // Numeric sorts of unshared typed arrays are radix sorted natively.
+        if (isTypedArray && TypedArrayNativeSort(obj))
+            return obj;
+
         comparefn = TypedArrayCompare;
         // CountingSort doesn't invoke the comparefn
         if (IsUint8TypedArray(obj)) {
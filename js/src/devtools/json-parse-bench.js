@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Measures JSON.parse throughput in the shell:
+//
+//   js devtools/json-parse-bench.js [iterations]
+//
+// Each input exercises one of the parser's scanning loops: long strings
+// without escapes, strings with escapes, deeply indented whitespace and
+// runs of numbers. Latin-1 and two-byte versions of each are parsed.
+
+var iterations = scriptArgs.length ? parseInt(scriptArgs[0], 10) : 20;
+var targetLength = 4 * 1024 * 1024;
+
+function repeat(make) {
+    var parts = [];
+    var length = 0;
+    for (var i = 0; length < targetLength; i++) {
+        var part = make(i);
+        parts.push(part);
+        length += part.length + 1;
+    }
+    return "[" + parts.join(",") + "]";
+}
+
+var inputs = {
+    "plain strings": repeat(i => JSON.stringify("lorem ipsum dolor sit amet " + i + " ".repeat(64))),
+    "escaped strings": repeat(i => JSON.stringify("line\t" + i + "\n\"quoted\"\\path\\" + i)),
+    "whitespace": repeat(i => '\n        {\n            "key" :   ' + i + '\n        }'),
+    "integers": repeat(i => String(i * 7919)),
+    "doubles": repeat(i => String(i * 1.0001) + "e-3"),
+    "objects": repeat(i => JSON.stringify({ id: i, name: "item" + i, tags: ["a", "b"], ok: true })),
+};
+
+function bench(name, text) {
+    // Warm up, then time whole iterations.
+    JSON.parse(text);
+    var start = dateNow();
+    for (var i = 0; i < iterations; i++)
+        JSON.parse(text);
+    var ms = dateNow() - start;
+    var bytes = text.length * iterations;
+    print(name + ": " + (bytes / (1024 * 1024) / (ms / 1000)).toFixed(1) + " MB/s");
+}
+
+for (var name in inputs) {
+    bench(name + " (latin1)", inputs[name]);
+    bench(name + " (two-byte)", inputs[name].replace("[", "[\"☃\","));
+}
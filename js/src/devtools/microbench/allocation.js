@@ -0,0 +1,30 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Short-lived object, array and string allocation; the reported GC counts
+// show how often each one collects.
+
+function objects() {
+    var last;
+    for (var i = 0; i < 10000; i++)
+        last = { a: i, b: i + 1 };
+    return last;
+}
+
+function arrays() {
+    var last;
+    for (var i = 0; i < 1000; i++)
+        last = [i, i, i, i, i, i, i, i];
+    return last;
+}
+
+function strings() {
+    var s = "";
+    for (var i = 0; i < 1000; i++)
+        s = "item" + i + s.length;
+    return s;
+}
+
+benchmarks = { objects, arrays, strings };
+options = { inner: 10 };
@@ -0,0 +1,32 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Scripted, native and closure calls.
+
+function add(a, b) { return a + b; }
+
+function scripted() {
+    var x = 0;
+    for (var i = 0; i < 10000; i++)
+        x = add(x, i);
+    return x;
+}
+
+function native() {
+    var x = 0;
+    for (var i = 0; i < 10000; i++)
+        x += Math.abs(i - 5000);
+    return x;
+}
+
+function closures() {
+    var x = 0;
+    var inc = n => { x += n; };
+    for (var i = 0; i < 10000; i++)
+        inc(i);
+    return x;
+}
+
+benchmarks = { scripted, native, closures };
+options = { inner: 10 };
@@ -0,0 +1,64 @@
+#!/usr/bin/env python
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+"""Compare two microbenchmark runs produced by run.js.
+
+    python compare.py base.json new.json
+
+A benchmark is reported as changed only when the difference between the two
+medians exceeds three times the larger of the two median absolute deviations,
+so that run-to-run noise is not mistaken for a regression. Changes in the
+engine counters are listed alongside, since a slowdown that comes with extra
+bailouts or GCs usually has a different cause than one that does not.
+"""
+
+from __future__ import print_function
+
+import json
+import sys
+
+COUNTERS = ('gcs', 'baselineCompiles', 'ionCompiles', 'bailouts', 'icStubs')
+
+
+def compare(base, new):
+    changed = False
+    for name in sorted(set(base) | set(new)):
+        if name not in base or name not in new:
+            print('{:40} only in {}'.format(name, 'base' if name in base else 'new'))
+            continue
+
+        b, n = base[name], new[name]
+        bmedian, nmedian = b['time']['median'], n['time']['median']
+        noise = 3 * max(b['time']['mad'], n['time']['mad'])
+        delta = nmedian - bmedian
+        ratio = nmedian / bmedian if bmedian else float('inf')
+
+        if abs(delta) <= noise:
+            verdict = ''
+        else:
+            verdict = 'slower' if delta > 0 else 'faster'
+            changed = True
+
+        counters = ['{} {}->{}'.format(c, b['counters'][c], n['counters'][c])
+                    for c in COUNTERS if b['counters'][c] != n['counters'][c]]
+
+        print('{:40} {:10.4f} {:10.4f} {:6.2f}x {:7} {}'.format(
+            name, bmedian, nmedian, ratio, verdict, ', '.join(counters)))
+    return changed
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(__doc__, file=sys.stderr)
+        return 2
+    with open(argv[1]) as f:
+        base = json.load(f)
+    with open(argv[2]) as f:
+        new = json.load(f)
+    return 1 if compare(base, new) else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,30 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Monomorphic and polymorphic property reads, which stress the Baseline and
+// Ion property ICs.
+
+function Point(x, y) { this.x = x; this.y = y; }
+
+var monomorphic = [];
+var polymorphic = [];
+for (var i = 0; i < 1000; i++) {
+    monomorphic.push(new Point(i, i));
+    var o = { x: i, y: i };
+    o["p" + (i % 6)] = i;
+    polymorphic.push(o);
+}
+
+function sumX(objects) {
+    var sum = 0;
+    for (var i = 0; i < objects.length; i++)
+        sum += objects[i].x;
+    return sum;
+}
+
+benchmarks = {
+    monomorphic: () => sumX(monomorphic),
+    polymorphic: () => sumX(polymorphic),
+};
+options = { inner: 100 };
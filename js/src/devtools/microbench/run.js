@@ -0,0 +1,32 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Runs the microbenchmarks in this directory with the shell's benchmark()
+// builtin and prints the results as one JSON object:
+//
+//   js devtools/microbench/run.js [filter]
+//
+// Each benchmark file defines a |benchmarks| object mapping names to
+// functions, with an optional |options| object that is passed on to
+// benchmark(). Compare two runs with compare.py.
+
+var dir = scriptPath.replace(/[^\/\\]*$/, "");
+var files = ["property-access.js", "calls.js", "allocation.js"];
+var filter = scriptArgs.length ? scriptArgs[0] : "";
+var benchmarks, options;
+
+var results = {};
+for (var file of files) {
+    load(dir + file);
+    for (var name in benchmarks) {
+        var fullName = file.replace(/\.js$/, "") + "/" + name;
+        if (!fullName.includes(filter))
+            continue;
+        var result = benchmark(benchmarks[name], options);
+        delete result.samples;
+        results[fullName] = result;
+    }
+}
+
+print(JSON.stringify(results, null, 2));
@@ -8,11 +8,136 @@
 
 #include "mozilla/MathAlgorithms.h"
 
+#include "threading/LockGuard.h"
+#include "threading/Mutex.h"
+
 using namespace js;
 
+using mozilla::FloorLog2;
 using mozilla::RoundUpPow2;
 using mozilla::tl::BitSize;
 
+namespace {
+
+// Compilations, parses and regexp compiles each create a LifoAlloc and free
+// all of its chunks when they finish. Rather than handing those chunks back to
+// malloc, chunks of the common sizes are kept in this process-wide pool and
+// reused by the next LifoAlloc, on any thread, that needs a chunk of the same
+// size. This saves the malloc/free churn and the page faults on touching
+// freshly mapped memory.
+class LifoChunkPool
+{
+    struct FreeChunk
+    {
+        FreeChunk* next;
+    };
+
+    // Chunks of 4 KiB to 64 KiB are pooled, one free list per power of two.
+    static const size_t MinSizeLog2 = 12;
+    static const size_t MaxSizeLog2 = 16;
+    static const size_t NumSizeClasses = MaxSizeLog2 - MinSizeLog2 + 1;
+
+    // Chunks freed once the pool holds this much are returned to malloc.
+    static const size_t MaxPooledBytes = 8 * 1024 * 1024;
+
+    Mutex lock_;
+    FreeChunk* freeLists_[NumSizeClasses];
+    size_t pooledBytes_;
+
+    static bool sizeClass(size_t chunkSize, size_t* classp) {
+        size_t log2 = FloorLog2(chunkSize);
+        if (log2 < MinSizeLog2 || log2 > MaxSizeLog2)
+            return false;
+        *classp = log2 - MinSizeLog2;
+        return true;
+    }
+
+  public:
+    LifoChunkPool()
+      : pooledBytes_(0)
+    {
+        mozilla::PodArrayZero(freeLists_);
+    }
+
+    ~LifoChunkPool() {
+        release();
+    }
+
+    void* get(size_t chunkSize) {
+        size_t cls;
+        if (!sizeClass(chunkSize, &cls))
+            return nullptr;
+
+        LockGuard<Mutex> guard(lock_);
+        FreeChunk* chunk = freeLists_[cls];
+        if (!chunk)
+            return nullptr;
+        freeLists_[cls] = chunk->next;
+        pooledBytes_ -= chunkSize;
+        return chunk;
+    }
+
+    bool put(void* mem, size_t chunkSize) {
+        size_t cls;
+        if (!sizeClass(chunkSize, &cls))
+            return false;
+
+        LockGuard<Mutex> guard(lock_);
+        if (pooledBytes_ + chunkSize > MaxPooledBytes)
+            return false;
+        FreeChunk* chunk = static_cast<FreeChunk*>(mem);
+        chunk->next = freeLists_[cls];
+        freeLists_[cls] = chunk;
+        pooledBytes_ += chunkSize;
+        return true;
+    }
+
+    void release() {
+        FreeChunk* lists[NumSizeClasses];
+        {
+            LockGuard<Mutex> guard(lock_);
+            mozilla::PodArrayCopy(lists, freeLists_);
+            mozilla::PodArrayZero(freeLists_);
+            pooledBytes_ = 0;
+        }
+
+        for (FreeChunk* chunk : lists) {
+            while (chunk) {
+                FreeChunk* next = chunk->next;
+                js_free(chunk);
+                chunk = next;
+            }
+        }
+    }
+};
+
+LifoChunkPool* gLifoChunkPool = nullptr;
+
+} // anonymous namespace
+
+bool
+js::CreateLifoChunkPool()
+{
+    MOZ_ASSERT(!gLifoChunkPool);
+    gLifoChunkPool = js_new<LifoChunkPool>();
+    return gLifoChunkPool != nullptr;
+}
+
+void
+js::DestroyLifoChunkPool()
+{
+    MOZ_ASSERT(gLifoChunkPool);
+    js_delete(gLifoChunkPool);
+    gLifoChunkPool = nullptr;
+}
+
+void
+js::ReleaseLifoChunkPool()
+{
+    if (gLifoChunkPool)
+        gLifoChunkPool->release();
+}
+
 namespace js {
 namespace detail {
 
@@ -20,9 +145,15 @@ BumpChunk*
 BumpChunk::new_(size_t chunkSize)
 {
     MOZ_ASSERT(RoundUpPow2(chunkSize) == chunkSize);
-    void* mem = js_malloc(chunkSize);
-    if (!mem)
-        return nullptr;
+    void* mem = gLifoChunkPool ? gLifoChunkPool->get(chunkSize) : nullptr;
+    if (mem) {
+        // A recycled chunk may still be partly marked as noaccess.
+        MOZ_MAKE_MEM_UNDEFINED(mem, chunkSize);
+    } else {
+        mem = js_malloc(chunkSize);
+        if (!mem)
+            return nullptr;
+    }
     BumpChunk* result = new (mem) BumpChunk(chunkSize - sizeof(BumpChunk));
 
     // We assume that the alignment of sAlign is less than that of
@@ -35,13 +166,15 @@ BumpChunk::new_(size_t chunkSize)
 void
 BumpChunk::delete_(BumpChunk* chunk)
 {
+    size_t size = sizeof(*chunk) + chunk->bumpSpaceSize;
 #ifdef DEBUG
     // Part of the chunk may have been marked as poisoned/noaccess.  Undo that
     // before writing the 0xcd bytes.
-    size_t size = sizeof(*chunk) + chunk->bumpSpaceSize;
     MOZ_MAKE_MEM_UNDEFINED(chunk, size);
     memset(chunk, 0xcd, size);
 #endif
+    if (gLifoChunkPool && gLifoChunkPool->put(chunk, size))
+        return;
     js_free(chunk);
 }
 
@@ -24,6 +24,18 @@
 
 namespace js {
 
+// Create the process-wide pool of recycled LifoAlloc chunks.
+MOZ_MUST_USE bool
+CreateLifoChunkPool();
+
+// Free the pooled chunks and destroy the pool.
+void
+DestroyLifoChunkPool();
+
+// Return all pooled chunks to the system, e.g. under memory pressure.
+void
+ReleaseLifoChunkPool();
+
 namespace detail {
 
 static const size_t LIFO_ALLOC_ALIGN = 8;
@@ -35,8 +35,14 @@
  *     void makeEmpty(Key*);
  */
 
+#include "mozilla/MathAlgorithms.h"
 #include "mozilla/Move.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define JS_ORDERED_HASH_TABLE_SSE2
+# include <emmintrin.h>
+#endif
+
 using mozilla::Forward;
 using mozilla::Move;
 
@@ -48,6 +54,14 @@ namespace detail {
  * detail::OrderedHashTable is the underlying data structure used to implement both
  * OrderedHashMap and OrderedHashSet. Programs should use one of those two
  * templates rather than OrderedHashTable.
+ *
+ * Entries are stored in insertion order in |data|. Removed entries are left
+ * in place with an empty key until the table is compacted, so that Ranges can
+ * keep their position. Lookups go through a separate open-addressed index:
+ * |hashTable| holds the positions in |data| of the entries, and |hashControl|
+ * holds one control byte per slot, either ControlEmpty, ControlDeleted, or 7
+ * bits of the entry's hash. Slots are probed a group of control bytes at a
+ * time, so most failed probes are rejected without touching |data| at all.
  */
 template <class T, class Ops, class AllocPolicy>
 class OrderedHashTable
@@ -59,39 +73,50 @@ class OrderedHashTable
     struct Data
     {
         T element;
-        Data* chain;
 
-        Data(const T& e, Data* c) : element(e), chain(c) {}
-        Data(T&& e, Data* c) : element(Move(e)), chain(c) {}
+        explicit Data(const T& e) : element(e) {}
+        explicit Data(T&& e) : element(Move(e)) {}
     };
 
     class Range;
     friend class Range;
 
   private:
-    Data** hashTable;           // hash table (has hashBuckets() elements)
+    uint32_t* hashTable;        // hash table: positions in data of the
+                                // entries (has hashBuckets() elements)
+    uint8_t* hashControl;       // control byte for each slot of hashTable,
+                                // allocated along with it
     Data* data;                 // data vector, an array of Data objects
                                 // data[0:dataLength] are constructed
     uint32_t dataLength;        // number of constructed elements in data
     uint32_t dataCapacity;      // size of data, in elements
     uint32_t liveCount;         // dataLength less empty (removed) entries
+    uint32_t hashUsed;          // slots of hashTable that are not empty
     uint32_t hashShift;         // multiplicative hash shift
     Range* ranges;              // list of all live Ranges on this table
     AllocPolicy alloc;
 
+    static const uint8_t ControlEmpty = 0x80;
+    static const uint8_t ControlDeleted = 0xfe;
+
+    // The number of control bytes examined at once.
+    static const uint32_t GroupWidth = 16;
+
+    static const uint32_t NoSlot = UINT32_MAX;
+
   public:
     explicit OrderedHashTable(AllocPolicy& ap)
-        : hashTable(nullptr), data(nullptr), dataLength(0), ranges(nullptr), alloc(ap) {}
+        : hashTable(nullptr), hashControl(nullptr), data(nullptr), dataLength(0),
+          ranges(nullptr), alloc(ap) {}
 
     MOZ_MUST_USE bool init() {
         MOZ_ASSERT(!hashTable, "init must be called at most once");
 
         uint32_t buckets = initialBuckets();
-        Data** tableAlloc = alloc.template pod_malloc<Data*>(buckets);
+        uint8_t* controlAlloc;
+        uint32_t* tableAlloc = allocHashTable(buckets, &controlAlloc);
         if (!tableAlloc)
             return false;
-        for (uint32_t i = 0; i < buckets; i++)
-            tableAlloc[i] = nullptr;
 
         uint32_t capacity = uint32_t(buckets * fillFactor());
         Data* dataAlloc = alloc.template pod_malloc<Data>(capacity);
@@ -103,10 +128,12 @@ class OrderedHashTable
         // clear() requires that members are assigned only after all allocation
         // has succeeded, and that this->ranges is left untouched.
         hashTable = tableAlloc;
+        hashControl = controlAlloc;
         data = dataAlloc;
         dataLength = 0;
         dataCapacity = capacity;
         liveCount = 0;
+        hashUsed = 0;
         hashShift = HashNumberSizeBits - initialBucketsLog2();
         MOZ_ASSERT(hashBuckets() == buckets);
         return true;
@@ -165,11 +192,10 @@ class OrderedHashTable
                 return false;
         }
 
-        h >>= hashShift;
         liveCount++;
-        Data* e = &data[dataLength++];
-        new (e) Data(Forward<ElementInput>(element), hashTable[h]);
-        hashTable[h] = e;
+        uint32_t pos = dataLength++;
+        new (&data[pos]) Data(Forward<ElementInput>(element));
+        insertIndex(h, pos);
         return true;
     }
 
@@ -188,18 +214,19 @@ class OrderedHashTable
         // benefit.
 
         // If a matching entry exists, empty it.
-        Data* e = lookup(l, prepareHash(l));
-        if (e == nullptr) {
+        uint32_t slot = lookupSlot(l, prepareHash(l));
+        if (slot == NoSlot) {
             *foundp = false;
             return true;
         }
 
         *foundp = true;
         liveCount--;
-        Ops::makeEmpty(&e->element);
+        hashControl[slot] = ControlDeleted;
+        uint32_t pos = hashTable[slot];
+        Ops::makeEmpty(&data[pos].element);
 
         // Update active Ranges.
-        uint32_t pos = e - data;
         for (Range* r = ranges; r; r = r->next)
             r->onRemove(pos);
 
@@ -223,7 +250,7 @@ class OrderedHashTable
      */
     MOZ_MUST_USE bool clear() {
         if (dataLength != 0) {
-            Data** oldHashTable = hashTable;
+            uint32_t* oldHashTable = hashTable;
             Data* oldData = data;
             uint32_t oldDataLength = dataLength;
 
@@ -432,32 +459,11 @@ class OrderedHashTable
         void rekeyFront(const Key& k) {
             MOZ_ASSERT(valid());
             Data& entry = ht->data[i];
-            HashNumber oldHash = prepareHash(Ops::getKey(entry.element)) >> ht->hashShift;
-            HashNumber newHash = prepareHash(k) >> ht->hashShift;
+            HashNumber oldHash = prepareHash(Ops::getKey(entry.element));
+            HashNumber newHash = prepareHash(k);
             Ops::setKey(entry.element, k);
-            if (newHash != oldHash) {
-                // Remove this entry from its old hash chain. (If this crashes
-                // reading nullptr, it would mean we did not find this entry on
-                // the hash chain where we expected it. That probably means the
-                // key's hash code changed since it was inserted, breaking the
-                // hash code invariant.)
-                Data** ep = &ht->hashTable[oldHash];
-                while (*ep != &entry)
-                    ep = &(*ep)->chain;
-                *ep = entry.chain;
-
-                // Add it to the new hash chain. We could just insert it at the
-                // beginning of the chain. Instead, we do a bit of work to
-                // preserve the invariant that hash chains always go in reverse
-                // insertion order (descending memory order). No code currently
-                // depends on this invariant, so it's fine to kill it if
-                // needed.
-                ep = &ht->hashTable[newHash];
-                while (*ep && *ep > &entry)
-                    ep = &(*ep)->chain;
-                entry.chain = *ep;
-                *ep = &entry;
-            }
+            if (newHash != oldHash)
+                ht->moveIndex(i, oldHash, newHash);
         }
 
         static size_t offsetOfHashTable() {
@@ -490,36 +496,16 @@ class OrderedHashTable
         if (current == newKey)
             return;
 
-        Data* entry = lookup(current, prepareHash(current));
+        HashNumber oldHash = prepareHash(current);
+        Data* entry = lookup(current, oldHash);
         if (!entry)
             return;
 
-        HashNumber oldHash = prepareHash(current) >> hashShift;
-        HashNumber newHash = prepareHash(newKey) >> hashShift;
+        HashNumber newHash = prepareHash(newKey);
 
         entry->element = element;
-
-        // Remove this entry from its old hash chain. (If this crashes
-        // reading nullptr, it would mean we did not find this entry on
-        // the hash chain where we expected it. That probably means the
-        // key's hash code changed since it was inserted, breaking the
-        // hash code invariant.)
-        Data** ep = &hashTable[oldHash];
-        while (*ep != entry)
-            ep = &(*ep)->chain;
-        *ep = entry->chain;
-
-        // Add it to the new hash chain. We could just insert it at the
-        // beginning of the chain. Instead, we do a bit of work to
-        // preserve the invariant that hash chains always go in reverse
-        // insertion order (descending memory order). No code currently
-        // depends on this invariant, so it's fine to kill it if
-        // needed.
-        ep = &hashTable[newHash];
-        while (*ep && *ep > entry)
-            ep = &(*ep)->chain;
-        entry->chain = *ep;
-        *ep = entry;
+        if (newHash != oldHash)
+            moveIndex(entry - data, oldHash, newHash);
     }
 
     static size_t offsetOfDataLength() {
@@ -535,21 +521,20 @@ class OrderedHashTable
 #endif
 
   private:
-    /* Logarithm base 2 of the number of buckets in the hash table initially. */
-    static uint32_t initialBucketsLog2() { return 1; }
+    /* Logarithm base 2 of the number of slots in the hash table initially. */
+    static uint32_t initialBucketsLog2() { return 3; }
     static uint32_t initialBuckets() { return 1 << initialBucketsLog2(); }
 
     /*
-     * The maximum load factor (mean number of entries per bucket).
+     * The maximum load factor (entries per slot of the hash table).
      * It is an invariant that
      *     dataCapacity == floor(hashBuckets() * fillFactor()).
      *
-     * The fill factor should be between 2 and 4, and it should be chosen so that
-     * the fill factor times sizeof(Data) is close to but <= a power of 2.
-     * This fixed fill factor was chosen to make the size of the data
-     * array, in bytes, close to a power of two when sizeof(T) is 16.
+     * Since data[] is only compacted when the table is rehashed, every slot
+     * used by an entry stays used until then, and this also bounds the number
+     * of non-empty slots. That guarantees that probing finds an empty slot.
      */
-    static double fillFactor() { return 8.0 / 3.0; }
+    static double fillFactor() { return 0.75; }
 
     /*
      * The minimum permitted value of (liveCount / dataLength).
@@ -566,6 +551,149 @@ class OrderedHashTable
         return 1 << (HashNumberSizeBits - hashShift);
     }
 
+    /*
+     * Allocate a hash table with |buckets| empty slots. The control bytes are
+     * stored after the positions, in the same allocation.
+     */
+    uint32_t* allocHashTable(uint32_t buckets, uint8_t** controlp) {
+        uint8_t* table =
+            alloc.template pod_malloc<uint8_t>(buckets * (sizeof(uint32_t) + sizeof(uint8_t)));
+        if (!table)
+            return nullptr;
+        *controlp = table + buckets * sizeof(uint32_t);
+        memset(*controlp, ControlEmpty, buckets);
+        return reinterpret_cast<uint32_t*>(table);
+    }
+
+    /*
+     * The top bits of the hash select the group of slots where probing
+     * starts, and the 7 bits below them are stored in the control byte.
+     */
+    uint8_t controlFor(HashNumber h) const {
+        return uint8_t((hashShift >= 7 ? h >> (hashShift - 7) : h) & 0x7f);
+    }
+
+    uint32_t groupWidth() const {
+        return hashBuckets() < GroupWidth ? hashBuckets() : GroupWidth;
+    }
+
+    /* A bitmask of the control bytes in |group| that are equal to |c|. */
+    static uint32_t matchControl(const uint8_t* group, uint32_t width, uint8_t c) {
+#ifdef JS_ORDERED_HASH_TABLE_SSE2
+        if (width == GroupWidth) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(char(c)))));
+        }
+#endif
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < width; i++) {
+            if (group[i] == c)
+                mask |= uint32_t(1) << i;
+        }
+        return mask;
+    }
+
+    /* A bitmask of the control bytes in |group| which are empty or deleted. */
+    static uint32_t matchFree(const uint8_t* group, uint32_t width) {
+#ifdef JS_ORDERED_HASH_TABLE_SSE2
+        if (width == GroupWidth) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            return uint32_t(_mm_movemask_epi8(bytes));
+        }
+#endif
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < width; i++) {
+            if (group[i] & 0x80)
+                mask |= uint32_t(1) << i;
+        }
+        return mask;
+    }
+
+    /*
+     * Probe the groups of slots for hash |h| in order, calling |f| on each
+     * slot whose control byte matches, until |f| returns true or a group with
+     * an empty slot is reached. Groups are visited in triangular order, which
+     * reaches every group since the number of groups is a power of two.
+     */
+    template <typename Found>
+    uint32_t findSlot(HashNumber h, Found found) const {
+        uint32_t width = groupWidth();
+        uint32_t groupMask = hashBuckets() / width - 1;
+        uint32_t group = (h >> hashShift) / width;
+        uint8_t c = controlFor(h);
+        for (uint32_t step = 1; ; step++) {
+            uint32_t base = group * width;
+            const uint8_t* control = hashControl + base;
+            for (uint32_t m = matchControl(control, width, c); m; m &= m - 1) {
+                uint32_t slot = base + mozilla::CountTrailingZeroes32(m);
+                if (found(hashTable[slot]))
+                    return slot;
+            }
+            if (matchControl(control, width, ControlEmpty))
+                return NoSlot;
+            MOZ_ASSERT(step <= groupMask + 1, "the hash table always has an empty slot");
+            group = (group + step) & groupMask;
+        }
+    }
+
+    uint32_t lookupSlot(const Lookup& l, HashNumber h) const {
+        return findSlot(h, [&](uint32_t pos) {
+            return Ops::match(Ops::getKey(data[pos].element), l);
+        });
+    }
+
+    /* Add data[pos], whose key has hash |h|, to the hash table. */
+    void insertIndex(HashNumber h, uint32_t pos) {
+        // Deleted slots are reused, but only rehashing empties them, so
+        // rebuild the table first if this would use up its last free slot.
+        if (hashUsed == dataCapacity) {
+            rebuildIndex();
+            return;
+        }
+
+        uint32_t width = groupWidth();
+        uint32_t groupMask = hashBuckets() / width - 1;
+        uint32_t group = (h >> hashShift) / width;
+        for (uint32_t step = 1; ; step++) {
+            uint32_t base = group * width;
+            if (uint32_t m = matchFree(hashControl + base, width)) {
+                uint32_t slot = base + mozilla::CountTrailingZeroes32(m);
+                if (hashControl[slot] == ControlEmpty)
+                    hashUsed++;
+                hashControl[slot] = controlFor(h);
+                hashTable[slot] = pos;
+                return;
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    /*
+     * Move the slot for data[pos] after its key's hash changed from |oldHash|
+     * to |newHash|.
+     */
+    void moveIndex(uint32_t pos, HashNumber oldHash, HashNumber newHash) {
+        // If this fails, it would mean we did not find this entry where we
+        // expected it. That probably means the key's hash code changed since
+        // it was inserted, breaking the hash code invariant.
+        uint32_t slot = findSlot(oldHash, [=](uint32_t p) { return p == pos; });
+        MOZ_RELEASE_ASSERT(slot != NoSlot);
+        hashControl[slot] = ControlDeleted;
+        insertIndex(newHash, pos);
+    }
+
+    /* Empty the hash table and add every entry in data[] to it again. */
+    void rebuildIndex() {
+        memset(hashControl, ControlEmpty, hashBuckets());
+        hashUsed = 0;
+        for (uint32_t pos = 0; pos < dataLength; pos++) {
+            const Key& key = Ops::getKey(data[pos].element);
+            if (!Ops::isEmpty(key))
+                insertIndex(prepareHash(key), pos);
+        }
+        MOZ_ASSERT(hashUsed == liveCount);
+    }
+
     static void destroyData(Data* data, uint32_t length) {
         for (Data* p = data + length; p != data; )
             (--p)->~Data();
@@ -577,11 +705,8 @@ class OrderedHashTable
     }
 
     Data* lookup(const Lookup& l, HashNumber h) {
-        for (Data* e = hashTable[h >> hashShift]; e; e = e->chain) {
-            if (Ops::match(Ops::getKey(e->element), l))
-                return e;
-        }
-        return nullptr;
+        uint32_t slot = lookupSlot(l, h);
+        return slot == NoSlot ? nullptr : &data[hashTable[slot]];
     }
 
     const Data* lookup(const Lookup& l) const {
@@ -598,17 +723,12 @@ class OrderedHashTable
 
     /* Compact the entries in |data| and rehash them. */
     void rehashInPlace() {
-        for (uint32_t i = 0, N = hashBuckets(); i < N; i++)
-            hashTable[i] = nullptr;
         Data* wp = data;
         Data* end = data + dataLength;
         for (Data* rp = data; rp != end; rp++) {
             if (!Ops::isEmpty(Ops::getKey(rp->element))) {
-                HashNumber h = prepareHash(Ops::getKey(rp->element)) >> hashShift;
                 if (rp != wp)
                     wp->element = Move(rp->element);
-                wp->chain = hashTable[h];
-                hashTable[h] = wp;
                 wp++;
             }
         }
@@ -617,6 +737,7 @@ class OrderedHashTable
         while (wp != end)
             (--end)->~Data();
         dataLength = liveCount;
+        rebuildIndex();
         compacted();
     }
 
@@ -637,11 +758,10 @@ class OrderedHashTable
 
         size_t newHashBuckets =
             size_t(1) << (HashNumberSizeBits - newHashShift);
-        Data** newHashTable = alloc.template pod_malloc<Data*>(newHashBuckets);
+        uint8_t* newHashControl;
+        uint32_t* newHashTable = allocHashTable(newHashBuckets, &newHashControl);
         if (!newHashTable)
             return false;
-        for (uint32_t i = 0; i < newHashBuckets; i++)
-            newHashTable[i] = nullptr;
 
         uint32_t newCapacity = uint32_t(newHashBuckets * fillFactor());
         Data* newData = alloc.template pod_malloc<Data>(newCapacity);
@@ -654,9 +774,7 @@ class OrderedHashTable
         Data* end = data + dataLength;
         for (Data* p = data; p != end; p++) {
             if (!Ops::isEmpty(Ops::getKey(p->element))) {
-                HashNumber h = prepareHash(Ops::getKey(p->element)) >> newHashShift;
-                new (wp) Data(Move(p->element), newHashTable[h]);
-                newHashTable[h] = wp;
+                new (wp) Data(Move(p->element));
                 wp++;
             }
         }
@@ -666,12 +784,14 @@ class OrderedHashTable
         freeData(data, dataLength);
 
         hashTable = newHashTable;
+        hashControl = newHashControl;
         data = newData;
         dataLength = liveCount;
         dataCapacity = newCapacity;
         hashShift = newHashShift;
         MOZ_ASSERT(hashBuckets() == newHashBuckets);
 
+        rebuildIndex();
         compacted();
         return true;
     }
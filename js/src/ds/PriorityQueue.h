@@ -47,6 +47,22 @@ class PriorityQueue
         return heap.empty();
     }
 
+    /*
+     * Elements are visited in heap order, not priority order. The queue must
+     * not be modified while iterating.
+     */
+    const T* begin() const {
+        return heap.begin();
+    }
+
+    const T* end() const {
+        return heap.end();
+    }
+
+    const T& highest() const {
+        return heap[0];
+    }
+
     T removeHighest() {
         T highest = heap[0];
         T last = heap.popCopy();
@@ -69,6 +85,25 @@ class PriorityQueue
         siftUp(heap.length() - 1);
     }
 
+    /*
+     * Remove every element for which pred returns true. The predicate is
+     * called exactly once per element, so it may take ownership of the
+     * elements it removes. This is O(n).
+     */
+    template <typename Pred>
+    void removeIf(Pred pred) {
+        size_t kept = 0;
+        for (size_t i = 0; i < heap.length(); i++) {
+            if (!pred(heap[i]))
+                heap[kept++] = heap[i];
+        }
+        if (kept == heap.length())
+            return;
+        heap.shrinkBy(heap.length() - kept);
+        for (size_t n = heap.length() / 2; n > 0; n--)
+            siftDown(n - 1);
+    }
+
   private:
 
     /*
@@ -156,10 +156,14 @@ Allocate(ExclusiveContext* cx) {
 template <typename T, AllowGC allowGC /* = CanGC */>
 T*
 Allocate(ExclusiveContext* cx, gc::AllocKind kind) {
-	JSContext* ncx = cx->asJSContext();
-	JSRuntime* rt = ncx->runtime();
-	Cell* obj = rt->gc.nursery.allocateObject(ncx, sizeof(T), 0, nullptr, (allowGC == CanGC) && (rt->gc.enabled == 0));
-	obj->setAllocKind(kind);
+	JSRuntime* rt = cx->zone()->runtimeFromAnyThread();
+	// The post barriers only track edges to objects, so nothing else may be
+	// allocated in new space.
+	Cell* obj = rt->gc.nursery.allocateObject(cx, kind, sizeof(T), 0, nullptr, (allowGC == CanGC) && (rt->gc.enabled == 0), true);
+	// Helper threads cannot collect, so their CanGC allocations report OOM
+	// as soon as the heap is full.
+	if (!obj && allowGC == CanGC && !cx->isJSContext())
+		ReportOutOfMemory(cx);
 	return (T*)obj;
 }
 
@@ -176,10 +180,16 @@ template <typename T, AllowGC allowGC /* = CanGC */>
 JSObject*
 js::Allocate(ExclusiveContext* cx, gc::AllocKind kind, size_t nDynamicSlots, gc::InitialHeap heap,
          const Class* clasp) {
-	JSContext* ncx = cx->asJSContext();
-	JSRuntime* rt = ncx->runtime();
-	JSObject* obj = rt->gc.nursery.allocateObject(ncx, OmrGcHelper::thingSize(kind), nDynamicSlots, clasp, (allowGC == CanGC) && (rt->gc.enabled == 0));
-	if (obj) obj->setAllocKind(kind);
+	JSRuntime* rt = cx->zone()->runtimeFromAnyThread();
+	// Objects of an off thread parse global are pinned until they are merged,
+	// even those made on the main thread, so they must not go in new space.
+	bool tenured = heap == gc::TenuredHeap || cx->compartment()->creationOptions().mergeable();
+	// The compactor cannot call objectMoved hooks, see objectMovedHooksUsed.
+	if (MOZ_UNLIKELY(clasp && clasp->extObjectMovedOp()))
+		rt->gc.objectMovedHooksUsed = true;
+	JSObject* obj = rt->gc.nursery.allocateObject(cx, kind, OmrGcHelper::thingSize(kind), nDynamicSlots, clasp, (allowGC == CanGC) && (rt->gc.enabled == 0), tenured);
+	if (!obj && allowGC == CanGC && !cx->isJSContext())
+		ReportOutOfMemory(cx);
 	return obj;
 }
 
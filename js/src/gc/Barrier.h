@@ -261,11 +261,11 @@ struct InternalBarrierMethods<T*>
 
     static bool isMarkableTaggedPointer(T* v) { return !IsNullTaggedPointer(v); }
 
-    static void preBarrier(T* v) {}
+    static void preBarrier(T* v) { T::writeBarrierPre(v); }
 
-    static void postBarrier(T** vp, T* prev, T* next) {}
+    static void postBarrier(T** vp, T* prev, T* next) { T::writeBarrierPost(vp, prev, next); }
 
-    static void readBarrier(T* v) {}
+    static void readBarrier(T* v) { T::readBarrier(v); }
 };
 
 template <typename S> struct PreBarrierFunctor : public VoidDefaultAdaptor<S> {
@@ -283,12 +283,33 @@ struct InternalBarrierMethods<Value>
     static bool isMarkableTaggedPointer(const Value& v) { return isMarkable(v); }
 
     static void preBarrier(const Value& v) {
+        if (v.isMarkable() && gc::OmrGcHelper::isConcurrentMarking())
+            DispatchTyped(PreBarrierFunctor<Value>(), v);
     }
 
     static void postBarrier(Value* vp, const Value& prev, const Value& next) {
+        MOZ_ASSERT(vp);
+
+        // Edges inside new space are traced when their owner is copied.
+        if (gc::OmrGcHelper::isInNewSpace(vp))
+            return;
+
+        // If the target needs an entry, add it. If prev already did, the
+        // entry is there.
+        if (next.isObject() && gc::OmrGcHelper::isInNewSpace(&next.toObject())) {
+            if (prev.isObject() && gc::OmrGcHelper::isInNewSpace(&prev.toObject()))
+                return;
+            gc::OmrGcHelper::putValueEdge(vp);
+            return;
+        }
+
+        // Remove the prev entry if the new value does not need it.
+        if (prev.isObject() && gc::OmrGcHelper::isInNewSpace(&prev.toObject()))
+            gc::OmrGcHelper::unputValueEdge(vp);
     }
 
     static void readBarrier(const Value& v) {
+        DispatchTyped(ReadBarrierFunctor<Value>(), v);
     }
 };
 
@@ -298,7 +319,10 @@ struct InternalBarrierMethods<jsid>
     static bool isMarkable(jsid id) { return JSID_IS_GCTHING(id); }
     static bool isMarkableTaggedPointer(jsid id) { return isMarkable(id); }
 
-    static void preBarrier(jsid id) {}
+    static void preBarrier(jsid id) {
+        if (JSID_IS_GCTHING(id) && gc::OmrGcHelper::isConcurrentMarking())
+            DispatchTyped(PreBarrierFunctor<jsid>(), id);
+    }
     static void postBarrier(jsid* idp, jsid prev, jsid next) {}
 };
 
@@ -349,11 +373,12 @@ class WriteBarrieredBase : public BarrieredBase<T>
     void unsafeSet(const T& v) { this->value = v; }
 
     // For users who need to manually barrier the raw types.
-    static void writeBarrierPre(const T& v) {}
+    static void writeBarrierPre(const T& v) { InternalBarrierMethods<T>::preBarrier(v); }
 
   protected:
-    void pre() {}
+    void pre() { InternalBarrierMethods<T>::preBarrier(this->value); }
     void post(const T& prev, const T& next) {
+        InternalBarrierMethods<T>::postBarrier(&this->value, prev, next);
     }
 };
 
@@ -690,6 +715,11 @@ class HeapSlot : public WriteBarrieredBase<Value>
             if (cell->storeBuffer())
                 cell->storeBuffer()->putSlot(owner, kind, slot, 1);
         }
+#else // ! OMR writebarrier
+        // Slots and elements always have an owner, so remember the owner
+        // itself rather than the edge.
+        if (this->value.isObject())
+            gc::OmrGcHelper::postBarrierOwned(reinterpret_cast<gc::Cell*>(owner), &this->value.toObject());
 #endif // ! OMR writebarrier
     }
 };
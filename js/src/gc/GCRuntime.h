@@ -9,6 +9,7 @@
 
 #include "mozilla/Atomics.h"
 #include "mozilla/EnumSet.h"
+#include "mozilla/LinkedList.h"
 
 #include "jsfriendapi.h"
 #include "jsgc.h"
@@ -54,17 +55,57 @@ using CallbackVector = Vector<Callback<F>, 4, SystemAllocPolicy>;
 
 typedef HashMap<Value*, const char*, DefaultHasher<Value*>, SystemAllocPolicy> RootedValueMap;
 
+class GCRuntime;
+
+/*
+ * A thread's buffer of cells overwritten while OMR's concurrent mark is
+ * running; see OmrGcHelper::concurrentWriteBarrierPre. The owning thread
+ * appends to it without locking. Its cells move to the collector's shared
+ * buffer under GCRuntime::concurrentBarrierLock only when it fills up, or
+ * when the collector reads every thread's buffer before the final mark.
+ */
+class ConcurrentBarrierBuffer : public mozilla::LinkedListElement<ConcurrentBarrierBuffer>
+{
+  public:
+    static const size_t Capacity = 256;
+
+    ConcurrentBarrierBuffer() : cycle_(0), length_(0) {}
+    ~ConcurrentBarrierBuffer();
+
+    /* Called on the owning thread only. */
+    void put(GCRuntime* gc, Cell* cell);
+
+    /* Called with GCRuntime::concurrentBarrierLock held. */
+    MOZ_MUST_USE bool appendTo(GCRuntime* gc, Vector<Cell*, 0, SystemAllocPolicy>& cells) const;
+
+  private:
+    /* The mark cycle the cells were recorded in. Changes under the lock. */
+    uint32_t cycle_;
+
+    /*
+     * Cells before this are complete. It only grows on the owning thread and
+     * is only reset under the lock.
+     */
+    mozilla::Atomic<size_t, mozilla::ReleaseAcquire> length_;
+
+    Cell* cells_[Capacity];
+};
+
+
 class GCRuntime
 {
   public:
     explicit GCRuntime(JSRuntime* rt)
         : enabled(0),
+        compactingEnabled(true),
+        compactingDisabledCount(0),
+        shrinkingGC(false),
+        shrinkRequested(false),
+        objectMovedHooksUsed(false),
 		number(0),
 		rt(rt),
 		nursery(rt),
-#ifndef OMR
         storeBuffer(rt, nursery),
-#endif // OMR
         stats(rt),
         marker(rt),
         usage(nullptr),
@@ -74,6 +115,31 @@ class GCRuntime
     uint32_t enabled;
 	void disable() { --enabled; }
 	void enable() { ++enabled; }
+
+    /*
+     * OMR's compactor slides every live cell and cannot leave single cells
+     * in place, so a cell which must not move pins the whole heap: while any
+     * AutoDisableCompactingGC is live, collections do not compact.
+     */
+    bool compactingEnabled;
+    uint32_t compactingDisabledCount;
+    void disableCompactingGC() { ++compactingDisabledCount; }
+    void enableCompactingGC() { MOZ_ASSERT(compactingDisabledCount > 0); --compactingDisabledCount; }
+    bool isCompactingGCEnabled() const { return compactingEnabled && compactingDisabledCount == 0; }
+
+    /* Whether the collection in progress was started by gc(GC_SHRINK, ...). */
+    bool shrinkingGC;
+    bool isShrinkingGC() const { return shrinkingGC; }
+
+    /* Set off the main thread when malloc fails; see gcIfRequested(). */
+    mozilla::Atomic<bool, mozilla::ReleaseAcquire> shrinkRequested;
+
+    /*
+     * Set once an object whose class has an objectMoved hook is allocated.
+     * The compactor only knows the new address of each cell and cannot call
+     * these hooks, so from then on collections do not compact.
+     */
+    mozilla::Atomic<bool, mozilla::ReleaseAcquire> objectMovedHooksUsed;
     
     MOZ_MUST_USE bool init(uint32_t maxbytes, uint32_t maxNurseryBytes);
 	void finishRoots();
@@ -93,7 +159,7 @@ class GCRuntime
     }
     // The return value indicates whether a major GC was performed.
     bool gcIfRequested();
-    void gc(JSGCInvocationKind gckind, JS::gcreason::Reason reason) {}
+    void gc(JSGCInvocationKind gckind, JS::gcreason::Reason reason);
 	void abortGC();
     void startDebugGC(JSGCInvocationKind gckind, SliceBudget& budget);
     void debugGCSlice(SliceBudget& budget);
@@ -115,6 +181,14 @@ class GCRuntime
     void traceRuntimeCommon(JSTracer* trc, TraceOrMarkRuntime traceOrMark,
                             AutoLockForExclusiveAccess& lock);
 
+    // The independent parts of traceRuntimeCommon, for collectors that hand
+    // them out to parallel threads.
+    void traceRuntimeStacks(JSTracer* trc);
+    void traceRuntimeJitActivations(JSTracer* trc);
+    void traceRuntimeGlobals(JSTracer* trc);
+    void traceRuntimeCompartments(JSTracer* trc, TraceOrMarkRuntime traceOrMark);
+    void traceEmbeddingRoots(JSTracer* trc, TraceOrMarkRuntime traceOrMark);
+
 #ifdef JS_GC_ZEAL
     const void* addressOfZealModeBits() { return nullptr; }
     void getZealBits(uint32_t* zealBits, uint32_t* frequency, uint32_t* nextScheduled);
@@ -182,10 +256,6 @@ class GCRuntime
 
     void setFullCompartmentChecks(bool enable);
 
-	JS::Zone* getCurrentZoneGroup() {
-         return OmrGcHelper::zone;
-    }
-
 	uint64_t number;
     uint64_t gcNumber() const { return number; }
 	void incGcNumber() { ++ number; }
@@ -242,9 +312,7 @@ class GCRuntime
 
     Nursery nursery;
 
-#ifndef OMR // Writebariers
     StoreBuffer storeBuffer;
-#endif // ! OMR Writebarriers
 
     gcstats::Statistics stats;
 
@@ -263,6 +331,45 @@ class GCRuntime
     Callback<JSTraceDataOp> grayRootTracer;
 
 	js::Mutex lock;
+
+    /*
+     * Cells overwritten while OMR's concurrent mark is running. They are
+     * marked by the collector; see OmrGcHelper::concurrentWriteBarrierPre.
+     */
+    js::Mutex concurrentBarrierLock;
+    Vector<Cell*, 0, SystemAllocPolicy> concurrentBarrierBuffer;
+
+    /* Every thread's ConcurrentBarrierBuffer, guarded by concurrentBarrierLock. */
+    mozilla::LinkedList<ConcurrentBarrierBuffer> concurrentBarrierBuffers;
+
+    /*
+     * Bumped at the end of each mark, so that cells left in a thread's
+     * buffer are dropped rather than marked in the next cycle.
+     */
+    mozilla::Atomic<uint32_t, mozilla::ReleaseAcquire> concurrentBarrierCycle;
+
+    /*
+     * Live cells at their new addresses, collected by the compactor's
+     * parallel object fixup and fixed up together with the roots. Objects
+     * are kept apart because they are fixed after the cells they read, and
+     * slots and elements buffers because objects look up where they went.
+     */
+    js::Mutex compactFixupLock;
+    Vector<Cell*, 0, SystemAllocPolicy> compactedCells;
+    Vector<JSObject*, 0, SystemAllocPolicy> compactedObjects;
+    Vector<OmrBuffer*, 0, SystemAllocPolicy> compactedBuffers;
+
+    /*
+     * The classes and alloc kinds of the cells holding the most live bytes
+     * at the last global collection, recorded while
+     * JSGC_FREQUENT_OBJECTS_ENABLED is set. Names are static strings.
+     */
+    struct FrequentObjectsEntry {
+        const char* name;
+        size_t bytes;
+    };
+    bool frequentObjectsEnabled = false;
+    Vector<FrequentObjectsEntry, 0, SystemAllocPolicy> frequentObjects;
 	
 	bool hasZealMode(ZealMode mode) { return false; }
 	bool upcomingZealousGC() { return false; }
@@ -197,8 +197,64 @@ struct Cell
 
     inline JS::TraceKind getTraceKind() const;
 
-    inline AllocKind getAllocKind() const { MOZ_ASSERT(((flags_ >> 2) & 829952) == 829952); return (AllocKind)((flags_ >> 2) & ~829952); }
-    inline void setAllocKind(AllocKind allocKind) { flags_ = (Flags)((((int)allocKind) | 829952) << 2); }
+    // The low byte of the header word is OMR's object metadata (hole bits,
+    // flags, age and remembered state); the alloc kind is encoded above it.
+    static const uintptr_t OmrMetadataShift = 8;
+    static const uintptr_t OmrMetadataMask = (uintptr_t(1) << OmrMetadataShift) - 1;
+    static const uintptr_t OmrRememberedBits = 0xF0;
+
+    // The index of the cell's zone in OmrGcHelper's zone table sits in the
+    // otherwise unused top of the header word. A 32-bit word has no room for
+    // the full eyecatcher, so there the alloc kind field is narrowed and the
+    // eyecatcher shortened to leave 16 bits for the zone index.
+#if JS_BITS_PER_WORD == 64
+    static const uintptr_t OmrEyeCatcher = 829952;
+    static const uintptr_t OmrAllocKindMask = 0x1FF;
+    static const uintptr_t OmrZoneIndexShift = 32;
+#else
+    static const uintptr_t OmrEyeCatcher = 0xC0;
+    static const uintptr_t OmrAllocKindMask = 0x3F;
+    static const uintptr_t OmrZoneIndexShift = 16;
+#endif
+    static const uintptr_t OmrZoneIndexBits = 16;
+    static const uintptr_t OmrZoneIndexMask = (uintptr_t(1) << OmrZoneIndexBits) - 1;
+    static const uintptr_t OmrMaxZones = OmrZoneIndexMask + 1;
+
+    // Heap cells holding the slots or elements of a native object are not GC
+    // things and have no AllocKind; see OmrBuffer.
+    static const uintptr_t OmrBufferKind = OmrAllocKindMask;
+    bool isOmrBuffer() const {
+        return ((flags_ >> OmrMetadataShift) & OmrAllocKindMask) == OmrBufferKind;
+    }
+
+    inline AllocKind getAllocKind() const {
+        MOZ_ASSERT(((flags_ >> OmrMetadataShift) & OmrEyeCatcher) == OmrEyeCatcher);
+        return (AllocKind)((flags_ >> OmrMetadataShift) & OmrAllocKindMask);
+    }
+    // Keeps the zone index; some cells re-set their kind after allocation.
+    inline void setAllocKind(AllocKind allocKind) {
+        setAllocKindAndZone(allocKind, omrZoneIndex());
+    }
+    inline void setAllocKindAndZone(AllocKind allocKind, uint32_t zoneIndex) {
+        flags_ = flagsForAllocKind(allocKind, zoneIndex);
+    }
+    uint32_t omrZoneIndex() const { return uint32_t((flags_ >> OmrZoneIndexShift) & OmrZoneIndexMask); }
+    // Moves the cell to another zone, keeping OMR's metadata.
+    inline void setOmrZoneIndex(uint32_t zoneIndex) {
+        flags_ = (flags_ & ~(OmrZoneIndexMask << OmrZoneIndexShift)) |
+                 (uintptr_t(zoneIndex) << OmrZoneIndexShift);
+    }
+
+    // Encoded header word for |allocKind| in zone |zoneIndex|, for the JIT's
+    // inline allocator.
+    static constexpr Flags flagsForAllocKind(AllocKind allocKind, uint32_t zoneIndex = 0) {
+        return (Flags)(((uintptr_t(allocKind) | OmrEyeCatcher) << OmrMetadataShift) |
+                       (uintptr_t(zoneIndex) << OmrZoneIndexShift));
+    }
+    static constexpr size_t offsetOfFlags() { return offsetof(Cell, flags_); }
+
+    // Whether OMR has this cell in its remembered set.
+    bool isOmrRemembered() const { return (flags_ & OmrRememberedBits) != 0; }
 
     static MOZ_ALWAYS_INLINE bool needWriteBarrierPre(JS::Zone* zone);
 
@@ -299,11 +355,140 @@ public:
         return thingSizes[size_t(kind)];
     }
 
-    static JS::Zone* zone;
     static GCRuntime* runtime;
+
+    /*
+     * Every live zone has a slot in this table, and its cells carry the
+     * index in their header (see Cell::omrZoneIndex). The table is allocated
+     * once at its full size, so collector threads can read it without locking.
+     */
+    static JS::Zone** zoneTable;
+    static bool registerZone(JS::Zone* zone, uint32_t* indexp);
+    static void unregisterZone(uint32_t index);
+    static JS::Zone* zoneFromIndex(uint32_t index) {
+        MOZ_ASSERT(zoneTable[index]);
+        return zoneTable[index];
+    }
+
+    /*
+     * The reserved address range of the scavenger's new space. It is fixed
+     * once the heap is initialized, so the JIT bakes it into its barrier
+     * checks. The size is zero when running a flat (non-generational) heap.
+     */
+    static JS_FRIEND_DATA(uintptr_t) newSpaceBase;
+    static JS_FRIEND_DATA(uintptr_t) newSpaceSize;
+
+    static bool isGenerational() { return newSpaceSize != 0; }
+    static bool isInNewSpace(const void* p) { return uintptr_t(p) - newSpaceBase < newSpaceSize; }
+
+    /* Read the heap and new space bounds out of the OMR heap; see gc/StoreBuffer.cpp. */
+    static void updateGenerationalBounds();
+
+    /* The reserved address range of the whole OMR heap. */
+    static uintptr_t heapBase;
+    static uintptr_t heapSize;
+
+    static bool isInHeap(const void* p) { return uintptr_t(p) - heapBase < heapSize; }
+
+    /*
+     * Free the slots or elements of a native object. Buffers in the OMR heap
+     * are reclaimed by the collector; only malloc'd ones are freed here.
+     */
+    static void freeObjectBuffer(void* p) {
+        if (!isInHeap(p))
+            js_free(p);
+    }
+
+    /*
+     * Post barrier entry points. Owned slots and elements remember their
+     * (tenured) owner in OMR's remembered set; edges with no owning cell go
+     * to the runtime's StoreBuffer.
+     */
+    static void rememberObject(Cell* owner);
+    static void putValueEdge(JS::Value* vp);
+    static void unputValueEdge(JS::Value* vp);
+    static void putCellEdge(Cell** cellp);
+    static void unputCellEdge(Cell** cellp);
+
+    static MOZ_ALWAYS_INLINE void postBarrierOwned(Cell* owner, const void* target) {
+        if (isInNewSpace(target) && !isInNewSpace(owner) && !owner->isOmrRemembered())
+            rememberObject(owner);
+    }
+
+    /*
+     * Concurrent mark support. Every zone's needsIncrementalBarrier flag is
+     * set while OMR's concurrent mark is running, which also switches on the
+     * JIT's pre barriers. Cells overwritten meanwhile are buffered and marked
+     * by the collector, so everything reachable when marking began survives.
+     */
+    static bool concurrentMarking;
+    static bool isConcurrentMarking() { return concurrentMarking; }
+    static void concurrentWriteBarrierPre(Cell* thing);
+    // Buffers the GC things held by |obj|'s trace hook, for private pointers
+    // whose referents are only reachable through that hook.
+    static void concurrentWriteBarrierPreChildren(JSObject* obj);
+    // Whether OMR may kick off concurrent mark cycles. This has no effect
+    // unless the collector was configured for concurrent mark at startup.
+    static void setConcurrentMarkEnabled(bool enabled);
+    static bool isConcurrentMarkEnabled();
+
+    /*
+     * Call |op| on every cell of |zone|, OmrBuffers included, with exclusive
+     * VM access held so that no other thread allocates meanwhile. |op| must
+     * not allocate.
+     */
+    static void forEachCellInZone(JS::Zone* zone, void (*op)(Cell* cell, void* data), void* data);
 };
 //#endif // ! OMR Arena replacemnt helpers
 
+/*
+ * The dynamic slots and elements of native objects live in OMR heap cells of
+ * their own, allocated tenured so that the scavenger never moves them. A
+ * buffer is marked by its owner and its contents are traced by its owner, so
+ * it has no trace kind. The compactor does move buffers: |self_| holds the
+ * address a buffer had before compaction, for updating its owner's pointer.
+ */
+class OmrBuffer
+{
+    Cell::Flags flags_;
+    uint32_t nbytes_;
+#if JS_BITS_PER_WORD == 32
+    uint32_t padding_;
+#endif
+    OmrBuffer* self_;
+
+  public:
+    static OmrBuffer* fromData(const void* data) {
+        return reinterpret_cast<OmrBuffer*>(uintptr_t(data) - sizeof(OmrBuffer));
+    }
+
+    void init(uint32_t zoneIndex, uint32_t nbytes) {
+        flags_ = Cell::flagsForAllocKind(AllocKind(Cell::OmrBufferKind), zoneIndex);
+        nbytes_ = nbytes;
+        self_ = this;
+    }
+
+    void* data() { return reinterpret_cast<uint8_t*>(this) + sizeof(OmrBuffer); }
+    size_t sizeInBytes() const { return nbytes_; }
+    size_t dataBytes() const { return nbytes_ - sizeof(OmrBuffer); }
+
+    OmrBuffer* addressBeforeCompaction() const { return self_; }
+    void updateAddressAfterCompaction() { self_ = this; }
+};
+
+static_assert(sizeof(OmrBuffer) % sizeof(JS::Value) == 0,
+              "The data of an OmrBuffer must be aligned for Values");
+
+static_assert(size_t(AllocKind::LIMIT) < Cell::OmrBufferKind,
+              "The alloc kind field must hold every AllocKind and OmrBufferKind");
+static_assert((Cell::OmrAllocKindMask & Cell::OmrEyeCatcher) == 0,
+              "The eyecatcher must not overlap the alloc kind field");
+static_assert(((Cell::OmrAllocKindMask | Cell::OmrEyeCatcher) << Cell::OmrMetadataShift) <
+              (uintptr_t(1) << Cell::OmrZoneIndexShift),
+              "The zone index must not overlap the alloc kind or the eyecatcher");
+static_assert(Cell::OmrZoneIndexShift + Cell::OmrZoneIndexBits <= JS_BITS_PER_WORD,
+              "The zone index must fit in the header word");
+
 #ifndef OMR // Arenas
 
 /*
@@ -496,15 +681,30 @@ struct Chunk
 
 /*
  * Tracks the used sizes for owned heap data and automatically maintains the
- * memory usage relationship between GCRuntime and Zones.
+ * memory usage relationship between GCRuntime and Zones. OMR does its own
+ * allocation accounting, so the counts are taken while sweeping and hold the
+ * live size as of the last collection.
  */
 class HeapUsage
 {
+    HeapUsage* const parent_;
+    size_t gcBytes_;
+
   public:
     explicit HeapUsage(HeapUsage* parent)
+      : parent_(parent),
+        gcBytes_(0)
     {}
 
-    size_t gcBytes() const { return 0; }
+    size_t gcBytes() const { return gcBytes_; }
+
+    void addGCBytes(size_t nbytes) {
+        gcBytes_ += nbytes;
+        if (parent_)
+            parent_->addGCBytes(nbytes);
+    }
+
+    void resetGCBytes() { gcBytes_ = 0; }
 };
 
 #ifndef OMR // Arenas
@@ -556,15 +756,13 @@ Cell::runtimeFromAnyThread() const
 inline JS::Zone*
 Cell::zoneFromAnyThread() const
 {
-    // OMRTODO: Proper zones
-    return OmrGcHelper::zone;
+    return OmrGcHelper::zoneFromIndex(omrZoneIndex());
 }
 
 inline JS::Zone*
 Cell::zone() const
 {
-    // OMRTODO: Use multiple zones obtained from a thread context
-    return OmrGcHelper::zone;
+    return OmrGcHelper::zoneFromIndex(omrZoneIndex());
 }
 
 inline JS::shadow::Runtime*
@@ -643,7 +841,7 @@ Cell::getTraceKind() const
 
 /* static */ MOZ_ALWAYS_INLINE bool
 Cell::needWriteBarrierPre(JS::Zone* zone) {
-    return false;
+    return JS::shadow::Zone::asShadowZone(zone)->needsIncrementalBarrier();
 }
 
 /* static */ MOZ_ALWAYS_INLINE TenuredCell*
@@ -719,11 +917,13 @@ TenuredCell::isInsideZone(JS::Zone* zone) const
 
 #endif // ! OMR
 
-// OMRTODO: Implement write barriers
-
 /* static */ MOZ_ALWAYS_INLINE void
 TenuredCell::readBarrier(TenuredCell* thing)
 {
+    // A weak edge read during concurrent mark makes the target strongly
+    // reachable, so it has to be marked like an overwritten edge.
+    if (thing && OmrGcHelper::isConcurrentMarking())
+        OmrGcHelper::concurrentWriteBarrierPre(thing);
 }
 
 void
@@ -732,6 +932,8 @@ AssertSafeToSkipBarrier(TenuredCell* thing);
 /* static */ MOZ_ALWAYS_INLINE void
 TenuredCell::writeBarrierPre(TenuredCell* thing)
 {
+    if (thing && OmrGcHelper::isConcurrentMarking())
+        OmrGcHelper::concurrentWriteBarrierPre(thing);
 }
 
 static MOZ_ALWAYS_INLINE void
@@ -742,6 +944,19 @@ AssertValidToSkipBarrier(TenuredCell* thing)
 /* static */ MOZ_ALWAYS_INLINE void
 TenuredCell::writeBarrierPost(void* cellp, TenuredCell* prior, TenuredCell* next)
 {
+    // Nothing to remember if the edge location itself is in new space; the
+    // scavenger will trace it when it copies the owner.
+    if (OmrGcHelper::isInNewSpace(cellp))
+        return;
+
+    if (next && OmrGcHelper::isInNewSpace(next)) {
+        if (!prior || !OmrGcHelper::isInNewSpace(prior))
+            OmrGcHelper::putCellEdge(static_cast<Cell**>(cellp));
+        return;
+    }
+
+    if (prior && OmrGcHelper::isInNewSpace(prior))
+        OmrGcHelper::unputCellEdge(static_cast<Cell**>(cellp));
 }
 
 #ifdef DEBUG
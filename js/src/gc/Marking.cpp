@@ -540,6 +540,10 @@ js::TraceProcessGlobalRoot(JSTracer* trc, T* thing, const char* name)
     // things so they do not need to go through the mark stack and may simply
     // be marked directly.  Moreover, well-known symbols can refer only to
     // permanent atoms, so likewise require no subsquent marking.
+    // The compaction tracer rewrites these roots itself: they are traced by
+    // value here and could not be updated in place.
+    if (trc->isOmrCompactingTracer())
+        return;
     CheckTracedThing(trc, *ConvertToBase(&thing));
 	if (trc->isOmrMarkingTracer())
 		return static_cast<omrjs::OMRGCMarker*>(trc)->traverse(ConvertToBase(&thing));
@@ -565,6 +569,11 @@ js::TraceGenericPointerRoot(JSTracer* trc, Cell** thingp, const char* name)
     MOZ_ASSERT(thingp);
     if (!*thingp)
         return;
+#if defined(OMR_GC_MODRON_COMPACTION)
+    // The referent may have moved, so its trace kind cannot be read yet.
+    if (trc->isOmrCompactingTracer())
+        return static_cast<omrjs::OMRCompactFixupTracer*>(trc)->traverse(thingp);
+#endif
     TraceRootFunctor f;
     DispatchTraceKindTyped(f, (*thingp)->getTraceKind(), trc, thingp, name);
 }
@@ -583,6 +592,10 @@ js::TraceManuallyBarrieredGenericPointerEdge(JSTracer* trc, Cell** thingp, const
     MOZ_ASSERT(thingp);
     if (!*thingp)
         return;
+#if defined(OMR_GC_MODRON_COMPACTION)
+    if (trc->isOmrCompactingTracer())
+        return static_cast<omrjs::OMRCompactFixupTracer*>(trc)->traverse(thingp);
+#endif
     TraceManuallyBarrieredEdgeFunctor f;
     DispatchTraceKindTyped(f, (*thingp)->getTraceKind(), trc, thingp, name);
 }
@@ -604,6 +617,10 @@ DispatchToTracer(JSTracer* trc, T* thingp, const char* name)
 #undef IS_SAME_TYPE_OR
 	if (trc->isOmrMarkingTracer())
 		return static_cast<omrjs::OMRGCMarker*>(trc)->traverse(thingp);
+#if defined(OMR_GC_MODRON_COMPACTION)
+    else if (trc->isOmrCompactingTracer())
+        return static_cast<omrjs::OMRCompactFixupTracer*>(trc)->traverse(thingp);
+#endif
     else if (trc->isMarkingTracer())
         return DoMarking(static_cast<GCMarker*>(trc), *thingp);
     else if (trc->isTenuringTracer())
@@ -2119,12 +2136,8 @@ template <typename T>
 void
 TenuringTracer::traverse(T** tp)
 {
-}
-
-template <>
-void
-TenuringTracer::traverse(JSObject** objp)
-{
+    if (*tp && OmrGcHelper::isInNewSpace(*tp))
+        copyEdge(reinterpret_cast<Cell**>(tp));
 }
 
 template <typename S>
@@ -2209,24 +2222,42 @@ IsMarkedInternalCommon(void* thingp)
 	return ((MM_ParallelGlobalGC*)env->getExtensions()->getGlobalCollector())->getMarkingScheme()->isMarked((omrobjectptr_t)(thingp));
 }
 
-bool
-js::gc::IsAboutToBeFinalizedDuringSweep(TenuredCell& tenured)
+// The mark bit looked up is the referent's, not that of the edge pointing to it.
+template <typename T>
+static bool
+IsMarkedInternal(T** thingp)
 {
-    return !tenured.isMarked();
+    return IsMarkedInternalCommon((void*)(*thingp));
 }
 
+template <typename S>
+struct IsMarkedFunctor : public IdentityDefaultAdaptor<S> {
+    template <typename T> S operator()(T* t, bool* rv) {
+        *rv = IsMarkedInternalCommon((void*)t);
+        return js::gc::RewrapTaggedPointer<S, T>::wrap(t);
+    }
+};
+
 template <typename T>
 static bool
-IsAboutToBeFinalizedInternal(T** thingp)
+IsMarkedInternal(T* thingp)
 {
-    return !IsMarkedInternalCommon((void*)(*thingp));
+    bool rv = true;
+    *thingp = DispatchTyped(IsMarkedFunctor<T>(), *thingp, &rv);
+    return rv;
+}
+
+bool
+js::gc::IsAboutToBeFinalizedDuringSweep(TenuredCell& tenured)
+{
+    return !tenured.isMarked();
 }
 
 template <typename T>
 static bool
 IsAboutToBeFinalizedInternal(T* thingp)
 {
-    return !IsMarkedInternalCommon((void*)thingp);
+    return !IsMarkedInternal(thingp);
 }
 
 namespace js {
@@ -2235,21 +2266,21 @@ namespace gc {
 bool
 IsMarkedCell(const TenuredCell* const thingp)
 {
-	return IsMarkedUnbarriered(thingp);
+	return IsMarkedInternalCommon((void *)thingp);
 }
 
 template <typename T>
 bool
 IsMarkedUnbarriered(T* thingp)
 {
-    return IsMarkedInternalCommon((void *)thingp);
+    return IsMarkedInternal(ConvertToBase(thingp));
 }
 
 template <typename T>
 bool
 IsMarked(WriteBarrieredBase<T>* thingp)
 {
-    return IsMarkedInternalCommon((void *)thingp->unsafeUnbarrieredForTracing());
+    return IsMarkedInternal(ConvertToBase(thingp->unsafeUnbarrieredForTracing()));
 }
 
 template <typename T>
@@ -847,6 +847,20 @@ DeallocateMappedContent(void* p, size_t length)
 #error "Memory mapping functions are not defined for your OS."
 #endif
 
+bool
+MarkPagesHuge(void* p, size_t size)
+{
+    MOZ_ASSERT(OffsetFromAligned(p, SystemPageSize()) == 0);
+#if defined(XP_LINUX) && defined(MADV_HUGEPAGE)
+    // The kernel only uses huge pages for the aligned huge page-sized ranges
+    // inside the advised region, and falls back to normal pages when it has no
+    // huge pages to spare.
+    return madvise(p, size, MADV_HUGEPAGE) == 0;
+#else
+    return false;
+#endif
+}
+
 void
 ProtectPages(void* p, size_t size)
 {
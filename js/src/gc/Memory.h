@@ -31,6 +31,11 @@ bool MarkPagesUnused(void* p, size_t size);
 // platforms.
 void MarkPagesInUse(void* p, size_t size);
 
+// Ask the OS to back the given pages with transparent huge pages. This is
+// only advice, and returns false where it isn't supported, in which case the
+// pages keep using the normal page size.
+bool MarkPagesHuge(void* p, size_t size);
+
 // Returns #(hard faults) + #(soft faults)
 size_t GetPageFaultCount();
 
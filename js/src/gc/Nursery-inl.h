@@ -12,6 +12,7 @@
 
 #include "jscntxt.h"
 
+#include "gc/Barrier.h"
 #include "gc/Heap.h"
 #include "gc/Zone.h"
 #include "js/TracingAPI.h"
@@ -49,6 +50,23 @@ ReallocateObjectBuffer(ExclusiveContext* cx, JSObject* obj, T* oldBuffer,
     return (T*)realloc(oldBuffer, sizeof(T) * newCount);
 }
 
+// Dynamic slots and elements go in the OMR heap, see gc::OmrBuffer.
+template <>
+inline HeapSlot*
+AllocateObjectBuffer<HeapSlot>(ExclusiveContext* cx, JSObject* obj, uint32_t count)
+{
+    return cx->zone()->runtimeFromAnyThread()->gc.nursery.allocateSlots(cx, count);
+}
+
+template <>
+inline HeapSlot*
+ReallocateObjectBuffer<HeapSlot>(ExclusiveContext* cx, JSObject* obj, HeapSlot* oldBuffer,
+                                 uint32_t oldCount, uint32_t newCount)
+{
+    return cx->zone()->runtimeFromAnyThread()->gc.nursery.reallocateSlots(cx, oldBuffer,
+                                                                         oldCount, newCount);
+}
+
 } // namespace js
 
 #endif /* gc_Nursery_inl_h */
@@ -26,6 +26,7 @@
 #if defined(DEBUG)
 #include "vm/EnvironmentObject.h"
 #endif
+#include "vm/HelperThreads.h"
 #include "vm/Time.h"
 #include "vm/TypedArrayObject.h"
 #include "vm/TypeInference.h"
@@ -35,6 +36,15 @@
 #include "vm/NativeObject-inl.h"
 
 #include "omrgc.h"
+#include "omrgcconsts.h"
+#include "omrthread.h"
+
+#include "CollectorLanguageInterfaceImpl.hpp"
+#include "EnvironmentBase.hpp"
+#include "GCExtensionsBase.hpp"
+#if defined(OMR_GC_THREAD_LOCAL_HEAP)
+#include "LanguageThreadLocalHeap.hpp"
+#endif /* OMR_GC_THREAD_LOCAL_HEAP */
 
 using namespace js;
 using namespace gc;
@@ -47,6 +57,80 @@ using mozilla::PodZero;
 
 OMR_VMThread* js::Nursery::omrVMThread = nullptr;
 OMR_VM* js::Nursery::omrVM = nullptr;
+AutoLockForExclusiveAccess* js::Nursery::collectorExclusiveAccess = nullptr;
+
+/*
+ * Helper threads allocate while holding the exclusive access lock, so a
+ * collection takes that lock before it stops the heap, and hands it to the
+ * collector. This holds it for a collection the main thread may trigger.
+ */
+class MOZ_RAII AutoCollectorExclusiveAccess
+{
+	AutoLockForExclusiveAccess lock;
+
+  public:
+	explicit AutoCollectorExclusiveAccess(JSRuntime* rt)
+	  : lock(rt)
+	{
+		MOZ_ASSERT(!Nursery::collectorExclusiveAccess);
+		Nursery::collectorExclusiveAccess = &lock;
+	}
+
+	~AutoCollectorExclusiveAccess() {
+		Nursery::collectorExclusiveAccess = nullptr;
+	}
+};
+
+/*
+ * A collection holds the VM thread list mutex for as long as it has exclusive
+ * VM access, flushing every thread's TLH. A helper thread holds the mutex
+ * while it allocates and writes the new cell's header, so collections only
+ * ever see its cells whole; the zones it allocates in are pinned by the
+ * collector until they are merged.
+ */
+class MOZ_RAII AutoHelperThreadHeapAccess
+{
+	bool onHelperThread;
+
+  public:
+	explicit AutoHelperThreadHeapAccess(ExclusiveContext* cx)
+	  : onHelperThread(cx->helperThread() != nullptr)
+	{
+		if (onHelperThread)
+			omrthread_monitor_enter(Nursery::omrVM->_vmThreadListMutex);
+	}
+
+	~AutoHelperThreadHeapAccess() {
+		if (onHelperThread)
+			omrthread_monitor_exit(Nursery::omrVM->_vmThreadListMutex);
+	}
+};
+
+static OMR_VMThread*
+OmrVMThreadFor(ExclusiveContext* cx)
+{
+	HelperThread* helperThread = cx->helperThread();
+	if (!helperThread)
+		return Nursery::omrVMThread;
+	MOZ_ASSERT(helperThread->omrVMThread);
+	return helperThread->omrVMThread;
+}
+
+/* static */ OMR_VMThread*
+js::Nursery::attachThread(const char* threadName)
+{
+	MM_GCExtensionsBase* extensions = MM_GCExtensionsBase::getExtensions(Nursery::omrVM);
+	MM_CollectorLanguageInterfaceImpl* cli = (MM_CollectorLanguageInterfaceImpl *)extensions->collectorLanguageInterface;
+	return cli->attachVMThread(Nursery::omrVM, threadName, 0);
+}
+
+/* static */ void
+js::Nursery::detachThread(OMR_VMThread* thread)
+{
+	MM_GCExtensionsBase* extensions = MM_GCExtensionsBase::getExtensions(Nursery::omrVM);
+	MM_CollectorLanguageInterfaceImpl* cli = (MM_CollectorLanguageInterfaceImpl *)extensions->collectorLanguageInterface;
+	cli->detachVMThread(Nursery::omrVM, thread, 0);
+}
 
 void
 js::Nursery::disable()
@@ -54,18 +138,37 @@ js::Nursery::disable()
 
 }
 
+/* static */ void
+js::Nursery::collectHeap(bool shrinking)
+{
+	/* OMR only compacts an explicit collection when it is asked to be aggressive. */
+	uint32_t gcCode = shrinking ? J9MMCONSTANT_EXPLICIT_GC_NATIVE_OUT_OF_MEMORY : J9MMCONSTANT_EXPLICIT_GC_SYSTEM_GC;
+	AutoCollectorExclusiveAccess access(OmrGcHelper::runtime->rt);
+	OMR_GC_SystemCollect(Nursery::omrVMThread, gcCode);
+}
+
 JSObject*
-js::Nursery::allocateObject(JSContext* cx, size_t size, size_t numDynamic, const js::Class* clasp, bool canGC)
+js::Nursery::allocateObject(ExclusiveContext* cx, AllocKind kind, size_t size, size_t numDynamic, const js::Class* clasp, bool canGC, bool tenured)
 {
+	/* Only the main thread collects. Helper threads' cells are pinned rather than scavenged. */
+	if (!cx->isJSContext()) {
+		canGC = false;
+		tenured = true;
+	}
+
+	AutoHelperThreadHeapAccess access(cx);
 	JSObject* obj = nullptr;
+	uintptr_t flags = tenured ? OMR_GC_ALLOCATE_OBJECT_TENURED : 0;
 	if (canGC) {
-		obj = (JSObject *)OMR_GC_Allocate(Nursery::omrVMThread, 0, size, 0);
+		AutoCollectorExclusiveAccess collectorAccess(cx->asJSContext());
+		obj = (JSObject *)OMR_GC_Allocate(Nursery::omrVMThread, 0, size, flags);
 	} else {
-		obj = (JSObject *)OMR_GC_AllocateNoGC(Nursery::omrVMThread, 0, size, 0);
+		obj = (JSObject *)OMR_GC_AllocateNoGC(OmrVMThreadFor(cx), 0, size, flags);
 	}
 	if (obj) {
+		obj->setAllocKindAndZone(kind, cx->zone()->omrIndex);
 		if (numDynamic > 0) {
-			HeapSlot* slots = (HeapSlot *)malloc(numDynamic * sizeof(HeapSlot *));//OMR_GC_AllocateNoGC(Nursery::omrVMThread, 0, numDynamic * sizeof(HeapSlot *), 0);
+			HeapSlot* slots = allocateSlots(cx, numDynamic);
 			if (!slots)
 				return nullptr;
 			obj->setInitialSlotsMaybeNonNative(slots);
@@ -74,4 +177,58 @@ js::Nursery::allocateObject(JSContext* cx, size_t size, size_t numDynamic, const
 			obj->setInitialSlotsMaybeNonNative(nullptr);
 	}
 	return obj;
-}
\ No newline at end of file
+}
+
+HeapSlot*
+js::Nursery::allocateSlots(ExclusiveContext* cx, uint32_t nslots)
+{
+	AutoHelperThreadHeapAccess access(cx);
+	size_t nbytes = sizeof(OmrBuffer) + nslots * sizeof(HeapSlot);
+	OmrBuffer* buffer = (OmrBuffer *)OMR_GC_AllocateNoGC(OmrVMThreadFor(cx), 0, nbytes, OMR_GC_ALLOCATE_OBJECT_TENURED);
+	if (!buffer)
+		return js_pod_malloc<HeapSlot>(nslots);
+	buffer->init(cx->zone()->omrIndex, nbytes);
+	/* The owner may already have been scanned by the concurrent marker. */
+	if (OmrGcHelper::isConcurrentMarking())
+		OmrGcHelper::concurrentWriteBarrierPre(reinterpret_cast<Cell *>(buffer));
+	return (HeapSlot *)buffer->data();
+}
+
+HeapSlot*
+js::Nursery::reallocateSlots(ExclusiveContext* cx, HeapSlot* oldSlots, uint32_t oldCount, uint32_t newCount)
+{
+	if (!OmrGcHelper::isInHeap(oldSlots))
+		return js_pod_realloc<HeapSlot>(oldSlots, oldCount, newCount);
+
+	/* Buffers are not resized in place; a count which still fits keeps the buffer. */
+	if (newCount * sizeof(HeapSlot) <= OmrBuffer::fromData(oldSlots)->dataBytes())
+		return oldSlots;
+
+	/* The old buffer is left to the collector. */
+	HeapSlot* newSlots = allocateSlots(cx, newCount);
+	if (newSlots)
+		PodCopy(newSlots, oldSlots, oldCount);
+	return newSlots;
+}
+
+void*
+js::Nursery::addressOfPosition() const
+{
+#if defined(OMR_GC_THREAD_LOCAL_HEAP)
+	MM_EnvironmentBase* env = MM_EnvironmentBase::getEnvironment(Nursery::omrVMThread);
+	return env->_languageThreadLocalHeap.getPointerToHeapAlloc(env, true);
+#else /* OMR_GC_THREAD_LOCAL_HEAP */
+	return nullptr;
+#endif /* OMR_GC_THREAD_LOCAL_HEAP */
+}
+
+void*
+js::Nursery::addressOfCurrentEnd() const
+{
+#if defined(OMR_GC_THREAD_LOCAL_HEAP)
+	MM_EnvironmentBase* env = MM_EnvironmentBase::getEnvironment(Nursery::omrVMThread);
+	return env->_languageThreadLocalHeap.getPointerToHeapTop(env, true);
+#else /* OMR_GC_THREAD_LOCAL_HEAP */
+	return nullptr;
+#endif /* OMR_GC_THREAD_LOCAL_HEAP */
+}
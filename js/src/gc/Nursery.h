@@ -32,6 +32,8 @@ struct Zone;
 
 namespace js {
 
+class AutoLockForExclusiveAccess;
+class ExclusiveContext;
 class ObjectElements;
 class NativeObject;
 class Nursery;
@@ -50,11 +52,16 @@ namespace jit {
 class MacroAssembler;
 } // namespace jit
 
+// Traces edges for OMR's scavenger: every edge into new space is handed to
+// the scavenger to be copied and updated. |env| is the scavenging thread's
+// MM_EnvironmentStandard.
 class TenuringTracer : public JSTracer
 {
-    TenuringTracer(JSRuntime* rt, Nursery* nursery) : JSTracer(rt, (JSTracer::TracerKindTag)0, (WeakMapTraceKind)0) {}
-
   public:
+    TenuringTracer(JSRuntime* rt, void* env)
+      : JSTracer(rt, JSTracer::TracerKindTag::Tenuring, TraceWeakMapKeysValues),
+        env_(env), shouldRemember_(false)
+    {}
 
     // Returns true if the pointer was updated.
     template <typename T> void traverse(T** thingp);
@@ -62,6 +69,19 @@ class TenuringTracer : public JSTracer
 
     // The store buffers need to be able to call these directly.
     void traceObject(JSObject* src) {}
+
+    // Whether an edge traced since the last reset still points into new
+    // space, i.e. whether a tenured owner must stay remembered.
+    bool shouldRemember() const { return shouldRemember_; }
+    void resetShouldRemember() { shouldRemember_ = false; }
+
+  private:
+    // Copy or forward the new space cell at |*cellp| and update the edge.
+    // Defined in glue/CollectorLanguageInterfaceImpl.cpp.
+    void copyEdge(gc::Cell** cellp);
+
+    void* env_;
+    bool shouldRemember_;
 };
 
 /*
@@ -83,6 +103,28 @@ class Nursery
     static OMR_VMThread* omrVMThread;
     static OMR_VM* omrVM;
 
+    /*
+     * Attach the calling helper thread to the OMR VM for the length of a task
+     * which allocates GC things, or detach it again. Each attached thread
+     * allocates through a TLH of its own. The main thread is attached by
+     * OMR_Initialize_VM, as omrVMThread.
+     */
+    static OMR_VMThread* attachThread(const char* threadName);
+    static void detachThread(OMR_VMThread* thread);
+
+    /*
+     * The exclusive access lock the main thread holds across a collection it
+     * triggered, for the collector to use rather than locking again; null
+     * when no such collection is running.
+     */
+    static AutoLockForExclusiveAccess* collectorExclusiveAccess;
+
+    /*
+     * Run a global collection of the OMR heap on the main thread. A shrinking
+     * collection asks OMR to compact; see GCRuntime::isCompactingGCEnabled.
+     */
+    static void collectHeap(bool shrinking);
+
     explicit Nursery(JSRuntime* rt) {}
     ~Nursery() {}
 
@@ -112,10 +154,25 @@ class Nursery
     }
 
     /*
-     * Allocate and return a pointer to a new GC object with its |slots|
-     * pointer pre-filled. Returns nullptr if the Nursery is full.
+     * Allocate and return a pointer to a new GC thing of |kind| in cx's zone,
+     * with its header set and, for objects, its |slots| pointer pre-filled.
+     * Returns nullptr if the Nursery is full. Only objects may be placed in
+     * new space; everything else, and objects that asked for the tenured
+     * heap, must pass |tenured|. Helper threads never collect and always
+     * allocate tenured.
+     */
+    JSObject* allocateObject(ExclusiveContext* cx, gc::AllocKind kind, size_t size, size_t numDynamic,
+                             const js::Class* clasp, bool canGC, bool tenured = false);
+
+    /*
+     * Allocate the dynamic slots or elements of an object in cx's zone as a
+     * gc::OmrBuffer, falling back to the malloc heap when the OMR heap is
+     * full; free the result with OmrGcHelper::freeObjectBuffer. These never
+     * collect, as the owner may not be initialized yet.
      */
-    JSObject* allocateObject(JSContext* cx, size_t size, size_t numDynamic, const js::Class* clasp, bool canGC);
+    HeapSlot* allocateSlots(ExclusiveContext* cx, uint32_t nslots);
+    HeapSlot* reallocateSlots(ExclusiveContext* cx, HeapSlot* oldSlots,
+                              uint32_t oldCount, uint32_t newCount);
 
     /* Allocate a buffer for a given zone, using the nursery if possible. */
     void* allocateBuffer(JS::Zone* zone, uint32_t nbytes) { return malloc(nbytes); }
@@ -192,11 +249,14 @@ class Nursery
      */
     JSRuntime* runtime_;
 
-    void* addressOfCurrentEnd() const {
-        return nullptr;
-    }
-
-	void* addressOfPosition() const { return nullptr; }
+    /*
+     * The JIT allocates inline by bumping the main thread's OMR thread-local
+     * heap. These return the addresses of that TLH's alloc and top pointers,
+     * which are stable for the lifetime of the OMR_VMThread, or nullptr if
+     * the collector was built without TLH support.
+     */
+    void* addressOfCurrentEnd() const;
+    void* addressOfPosition() const;
 
     friend class jit::MacroAssembler;
 };
@@ -82,6 +82,8 @@ class NurseryAwareHashMap
     MOZ_MUST_USE bool init(uint32_t len = 16) { return map.init(len); }
 
     bool empty() const { return map.empty(); }
+    uint32_t count() const { return map.count(); }
+    void clear() { map.clear(); }
     Ptr lookup(const Lookup& l) const { return map.lookup(l); }
     void remove(Ptr p) { map.remove(p); }
     Range all() const { return map.all(); }
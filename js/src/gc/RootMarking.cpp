@@ -24,6 +24,7 @@
 #include "js/HashTable.h"
 #include "vm/Debugger.h"
 #include "vm/JSONParser.h"
+#include "vm/RegExpObject.h"
 
 #include "jsgcinlines.h"
 #include "jsobjinlines.h"
@@ -324,25 +325,48 @@ js::gc::GCRuntime::traceRuntimeCommon(JSTracer* trc, TraceOrMarkRuntime traceOrM
 {
     MOZ_ASSERT(!rt->mainThread.suppressGC);
 
-    {
-        gcstats::AutoPhase ap(stats, gcstats::PHASE_MARK_STACK);
+    traceRuntimeStacks(trc);
+    traceRuntimeJitActivations(trc);
+    traceRuntimeGlobals(trc);
+    traceRuntimeCompartments(trc, traceOrMark);
+    traceEmbeddingRoots(trc, traceOrMark);
+}
 
-        // Trace active interpreter and JIT stack roots.
-        MarkInterpreterActivations(rt, trc);
-        jit::MarkJitActivations(rt, trc);
+// The pieces of traceRuntimeCommon below touch disjoint root sets, so a
+// parallel collector may trace them on different threads at once.
 
-        // Trace legacy C stack roots.
-        AutoGCRooter::traceAll(trc);
+void
+js::gc::GCRuntime::traceRuntimeStacks(JSTracer* trc)
+{
+    gcstats::AutoPhase ap(stats, gcstats::PHASE_MARK_STACK);
 
-        for (RootRange r = rootsHash.all(); !r.empty(); r.popFront()) {
-            const RootEntry& entry = r.front();
-            TraceRoot(trc, entry.key(), entry.value());
-        }
+    // Trace active interpreter stack roots.
+    MarkInterpreterActivations(rt, trc);
 
-        // Trace C stack roots.
-        MarkExactStackRoots(rt, trc);
+    // Trace legacy C stack roots.
+    AutoGCRooter::traceAll(trc);
+
+    for (RootRange r = rootsHash.all(); !r.empty(); r.popFront()) {
+        const RootEntry& entry = r.front();
+        TraceRoot(trc, entry.key(), entry.value());
     }
 
+    // Trace C stack roots.
+    MarkExactStackRoots(rt, trc);
+}
+
+void
+js::gc::GCRuntime::traceRuntimeJitActivations(JSTracer* trc)
+{
+    gcstats::AutoPhase ap(stats, gcstats::PHASE_MARK_STACK);
+
+    // Trace active JIT stack roots.
+    jit::MarkJitActivations(rt, trc);
+}
+
+void
+js::gc::GCRuntime::traceRuntimeGlobals(JSTracer* trc)
+{
     // Trace runtime global roots.
     MarkPersistentRooted(rt, trc);
 
@@ -353,17 +377,29 @@ js::gc::GCRuntime::traceRuntimeCommon(JSTracer* trc, TraceOrMarkRuntime traceOrM
     // same struct as the JSRuntime, but is still split for historical reasons.
     rt->contextFromMainThread()->mark(trc);
 
-    // Trace all compartment roots, but not the compartment itself; it is
-    // marked via the parent pointer if traceRoots actually traces anything.
-    for (CompartmentsIter c(rt, SkipAtoms); !c.done(); c.next())
-        c->traceRoots(trc, traceOrMark);
-
     // Trace SPS.
     rt->spsProfiler.trace(trc);
 
+    // Trace the programs shared by every compartment's regexps.
+    if (rt->regExpCodeCache)
+        rt->regExpCodeCache->trace(trc);
+
     // Trace helper thread roots.
     HelperThreadState().trace(trc);
+}
 
+void
+js::gc::GCRuntime::traceRuntimeCompartments(JSTracer* trc, TraceOrMarkRuntime traceOrMark)
+{
+    // Trace all compartment roots, but not the compartment itself; it is
+    // marked via the parent pointer if traceRoots actually traces anything.
+    for (CompartmentsIter c(rt, SkipAtoms); !c.done(); c.next())
+        c->traceRoots(trc, traceOrMark);
+}
+
+void
+js::gc::GCRuntime::traceEmbeddingRoots(JSTracer* trc, TraceOrMarkRuntime traceOrMark)
+{
     // Trace the embedding's black and gray roots.
     if (!rt->isHeapMinorCollecting()) {
         gcstats::AutoPhase ap(stats, gcstats::PHASE_MARK_EMBEDDING);
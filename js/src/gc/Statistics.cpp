@@ -16,10 +16,14 @@
 #include <stdarg.h>
 #include <stdio.h>
 
+#include "jsfriendapi.h"
 #include "jsprf.h"
 #include "jsutil.h"
 
+#include "gc/GCRuntime.h"
 #include "gc/Memory.h"
+#include "gc/Zone.h"
+#include "threading/LockGuard.h"
 #include "vm/Debugger.h"
 #include "vm/HelperThreads.h"
 #include "vm/Runtime.h"
@@ -31,17 +35,503 @@ using namespace js::gcstats;
 
 using mozilla::DebugOnly;
 using mozilla::MakeRange;
+using mozilla::Max;
 using mozilla::PodArrayZero;
+using mozilla::PodCopy;
 using mozilla::PodZero;
 
-/*
- * If this fails, then you can either delete this assertion and allow all
- * larger-numbered reasons to pile up in the last telemetry bucket, or switch
- * to GC_REASON_3 and bump the max value.
- */
+static const struct PhaseInfo {
+    Phase index;
+    const char* name;
+} phases[] = {
+    { PHASE_MUTATOR, "Mutator Running" },
+    { PHASE_GC_BEGIN, "Begin Callback" },
+    { PHASE_WAIT_BACKGROUND_THREAD, "Wait Background Thread" },
+    { PHASE_MARK_DISCARD_CODE, "Mark Discard Code" },
+    { PHASE_RELAZIFY_FUNCTIONS, "Relazify Functions" },
+    { PHASE_PURGE, "Purge" },
+    { PHASE_MARK, "Mark" },
+    { PHASE_UNMARK, "Unmark" },
+    { PHASE_MARK_DELAYED, "Mark Delayed" },
+    { PHASE_SWEEP, "Sweep" },
+    { PHASE_SWEEP_MARK, "Mark During Sweeping" },
+    { PHASE_SWEEP_MARK_TYPES, "Mark Types During Sweeping" },
+    { PHASE_SWEEP_MARK_INCOMING_BLACK, "Mark Incoming Black Pointers" },
+    { PHASE_SWEEP_MARK_WEAK, "Mark Weak" },
+    { PHASE_SWEEP_MARK_INCOMING_GRAY, "Mark Incoming Gray Pointers" },
+    { PHASE_SWEEP_MARK_GRAY, "Mark Gray" },
+    { PHASE_SWEEP_MARK_GRAY_WEAK, "Mark Gray and Weak" },
+    { PHASE_FINALIZE_START, "Finalize Start Callbacks" },
+    { PHASE_WEAK_ZONEGROUP_CALLBACK, "Per-Slice Weak Callback" },
+    { PHASE_WEAK_COMPARTMENT_CALLBACK, "Per-Compartment Weak Callback" },
+    { PHASE_SWEEP_ATOMS, "Sweep Atoms" },
+    { PHASE_SWEEP_SYMBOL_REGISTRY, "Sweep Symbol Registry" },
+    { PHASE_SWEEP_COMPARTMENTS, "Sweep Compartments" },
+    { PHASE_SWEEP_DISCARD_CODE, "Sweep Discard Code" },
+    { PHASE_SWEEP_INNER_VIEWS, "Sweep Inner Views" },
+    { PHASE_SWEEP_CC_WRAPPER, "Sweep Cross Compartment Wrappers" },
+    { PHASE_SWEEP_BASE_SHAPE, "Sweep Base Shapes" },
+    { PHASE_SWEEP_INITIAL_SHAPE, "Sweep Initial Shapes" },
+    { PHASE_SWEEP_TYPE_OBJECT, "Sweep Type Objects" },
+    { PHASE_SWEEP_BREAKPOINT, "Sweep Breakpoints" },
+    { PHASE_SWEEP_REGEXP, "Sweep Regexps" },
+    { PHASE_SWEEP_MISC, "Sweep Miscellaneous" },
+    { PHASE_SWEEP_TYPES, "Sweep type information" },
+    { PHASE_SWEEP_TYPES_BEGIN, "Sweep type tables and compilations" },
+    { PHASE_SWEEP_TYPES_END, "Free type arena" },
+    { PHASE_SWEEP_OBJECT, "Sweep Object" },
+    { PHASE_SWEEP_STRING, "Sweep String" },
+    { PHASE_SWEEP_SCRIPT, "Sweep Script" },
+    { PHASE_SWEEP_SCOPE, "Sweep Scope" },
+    { PHASE_SWEEP_SHAPE, "Sweep Shape" },
+    { PHASE_SWEEP_JITCODE, "Sweep JIT code" },
+    { PHASE_FINALIZE_END, "Finalize End Callback" },
+    { PHASE_DESTROY, "Deallocate" },
+    { PHASE_COMPACT, "Compact" },
+    { PHASE_COMPACT_MOVE, "Compact Move" },
+    { PHASE_COMPACT_UPDATE, "Compact Update" },
+    { PHASE_COMPACT_UPDATE_CELLS, "Compact Update Cells" },
+    { PHASE_GC_END, "End Callback" },
+    { PHASE_MINOR_GC, "All Minor GCs" },
+    { PHASE_EVICT_NURSERY, "Minor GCs to Evict Nursery" },
+    { PHASE_TRACE_HEAP, "Trace Heap" },
+    { PHASE_BARRIER, "Barrier" },
+    { PHASE_UNMARK_GRAY, "Unmark gray" },
+    { PHASE_MARK_ROOTS, "Mark Roots" },
+    { PHASE_BUFFER_GRAY_ROOTS, "Buffer Gray Roots" },
+    { PHASE_MARK_CCWS, "Mark Cross Compartment Wrappers" },
+    { PHASE_MARK_STACK, "Mark C and JS stacks" },
+    { PHASE_MARK_RUNTIME_DATA, "Mark Runtime-wide Data" },
+    { PHASE_MARK_EMBEDDING, "Mark Embedding" },
+    { PHASE_MARK_COMPARTMENTS, "Mark Compartments" },
+};
+
+static_assert(mozilla::ArrayLength(phases) == PHASE_LIMIT, "Every phase needs a name");
+
+static double
+t(int64_t t)
+{
+    return double(t) / PRMJ_USEC_PER_MSEC;
+}
+
+/* The phase's name as a JSON key: "Mark Roots" is "mark_roots". */
+static void
+JsonPhaseName(Phase phase, char* buffer, size_t size)
+{
+    const char* name = phases[phase].name;
+    size_t i = 0;
+    for (; name[i] && i < size - 1; i++)
+        buffer[i] = isalnum(name[i]) ? tolower(name[i]) : '_';
+    buffer[i] = '\0';
+}
+
+/* Append to |buffer|, which is freed and nulled if that fails. */
+static void
+Append(UniqueChars& buffer, const char* fmt, ...)
+{
+    if (!buffer)
+        return;
+    va_list ap;
+    va_start(ap, fmt);
+    char* appended = JS_vsprintf_append(buffer.get(), fmt, ap);
+    va_end(ap);
+    // JS_vsprintf_append reallocated or freed the old buffer.
+    (void) buffer.release();
+    buffer.reset(appended);
+}
 
 JS_PUBLIC_API(const char*)
 JS::gcreason::ExplainReason(JS::gcreason::Reason reason)
 {
-	return " ";
-}
\ No newline at end of file
+    switch (reason) {
+#define SWITCH_REASON(name)                         \
+        case JS::gcreason::name:                    \
+          return #name;
+        GCREASONS(SWITCH_REASON)
+
+        default:
+          MOZ_CRASH("bad GC reason");
+#undef SWITCH_REASON
+    }
+}
+
+Statistics::Statistics(JSRuntime* rt)
+  : runtime(rt),
+    nextKind(GC_NORMAL),
+    nextReason(JS::gcreason::NO_REASON),
+    gckind(GC_NORMAL),
+    nonincrementalReason_(nullptr),
+    sliceActive(false),
+    phaseNestingDepth(0),
+    minorGCs(0),
+    nurseryStart(0),
+    nurseryReason(JS::gcreason::NO_REASON),
+    maxPauseInInterval(0),
+    timingMutator(false),
+    mutatorStart(0),
+    gcTimeWhileTimingMutator(0),
+    sliceCallback(nullptr),
+    nurseryCollectionCallback(nullptr)
+{
+    PodArrayZero(phaseTimes);
+    PodArrayZero(phaseStartTimes);
+    PodArrayZero(parallelTimes);
+    PodArrayZero(maxParallelTimes);
+    PodArrayZero(counts);
+
+#ifdef DEBUG
+    for (size_t i = 0; i < PHASE_LIMIT; i++)
+        MOZ_ASSERT(phases[i].index == i);
+#endif
+}
+
+void
+Statistics::beginSlice()
+{
+    MOZ_ASSERT(!sliceActive);
+
+    JS::gcreason::Reason reason = nextReason;
+    if (reason == JS::gcreason::NO_REASON)
+        reason = JS::gcreason::ALLOC_TRIGGER;
+    gckind = nextKind;
+    nextKind = GC_NORMAL;
+    nextReason = JS::gcreason::NO_REASON;
+
+    // Each collection is one slice, so this never outgrows the inline storage.
+    slices.clear();
+    MOZ_ALWAYS_TRUE(slices.append(SliceData(SliceBudget::unlimited(), reason, PRMJ_Now(),
+                                            JS_GetCurrentEmbedderTime(), GetPageFaultCount(),
+                                            gc::State::NotActive)));
+    nonincrementalReason_ = "OMR collections are not incremental";
+
+    PodArrayZero(phaseTimes);
+    {
+        LockGuard<Mutex> guard(parallelLock);
+        PodArrayZero(parallelTimes);
+        PodArrayZero(maxParallelTimes);
+    }
+
+    sliceThread = ThisThread::GetId();
+    sliceActive = true;
+
+    runtime->addTelemetry(JS_TELEMETRY_GC_REASON, reason);
+
+    if (sliceCallback) {
+        (*sliceCallback)(runtime->contextFromMainThread(), JS::GC_CYCLE_BEGIN,
+                         JS::GCDescription(false, gckind, reason));
+    }
+}
+
+void
+Statistics::endSlice()
+{
+    MOZ_ASSERT(onSliceThread());
+
+    while (phaseNestingDepth)
+        endPhase(currentPhase());
+
+    SliceData& slice = slices.back();
+    slice.end = PRMJ_Now();
+    slice.endTimestamp = JS_GetCurrentEmbedderTime();
+    slice.endFaults = GetPageFaultCount();
+    slice.finalState = gc::State::NotActive;
+    PodCopy(slice.phaseTimes, phaseTimes, PHASE_LIMIT);
+
+    sliceActive = false;
+
+    maxPauseInInterval = Max(maxPauseInInterval, slice.duration());
+    if (timingMutator)
+        gcTimeWhileTimingMutator += slice.duration();
+
+    sendTelemetry();
+
+    if (sliceCallback) {
+        (*sliceCallback)(runtime->contextFromMainThread(), JS::GC_CYCLE_END,
+                         JS::GCDescription(false, gckind, slice.reason));
+    }
+
+    // The counts reported for a collection are those since the one before.
+    minorGCs = 0;
+    PodArrayZero(counts);
+}
+
+void
+Statistics::beginPhase(Phase phase)
+{
+    if (!onSliceThread())
+        return;
+
+    MOZ_ASSERT(phaseNestingDepth < MAX_NESTING);
+    phaseNesting[phaseNestingDepth++] = phase;
+    phaseStartTimes[phase] = PRMJ_Now();
+}
+
+void
+Statistics::endPhase(Phase phase)
+{
+    if (!onSliceThread())
+        return;
+
+    MOZ_ASSERT(currentPhase() == phase);
+    phaseNestingDepth--;
+    phaseTimes[phase] += PRMJ_Now() - phaseStartTimes[phase];
+}
+
+void
+Statistics::recordParallelPhase(Phase phase, int64_t duration)
+{
+    LockGuard<Mutex> guard(parallelLock);
+    parallelTimes[phase] += duration;
+    maxParallelTimes[phase] = Max(maxParallelTimes[phase], duration);
+}
+
+void
+Statistics::beginNurseryCollection(JS::gcreason::Reason reason)
+{
+    nurseryStart = PRMJ_Now();
+    nurseryReason = reason;
+
+    if (nurseryCollectionCallback) {
+        (*nurseryCollectionCallback)(runtime->contextFromMainThread(),
+                                     JS::GCNurseryProgress::GC_NURSERY_COLLECTION_START,
+                                     reason);
+    }
+}
+
+void
+Statistics::endNurseryCollection()
+{
+    int64_t us = PRMJ_Now() - nurseryStart;
+
+    count(STAT_MINOR_GC);
+    minorGCs++;
+    maxPauseInInterval = Max(maxPauseInInterval, us);
+    if (timingMutator)
+        gcTimeWhileTimingMutator += us;
+
+    runtime->addTelemetry(JS_TELEMETRY_GC_MINOR_REASON, nurseryReason);
+    if (us > 1000)
+        runtime->addTelemetry(JS_TELEMETRY_GC_MINOR_REASON_LONG, nurseryReason);
+    runtime->addTelemetry(JS_TELEMETRY_GC_MINOR_US, us);
+
+    if (nurseryCollectionCallback) {
+        (*nurseryCollectionCallback)(runtime->contextFromMainThread(),
+                                     JS::GCNurseryProgress::GC_NURSERY_COLLECTION_END,
+                                     nurseryReason);
+    }
+}
+
+bool
+Statistics::startTimingMutator()
+{
+    if (timingMutator || sliceActive)
+        return false;
+
+    timingMutator = true;
+    mutatorStart = PRMJ_Now();
+    gcTimeWhileTimingMutator = 0;
+    return true;
+}
+
+bool
+Statistics::stopTimingMutator(double& mutator_ms, double& gc_ms)
+{
+    if (!timingMutator || sliceActive)
+        return false;
+
+    int64_t total = PRMJ_Now() - mutatorStart;
+    gc_ms = t(gcTimeWhileTimingMutator);
+    mutator_ms = t(total - gcTimeWhileTimingMutator);
+    timingMutator = false;
+    return true;
+}
+
+int64_t
+Statistics::clearMaxGCPauseAccumulator()
+{
+    int64_t prior = maxPauseInInterval;
+    maxPauseInInterval = 0;
+    return prior;
+}
+
+int64_t
+Statistics::getMaxGCPauseSinceClear()
+{
+    return maxPauseInInterval;
+}
+
+JS::GCSliceCallback
+Statistics::setSliceCallback(JS::GCSliceCallback newCallback)
+{
+    JS::GCSliceCallback oldCallback = sliceCallback;
+    sliceCallback = newCallback;
+    return oldCallback;
+}
+
+JS::GCNurseryCollectionCallback
+Statistics::setNurseryCollectionCallback(JS::GCNurseryCollectionCallback newCallback)
+{
+    auto oldCallback = nurseryCollectionCallback;
+    nurseryCollectionCallback = newCallback;
+    return oldCallback;
+}
+
+/* The total pause time of the last collection. */
+int64_t
+Statistics::gcDuration() const
+{
+    int64_t total = 0;
+    for (const SliceData& slice : slices)
+        total += slice.duration();
+    return total;
+}
+
+void
+Statistics::sendTelemetry() const
+{
+    const SliceData& slice = slices.back();
+    auto phaseTime = [this](Phase phase) {
+        return uint32_t(t(Max(phaseTimes[phase], maxParallelTimes[phase])));
+    };
+
+    runtime->addTelemetry(JS_TELEMETRY_GC_IS_ZONE_GC, 0);
+    runtime->addTelemetry(JS_TELEMETRY_GC_MS, uint32_t(t(gcDuration())));
+    runtime->addTelemetry(JS_TELEMETRY_GC_MAX_PAUSE_MS, uint32_t(t(slice.duration())));
+    runtime->addTelemetry(JS_TELEMETRY_GC_SLICE_MS, uint32_t(t(slice.duration())));
+    runtime->addTelemetry(JS_TELEMETRY_GC_MARK_MS, phaseTime(PHASE_MARK));
+    runtime->addTelemetry(JS_TELEMETRY_GC_SWEEP_MS, phaseTime(PHASE_SWEEP));
+    if (phaseTimes[PHASE_COMPACT])
+        runtime->addTelemetry(JS_TELEMETRY_GC_COMPACT_MS, phaseTime(PHASE_COMPACT));
+    runtime->addTelemetry(JS_TELEMETRY_GC_MARK_ROOTS_MS, phaseTime(PHASE_MARK_ROOTS));
+    runtime->addTelemetry(JS_TELEMETRY_GC_NON_INCREMENTAL, 1);
+}
+
+UniqueChars
+Statistics::formatCompactSliceMessage() const
+{
+    if (slices.empty())
+        return nullptr;
+
+    size_t index = slices.length() - 1;
+    const SliceData& slice = slices.back();
+    UniqueChars buffer(JS_smprintf("GC Slice %u - Pause: %.3fms (@ %.3fms); Reason: %s; Times: ",
+                                   unsigned(index), t(slice.duration()),
+                                   t(slice.end - slices[0].start),
+                                   JS::gcreason::ExplainReason(slice.reason)));
+
+    const char* separator = "";
+    for (size_t i = 0; i < PHASE_LIMIT; i++) {
+        if (!slice.phaseTimes[i])
+            continue;
+        Append(buffer, "%s%s: %.3fms", separator, phases[i].name, t(slice.phaseTimes[i]));
+        separator = ", ";
+    }
+    return buffer;
+}
+
+UniqueChars
+Statistics::formatCompactSummaryMessage() const
+{
+    unsigned compartments = 0;
+    for (Zone* zone : runtime->gc.zones)
+        compartments += zone->compartments.length();
+
+    int64_t maxPause = 0;
+    for (const SliceData& slice : slices)
+        maxPause = Max(maxPause, slice.duration());
+
+    return UniqueChars(JS_smprintf("Max Pause: %.3fms; Total: %.3fms; Zones: %u; "
+                                   "Compartments: %u; MinorGCs: %u; Store Buffer Overflows: %u; "
+                                   "Kind: %s; Reason: %s",
+                                   t(maxPause), t(gcDuration()),
+                                   unsigned(runtime->gc.zones.length()), compartments, minorGCs,
+                                   counts[STAT_STOREBUFFER_OVERFLOW],
+                                   gckind == GC_SHRINK ? "Shrinking" : "Normal",
+                                   nonincrementalReason_ ? nonincrementalReason_ : "none"));
+}
+
+UniqueChars
+Statistics::formatJsonMessage(uint64_t timestamp) const
+{
+    unsigned compartments = 0;
+    for (Zone* zone : runtime->gc.zones)
+        compartments += zone->compartments.length();
+
+    int64_t maxPause = 0;
+    for (const SliceData& slice : slices)
+        maxPause = Max(maxPause, slice.duration());
+
+    unsigned zones = unsigned(runtime->gc.zones.length());
+    UniqueChars buffer(JS_smprintf("{\"timestamp\":%llu,\"max_pause\":%.3f,\"total_time\":%.3f,"
+                                   "\"zones_collected\":%u,\"total_zones\":%u,"
+                                   "\"total_compartments\":%u,\"minor_gcs\":%u,"
+                                   "\"store_buffer_overflows\":%u,"
+                                   "\"nonincremental_reason\":\"%s\",\"slices\":[",
+                                   (unsigned long long)timestamp, t(maxPause), t(gcDuration()),
+                                   zones, zones, compartments, minorGCs,
+                                   counts[STAT_STOREBUFFER_OVERFLOW],
+                                   nonincrementalReason_ ? nonincrementalReason_ : "none"));
+
+    char name[64];
+    for (size_t i = 0; i < slices.length(); i++) {
+        const SliceData& slice = slices[i];
+        Append(buffer, "%s{\"slice\":%u,\"pause\":%.3f,\"when\":%.3f,\"reason\":\"%s\","
+                       "\"page_faults\":%u,\"start_timestamp\":%.3f,\"end_timestamp\":%.3f,"
+                       "\"times\":{",
+               i ? "," : "", unsigned(i), t(slice.duration()), t(slice.start - slices[0].start),
+               JS::gcreason::ExplainReason(slice.reason), unsigned(slice.endFaults - slice.startFaults),
+               slice.startTimestamp, slice.endTimestamp);
+        const char* separator = "";
+        for (size_t phase = 0; phase < PHASE_LIMIT; phase++) {
+            if (!slice.phaseTimes[phase])
+                continue;
+            JsonPhaseName(Phase(phase), name, sizeof(name));
+            Append(buffer, "%s\"%s\":%.3f", separator, name, t(slice.phaseTimes[phase]));
+            separator = ",";
+        }
+        Append(buffer, "}}");
+    }
+
+    Append(buffer, "],\"totals\":{");
+    const char* separator = "";
+    for (size_t phase = 0; phase < PHASE_LIMIT; phase++) {
+        if (!phaseTimes[phase])
+            continue;
+        JsonPhaseName(Phase(phase), name, sizeof(name));
+        Append(buffer, "%s\"%s\":%.3f", separator, name, t(phaseTimes[phase]));
+        separator = ",";
+    }
+
+    // Time the GC worker threads other than the slice's spent in each phase.
+    Append(buffer, "},\"worker_times\":{");
+    separator = "";
+    for (size_t phase = 0; phase < PHASE_LIMIT; phase++) {
+        if (!parallelTimes[phase])
+            continue;
+        JsonPhaseName(Phase(phase), name, sizeof(name));
+        Append(buffer, "%s\"%s\":{\"total\":%.3f,\"max\":%.3f}", separator, name,
+               t(parallelTimes[phase]), t(maxParallelTimes[phase]));
+        separator = ",";
+    }
+    Append(buffer, "}}");
+    return buffer;
+}
+
+void
+AutoPhase::begin()
+{
+    onSliceThread = enabled && stats.onSliceThread();
+    start = 0;
+    if (onSliceThread)
+        stats.beginPhase(phase);
+    else if (enabled && stats.isSliceActive())
+        start = PRMJ_Now();
+}
+
+AutoPhase::~AutoPhase()
+{
+    if (onSliceThread)
+        stats.endPhase(phase);
+    else if (start)
+        stats.recordParallelPhase(phase, PRMJ_Now() - start);
+}
@@ -17,6 +17,8 @@
 
 #include "js/GCAPI.h"
 #include "js/Vector.h"
+#include "threading/Mutex.h"
+#include "threading/Thread.h"
 
 namespace js {
 
@@ -109,37 +111,77 @@ enum Stat {
 };
 
 /*
- * Struct for collecting timing statistics on a "phase tree". The tree is
- * specified as a limited DAG, but the timings are collected for the whole tree
- * that you would get by expanding out the DAG by duplicating subtrees rooted
- * at nodes with multiple parents.
+ * Struct for collecting timing statistics on the collections OMR runs.
  *
- * During execution, a child phase can be activated multiple times, and the
- * total time will be accumulated. (So for example, you can start and end
- * PHASE_MARK_ROOTS multiple times before completing the parent phase.)
+ * Every OMR global collection is a single, non-incremental slice, bracketed
+ * by the collector language interface's masterThreadGarbageCollect hooks,
+ * which also move the slice through PHASE_MARK, PHASE_SWEEP and
+ * PHASE_COMPACT. Scavenges are nursery collections, as for a minor GC.
  *
- * Incremental GC is represented by recording separate timing results for each
- * slice within the overall GC.
+ * Only the thread running the slice keeps the phase stack. Time the other
+ * GC worker threads spend in a phase during the slice is accumulated per
+ * phase, with the longest any one thread took, by recordParallelPhase.
+ * Phases entered outside a slice are not timed.
  */
 struct Statistics
 {
     static MOZ_MUST_USE bool initialize() { return true; }
 
-    explicit Statistics(JSRuntime* rt) {}
+    explicit Statistics(JSRuntime* rt);
     ~Statistics() {}
 
-    MOZ_MUST_USE bool startTimingMutator() { return true; }
-    MOZ_MUST_USE bool stopTimingMutator(double& mutator_ms, double& gc_ms) { return true; }
+    /*
+     * The kind and reason of the collection GCRuntime::gc is about to ask for.
+     * Collections OMR starts by itself, on allocation failure, are normal
+     * ALLOC_TRIGGER collections.
+     */
+    void prepareSlice(JSGCInvocationKind gckind, JS::gcreason::Reason reason) {
+        nextKind = gckind;
+        nextReason = reason;
+    }
+
+    void beginSlice();
+    void endSlice();
+
+    void beginPhase(Phase phase);
+    void endPhase(Phase phase);
+    Phase currentPhase() const {
+        return phaseNestingDepth ? phaseNesting[phaseNestingDepth - 1] : PHASE_NONE;
+    }
+
+    /* Whether the calling thread runs the slice in progress, if any. */
+    bool onSliceThread() const {
+        return sliceActive && ThisThread::GetId() == sliceThread;
+    }
+    bool isSliceActive() const { return sliceActive; }
+
+    void recordParallelPhase(Phase phase, int64_t duration);
+
+    void beginNurseryCollection(JS::gcreason::Reason reason);
+    void endNurseryCollection();
 
+    MOZ_MUST_USE bool startTimingMutator();
+    MOZ_MUST_USE bool stopTimingMutator(double& mutator_ms, double& gc_ms);
+
+    /* OMR's collections are never incremental, so they are never reset. */
     void reset(const char* reason) {
     }
-    const char* nonincrementalReason() const { return ""; }
+    const char* nonincrementalReason() const { return nonincrementalReason_; }
 
     void count(Stat s) {
+        counts[s]++;
     }
 
-    int64_t clearMaxGCPauseAccumulator() { return 0; }
-    int64_t getMaxGCPauseSinceClear() { return 0; }
+    int64_t clearMaxGCPauseAccumulator();
+    int64_t getMaxGCPauseSinceClear();
+
+    JS::GCSliceCallback setSliceCallback(JS::GCSliceCallback callback);
+    JS::GCNurseryCollectionCallback setNurseryCollectionCallback(
+        JS::GCNurseryCollectionCallback callback);
+
+    UniqueChars formatCompactSliceMessage() const;
+    UniqueChars formatCompactSummaryMessage() const;
+    UniqueChars formatJsonMessage(uint64_t timestamp) const;
 
     static const size_t MAX_NESTING = 20;
 
@@ -153,6 +195,7 @@ struct Statistics
             start(start), startTimestamp(startTimestamp),
             startFaults(startFaults)
         {
+            mozilla::PodArrayZero(phaseTimes);
         }
 
         SliceBudget budget;
@@ -162,6 +205,7 @@ struct Statistics
         int64_t start, end;
         double startTimestamp, endTimestamp;
         size_t startFaults, endFaults;
+        int64_t phaseTimes[PHASE_LIMIT];
 	
         int64_t duration() const { return end - start; }
     };
@@ -175,33 +219,91 @@ struct Statistics
     void printTotalProfileTimes() {}
 
   private:
+    JSRuntime* runtime;
+
+    JSGCInvocationKind nextKind;
+    JS::gcreason::Reason nextReason;
+
+    /* The slices of the last collection; OMR's collections have one each. */
     SliceDataVector slices;
+    JSGCInvocationKind gckind;
+    const char* nonincrementalReason_;
+
+    mozilla::Atomic<bool, mozilla::ReleaseAcquire> sliceActive;
+    Thread::Id sliceThread;
+
+    /* Time spent in each phase in the last collection, on the slice thread. */
+    int64_t phaseTimes[PHASE_LIMIT];
+    int64_t phaseStartTimes[PHASE_LIMIT];
+
+    /*
+     * Time the GC worker threads spent in each phase in the last collection,
+     * summed over the threads, and the most any one of them spent.
+     */
+    Mutex parallelLock;
+    int64_t parallelTimes[PHASE_LIMIT];
+    int64_t maxParallelTimes[PHASE_LIMIT];
+
+    Phase phaseNesting[MAX_NESTING];
+    size_t phaseNestingDepth;
+
+    /* Number of events of the given type since the last collection. */
+    unsigned int counts[STAT_LIMIT];
+
+    /* Minor GCs since the last major one, and the start of the current one. */
+    unsigned int minorGCs;
+    int64_t nurseryStart;
+    JS::gcreason::Reason nurseryReason;
+
+    int64_t maxPauseInInterval;
+
+    bool timingMutator;
+    int64_t mutatorStart;
+    int64_t gcTimeWhileTimingMutator;
+
+    JS::GCSliceCallback sliceCallback;
+    JS::GCNurseryCollectionCallback nurseryCollectionCallback;
+
+    int64_t gcDuration() const;
+    void sendTelemetry() const;
 };
 
+/*
+ * Times the enclosing scope as |phase|: on the slice thread in the phase
+ * stack, and on other threads as parallel work.
+ */
 struct MOZ_RAII AutoPhase
 {
     AutoPhase(Statistics& stats, Phase phase)
       : stats(stats), task(nullptr), phase(phase), enabled(true)
     {
+        begin();
     }
 
     AutoPhase(Statistics& stats, bool condition, Phase phase)
       : stats(stats), task(nullptr), phase(phase), enabled(condition)
     {
+        begin();
     }
 
     AutoPhase(Statistics& stats, const GCParallelTask& task, Phase phase)
       : stats(stats), task(&task), phase(phase), enabled(true)
     {
+        begin();
     }
 
-    ~AutoPhase() {
-    }
+    ~AutoPhase();
 
     Statistics& stats;
     const GCParallelTask* task;
     Phase phase;
     bool enabled;
+
+  private:
+    void begin();
+
+    bool onSliceThread;
+    int64_t start;
 };
 
 } /* namespace gcstats */
@@ -48,6 +48,14 @@ StoreBuffer::putWholeCell(Cell* cell)
 {
 }
 
+#else // ! OMR
+
+inline void
+StoreBuffer::putWholeCell(Cell* cell)
+{
+    OmrGcHelper::rememberObject(cell);
+}
+
 #endif // ! OMR
 
 } // namespace gc
@@ -0,0 +1,217 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=8 sts=4 et sw=4 tw=99:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "gc/StoreBuffer-inl.h"
+
+#include "mozilla/Assertions.h"
+
+#include <algorithm>
+
+#include "jscntxt.h"
+#include "jsgc.h"
+
+#include "gc/Marking.h"
+#include "gc/Nursery.h"
+#include "gc/Statistics.h"
+#include "vm/NativeObject.h"
+#include "vm/Runtime.h"
+
+#ifdef OMR // Writebarriers
+#include "omrcfg.h"
+#include "EnvironmentStandard.hpp"
+#include "GCExtensionsBase.hpp"
+#include "Heap.hpp"
+#if defined(OMR_GC_MODRON_SCAVENGER)
+#include "Scavenger.hpp"
+#endif /* OMR_GC_MODRON_SCAVENGER */
+#endif // OMR Writebarriers
+
+using namespace js;
+using namespace js::gc;
+
+#ifdef OMR // Writebarriers
+
+bool
+StoreBuffer::enable()
+{
+    if (isEnabled())
+        return true;
+
+    if (!values_.init() || !cells_.init()) {
+        values_.finish();
+        cells_.finish();
+        return false;
+    }
+    return true;
+}
+
+void
+StoreBuffer::disable()
+{
+    if (!isEnabled())
+        return;
+
+    clear();
+    values_.finish();
+    cells_.finish();
+}
+
+void
+StoreBuffer::clear()
+{
+    if (!isEnabled())
+        return;
+
+    values_.clear();
+    cells_.clear();
+}
+
+void
+StoreBuffer::putSlot(NativeObject* obj, int kind, int32_t start, int32_t count)
+{
+    OmrGcHelper::rememberObject(obj);
+}
+
+void
+StoreBuffer::traceEdges(JSTracer* trc)
+{
+    mozilla::ReentrancyGuard g(*this);
+    if (!isEnabled())
+        return;
+
+    for (EdgeSet::Range r = values_.all(); !r.empty(); r.popFront())
+        TraceRoot(trc, static_cast<JS::Value*>(r.front()), "store buffer value");
+    for (EdgeSet::Range r = cells_.all(); !r.empty(); r.popFront())
+        TraceGenericPointerRoot(trc, static_cast<Cell**>(r.front()), "store buffer cell");
+}
+
+void
+StoreBuffer::sweepTenuredEdges()
+{
+    mozilla::ReentrancyGuard g(*this);
+    if (!isEnabled())
+        return;
+
+    for (EdgeSet::Enum e(values_); !e.empty(); e.popFront()) {
+        const JS::Value& v = *static_cast<JS::Value*>(e.front());
+        if (!v.isObject() || !OmrGcHelper::isInNewSpace(&v.toObject()))
+            e.removeFront();
+    }
+    for (EdgeSet::Enum e(cells_); !e.empty(); e.popFront()) {
+        Cell* cell = *static_cast<Cell**>(e.front());
+        if (!cell || !OmrGcHelper::isInNewSpace(cell))
+            e.removeFront();
+    }
+}
+
+bool
+StoreBuffer::beginSweepDeadEdges()
+{
+    MOZ_ASSERT(sweepEdges_.empty());
+    if (!isEnabled())
+        return true;
+
+    if (!sweepEdges_.reserve(values_.count() + cells_.count()))
+        return false;
+    for (EdgeSet::Range r = values_.all(); !r.empty(); r.popFront())
+        sweepEdges_.infallibleAppend(r.front());
+    for (EdgeSet::Range r = cells_.all(); !r.empty(); r.popFront())
+        sweepEdges_.infallibleAppend(r.front());
+    std::sort(sweepEdges_.begin(), sweepEdges_.end());
+    return true;
+}
+
+void
+StoreBuffer::sweepDeadEdgesInRange(uintptr_t start, uintptr_t end)
+{
+    void** edge = std::lower_bound(sweepEdges_.begin(), sweepEdges_.end(),
+                                   reinterpret_cast<void*>(start));
+    for (; edge != sweepEdges_.end() && uintptr_t(*edge) < end; edge++) {
+        values_.remove(*edge);
+        cells_.remove(*edge);
+    }
+}
+
+void
+StoreBuffer::endSweepDeadEdges()
+{
+    sweepEdges_.clearAndFree();
+}
+
+void
+StoreBuffer::addSizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf, JS::GCSizes* sizes)
+{
+    sizes->storeBufferVals += values_.sizeOfExcludingThis(mallocSizeOf);
+    sizes->storeBufferCells += cells_.sizeOfExcludingThis(mallocSizeOf);
+}
+
+/* static */ void
+OmrGcHelper::updateGenerationalBounds()
+{
+    newSpaceBase = 0;
+    newSpaceSize = 0;
+
+    MM_GCExtensionsBase* extensions = MM_GCExtensionsBase::getExtensions(Nursery::omrVM);
+    uintptr_t heapTop = uintptr_t(extensions->heap->getHeapTop());
+    heapBase = uintptr_t(extensions->heap->getHeapBase());
+    heapSize = heapTop - heapBase;
+
+#if defined(OMR_GC_MODRON_SCAVENGER)
+    if (!extensions->scavengerEnabled)
+        return;
+
+    // The barrier range covers tenure space; new space is the rest of the
+    // heap reservation, on whichever side of it the scavenger put it.
+    uintptr_t oldBase = uintptr_t(extensions->_heapBaseForBarrierRange0);
+    uintptr_t oldTop = oldBase + extensions->_heapSizeForBarrierRange0;
+    if (oldBase > heapBase) {
+        newSpaceBase = heapBase;
+        newSpaceSize = oldBase - heapBase;
+    } else {
+        newSpaceBase = oldTop;
+        newSpaceSize = heapTop - oldTop;
+    }
+#endif /* OMR_GC_MODRON_SCAVENGER */
+}
+
+/* static */ void
+OmrGcHelper::rememberObject(Cell* owner)
+{
+#if defined(OMR_GC_MODRON_SCAVENGER)
+    if (!isGenerational() || isInNewSpace(owner))
+        return;
+
+    MM_GCExtensionsBase* extensions = MM_GCExtensionsBase::getExtensions(Nursery::omrVM);
+    MM_EnvironmentStandard* env = MM_EnvironmentStandard::getEnvironment(Nursery::omrVMThread);
+    extensions->scavenger->rememberObject(env, (omrobjectptr_t)owner);
+#endif /* OMR_GC_MODRON_SCAVENGER */
+}
+
+/* static */ void
+OmrGcHelper::putValueEdge(JS::Value* vp)
+{
+    runtime->storeBuffer.putValue(vp);
+}
+
+/* static */ void
+OmrGcHelper::unputValueEdge(JS::Value* vp)
+{
+    runtime->storeBuffer.unputValue(vp);
+}
+
+/* static */ void
+OmrGcHelper::putCellEdge(Cell** cellp)
+{
+    runtime->storeBuffer.putCell(cellp);
+}
+
+/* static */ void
+OmrGcHelper::unputCellEdge(Cell** cellp)
+{
+    runtime->storeBuffer.unputCell(cellp);
+}
+
+#endif // OMR Writebarriers
@@ -147,6 +147,96 @@ class ArenaCellSet
 
 inline ArenaCellSet* AllocateWholeCellSet(Arena* arena) { return nullptr; }
 
+#else // ! OMR
+
+typedef HashSet<void*, PointerHasher<void*, 3>, SystemAllocPolicy> EdgeSet;
+
+/*
+ * Under OMR, objects whose slots or elements point into new space are kept in
+ * OMR's own remembered set (see OmrGcHelper::rememberObject), so only edges
+ * with no known owning cell are buffered here: barriered pointers in malloc'd
+ * structures and the GCPtr fields of non-object cells. The scavenger treats
+ * every buffered edge as a root, then drops the edges it tenured.
+ */
+class StoreBuffer
+{
+    friend class mozilla::ReentrancyGuard;
+
+    EdgeSet values_;
+    EdgeSet cells_;
+
+    /*
+     * Past this many edges, scanning them all as roots costs more than the
+     * scavenge saves, so the scavenger percolates to a global collection.
+     */
+    static const size_t MaxEntries = 48 * 1024;
+
+#ifdef DEBUG
+    bool mEntered;
+#endif
+
+    /* Scratch space used by global GC to drop edges inside dead cells. */
+    Vector<void*, 0, SystemAllocPolicy> sweepEdges_;
+
+    void put(EdgeSet& set, void* edge) {
+        mozilla::ReentrancyGuard g(*this);
+        AutoEnterOOMUnsafeRegion oomUnsafe;
+        if (!set.put(edge))
+            oomUnsafe.crash("Failed to allocate for StoreBuffer::put.");
+    }
+
+    void unput(EdgeSet& set, void* edge) {
+        mozilla::ReentrancyGuard g(*this);
+        set.remove(edge);
+    }
+
+  public:
+    explicit StoreBuffer(JSRuntime* rt, const Nursery& nursery)
+#ifdef DEBUG
+      : mEntered(false)
+#endif
+    {
+    }
+
+    MOZ_MUST_USE bool enable();
+    void disable();
+    bool isEnabled() const { return values_.initialized(); }
+
+    void clear();
+
+    bool hasOverflowed() const {
+        return isEnabled() && values_.count() + cells_.count() > MaxEntries;
+    }
+    bool cancelIonCompilations() const { return false; }
+
+    /* Insert a single edge into the buffer/remembered set. */
+    void putValue(JS::Value* vp) { put(values_, vp); }
+    void unputValue(JS::Value* vp) { unput(values_, vp); }
+    void putCell(Cell** cellp) { put(cells_, cellp); }
+    void unputCell(Cell** cellp) { unput(cells_, cellp); }
+    void putSlot(NativeObject* obj, int kind, int32_t start, int32_t count);
+    inline void putWholeCell(Cell* cell);
+
+    void setShouldCancelIonCompilations() {}
+
+    /* Trace every buffered edge as a root; used by the scavenger. */
+    void traceEdges(JSTracer* trc);
+
+    /* After a scavenge, drop the edges that no longer point into new space. */
+    void sweepTenuredEdges();
+
+    /*
+     * Global GC support: edges located inside a cell that is about to be
+     * freed must be dropped, since nothing will unput them. Callers bracket
+     * a walk over the dead cells in address order with these.
+     */
+    MOZ_MUST_USE bool beginSweepDeadEdges();
+    void sweepDeadEdgesInRange(uintptr_t start, uintptr_t end);
+    void endSweepDeadEdges();
+
+    void addSizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf, JS::GCSizes* sizes);
+};
+
 #endif // ! OMR
 
 } /* namespace gc */
@@ -6,6 +6,8 @@
 
 #include "gc/Zone.h"
 
+#include "mozilla/Pair.h"
+
 #include "jsgc.h"
 
 #include "gc/Policy.h"
@@ -41,6 +43,9 @@ JS::Zone::Zone(JSRuntime* rt)
     initialShapes(this, InitialShapeSet()),
     data(nullptr),
     isSystem(false),
+#ifdef OMR // Zones
+    omrIndex(0),
+#endif // OMR Zones
     usedByExclusiveThread(false),
     active(false),
     jitZone_(nullptr) {}
@@ -53,15 +58,31 @@ Zone::getOrCreateDebuggers(JSContext* cx)
 
 Zone::~Zone()
 {
+#ifdef OMR // Zones
+    if (OmrGcHelper::zoneTable && OmrGcHelper::zoneTable[omrIndex] == this)
+        OmrGcHelper::unregisterZone(omrIndex);
+#endif // OMR Zones
     js_delete(jitZone_);
 }
 
 MOZ_MUST_USE bool
 Zone::init(bool isSystem) { 
-	return uniqueIds_.init() &&
-	    gcWeakKeys.init() &&
-		gcZoneGroupEdges.init() &&
-		typeDescrObjects.init();
+    this->isSystem = isSystem;
+	if (!uniqueIds_.init() ||
+	    !gcWeakKeys.init() ||
+		!gcZoneGroupEdges.init() ||
+		!typeDescrObjects.init())
+	{
+		return false;
+	}
+#ifdef OMR // Zones
+    if (!OmrGcHelper::registerZone(this, &omrIndex))
+        return false;
+    // A zone created while concurrent mark is running needs its barriers on
+    // from the start, like every other zone.
+    needsIncrementalBarrier_ = OmrGcHelper::isConcurrentMarking();
+#endif // OMR Zones
+	return true;
 }
 
 JS_PUBLIC_API(void)
@@ -91,6 +112,40 @@ Zone::clearTables()
         initialShapes.clear();
 }
 
+#ifdef OMR // Compaction
+void
+Zone::fixupAfterCompaction(JSTracer* trc)
+{
+    AutoEnterOOMUnsafeRegion oomUnsafe;
+
+    // Unique ids are keyed by address. A cell may have moved to the old
+    // address of another, so the table is rebuilt rather than rekeyed.
+    using IdEntry = mozilla::Pair<Cell*, uint64_t>;
+    Vector<IdEntry, 0, SystemAllocPolicy> ids;
+    if (!ids.reserve(uniqueIds_.count()))
+        oomUnsafe.crash("Zone::fixupAfterCompaction");
+    for (UniqueIdMap::Range r = uniqueIds_.all(); !r.empty(); r.popFront()) {
+        Cell* cell = r.front().key();
+        TraceManuallyBarrieredGenericPointerEdge(trc, &cell, "unique id key");
+        ids.infallibleAppend(IdEntry(cell, r.front().value()));
+    }
+    uniqueIds_.clear();
+    for (const IdEntry& id : ids)
+        uniqueIds_.putNewInfallible(id.first(), id.second());
+
+    // Base shapes are hashed by class and flags only.
+    if (baseShapes.initialized()) {
+        for (BaseShapeSet::Enum e(baseShapes.get()); !e.empty(); e.popFront())
+            TraceEdge(trc, &e.mutableFront(), "base shape table entry");
+    }
+
+    // Initial shapes are hashed by their prototype. The table is only a
+    // cache, so drop it rather than rebuild it.
+    if (initialShapes.initialized())
+        initialShapes.clear();
+}
+#endif // OMR Compaction
+
 void
 Zone::beginSweepTypes(FreeOp* fop, bool releaseTypes)
 {
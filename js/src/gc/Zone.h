@@ -171,13 +171,13 @@ struct Zone : public JS::shadow::Zone,
     // possibly at other times too.
     uint64_t gcNumber() { return runtimeFromMainThread()->gc.gcNumber(); }
 
-    const bool* addressOfNeedsIncrementalBarrier() const { return nullptr; }
+    const bool* addressOfNeedsIncrementalBarrier() const { return &needsIncrementalBarrier_; }
 
     js::jit::JitZone* getJitZone(JSContext* cx) { return jitZone_ ? jitZone_ : createJitZone(cx); }
     js::jit::JitZone* jitZone() { return jitZone_; }
 
-    bool isAtomsZone() const { return true; }
-    bool isSelfHostingZone() const { return true; }
+    bool isAtomsZone() const { return runtimeFromAnyThread()->isAtomsZone(this); }
+    bool isSelfHostingZone() const { return runtimeFromAnyThread()->isSelfHostingZone(this); }
 
 #ifdef DEBUG
     // For testing purposes, return the index of the zone group which this zone
@@ -293,12 +293,22 @@ struct Zone : public JS::shadow::Zone,
 #endif
     void fixupInitialShapeTable();
     void fixupAfterMovingGC();
+#ifdef OMR // Compaction
+    // Update the zone's tables after the OMR heap has been compacted.
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
 
     // Per-zone data for use by an embedder.
     void* data;
 
     bool isSystem;
 
+#ifdef OMR // Zones
+    // This zone's slot in OmrGcHelper::zoneTable, recorded in the header of
+    // every cell allocated in it.
+    uint32_t omrIndex;
+#endif // OMR Zones
+
     mozilla::Atomic<bool> usedByExclusiveThread;
 
     // True when there are active frames.
@@ -435,12 +445,10 @@ class ZonesIter
         it = rt->gc.zones.begin();
         end = rt->gc.zones.end();
 
-		/*MOZ_ASSERT(*it == *end);
-
         if (selector == SkipAtoms) {
             MOZ_ASSERT(atAtomsZone(rt));
             it++;
-        }*/
+        }
     }
 
     bool atAtomsZone(JSRuntime* rt);
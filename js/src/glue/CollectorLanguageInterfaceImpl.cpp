@@ -29,6 +29,7 @@
 #endif /* OMR_GC_MODRON_COMPACTION */
 #include "EnvironmentStandard.hpp"
 #include "ForwardedHeader.hpp"
+#include "FrequentObjectsStats.hpp"
 #include "GCExtensionsBase.hpp"
 #include "HeapLinkedFreeHeader.hpp"
 #include "MarkingScheme.hpp"
@@ -40,6 +41,8 @@
 #include "OMRVMInterface.hpp"
 #include "Scavenger.hpp"
 #include "SlotObject.hpp"
+#include "TracingObjectScanner.hpp"
+#include "VerboseManagerImpl.hpp"
 
 /// Spidermonkey Headers
 #include "js/TracingAPI.h"
@@ -47,22 +50,31 @@
 // JS
 #include "mozilla/DebugOnly.h"
 #include "mozilla/IntegerRange.h"
+#include "mozilla/Maybe.h"
 #include "mozilla/ReentrancyGuard.h"
 #include "mozilla/ScopeExit.h"
 #include "mozilla/TypeTraits.h"
 
+#include "jsatom.h"
 #include "jsgc.h"
 #include "jsprf.h"
 
 #include "builtin/ModuleObject.h"
+#include "builtin/TypedObject.h"
 #include "gc/GCInternals.h"
 #include "gc/Policy.h"
+#include "jit/Ion.h"
 #include "jit/IonCode.h"
+#include "jit/JitCompartment.h"
+#include "jit/JitFrames.h"
 #include "js/SliceBudget.h"
+#include "threading/LockGuard.h"
 #include "vm/ArgumentsObject.h"
 #include "vm/ArrayObject.h"
 #include "vm/Debugger.h"
 #include "vm/EnvironmentObject.h"
+#include "vm/HelperThreads.h"
+#include "vm/RegExpObject.h"
 #include "vm/Scope.h"
 #include "vm/Shape.h"
 #include "vm/Symbol.h"
@@ -122,6 +134,228 @@ OMRGCMarker::OMRGCMarker(JSRuntime* rt, MM_EnvironmentBase* env, MM_MarkingSchem
 	  _markingScheme(ms) {
 }
 
+/* The OMR heap buffer holding a native object's dynamic slots, or NULL if
+ * they are malloc'd.
+ */
+static OmrBuffer *
+SlotsBuffer(NativeObject *nobj)
+{
+	if (!nobj->hasDynamicSlots()) {
+		return NULL;
+	}
+	HeapSlot *slots = nobj->getSlotAddressUnchecked(nobj->numFixedSlots());
+	return OmrGcHelper::isInHeap(slots) ? OmrBuffer::fromData(slots) : NULL;
+}
+
+/* The OMR heap buffer holding the elements a native object owns, or NULL if
+ * they are fixed, malloc'd, or copy on write elements of another object.
+ */
+static OmrBuffer *
+ElementsBuffer(NativeObject *nobj)
+{
+	if (!nobj->hasDynamicElements()) {
+		return NULL;
+	}
+	ObjectElements *header = nobj->getElementsHeader();
+	if (!OmrGcHelper::isInHeap(header) || (header->isCopyOnWrite() && (header->ownerObject() != nobj))) {
+		return NULL;
+	}
+	return OmrBuffer::fromData(header);
+}
+
+/* The exclusive access lock for tracing the runtime during a collection: the
+ * one the main thread holds if it triggered the collection (see
+ * Nursery::collectorExclusiveAccess), or else one taken here.
+ */
+class CollectorSession
+{
+	mozilla::Maybe<AutoLockForExclusiveAccess> _ownLock;
+	AutoLockForExclusiveAccess *_lock;
+
+public:
+	explicit CollectorSession(JSRuntime *rt)
+		: _lock(Nursery::collectorExclusiveAccess)
+	{
+		if (NULL == _lock) {
+			_ownLock.emplace(rt);
+			_lock = _ownLock.ptr();
+		}
+	}
+
+	AutoLockForExclusiveAccess &lock() { return *_lock; }
+};
+
+/* Whether a cell is in a zone in use off the main thread. Such zones are
+ * pinned until they are merged: their cells are kept, neither moved nor
+ * swept, and only their headers are read, as the helper thread may still be
+ * initializing them. Nothing outside the zone refers into it.
+ */
+static bool
+IsPinned(Cell *cell)
+{
+	return cell->zoneFromAnyThread()->usedByExclusiveThread;
+}
+
+/* Move the collection on from the top level phase it is in to |phase|. */
+static void
+SwitchPhase(gcstats::Statistics &stats, gcstats::Phase phase)
+{
+	if (gcstats::PHASE_NONE != stats.currentPhase()) {
+		stats.endPhase(stats.currentPhase());
+	}
+	stats.beginPhase(phase);
+}
+
+/* Sweeping that touches nothing the main thread sweeps meanwhile, run on a
+ * helper thread as GCRuntime::beginSweepingZoneGroup does.
+ */
+class SweepTask : public GCParallelTask
+{
+	typedef void (*SweepOp)(JSRuntime *rt);
+
+	JSRuntime *_rt;
+	SweepOp _op;
+
+	virtual void runFromHelperThread(AutoLockHelperThreadState &locked) override {
+		AutoSetThreadIsSweeping threadIsSweeping;
+		GCParallelTask::runFromHelperThread(locked);
+	}
+
+	virtual void run() override {
+		_op(_rt);
+	}
+
+	SweepTask(const SweepTask &) = delete;
+
+public:
+	SweepTask(JSRuntime *rt, SweepOp op) : _rt(rt), _op(op) {}
+	~SweepTask() { join(); }
+};
+
+class SweepWeakCacheTask : public GCParallelTask
+{
+	JS::WeakCache<void*> &_cache;
+
+	virtual void runFromHelperThread(AutoLockHelperThreadState &locked) override {
+		AutoSetThreadIsSweeping threadIsSweeping;
+		GCParallelTask::runFromHelperThread(locked);
+	}
+
+	virtual void run() override {
+		_cache.sweep();
+	}
+
+	SweepWeakCacheTask(const SweepWeakCacheTask &) = delete;
+
+public:
+	explicit SweepWeakCacheTask(JS::WeakCache<void*> &cache) : _cache(cache) {}
+	SweepWeakCacheTask(SweepWeakCacheTask &&other)
+		: GCParallelTask(mozilla::Move(other)), _cache(other._cache) {}
+	~SweepWeakCacheTask() { join(); }
+};
+
+typedef mozilla::Vector<SweepWeakCacheTask, 0, SystemAllocPolicy> WeakCacheTaskVector;
+
+static void
+SweepAtoms(JSRuntime *rt)
+{
+	rt->sweepAtoms();
+}
+
+static void
+SweepCCWrappers(JSRuntime *rt)
+{
+	for (GCCompartmentGroupIter c(rt); !c.done(); c.next()) {
+		c->sweepCrossCompartmentWrappers();
+	}
+}
+
+static void
+SweepRegExps(JSRuntime *rt)
+{
+	for (GCCompartmentGroupIter c(rt); !c.done(); c.next()) {
+		c->sweepRegExps();
+	}
+}
+
+static void
+SweepObjectGroups(JSRuntime *rt)
+{
+	for (GCCompartmentGroupIter c(rt); !c.done(); c.next()) {
+		c->objectGroups.sweep(rt->defaultFreeOp());
+	}
+}
+
+static void
+SweepMisc(JSRuntime *rt)
+{
+	for (GCCompartmentGroupIter c(rt); !c.done(); c.next()) {
+		c->sweepSavedStacks();
+		c->sweepSelfHostingScriptSource();
+		c->sweepNativeIterators();
+	}
+}
+
+/* One task per weak cache of the zones being swept. If the tasks can't all
+ * be allocated, the caches are swept here instead and none are returned.
+ */
+static void
+PrepareWeakCacheTasks(JSRuntime *rt, WeakCacheTaskVector &tasks)
+{
+	for (GCZoneGroupIter zone(rt); !zone.done(); zone.next()) {
+		for (JS::WeakCache<void*>* cache : zone->weakCaches_) {
+			if (!tasks.append(SweepWeakCacheTask(*cache))) {
+				tasks.clear();
+				for (GCZoneGroupIter sweepZone(rt); !sweepZone.done(); sweepZone.next()) {
+					for (JS::WeakCache<void*>* sweepCache : sweepZone->weakCaches_) {
+						sweepCache->sweep();
+					}
+				}
+				return;
+			}
+		}
+	}
+}
+
+/* Frees the malloc'd slots and elements of dead objects on a helper thread
+ * once the collection is over, as stock SpiderMonkey's background sweeping
+ * does for background finalized kinds. The next collection joins it before
+ * queueing more.
+ */
+class FreeBuffersTask : public GCParallelTask
+{
+	mozilla::Vector<void*, 0, SystemAllocPolicy> _buffers;
+
+	virtual void run() override {
+		for (void *buffer : _buffers) {
+			js_free(buffer);
+		}
+		_buffers.clear();
+	}
+
+public:
+	~FreeBuffersTask() { join(); }
+
+	bool empty() const { return _buffers.empty(); }
+
+	/* Queue a dead object's buffer, or free it now if it can't be queued. */
+	void queue(void *buffer) {
+		if (!OmrGcHelper::isInHeap(buffer) && !_buffers.append(buffer)) {
+			js_free(buffer);
+		}
+	}
+};
+
+/* Start |task| on a helper thread, or run it now if that isn't possible. */
+static void
+StartSweepTask(JSRuntime *rt, GCParallelTask &task, AutoLockHelperThreadState &locked)
+{
+	if (!task.startWithLockHeld(locked)) {
+		AutoUnlockHelperThreadState unlock(locked);
+		task.runFromMainThread(rt);
+	}
+}
+
 } // namespace omrjs
 
 /* This enum extends ConcurrentStatus with values > CONCURRENT_ROOT_TRACING. Values from this
@@ -164,6 +398,13 @@ void
 MM_CollectorLanguageInterfaceImpl::kill(MM_EnvironmentBase *env)
 {
 	OMR_VM *omrVM = env->getOmrVM();
+	if (NULL != _frequentObjectsStats) {
+		_frequentObjectsStats->kill(env);
+		_frequentObjectsStats = NULL;
+	}
+	/* Waits for any buffers still being freed. */
+	js_delete(_freeBuffersTask);
+	_freeBuffersTask = NULL;
 	tearDown(omrVM);
 	MM_GCExtensionsBase::getExtensions(omrVM)->getForge()->free(this);
 }
@@ -206,6 +447,21 @@ MM_CollectorLanguageInterfaceImpl::detachVMThread(OMR_VM *omrVM, OMR_VMThread *o
 	}
 }
 
+void
+MM_CollectorLanguageInterfaceImpl::parallelGlobalGC_masterThreadGarbageCollect_beforeGC(MM_EnvironmentBase *env)
+{
+	/* A global collection is a single slice, which starts by marking. */
+	gcstats::Statistics &stats = OmrGcHelper::runtime->stats;
+	stats.beginSlice();
+	stats.beginPhase(gcstats::PHASE_MARK);
+}
+
+void
+MM_CollectorLanguageInterfaceImpl::parallelGlobalGC_masterThreadGarbageCollect_afterGC(MM_EnvironmentBase *env, bool compactThisCycle)
+{
+	OmrGcHelper::runtime->stats.endSlice();
+}
+
 void
 MM_CollectorLanguageInterfaceImpl::markingScheme_masterSetupForGC(MM_EnvironmentBase *env)
 {
@@ -215,35 +471,82 @@ MM_CollectorLanguageInterfaceImpl::markingScheme_masterSetupForGC(MM_Environment
 void
 MM_CollectorLanguageInterfaceImpl::markingScheme_scanRoots(MM_EnvironmentBase *env)
 {
+	/* Each root set is its own work unit so that idle GC threads can claim
+	 * the rest while one traces, say, a large atoms table. Every thread marks
+	 * through its own tracer, bound to its own environment and work stack.
+	 */
+	JSRuntime *rt = (JSRuntime *)env->getOmrVM()->_language_vm;
+	GCRuntime *gc = &rt->gc;
+	omrjs::OMRGCMarker marker(rt, env, _markingScheme);
+
+	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		gcstats::AutoPhase ap(gc->stats, gcstats::PHASE_MARK_ROOTS);
+		/* Only the atoms table needs exclusive access. */
+		omrjs::CollectorSession session(rt);
+		gc->traceRuntimeAtoms(&marker, session.lock());
+	}
+	// JSCompartment::traceIncomingCrossCompartmentEdgesForZoneGC(trc);
+	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		gcstats::AutoPhase ap(gc->stats, gcstats::PHASE_MARK_ROOTS);
+		gc->traceRuntimeStacks(&marker);
+	}
+	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		gcstats::AutoPhase ap(gc->stats, gcstats::PHASE_MARK_ROOTS);
+		gc->traceRuntimeJitActivations(&marker);
+	}
+	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		gcstats::AutoPhase ap(gc->stats, gcstats::PHASE_MARK_ROOTS);
+		gc->traceRuntimeGlobals(&marker);
+	}
 	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
-		OMR_VM *omrVM = env->getOmrVM();
-		JSRuntime *rt = (JSRuntime *)omrVM->_language_vm;
-		if (NULL == _omrGCMarker) {
-			MM_GCExtensionsBase *extensions = MM_GCExtensionsBase::getExtensions(omrVM);
+		gcstats::AutoPhase ap(gc->stats, gcstats::PHASE_MARK_ROOTS);
+		gc->traceRuntimeCompartments(&marker, GCRuntime::TraceRuntime);
+	}
+	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		gcstats::AutoPhase ap(gc->stats, gcstats::PHASE_MARK_ROOTS);
+		gc->traceEmbeddingRoots(&marker, GCRuntime::TraceRuntime);
+	}
+#if defined(OMR_GC_MODRON_CONCURRENT_MARK)
+	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		/* Edges overwritten while concurrent mark was running are roots of the snapshot. */
+		concurrentGC_markBarrieredCells(env);
+	}
+#endif /* OMR_GC_MODRON_CONCURRENT_MARK */
+}
 
-			_omrGCMarker = (omrjs::OMRGCMarker *)extensions->getForge()->allocate(sizeof(omrjs::OMRGCMarker), MM_AllocationCategory::FIXED, OMR_GET_CALLSITE());
-			new (_omrGCMarker) omrjs::OMRGCMarker(rt, env, _markingScheme);
+void
+MM_CollectorLanguageInterfaceImpl::markingScheme_completeMarking(MM_EnvironmentBase *env)
+{
+	/* Weak map entries are ephemerons: a value is live only once its map and
+	 * its key are. Tracing a live map marked the values of the keys marked
+	 * then, so keep passing over the live maps, sharing them out between the
+	 * GC threads, until a pass marks nothing new.
+	 */
+	JSRuntime *rt = (JSRuntime *)env->getOmrVM()->_language_vm;
+	GCRuntime *gc = &rt->gc;
+	omrjs::OMRGCMarker marker(rt, env, _markingScheme);
+	gcstats::AutoPhase ap(gc->stats, gcstats::PHASE_SWEEP_MARK_WEAK);
+
+	do {
+		if (env->_currentTask->synchronizeGCThreadsAndReleaseSingleThread(env, UNIQUE_ID)) {
+			_weakMapsMarkedAny = false;
+			env->_currentTask->releaseSynchronizedGCThreads(env);
 		}
 
-		gcstats::AutoPhase ap(rt->gc.stats, gcstats::PHASE_MARK_ROOTS);
-		js::gc::AutoTraceSession session(rt);
-		rt->gc.traceRuntimeAtoms(_omrGCMarker, session.lock);
-		// JSCompartment::traceIncomingCrossCompartmentEdgesForZoneGC(trc);
-		rt->gc.traceRuntimeCommon(_omrGCMarker, js::gc::GCRuntime::TraceOrMarkRuntime::TraceRuntime, session.lock);
-
-		//for (GCZoneGroupIter zone(rt); !zone.done(); zone.next()) {
-		Zone *zone = OmrGcHelper::zone;
-		if (!zone->gcWeakMapList.isEmpty()) {
+		for (Zone *zone : gc->zones) {
 			for (WeakMapBase* m : zone->gcWeakMapList) {
-				m->trace(_omrGCMarker);
+				if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+					if (WeakMapBase::markIteratively(m, &marker)) {
+						_weakMapsMarkedAny = true;
+					}
+				}
 			}
 		}
-	}
-}
+		_markingScheme->completeScan(env);
 
-void
-MM_CollectorLanguageInterfaceImpl::markingScheme_completeMarking(MM_EnvironmentBase *env)
-{
+		/* Every thread must see the last map's result before the flag is reset. */
+		env->_currentTask->synchronizeGCThreads(env, UNIQUE_ID);
+	} while (_weakMapsMarkedAny);
 }
 
 void
@@ -259,25 +562,38 @@ MM_CollectorLanguageInterfaceImpl::markingScheme_masterSetupForWalk(MM_Environme
 void
 MM_CollectorLanguageInterfaceImpl::markingScheme_masterCleanupAfterGC(MM_EnvironmentBase *env)
 {
+	/* Anything buffered after the final drain belongs to a cycle that is over. */
+	GCRuntime *gc = OmrGcHelper::runtime;
+	LockGuard<Mutex> guard(gc->concurrentBarrierLock);
+	gc->concurrentBarrierBuffer.clearAndFree();
+	gc->concurrentBarrierCycle++;
 }
 
-struct TraceChildrenFunctor {
-	MM_CollectorLanguageInterfaceImpl *cli;
-
-	template <typename T>
-	void operator()(T* thing) {
-		static_cast<T*>(thing)->traceChildren(cli->_omrGCMarker);
-	}
-};
-
-
 uintptr_t
 MM_CollectorLanguageInterfaceImpl::markingScheme_scanObject(MM_EnvironmentBase *env, omrobjectptr_t objectPtr, MarkingSchemeScanReason reason)
 {
-	TraceChildrenFunctor traceChildren = {this};
+	/* Tracers are cheap to build, and one per call keeps concurrent scanners apart. */
+	omrjs::OMRGCMarker marker((JSRuntime *)env->getOmrVM()->_language_vm, env, _markingScheme);
+	omrjs::TraceChildrenFunctor traceChildren(&marker);
 	if (JS::TraceKind::Null != ((Cell *)objectPtr)->getTraceKind()) {
 		DispatchTraceKindTyped(traceChildren, (Cell *)objectPtr, ((Cell *)objectPtr)->getTraceKind());
 	}
+
+	/* Slots and elements buffers are only reachable from their owner, whose
+	 * trace hook has traced their contents.
+	 */
+	Cell *cell = (Cell *)objectPtr;
+	if ((JS::TraceKind::Object == cell->getTraceKind()) && ((JSObject *)cell)->isNative()) {
+		NativeObject *nobj = &((JSObject *)cell)->as<NativeObject>();
+		OmrBuffer *buffer = omrjs::SlotsBuffer(nobj);
+		if (NULL != buffer) {
+			_markingScheme->markObject(env, (omrobjectptr_t)buffer, false);
+		}
+		buffer = omrjs::ElementsBuffer(nobj);
+		if (NULL != buffer) {
+			_markingScheme->markObject(env, (omrobjectptr_t)buffer, false);
+		}
+	}
 	return 0;
 }
 
@@ -285,10 +601,169 @@ MM_CollectorLanguageInterfaceImpl::markingScheme_scanObject(MM_EnvironmentBase *
 uintptr_t
 MM_CollectorLanguageInterfaceImpl::markingScheme_scanObjectWithSize(MM_EnvironmentBase *env, omrobjectptr_t objectPtr, MarkingSchemeScanReason reason, uintptr_t sizeToDo)
 {
-#error implement an object scanner which scans up to sizeToDo bytes
+	/* Cells are traced through their trace hooks, which cannot be resumed part
+	 * way through, so the budget is honoured at object granularity: the whole
+	 * object is scanned and the bytes it accounts for are reported.
+	 */
+	markingScheme_scanObject(env, objectPtr, reason);
+
+	uintptr_t bytesScanned = _extensions->objectModel.getConsumedSizeInBytesWithHeader(objectPtr);
+	Cell *cell = (Cell *)objectPtr;
+	if ((JS::TraceKind::Object == cell->getTraceKind()) && ((JSObject *)cell)->isNative()) {
+		NativeObject *nobj = &((JSObject *)cell)->as<NativeObject>();
+		/* Buffers in the OMR heap report their own size when they are scanned. */
+		if (NULL == omrjs::SlotsBuffer(nobj)) {
+			bytesScanned += nobj->numDynamicSlots() * sizeof(HeapSlot);
+		}
+		if (!nobj->hasEmptyElements() && !nobj->denseElementsAreCopyOnWrite() && (NULL == omrjs::ElementsBuffer(nobj))) {
+			bytesScanned += nobj->getDenseCapacity() * sizeof(HeapSlot);
+		}
+	}
+	return bytesScanned;
 }
 #endif /* OMR_GC_MODRON_CONCURRENT_MARK */
 
+/* Tracer which buffers each child for the concurrent pre barrier. */
+class ConcurrentBarrierTracer : public JS::CallbackTracer
+{
+public:
+	explicit ConcurrentBarrierTracer(JSRuntime *rt)
+		: JS::CallbackTracer(rt)
+	{
+	}
+
+	void onChild(const JS::GCCellPtr &thing) override
+	{
+		OmrGcHelper::concurrentWriteBarrierPre(thing.asCell());
+	}
+};
+
+/* static */ void
+OmrGcHelper::concurrentWriteBarrierPre(Cell *thing)
+{
+	/* The mutator must not push to the collector's work packets, so the cell
+	 * is queued here and marked by the collector the next time it drains the
+	 * buffer.
+	 */
+	MM_GCExtensionsBase *extensions = MM_GCExtensionsBase::getExtensions(Nursery::omrVM);
+	MM_CollectorLanguageInterfaceImpl *cli = (MM_CollectorLanguageInterfaceImpl *)extensions->collectorLanguageInterface;
+	if (cli->getMarkingScheme()->isMarked((omrobjectptr_t)thing) || omrjs::IsPinned(thing)) {
+		return;
+	}
+
+	/* Threads running JS buffer their cells and only take the lock once per
+	 * ConcurrentBarrierBuffer::Capacity cells, like OMR's own SATB buffers.
+	 */
+	PerThreadData *pt = TlsPerThreadData.get();
+	if (NULL != pt) {
+		pt->concurrentBarrierBuffer.put(runtime, thing);
+		return;
+	}
+
+	LockGuard<Mutex> guard(runtime->concurrentBarrierLock);
+	AutoEnterOOMUnsafeRegion oomUnsafe;
+	if (!runtime->concurrentBarrierBuffer.append(thing)) {
+		oomUnsafe.crash("Failed to allocate for OmrGcHelper::concurrentWriteBarrierPre.");
+	}
+}
+
+void
+ConcurrentBarrierBuffer::put(GCRuntime *gc, Cell *cell)
+{
+	uint32_t cycle = gc->concurrentBarrierCycle;
+	if ((cycle_ != cycle) || (Capacity == length_)) {
+		LockGuard<Mutex> guard(gc->concurrentBarrierLock);
+		AutoEnterOOMUnsafeRegion oomUnsafe;
+		if ((cycle_ == cycle) && !appendTo(gc, gc->concurrentBarrierBuffer)) {
+			oomUnsafe.crash("Failed to allocate for ConcurrentBarrierBuffer::put.");
+		}
+		/* Cells from a finished cycle are dropped; they may be dead by now. */
+		length_ = 0;
+		cycle_ = cycle;
+		if (!isInList()) {
+			gc->concurrentBarrierBuffers.insertBack(this);
+		}
+	}
+
+	size_t length = length_;
+	cells_[length] = cell;
+	length_ = length + 1;
+}
+
+bool
+ConcurrentBarrierBuffer::appendTo(GCRuntime *gc, Vector<Cell *, 0, SystemAllocPolicy> &cells) const
+{
+	/* The owning thread may still be appending; take what it has published. */
+	if (cycle_ != gc->concurrentBarrierCycle) {
+		return true;
+	}
+	return cells.append(cells_, length_);
+}
+
+ConcurrentBarrierBuffer::~ConcurrentBarrierBuffer()
+{
+	/* GCRuntime::finish empties the list if the runtime goes first. */
+	if (isInList()) {
+		LockGuard<Mutex> guard(OmrGcHelper::runtime->concurrentBarrierLock);
+		remove();
+	}
+}
+
+/* static */ void
+OmrGcHelper::concurrentWriteBarrierPreChildren(JSObject *obj)
+{
+	ConcurrentBarrierTracer trc(runtime->rt);
+	obj->getClass()->doTrace(&trc, obj);
+}
+
+/* static */ void
+OmrGcHelper::setConcurrentMarkEnabled(bool enabled)
+{
+#if defined(OMR_GC_MODRON_CONCURRENT_MARK)
+	MM_GCExtensionsBase *extensions = MM_GCExtensionsBase::getExtensions(Nursery::omrVM);
+	extensions->concurrentKickoffEnabled = enabled;
+#endif /* OMR_GC_MODRON_CONCURRENT_MARK */
+}
+
+/* static */ bool
+OmrGcHelper::isConcurrentMarkEnabled()
+{
+#if defined(OMR_GC_MODRON_CONCURRENT_MARK)
+	MM_GCExtensionsBase *extensions = MM_GCExtensionsBase::getExtensions(Nursery::omrVM);
+	return extensions->concurrentMark && extensions->concurrentKickoffEnabled;
+#else /* OMR_GC_MODRON_CONCURRENT_MARK */
+	return false;
+#endif /* OMR_GC_MODRON_CONCURRENT_MARK */
+}
+
+/* static */ void
+OmrGcHelper::forEachCellInZone(JS::Zone *zone, void (*op)(Cell *cell, void *data), void *data)
+{
+	MM_EnvironmentBase *env = MM_EnvironmentBase::getEnvironment(Nursery::omrVMThread);
+	MM_GCExtensionsBase *extensions = env->getExtensions();
+	env->acquireExclusiveVMAccess();
+
+	/* Helper threads' TLHs are only walkable while they are held off. */
+	GC_OMRVMInterface::flushCachesForGC(env);
+
+	GC_HeapRegionIterator regionIterator(extensions->getHeap()->getHeapRegionManager());
+	MM_HeapRegionDescriptor *hrd = regionIterator.nextRegion();
+	while (NULL != hrd) {
+		GC_ObjectHeapIteratorAddressOrderedList objectIterator(extensions, hrd, false);
+		omrobjectptr_t omrobjPtr = objectIterator.nextObject();
+		while (NULL != omrobjPtr) {
+			Cell *cell = (Cell *)omrobjPtr;
+			if (cell->omrZoneIndex() == zone->omrIndex) {
+				op(cell, data);
+			}
+			omrobjPtr = objectIterator.nextObject();
+		}
+		hrd = regionIterator.nextRegion();
+	}
+
+	env->releaseExclusiveVMAccess();
+}
+
 void
 MM_CollectorLanguageInterfaceImpl::parallelDispatcher_handleMasterThread(OMR_VMThread *omrVMThread)
 {
@@ -305,19 +780,43 @@ MM_CollectorLanguageInterfaceImpl::scavenger_reportObjectEvents(MM_EnvironmentBa
 void
 MM_CollectorLanguageInterfaceImpl::scavenger_masterSetupForGC(MM_EnvironmentBase *env)
 {
-	/* Do nothing for now */
+	/* Scavenges only run when new space is full. */
+	OmrGcHelper::runtime->stats.beginNurseryCollection(JS::gcreason::OUT_OF_NURSERY);
+
+	/* The JIT bakes the new space bounds into its barriers; they must not have moved. */
+	mozilla::DebugOnly<uintptr_t> newSpaceBase = OmrGcHelper::newSpaceBase;
+	mozilla::DebugOnly<uintptr_t> newSpaceSize = OmrGcHelper::newSpaceSize;
+	OmrGcHelper::updateGenerationalBounds();
+	MOZ_ASSERT(newSpaceBase == OmrGcHelper::newSpaceBase);
+	MOZ_ASSERT(newSpaceSize == OmrGcHelper::newSpaceSize);
 }
 
 void
 MM_CollectorLanguageInterfaceImpl::scavenger_workerSetupForGC_clearEnvironmentLangStats(MM_EnvironmentBase *env)
 {
-	/* Do nothing for now */
+	/* Every worker passes through here once per scavenge, so this is where the
+	 * roots are handed out. Anything they copy is scanned by completeScan().
+	 */
+	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		JSRuntime *rt = (JSRuntime *)env->getOmrVM()->_language_vm;
+		omrjs::CollectorSession session(rt);
+		js::TenuringTracer mover(rt, env);
+		rt->gc.traceRuntimeAtoms(&mover, session.lock());
+		rt->gc.traceRuntimeCommon(&mover, js::gc::GCRuntime::TraceOrMarkRuntime::TraceRuntime, session.lock());
+		rt->contextFromMainThread()->caches.newObjectCache.clearNurseryObjects(rt);
+	}
+	if (J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		/* Edges with no owning cell (stack-allocated Heap<T>, hash table entries, ...). */
+		JSRuntime *rt = (JSRuntime *)env->getOmrVM()->_language_vm;
+		js::TenuringTracer mover(rt, env);
+		rt->gc.storeBuffer.traceEdges(&mover);
+	}
 }
 
 void
 MM_CollectorLanguageInterfaceImpl::scavenger_reportScavengeEnd(MM_EnvironmentBase * envBase, bool scavengeSuccessful)
 {
-	/* Do nothing for now */
+	OmrGcHelper::runtime->stats.endNurseryCollection();
 }
 
 void
@@ -335,19 +834,44 @@ MM_CollectorLanguageInterfaceImpl::scavenger_masterThreadGarbageCollect_scavenge
 void
 MM_CollectorLanguageInterfaceImpl::scavenger_masterThreadGarbageCollect_scavengeSuccess(MM_EnvironmentBase *envBase)
 {
-	/* Do nothing for now */
+	/* The store buffer edges were updated as roots; keep only the ones whose
+	 * targets survived within new space.
+	 */
+	JSRuntime *rt = (JSRuntime *)envBase->getOmrVM()->_language_vm;
+	rt->gc.storeBuffer.sweepTenuredEdges();
 }
 
 bool
 MM_CollectorLanguageInterfaceImpl::scavenger_internalGarbageCollect_shouldPercolateGarbageCollect(MM_EnvironmentBase *envBase, PercolateReason *reason, uint32_t *gcCode)
 {
-#error Return true if scavenge cycle should be forgone and GC cycle percolated up to another collector
+	/* Too many buffered edges to be worth scanning as roots. */
+	JSRuntime *rt = (JSRuntime *)envBase->getOmrVM()->_language_vm;
+	if (rt->gc.storeBuffer.hasOverflowed()) {
+		rt->gc.stats.count(gcstats::STAT_STOREBUFFER_OVERFLOW);
+		*reason = REMEMBERED_SET_OVERFLOW;
+		*gcCode = J9MMCONSTANT_IMPLICIT_GC_PERCOLATE;
+		return true;
+	}
+	return false;
 }
 
 GC_ObjectScanner *
 MM_CollectorLanguageInterfaceImpl::scavenger_getObjectScanner(MM_EnvironmentStandard *env, omrobjectptr_t objectPtr, void *allocSpace, uintptr_t flags)
 {
-#error Implement a GC_ObjectScanner subclass for each distinct kind of objects (eg scanner for scalar objects and scanner for indexable objects)
+	/* Remembered objects are traced by scavenger_scavengeIndirectObjectSlots(), which
+	 * can report whether they need to stay remembered.
+	 */
+	JSRuntime *rt = (JSRuntime *)env->getOmrVM()->_language_vm;
+	GC_TracingObjectScanner *objectScanner = GC_TracingObjectScanner::newInstance(env, rt, objectPtr, allocSpace, flags);
+	if (GC_ObjectScanner::scanRoots == (flags & GC_ObjectScanner::scanRoots)) {
+		return objectScanner;
+	}
+
+	/* A newly tenured copy that still refers into new space must be remembered. */
+	if (objectScanner->scanObject() && !OmrGcHelper::isInNewSpace(objectPtr)) {
+		_extensions->scavenger->rememberObject(env, objectPtr);
+	}
+	return objectScanner;
 }
 
 void
@@ -359,22 +883,22 @@ MM_CollectorLanguageInterfaceImpl::scavenger_flushReferenceObjects(MM_Environmen
 bool
 MM_CollectorLanguageInterfaceImpl::scavenger_hasIndirectReferentsInNewSpace(MM_EnvironmentStandard *env, omrobjectptr_t objectPtr)
 {
-	/* This method must be implemented and return true an object may hold any object references that are live
-	 * but not reachable by traversing the reference graph from the root set or remembered set. Otherwise this
-	 * default implementation should be used.
+	/* Slots and elements are malloc'd, so every reference a remembered object
+	 * holds is "indirect" as far as OMR's slot-based scanning is concerned.
 	 */
-	return false;
+	return _extensions->objectModel.isRemembered(objectPtr);
 }
 
 bool
 MM_CollectorLanguageInterfaceImpl::scavenger_scavengeIndirectObjectSlots(MM_EnvironmentStandard *env, omrobjectptr_t objectPtr)
 {
-	/* This method must be implemented if an object may hold any object references that are live but not reachable
-	 * by traversing the reference graph from the root set or remembered set. In that case, this method should
-	 * call MM_Scavenger::copyObjectSlot(..) for each such indirect object reference, ORing the boolean result
-	 * from each call to MM_Scavenger::copyObjectSlot(..) into a single boolean value to be returned.
+	/* Trace a remembered object; the return value keeps it remembered if any
+	 * of its referents are still in new space.
 	 */
-	return false;
+	JSRuntime *rt = (JSRuntime *)env->getOmrVM()->_language_vm;
+	GC_ObjectScannerState objectScannerState;
+	GC_TracingObjectScanner *objectScanner = GC_TracingObjectScanner::newInstance(env, rt, objectPtr, &objectScannerState, GC_ObjectScanner::scanRoots);
+	return objectScanner->scanObject();
 }
 
 void
@@ -423,31 +947,458 @@ MM_CollectorLanguageInterfaceImpl::scavenger_fixupDestroyedSlot(MM_EnvironmentBa
 	Assert_MM_unimplemented();
 }
 #endif /* OMR_INTERP_COMPRESSED_OBJECT_HEADER */
+
+namespace js {
+
+void
+TenuringTracer::copyEdge(gc::Cell **cellp)
+{
+	MM_EnvironmentStandard *env = (MM_EnvironmentStandard *)env_;
+	MM_GCExtensionsBase *extensions = env->getExtensions();
+	extensions->scavenger->copyObjectSlot(env, (volatile omrobjectptr_t *)cellp);
+	if (OmrGcHelper::isInNewSpace(*cellp)) {
+		shouldRemember_ = true;
+	}
+}
+
+} // namespace js
 #endif /* OMR_GC_MODRON_SCAVENGER */
 
 #if defined(OMR_GC_MODRON_COMPACTION)
+namespace omrjs {
+
+bool
+OMRCompactFixupTracer::shouldFixup(void *location)
+{
+	if (isInHeap(location)) {
+		/* Each cell is traced once, so a location inside one is reached once
+		 * unless it was written before its cell was traced.
+		 */
+		if ((location == _fixedHeader[0]) || (location == _fixedHeader[1])) {
+			return false;
+		}
+		return !_rememberedInHeap || !_seen.has(location);
+	}
+	for (size_t i = 0; i < _ownedCount; i++) {
+		if ((uintptr_t(location) >= _owned[i].start) && (uintptr_t(location) < _owned[i].end)) {
+			return true;
+		}
+	}
+	if (isStackTemporary(location)) {
+		return true;
+	}
+
+	decltype(_seen)::AddPtr p = _seen.lookupForAdd(location);
+	if (p) {
+		return false;
+	}
+	if (!_seen.add(p, location)) {
+		AutoEnterOOMUnsafeRegion oomUnsafe;
+		oomUnsafe.crash("OMRCompactFixupTracer::shouldFixup");
+	}
+	return true;
+}
+
+void
+OMRCompactFixupTracer::rememberLocation(void *location)
+{
+	MOZ_ASSERT(isInHeap(location));
+	if (!_seen.put(location)) {
+		AutoEnterOOMUnsafeRegion oomUnsafe;
+		oomUnsafe.crash("OMRCompactFixupTracer::rememberLocation");
+	}
+	_rememberedInHeap = true;
+}
+
+void
+OMRCompactFixupTracer::traverse(JS::Value *vp)
+{
+	if (!vp->isGCThing() || !shouldFixup(vp)) {
+		return;
+	}
+	if (vp->isString()) {
+		vp->setString(forward(vp->toString()));
+	} else if (vp->isObject()) {
+		vp->setObject(*forward(&vp->toObject()));
+	} else if (vp->isSymbol()) {
+		vp->setSymbol(forward(vp->toSymbol()));
+	} else if (vp->isPrivateGCThing()) {
+		*vp = JS::PrivateGCThingValue(forward(vp->toGCThing()));
+	}
+}
+
+void
+OMRCompactFixupTracer::traverse(jsid *idp)
+{
+	if (!JSID_IS_GCTHING(*idp) || !shouldFixup(idp)) {
+		return;
+	}
+	if (JSID_IS_STRING(*idp)) {
+		*idp = NON_INTEGER_ATOM_TO_JSID(forward(JSID_TO_ATOM(*idp)));
+	} else if (JSID_IS_SYMBOL(*idp)) {
+		*idp = SYMBOL_TO_JSID(forward(JSID_TO_SYMBOL(*idp)));
+	}
+}
+
+void
+OMRCompactFixupTracer::traverse(js::TaggedProto *protop)
+{
+	if (protop->isObject() && shouldFixup(protop)) {
+		*protop = TaggedProto(forward(protop->toObject()));
+	}
+}
+
+/* Objects whose shape_ field holds a shape, see ShapedObject. */
+static bool
+IsShapedClass(const js::Class *clasp)
+{
+	return clasp->isNative() || clasp->isProxy() || IsTypedObjectClass(clasp);
+}
+
+static void
+FixupCellAfterCompaction(OMRCompactFixupTracer *trc, Cell *cell)
+{
+	JS::TraceKind kind = cell->getTraceKind();
+	switch (kind) {
+	case JS::TraceKind::JitCode:
+		/* Code addresses do not move, so jump relocations are left alone. */
+		((jit::JitCode *)cell)->fixupAfterCompaction(trc);
+		break;
+	case JS::TraceKind::Shape:
+		((Shape *)cell)->fixupAfterCompaction(trc);
+		break;
+	default:
+		DispatchTraceKindTyped(TraceChildrenFunctor(trc), cell, kind);
+		break;
+	}
+}
+
+/* Tables hashed by the contents of moved cells are only rebuilt once every
+ * cell has been fixed up.
+ */
+static void
+RehashCellAfterCompaction(OMRCompactFixupTracer *trc, Cell *cell)
+{
+	JS::TraceKind kind = cell->getTraceKind();
+	if (JS::TraceKind::Shape == kind) {
+		((Shape *)cell)->fixupKidsAfterCompaction(trc);
+	} else if ((JS::TraceKind::BaseShape == kind) && ((BaseShape *)cell)->hasTable()) {
+		((BaseShape *)cell)->table().rehashAfterCompaction();
+	}
+}
+
+/* Rewrites the group, the shape and any pointers into the old cell. This is
+ * done for every object before any object is traced, so that trace hooks can
+ * read classes, slots and data pointers of the objects they refer to.
+ */
+static void
+FixupObjectHeaderAfterCompaction(OMRCompactFixupTracer *trc, JSObject *obj)
+{
+	ObjectGroup **groupp = (ObjectGroup **)(uintptr_t(obj) + JSObject::offsetOfGroup());
+	*groupp = trc->forward(*groupp);
+	const js::Class *clasp = obj->getClass();
+	if (IsShapedClass(clasp)) {
+		Shape **shapep = (Shape **)(uintptr_t(obj) + ShapedObject::offsetOfShape());
+		*shapep = trc->forward(*shapep);
+	}
+
+	if (clasp->isNative()) {
+		NativeObject *nobj = &obj->as<NativeObject>();
+		HeapSlot **slotsp = (HeapSlot **)(uintptr_t(nobj) + NativeObject::offsetOfSlots());
+		if (trc->isInHeap(*slotsp)) {
+			OmrBuffer *buffer = trc->movedBuffer(*slotsp);
+			MOZ_ASSERT(NULL != buffer);
+			*slotsp = (HeapSlot *)buffer->data();
+		}
+
+		HeapSlot **elementsp = (HeapSlot **)(uintptr_t(nobj) + NativeObject::offsetOfElements());
+		OmrBuffer *elementsBuffer = NULL;
+		if (trc->isInHeap(*elementsp)) {
+			elementsBuffer = trc->movedBuffer(ObjectElements::fromElements(*elementsp));
+		}
+		if (NULL != elementsBuffer) {
+			/* Dynamic elements: this object's own or a copy on write owner's. */
+			*elementsp = ((ObjectElements *)elementsBuffer->data())->elements();
+			if (nobj->denseElementsAreCopyOnWrite()) {
+				/* Shared by every sharer, so the owner is only forwarded once. */
+				GCPtrNativeObject &ownerObject = nobj->getElementsHeader()->ownerObject();
+				if (!trc->isRememberedLocation(&ownerObject)) {
+					trc->rememberLocation(&ownerObject);
+					ownerObject.unsafeSet(trc->forward(ownerObject.get()));
+				}
+			}
+		} else if (trc->isInHeap(*elementsp)) {
+			/* Any other elements in the heap are fixed elements: this
+			 * object's own or a copy on write owner's.
+			 */
+			JSObject *owner = (JSObject *)(uintptr_t(*elementsp) - NativeObject::offsetOfFixedElements());
+			owner = trc->forward(owner);
+			*elementsp = (HeapSlot *)(uintptr_t(owner) + NativeObject::offsetOfFixedElements());
+			if (nobj->denseElementsAreCopyOnWrite()) {
+				GCPtrNativeObject &ownerObject = nobj->getElementsHeader()->ownerObject();
+				trc->rememberLocation(&ownerObject);
+				ownerObject.unsafeSet(static_cast<NativeObject *>(owner));
+			}
+		} else if (nobj->denseElementsAreCopyOnWrite()) {
+			/* Read by every sharer to decide whether it owns the elements. */
+			TraceEdge(trc, &nobj->getElementsHeader()->ownerObject(), "objectElementsOwner");
+		}
+	} else if (&UnboxedArrayObject::class_ == clasp) {
+		UnboxedArrayObject *array = &obj->as<UnboxedArrayObject>();
+		if (trc->isInHeap(array->elements())) {
+			array->setInlineElementsAfterCompaction();
+		}
+	}
+
+	if (&ArrayBufferObject::class_ == clasp) {
+		ArrayBufferObject *buffer = &obj->as<ArrayBufferObject>();
+		/* Data inline in a typed object is fixed by the buffer's trace hook. */
+		if (!buffer->forInlineTypedObject() && trc->isInHeap(buffer->dataPointer())) {
+			buffer->setInlineDataAfterCompaction();
+		}
+	} else if (IsTypedArrayClass(clasp)) {
+		TypedArrayObject *array = &obj->as<TypedArrayObject>();
+		if (!array->hasBuffer() && trc->isInHeap(array->elements())) {
+			array->setInlineElements();
+		}
+	}
+}
+
+/* Updates a slots or elements pointer held by an Ion frame. */
+static void
+ForwardSlotsOrElements(JSTracer *jstrc, HeapSlot **slotsp)
+{
+	OMRCompactFixupTracer *trc = static_cast<OMRCompactFixupTracer *>(jstrc);
+	HeapSlot *slots = *slotsp;
+	if (!trc->isInHeap(slots)) {
+		return;
+	}
+	OmrBuffer *buffer = trc->movedBuffer(slots);
+	if (NULL != buffer) {
+		*slotsp = (HeapSlot *)buffer->data();
+		return;
+	}
+	buffer = trc->movedBuffer(ObjectElements::fromElements(slots));
+	if (NULL != buffer) {
+		*slotsp = ((ObjectElements *)buffer->data())->elements();
+		return;
+	}
+	JSObject *owner = (JSObject *)(uintptr_t(slots) - NativeObject::offsetOfFixedElements());
+	*slotsp = (HeapSlot *)(uintptr_t(trc->forward(owner)) + NativeObject::offsetOfFixedElements());
+}
+
+static void
+FixupObjectAfterCompaction(OMRCompactFixupTracer *trc, JSObject *obj)
+{
+	const js::Class *clasp = obj->getClass();
+	trc->setFixedHeader((void *)(uintptr_t(obj) + JSObject::offsetOfGroup()),
+		IsShapedClass(clasp) ? (void *)(uintptr_t(obj) + ShapedObject::offsetOfShape()) : nullptr);
+
+	if (clasp->isNative()) {
+		NativeObject *nobj = &obj->as<NativeObject>();
+		uint32_t dynamicSlots = nobj->numDynamicSlots();
+		if (0 != dynamicSlots) {
+			trc->addOwnedRange(nobj->getSlotAddressUnchecked(nobj->numFixedSlots()), dynamicSlots * sizeof(HeapSlot));
+		}
+		HeapSlot *elements = static_cast<HeapSlot *>(nobj->getDenseElementsAllowCopyOnWrite());
+		if (!trc->isInHeap(elements) && !nobj->denseElementsAreCopyOnWrite()) {
+			trc->addOwnedRange(elements, nobj->getDenseInitializedLength() * sizeof(HeapSlot));
+		}
+	}
+
+	obj->traceChildren(trc);
+	trc->clearOwnedRanges();
+}
+
+} // namespace omrjs
+
 void
 MM_CollectorLanguageInterfaceImpl::compactScheme_verifyHeap(MM_EnvironmentBase *env, MM_MarkMap *markMap)
 {
-	Assert_MM_unimplemented();
+	/* Nothing to verify beyond MM_CompactSchemeFixupObject::verifyForwardingPtr. */
+}
+
+uintptr_t
+MM_CollectorLanguageInterfaceImpl::compactScheme_fixupObject(MM_EnvironmentBase *env, omrobjectptr_t objectPtr)
+{
+	/* Fixing a cell can read other cells, which may not have been fixed yet
+	 * by another thread, so cells are only collected here and fixed up along
+	 * with the roots.
+	 */
+	Cell *cell = (Cell *)objectPtr;
+	JS::TraceKind kind = cell->getTraceKind();
+	if ((JS::TraceKind::Null == kind) && !cell->isOmrBuffer()) {
+		return 0;
+	}
+
+	GCRuntime *gc = OmrGcHelper::runtime;
+	LockGuard<Mutex> guard(gc->compactFixupLock);
+	bool ok;
+	if (cell->isOmrBuffer()) {
+		ok = gc->compactedBuffers.append((OmrBuffer *)cell);
+	} else if (JS::TraceKind::Object == kind) {
+		ok = gc->compactedObjects.append((JSObject *)cell);
+	} else {
+		ok = gc->compactedCells.append(cell);
+	}
+	if (!ok) {
+		AutoEnterOOMUnsafeRegion oomUnsafe;
+		oomUnsafe.crash("compactScheme_fixupObject");
+	}
+	return 0;
 }
 
 void
 MM_CollectorLanguageInterfaceImpl::compactScheme_fixupRoots(MM_EnvironmentBase *env, MM_CompactScheme *compactScheme)
 {
-	Assert_MM_unimplemented();
+	/* OMR calls this once every live cell has gone through fixupObject. The
+	 * fixup is done by a single thread, as forwarding is not idempotent and
+	 * the tracer keeps track of the locations it has updated.
+	 */
+	if (!J9MODRON_HANDLE_NEXT_WORK_UNIT(env)) {
+		return;
+	}
+
+	OMR_VM *omrVM = env->getOmrVM();
+	JSRuntime *rt = (JSRuntime *)omrVM->_language_vm;
+	GCRuntime *gc = &rt->gc;
+	AutoEnterOOMUnsafeRegion oomUnsafe;
+
+	/* Must be a local of this frame, see OMRCompactFixupTracer::isStackTemporary. */
+	omrjs::OMRCompactFixupTracer trc(rt, compactScheme, _extensions->heap->getHeapBase(), _extensions->heap->getHeapTop());
+	if (!trc.init()) {
+		oomUnsafe.crash("compactScheme_fixupRoots");
+	}
+
+	for (Cell *cell : gc->compactedCells) {
+		omrjs::FixupCellAfterCompaction(&trc, cell);
+	}
+	for (Cell *cell : gc->compactedCells) {
+		omrjs::RehashCellAfterCompaction(&trc, cell);
+	}
+	for (OmrBuffer *buffer : gc->compactedBuffers) {
+		if (!trc.addMovedBuffer(buffer)) {
+			oomUnsafe.crash("compactScheme_fixupRoots");
+		}
+	}
+	for (JSObject *obj : gc->compactedObjects) {
+		omrjs::FixupObjectHeaderAfterCompaction(&trc, obj);
+	}
+	for (JSObject *obj : gc->compactedObjects) {
+		omrjs::FixupObjectAfterCompaction(&trc, obj);
+	}
+	trc.setFixedHeader(nullptr, nullptr);
+	gc->compactedCells.clearAndFree();
+	gc->compactedObjects.clearAndFree();
+	gc->compactedBuffers.clearAndFree();
+
+	/* Ion frames may hold slots and elements pointers, as for a minor GC. */
+	jit::UpdateJitActivationsForCompaction(rt, &trc, omrjs::ForwardSlotsOrElements);
+
+	omrjs::CollectorSession session(rt);
+	gc->traceRuntimeCommon(&trc, js::gc::GCRuntime::TraceOrMarkRuntime::TraceRuntime, session.lock());
+	/* Cells in every zone may have moved, including zones used off the main thread. */
+	for (Zone *zone : gc->zones) {
+		for (WeakMapBase* m : zone->gcWeakMapList) {
+			m->trace(&trc);
+		}
+	}
+
+	/* Tables keyed by address are rebuilt last, once nothing else can reach
+	 * their entries through the tracer.
+	 */
+	FixupAtomsAfterCompaction(&trc, session.lock());
+	if (rt->hasJitRuntime()) {
+		rt->jitRuntime()->fixupAfterCompaction(&trc);
+	}
+	if (NULL != rt->regExpCodeCache) {
+		rt->regExpCodeCache->fixupAfterCompaction(&trc);
+	}
+	for (Zone *zone : gc->zones) {
+		zone->fixupAfterCompaction(&trc);
+		for (CompartmentsInZoneIter c(zone); !c.done(); c.next()) {
+			c->fixupAfterCompaction(&trc);
+		}
+	}
+
+	/* The symbol registry is hashed by the address of each description. */
+	SymbolRegistry &registry = rt->symbolRegistry(session.lock());
+	Vector<JS::Symbol *, 0, SystemAllocPolicy> symbols;
+	if (!symbols.reserve(registry.count())) {
+		oomUnsafe.crash("compactScheme_fixupRoots");
+	}
+	for (SymbolRegistry::Enum e(registry); !e.empty(); e.popFront()) {
+		JS::Symbol *sym = e.front().unbarrieredGet();
+		TraceManuallyBarrieredEdge(&trc, &sym, "symbol registry entry");
+		symbols.infallibleAppend(sym);
+	}
+	registry.clear();
+	for (JS::Symbol *sym : symbols) {
+		registry.putNewInfallible(sym->description(), sym);
+	}
+
+	/* The context's caches are keyed by, or hold, cells: empty them. */
+	ContextCaches &caches = rt->contextFromMainThread()->caches;
+	caches.envCoordinateNameCache.purge();
+	caches.newObjectCache.purge();
+	caches.nativeIterCache.purge();
+	caches.megamorphicCache.purge();
+	if (caches.evalCache.initialized()) {
+		caches.evalCache.clear();
+	}
+	caches.lazyScriptCache = LazyScriptCache();
 }
 
 void
 MM_CollectorLanguageInterfaceImpl::compactScheme_workerCleanupAfterGC(MM_EnvironmentBase *env)
 {
-	Assert_MM_unimplemented();
 }
 
 void
 MM_CollectorLanguageInterfaceImpl::compactScheme_languageMasterSetupForGC(MM_EnvironmentBase *env)
 {
-	Assert_MM_unimplemented();
+	GCRuntime *gc = OmrGcHelper::runtime;
+	omrjs::SwitchPhase(gc->stats, gcstats::PHASE_COMPACT);
+	gc->compactedCells.clear();
+	gc->compactedObjects.clear();
+}
+
+/* Whether anything which compactScheme_fixupRoots cannot update refers to
+ * cells: objectMoved hooks, debuggers (their weak maps, breakpoints and
+ * debug scripts), watchpoints and script counts.
+ */
+static bool
+HasReferencesUnfixableByCompaction(JSRuntime *rt)
+{
+	if (rt->gc.objectMovedHooksUsed || !rt->debuggerList.isEmpty()) {
+		return true;
+	}
+	for (CompartmentsIter c(rt, WithAtoms); !c.done(); c.next()) {
+		if ((c->watchpointMap && !c->watchpointMap->empty())
+			|| (c->scriptCountsMap && !c->scriptCountsMap->empty())
+			|| (c->debugScriptMap && !c->debugScriptMap->empty())
+		) {
+			return true;
+		}
+	}
+	return false;
+}
+
+CompactPreventedReason
+MM_CollectorLanguageInterfaceImpl::parallelGlobalGC_checkIfCompactionShouldBePrevented(MM_EnvironmentBase *env)
+{
+	/* Only shrinking collections compact. Cells cannot be pinned one at a
+	 * time, so any AutoDisableCompactingGC in scope, any zone in use off the
+	 * main thread, or any reference the fixup cannot reach, prevents
+	 * compaction.
+	 */
+	GCRuntime *gc = OmrGcHelper::runtime;
+	if (gc->isShrinkingGC() && gc->isCompactingGCEnabled() && !gc->rt->exclusiveThreadsPresent()
+		&& !HasReferencesUnfixableByCompaction(gc->rt)
+	) {
+		return COMPACT_PREVENTED_NONE;
+	}
+	return COMPACT_PREVENTED_CRITICAL_REGIONS;
 }
 #endif /* OMR_GC_MODRON_COMPACTION */
 
@@ -494,6 +1445,63 @@ MM_CollectorLanguageInterfaceImpl::concurrentGC_collectRoots(MM_EnvironmentStand
 
 	return bytesScanned;
 }
+
+void
+MM_CollectorLanguageInterfaceImpl::concurrentGC_signalThreadsToDirtyCards(MM_EnvironmentStandard *env)
+{
+	/* SpiderMonkey's pre barriers record the overwritten edge rather than
+	 * dirtying the owner's card, so "dirtying cards" here means switching on
+	 * the pre barriers in the runtime and in jitcode.
+	 */
+	concurrentGC_toggleBarriers(true);
+}
+
+void
+MM_CollectorLanguageInterfaceImpl::concurrentGC_signalThreadsToStopDirtyingCards(MM_EnvironmentStandard *env)
+{
+	concurrentGC_toggleBarriers(false);
+}
+
+void
+MM_CollectorLanguageInterfaceImpl::concurrentGC_toggleBarriers(bool enabled)
+{
+	if (OmrGcHelper::concurrentMarking == enabled) {
+		return;
+	}
+	OmrGcHelper::concurrentMarking = enabled;
+
+	/* The whole heap is marked, so zones in use off the main thread need barriers too. */
+	GCRuntime *gc = OmrGcHelper::runtime;
+	for (Zone *zone : gc->zones) {
+		JS::shadow::Zone::asShadowZone(zone)->needsIncrementalBarrier_ = enabled;
+		js::jit::ToggleBarriers(zone, enabled);
+	}
+}
+
+void
+MM_CollectorLanguageInterfaceImpl::concurrentGC_markBarrieredCells(MM_EnvironmentBase *env)
+{
+	GCRuntime *gc = OmrGcHelper::runtime;
+	Vector<Cell *, 0, SystemAllocPolicy> cells;
+	{
+		LockGuard<Mutex> guard(gc->concurrentBarrierLock);
+		cells.swap(gc->concurrentBarrierBuffer);
+
+		/* The cells still in the threads' buffers. The buffers keep them,
+		 * and marking a cell twice is harmless.
+		 */
+		AutoEnterOOMUnsafeRegion oomUnsafe;
+		for (ConcurrentBarrierBuffer *buffer : gc->concurrentBarrierBuffers) {
+			if (!buffer->appendTo(gc, cells)) {
+				oomUnsafe.crash("Failed to allocate for concurrentGC_markBarrieredCells.");
+			}
+		}
+	}
+
+	for (Cell *cell : cells) {
+		_markingScheme->markObject(env, (omrobjectptr_t)cell, false);
+	}
+}
 #endif /* OMR_GC_MODRON_CONCURRENT_MARK */
 
 omrobjectptr_t
@@ -506,32 +1514,40 @@ MM_CollectorLanguageInterfaceImpl::parallelGlobalGC_postMarkProcessing(MM_Enviro
 {
 	OMR_VM *omrVM = env->getOmrVM();
 	JSRuntime *rt = (JSRuntime *)omrVM->_language_vm;
-	Zone *zone = OmrGcHelper::zone;
-	js::AutoLockForExclusiveAccess lock(rt);
+	omrjs::CollectorSession session(rt);
+	AutoLockForExclusiveAccess &lock = session.lock();
+
+	omrjs::SwitchPhase(rt->gc.stats, gcstats::PHASE_SWEEP);
 
 	/* Clear new object cache. Its entries may point to dead objects. */
 	rt->contextFromMainThread()->caches.newObjectCache.clearNurseryObjects(rt);
+	/* Likewise the megamorphic cache, whose keys are shapes. */
+	rt->contextFromMainThread()->caches.megamorphicCache.purge();
 
-	for (WeakMapBase* m : zone->gcWeakMapList) {
-		m->sweep();
-	}
-	for (JS::WeakCache<void*>* cache : zone->weakCaches_) {
-		cache->sweep();
-	}
+	/* Every zone is swept as part of one group, except those in use off the
+	 * main thread, whose tables belong to that thread until it is done.
+	 */
+	AutoEnterOOMUnsafeRegion oomUnsafe;
+	for (GCZoneGroupIter zone(rt); !zone.done(); zone.next()) {
+		/* Drop the maps whose owners died and the dead entries of the rest.
+		 * The survivors start the next cycle unmarked, like any other cell.
+		 */
+		WeakMapBase::sweepZone(zone);
+		WeakMapBase::unmarkZone(zone);
+
+		for (auto edge : zone->gcWeakRefs) {
+			/* Edges may be present multiple times, so may already be nulled. */
+			if (*edge && IsAboutToBeFinalizedDuringSweep(**edge)) {
+				*edge = nullptr;
+			}
+		}
+		zone->gcWeakRefs.clear();
 
-	for (auto edge : zone->gcWeakRefs) {
-		/* Edges may be present multiple times, so may already be nulled. */
-		if (*edge && IsAboutToBeFinalizedDuringSweep(**edge)) {
-			*edge = nullptr;
+		/* No need to look up any more weakmap keys from this zone group. */
+		if (!zone->gcWeakKeys.clear()) {
+			oomUnsafe.crash("clearing weak keys in beginSweepingZoneGroup()");
 		}
 	}
-    zone->gcWeakRefs.clear();
-
-    /* No need to look up any more weakmap keys from this zone group. */
-    AutoEnterOOMUnsafeRegion oomUnsafe;
-    if (!zone->gcWeakKeys.clear()) {
-            oomUnsafe.crash("clearing weak keys in beginSweepingZoneGroup()");
-    }
 
 	FreeOp fop(rt);
     
@@ -542,9 +1558,28 @@ MM_CollectorLanguageInterfaceImpl::parallelGlobalGC_postMarkProcessing(MM_Enviro
     //         callWeakPointerCompartmentCallbacks(comp);
     // }
 
-	// for (auto& task : sweepCacheTasks) {
-	// 	startTask(task, gcstats::PHASE_SWEEP_MISC, helperLock);
-	// }
+	/* The weak caches and the tables below have no dependencies on what
+	 * the main thread sweeps until the tasks are joined, so they are swept
+	 * on helper threads meanwhile.
+	 */
+	omrjs::SweepTask sweepAtomsTask(rt, omrjs::SweepAtoms);
+	omrjs::SweepTask sweepCCWrappersTask(rt, omrjs::SweepCCWrappers);
+	omrjs::SweepTask sweepRegExpsTask(rt, omrjs::SweepRegExps);
+	omrjs::SweepTask sweepObjectGroupsTask(rt, omrjs::SweepObjectGroups);
+	omrjs::SweepTask sweepMiscTask(rt, omrjs::SweepMisc);
+	omrjs::WeakCacheTaskVector sweepCacheTasks;
+	omrjs::PrepareWeakCacheTasks(rt, sweepCacheTasks);
+	{
+		AutoLockHelperThreadState helperLock;
+		omrjs::StartSweepTask(rt, sweepAtomsTask, helperLock);
+		omrjs::StartSweepTask(rt, sweepCCWrappersTask, helperLock);
+		omrjs::StartSweepTask(rt, sweepRegExpsTask, helperLock);
+		omrjs::StartSweepTask(rt, sweepObjectGroupsTask, helperLock);
+		omrjs::StartSweepTask(rt, sweepMiscTask, helperLock);
+		for (auto &task : sweepCacheTasks) {
+			omrjs::StartSweepTask(rt, task, helperLock);
+		}
+	}
 
 	// Cancel any active or pending off thread compilations.
 	js::CancelOffThreadIonCompile(rt, JS::Zone::Sweep);
@@ -568,45 +1603,54 @@ MM_CollectorLanguageInterfaceImpl::parallelGlobalGC_postMarkProcessing(MM_Enviro
 	// Sweep entries containing about-to-be-finalized JitCode and
 	// update relocated TypeSet::Types inside the JitcodeGlobalTable.
 	jit::JitRuntime::SweepJitcodeGlobalTable(rt);
-	zone->discardJitCode(&fop);
+	for (GCZoneGroupIter zone(rt); !zone.done(); zone.next()) {
+		zone->discardJitCode(&fop);
 
-	zone->beginSweepTypes(&fop, !zone->isPreservingCode());
-	zone->sweepBreakpoints(&fop);
-	zone->sweepUniqueIds(&fop);
+		zone->beginSweepTypes(&fop, !zone->isPreservingCode());
+		zone->sweepBreakpoints(&fop);
+		zone->sweepUniqueIds(&fop);
+	}
 	rt->symbolRegistry(lock).sweep();
-	
-	rt->sweepAtoms();
 
-    for (GCCompartmentGroupIter c(rt); !c.done(); c.next()) {
-        c->sweepCrossCompartmentWrappers();
+	{
+		AutoLockHelperThreadState helperLock;
+		sweepAtomsTask.joinWithLockHeld(helperLock);
+		sweepCCWrappersTask.joinWithLockHeld(helperLock);
+		sweepRegExpsTask.joinWithLockHeld(helperLock);
+		sweepObjectGroupsTask.joinWithLockHeld(helperLock);
+		sweepMiscTask.joinWithLockHeld(helperLock);
+		for (auto &task : sweepCacheTasks) {
+			task.joinWithLockHeld(helperLock);
+		}
 	}
 
-    for (GCCompartmentGroupIter c(rt); !c.done(); c.next())
-        c->sweepRegExps();
-
-    for (GCCompartmentGroupIter c(rt); !c.done(); c.next())
-        c->objectGroups.sweep(rt->defaultFreeOp());
-
-   	for (GCCompartmentGroupIter c(rt); !c.done(); c.next()) {
-        c->sweepSavedStacks();
-        c->sweepSelfHostingScriptSource();
-        c->sweepNativeIterators();
-    }
-
 	rt->gc.callFinalizeCallbacks(&fop, JSFINALIZE_GROUP_END);
 
-	zone->types.endSweep(rt);
+	for (GCZoneGroupIter zone(rt); !zone.done(); zone.next()) {
+		zone->types.endSweep(rt);
+	}
 
 	/* This puts the heap into the state required to walk it */
 	GC_OMRVMInterface::flushCachesForGC(env);
 
+	/* The buffers of dead background finalized objects are freed after the
+	 * collection. The last collection's must be gone before queueing more.
+	 */
+	if (NULL == _freeBuffersTask) {
+		_freeBuffersTask = js_new<omrjs::FreeBuffersTask>();
+	} else {
+		_freeBuffersTask->join();
+	}
+	omrjs::FreeBuffersTask *freeBuffersTask = _freeBuffersTask;
+
 	MM_HeapRegionManager *regionManager = _extensions->getHeap()->getHeapRegionManager();
 	{
 		GC_HeapRegionIterator regionIterator(regionManager);
 
-		/* Walk the heap for sweeping. */
+		/* Walk the heap for sweeping. Each cell clears its own zone's type
+		 * inference state on OOM, as cells of all zones are interleaved.
+		 */
 		MM_HeapRegionDescriptor *hrd = regionIterator.nextRegion();
-		AutoClearTypeInferenceStateOnOOM oom(zone);
 		while (NULL != hrd) {
 			GC_ObjectHeapIteratorAddressOrderedList objectIterator(_extensions, hrd, false);
 			omrobjectptr_t omrobjPtr = objectIterator.nextObject();
@@ -614,18 +1658,27 @@ MM_CollectorLanguageInterfaceImpl::parallelGlobalGC_postMarkProcessing(MM_Enviro
 				/* Sweep scripts, object groups, and shapes. */
 				js::gc::Cell *thing = (js::gc::Cell *)omrobjPtr;
 				js::gc::AllocKind kind = thing->getAllocKind();
-				if (kind == js::gc::AllocKind::SHAPE || kind == js::gc::AllocKind::ACCESSOR_SHAPE /*|| kind == js::gc::AllocKind::BASE_SHAPE*/) {
+				if (omrjs::IsPinned(thing)) {
+					/* Kept without being scanned, so the sweep below leaves it be. */
+					_markingScheme->markObject(env, omrobjPtr, true);
+				} else if (kind == js::gc::AllocKind::SHAPE || kind == js::gc::AllocKind::ACCESSOR_SHAPE /*|| kind == js::gc::AllocKind::BASE_SHAPE*/) {
 					if (!((Shape *)thing)->isMarked()) {
 						((Shape *)thing)->sweep();
 					}
 				} else if (kind == js::gc::AllocKind::OBJECT_GROUP) {
-					((ObjectGroup *)thing)->maybeSweep(&oom);
+					((ObjectGroup *)thing)->maybeSweep(nullptr);
 				} else if (kind == js::gc::AllocKind::SCRIPT /*|| kind == js::gc::AllocKind::LAZY_SCRIPT*/) {
-					((JSScript *)thing)->maybeSweepTypes(&oom);
+					((JSScript *)thing)->maybeSweepTypes(nullptr);
 				} else if (((int)kind) >= (int)js::gc::AllocKind::OBJECT0 && ((int)kind) <= (int)js::gc::AllocKind::OBJECT16_BACKGROUND) {
 					JSObject *obj = (JSObject *)thing;
 					if (obj->is<js::NativeObject>() && !_markingScheme->isMarked(omrobjPtr)) {
-						obj->as<js::NativeObject>().deleteAllSlots();
+						if ((NULL != freeBuffersTask) && IsBackgroundFinalized(kind)) {
+							obj->as<js::NativeObject>().deleteAllSlots([freeBuffersTask](void *buffer) {
+								freeBuffersTask->queue(buffer);
+							});
+						} else {
+							obj->as<js::NativeObject>().deleteAllSlots();
+						}
 					}
 				}
 				omrobjPtr = objectIterator.nextObject();
@@ -633,29 +1686,87 @@ MM_CollectorLanguageInterfaceImpl::parallelGlobalGC_postMarkProcessing(MM_Enviro
 			hrd = regionIterator.nextRegion();
 		}
 	}
+	if ((NULL != freeBuffersTask) && !freeBuffersTask->empty() && !freeBuffersTask->start()) {
+		freeBuffersTask->runFromMainThread(rt);
+	}
 	{
 		GC_HeapRegionIterator regionIterator(regionManager);
+		js::gc::StoreBuffer &storeBuffer = rt->gc.storeBuffer;
+		AutoEnterOOMUnsafeRegion oomUnsafeStoreBuffer;
+		if (!storeBuffer.beginSweepDeadEdges()) {
+			oomUnsafeStoreBuffer.crash("sweeping the store buffer in parallelGlobalGC_postMarkProcessing()");
+		}
 
 		/* Walk the heap, for objects that are not marked we corrupt them to maximize the chance we will crash immediately
 		if they are used.  For live objects validate that they have the expected eyecatcher */
 		MM_HeapRegionDescriptor *hrd = regionIterator.nextRegion();
-		AutoClearTypeInferenceStateOnOOM oom(zone);
+
+		/* Live bytes are counted per zone on the way, for the memory reporters. */
+		rt->gc.usage.resetGCBytes();
+		for (Zone *zone : rt->gc.zones) {
+			zone->usage.resetGCBytes();
+		}
+
+		/* And by class and alloc kind, if asked for. */
+		MM_FrequentObjectsStats *frequentObjects = NULL;
+		if (rt->gc.frequentObjectsEnabled) {
+			if (NULL == _frequentObjectsStats) {
+				_frequentObjectsStats = MM_FrequentObjectsStats::newInstance(env);
+			}
+			frequentObjects = _frequentObjectsStats;
+			if (NULL != frequentObjects) {
+				frequentObjects->clear();
+			}
+		}
+
 		while (NULL != hrd) {
 			/* Walk all of the objects, making sure that those that were not marked are no longer
 			usable. If they are later used we will know this and optimally crash */
 			GC_ObjectHeapIteratorAddressOrderedList objectIterator(_extensions, hrd, false);
 			omrobjectptr_t omrobjPtr = objectIterator.nextObject();
 			while (NULL != omrobjPtr) {
+				uintptr_t objsize = _extensions->objectModel.getConsumedSizeInBytesWithHeader(omrobjPtr);
 				if (!_markingScheme->isMarked(omrobjPtr)) {
 					/* object will be collected. We write the full contents of the object with a known value. */
-					uintptr_t objsize = _extensions->objectModel.getConsumedSizeInBytesWithHeader(omrobjPtr);
+					/* Store buffer edges inside the object die with it. */
+					storeBuffer.sweepDeadEdgesInRange((uintptr_t)omrobjPtr, (uintptr_t)omrobjPtr + objsize);
 					memset(omrobjPtr, 0x5E, (size_t)objsize);
 					MM_HeapLinkedFreeHeader::fillWithHoles(omrobjPtr, objsize);
+				} else {
+					((js::gc::Cell *)omrobjPtr)->zone()->usage.addGCBytes(objsize);
+					if (NULL != frequentObjects) {
+						frequentObjects->update(env, omrobjPtr);
+					}
 				}
 				omrobjPtr = objectIterator.nextObject();
 			}
 			hrd = regionIterator.nextRegion();
 		}
+		storeBuffer.endSweepDeadEdges();
+
+		if (NULL != frequentObjects) {
+			reportFrequentObjects(env, frequentObjects);
+		}
+	}
+}
+
+void
+MM_CollectorLanguageInterfaceImpl::reportFrequentObjects(MM_EnvironmentBase *env, MM_FrequentObjectsStats *stats)
+{
+	/* Kept for the frequentObjects() shell function. */
+	GCRuntime *gc = OmrGcHelper::runtime;
+	gc->frequentObjects.clear();
+	if (gc->frequentObjects.reserve(stats->getCount())) {
+		for (uintptr_t k = 1; k <= stats->getCount(); k++) {
+			GCRuntime::FrequentObjectsEntry entry;
+			entry.name = MM_FrequentObjectsStats::getKeyName(stats->getKthMostFrequent(k));
+			entry.bytes = stats->getKthMostFrequentBytes(k);
+			gc->frequentObjects.infallibleAppend(entry);
+		}
+	}
+
+	if (NULL != _extensions->verboseGCManager) {
+		((MM_VerboseManagerImpl *)_extensions->verboseGCManager)->outputFrequentObjects(env, stats);
 	}
 }
 
@@ -29,10 +29,12 @@ class GC_ObjectScanner;
 class MM_CompactScheme;
 class MM_EnvironmentStandard;
 class MM_ForwardedHeader;
+class MM_FrequentObjectsStats;
 class MM_MarkingScheme;
 class MM_MemorySubSpaceSemiSpace;
 
 namespace omrjs {
+	class FreeBuffersTask;
 	class OMRGCMarker;
 };
 
@@ -47,6 +49,9 @@ protected:
 	OMR_VM *_omrVM;
 	MM_GCExtensionsBase *_extensions;
 	MM_MarkingScheme *_markingScheme;
+	MM_FrequentObjectsStats *_frequentObjectsStats; /**< Created on first use, see JSGC_FREQUENT_OBJECTS_ENABLED */
+	omrjs::FreeBuffersTask *_freeBuffersTask; /**< Frees dead objects' malloc'd buffers after a collection, created on first use */
+	volatile bool _weakMapsMarkedAny; /**< Whether the current weak map marking pass marked anything */
 
 public:
 	enum AttachVMThreadReason {
@@ -55,9 +60,14 @@ public:
 		ATTACH_GC_HELPER_THREAD = 0x2,
 		ATTACH_GC_MASTER_THREAD = 0x3,
 	};
-	omrjs::OMRGCMarker *_omrGCMarker;
 
 private:
+	void reportFrequentObjects(MM_EnvironmentBase *env, MM_FrequentObjectsStats *stats);
+#if defined(OMR_GC_MODRON_CONCURRENT_MARK)
+	void concurrentGC_markBarrieredCells(MM_EnvironmentBase *env);
+	void concurrentGC_toggleBarriers(bool enabled);
+#endif /* OMR_GC_MODRON_CONCURRENT_MARK */
+
 protected:
 	bool initialize(OMR_VM *omrVM);
 	void tearDown(OMR_VM *omrVM);
@@ -66,7 +76,10 @@ protected:
 		: MM_CollectorLanguageInterface()
 		,_omrVM(omrVM)
 		,_extensions(MM_GCExtensionsBase::getExtensions(omrVM))
-		,_omrGCMarker(NULL)
+		,_markingScheme(NULL)
+		,_frequentObjectsStats(NULL)
+		,_freeBuffersTask(NULL)
+		,_weakMapsMarkedAny(false)
 	{
 		_typeId = __FUNCTION__;
 	}
@@ -75,6 +88,8 @@ public:
 	static MM_CollectorLanguageInterfaceImpl *newInstance(MM_EnvironmentBase *env);
 	virtual void kill(MM_EnvironmentBase *env);
 
+	MM_MarkingScheme *getMarkingScheme() { return _markingScheme; }
+
 	virtual void doFrequentObjectAllocationSampling(MM_EnvironmentBase* env) {}
 	virtual bool checkForExcessiveGC(MM_EnvironmentBase *env, MM_Collector *collector) {return false;}
 
@@ -86,8 +101,8 @@ public:
 	virtual bool globalCollector_isTimeForGlobalGCKickoff() {return false;}
 	virtual void globalCollector_internalPostCollect(MM_EnvironmentBase* env, MM_MemorySubSpace* subSpace) {}
 
-	virtual void parallelGlobalGC_masterThreadGarbageCollect_beforeGC(MM_EnvironmentBase *env) {}
-	virtual void parallelGlobalGC_masterThreadGarbageCollect_afterGC(MM_EnvironmentBase *env, bool compactThisCycle) {}
+	virtual void parallelGlobalGC_masterThreadGarbageCollect_beforeGC(MM_EnvironmentBase *env);
+	virtual void parallelGlobalGC_masterThreadGarbageCollect_afterGC(MM_EnvironmentBase *env, bool compactThisCycle);
 	virtual void parallelGlobalGC_postPrepareHeapForWalk(MM_EnvironmentBase *env) {}
 	virtual void parallelGlobalGC_postMarkProcessing(MM_EnvironmentBase *env);
 	virtual void parallelGlobalGC_setupBeforeGC(MM_EnvironmentBase *env) {}
@@ -117,8 +132,8 @@ public:
 	virtual uintptr_t concurrentGC_getNextTracingMode(uintptr_t executionMode);
 	virtual uintptr_t concurrentGC_collectRoots(MM_EnvironmentStandard *env, uintptr_t concurrentStatus, bool *collectedRoots, bool *paidTax);
 	virtual void concurrentGC_signalThreadsToTraceStacks(MM_EnvironmentStandard *env) {}
-	virtual void concurrentGC_signalThreadsToDirtyCards(MM_EnvironmentStandard *env) {}
-	virtual void concurrentGC_signalThreadsToStopDirtyingCards(MM_EnvironmentStandard *env) {}
+	virtual void concurrentGC_signalThreadsToDirtyCards(MM_EnvironmentStandard *env);
+	virtual void concurrentGC_signalThreadsToStopDirtyingCards(MM_EnvironmentStandard *env);
 	virtual void concurrentGC_kickoffCardCleaning(MM_EnvironmentStandard *env) {}
 	virtual void concurrentGC_flushRegionReferenceLists(MM_EnvironmentBase *env) {}
 	virtual void concurrentGC_flushThreadReferenceBuffer(MM_EnvironmentBase *env) {}
@@ -151,11 +166,16 @@ public:
 	virtual omrobjectptr_t heapWalker_heapWalkerObjectSlotDo(omrobjectptr_t object);
 
 #if defined(OMR_GC_MODRON_COMPACTION)
-	virtual CompactPreventedReason parallelGlobalGC_checkIfCompactionShouldBePrevented(MM_EnvironmentBase *env) {return COMPACT_PREVENTED_NONE;}
+	virtual CompactPreventedReason parallelGlobalGC_checkIfCompactionShouldBePrevented(MM_EnvironmentBase *env);
 	virtual void compactScheme_languageMasterSetupForGC(MM_EnvironmentBase *env);
 	virtual void compactScheme_fixupRoots(MM_EnvironmentBase *env, MM_CompactScheme *compactScheme);
 	virtual void compactScheme_workerCleanupAfterGC(MM_EnvironmentBase *env);
 	virtual void compactScheme_verifyHeap(MM_EnvironmentBase *env, MM_MarkMap *markMap);
+	/**
+	 * Called from MM_CompactSchemeFixupObject for every live cell, at its new
+	 * address. The cell is fixed up later, in compactScheme_fixupRoots.
+	 */
+	uintptr_t compactScheme_fixupObject(MM_EnvironmentBase *env, omrobjectptr_t objectPtr);
 #endif /* OMR_GC_MODRON_COMPACTION */
 
 #if defined(OMR_GC_MODRON_SCAVENGER)
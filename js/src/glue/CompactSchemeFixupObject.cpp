@@ -19,22 +19,25 @@
 #include "omr.h"
 #include "objectdescription.h"
 
+#include "CollectorLanguageInterfaceImpl.hpp"
 #include "CompactSchemeFixupObject.hpp"
 #include "EnvironmentStandard.hpp"
+#include "ModronAssertions.h"
 
 #if defined(OMR_GC_MODRON_COMPACTION)
 
 void
 MM_CompactSchemeFixupObject::fixupObject(MM_EnvironmentStandard *env, omrobjectptr_t objectPtr)
 {
-#error provide an implementation to fix objects during a compact
+	((MM_CollectorLanguageInterfaceImpl *)_extensions->collectorLanguageInterface)->compactScheme_fixupObject(env, objectPtr);
 }
 
 
 void
 MM_CompactSchemeFixupObject::verifyForwardingPtr(omrobjectptr_t objectPtr, omrobjectptr_t forwardingPtr)
 {
-#error provide an implementation to verify objects after a compact is complete
+	/* The compactor slides cells towards the start of the heap. */
+	Assert_MM_true(forwardingPtr <= objectPtr);
 }
 
 #endif /* OMR_GC_MODRON_COMPACTION */
@@ -21,6 +21,9 @@
 #include "EnvironmentStandard.hpp"
 #include "Forge.hpp"
 #include "GCExtensionsBase.hpp"
+#if defined (OMR_GC_THREAD_LOCAL_HEAP)
+#include "LanguageThreadLocalHeap.hpp"
+#endif /* OMR_GC_THREAD_LOCAL_HEAP */
 
 
 MM_EnvironmentLanguageInterfaceImpl::MM_EnvironmentLanguageInterfaceImpl(MM_EnvironmentBase *env)
@@ -81,6 +84,14 @@ MM_EnvironmentLanguageInterfaceImpl::tearDown(MM_EnvironmentBase *env)
 void
 MM_EnvironmentLanguageInterfaceImpl::disableInlineTLHAllocate()
 {
+	LanguageThreadLocalHeapStruct *tlh = _env->_languageThreadLocalHeap.getLanguageThreadLocalHeapStruct(_env, true);
+	uint8_t **heapAlloc = _env->_languageThreadLocalHeap.getPointerToHeapAlloc(_env, true);
+	uint8_t **heapTop = _env->_languageThreadLocalHeap.getPointerToHeapTop(_env, true);
+	if (NULL == tlh->realHeapAlloc) {
+		/* The JIT bump-allocates against heapAlloc/heapTop, so an empty TLH sends it out of line */
+		tlh->realHeapAlloc = *heapAlloc;
+		*heapAlloc = *heapTop;
+	}
 }
 
 /**
@@ -89,6 +100,12 @@ MM_EnvironmentLanguageInterfaceImpl::disableInlineTLHAllocate()
 void
 MM_EnvironmentLanguageInterfaceImpl::enableInlineTLHAllocate()
 {
+	LanguageThreadLocalHeapStruct *tlh = _env->_languageThreadLocalHeap.getLanguageThreadLocalHeapStruct(_env, true);
+	uint8_t **heapAlloc = _env->_languageThreadLocalHeap.getPointerToHeapAlloc(_env, true);
+	if (NULL != tlh->realHeapAlloc) {
+		*heapAlloc = tlh->realHeapAlloc;
+		tlh->realHeapAlloc = NULL;
+	}
 }
 
 /**
@@ -98,7 +115,8 @@ MM_EnvironmentLanguageInterfaceImpl::enableInlineTLHAllocate()
 bool
 MM_EnvironmentLanguageInterfaceImpl::isInlineTLHAllocateEnabled()
 {
-	return false;
+	LanguageThreadLocalHeapStruct *tlh = _env->_languageThreadLocalHeap.getLanguageThreadLocalHeapStruct(_env, true);
+	return NULL == tlh->realHeapAlloc;
 }
 #endif /* OMR_GC_THREAD_LOCAL_HEAP */
 
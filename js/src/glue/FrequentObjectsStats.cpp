@@ -20,6 +20,10 @@
 #include "EnvironmentBase.hpp"
 #include "ModronAssertions.h"
 
+#include "jsobj.h"
+
+#include "gc/Heap.h"
+
 /**
  * Create and return a new instance of MM_FrequentObjectsStats.
  *
@@ -28,44 +32,94 @@
 MM_FrequentObjectsStats *
 MM_FrequentObjectsStats::newInstance(MM_EnvironmentBase *env)
 {
-	/* DO NOTHING */
-	return NULL;
+	OMRPORT_ACCESS_FROM_ENVIRONMENT(env);
+	MM_FrequentObjectsStats *frequentObjectsStats = (MM_FrequentObjectsStats *)env->getForge()->allocate(sizeof(MM_FrequentObjectsStats), MM_AllocationCategory::FIXED, OMR_GET_CALLSITE());
+	if (NULL != frequentObjectsStats) {
+		new(frequentObjectsStats) MM_FrequentObjectsStats(OMRPORTLIB);
+		if (!frequentObjectsStats->initialize(env)) {
+			frequentObjectsStats->kill(env);
+			frequentObjectsStats = NULL;
+		}
+	}
+	return frequentObjectsStats;
 }
 
 
 bool
 MM_FrequentObjectsStats::initialize(MM_EnvironmentBase *env)
 {
-	/* DO NOTHING */
-	return false;
+	_spaceSaving = spaceSavingNew(_portLibrary, getSizeForTopKFrequent(_topKFrequent));
+	return NULL != _spaceSaving;
 }
 
 void
 MM_FrequentObjectsStats::tearDown(MM_EnvironmentBase *env)
 {
-	/* DO NOTHING */
-	return;
+	if (NULL != _spaceSaving) {
+		spaceSavingFree(_spaceSaving);
+		_spaceSaving = NULL;
+	}
 }
 
 
 void
 MM_FrequentObjectsStats::kill(MM_EnvironmentBase *env)
 {
-	/* DO NOTHING */
-	return;
+	tearDown(env);
+	env->getForge()->free(this);
+}
+
+void *
+MM_FrequentObjectsStats::getKey(omrobjectptr_t object)
+{
+	js::gc::Cell *cell = (js::gc::Cell *)object;
+	if (!cell->isOmrBuffer() && (JS::TraceKind::Object == cell->getTraceKind())) {
+		return (void *)((JSObject *)cell)->getClass();
+	}
+	uintptr_t kind = cell->isOmrBuffer() ? js::gc::Cell::OmrBufferKind : uintptr_t(cell->getAllocKind());
+	return (void *)((kind << 1) | 1);
+}
+
+const char *
+MM_FrequentObjectsStats::getKeyName(void *key)
+{
+	if (0 == (uintptr_t(key) & 1)) {
+		return ((const js::Class *)key)->name;
+	}
+	uintptr_t kind = uintptr_t(key) >> 1;
+	if (js::gc::Cell::OmrBufferKind == kind) {
+		return "slots and elements";
+	}
+	switch ((js::gc::AllocKind)kind) {
+#define ALLOCKIND_NAME(allocKind, traceKind, type, sizedType) \
+	case js::gc::AllocKind::allocKind: return #allocKind;
+FOR_EACH_NONOBJECT_ALLOCKIND(ALLOCKIND_NAME)
+#undef ALLOCKIND_NAME
+	default:
+		return "unknown";
+	}
+}
+
+void
+MM_FrequentObjectsStats::update(MM_EnvironmentBase *env, omrobjectptr_t object)
+{
+	uintptr_t size = env->getExtensions()->objectModel.getConsumedSizeInBytesWithHeader(object);
+	spaceSavingUpdate(_spaceSaving, getKey(object), size);
 }
 
 void
 MM_FrequentObjectsStats::traceStats(MM_EnvironmentBase *env)
 {
-	/* DO NOTHING */
-	return;
+	OMRPORT_ACCESS_FROM_ENVIRONMENT(env);
+	for (uintptr_t k = 1; k <= getCount(); k++) {
+		omrtty_printf("\t%s %zu\n", getKeyName(getKthMostFrequent(k)), (size_t)getKthMostFrequentBytes(k));
+	}
 }
 
 void
 MM_FrequentObjectsStats::merge(MM_FrequentObjectsStats* frequentObjectsStats)
 {
-	/* DO NOTHING */
-	return;
+	for (uintptr_t k = 1; k <= frequentObjectsStats->getCount(); k++) {
+		spaceSavingUpdate(_spaceSaving, frequentObjectsStats->getKthMostFrequent(k), frequentObjectsStats->getKthMostFrequentBytes(k));
+	}
 }
-
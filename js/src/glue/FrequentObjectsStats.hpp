@@ -30,12 +30,16 @@ class MM_EnvironmentBase;
 #define K_TO_SIZE_RATIO 8
 
 /*
- * Keeps track of the most frequent class instantiations
+ * Keeps track of the kinds of cells holding the most bytes. Objects are
+ * counted by js::Class and other cells by js::gc::AllocKind.
  */
 
 class MM_FrequentObjectsStats : public MM_Base
 {
 private:
+	OMRPortLibrary *_portLibrary;
+	OMRSpaceSaving *_spaceSaving;
+	uint32_t _topKFrequent;
 
 	/*
 	 * Estimates the space necessary to report the top k elements accurately 90% of the time.
@@ -45,10 +49,14 @@ private:
 	uint32_t
 	getSizeForTopKFrequent(uint32_t topKFrequent)
 	{
-		/* DO NOTHING */
-		return 0;
+		return topKFrequent * K_TO_SIZE_RATIO;
 	}
 
+	/* The key a cell is counted under. Classes are word aligned, so alloc
+	 * kinds are tagged with the low bit.
+	 */
+	static void *getKey(omrobjectptr_t object);
+
 /* Function Members */
 public:
 	static MM_FrequentObjectsStats *newInstance(MM_EnvironmentBase *env);
@@ -57,27 +65,39 @@ public:
 	/* reset the stats*/
 	void clear()
 	{
-		/* DO NOTHING */
-		return;
+		spaceSavingClear(_spaceSaving);
 	}
 
 	/*
-	 * Update stats with another class
-	 * @param clazz another clazz to record
+	 * Update stats with another cell
+	 * @param object the cell to record, counted by its size in bytes
 	 */
-	void
-	update(MM_EnvironmentBase *env, omrobjectptr_t object)
+	void update(MM_EnvironmentBase *env, omrobjectptr_t object);
+
+	/* The number of entries which can be reported. */
+	uintptr_t
+	getCount()
 	{
-		/* DO NOTHING */
-		return;
+		uintptr_t size = spaceSavingGetCurSize(_spaceSaving);
+		return (size < _topKFrequent) ? size : _topKFrequent;
 	}
 
+	/* The key and byte count of the k'th most frequent entry, from 1. */
+	void *getKthMostFrequent(uintptr_t k) { return spaceSavingGetKthMostFreq(_spaceSaving, k); }
+	uintptr_t getKthMostFrequentBytes(uintptr_t k) { return spaceSavingGetKthMostFreqCount(_spaceSaving, k); }
+
+	/* The class or alloc kind name of a key. */
+	static const char *getKeyName(void *key);
+
 	/* Creates a data structure which keeps track of the k most frequent class allocations (estimated probability of 90% of
 	 * reporting this accurately (and in the correct order).  The larger k is, the more memory is required
 	 * @param portLibrary the port library
 	 * @param k the number of frequent objects we'd like to accurately report
 	 */
 	MM_FrequentObjectsStats(OMRPortLibrary *portLibrary, uint32_t k=TOPK_FREQUENT_DEFAULT)
+		: _portLibrary(portLibrary)
+		, _spaceSaving(NULL)
+		, _topKFrequent(k)
 	{}
 
 
@@ -28,6 +28,7 @@
 #include "ModronAssertions.h"
 #include "modronbase.h"
 #include "objectdescription.h"
+#include "AtomicOperations.hpp"
 #include "Bits.hpp"
 #include "HeapLinkedFreeHeader.hpp"
 
@@ -68,6 +69,10 @@
 #define STATE_NOT_REMEMBERED  	0
 #define STATE_REMEMBERED		(OMR_OBJECT_METADATA_REMEMBERED_BITS_TO_SET & OMR_OBJECT_METADATA_REMEMBERED_BITS)
 
+/* The JIT and the post barriers test the remembered bits through js::gc::Cell. */
+static_assert(OMR_OBJECT_METADATA_REMEMBERED_BITS == js::gc::Cell::OmrRememberedBits, "remembered bits must match gc::Cell");
+static_assert(OMR_OBJECT_METADATA_SIZE_SHIFT == js::gc::Cell::OmrMetadataShift, "metadata shift must match gc::Cell");
+
 #define OMR_TENURED_STACK_OBJECT_RECENTLY_REFERENCED	(STATE_REMEMBERED + (1 << OMR_OBJECT_METADATA_REMEMBERED_BITS_SHIFT))
 #define OMR_TENURED_STACK_OBJECT_CURRENTLY_REFERENCED	(STATE_REMEMBERED + (2 << OMR_OBJECT_METADATA_REMEMBERED_BITS_SHIFT))
 
@@ -219,7 +224,11 @@ public:
 	MMINLINE uintptr_t
 	getSizeInBytesWithHeader(omrobjectptr_t objectPtr)
 	{
-          return js::gc::OmrGcHelper::thingSize(((js::gc::Cell*)objectPtr)->getAllocKind());
+		js::gc::Cell *cell = (js::gc::Cell *)objectPtr;
+		if (cell->isOmrBuffer()) {
+			return ((js::gc::OmrBuffer *)cell)->sizeInBytes();
+		}
+		return js::gc::OmrGcHelper::thingSize(cell->getAllocKind());
 	}
 
 #if defined(OMR_GC_MODRON_COMPACTION)
@@ -255,8 +264,62 @@ public:
 	MMINLINE bool
 	isRemembered(omrobjectptr_t objectPtr)
 	{
+		return 0 != getRememberedBits(objectPtr);
+	}
+
+	/**
+	 * Returns the remembered bits of an object's header.
+	 * @param objectPtr Pointer to an object
+	 * @return The remembered bits, in place
+	 */
+	MMINLINE uintptr_t
+	getRememberedBits(omrobjectptr_t objectPtr)
+	{
+		return *OMR_OBJECT_METADATA_SLOT_EA(objectPtr) & OMR_OBJECT_METADATA_REMEMBERED_BITS;
+	}
+
+	/**
+	 * Replace the remembered bits of an object's header.
+	 * @param objectPtr Pointer to an object
+	 * @param rememberedBits The new remembered bits, in place
+	 */
+	MMINLINE void
+	setRememberedBits(omrobjectptr_t objectPtr, uintptr_t rememberedBits)
+	{
+		uintptr_t header = *OMR_OBJECT_METADATA_SLOT_EA(objectPtr) & ~(uintptr_t)OMR_OBJECT_METADATA_REMEMBERED_BITS;
+		*OMR_OBJECT_METADATA_SLOT_EA(objectPtr) = header | (rememberedBits & OMR_OBJECT_METADATA_REMEMBERED_BITS);
+	}
+
+	/**
+	 * Atomically mark an object as remembered.
+	 * @param objectPtr Pointer to an object
+	 * @return true if this call set the state, false if it was already remembered
+	 */
+	MMINLINE bool
+	atomicSetRememberedState(omrobjectptr_t objectPtr)
+	{
+		volatile uintptr_t *headerPtr = (volatile uintptr_t *)OMR_OBJECT_METADATA_SLOT_EA(objectPtr);
+		uintptr_t oldHeader = *headerPtr;
+		while (0 == (oldHeader & OMR_OBJECT_METADATA_REMEMBERED_BITS)) {
+			uintptr_t newHeader = oldHeader | STATE_REMEMBERED;
+			uintptr_t previous = MM_AtomicOperations::lockCompareExchange(headerPtr, oldHeader, newHeader);
+			if (previous == oldHeader) {
+				return true;
+			}
+			oldHeader = previous;
+		}
 		return false;
 	}
+
+	/**
+	 * Clear the remembered state of an object.
+	 * @param objectPtr Pointer to an object
+	 */
+	MMINLINE void
+	clearRemembered(omrobjectptr_t objectPtr)
+	{
+		setRememberedBits(objectPtr, 0);
+	}
 #endif /* OMR_GC_MODRON_SCAVENGER */
 
  	/**
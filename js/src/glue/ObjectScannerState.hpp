@@ -20,6 +20,7 @@
 #define OBJECTSCANNERSTATE_HPP_
 
 #include "ObjectScanner.hpp"
+#include "TracingObjectScanner.hpp"
 
 /**
  * This union is not intended for runtime usage -- it is required only to determine the maximal size of
@@ -30,6 +31,9 @@
 typedef union GC_ObjectScannerState
 {
 	uint8_t scanner[sizeof(GC_ObjectScanner)];
+#if defined(OMR_GC_MODRON_SCAVENGER)
+	uint8_t tracingObjectScanner[sizeof(GC_TracingObjectScanner)];
+#endif /* OMR_GC_MODRON_SCAVENGER */
 } GC_ObjectScannerState;
 
 #endif /* OBJECTSCANNERSTATE_HPP_ */
@@ -22,6 +22,9 @@
 #include "ConfigurationSegregated.hpp"
 #endif /* OMR_GC_SEGREGATED_HEAP */
 #include "ConfigurationFlat.hpp"
+#if defined(OMR_GC_MODRON_SCAVENGER)
+#include "ConfigurationGenerational.hpp"
+#endif /* OMR_GC_MODRON_SCAVENGER */
 #include "VerboseManagerImpl.hpp"
 
 #include "StartupManagerImpl.hpp"
@@ -31,6 +34,16 @@
 #define OMR_SEGREGATEDHEAP_LENGTH 21
 #endif /* OMR_GC_SEGREGATED_HEAP */
 
+#if defined(OMR_GC_MODRON_SCAVENGER)
+#define OMR_GENCON "-Xgcpolicy:gencon"
+#define OMR_GENCON_LENGTH 17
+#endif /* OMR_GC_MODRON_SCAVENGER */
+
+#if defined(OMR_GC_MODRON_CONCURRENT_MARK)
+#define OMR_OPTAVGPAUSE "-Xgcpolicy:optavgpause"
+#define OMR_OPTAVGPAUSE_LENGTH 22
+#endif /* OMR_GC_MODRON_CONCURRENT_MARK */
+
 bool
 MM_StartupManagerImpl::handleOption(MM_GCExtensionsBase *extensions, char *option)
 {
@@ -46,6 +59,18 @@ MM_StartupManagerImpl::handleOption(MM_GCExtensionsBase *extensions, char *optio
 			result = true;
 		}
 #endif /* OMR_GC_SEGREGATED_HEAP */
+#if defined(OMR_GC_MODRON_SCAVENGER)
+		if (0 == strncmp(option, OMR_GENCON, OMR_GENCON_LENGTH)) {
+			extensions->scavengerEnabled = true;
+			result = true;
+		}
+#endif /* OMR_GC_MODRON_SCAVENGER */
+#if defined(OMR_GC_MODRON_CONCURRENT_MARK)
+		if (0 == strncmp(option, OMR_OPTAVGPAUSE, OMR_OPTAVGPAUSE_LENGTH)) {
+			extensions->concurrentMark = true;
+			result = true;
+		}
+#endif /* OMR_GC_MODRON_CONCURRENT_MARK */
 	}
 
 	return result;
@@ -83,6 +108,11 @@ MM_StartupManagerImpl::createConfiguration(MM_EnvironmentBase *env, MM_Configura
 		return MM_ConfigurationSegregated::newInstance(env, cli);
 	} else
 #endif /* OMR_GC_SEGREGATED_HEAP */
+#if defined(OMR_GC_MODRON_SCAVENGER)
+	if (MM_GCExtensionsBase::getExtensions(env->getOmrVM())->scavengerEnabled) {
+		return MM_ConfigurationGenerational::newInstance(env, cli);
+	} else
+#endif /* OMR_GC_MODRON_SCAVENGER */
 	{
 		return MM_ConfigurationFlat::newInstance(env, cli);
 	}
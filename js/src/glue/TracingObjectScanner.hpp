@@ -0,0 +1,110 @@
+/*******************************************************************************
+ *
+ * (c) Copyright IBM Corp. 1991, 2016
+ *
+ *  This program and the accompanying materials are made available
+ *  under the terms of the Eclipse Public License v1.0 and
+ *  Apache License v2.0 which accompanies this distribution.
+ *
+ *      The Eclipse Public License is available at
+ *      http://www.eclipse.org/legal/epl-v10.html
+ *
+ *      The Apache License v2.0 is available at
+ *      http://www.opensource.org/licenses/apache2.0.php
+ *
+ * Contributors:
+ *    Multiple authors (IBM Corp.) - initial implementation and documentation
+ *******************************************************************************/
+
+#if !defined(TRACINGOBJECTSCANNER_HPP_)
+#define TRACINGOBJECTSCANNER_HPP_
+
+#include "ObjectScanner.hpp"
+
+#include "gc/Nursery.h"
+#include "gc/Tracer.h"
+
+#if defined(OMR_GC_MODRON_SCAVENGER)
+
+/**
+ * Object scanner for the scavenger. SpiderMonkey cells do not have a flat
+ * slot layout (Values are boxed, slots and elements live out of line), so
+ * rather than presenting slots this scanner runs the cell's trace hook with
+ * a TenuringTracer, which copies each new space referent as it is visited.
+ * getNextSlot() therefore never returns a slot.
+ */
+class GC_TracingObjectScanner : public GC_ObjectScanner
+{
+	/*
+	 * Data members
+	 */
+private:
+	omrobjectptr_t _objectPtr;
+	js::TenuringTracer _tracer;
+	bool _scanned;
+
+protected:
+
+public:
+
+	/*
+	 * Function members
+	 */
+private:
+
+protected:
+	GC_TracingObjectScanner(MM_EnvironmentBase *env, JSRuntime *rt, omrobjectptr_t objectPtr, uintptr_t flags)
+		: GC_ObjectScanner(env, NULL, 0, flags)
+		, _objectPtr(objectPtr)
+		, _tracer(rt, env)
+		, _scanned(false)
+	{
+		_typeId = __FUNCTION__;
+	}
+
+	virtual void
+	initialize(MM_EnvironmentBase *env)
+	{
+		GC_ObjectScanner::initialize(env);
+	}
+
+public:
+	static GC_TracingObjectScanner *
+	newInstance(MM_EnvironmentBase *env, JSRuntime *rt, omrobjectptr_t objectPtr, void *allocSpace, uintptr_t flags)
+	{
+		GC_TracingObjectScanner *objectScanner = (GC_TracingObjectScanner *)allocSpace;
+		new(objectScanner) GC_TracingObjectScanner(env, rt, objectPtr, flags);
+		objectScanner->initialize(env);
+		return objectScanner;
+	}
+
+	/**
+	 * Trace the object on the first call. Returns true if the object still
+	 * refers into new space afterwards.
+	 */
+	bool
+	scanObject()
+	{
+		if (!_scanned) {
+			_scanned = true;
+			_tracer.resetShouldRemember();
+			js::gc::Cell *cell = (js::gc::Cell *)_objectPtr;
+			JS::TraceKind kind = cell->getTraceKind();
+			if (JS::TraceKind::Null != kind) {
+				js::TraceChildren(&_tracer, cell, kind);
+			}
+		}
+		return _tracer.shouldRemember();
+	}
+
+	virtual GC_SlotObject *
+	getNextSlot()
+	{
+		scanObject();
+		return NULL;
+	}
+};
+
+#endif /* OMR_GC_MODRON_SCAVENGER */
+
+#endif /* TRACINGOBJECTSCANNER_HPP_ */
@@ -21,8 +21,10 @@
 #include <string.h>
 
 #include "EnvironmentBase.hpp"
+#include "FrequentObjectsStats.hpp"
 #include "GCExtensionsBase.hpp"
 #include "VerboseManagerImpl.hpp"
+#include "VerboseWriterChain.hpp"
 
 #include "VerboseHandlerOutputStandard.hpp"
 
@@ -122,3 +124,16 @@ MM_VerboseManagerImpl::createVerboseHandlerOutputObject(MM_EnvironmentBase *env)
 {
 	return MM_VerboseHandlerOutputStandard::newInstance(env, this);
 }
+
+void
+MM_VerboseManagerImpl::outputFrequentObjects(MM_EnvironmentBase *env, MM_FrequentObjectsStats *stats)
+{
+	MM_VerboseWriterChain *writerChain = getWriterChain();
+	writerChain->formatAndOutput(env, 0, "<frequent-objects>");
+	for (uintptr_t k = 1; k <= stats->getCount(); k++) {
+		writerChain->formatAndOutput(env, 1, "<cells name=\"%s\" bytes=\"%zu\" />",
+			MM_FrequentObjectsStats::getKeyName(stats->getKthMostFrequent(k)), (size_t)stats->getKthMostFrequentBytes(k));
+	}
+	writerChain->formatAndOutput(env, 0, "</frequent-objects>");
+	writerChain->flush(env);
+}
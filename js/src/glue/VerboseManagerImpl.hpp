@@ -25,6 +25,7 @@
 #include "VerboseWriter.hpp"
 
 class MM_EnvironmentBase;
+class MM_FrequentObjectsStats;
 class MM_VerboseHandlerOutputStandardRuby;
 
 class MM_VerboseManagerImpl : public MM_VerboseManager
@@ -58,6 +59,9 @@ public:
 
 	virtual MM_VerboseHandlerOutput *createVerboseHandlerOutputObject(MM_EnvironmentBase *env);
 
+	/* Write the cells holding the most live bytes after a global collection. */
+	void outputFrequentObjects(MM_EnvironmentBase *env, MM_FrequentObjectsStats *stats);
+
 	static MM_VerboseManagerImpl *newInstance(MM_EnvironmentBase *env, OMR_VM* vm);
 
 	MM_VerboseManagerImpl(OMR_VM *omrVM)
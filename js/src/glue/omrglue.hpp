@@ -12,6 +12,7 @@
 #include "jsfriendapi.h"
 
 #include "ds/OrderedHashTable.h"
+#include "js/HashTable.h"
 #include "gc/Heap.h"
 #include "gc/Tracer.h"
 #include "js/GCAPI.h"
@@ -23,6 +24,9 @@
 // OMR
 #include "omr/gc/base/MarkingScheme.hpp"
 #include "omr/gc/base/EnvironmentBase.hpp"
+#if defined(OMR_GC_MODRON_COMPACTION)
+#include "omr/gc/base/standard/CompactScheme.hpp"
+#endif /* OMR_GC_MODRON_COMPACTION */
 
 class JSLinearString;
 class JSRope;
@@ -129,6 +133,123 @@ template <> inline void OMRGCMarker::traverse(JS::Value* thing) {
 	}
 }
 
+// Traces the children of a cell with the given tracer, using the cell's
+// concrete type. Intended for DispatchTraceKindTyped.
+struct TraceChildrenFunctor {
+    JSTracer* trc;
+    explicit TraceChildrenFunctor(JSTracer* trc) : trc(trc) {}
+    template <typename T> void operator()(T* thing) { thing->traceChildren(trc); }
+};
+
+#if defined(OMR_GC_MODRON_COMPACTION)
+// Rewrites edges to cells moved by the compactor. Unlike a callback tracer
+// every edge is visited at its real location, which matters because OMR's
+// forwarding lookup is not idempotent: asking for the forwarding address of a
+// cell's new address gives garbage. Each location is therefore updated
+// exactly once, and locations outside the heap that may be reached through
+// several owners (a RegExpShared, a malloc'd table) are remembered.
+class OMRCompactFixupTracer : public JSTracer
+{
+public:
+    OMRCompactFixupTracer(JSRuntime* rt, MM_CompactScheme* compactScheme, void* heapBase, void* heapTop)
+      : JSTracer(rt, JSTracer::TracerKindTag::OMR_COMPACT, TraceWeakMapKeysValues)
+      , _compactScheme(compactScheme)
+      , _heapBase(uintptr_t(heapBase))
+      , _heapTop(uintptr_t(heapTop))
+      , _ownedCount(0)
+      , _rememberedInHeap(false)
+    {
+        setFixedHeader(nullptr, nullptr);
+#ifdef DEBUG
+        // Referents are read at their old addresses otherwise.
+        setCheckEdges(false);
+#endif
+    }
+
+    bool init() { return _seen.init() && _buffers.init(); }
+
+    bool isInHeap(const void* p) const {
+        return uintptr_t(p) - _heapBase < _heapTop - _heapBase;
+    }
+
+    // The new address of |thing|, which must not already have been forwarded.
+    template <typename T> T* forward(T* thing) {
+        if (!thing || !isInHeap(thing))
+            return thing;
+        return (T*)_compactScheme->getForwardingPtr((omrobjectptr_t)thing);
+    }
+
+    template <typename T> void traverse(T** thingp) {
+        if (*thingp && shouldFixup(thingp))
+            *thingp = forward(*thingp);
+    }
+    void traverse(JS::Value* vp);
+    void traverse(jsid* idp);
+    void traverse(js::TaggedProto* protop);
+
+    // Out of line storage owned by the cell being traced (its slots and
+    // elements) is only reachable from that cell, so it is not remembered.
+    void addOwnedRange(const void* start, size_t bytes) {
+        MOZ_ASSERT(_ownedCount < MaxOwnedRanges);
+        _owned[_ownedCount].start = uintptr_t(start);
+        _owned[_ownedCount].end = uintptr_t(start) + bytes;
+        _ownedCount++;
+    }
+    void clearOwnedRanges() { _ownedCount = 0; }
+
+    // Marks a location inside the heap as already updated, for fields that
+    // are written before the cell holding them is traced (the owner pointer
+    // of copy on write elements stored inline in the owner).
+    void rememberLocation(void* location);
+    bool isRememberedLocation(void* location) const { return _seen.has(location); }
+
+    // Slots and elements buffers are not traced, and objects are fixed up by
+    // looking up where their buffers went. |buffer| must be at its new
+    // address; movedBuffer takes the address of the data before compaction.
+    bool addMovedBuffer(js::gc::OmrBuffer* buffer) {
+        js::gc::OmrBuffer* old = buffer->addressBeforeCompaction();
+        buffer->updateAddressAfterCompaction();
+        return _buffers.putNew(old, buffer);
+    }
+    js::gc::OmrBuffer* movedBuffer(const void* oldData) const {
+        auto p = _buffers.lookup(js::gc::OmrBuffer::fromData(oldData));
+        return p ? p->value() : nullptr;
+    }
+
+    // Objects have their group and shape rewritten before any object is
+    // traced, so that trace hooks can read classes and slots. These two
+    // locations of the object being traced are then skipped.
+    void setFixedHeader(const void* groupp, const void* shapep) {
+        _fixedHeader[0] = groupp;
+        _fixedHeader[1] = shapep;
+    }
+
+private:
+    static const size_t MaxOwnedRanges = 2;
+    struct Range { uintptr_t start; uintptr_t end; };
+
+    MM_CompactScheme* _compactScheme;
+    uintptr_t _heapBase;
+    uintptr_t _heapTop;
+    Range _owned[MaxOwnedRanges];
+    size_t _ownedCount;
+    bool _rememberedInHeap;
+    const void* _fixedHeader[2];
+    HashSet<void*, DefaultHasher<void*>, SystemAllocPolicy> _seen;
+    HashMap<js::gc::OmrBuffer*, js::gc::OmrBuffer*, DefaultHasher<js::gc::OmrBuffer*>, SystemAllocPolicy> _buffers;
+
+    // Trace hooks sometimes trace a copy held in a local. Such a location is
+    // live only for one edge and its address is reused, so it is never
+    // remembered. Locals of the hooks lie between this frame and the tracer.
+    MOZ_NEVER_INLINE bool isStackTemporary(const void* location) const {
+        volatile uintptr_t probe = 0;
+        return uintptr_t(location) >= uintptr_t(&probe) && uintptr_t(location) < uintptr_t(this);
+    }
+
+    bool shouldFixup(void* location);
+};
+#endif /* OMR_GC_MODRON_COMPACTION */
+
 } // namespace omrjs
 
 #endif // OMRGLUE_HPP_
\ No newline at end of file
@@ -28,7 +28,7 @@
 #if defined(OMR_GC_SEGREGATED_HEAP)
 
 /* The number of non-zero allocation sizes defined in the SMALL_SIZECLASSES array. */
-#define OMR_SIZECLASSES_NUM_SMALL 0x0F
+#define OMR_SIZECLASSES_NUM_SMALL 0x17
 
 /* The index of the smallest non-zero small size class in the SMALL_SIZECLASSES array. */
 #define OMR_SIZECLASSES_MIN_SMALL 0x1
@@ -54,9 +54,28 @@
  * Note that this array must be of size OMR_SIZECLASSES_NUM_SMALL+1. Note that
  * the 0 size class isn't used since there are no 0-size objects.
  *
- * Trivial example below admits 15 allocation sizes up to 2k.
+ * The smaller classes are the sizes of SpiderMonkey's GC things, rounded up
+ * to the 8 byte alignment of every cell, so that each gc::AllocKind fills its
+ * cells exactly: a cell is a header word followed by the thing, so
+ * OBJECT0..OBJECT16 take five words plus their fixed slots. On a 64-bit
+ * target those are 40, 56, 72, 104, 136 and 168 bytes, functions 64 and 80,
+ * strings 32 and 40, and symbols 24; on a 32-bit target objects take 24, 40,
+ * 56, 88, 120 and 152 bytes, functions 32 and 48, strings 24 and 40, and
+ * symbols 24. Above that the classes grow by about a quarter at a time, for
+ * scripts and for the gc::OmrBuffers holding slots and elements, whose sizes
+ * vary.
+ *
+ * jsgc.cpp checks at compile time that every AllocKind has a class which
+ * wastes at most a quarter of its cells, and that objects waste nothing but
+ * their alignment.
  */
-#define SMALL_SIZECLASSES	{ 0, 16, 32, 64, 96, 160, 240, 352, 456, 592, 760, 968, 1200, 1520, 1760, 2048 }
+#if defined(OMR_ENV_DATA64)
+#define SMALL_SIZECLASSES	{ 0, 16, 24, 32, 40, 48, 56, 64, 72, 80, 104, 136, 168, 208, \
+							  256, 320, 400, 512, 640, 800, 1024, 1280, 1600, 2048 }
+#else /* OMR_ENV_DATA64 */
+#define SMALL_SIZECLASSES	{ 0, 16, 24, 32, 40, 48, 56, 64, 72, 88, 104, 120, 152, 192, \
+							  240, 304, 384, 480, 608, 768, 960, 1216, 1536, 2048 }
+#endif /* OMR_ENV_DATA64 */
 
 typedef struct OMR_SizeClasses {
     uintptr_t smallCellSizes[OMR_SIZECLASSES_MAX_SMALL + 1];
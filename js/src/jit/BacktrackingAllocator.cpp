@@ -9,6 +9,7 @@
 #include "jsprf.h"
 
 #include "jit/BitSet.h"
+#include "jit/JitOptions.h"
 
 using namespace js;
 using namespace js::jit;
@@ -830,11 +831,23 @@ BacktrackingAllocator::go()
 
     JitSpew(JitSpew_RegAlloc, "Beginning main allocation loop");
 
+    // Allocation time grows faster than linearly with the size of the
+    // function, so very large functions are allocated coarsely from the start,
+    // and others once they have processed too many bundles.
+    if (graph.numInstructions() > JitOptions.regAllocCoarseInstructionThreshold)
+        enterCoarseMode("too many instructions");
+    size_t bundleBudget =
+        size_t(graph.numVirtualRegisters()) * JitOptions.regAllocBundleBudgetFactor;
+    size_t processedBundles = 0;
+
     // Allocate, spill and split bundles until finished.
     while (!allocationQueue.empty()) {
         if (mir->shouldCancel("Backtracking Allocation"))
             return false;
 
+        if (!coarse && ++processedBundles > bundleBudget)
+            enterCoarseMode("bundle budget exceeded");
+
         QueueItem item = allocationQueue.removeHighest();
         if (!processBundle(mir, item.bundle))
             return false;
@@ -862,6 +875,21 @@ BacktrackingAllocator::go()
     return true;
 }
 
+void
+BacktrackingAllocator::enterCoarseMode(const char* reason)
+{
+    MOZ_ASSERT(!coarse);
+    coarse = true;
+
+    JitSpew(JitSpew_RegAlloc, "Switching to coarse allocation: %s", reason);
+#ifdef JS_JITSPEW
+    if (JSScript* script = mir->info().script()) {
+        JitSpew(JitSpew_IonScripts, "Coarse register allocation for %s:%" PRIuSIZE " (%s)",
+                script->filename(), script->lineno(), reason);
+    }
+#endif
+}
+
 static bool
 IsArgumentSlotDefinition(LDefinition* def)
 {
@@ -1302,8 +1330,11 @@ BacktrackingAllocator::processBundle(MIRGenerator* mir, LiveBundle* bundle)
 
             // If that didn't work, but we have one or more non-fixed bundles
             // known to be conflicting, maybe we can evict them and try again.
+            // In coarse mode only minimal bundles, which cannot be split
+            // further, do this.
             if (attempt < MAX_ATTEMPTS &&
                 !fixed &&
+                (!coarse || minimalBundle(bundle)) &&
                 !conflicting.empty() &&
                 maximumSpillWeight(conflicting) < computeSpillWeight(bundle))
                 {
@@ -3092,6 +3123,11 @@ BacktrackingAllocator::chooseBundleSplit(LiveBundle* bundle, bool fixed, LiveBun
 {
     bool success = false;
 
+    if (coarse && !fixed) {
+        SplitPositionVector emptyPositions;
+        return splitAt(bundle, emptyPositions);
+    }
+
     if (!trySplitAcrossHotcode(bundle, &success))
         return false;
     if (success)
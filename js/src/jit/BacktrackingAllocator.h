@@ -594,6 +594,13 @@ class BacktrackingAllocator : protected RegisterAllocator
     // This flag is set when testing new allocator modifications.
     bool testbed;
 
+    // This flag is set when allocation must finish quickly, either because
+    // the function is very large or because the main allocation loop used up
+    // its budget. Bundles which cannot be allocated are then split at all of
+    // their register uses instead of at carefully chosen positions, and only
+    // minimal bundles may evict others.
+    bool coarse;
+
     BitSet* liveIn;
     FixedList<VirtualRegister> vregs;
 
@@ -676,6 +683,7 @@ class BacktrackingAllocator : protected RegisterAllocator
     BacktrackingAllocator(MIRGenerator* mir, LIRGenerator* lir, LIRGraph& graph, bool testbed)
       : RegisterAllocator(mir, lir, graph),
         testbed(testbed),
+        coarse(false),
         liveIn(nullptr),
         callRanges(nullptr)
     { }
@@ -794,6 +802,7 @@ class BacktrackingAllocator : protected RegisterAllocator
     size_t maximumSpillWeight(const LiveBundleVector& bundles);
 
     MOZ_MUST_USE bool chooseBundleSplit(LiveBundle* bundle, bool fixed, LiveBundle* conflict);
+    void enterCoarseMode(const char* reason);
 
     MOZ_MUST_USE bool splitAt(LiveBundle* bundle, const SplitPositionVector& splitPositions);
     MOZ_MUST_USE bool trySplitAcrossHotcode(LiveBundle* bundle, bool* success);
@@ -1013,6 +1013,41 @@ BaselineCacheIRCompiler::emitLoadArgumentsObjectLengthResult()
     return true;
 }
 
+bool
+BaselineCacheIRCompiler::emitLoadTypedObjectLengthResult()
+{
+    // The object operand was only needed for the guards.
+    reader.objOperandId();
+
+    masm.load32(stubAddress(reader.stubOffset()), R0.scratchReg());
+    masm.tagValue(JSVAL_TYPE_INT32, R0.scratchReg(), R0);
+
+    // The int32 type was monitored when attaching the stub, so we can
+    // just return.
+    emitReturnFromIC();
+    return true;
+}
+
+bool
+BaselineCacheIRCompiler::emitMegamorphicLoadSlotResult()
+{
+    Register obj = allocator.useRegister(masm, reader.objOperandId());
+    AutoScratchRegister name(allocator, masm);
+    AutoScratchRegister scratch1(allocator, masm);
+    AutoScratchRegister scratch2(allocator, masm);
+
+    FailurePath* failure;
+    if (!addFailurePath(&failure))
+        return false;
+
+    // On a miss, fall through to the next stub. The generic stub behind us
+    // fills the cache.
+    masm.loadPtr(stubAddress(reader.stubOffset()), name);
+    masm.megamorphicCacheProbe(obj, name, scratch1, scratch2, R0, failure->label());
+    emitEnterTypeMonitorIC();
+    return true;
+}
+
 bool
 BaselineCacheIRCompiler::emitLoadObject()
 {
@@ -1078,6 +1113,7 @@ CacheIRStubInfo::getStubField(ICStub* stub, uint32_t field) const
 template GCPtr<Shape*>& CacheIRStubInfo::getStubField(ICStub* stub, uint32_t offset) const;
 template GCPtr<ObjectGroup*>& CacheIRStubInfo::getStubField(ICStub* stub, uint32_t offset) const;
 template GCPtr<JSObject*>& CacheIRStubInfo::getStubField(ICStub* stub, uint32_t offset) const;
+template GCPtr<JSString*>& CacheIRStubInfo::getStubField(ICStub* stub, uint32_t offset) const;
 
 template <typename T>
 static void
@@ -1105,6 +1141,9 @@ CacheIRWriter::copyStubData(uint8_t* dest) const
           case StubField::GCType::ObjectGroup:
             InitGCPtr<ObjectGroup>(destWords + i, stubFields_[i].word);
             continue;
+          case StubField::GCType::String:
+            InitGCPtr<JSString>(destWords + i, stubFields_[i].word);
+            continue;
           case StubField::GCType::Limit:
             break;
         }
@@ -1258,6 +1297,10 @@ jit::TraceBaselineCacheIRStub(JSTracer* trc, ICStub* stub, const CacheIRStubInfo
             TraceNullableEdge(trc, &stubInfo->getStubField<JSObject*>(stub, field),
                               "baseline-cacheir-object");
             break;
+          case StubField::GCType::String:
+            TraceNullableEdge(trc, &stubInfo->getStubField<JSString*>(stub, field),
+                              "baseline-cacheir-string");
+            break;
           case StubField::GCType::Limit:
             return; // Done.
           default:
@@ -481,6 +481,20 @@ BaselineInspector::hasSeenAccessedGetter(jsbytecode* pc)
     return false;
 }
 
+bool
+BaselineInspector::isMegamorphicGetProp(jsbytecode* pc)
+{
+    if (!hasBaselineScript())
+        return false;
+
+    const ICEntry& entry = icEntryFromPC(pc);
+    ICStub* stub = entry.fallbackStub();
+
+    if (stub->isGetProp_Fallback())
+        return stub->toGetProp_Fallback()->isMegamorphic();
+    return false;
+}
+
 bool
 BaselineInspector::hasSeenNonStringIterMore(jsbytecode* pc)
 {
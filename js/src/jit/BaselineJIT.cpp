@@ -17,7 +17,9 @@
 #include "jit/JitCommon.h"
 #include "jit/JitSpewer.h"
 #include "vm/Debugger.h"
+#include "vm/HelperThreads.h"
 #include "vm/Interpreter.h"
+#include "vm/Time.h"
 #include "vm/TraceLogging.h"
 
 #include "jsobjinlines.h"
@@ -76,7 +78,8 @@ BaselineScript::BaselineScript(uint32_t prologueOffset, uint32_t epilogueOffset,
     flags_(0),
     inlinedBytecodeLength_(0),
     maxInliningDepth_(UINT8_MAX),
-    pendingBuilder_(nullptr)
+    pendingBuilder_(nullptr),
+    creationTime_(PRMJ_Now())
 { }
 
 static const unsigned BASELINE_MAX_ARGS_LENGTH = 20000;
@@ -300,6 +303,8 @@ jit::BaselineCompile(JSContext* cx, JSScript* script, bool forceDebugInstrumenta
 
     if (status == Method_CantCompile)
         script->setBaselineScript(cx->runtime(), BASELINE_DISABLED_SCRIPT);
+    else if (status == Method_Compiled)
+        cx->runtime()->jitRuntime()->eventCounts().baselineCompiles++;
 
     return status;
 }
@@ -1151,6 +1156,12 @@ jit::FinishDiscardBaselineScript(FreeOp* fop, JSScript* script)
         return;
     }
 
+    // Builders for this script read its baseline ICs, and finishing them
+    // touches the BaselineScript, so cancel any that are still queued,
+    // running or waiting to be linked before the script goes away.
+    if (script->isIonCompilingOffThread() || script->baselineScript()->hasPendingIonBuilder())
+        CancelOffThreadIonCompile(script);
+
     BaselineScript* baseline = script->baselineScript();
     script->setBaselineScript(nullptr, nullptr);
     BaselineScript::Destroy(fop, baseline);
@@ -239,6 +239,10 @@ struct BaselineScript
     // An ion compilation that is ready, but isn't linked yet.
     IonBuilder *pendingBuilder_;
 
+    // PRMJ_Now() when this script was created. Used together with the
+    // script's warm-up counter to estimate how quickly it is getting hot.
+    int64_t creationTime_;
+
   public:
     // Do not call directly, use BaselineScript::New. This is public for cx->new_.
     BaselineScript(uint32_t prologueOffset, uint32_t epilogueOffset,
@@ -468,6 +472,9 @@ struct BaselineScript
     uint8_t maxInliningDepth() const {
         return maxInliningDepth_;
     }
+    int64_t creationTime() const {
+        return creationTime_;
+    }
     void setMaxInliningDepth(uint32_t depth) {
         MOZ_ASSERT(depth <= UINT8_MAX);
         maxInliningDepth_ = depth;
@@ -73,6 +73,46 @@ GetPropIRGenerator::tryAttachStub(Maybe<CacheIRWriter>& writer)
     return true;
 }
 
+bool
+GetPropIRGenerator::tryAttachMegamorphicStub(Maybe<CacheIRWriter>& writer)
+{
+    AutoAssertNoPendingException aanpe(cx_);
+    JS::AutoCheckCannotGC nogc;
+
+    MOZ_ASSERT(!emitted_);
+
+    writer.emplace();
+    ValOperandId valId(writer->setInputOperandId(0));
+
+    if (val_.isObject()) {
+        RootedObject obj(cx_, &val_.toObject());
+        ObjOperandId objId = writer->guardIsObject(valId);
+
+        if (!tryAttachMegamorphic(*writer, obj, objId))
+            return false;
+    }
+
+    return true;
+}
+
+bool
+GetPropIRGenerator::tryAttachMegamorphic(CacheIRWriter& writer, HandleObject obj,
+                                         ObjOperandId objId)
+{
+    MOZ_ASSERT(!emitted_);
+
+    // A miss would have to throw a ReferenceError.
+    if (*pc_ == JSOP_GETXPROP)
+        return true;
+
+    if (!obj->isNative())
+        return true;
+
+    emitted_ = true;
+    writer.megamorphicLoadSlotResult(objId, name_);
+    return true;
+}
+
 static bool
 IsCacheableNoProperty(JSContext* cx, JSObject* obj, JSObject* holder, Shape* shape, jsid id,
                       jsbytecode* pc)
@@ -381,6 +421,19 @@ GetPropIRGenerator::tryAttachObjectLength(CacheIRWriter& writer, HandleObject ob
         return true;
     }
 
+    // The length of an array typed object is fixed by its type descriptor,
+    // which the group determines.
+    if (obj->is<TypedObject>() &&
+        obj->as<TypedObject>().typeDescr().is<ArrayTypeDescr>() &&
+        !cx_->compartment()->detachedTypedObjects)
+    {
+        writer.guardNoDetachedTypedObjects();
+        writer.guardGroup(objId, obj->group());
+        writer.loadTypedObjectLengthResult(objId, obj->as<TypedObject>().length());
+        emitted_ = true;
+        return true;
+    }
+
     return true;
 }
 
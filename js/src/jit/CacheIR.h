@@ -98,6 +98,8 @@ class ObjOperandId : public OperandId
     _(LoadInt32ArrayLengthResult)         \
     _(LoadUnboxedArrayLengthResult)       \
     _(LoadArgumentsObjectLengthResult)    \
+    _(LoadTypedObjectLengthResult)        \
+    _(MegamorphicLoadSlotResult)          \
     _(LoadUndefinedResult)
 
 enum class CacheOp {
@@ -112,6 +114,7 @@ struct StubField {
         Shape,
         ObjectGroup,
         JSObject,
+        String,
         Limit
     };
 
@@ -334,6 +337,14 @@ class MOZ_RAII CacheIRWriter
     void loadArgumentsObjectLengthResult(ObjOperandId obj) {
         writeOpWithOperandId(CacheOp::LoadArgumentsObjectLengthResult, obj);
     }
+    void loadTypedObjectLengthResult(ObjOperandId obj, int32_t length) {
+        writeOpWithOperandId(CacheOp::LoadTypedObjectLengthResult, obj);
+        addStubWord(length, StubField::GCType::NoGCThing);
+    }
+    void megamorphicLoadSlotResult(ObjOperandId obj, PropertyName* name) {
+        writeOpWithOperandId(CacheOp::MegamorphicLoadSlotResult, obj);
+        addStubWord(uintptr_t(name), StubField::GCType::String);
+    }
 };
 
 class CacheIRStubInfo;
@@ -421,6 +432,8 @@ class MOZ_RAII GetPropIRGenerator
                                             ObjOperandId objId);
     MOZ_MUST_USE bool tryAttachModuleNamespace(CacheIRWriter& writer, HandleObject obj,
                                                ObjOperandId objId);
+    MOZ_MUST_USE bool tryAttachMegamorphic(CacheIRWriter& writer, HandleObject obj,
+                                           ObjOperandId objId);
 
     GetPropIRGenerator(const GetPropIRGenerator&) = delete;
     GetPropIRGenerator& operator=(const GetPropIRGenerator&) = delete;
@@ -433,6 +446,10 @@ class MOZ_RAII GetPropIRGenerator
 
     MOZ_MUST_USE bool tryAttachStub(mozilla::Maybe<CacheIRWriter>& writer);
 
+    // Attach a single stub for any native receiver, which looks the property
+    // up in the MegamorphicCache. Used once a site has seen too many shapes.
+    MOZ_MUST_USE bool tryAttachMegamorphicStub(mozilla::Maybe<CacheIRWriter>& writer);
+
     bool shouldUnlinkPreliminaryObjectStubs() const {
         return preliminaryObjectAction_ == PreliminaryObjectAction::Unlink;
     }
@@ -3462,9 +3462,6 @@ static void
 EmitPostWriteBarrier(MacroAssembler& masm, Register objreg, JSObject* maybeConstant, bool isGlobal,
                      AllocatableGeneralRegisterSet& regs)
 {
-#ifndef OMR // Writebarrier
-    // OMRTODO: JIT writebarrier
-
     MOZ_ASSERT_IF(isGlobal, maybeConstant);
 
     Label callVM;
@@ -3472,8 +3469,17 @@ EmitPostWriteBarrier(MacroAssembler& masm, Register objreg, JSObject* maybeConst
 
     // We already have a fast path to check whether a global is in the store
     // buffer.
+#ifndef OMR // Writebarrier
     if (!isGlobal && maybeConstant)
         EmitStoreBufferCheckForConstant(masm, maybeConstant, regs, &exit, &callVM);
+#else // ! OMR Writebarrier
+    // Objects already in OMR's remembered set carry that state in their
+    // header word.
+    if (!isGlobal) {
+        masm.branchTestPtr(Assembler::NonZero, Address(objreg, gc::Cell::offsetOfFlags()),
+                           Imm32(gc::Cell::OmrRememberedBits), &exit);
+    }
+#endif // ! OMR Writebarrier
 
     // Call into the VM to barrier the write.
     masm.bind(&callVM);
@@ -3488,14 +3494,11 @@ EmitPostWriteBarrier(MacroAssembler& masm, Register objreg, JSObject* maybeConst
     masm.callWithABI(JS_FUNC_TO_DATA_PTR(void*, fun));
 
     masm.bind(&exit);
-
-#endif // ! OMR Writebarrier
 }
 
 void
 CodeGenerator::emitPostWriteBarrier(const LAllocation* obj)
 {
-#ifndef OMR // Writebarrier
     AllocatableGeneralRegisterSet regs(GeneralRegisterSet::Volatile());
 
     Register objreg;
@@ -3512,28 +3515,23 @@ CodeGenerator::emitPostWriteBarrier(const LAllocation* obj)
     }
 
     EmitPostWriteBarrier(masm, objreg, object, isGlobal, regs);
-#endif // ! OMR Writebarrier
 }
 
 void
 CodeGenerator::emitPostWriteBarrier(Register objreg)
 {
-#ifndef OMR // Writebarrier
     AllocatableGeneralRegisterSet regs(GeneralRegisterSet::Volatile());
     regs.takeUnchecked(objreg);
     EmitPostWriteBarrier(masm, objreg, nullptr, false, regs);
-#endif // ! OMR Writebarrier
 }
 
 void
 CodeGenerator::visitOutOfLineCallPostWriteBarrier(OutOfLineCallPostWriteBarrier* ool)
 {
-#ifndef OMR // Writebarrier
     saveLiveVolatile(ool->lir());
     const LAllocation* obj = ool->object();
     emitPostWriteBarrier(obj);
     restoreLiveVolatile(ool->lir());
-#endif // ! OMR Writebarrier
 
     masm.jump(ool->rejoin());
 }
@@ -6240,9 +6238,8 @@ ValueMapRangeFront(MacroAssembler& masm, Register range, Register i, Register fr
     masm.loadPtr(Address(range, ValueMap::Range::offsetOfHashTable()), front);
     masm.loadPtr(Address(front, ValueMap::offsetOfImplData()), front);
 
-    MOZ_ASSERT(ValueMap::sizeofImplData() == 24);
-    masm.mulBy3(i, i);
-    masm.lshiftPtr(Imm32(3), i);
+    MOZ_ASSERT(ValueMap::sizeofImplData() == 16);
+    masm.lshiftPtr(Imm32(4), i);
     masm.addPtr(i, front);
 }
 
@@ -6261,8 +6258,8 @@ ValueMapRangePopFront(MacroAssembler& masm, Register range, Register front, Regi
     masm.bind(&seek);
     masm.branch32(Assembler::AboveOrEqual, i, dataLength, &done);
 
-    MOZ_ASSERT(ValueMap::sizeofImplData() == 24);
-    masm.addPtr(Imm32(24), front);
+    MOZ_ASSERT(ValueMap::sizeofImplData() == 16);
+    masm.addPtr(Imm32(16), front);
 
     masm.branchTestMagic(Assembler::NotEqual, Address(front, ValueMap::Entry::offsetOfKey()),
                          JS_HASH_KEY_EMPTY, &done);
@@ -9537,6 +9534,7 @@ CodeGenerator::link(JSContext* cx, CompilerConstraintList* constraints)
         ionScript->setHasProfilingInstrumentation();
 
     script->setIonScript(cx->runtime(), ionScript);
+    cx->runtime()->jitRuntime()->eventCounts().ionCompiles++;
 
     // Adopt fallback shared stubs from the compiler into the ion script.
     ionScript->adoptFallbackStubs(&stubSpace_);
@@ -9649,13 +9647,17 @@ CodeGenerator::link(JSContext* cx, CompilerConstraintList* constraints)
         ionScript->copyConstants(vp);
         for (size_t i = 0; i < graph.numConstants(); i++) {
             const Value& v = vp[i];
-            if (v.isObject() && IsInsideNursery(&v.toObject())) {
 #ifndef OMR // Writebarriers
-                // OMRTODO: Write barrier here
+            if (v.isObject() && IsInsideNursery(&v.toObject())) {
                 cx->runtime()->gc.storeBuffer.putWholeCell(script);
-#endif // ! OMR Writebarriers
                 break;
             }
+#else // ! OMR Writebarriers
+            if (v.isObject() && gc::OmrGcHelper::isInNewSpace(&v.toObject())) {
+                gc::OmrGcHelper::rememberObject(script);
+                break;
+            }
+#endif // ! OMR Writebarriers
         }
     }
     if (patchableBackedges_.length() > 0)
@@ -9751,6 +9753,29 @@ CodeGenerator::visitCallGetProperty(LCallGetProperty* lir)
     callVM(GetPropertyInfo, lir);
 }
 
+typedef bool (*GetPropertyMegamorphicFn)(JSContext*, HandleObject, HandlePropertyName,
+                                         MutableHandleValue);
+static const VMFunction GetPropertyMegamorphicInfo =
+    FunctionInfo<GetPropertyMegamorphicFn>(GetPropertyMegamorphic, "GetPropertyMegamorphic");
+
+void
+CodeGenerator::visitMegamorphicLoadSlot(LMegamorphicLoadSlot* lir)
+{
+    Register obj = ToRegister(lir->object());
+    Register name = ToRegister(lir->name());
+    Register temp1 = ToRegister(lir->temp1());
+    Register temp2 = ToRegister(lir->temp2());
+    ValueOperand output = ToOutValue(lir);
+
+    OutOfLineCode* ool = oolCallVM(GetPropertyMegamorphicInfo, lir,
+                                   ArgList(obj, ImmGCPtr(lir->mir()->name())),
+                                   StoreValueTo(output));
+
+    masm.movePtr(ImmGCPtr(lir->mir()->name()), name);
+    masm.megamorphicCacheProbe(obj, name, temp1, temp2, output, ool->entry());
+    masm.bind(ool->rejoin());
+}
+
 typedef bool (*GetOrCallElementFn)(JSContext*, MutableHandleValue, HandleValue, MutableHandleValue);
 static const VMFunction GetElementInfo =
     FunctionInfo<GetOrCallElementFn>(js::GetElement, "GetElement");
@@ -282,6 +282,7 @@ class CodeGenerator final : public CodeGeneratorSpecific
     void visitStringSplit(LStringSplit* lir);
     void visitFunctionEnvironment(LFunctionEnvironment* lir);
     void visitCallGetProperty(LCallGetProperty* lir);
+    void visitMegamorphicLoadSlot(LMegamorphicLoadSlot* lir);
     void visitCallGetElement(LCallGetElement* lir);
     void visitCallSetElement(LCallSetElement* lir);
     void visitCallInitElementArray(LCallInitElementArray* lir);
@@ -94,6 +94,12 @@ CompileRuntime::getJSContext()
     return runtime()->unsafeContextFromAnyThread();
 }
 
+const MegamorphicCache*
+CompileRuntime::addressOfMegamorphicCache()
+{
+    return &runtime()->unsafeContextFromAnyThread()->caches.megamorphicCache;
+}
+
 const JitRuntime*
 CompileRuntime::jitRuntime()
 {
@@ -225,6 +231,14 @@ CompileZone::addressOfFreeList(gc::AllocKind allocKind)
 #endif
 }
 
+#ifdef OMR // Zones
+uint32_t
+CompileZone::omrIndex()
+{
+    return zone()->omrIndex;
+}
+#endif // OMR Zones
+
 JSCompartment*
 CompileCompartment::compartment()
 {
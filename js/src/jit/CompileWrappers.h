@@ -61,6 +61,9 @@ class CompileRuntime
     // used/dereferenced on the background thread so we return it as void*.
     const void* getJSContext();
 
+    // &runtime()->unsafeContextFromAnyThread()->caches.megamorphicCache
+    const MegamorphicCache* addressOfMegamorphicCache();
+
     const JitRuntime* jitRuntime();
 
     // Compilation does not occur off thread when the SPS profiler is enabled.
@@ -100,6 +103,10 @@ class CompileZone
     const void* addressOfNeedsIncrementalBarrier();
 
     const void* addressOfFreeList(gc::AllocKind allocKind);
+
+#ifdef OMR // Zones
+    uint32_t omrIndex();
+#endif // OMR Zones
 };
 
 class JitCompartment;
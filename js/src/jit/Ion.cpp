@@ -207,7 +207,8 @@ JitRuntime::JitRuntime(JSRuntime* rt)
     preventBackedgePatching_(false),
     backedgeTarget_(BackedgeLoopHeader),
     ionReturnOverride_(MagicValue(JS_ARG_POISON)),
-    jitcodeGlobalTable_(nullptr)
+    jitcodeGlobalTable_(nullptr),
+    eventCounts_()
 {
 }
 
@@ -686,6 +687,58 @@ JitCompartment::sweep(FreeOp* fop, JSCompartment* compartment)
     }
 }
 
+#ifdef OMR // Compaction
+void
+JitRuntime::fixupAfterCompaction(JSTracer* trc)
+{
+    JitCode** stubs[] = {
+        &exceptionTail_, &bailoutTail_, &profilerExitFrameTail_, &enterJIT_,
+        &enterBaselineJIT_, &bailoutHandler_, &argumentsRectifier_, &invalidator_,
+        &valuePreBarrier_, &stringPreBarrier_, &objectPreBarrier_, &shapePreBarrier_,
+        &objectGroupPreBarrier_, &mallocStub_, &freeStub_, &lazyLinkStub_,
+        &debugTrapHandler_, &baselineDebugModeOSRHandler_
+    };
+    for (JitCode** stub : stubs) {
+        if (*stub)
+            TraceManuallyBarrieredEdge(trc, stub, "JitRuntime stub");
+    }
+
+    for (JitCode*& table : bailoutTables_)
+        TraceManuallyBarrieredEdge(trc, &table, "bailout table");
+
+    if (functionWrappers_) {
+        for (VMWrapperMap::Enum e(*functionWrappers_); !e.empty(); e.popFront())
+            TraceManuallyBarrieredEdge(trc, &e.front().value(), "VM wrapper");
+    }
+
+    if (hasJitcodeGlobalTable())
+        getJitcodeGlobalTable()->fixupAfterCompaction(trc);
+}
+
+void
+JitCompartment::fixupAfterCompaction(JSTracer* trc)
+{
+    // Both stub tables are keyed by value, so entries are updated in place.
+    for (ICStubCodeMap::Enum e(*stubCodes_); !e.empty(); e.popFront())
+        TraceEdge(trc, &e.front().value(), "baseline IC stub");
+    for (CacheIRStubCodeMap::Enum e(*cacheIRStubCodes_); !e.empty(); e.popFront())
+        TraceEdge(trc, &e.front().value(), "CacheIR stub");
+
+    JitCode** stubs[] = {
+        &stringConcatStub_, &regExpMatcherStub_, &regExpSearcherStub_, &regExpTesterStub_
+    };
+    for (JitCode** stub : stubs) {
+        if (*stub)
+            TraceManuallyBarrieredEdge(trc, stub, "JitCompartment stub");
+    }
+
+    for (ReadBarrieredObject& obj : simdTemplateObjects_) {
+        if (obj)
+            TraceEdge(trc, &obj, "SIMD template object");
+    }
+}
+#endif // OMR Compaction
+
 void
 JitCompartment::toggleBarriers(bool enabled)
 {
@@ -807,6 +860,24 @@ JitCode::traceChildren(JSTracer* trc)
     }
 }
 
+#ifdef OMR // Compaction
+void
+JitCode::fixupAfterCompaction(JSTracer* trc)
+{
+    // FromExecutable finds the header through the word before the code,
+    // which is part of the executable allocation.
+    AutoWritableJitCode awjc(runtimeFromMainThread(), code_ - headerSize_, headerSize_ + bufferSize_);
+    *(JitCode**)(code_ - sizeof(JitCode*)) = this;
+
+    if (invalidated() || !dataRelocTableBytes_)
+        return;
+
+    uint8_t* start = code_ + dataRelocTableOffset();
+    CompactBufferReader reader(start, start + dataRelocTableBytes_);
+    MacroAssembler::TraceDataRelocations(trc, this, reader);
+}
+#endif // OMR Compaction
+
 void
 JitCode::finalize(FreeOp* fop)
 {
@@ -160,6 +160,7 @@ IonBuilder::IonBuilder(JSContext* analysisContext, CompileCompartment* comp,
 {
     script_ = info->script();
     scriptHasIonScript_ = script_->hasIonScript();
+    priority_ = Priority{0, 0};
     pc = info->startPC();
     abortReason_ = AbortReason_Disable;
 
@@ -11524,6 +11525,11 @@ IonBuilder::jsop_getprop(PropertyName* name)
             return emitted;
     }
 
+    // Try to emit a load through the megamorphic cache.
+    trackOptimizationAttempt(TrackedStrategy::GetProp_Megamorphic);
+    if (!getPropTryMegamorphic(&emitted, obj, name, types) || emitted)
+        return emitted;
+
     // Try to emit a polymorphic cache.
     trackOptimizationAttempt(TrackedStrategy::GetProp_InlineCache);
     if (!getPropTryCache(&emitted, obj, name, barrier, types) || emitted)
@@ -12000,6 +12006,42 @@ IonBuilder::getPropTryModuleNamespace(bool* emitted, MDefinition* obj, PropertyN
     return true;
 }
 
+bool
+IonBuilder::getPropTryMegamorphic(bool* emitted, MDefinition* obj, PropertyName* name,
+                                  TemporaryTypeSet* types)
+{
+    MOZ_ASSERT(*emitted == false);
+
+    // Only sites whose baseline IC gave up on per-shape stubs.
+    if (!inspector->isMegamorphicGetProp(pc)) {
+        trackOptimizationOutcome(TrackedOutcome::GenericFailure);
+        return true;
+    }
+
+    // A miss on JSOP_GETXPROP has to throw, which the VM call doesn't do.
+    if (JSOp(*pc) == JSOP_GETXPROP) {
+        trackOptimizationOutcome(TrackedOutcome::GenericFailure);
+        return true;
+    }
+
+    if (obj->type() != MIRType::Object) {
+        trackOptimizationOutcome(TrackedOutcome::NotObject);
+        return true;
+    }
+
+    MMegamorphicLoadSlot* load = MMegamorphicLoadSlot::New(alloc(), obj, name);
+    current->add(load);
+    current->push(load);
+    if (!resumeAfter(load))
+        return false;
+    if (!pushTypeBarrier(load, types, BarrierKind::TypeSet))
+        return false;
+
+    trackOptimizationSuccess();
+    *emitted = true;
+    return true;
+}
+
 MInstruction*
 IonBuilder::loadUnboxedProperty(MDefinition* obj, size_t offset, JSValueType unboxedType,
                                 BarrierKind barrier, TemporaryTypeSet* types)
@@ -461,6 +461,8 @@ class IonBuilder
                                                          size_t fieldIndex);
     MOZ_MUST_USE bool getPropTryInnerize(bool* emitted, MDefinition* obj, PropertyName* name,
                                          TemporaryTypeSet* types);
+    MOZ_MUST_USE bool getPropTryMegamorphic(bool* emitted, MDefinition* obj, PropertyName* name,
+                                            TemporaryTypeSet* types);
     MOZ_MUST_USE bool getPropTryCache(bool* emitted, MDefinition* obj, PropertyName* name,
                                       BarrierKind barrier, TemporaryTypeSet* types);
     MOZ_MUST_USE bool getPropTrySharedStub(bool* emitted, MDefinition* obj,
@@ -1100,6 +1102,30 @@ class IonBuilder
     // calling hasIonScript() from background compilation threads.
     bool scriptHasIonScript_;
 
+  public:
+    // Ordering key for the off thread compilation worklist. Higher keys are
+    // compiled first. The tier always wins; the score only orders builders
+    // within a tier.
+    struct Priority
+    {
+        uint32_t tier;
+        double score;
+
+        bool operator<(const Priority& other) const {
+            if (tier != other.tier)
+                return tier < other.tier;
+            return score < other.score;
+        }
+        bool operator>(const Priority& other) const {
+            return other < *this;
+        }
+    };
+
+  private:
+    // Computed on the main thread when the builder is queued, so that helper
+    // threads never need to look at the script to order the worklist.
+    Priority priority_;
+
     // If off thread compilation is successful, the final code generator is
     // attached here. Code has been generated, but not linked (there is not yet
     // an IonScript). This is heap allocated, and must be explicitly destroyed,
@@ -1127,6 +1153,9 @@ class IonBuilder
     JSScript* script() const { return script_; }
     bool scriptHasIonScript() const { return scriptHasIonScript_; }
 
+    const Priority& priority() const { return priority_; }
+    void setPriority(const Priority& priority) { priority_ = priority; }
+
     CodeGenerator* backgroundCodegen() const { return backgroundCodegen_; }
     void setBackgroundCodegen(CodeGenerator* codegen) { backgroundCodegen_ = codegen; }
 
@@ -115,6 +115,11 @@ class JitCode : public gc::TenuredCell
 
     void traceChildren(JSTracer* trc);
     void finalize(FreeOp* fop);
+#ifdef OMR // Compaction
+    // Only the header moves when the OMR heap is compacted; the code and the
+    // code addresses it jumps to stay where they are.
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
     void setInvalidated() {
         invalidated_ = true;
     }
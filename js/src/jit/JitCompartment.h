@@ -187,7 +187,18 @@ class JitRuntime
     // Global table of jitcode native address => bytecode address mappings.
     JitcodeGlobalTable* jitcodeGlobalTable_;
 
+  public:
+    // Running totals of JIT events, reported by the shell's benchmark().
+    struct EventCounts {
+        uint64_t baselineCompiles;
+        uint64_t ionCompiles;
+        uint64_t bailouts;
+        uint64_t icStubs;
+    };
+
   private:
+    EventCounts eventCounts_;
+
     JitCode* generateLazyLinkStub(JSContext* cx);
     JitCode* generateProfilerExitFrameTailStub(JSContext* cx);
     JitCode* generateExceptionTailStub(JSContext* cx, void* handler);
@@ -223,6 +234,10 @@ class JitRuntime
 
     static void Mark(JSTracer* trc, js::AutoLockForExclusiveAccess& lock);
     static void MarkJitcodeGlobalTableUnconditionally(JSTracer* trc);
+#ifdef OMR // Compaction
+    // Update the stubs held in untraced fields after the OMR heap is compacted.
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
     static MOZ_MUST_USE bool MarkJitcodeGlobalTableIteratively(JSTracer* trc);
     static void SweepJitcodeGlobalTable(JSRuntime* rt);
 
@@ -371,6 +386,10 @@ class JitRuntime
         return jitcodeGlobalTable_;
     }
 
+    EventCounts& eventCounts() {
+        return eventCounts_;
+    }
+
     bool isProfilerInstrumentationEnabled(JSRuntime* rt) {
         return rt->spsProfiler.enabled();
     }
@@ -562,6 +581,9 @@ class JitCompartment
 
     void mark(JSTracer* trc, JSCompartment* compartment);
     void sweep(FreeOp* fop, JSCompartment* compartment);
+#ifdef OMR // Compaction
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
 
     JitCode* stringConcatStubNoBarrier() const {
         return stringConcatStub_;
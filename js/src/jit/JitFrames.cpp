@@ -1121,12 +1121,10 @@ MarkBailoutFrame(JSTracer* trc, const JitFrameIterator& frame)
 
 }
 
-void
-UpdateIonJSFrameForMinorGC(JSTracer* trc, const JitFrameIterator& frame)
+template <typename Forward>
+static void
+UpdateIonJSFrameSlotsOrElements(const JitFrameIterator& frame, Forward forward)
 {
-    // Minor GCs may move slots/elements allocated in the nursery. Update
-    // any slots/elements pointers stored in this frame.
-
     JitFrameLayout* layout = (JitFrameLayout*)frame.fp();
 
     IonScript* ionScript = nullptr;
@@ -1138,8 +1136,6 @@ UpdateIonJSFrameForMinorGC(JSTracer* trc, const JitFrameIterator& frame)
         ionScript = frame.ionScriptFromCalleeToken();
     }
 
-    Nursery& nursery = trc->runtime()->gc.nursery;
-
     const SafepointIndex* si = ionScript->getSafepointIndex(frame.returnAddressToFp());
     SafepointReader safepoint(ionScript, si);
 
@@ -1148,7 +1144,7 @@ UpdateIonJSFrameForMinorGC(JSTracer* trc, const JitFrameIterator& frame)
     for (GeneralRegisterBackwardIterator iter(safepoint.allGprSpills()); iter.more(); ++iter) {
         --spill;
         if (slotsRegs.has(*iter))
-            nursery.forwardBufferPointer(reinterpret_cast<HeapSlot**>(spill));
+            forward(reinterpret_cast<HeapSlot**>(spill));
     }
 
     // Skip to the right place in the safepoint
@@ -1162,10 +1158,21 @@ UpdateIonJSFrameForMinorGC(JSTracer* trc, const JitFrameIterator& frame)
 
     while (safepoint.getSlotsOrElementsSlot(&entry)) {
         HeapSlot** slots = reinterpret_cast<HeapSlot**>(layout->slotRef(entry));
-        nursery.forwardBufferPointer(slots);
+        forward(slots);
     }
 }
 
+void
+UpdateIonJSFrameForMinorGC(JSTracer* trc, const JitFrameIterator& frame)
+{
+    // Minor GCs may move slots/elements allocated in the nursery. Update
+    // any slots/elements pointers stored in this frame.
+    Nursery& nursery = trc->runtime()->gc.nursery;
+    UpdateIonJSFrameSlotsOrElements(frame, [&](HeapSlot** pSlotsElems) {
+        nursery.forwardBufferPointer(pSlotsElems);
+    });
+}
+
 static void
 MarkJitStubFrame(JSTracer* trc, const JitFrameIterator& frame)
 {
@@ -1479,6 +1486,22 @@ void UpdateJitActivationsForMinorGC(JSRuntime* rt, JSTracer* trc)
     }
 }
 
+#ifdef OMR // Buffers
+void
+UpdateJitActivationsForCompaction(JSRuntime* rt, JSTracer* trc, SlotsOrElementsForwarder forward)
+{
+    for (JitActivationIterator activations(rt); !activations.done(); ++activations) {
+        for (JitFrameIterator frames(activations); !frames.done(); ++frames) {
+            if (frames.type() == JitFrame_IonJS) {
+                UpdateIonJSFrameSlotsOrElements(frames, [&](HeapSlot** pSlotsElems) {
+                    forward(trc, pSlotsElems);
+                });
+            }
+        }
+    }
+}
+#endif // OMR Buffers
+
 void
 GetPcScript(JSContext* cx, JSScript** scriptRes, jsbytecode** pcRes)
 {
@@ -291,6 +291,13 @@ TopmostIonActivationCompartment(JSRuntime* rt);
 
 void UpdateJitActivationsForMinorGC(JSRuntime* rt, JSTracer* trc);
 
+#ifdef OMR // Buffers
+// The OMR compactor moves the heap cells holding slots and elements. Update
+// the slots/elements pointers stored in Ion frames with |forward|.
+typedef void (*SlotsOrElementsForwarder)(JSTracer* trc, HeapSlot** pSlotsElems);
+void UpdateJitActivationsForCompaction(JSRuntime* rt, JSTracer* trc, SlotsOrElementsForwarder forward);
+#endif // OMR Buffers
+
 static inline uint32_t
 EncodeFrameHeaderSize(size_t headerSize)
 {
@@ -186,6 +186,12 @@ DefaultJitOptions::DefaultJitOptions()
     SET_DEFAULT(branchPruningEffectfulInstFactor, 3500);
     SET_DEFAULT(branchPruningThreshold, 4000);
 
+    // The backtracking allocator switches to coarser, faster bundle splitting
+    // for functions with more LIR instructions than this, or after processing
+    // this many bundles per virtual register.
+    SET_DEFAULT(regAllocCoarseInstructionThreshold, 100000);
+    SET_DEFAULT(regAllocBundleBudgetFactor, 16);
+
     // Force how many invocation or loop iterations are needed before compiling
     // a function with the highest ionmonkey optimization level.
     // (i.e. OptimizationLevel_Normal)
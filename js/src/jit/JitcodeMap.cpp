@@ -461,6 +461,52 @@ JitcodeGlobalTable::lookupForSamplerInfallible(void* ptr, JSRuntime* rt, uint32_
 
 JitcodeGlobalEntry*
 JitcodeGlobalTable::lookupInternal(void* ptr)
+{
+    if (lastHit_ && lastHit_->containsPointer(ptr))
+        return lastHit_;
+
+    if (!indexValid_)
+        rebuildIndex();
+
+    // Find the last entry starting at or below |ptr|.
+    uint8_t* addr = static_cast<uint8_t*>(ptr);
+    size_t lo = 0, hi = index_.length();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index_[mid].start <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return nullptr;
+
+    JitcodeGlobalEntry* entry = index_[lo - 1].entry;
+    if (!entry->containsPointer(ptr))
+        return nullptr;
+
+    MOZ_ASSERT(entry == lookupInSkiplist(ptr));
+    lastHit_ = entry;
+    return entry;
+}
+
+void
+JitcodeGlobalTable::rebuildIndex()
+{
+    // addEntry reserved space for every entry, so this does not allocate.
+    MOZ_ASSERT(index_.capacity() >= skiplistSize_);
+    index_.clear();
+    for (Range r(*this); !r.empty(); r.popFront()) {
+        JitcodeGlobalEntry* entry = r.front();
+        IndexEntry indexEntry = { static_cast<uint8_t*>(entry->nativeStartAddr()), entry };
+        index_.infallibleAppend(indexEntry);
+    }
+    MOZ_ASSERT(index_.length() == skiplistSize_);
+    indexValid_ = true;
+}
+
+JitcodeGlobalEntry*
+JitcodeGlobalTable::lookupInSkiplist(void* ptr)
 {
     JitcodeGlobalEntry query = JitcodeGlobalEntry::MakeQuery(ptr);
     JitcodeGlobalEntry* searchTower[JitcodeSkiplistTower::MAX_HEIGHT];
@@ -497,6 +543,15 @@ JitcodeGlobalTable::addEntry(const JitcodeGlobalEntry& entry, JSRuntime* rt)
     JitcodeGlobalEntry* searchTower[JitcodeSkiplistTower::MAX_HEIGHT];
     searchInternal(entry, searchTower);
 
+    // Suppress profiler sampling while the index and skiplist are being
+    // mutated. The sampler reads index_ in lookup(), so the index must be
+    // invalidated before reserve() may reallocate it.
+    AutoSuppressProfilerSampling suppressSampling(rt);
+    invalidateIndex();
+
+    if (!index_.reserve(skiplistSize_ + 1))
+        return false;
+
     // Allocate a new entry and tower.
     JitcodeSkiplistTower* newTower = allocateTower(generateTowerHeight());
     if (!newTower)
@@ -509,9 +564,6 @@ JitcodeGlobalTable::addEntry(const JitcodeGlobalEntry& entry, JSRuntime* rt)
     *newEntry = entry;
     newEntry->tower_ = newTower;
 
-    // Suppress profiler sampling while skiplist is being mutated.
-    AutoSuppressProfilerSampling suppressSampling(rt);
-
     // Link up entry with forward entries taken from tower.
     for (int level = newTower->height() - 1; level >= 0; level--) {
         JitcodeGlobalEntry* searchTowerEntry = searchTower[level];
@@ -539,6 +591,9 @@ JitcodeGlobalTable::removeEntry(JitcodeGlobalEntry& entry, JitcodeGlobalEntry**
 {
     MOZ_ASSERT(!rt->isProfilerSamplingEnabled());
 
+    // Drop the index before the entry is unlinked and freed.
+    invalidateIndex();
+
     // Unlink query entry.
     for (int level = entry.tower_->height() - 1; level >= 0; level--) {
         JitcodeGlobalEntry* prevTowerEntry = prevTower[level];
@@ -740,6 +795,18 @@ JitcodeGlobalTable::markUnconditionally(JSTracer* trc)
         r.front()->mark<Unconditionally>(trc);
 }
 
+#ifdef OMR // Compaction
+void
+JitcodeGlobalTable::fixupAfterCompaction(JSTracer* trc)
+{
+    // Entries are keyed by native code addresses, which do not move, so the
+    // cells they hold are updated in place whether or not the profiler is on.
+    AutoSuppressProfilerSampling suppressSampling(trc->runtime());
+    for (Range r(*this); !r.empty(); r.popFront())
+        r.front()->mark<Unconditionally>(trc);
+}
+#endif // OMR Compaction
+
 struct IfUnmarked
 {
     template <typename T>
@@ -1014,9 +1014,28 @@ class JitcodeGlobalTable
     JitcodeGlobalEntry* startTower_[JitcodeSkiplistTower::MAX_HEIGHT];
     JitcodeSkiplistTower* freeTowers_[JitcodeSkiplistTower::MAX_HEIGHT];
 
+    // Lookups, which mostly come from the profiler's sampler, binary search a
+    // sorted array of the entries' start addresses instead of walking the
+    // skiplist. The array is rebuilt from the skiplist by the first lookup
+    // after entries are added or removed. Its capacity is reserved whenever
+    // an entry is added, so rebuilding never allocates and is safe to do
+    // while sampling.
+    struct IndexEntry
+    {
+        uint8_t* start;
+        JitcodeGlobalEntry* entry;
+    };
+    Vector<IndexEntry, 0, SystemAllocPolicy> index_;
+    bool indexValid_;
+
+    // The entry found by the last lookup. Consecutive samples often land in
+    // the same code.
+    JitcodeGlobalEntry* lastHit_;
+
   public:
     JitcodeGlobalTable()
-      : alloc_(LIFO_CHUNK_SIZE), freeEntries_(nullptr), rand_(0), skiplistSize_(0)
+      : alloc_(LIFO_CHUNK_SIZE), freeEntries_(nullptr), rand_(0), skiplistSize_(0),
+        indexValid_(false), lastHit_(nullptr)
     {
         for (unsigned i = 0; i < JitcodeSkiplistTower::MAX_HEIGHT; i++)
             startTower_[i] = nullptr;
@@ -1062,11 +1081,21 @@ class JitcodeGlobalTable
     void markUnconditionally(JSTracer* trc);
     MOZ_MUST_USE bool markIteratively(JSTracer* trc);
     void sweep(JSRuntime* rt);
+#ifdef OMR // Compaction
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
 
   private:
     MOZ_MUST_USE bool addEntry(const JitcodeGlobalEntry& entry, JSRuntime* rt);
 
     JitcodeGlobalEntry* lookupInternal(void* ptr);
+    JitcodeGlobalEntry* lookupInSkiplist(void* ptr);
+
+    void invalidateIndex() {
+        indexValid_ = false;
+        lastHit_ = nullptr;
+    }
+    void rebuildIndex();
 
     // Initialize towerOut such that towerOut[i] (for i in [0, MAX_HEIGHT-1])
     // is a JitcodeGlobalEntry that is sorted to be <query, whose successor at
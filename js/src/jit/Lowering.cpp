@@ -3797,6 +3797,17 @@ LIRGenerator::visitCallGetProperty(MCallGetProperty* ins)
     assignSafepoint(lir, ins);
 }
 
+void
+LIRGenerator::visitMegamorphicLoadSlot(MMegamorphicLoadSlot* ins)
+{
+    MOZ_ASSERT(ins->object()->type() == MIRType::Object);
+
+    LMegamorphicLoadSlot* lir =
+        new(alloc()) LMegamorphicLoadSlot(useRegister(ins->object()), temp(), temp(), temp());
+    defineBox(lir, ins);
+    assignSafepoint(lir, ins);
+}
+
 void
 LIRGenerator::visitCallGetElement(MCallGetElement* ins)
 {
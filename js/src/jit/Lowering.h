@@ -254,6 +254,7 @@ class LIRGenerator : public LIRGeneratorSpecific
     void visitPolyInlineGuard(MPolyInlineGuard* ins);
     void visitAssertRange(MAssertRange* ins);
     void visitCallGetProperty(MCallGetProperty* ins);
+    void visitMegamorphicLoadSlot(MMegamorphicLoadSlot* ins);
     void visitDeleteProperty(MDeleteProperty* ins);
     void visitDeleteElement(MDeleteElement* ins);
     void visitGetNameCache(MGetNameCache* ins);
@@ -236,6 +236,7 @@ namespace jit {
     _(LoadFixedSlotAndUnbox)                                                \
     _(StoreFixedSlot)                                                       \
     _(CallGetProperty)                                                      \
+    _(MegamorphicLoadSlot)                                                  \
     _(GetNameCache)                                                         \
     _(CallGetIntrinsicValue)                                                \
     _(CallGetElement)                                                       \
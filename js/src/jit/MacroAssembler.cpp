@@ -726,6 +726,46 @@ MacroAssembler::checkUnboxedArrayCapacity(Register obj, const RegisterOrInt32Con
     bind(&done);
 }
 
+void
+MacroAssembler::megamorphicCacheProbe(Register obj, Register id, Register scratch1,
+                                      Register scratch2, ValueOperand output, Label* miss)
+{
+    // |output| may alias |obj|: it is only written once the probe has hit.
+    MOZ_ASSERT(!output.aliases(id));
+
+    const MegamorphicCache* cache = GetJitContext()->runtime->addressOfMegamorphicCache();
+
+    // Find the entry, as MegamorphicCache::getIndex does. Only native shapes
+    // are ever added, so any other shape misses.
+    loadPtr(Address(obj, ShapedObject::offsetOfShape()), scratch1);
+    movePtr(scratch1, scratch2);
+    xorPtr(id, scratch2);
+    rshiftPtr(Imm32(MegamorphicCache::HashShift), scratch2);
+    andPtr(Imm32(MegamorphicCache::NumEntries - 1), scratch2);
+    lshiftPtr(Imm32(MegamorphicCache::EntryShift), scratch2);
+    addPtr(ImmPtr(cache->addressOfEntries()), scratch2);
+
+    branchPtr(Assembler::NotEqual, Address(scratch2, MegamorphicCache::offsetOfEntryShape()),
+              scratch1, miss);
+    branchPtr(Assembler::NotEqual, Address(scratch2, MegamorphicCache::offsetOfEntryId()),
+              id, miss);
+
+    Label dynamicSlot, done;
+    loadPtr(Address(scratch2, MegamorphicCache::offsetOfEntryKind()), scratch1);
+    loadPtr(Address(scratch2, MegamorphicCache::offsetOfEntryOffset()), scratch2);
+    branchPtr(Assembler::Equal, scratch1, ImmWord(uintptr_t(MegamorphicCache::Kind::DynamicSlot)),
+              &dynamicSlot);
+    branchPtr(Assembler::NotEqual, scratch1, ImmWord(uintptr_t(MegamorphicCache::Kind::FixedSlot)),
+              miss);
+    loadValue(BaseIndex(obj, scratch2, TimesOne), output);
+    jump(&done);
+
+    bind(&dynamicSlot);
+    loadPtr(Address(obj, NativeObject::offsetOfSlots()), scratch1);
+    loadValue(BaseIndex(scratch1, scratch2, TimesOne), output);
+    bind(&done);
+}
+
 // Inlined version of gc::CheckAllocatorState that checks the bare essentials
 // and bails for anything that cannot be handled with our jit allocators.
 void
@@ -768,8 +808,10 @@ MacroAssembler::nurseryAllocate(Register result, Register temp, gc::AllocKind al
                                 size_t nDynamicSlots, gc::InitialHeap initialHeap, Label* fail)
 {
 #ifdef OMR // Allocate
-    MOZ_ASSERT(0);
-    // OMRTODO: Use OMR allocators and TLHs
+    // There is no separate nursery under OMR; allocateObject sends every
+    // object through the thread-local heap path in freeListAllocate.
+    MOZ_ASSERT(!nDynamicSlots);
+    freeListAllocate(result, temp, allocKind, fail);
 #else // OMR Allocate
     MOZ_ASSERT(IsNurseryAllocable(allocKind));
     MOZ_ASSERT(initialHeap != gc::TenuredHeap);
@@ -806,8 +848,27 @@ void
 MacroAssembler::freeListAllocate(Register result, Register temp, gc::AllocKind allocKind, Label* fail)
 {
 #ifdef OMR // Allocate
-    // OMRTODO: Allocate in the JIT
-    MOZ_ASSERT(0);
+    // Bump allocate out of the main thread's OMR thread-local heap. When the
+    // TLH is exhausted (or inline TLH allocation has been disabled, which
+    // makes it look full) we bail, and the VM refreshes it via OMR_GC_Allocate.
+    const Nursery& nursery = GetJitContext()->runtime->gcNursery();
+    if (!nursery.addressOfPosition()) {
+        jump(fail);
+        return;
+    }
+
+    int thingSize = int(gc::OmrGcHelper::thingSize(allocKind));
+    MOZ_ASSERT(thingSize % gc::CellSize == 0);
+    loadPtr(AbsoluteAddress(nursery.addressOfPosition()), result);
+    computeEffectiveAddress(Address(result, thingSize), temp);
+    branchPtr(Assembler::Below, AbsoluteAddress(nursery.addressOfCurrentEnd()), temp, fail);
+    storePtr(temp, AbsoluteAddress(nursery.addressOfPosition()));
+
+    // The object model sizes cells by their alloc kind, so the header must be
+    // valid before anything can walk the heap.
+    uint32_t zoneIndex = GetJitContext()->compartment->zone()->omrIndex();
+    storePtr(ImmWord(gc::Cell::flagsForAllocKind(allocKind, zoneIndex)),
+             Address(result, gc::Cell::offsetOfFlags()));
 #else // OMR Allocate
     CompileZone* zone = GetJitContext()->compartment->zone();
     int thingSize = int(gc::Arena::thingSize(allocKind));
@@ -888,8 +949,17 @@ MacroAssembler::allocateObject(Register result, Register temp, gc::AllocKind all
 
     checkAllocatorState(fail);
 
+#ifndef OMR // Nursery
     if (shouldNurseryAllocate(allocKind, initialHeap))
         return nurseryAllocate(result, temp, allocKind, nDynamicSlots, initialHeap, fail);
+#else // ! OMR Nursery
+    // The thread-local heap is carved out of new space, so pretenured
+    // objects have to come from the VM.
+    if (initialHeap == gc::TenuredHeap && gc::OmrGcHelper::isGenerational()) {
+        jump(fail);
+        return;
+    }
+#endif // ! OMR Nursery
 
     if (!nDynamicSlots)
         return freeListAllocate(result, temp, allocKind, fail);
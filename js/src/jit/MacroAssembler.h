@@ -1613,6 +1613,13 @@ class MacroAssembler : public MacroAssemblerSpecific
     void checkUnboxedArrayCapacity(Register obj, const RegisterOrInt32Constant& index,
                                    Register temp, Label* failure);
 
+    // Look the property |id| (a PropertyName*) of |obj| up in the
+    // MegamorphicCache. If the cache has it as a data property of |obj|
+    // itself, load its value into |output|, else jump to |miss|. |obj| must
+    // be a ShapedObject, though not necessarily a native one.
+    void megamorphicCacheProbe(Register obj, Register id, Register scratch1, Register scratch2,
+                               ValueOperand output, Label* miss);
+
     Register extractString(const Address& address, Register scratch) {
         return extractObject(address, scratch);
     }
@@ -2710,9 +2710,22 @@ DoGetPropFallback(JSContext* cx, void* payload, ICGetProp_Fallback* stub_,
     MOZ_ASSERT(!stub->hasStub(ICStub::GetProp_Generic));
 
     if (stub->numOptimizedStubs() >= ICGetProp_Fallback::MAX_OPTIMIZED_STUBS && !stub.invalid()) {
-        // Discard all stubs in this IC and replace with generic getprop stub.
+        // Discard all stubs in this IC and replace with generic getprop stub,
+        // fronted by a megamorphic cache probe for native receivers.
         for (ICStubIterator iter = stub->beginChain(); !iter.atEnd(); iter++)
             iter.unlink(cx);
+        stub->noteMegamorphic();
+        if (!JitOptions.disableCacheIR) {
+            mozilla::Maybe<CacheIRWriter> writer;
+            GetPropIRGenerator gen(cx, pc, val, name, res);
+            if (!gen.tryAttachMegamorphicStub(writer))
+                return false;
+            if (gen.emitted() &&
+                AttachBaselineCacheIRStub(cx, writer.ref(), CacheKind::GetProp, stub))
+            {
+                JitSpew(JitSpew_BaselineIC, "  Attached megamorphic CacheIR stub");
+            }
+        }
         ICGetProp_Generic::Compiler compiler(cx, engine,
                                              stub->fallbackMonitorStub()->firstMonitorStub());
         ICStub* newStub = compiler.getStub(compiler.getStubSpace(info.outerScript(cx)));
@@ -3629,6 +3642,12 @@ DoGetPropGeneric(JSContext* cx, void* payload, ICGetProp_Generic* stub,
     jsbytecode* pc = info.pc();
     JSOp op = JSOp(*pc);
     RootedPropertyName name(cx, script->getName(pc));
+
+    // Try the megamorphic cache first. This also fills it for the probe
+    // stub in front of us.
+    if (val.isObject() && GetNativeDataPropertyPure(cx, &val.toObject(), name, res.address()))
+        return true;
+
     return ComputeGetPropResult(cx, info.maybeFrame(), op, name, val, res);
 }
 
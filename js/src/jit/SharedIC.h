@@ -523,6 +523,8 @@ class ICStub
         T* result = space->allocate<T>(code, mozilla::Forward<Args>(args)...);
         if (!result)
             ReportOutOfMemory(cx);
+        else
+            cx->runtime()->jitRuntime()->eventCounts().icStubs++;
         return result;
     }
 
@@ -2305,6 +2307,7 @@ class ICGetProp_Fallback : public ICMonitoredFallbackStub
     static const uint32_t MAX_OPTIMIZED_STUBS = 16;
     static const size_t UNOPTIMIZABLE_ACCESS_BIT = 0;
     static const size_t ACCESSED_GETTER_BIT = 1;
+    static const size_t MEGAMORPHIC_BIT = 2;
 
     void noteUnoptimizableAccess() {
         extra_ |= (1u << UNOPTIMIZABLE_ACCESS_BIT);
@@ -2320,6 +2323,13 @@ class ICGetProp_Fallback : public ICMonitoredFallbackStub
         return extra_ & (1u << ACCESSED_GETTER_BIT);
     }
 
+    void noteMegamorphic() {
+        extra_ |= (1u << MEGAMORPHIC_BIT);
+    }
+    bool isMegamorphic() const {
+        return extra_ & (1u << MEGAMORPHIC_BIT);
+    }
+
     class Compiler : public ICStubCompiler {
       public:
         static const int32_t BASELINE_KEY =
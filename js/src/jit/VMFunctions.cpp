@@ -482,9 +482,10 @@ NewCallObject(JSContext* cx, HandleShape shape, HandleObjectGroup group)
     // the initializing writes. The interpreter, however, may have allocated
     // the call object tenured, so barrier as needed before re-entering.
 #ifndef OMR
-    // OMRTODO: Writebarrier here
     if (!IsInsideNursery(obj))
         cx->runtime()->gc.storeBuffer.putWholeCell(obj);
+#else // ! OMR
+    gc::OmrGcHelper::rememberObject(obj);
 #endif // OMR
     return obj;
 }
@@ -503,8 +504,9 @@ NewSingletonCallObject(JSContext* cx, HandleShape shape)
     MOZ_ASSERT(!IsInsideNursery(obj),
                "singletons are created in the tenured heap");
 
-    // OMRTODO: Writebarrier here
     cx->runtime()->gc.storeBuffer.putWholeCell(obj);
+#else // ! OMR
+    gc::OmrGcHelper::rememberObject(obj);
 #endif // OMR
     return obj;
 }
@@ -609,9 +611,11 @@ void
 PostWriteBarrier(JSRuntime* rt, JSObject* obj)
 {
 #ifndef OMR
-    // OMRTODO: Writebarrier here
     MOZ_ASSERT(!IsInsideNursery(obj));
     rt->gc.storeBuffer.putWholeCell(obj);
+#else // ! OMR
+    MOZ_ASSERT(!gc::OmrGcHelper::isInNewSpace(obj));
+    gc::OmrGcHelper::rememberObject(obj);
 #endif // OMR
 }
 
@@ -636,6 +640,10 @@ PostWriteElementBarrier(JSRuntime* rt, JSObject* obj, int32_t index)
     }
 
     rt->gc.storeBuffer.putWholeCell(obj);
+#else // ! OMR Writebarrier
+    // OMR only remembers whole objects, so the element index is not needed.
+    MOZ_ASSERT(!gc::OmrGcHelper::isInNewSpace(obj));
+    gc::OmrGcHelper::rememberObject(obj);
 #endif // ! OMR Writebarrier
 }
 
@@ -1274,6 +1282,89 @@ ObjectIsConstructor(JSObject* obj)
     return obj->isConstructor();
 }
 
+bool
+GetNativeDataPropertyPure(JSContext* cx, JSObject* obj, PropertyName* name, Value* vp)
+{
+    JS::AutoCheckCannotGC nogc;
+    MegamorphicCache& cache = cx->caches.megamorphicCache;
+    jsid id = NameToId(name);
+
+    while (obj->isNative()) {
+        NativeObject* nobj = &obj->as<NativeObject>();
+        Shape* lastProperty = nobj->lastProperty();
+        bool cacheable = !lastProperty->inDictionary();
+
+        MegamorphicCache::Kind kind;
+        uintptr_t offset = 0;
+        const MegamorphicCache::Entry* entry = cacheable ? cache.lookup(lastProperty, id) : nullptr;
+        if (entry) {
+            kind = entry->kind;
+            offset = entry->offset;
+        } else {
+            // Class hooks can resolve or compute properties the shape does
+            // not describe. The class is fixed for a shape, so such objects
+            // are never cached.
+            const Class* clasp = nobj->getClass();
+            if (clasp->getResolve() || clasp->getGetProperty() ||
+                clasp->getOpsLookupProperty() || clasp->getOpsGetProperty())
+            {
+                return false;
+            }
+
+            Shape* shape = nobj->lookupPure(id);
+            if (!shape) {
+                kind = MegamorphicCache::Kind::Missing;
+            } else if (shape->hasSlot() && shape->hasDefaultGetter()) {
+                uint32_t slot = shape->slot();
+                if (nobj->isFixedSlot(slot)) {
+                    kind = MegamorphicCache::Kind::FixedSlot;
+                    offset = NativeObject::getFixedSlotOffset(slot);
+                } else {
+                    kind = MegamorphicCache::Kind::DynamicSlot;
+                    offset = nobj->dynamicSlotIndex(slot) * sizeof(Value);
+                }
+            } else {
+                return false;
+            }
+
+            if (cacheable)
+                cache.add(lastProperty, id, kind, offset);
+        }
+
+        switch (kind) {
+          case MegamorphicCache::Kind::FixedSlot:
+            *vp = nobj->getFixedSlot((offset - NativeObject::getFixedSlotOffset(0)) / sizeof(Value));
+            return true;
+          case MegamorphicCache::Kind::DynamicSlot:
+            *vp = nobj->getSlot(nobj->numFixedSlots() + offset / sizeof(Value));
+            return true;
+          case MegamorphicCache::Kind::Missing:
+            break;
+        }
+
+        // Nonexistent properties are left to the VM, which may need to warn
+        // or throw.
+        if (!nobj->hasStaticPrototype())
+            return false;
+        obj = nobj->staticPrototype();
+        if (!obj)
+            return false;
+    }
+
+    return false;
+}
+
+bool
+GetPropertyMegamorphic(JSContext* cx, HandleObject obj, HandlePropertyName name,
+                       MutableHandleValue vp)
+{
+    if (GetNativeDataPropertyPure(cx, obj, name, vp.address()))
+        return true;
+
+    RootedValue receiver(cx, ObjectValue(*obj));
+    return GetProperty(cx, obj, receiver, name, vp);
+}
+
 void
 MarkValueFromIon(JSRuntime* rt, Value* vp)
 {
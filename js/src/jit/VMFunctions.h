@@ -783,6 +783,17 @@ IonMarkFunction(MIRType type)
 bool ObjectIsCallable(JSObject* obj);
 bool ObjectIsConstructor(JSObject* obj);
 
+// Get a plain data property of |obj| or its prototypes through the context's
+// MegamorphicCache, filling the cache as it goes. Returns false, having done
+// nothing observable, if a getter, class hook or missing property means the
+// VM has to do the lookup instead.
+bool GetNativeDataPropertyPure(JSContext* cx, JSObject* obj, PropertyName* name, Value* vp);
+
+// As GetProperty, trying GetNativeDataPropertyPure first.
+MOZ_MUST_USE bool
+GetPropertyMegamorphic(JSContext* cx, HandleObject obj, HandlePropertyName name,
+                       MutableHandleValue vp);
+
 MOZ_MUST_USE bool
 ThrowRuntimeLexicalError(JSContext* cx, unsigned errorNumber);
 MOZ_MUST_USE bool
@@ -6943,6 +6943,38 @@ class LCallGetProperty : public LCallInstructionHelper<BOX_PIECES, BOX_PIECES, 0
     }
 };
 
+class LMegamorphicLoadSlot : public LInstructionHelper<BOX_PIECES, 1, 3>
+{
+  public:
+    LIR_HEADER(MegamorphicLoadSlot)
+
+    LMegamorphicLoadSlot(const LAllocation& obj, const LDefinition& name,
+                         const LDefinition& temp1, const LDefinition& temp2)
+    {
+        setOperand(0, obj);
+        setTemp(0, name);
+        setTemp(1, temp1);
+        setTemp(2, temp2);
+    }
+
+    const LAllocation* object() {
+        return getOperand(0);
+    }
+    const LDefinition* name() {
+        return getTemp(0);
+    }
+    const LDefinition* temp1() {
+        return getTemp(1);
+    }
+    const LDefinition* temp2() {
+        return getTemp(2);
+    }
+
+    MMegamorphicLoadSlot* mir() const {
+        return mir_->toMegamorphicLoadSlot();
+    }
+};
+
 // Call js::GetElement.
 class LCallGetElement : public LCallInstructionHelper<BOX_PIECES, 2 * BOX_PIECES, 0>
 {
@@ -323,6 +323,7 @@
     _(BindNameCache)                \
     _(CallBindVar)                  \
     _(CallGetProperty)              \
+    _(MegamorphicLoadSlot)          \
     _(GetNameCache)                 \
     _(CallGetIntrinsicValue)        \
     _(CallGetElement)               \
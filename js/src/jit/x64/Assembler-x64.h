@@ -756,8 +756,8 @@ class Assembler : public AssemblerX86Shared
         movq(imm, dest);
     }
     void mov(wasm::SymbolicAddress imm, Register dest) {
-        masm.movq_i64r(-1, dest.encoding());
-        append(AsmJSAbsoluteAddress(CodeOffset(masm.currentOffset()), imm));
+        CodeOffset label = loadRipRelativeInt64(dest);
+        append(wasm::GlobalAccess(label, wasm::SymbolicAddressGlobalDataOffset(imm)));
     }
     void mov(const Operand& src, Register dest) {
         movq(src, dest);
@@ -566,10 +566,26 @@ MacroAssembler::branchPtrInNurseryChunk(Condition cond, Register ptr, Register t
     MOZ_ASSERT(ptr != temp);
     MOZ_ASSERT(ptr != scratch);
 
+#ifdef OMR // Writebarrier
+    // OMR's new space is one range reserved when the heap is created, so
+    // its bounds can be baked into the code.
+    if (!gc::OmrGcHelper::isGenerational()) {
+        if (cond == Assembler::NotEqual)
+            jump(label);
+        return;
+    }
+
+    MOZ_ASSERT(gc::OmrGcHelper::newSpaceSize <= uintptr_t(INT32_MAX));
+    movePtr(ImmWord(-gc::OmrGcHelper::newSpaceBase), scratch);
+    addPtr(ptr, scratch);
+    branchPtr(cond == Assembler::Equal ? Assembler::Below : Assembler::AboveOrEqual, scratch,
+              Imm32(int32_t(gc::OmrGcHelper::newSpaceSize)), label);
+#else // ! OMR Writebarrier
     movePtr(ptr, scratch);
     orPtr(Imm32(gc::ChunkMask), scratch);
     branch32(cond, Address(scratch, gc::ChunkLocationOffsetFromLastByte),
              Imm32(int32_t(gc::ChunkLocation::Nursery)), label);
+#endif // ! OMR Writebarrier
 }
 
 void
@@ -597,10 +613,25 @@ MacroAssembler::branchValueIsNurseryObjectImpl(Condition cond, const T& value, R
     Label done;
     branchTestObject(Assembler::NotEqual, value, cond == Assembler::Equal ? &done : label);
 
+#ifdef OMR // Writebarrier
+    if (!gc::OmrGcHelper::isGenerational()) {
+        if (cond == Assembler::NotEqual)
+            jump(label);
+        bind(&done);
+        return;
+    }
+
+    MOZ_ASSERT(gc::OmrGcHelper::newSpaceSize <= uintptr_t(INT32_MAX));
+    extractObject(value, temp);
+    addPtr(ImmWord(-gc::OmrGcHelper::newSpaceBase), temp);
+    branchPtr(cond == Assembler::Equal ? Assembler::Below : Assembler::AboveOrEqual, temp,
+              Imm32(int32_t(gc::OmrGcHelper::newSpaceSize)), label);
+#else // ! OMR Writebarrier
     extractObject(value, temp);
     orPtr(Imm32(gc::ChunkMask), temp);
     branch32(cond, Address(temp, gc::ChunkLocationOffsetFromLastByte),
              Imm32(int32_t(gc::ChunkLocation::Nursery)), label);
+#endif // ! OMR Writebarrier
 
     bind(&done);
 }
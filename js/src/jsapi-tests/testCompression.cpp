@@ -0,0 +1,76 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=8 sts=4 et sw=4 tw=99:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/UniquePtr.h"
+
+#include "jsapi-tests/tests.h"
+#include "vm/Compression.h"
+
+using js::Compressor;
+
+static bool
+CompressAndCheckChunks(Compressor::Codec codec, const unsigned char* input, size_t inputBytes)
+{
+    // Plenty of room, so compressMore() never asks for more output.
+    size_t outputBytes = inputBytes * 2 + 1024;
+    mozilla::UniquePtr<char[], JS::FreePolicy> output(js_pod_malloc<char>(outputBytes));
+    if (!output)
+        return false;
+
+    Compressor comp(input, inputBytes, codec);
+    if (!comp.init())
+        return false;
+    comp.setOutput(reinterpret_cast<unsigned char*>(output.get()), outputBytes);
+
+    Compressor::Status status;
+    do {
+        status = comp.compressMore();
+    } while (status == Compressor::CONTINUE);
+    if (status != Compressor::DONE)
+        return false;
+
+    size_t totalBytes = comp.totalBytesNeeded();
+    if (totalBytes > outputBytes)
+        return false;
+    comp.finish(output.get(), totalBytes);
+
+    // Decompress the chunks in reverse order, to check that each one can be
+    // decompressed on its own.
+    size_t numChunks = (inputBytes - 1) / Compressor::CHUNK_SIZE + 1;
+    mozilla::UniquePtr<unsigned char[], JS::FreePolicy>
+        chunk(js_pod_malloc<unsigned char>(Compressor::CHUNK_SIZE));
+    if (!chunk)
+        return false;
+    for (size_t i = numChunks; i > 0; i--) {
+        size_t chunkBytes = Compressor::chunkSize(inputBytes, i - 1);
+        if (!js::DecompressStringChunk(reinterpret_cast<unsigned char*>(output.get()), i - 1,
+                                       chunk.get(), chunkBytes))
+        {
+            return false;
+        }
+        if (memcmp(chunk.get(), input + (i - 1) * Compressor::CHUNK_SIZE, chunkBytes) != 0)
+            return false;
+    }
+    return true;
+}
+
+BEGIN_TEST(testCompression_chunks)
+{
+    // A little over three chunks of somewhat compressible data.
+    const size_t inputBytes = 3 * Compressor::CHUNK_SIZE + 1234;
+    mozilla::UniquePtr<unsigned char[], JS::FreePolicy> input(js_pod_malloc<unsigned char>(inputBytes));
+    CHECK(input);
+    for (size_t i = 0; i < inputBytes; i++)
+        input[i] = (unsigned char)((i * 7) ^ (i >> 9));
+
+    CHECK(CompressAndCheckChunks(Compressor::Zlib, input.get(), inputBytes));
+    CHECK(CompressAndCheckChunks(Compressor::LZ4, input.get(), inputBytes));
+
+    // An input that ends exactly on a chunk boundary.
+    CHECK(CompressAndCheckChunks(Compressor::LZ4, input.get(), 2 * Compressor::CHUNK_SIZE));
+    return true;
+}
+END_TEST(testCompression_chunks)
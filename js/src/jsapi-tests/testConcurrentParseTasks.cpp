@@ -0,0 +1,90 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=8 sts=4 et sw=4 tw=99:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/Atomics.h"
+
+#include "jsapi-tests/tests.h"
+#include "vm/HelperThreads.h"
+
+using namespace js;
+
+static const size_t NumParses = 4;
+
+struct ParseResults
+{
+    mozilla::Atomic<size_t> finished;
+    void* tokens[NumParses];
+};
+
+static void
+OnParseFinished(void* token, void* data)
+{
+    ParseResults* results = static_cast<ParseResults*>(data);
+    results->tokens[results->finished++] = token;
+}
+
+BEGIN_TEST(testConcurrentParseTasks)
+{
+    if (!CanUseExtraThreads() || HelperThreadState().threadCount < 2)
+        return true;
+
+    // A source that takes long enough to parse for the tasks to overlap.
+    const char line[] = "x = [0, 1, 2, 3, 4, 5, 6, 7, 8, 9];\n";
+    const size_t lineLength = sizeof(line) - 1;
+    const size_t numLines = 50000;
+    Vector<char16_t, 0, SystemAllocPolicy> chars;
+    CHECK(chars.reserve(lineLength * numLines));
+    for (size_t i = 0; i < numLines; i++) {
+        for (size_t j = 0; j < lineLength; j++)
+            chars.infallibleAppend(char16_t(line[j]));
+    }
+
+    // Only one parse task runs at a time by default.
+    size_t maxRunning;
+    CHECK(runParses(chars, &maxRunning));
+    CHECK_EQUAL(maxRunning, 1u);
+
+    JS_SetConcurrentParseTasksEnabled(true);
+    bool ok = runParses(chars, &maxRunning);
+    JS_SetConcurrentParseTasksEnabled(false);
+    CHECK(ok);
+    CHECK(maxRunning > 1);
+    return true;
+}
+
+// Parses |chars| NumParses times off thread and reports the largest number of
+// helper threads seen parsing at once.
+bool
+runParses(const Vector<char16_t, 0, SystemAllocPolicy>& chars, size_t* maxRunning)
+{
+    JS::CompileOptions options(cx);
+    options.setFileAndLine(__FILE__, __LINE__).setForceAsync(true);
+
+    ParseResults results;
+    for (size_t i = 0; i < NumParses; i++) {
+        CHECK(JS::CanCompileOffThread(cx, options, chars.length()));
+        CHECK(JS::CompileOffThread(cx, options, chars.begin(), chars.length(),
+                                   OnParseFinished, &results));
+    }
+
+    *maxRunning = 0;
+    while (results.finished < NumParses) {
+        AutoLockHelperThreadState lock;
+        size_t running = 0;
+        for (auto& thread : *HelperThreadState().threads) {
+            if (thread.parseTask())
+                running++;
+        }
+        if (running > *maxRunning)
+            *maxRunning = running;
+    }
+
+    for (size_t i = 0; i < NumParses; i++)
+        CHECK(JS::FinishOffThreadScript(cx, results.tokens[i]));
+    return true;
+}
+END_TEST(testConcurrentParseTasks)
@@ -63,3 +63,53 @@ bool testIndirectEval(JS::HandleObject scope, const char* code)
     return true;
 }
 END_TEST(testDebugger_newScriptHook)
+
+BEGIN_TEST(testDebugger_allocationsLogBuffer)
+{
+    CHECK(JS_DefineDebuggerObject(cx, global));
+    JS::CompartmentOptions options;
+    JS::RootedObject g(cx, JS_NewGlobalObject(cx, getGlobalClass(), nullptr,
+                                              JS::FireOnNewGlobalHook, options));
+    CHECK(g);
+    {
+        JSAutoCompartment ae(cx, g);
+        CHECK(JS_InitStandardClasses(cx, g));
+    }
+
+    JS::RootedObject gWrapper(cx, g);
+    CHECK(JS_WrapObject(cx, &gWrapper));
+    JS::RootedValue v(cx, JS::ObjectValue(*gWrapper));
+    CHECK(JS_SetProperty(cx, global, "g", v));
+
+    // Allocate from the same site repeatedly, overflowing a small ring
+    // buffer; each frame and class name is reported once, and every id in
+    // the records refers to one of them.
+    EXEC("var dbg = Debugger(g);\n"
+         "dbg.memory.allocationsLogBinary = true;\n"
+         "dbg.memory.maxAllocationsLogLength = 8;\n"
+         "dbg.memory.trackingAllocationSites = true;\n"
+         "g.eval('for (var i = 0; i < 20; i++) ({});');\n"
+         "var log = dbg.memory.drainAllocationsLogBuffer();\n"
+         "var view = new DataView(log.records);\n"
+         "var count = log.records.byteLength / log.recordSize;\n"
+         "var frameIds = new Set(), classIds = new Set();\n"
+         "for (var i = 0; i < count; i++) {\n"
+         "    frameIds.add(view.getUint32(i * log.recordSize + 8, true));\n"
+         "    classIds.add(view.getUint32(i * log.recordSize + 12, true));\n"
+         "}\n"
+         "var again = dbg.memory.drainAllocationsLogBuffer();\n");
+
+    JS::RootedValue result(cx);
+    EVAL("count === 8 && log.classNames.indexOf('Object') !== -1 && "
+         "[...frameIds].every(id => id >= 1 && id <= log.frames.length) && "
+         "[...classIds].every(id => id >= 1 && id <= log.classNames.length)",
+         &result);
+    CHECK(result.isTrue());
+
+    EVAL("again.records.byteLength === 0 && again.frames.length === 0 && "
+         "again.classNames.length === 0",
+         &result);
+    CHECK(result.isTrue());
+    return true;
+}
+END_TEST(testDebugger_allocationsLogBuffer)
@@ -0,0 +1,57 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=8 sts=4 et sw=4 tw=99:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "jsapi-tests/tests.h"
+#include "vm/NativeObject.h"
+#include "vm/Shape.h"
+
+// Build a large map-like object and check that its ShapeTable fills past 3/4
+// and that lookups work as the table grows and shrinks.
+BEGIN_TEST(testDictionaryShapeTable)
+{
+    // Large enough for a large table, and chosen such that the table would be
+    // twice as large at a load factor of 3/4.
+    static const uint32_t NumProperties = 3500;
+
+    JS::RootedObject obj(cx, JS_NewPlainObject(cx));
+    CHECK(obj);
+
+    char name[16];
+    for (uint32_t i = 0; i < NumProperties; i++) {
+        snprintf(name, sizeof(name), "p%u", i);
+        CHECK(JS_DefineProperty(cx, obj, name, int32_t(i), JSPROP_ENUMERATE));
+    }
+
+    js::NativeObject& nobj = obj->as<js::NativeObject>();
+    CHECK(nobj.inDictionaryMode());
+
+    js::ShapeTable& table = nobj.lastProperty()->table();
+    CHECK_EQUAL(table.entryCount(), NumProperties);
+    CHECK(table.capacity() < 2 * table.entryCount());
+
+    JS::RootedValue v(cx);
+    for (uint32_t i = 0; i < NumProperties; i++) {
+        snprintf(name, sizeof(name), "p%u", i);
+        CHECK(JS_GetProperty(cx, obj, name, &v));
+        CHECK(v.isInt32(i));
+    }
+
+    // Lookups keep working as properties are removed and the table shrinks.
+    for (uint32_t i = 0; i < NumProperties; i += 2) {
+        snprintf(name, sizeof(name), "p%u", i);
+        CHECK(JS_DeleteProperty(cx, obj, name));
+    }
+    for (uint32_t i = 0; i < NumProperties; i++) {
+        snprintf(name, sizeof(name), "p%u", i);
+        bool found;
+        CHECK(JS_HasProperty(cx, obj, name, &found));
+        CHECK_EQUAL(found, i % 2 == 1);
+    }
+
+    return true;
+}
+END_TEST(testDictionaryShapeTable)
@@ -0,0 +1,91 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=8 sts=4 et sw=4 tw=99:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "jsstr.h"
+
+#include "jsapi-tests/tests.h"
+
+// Exercise the vectorized conversions at every length and alignment around
+// the vector width, so that both the vector loops and their scalar tails run.
+BEGIN_TEST(testLatin1Conversions)
+{
+    static const size_t MaxLength = 80;
+    static const size_t MaxOffset = 16;
+
+    JS::Latin1Char latin1[MaxLength + MaxOffset];
+    char16_t twoByte[MaxLength + MaxOffset];
+    for (size_t i = 0; i < MaxLength + MaxOffset; i++)
+        latin1[i] = JS::Latin1Char(i * 7 + 0x80);
+
+    for (size_t offset = 0; offset < MaxOffset; offset++) {
+        for (size_t length = 0; length + offset <= MaxLength; length++) {
+            const JS::Latin1Char* src = latin1 + offset;
+
+            char16_t inflated[MaxLength + 1];
+            inflated[length] = 0xffff;
+            js::InflateChars(inflated, src, length);
+            for (size_t i = 0; i < length; i++)
+                CHECK_EQUAL(inflated[i], char16_t(src[i]));
+            CHECK_EQUAL(inflated[length], char16_t(0xffff));
+
+            CHECK(js::CharsFitLatin1(inflated, length));
+
+            JS::Latin1Char deflated[MaxLength + 1];
+            deflated[length] = 0x5a;
+            js::DeflateChars(deflated, inflated, length);
+            CHECK(memcmp(deflated, src, length) == 0);
+            CHECK_EQUAL(deflated[length], JS::Latin1Char(0x5a));
+
+            // A single char outside the Latin1 range is found wherever it is,
+            // and deflating it keeps its low byte.
+            for (size_t i = 0; i < length; i++) {
+                mozilla::PodCopy(twoByte, inflated, length);
+                twoByte[i] = char16_t(0x2600 | src[i]);
+                CHECK(!js::CharsFitLatin1(twoByte, length));
+                js::DeflateChars(deflated, twoByte, length);
+                CHECK(memcmp(deflated, src, length) == 0);
+            }
+        }
+    }
+
+    return true;
+}
+END_TEST(testLatin1Conversions)
+
+// Large ropes whose TwoByte leaves only contain Latin1 chars are flattened
+// into Latin1 strings.
+BEGIN_TEST(testFlattenDeflatesTwoByteRope)
+{
+    JS::RootedValue v(cx);
+    // indexOf flattens |twoByte|, so |leaf| depends on a TwoByte string.
+    EVAL("var twoByte = '\\u2603' + 'abcdefgh'.repeat(256);\n"
+         "twoByte.indexOf('z');\n"
+         "var leaf = twoByte.substring(1);\n"
+         "var rope = leaf;\n"
+         "for (var i = 0; i < 8; i++)\n"
+         "    rope = rope + 'x' + leaf;\n"
+         "rope;",
+         &v);
+    JS::RootedString rope(cx, v.toString());
+    CHECK(!JS_StringHasLatin1Chars(rope));
+
+    JSFlatString* flat = JS_FlattenString(cx, rope);
+    CHECK(flat);
+    CHECK(JS_StringHasLatin1Chars(flat));
+
+    EVAL("rope === leaf + ('x' + leaf).repeat(8)", &v);
+    CHECK(v.toBoolean());
+
+    // Ropes with chars outside Latin1 stay TwoByte.
+    EVAL("var mixed = leaf + leaf + twoByte; mixed.indexOf('\\u2603');", &v);
+    CHECK_SAME(v, JS::Int32Value(2 * 2048));
+    EVAL("mixed", &v);
+    CHECK(!JS_StringHasLatin1Chars(v.toString()));
+
+    return true;
+}
+END_TEST(testFlattenDeflatesTwoByteRope)
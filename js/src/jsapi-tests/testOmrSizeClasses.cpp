@@ -0,0 +1,80 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=8 sts=4 et sw=4 tw=99:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "gc/Heap.h"
+
+#include "jsapi-tests/tests.h"
+
+#ifdef OMR
+#include "sizeclasses.h"
+#endif
+
+#if defined(OMR_GC_SEGREGATED_HEAP)
+
+using namespace js;
+using namespace js::gc;
+
+// The generic table sizeclasses.h shipped with before it was fitted to
+// SpiderMonkey's things.
+static const uintptr_t ExampleSizeClasses[] =
+    { 0, 16, 32, 64, 96, 160, 240, 352, 456, 592, 760, 968, 1200, 1520, 1760, 2048 };
+
+static const uintptr_t SmallSizeClasses[] = SMALL_SIZECLASSES;
+
+template <size_t N>
+static uintptr_t
+SizeClassFor(const uintptr_t (&classes)[N], size_t size)
+{
+    for (size_t i = 1; i < N; i++) {
+        if (classes[i] >= size)
+            return classes[i];
+    }
+    return 0;
+}
+
+// Bytes used and bytes allocated for one of each AllocKind, and for slot
+// buffers of every small length, as a stand-in for a heap's population.
+template <size_t N>
+static void
+MeasureOccupancy(const uintptr_t (&classes)[N], size_t* used, size_t* allocated)
+{
+    *used = 0;
+    *allocated = 0;
+    for (size_t i = 0; i < size_t(AllocKind::LIMIT); i++) {
+        size_t size = OmrGcHelper::thingSize(AllocKind(i));
+        *used += size;
+        *allocated += SizeClassFor(classes, size);
+    }
+    for (size_t nslots = 1; sizeof(OmrBuffer) + nslots * sizeof(HeapSlot) <= classes[N - 1]; nslots++) {
+        size_t size = sizeof(OmrBuffer) + nslots * sizeof(HeapSlot);
+        *used += size;
+        *allocated += SizeClassFor(classes, size);
+    }
+}
+
+BEGIN_TEST(testOmrSizeClasses_occupancy)
+{
+    size_t exampleUsed, exampleAllocated;
+    MeasureOccupancy(ExampleSizeClasses, &exampleUsed, &exampleAllocated);
+    size_t used, allocated;
+    MeasureOccupancy(SmallSizeClasses, &used, &allocated);
+
+    CHECK(used == exampleUsed);
+    CHECK(allocated < exampleAllocated);
+
+    // Objects, the most numerous things, fill their 8 byte aligned cells.
+    for (size_t i = 0; i < size_t(AllocKind::LIMIT); i++) {
+        size_t size = OmrGcHelper::thingSize(AllocKind(i));
+        if (IsObjectAllocKind(AllocKind(i)))
+            CHECK(SizeClassFor(SmallSizeClasses, size) == AlignBytes(size, 8));
+    }
+
+    return true;
+}
+END_TEST(testOmrSizeClasses_occupancy)
+
+#endif // OMR_GC_SEGREGATED_HEAP
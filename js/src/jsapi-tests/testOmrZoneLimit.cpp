@@ -0,0 +1,51 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=8 sts=4 et sw=4 tw=99:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "gc/Heap.h"
+
+#include "jsapi-tests/tests.h"
+
+#ifdef OMR
+
+using namespace js;
+using namespace js::gc;
+
+// Every zone takes a slot in OmrGcHelper's zone table, whose index is kept in
+// the header of each of its cells. Running out of slots must fail zone
+// creation with an ordinary OOM rather than crashing.
+BEGIN_TEST(testOmrZoneLimit)
+{
+    CHECK(Cell::OmrMaxZones >= 1 << 16);
+
+    // Fill the remaining slots. Nothing is allocated in them, so the zone of
+    // the test's global can stand in for the missing zones.
+    Vector<uint32_t, 0, SystemAllocPolicy> filled;
+    uint32_t index;
+    while (OmrGcHelper::registerZone(global->zone(), &index))
+        CHECK(filled.append(index));
+    CHECK(filled.length() < Cell::OmrMaxZones);
+
+    JS::CompartmentOptions options;
+    JSObject* full = JS_NewGlobalObject(cx, getGlobalClass(), nullptr,
+                                        JS::FireOnNewGlobalHook, options);
+    bool failedCleanly = !full && JS_IsExceptionPending(cx);
+    JS_ClearPendingException(cx);
+
+    for (uint32_t i : filled)
+        OmrGcHelper::unregisterZone(i);
+    CHECK(failedCleanly);
+
+    // Zones can be created again once slots are free.
+    JS::RootedObject newGlobal(cx, JS_NewGlobalObject(cx, getGlobalClass(), nullptr,
+                                                      JS::FireOnNewGlobalHook, options));
+    CHECK(newGlobal);
+    CHECK(newGlobal->zone() != global->zone());
+    return true;
+}
+END_TEST(testOmrZoneLimit)
+
+#endif // OMR
@@ -0,0 +1,124 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ds/OrderedHashTable.h"
+#include "jsapi-tests/tests.h"
+
+/*
+ * The hash policy maps many keys to the same hash, so that probing has to
+ * skip over colliding entries and continue past full groups.
+ */
+struct CollidingHashPolicy
+{
+    typedef uint32_t Lookup;
+    static js::HashNumber hash(const Lookup& l) { return l % 7; }
+    static bool match(const uint32_t& k, const Lookup& l) { return k == l; }
+    static bool isEmpty(const uint32_t& k) { return k == UINT32_MAX; }
+    static void makeEmpty(uint32_t* kp) { *kp = UINT32_MAX; }
+};
+
+typedef js::OrderedHashMap<uint32_t, uint32_t, CollidingHashPolicy, js::SystemAllocPolicy> IntMap;
+
+BEGIN_TEST(testOrderedHashTable_putRemoveRehash)
+{
+    const uint32_t N = 1000;
+
+    IntMap map;
+    CHECK(map.init());
+
+    for (uint32_t i = 0; i < N; i++)
+        CHECK(map.put(i, i * 2));
+    CHECK(map.count() == N);
+
+    // Remove the odd keys while a Range is live; it should skip the removed
+    // entries and keep its position when the table is compacted.
+    IntMap::Range r = map.all();
+    CHECK(r.front().key == 0);
+    r.popFront();
+    for (uint32_t i = 1; i < N; i += 2) {
+        bool found;
+        CHECK(map.remove(i, &found));
+        CHECK(found);
+    }
+    CHECK(map.count() == N / 2);
+    CHECK(r.front().key == 2);
+
+    for (uint32_t i = 0; i < N; i++) {
+        const IntMap::Entry* e = map.get(i);
+        if (i % 2) {
+            CHECK(!e);
+        } else {
+            CHECK(e);
+            CHECK(e->value == i * 2);
+        }
+    }
+
+    // Reinsert the removed keys; iteration follows insertion order.
+    for (uint32_t i = 1; i < N; i += 2)
+        CHECK(map.put(i, i * 2));
+    CHECK(map.count() == N);
+
+    uint32_t expected = 2;
+    for (; !r.empty(); r.popFront()) {
+        CHECK(r.front().key == expected);
+        expected += 2;
+        if (expected == N)
+            expected = 1;
+    }
+    CHECK(expected == N + 1);
+
+    return true;
+}
+END_TEST(testOrderedHashTable_putRemoveRehash)
+
+BEGIN_TEST(testOrderedHashTable_rekey)
+{
+    const uint32_t N = 500;
+
+    IntMap map;
+    CHECK(map.init());
+    for (uint32_t i = 0; i < N; i++)
+        CHECK(map.put(i, i));
+
+    // Rekey every entry, both through Range::rekeyFront and
+    // rekeyOneEntry. Each entry keeps its position in iteration order.
+    for (IntMap::Range r = map.all(); !r.empty(); r.popFront()) {
+        uint32_t key = r.front().key;
+        if (key % 2 == 0)
+            r.rekeyFront(key + N);
+    }
+    for (uint32_t i = 1; i < N; i += 2)
+        map.rekeyOneEntry(i, i + N);
+
+    CHECK(map.count() == N);
+    uint32_t expected = 0;
+    for (IntMap::Range r = map.all(); !r.empty(); r.popFront()) {
+        CHECK(r.front().key == expected + N);
+        CHECK(r.front().value == expected);
+        expected++;
+    }
+    CHECK(expected == N);
+
+    for (uint32_t i = 0; i < N; i++) {
+        CHECK(!map.has(i));
+        CHECK(map.has(i + N));
+    }
+
+    // Removing and adding entries repeatedly without growing the table
+    // must not exhaust its free slots.
+    for (uint32_t round = 0; round < 20; round++) {
+        for (uint32_t i = 0; i < N; i++) {
+            bool found;
+            CHECK(map.remove(i + N, &found));
+            CHECK(found);
+            CHECK(map.put(i + N, i));
+        }
+    }
+    CHECK(map.count() == N);
+    for (uint32_t i = 0; i < N; i++)
+        CHECK(map.get(i + N)->value == i);
+
+    return true;
+}
+END_TEST(testOrderedHashTable_rekey)
@@ -89,3 +89,26 @@ BEGIN_TEST(testPromise_RejectPromise)
     return true;
 }
 END_TEST(testPromise_RejectPromise)
+
+BEGIN_TEST(testPromise_ResolveThenResult)
+{
+    // The result of |then| is created without resolving functions, but must
+    // still be resolvable through the API.
+    RootedValue val(cx);
+    EVAL("new Promise(() => {}).then(x => x)", &val);
+    RootedObject promise(cx, &val.toObject());
+    CHECK(JS::IsPromiseObject(promise));
+    CHECK(JS::GetPromiseState(promise) == JS::PromiseState::Pending);
+
+    RootedValue result(cx);
+    result.setInt32(42);
+    CHECK(JS::ResolvePromise(cx, promise, result));
+    CHECK(JS::GetPromiseState(promise) == JS::PromiseState::Fulfilled);
+
+    // Settled promises ignore further resolution.
+    CHECK(JS::RejectPromise(cx, promise, result));
+    CHECK(JS::GetPromiseState(promise) == JS::PromiseState::Fulfilled);
+
+    return true;
+}
+END_TEST(testPromise_ResolveThenResult)
@@ -58,3 +58,37 @@ BEGIN_TEST(testGetRegExpSource)
     return true;
 }
 END_TEST(testGetRegExpSource)
+
+BEGIN_TEST(testRegExpCodeCache)
+{
+    JS::ContextOptionsRef(cx).setSharedRegExpCache(true);
+
+    JS::RootedValue val(cx);
+    EVAL("/(fo+)(py)?/.exec('a foopy')[1]", &val);
+    CHECK(val.isString());
+    CHECK(JS_FlatStringEqualsAscii(JS_ASSERT_STRING_IS_FLAT(val.toString()), "foo"));
+    CHECK(cx->runtime()->regExpCodeCache);
+
+    // The same regexp in another compartment runs the programs compiled by
+    // the first, including after a GC.
+    JS::CompartmentOptions options;
+    JS::RootedObject otherGlobal(cx, JS_NewGlobalObject(cx, getGlobalClass(), nullptr,
+                                                        JS::FireOnNewGlobalHook, options));
+    CHECK(otherGlobal);
+    {
+        JSAutoCompartment ac(cx, otherGlobal);
+        EVAL("/(fo+)(py)?/.exec('a foopy')[2]", &val);
+        CHECK(val.isString());
+        CHECK(JS_FlatStringEqualsAscii(JS_ASSERT_STRING_IS_FLAT(val.toString()), "py"));
+
+        JS_GC(cx);
+
+        EVAL("/(fo+)(py)?/.exec('fooo')[1]", &val);
+        CHECK(val.isString());
+        CHECK(JS_FlatStringEqualsAscii(JS_ASSERT_STRING_IS_FLAT(val.toString()), "fooo"));
+    }
+
+    JS::ContextOptionsRef(cx).setSharedRegExpCache(false);
+    return true;
+}
+END_TEST(testRegExpCodeCache)
@@ -0,0 +1,50 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=8 sts=4 et sw=4 tw=99:
+ */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "jsapi-tests/tests.h"
+
+// Check the native radix sort against a comparator sort, for every element
+// type and for lengths that take the insertion sort, radix sort and parallel
+// radix sort paths.
+BEGIN_TEST(testTypedArraySort)
+{
+    JS::RootedValue v(cx);
+    EVAL("var seed = 1;\n"
+         "function random() {\n"
+         "    seed = (seed * 1103515245 + 12345) % 2147483648;\n"
+         "    return seed / 2147483648;\n"
+         "}\n"
+         "function compare(a, b) {\n"
+         "    if (a !== a) return b !== b ? 0 : 1;\n"
+         "    if (b !== b) return -1;\n"
+         "    if (a === 0 && b === 0) return Object.is(a, b) ? 0 : Object.is(a, -0) ? -1 : 1;\n"
+         "    return a < b ? -1 : a > b ? 1 : 0;\n"
+         "}\n"
+         "function check(Type, length) {\n"
+         "    var specials = [NaN, -0, 0, Infinity, -Infinity, -1, 1, 2147483647, -2147483648];\n"
+         "    var array = new Type(length);\n"
+         "    for (var i = 0; i < length; i++) {\n"
+         "        var r = random();\n"
+         "        array[i] = r < 0.1 ? specials[i % specials.length] : (r - 0.5) * 1e10;\n"
+         "    }\n"
+         "    var expected = Array.from(array).sort(compare);\n"
+         "    array.sort();\n"
+         "    for (var i = 0; i < length; i++) {\n"
+         "        if (!Object.is(array[i], expected[i]))\n"
+         "            return false;\n"
+         "    }\n"
+         "    return true;\n"
+         "}\n"
+         "var types = [Int8Array, Uint8Array, Uint8ClampedArray, Int16Array, Uint16Array,\n"
+         "             Int32Array, Uint32Array, Float32Array, Float64Array];\n"
+         "types.every(Type => [0, 1, 2, 63, 64, 65, 1000, 300000].every(n => check(Type, n)));",
+         &v);
+    CHECK(v.isTrue());
+
+    return true;
+}
+END_TEST(testTypedArraySort)
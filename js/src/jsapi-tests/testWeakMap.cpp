@@ -68,6 +68,47 @@ checkSize(JS::HandleObject map, uint32_t expected)
 }
 END_TEST(testWeakMap_basicOperations)
 
+BEGIN_TEST(testWeakMap_ephemeronChain)
+{
+    JS::RootedObject map(cx, JS::NewWeakMapObject(cx));
+    CHECK(map);
+
+    // The second key is only reachable as the value of the first one's entry.
+    JS::RootedObject key1(cx, JS_NewPlainObject(cx));
+    CHECK(key1);
+    {
+        JS::RootedObject key2(cx, JS_NewPlainObject(cx));
+        CHECK(key2);
+        JS::RootedValue val(cx, JS::ObjectValue(*key2));
+        CHECK(SetWeakMapEntry(cx, map, key1, val));
+        val = JS::Int32Value(1);
+        CHECK(SetWeakMapEntry(cx, map, key2, val));
+    }
+
+    JS_GC(cx);
+    CHECK(checkSize(map, 2));
+
+    key1 = nullptr;
+    JS_GC(cx);
+    CHECK(checkSize(map, 0));
+
+    return true;
+}
+
+bool
+checkSize(JS::HandleObject map, uint32_t expected)
+{
+    JS::RootedObject keys(cx);
+    CHECK(JS_NondeterministicGetWeakMapKeys(cx, map, &keys));
+
+    uint32_t length;
+    CHECK(JS_GetArrayLength(cx, keys, &length));
+    CHECK(length == expected);
+
+    return true;
+}
+END_TEST(testWeakMap_ephemeronChain)
+
 BEGIN_TEST(testWeakMap_keyDelegates)
 {
     JS_SetGCParameter(cx, JSGC_MODE, JSGC_MODE_INCREMENTAL);
@@ -9,6 +9,8 @@
 #include "jsstr.h"
 
 #include "jsapi-tests/tests.h"
+#include "threading/ConditionVariable.h"
+#include "threading/Mutex.h"
 
 #include "jsscriptinlines.h"
 
@@ -164,3 +166,105 @@ BEGIN_TEST(testXDR_sourceMap)
     return true;
 }
 END_TEST(testXDR_sourceMap)
+
+struct OffThreadDecode {
+    js::Mutex mutex;
+    js::ConditionVariable condition;
+    void* token;
+
+    OffThreadDecode() : token(nullptr) {}
+
+    static void callback(void* token, void* data) {
+        OffThreadDecode* decode = static_cast<OffThreadDecode*>(data);
+        js::UniqueLock<js::Mutex> lock(decode->mutex);
+        decode->token = token;
+        decode->condition.notify_one();
+    }
+
+    void* waitForToken() {
+        js::UniqueLock<js::Mutex> lock(mutex);
+        while (!token)
+            condition.wait(lock);
+        return token;
+    }
+};
+
+BEGIN_TEST(testXDR_offThreadDecode)
+{
+    const char* s =
+        "function outer(x) {\n"
+        "    function inner(y) { return x + y; }\n"
+        "    return inner(1);\n"
+        "}\n"
+        "outer(41);\n";
+
+    JS::CompileOptions options(cx);
+    options.setFileAndLine(__FILE__, __LINE__);
+    options.forceAsync = true;
+    if (!JS::CanDecodeOffThread(cx, options, 0))
+        return true;
+
+    JS::RootedScript script(cx);
+    CHECK(JS_CompileScript(cx, s, strlen(s), options, &script));
+
+    JS::SetBuildIdOp(cx, GetBuildId);
+    uint32_t nbytes;
+    void* memory = JS_EncodeScript(cx, script, &nbytes);
+    CHECK(memory);
+
+    // Decode data that is all available up front.
+    {
+        OffThreadDecode decode;
+        CHECK(JS::DecodeOffThreadScript(cx, options, memory, nbytes,
+                                        OffThreadDecode::callback, &decode));
+        script = JS::FinishOffThreadScriptDecoder(cx, decode.waitForToken());
+        CHECK(script);
+
+        JS::RootedValue v(cx);
+        CHECK(JS_ExecuteScript(cx, script, &v));
+        CHECK(v.isInt32());
+        CHECK_EQUAL(v.toInt32(), 42);
+    }
+
+    // Decode data delivered in pieces after the decoder has started.
+    {
+        OffThreadDecode decode;
+        void* token = JS::StartStreamingDecodeOffThread(cx, options, nbytes,
+                                                        OffThreadDecode::callback, &decode);
+        CHECK(token);
+        const uint8_t* bytes = static_cast<const uint8_t*>(memory);
+        uint32_t chunk = nbytes / 3 + 1;
+        for (uint32_t offset = 0; offset < nbytes; offset += chunk) {
+            uint32_t length = mozilla::Min(chunk, nbytes - offset);
+            CHECK(JS::AppendStreamingDecodeData(token, bytes + offset, length));
+        }
+        CHECK(!JS::AppendStreamingDecodeData(token, bytes, 1));
+        JS::EndStreamingDecodeData(token);
+        CHECK(decode.waitForToken() == token);
+        script = JS::FinishOffThreadScriptDecoder(cx, token);
+        CHECK(script);
+
+        JS::RootedValue v(cx);
+        CHECK(JS_ExecuteScript(cx, script, &v));
+        CHECK(v.isInt32());
+        CHECK_EQUAL(v.toInt32(), 42);
+    }
+
+    // A stream that ends early fails to decode.
+    {
+        OffThreadDecode decode;
+        void* token = JS::StartStreamingDecodeOffThread(cx, options, nbytes,
+                                                        OffThreadDecode::callback, &decode);
+        CHECK(token);
+        CHECK(JS::AppendStreamingDecodeData(token, memory, nbytes / 2));
+        JS::EndStreamingDecodeData(token);
+        CHECK(decode.waitForToken() == token);
+        CHECK(!JS::FinishOffThreadScriptDecoder(cx, token));
+        CHECK(JS_IsExceptionPending(cx));
+        JS_ClearPendingException(cx);
+    }
+
+    js_free(memory);
+    return true;
+}
+END_TEST(testXDR_offThreadDecode)
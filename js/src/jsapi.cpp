@@ -60,6 +60,7 @@
 #include "frontend/FullParseHandler.h"  // for JS_BufferIsCompileableUnit
 #include "frontend/Parser.h" // for JS_BufferIsCompileableUnit
 #include "gc/Marking.h"
+#include "gc/Memory.h"
 #include "gc/Policy.h"
 #include "jit/JitCommon.h"
 #include "js/CharacterEncoding.h"
@@ -511,6 +512,13 @@ JS_NewContext(uint32_t maxbytes, uint32_t maxNurseryBytes, JSContext* parentCont
 #if defined(OMR)
 	omr_error_t rc = InitializeOMR();
 	Nursery::omrVM->_language_vm = cx->runtime();
+	/* The heap is now reserved; the post barriers need to know where new space is. */
+	gc::OmrGcHelper::updateGenerationalBounds();
+	/* Opt-in, so that the TLB effect of huge pages can be measured. */
+	if (getenv("JS_GC_HUGE_PAGES")) {
+		gc::MarkPagesHuge(reinterpret_cast<void*>(gc::OmrGcHelper::heapBase),
+		                  gc::OmrGcHelper::heapSize);
+	}
 #endif /* defined(OMR) */
 	return cx;
 }
@@ -4136,6 +4144,72 @@ JS::CancelOffThreadModule(JSContext* cx, void* token)
     HelperThreadState().cancelParseTask(cx, ParseTaskKind::Module, token);
 }
 
+JS_PUBLIC_API(bool)
+JS::CanDecodeOffThread(JSContext* cx, const ReadOnlyCompileOptions& options, size_t length)
+{
+    static const size_t TINY_LENGTH = 5 * 1000;
+
+    // As for compilation, these are heuristics which the caller may choose to
+    // ignore. Decoding is cheaper than parsing, so it is never worth waiting
+    // for a GC to complete first.
+    if (!options.forceAsync) {
+        if (length < TINY_LENGTH)
+            return false;
+
+        if (OffThreadParsingMustWaitForGC(cx->runtime()))
+            return false;
+    }
+
+    return cx->runtime()->canUseParallelParsing() && CanUseExtraThreads();
+}
+
+JS_PUBLIC_API(bool)
+JS::DecodeOffThreadScript(JSContext* cx, const ReadOnlyCompileOptions& options,
+                          const void* data, uint32_t length,
+                          OffThreadCompileCallback callback, void* callbackData)
+{
+    MOZ_ASSERT(CanDecodeOffThread(cx, options, length));
+    return StartOffThreadDecodeScript(cx, options, data, length, callback, callbackData);
+}
+
+JS_PUBLIC_API(void*)
+JS::StartStreamingDecodeOffThread(JSContext* cx, const ReadOnlyCompileOptions& options,
+                                  uint32_t length,
+                                  OffThreadCompileCallback callback, void* callbackData)
+{
+    MOZ_ASSERT(CanDecodeOffThread(cx, options, length));
+    return StartOffThreadStreamingDecodeScript(cx, options, length, callback, callbackData);
+}
+
+JS_PUBLIC_API(bool)
+JS::AppendStreamingDecodeData(void* token, const void* data, uint32_t length)
+{
+    return static_cast<ScriptDecodeTask*>(token)->appendData(data, length);
+}
+
+JS_PUBLIC_API(void)
+JS::EndStreamingDecodeData(void* token)
+{
+    AutoLockHelperThreadState lock;
+    static_cast<ScriptDecodeTask*>(token)->endStream(lock);
+}
+
+JS_PUBLIC_API(JSScript*)
+JS::FinishOffThreadScriptDecoder(JSContext* cx, void* token)
+{
+    MOZ_ASSERT(cx);
+    MOZ_ASSERT(CurrentThreadCanAccessRuntime(cx));
+    return HelperThreadState().finishScriptDecodeTask(cx, token);
+}
+
+JS_PUBLIC_API(void)
+JS::CancelOffThreadScriptDecoder(JSContext* cx, void* token)
+{
+    MOZ_ASSERT(cx);
+    MOZ_ASSERT(CurrentThreadCanAccessRuntime(cx));
+    HelperThreadState().cancelParseTask(cx, ParseTaskKind::ScriptDecode, token);
+}
+
 JS_PUBLIC_API(bool)
 JS_CompileScript(JSContext* cx, const char* ascii, size_t length,
                  const JS::CompileOptions& options, MutableHandleScript script)
@@ -6239,6 +6313,12 @@ JS_SetParallelParsingEnabled(JSContext* cx, bool enabled)
     cx->setParallelParsingEnabled(enabled);
 }
 
+JS_PUBLIC_API(void)
+JS_SetConcurrentParseTasksEnabled(bool enabled)
+{
+    js::SetConcurrentParseTasksEnabled(enabled);
+}
+
 JS_PUBLIC_API(void)
 JS_SetOffthreadIonCompilationEnabled(JSContext* cx, bool enabled)
 {
@@ -6683,6 +6763,12 @@ JS::SetAsmJSCacheOps(JSContext* cx, const JS::AsmJSCacheOps* ops)
     cx->runtime()->asmJSCacheOps = *ops;
 }
 
+JS_PUBLIC_API(void)
+JS::SetWasmCacheOps(JSContext* cx, const JS::WasmCacheOps* ops)
+{
+    cx->runtime()->wasmCacheOps = *ops;
+}
+
 char*
 JSAutoByteString::encodeLatin1(ExclusiveContext* cx, JSString* str)
 {
@@ -1087,8 +1087,11 @@ class JS_PUBLIC_API(ContextOptions) {
         asmJS_(true),
         wasm_(false),
         wasmAlwaysBaseline_(false),
+        wasmTiering_(false),
         throwOnAsmJSValidationFailure_(false),
         nativeRegExp_(true),
+        sharedRegExpCache_(false),
+        lz4SourceCompression_(false),
         unboxedArrays_(false),
         asyncStack_(true),
         throwOnDebuggeeWouldRun_(true),
@@ -1149,6 +1152,16 @@ class JS_PUBLIC_API(ContextOptions) {
         return *this;
     }
 
+    bool wasmTiering() const { return wasmTiering_; }
+    ContextOptions& setWasmTiering(bool flag) {
+        wasmTiering_ = flag;
+        return *this;
+    }
+    ContextOptions& toggleWasmTiering() {
+        wasmTiering_ = !wasmTiering_;
+        return *this;
+    }
+
     bool throwOnAsmJSValidationFailure() const { return throwOnAsmJSValidationFailure_; }
     ContextOptions& setThrowOnAsmJSValidationFailure(bool flag) {
         throwOnAsmJSValidationFailure_ = flag;
@@ -1165,6 +1178,23 @@ class JS_PUBLIC_API(ContextOptions) {
         return *this;
     }
 
+    // Share compiled regexps between compartments through a runtime-wide
+    // cache, rather than compiling them once per compartment.
+    bool sharedRegExpCache() const { return sharedRegExpCache_; }
+    ContextOptions& setSharedRegExpCache(bool flag) {
+        sharedRegExpCache_ = flag;
+        return *this;
+    }
+
+    // Compress script sources with LZ4 instead of zlib. The compressed source
+    // is somewhat larger, but compressing it and decompressing chunks of it
+    // for Function.prototype.toString and lazy parsing is much faster.
+    bool lz4SourceCompression() const { return lz4SourceCompression_; }
+    ContextOptions& setLZ4SourceCompression(bool flag) {
+        lz4SourceCompression_ = flag;
+        return *this;
+    }
+
     bool unboxedArrays() const { return unboxedArrays_; }
     ContextOptions& setUnboxedArrays(bool flag) {
         unboxedArrays_ = flag;
@@ -1225,8 +1255,11 @@ class JS_PUBLIC_API(ContextOptions) {
     bool asmJS_ : 1;
     bool wasm_ : 1;
     bool wasmAlwaysBaseline_ : 1;
+    bool wasmTiering_ : 1;
     bool throwOnAsmJSValidationFailure_ : 1;
     bool nativeRegExp_ : 1;
+    bool sharedRegExpCache_ : 1;
+    bool lz4SourceCompression_ : 1;
     bool unboxedArrays_ : 1;
     bool asyncStack_ : 1;
     bool throwOnDebuggeeWouldRun_ : 1;
@@ -1756,6 +1789,18 @@ typedef enum JSGCParamKey {
 
     /** If true, painting can trigger IGC slices. */
     JSGC_REFRESH_FRAME_SLICES_ENABLED = 24,
+
+    /**
+     * Whether the OMR collector may start concurrent mark cycles. This only
+     * has an effect if the collector was configured for concurrent mark.
+     */
+    JSGC_CONCURRENT_MARK_ENABLED = 25,
+
+    /**
+     * Whether global collections of the OMR heap record the classes and kinds
+     * of the cells holding the most live bytes.
+     */
+    JSGC_FREQUENT_OBJECTS_ENABLED = 26,
 } JSGCParamKey;
 
 extern JS_PUBLIC_API(void)
@@ -4108,6 +4153,51 @@ FinishOffThreadModule(JSContext* cx, void* token);
 extern JS_PUBLIC_API(void)
 CancelOffThreadModule(JSContext* cx, void* token);
 
+extern JS_PUBLIC_API(bool)
+CanDecodeOffThread(JSContext* cx, const ReadOnlyCompileOptions& options, size_t length);
+
+/*
+ * Off thread decoding of scripts encoded with JS_EncodeScript follows the
+ * same control flow as off thread compilation, with FinishOffThreadScriptDecoder
+ * and CancelOffThreadScriptDecoder in place of FinishOffThreadScript and
+ * CancelOffThreadScript. The data passed to DecodeOffThreadScript must remain
+ * live until the callback is invoked.
+ *
+ * StartStreamingDecodeOffThread starts decoding a script of |length| bytes
+ * before its data is available, for instance while it is being read from a
+ * cache, and returns the token of the decode. The bytes are then delivered in
+ * order with AppendStreamingDecodeData, which may be called from any thread
+ * and copies them, and which fails if more than |length| bytes are delivered.
+ * The decoder works through each part of the script as soon as it has
+ * arrived. EndStreamingDecodeData must be called once all the data has been
+ * delivered or the transfer has failed, and before the decode is finished or
+ * cancelled; if the data is incomplete, decoding fails and the callback is
+ * invoked as usual. Off thread parses run one at a time, so a stalled stream
+ * also delays other off thread compilations until it is ended.
+ */
+
+extern JS_PUBLIC_API(bool)
+DecodeOffThreadScript(JSContext* cx, const ReadOnlyCompileOptions& options,
+                      const void* data, uint32_t length,
+                      OffThreadCompileCallback callback, void* callbackData);
+
+extern JS_PUBLIC_API(void*)
+StartStreamingDecodeOffThread(JSContext* cx, const ReadOnlyCompileOptions& options,
+                              uint32_t length,
+                              OffThreadCompileCallback callback, void* callbackData);
+
+extern JS_PUBLIC_API(bool)
+AppendStreamingDecodeData(void* token, const void* data, uint32_t length);
+
+extern JS_PUBLIC_API(void)
+EndStreamingDecodeData(void* token);
+
+extern JS_PUBLIC_API(JSScript*)
+FinishOffThreadScriptDecoder(JSContext* cx, void* token);
+
+extern JS_PUBLIC_API(void)
+CancelOffThreadScriptDecoder(JSContext* cx, void* token);
+
 /**
  * Compile a function with envChain plus the global as its scope chain.
  * envChain must contain objects in the current compartment of cx.  The actual
@@ -5684,6 +5774,14 @@ JS_ScheduleGC(JSContext* cx, uint32_t count);
 extern JS_PUBLIC_API(void)
 JS_SetParallelParsingEnabled(JSContext* cx, bool enabled);
 
+/*
+ * Let off thread parses of different scripts run at the same time, each on
+ * its own helper thread. This is process-wide and off by default, so that
+ * only one helper thread at a time spends memory and CPU on parsing.
+ */
+extern JS_PUBLIC_API(void)
+JS_SetConcurrentParseTasksEnabled(bool enabled);
+
 extern JS_PUBLIC_API(void)
 JS_SetOffthreadIonCompilationEnabled(JSContext* cx, bool enabled);
 
@@ -5949,6 +6047,41 @@ SetAsmJSCacheOps(JSContext* cx, const AsmJSCacheOps* callbacks);
 extern JS_PUBLIC_API(void)
 SetBuildIdOp(JSContext* cx, BuildIdOp buildIdOp);
 
+/**
+ * The wasm cache callbacks mirror the asm.js ones above for modules compiled
+ * through the WebAssembly JS API, except that entries are keyed by a
+ * WasmCacheKeyLength-byte hash of the module's bytecode instead of its source.
+ * The JS engine checks an entry's build id, CPU features and full bytecode
+ * before using it, so an embedding may return stale or colliding entries.
+ * Returning 'false' from either open callback simply bypasses the cache. If
+ * an open callback returns 'true', the JS engine guarantees a call to the
+ * matching close callback, passing the same base address, size and handle.
+ */
+static const size_t WasmCacheKeyLength = 20;
+
+typedef bool
+(* OpenWasmCacheEntryForReadOp)(HandleObject global, const uint8_t* key,
+                                size_t* size, const uint8_t** memory, intptr_t* handle);
+typedef void
+(* CloseWasmCacheEntryForReadOp)(size_t size, const uint8_t* memory, intptr_t handle);
+
+typedef bool
+(* OpenWasmCacheEntryForWriteOp)(HandleObject global, const uint8_t* key,
+                                 size_t size, uint8_t** memory, intptr_t* handle);
+typedef void
+(* CloseWasmCacheEntryForWriteOp)(size_t size, uint8_t* memory, intptr_t handle);
+
+struct WasmCacheOps
+{
+    OpenWasmCacheEntryForReadOp openEntryForRead;
+    CloseWasmCacheEntryForReadOp closeEntryForRead;
+    OpenWasmCacheEntryForWriteOp openEntryForWrite;
+    CloseWasmCacheEntryForWriteOp closeEntryForWrite;
+};
+
+extern JS_PUBLIC_API(void)
+SetWasmCacheOps(JSContext* cx, const WasmCacheOps* callbacks);
+
 /**
  * Convenience class for imitating a JS level for-of loop. Typical usage:
  *
@@ -6438,6 +6571,16 @@ SetStopwatchIsMonitoringJank(JSContext*, bool);
 extern JS_PUBLIC_API(bool)
 GetStopwatchIsMonitoringJank(JSContext*);
 
+/**
+ * Measure only a random sample of the entries into JS, on average one
+ * out of `interval`, and scale the measures accordingly. An interval
+ * of 0 or 1 measures every entry, which is the default.
+ */
+extern JS_PUBLIC_API(void)
+SetStopwatchSamplingInterval(JSContext*, uint32_t interval);
+extern JS_PUBLIC_API(uint32_t)
+GetStopwatchSamplingInterval(JSContext*);
+
 // Extract the CPU rescheduling data.
 extern JS_PUBLIC_API(void)
 GetPerfMonitoringTestCpuRescheduling(JSContext*, uint64_t* stayed, uint64_t* moved);
@@ -253,6 +253,64 @@ js::MarkWellKnownSymbols(JSTracer* trc)
     }
 }
 
+#ifdef OMR // Compaction
+template <typename T>
+static void
+FixupImmutablePtr(JSTracer* trc, ImmutableTenuredPtr<T>& ptr, const char* name)
+{
+    T thing = ptr.get();
+    if (thing) {
+        TraceManuallyBarrieredEdge(trc, &thing, name);
+        ptr.init(thing);
+    }
+}
+
+static void
+FixupAtomStateEntry(JSTracer* trc, AtomStateEntry& entry)
+{
+    // Atoms are hashed by their characters, so entries are updated in place.
+    JSAtom* atom = entry.asPtrUnbarriered();
+    TraceManuallyBarrieredEdge(trc, &atom, "atom table entry");
+    entry = AtomStateEntry(atom, entry.isPinned());
+}
+
+void
+js::FixupAtomsAfterCompaction(JSTracer* trc, AutoLockForExclusiveAccess& lock)
+{
+    JSRuntime* rt = trc->runtime();
+
+    if (!rt->atomsAreFinished()) {
+        for (AtomSet::Enum e(rt->atoms(lock)); !e.empty(); e.popFront())
+            FixupAtomStateEntry(trc, e.mutableFront());
+    }
+
+    // Everything below is shared with, and fixed up by, the parent runtime.
+    if (rt->parentRuntime)
+        return;
+
+    if (rt->staticStrings)
+        rt->staticStrings->fixupAfterCompaction(trc);
+
+    if (rt->permanentAtoms) {
+        for (FrozenAtomSet::Range r(rt->permanentAtoms->all()); !r.empty(); r.popFront())
+            FixupAtomStateEntry(trc, const_cast<AtomStateEntry&>(r.front()));
+    }
+
+    if (WellKnownSymbols* wks = rt->wellKnownSymbols) {
+        ImmutableSymbolPtr* symbols = reinterpret_cast<ImmutableSymbolPtr*>(wks);
+        for (size_t i = 0; i < JS::WellKnownSymbolLimit; i++)
+            FixupImmutablePtr(trc, symbols[i], "well_known_symbol");
+    }
+
+    if (rt->commonNames) {
+        ImmutablePropertyNamePtr* names = reinterpret_cast<ImmutablePropertyNamePtr*>(rt->commonNames);
+        for (size_t i = 0; i < sizeof(JSAtomState) / sizeof(ImmutablePropertyNamePtr); i++)
+            FixupImmutablePtr(trc, names[i], "common_name");
+        rt->emptyString = rt->commonNames->empty;
+    }
+}
+#endif // OMR Compaction
+
 void
 JSRuntime::sweepAtoms()
 {
@@ -563,15 +621,19 @@ js::XDRAtom(XDRState<mode>* xdr, MutableHandleAtom atomp)
     uint32_t length = lengthAndEncoding >> 1;
     bool latin1 = lengthAndEncoding & 0x1;
 
-    JSContext* cx = xdr->cx();
+    ExclusiveContext* cx = xdr->cx();
     JSAtom* atom;
     if (latin1) {
         const Latin1Char* chars = reinterpret_cast<const Latin1Char*>(xdr->buf.read(length));
+        if (!chars)
+            return false;
         atom = AtomizeChars(cx, chars, length);
     } else {
 #if IS_LITTLE_ENDIAN
         /* Directly access the little endian chars in the XDR buffer. */
         const char16_t* chars = reinterpret_cast<const char16_t*>(xdr->buf.read(length * sizeof(char16_t)));
+        if (!chars)
+            return false;
         atom = AtomizeChars(cx, chars, length);
 #else
         /*
@@ -593,8 +655,10 @@ js::XDRAtom(XDRState<mode>* xdr, MutableHandleAtom atomp)
                 return false;
         }
 
-        JS_ALWAYS_TRUE(xdr->codeChars(chars, length));
-        atom = AtomizeChars(cx, chars, length);
+        if (xdr->codeChars(chars, length))
+            atom = AtomizeChars(cx, chars, length);
+        else
+            atom = nullptr;
         if (chars != stackChars)
             js_free(chars);
 #endif /* !IS_LITTLE_ENDIAN */
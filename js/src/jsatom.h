@@ -205,6 +205,15 @@ MarkPermanentAtoms(JSTracer* trc);
 void
 MarkWellKnownSymbols(JSTracer* trc);
 
+#ifdef OMR // Compaction
+/*
+ * Update the atoms tables and the runtime's pinned names after the OMR heap
+ * has been compacted. The root marking above traces most of these by value.
+ */
+void
+FixupAtomsAfterCompaction(JSTracer* trc, AutoLockForExclusiveAccess& lock);
+#endif // OMR Compaction
+
 /* N.B. must correspond to boolean tagging behavior. */
 enum PinningBehavior
 {
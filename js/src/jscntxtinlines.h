@@ -84,16 +84,8 @@ class CompartmentChecker
     }
 
     void check(JSString* str) {
-#ifdef OMR
-        // OMRTODO: Obtain zone from context
-        // OMRTODO: What is checkZone, anyways?
-        if (!str->isAtom()) {
-            checkZone(gc::OmrGcHelper::zone);
-        }
-#else // OMR
         if (!str->isAtom())
             checkZone(str->zone());
-#endif // ! OMR
     }
 
     void check(const js::Value& v) {
@@ -8,6 +8,7 @@
 
 #include "mozilla/DebugOnly.h"
 #include "mozilla/MemoryReporting.h"
+#include "mozilla/Pair.h"
 
 #include "jscntxt.h"
 #include "jsfriendapi.h"
@@ -858,6 +859,72 @@ JSCompartment::fixupAfterMovingGC()
     fixupScriptMapsAfterMovingGC();
 }
 
+#ifdef OMR // Compaction
+void
+JSCompartment::fixupAfterCompaction(JSTracer* trc)
+{
+    purge();
+
+    if (global_.unbarrieredGet())
+        TraceRoot(trc, global_.unsafeUnbarrieredForTracing(), "compartment global");
+    if (selfHostingScriptSource.unbarrieredGet())
+        TraceRoot(trc, selfHostingScriptSource.unsafeUnbarrieredForTracing(), "self-hosting script source");
+    if (mappedArgumentsTemplate_)
+        TraceEdge(trc, &mappedArgumentsTemplate_, "mapped arguments template");
+    if (unmappedArgumentsTemplate_)
+        TraceEdge(trc, &unmappedArgumentsTemplate_, "unmapped arguments template");
+
+    if (jitCompartment_)
+        jitCompartment_->fixupAfterCompaction(trc);
+
+    AutoEnterOOMUnsafeRegion oomUnsafe;
+
+    // Wrappers are keyed by the address of their referent. A cell may have
+    // moved to the old address of another, so the map is rebuilt.
+    using WrapperEntry = mozilla::Pair<CrossCompartmentKey, Value>;
+    Vector<WrapperEntry, 0, SystemAllocPolicy> wrappers;
+    if (!wrappers.reserve(crossCompartmentWrappers.count()))
+        oomUnsafe.crash("JSCompartment::fixupAfterCompaction");
+    for (WrapperMap::Enum e(crossCompartmentWrappers); !e.empty(); e.popFront()) {
+        e.front().mutableKey().trace(trc);
+        TraceManuallyBarrieredEdge(trc, e.front().value().unsafeUnbarrieredForTracing(),
+                                   "cross-compartment wrapper");
+        wrappers.infallibleAppend(WrapperEntry(e.front().key(), e.front().value().unbarrieredGet()));
+    }
+    crossCompartmentWrappers.clear();
+    for (const WrapperEntry& wrapper : wrappers) {
+        if (!crossCompartmentWrappers.put(wrapper.first(), wrapper.second()))
+            oomUnsafe.crash("JSCompartment::fixupAfterCompaction");
+    }
+
+    // The global's trace hook may have updated these entries in place
+    // already; the compaction tracer skips locations it has seen.
+    if (varNames_.initialized()) {
+        Vector<JSAtom*, 0, SystemAllocPolicy> names;
+        if (!names.reserve(varNames_.count()))
+            oomUnsafe.crash("JSCompartment::fixupAfterCompaction");
+        for (decltype(varNames_)::Enum e(varNames_); !e.empty(); e.popFront()) {
+            TraceManuallyBarrieredEdge(trc, &e.mutableFront(), "var name");
+            names.infallibleAppend(e.front());
+        }
+        varNames_.clear();
+        for (JSAtom* name : names)
+            varNames_.putNewInfallible(name);
+    }
+
+    regExps.fixupAfterCompaction(trc);
+    innerViews.fixupAfterCompaction(trc);
+
+    // These tables are caches keyed by address.
+    objectGroups.clearTables();
+    if (savedStacks_.initialized())
+        savedStacks_.clear();
+
+    // watchpointMap, scriptCountsMap and debugScriptMap are keyed by address
+    // too, but collections do not compact while they have entries.
+}
+#endif // OMR Compaction
+
 void
 JSCompartment::fixupGlobal()
 {
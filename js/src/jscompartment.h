@@ -650,6 +650,10 @@ struct JSCompartment
 
     static void fixupCrossCompartmentWrappersAfterMovingGC(JSTracer* trc);
     void fixupAfterMovingGC();
+#ifdef OMR // Compaction
+    // Update the compartment's tables after the OMR heap has been compacted.
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
     void fixupGlobal();
     void fixupScriptMapsAfterMovingGC();
 
@@ -558,7 +558,7 @@ js::XDRInterpretedFunction(XDRState<mode>* xdr, HandleScope enclosingScope,
     uint32_t firstword = 0;        /* bitmask of FirstWordFlag */
     uint32_t flagsword = 0;        /* word for argument count and fun->flags */
 
-    JSContext* cx = xdr->cx();
+    ExclusiveContext* cx = xdr->cx();
     RootedFunction fun(cx);
     RootedScript script(cx);
     Rooted<LazyScript*> lazy(cx);
@@ -567,8 +567,8 @@ js::XDRInterpretedFunction(XDRState<mode>* xdr, HandleScope enclosingScope,
         fun = objp;
         if (!fun->isInterpreted()) {
             JSAutoByteString funNameBytes;
-            if (const char* name = GetFunctionNameBytes(cx, fun, &funNameBytes)) {
-                JS_ReportErrorNumberLatin1(cx, GetErrorMessage, nullptr,
+            if (const char* name = GetFunctionNameBytes(cx->asJSContext(), fun, &funNameBytes)) {
+                JS_ReportErrorNumberLatin1(cx->asJSContext(), GetErrorMessage, nullptr,
                                            JSMSG_NOT_SCRIPTED_FUNCTION, name);
             }
             return false;
@@ -615,7 +615,11 @@ js::XDRInterpretedFunction(XDRState<mode>* xdr, HandleScope enclosingScope,
     if (mode == XDR_DECODE) {
         RootedObject proto(cx);
         if (firstword & IsStarGenerator) {
-            proto = GlobalObject::getOrCreateStarGeneratorFunctionPrototype(cx, cx->global());
+            // If we are off the main thread, the generator meta-objects have
+            // already been created by js::StartOffThreadDecodeScript, so cx
+            // will not be necessary.
+            JSContext* mainCx = cx->maybeJSContext();
+            proto = GlobalObject::getOrCreateStarGeneratorFunctionPrototype(mainCx, cx->global());
             if (!proto)
                 return false;
         }
@@ -204,6 +204,7 @@
 #include "jsobj.h"
 #include "jsprf.h"
 #include "jsscript.h"
+#include "jsstr.h"
 #include "jstypes.h"
 #include "jsutil.h"
 #include "jswatchpoint.h"
@@ -224,7 +225,9 @@
 #include "jit/JitcodeMap.h"
 #include "js/SliceBudget.h"
 #include "proxy/DeadObjectProxy.h"
+#include "threading/LockGuard.h"
 #include "vm/Debugger.h"
+#include "vm/HelperThreads.h"
 #include "vm/ProxyObject.h"
 #include "vm/Shape.h"
 #include "vm/SPSProfiler.h"
@@ -232,8 +235,13 @@
 #include "vm/Symbol.h"
 #include "vm/Time.h"
 #include "vm/TraceLogging.h"
+#include "vm/UnboxedObject.h"
 #include "vm/WrapperObject.h"
 
+#ifdef OMR // Sizes
+#include "sizeclasses.h"
+#endif // OMR Sizes
+
 #include "jsobjinlines.h"
 #include "jsscriptinlines.h"
 
@@ -270,6 +278,46 @@ const AllocKind gc::slotsToThingKind[] = {
  #undef EXPAND_THING_SIZE
  };
 
+#if defined(OMR_GC_SEGREGATED_HEAP)
+
+static constexpr uintptr_t SmallSizeClasses[] = SMALL_SIZECLASSES;
+
+static_assert(ArrayLength(SmallSizeClasses) == OMR_SIZECLASSES_NUM_SMALL + 1,
+              "SMALL_SIZECLASSES must list OMR_SIZECLASSES_NUM_SMALL sizes");
+
+// The size of the cells a thing of |size| bytes is allocated in.
+static constexpr uintptr_t
+SizeClassFor(size_t size, size_t index = OMR_SIZECLASSES_MIN_SMALL)
+{
+    return index > OMR_SIZECLASSES_MAX_SMALL
+           ? 0
+           : SmallSizeClasses[index] >= size
+             ? SmallSizeClasses[index]
+             : SizeClassFor(size, index + 1);
+}
+
+#define CHECK_THING_SIZE_CLASS(allocKind, traceKind, type, sizedType) \
+    static_assert(SizeClassFor(sizeof(sizedType)) != 0 && \
+                  SizeClassFor(sizeof(sizedType)) * 3 <= sizeof(sizedType) * 4, \
+                  "No size class fits AllocKind::" #allocKind " to within a quarter");
+FOR_EACH_ALLOCKIND(CHECK_THING_SIZE_CLASS)
+#undef CHECK_THING_SIZE_CLASS
+
+// OMR aligns every cell to 8 bytes.
+static constexpr uintptr_t
+AlignedCellSize(size_t size)
+{
+    return (size + 7) & ~uintptr_t(7);
+}
+
+#define CHECK_OBJECT_SIZE_CLASS(allocKind, traceKind, type, sizedType) \
+    static_assert(SizeClassFor(sizeof(sizedType)) == AlignedCellSize(sizeof(sizedType)), \
+                  "AllocKind::" #allocKind " needs a size class of its own");
+FOR_EACH_OBJECT_ALLOCKIND(CHECK_OBJECT_SIZE_CLASS)
+#undef CHECK_OBJECT_SIZE_CLASS
+
+#endif // OMR_GC_SEGREGATED_HEAP
+
 #else // OMR Sizes
 
  const uint32_t Arena::ThingSizes[] = {
@@ -373,6 +421,12 @@ GCRuntime::init(uint32_t maxbytes, uint32_t maxNurseryBytes)
     if (!rootsHash.init(256))
         return false;
 
+#ifdef OMR // Writebarriers
+    OmrGcHelper::runtime = this;
+    if (!storeBuffer.enable())
+        return false;
+#endif // OMR Writebarriers
+
     AutoLockGC lock(rt);
     return nursery.init(maxNurseryBytes, lock);
 }
@@ -380,18 +434,44 @@ GCRuntime::init(uint32_t maxbytes, uint32_t maxNurseryBytes)
 void
 GCRuntime::finish()
 {
+    // Helper threads keep their barrier buffers after the runtime is gone.
+    LockGuard<Mutex> guard(concurrentBarrierLock);
+    while (concurrentBarrierBuffers.popFirst()) {}
 }
 
 bool
 GCRuntime::setParameter(JSGCParamKey key, uint32_t value, AutoLockGC& lock)
 {
-    return true;
+    switch (key) {
+      case JSGC_CONCURRENT_MARK_ENABLED:
+        OmrGcHelper::setConcurrentMarkEnabled(value != 0);
+        return true;
+      case JSGC_FREQUENT_OBJECTS_ENABLED:
+        frequentObjectsEnabled = value != 0;
+        if (!frequentObjectsEnabled)
+            frequentObjects.clearAndFree();
+        return true;
+      case JSGC_COMPACTING_ENABLED:
+        compactingEnabled = value != 0;
+        return true;
+      default:
+        return true;
+    }
 }
 
 uint32_t
 GCRuntime::getParameter(JSGCParamKey key, const AutoLockGC& lock)
 {
-    return 0;
+    switch (key) {
+      case JSGC_CONCURRENT_MARK_ENABLED:
+        return OmrGcHelper::isConcurrentMarkEnabled();
+      case JSGC_FREQUENT_OBJECTS_ENABLED:
+        return frequentObjectsEnabled;
+      case JSGC_COMPACTING_ENABLED:
+        return compactingEnabled;
+      default:
+        return 0;
+    }
 }
 
 bool
@@ -539,12 +619,12 @@ GCMarker::delayMarkingChildren(const void* thing)
 AutoDisableCompactingGC::AutoDisableCompactingGC(JSContext* cx)
     : gc(cx->gc)
 {
-	gc.disable();
+    gc.disableCompactingGC();
 }
 
 AutoDisableCompactingGC::~AutoDisableCompactingGC()
 {
-	gc.enable();
+    gc.enableCompactingGC();
 }
 
 static const AllocKind AllocKindsToRelocate[] = {
@@ -1144,6 +1224,13 @@ js::PrepareForDebugGC(JSRuntime* rt)
 void
 GCRuntime::onOutOfMallocMemory()
 {
+    // This may be called off the main thread, so only ask for a shrinking
+    // collection at the next interrupt check.
+    shrinkRequested = true;
+    rt->requestInterrupt(JSRuntime::RequestInterruptCanWait);
+
+    // The recycled LifoAlloc chunks can be given back right away.
+    ReleaseLifoChunkPool();
 }
 
 void
@@ -1154,7 +1241,33 @@ GCRuntime::minorGC(JS::gcreason::Reason reason, gcstats::Phase phase)
 bool
 GCRuntime::gcIfRequested()
 {
-    return false;
+    if (!shrinkRequested)
+        return false;
+
+    shrinkRequested = false;
+    gc(GC_SHRINK, JS::gcreason::MEM_PRESSURE);
+    return true;
+}
+
+void
+GCRuntime::gc(JSGCInvocationKind gckind, JS::gcreason::Reason reason)
+{
+    // Collections are suppressed while any AutoSuppressGC is live.
+    if (enabled != 0)
+        return;
+
+    // Off thread Ion compilations hold unbarriered pointers to cells, which
+    // a compacting collection would leave dangling.
+    if (gckind == GC_SHRINK) {
+        CancelOffThreadIonCompile(rt);
+        ReleaseLifoChunkPool();
+    }
+
+    shrinkingGC = gckind == GC_SHRINK;
+    stats.prepareSlice(gckind, reason);
+    Nursery::collectHeap(shrinkingGC);
+    stats.prepareSlice(GC_NORMAL, JS::gcreason::NO_REASON);
+    shrinkingGC = false;
 }
 
 void
@@ -1162,6 +1275,12 @@ js::gc::FinishGC(JSContext* cx)
 {
 }
 
+bool
+ZonesIter::atAtomsZone(JSRuntime* rt)
+{
+    return rt->isAtomsZone(*it);
+}
+
 AutoPrepareForTracing::AutoPrepareForTracing(JSContext* cx, ZoneSelector selector)
 {
     session_.emplace(cx);
@@ -1175,12 +1294,18 @@ js::NewCompartment(JSContext* cx, Zone* zone, JSPrincipals* principals,
     ScopedJSDeletePtr<Zone> zoneHolder;
 
     if (!zone) {
-        zone = *rt->gc.zones.begin();
+        zone = cx->new_<Zone>(rt);
+        if (!zone)
+            return nullptr;
+
         zoneHolder.reset(zone);
-#ifdef OMR
-        // OMRTODO: Use multiple zones from a context correctly.
-        OmrGcHelper::zone = zone;
-#endif
+
+        const JSPrincipals* trusted = rt->trustedPrincipals();
+        bool isSystem = principals && principals == trusted;
+        if (!zone->init(isSystem)) {
+            ReportOutOfMemory(cx);
+            return nullptr;
+        }
     }
     ScopedJSDeletePtr<JSCompartment> compartment(cx->new_<JSCompartment>(zone, options));
     if (!compartment || !compartment->init(cx))
@@ -1205,9 +1330,82 @@ js::NewCompartment(JSContext* cx, Zone* zone, JSPrincipals* principals,
     return compartment.forget();
 }
 
+typedef Vector<Cell*, 0, SystemAllocPolicy> CellVector;
+
+static void
+AppendCell(Cell* cell, void* data)
+{
+    AutoEnterOOMUnsafeRegion oomUnsafe;
+    if (!static_cast<CellVector*>(data)->append(cell))
+        oomUnsafe.crash("MergeCompartments");
+}
+
 void
 gc::MergeCompartments(JSCompartment* source, JSCompartment* target)
 {
+    // The source compartment must be specifically flagged as mergable.  This
+    // also implies that the compartment is not visible to the debugger.
+    MOZ_ASSERT(source->creationOptions().mergeable());
+    MOZ_ASSERT(source->creationOptions().invisibleToDebugger());
+
+    MOZ_ASSERT(source->creationOptions().addonIdOrNull() ==
+               target->creationOptions().addonIdOrNull());
+
+    // The source should be the only compartment in its zone.
+    MOZ_ASSERT(source->zone()->compartments.length() == 1);
+
+    source->clearTables();
+    source->zone()->clearTables();
+    source->unsetIsDebuggee();
+
+    // The delazification flag indicates the presence of LazyScripts in a
+    // compartment for the Debugger API, so if the source compartment created
+    // LazyScripts, the flag must be propagated to the target compartment.
+    if (source->needsDelazificationForDebugger())
+        target->scheduleDelazificationForDebugger();
+
+    // The source zone's cells are interleaved with everyone else's in the OMR
+    // heap, so there are no arenas to hand over. Instead each cell is moved
+    // to the target zone by rewriting the zone index in its header.
+    CellVector cells;
+    OmrGcHelper::forEachCellInZone(source->zone(), AppendCell, &cells);
+
+    // Fixup compartment pointers in source to refer to target, and make sure
+    // type information generations are in sync.
+    for (Cell* cell : cells) {
+        if (!cell->isOmrBuffer()) {
+            switch (cell->getAllocKind()) {
+              case AllocKind::SCRIPT: {
+                JSScript* script = static_cast<JSScript*>(cell);
+                MOZ_ASSERT(script->compartment() == source);
+                script->compartment_ = target;
+                script->setTypesGeneration(target->zone()->types.generation);
+                break;
+              }
+              case AllocKind::OBJECT_GROUP: {
+                ObjectGroup* group = static_cast<ObjectGroup*>(cell);
+                group->setGeneration(target->zone()->types.generation);
+                group->compartment_ = target;
+
+                // Remove any unboxed layouts from the list in the off thread
+                // compartment. These do not need to be reinserted in the target
+                // compartment's list, as the list is not required to be complete.
+                if (UnboxedLayout* layout = group->maybeUnboxedLayoutDontCheckGeneration())
+                    layout->detachFromCompartment();
+                break;
+              }
+              default:
+                break;
+            }
+        }
+        cell->setOmrZoneIndex(target->zone()->omrIndex);
+    }
+
+    // The zones' usage is recounted by the next collection.
+
+    // Merge other info in source's zone into target's zone.
+    target->zone()->types.typeLifoAlloc.transferFrom(&source->zone()->types.typeLifoAlloc);
+    target->zone()->adoptUniqueIds(source->zone());
 }
 
 void
@@ -1410,6 +1608,14 @@ JS::SkipZoneForGC(Zone* zone)
 JS_PUBLIC_API(void)
 JS::GCForReason(JSContext* cx, JSGCInvocationKind gckind, gcreason::Reason reason)
 {
+    MOZ_ASSERT(gckind == GC_NORMAL || gckind == GC_SHRINK);
+    cx->gc.gc(gckind, reason);
+}
+
+JS_PUBLIC_API(void)
+JS::ShrinkGCBuffers(JSContext* cx)
+{
+    cx->gc.gc(GC_SHRINK, gcreason::API);
 }
 
 JS_PUBLIC_API(void)
@@ -1432,16 +1638,32 @@ JS::AbortIncrementalGC(JSContext* cx)
 {
 }
 
+static char16_t*
+InflateGCMessage(UniqueChars cstr)
+{
+    if (!cstr)
+        return nullptr;
+
+    size_t nchars = strlen(cstr.get());
+    UniqueTwoByteChars out(js_pod_malloc<char16_t>(nchars + 1));
+    if (!out)
+        return nullptr;
+    out.get()[nchars] = 0;
+
+    CopyAndInflateChars(out.get(), cstr.get(), nchars);
+    return out.release();
+}
+
 char16_t*
 JS::GCDescription::formatSliceMessage(JSContext* cx) const
 {
-    return nullptr;
+    return InflateGCMessage(cx->gc.stats.formatCompactSliceMessage());
 }
 
 char16_t*
 JS::GCDescription::formatSummaryMessage(JSContext* cx) const
 {
-    return nullptr;
+    return InflateGCMessage(cx->gc.stats.formatCompactSummaryMessage());
 }
 
 JS::dbg::GarbageCollectionEvent::Ptr
@@ -1453,13 +1675,13 @@ JS::GCDescription::toGCEvent(JSContext* cx) const
 char16_t*
 JS::GCDescription::formatJSON(JSContext* cx, uint64_t timestamp) const
 {
-    return nullptr;
+    return InflateGCMessage(cx->gc.stats.formatJsonMessage(timestamp));
 }
 
 JS_PUBLIC_API(JS::GCSliceCallback)
 JS::SetGCSliceCallback(JSContext* cx, GCSliceCallback callback)
 {
-    return nullptr;
+    return cx->gc.stats.setSliceCallback(callback);
 }
 
 JS_PUBLIC_API(JS::DoCycleCollectionCallback)
@@ -1471,7 +1693,7 @@ JS::SetDoCycleCollectionCallback(JSContext* cx, JS::DoCycleCollectionCallback ca
 JS_PUBLIC_API(JS::GCNurseryCollectionCallback)
 JS::SetGCNurseryCollectionCallback(JSContext* cx, GCNurseryCollectionCallback callback)
 {
-    return nullptr;
+    return cx->gc.stats.setNurseryCollectionCallback(callback);
 }
 
 JS_PUBLIC_API(void)
@@ -1655,8 +1877,42 @@ AutoEmptyNursery::AutoEmptyNursery(JSRuntime *rt)
 
 // OMR GC Helper
 #ifdef OMR
-Zone* OmrGcHelper::zone;
+Zone** OmrGcHelper::zoneTable;
 GCRuntime* OmrGcHelper::runtime;
+uintptr_t OmrGcHelper::newSpaceBase;
+uintptr_t OmrGcHelper::newSpaceSize;
+uintptr_t OmrGcHelper::heapBase;
+uintptr_t OmrGcHelper::heapSize;
+bool OmrGcHelper::concurrentMarking;
+
+/* static */ bool
+OmrGcHelper::registerZone(Zone* zone, uint32_t* indexp)
+{
+    // Zones are created and destroyed on the main thread, so only the GC's
+    // readers race with this and they never look at a free slot.
+    if (!zoneTable) {
+        zoneTable = js_pod_calloc<Zone*>(Cell::OmrMaxZones);
+        if (!zoneTable)
+            return false;
+    }
+
+    // Take the lowest free slot, so the atoms zone, created first, gets 0.
+    for (uint32_t i = 0; i < Cell::OmrMaxZones; i++) {
+        if (!zoneTable[i]) {
+            zoneTable[i] = zone;
+            *indexp = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* static */ void
+OmrGcHelper::unregisterZone(uint32_t index)
+{
+    MOZ_ASSERT(zoneTable[index]);
+    zoneTable[index] = nullptr;
+}
 #endif // OMR
 
 } /* namespace gc */
@@ -228,18 +228,14 @@ class GCZonesIter
     ZonesIter zone;
 
   public:
-    explicit GCZonesIter(JSRuntime* rt, ZoneSelector selector = WithAtoms) : zone(rt, selector) {
-        if (!zone->isCollecting())
-            next();
-    }
+    // OMR collects the whole heap, so every zone takes part in each GC.
+    explicit GCZonesIter(JSRuntime* rt, ZoneSelector selector = WithAtoms) : zone(rt, selector) {}
 
     bool done() const { return zone.done(); }
 
     void next() {
         MOZ_ASSERT(!done());
-        do {
-            zone.next();
-        } while (!zone.done());
+        zone.next();
     }
 
     JS::Zone* get() const {
@@ -253,26 +249,27 @@ class GCZonesIter
 
 typedef CompartmentsIterT<GCZonesIter> GCCompartmentsIter;
 
-/* Iterates over all zones in the current zone group. */
+/*
+ * Iterates over all zones in the current zone group. With OMR all zones are
+ * swept together, as a single group.
+ */
 class GCZoneGroupIter {
   private:
-    JS::Zone* current;
+    ZonesIter zone;
 
   public:
-    explicit GCZoneGroupIter(JSRuntime* rt) {
-        current = rt->gc.getCurrentZoneGroup();
-    }
+    explicit GCZoneGroupIter(JSRuntime* rt) : zone(rt, WithAtoms) {}
 
-    bool done() const { return !current; }
+    bool done() const { return zone.done(); }
 
     void next() {
         MOZ_ASSERT(!done());
-        current = current->nextNodeInGroup();
+        zone.next();
     }
 
     JS::Zone* get() const {
         MOZ_ASSERT(!done());
-        return current;
+        return zone;
     }
 
     operator JS::Zone*() const { return get(); }
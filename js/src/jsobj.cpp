@@ -1378,7 +1378,7 @@ js::XDRObjectLiteral(XDRState<mode>* xdr, MutableHandleObject obj)
 {
     /* NB: Keep this in sync with DeepCloneObjectLiteral. */
 
-    JSContext* cx = xdr->cx();
+    ExclusiveContext* cx = xdr->cx();
     MOZ_ASSERT_IF(mode == XDR_ENCODE && obj->isSingleton(),
                   cx->compartment()->behaviors().getSingletonsAsTemplates());
 
@@ -1402,8 +1402,11 @@ js::XDRObjectLiteral(XDRState<mode>* xdr, MutableHandleObject obj)
 
     if (isArray) {
         Rooted<GCVector<Value>> values(cx, GCVector<Value>(cx));
-        if (mode == XDR_ENCODE && !GetScriptArrayObjectElements(cx, obj, &values))
+        if (mode == XDR_ENCODE &&
+            !GetScriptArrayObjectElements(cx->asJSContext(), obj, &values))
+        {
             return false;
+        }
 
         uint32_t initialized;
         if (mode == XDR_ENCODE)
@@ -1441,8 +1444,11 @@ js::XDRObjectLiteral(XDRState<mode>* xdr, MutableHandleObject obj)
 
     // Code the properties in the object.
     Rooted<IdValueVector> properties(cx, IdValueVector(cx));
-    if (mode == XDR_ENCODE && !GetScriptPlainObjectProperties(cx, obj, &properties))
+    if (mode == XDR_ENCODE &&
+        !GetScriptPlainObjectProperties(cx->asJSContext(), obj, &properties))
+    {
         return false;
+    }
 
     uint32_t nproperties = properties.length();
     if (!xdr->codeUint32(&nproperties))
@@ -1513,7 +1519,7 @@ NativeObject::fillInAfterSwap(JSContext* cx, const Vector<Value>& values, void*
         MOZ_ASSERT(!priv);
 
     if (slots_) {
-        js_free(slots_);
+        gc::OmrGcHelper::freeObjectBuffer(slots_);
         slots_ = nullptr;
     }
 
@@ -3753,12 +3759,17 @@ JSObject::allocKindForTenure(const js::Nursery& nursery) const
 void
 JSObject::addSizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf, JS::ClassInfo* info)
 {
-    if (is<NativeObject>() && as<NativeObject>().hasDynamicSlots())
+    // Slots and elements in the OMR heap are counted with the GC heap.
+    if (is<NativeObject>() && as<NativeObject>().hasDynamicSlots() &&
+        !gc::OmrGcHelper::isInHeap(as<NativeObject>().slots_))
+    {
         info->objectsMallocHeapSlots += mallocSizeOf(as<NativeObject>().slots_);
+    }
 
     if (is<NativeObject>() && as<NativeObject>().hasDynamicElements()) {
         js::ObjectElements* elements = as<NativeObject>().getElementsHeader();
-        if (!elements->isCopyOnWrite() || elements->ownerObject() == this)
+        if (!gc::OmrGcHelper::isInHeap(elements) &&
+            (!elements->isCopyOnWrite() || elements->ownerObject() == this))
             info->objectsMallocHeapElementsNormal += mallocSizeOf(elements);
     }
 
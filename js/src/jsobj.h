@@ -650,6 +650,8 @@ JSObject::readBarrier(JSObject* obj)
     MOZ_ASSERT_IF(obj, !isNullLike(obj));
     if (obj && obj->isTenured())
         obj->asTenured().readBarrier(&obj->asTenured());
+#else // !OMR
+    js::gc::TenuredCell::readBarrier(reinterpret_cast<js::gc::TenuredCell*>(obj));
 #endif // !OMR
 }
 
@@ -660,6 +662,8 @@ JSObject::writeBarrierPre(JSObject* obj)
     MOZ_ASSERT_IF(obj, !isNullLike(obj));
     if (obj && obj->isTenured())
         obj->asTenured().writeBarrierPre(&obj->asTenured());
+#else // OMR
+    js::gc::TenuredCell::writeBarrierPre(reinterpret_cast<js::gc::TenuredCell*>(obj));
 #endif // OMR
 }
 
@@ -687,6 +691,9 @@ JSObject::writeBarrierPost(void* cellp, JSObject* prev, JSObject* next)
     // Remove the prev entry if the new value does not need it.
     if (prev && (buffer = prev->storeBuffer()))
         buffer->unputCell(static_cast<js::gc::Cell**>(cellp));
+#else // ! OMR
+    js::gc::TenuredCell::writeBarrierPost(cellp, reinterpret_cast<js::gc::TenuredCell*>(prev),
+                                          reinterpret_cast<js::gc::TenuredCell*>(next));
 #endif // OMR
 }
 
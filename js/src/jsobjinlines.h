@@ -89,12 +89,14 @@ JSObject::finalize(js::FreeOp* fop)
     if (!nobj)
         return;
 
-    if (nobj->hasDynamicSlots())
+    if (nobj->hasDynamicSlots() && !js::gc::OmrGcHelper::isInHeap(nobj->slots_))
         fop->free_(nobj->slots_);
 
     if (nobj->hasDynamicElements()) {
         js::ObjectElements* elements = nobj->getElementsHeader();
-        if (elements->isCopyOnWrite()) {
+        if (js::gc::OmrGcHelper::isInHeap(elements)) {
+            // Reclaimed by the collector along with this object.
+        } else if (elements->isCopyOnWrite()) {
             if (elements->ownerObject() == this) {
                 // Don't free the elements until object finalization finishes,
                 // so that other objects can access these elements while they
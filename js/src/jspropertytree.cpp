@@ -315,6 +315,60 @@ Shape::fixupAfterMovingGC()
         fixupShapeTreeAfterMovingGC();
 }
 
+#ifdef OMR // Compaction
+void
+Shape::fixupAfterCompaction(JSTracer* trc)
+{
+    traceChildren(trc);
+
+    if (!inDictionary() || !listp)
+        return;
+
+    // As in fixupDictionaryShapeAfterMovingGC, listp points into the next
+    // shape unless this is the last property. The owner is found from the
+    // stale listp and forwarded through a local copy.
+    if (!base()->isOwned()) {
+        Shape* next = reinterpret_cast<Shape*>(uintptr_t(listp) - offsetof(Shape, parent));
+        TraceManuallyBarrieredEdge(trc, &next, "dictionary shape list");
+        listp = &next->parent;
+    } else {
+        // The object has not been fixed up yet, so its class cannot be read.
+        JSObject* last = reinterpret_cast<JSObject*>(uintptr_t(listp) - ShapedObject::offsetOfShape());
+        TraceManuallyBarrieredEdge(trc, &last, "dictionary shape list");
+        listp = reinterpret_cast<GCPtrShape*>(uintptr_t(last) + ShapedObject::offsetOfShape());
+    }
+}
+
+void
+Shape::fixupKidsAfterCompaction(JSTracer* trc)
+{
+    if (inDictionary() || kids.isNull())
+        return;
+
+    if (kids.isShape()) {
+        Shape* kid = kids.toShape();
+        TraceManuallyBarrieredEdge(trc, &kid, "shape kid");
+        kids.setShape(kid);
+        return;
+    }
+
+    KidsHash* kh = kids.toHash();
+    Vector<Shape*, 0, SystemAllocPolicy> children;
+    AutoEnterOOMUnsafeRegion oomUnsafe;
+    if (!children.reserve(kh->count()))
+        oomUnsafe.crash("Shape::fixupKidsAfterCompaction");
+    for (KidsHash::Range r = kh->all(); !r.empty(); r.popFront()) {
+        Shape* kid = r.front();
+        TraceManuallyBarrieredEdge(trc, &kid, "shape kid");
+        children.infallibleAppend(kid);
+    }
+
+    kh->clear();
+    for (Shape* kid : children)
+        kh->putNewInfallible(StackShape(kid), kid);
+}
+#endif // OMR Compaction
+
 void
 Shape::fixupGetterSetterForBarrier(JSTracer* trc)
 {
@@ -65,6 +65,7 @@ using namespace js::gc;
 using namespace js::frontend;
 
 using mozilla::AsVariant;
+using mozilla::Maybe;
 using mozilla::PodCopy;
 using mozilla::PodZero;
 using mozilla::RotateLeft;
@@ -73,7 +74,7 @@ template<XDRMode mode>
 bool
 js::XDRScriptConst(XDRState<mode>* xdr, MutableHandleValue vp)
 {
-    JSContext* cx = xdr->cx();
+    ExclusiveContext* cx = xdr->cx();
 
     /*
      * A script constant can be an arbitrary primitive value as they are used
@@ -197,7 +198,7 @@ template<XDRMode mode>
 static bool
 XDRLazyClosedOverBindings(XDRState<mode>* xdr, MutableHandle<LazyScript*> lazy)
 {
-    JSContext* cx = xdr->cx();
+    ExclusiveContext* cx = xdr->cx();
     RootedAtom atom(cx);
     for (size_t i = 0; i < lazy->numClosedOverBindings(); i++) {
         uint8_t endOfScopeSentinel;
@@ -230,7 +231,7 @@ XDRRelazificationInfo(XDRState<mode>* xdr, HandleFunction fun, HandleScript scri
     MOZ_ASSERT_IF(mode == XDR_ENCODE, script->isRelazifiable() && script->maybeLazyScript());
     MOZ_ASSERT_IF(mode == XDR_ENCODE, !lazy->numInnerFunctions());
 
-    JSContext* cx = xdr->cx();
+    ExclusiveContext* cx = xdr->cx();
 
     uint64_t packedFields;
     {
@@ -338,7 +339,7 @@ js::XDRScript(XDRState<mode>* xdr, HandleScope scriptEnclosingScope, HandleScrip
     uint32_t scriptBits = 0;
     uint32_t bodyScopeIndex = 0;
 
-    JSContext* cx = xdr->cx();
+    ExclusiveContext* cx = xdr->cx();
     RootedScript script(cx);
     natoms = nsrcnotes = 0;
     nconsts = nobjects = nscopes = nregexps = ntrynotes = nscopenotes = nyieldoffsets = 0;
@@ -358,7 +359,7 @@ js::XDRScript(XDRState<mode>* xdr, HandleScope scriptEnclosingScope, HandleScrip
             if (!comp->creationOptions().cloneSingletons() ||
                 !comp->behaviors().getSingletonsAsTemplates())
             {
-                JS_ReportErrorASCII(cx,
+                JS_ReportErrorASCII(cx->asJSContext(),
                                     "Can't serialize a run-once non-function script "
                                     "when we're not doing singleton cloning");
                 return false;
@@ -483,10 +484,17 @@ js::XDRScript(XDRState<mode>* xdr, HandleScope scriptEnclosingScope, HandleScrip
         JSVersion version_ = JSVersion(version);
         MOZ_ASSERT((version_ & VersionFlags::MASK) == unsigned(version_));
 
-        CompileOptions options(cx);
-        options.setVersion(version_)
-               .setNoScriptRval(!!(scriptBits & (1 << NoScriptRval)))
-               .setSelfHostingMode(!!(scriptBits & (1 << SelfHosted)));
+        // Off the main thread there is no JSContext to build default options
+        // from, so start from the options the decoder was given.
+        Maybe<CompileOptions> options;
+        if (xdr->hasOptions())
+            options.emplace(cx, xdr->options());
+        else
+            options.emplace(cx->asJSContext());
+        (*options).setVersion(version_)
+                  .setIsRunOnce(false)
+                  .setNoScriptRval(!!(scriptBits & (1 << NoScriptRval)))
+                  .setSelfHostingMode(!!(scriptBits & (1 << SelfHosted)));
         RootedScriptSource sourceObject(cx);
         if (scriptBits & (1 << OwnSource)) {
             ScriptSource* ss = cx->new_<ScriptSource>();
@@ -495,17 +503,29 @@ js::XDRScript(XDRState<mode>* xdr, HandleScope scriptEnclosingScope, HandleScrip
             ScriptSourceHolder ssHolder(ss);
 
             /*
-             * We use this CompileOptions only to initialize the
-             * ScriptSourceObject. Most CompileOptions fields aren't used by
-             * ScriptSourceObject, and those that are (element; elementAttributeName)
-             * aren't preserved by XDR. So this can be simple.
+             * We use these options only to initialize the ScriptSourceObject.
+             * Most CompileOptions fields aren't used by ScriptSourceObject, and
+             * those that are (element; elementAttributeName) aren't preserved
+             * by XDR. Off the main thread, the source object is initialized
+             * from the decoder's options once the script is finished.
              */
-            CompileOptions options(cx);
-            ss->initFromOptions(cx, options);
+            Maybe<CompileOptions> sourceOptions;
+            if (xdr->hasOptions())
+                sourceOptions.emplace(cx, xdr->options());
+            else
+                sourceOptions.emplace(cx->asJSContext());
+            ss->initFromOptions(cx, *sourceOptions);
             sourceObject = ScriptSourceObject::create(cx, ss);
-            if (!sourceObject ||
-                !ScriptSourceObject::initFromOptions(cx, sourceObject, options))
+            if (!sourceObject)
+                return false;
+            if (ScriptSourceObject** sourceObjectOut = xdr->sourceObjectOut()) {
+                MOZ_ASSERT(!*sourceObjectOut);
+                *sourceObjectOut = sourceObject;
+            } else if (!ScriptSourceObject::initFromOptions(cx->asJSContext(), sourceObject,
+                                                              *sourceOptions))
+            {
                 return false;
+            }
         } else {
             MOZ_ASSERT(enclosingScript);
             // When decoding, all the scripts and the script source object
@@ -515,7 +535,7 @@ js::XDRScript(XDRState<mode>* xdr, HandleScope scriptEnclosingScope, HandleScrip
             sourceObject = &enclosingScript->sourceObject()->as<ScriptSourceObject>();
         }
 
-        script = JSScript::Create(cx, options, sourceObject, 0, 0);
+        script = JSScript::Create(cx, *options, sourceObject, 0, 0);
         if (!script)
             return false;
 
@@ -795,7 +815,8 @@ js::XDRScript(XDRState<mode>* xdr, HandleScope scriptEnclosingScope, HandleScrip
                     funEnclosingScope = function->nonLazyScript()->enclosingScope();
                 } else {
                     MOZ_ASSERT(function->isAsmJSNative());
-                    JS_ReportErrorASCII(cx, "AsmJS modules are not yet supported in XDR serialization.");
+                    JS_ReportErrorASCII(cx->asJSContext(),
+                                        "AsmJS modules are not yet supported in XDR serialization.");
                     return false;
                 }
 
@@ -883,9 +904,12 @@ js::XDRScript(XDRState<mode>* xdr, HandleScope scriptEnclosingScope, HandleScrip
     if (mode == XDR_DECODE) {
         scriptp.set(script);
 
-        /* see BytecodeEmitter::tellDebuggerAboutCompiledScript */
-        if (!fun)
-            Debugger::onNewScript(cx, script);
+        /*
+         * See BytecodeEmitter::tellDebuggerAboutCompiledScript. Off the main
+         * thread, the debugger is told when the decoded script is finished.
+         */
+        if (!fun && cx->isJSContext())
+            Debugger::onNewScript(cx->asJSContext(), script);
     }
 
     return true;
@@ -904,7 +928,7 @@ bool
 js::XDRLazyScript(XDRState<mode>* xdr, HandleScope enclosingScope, HandleScript enclosingScript,
                   HandleFunction fun, MutableHandle<LazyScript*> lazy)
 {
-    JSContext* cx = xdr->cx();
+    ExclusiveContext* cx = xdr->cx();
 
     {
         uint32_t begin;
@@ -1801,7 +1825,7 @@ SourceCompressionTask::work()
 
     const char16_t* chars = ss->data.as<ScriptSource::Uncompressed>().string.chars();
     Compressor comp(reinterpret_cast<const unsigned char*>(chars),
-                    inputBytes);
+                    inputBytes, codec);
     if (!comp.init())
         return OOM;
 
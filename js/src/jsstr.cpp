@@ -9,6 +9,7 @@
 #include "mozilla/Attributes.h"
 #include "mozilla/Casting.h"
 #include "mozilla/CheckedInt.h"
+#include "mozilla/EndianUtils.h"
 #include "mozilla/FloatingPoint.h"
 #include "mozilla/PodOperations.h"
 #include "mozilla/Range.h"
@@ -19,6 +20,14 @@
 #include <limits>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define JS_STR_SSE2
+# include <emmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && MOZ_LITTLE_ENDIAN
+# define JS_STR_NEON
+# include <arm_neon.h>
+#endif
+
 #include "jsapi.h"
 #include "jsarray.h"
 #include "jsatom.h"
@@ -3399,6 +3408,101 @@ js::InflateString(ExclusiveContext* cx, const char* bytes, size_t* lengthp)
     return nullptr;
 }
 
+/*
+ * Flattening large ropes and creating strings from large buffers spend most
+ * of their time converting between Latin1 and TwoByte chars, so these loops
+ * handle 16 chars at a time when vector instructions are available at
+ * compile time, leaving the tail to the scalar loop.
+ */
+void
+js::InflateChars(char16_t* dst, const Latin1Char* src, size_t srclen)
+{
+    size_t i = 0;
+#if defined(JS_STR_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= srclen; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(bytes, zero));
+    }
+#elif defined(JS_STR_NEON)
+    for (; i + 16 <= srclen; i += 16) {
+        uint8x16_t bytes = vld1q_u8(src + i);
+        vst1q_u16(reinterpret_cast<uint16_t*>(dst + i), vmovl_u8(vget_low_u8(bytes)));
+        vst1q_u16(reinterpret_cast<uint16_t*>(dst + i + 8), vmovl_u8(vget_high_u8(bytes)));
+    }
+#endif
+    for (; i < srclen; i++)
+        dst[i] = src[i];
+}
+
+void
+js::DeflateChars(Latin1Char* dst, const char16_t* src, size_t srclen)
+{
+    size_t i = 0;
+#if defined(JS_STR_SSE2)
+    // packus saturates rather than truncates, so clear the high bytes first.
+    const __m128i lowBytes = _mm_set1_epi16(0xff);
+    for (; i + 16 <= srclen; i += 16) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+        lo = _mm_and_si128(lo, lowBytes);
+        hi = _mm_and_si128(hi, lowBytes);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(JS_STR_NEON)
+    for (; i + 16 <= srclen; i += 16) {
+        uint16x8_t lo = vld1q_u16(reinterpret_cast<const uint16_t*>(src + i));
+        uint16x8_t hi = vld1q_u16(reinterpret_cast<const uint16_t*>(src + i + 8));
+        vst1q_u8(dst + i, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+    }
+#endif
+    for (; i < srclen; i++)
+        dst[i] = Latin1Char(src[i]);
+}
+
+bool
+js::CharsFitLatin1(const char16_t* s, size_t length)
+{
+    size_t i = 0;
+#if defined(JS_STR_SSE2)
+    const __m128i highBytes = _mm_set1_epi16(int16_t(0xff00));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 8));
+        __m128i high = _mm_and_si128(_mm_or_si128(lo, hi), highBytes);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xffff)
+            return false;
+    }
+#elif defined(JS_STR_NEON)
+    for (; i + 16 <= length; i += 16) {
+        uint16x8_t lo = vld1q_u16(reinterpret_cast<const uint16_t*>(s + i));
+        uint16x8_t hi = vld1q_u16(reinterpret_cast<const uint16_t*>(s + i + 8));
+        uint8x8_t high = vshrn_n_u16(vorrq_u16(lo, hi), 8);
+        if (vget_lane_u64(vreinterpret_u64_u8(high), 0))
+            return false;
+    }
+#endif
+    for (; i < length; i++) {
+        if (s[i] > JSString::MAX_LATIN1_CHAR)
+            return false;
+    }
+    return true;
+}
+
+static void
+CopyAndDeflateChars(char* dst, const Latin1Char* src, size_t srclen)
+{
+    PodCopy(dst, reinterpret_cast<const char*>(src), srclen);
+}
+
+static void
+CopyAndDeflateChars(char* dst, const char16_t* src, size_t srclen)
+{
+    DeflateChars(reinterpret_cast<Latin1Char*>(dst), src, srclen);
+}
+
 template <typename CharT>
 bool
 js::DeflateStringToBuffer(JSContext* maybecx, const CharT* src, size_t srclen,
@@ -3406,8 +3510,7 @@ js::DeflateStringToBuffer(JSContext* maybecx, const CharT* src, size_t srclen,
 {
     size_t dstlen = *dstlenp;
     if (srclen > dstlen) {
-        for (size_t i = 0; i < dstlen; i++)
-            dst[i] = char(src[i]);
+        CopyAndDeflateChars(dst, src, dstlen);
         if (maybecx) {
             AutoSuppressGC suppress(maybecx);
             JS_ReportErrorNumberASCII(maybecx, GetErrorMessage, nullptr,
@@ -3415,8 +3518,7 @@ js::DeflateStringToBuffer(JSContext* maybecx, const CharT* src, size_t srclen,
         }
         return false;
     }
-    for (size_t i = 0; i < srclen; i++)
-        dst[i] = char(src[i]);
+    CopyAndDeflateChars(dst, src, srclen);
     *dstlenp = srclen;
     return true;
 }
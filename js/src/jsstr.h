@@ -294,9 +294,31 @@ CopyAndInflateChars(char16_t* dst, const char* src, size_t srclen)
         dst[i] = (unsigned char) src[i];
 }
 
+/*
+ * Bulk conversions between Latin1 and TwoByte chars. These process a vector
+ * register's worth of chars at a time where SSE2 or NEON is available.
+ *
+ * DeflateChars keeps only the low byte of each char, so callers must either
+ * know that all chars are Latin1 or want that truncation.
+ */
+extern void
+InflateChars(char16_t* dst, const JS::Latin1Char* src, size_t srclen);
+
+extern void
+DeflateChars(JS::Latin1Char* dst, const char16_t* src, size_t srclen);
+
+/* Whether every char in |s| is at most JSString::MAX_LATIN1_CHAR. */
+extern bool
+CharsFitLatin1(const char16_t* s, size_t length);
+
 inline void
 CopyAndInflateChars(char16_t* dst, const JS::Latin1Char* src, size_t srclen)
 {
+    // Most strings are short; don't leave the inline loop for them.
+    if (srclen >= 32) {
+        InflateChars(dst, src, srclen);
+        return;
+    }
     for (size_t i = 0; i < srclen; i++)
         dst[i] = src[i];
 }
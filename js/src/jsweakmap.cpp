@@ -57,12 +57,18 @@ WeakMapBase::markZoneIteratively(JS::Zone* zone, JSTracer* tracer)
 {
     bool markedAny = false;
     for (WeakMapBase* m : zone->gcWeakMapList) {
-        if (m->marked && m->traceEntries(tracer))
+        if (markIteratively(m, tracer))
             markedAny = true;
     }
     return markedAny;
 }
 
+bool
+WeakMapBase::markIteratively(WeakMapBase* map, JSTracer* tracer)
+{
+    return map->marked && map->traceEntries(tracer);
+}
+
 bool
 WeakMapBase::findInterZoneEdges(JS::Zone* zone)
 {
@@ -62,6 +62,10 @@ class WeakMapBase : public mozilla::LinkedListElement<WeakMapBase>
     // another pass. In other words, mark my marked maps' marked members' mid-collection.
     static bool markZoneIteratively(JS::Zone* zone, JSTracer* tracer);
 
+    // As markZoneIteratively, for one weak map, so that a parallel collector
+    // can share out the maps of a zone between its threads.
+    static bool markIteratively(WeakMapBase* map, JSTracer* tracer);
+
     // Add zone edges for weakmaps with key delegates in a different zone.
     static bool findInterZoneEdges(JS::Zone* zone);
 
@@ -137,7 +141,10 @@ class WeakMap : public HashMap<Key, Value, HashPolicy, RuntimeAllocPolicy>,
             return false;
         zone->gcWeakMapList.insertFront(this);
         JSRuntime* rt = zone->runtimeFromMainThread();
-        marked = JS::IsIncrementalGCInProgress(rt->contextFromMainThread());
+        // A map created while OMR marks concurrently may belong to an object
+        // that is allocated marked, and so is never traced in this cycle.
+        marked = JS::IsIncrementalGCInProgress(rt->contextFromMainThread()) ||
+                 gc::OmrGcHelper::isConcurrentMarking();
         return true;
     }
 
@@ -231,12 +238,7 @@ class WeakMap : public HashMap<Key, Value, HashPolicy, RuntimeAllocPolicy>,
     {
         GCMarker& marker = *static_cast<GCMarker*>(trc);
 
-#ifdef OMR // Zone
-        // OMRTODO: Get a real zone from a context passed through.
-        Zone* zone = gc::OmrGcHelper::zone; // use a single global zone
-#else // OMR Zone
         Zone* zone = key.asCell()->asTenured().zone();
-#endif // ! OMR Zone
 
         auto p = zone->gcWeakKeys.get(key);
         if (p) {
@@ -23,6 +23,7 @@
 # include <direct.h>
 # include <process.h>
 #endif
+#include <algorithm>
 #include <errno.h>
 #include <fcntl.h>
 #if defined(XP_WIN)
@@ -71,6 +72,7 @@
 #include "jit/InlinableNatives.h"
 #include "jit/Ion.h"
 #include "jit/JitcodeMap.h"
+#include "jit/JitCompartment.h"
 #include "jit/OptimizationTracking.h"
 #include "js/Debug.h"
 #include "js/GCAPI.h"
@@ -116,6 +118,7 @@ using mozilla::Nothing;
 using mozilla::NumberEqualsInt32;
 using mozilla::PodCopy;
 using mozilla::PodEqual;
+using mozilla::PodZero;
 using mozilla::TimeDuration;
 using mozilla::TimeStamp;
 
@@ -311,9 +314,12 @@ static bool enableBaseline = false;
 static bool enableIon = false;
 static bool enableAsmJS = false;
 static bool enableNativeRegExp = false;
+static bool enableSharedRegExpCache = false;
+static bool enableLZ4SourceCompression = false;
 static bool enableUnboxedArrays = false;
 static bool enableSharedMemory = SHARED_MEMORY_DEFAULT;
 static bool enableWasmAlwaysBaseline = false;
+static bool enableWasmTiering = false;
 #ifdef JS_GC_ZEAL
 static uint32_t gZealBits = 0;
 static uint32_t gZealFrequency = 0;
@@ -321,6 +327,7 @@ static uint32_t gZealFrequency = 0;
 static bool printTiming = false;
 static const char* jsCacheDir = nullptr;
 static const char* jsCacheAsmJSPath = nullptr;
+static const char* jsCacheWasmPath = nullptr;
 static RCFile* gErrFile = nullptr;
 static RCFile* gOutFile = nullptr;
 static bool reportWarnings = true;
@@ -3824,6 +3831,213 @@ Elapsed(JSContext* cx, unsigned argc, Value* vp)
     return false;
 }
 
+// Engine event totals, sampled around each benchmark() iteration.
+struct BenchmarkCounts
+{
+    uint64_t gcs;
+    jit::JitRuntime::EventCounts events;
+
+    static BenchmarkCounts now(JSContext* cx) {
+        BenchmarkCounts counts;
+        counts.gcs = cx->runtime()->gc.gcNumber();
+        if (cx->runtime()->hasJitRuntime())
+            counts.events = cx->runtime()->jitRuntime()->eventCounts();
+        else
+            PodZero(&counts.events);
+        return counts;
+    }
+
+    void add(const BenchmarkCounts& after, const BenchmarkCounts& before) {
+        gcs += after.gcs - before.gcs;
+        events.baselineCompiles += after.events.baselineCompiles - before.events.baselineCompiles;
+        events.ionCompiles += after.events.ionCompiles - before.events.ionCompiles;
+        events.bailouts += after.events.bailouts - before.events.bailouts;
+        events.icStubs += after.events.icStubs - before.events.icStubs;
+    }
+
+    bool define(JSContext* cx, HandleObject obj) const {
+        return JS_DefineProperty(cx, obj, "gcs", double(gcs), JSPROP_ENUMERATE) &&
+               JS_DefineProperty(cx, obj, "baselineCompiles", double(events.baselineCompiles),
+                                 JSPROP_ENUMERATE) &&
+               JS_DefineProperty(cx, obj, "ionCompiles", double(events.ionCompiles),
+                                 JSPROP_ENUMERATE) &&
+               JS_DefineProperty(cx, obj, "bailouts", double(events.bailouts), JSPROP_ENUMERATE) &&
+               JS_DefineProperty(cx, obj, "icStubs", double(events.icStubs), JSPROP_ENUMERATE);
+    }
+};
+
+static bool
+GetBenchmarkOption(JSContext* cx, HandleObject options, const char* name, uint32_t min,
+                   uint32_t* result)
+{
+    if (!options)
+        return true;
+
+    RootedValue v(cx);
+    if (!JS_GetProperty(cx, options, name, &v))
+        return false;
+    if (v.isUndefined())
+        return true;
+
+    double d;
+    if (!ToNumber(cx, v, &d))
+        return false;
+    if (!(d >= min && d <= UINT32_MAX)) {
+        JS_ReportErrorASCII(cx, "benchmark: option '%s' must be an integer of at least %u",
+                            name, min);
+        return false;
+    }
+    *result = uint32_t(d);
+    return true;
+}
+
+static double
+SortedMedian(const Vector<double, 0, SystemAllocPolicy>& sorted)
+{
+    size_t n = sorted.length();
+    return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+}
+
+static bool
+Benchmark(JSContext* cx, unsigned argc, Value* vp)
+{
+    CallArgs args = CallArgsFromVp(argc, vp);
+    RootedObject callee(cx, &args.callee());
+
+    if (args.length() < 1 || args.length() > 2) {
+        ReportUsageErrorASCII(cx, callee, "Wrong number of arguments");
+        return false;
+    }
+    if (!IsCallable(args[0])) {
+        ReportUsageErrorASCII(cx, callee, "First argument must be a function");
+        return false;
+    }
+    RootedObject options(cx);
+    if (args.length() > 1 && !args[1].isUndefined()) {
+        if (!args[1].isObject()) {
+            ReportUsageErrorASCII(cx, callee, "Second argument must be an options object");
+            return false;
+        }
+        options = &args[1].toObject();
+    }
+
+    uint32_t warmup = 10;
+    uint32_t iterations = 50;
+    uint32_t inner = 1;
+    if (!GetBenchmarkOption(cx, options, "warmup", 0, &warmup) ||
+        !GetBenchmarkOption(cx, options, "iterations", 1, &iterations) ||
+        !GetBenchmarkOption(cx, options, "inner", 1, &inner))
+    {
+        return false;
+    }
+
+    RootedValue fun(cx, args[0]);
+    RootedValue rval(cx);
+    for (uint32_t i = 0; i < warmup; i++) {
+        if (!JS::Call(cx, UndefinedHandleValue, fun, JS::HandleValueArray::empty(), &rval))
+            return false;
+    }
+
+    RootedObject samples(cx, JS_NewArrayObject(cx, iterations));
+    if (!samples)
+        return false;
+
+    Vector<double, 0, SystemAllocPolicy> times;
+    if (!times.reserve(iterations)) {
+        JS_ReportOutOfMemory(cx);
+        return false;
+    }
+
+    BenchmarkCounts total;
+    PodZero(&total);
+    for (uint32_t i = 0; i < iterations; i++) {
+        BenchmarkCounts before = BenchmarkCounts::now(cx);
+        TimeStamp start = TimeStamp::Now();
+        for (uint32_t j = 0; j < inner; j++) {
+            if (!JS::Call(cx, UndefinedHandleValue, fun, JS::HandleValueArray::empty(), &rval))
+                return false;
+        }
+        double ms = (TimeStamp::Now() - start).ToMilliseconds() / inner;
+        BenchmarkCounts after = BenchmarkCounts::now(cx);
+
+        BenchmarkCounts delta;
+        PodZero(&delta);
+        delta.add(after, before);
+        total.add(after, before);
+        times.infallibleAppend(ms);
+
+        RootedObject sample(cx, JS_NewPlainObject(cx));
+        if (!sample ||
+            !JS_DefineProperty(cx, sample, "time", ms, JSPROP_ENUMERATE) ||
+            !delta.define(cx, sample) ||
+            !JS_DefineElement(cx, samples, i, sample, JSPROP_ENUMERATE))
+        {
+            return false;
+        }
+    }
+
+    // Summarize the times with statistics that a few slow iterations (a GC,
+    // a compilation) cannot skew: the median, the median absolute deviation,
+    // and the mean of the times within three scaled MADs of the median.
+    Vector<double, 0, SystemAllocPolicy> sorted;
+    Vector<double, 0, SystemAllocPolicy> deviations;
+    if (!sorted.appendAll(times) || !deviations.reserve(iterations)) {
+        JS_ReportOutOfMemory(cx);
+        return false;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    double median = SortedMedian(sorted);
+    double sum = 0;
+    for (double t : times) {
+        sum += t;
+        deviations.infallibleAppend(fabs(t - median));
+    }
+    std::sort(deviations.begin(), deviations.end());
+    double mad = SortedMedian(deviations);
+
+    double bound = 3 * 1.4826 * mad;
+    double robustSum = 0;
+    uint32_t kept = 0;
+    for (double t : times) {
+        if (fabs(t - median) <= bound) {
+            robustSum += t;
+            kept++;
+        }
+    }
+
+    RootedObject time(cx, JS_NewPlainObject(cx));
+    if (!time ||
+        !JS_DefineProperty(cx, time, "min", sorted[0], JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, time, "max", sorted.back(), JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, time, "mean", sum / iterations, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, time, "median", median, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, time, "mad", mad, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, time, "robustMean", robustSum / kept, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, time, "outliers", double(iterations - kept), JSPROP_ENUMERATE))
+    {
+        return false;
+    }
+
+    RootedObject counters(cx, JS_NewPlainObject(cx));
+    if (!counters || !total.define(cx, counters))
+        return false;
+
+    RootedObject result(cx, JS_NewPlainObject(cx));
+    if (!result ||
+        !JS_DefineProperty(cx, result, "warmup", double(warmup), JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, result, "iterations", double(iterations), JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, result, "inner", double(inner), JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, result, "time", time, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, result, "counters", counters, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, result, "samples", samples, JSPROP_ENUMERATE))
+    {
+        return false;
+    }
+
+    args.rval().setObject(*result);
+    return true;
+}
+
 static bool
 Compile(JSContext* cx, unsigned argc, Value* vp)
 {
@@ -5874,6 +6088,15 @@ static const JSFunctionSpecWithHelp shell_functions[] = {
 "elapsed()",
 "  Execution time elapsed for the current thread."),
 
+    JS_FN_HELP("benchmark", Benchmark, 2, 0,
+"benchmark(fun, [options])",
+"  Call |fun| options.warmup times (default 10), then time options.iterations\n"
+"  (default 50) iterations of options.inner calls (default 1). Returns an\n"
+"  object with the per-call times in milliseconds summarized as min, max,\n"
+"  mean, median, median absolute deviation and a mean without outliers, the\n"
+"  per-iteration samples, and the GCs, Baseline and Ion compilations,\n"
+"  bailouts and IC stubs counted during the timed iterations."),
+
     JS_FN_HELP("decompileFunction", DecompileFunction, 1, 0,
 "decompileFunction(func)",
 "  Decompile a function."),
@@ -6713,14 +6936,13 @@ class ScopedFileDesc
 static const uint32_t asmJSCacheCookie = 0xabbadaba;
 
 static bool
-ShellOpenAsmJSCacheEntryForRead(HandleObject global, const char16_t* begin, const char16_t* limit,
-                                size_t* serializedSizeOut, const uint8_t** memoryOut,
-                                intptr_t* handleOut)
+ShellOpenCacheEntryForRead(const char* path, size_t* serializedSizeOut, const uint8_t** memoryOut,
+                           intptr_t* handleOut)
 {
-    if (!jsCachingEnabled || !jsCacheAsmJSPath)
+    if (!jsCachingEnabled || !path)
         return false;
 
-    ScopedFileDesc fd(open(jsCacheAsmJSPath, O_RDWR), ScopedFileDesc::READ_LOCK);
+    ScopedFileDesc fd(open(path, O_RDWR), ScopedFileDesc::READ_LOCK);
     if (fd == -1)
         return false;
 
@@ -6766,7 +6988,7 @@ ShellOpenAsmJSCacheEntryForRead(HandleObject global, const char16_t* begin, cons
 }
 
 static void
-ShellCloseAsmJSCacheEntryForRead(size_t serializedSize, const uint8_t* memory, intptr_t handle)
+ShellCloseCacheEntryForRead(size_t serializedSize, const uint8_t* memory, intptr_t handle)
 {
     // Undo the cookie adjustment done when opening the file.
     memory -= sizeof(uint32_t);
@@ -6785,11 +7007,10 @@ ShellCloseAsmJSCacheEntryForRead(size_t serializedSize, const uint8_t* memory, i
 }
 
 static JS::AsmJSCacheResult
-ShellOpenAsmJSCacheEntryForWrite(HandleObject global, bool installed,
-                                 const char16_t* begin, const char16_t* end,
-                                 size_t serializedSize, uint8_t** memoryOut, intptr_t* handleOut)
+ShellOpenCacheEntryForWrite(const char* path, size_t serializedSize, uint8_t** memoryOut,
+                            intptr_t* handleOut)
 {
-    if (!jsCachingEnabled || !jsCacheAsmJSPath)
+    if (!jsCachingEnabled || !path)
         return JS::AsmJSCache_Disabled_ShellFlags;
 
     // Create the cache directory if it doesn't already exist.
@@ -6807,7 +7028,7 @@ ShellOpenAsmJSCacheEntryForWrite(HandleObject global, bool installed,
 #endif
     }
 
-    ScopedFileDesc fd(open(jsCacheAsmJSPath, O_CREAT|O_RDWR, 0660), ScopedFileDesc::WRITE_LOCK);
+    ScopedFileDesc fd(open(path, O_CREAT|O_RDWR, 0660), ScopedFileDesc::WRITE_LOCK);
     if (fd == -1)
         return JS::AsmJSCache_InternalError;
 
@@ -6854,7 +7075,7 @@ ShellOpenAsmJSCacheEntryForWrite(HandleObject global, bool installed,
 }
 
 static void
-ShellCloseAsmJSCacheEntryForWrite(size_t serializedSize, uint8_t* memory, intptr_t handle)
+ShellCloseCacheEntryForWrite(size_t serializedSize, uint8_t* memory, intptr_t handle)
 {
     // Undo the cookie adjustment done when opening the file.
     memory -= sizeof(uint32_t);
@@ -6883,6 +7104,42 @@ ShellCloseAsmJSCacheEntryForWrite(size_t serializedSize, uint8_t* memory, intptr
     close(handle);
 }
 
+// The asm.js and wasm caches each hold a single entry, in separate files. The
+// JS engine checks that an entry matches what is being compiled before using
+// it.
+
+static bool
+ShellOpenAsmJSCacheEntryForRead(HandleObject global, const char16_t* begin, const char16_t* limit,
+                                size_t* serializedSizeOut, const uint8_t** memoryOut,
+                                intptr_t* handleOut)
+{
+    return ShellOpenCacheEntryForRead(jsCacheAsmJSPath, serializedSizeOut, memoryOut, handleOut);
+}
+
+static JS::AsmJSCacheResult
+ShellOpenAsmJSCacheEntryForWrite(HandleObject global, bool installed,
+                                 const char16_t* begin, const char16_t* end,
+                                 size_t serializedSize, uint8_t** memoryOut, intptr_t* handleOut)
+{
+    return ShellOpenCacheEntryForWrite(jsCacheAsmJSPath, serializedSize, memoryOut, handleOut);
+}
+
+static bool
+ShellOpenWasmCacheEntryForRead(HandleObject global, const uint8_t* key,
+                               size_t* serializedSizeOut, const uint8_t** memoryOut,
+                               intptr_t* handleOut)
+{
+    return ShellOpenCacheEntryForRead(jsCacheWasmPath, serializedSizeOut, memoryOut, handleOut);
+}
+
+static bool
+ShellOpenWasmCacheEntryForWrite(HandleObject global, const uint8_t* key,
+                                size_t serializedSize, uint8_t** memoryOut, intptr_t* handleOut)
+{
+    return ShellOpenCacheEntryForWrite(jsCacheWasmPath, serializedSize, memoryOut, handleOut) ==
+           JS::AsmJSCache_Success;
+}
+
 static bool
 ShellBuildId(JS::BuildIdCharVector* buildId)
 {
@@ -6901,9 +7158,16 @@ ShellBuildId(JS::BuildIdCharVector* buildId)
 
 static const JS::AsmJSCacheOps asmJSCacheOps = {
     ShellOpenAsmJSCacheEntryForRead,
-    ShellCloseAsmJSCacheEntryForRead,
+    ShellCloseCacheEntryForRead,
     ShellOpenAsmJSCacheEntryForWrite,
-    ShellCloseAsmJSCacheEntryForWrite
+    ShellCloseCacheEntryForWrite
+};
+
+static const JS::WasmCacheOps wasmCacheOps = {
+    ShellOpenWasmCacheEntryForRead,
+    ShellCloseCacheEntryForRead,
+    ShellOpenWasmCacheEntryForWrite,
+    ShellCloseCacheEntryForWrite
 };
 
 static JSObject*
@@ -7127,15 +7391,21 @@ SetContextOptions(JSContext* cx, const OptionParser& op)
     enableIon = !op.getBoolOption("no-ion");
     enableAsmJS = !op.getBoolOption("no-asmjs");
     enableNativeRegExp = !op.getBoolOption("no-native-regexp");
+    enableSharedRegExpCache = op.getBoolOption("shared-regexp-cache");
+    enableLZ4SourceCompression = op.getBoolOption("lz4-source-compression");
     enableUnboxedArrays = op.getBoolOption("unboxed-arrays");
     enableWasmAlwaysBaseline = op.getBoolOption("wasm-always-baseline");
+    enableWasmTiering = op.getBoolOption("wasm-tiering");
 
     JS::ContextOptionsRef(cx).setBaseline(enableBaseline)
                              .setIon(enableIon)
                              .setAsmJS(enableAsmJS)
                              .setWasm(true)
                              .setWasmAlwaysBaseline(enableWasmAlwaysBaseline)
+                             .setWasmTiering(enableWasmTiering)
                              .setNativeRegExp(enableNativeRegExp)
+                             .setSharedRegExpCache(enableSharedRegExpCache)
+                             .setLZ4SourceCompression(enableLZ4SourceCompression)
                              .setUnboxedArrays(enableUnboxedArrays);
 
     if (op.getBoolOption("no-unboxed-objects"))
@@ -7385,6 +7655,7 @@ SetContextOptions(JSContext* cx, const OptionParser& op)
         if (!jsCacheDir)
             return false;
         jsCacheAsmJSPath = JS_smprintf("%s/asmjs.cache", jsCacheDir);
+        jsCacheWasmPath = JS_smprintf("%s/wasm.cache", jsCacheDir);
     }
 
 #ifdef DEBUG
@@ -7413,7 +7684,10 @@ SetWorkerContextOptions(JSContext* cx)
                              .setAsmJS(enableAsmJS)
                              .setWasm(true)
                              .setWasmAlwaysBaseline(enableWasmAlwaysBaseline)
+                             .setWasmTiering(enableWasmTiering)
                              .setNativeRegExp(enableNativeRegExp)
+                             .setSharedRegExpCache(enableSharedRegExpCache)
+                             .setLZ4SourceCompression(enableLZ4SourceCompression)
                              .setUnboxedArrays(enableUnboxedArrays);
     cx->setOffthreadIonCompilationEnabled(offthreadCompilation);
     cx->profilingScripts = enableCodeCoverage || enableDisassemblyDumps;
@@ -7482,6 +7756,10 @@ Shell(JSContext* cx, OptionParser* op, char** envp)
             unlink(jsCacheAsmJSPath);
             JS_free(cx, const_cast<char*>(jsCacheAsmJSPath));
         }
+        if (jsCacheWasmPath) {
+            unlink(jsCacheWasmPath);
+            JS_free(cx, const_cast<char*>(jsCacheWasmPath));
+        }
         if (jsCacheDir) {
             rmdir(jsCacheDir);
             JS_free(cx, const_cast<char*>(jsCacheDir));
@@ -7592,9 +7870,13 @@ main(int argc, char** argv, char** envp)
         || !op.addBoolOption('\0', "no-ion", "Disable IonMonkey")
         || !op.addBoolOption('\0', "no-asmjs", "Disable asm.js compilation")
         || !op.addBoolOption('\0', "no-native-regexp", "Disable native regexp compilation")
+        || !op.addBoolOption('\0', "shared-regexp-cache", "Share compiled regexps between compartments")
+        || !op.addBoolOption('\0', "lz4-source-compression", "Compress script sources with LZ4 instead of zlib")
         || !op.addBoolOption('\0', "no-unboxed-objects", "Disable creating unboxed plain objects")
         || !op.addBoolOption('\0', "unboxed-arrays", "Allow creating unboxed arrays")
         || !op.addBoolOption('\0', "wasm-always-baseline", "Enable experimental Wasm baseline compiler when possible")
+        || !op.addBoolOption('\0', "wasm-tiering", "Compile Wasm with the baseline compiler first and "
+                             "recompile hot functions with Ion in the background")
 #ifdef ENABLE_SHARED_ARRAY_BUFFER
         || !op.addStringOption('\0', "shared-memory", "on/off",
                                "SharedArrayBuffer and Atomics "
@@ -7808,6 +8090,7 @@ main(int argc, char** argv, char** envp)
     JS_AddInterruptCallback(cx, ShellInterruptCallback);
     JS::SetBuildIdOp(cx, ShellBuildId);
     JS::SetAsmJSCacheOps(cx, &asmJSCacheOps);
+    JS::SetWasmCacheOps(cx, &wasmCacheOps);
 
     JS_SetNativeStackQuota(cx, gMaxStackSize);
 
@@ -1220,6 +1220,11 @@ ArrayBufferObject::trace(JSTracer* trc, JSObject* obj)
     JSObject* view = MaybeForwarded(buf.firstView());
     MOZ_ASSERT(view && view->is<InlineTransparentTypedObject>());
 
+#ifdef OMR // Compaction
+    // The compactor has already updated the view slot, and forwarding the
+    // new address again would not be a no-op.
+    if (!trc->isOmrCompactingTracer())
+#endif // OMR Compaction
     TraceManuallyBarrieredEdge(trc, &view, "array buffer inline typed object owner");
     buf.setSlot(DATA_SLOT, PrivateValue(view->as<InlineTransparentTypedObject>().inlineTypedMem()));
 }
@@ -1235,6 +1240,15 @@ ArrayBufferObject::objectMoved(JSObject* obj, const JSObject* old)
         dst.setSlot(DATA_SLOT, PrivateValue(dst.inlineDataPointer()));
 }
 
+#ifdef OMR // Compaction
+void
+ArrayBufferObject::setInlineDataAfterCompaction()
+{
+    MOZ_ASSERT(!forInlineTypedObject());
+    setSlot(DATA_SLOT, PrivateValue(inlineDataPointer()));
+}
+#endif // OMR Compaction
+
 ArrayBufferViewObject*
 ArrayBufferObject::firstView()
 {
@@ -1397,6 +1411,24 @@ InnerViewTable::sweepAfterMinorGC()
     }
 }
 
+#ifdef OMR // Compaction
+void
+InnerViewTable::fixupAfterCompaction(JSTracer* trc)
+{
+    // Keys are hashed by unique id, which stays with a cell when it moves, so
+    // entries are updated in place.
+    if (map.initialized()) {
+        for (Map::Enum e(map); !e.empty(); e.popFront()) {
+            TraceManuallyBarrieredEdge(trc, &e.front().mutableKey(), "inner view table key");
+            for (ArrayBufferViewObject*& view : e.front().value())
+                TraceManuallyBarrieredEdge(trc, &view, "inner view");
+        }
+    }
+    for (JSObject*& key : nurseryKeys)
+        TraceManuallyBarrieredEdge(trc, &key, "inner view nursery key");
+}
+#endif // OMR Compaction
+
 size_t
 InnerViewTable::sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf)
 {
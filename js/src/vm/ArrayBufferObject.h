@@ -275,6 +275,11 @@ class ArrayBufferObject : public ArrayBufferObjectMaybeShared
 
     static void trace(JSTracer* trc, JSObject* obj);
     static void objectMoved(JSObject* obj, const JSObject* old);
+#ifdef OMR // Compaction
+    // The compactor cannot read the old cell, so it calls this when the data
+    // pointer still points into the heap, i.e. at the old inline data.
+    void setInlineDataAfterCompaction();
+#endif // OMR Compaction
 
     static BufferContents externalizeContents(JSContext* cx,
                                               Handle<ArrayBufferObject*> buffer,
@@ -605,6 +610,9 @@ class InnerViewTable
     // to reflect moved objects.
     void sweep();
     void sweepAfterMinorGC();
+#ifdef OMR // Compaction
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
 
     bool needsSweepAfterMinorGC() const {
         return !nurseryKeys.empty() || !nurseryKeysValid;
@@ -630,6 +638,9 @@ class WeakCacheBase<InnerViewTable>
     void removeViews(ArrayBufferObject* obj) { table().removeViews(obj); }
     void sweepAfterMinorGC() { table().sweepAfterMinorGC(); }
     bool needsSweepAfterMinorGC() const { return table().needsSweepAfterMinorGC(); }
+#ifdef OMR // Compaction
+    void fixupAfterCompaction(JSTracer* trc) { table().fixupAfterCompaction(trc); }
+#endif // OMR Compaction
     size_t sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf) {
         return table().sizeOfExcludingThis(mallocSizeOf);
     }
@@ -7,6 +7,8 @@
 #ifndef vm_Caches_h
 #define vm_Caches_h
 
+#include "mozilla/TemplateLib.h"
+
 #include "jsatom.h"
 #include "jsbytecode.h"
 #include "jsobj.h"
@@ -143,6 +145,85 @@ class NativeIterCache
     }
 };
 
+/*
+ * Cache of own property lookups on native objects, keyed by the object's
+ * shape and the property's id, for property accesses that have seen too many
+ * shapes to have a stub for each. Only shapes outside dictionary mode are
+ * cached: the properties they describe never change, so an entry is good
+ * until its shape dies. The cache is therefore purged on every GC.
+ *
+ * The JIT probes the cache inline, see MacroAssembler::megamorphicCacheProbe.
+ */
+class MegamorphicCache
+{
+  public:
+    enum class Kind : uintptr_t {
+        // The shape has no property with this id.
+        Missing,
+        // A plain data property, at |offset| bytes into the object.
+        FixedSlot,
+        // A plain data property, at |offset| bytes into the object's slots.
+        DynamicSlot
+    };
+
+    // Every field is a word so that an entry's size is a power of two, which
+    // lets the JIT index the table with a shift.
+    struct Entry
+    {
+        Shape* shape;
+        jsid id;
+        Kind kind;
+        uintptr_t offset;
+    };
+
+    static const size_t NumEntries = 1024;
+    static const uint32_t HashShift = 3;
+    static const uint32_t EntryShift = mozilla::tl::FloorLog2<sizeof(Entry)>::value;
+
+  private:
+    Entry entries[NumEntries];
+
+    static_assert(mozilla::tl::IsPowerOfTwo<sizeof(Entry)>::value,
+                  "the JIT scales entry indexes by shifting");
+
+    // Shapes and atoms are both at least 8 byte aligned, so their low bits
+    // are always zero and are shifted out. The JIT repeats this computation.
+    static size_t getIndex(Shape* shape, jsid id) {
+        return ((uintptr_t(shape) ^ uintptr_t(JSID_BITS(id))) >> HashShift) & (NumEntries - 1);
+    }
+
+  public:
+    MegamorphicCache() {
+        purge();
+    }
+
+    void purge() {
+        mozilla::PodArrayZero(entries);
+    }
+
+    const Entry* lookup(Shape* shape, jsid id) const {
+        const Entry& entry = entries[getIndex(shape, id)];
+        if (entry.shape != shape || entry.id != id)
+            return nullptr;
+        return &entry;
+    }
+
+    void add(Shape* shape, jsid id, Kind kind, uintptr_t offset) {
+        MOZ_ASSERT(!shape->inDictionary());
+        Entry& entry = entries[getIndex(shape, id)];
+        entry.shape = shape;
+        entry.id = id;
+        entry.kind = kind;
+        entry.offset = offset;
+    }
+
+    const Entry* addressOfEntries() const { return entries; }
+    static size_t offsetOfEntryShape() { return offsetof(Entry, shape); }
+    static size_t offsetOfEntryId() { return offsetof(Entry, id); }
+    static size_t offsetOfEntryKind() { return offsetof(Entry, kind); }
+    static size_t offsetOfEntryOffset() { return offsetof(Entry, offset); }
+};
+
 /*
  * Cache for speeding up repetitive creation of objects in the VM.
  * When an object is created which matches the criteria in the 'key' section
@@ -295,6 +376,7 @@ class ContextCaches
     js::EnvironmentCoordinateNameCache envCoordinateNameCache;
     js::NewObjectCache newObjectCache;
     js::NativeIterCache nativeIterCache;
+    js::MegamorphicCache megamorphicCache;
     js::UncompressedSourceCache uncompressedSourceCache;
     js::EvalCache evalCache;
     js::LazyScriptCache lazyScriptCache;
@@ -19,6 +19,10 @@ namespace js {
 struct CompressedDataHeader
 {
     uint32_t compressedBytes;
+
+    // A Compressor::Codec value, so chunks can be decompressed without
+    // knowing which codec the compressing thread picked.
+    uint32_t codec;
 };
 
 class Compressor
@@ -28,13 +32,25 @@ class Compressor
     // start decompression at that point.
     static const size_t CHUNK_SIZE = 64 * 1024;
 
+    // Zlib produces smaller output, but LZ4 compresses and decompresses
+    // several times faster. Both store each chunk so it can be decompressed
+    // independently: zlib with full flushes, LZ4 by compressing every chunk
+    // as a separate block.
+    enum Codec {
+        Zlib,
+        LZ4
+    };
+
   private:
     // Number of bytes we should hand to zlib each compressMore() call.
     static const size_t MAX_INPUT_SIZE = 2 * 1024;
 
+    Codec codec;
     z_stream zs;
     const unsigned char* inp;
     size_t inplen;
+    unsigned char* out;
+    size_t outlen;
     size_t outbytes;
     bool initialized;
     bool finished;
@@ -55,7 +71,7 @@ class Compressor
         OOM
     };
 
-    Compressor(const unsigned char* inp, size_t inplen);
+    Compressor(const unsigned char* inp, size_t inplen, Codec codec = Zlib);
     ~Compressor();
     bool init();
     void setOutput(unsigned char* out, size_t outlen);
@@ -67,7 +83,7 @@ class Compressor
     // the chunk offsets.
     size_t totalBytesNeeded() const;
 
-    // Append the chunk offsets to |dest|.
+    // Write the header and append the chunk offsets to |dest|.
     void finish(char* dest, size_t destBytes);
 
     static void toChunkOffset(size_t uncompressedOffset, size_t* chunk, size_t* chunkOffset) {
@@ -82,6 +98,9 @@ class Compressor
             return CHUNK_SIZE;
         return uncompressedBytes % CHUNK_SIZE;
     }
+
+  private:
+    Status compressMoreLZ4();
 };
 
 /*
@@ -634,6 +634,9 @@ Debugger::Debugger(JSContext* cx, NativeObject* dbg)
     allocationSamplingProbability(1.0),
     maxAllocationsLogLength(DEFAULT_MAX_LOG_LENGTH),
     allocationsLogOverflowed(false),
+    allocationsLogBinary(false),
+    allocationsLogRecordsStart(0),
+    allocationsLogRecordsLength(0),
     frames(cx->runtime()),
     scripts(cx),
     sources(cx),
@@ -668,7 +671,7 @@ Debugger::Debugger(JSContext* cx, NativeObject* dbg)
 Debugger::~Debugger()
 {
     MOZ_ASSERT_IF(debuggees.initialized(), debuggees.empty());
-    allocationsLog.clear();
+    clearAllocationsLog();
 
     /*
      * Since the inactive state for this link is a singleton cycle, it's always
@@ -2223,6 +2226,9 @@ Debugger::appendAllocationSite(JSContext* cx, HandleObject obj, HandleSavedFrame
     auto size = JS::ubi::Node(obj.get()).size(cx->runtime()->debuggerMallocSizeOf);
     auto inNursery = gc::IsInsideNursery(obj);
 
+    if (allocationsLogBinary)
+        return appendAllocationRecord(cx, wrappedFrame, when, className, size, inNursery);
+
     if (!allocationsLog.emplaceBack(wrappedFrame, when, className, ctorName, size, inNursery)) {
         ReportOutOfMemory(cx);
         return false;
@@ -2240,6 +2246,102 @@ Debugger::appendAllocationSite(JSContext* cx, HandleObject obj, HandleSavedFrame
     return true;
 }
 
+bool
+Debugger::appendAllocationRecord(JSContext* cx, HandleObject frame, double when,
+                                  const char* className, size_t size, bool inNursery)
+{
+    if ((!allocationsLogFrameIds.initialized() && !allocationsLogFrameIds.init()) ||
+        (!allocationsLogClassIds.initialized() && !allocationsLogClassIds.init()) ||
+        (allocationsLogRecords.empty() && !resizeAllocationRecords(maxAllocationsLogLength)))
+    {
+        ReportOutOfMemory(cx);
+        return false;
+    }
+
+    uint32_t frameId = 0;
+    if (frame) {
+        AllocationsLogFrameIds::AddPtr p = allocationsLogFrameIds.lookupForAdd(frame);
+        if (p) {
+            frameId = p->value();
+        } else {
+            frameId = allocationsLogFrameIds.count() + 1;
+            if (!allocationsLogNewFrames.append(frame.get()) ||
+                !allocationsLogFrameIds.add(p, frame.get(), frameId))
+            {
+                ReportOutOfMemory(cx);
+                return false;
+            }
+        }
+    }
+
+    uint32_t classId;
+    AllocationsLogClassIds::AddPtr p = allocationsLogClassIds.lookupForAdd(className);
+    if (p) {
+        classId = p->value();
+    } else {
+        classId = allocationsLogClassIds.count() + 1;
+        if (!allocationsLogNewClasses.append(className) ||
+            !allocationsLogClassIds.add(p, className, classId))
+        {
+            ReportOutOfMemory(cx);
+            return false;
+        }
+    }
+
+    size_t capacity = allocationsLogRecords.length();
+    size_t index = (allocationsLogRecordsStart + allocationsLogRecordsLength) % capacity;
+    if (allocationsLogRecordsLength == capacity) {
+        allocationsLogRecordsStart = (allocationsLogRecordsStart + 1) % capacity;
+        allocationsLogOverflowed = true;
+    } else {
+        allocationsLogRecordsLength++;
+    }
+
+    AllocationsLogRecord& record = allocationsLogRecords[index];
+    record.when = when;
+    record.frameId = frameId;
+    record.classId = classId;
+    record.size = uint32_t(Min(size, size_t(UINT32_MAX)));
+    record.inNursery = inNursery;
+    return true;
+}
+
+bool
+Debugger::resizeAllocationRecords(size_t newLength)
+{
+    // Keep the newest records, moved to the front of the new buffer.
+    Vector<AllocationsLogRecord, 0, SystemAllocPolicy> records;
+    if (!records.resize(newLength))
+        return false;
+
+    size_t kept = Min(allocationsLogRecordsLength, newLength);
+    size_t oldCapacity = allocationsLogRecords.length();
+    for (size_t i = 0; i < kept; i++) {
+        size_t from = allocationsLogRecordsStart + allocationsLogRecordsLength - kept + i;
+        records[i] = allocationsLogRecords[from % oldCapacity];
+    }
+
+    allocationsLogRecords = mozilla::Move(records);
+    allocationsLogRecordsStart = 0;
+    allocationsLogRecordsLength = kept;
+    return true;
+}
+
+void
+Debugger::clearAllocationsLog()
+{
+    allocationsLog.clear();
+    allocationsLogRecords.clearAndFree();
+    allocationsLogRecordsStart = 0;
+    allocationsLogRecordsLength = 0;
+    if (allocationsLogFrameIds.initialized())
+        allocationsLogFrameIds.clear();
+    allocationsLogNewFrames.clearAndFree();
+    if (allocationsLogClassIds.initialized())
+        allocationsLogClassIds.clear();
+    allocationsLogNewClasses.clearAndFree();
+}
+
 JSTrapStatus
 Debugger::firePromiseHook(JSContext* cx, Hook hook, HandleObject promise, MutableHandleValue vp)
 {
@@ -2881,7 +2983,7 @@ Debugger::removeAllocationsTrackingForAllDebuggees()
     for (WeakGlobalObjectSet::Range r = debuggees.all(); !r.empty(); r.popFront())
         Debugger::removeAllocationsTracking(*r.front().get());
 
-    allocationsLog.clear();
+    clearAllocationsLog();
 }
 
 
@@ -3074,6 +3176,10 @@ Debugger::trace(JSTracer* trc)
     }
 
     allocationsLog.trace(trc);
+    for (AllocationsLogFrameIds::Enum e(allocationsLogFrameIds); !e.empty(); e.popFront())
+        TraceEdge(trc, &e.front().mutableKey(), "Debugger allocations log frame id");
+    for (HeapPtr<JSObject*>& frame : allocationsLogNewFrames)
+        TraceEdge(trc, &frame, "Debugger allocations log new frame");
 
     /* Trace the weak map from JSScript instances to Debugger.Script objects. */
     scripts.trace(trc);
@@ -358,6 +358,19 @@ class Debugger : private mozilla::LinkedListElement<Debugger>
         }
     };
 
+    // A fixed-size record in the binary allocations log. Allocation sites and
+    // class names are stored as 1-based ids into tables that are handed out
+    // incrementally by drainAllocationsLogBuffer; a frame id of zero means no
+    // stack was captured.
+    struct AllocationsLogRecord
+    {
+        double when;
+        uint32_t frameId;
+        uint32_t classId;
+        uint32_t size;
+        uint32_t inNursery;
+    };
+
     // Barrier methods so we can have ReadBarriered<Debugger*>.
     static void readBarrier(Debugger* dbg) {
         InternalBarrierMethods<JSObject*>::readBarrier(dbg->object);
@@ -392,8 +405,32 @@ class Debugger : private mozilla::LinkedListElement<Debugger>
 
     static const size_t DEFAULT_MAX_LOG_LENGTH = 5000;
 
+    // When allocationsLogBinary is set, allocation sites are written as
+    // AllocationsLogRecords into a ring buffer of maxAllocationsLogLength
+    // entries instead of allocationsLog, overwriting the oldest records when
+    // full. Each distinct frame and class name is given an id the first time
+    // it is logged, and is queued to be reported by the next drain.
+    using AllocationsLogFrameIds = HashMap<HeapPtr<JSObject*>, uint32_t,
+                                           MovableCellHasher<HeapPtr<JSObject*>>,
+                                           SystemAllocPolicy>;
+    using AllocationsLogClassIds = HashMap<const char*, uint32_t, DefaultHasher<const char*>,
+                                           SystemAllocPolicy>;
+
+    bool allocationsLogBinary;
+    Vector<AllocationsLogRecord, 0, SystemAllocPolicy> allocationsLogRecords;
+    size_t allocationsLogRecordsStart;
+    size_t allocationsLogRecordsLength;
+    AllocationsLogFrameIds allocationsLogFrameIds;
+    Vector<HeapPtr<JSObject*>, 0, SystemAllocPolicy> allocationsLogNewFrames;
+    AllocationsLogClassIds allocationsLogClassIds;
+    Vector<const char*, 0, SystemAllocPolicy> allocationsLogNewClasses;
+
     MOZ_MUST_USE bool appendAllocationSite(JSContext* cx, HandleObject obj, HandleSavedFrame frame,
                                            double when);
+    MOZ_MUST_USE bool appendAllocationRecord(JSContext* cx, HandleObject frame, double when,
+                                             const char* className, size_t size, bool inNursery);
+    MOZ_MUST_USE bool resizeAllocationRecords(size_t newLength);
+    void clearAllocationsLog();
 
     /*
      * Recompute the set of debuggee zones based on the set of debuggee globals.
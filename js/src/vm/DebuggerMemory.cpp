@@ -23,6 +23,7 @@
 #include "js/UbiNode.h"
 #include "js/UbiNodeCensus.h"
 #include "js/Utility.h"
+#include "vm/ArrayBufferObject.h"
 #include "vm/Debugger.h"
 #include "vm/GlobalObject.h"
 #include "vm/SavedStacks.h"
@@ -247,6 +248,104 @@ DebuggerMemory::drainAllocationsLog(JSContext* cx, unsigned argc, Value* vp)
     return true;
 }
 
+/* static */ bool
+DebuggerMemory::drainAllocationsLogBuffer(JSContext* cx, unsigned argc, Value* vp)
+{
+    THIS_DEBUGGER_MEMORY(cx, argc, vp, "drainAllocationsLogBuffer", args, memory);
+    Debugger* dbg = memory->getDebugger();
+
+    if (!dbg->trackingAllocationSites) {
+        JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_NOT_TRACKING_ALLOCATIONS,
+                                  "drainAllocationsLogBuffer");
+        return false;
+    }
+
+    // The records are copied out oldest first, in at most two pieces since
+    // the ring buffer may wrap around.
+    using Record = Debugger::AllocationsLogRecord;
+    size_t length = dbg->allocationsLogRecordsLength;
+    Rooted<ArrayBufferObject*> records(cx, ArrayBufferObject::create(cx, length * sizeof(Record)));
+    if (!records)
+        return false;
+    if (length) {
+        size_t capacity = dbg->allocationsLogRecords.length();
+        size_t start = dbg->allocationsLogRecordsStart;
+        size_t first = Min(length, capacity - start);
+        uint8_t* data = records->dataPointer();
+        memcpy(data, &dbg->allocationsLogRecords[start], first * sizeof(Record));
+        memcpy(data + first * sizeof(Record), &dbg->allocationsLogRecords[0],
+               (length - first) * sizeof(Record));
+    }
+
+    // Frames and class names logged for the first time since the last drain,
+    // in id order.
+    size_t framesLength = dbg->allocationsLogNewFrames.length();
+    RootedArrayObject frames(cx, NewDenseFullyAllocatedArray(cx, framesLength));
+    if (!frames)
+        return false;
+    frames->ensureDenseInitializedLength(cx, 0, framesLength);
+    for (size_t i = 0; i < framesLength; i++)
+        frames->setDenseElement(i, ObjectValue(*dbg->allocationsLogNewFrames[i]));
+
+    size_t classesLength = dbg->allocationsLogNewClasses.length();
+    RootedArrayObject classNames(cx, NewDenseFullyAllocatedArray(cx, classesLength));
+    if (!classNames)
+        return false;
+    classNames->ensureDenseInitializedLength(cx, 0, classesLength);
+    for (size_t i = 0; i < classesLength; i++) {
+        const char* name = dbg->allocationsLogNewClasses[i];
+        JSAtom* atom = Atomize(cx, name, strlen(name));
+        if (!atom)
+            return false;
+        classNames->setDenseElement(i, StringValue(atom));
+    }
+
+    RootedObject result(cx, NewBuiltinClassInstance<PlainObject>(cx));
+    if (!result ||
+        !JS_DefineProperty(cx, result, "records", records, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, result, "recordSize", int32_t(sizeof(Record)), JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, result, "frames", frames, JSPROP_ENUMERATE) ||
+        !JS_DefineProperty(cx, result, "classNames", classNames, JSPROP_ENUMERATE))
+    {
+        return false;
+    }
+
+    dbg->allocationsLogRecordsStart = 0;
+    dbg->allocationsLogRecordsLength = 0;
+    dbg->allocationsLogNewFrames.clear();
+    dbg->allocationsLogNewClasses.clear();
+    dbg->allocationsLogOverflowed = false;
+    args.rval().setObject(*result);
+    return true;
+}
+
+/* static */ bool
+DebuggerMemory::getAllocationsLogBinary(JSContext* cx, unsigned argc, Value* vp)
+{
+    THIS_DEBUGGER_MEMORY(cx, argc, vp, "(get allocationsLogBinary)", args, memory);
+    args.rval().setBoolean(memory->getDebugger()->allocationsLogBinary);
+    return true;
+}
+
+/* static */ bool
+DebuggerMemory::setAllocationsLogBinary(JSContext* cx, unsigned argc, Value* vp)
+{
+    THIS_DEBUGGER_MEMORY(cx, argc, vp, "(set allocationsLogBinary)", args, memory);
+    if (!args.requireAtLeast(cx, "(set allocationsLogBinary)", 1))
+        return false;
+
+    // Entries logged in the old format are discarded, along with the frame
+    // and class name ids handed out so far.
+    Debugger* dbg = memory->getDebugger();
+    bool binary = ToBoolean(args[0]);
+    if (binary != dbg->allocationsLogBinary) {
+        dbg->clearAllocationsLog();
+        dbg->allocationsLogBinary = binary;
+    }
+
+    return undefined(args);
+}
+
 /* static */ bool
 DebuggerMemory::getMaxAllocationsLogLength(JSContext* cx, unsigned argc, Value* vp)
 {
@@ -283,6 +382,11 @@ DebuggerMemory::setMaxAllocationsLogLength(JSContext* cx, unsigned argc, Value*
         }
     }
 
+    if (!dbg->allocationsLogRecords.empty() && !dbg->resizeAllocationRecords(max)) {
+        ReportOutOfMemory(cx);
+        return false;
+    }
+
     args.rval().setUndefined();
     return true;
 }
@@ -448,6 +552,7 @@ DebuggerMemory::takeCensus(JSContext* cx, unsigned argc, Value* vp)
     JS_PSGS("maxAllocationsLogLength", getMaxAllocationsLogLength, setMaxAllocationsLogLength, 0),
     JS_PSGS("allocationSamplingProbability", getAllocationSamplingProbability, setAllocationSamplingProbability, 0),
     JS_PSG("allocationsLogOverflowed", getAllocationsLogOverflowed, 0),
+    JS_PSGS("allocationsLogBinary", getAllocationsLogBinary, setAllocationsLogBinary, 0),
 
     JS_PSGS("onGarbageCollection", getOnGarbageCollection, setOnGarbageCollection, 0),
     JS_PS_END
@@ -455,6 +560,7 @@ DebuggerMemory::takeCensus(JSContext* cx, unsigned argc, Value* vp)
 
 /* static */ const JSFunctionSpec DebuggerMemory::methods[] = {
     JS_FN("drainAllocationsLog", DebuggerMemory::drainAllocationsLog, 0, 0),
+    JS_FN("drainAllocationsLogBuffer", DebuggerMemory::drainAllocationsLogBuffer, 0, 0),
     JS_FN("takeCensus", takeCensus, 0, 0),
     JS_FS_END
 };
@@ -44,6 +44,8 @@ class DebuggerMemory : public NativeObject {
     static bool setAllocationSamplingProbability(JSContext* cx, unsigned argc, Value* vp);
     static bool getAllocationSamplingProbability(JSContext* cx, unsigned argc, Value* vp);
     static bool getAllocationsLogOverflowed(JSContext* cx, unsigned argc, Value* vp);
+    static bool setAllocationsLogBinary(JSContext* cx, unsigned argc, Value* vp);
+    static bool getAllocationsLogBinary(JSContext* cx, unsigned argc, Value* vp);
 
     static bool getOnGarbageCollection(JSContext* cx, unsigned argc, Value* vp);
     static bool setOnGarbageCollection(JSContext* cx, unsigned argc, Value* vp);
@@ -52,6 +54,7 @@ class DebuggerMemory : public NativeObject {
 
     static bool takeCensus(JSContext* cx, unsigned argc, Value* vp);
     static bool drainAllocationsLog(JSContext* cx, unsigned argc, Value* vp);
+    static bool drainAllocationsLogBuffer(JSContext* cx, unsigned argc, Value* vp);
 };
 
 } /* namespace js */
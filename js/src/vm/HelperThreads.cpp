@@ -7,11 +7,15 @@
 #include "vm/HelperThreads.h"
 
 #include "mozilla/DebugOnly.h"
+#include "mozilla/MathAlgorithms.h"
 #include "mozilla/Unused.h"
 
+#include <math.h>
+
 #include "jsnativestack.h"
 #include "jsnum.h" // For FIX_FPU()
 
+#include "asmjs/WasmCompile.h"
 #include "asmjs/WasmIonCompile.h"
 #include "builtin/Promise.h"
 #include "frontend/BytecodeCompiler.h"
@@ -31,6 +35,7 @@ using namespace js;
 
 using mozilla::ArrayLength;
 using mozilla::DebugOnly;
+using mozilla::Max;
 using mozilla::Unused;
 using mozilla::TimeDuration;
 
@@ -73,6 +78,16 @@ ThreadCountForCPUCount(size_t cpuCount)
     return cpuCount + EXCESS_THREADS;
 }
 
+void
+js::SetConcurrentParseTasksEnabled(bool enabled)
+{
+    AutoLockHelperThreadState lock;
+    HelperThreadState().concurrentParseTasksEnabled = enabled;
+
+    // Queued parse tasks may now be able to start.
+    HelperThreadState().notifyAll(GlobalHelperThreadState::PRODUCER, lock);
+}
+
 void
 js::SetFakeCPUCount(size_t count)
 {
@@ -99,12 +114,89 @@ js::StartOffThreadWasmCompile(wasm::IonCompileTask* task)
     return true;
 }
 
+bool
+js::StartOffThreadWasmTierUp(wasm::TierUpTask* task)
+{
+    AutoLockHelperThreadState lock;
+
+    if (!HelperThreadState().wasmTierUpWorklist(lock).append(task))
+        return false;
+
+    HelperThreadState().notifyOne(GlobalHelperThreadState::PRODUCER, lock);
+    return true;
+}
+
+void
+js::CancelOffThreadWasmTierUp(wasm::TierUpTask* task)
+{
+    AutoLockHelperThreadState lock;
+
+    wasm::TierUpTaskPtrVector& worklist = HelperThreadState().wasmTierUpWorklist(lock);
+    for (size_t i = 0; i < worklist.length(); i++) {
+        if (worklist[i] == task) {
+            HelperThreadState().remove(worklist, &i);
+            js_delete(task);
+            return;
+        }
+    }
+
+    if (task->finished()) {
+        js_delete(task);
+        return;
+    }
+
+    task->setOrphaned();
+}
+
+struct GlobalHelperThreadState::IonBuilderPriority
+{
+    static jit::IonBuilder::Priority priority(jit::IonBuilder* builder) {
+        return builder->priority();
+    }
+};
+
+// Within a tier, builders are scored in milliseconds of queueing time: every
+// doubling of a script's warm-up rate lets it overtake builders queued up to
+// IonVelocityWeight ms earlier, and every doubling of its bytecode length
+// costs it IonSizeWeight ms. Scores are fixed when the builder is queued, and
+// subtracting the queueing time ages older builders relative to newer ones
+// so that large or lukewarm scripts are never starved.
+static const double IonVelocityWeight = 20;
+static const double IonSizeWeight = 10;
+
+static jit::IonBuilder::Priority
+ComputeIonBuilderPriority(jit::IonBuilder* builder)
+{
+    JSScript* script = builder->script();
+    MOZ_ASSERT(script->hasBaselineScript());
+
+    // A lower optimization level indicates a higher priority, and a script
+    // without an IonScript has precedence on one with.
+    uint32_t level = uint32_t(builder->optimizationInfo().level());
+    MOZ_ASSERT(level < uint32_t(jit::OptimizationLevel::Count));
+    uint32_t tier = (uint32_t(jit::OptimizationLevel::Count) - level) * 2;
+    if (!builder->scriptHasIonScript())
+        tier++;
+
+    // Warm-up counts per millisecond since the script was baseline compiled.
+    double nowMs = double(PRMJ_Now()) / PRMJ_USEC_PER_MSEC;
+    double baselineMs = double(script->baselineScript()->creationTime()) / PRMJ_USEC_PER_MSEC;
+    double velocity = script->getWarmUpCount() / Max(nowMs - baselineMs, 1.0);
+
+    double score = IonVelocityWeight * log2(1 + velocity) -
+                   IonSizeWeight * log2(double(script->length())) -
+                   nowMs;
+    return jit::IonBuilder::Priority{tier, score};
+}
+
 bool
 js::StartOffThreadIonCompile(JSContext* cx, jit::IonBuilder* builder)
 {
+    builder->setPriority(ComputeIonBuilderPriority(builder));
+
     AutoLockHelperThreadState lock;
 
-    if (!HelperThreadState().ionWorklist(lock).append(builder))
+    if (!HelperThreadState().ionWorklist(lock).insert(builder))
         return false;
 
     HelperThreadState().notifyOne(GlobalHelperThreadState::PRODUCER, lock);
@@ -186,14 +278,12 @@ js::CancelOffThreadIonCompile(CompilationSelector selector, bool discardLazyLink
         return;
 
     /* Cancel any pending entries for which processing hasn't started. */
-    GlobalHelperThreadState::IonBuilderVector& worklist = HelperThreadState().ionWorklist(lock);
-    for (size_t i = 0; i < worklist.length(); i++) {
-        jit::IonBuilder* builder = worklist[i];
-        if (CompiledScriptMatches(selector, builder->script())) {
-            FinishOffThreadIonCompile(builder, lock);
-            HelperThreadState().remove(worklist, &i);
-        }
-    }
+    HelperThreadState().ionWorklist(lock).removeIf([&](jit::IonBuilder* builder) {
+        if (!CompiledScriptMatches(selector, builder->script()))
+            return false;
+        FinishOffThreadIonCompile(builder, lock);
+        return true;
+    });
 
     /* Wait for in progress entries to finish up. */
     bool cancelled;
@@ -251,9 +341,7 @@ js::HasOffThreadIonCompile(JSCompartment* comp)
     if (!HelperThreadState().threads)
         return false;
 
-    GlobalHelperThreadState::IonBuilderVector& worklist = HelperThreadState().ionWorklist(lock);
-    for (size_t i = 0; i < worklist.length(); i++) {
-        jit::IonBuilder* builder = worklist[i];
+    for (jit::IonBuilder* builder : HelperThreadState().ionWorklist(lock)) {
         if (builder->script()->compartment() == comp)
             return true;
     }
@@ -390,6 +478,64 @@ ModuleParseTask::parse()
         script = module->script();
 }
 
+ScriptDecodeTask::ScriptDecodeTask(ExclusiveContext* cx, JSObject* exclusiveContextGlobal,
+                                   JSContext* initCx, const void* data, uint32_t length,
+                                   JS::OffThreadCompileCallback callback, void* callbackData)
+  : ParseTask(ParseTaskKind::ScriptDecode, cx, exclusiveContextGlobal, initCx,
+              nullptr, 0, callback, callbackData),
+    data(data), dataLength(length), received(length), streamEnded(true)
+{
+}
+
+void
+ScriptDecodeTask::parse()
+{
+    uint32_t available;
+    {
+        AutoLockHelperThreadState lock;
+        available = received;
+    }
+
+    RootedScript resultScript(cx);
+    XDRDecoder decoder(cx, options, &sourceObject, data, available,
+                       isStreaming() ? this : nullptr);
+    if (decoder.codeScript(&resultScript))
+        script = resultScript;
+}
+
+bool
+ScriptDecodeTask::appendData(const void* bytes, uint32_t length)
+{
+    MOZ_ASSERT(isStreaming());
+
+    AutoLockHelperThreadState lock;
+    if (streamEnded || length > dataLength - received)
+        return false;
+
+    mozilla::PodCopy(streamBuffer.get() + received, static_cast<const uint8_t*>(bytes), length);
+    received += length;
+    HelperThreadState().notifyAll(GlobalHelperThreadState::INPUT, lock);
+    return true;
+}
+
+void
+ScriptDecodeTask::endStream(const AutoLockHelperThreadState& lock)
+{
+    streamEnded = true;
+    HelperThreadState().notifyAll(GlobalHelperThreadState::INPUT, lock);
+}
+
+size_t
+ScriptDecodeTask::waitForLength(size_t length)
+{
+    MOZ_ASSERT(isStreaming());
+
+    AutoLockHelperThreadState lock;
+    while (received < length && !streamEnded)
+        HelperThreadState().wait(lock, GlobalHelperThreadState::INPUT);
+    return received;
+}
+
 void
 js::CancelOffThreadParses(JSRuntime* rt)
 {
@@ -405,6 +551,18 @@ js::CancelOffThreadParses(JSRuntime* rt)
         MOZ_ASSERT(!waitingOnGC[i]->runtimeMatches(rt));
 #endif
 
+    // Streaming decodes wait for data that will no longer arrive. End their
+    // streams so that they fail instead of blocking the wait below.
+    for (ParseTask* task : HelperThreadState().parseWorklist(lock)) {
+        if (task->runtimeMatches(rt) && task->kind == ParseTaskKind::ScriptDecode)
+            static_cast<ScriptDecodeTask*>(task)->endStream(lock);
+    }
+    for (auto& thread : *HelperThreadState().threads) {
+        ParseTask* task = thread.parseTask();
+        if (task && task->runtimeMatches(rt) && task->kind == ParseTaskKind::ScriptDecode)
+            static_cast<ScriptDecodeTask*>(task)->endStream(lock);
+    }
+
     // Instead of forcibly canceling pending parse tasks, just wait for all scheduled
     // and in progress ones to complete. Otherwise the final GC may not collect
     // everything due to zones being used off thread.
@@ -632,6 +790,73 @@ js::StartOffThreadParseModule(JSContext* cx, const ReadOnlyCompileOptions& optio
     return true;
 }
 
+static ScriptDecodeTask*
+StartOffThreadDecodeTask(JSContext* cx, const ReadOnlyCompileOptions& options,
+                         const void* data, uint32_t length, bool streaming,
+                         JS::OffThreadCompileCallback callback, void* callbackData)
+{
+    // Suppress GC so that calls below do not trigger a new incremental GC
+    // which could require barriers on the atoms compartment.
+    gc::AutoSuppressGC nogc(cx);
+    gc::AutoAssertNoNurseryAlloc noNurseryAlloc(cx->runtime());
+    AutoSuppressAllocationMetadataBuilder suppressMetadata(cx);
+
+    JSObject* global = CreateGlobalForOffThreadParse(cx, ParseTaskKind::ScriptDecode, nogc);
+    if (!global)
+        return nullptr;
+
+    UniquePtr<uint8_t[], JS::FreePolicy> streamBuffer;
+    if (streaming) {
+        streamBuffer.reset(cx->pod_malloc<uint8_t>(mozilla::Max<uint32_t>(length, 1)));
+        if (!streamBuffer)
+            return nullptr;
+        data = streamBuffer.get();
+    }
+
+    ScopedJSDeletePtr<ExclusiveContext> helpercx(
+        cx->new_<ExclusiveContext>(cx->runtime(), (PerThreadData*) nullptr,
+                                   ExclusiveContext::Context_Exclusive, cx->options()));
+    if (!helpercx)
+        return nullptr;
+
+    ScopedJSDeletePtr<ScriptDecodeTask> task(
+        cx->new_<ScriptDecodeTask>(helpercx.get(), global, cx, data, length,
+                                   callback, callbackData));
+    if (!task)
+        return nullptr;
+
+    helpercx.forget();
+
+    if (streaming) {
+        task->streamBuffer = mozilla::Move(streamBuffer);
+        task->received = 0;
+        task->streamEnded = false;
+    }
+
+    if (!task->init(cx, options) || !QueueOffThreadParseTask(cx, task))
+        return nullptr;
+
+    return task.forget();
+}
+
+bool
+js::StartOffThreadDecodeScript(JSContext* cx, const ReadOnlyCompileOptions& options,
+                               const void* data, uint32_t length,
+                               JS::OffThreadCompileCallback callback, void* callbackData)
+{
+    return !!StartOffThreadDecodeTask(cx, options, data, length, /* streaming = */ false,
+                                      callback, callbackData);
+}
+
+ScriptDecodeTask*
+js::StartOffThreadStreamingDecodeScript(JSContext* cx, const ReadOnlyCompileOptions& options,
+                                        uint32_t length,
+                                        JS::OffThreadCompileCallback callback, void* callbackData)
+{
+    return StartOffThreadDecodeTask(cx, options, nullptr, length, /* streaming = */ true,
+                                    callback, callbackData);
+}
+
 void
 js::EnqueuePendingParseTasksAfterGC(JSRuntime* rt)
 {
@@ -740,6 +965,7 @@ GlobalHelperThreadState::GlobalHelperThreadState()
    threadCount(0),
    threads(nullptr),
    wasmCompilationInProgress(false),
+   concurrentParseTasksEnabled(false),
    numWasmFailedJobs(0)
 {
     cpuCount = GetCPUCount();
@@ -873,17 +1099,32 @@ GlobalHelperThreadState::maxWasmCompilationThreads() const
     return cpuCount;
 }
 
+size_t
+GlobalHelperThreadState::maxWasmTierUpThreads() const
+{
+    // A tier-up task compiles a whole module and may itself use helper threads
+    // for parallel compilation, so run one at a time.
+    return 1;
+}
+
 size_t
 GlobalHelperThreadState::maxParseThreads() const
 {
     if (IsHelperThreadSimulatingOOM(js::oom::THREAD_TYPE_PARSE))
         return 1;
 
-    // Don't allow simultaneous off thread parses, to reduce contention on the
-    // atoms table. Note that asm.js compilation depends on this to avoid
-    // stalling the helper thread, as off thread parse tasks can trigger and
-    // block on other off thread asm.js compilation tasks.
-    return 1;
+    // Unless enabled, don't allow simultaneous off thread parses, to reduce
+    // contention on the atoms table and the memory and CPU they use.
+    if (!concurrentParseTasksEnabled)
+        return 1;
+
+    // Parse tasks for different scripts can run in parallel: each one parses
+    // into its own zone, and only atomization is serialized, under the
+    // runtime's exclusive access lock. A parse task compiling asm.js may block
+    // its thread on wasm compilation tasks, but wasmCompilationInProgress
+    // ensures at most one thread does so at a time, and the other parse tasks
+    // finish without waiting on anything.
+    return threadCount;
 }
 
 size_t
@@ -925,6 +1166,13 @@ GlobalHelperThreadState::canStartWasmCompile(const AutoLockHelperThreadState& lo
     return true;
 }
 
+bool
+GlobalHelperThreadState::canStartWasmTierUp(const AutoLockHelperThreadState& lock)
+{
+    return !wasmTierUpWorklist(lock).empty() &&
+           checkTaskThreadLimit<wasm::TierUpTask*>(maxWasmTierUpThreads());
+}
+
 bool
 GlobalHelperThreadState::canStartPromiseTask(const AutoLockHelperThreadState& lock)
 {
@@ -934,20 +1182,9 @@ GlobalHelperThreadState::canStartPromiseTask(const AutoLockHelperThreadState& lo
 static bool
 IonBuilderHasHigherPriority(jit::IonBuilder* first, jit::IonBuilder* second)
 {
-    // This method can return whatever it wants, though it really ought to be a
-    // total order. The ordering is allowed to race (change on the fly), however.
-
-    // A lower optimization level indicates a higher priority.
-    if (first->optimizationInfo().level() != second->optimizationInfo().level())
-        return first->optimizationInfo().level() < second->optimizationInfo().level();
-
-    // A script without an IonScript has precedence on one with.
-    if (first->scriptHasIonScript() != second->scriptHasIonScript())
-        return !first->scriptHasIonScript();
-
-    // A higher warm-up counter indicates a higher priority.
-    return first->script()->getWarmUpCount() / first->script()->length() >
-           second->script()->getWarmUpCount() / second->script()->length();
+    // Priorities are computed when builders are queued and do not change
+    // afterwards, so this agrees with the order of the worklist.
+    return first->priority() > second->priority();
 }
 
 bool
@@ -968,15 +1205,7 @@ GlobalHelperThreadState::highestPriorityPendingIonCompile(const AutoLockHelperTh
     }
 
     // Get the highest priority IonBuilder which has not started compilation yet.
-    size_t index = 0;
-    for (size_t i = 1; i < worklist.length(); i++) {
-        if (IonBuilderHasHigherPriority(worklist[i], worklist[index]))
-            index = i;
-    }
-    jit::IonBuilder* builder = worklist[index];
-    if (remove)
-        worklist.erase(&worklist[index]);
-    return builder;
+    return remove ? worklist.removeHighest() : worklist.highest();
 }
 
 HelperThread*
@@ -1296,6 +1525,14 @@ GlobalHelperThreadState::finishModuleParseTask(JSContext* cx, void* token)
     return module;
 }
 
+JSScript*
+GlobalHelperThreadState::finishScriptDecodeTask(JSContext* cx, void* token)
+{
+    JSScript* script = finishParseTask(cx, ParseTaskKind::ScriptDecode, token);
+    MOZ_ASSERT_IF(script, script->isGlobalCode());
+    return script;
+}
+
 void
 GlobalHelperThreadState::cancelParseTask(JSContext* cx, ParseTaskKind kind, void* token)
 {
@@ -1436,6 +1673,30 @@ HelperThread::handleWasmWorkload(AutoLockHelperThreadState& locked)
     currentTask.reset();
 }
 
+void
+HelperThread::handleWasmTierUpWorkload(AutoLockHelperThreadState& locked)
+{
+    MOZ_ASSERT(HelperThreadState().canStartWasmTierUp(locked));
+    MOZ_ASSERT(idle());
+
+    currentTask.emplace(HelperThreadState().wasmTierUpWorklist(locked).popCopy());
+
+    wasm::TierUpTask* task = wasmTierUpTask();
+    {
+        AutoUnlockHelperThreadState unlock(locked);
+        task->execute();
+    }
+
+    // The owner of a cancelled task left it for us to delete.
+    if (task->orphaned())
+        js_delete(task);
+    else
+        task->setFinished();
+
+    HelperThreadState().notifyAll(GlobalHelperThreadState::CONSUMER, locked);
+    currentTask.reset();
+}
+
 void
 HelperThread::handlePromiseTaskWorkload(AutoLockHelperThreadState& locked)
 {
@@ -1477,10 +1738,11 @@ HelperThread::handleIonWorkload(AutoLockHelperThreadState& locked)
         HelperThreadState().highestPriorityPendingIonCompile(locked, /* remove = */ true);
 
     // If there are now too many threads with active IonBuilders, indicate to
-    // the one with the lowest priority that it should pause. Note that due to
-    // builder priorities changing since pendingIonCompileHasSufficientPriority
-    // was called, the builder we are pausing may actually be higher priority
-    // than the one we are about to start. Oh well.
+    // the one with the lowest priority that it should pause. Note that if
+    // other threads have taken higher priority builders off the worklist since
+    // pendingIonCompileHasSufficientPriority was called, the builder we are
+    // pausing may actually be higher priority than the one we are about to
+    // start. Oh well.
     HelperThread* other = HelperThreadState().lowestPriorityUnpausedIonCompileAtThreshold(locked);
     if (other) {
         MOZ_ASSERT(other->ionBuilder() && !other->pause);
@@ -1623,7 +1885,20 @@ HelperThread::handleParseWorkload(AutoLockHelperThreadState& locked, uintptr_t s
         AutoUnlockHelperThreadState unlock(locked);
         PerThreadData::AutoEnterRuntime enter(threadData.ptr(),
                                               task->exclusiveContextGlobal->runtimeFromAnyThread());
+#ifdef OMR // Helper threads
+        // The task's atoms and scripts go straight into the OMR heap, through
+        // this thread's own TLH.
+        omrVMThread = Nursery::attachThread("JS Helper");
+        if (omrVMThread) {
+            task->parse();
+            Nursery::detachThread(omrVMThread);
+            omrVMThread = nullptr;
+        } else {
+            task->outOfMemory = true;
+        }
+#else
         task->parse();
+#endif // OMR Helper threads
     }
 
     // The callback is invoked while we are still off the main thread.
@@ -1854,6 +2129,7 @@ HelperThread::threadLoop()
                 HelperThreadState().canStartPromiseTask(lock) ||
                 HelperThreadState().canStartParseTask(lock) ||
                 HelperThreadState().canStartCompressionTask(lock) ||
+                HelperThreadState().canStartWasmTierUp(lock) ||
                 HelperThreadState().canStartGCHelperTask(lock) ||
                 HelperThreadState().canStartGCParallelTask(lock))
             {
@@ -1877,6 +2153,9 @@ HelperThread::threadLoop()
         } else if (HelperThreadState().canStartCompressionTask(lock)) {
             js::oom::SetThreadType(js::oom::THREAD_TYPE_COMPRESS);
             handleCompressionWorkload(lock);
+        } else if (HelperThreadState().canStartWasmTierUp(lock)) {
+            js::oom::SetThreadType(js::oom::THREAD_TYPE_ASMJS);
+            handleWasmTierUpWorkload(lock);
         } else if (HelperThreadState().canStartGCHelperTask(lock)) {
             js::oom::SetThreadType(js::oom::THREAD_TYPE_GCHELPER);
             handleGCHelperWorkload(lock);
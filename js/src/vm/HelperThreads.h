@@ -20,10 +20,13 @@
 
 #include "jscntxt.h"
 
+#include "ds/PriorityQueue.h"
 #include "frontend/TokenStream.h"
 #include "jit/Ion.h"
 #include "threading/ConditionVariable.h"
 #include "threading/Mutex.h"
+#include "vm/Compression.h"
+#include "vm/Xdr.h"
 
 namespace JS {
 struct Zone;
@@ -36,6 +39,7 @@ class AutoUnlockHelperThreadState;
 class PromiseTask;
 struct HelperThread;
 struct ParseTask;
+struct ScriptDecodeTask;
 namespace jit {
   class IonBuilder;
 } // namespace jit
@@ -43,13 +47,16 @@ namespace wasm {
   class FuncIR;
   class FunctionCompileResults;
   class IonCompileTask;
+  class TierUpTask;
   typedef Vector<IonCompileTask*, 0, SystemAllocPolicy> IonCompileTaskPtrVector;
+  typedef Vector<TierUpTask*, 0, SystemAllocPolicy> TierUpTaskPtrVector;
 } // namespace wasm
 
 enum class ParseTaskKind
 {
     Script,
-    Module
+    Module,
+    ScriptDecode
 };
 
 // Per-process state for off thread work items.
@@ -67,6 +74,12 @@ class GlobalHelperThreadState
     size_t threadCount;
 
     typedef Vector<jit::IonBuilder*, 0, SystemAllocPolicy> IonBuilderVector;
+
+    // Orders pending Ion compilations by IonBuilder::priority(). Defined in
+    // HelperThreads.cpp, the only place the worklist is modified.
+    struct IonBuilderPriority;
+    typedef PriorityQueue<jit::IonBuilder*, IonBuilderPriority, 0, SystemAllocPolicy>
+        IonBuilderWorklist;
     typedef Vector<ParseTask*, 0, SystemAllocPolicy> ParseTaskVector;
     typedef Vector<SourceCompressionTask*, 0, SystemAllocPolicy> SourceCompressionTaskVector;
     typedef Vector<GCHelperState*, 0, SystemAllocPolicy> GCHelperStateVector;
@@ -81,7 +94,8 @@ class GlobalHelperThreadState
     // The lists below are all protected by |lock|.
 
     // Ion compilation worklist and finished jobs.
-    IonBuilderVector ionWorklist_, ionFinishedList_;
+    IonBuilderWorklist ionWorklist_;
+    IonBuilderVector ionFinishedList_;
 
     // wasm worklist and finished jobs.
     wasm::IonCompileTaskPtrVector wasmWorklist_, wasmFinishedList_;
@@ -91,7 +105,14 @@ class GlobalHelperThreadState
     // time. This avoids race conditions on wasmWorklist/wasmFinishedList/etc.
     mozilla::Atomic<bool> wasmCompilationInProgress;
 
+    // Whether parse tasks for different scripts may run on several helper
+    // threads at once; see JS_SetConcurrentParseTasksEnabled.
+    mozilla::Atomic<bool> concurrentParseTasksEnabled;
+
   private:
+    // wasm modules being recompiled with Ion for tiered compilation.
+    wasm::TierUpTaskPtrVector wasmTierUpWorklist_;
+
     // Async tasks that, upon completion, are dispatched back to the JSContext's
     // owner thread via embedding callbacks instead of a finished list.
     PromiseTaskVector promiseTasks_;
@@ -117,6 +138,7 @@ class GlobalHelperThreadState
     size_t maxIonCompilationThreads() const;
     size_t maxUnpausedIonCompilationThreads() const;
     size_t maxWasmCompilationThreads() const;
+    size_t maxWasmTierUpThreads() const;
     size_t maxParseThreads() const;
     size_t maxCompressionThreads() const;
     size_t maxGCHelperThreads() const;
@@ -140,7 +162,11 @@ class GlobalHelperThreadState
 
         // For notifying threads doing work which are paused that they may be
         // able to resume making progress.
-        PAUSE
+        PAUSE,
+
+        // For notifying threads doing work which are waiting for their input
+        // that more of it has arrived.
+        INPUT
     };
 
     void wait(AutoLockHelperThreadState& locked, CondVar which,
@@ -156,7 +182,7 @@ class GlobalHelperThreadState
         vector.popBack();
     }
 
-    IonBuilderVector& ionWorklist(const AutoLockHelperThreadState&) {
+    IonBuilderWorklist& ionWorklist(const AutoLockHelperThreadState&) {
         return ionWorklist_;
     }
     IonBuilderVector& ionFinishedList(const AutoLockHelperThreadState&) {
@@ -170,6 +196,10 @@ class GlobalHelperThreadState
         return wasmFinishedList_;
     }
 
+    wasm::TierUpTaskPtrVector& wasmTierUpWorklist(const AutoLockHelperThreadState&) {
+        return wasmTierUpWorklist_;
+    }
+
     PromiseTaskVector& promiseTasks(const AutoLockHelperThreadState&) {
         return promiseTasks_;
     }
@@ -197,6 +227,7 @@ class GlobalHelperThreadState
     }
 
     bool canStartWasmCompile(const AutoLockHelperThreadState& lock);
+    bool canStartWasmTierUp(const AutoLockHelperThreadState& lock);
     bool canStartPromiseTask(const AutoLockHelperThreadState& lock);
     bool canStartIonCompile(const AutoLockHelperThreadState& lock);
     bool canStartParseTask(const AutoLockHelperThreadState& lock);
@@ -246,6 +277,7 @@ class GlobalHelperThreadState
   public:
     JSScript* finishScriptParseTask(JSContext* cx, void* token);
     JSObject* finishModuleParseTask(JSContext* cx, void* token);
+    JSScript* finishScriptDecodeTask(JSContext* cx, void* token);
     bool compressionInProgress(SourceCompressionTask* task, const AutoLockHelperThreadState& lock);
     SourceCompressionTask* compressionTaskForSource(ScriptSource* ss, const AutoLockHelperThreadState& lock);
 
@@ -267,12 +299,14 @@ class GlobalHelperThreadState
     js::ConditionVariable consumerWakeup;
     js::ConditionVariable producerWakeup;
     js::ConditionVariable pauseWakeup;
+    js::ConditionVariable inputWakeup;
 
     js::ConditionVariable& whichWakeup(CondVar which) {
         switch (which) {
           case CONSUMER: return consumerWakeup;
           case PRODUCER: return producerWakeup;
           case PAUSE: return pauseWakeup;
+          case INPUT: return inputWakeup;
           default: MOZ_CRASH("Invalid CondVar in |whichWakeup|");
         }
     }
@@ -306,9 +340,18 @@ struct HelperThread
      */
     mozilla::Atomic<bool, mozilla::Relaxed> pause;
 
+#ifdef OMR // Helper threads
+    /*
+     * The thread's OMR_VMThread while it runs a parse task, through which
+     * the task allocates; see Nursery::attachThread.
+     */
+    OMR_VMThread* omrVMThread;
+#endif // OMR Helper threads
+
     /* The current task being executed by this thread, if any. */
     mozilla::Maybe<mozilla::Variant<jit::IonBuilder*,
                                     wasm::IonCompileTask*,
+                                    wasm::TierUpTask*,
                                     PromiseTask*,
                                     ParseTask*,
                                     SourceCompressionTask*,
@@ -329,6 +372,11 @@ struct HelperThread
         return maybeCurrentTaskAs<wasm::IonCompileTask*>();
     }
 
+    /* Any wasm module being recompiled for tier-up on this thread. */
+    wasm::TierUpTask* wasmTierUpTask() {
+        return maybeCurrentTaskAs<wasm::TierUpTask*>();
+    }
+
     /* Any source being parsed/emitted on this thread. */
     ParseTask* parseTask() {
         return maybeCurrentTaskAs<ParseTask*>();
@@ -364,6 +412,7 @@ struct HelperThread
     }
 
     void handleWasmWorkload(AutoLockHelperThreadState& locked);
+    void handleWasmTierUpWorkload(AutoLockHelperThreadState& locked);
     void handlePromiseTaskWorkload(AutoLockHelperThreadState& locked);
     void handleIonWorkload(AutoLockHelperThreadState& locked);
     void handleParseWorkload(AutoLockHelperThreadState& locked, uintptr_t stackLimit);
@@ -391,6 +440,11 @@ EnsureHelperThreadsInitialized();
 void
 SetFakeCPUCount(size_t count);
 
+// Allow parse tasks for different scripts to run on several helper threads at
+// once, rather than one at a time.
+void
+SetConcurrentParseTasksEnabled(bool enabled);
+
 // Pause the current thread until it's pause flag is unset.
 void
 PauseCurrentHelperThread();
@@ -399,6 +453,20 @@ PauseCurrentHelperThread();
 bool
 StartOffThreadWasmCompile(wasm::IonCompileTask* task);
 
+/*
+ * Recompile a wasm module for tier-up. Once started, the task is owned by the
+ * helper threads until it has finished or been cancelled.
+ */
+bool
+StartOffThreadWasmTierUp(wasm::TierUpTask* task);
+
+/*
+ * Cancel a tier-up task that is queued or running, or delete a finished one.
+ * A running task is deleted by its helper thread once it completes.
+ */
+void
+CancelOffThreadWasmTierUp(wasm::TierUpTask* task);
+
 /*
  * Start executing the given PromiseTask on a helper thread, finishing back on
  * the originating JSContext's owner thread.
@@ -481,6 +549,25 @@ StartOffThreadParseModule(JSContext* cx, const ReadOnlyCompileOptions& options,
                           const char16_t* chars, size_t length,
                           JS::OffThreadCompileCallback callback, void* callbackData);
 
+/*
+ * Start decoding an XDR encoded script. The data must stay alive until the
+ * decoding finishes.
+ */
+bool
+StartOffThreadDecodeScript(JSContext* cx, const ReadOnlyCompileOptions& options,
+                           const void* data, uint32_t length,
+                           JS::OffThreadCompileCallback callback, void* callbackData);
+
+/*
+ * Start decoding an XDR encoded script of |length| bytes whose data has not
+ * arrived yet. The returned task is fed with ScriptDecodeTask::appendData and
+ * decodes each part of the script as soon as its bytes are available.
+ */
+ScriptDecodeTask*
+StartOffThreadStreamingDecodeScript(JSContext* cx, const ReadOnlyCompileOptions& options,
+                                    uint32_t length,
+                                    JS::OffThreadCompileCallback callback, void* callbackData);
+
 /*
  * Called at the end of GC to enqueue any Parse tasks that were waiting on an
  * atoms-zone GC to finish.
@@ -592,6 +679,37 @@ struct ModuleParseTask : public ParseTask
     void parse() override;
 };
 
+struct ScriptDecodeTask : public ParseTask, public XDRStream
+{
+    // The encoded script. For streaming decodes this is streamBuffer, which
+    // is filled in as the data arrives.
+    const void* data;
+    uint32_t dataLength;
+
+    // For streaming decodes, the number of bytes received so far and whether
+    // the stream has ended. Both are protected by the helper thread lock, and
+    // the bytes of the buffer below |received| are not written again.
+    UniquePtr<uint8_t[], JS::FreePolicy> streamBuffer;
+    uint32_t received;
+    bool streamEnded;
+
+    ScriptDecodeTask(ExclusiveContext* cx, JSObject* exclusiveContextGlobal,
+                     JSContext* initCx, const void* data, uint32_t length,
+                     JS::OffThreadCompileCallback callback, void* callbackData);
+    void parse() override;
+
+    bool isStreaming() const {
+        return !!streamBuffer;
+    }
+
+    // Called on any thread to deliver the next bytes of a streaming decode,
+    // and to signal that no more will arrive.
+    bool appendData(const void* bytes, uint32_t length);
+    void endStream(const AutoLockHelperThreadState& lock);
+
+    size_t waitForLength(size_t length) override;
+};
+
 // Return whether, if a new parse task was started, it would need to wait for
 // an in-progress GC to complete before starting.
 extern bool
@@ -614,6 +732,10 @@ struct SourceCompressionTask
 
     ScriptSource* ss;
 
+    // Codec to compress with, read from the triggering context's options so
+    // the helper thread doesn't need to touch |cx|.
+    Compressor::Codec codec;
+
     // Atomic flag to indicate to a helper thread that it should abort
     // compression on the source.
     mozilla::Atomic<bool, mozilla::Relaxed> abort_;
@@ -632,6 +754,7 @@ struct SourceCompressionTask
       : helperThread(nullptr)
       , cx(cx)
       , ss(nullptr)
+      , codec(cx->options().lz4SourceCompression() ? Compressor::LZ4 : Compressor::Zlib)
       , abort_(false)
       , result(OOM)
     {}
@@ -15,6 +15,7 @@
 #include "jstypes.h"
 
 #include "builtin/AtomicsObject.h"
+#include "ds/LifoAlloc.h"
 #include "ds/MemoryProtectionExceptionHandler.h"
 #include "gc/Statistics.h"
 #include "jit/ExecutableAllocator.h"
@@ -114,6 +115,7 @@ JS::detail::InitWithFailureDiagnostic(bool isDebugBuild)
         return "u_init() failed";
 #endif // EXPOSE_INTL_API
 
+    RETURN_IF_FAIL(js::CreateLifoChunkPool());
     RETURN_IF_FAIL(js::CreateHelperThreadsState());
     RETURN_IF_FAIL(FutexRuntime::initialize());
     RETURN_IF_FAIL(js::gcstats::Statistics::initialize());
@@ -150,6 +152,8 @@ JS_ShutDown(void)
 
     js::MemoryProtectionExceptionHandler::uninstall();
 
+    js::DestroyLifoChunkPool();
+
     // The only difficult-to-address reason for the restriction that you can't
     // call JS_Init/stuff/JS_ShutDown multiple times is the Windows PRMJ
     // NowInit initialization code, which uses PR_CallOnce to initialize the
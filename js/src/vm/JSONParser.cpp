@@ -6,12 +6,22 @@
 
 #include "vm/JSONParser.h"
 
+#include "mozilla/EndianUtils.h"
+#include "mozilla/MathAlgorithms.h"
 #include "mozilla/Range.h"
 #include "mozilla/RangedPtr.h"
 #include "mozilla/Sprintf.h"
 
 #include <ctype.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define JS_JSON_SSE2
+# include <emmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && MOZ_LITTLE_ENDIAN
+# define JS_JSON_NEON
+# include <arm_neon.h>
+#endif
+
 #include "jsarray.h"
 #include "jscompartment.h"
 #include "jsnum.h"
@@ -23,8 +33,241 @@
 
 using namespace js;
 
+using mozilla::CountTrailingZeroes32;
+using mozilla::CountTrailingZeroes64;
 using mozilla::RangedPtr;
 
+/*
+ * Scanning the long runs of string characters, whitespace and digits in large
+ * JSON texts dominates parsing, so when vector instructions are available at
+ * compile time, CharVector<CharT> lets the scans below examine a register's
+ * worth of characters at a time.
+ */
+#if defined(JS_JSON_SSE2) || defined(JS_JSON_NEON)
+# define JS_JSON_SIMD
+
+template <typename CharT>
+struct CharVector;
+
+# if defined(JS_JSON_SSE2)
+template <>
+struct CharVector<Latin1Char>
+{
+    typedef __m128i V;
+    static const size_t Length = 16;
+
+    static V load(const Latin1Char* p) { return _mm_loadu_si128(reinterpret_cast<const V*>(p)); }
+    static V splat(int c) { return _mm_set1_epi8(char(c)); }
+    static V eq(V a, V b) { return _mm_cmpeq_epi8(a, b); }
+    static V lessThan(V a, V b) { return _mm_cmplt_epi8(a, b); }
+    static V greaterThan(V a, V b) { return _mm_cmpgt_epi8(a, b); }
+    static V sub(V a, V b) { return _mm_sub_epi8(a, b); }
+    static V and_(V a, V b) { return _mm_and_si128(a, b); }
+    static V or_(V a, V b) { return _mm_or_si128(a, b); }
+
+    // The index of the first lane of |v| that is set, or Length.
+    static size_t firstSet(V v) {
+        uint32_t mask = _mm_movemask_epi8(v);
+        return mask ? CountTrailingZeroes32(mask) : Length;
+    }
+    static size_t firstClear(V v) {
+        uint32_t mask = ~_mm_movemask_epi8(v) & 0xffff;
+        return mask ? CountTrailingZeroes32(mask) : Length;
+    }
+};
+
+template <>
+struct CharVector<char16_t>
+{
+    typedef __m128i V;
+    static const size_t Length = 8;
+
+    static V load(const char16_t* p) { return _mm_loadu_si128(reinterpret_cast<const V*>(p)); }
+    static V splat(int c) { return _mm_set1_epi16(int16_t(c)); }
+    static V eq(V a, V b) { return _mm_cmpeq_epi16(a, b); }
+    static V lessThan(V a, V b) { return _mm_cmplt_epi16(a, b); }
+    static V greaterThan(V a, V b) { return _mm_cmpgt_epi16(a, b); }
+    static V sub(V a, V b) { return _mm_sub_epi16(a, b); }
+    static V and_(V a, V b) { return _mm_and_si128(a, b); }
+    static V or_(V a, V b) { return _mm_or_si128(a, b); }
+
+    // Each 16-bit lane contributes two bits to the byte mask.
+    static size_t firstSet(V v) {
+        uint32_t mask = _mm_movemask_epi8(v);
+        return mask ? CountTrailingZeroes32(mask) / 2 : Length;
+    }
+    static size_t firstClear(V v) {
+        uint32_t mask = ~_mm_movemask_epi8(v) & 0xffff;
+        return mask ? CountTrailingZeroes32(mask) / 2 : Length;
+    }
+};
+# else
+template <>
+struct CharVector<Latin1Char>
+{
+    typedef uint8x16_t V;
+    static const size_t Length = 16;
+
+    static V load(const Latin1Char* p) { return vld1q_u8(p); }
+    static V splat(int c) { return vdupq_n_u8(uint8_t(c)); }
+    static V eq(V a, V b) { return vceqq_u8(a, b); }
+    static V lessThan(V a, V b) {
+        return vcltq_s8(vreinterpretq_s8_u8(a), vreinterpretq_s8_u8(b));
+    }
+    static V greaterThan(V a, V b) {
+        return vcgtq_s8(vreinterpretq_s8_u8(a), vreinterpretq_s8_u8(b));
+    }
+    static V sub(V a, V b) { return vsubq_u8(a, b); }
+    static V and_(V a, V b) { return vandq_u8(a, b); }
+    static V or_(V a, V b) { return vorrq_u8(a, b); }
+
+    // Narrowing each 16-bit pair of lanes by 4 bits leaves a nibble per lane.
+    static size_t firstSet(V v) {
+        uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(v), 4);
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+        return mask ? CountTrailingZeroes64(mask) / 4 : Length;
+    }
+    static size_t firstClear(V v) { return firstSet(vmvnq_u8(v)); }
+};
+
+template <>
+struct CharVector<char16_t>
+{
+    typedef uint16x8_t V;
+    static const size_t Length = 8;
+
+    static V load(const char16_t* p) { return vld1q_u16(reinterpret_cast<const uint16_t*>(p)); }
+    static V splat(int c) { return vdupq_n_u16(uint16_t(c)); }
+    static V eq(V a, V b) { return vceqq_u16(a, b); }
+    static V lessThan(V a, V b) {
+        return vcltq_s16(vreinterpretq_s16_u16(a), vreinterpretq_s16_u16(b));
+    }
+    static V greaterThan(V a, V b) {
+        return vcgtq_s16(vreinterpretq_s16_u16(a), vreinterpretq_s16_u16(b));
+    }
+    static V sub(V a, V b) { return vsubq_u16(a, b); }
+    static V and_(V a, V b) { return vandq_u16(a, b); }
+    static V or_(V a, V b) { return vorrq_u16(a, b); }
+
+    // Narrowing each lane to a byte leaves 8 bits per lane.
+    static size_t firstSet(V v) {
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(v)), 0);
+        return mask ? CountTrailingZeroes64(mask) / 8 : Length;
+    }
+    static size_t firstClear(V v) { return firstSet(vmvnq_u16(v)); }
+};
+# endif
+#endif // JS_JSON_SIMD
+
+static inline bool
+IsJSONWhitespace(char16_t c)
+{
+    return c == '\t' || c == '\r' || c == '\n' || c == ' ';
+}
+
+/*
+ * Each scan finds the first character that its |stop| predicate holds for.
+ * |vectorStop| evaluates the same predicate across a vector of characters and
+ * returns the index of the first lane it holds for, or the vector's length.
+ */
+struct StringSpecialScan
+{
+    // A quote, a backslash or a control character, which all end a run of
+    // characters that can be copied verbatim.
+    template <typename CharT>
+    static bool stop(CharT c) {
+        return c == '"' || c == '\\' || c <= 0x001F;
+    }
+
+#ifdef JS_JSON_SIMD
+    template <typename Vec>
+    static size_t vectorStop(typename Vec::V chars) {
+        // Characters of the control range are those with only their low five
+        // bits set, which a signed comparison cannot test for 0x80 and above.
+        typename Vec::V special = Vec::or_(Vec::eq(chars, Vec::splat('"')),
+                                           Vec::eq(chars, Vec::splat('\\')));
+        typename Vec::V control = Vec::eq(Vec::and_(chars, Vec::splat(~0x1F)), Vec::splat(0));
+        return Vec::firstSet(Vec::or_(special, control));
+    }
+#endif
+};
+
+struct NonWhitespaceScan
+{
+    template <typename CharT>
+    static bool stop(CharT c) {
+        return !IsJSONWhitespace(c);
+    }
+
+#ifdef JS_JSON_SIMD
+    template <typename Vec>
+    static size_t vectorStop(typename Vec::V chars) {
+        typename Vec::V space = Vec::or_(Vec::or_(Vec::eq(chars, Vec::splat(' ')),
+                                                  Vec::eq(chars, Vec::splat('\n'))),
+                                         Vec::or_(Vec::eq(chars, Vec::splat('\r')),
+                                                  Vec::eq(chars, Vec::splat('\t'))));
+        return Vec::firstClear(space);
+    }
+#endif
+};
+
+struct NonDigitScan
+{
+    template <typename CharT>
+    static bool stop(CharT c) {
+        return !JS7_ISDEC(c);
+    }
+
+#ifdef JS_JSON_SIMD
+    template <typename Vec>
+    static size_t vectorStop(typename Vec::V chars) {
+        // After subtracting '0', digits are exactly the lanes in [0, 10) when
+        // compared as signed; no other character wraps into that range.
+        typename Vec::V offset = Vec::sub(chars, Vec::splat('0'));
+        typename Vec::V digit = Vec::and_(Vec::greaterThan(offset, Vec::splat(-1)),
+                                          Vec::lessThan(offset, Vec::splat(10)));
+        return Vec::firstClear(digit);
+    }
+#endif
+};
+
+template <typename Scan, typename CharT>
+static MOZ_ALWAYS_INLINE const CharT*
+ScanChars(const CharT* p, const CharT* end)
+{
+#ifdef JS_JSON_SIMD
+    typedef CharVector<CharT> Vec;
+    while (size_t(end - p) >= Vec::Length) {
+        size_t index = Scan::template vectorStop<Vec>(Vec::load(p));
+        if (index < Vec::Length)
+            return p + index;
+        p += Vec::Length;
+    }
+#endif
+    while (p < end && !Scan::stop(*p))
+        p++;
+    return p;
+}
+
+template <typename Scan, typename CharT>
+static MOZ_ALWAYS_INLINE void
+AdvanceUntil(RangedPtr<const CharT>& current, const RangedPtr<const CharT>& end)
+{
+    current += ScanChars<Scan>(current.get(), end.get()) - current.get();
+}
+
+template <typename CharT>
+static MOZ_ALWAYS_INLINE void
+SkipWhitespace(RangedPtr<const CharT>& current, const RangedPtr<const CharT>& end)
+{
+    // Most runs of whitespace are empty or a single space, so only start a
+    // vector scan once a run is under way.
+    if (current < end && IsJSONWhitespace(*current)) {
+        current++;
+        AdvanceUntil<NonWhitespaceScan>(current, end);
+    }
+}
+
 JSONParserBase::~JSONParserBase()
 {
     for (size_t i = 0; i < stack.length(); i++) {
@@ -129,7 +372,8 @@ JSONParser<CharT>::readString()
      * string directly from the source text.
      */
     CharPtr start = current;
-    for (; current < end; current++) {
+    AdvanceUntil<StringSpecialScan>(current, end);
+    if (current < end) {
         if (*current == '"') {
             size_t length = current - start;
             current++;
@@ -141,10 +385,7 @@ JSONParser<CharT>::readString()
             return stringToken(str);
         }
 
-        if (*current == '\\')
-            break;
-
-        if (*current <= 0x001F) {
+        if (*current != '\\') {
             error("bad control character in string literal");
             return token(Error);
         }
@@ -231,10 +472,7 @@ JSONParser<CharT>::readString()
             return token(OOM);
 
         start = current;
-        for (; current < end; current++) {
-            if (*current == '"' || *current == '\\' || *current <= 0x001F)
-                break;
-        }
+        AdvanceUntil<StringSpecialScan>(current, end);
     } while (current < end);
 
     error("unterminated string");
@@ -268,12 +506,8 @@ JSONParser<CharT>::readNumber()
         error("unexpected non-digit");
         return token(Error);
     }
-    if (*current++ != '0') {
-        for (; current < end; current++) {
-            if (!JS7_ISDEC(*current))
-                break;
-        }
-    }
+    if (*current++ != '0')
+        AdvanceUntil<NonDigitScan>(current, end);
 
     /* Fast path: no fractional or exponent part. */
     if (current == end || (*current != '.' && *current != 'e' && *current != 'E')) {
@@ -305,10 +539,8 @@ JSONParser<CharT>::readNumber()
             error("unterminated fractional number");
             return token(Error);
         }
-        while (++current < end) {
-            if (!JS7_ISDEC(*current))
-                break;
-        }
+        current++;
+        AdvanceUntil<NonDigitScan>(current, end);
     }
 
     /* ([eE][\+\-]?[0-9]+)? */
@@ -327,10 +559,8 @@ JSONParser<CharT>::readNumber()
             error("exponent part is missing a number");
             return token(Error);
         }
-        while (++current < end) {
-            if (!JS7_ISDEC(*current))
-                break;
-        }
+        current++;
+        AdvanceUntil<NonDigitScan>(current, end);
     }
 
     double d;
@@ -341,18 +571,11 @@ JSONParser<CharT>::readNumber()
     return numberToken(negative ? -d : d);
 }
 
-static inline bool
-IsJSONWhitespace(char16_t c)
-{
-    return c == '\t' || c == '\r' || c == '\n' || c == ' ';
-}
-
 template <typename CharT>
 JSONParserBase::Token
 JSONParser<CharT>::advance()
 {
-    while (current < end && IsJSONWhitespace(*current))
-        current++;
+    SkipWhitespace(current, end);
     if (current >= end) {
         error("unexpected end of data");
         return token(Error);
@@ -435,8 +658,7 @@ JSONParser<CharT>::advanceAfterObjectOpen()
 {
     MOZ_ASSERT(current[-1] == '{');
 
-    while (current < end && IsJSONWhitespace(*current))
-        current++;
+    SkipWhitespace(current, end);
     if (current >= end) {
         error("end of data while reading object contents");
         return token(Error);
@@ -488,8 +710,7 @@ JSONParser<CharT>::advanceAfterArrayElement()
 {
     AssertPastValue(current);
 
-    while (current < end && IsJSONWhitespace(*current))
-        current++;
+    SkipWhitespace(current, end);
     if (current >= end) {
         error("end of data when ',' or ']' was expected");
         return token(Error);
@@ -515,8 +736,7 @@ JSONParser<CharT>::advancePropertyName()
 {
     MOZ_ASSERT(current[-1] == ',');
 
-    while (current < end && IsJSONWhitespace(*current))
-        current++;
+    SkipWhitespace(current, end);
     if (current >= end) {
         error("end of data when property name was expected");
         return token(Error);
@@ -535,8 +755,7 @@ JSONParser<CharT>::advancePropertyColon()
 {
     MOZ_ASSERT(current[-1] == '"');
 
-    while (current < end && IsJSONWhitespace(*current))
-        current++;
+    SkipWhitespace(current, end);
     if (current >= end) {
         error("end of data after property name when ':' was expected");
         return token(Error);
@@ -557,8 +776,7 @@ JSONParser<CharT>::advanceAfterProperty()
 {
     AssertPastValue(current);
 
-    while (current < end && IsJSONWhitespace(*current))
-        current++;
+    SkipWhitespace(current, end);
     if (current >= end) {
         error("end of data after property value in object");
         return token(Error);
@@ -361,9 +361,9 @@ NativeObject::setLastPropertyMakeNonNative(Shape* shape)
     MOZ_ASSERT(shape->numFixedSlots() == 0);
 
     if (hasDynamicElements())
-        js_free(getElementsHeader());
+        gc::OmrGcHelper::freeObjectBuffer(getElementsHeader());
     if (hasDynamicSlots()) {
-        js_free(slots_);
+        gc::OmrGcHelper::freeObjectBuffer(slots_);
         slots_ = nullptr;
     }
 
@@ -460,10 +460,7 @@ NativeObject::growSlotsDontReportOOM(ExclusiveContext* cx, NativeObject* obj, ui
 static void
 FreeSlots(ExclusiveContext* cx, HeapSlot* slots)
 {
-    // Note: threads without a JSContext do not have access to GGC nursery allocated things.
-    if (cx->isJSContext())
-        return cx->asJSContext()->runtime()->gc.nursery.freeBuffer(slots);
-    js_free(slots);
+    gc::OmrGcHelper::freeObjectBuffer(slots);
 }
 
 void
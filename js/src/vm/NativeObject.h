@@ -409,10 +409,18 @@ class NativeObject : public ShapedObject
 
   public:
 	void deleteAllSlots() {
+		deleteAllSlots(gc::OmrGcHelper::freeObjectBuffer);
+	}
+
+	/* Pass each buffer deleteAllSlots would free to |freeBuffer| instead. */
+	template <typename F>
+	void deleteAllSlots(F freeBuffer) {
 		if (slots_ != 0) {
-			free(slots_);
+			freeBuffer(slots_);
 			slots_ = nullptr;
 		}
+		if (hasDynamicElements() && !denseElementsAreCopyOnWrite())
+			freeBuffer(getElementsHeader());
 	}
   
     Shape* lastProperty() const {
@@ -483,9 +491,9 @@ class NativeObject : public ShapedObject
 
     bool isInWholeCellBuffer() const {
 #ifdef OMR // Writebarriers
-        // OMRTODO: What are cell buffers and why are they tied to an arena?
-        // I think they are just used to 
-        return true;
+        // Whole cells are remembered in OMR's remembered set, which keeps its
+        // state in the cell header.
+        return isOmrRemembered();
 #else // OMR Writebarriers
         const gc::TenuredCell* cell = &asTenured();
         gc::ArenaCellSet* cells = cell->arena()->bufferedCells;
@@ -1015,7 +1023,13 @@ class NativeObject : public ShapedObject
     // single step.
     inline void elementsRangeWriteBarrierPost(uint32_t start, uint32_t count) {
 #ifdef OMR // Writebarrier
-        return;
+        for (size_t i = 0; i < count; i++) {
+            const Value& v = elements_[start + i];
+            if (v.isObject() && gc::OmrGcHelper::isInNewSpace(&v.toObject())) {
+                gc::OmrGcHelper::postBarrierOwned(this, &v.toObject());
+                return;
+            }
+        }
 #else // OMR Writebarrier
         for (size_t i = 0; i < count; i++) {
             const Value& v = elements_[start + i];
@@ -1072,8 +1086,13 @@ class NativeObject : public ShapedObject
         MOZ_ASSERT(dstStart + count <= getDenseCapacity());
         MOZ_ASSERT(!denseElementsAreCopyOnWrite());
 #ifdef OMR // Writebarriers
-        // OMRTODO: Add write barrier calls here
-        memcpy(&elements_[dstStart], src, count * sizeof(HeapSlot));
+        if (gc::OmrGcHelper::isConcurrentMarking()) {
+            for (uint32_t i = 0; i < count; ++i)
+                elements_[dstStart + i].set(this, HeapSlot::Element, dstStart + i, src[i]);
+        } else {
+            memcpy(&elements_[dstStart], src, count * sizeof(HeapSlot));
+            elementsRangeWriteBarrierPost(dstStart, count);
+        }
 #else // OMR Writebarriers
         // OMRTODO: Obtain the zone from a context
         if (JS::shadow::Zone::asShadowZone(zone())->needsIncrementalBarrier()) {
@@ -1111,11 +1130,10 @@ class NativeObject : public ShapedObject
          * the array before and after the move.
         */
 #if defined OMR // Writebarriers
-        // OMRTODO: Pull the zone from a context
-        // OMRTODO: Write barriers
-        memmove(elements_ + dstStart, elements_ + srcStart, count * sizeof(HeapSlot));
+        if (gc::OmrGcHelper::isConcurrentMarking()) {
 #else // OMR
         if (JS::shadow::Zone::asShadowZone(zone())->needsIncrementalBarrier()) {
+#endif // OMR
             if (dstStart < srcStart) {
                 HeapSlot* dst = elements_ + dstStart;
                 HeapSlot* src = elements_ + srcStart;
@@ -1131,7 +1149,6 @@ class NativeObject : public ShapedObject
             memmove(elements_ + dstStart, elements_ + srcStart, count * sizeof(HeapSlot));
             elementsRangeWriteBarrierPost(dstStart, count);
         }
-#endif // OMR
     }
 
     void moveDenseElementsNoPreBarrier(uint32_t dstStart, uint32_t srcStart, uint32_t count) {
@@ -1255,6 +1272,11 @@ class NativeObject : public ShapedObject
         gc::StoreBuffer* storeBuffer = (*cellp)->storeBuffer();
         if (storeBuffer)
             storeBuffer->putCell(cellp);
+#else // ! OMR Writebarrier
+        gc::Cell** cellp = reinterpret_cast<gc::Cell**>(pprivate);
+        MOZ_ASSERT(cellp);
+        MOZ_ASSERT(*cellp);
+        gc::OmrGcHelper::postBarrierOwned(this, *cellp);
 #endif // OMR
     }
 
@@ -1336,10 +1358,12 @@ inline void
 NativeObject::privateWriteBarrierPre(void** oldval)
 {
 #ifndef OMR // Writebarrier
-    // OMRTODO: Writebarrier
     JS::shadow::Zone* shadowZone = this->shadowZoneFromAnyThread();
     if (shadowZone->needsIncrementalBarrier() && *oldval && getClass()->hasTrace())
         getClass()->doTrace(shadowZone->barrierTracer(), this);
+#else // ! OMR Writebarrier
+    if (gc::OmrGcHelper::isConcurrentMarking() && *oldval && getClass()->hasTrace())
+        gc::OmrGcHelper::concurrentWriteBarrierPreChildren(this);
 #endif // ! OMR Writebarrier
 }
 
@@ -14,6 +14,7 @@
 #include "builtin/RegExp.h"
 #include "frontend/TokenStream.h"
 #include "irregexp/RegExpParser.h"
+#include "jit/IonCode.h"
 #include "vm/MatchPairs.h"
 #include "vm/RegExpStatics.h"
 #include "vm/StringBuffer.h"
@@ -30,6 +31,7 @@ using namespace js;
 using mozilla::ArrayLength;
 using mozilla::DebugOnly;
 using mozilla::Maybe;
+using mozilla::PodArrayZero;
 using mozilla::PodCopy;
 using js::frontend::TokenStream;
 
@@ -526,14 +528,68 @@ js::StringHasRegExpMetaChars(JSLinearString* str)
     return HasRegExpMetaChars(str->twoByteChars(nogc), str->length());
 }
 
+/* RegExpCode */
+
+RegExpCode::RegExpCode(JSAtom* source, RegExpFlag flags)
+  : source(source), flags(flags), parenCount(0), refCount(0), cached(false)
+{
+    PodArrayZero(byteCode);
+}
+
+RegExpCode::~RegExpCode()
+{
+    MOZ_ASSERT(!cached);
+
+    for (size_t i = 0; i < NumPrograms; i++)
+        js_free(byteCode[i]);
+    for (size_t i = 0; i < tables.length(); i++)
+        js_delete(tables[i]);
+}
+
+void
+RegExpCode::trace(JSTracer* trc)
+{
+    TraceEdge(trc, &source, "RegExpCode source");
+
+    for (size_t i = 0; i < NumPrograms; i++)
+        TraceNullableEdge(trc, &jitCode[i], "RegExpCode code");
+}
+
+size_t
+RegExpCode::sizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf)
+{
+    size_t n = mallocSizeOf(this);
+
+    for (size_t i = 0; i < NumPrograms; i++) {
+        if (byteCode[i])
+            n += mallocSizeOf(byteCode[i]);
+    }
+
+    n += tables.sizeOfExcludingThis(mallocSizeOf);
+    for (size_t i = 0; i < tables.length(); i++)
+        n += mallocSizeOf(tables[i]);
+
+    return n;
+}
+
 /* RegExpShared */
 
 RegExpShared::RegExpShared(JSAtom* source, RegExpFlag flags)
-  : source(source), flags(flags), parenCount(0), canStringMatch(false), marked_(false)
+  : source(source), flags(flags), parenCount(0), canStringMatch(false), marked_(false),
+    code_(nullptr)
 {}
 
 RegExpShared::~RegExpShared()
 {
+    if (code_) {
+        for (size_t i = 0; i < ArrayLength(compilationArray); i++) {
+            RegExpCompilation& compilation = compilationArray[i];
+            if (compilation.byteCode == code_->byteCode[i])
+                compilation.byteCode = nullptr;
+        }
+        code_->Release();
+    }
+
     for (size_t i = 0; i < tables.length(); i++)
         js_delete(tables[i]);
 }
@@ -570,6 +626,11 @@ RegExpShared::compile(JSContext* cx, HandleAtom pattern, HandleLinearString inpu
     if (!ignoreCase() && !StringHasRegExpMetaChars(pattern))
         canStringMatch = true;
 
+    if (adoptCachedProgram(cx, mode, input->hasLatin1Chars(), force))
+        return true;
+
+    size_t firstTable = tables.length();
+
     CompileOptions options(cx);
     TokenStream dummyTokenStream(cx, options, nullptr, 0, nullptr);
 
@@ -605,9 +666,85 @@ RegExpShared::compile(JSContext* cx, HandleAtom pattern, HandleLinearString inpu
     else if (code.byteCode)
         compilation.byteCode = code.byteCode;
 
+    publishProgram(cx, mode, input->hasLatin1Chars(), firstTable);
     return true;
 }
 
+bool
+RegExpShared::adoptCachedProgram(JSContext* cx, CompilationMode mode, bool latin1,
+                                 ForceByteCodeEnum force)
+{
+    if (!code_) {
+        if (!cx->options().sharedRegExpCache())
+            return false;
+
+        // The cache is an optimization: if it cannot be created or extended,
+        // compile privately instead.
+        JSRuntime* rt = cx->runtime();
+        if (!rt->regExpCodeCache) {
+            RegExpCodeCache* cache = js_new<RegExpCodeCache>();
+            if (!cache || !cache->init()) {
+                js_delete(cache);
+                return false;
+            }
+            rt->regExpCodeCache = cache;
+        }
+
+        code_ = rt->regExpCodeCache->lookupOrAdd(source, flags);
+        if (!code_)
+            return false;
+    }
+
+    // Only cached entries have their programs traced.
+    if (!code_->cached)
+        return false;
+
+    int index = CompilationIndex(mode, latin1);
+    RegExpCompilation& compilation = compilationArray[index];
+    if (!compilation.jitCode && code_->jitCode[index])
+        compilation.jitCode = code_->jitCode[index];
+    if (!compilation.byteCode && code_->byteCode[index])
+        compilation.byteCode = code_->byteCode[index];
+    if (!compilation.compiled(force))
+        return false;
+
+    parenCount = code_->parenCount;
+    cx->runtime()->regExpCodeCache->touch(code_);
+    return true;
+}
+
+void
+RegExpShared::publishProgram(JSContext* cx, CompilationMode mode, bool latin1,
+                             size_t firstTable)
+{
+    if (!code_)
+        return;
+
+    int index = CompilationIndex(mode, latin1);
+    RegExpCompilation& compilation = compilationArray[index];
+
+    if (compilation.jitCode && !code_->jitCode[index]) {
+        // The tables the code refers to must live as long as it does.
+        size_t numTables = tables.length() - firstTable;
+        if (!code_->tables.reserve(code_->tables.length() + numTables))
+            return;
+        for (size_t i = firstTable; i < tables.length(); i++)
+            code_->tables.infallibleAppend(tables[i]);
+        tables.shrinkTo(firstTable);
+
+        // The code no longer belongs to this compartment.
+        AutoLockForExclusiveAccess lock(cx);
+        Zone* atomsZone = cx->runtime()->atomsCompartment(lock)->zone();
+        compilation.jitCode->setOmrZoneIndex(atomsZone->omrIndex);
+        code_->jitCode[index] = compilation.jitCode;
+    }
+
+    if (compilation.byteCode && !code_->byteCode[index])
+        code_->byteCode[index] = compilation.byteCode;
+
+    code_->parenCount = parenCount;
+}
+
 bool
 RegExpShared::compileIfNecessary(JSContext* cx, HandleLinearString input,
                                  CompilationMode mode, ForceByteCodeEnum force)
@@ -750,9 +887,10 @@ RegExpShared::sizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf)
 {
     size_t n = mallocSizeOf(this);
 
+    // Bytecode shared through the RegExpCodeCache is counted there.
     for (size_t i = 0; i < ArrayLength(compilationArray); i++) {
         const RegExpCompilation& compilation = compilationArray[i];
-        if (compilation.byteCode)
+        if (compilation.byteCode && (!code_ || compilation.byteCode != code_->byteCode[i]))
             n += mallocSizeOf(compilation.byteCode);
     }
 
@@ -908,6 +1046,38 @@ RegExpCompartment::sweep(JSRuntime* rt)
     }
 }
 
+#ifdef OMR // Compaction
+void
+RegExpCompartment::fixupAfterCompaction(JSTracer* trc)
+{
+    if (!set_.initialized())
+        return;
+
+    // Shareds are keyed by the address of their source atom. Their edges may
+    // already have been updated through a RegExpObject; the compaction
+    // tracer skips those.
+    Vector<RegExpShared*, 0, SystemAllocPolicy> shareds;
+    AutoEnterOOMUnsafeRegion oomUnsafe;
+    if (!shareds.reserve(set_.count()))
+        oomUnsafe.crash("RegExpCompartment::fixupAfterCompaction");
+    for (Set::Range r = set_.all(); !r.empty(); r.popFront()) {
+        RegExpShared* shared = r.front();
+        shared->trace(trc);
+        shareds.infallibleAppend(shared);
+    }
+    set_.clear();
+    for (RegExpShared* shared : shareds)
+        set_.putNewInfallible(Key(shared), shared);
+
+    if (matchResultTemplateObject_)
+        TraceEdge(trc, &matchResultTemplateObject_, "RegExp match result template");
+    if (optimizableRegExpPrototypeShape_)
+        TraceEdge(trc, &optimizableRegExpPrototypeShape_, "optimizable RegExp prototype shape");
+    if (optimizableRegExpInstanceShape_)
+        TraceEdge(trc, &optimizableRegExpInstanceShape_, "optimizable RegExp instance shape");
+}
+#endif // OMR Compaction
+
 bool
 RegExpCompartment::get(JSContext* cx, JSAtom* source, RegExpFlag flags, RegExpGuard* g)
 {
@@ -960,6 +1130,105 @@ RegExpCompartment::sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf)
     return n;
 }
 
+/* RegExpCodeCache */
+
+RegExpCodeCache::~RegExpCodeCache()
+{
+    purge();
+}
+
+RegExpCode*
+RegExpCodeCache::lookupOrAdd(JSAtom* source, RegExpFlag flags)
+{
+    Key key(source, flags);
+    Set::AddPtr p = set_.lookupForAdd(key);
+    if (p) {
+        touch(*p);
+        (*p)->AddRef();
+        return *p;
+    }
+
+    RegExpCode* code = js_new<RegExpCode>(source, flags);
+    if (!code)
+        return nullptr;
+
+    if (!set_.add(p, code)) {
+        js_delete(code);
+        return nullptr;
+    }
+
+    // One reference for the cache, one for the caller.
+    code->AddRef();
+    code->AddRef();
+    code->cached = true;
+    lru_.insertFront(code);
+
+    if (set_.count() > MaxEntries)
+        evict(lru_.getLast());
+
+    return code;
+}
+
+void
+RegExpCodeCache::touch(RegExpCode* code)
+{
+    if (!code->cached || code == lru_.getFirst())
+        return;
+
+    code->remove();
+    lru_.insertFront(code);
+}
+
+void
+RegExpCodeCache::evict(RegExpCode* code)
+{
+    MOZ_ASSERT(code->cached);
+
+    set_.remove(Key(code));
+    code->remove();
+    code->cached = false;
+    code->Release();
+}
+
+void
+RegExpCodeCache::purge()
+{
+    while (RegExpCode* code = lru_.getFirst())
+        evict(code);
+}
+
+void
+RegExpCodeCache::trace(JSTracer* trc)
+{
+    for (RegExpCode* code = lru_.getFirst(); code; code = code->getNext())
+        code->trace(trc);
+}
+
+#ifdef OMR // Compaction
+void
+RegExpCodeCache::fixupAfterCompaction(JSTracer* trc)
+{
+    if (!set_.initialized())
+        return;
+
+    // Entries are keyed by the address of their source atom, which the root
+    // trace has already updated.
+    set_.clear();
+    for (RegExpCode* code = lru_.getFirst(); code; code = code->getNext())
+        set_.putNewInfallible(Key(code), code);
+}
+#endif // OMR Compaction
+
+size_t
+RegExpCodeCache::sizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf)
+{
+    size_t n = mallocSizeOf(this);
+    n += set_.sizeOfExcludingThis(mallocSizeOf);
+    for (RegExpCode* code = lru_.getFirst(); code; code = code->getNext())
+        n += code->sizeOfIncludingThis(mallocSizeOf);
+    return n;
+}
+
 /* Functions */
 
 JSObject*
@@ -1086,9 +1355,20 @@ js::XDRScriptRegExpObject(XDRState<mode>* xdr, MutableHandle<RegExpObject*> objp
     if (!XDRAtom(xdr, &source) || !xdr->codeUint32(&flagsword))
         return false;
     if (mode == XDR_DECODE) {
+        ExclusiveContext* cx = xdr->cx();
         RegExpFlag flags = RegExpFlag(flagsword);
-        RegExpObject* reobj = RegExpObject::create(xdr->cx(), source, flags, nullptr,
-                                                   xdr->cx()->tempLifoAlloc());
+        RegExpObject* reobj;
+        if (cx->isJSContext()) {
+            reobj = RegExpObject::create(cx, source, flags, nullptr,
+                                         cx->asJSContext()->tempLifoAlloc());
+        } else {
+            // Off the main thread, syntax errors are reported through a token
+            // stream for the decoder's options, as when parsing.
+            LifoAlloc alloc(JSRuntime::TEMP_LIFO_ALLOC_PRIMARY_CHUNK_SIZE);
+            TokenStream dummyTokenStream(cx, xdr->options(), (const char16_t*) nullptr, 0,
+                                         (frontend::StrictModeGetter*) nullptr);
+            reobj = RegExpObject::create(cx, source, flags, &dummyTokenStream, alloc);
+        }
         if (!reobj)
             return false;
 
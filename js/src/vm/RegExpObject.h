@@ -8,6 +8,7 @@
 #define vm_RegExpObject_h
 
 #include "mozilla/Attributes.h"
+#include "mozilla/LinkedList.h"
 #include "mozilla/MemoryReporting.h"
 
 #include "jscntxt.h"
@@ -30,6 +31,9 @@
  *
  *   RegExpCompartment - Owns all RegExpShared instances in a compartment.
  *
+ *   RegExpCodeCache - Optionally shares the compiled programs of identical
+ *                     RegExpShareds across every compartment in the runtime.
+ *
  * To save memory, a RegExpShared is not created for a RegExpObject until it is
  * needed for execution. When a RegExpShared needs to be created, it is looked
  * up in a per-compartment table to allow reuse between objects. Lastly, on
@@ -82,6 +86,49 @@ CloneRegExpObject(JSContext* cx, JSObject* regexp);
 extern JSObject*
 CreateRegExpPrototype(JSContext* cx, JSProtoKey key);
 
+/*
+ * The compiled programs for one (source, flags) pair, shared by the
+ * RegExpShareds of every compartment that compiles that pair, and by the
+ * RegExpCodeCache while it is cached. It holds as many programs as
+ * RegExpShared has compilations, owns their bytecode and the tables their JIT
+ * code refers to, and is freed when the last reference goes away.
+ *
+ * The cache traces the programs of cached entries; a RegExpShared only traces
+ * the programs it has itself adopted. So a RegExpShared may only adopt more
+ * programs from an entry while the entry is still cached.
+ */
+class RegExpCode : public mozilla::LinkedListElement<RegExpCode>
+{
+    friend class RegExpCodeCache;
+    friend class RegExpShared;
+
+    static const size_t NumPrograms = 4;
+
+    HeapPtr<JSAtom*> source;
+    RegExpFlag flags;
+    size_t parenCount;
+    HeapPtr<jit::JitCode*> jitCode[NumPrograms];
+    uint8_t* byteCode[NumPrograms];
+    Vector<uint8_t*, 0, SystemAllocPolicy> tables;
+
+    uint32_t refCount;
+    bool cached;
+
+    void trace(JSTracer* trc);
+    size_t sizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf);
+
+  public:
+    RegExpCode(JSAtom* source, RegExpFlag flags);
+    ~RegExpCode();
+
+    void AddRef() { refCount++; }
+    void Release() {
+        MOZ_ASSERT(refCount > 0);
+        if (--refCount == 0)
+            js_delete(this);
+    }
+};
+
 /*
  * A RegExpShared is the compiled representation of a regexp. A RegExpShared is
  * potentially pointed to by multiple RegExpObjects. Additionally, C++ code may
@@ -135,7 +182,11 @@ class RegExpShared
     bool               canStringMatch;
     bool               marked_;
 
-    RegExpCompilation  compilationArray[4];
+    RegExpCompilation  compilationArray[RegExpCode::NumPrograms];
+
+    // The runtime-wide programs for this source and flags, if the
+    // RegExpCodeCache is enabled. Its bytecode is not ours to free.
+    RegExpCode*        code_;
 
     static int CompilationIndex(CompilationMode mode, bool latin1) {
         switch (mode) {
@@ -157,6 +208,10 @@ class RegExpShared
     bool compileIfNecessary(JSContext* cx, HandleLinearString input,
                             CompilationMode mode, ForceByteCodeEnum force);
 
+    bool adoptCachedProgram(JSContext* cx, CompilationMode mode, bool latin1,
+                            ForceByteCodeEnum force);
+    void publishProgram(JSContext* cx, CompilationMode mode, bool latin1, size_t firstTable);
+
     const RegExpCompilation& compilation(CompilationMode mode, bool latin1) const {
         return compilationArray[CompilationIndex(mode, latin1)];
     }
@@ -348,6 +403,9 @@ class RegExpCompartment
 
     bool init(JSContext* cx);
     void sweep(JSRuntime* rt);
+#ifdef OMR // Compaction
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
 
     bool empty() { return set_.empty(); }
 
@@ -386,6 +444,74 @@ class RegExpCompartment
     size_t sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf);
 };
 
+/*
+ * A runtime-wide cache of compiled irregexp programs, keyed by source atom and
+ * flags. Embeddings that load the same library into many globals otherwise
+ * parse, compile and keep one copy of each of its regexps per compartment.
+ *
+ * Regexp JIT code only refers to runtime state, so one copy can run in any
+ * compartment. It is moved to the atoms zone, like the source atoms, when it
+ * is published. The cache holds its entries strongly and evicts the least
+ * recently used once it has MaxEntries of them; compartments still using an
+ * evicted entry's programs keep it alive until they are swept.
+ */
+class RegExpCodeCache
+{
+    struct Key {
+        JSAtom* atom;
+        uint16_t flag;
+
+        Key() {}
+        Key(JSAtom* atom, RegExpFlag flag)
+          : atom(atom), flag(flag)
+        { }
+        MOZ_IMPLICIT Key(RegExpCode* code)
+          : atom(code->source), flag(code->flags)
+        { }
+
+        typedef Key Lookup;
+        static HashNumber hash(const Lookup& l) {
+            return DefaultHasher<JSAtom*>::hash(l.atom) ^ (l.flag << 1);
+        }
+        static bool match(Key l, Key r) {
+            return l.atom == r.atom && l.flag == r.flag;
+        }
+    };
+
+    typedef HashSet<RegExpCode*, Key, SystemAllocPolicy> Set;
+    Set set_;
+
+    // Most recently used first.
+    mozilla::LinkedList<RegExpCode> lru_;
+
+    void evict(RegExpCode* code);
+
+  public:
+    static const size_t MaxEntries = 512;
+
+    RegExpCodeCache() {}
+    ~RegExpCodeCache();
+
+    bool init() { return set_.init(); }
+
+    // Return the entry for |source| and |flags| with a reference added for
+    // the caller, creating it if needed. Returns nullptr on OOM, without
+    // reporting it: callers fall back to compiling privately.
+    RegExpCode* lookupOrAdd(JSAtom* source, RegExpFlag flags);
+
+    // Mark a cached entry as recently used.
+    void touch(RegExpCode* code);
+
+    void purge();
+
+    void trace(JSTracer* trc);
+#ifdef OMR // Compaction
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
+
+    size_t sizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf);
+};
+
 class RegExpObject : public NativeObject
 {
     static const unsigned LAST_INDEX_SLOT          = 0;
@@ -52,6 +52,7 @@
 #include "js/MemoryMetrics.h"
 #include "js/SliceBudget.h"
 #include "vm/Debugger.h"
+#include "vm/RegExpObject.h"
 
 #include "jscntxtinlines.h"
 #include "jsgcinlines.h"
@@ -230,6 +231,7 @@ JSRuntime::JSRuntime(JSRuntime* parentRuntime)
     jitSupportsUnalignedAccesses(false),
     jitSupportsSimd(false),
     ionPcScriptCache(nullptr),
+    regExpCodeCache(nullptr),
     scriptEnvironmentPreparer(nullptr),
     ctypesActivityCallback(nullptr),
     windowProxyClass_(nullptr),
@@ -259,6 +261,7 @@ JSRuntime::JSRuntime(JSRuntime* parentRuntime)
 
     PodArrayZero(nativeStackQuota);
     PodZero(&asmJSCacheOps);
+    PodZero(&wasmCacheOps);
     lcovOutput.init();
 }
 
@@ -405,6 +408,13 @@ JSRuntime::destroyRuntime()
         /* Set the profiler sampler buffer generation to invalid. */
         profilerSampleBufferGen_ = UINT32_MAX;
 
+        /*
+         * Drop the regexp cache's roots. Entries still in use outlive it
+         * until their compartments' RegExpShareds are swept.
+         */
+        js_delete(regExpCodeCache);
+        regExpCodeCache = nullptr;
+
         JS::PrepareForFullGC(contextFromMainThread());
         gc.gc(GC_NORMAL, JS::gcreason::DESTROY_RUNTIME);
     }
@@ -435,9 +445,7 @@ JSRuntime::destroyRuntime()
 
     js_delete(ionPcScriptCache);
 
-#ifndef OMR // Writebarrier
     gc.storeBuffer.disable();
-#endif // ! OMR Writebarrier
 
     gc.nursery.disable();
 
@@ -506,6 +514,9 @@ JSRuntime::addSizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf, JS::Runtim
     rtSizes->uncompressedSourceCache +=
         cx->caches.uncompressedSourceCache.sizeOfExcludingThis(mallocSizeOf);
 
+    if (regExpCodeCache)
+        rtSizes->regExpCodeCache += regExpCodeCache->sizeOfIncludingThis(mallocSizeOf);
+
 
     rtSizes->scriptData += scriptDataTable(lock).sizeOfExcludingThis(mallocSizeOf);
     for (ScriptDataTable::Range r = scriptDataTable(lock).all(); !r.empty(); r.popFront())
@@ -520,9 +531,7 @@ JSRuntime::addSizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf, JS::Runtim
     rtSizes->gc.nurseryCommitted += gc.nursery.sizeOfHeapCommitted();
     rtSizes->gc.nurseryMallocedBuffers += gc.nursery.sizeOfMallocedBuffers(mallocSizeOf);
 
-#ifndef OMR
     gc.storeBuffer.addSizeOfExcludingThis(mallocSizeOf, &rtSizes->gc);
-#endif
 }
 
 static bool
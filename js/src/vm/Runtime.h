@@ -26,6 +26,7 @@
 # include "asmjs/WasmSignalHandlers.h"
 #endif
 #include "builtin/AtomicsObject.h"
+#include "builtin/Intl.h"
 #include "builtin/Promise.h"
 #include "ds/FixedSizeHash.h"
 #include "frontend/NameCollections.h"
@@ -94,6 +95,7 @@ extern MOZ_COLD void
 ReportOverRecursed(ExclusiveContext* cx);
 
 class Activation;
+class RegExpCodeCache;
 class ActivationIterator;
 class WasmActivation;
 
@@ -307,6 +309,10 @@ class PerThreadData
     // compilations.
     frontend::NameCollectionPool frontendCollectionPool;
 
+    // Cells overwritten by this thread while OMR's concurrent mark is
+    // running, handed to the collector in batches.
+    gc::ConcurrentBarrierBuffer concurrentBarrierBuffer;
+
     explicit PerThreadData(JSRuntime* runtime);
     ~PerThreadData();
 
@@ -691,6 +697,9 @@ struct JSRuntime : public JS::shadow::Runtime,
     /* Default locale for Internationalization API */
     char* defaultLocale;
 
+    /* Recently created ICU formatters for the Internationalization API. */
+    js::IntlFormatterCache intlFormatterCache;
+
     /* Default JSVersion. */
     JSVersion defaultVersion_;
 
@@ -950,6 +959,9 @@ struct JSRuntime : public JS::shadow::Runtime,
     /* AsmJSCache callbacks are runtime-wide. */
     JS::AsmJSCacheOps   asmJSCacheOps;
 
+    /* As are the wasm cache callbacks. */
+    JS::WasmCacheOps    wasmCacheOps;
+
     /*
      * The propertyRemovals counter is incremented for every JSObject::clear,
      * and for each JSObject::remove method call that frees a slot in the given
@@ -1099,6 +1111,10 @@ struct JSRuntime : public JS::shadow::Runtime,
     // Cache for jit::GetPcScript().
     js::jit::PcScriptCache* ionPcScriptCache;
 
+    // Regexp programs shared by every compartment, created on first use when
+    // ContextOptions::sharedRegExpCache is set.
+    js::RegExpCodeCache* regExpCodeCache;
+
     js::ScriptEnvironmentPreparer* scriptEnvironmentPreparer;
 
     js::CTypesActivityCallback  ctypesActivityCallback;
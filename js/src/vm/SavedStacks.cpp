@@ -1171,6 +1171,7 @@ SavedStacks::copyAsyncStack(JSContext* cx, HandleObject asyncStack, HandleString
 void
 SavedStacks::sweep()
 {
+    clearFrameCache();
     frames.sweep();
     pcLocationMap.sweep();
 }
@@ -1178,6 +1179,7 @@ SavedStacks::sweep()
 void
 SavedStacks::trace(JSTracer* trc)
 {
+    clearFrameCache();
     pcLocationMap.trace(trc);
 }
 
@@ -1191,6 +1193,7 @@ SavedStacks::count()
 void
 SavedStacks::clear()
 {
+    clearFrameCache();
     frames.clear();
 }
 
@@ -1470,9 +1473,25 @@ SavedFrame*
 SavedStacks::getOrCreateSavedFrame(JSContext* cx, SavedFrame::HandleLookup lookup)
 {
     const SavedFrame::Lookup& lookupInstance = lookup.get();
+
+    // Only frames captured from the live stack have a pc.
+    FrameCacheEntry* cacheEntry = nullptr;
+    if (lookupInstance.pc) {
+        cacheEntry = &frameCacheEntry(lookupInstance.pc, lookupInstance.parent);
+        if (cacheEntry->pc == lookupInstance.pc &&
+            SavedFrame::HashPolicy::match(cacheEntry->frame, lookupInstance))
+        {
+            return cacheEntry->frame;
+        }
+    }
+
     DependentAddPtr<SavedFrame::Set> p(cx, frames, lookupInstance);
     if (p) {
         MOZ_ASSERT(*p);
+        if (cacheEntry) {
+            cacheEntry->pc = lookupInstance.pc;
+            cacheEntry->frame = *p;
+        }
         return *p;
     }
 
@@ -1483,6 +1502,13 @@ SavedStacks::getOrCreateSavedFrame(JSContext* cx, SavedFrame::HandleLookup looku
     if (!p.add(cx, frames, lookupInstance, frame))
         return nullptr;
 
+    // Creating the frame may have run a GC, which empties the cache.
+    if (lookupInstance.pc) {
+        FrameCacheEntry& entry = frameCacheEntry(lookupInstance.pc, lookupInstance.parent);
+        entry.pc = lookupInstance.pc;
+        entry.frame = frame;
+    }
+
     return frame;
 }
 
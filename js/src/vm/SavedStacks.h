@@ -9,6 +9,7 @@
 
 #include "mozilla/Attributes.h"
 #include "mozilla/FastBernoulliTrial.h"
+#include "mozilla/PodOperations.h"
 
 #include "jscntxt.h"
 #include "jsmath.h"
@@ -160,7 +161,9 @@ class SavedStacks {
         bernoulliSeeded(false),
         bernoulli(1.0, 0x59fdad7f6b4cc573, 0x91adf38db96a9354),
         creatingSavedFrame(false)
-    { }
+    {
+        clearFrameCache();
+    }
 
     MOZ_MUST_USE bool init();
     bool initialized() const { return frames.initialized(); }
@@ -229,6 +232,24 @@ class SavedStacks {
     SavedFrame* getOrCreateSavedFrame(JSContext* cx, SavedFrame::HandleLookup lookup);
     SavedFrame* createFrameFromLookup(JSContext* cx, SavedFrame::HandleLookup lookup);
 
+    // A small direct-mapped cache in front of |frames|, indexed by the pc and
+    // parent of a frame. Stacks captured repeatedly from the same code mostly
+    // hit it, which saves hashing the whole lookup and the parent's unique
+    // id. It holds unbarriered pointers, so it is emptied whenever the
+    // compartment is traced, swept or cleared.
+    struct FrameCacheEntry {
+        jsbytecode* pc;
+        SavedFrame* frame;
+    };
+    static const size_t FrameCacheSize = 256;
+    FrameCacheEntry frameCache[FrameCacheSize];
+
+    void clearFrameCache() { mozilla::PodArrayZero(frameCache); }
+    FrameCacheEntry& frameCacheEntry(jsbytecode* pc, SavedFrame* parent) {
+        HashNumber h = mozilla::HashGeneric(pc, parent);
+        return frameCache[h & (FrameCacheSize - 1)];
+    }
+
     // Cache for memoizing PCToLineNumber lookups.
 
     struct PCKey {
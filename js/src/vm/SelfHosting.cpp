@@ -1177,6 +1177,22 @@ intrinsic_PossiblyWrappedTypedArrayLength(JSContext* cx, unsigned argc, Value* v
     return true;
 }
 
+static bool
+intrinsic_TypedArrayNativeSort(JSContext* cx, unsigned argc, Value* vp)
+{
+    CallArgs args = CallArgsFromVp(argc, vp);
+    MOZ_ASSERT(args.length() == 1);
+
+    Rooted<TypedArrayObject*> tarray(cx, &args[0].toObject().as<TypedArrayObject>());
+
+    bool sorted;
+    if (!SortTypedArray(cx, tarray, &sorted))
+        return false;
+
+    args.rval().setBoolean(sorted);
+    return true;
+}
+
 static bool
 intrinsic_MoveTypedArrayElements(JSContext* cx, unsigned argc, Value* vp)
 {
@@ -1818,11 +1834,11 @@ intrinsic_EnqueuePromiseReactionJob(JSContext* cx, unsigned argc, Value* vp)
 
     RootedValue handlerArg(cx, args[1]);
 
-    RootedObject resolve(cx, &args[2].toObject());
-    MOZ_ASSERT(IsCallable(resolve));
+    RootedObject resolve(cx, args[2].toObjectOrNull());
+    MOZ_ASSERT_IF(resolve, IsCallable(resolve));
 
-    RootedObject reject(cx, &args[3].toObject());
-    MOZ_ASSERT(IsCallable(reject));
+    RootedObject reject(cx, args[3].toObjectOrNull());
+    MOZ_ASSERT_IF(reject, IsCallable(reject));
 
     RootedObject promise(cx, args[4].toObjectOrNull());
     RootedObject objectFromIncumbentGlobal(cx, args[5].toObjectOrNull());
@@ -1852,6 +1868,20 @@ intrinsic_HostPromiseRejectionTracker(JSContext* cx, unsigned argc, Value* vp)
     return true;
 }
 
+static bool
+intrinsic_CreatePromiseSkippingExecutor(JSContext* cx, unsigned argc, Value* vp)
+{
+    CallArgs args = CallArgsFromVp(argc, vp);
+    MOZ_ASSERT(args.length() == 0);
+
+    PromiseObject* promise = PromiseObject::createSkippingExecutor(cx);
+    if (!promise)
+        return false;
+
+    args.rval().setObject(*promise);
+    return true;
+}
+
 /**
  * Returns the default locale as a well-formed, but not necessarily canonicalized,
  * BCP-47 language tag.
@@ -2428,6 +2458,7 @@ static const JSFunctionSpec intrinsic_functions[] = {
     JS_INLINABLE_FN("PossiblyWrappedTypedArrayLength", intrinsic_PossiblyWrappedTypedArrayLength,
                     1, 0, IntrinsicPossiblyWrappedTypedArrayLength),
 
+    JS_FN("TypedArrayNativeSort",    intrinsic_TypedArrayNativeSort,    1,0),
     JS_FN("MoveTypedArrayElements",  intrinsic_MoveTypedArrayElements,  4,0),
     JS_FN("SetFromTypedArrayApproach",intrinsic_SetFromTypedArrayApproach, 4, 0),
     JS_FN("SetOverlappingTypedElements",intrinsic_SetOverlappingTypedElements,3,0),
@@ -2454,6 +2485,7 @@ static const JSFunctionSpec intrinsic_functions[] = {
     JS_FN("IsWrappedPromise",               intrinsic_IsWrappedPromiseObject,     1, 0),
     JS_FN("_EnqueuePromiseReactionJob",     intrinsic_EnqueuePromiseReactionJob,  2, 0),
     JS_FN("HostPromiseRejectionTracker",    intrinsic_HostPromiseRejectionTracker,2, 0),
+    JS_FN("CreatePromiseSkippingExecutor",  intrinsic_CreatePromiseSkippingExecutor, 0, 0),
     JS_FN("CallPromiseMethodIfWrapped",
           CallNonGenericSelfhostedMethod<Is<PromiseObject>>,      2,0),
 
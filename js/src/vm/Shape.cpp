@@ -42,7 +42,7 @@ ShapeTable::init(ExclusiveContext* cx, Shape* lastProp)
 {
     uint32_t sizeLog2 = CeilingLog2Size(entryCount_);
     uint32_t size = JS_BIT(sizeLog2);
-    if (entryCount_ >= size - (size >> 2))
+    if (entryCount_ >= maxLoad(size))
         sizeLog2++;
     if (sizeLog2 < MIN_SIZE_LOG2)
         sizeLog2 = MIN_SIZE_LOG2;
@@ -338,6 +338,32 @@ ShapeTable::trace(JSTracer* trc)
     }
 }
 
+#ifdef OMR // Compaction
+void
+ShapeTable::rehashAfterCompaction()
+{
+    uint32_t size = capacity();
+    Entry* oldTable = entries_;
+    entries_ = js_pod_calloc<Entry>(size);
+    if (!entries_) {
+        AutoEnterOOMUnsafeRegion oomUnsafe;
+        oomUnsafe.crash("ShapeTable::rehashAfterCompaction");
+    }
+    removedCount_ = 0;
+
+    for (Entry* oldEntry = oldTable; size != 0; oldEntry++) {
+        if (Shape* shape = oldEntry->shape()) {
+            Entry& entry = search<MaybeAdding::Adding>(shape->propid());
+            MOZ_ASSERT(entry.isFree());
+            entry.setShape(shape);
+        }
+        size--;
+    }
+
+    js_free(oldTable);
+}
+#endif // OMR Compaction
+
 #ifdef JSGC_HASH_TABLE_CHECKS
 
 void
@@ -178,6 +178,13 @@ class ShapeTable {
     static const uint32_t MIN_SIZE_LOG2 = 2;
     static const uint32_t MIN_SIZE      = JS_BIT(MIN_SIZE_LOG2);
 
+    // Tables at least this large are nearly always those of dictionary-mode
+    // objects used as maps, where the table is a large part of the memory
+    // spent per property. They are allowed a load factor of 7/8 instead of
+    // 3/4: with double hashing, successful lookups still average under 2.5
+    // probes.
+    static const uint32_t LARGE_SIZE_LOG2 = 8;
+
     uint32_t        hashShift_;         /* multiplicative hash shift */
 
     uint32_t        entryCount_;        /* number of entries in table */
@@ -206,6 +213,9 @@ class ShapeTable {
 
     uint32_t entryCount() const { return entryCount_; }
 
+    /* By definition, hashShift = HASH_BITS - log2(capacity). */
+    uint32_t capacity() const { return JS_BIT(HASH_BITS - hashShift_); }
+
     uint32_t freeList() const { return freeList_; }
     void setFreeList(uint32_t slot) { freeList_ = slot; }
 
@@ -230,6 +240,10 @@ class ShapeTable {
 #ifdef JSGC_HASH_TABLE_CHECKS
     void checkAfterMovingGC();
 #endif
+#ifdef OMR // Compaction
+    // Reinsert every entry once their ids have been updated after compaction.
+    void rehashAfterCompaction();
+#endif // OMR Compaction
 
   private:
     Entry& getEntry(uint32_t i) const {
@@ -249,13 +263,14 @@ class ShapeTable {
         MOZ_ASSERT(entryCount_ + removedCount_ <= capacity());
     }
 
-    /* By definition, hashShift = HASH_BITS - log2(capacity). */
-    uint32_t capacity() const { return JS_BIT(HASH_BITS - hashShift_); }
+    /* The number of live and removed entries a table of |size| may hold. */
+    static uint32_t maxLoad(uint32_t size) {
+        return size >= JS_BIT(LARGE_SIZE_LOG2) ? size - (size >> 3) : size - (size >> 2);
+    }
 
-    /* Whether we need to grow.  We want to do this if the load factor is >= 0.75 */
+    /* Whether we need to grow: see maxLoad. */
     bool needsToGrow() const {
-        uint32_t size = capacity();
-        return entryCount_ + removedCount_ >= size - (size >> 2);
+        return entryCount_ + removedCount_ >= maxLoad(capacity());
     }
 
     /*
@@ -954,6 +969,15 @@ class Shape : public gc::TenuredCell
     void fixupGetterSetterForBarrier(JSTracer* trc);
     void updateBaseShapeAfterMovingGC();
 
+#ifdef OMR // Compaction
+    // OMR's compactor leaves no forwarding pointers to test, so edges are
+    // updated by tracing with the compaction tracer instead. The kids table
+    // is keyed by the children's fields and is rebuilt in a second pass,
+    // once every shape has been fixed up.
+    void fixupAfterCompaction(JSTracer* trc);
+    void fixupKidsAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
+
     /* For JIT usage */
     static inline size_t offsetOfBase() { return offsetof(Shape, base_); }
     static inline size_t offsetOfSlotInfo() { return offsetof(Shape, slotInfo); }
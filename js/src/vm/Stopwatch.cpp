@@ -166,6 +166,38 @@ PerformanceMonitoring::commit()
     return success;
 }
 
+uint32_t
+PerformanceMonitoring::enterStopwatch()
+{
+    if (stopwatchDepth_++ > 0)
+        return currentSampleWeight_;
+
+    if (samplingInterval_ == 1) {
+        currentSampleWeight_ = 1;
+        return currentSampleWeight_;
+    }
+
+    if (entriesUntilSample_ > 1) {
+        --entriesUntilSample_;
+        currentSampleWeight_ = 0;
+        return currentSampleWeight_;
+    }
+
+    // Pick the distance to the next sample uniformly in
+    // [1, 2 * samplingInterval_ - 1], i.e. with an average of
+    // `samplingInterval_`.
+    entriesUntilSample_ = 1 + samplingRNG_.next() % (2 * uint64_t(samplingInterval_) - 1);
+    currentSampleWeight_ = samplingInterval_;
+    return currentSampleWeight_;
+}
+
+void
+PerformanceMonitoring::exitStopwatch()
+{
+    MOZ_ASSERT(stopwatchDepth_ > 0);
+    --stopwatchDepth_;
+}
+
 uint64_t
 PerformanceMonitoring::monotonicReadTimestampCounter()
 {
@@ -221,16 +253,23 @@ AutoStopwatch::AutoStopwatch(JSContext* cx MOZ_GUARD_OBJECT_NOTIFIER_PARAM_IN_IM
   , iteration_(0)
   , isMonitoringJank_(false)
   , isMonitoringCPOW_(false)
+  , weight_(0)
   , cyclesStart_(0)
   , CPOWTimeStart_(0)
 {
     MOZ_GUARD_OBJECT_NOTIFIER_INIT;
 
+    JSRuntime* runtime = cx_->runtime();
+    weight_ = runtime->performanceMonitoring.enterStopwatch();
+    if (weight_ == 0) {
+        // This entry is not part of the sample.
+        return;
+    }
+
     JSCompartment* compartment = cx_->compartment();
     if (compartment->scheduledForDestruction)
         return;
 
-    JSRuntime* runtime = cx_->runtime();
     iteration_ = runtime->performanceMonitoring.iteration();
 
     const PerformanceGroupVector* groups = compartment->performanceMonitoring.getGroups(cx);
@@ -260,6 +299,8 @@ AutoStopwatch::AutoStopwatch(JSContext* cx MOZ_GUARD_OBJECT_NOTIFIER_PARAM_IN_IM
 
 AutoStopwatch::~AutoStopwatch()
 {
+    cx_->runtime()->performanceMonitoring.exitStopwatch();
+
     if (groups_.length() == 0) {
         // We are not in charge of monitoring anything.
         return;
@@ -388,9 +429,9 @@ AutoStopwatch::addToGroup(JSRuntime* runtime, uint64_t cyclesDelta, uint64_t CPO
 
     if (!runtime->performanceMonitoring.addRecentGroup(group))
       return false;
-    group->addRecentTicks(iteration_, 1);
-    group->addRecentCycles(iteration_, cyclesDelta);
-    group->addRecentCPOW(iteration_, CPOWTimeDelta);
+    group->addRecentTicks(iteration_, weight_);
+    group->addRecentCycles(iteration_, cyclesDelta * weight_);
+    group->addRecentCPOW(iteration_, CPOWTimeDelta * weight_);
     return true;
 }
 
@@ -637,6 +678,17 @@ GetStopwatchIsMonitoringCPOW(JSContext* cx)
     return cx->performanceMonitoring.isMonitoringCPOW();
 }
 
+JS_PUBLIC_API(void)
+SetStopwatchSamplingInterval(JSContext* cx, uint32_t interval)
+{
+    cx->performanceMonitoring.setSamplingInterval(interval);
+}
+JS_PUBLIC_API(uint32_t)
+GetStopwatchSamplingInterval(JSContext* cx)
+{
+    return cx->performanceMonitoring.samplingInterval();
+}
+
 JS_PUBLIC_API(void)
 GetPerfMonitoringTestCpuRescheduling(JSContext* cx, uint64_t* stayed, uint64_t* moved)
 {
@@ -9,6 +9,7 @@
 
 #include "mozilla/RefPtr.h"
 #include "mozilla/Vector.h"
+#include "mozilla/XorShift128PlusRNG.h"
 
 #include "jsapi.h"
 
@@ -84,6 +85,11 @@ struct PerformanceMonitoring {
       , iteration_(0)
       , startedAtIteration_(0)
       , highestTimestampCounter_(0)
+      , samplingInterval_(1)
+      , entriesUntilSample_(0)
+      , stopwatchDepth_(0)
+      , currentSampleWeight_(1)
+      , samplingRNG_(0x5a17b0e1d3c2a401ULL, 0x9e3779b97f4a7c15ULL)
     { }
 
     /**
@@ -168,6 +174,39 @@ struct PerformanceMonitoring {
         return isMonitoringCPOW_;
     }
 
+    /**
+     * Set the average number of entries into JS between two measured
+     * entries.
+     *
+     * With an interval of 0 or 1, every entry is measured. With an
+     * interval of N > 1, roughly one outermost entry out of N is
+     * measured, and its ticks, cycles and CPOW time are scaled by N,
+     * so that the aggregated values remain unbiased estimates of
+     * the full measurements at a fraction of the overhead.
+     *
+     * May be changed at any time. Measures that are in progress keep
+     * the weight with which they were started.
+     */
+    void setSamplingInterval(uint32_t interval) {
+        samplingInterval_ = interval > 1 ? interval : 1;
+        entriesUntilSample_ = 0;
+    }
+    uint32_t samplingInterval() const {
+        return samplingInterval_;
+    }
+
+    /**
+     * Called by `AutoStopwatch` whenever it starts/stops.
+     *
+     * `enterStopwatch` returns the weight by which the measures of
+     * the entry should be multiplied, or 0 if the entry should not
+     * be measured at all. Nested entries inherit the decision of the
+     * outermost entry, so that all the groups of an event share the
+     * same sample.
+     */
+    uint32_t enterStopwatch();
+    void exitStopwatch();
+
     /**
      * Callbacks called when we start executing an event/when we have
      * run to completion (including enqueued microtasks).
@@ -297,6 +336,35 @@ struct PerformanceMonitoring {
      * during this iteration.
      */
     uint64_t highestTimestampCounter_;
+
+    /**
+     * The average number of entries between two measured entries.
+     * Always >= 1.
+     */
+    uint32_t samplingInterval_;
+
+    /**
+     * The number of outermost entries to skip before the next sample.
+     */
+    uint64_t entriesUntilSample_;
+
+    /**
+     * The number of live instances of `AutoStopwatch`.
+     */
+    uint32_t stopwatchDepth_;
+
+    /**
+     * The weight of the current outermost entry, 0 if it is not
+     * being measured.
+     */
+    uint32_t currentSampleWeight_;
+
+    /**
+     * Used to jitter the distance between two samples, so that
+     * periodic patterns in the JS entries do not alias with the
+     * sampling interval.
+     */
+    mozilla::non_crypto::XorShift128PlusRNG samplingRNG_;
 };
 
 #if WINVER >= 0x0600
@@ -334,6 +402,10 @@ class AutoStopwatch final {
     // `true` if we are monitoring CPOW, `false` otherwise.
     bool isMonitoringCPOW_;
 
+    // The factor by which measures are multiplied when added to the
+    // groups, 0 if this entry is not sampled.
+    uint32_t weight_;
+
     // Timestamps captured while starting the stopwatch.
     uint64_t cyclesStart_;
     uint64_t CPOWTimeStart_;
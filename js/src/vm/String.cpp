@@ -364,10 +364,8 @@ CopyChars(Latin1Char* dest, const JSLinearString& str)
          */
         size_t len = str.length();
         const char16_t* chars = str.twoByteChars(nogc);
-        for (size_t i = 0; i < len; i++) {
-            MOZ_ASSERT(chars[i] <= JSString::MAX_LATIN1_CHAR);
-            dest[i] = chars[i];
-        }
+        MOZ_ASSERT(CharsFitLatin1(chars, len));
+        DeflateChars(dest, chars, len);
     }
 }
 
@@ -555,12 +553,59 @@ JSRope::flattenInternal(ExclusiveContext* maybecx)
     }
 }
 
+/*
+ * A rope has TwoByte chars if any of its leaves does, even if every char in
+ * those leaves is in the Latin1 range, for instance because the leaf was
+ * sliced from a TwoByte string. Flattening a large rope like that into a
+ * Latin1 buffer halves its size; the TwoByte leaves are deflated as they are
+ * copied, as CopyChars already does for TwoByte leaves of Latin1 ropes.
+ */
+static const size_t MinDeflatedFlattenLength = 1024;
+
+static bool
+RopeCharsFitLatin1(JSRope* rope)
+{
+    // Keep repeatedly appending to and flattening a string linear: when the
+    // leftmost leaf is a TwoByte extensible string, flattenInternal can reuse
+    // its buffer, and rescanning it on every flatten would be quadratic.
+    JSString* leftMost = rope;
+    while (leftMost->isRope())
+        leftMost = leftMost->asRope().leftChild();
+    if (leftMost->isExtensible() && leftMost->hasTwoByteChars())
+        return false;
+
+    // Visit the TwoByte subtrees without mutating the rope, giving up on OOM.
+    // Latin1 ropes may also have TwoByte leaves, but their chars are known to
+    // fit (see CopyChars above).
+    AutoCheckCannotGC nogc;
+    Vector<JSString*, 16, SystemAllocPolicy> pending;
+    JSString* str = rope;
+    while (true) {
+        if (str->hasTwoByteChars()) {
+            if (str->isRope()) {
+                if (!pending.append(str->asRope().rightChild()))
+                    return false;
+                str = str->asRope().leftChild();
+                continue;
+            }
+            JSLinearString& linear = str->asLinear();
+            if (!CharsFitLatin1(linear.twoByteChars(nogc), linear.length()))
+                return false;
+        }
+        if (pending.empty())
+            return true;
+        str = pending.popCopy();
+    }
+}
+
 template<JSRope::UsingBarrier b>
 JSFlatString*
 JSRope::flattenInternal(ExclusiveContext* maybecx)
 {
-    if (hasTwoByteChars())
-        return flattenInternal<b, char16_t>(maybecx);
+    if (hasTwoByteChars()) {
+        if (length() < MinDeflatedFlattenLength || !RopeCharsFitLatin1(this))
+            return flattenInternal<b, char16_t>(maybecx);
+    }
     return flattenInternal<b, Latin1Char>(maybecx);
 }
 
@@ -867,6 +912,21 @@ StaticStrings::trace(JSTracer* trc)
         TraceProcessGlobalRoot(trc, intStaticTable[i], "int-static-string");
 }
 
+#ifdef OMR // Compaction
+void
+StaticStrings::fixupAfterCompaction(JSTracer* trc)
+{
+    for (uint32_t i = 0; i < UNIT_STATIC_LIMIT; i++)
+        TraceManuallyBarrieredEdge(trc, &unitStaticTable[i], "unit-static-string");
+
+    for (uint32_t i = 0; i < NUM_SMALL_CHARS * NUM_SMALL_CHARS; i++)
+        TraceManuallyBarrieredEdge(trc, &length2StaticTable[i], "length2-static-string");
+
+    for (uint32_t i = 0; i < INT_STATIC_LIMIT; i++)
+        TraceManuallyBarrieredEdge(trc, &intStaticTable[i], "int-static-string");
+}
+#endif // OMR Compaction
+
 template <typename CharT>
 /* static */ bool
 StaticStrings::isStatic(const CharT* chars, size_t length)
@@ -1093,12 +1153,7 @@ js::NewDependentString(JSContext* cx, JSString* baseArg, size_t start, size_t le
 static bool
 CanStoreCharsAsLatin1(const char16_t* s, size_t length)
 {
-    for (const char16_t* end = s + length; s < end; ++s) {
-        if (*s > JSString::MAX_LATIN1_CHAR)
-            return false;
-    }
-
-    return true;
+    return CharsFitLatin1(s, length);
 }
 
 static bool
@@ -1157,10 +1212,8 @@ NewStringDeflated(ExclusiveContext* cx, const char16_t* s, size_t n)
     if (!news)
         return nullptr;
 
-    for (size_t i = 0; i < n; i++) {
-        MOZ_ASSERT(s[i] <= JSString::MAX_LATIN1_CHAR);
-        news.get()[i] = Latin1Char(s[i]);
-    }
+    MOZ_ASSERT(CharsFitLatin1(s, n));
+    DeflateChars(news.get(), s, n);
     news[n] = '\0';
 
     JSFlatString* str = JSFlatString::new_<allowGC>(cx, news.get(), n);
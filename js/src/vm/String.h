@@ -1022,6 +1022,10 @@ class StaticStrings
 
     bool init(JSContext* cx);
     void trace(JSTracer* trc);
+#ifdef OMR // Compaction
+    // trace() passes the atoms by value, so they are updated here instead.
+    void fixupAfterCompaction(JSTracer* trc);
+#endif // OMR Compaction
 
     static bool hasUint(uint32_t u) { return u < INT_STATIC_LIMIT; }
 
@@ -9,7 +9,9 @@
 #include "mozilla/Alignment.h"
 #include "mozilla/Casting.h"
 #include "mozilla/FloatingPoint.h"
+#include "mozilla/Move.h"
 #include "mozilla/PodOperations.h"
+#include "mozilla/TypeTraits.h"
 
 #include <string.h>
 #ifndef XP_WIN
@@ -20,6 +22,7 @@
 #include "jsarray.h"
 #include "jscntxt.h"
 #include "jscpucfg.h"
+#include "jsgc.h"
 #include "jsnum.h"
 #include "jsobj.h"
 #include "jstypes.h"
@@ -2861,6 +2864,233 @@ js::StringIsTypedArrayIndex(const char16_t* s, size_t length, uint64_t* indexp);
 template bool
 js::StringIsTypedArrayIndex(const Latin1Char* s, size_t length, uint64_t* indexp);
 
+/*
+ * %TypedArray%.prototype.sort without a comparator sorts numerically, so the
+ * elements can be radix sorted. Each element is mapped in place to an
+ * unsigned key of the same size which orders the same way, the keys are
+ * sorted a byte at a time, and then mapped back.
+ */
+namespace {
+
+template <typename T, typename U>
+struct IntegerSortKey
+{
+    typedef U Key;
+
+    // Flipping the sign bit orders signed values as unsigned keys.
+    static const U SignBit = mozilla::IsSigned<T>::value ? U(U(1) << (sizeof(U) * 8 - 1)) : 0;
+
+    static U toKey(T v) { return U(v) ^ SignBit; }
+    static T fromKey(U key) { return T(key ^ SignBit); }
+};
+
+template <typename T, typename U>
+struct FloatSortKey
+{
+    typedef U Key;
+
+    static const U SignBit = U(1) << (sizeof(U) * 8 - 1);
+
+    // Flip every bit of negative numbers and only the sign bit of the others,
+    // which orders -0 before +0. All NaNs map to the largest key, so they
+    // sort last, and come back as a positive quiet NaN.
+    static U toKey(T v) {
+        if (mozilla::IsNaN(v))
+            return U(-1);
+        U bits = mozilla::BitwiseCast<U>(v);
+        return (bits & SignBit) ? ~bits : bits ^ SignBit;
+    }
+    static T fromKey(U key) {
+        return mozilla::BitwiseCast<T>((key & SignBit) ? key ^ SignBit : ~key);
+    }
+};
+
+// Below this length, insertion sort beats setting up the radix passes.
+static const size_t InsertionSortMaxLength = 64;
+
+// Above this length, half of the array is sorted on a helper thread.
+static const size_t ParallelSortMinLength = 256 * 1024;
+
+// Sort |keys|, using |scratch| as a buffer of the same length.
+template <typename U>
+static void
+RadixSortKeys(U* keys, U* scratch, size_t length)
+{
+    if (length <= InsertionSortMaxLength) {
+        for (size_t i = 1; i < length; i++) {
+            U key = keys[i];
+            size_t j = i;
+            for (; j > 0 && keys[j - 1] > key; j--)
+                keys[j] = keys[j - 1];
+            keys[j] = key;
+        }
+        return;
+    }
+
+    static const size_t Passes = sizeof(U);
+    static const size_t Radix = 256;
+
+    // Count the occurrences of every digit in a single pass over the keys.
+    uint32_t counts[Passes][Radix];
+    mozilla::PodArrayZero(counts);
+    for (size_t i = 0; i < length; i++) {
+        U key = keys[i];
+        for (size_t pass = 0; pass < Passes; pass++)
+            counts[pass][(key >> (pass * 8)) & 0xff]++;
+    }
+
+    U* src = keys;
+    U* dst = scratch;
+    for (size_t pass = 0; pass < Passes; pass++) {
+        unsigned shift = pass * 8;
+        uint32_t* digitCounts = counts[pass];
+
+        // A digit shared by every key doesn't change the order.
+        if (digitCounts[(src[0] >> shift) & 0xff] == length)
+            continue;
+
+        uint32_t offset = 0;
+        for (size_t digit = 0; digit < Radix; digit++) {
+            uint32_t count = digitCounts[digit];
+            digitCounts[digit] = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            U key = src[i];
+            dst[digitCounts[(key >> shift) & 0xff]++] = key;
+        }
+        mozilla::Swap(src, dst);
+    }
+
+    if (src != keys)
+        mozilla::PodCopy(keys, src, length);
+}
+
+template <typename U>
+class RadixSortTask : public GCParallelTask
+{
+    U* keys_;
+    U* scratch_;
+    size_t length_;
+
+    void run() override {
+        RadixSortKeys(keys_, scratch_, length_);
+    }
+
+  public:
+    RadixSortTask(U* keys, U* scratch, size_t length)
+      : keys_(keys), scratch_(scratch), length_(length)
+    {}
+
+    ~RadixSortTask() override { join(); }
+};
+
+template <typename K, typename T>
+static bool
+SortElements(JSContext* cx, T* elements, size_t length)
+{
+    typedef typename K::Key U;
+    static_assert(sizeof(T) == sizeof(U), "keys replace elements in place");
+
+    UniquePtr<U[], JS::FreePolicy> scratch(cx->pod_malloc<U>(length));
+    if (!scratch)
+        return false;
+
+    JS::AutoCheckCannotGC nogc;
+
+    U* keys = reinterpret_cast<U*>(elements);
+    for (size_t i = 0; i < length; i++) {
+        T element;
+        memcpy(&element, &keys[i], sizeof(T));
+        keys[i] = K::toKey(element);
+    }
+
+    if (length < ParallelSortMinLength || !CanUseExtraThreads()) {
+        RadixSortKeys(keys, scratch.get(), length);
+        for (size_t i = 0; i < length; i++) {
+            T element = K::fromKey(keys[i]);
+            memcpy(&keys[i], &element, sizeof(T));
+        }
+        return true;
+    }
+
+    // Sort the two halves concurrently, then merge them into |scratch| and
+    // map the keys back into the array.
+    size_t half = length / 2;
+    {
+        RadixSortTask<U> task(keys + half, scratch.get() + half, length - half);
+        if (!task.start())
+            task.runFromMainThread(cx->runtime());
+        RadixSortKeys(keys, scratch.get(), half);
+    }
+
+    U* left = keys;
+    U* leftEnd = keys + half;
+    U* right = leftEnd;
+    U* rightEnd = keys + length;
+    U* out = scratch.get();
+    while (left != leftEnd && right != rightEnd)
+        *out++ = (*right < *left) ? *right++ : *left++;
+    while (left != leftEnd)
+        *out++ = *left++;
+    while (right != rightEnd)
+        *out++ = *right++;
+
+    for (size_t i = 0; i < length; i++) {
+        T element = K::fromKey(scratch[i]);
+        memcpy(&keys[i], &element, sizeof(T));
+    }
+    return true;
+}
+
+} /* anonymous namespace */
+
+bool
+js::SortTypedArray(JSContext* cx, Handle<TypedArrayObject*> tarray, bool* sorted)
+{
+    // Racing with other threads on shared memory is left to the self-hosted
+    // sort, which performs every access through the typed array.
+    if (tarray->isSharedMemory()) {
+        *sorted = false;
+        return true;
+    }
+
+    *sorted = true;
+    size_t length = tarray->length();
+    if (length <= 1)
+        return true;
+
+    void* data = tarray->viewDataUnshared();
+    switch (tarray->type()) {
+      case Scalar::Int8:
+        return SortElements<IntegerSortKey<int8_t, uint8_t>>(cx, static_cast<int8_t*>(data), length);
+      case Scalar::Uint8:
+      case Scalar::Uint8Clamped:
+        return SortElements<IntegerSortKey<uint8_t, uint8_t>>(cx, static_cast<uint8_t*>(data), length);
+      case Scalar::Int16:
+        return SortElements<IntegerSortKey<int16_t, uint16_t>>(cx, static_cast<int16_t*>(data), length);
+      case Scalar::Uint16:
+        return SortElements<IntegerSortKey<uint16_t, uint16_t>>(cx, static_cast<uint16_t*>(data), length);
+      case Scalar::Int32:
+        return SortElements<IntegerSortKey<int32_t, uint32_t>>(cx, static_cast<int32_t*>(data), length);
+      case Scalar::Uint32:
+        return SortElements<IntegerSortKey<uint32_t, uint32_t>>(cx, static_cast<uint32_t*>(data), length);
+      case Scalar::Float32:
+        return SortElements<FloatSortKey<float, uint32_t>>(cx, static_cast<float*>(data), length);
+      case Scalar::Float64:
+        return SortElements<FloatSortKey<double, uint64_t>>(cx, static_cast<double*>(data), length);
+      case Scalar::Int64:
+      case Scalar::Float32x4:
+      case Scalar::Int8x16:
+      case Scalar::Int16x8:
+      case Scalar::Int32x4:
+      case Scalar::MaxTypedArrayViewType:
+        break;
+    }
+    MOZ_CRASH("invalid typed array type");
+}
+
 /* ES6 draft rev 34 (2015 Feb 20) 9.4.5.3 [[DefineOwnProperty]] step 3.c. */
 bool
 js::DefineTypedArrayElement(JSContext* cx, HandleObject obj, uint64_t index,
@@ -298,6 +298,14 @@ MOZ_MUST_USE bool TypedArray_bufferGetter(JSContext* cx, unsigned argc, Value* v
 extern TypedArrayObject*
 TypedArrayCreateWithTemplate(JSContext* cx, HandleObject templateObj, int32_t len);
 
+/*
+ * Sort the elements of |tarray| numerically in place, as
+ * %TypedArray%.prototype.sort does without a comparator. Arrays backed by
+ * shared memory are not sorted, and *sorted is set to false.
+ */
+extern MOZ_MUST_USE bool
+SortTypedArray(JSContext* cx, Handle<TypedArrayObject*> tarray, bool* sorted);
+
 inline bool
 IsTypedArrayClass(const Class* clasp)
 {
@@ -432,6 +432,10 @@ class UnboxedArrayObject : public JSObject
     static void trace(JSTracer* trc, JSObject* object);
     static void objectMoved(JSObject* obj, const JSObject* old);
     static void finalize(FreeOp* fop, JSObject* obj);
+#ifdef OMR // Compaction
+    // See ArrayBufferObject::setInlineDataAfterCompaction.
+    void setInlineElementsAfterCompaction() { setInlineElements(); }
+#endif // OMR Compaction
 
     static size_t objectMovedDuringMinorGC(JSTracer* trc, JSObject* dst, JSObject* src,
                                            gc::AllocKind allocKind);
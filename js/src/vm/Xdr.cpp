@@ -11,14 +11,43 @@
 #include <string.h>
 
 #include "jsapi.h"
+#include "jscntxt.h"
 #include "jsscript.h"
 
+#include "frontend/TokenStream.h"
 #include "vm/Debugger.h"
 #include "vm/EnvironmentObject.h"
 
 using namespace js;
 using mozilla::PodEqual;
 
+/*
+ * Report an error while coding. Off the main thread the error is saved, to be
+ * reported when the decoded script is finished on the main thread.
+ */
+static void
+ReportXDRError(ExclusiveContext* cx, unsigned errorNumber, ...)
+{
+    va_list args;
+    va_start(args, errorNumber);
+
+    frontend::CompileError* err;
+    if (cx->isJSContext()) {
+        JS_ReportErrorNumberASCIIVA(cx->asJSContext(), GetErrorMessage, nullptr, errorNumber,
+                                    args);
+    } else if (cx->addPendingCompileError(&err)) {
+        err->report.flags = JSREPORT_ERROR;
+        err->report.errorNumber = errorNumber;
+        if (!ExpandErrorArgumentsVA(cx, GetErrorMessage, nullptr, errorNumber, &err->message,
+                                    nullptr, ArgumentsAreASCII, &err->report, args))
+        {
+            cx->addPendingOutOfMemory();
+        }
+    }
+
+    va_end(args);
+}
+
 void
 XDRBuffer::freeBuffer()
 {
@@ -39,7 +68,7 @@ XDRBuffer::grow(size_t n)
     MOZ_ASSERT(offset <= MAX_CAPACITY);
     if (n > MAX_CAPACITY - offset) {
         js::gc::AutoSuppressGC suppressGC(cx());
-        JS_ReportErrorNumberASCII(cx(), GetErrorMessage, nullptr, JSMSG_TOO_BIG_TO_ENCODE);
+        ReportXDRError(cx(), JSMSG_TOO_BIG_TO_ENCODE);
         return false;
     }
     size_t newCapacity = mozilla::RoundUpPow2(offset + n);
@@ -58,6 +87,24 @@ XDRBuffer::grow(size_t n)
     return true;
 }
 
+bool
+XDRBuffer::waitForData(size_t n)
+{
+    MOZ_ASSERT(n > size_t(limit - cursor));
+
+    if (stream) {
+        size_t offset = cursor - base;
+        size_t received = stream->waitForLength(offset + n);
+        MOZ_ASSERT(received >= size_t(limit - base));
+        limit = base + received;
+        if (n <= received - offset)
+            return true;
+    }
+
+    ReportXDRError(cx(), JSMSG_TRUNCATED_XDR);
+    return false;
+}
+
 template<XDRMode mode>
 bool
 XDRState<mode>::codeChars(const Latin1Char* chars, size_t nchars)
@@ -86,6 +133,8 @@ XDRState<mode>::codeChars(char16_t* chars, size_t nchars)
         mozilla::NativeEndian::copyAndSwapToLittleEndian(ptr, chars, nchars);
     } else {
         const uint8_t* ptr = buf.read(nbytes);
+        if (!ptr)
+            return false;
         mozilla::NativeEndian::copyAndSwapFromLittleEndian(chars, ptr, nchars);
     }
     return true;
@@ -97,8 +146,7 @@ VersionCheck(XDRState<mode>* xdr)
 {
     JS::BuildIdCharVector buildId;
     if (!xdr->cx()->buildIdOp() || !xdr->cx()->buildIdOp()(&buildId)) {
-        JS_ReportErrorNumberASCII(xdr->cx(), GetErrorMessage, nullptr,
-                                  JSMSG_BUILD_ID_NOT_AVAILABLE);
+        ReportXDRError(xdr->cx(), JSMSG_BUILD_ID_NOT_AVAILABLE);
         return false;
     }
     MOZ_ASSERT(!buildId.empty());
@@ -111,7 +159,7 @@ VersionCheck(XDRState<mode>* xdr)
         return false;
 
     if (mode == XDR_DECODE && buildIdLength != buildId.length()) {
-        JS_ReportErrorNumberASCII(xdr->cx(), GetErrorMessage, nullptr, JSMSG_BAD_BUILD_ID);
+        ReportXDRError(xdr->cx(), JSMSG_BAD_BUILD_ID);
         return false;
     }
 
@@ -133,7 +181,7 @@ VersionCheck(XDRState<mode>* xdr)
 
         if (!PodEqual(decodedBuildId.begin(), buildId.begin(), buildIdLength)) {
             // We do not provide binary compatibility with older scripts.
-            JS_ReportErrorNumberASCII(xdr->cx(), GetErrorMessage, nullptr, JSMSG_BAD_BUILD_ID);
+            ReportXDRError(xdr->cx(), JSMSG_BAD_BUILD_ID);
             return false;
         }
     }
@@ -179,11 +227,21 @@ XDRState<mode>::codeConstValue(MutableHandleValue vp)
     return XDRScriptConst(this, vp);
 }
 
-XDRDecoder::XDRDecoder(JSContext* cx, const void* data, uint32_t length)
+XDRDecoder::XDRDecoder(ExclusiveContext* cx, const void* data, uint32_t length)
   : XDRState<XDR_DECODE>(cx)
 {
     buf.setData(data, length);
 }
 
+XDRDecoder::XDRDecoder(ExclusiveContext* cx, const ReadOnlyCompileOptions& options,
+                       ScriptSourceObject** sourceObjectOut, const void* data, uint32_t length,
+                       XDRStream* stream /* = nullptr */)
+  : XDRState<XDR_DECODE>(cx)
+{
+    options_ = &options;
+    sourceObjectOut_ = sourceObjectOut;
+    buf.setStreamingData(data, length, stream);
+}
+
 template class js::XDRState<XDR_ENCODE>;
 template class js::XDRState<XDR_DECODE>;
@@ -15,12 +15,30 @@
 
 namespace js {
 
+class ScriptSourceObject;
+
+/*
+ * Source of the bytes of a decoding buffer whose contents are still arriving,
+ * as when decoding off the main thread while the data is being read in.
+ */
+class XDRStream {
+  public:
+    /*
+     * Block until at least |length| bytes of the buffer have been received or
+     * the stream has ended, and return the number of bytes received.
+     */
+    virtual size_t waitForLength(size_t length) = 0;
+
+  protected:
+    ~XDRStream() {}
+};
+
 class XDRBuffer {
   public:
-    explicit XDRBuffer(JSContext* cx)
-      : context(cx), base(nullptr), cursor(nullptr), limit(nullptr) { }
+    explicit XDRBuffer(ExclusiveContext* cx)
+      : context(cx), base(nullptr), cursor(nullptr), limit(nullptr), stream(nullptr) { }
 
-    JSContext* cx() const {
+    ExclusiveContext* cx() const {
         return context;
     }
 
@@ -36,8 +54,22 @@ class XDRBuffer {
         limit = base + length;
     }
 
+    /*
+     * Decode from |data| as its bytes arrive through |stream|. Only the first
+     * |received| bytes are available to begin with.
+     */
+    void setStreamingData(const void* data, uint32_t received, XDRStream* stream) {
+        setData(data, received);
+        this->stream = stream;
+    }
+
+    /*
+     * Both of the following return nullptr if the data ends before the
+     * requested bytes, after reporting an error.
+     */
     const uint8_t* read(size_t n) {
-        MOZ_ASSERT(n <= size_t(limit - cursor));
+        if (MOZ_UNLIKELY(n > size_t(limit - cursor)) && !waitForData(n))
+            return nullptr;
         uint8_t* ptr = cursor;
         cursor += n;
         return ptr;
@@ -45,7 +77,12 @@ class XDRBuffer {
 
     const char* readCString() {
         char* ptr = reinterpret_cast<char*>(cursor);
-        cursor = reinterpret_cast<uint8_t*>(strchr(ptr, '\0')) + 1;
+        void* end;
+        while (!(end = memchr(cursor, '\0', size_t(limit - cursor)))) {
+            if (!waitForData(size_t(limit - cursor) + 1))
+                return nullptr;
+        }
+        cursor = static_cast<uint8_t*>(end) + 1;
         MOZ_ASSERT(base < cursor);
         MOZ_ASSERT(cursor <= limit);
         return ptr;
@@ -65,11 +102,13 @@ class XDRBuffer {
 
   private:
     bool grow(size_t n);
+    bool waitForData(size_t n);
 
-    JSContext*  const context;
+    ExclusiveContext* const context;
     uint8_t*    base;
     uint8_t*    cursor;
     uint8_t*    limit;
+    XDRStream*  stream;
 };
 
 /*
@@ -81,14 +120,34 @@ class XDRState {
     XDRBuffer buf;
 
   protected:
-    explicit XDRState(JSContext* cx)
-      : buf(cx) { }
+    /*
+     * Options of the compilation being decoded, and where to store the
+     * top-level ScriptSourceObject, when decoding off the main thread. The
+     * source object is then initialized from the options once the decoded
+     * script has reached the main thread.
+     */
+    const ReadOnlyCompileOptions* options_;
+    ScriptSourceObject** sourceObjectOut_;
+
+    explicit XDRState(ExclusiveContext* cx)
+      : buf(cx), options_(nullptr), sourceObjectOut_(nullptr) { }
 
   public:
-    JSContext* cx() const {
+    ExclusiveContext* cx() const {
         return buf.cx();
     }
 
+    bool hasOptions() const {
+        return !!options_;
+    }
+    const ReadOnlyCompileOptions& options() const {
+        MOZ_ASSERT(hasOptions());
+        return *options_;
+    }
+    ScriptSourceObject** sourceObjectOut() const {
+        return sourceObjectOut_;
+    }
+
     bool codeUint8(uint8_t* n) {
         if (mode == XDR_ENCODE) {
             uint8_t* ptr = buf.write(sizeof *n);
@@ -96,7 +155,10 @@ class XDRState {
                 return false;
             *ptr = *n;
         } else {
-            *n = *buf.read(sizeof *n);
+            const uint8_t* ptr = buf.read(sizeof *n);
+            if (!ptr)
+                return false;
+            *n = *ptr;
         }
         return true;
     }
@@ -109,6 +171,8 @@ class XDRState {
             mozilla::LittleEndian::writeUint16(ptr, *n);
         } else {
             const uint8_t* ptr = buf.read(sizeof *n);
+            if (!ptr)
+                return false;
             *n = mozilla::LittleEndian::readUint16(ptr);
         }
         return true;
@@ -122,6 +186,8 @@ class XDRState {
             mozilla::LittleEndian::writeUint32(ptr, *n);
         } else {
             const uint8_t* ptr = buf.read(sizeof *n);
+            if (!ptr)
+                return false;
             *n = mozilla::LittleEndian::readUint32(ptr);
         }
         return true;
@@ -135,6 +201,8 @@ class XDRState {
             mozilla::LittleEndian::writeUint64(ptr, *n);
         } else {
             const uint8_t* ptr = buf.read(sizeof(*n));
+            if (!ptr)
+                return false;
             *n = mozilla::LittleEndian::readUint64(ptr);
         }
         return true;
@@ -179,7 +247,10 @@ class XDRState {
                 return false;
             memcpy(ptr, bytes, len);
         } else {
-            memcpy(bytes, buf.read(len), len);
+            const uint8_t* ptr = buf.read(len);
+            if (!ptr)
+                return false;
+            memcpy(bytes, ptr, len);
         }
         return true;
     }
@@ -199,6 +270,8 @@ class XDRState {
             memcpy(ptr, *sp, n);
         } else {
             *sp = buf.readCString();
+            if (!*sp)
+                return false;
         }
         return true;
     }
@@ -213,7 +286,7 @@ class XDRState {
 
 class XDREncoder : public XDRState<XDR_ENCODE> {
   public:
-    explicit XDREncoder(JSContext* cx)
+    explicit XDREncoder(ExclusiveContext* cx)
       : XDRState<XDR_ENCODE>(cx) {
     }
 
@@ -234,8 +307,16 @@ class XDREncoder : public XDRState<XDR_ENCODE> {
 
 class XDRDecoder : public XDRState<XDR_DECODE> {
   public:
-    XDRDecoder(JSContext* cx, const void* data, uint32_t length);
+    XDRDecoder(ExclusiveContext* cx, const void* data, uint32_t length);
 
+    /*
+     * Decoder for off main thread use. If |stream| is non-null, only the first
+     * |length| bytes of |data| have been received and the rest are waited for
+     * as they are needed.
+     */
+    XDRDecoder(ExclusiveContext* cx, const ReadOnlyCompileOptions& options,
+               ScriptSourceObject** sourceObjectOut, const void* data, uint32_t length,
+               XDRStream* stream = nullptr);
 };
 
 } /* namespace js */
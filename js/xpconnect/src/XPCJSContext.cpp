@@ -1429,11 +1429,17 @@ ReloadPrefsCallback(const char* pref, void* data)
     bool useAsmJS = Preferences::GetBool(JS_OPTIONS_DOT_STR "asmjs") && !safeMode;
     bool useWasm = Preferences::GetBool(JS_OPTIONS_DOT_STR "wasm") && !safeMode;
     bool useWasmBaseline = Preferences::GetBool(JS_OPTIONS_DOT_STR "wasm_baselinejit") && !safeMode;
+    bool useWasmTiering = Preferences::GetBool(JS_OPTIONS_DOT_STR "wasm_tiering") && !safeMode;
     bool throwOnAsmJSValidationFailure = Preferences::GetBool(JS_OPTIONS_DOT_STR
                                                               "throw_on_asmjs_validation_failure");
     bool useNativeRegExp = Preferences::GetBool(JS_OPTIONS_DOT_STR "native_regexp") && !safeMode;
+    bool useSharedRegExpCache = Preferences::GetBool(JS_OPTIONS_DOT_STR "shared_regexp_cache");
+    bool useLZ4SourceCompression = Preferences::GetBool(JS_OPTIONS_DOT_STR
+                                                        "lz4_source_compression");
 
     bool parallelParsing = Preferences::GetBool(JS_OPTIONS_DOT_STR "parallel_parsing");
+    bool concurrentParseTasks = Preferences::GetBool(JS_OPTIONS_DOT_STR
+                                                     "concurrent_parse_tasks");
     bool offthreadIonCompilation = Preferences::GetBool(JS_OPTIONS_DOT_STR
                                                        "ion.offthread_compilation");
     bool useBaselineEager = Preferences::GetBool(JS_OPTIONS_DOT_STR
@@ -1475,8 +1481,11 @@ ReloadPrefsCallback(const char* pref, void* data)
                              .setAsmJS(useAsmJS)
                              .setWasm(useWasm)
                              .setWasmAlwaysBaseline(useWasmBaseline)
+                             .setWasmTiering(useWasmTiering)
                              .setThrowOnAsmJSValidationFailure(throwOnAsmJSValidationFailure)
                              .setNativeRegExp(useNativeRegExp)
+                             .setSharedRegExpCache(useSharedRegExpCache)
+                             .setLZ4SourceCompression(useLZ4SourceCompression)
                              .setAsyncStack(useAsyncStack)
                              .setThrowOnDebuggeeWouldRun(throwOnDebuggeeWouldRun)
                              .setDumpStackOnDebuggeeWouldRun(dumpStackOnDebuggeeWouldRun)
@@ -1484,6 +1493,7 @@ ReloadPrefsCallback(const char* pref, void* data)
                              .setExtraWarnings(extraWarnings);
 
     JS_SetParallelParsingEnabled(cx, parallelParsing);
+    JS_SetConcurrentParseTasksEnabled(concurrentParseTasks);
     JS_SetOffthreadIonCompilationEnabled(cx, offthreadIonCompilation);
     JS_SetGlobalJitCompilerOption(cx, JSJITCOMPILER_BASELINE_WARMUP_TRIGGER,
                                   useBaselineEager ? 0 : -1);
@@ -2378,6 +2388,10 @@ ReportJSRuntimeExplicitTreeStats(const JS::RuntimeStats& rtStats,
         KIND_HEAP, rtStats.runtime.uncompressedSourceCache,
         "The uncompressed source code cache.");
 
+    RREPORT_BYTES(rtPath + NS_LITERAL_CSTRING("runtime/regexp-code-cache"),
+        KIND_HEAP, rtStats.runtime.regExpCodeCache,
+        "Regexp bytecode and tables shared across all compartments.");
+
     RREPORT_BYTES(rtPath + NS_LITERAL_CSTRING("runtime/script-data"),
         KIND_HEAP, rtStats.runtime.scriptData,
         "The table holding script data shared in the runtime.");
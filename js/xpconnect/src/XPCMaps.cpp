@@ -124,7 +124,9 @@ Native2WrappedNativeMap::newMap(int length)
 }
 
 Native2WrappedNativeMap::Native2WrappedNativeMap(int length)
-  : mTable(PLDHashTable::StubOps(), sizeof(Entry), length)
+  : mTable(PLDHashTable::StubOps(), sizeof(Entry), length),
+    mLastKey(nullptr),
+    mLastValue(nullptr)
 {
 }
 
@@ -115,8 +115,16 @@ public:
     inline XPCWrappedNative* Find(nsISupports* Obj)
     {
         NS_PRECONDITION(Obj,"bad param");
+        // The same object tends to be wrapped several times in a row, so
+        // check the last entry we found before hashing.
+        if (Obj == mLastKey)
+            return mLastValue;
         auto entry = static_cast<Entry*>(mTable.Search(Obj));
-        return entry ? entry->value : nullptr;
+        if (!entry)
+            return nullptr;
+        mLastKey = entry->key;
+        mLastValue = entry->value;
+        return entry->value;
     }
 
     inline XPCWrappedNative* Add(XPCWrappedNative* wrapper)
@@ -131,6 +139,8 @@ public:
             return entry->value;
         entry->key = obj;
         entry->value = wrapper;
+        mLastKey = obj;
+        mLastValue = wrapper;
         return wrapper;
     }
 
@@ -144,12 +154,16 @@ public:
                    "nsISupports identity! This will most likely cause serious "
                    "problems!");
 #endif
+        if (mLastKey == wrapper->GetIdentityObject())
+            ClearLastEntry();
         mTable.Remove(wrapper->GetIdentityObject());
     }
 
     inline uint32_t Count() { return mTable.EntryCount(); }
 
-    PLDHashTable::Iterator Iter() { return mTable.Iter(); }
+    // Callers may remove entries through the iterator, so forget the cached
+    // entry rather than risk handing out a dead wrapper later.
+    PLDHashTable::Iterator Iter() { ClearLastEntry(); return mTable.Iter(); }
 
     size_t SizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf) const;
 
@@ -157,8 +171,18 @@ private:
     Native2WrappedNativeMap();    // no implementation
     explicit Native2WrappedNativeMap(int size);
 
+    void ClearLastEntry()
+    {
+        mLastKey = nullptr;
+        mLastValue = nullptr;
+    }
+
 private:
     PLDHashTable mTable;
+
+    // Single-entry cache of the last wrapper found or added.
+    nsISupports*      mLastKey;
+    XPCWrappedNative* mLastValue;
 };
 
 /*************************/
@@ -2667,7 +2667,6 @@ PaintedLayerDataNode::FindPaintedLayerFor(const nsIntRect& aVisibleRect,
           data.mScrollClip == aScrollClip) {
         lowestUsableLayer = &data;
       }
-      nsIntRegion visibleRegion = data.mVisibleRegion;
       // Also check whether the event-regions intersect the visible rect,
       // unless we're in an inactive layer, in which case the event-regions
       // will be hoisted out into their own layer.
@@ -2678,7 +2677,7 @@ PaintedLayerDataNode::FindPaintedLayerFor(const nsIntRect& aVisibleRect,
            data.mScaledMaybeHitRegionBounds.Intersects(aVisibleRect))) {
         break;
       }
-      if (visibleRegion.Intersects(aVisibleRect)) {
+      if (data.mVisibleRegion.Intersects(aVisibleRect)) {
         break;
       }
     }
@@ -3354,13 +3353,19 @@ PaintedLayerData::Accumulate(ContainerState* aState,
     aItem->DisableComponentAlpha();
   }
 
+  // Consecutive items usually share their clip, in which case there is no
+  // need to copy its rounded rects again.
   bool clipMatches = mItemClip == aClip;
-  mItemClip = aClip;
+  if (!clipMatches) {
+    mItemClip = aClip;
+  }
 
   mAssignedDisplayItems.AppendElement(AssignedDisplayItem(aItem, aClip, aLayerState));
 
-  if (!mIsSolidColorInVisibleRegion && mOpaqueRegion.Contains(aVisibleRect) &&
-      mVisibleRegion.Contains(aVisibleRect) && !mImage) {
+  if (!mIsSolidColorInVisibleRegion && !mImage &&
+      mOpaqueRegion.Contains(aVisibleRect)) {
+    NS_ASSERTION(mVisibleRegion.Contains(aVisibleRect),
+                 "the opaque region should be inside the visible region");
     // A very common case! Most pages have a PaintedLayer with the page
     // background (opaque) visible and most or all of the page content over the
     // top of that background.
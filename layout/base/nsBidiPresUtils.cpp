@@ -19,6 +19,7 @@
 #include "nsFirstLetterFrame.h"
 #include "nsUnicodeProperties.h"
 #include "nsTextFrame.h"
+#include "nsTextFragment.h"
 #include "nsBlockFrame.h"
 #include "nsIFrameInlines.h"
 #include "nsStyleStructInlines.h"
@@ -673,9 +674,82 @@ CreateContinuation(nsIFrame*  aFrame,
  *  We may also need to call RemoveBidiContinuation() to convert frames created
  *  by EnsureBidiContinuation() in previous reflows into fluid continuations.
  */
+/**
+ * Returns true if bidi resolution would give level 0 to all the frames in the
+ * sibling list starting at aFirstChild, and their descendants, without
+ * having to split or join any of them: there is no right-to-left text, no
+ * style that implies bidi control characters, and nothing left over from an
+ * earlier resolution that found right-to-left text.
+ */
+static bool
+IsPureLTRFrameList(nsIFrame* aFirstChild)
+{
+  for (nsIFrame* frame = aFirstChild; frame; frame = frame->GetNextSibling()) {
+    if (nsGkAtoms::placeholderFrame == frame->GetType() &&
+        nsPlaceholderFrame::GetRealFrameForPlaceholder(frame)->GetType() ==
+          nsGkAtoms::letterFrame) {
+      // TraverseFrames includes floating first letters in the paragraph;
+      // leave those to it.
+      return false;
+    }
+
+    if (frame->GetPrevContinuation() && !frame->GetPrevInFlow()) {
+      // A bidi continuation, which may need to be joined again.
+      return false;
+    }
+
+    if (frame->IsFrameOfType(nsIFrame::eBidiInlineContainer)) {
+      nsStyleContext* sc = frame->StyleContext();
+      if (GetBidiControl(sc) != 0 || GetBidiOverride(sc) != 0) {
+        return false;
+      }
+      if (!(frame->GetStateBits() & NS_FRAME_FIRST_REFLOW) &&
+          frame->GetChildList(nsIFrame::kOverflowList).FirstChild()) {
+        // TraverseFrames would drain this, and we'd have to look at it too.
+        return false;
+      }
+    }
+
+    if (IsBidiLeaf(frame)) {
+      FrameBidiData bidiData = nsBidi::GetBidiData(frame);
+      if (bidiData.embeddingLevel != 0 || bidiData.baseLevel != 0) {
+        return false;
+      }
+      if (nsGkAtoms::textFrame == frame->GetType() &&
+          frame->GetContent()->GetText()->IsBidi()) {
+        return false;
+      }
+    } else if (!IsPureLTRFrameList(frame->PrincipalChildList().FirstChild())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 nsresult
 nsBidiPresUtils::Resolve(nsBlockFrame* aBlockFrame)
 {
+  // Once a document has any right-to-left text, every block goes through
+  // here.  Checking that a block only has left-to-right text is much cheaper
+  // than building its paragraphs and running the bidi algorithm on them, and
+  // for most blocks that's all there is.
+  if (BidiLevelFromStyle(aBlockFrame->StyleContext()) == NSBIDI_LTR &&
+      GetBidiOverride(aBlockFrame->StyleContext()) == 0 &&
+      !aBlockFrame->PresContext()->IsVisualMode()) {
+    bool isPureLTR = true;
+    for (nsBlockFrame* block = aBlockFrame; block && isPureLTR;
+         block = static_cast<nsBlockFrame*>(block->GetNextContinuation())) {
+      isPureLTR = IsPureLTRFrameList(block->PrincipalChildList().FirstChild());
+    }
+    if (isPureLTR) {
+      for (nsBlockFrame* block = aBlockFrame; block;
+           block = static_cast<nsBlockFrame*>(block->GetNextContinuation())) {
+        block->RemoveStateBits(NS_BLOCK_NEEDS_BIDI_RESOLUTION);
+      }
+      return NS_OK;
+    }
+  }
+
   BidiParagraphData bpd;
   bpd.Init(aBlockFrame);
 
@@ -7,16 +7,6 @@
 
 /* arena allocation for the frame tree and closely-related objects */
 
-// Even on 32-bit systems, we allocate objects from the frame arena
-// that require 8-byte alignment.  The cast to uintptr_t is needed
-// because plarena isn't as careful about mask construction as it
-// ought to be.
-#define ALIGN_SHIFT 3
-#define PL_ARENA_CONST_ALIGN_MASK ((uintptr_t(1) << ALIGN_SHIFT) - 1)
-#include "plarena.h"
-// plarena.h needs to be included first to make it use the above
-// PL_ARENA_CONST_ALIGN_MASK in this file.
-
 #include "nsPresArena.h"
 
 #include "mozilla/Poison.h"
@@ -24,17 +14,42 @@
 #include "nsArenaMemoryStats.h"
 #include "nsPrintfCString.h"
 #include "nsStyleContext.h"
+#include "prenv.h"
 
+#include <algorithm>
 #include <inttypes.h>
+#include <stdlib.h>
 
 using namespace mozilla;
 
-// Size to use for PLArena block allocations.
+// Size to use for chunk allocations.
 static const size_t ARENA_PAGE_SIZE = 8192;
 
+// Even on 32-bit systems, we allocate objects from the frame arena
+// that require 8-byte alignment.
+static const size_t ARENA_ALIGNMENT = 8;
+
+static inline size_t
+AlignedSize(size_t aSize)
+{
+  return (aSize + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+#ifdef DEBUG
+// With MOZ_PRES_ARENA_NO_RECYCLING set, freed objects are never reused, so
+// that comparing the arena's size with and without it shows how much memory
+// the free lists save (or how fragmented they are).
+static bool
+ShouldRecycle()
+{
+  static const bool sRecycle = !PR_GetEnv("MOZ_PRES_ARENA_NO_RECYCLING");
+  return sRecycle;
+}
+#endif
+
 nsPresArena::nsPresArena()
+  : mCurrentChunk(nullptr)
 {
-  PL_INIT_ARENA_POOL(&mPool, "PresArena", ARENA_PAGE_SIZE);
 }
 
 nsPresArena::~nsPresArena()
@@ -53,7 +68,61 @@ nsPresArena::~nsPresArena()
   }
 #endif
 
-  PL_FinishArenaPool(&mPool);
+  for (Chunk* chunk : mChunks) {
+    MOZ_MAKE_MEM_UNDEFINED(chunk, chunk->mSize);
+    free(chunk);
+  }
+}
+
+nsPresArena::Chunk*
+nsPresArena::NewChunk(size_t aObjectSize)
+{
+  const size_t headerSize = AlignedSize(sizeof(Chunk));
+  // Objects too large for a normal chunk get a chunk of their own, like
+  // PLArena used to do.
+  const size_t size = std::max(ARENA_PAGE_SIZE, headerSize + aObjectSize);
+  Chunk* chunk = static_cast<Chunk*>(malloc(size));
+  if (!chunk) {
+    NS_ABORT_OOM(size);
+  }
+  chunk->mSize = size;
+  chunk->mUsed = headerSize;
+  chunk->mLiveObjects = 0;
+
+  size_t index = 0;
+  size_t high = mChunks.Length();
+  while (index < high) {
+    size_t mid = index + (high - index) / 2;
+    if (mChunks[mid] < chunk) {
+      index = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  mChunks.InsertElementAt(index, chunk);
+  return chunk;
+}
+
+nsPresArena::Chunk*
+nsPresArena::ChunkFor(void* aPtr) const
+{
+  // Find the last chunk that starts at or before aPtr.
+  size_t low = 0;
+  size_t high = mChunks.Length();
+  while (high - low > 1) {
+    size_t mid = low + (high - low) / 2;
+    if (reinterpret_cast<void*>(mChunks[mid]) <= aPtr) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  Chunk* chunk = mChunks[low];
+  MOZ_ASSERT(reinterpret_cast<char*>(chunk) < static_cast<char*>(aPtr) &&
+             static_cast<char*>(aPtr) <
+               reinterpret_cast<char*>(chunk) + chunk->mUsed,
+             "pointer not allocated from this arena");
+  return chunk;
 }
 
 /* inline */ void
@@ -114,7 +183,7 @@ nsPresArena::Allocate(uint32_t aCode, size_t aSize)
   MOZ_ASSERT(aSize > 0, "PresArena cannot allocate zero bytes");
 
   // We only hand out aligned sizes
-  aSize = PL_ARENA_ALIGN(&mPool, aSize);
+  aSize = AlignedSize(aSize);
 
   // If there is no free-list entry for this type already, we have
   // to create one now, to record its size.
@@ -157,15 +226,22 @@ nsPresArena::Allocate(uint32_t aCode, size_t aSize)
     }
 #endif
     MOZ_MAKE_MEM_UNDEFINED(result, list->mEntrySize);
+    ChunkFor(result)->mLiveObjects++;
     return result;
   }
 
-  // Allocate a new chunk from the arena
+  // Carve a new object out of the current chunk, or out of a new one.
   list->mEntriesEverAllocated++;
-  PL_ARENA_ALLOCATE(result, &mPool, aSize);
-  if (!result) {
-    NS_ABORT_OOM(aSize);
+  Chunk* chunk = mCurrentChunk;
+  if (!chunk || chunk->mSize - chunk->mUsed < aSize) {
+    chunk = NewChunk(aSize);
+    if (chunk->mSize == ARENA_PAGE_SIZE) {
+      mCurrentChunk = chunk;
+    }
   }
+  result = reinterpret_cast<char*>(chunk) + chunk->mUsed;
+  chunk->mUsed += aSize;
+  chunk->mLiveObjects++;
   return result;
 }
 
@@ -180,9 +256,56 @@ nsPresArena::Free(uint32_t aCode, void* aPtr)
   mozWritePoison(aPtr, list->mEntrySize);
 
   MOZ_MAKE_MEM_NOACCESS(aPtr, list->mEntrySize);
+  ChunkFor(aPtr)->mLiveObjects--;
+#ifdef DEBUG
+  if (!ShouldRecycle()) {
+    return;
+  }
+#endif
   list->mEntries.AppendElement(aPtr);
 }
 
+size_t
+nsPresArena::ReleaseFreeChunks()
+{
+  bool haveFreeChunks = false;
+  for (Chunk* chunk : mChunks) {
+    if (chunk->mLiveObjects == 0) {
+      haveFreeChunks = true;
+      break;
+    }
+  }
+  if (!haveFreeChunks) {
+    return 0;
+  }
+
+  // Every object in a chunk without live objects is on a free list.
+  for (auto iter = mFreeLists.Iter(); !iter.Done(); iter.Next()) {
+    FreeList* entry = iter.Get();
+    size_t oldLength = entry->mEntries.Length();
+    entry->mEntries.RemoveElementsBy([this](void* aPtr) {
+      return ChunkFor(aPtr)->mLiveObjects == 0;
+    });
+    // Those objects are gone for good.
+    entry->mEntriesEverAllocated -= oldLength - entry->mEntries.Length();
+  }
+
+  size_t released = 0;
+  mChunks.RemoveElementsBy([this, &released](Chunk* aChunk) {
+    if (aChunk->mLiveObjects != 0) {
+      return false;
+    }
+    if (aChunk == mCurrentChunk) {
+      mCurrentChunk = nullptr;
+    }
+    released += aChunk->mSize;
+    MOZ_MAKE_MEM_UNDEFINED(aChunk, aChunk->mSize);
+    free(aChunk);
+    return true;
+  });
+  return released;
+}
+
 void
 nsPresArena::AddSizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf,
                                     nsArenaMemoryStats* aArenaStats)
@@ -198,19 +321,23 @@ nsPresArena::AddSizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf,
   // slop in the arena itself as well as the size of objects that
   // we've not measured explicitly.
 
-  size_t mallocSize = PL_SizeOfArenaPoolExcludingPool(&mPool, aMallocSizeOf);
+  size_t mallocSize = mChunks.ShallowSizeOfExcludingThis(aMallocSizeOf);
+  for (Chunk* chunk : mChunks) {
+    mallocSize += aMallocSizeOf(chunk);
+  }
   mallocSize += mFreeLists.SizeOfExcludingThis(aMallocSizeOf);
 
   size_t totalSizeInFreeLists = 0;
   for (auto iter = mFreeLists.Iter(); !iter.Done(); iter.Next()) {
     FreeList* entry = iter.Get();
 
-    // Note that we're not measuring the size of the entries on the free
-    // list here.  The free list knows how many objects we've allocated
-    // ever (which includes any objects that may be on the FreeList's
-    // |mEntries| at this point) and we're using that to determine the
-    // total size of objects allocated with a given ID.
-    size_t totalSize = entry->mEntrySize * entry->mEntriesEverAllocated;
+    // The free list knows how many objects we've allocated ever, including
+    // the ones on its |mEntries| at this point, which are not in use.  Only
+    // count the objects in use against their type; the free ones end up in
+    // mOther along with the arena's slop.
+    MOZ_ASSERT(entry->mEntriesEverAllocated >= entry->mEntries.Length());
+    size_t totalSize = entry->mEntrySize *
+      (entry->mEntriesEverAllocated - entry->mEntries.Length());
     size_t* p;
 
     switch (NS_PTR_TO_INT32(entry->mKey)) {
@@ -20,7 +20,6 @@
 #include "nsHashKeys.h"
 #include "nsTArray.h"
 #include "nsTHashtable.h"
-#include "plarena.h"
 
 struct nsArenaMemoryStats;
 
@@ -115,10 +114,31 @@ public:
   void AddSizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf,
                               nsArenaMemoryStats* aArenaStats);
 
+  /**
+   * Returns the chunks that only contain freed objects to the system, and
+   * drops those objects from the free lists.  Returns the number of bytes
+   * released.  Called on memory pressure.
+   */
+  size_t ReleaseFreeChunks();
+
 private:
   void* Allocate(uint32_t aCode, size_t aSize);
   void Free(uint32_t aCode, void* aPtr);
 
+  // A malloc'd block of memory that objects are carved out of, starting
+  // right after this header.  Objects never move, and a chunk can only be
+  // freed once none of the objects in it are in use, so we count them.
+  struct Chunk
+  {
+    size_t mSize;        // of the whole block, including this header
+    size_t mUsed;        // bytes handed out, including this header
+    size_t mLiveObjects; // objects allocated and not freed
+  };
+
+  Chunk* NewChunk(size_t aObjectSize);
+  // Returns the chunk that aPtr was allocated from.
+  Chunk* ChunkFor(void* aPtr) const;
+
   inline void ClearArenaRefPtrWithoutDeregistering(
       void* aPtr,
       mozilla::ArenaObjectID aObjectID);
@@ -156,7 +176,11 @@ private:
   };
 
   nsTHashtable<FreeList> mFreeLists;
-  PLArenaPool mPool;
+  // All our chunks, sorted by address.
+  nsTArray<Chunk*> mChunks;
+  // The chunk that new objects are allocated from when their free list is
+  // empty.
+  Chunk* mCurrentChunk;
   nsDataHashtable<nsPtrHashKey<void>, mozilla::ArenaObjectID> mArenaRefPtrs;
 };
 
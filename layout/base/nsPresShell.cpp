@@ -9755,6 +9755,11 @@ PresShell::Observe(nsISupports* aSubject,
     if (!AssumeAllFramesVisible() && mPresContext->IsRootContentDocument()) {
       DoUpdateApproximateFrameVisibility(/* aRemoveOnly = */ true);
     }
+    // Give back the memory of frames and other arena objects that have been
+    // destroyed since the peak of this document's layout.
+    if (!mIsDestroying) {
+      mFrameArena.ReleaseFreeChunks();
+    }
     return NS_OK;
   }
 
@@ -64,6 +64,7 @@
 #include "VsyncSource.h"
 #include "mozilla/VsyncDispatcher.h"
 #include "nsThreadUtils.h"
+#include "nsThread.h"
 #include "mozilla/Unused.h"
 #include "mozilla/TimelineConsumers.h"
 #include "nsAnimationManager.h"
@@ -82,6 +83,10 @@ static mozilla::LazyLogModule sRefreshDriverLog("nsRefreshDriver");
 // after 10 minutes, stop firing off inactive timers
 #define DEFAULT_INACTIVE_TIMER_DISABLE_SECONDS 600
 
+// How long idle runnables may run on the main thread when no refresh driver
+// is ticking.
+#define DEFAULT_LONG_IDLE_PERIOD_MS 50
+
 // The number of seconds spent skipping frames because we are waiting for the compositor
 // before logging.
 #ifdef MOZ_VALGRIND
@@ -195,6 +200,22 @@ public:
   TimeStamp MostRecentRefresh() const { return mLastFireTime; }
   int64_t MostRecentRefreshEpochTime() const { return mLastFireEpoch; }
 
+  TimeStamp GetIdleDeadlineHint(TimeStamp aDefault)
+  {
+    MOZ_ASSERT(NS_IsMainThread());
+
+    if (mContentRefreshDrivers.IsEmpty() && mRootRefreshDrivers.IsEmpty()) {
+      // Nothing is going to tick, so we don't know of any deadline.
+      return aDefault;
+    }
+
+    // Leave enough time before the next tick to not delay it, assuming that
+    // it will take about as long as the previous one.  The result may well be
+    // in the past, meaning that the main thread isn't idle.
+    TimeStamp nextTick = mLastFireTime + GetTimerRate();
+    return nextTick - mLastTickDuration;
+  }
+
   void SwapRefreshDrivers(RefreshDriverTimer* aNewTimer)
   {
     MOZ_ASSERT(NS_IsMainThread());
@@ -220,6 +241,9 @@ protected:
   virtual void StopTimer() = 0;
   virtual void ScheduleNextTick(TimeStamp aNowTime) = 0;
 
+  // The expected time between two ticks.
+  virtual TimeDuration GetTimerRate() = 0;
+
   bool IsRootRefreshDriver(nsRefreshDriver* aDriver)
   {
     nsPresContext* rootContext = aDriver->PresContext()->GetRootPresContext();
@@ -272,8 +296,10 @@ protected:
     // RD is short for RefreshDriver
     profiler_tracing("Paint", "RD", TRACING_INTERVAL_START);
 
+    TimeStamp tickStart = TimeStamp::Now();
     TickRefreshDrivers(jsnow, now, mContentRefreshDrivers);
     TickRefreshDrivers(jsnow, now, mRootRefreshDrivers);
+    mLastTickDuration = TimeStamp::Now() - tickStart;
 
     profiler_tracing("Paint", "RD", TRACING_INTERVAL_END);
     LOG("[%p] done.", this);
@@ -288,6 +314,8 @@ protected:
   int64_t mLastFireEpoch;
   TimeStamp mLastFireTime;
   TimeStamp mTargetTime;
+  // How long ticking the refresh drivers took the last time.
+  TimeDuration mLastTickDuration;
 
   nsTArray<RefPtr<nsRefreshDriver> > mContentRefreshDrivers;
   nsTArray<RefPtr<nsRefreshDriver> > mRootRefreshDrivers;
@@ -338,6 +366,11 @@ public:
     return mRateMilliseconds;
   }
 
+  virtual TimeDuration GetTimerRate()
+  {
+    return mRateDuration;
+  }
+
 protected:
 
   virtual void StartTimer()
@@ -591,6 +624,19 @@ private:
     // RefreshDriverVsyncObserver.
   }
 
+  virtual TimeDuration GetTimerRate() override
+  {
+    if (mVsyncChild) {
+      TimeDuration rate = mVsyncChild->GetVsyncRate();
+      if (rate != TimeDuration::Forever()) {
+        return rate;
+      }
+      // We haven't heard about the rate from the parent yet.
+      return TimeDuration::FromMilliseconds(nsRefreshDriver::DefaultInterval());
+    }
+    return gfxPlatform::GetPlatform()->GetHardwareVsync()->GetGlobalDisplay().GetVsyncRate();
+  }
+
   void RunRefreshDrivers(TimeStamp aTimeStamp)
   {
     int64_t jsnow = JS_Now();
@@ -814,6 +860,31 @@ NS_IMPL_ISUPPORTS(VsyncChildCreateCallback, nsIIPCBackgroundChildCreateCallback)
 
 static RefreshDriverTimer* sRegularRateTimer;
 static InactiveRefreshDriverTimer* sThrottledRateTimer;
+static bool sIdlePeriodRegistered = false;
+
+namespace mozilla {
+
+/*
+ * The idle period of the main thread, which ends when the refresh driver is
+ * about to tick again.
+ */
+class RefreshDriverIdlePeriod final : public IdlePeriod
+{
+public:
+  virtual TimeStamp GetIdlePeriodHint() override
+  {
+    // Even if nothing is ticking, something may come up, so don't let idle
+    // runnables think that they can run forever.
+    TimeStamp longIdlePeriodEnd = TimeStamp::Now() +
+      TimeDuration::FromMilliseconds(DEFAULT_LONG_IDLE_PERIOD_MS);
+    return nsRefreshDriver::GetIdleDeadlineHint(longIdlePeriodEnd);
+  }
+
+private:
+  ~RefreshDriverIdlePeriod() {}
+};
+
+} // namespace mozilla
 
 #ifdef XP_WIN
 static int32_t sHighPrecisionTimerRequests = 0;
@@ -918,6 +989,17 @@ nsRefreshDriver::DefaultInterval()
   return NSToIntRound(1000.0 / gfxPlatform::GetDefaultFrameRate());
 }
 
+/* static */ TimeStamp
+nsRefreshDriver::GetIdleDeadlineHint(TimeStamp aDefault)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!sRegularRateTimer) {
+    return aDefault;
+  }
+  return sRegularRateTimer->GetIdleDeadlineHint(aDefault);
+}
+
 // Compute the interval to use for the refresh driver timer, in milliseconds.
 // outIsDefault indicates that rate was not explicitly set by the user
 // so we might choose other, more appropriate rates (e.g. vsync, etc)
@@ -1032,6 +1114,15 @@ nsRefreshDriver::nsRefreshDriver(nsPresContext* aPresContext)
   mNextThrottledFrameRequestTick = mMostRecentTick;
   mNextRecomputeVisibilityTick = mMostRecentTick;
 
+  if (!sIdlePeriodRegistered) {
+    // The main thread is always an nsThread.
+    nsThread* mainThread = static_cast<nsThread*>(NS_GetCurrentThread());
+    if (mainThread) {
+      mainThread->RegisterIdlePeriod(MakeAndAddRef<RefreshDriverIdlePeriod>());
+      sIdlePeriodRegistered = true;
+    }
+  }
+
   ++sRefreshDriverCount;
 }
 
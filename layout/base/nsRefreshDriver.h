@@ -296,6 +296,14 @@ public:
    */
   static int32_t DefaultInterval();
 
+  /**
+   * Returns a hint for when the current idle period of the main thread ends:
+   * the time of the next tick of the regular refresh timer, minus how long we
+   * expect that tick to take.  The result may be in the past.  Returns
+   * aDefault if the regular refresh timer isn't ticking.
+   */
+  static mozilla::TimeStamp GetIdleDeadlineHint(mozilla::TimeStamp aDefault);
+
   bool IsInRefresh() { return mInRefresh; }
 
   void SetIsResizeSuppressed() { mResizeSuppressed = true; }
@@ -598,7 +598,7 @@ MathMLTextRunFactory::RebuildTextRun(nsTransformedTextRun* aTextRun,
           gfxFontFeature settingSSTY;
           settingSSTY.mTag = TT_SSTY;
           settingSSTY.mValue = sstyLevel;
-          font.fontFeatureSettings.AppendElement(settingSSTY);
+          font.fontFeatureSettings.EnsureMutable().AppendElement(settingSSTY);
         }
       }
       /*
@@ -615,7 +615,7 @@ MathMLTextRunFactory::RebuildTextRun(nsTransformedTextRun* aTextRun,
         gfxFontFeature settingDTLS;
         settingDTLS.mTag = TT_DTLS;
         settingDTLS.mValue = 1;
-        font.fontFeatureSettings.AppendElement(settingDTLS);
+        font.fontFeatureSettings.EnsureMutable().AppendElement(settingDTLS);
       }
     }
   }
@@ -140,6 +140,7 @@ bool nsBlockFrame::gReallyNoisyReflow;
 bool nsBlockFrame::gNoisyFloatManager;
 bool nsBlockFrame::gVerifyLines;
 bool nsBlockFrame::gDisableResizeOpt;
+bool nsBlockFrame::gNoisyLineStats;
 
 int32_t nsBlockFrame::gNoiseIndent;
 
@@ -158,6 +159,7 @@ static const BlockDebugFlags gFlags[] = {
   { "lame-paint-metrics", &nsBlockFrame::gLamePaintMetrics },
   { "lame-reflow-metrics", &nsBlockFrame::gLameReflowMetrics },
   { "disable-resize-opt", &nsBlockFrame::gDisableResizeOpt },
+  { "line-stats", &nsBlockFrame::gNoisyLineStats },
 };
 #define NUM_DEBUG_FLAGS (sizeof(gFlags) / sizeof(gFlags[0]))
 
@@ -2083,6 +2085,43 @@ static void DumpLine(const BlockReflowInput& aState, nsLineBox* aLine,
 #endif
 }
 
+// Why ReflowDirtyLines reflowed a line that wasn't dirty when it started.
+enum class LineDirtyReason : uint8_t {
+  Clean,          // the line was not reflowed
+  Changed,        // the line was dirty before this reflow
+  SelfDirty,      // the block itself is dirty
+  ClearChildren,  // a block child has clear elements inside it
+  Clearance,      // the line's clearance may have changed
+  BRClearance,    // the line follows a clearing BR
+  PreviousMargin, // the margin carried into the line may have changed
+  PastBEnd,       // the line would slide past the available block-size
+  Fragmentation,  // the line may have to be pushed or pulled
+  FloatDamage,    // a float that moved may intersect the line
+  ContainerSize,  // the line is not left-aligned and our size changed
+  Count
+};
+
+static void
+MarkDirtyForReason(nsLineBox* aLine, LineDirtyReason aReason,
+                   LineDirtyReason& aDirtyReason)
+{
+  if (!aLine->IsDirty()) {
+    aDirtyReason = aReason;
+  }
+  aLine->MarkDirty();
+}
+
+#ifdef DEBUG
+static const char* const kLineDirtyReasonNames[] = {
+  "clean", "changed", "self-dirty", "clear-children", "clearance",
+  "br-clearance", "previous-margin", "past-bend", "fragmentation",
+  "float-damage", "container-size"
+};
+static_assert(MOZ_ARRAY_LENGTH(kLineDirtyReasonNames) ==
+                size_t(LineDirtyReason::Count),
+              "every LineDirtyReason needs a name");
+#endif
+
 void
 nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
 {
@@ -2099,6 +2138,12 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
     printf(" computedISize=%d\n", aState.mReflowInput.ComputedISize());
   }
   AutoNoisyIndenter indent(gNoisyReflow);
+
+  // For the line-stats flag: lines reflowed, by reason, and clean lines that
+  // were slid or left in place.
+  uint32_t reflowedLines[size_t(LineDirtyReason::Count)] = {};
+  uint32_t slidLines = 0;
+  uint32_t unmovedLines = 0;
 #endif
 
   bool selfDirty = (GetStateBits() & NS_FRAME_IS_DIRTY) ||
@@ -2140,15 +2185,18 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
     AutoNoisyIndenter indent2(gNoisyReflow);
 #endif
 
+    LineDirtyReason dirtyReason = line->IsDirty() ? LineDirtyReason::Changed
+                                                  : LineDirtyReason::Clean;
+
     if (selfDirty)
-      line->MarkDirty();
+      MarkDirtyForReason(line, LineDirtyReason::SelfDirty, dirtyReason);
 
     // This really sucks, but we have to look inside any blocks that have clear
     // elements inside them.
     // XXX what can we do smarter here?
     if (!line->IsDirty() && line->IsBlock() &&
         (line->mFirstChild->GetStateBits() & NS_BLOCK_HAS_CLEAR_CHILDREN)) {
-      line->MarkDirty();
+      MarkDirtyForReason(line, LineDirtyReason::ClearChildren, dirtyReason);
     }
 
     nsIFrame *replacedBlock = nullptr;
@@ -2180,12 +2228,12 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
             // block by deltaBCoord isn't going to put it in the predicted
             // position, then we'd better reflow the line.
             || newBCoord != line->BStart() + deltaBCoord) {
-          line->MarkDirty();
+          MarkDirtyForReason(line, LineDirtyReason::Clearance, dirtyReason);
         }
       } else {
         // Reflow the line if the line might have clearance now.
         if (curBCoord != newBCoord) {
-          line->MarkDirty();
+          MarkDirtyForReason(line, LineDirtyReason::Clearance, dirtyReason);
         }
       }
     }
@@ -2196,7 +2244,7 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
       if (aState.mBCoord != line->BStart() + deltaBCoord) {
         // SlideLine is not going to put the line where the clearance
         // put it. Reflow the line to be sure.
-        line->MarkDirty();
+        MarkDirtyForReason(line, LineDirtyReason::BRClearance, dirtyReason);
       }
       inlineFloatBreakType = StyleClear::None;
     }
@@ -2204,12 +2252,12 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
     bool previousMarginWasDirty = line->IsPreviousMarginDirty();
     if (previousMarginWasDirty) {
       // If the previous margin is dirty, reflow the current line
-      line->MarkDirty();
+      MarkDirtyForReason(line, LineDirtyReason::PreviousMargin, dirtyReason);
       line->ClearPreviousMarginDirty();
     } else if (line->BEnd() + deltaBCoord > aState.mBEndEdge) {
       // Lines that aren't dirty but get slid past our height constraint must
       // be reflowed.
-      line->MarkDirty();
+      MarkDirtyForReason(line, LineDirtyReason::PastBEnd, dirtyReason);
     }
 
     // If we have a constrained height (i.e., breaking columns/pages),
@@ -2224,13 +2272,16 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
         (deltaBCoord != 0 || aState.mReflowInput.IsBResize() ||
          aState.mReflowInput.mFlags.mMustReflowPlaceholders) &&
         (line->IsBlock() || line->HasFloats() || line->HadFloatPushed())) {
-      line->MarkDirty();
+      MarkDirtyForReason(line, LineDirtyReason::Fragmentation, dirtyReason);
     }
 
     if (!line->IsDirty()) {
       // See if there's any reflow damage that requires that we mark the
       // line dirty.
       PropagateFloatDamage(aState, line, deltaBCoord);
+      if (line->IsDirty()) {
+        dirtyReason = LineDirtyReason::FloatDamage;
+      }
     }
 
     // If the container size has changed, reset mContainerSize. If the
@@ -2250,7 +2301,7 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
           !IsAlignedLeft(align,
                          aState.mReflowInput.mStyleVisibility->mDirection,
                          StyleTextReset()->mUnicodeBidi, this)) {
-        line->MarkDirty();
+        MarkDirtyForReason(line, LineDirtyReason::ContainerSize, dirtyReason);
       }
     }
 
@@ -2285,6 +2336,9 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
     // line dirty below under "if (aState.mReflowInput.mDiscoveredClearance..."
     if (line->IsDirty() && (line->HasFloats() || !willReflowAgain)) {
       lastLineMovedUp = true;
+#ifdef DEBUG
+      reflowedLines[size_t(dirtyReason)]++;
+#endif
 
       bool maybeReflowingForFirstTime =
         line->IStart() == 0 && line->BStart() == 0 &&
@@ -2379,6 +2433,14 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
 
       lastLineMovedUp = deltaBCoord < 0;
 
+#ifdef DEBUG
+      if (deltaBCoord != 0) {
+        slidLines++;
+      } else {
+        unmovedLines++;
+      }
+#endif
+
       if (deltaBCoord != 0)
         SlideLine(aState, line, deltaBCoord);
       else
@@ -2450,6 +2512,21 @@ nsBlockFrame::ReflowDirtyLines(BlockReflowInput& aState)
     }
   }
 
+#ifdef DEBUG
+  if (gNoisyLineStats) {
+    IndentBy(stdout, gNoiseIndent);
+    ListTag(stdout);
+    printf(": line-stats slid=%u unmoved=%u reflowed:", slidLines,
+           unmovedLines);
+    for (size_t i = 0; i < size_t(LineDirtyReason::Count); ++i) {
+      if (reflowedLines[i]) {
+        printf(" %s=%u", kLineDirtyReasonNames[i], reflowedLines[i]);
+      }
+    }
+    printf("\n");
+  }
+#endif
+
   // Handle BR-clearance from the last line of the block
   if (inlineFloatBreakType != StyleClear::None) {
     aState.mBCoord = aState.ClearFloats(aState.mBCoord, inlineFloatBreakType);
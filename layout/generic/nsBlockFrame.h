@@ -887,6 +887,7 @@ public:
   static bool gNoisyFloatManager;
   static bool gVerifyLines;
   static bool gDisableResizeOpt;
+  static bool gNoisyLineStats;
 
   static int32_t gNoiseIndent;
 
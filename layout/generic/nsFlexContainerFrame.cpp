@@ -1607,6 +1607,52 @@ nsFlexContainerFrame::
   }
 }
 
+/**
+ * The result of the last "measuring" reflow of a flex item, along with the
+ * parts of the item's ReflowInput that it depends on.  As long as the item
+ * isn't dirty and is measured with the same sizes again, we can use the
+ * cached result instead of reflowing the item; without this, a flex item's
+ * subtree would get two reflows per reflow of its container, which grows
+ * exponentially with the depth of nested column flex containers.
+ */
+class CachedMeasuringReflowResult
+{
+public:
+  CachedMeasuringReflowResult(const ReflowInput& aReflowInput,
+                              nscoord aHeight, nscoord aAscent)
+    : mAvailableSize(aReflowInput.AvailableSize())
+    , mComputedSize(aReflowInput.ComputedSize())
+    , mComputedMinBSize(aReflowInput.ComputedMinBSize())
+    , mComputedMaxBSize(aReflowInput.ComputedMaxBSize())
+    , mHeight(aHeight)
+    , mAscent(aAscent)
+  {}
+
+  bool IsValidFor(const ReflowInput& aReflowInput) const {
+    return mAvailableSize == aReflowInput.AvailableSize() &&
+           mComputedSize == aReflowInput.ComputedSize() &&
+           mComputedMinBSize == aReflowInput.ComputedMinBSize() &&
+           mComputedMaxBSize == aReflowInput.ComputedMaxBSize();
+  }
+
+  nscoord Height() const { return mHeight; }
+  nscoord Ascent() const { return mAscent; }
+
+private:
+  // The cache key.
+  const LogicalSize mAvailableSize;
+  const LogicalSize mComputedSize;
+  const nscoord mComputedMinBSize;
+  const nscoord mComputedMaxBSize;
+
+  // The cached result.
+  const nscoord mHeight;
+  const nscoord mAscent;
+};
+
+NS_DECLARE_FRAME_PROPERTY_DELETABLE(CachedFlexMeasuringReflow,
+                                    CachedMeasuringReflowResult)
+
 nscoord
 nsFlexContainerFrame::
   MeasureFlexItemContentHeight(nsPresContext* aPresContext,
@@ -1630,6 +1676,27 @@ nsFlexContainerFrame::
     childRIForMeasuringHeight.SetHResize(true);
   }
 
+  // If neither the item nor anything that affects all of our kids has
+  // changed since we last measured the item with these sizes, we know what
+  // this reflow would give us.  Note that in that case we leave the item
+  // alone, so it doesn't count as having had a measuring reflow.
+  nsIFrame* frame = aFlexItem.Frame();
+  const CachedMeasuringReflowResult* cachedResult =
+    frame->Properties().Get(CachedFlexMeasuringReflow());
+  if (cachedResult && !NS_SUBTREE_DIRTY(frame) &&
+      !aParentReflowInput.ShouldReflowAllKids() &&
+      cachedResult->IsValidFor(childRIForMeasuringHeight)) {
+    MOZ_LOG(gFlexContainerLog, LogLevel::Debug,
+            ("Using cached measuring reflow for flex item %p\n", frame));
+    if (frame == mFrames.FirstChild() ||
+        aFlexItem.GetAlignSelf() == NS_STYLE_ALIGN_BASELINE) {
+      aFlexItem.SetAscent(cachedResult->Ascent());
+    }
+    return cachedResult->Height();
+  }
+  MOZ_LOG(gFlexContainerLog, LogLevel::Debug,
+          ("Measuring reflow for flex item %p\n", frame));
+
   if (aForceVerticalResizeForMeasuringReflow) {
     childRIForMeasuringHeight.SetVResize(true);
   }
@@ -1663,8 +1730,14 @@ nsFlexContainerFrame::
   // the effective computed value of the "height" property.
   nscoord childDesiredHeight = childDesiredSize.Height() -
     childRIForMeasuringHeight.ComputedPhysicalBorderPadding().TopBottom();
+  childDesiredHeight = std::max(0, childDesiredHeight);
+
+  frame->Properties().Set(CachedFlexMeasuringReflow(),
+                          new CachedMeasuringReflowResult(
+                            childRIForMeasuringHeight, childDesiredHeight,
+                            childDesiredSize.BlockStartAscent()));
 
-  return std::max(0, childDesiredHeight);
+  return childDesiredHeight;
 }
 
 FlexItem::FlexItem(ReflowInput& aFlexItemReflowInput,
@@ -4358,6 +4431,13 @@ nsFlexContainerFrame::ReflowFlexItem(nsPresContext* aPresContext,
   // after this point, because some of its methods (e.g. SetComputedWidth)
   // internally call InitResizeFlags and stomp on mVResize & mHResize.
 
+  // If the item changed and we didn't measure it in this reflow, the result
+  // of its last measuring reflow is stale, and this reflow will clear the
+  // dirty bits that would have told us so.
+  if (!aItem.HadMeasuringReflow() && NS_SUBTREE_DIRTY(aItem.Frame())) {
+    aItem.Frame()->Properties().Delete(CachedFlexMeasuringReflow());
+  }
+
   ReflowOutput childDesiredSize(childReflowInput);
   nsReflowStatus childReflowStatus;
   ReflowChild(aItem.Frame(), aPresContext,
@@ -46,6 +46,7 @@ nsFloatManager::nsFloatManager(nsIPresShell* aPresShell,
     mWritingMode(aWM),
 #endif
     mLineLeft(0), mBlockStart(0),
+    mIndexedFloatCount(0),
     mFloatDamage(PSArenaAllocCB, PSArenaFreeCB, aPresShell),
     mPushedLeftFloatPastBreak(false),
     mPushedRightFloatPastBreak(false),
@@ -116,6 +117,10 @@ void nsFloatManager::Shutdown()
   sCachedFloatManagerCount = -1;
 }
 
+// The number of floats from which GetFlowArea uses mFloatIndex rather than
+// walking mFloats.
+static const uint32_t kMinFloatsForIndex = 32;
+
 #define CHECK_BLOCK_DIR(aWM) \
   NS_ASSERTION((aWM).GetBlockDir() == mWritingMode.GetBlockDir(), \
   "incompatible writing modes")
@@ -177,22 +182,10 @@ nsFloatManager::GetFlowArea(WritingMode aWM, nscoord aBOffset,
     lineRight = lineLeft;
   }
 
-  // Walk backwards through the floats until we either hit the front of
-  // the list or we're above |blockStart|.
   bool haveFloats = false;
-  for (uint32_t i = floatCount; i > 0; --i) {
-    const FloatInfo &fi = mFloats[i-1];
-    if (fi.mLeftBEnd <= blockStart && fi.mRightBEnd <= blockStart) {
-      // There aren't any more floats that could intersect this band.
-      break;
-    }
-    if (fi.IsEmpty()) {
-      // For compatibility, ignore floats with empty rects, even though it
-      // disagrees with the spec.  (We might want to fix this in the
-      // future, though.)
-      continue;
-    }
-
+  // Narrows the band for a float that may intersect it.  The order in which
+  // floats are passed to this doesn't matter.
+  auto considerFloat = [&](const FloatInfo& fi) {
     nscoord floatBStart = fi.BStart();
     nscoord floatBEnd = fi.BEnd();
     if (blockStart < floatBStart && aInfoType == BAND_FROM_POINT) {
@@ -239,6 +232,57 @@ nsFloatManager::GetFlowArea(WritingMode aWM, nscoord aBOffset,
         }
       }
     }
+  };
+
+  if (floatCount < kMinFloatsForIndex) {
+    // Walk backwards through the floats until we either hit the front of
+    // the list or we're above |blockStart|.
+    for (uint32_t i = floatCount; i > 0; --i) {
+      const FloatInfo &fi = mFloats[i-1];
+      if (fi.mLeftBEnd <= blockStart && fi.mRightBEnd <= blockStart) {
+        // There aren't any more floats that could intersect this band.
+        break;
+      }
+      if (fi.IsEmpty()) {
+        // For compatibility, ignore floats with empty rects, even though it
+        // disagrees with the spec.  (We might want to fix this in the
+        // future, though.)
+        continue;
+      }
+      considerFloat(fi);
+    }
+  } else {
+    // Walk down the float index, skipping the groups of floats that are
+    // entirely above the band or below it (whose block-end only moves up as
+    // we go).
+    // Empty floats are not in the index at all, see above.
+    UpdateFloatIndex();
+    uint32_t leafCount = mFloatIndex.Length() / 2;
+    struct Node {
+      uint32_t mIndex;
+      // The index in mFloats of the first float under this node.
+      uint32_t mFirstFloat;
+      uint32_t mFloatCount;
+    };
+    AutoTArray<Node, 64> stack;
+    stack.AppendElement(Node { 1, 0, leafCount });
+    while (!stack.IsEmpty()) {
+      Node node = stack.LastElement();
+      stack.RemoveElementAt(stack.Length() - 1);
+      const BandExtent& extent = mFloatIndex[node.mIndex];
+      if (node.mFirstFloat >= floatCount ||
+          extent.mBEnd <= blockStart || extent.mBStart > blockEnd) {
+        continue;
+      }
+      if (node.mFloatCount == 1) {
+        considerFloat(mFloats[node.mFirstFloat]);
+        continue;
+      }
+      uint32_t half = node.mFloatCount / 2;
+      stack.AppendElement(Node { 2 * node.mIndex + 1,
+                                 node.mFirstFloat + half, half });
+      stack.AppendElement(Node { 2 * node.mIndex, node.mFirstFloat, half });
+    }
   }
 
   nscoord blockSize = (blockEnd == nscoord_MAX) ?
@@ -291,6 +335,80 @@ nsFloatManager::AddFloat(nsIFrame* aFloatFrame, const LogicalRect& aMarginRect,
   return NS_OK;
 }
 
+void
+nsFloatManager::UpdateFloatIndex() const
+{
+  uint32_t floatCount = mFloats.Length();
+  if (mIndexedFloatCount == floatCount) {
+    return;
+  }
+
+  const BandExtent emptyExtent = { nscoord_MAX, nscoord_MIN };
+  uint32_t leafCount = mFloatIndex.Length() / 2;
+  if (floatCount > leafCount) {
+    // Start over with room for twice as many floats as we have now.
+    leafCount = RoundUpPow2(2 * floatCount);
+    mFloatIndex.Clear();
+    mFloatIndex.AppendElements(2 * leafCount);
+    for (BandExtent& extent : mFloatIndex) {
+      extent = emptyExtent;
+    }
+    mIndexedFloatCount = 0;
+  }
+
+  for (uint32_t i = mIndexedFloatCount; i < floatCount; ++i) {
+    const FloatInfo& fi = mFloats[i];
+    if (fi.IsEmpty()) {
+      // Leave it out, like GetFlowArea does.
+      continue;
+    }
+    nscoord bStart = fi.BStart();
+    nscoord bEnd = fi.BEnd();
+    for (uint32_t node = leafCount + i; node >= 1; node /= 2) {
+      BandExtent& extent = mFloatIndex[node];
+      extent.mBStart = std::min(extent.mBStart, bStart);
+      extent.mBEnd = std::max(extent.mBEnd, bEnd);
+    }
+  }
+  mIndexedFloatCount = floatCount;
+}
+
+void
+nsFloatManager::TruncateFloatIndex(uint32_t aLength)
+{
+  if (aLength >= mIndexedFloatCount) {
+    return;
+  }
+
+  if (aLength < kMinFloatsForIndex) {
+    // GetFlowArea won't use the index until we have many floats again, so
+    // there's no point in keeping it up to date.
+    mFloatIndex.Clear();
+    mIndexedFloatCount = 0;
+    return;
+  }
+
+  const BandExtent emptyExtent = { nscoord_MAX, nscoord_MIN };
+  uint32_t leafCount = mFloatIndex.Length() / 2;
+  for (uint32_t i = aLength; i < mIndexedFloatCount; ++i) {
+    mFloatIndex[leafCount + i] = emptyExtent;
+  }
+  // Recompute the ancestors of the leaves we cleared, level by level.
+  uint32_t first = (leafCount + aLength) / 2;
+  uint32_t last = (leafCount + mIndexedFloatCount - 1) / 2;
+  while (first >= 1) {
+    for (uint32_t node = first; node <= last; ++node) {
+      const BandExtent& start = mFloatIndex[2 * node];
+      const BandExtent& end = mFloatIndex[2 * node + 1];
+      mFloatIndex[node].mBStart = std::min(start.mBStart, end.mBStart);
+      mFloatIndex[node].mBEnd = std::max(start.mBEnd, end.mBEnd);
+    }
+    first /= 2;
+    last /= 2;
+  }
+  mIndexedFloatCount = aLength;
+}
+
 // static
 LogicalRect
 nsFloatManager::CalculateRegionFor(WritingMode          aWM,
@@ -384,6 +502,7 @@ nsFloatManager::RemoveTrailingRegions(nsIFrame* aFrameList)
     --newLength;
   }
   mFloats.TruncateLength(newLength);
+  TruncateFloatIndex(newLength);
 
 #ifdef DEBUG
   for (uint32_t i = 0; i < mFloats.Length(); ++i) {
@@ -441,6 +560,7 @@ nsFloatManager::PopState(SavedState* aState)
   NS_ASSERTION(aState->mFloatInfoCount <= mFloats.Length(),
                "somebody misused PushState/PopState");
   mFloats.TruncateLength(aState->mFloatInfoCount);
+  TruncateFloatIndex(aState->mFloatInfoCount);
 }
 
 nscoord
@@ -336,6 +336,24 @@ private:
     nsRect mRect;
   };
 
+  // The block-direction extent of a group of floats: the smallest block-start
+  // and the largest block-end of the non-empty floats in it.
+  struct BandExtent {
+    nscoord mBStart, mBEnd;
+  };
+
+  /**
+   * Bring mFloatIndex up to date with mFloats, building it if needed.  Only
+   * worth it (and only done) once there are many floats.
+   */
+  void UpdateFloatIndex() const;
+
+  /**
+   * Forget about the floats from aLength onwards in mFloatIndex.  Must be
+   * called whenever mFloats is truncated.
+   */
+  void TruncateFloatIndex(uint32_t aLength);
+
 #ifdef DEBUG
   mozilla::WritingMode mWritingMode;
 #endif
@@ -343,6 +361,15 @@ private:
   // Translation from local to global coordinate space.
   nscoord mLineLeft, mBlockStart;
   nsTArray<FloatInfo> mFloats;
+
+  // A segment tree over the block-direction extents of mFloats, used by
+  // GetFlowArea to find the floats that intersect a band without walking over
+  // all the floats that come after it.  Node 1 is the root, node i has
+  // children 2i and 2i+1, and the second half of the array holds the leaves,
+  // one per float.  Only the first mIndexedFloatCount floats are in it;
+  // GetFlowArea adds the others lazily, hence mutable.
+  mutable nsTArray<BandExtent> mFloatIndex;
+  mutable uint32_t mIndexedFloatCount;
   nsIntervalSet   mFloatDamage;
 
   // Did we try to place a float that could not fit at all and had to be
@@ -3663,13 +3663,64 @@ nsGridContainerFrame::Tracks::Initialize(
 }
 
 /**
- * Reflow aChild in the given aAvailableSize.
+ * The block-size that a grid item got in its last measuring reflow, along
+ * with the parts of its ReflowInput that the result depends on.  Measuring
+ * the block-axis contributions of the items requires a reflow of each of
+ * them, so we keep the result around and reuse it in later reflows of the
+ * grid as long as the item hasn't changed.
+ */
+class CachedBAxisMeasurement
+{
+public:
+  CachedBAxisMeasurement(const ReflowInput& aReflowInput, bool aIsIntrinsic,
+                         nscoord aBSize)
+    : mAvailableSize(aReflowInput.AvailableSize())
+    , mComputedSize(aReflowInput.ComputedSize())
+    , mComputedMinBSize(aReflowInput.ComputedMinBSize())
+    , mComputedMaxBSize(aReflowInput.ComputedMaxBSize())
+    , mBorderPadding(aReflowInput.ComputedPhysicalBorderPadding())
+    , mIsIntrinsic(aIsIntrinsic)
+    , mBSize(aBSize)
+  {}
+
+  bool IsValidFor(const ReflowInput& aReflowInput, bool aIsIntrinsic) const {
+    return mIsIntrinsic == aIsIntrinsic &&
+           mAvailableSize == aReflowInput.AvailableSize() &&
+           mComputedSize == aReflowInput.ComputedSize() &&
+           mComputedMinBSize == aReflowInput.ComputedMinBSize() &&
+           mComputedMaxBSize == aReflowInput.ComputedMaxBSize() &&
+           mBorderPadding == aReflowInput.ComputedPhysicalBorderPadding();
+  }
+
+  nscoord BSize() const { return mBSize; }
+
+private:
+  const LogicalSize mAvailableSize;
+  const LogicalSize mComputedSize;
+  const nscoord mComputedMinBSize;
+  const nscoord mComputedMaxBSize;
+  const nsMargin mBorderPadding;
+  // Whether this was measured for the grid's intrinsic size rather than
+  // during its reflow.
+  const bool mIsIntrinsic;
+
+  const nscoord mBSize;
+};
+
+NS_DECLARE_FRAME_PROPERTY_DELETABLE(CachedBAxisMeasurementProperty,
+                                    CachedBAxisMeasurement)
+
+/**
+ * Reflow aChild in the given aAvailableSize.  If aMayUseCachedBSize is true,
+ * the caller only needs the resulting block-size, which may then come from
+ * an earlier measurement without reflowing aChild.
  */
 static nscoord
 MeasuringReflow(nsIFrame*                aChild,
                 const ReflowInput* aReflowInput,
                 nsRenderingContext*      aRC,
-                const LogicalSize&       aAvailableSize)
+                const LogicalSize&       aAvailableSize,
+                bool                     aMayUseCachedBSize = false)
 {
   nsContainerFrame* parent = aChild->GetParent();
   nsPresContext* pc = aChild->PresContext();
@@ -3691,6 +3742,20 @@ MeasuringReflow(nsIFrame*                aChild,
   ReflowInput childRI(pc, *rs, aChild, aAvailableSize, nullptr,
                             ReflowInput::COMPUTE_SIZE_SHRINK_WRAP |
                             ReflowInput::COMPUTE_SIZE_USE_AUTO_BSIZE);
+
+  // Reuse the result of the last measurement if nothing it depends on
+  // changed since.
+  const bool isIntrinsic = !aReflowInput;
+  const CachedBAxisMeasurement* cached =
+    aChild->Properties().Get(CachedBAxisMeasurementProperty());
+  if (aMayUseCachedBSize && cached && !NS_SUBTREE_DIRTY(aChild) &&
+      !rs->ShouldReflowAllKids() && cached->IsValidFor(childRI, isIntrinsic)) {
+#ifdef DEBUG
+    parent->Properties().Delete(nsContainerFrame::DebugReflowingWithInfiniteISize());
+#endif
+    return cached->BSize();
+  }
+
   ReflowOutput childSize(childRI);
   nsReflowStatus childStatus;
   const uint32_t flags = NS_FRAME_NO_MOVE_FRAME | NS_FRAME_NO_SIZE_VIEW;
@@ -3702,6 +3767,9 @@ MeasuringReflow(nsIFrame*                aChild,
 #ifdef DEBUG
     parent->Properties().Delete(nsContainerFrame::DebugReflowingWithInfiniteISize());
 #endif
+  aChild->Properties().Set(CachedBAxisMeasurementProperty(),
+                           new CachedBAxisMeasurement(childRI, isIntrinsic,
+                                                      childSize.BSize(wm)));
   return childSize.BSize(wm);
 }
 
@@ -3738,7 +3806,8 @@ ContentContribution(const GridItemInfo&               aGridItem,
       }
     }
     LogicalSize availableSize(childWM, cbISize, cbBSize);
-    size = ::MeasuringReflow(child, aState.mReflowInput, aRC, availableSize);
+    size = ::MeasuringReflow(child, aState.mReflowInput, aRC, availableSize,
+                             true);
     nsIFrame::IntrinsicISizeOffsetData offsets = child->IntrinsicBSizeOffsets();
     size += offsets.hMargin;
     auto percent = offsets.hPctMargin;
@@ -5057,6 +5126,13 @@ nsGridContainerFrame::ReflowInFlowChild(nsIFrame*              aChild,
     }
   }
 
+  // A measuring reflow clears the child's dirty bits, so if they're still set
+  // the child changed since it was last measured, and this reflow is about
+  // to clear them.
+  if (NS_SUBTREE_DIRTY(aChild)) {
+    aChild->Properties().Delete(CachedBAxisMeasurementProperty());
+  }
+
   // We need the width of the child before we can correctly convert
   // the writing-mode of its origin, so we reflow at (0, 0) using a dummy
   // aContainerSize, and then pass the correct position to FinishReflowChild.
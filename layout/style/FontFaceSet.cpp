@@ -1778,6 +1778,18 @@ FontFaceSet::UserFontSet::RecordFontLoadDone(uint32_t aFontSize,
   }
 }
 
+void
+FontFaceSet::UserFontSet::UserFontEntryLoadedAsync(
+                                            gfxUserFontEntry* aUserFontEntry)
+{
+  nsPresContext* ctx = FontFaceSet::GetPresContextFor(this);
+  if (ctx) {
+    // Update layout for the presence of the new font.  Since this is
+    // asynchronous, reflows will coalesce.
+    ctx->UserFontSetUpdated(aUserFontEntry);
+  }
+}
+
 /* virtual */ nsresult
 FontFaceSet::UserFontSet::LogMessage(gfxUserFontEntry* aUserFontEntry,
                                      const char* aMessage,
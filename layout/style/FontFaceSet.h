@@ -74,6 +74,8 @@ public:
     void RecordFontLoadDone(uint32_t aFontSize,
                             mozilla::TimeStamp aDoneTime) override;
 
+    void UserFontEntryLoadedAsync(gfxUserFontEntry* aUserFontEntry) override;
+
   protected:
     virtual bool GetPrivateBrowsing() override;
     virtual nsresult SyncLoadFontData(gfxUserFontEntry* aFontToLoad,
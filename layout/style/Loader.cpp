@@ -56,6 +56,7 @@
 #include "mozilla/StyleSheet.h"
 #include "mozilla/StyleSheetInlines.h"
 #include "mozilla/ConsoleReportCollector.h"
+#include "mozilla/TimeStamp.h"
 
 #ifdef MOZ_XUL
 #include "nsXULPrototypeCache.h"
@@ -231,6 +232,15 @@ public:
   // async observer notification for an already-complete sheet.
   bool                       mSheetAlreadyComplete : 1;
 
+  // mParseSuspended is true while the parse of a large sheet is waiting for
+  // its next slice to run.  See Loader::ParseSheetSlice.
+  bool                       mParseSuspended : 1;
+
+  // The sheet text still being parsed by ParseSheetSlice, and how much of it
+  // has been parsed.
+  nsString                   mParseInput;
+  uint32_t                   mParseOffset;
+
   // This is the element that imported the sheet.  Needed to get the
   // charset set on it and to fire load/error events.
   nsCOMPtr<nsIStyleSheetLinkingElement> mOwningElement;
@@ -282,6 +292,13 @@ static mozilla::LazyLogModule gSriPRLog("SRI");
     }                                               \
   PR_END_MACRO
 
+// Sheets at least this long (in characters) that are loaded asynchronously
+// are parsed a slice at a time, so they don't block the main thread.
+static const uint32_t kIncrementalParseMinLength = 64 * 1024;
+
+// How long each slice of an incremental parse should take.
+static const double kParseSliceMilliseconds = 5.0;
+
 // And some convenience strings...
 static const char* const gStateStrings[] = {
   "eSheetStateUnknown",
@@ -321,6 +338,8 @@ SheetLoadData::SheetLoadData(Loader* aLoader,
     mWasAlternate(aIsAlternate),
     mUseSystemPrincipal(false),
     mSheetAlreadyComplete(false),
+    mParseSuspended(false),
+    mParseOffset(0),
     mOwningElement(aOwningElement),
     mObserver(aObserver),
     mLoaderPrincipal(aLoaderPrincipal),
@@ -351,6 +370,8 @@ SheetLoadData::SheetLoadData(Loader* aLoader,
     mWasAlternate(false),
     mUseSystemPrincipal(false),
     mSheetAlreadyComplete(false),
+    mParseSuspended(false),
+    mParseOffset(0),
     mOwningElement(nullptr),
     mObserver(aObserver),
     mLoaderPrincipal(aLoaderPrincipal),
@@ -391,6 +412,8 @@ SheetLoadData::SheetLoadData(Loader* aLoader,
     mWasAlternate(false),
     mUseSystemPrincipal(aUseSystemPrincipal),
     mSheetAlreadyComplete(false),
+    mParseSuspended(false),
+    mParseOffset(0),
     mOwningElement(nullptr),
     mObserver(aObserver),
     mLoaderPrincipal(aLoaderPrincipal),
@@ -1761,6 +1784,13 @@ Loader::ParseSheet(const nsAString& aInput,
 
   aCompleted = false;
 
+  if (aLoadData->mSheet->IsGecko() && !aLoadData->mSyncLoad &&
+      aInput.Length() >= kIncrementalParseMinLength) {
+    aLoadData->mParseInput = aInput;
+    aLoadData->mParseOffset = 0;
+    return ParseSheetSlice(aLoadData, aCompleted);
+  }
+
   // Push our load data on the stack so any kids can pick it up
   mParsingDatas.AppendElement(aLoadData);
   nsIURI* sheetURI = aLoadData->mSheet->GetSheetURI();
@@ -1782,10 +1812,92 @@ Loader::ParseSheet(const nsAString& aInput,
 
   mParsingDatas.RemoveElementAt(mParsingDatas.Length() - 1);
 
-  if (NS_FAILED(rv)) {
+  return FinishParsingSheet(aLoadData, rv, aCompleted);
+}
+
+/**
+ * ParseSheetSlice parses the next part of aLoadData->mParseInput, stopping
+ * after kParseSliceMilliseconds.  If there is more to parse, the rest is
+ * parsed by a later event, so that big sheets don't block the main thread
+ * for their whole parse.  The sheet is not complete, and thus not applied or
+ * exposed through the CSSOM, until the last slice is done.
+ */
+nsresult
+Loader::ParseSheetSlice(SheetLoadData* aLoadData, bool& aCompleted)
+{
+  LOG(("css::Loader::ParseSheetSlice"));
+  MOZ_ASSERT(aLoadData->mSheet->IsGecko());
+
+  aCompleted = false;
+
+  const nsDependentSubstring input =
+    Substring(aLoadData->mParseInput, aLoadData->mParseOffset);
+  uint32_t parsedLength = 0;
+  uint32_t nextLineNumber = aLoadData->mLineNumber;
+  TimeStamp deadline = TimeStamp::Now() +
+    TimeDuration::FromMilliseconds(kParseSliceMilliseconds);
+
+  // Push our load data on the stack so any kids can pick it up
+  mParsingDatas.AppendElement(aLoadData);
+  nsCSSParser parser(this, aLoadData->mSheet->AsGecko());
+  nsresult rv = parser.ParseSheetUntil(input,
+                                       aLoadData->mSheet->GetSheetURI(),
+                                       aLoadData->mSheet->GetBaseURI(),
+                                       aLoadData->mSheet->Principal(),
+                                       aLoadData->mLineNumber, deadline,
+                                       parsedLength, nextLineNumber);
+  mParsingDatas.RemoveElementAt(mParsingDatas.Length() - 1);
+
+  if (NS_SUCCEEDED(rv) && parsedLength < input.Length()) {
+    aLoadData->mParseOffset += parsedLength;
+    aLoadData->mLineNumber = nextLineNumber;
+    nsCOMPtr<nsIRunnable> event =
+      NewRunnableMethod<RefPtr<SheetLoadData>>(this,
+                                               &Loader::ContinueParsingSheet,
+                                               aLoadData);
+    rv = NS_DispatchToCurrentThread(event);
+    if (NS_SUCCEEDED(rv)) {
+      LOG(("  Parse suspended at offset %u", aLoadData->mParseOffset));
+      aLoadData->mParseSuspended = true;
+      return NS_OK;
+    }
+  }
+
+  aLoadData->mParseInput.Truncate();
+  aLoadData->mParseOffset = 0;
+  return FinishParsingSheet(aLoadData, rv, aCompleted);
+}
+
+void
+Loader::ContinueParsingSheet(SheetLoadData* aLoadData)
+{
+  aLoadData->mParseSuspended = false;
+
+  if (aLoadData->mIsCancelled) {
+    // Stop() already called SheetComplete on it.
+    aLoadData->mParseInput.Truncate();
+    return;
+  }
+
+  if (!mDocument && !aLoadData->mIsNonDocumentSheet) {
+    LOG_WARN(("  No document and not non-document sheet; dropping parse"));
+    aLoadData->mParseInput.Truncate();
+    SheetComplete(aLoadData, NS_BINDING_ABORTED);
+    return;
+  }
+
+  bool completed;
+  ParseSheetSlice(aLoadData, completed);
+}
+
+nsresult
+Loader::FinishParsingSheet(SheetLoadData* aLoadData, nsresult aStatus,
+                           bool& aCompleted)
+{
+  if (NS_FAILED(aStatus)) {
     LOG_ERROR(("  Low-level error in parser!"));
-    SheetComplete(aLoadData, rv);
-    return rv;
+    SheetComplete(aLoadData, aStatus);
+    return aStatus;
   }
 
   NS_ASSERTION(aLoadData->mPendingChildren == 0 || !aLoadData->mSyncLoad,
@@ -1917,7 +2029,8 @@ Loader::DoSheetComplete(SheetLoadData* aLoadData, nsresult aStatus,
     // or some such).
     if (data->mParentData &&
         --(data->mParentData->mPendingChildren) == 0 &&
-        !mParsingDatas.Contains(data->mParentData)) {
+        !mParsingDatas.Contains(data->mParentData) &&
+        !data->mParentData->mParseSuspended) {
       DoSheetComplete(data->mParentData, aStatus, aDatasToNotify);
     }
 
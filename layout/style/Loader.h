@@ -525,12 +525,25 @@ private:
 
   // Parse the stylesheet in aLoadData.  The sheet data comes from aInput.
   // Set aCompleted to true if the parse finished, false otherwise (e.g. if the
-  // sheet had an @import).  If aCompleted is true when this returns, then
+  // sheet had an @import, or is big enough to be parsed a slice at a time).
+  // If aCompleted is true when this returns, then
   // ParseSheet also called SheetComplete on aLoadData.
   nsresult ParseSheet(const nsAString& aInput,
                       SheetLoadData* aLoadData,
                       bool& aCompleted);
 
+  // Parse the next slice of a sheet that is parsed incrementally.  Same
+  // contract as ParseSheet.
+  nsresult ParseSheetSlice(SheetLoadData* aLoadData, bool& aCompleted);
+
+  // Handle the event posted by ParseSheetSlice to parse the next slice.
+  void ContinueParsingSheet(SheetLoadData* aLoadData);
+
+  // Common tail of ParseSheet and ParseSheetSlice, once the whole sheet has
+  // been parsed or parsing failed with aStatus.
+  nsresult FinishParsingSheet(SheetLoadData* aLoadData, nsresult aStatus,
+                              bool& aCompleted);
+
   // The load of the sheet in aLoadData is done, one way or another.  Do final
   // cleanup, including releasing aLoadData.
   void SheetComplete(SheetLoadData* aLoadData, nsresult aStatus);
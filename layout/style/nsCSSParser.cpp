@@ -11,6 +11,7 @@
 #include "mozilla/Move.h"
 #include "mozilla/MathAlgorithms.h"
 #include "mozilla/TypedEnumBits.h"
+#include "mozilla/TimeStamp.h"
 
 #include <algorithm> // for std::stable_sort
 #include <limits> // for std::numeric_limits
@@ -158,7 +159,10 @@ public:
                       nsIURI*          aBaseURI,
                       nsIPrincipal*    aSheetPrincipal,
                       uint32_t         aLineNumber,
-                      css::LoaderReusableStyleSheets* aReusableSheets);
+                      css::LoaderReusableStyleSheets* aReusableSheets,
+                      const TimeStamp& aDeadline = TimeStamp(),
+                      uint32_t*        aParsedLength = nullptr,
+                      uint32_t*        aNextLineNumber = nullptr);
 
   already_AddRefed<css::Declaration>
            ParseStyleAttribute(const nsAString&  aAttributeValue,
@@ -1670,7 +1674,10 @@ CSSParserImpl::ParseSheet(const nsAString& aInput,
                           nsIURI*          aBaseURI,
                           nsIPrincipal*    aSheetPrincipal,
                           uint32_t         aLineNumber,
-                          css::LoaderReusableStyleSheets* aReusableSheets)
+                          css::LoaderReusableStyleSheets* aReusableSheets,
+                          const TimeStamp& aDeadline,
+                          uint32_t*        aParsedLength,
+                          uint32_t*        aNextLineNumber)
 {
   NS_PRECONDITION(aSheetPrincipal, "Must have principal here!");
   NS_PRECONDITION(aBaseURI, "need base URI");
@@ -1719,8 +1726,23 @@ CSSParserImpl::ParseSheet(const nsAString& aInput,
   mIsChrome = dom::IsChromeURI(aSheetURI);
   mReusableSheets = aReusableSheets;
 
+  uint32_t parsedLength = aInput.Length();
+  uint32_t nextLineNumber = aLineNumber;
+  uint32_t rulesSinceDeadlineCheck = 0;
+
   nsCSSToken* tk = &mToken;
   for (;;) {
+    // Checking the time is not free, so only do it every few rules, and only
+    // between top-level rules.
+    if (!aDeadline.IsNull() && !mHavePushBack &&
+        ++rulesSinceDeadlineCheck == 16) {
+      rulesSinceDeadlineCheck = 0;
+      if (TimeStamp::Now() >= aDeadline) {
+        parsedLength = mScanner->GetTokenEndOffset();
+        nextLineNumber = mScanner->GetEndLineNumber();
+        break;
+      }
+    }
     // Get next non-whitespace token
     if (!GetToken(true)) {
       OUTPUT_ERROR();
@@ -1740,6 +1762,13 @@ CSSParserImpl::ParseSheet(const nsAString& aInput,
   }
   ReleaseScanner();
 
+  if (aParsedLength) {
+    *aParsedLength = parsedLength;
+  }
+  if (aNextLineNumber) {
+    *aNextLineNumber = nextLineNumber;
+  }
+
   mParsingMode = css::eAuthorSheetFeatures;
   mIsChrome = false;
   mReusableSheets = nullptr;
@@ -17808,6 +17837,21 @@ nsCSSParser::ParseSheet(const nsAString& aInput,
                aReusableSheets);
 }
 
+nsresult
+nsCSSParser::ParseSheetUntil(const nsAString& aInput,
+                             nsIURI*          aSheetURI,
+                             nsIURI*          aBaseURI,
+                             nsIPrincipal*    aSheetPrincipal,
+                             uint32_t         aLineNumber,
+                             const TimeStamp& aDeadline,
+                             uint32_t&        aParsedLength,
+                             uint32_t&        aNextLineNumber)
+{
+  return static_cast<CSSParserImpl*>(mImpl)->
+    ParseSheet(aInput, aSheetURI, aBaseURI, aSheetPrincipal, aLineNumber,
+               nullptr, aDeadline, &aParsedLength, &aNextLineNumber);
+}
+
 already_AddRefed<css::Declaration>
 nsCSSParser::ParseStyleAttribute(const nsAString&  aAttributeValue,
                                  nsIURI*           aDocURI,
@@ -30,6 +30,7 @@ struct nsRuleData;
 namespace mozilla {
 class CSSStyleSheet;
 class CSSVariableValues;
+class TimeStamp;
 namespace css {
 class Rule;
 class Declaration;
@@ -78,6 +79,24 @@ public:
                       mozilla::css::LoaderReusableStyleSheets* aReusableSheets =
                         nullptr);
 
+  /**
+   * Like ParseSheet, but stops at the end of the first top-level rule that
+   * finishes after aDeadline.  aParsedLength is set to the length of the
+   * part of aInput that was parsed (all of it if the deadline wasn't hit),
+   * and aNextLineNumber to the line number the rest of aInput starts at.
+   *
+   * The rest can be parsed with another call to ParseSheet or
+   * ParseSheetUntil, which pick up after the last rule already in the sheet.
+   */
+  nsresult ParseSheetUntil(const nsAString& aInput,
+                           nsIURI*          aSheetURL,
+                           nsIURI*          aBaseURI,
+                           nsIPrincipal*    aSheetPrincipal,
+                           uint32_t         aLineNumber,
+                           const mozilla::TimeStamp& aDeadline,
+                           uint32_t&        aParsedLength,
+                           uint32_t&        aNextLineNumber);
+
   // Parse HTML style attribute or its equivalent in other markup
   // languages.  aBaseURL is the base url to use for relative links in
   // the declaration.
@@ -97,7 +97,8 @@ struct RuleSelectorPair {
  */
 struct RuleValue : RuleSelectorPair {
   enum {
-    eMaxAncestorHashes = 4
+    eMaxAncestorHashes = 4,
+    eMaxSubjectClasses = 2
   };
 
   RuleValue(const RuleSelectorPair& aRuleSelectorPair, int32_t aIndex,
@@ -106,12 +107,81 @@ struct RuleValue : RuleSelectorPair {
     mIndex(aIndex)
   {
     CollectAncestorHashes(aQuirksMode);
+    CollectSubject();
+  }
+
+  /**
+   * Returns false if aElement can't match the compound selector that applies
+   * to the element itself, judging from the mSubject* fields alone.  These
+   * are tested by SelectorMatches too, and before anything that has side
+   * effects, so rejecting here doesn't change any outcome; it just avoids
+   * walking the nsCSSSelector structures for most candidates that don't
+   * match.
+   */
+  bool SubjectMightMatch(Element* aElement,
+                         const TreeMatchContext& aTreeMatchContext) const {
+    if (mSubjectNameSpace != kNameSpaceID_Unknown &&
+        aElement->GetNameSpaceID() != mSubjectNameSpace) {
+      return false;
+    }
+    if (mSubjectTag && mSubjectTag != aElement->NodeInfo()->NameAtom()) {
+      return false;
+    }
+    if (mSubjectClasses[0]) {
+      const nsAttrValue* elementClasses = aElement->GetClasses();
+      if (!elementClasses) {
+        return false;
+      }
+      nsCaseTreatment caseTreatment =
+        aTreeMatchContext.mCompatMode != eCompatibility_NavQuirks ?
+          eCaseMatters : eIgnoreCase;
+      for (size_t i = 0; i < eMaxSubjectClasses && mSubjectClasses[i]; ++i) {
+        if (!elementClasses->Contains(mSubjectClasses[i], caseTreatment)) {
+          return false;
+        }
+      }
+    }
+    return true;
   }
 
   int32_t mIndex; // High index means high weight/order.
   uint32_t mAncestorSelectorHashes[eMaxAncestorHashes];
 
+  // A flat copy of the namespace, type selector and first classes of the
+  // compound selector that applies to the element itself.  mSubjectTag is
+  // only set when the type selector is the same in HTML and other
+  // documents, i.e. all-lowercase.
+  int32_t mSubjectNameSpace;
+  nsIAtom* mSubjectTag;
+  nsIAtom* mSubjectClasses[eMaxSubjectClasses];
+
 private:
+  void CollectSubject() {
+    mSubjectNameSpace = kNameSpaceID_Unknown;
+    mSubjectTag = nullptr;
+    for (size_t i = 0; i < eMaxSubjectClasses; ++i) {
+      mSubjectClasses[i] = nullptr;
+    }
+
+    nsCSSSelector* sel = mSelector;
+    if (sel->IsPseudoElement()) {
+      // ContentEnumFunc tests the pseudo-element against the pseudo-element,
+      // and the rest against the element.
+      return;
+    }
+
+    mSubjectNameSpace = sel->mNameSpace;
+    if (sel->mLowercaseTag && sel->mCasedTag == sel->mLowercaseTag) {
+      mSubjectTag = sel->mLowercaseTag;
+    }
+    size_t classIndex = 0;
+    for (nsAtomList* classes = sel->mClassList;
+         classes && classIndex < eMaxSubjectClasses;
+         classes = classes->mNext) {
+      mSubjectClasses[classIndex++] = classes->mAtom;
+    }
+  }
+
   void CollectAncestorHashes(bool aQuirksMode) {
     // Collect up our mAncestorSelectorHashes.  It's not clear whether it's
     // better to stop once we've found eMaxAncestorHashes of them or to keep
@@ -2485,6 +2555,10 @@ void ContentEnumFunc(const RuleValue& value, nsCSSSelector* aSelector,
   if (nodeContext.mIsRelevantLink) {
     data->mTreeMatchContext.SetHaveRelevantLink();
   }
+  if (aSelector == value.mSelector &&
+      !value.SubjectMightMatch(data->mElement, data->mTreeMatchContext)) {
+    return;
+  }
   if (ancestorFilter &&
       !ancestorFilter->MightHaveMatchingAncestor<RuleValue::eMaxAncestorHashes>(
           value.mAncestorSelectorHashes)) {
@@ -248,6 +248,10 @@ class nsCSSScanner {
   uint32_t GetTokenEndOffset() const
   { return mOffset; }
 
+  // Get the 1-based line number of the character at GetTokenEndOffset().
+  uint32_t GetEndLineNumber() const
+  { return mLineNumber; }
+
   // Get the text of the line containing the first character of
   // the most recently processed token.
   nsDependentSubstring GetCurrentLine() const;
@@ -3929,10 +3929,13 @@ nsRuleNode::SetFont(nsPresContext* aPresContext, nsStyleContext* aContext,
     break;
 
   case eCSSUnit_PairList:
-  case eCSSUnit_PairListDep:
+  case eCSSUnit_PairListDep: {
+    nsTArray<gfxFontFeature> featureSettings;
     ComputeFontFeatures(featureSettingsValue->GetPairListValue(),
-                        aFont->mFont.fontFeatureSettings);
+                        featureSettings);
+    aFont->mFont.fontFeatureSettings.Assign(Move(featureSettings));
     break;
+  }
 
   default:
     MOZ_ASSERT(false, "unexpected value unit");
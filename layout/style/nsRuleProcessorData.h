@@ -17,6 +17,7 @@
 #include "nsCSSPseudoElements.h"
 #include "nsRuleWalker.h"
 #include "nsNthIndexCache.h"
+#include "nsStyleSharingCache.h"
 #include "nsILoadContext.h"
 #include "nsIDocument.h"
 #include "mozilla/AutoRestore.h"
@@ -358,6 +359,9 @@ struct MOZ_STACK_CLASS TreeMatchContext {
   // The nth-index cache we should use
   nsNthIndexCache mNthIndexCache;
 
+  // Rule nodes recently matched for elements, that their siblings may share
+  nsStyleSharingCache mStyleSharingCache;
+
   // An ancestor filter
   AncestorFilter mAncestorFilter;
 
@@ -1358,6 +1358,29 @@ nsStyleSet::ResolveStyleFor(Element* aElement,
   NS_ENSURE_FALSE(mInShutdown, nullptr);
   NS_ASSERTION(aElement, "aElement must not be null");
 
+  uint32_t flags = eDoAnimation;
+  if (nsCSSRuleProcessor::IsLink(aElement)) {
+    flags |= eIsLink;
+  }
+  if (nsCSSRuleProcessor::GetContentState(aElement, aTreeMatchContext).
+                            HasState(NS_EVENT_STATE_VISITED)) {
+    flags |= eIsVisitedLink;
+  }
+  if (aTreeMatchContext.mSkippingParentDisplayBasedStyleFixup) {
+    flags |= eSkipParentDisplayBasedStyleFixup;
+  }
+
+  // A sibling that matches the same rules may have been resolved already, in
+  // which case GetContext will find the style context it got.
+  const nsStyleSharingCache::Entry* shared =
+    aTreeMatchContext.mStyleSharingCache.Lookup(aElement, aParentContext,
+                                                flags);
+  if (shared) {
+    return GetContext(aParentContext, shared->mRuleNode, nullptr,
+                      nullptr, CSSPseudoElementType::NotPseudo,
+                      aElement, flags);
+  }
+
   nsRuleWalker ruleWalker(mRuleTree, mAuthorStyleDisabled);
   aTreeMatchContext.ResetForUnvisitedMatching();
   ElementRuleProcessorData data(PresContext(), aElement, &ruleWalker,
@@ -1375,18 +1398,9 @@ nsStyleSet::ResolveStyleFor(Element* aElement,
     FileRules(EnumRulesMatching<ElementRuleProcessorData>, &data, aElement,
               &ruleWalker);
     visitedRuleNode = ruleWalker.CurrentNode();
-  }
-
-  uint32_t flags = eDoAnimation;
-  if (nsCSSRuleProcessor::IsLink(aElement)) {
-    flags |= eIsLink;
-  }
-  if (nsCSSRuleProcessor::GetContentState(aElement, aTreeMatchContext).
-                            HasState(NS_EVENT_STATE_VISITED)) {
-    flags |= eIsVisitedLink;
-  }
-  if (aTreeMatchContext.mSkippingParentDisplayBasedStyleFixup) {
-    flags |= eSkipParentDisplayBasedStyleFixup;
+  } else {
+    aTreeMatchContext.mStyleSharingCache.Insert(aElement, aParentContext,
+                                                ruleNode, flags);
   }
 
   return GetContext(aParentContext, ruleNode, visitedRuleNode,
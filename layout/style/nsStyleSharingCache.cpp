@@ -0,0 +1,142 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/*
+ * A cache of recently matched rule nodes, used to skip selector matching for
+ * siblings that match the same rules.
+ */
+
+#include "nsStyleSharingCache.h"
+#include "mozilla/EffectSet.h"
+#include "mozilla/dom/Element.h"
+#include "nsCSSRuleProcessor.h"
+#include "nsRuleNode.h"
+#include "nsStyleContext.h"
+
+using namespace mozilla;
+using namespace mozilla::dom;
+
+// Long runs of similar siblings are the case we care about, so there is no
+// point in remembering many different kinds of siblings.
+static const uint32_t kMaxEntries = 8;
+
+nsStyleSharingCache::nsStyleSharingCache()
+{
+}
+
+nsStyleSharingCache::~nsStyleSharingCache()
+{
+}
+
+void
+nsStyleSharingCache::Reset()
+{
+  mEntries.Clear();
+}
+
+/* static */ bool
+nsStyleSharingCache::CanShare(Element* aElement)
+{
+  nsIContent* parent = aElement->GetParent();
+  if (!parent || !parent->IsElement()) {
+    // Don't bother with the root element and with shadow root children.
+    return false;
+  }
+
+  // Selectors that depend on the position of aElement among its siblings set
+  // these flags on the parent while matching.
+  if (parent->HasFlag(NODE_HAS_SLOW_SELECTOR |
+                      NODE_HAS_EDGE_CHILD_SELECTOR |
+                      NODE_HAS_SLOW_SELECTOR_LATER_SIBLINGS)) {
+    return false;
+  }
+
+  // SVG and MathML have their own ways of mapping attributes and animating
+  // style, so stick to HTML.
+  if (!aElement->IsHTMLElement() ||
+      aElement->HasID() ||
+      aElement->MayHaveStyle() ||
+      aElement->IsElementInStyleScope() ||
+      nsCSSRuleProcessor::IsLink(aElement)) {
+    return false;
+  }
+
+  return !EffectSet::GetEffectSet(aElement, CSSPseudoElementType::NotPseudo);
+}
+
+/* static */ bool
+nsStyleSharingCache::HaveSameAttributes(Element* aElement,
+                                        Element* aCandidate)
+{
+  uint32_t count = aElement->GetAttrCount();
+  if (count != aCandidate->GetAttrCount()) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    BorrowedAttrInfo info = aElement->GetAttrInfoAt(i);
+    const nsAttrValue* value =
+      aCandidate->GetParsedAttr(info.mName->LocalName(),
+                                info.mName->NamespaceID());
+    if (!value || !value->Equals(*info.mValue)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const nsStyleSharingCache::Entry*
+nsStyleSharingCache::Lookup(Element* aElement, nsStyleContext* aParentContext,
+                            uint32_t aFlags)
+{
+  if (mEntries.IsEmpty() || !aParentContext || !CanShare(aElement)) {
+    return nullptr;
+  }
+
+  nsIContent* parent = aElement->GetParent();
+  for (uint32_t i = 0; i < mEntries.Length(); ++i) {
+    const Entry& entry = mEntries[i];
+    Element* candidate = entry.mElement;
+    if (entry.mParentContext != aParentContext ||
+        entry.mFlags != aFlags ||
+        candidate->GetParent() != parent ||
+        candidate->NodeInfo() != aElement->NodeInfo() ||
+        candidate->GetBindingParent() != aElement->GetBindingParent() ||
+        candidate->IsInNativeAnonymousSubtree() !=
+          aElement->IsInNativeAnonymousSubtree() ||
+        candidate->StyleState() != aElement->StyleState() ||
+        !HaveSameAttributes(aElement, candidate)) {
+      continue;
+    }
+    if (i != 0) {
+      Entry hit = mEntries[i];
+      mEntries.RemoveElementAt(i);
+      mEntries.InsertElementAt(0, hit);
+    }
+    return &mEntries[0];
+  }
+  return nullptr;
+}
+
+void
+nsStyleSharingCache::Insert(Element* aElement, nsStyleContext* aParentContext,
+                            nsRuleNode* aRuleNode, uint32_t aFlags)
+{
+  // Selectors that depend on the children of aElement set these flags on it
+  // while matching.
+  if (!aParentContext ||
+      aElement->HasFlag(NODE_HAS_EMPTY_SELECTOR | NODE_HAS_SLOW_SELECTOR) ||
+      !CanShare(aElement)) {
+    return;
+  }
+
+  if (mEntries.Length() == kMaxEntries) {
+    mEntries.RemoveElementAt(kMaxEntries - 1);
+  }
+  Entry* entry = mEntries.InsertElementAt(0);
+  entry->mElement = aElement;
+  entry->mParentContext = aParentContext;
+  entry->mRuleNode = aRuleNode;
+  entry->mFlags = aFlags;
+}
@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef nsStyleSharingCache_h__
+#define nsStyleSharingCache_h__
+
+#include "mozilla/RefPtr.h"
+#include "nsTArray.h"
+
+class nsRuleNode;
+class nsStyleContext;
+
+namespace mozilla {
+namespace dom {
+class Element;
+} // namespace dom
+} // namespace mozilla
+
+/*
+ * A small cache of the rule nodes recently matched for elements, used to
+ * skip selector matching for siblings that are known to match exactly the
+ * same rules (for example the rows of a table, or the items of a list).
+ *
+ * An element can use the results of a cached sibling if both have the same
+ * parent element and parent style context, the same tag, attributes and
+ * state, and neither the sibling's nor the parent's selector flags show that
+ * matching depended on the position of the element among its siblings or on
+ * its children.  Elements with an ID, a style attribute, animations, or that
+ * are links or in a style scope are never shared.
+ *
+ * Like nsNthIndexCache, this lives in a TreeMatchContext, and relies on the
+ * DOM not changing during its lifetime.
+ */
+
+class nsStyleSharingCache {
+private:
+  typedef mozilla::dom::Element Element;
+
+public:
+  struct Entry {
+    Element* mElement;
+    RefPtr<nsStyleContext> mParentContext;
+    RefPtr<nsRuleNode> mRuleNode;
+    // Flags passed to nsStyleSet::GetContext.
+    uint32_t mFlags;
+  };
+
+  /**
+   * Constructor and destructor out of line so that we don't try to
+   * instantiate the array template all over the place.
+   */
+  nsStyleSharingCache();
+  ~nsStyleSharingCache();
+
+  /**
+   * Returns the entry of a sibling of aElement that it can share rule nodes
+   * with, or null.
+   */
+  const Entry* Lookup(Element* aElement, nsStyleContext* aParentContext,
+                      uint32_t aFlags);
+
+  /**
+   * Records the rule nodes that aElement matched, if other elements can share
+   * them.  Must be called after selector matching for aElement, so that its
+   * selector flags are up to date.
+   */
+  void Insert(Element* aElement, nsStyleContext* aParentContext,
+              nsRuleNode* aRuleNode, uint32_t aFlags);
+
+  void Reset();
+
+private:
+  // Checks that only depend on aElement itself.
+  static bool CanShare(Element* aElement);
+  static bool HaveSameAttributes(Element* aElement, Element* aCandidate);
+
+  // Most recently inserted or used first.
+  AutoTArray<Entry, 8> mEntries;
+};
+
+#endif /* nsStyleSharingCache_h__ */
@@ -159,6 +159,7 @@ jemalloc_stats_impl(jemalloc_stats_t *stats)
   stats->allocated = allocated;
   stats->waste = active - allocated;
   stats->page_cache = pdirty * page;
+  stats->thread_cache = 0;
   compute_bin_unused_and_bookkeeping(stats, narenas);
   stats->waste -= stats->bin_unused;
 }
@@ -322,6 +322,13 @@ __FBSDID("$FreeBSD: head/lib/libc/stdlib/malloc.c 180599 2008-07-18 19:35:44Z ja
 #ifndef MADV_FREE
 #  define MADV_FREE	MADV_DONTNEED
 #endif
+#ifdef MADV_HUGEPAGE
+   /*
+    * MALLOC_HUGEPAGES supports backing chunks with transparent huge pages;
+    * see opt_hugepages.
+    */
+#  define MALLOC_HUGEPAGES
+#endif
 #ifndef MAP_NOSYNC
 #  define MAP_NOSYNC	0
 #endif
@@ -536,6 +543,16 @@ static const bool isthreaded = true;
 #  endif
 #endif
 
+/*
+ * MALLOC_TCACHE enables per-thread caches of small regions, so that most small
+ * allocations and deallocations don't need to take the arena lock.  A cache is
+ * flushed by a pthread key destructor when its thread exits, so this requires
+ * both TLS and pthreads.
+ */
+#if !defined(NO_TLS) && !defined(MOZ_MEMORY_WINDOWS)
+#  define MALLOC_TCACHE
+#endif
+
 /*
  * Size and alignment of memory chunks that are allocated by the OS's virtual
  * memory system.
@@ -544,6 +561,30 @@ static const bool isthreaded = true;
 /* Maximum number of dirty pages per arena. */
 #define	DIRTY_MAX_DEFAULT	(1U << 8)
 
+#ifdef MALLOC_HUGEPAGES
+/* Size of a transparent huge page. */
+#define	HUGEPAGE_2POW		21
+#define	HUGEPAGE_SIZE		((size_t)1 << HUGEPAGE_2POW)
+#endif
+
+#ifdef MALLOC_TCACHE
+/*
+ * A thread cache keeps up to TCACHE_BIN_BYTES worth of regions for each small
+ * size class, but never fewer than TCACHE_BIN_NSLOTS_MIN or more than
+ * TCACHE_BIN_NSLOTS_MAX regions.
+ */
+#define	TCACHE_BIN_BYTES	4096
+#define	TCACHE_BIN_NSLOTS_MIN	4
+#define	TCACHE_BIN_NSLOTS_MAX	32
+
+/*
+ * Number of allocation and deallocation events between incremental GC passes
+ * over a thread cache.  Each pass returns the regions of one bin that have gone
+ * unused since the previous pass over that bin.
+ */
+#define	TCACHE_GC_INCR		256
+#endif
+
 /*
  * Maximum size of L1 cache line.  This is used to avoid cache line aliasing,
  * so over-estimates are okay (up to a point), but under-estimates will
@@ -1069,6 +1110,50 @@ struct arena_s {
 	arena_bin_t		bins[1]; /* Dynamically sized. */
 };
 
+#ifdef MALLOC_TCACHE
+/*
+ * Thread cache data structures.  A thread allocates small regions from, and
+ * frees them to, its own cache without locking; the arena lock is only taken
+ * to fill an empty bin of the cache, or to flush part of a full one.  Regions
+ * in a thread cache are allocated as far as their arena is concerned.
+ */
+
+typedef struct tcache_bin_s tcache_bin_t;
+struct tcache_bin_s {
+	/* Number of cached regions; slots[ncached - 1] is handed out next. */
+	uint32_t	ncached;
+
+	/* Minimum of ncached since the last GC pass over this bin. */
+	uint32_t	lowwater;
+
+	/* Capacity of slots. */
+	uint32_t	nslots;
+
+	void		**slots;
+};
+
+typedef struct tcache_s tcache_t;
+struct tcache_s {
+	/* Linkage for the list of all thread caches. */
+	LinkedList	link;
+
+	/* Arena that the cached regions belong to. */
+	arena_t		*arena;
+
+	/* Allocation and deallocation events since the last GC pass. */
+	unsigned	ev_count;
+
+	/* Bin that the next GC pass will look at. */
+	unsigned	next_gc_bin;
+
+	/* Value of tcache_epoch when this cache was last flushed. */
+	unsigned	epoch;
+
+	/* One bin per arena bin; the slots arrays follow. */
+	tcache_bin_t	bins[1]; /* Dynamically sized. */
+};
+#endif
+
 /******************************************************************************/
 /*
  * Data.
@@ -1303,6 +1388,30 @@ static __thread arena_t	*arenas_map;
 #endif
 #endif
 
+#ifdef MALLOC_TCACHE
+/*
+ * The calling thread's cache.  NULL until it has been created, and
+ * TCACHE_DISABLED while it is being created, once its thread is exiting, or if
+ * the thread can't have one.
+ */
+#define	TCACHE_DISABLED		((tcache_t *)(uintptr_t)1)
+static __thread tcache_t	*tcache_tls;
+
+/* Key whose destructor flushes and frees a thread's cache. */
+static pthread_key_t	tcache_key;
+static bool		tcache_key_created;
+
+/* List of all thread caches.  Protected by arenas_lock. */
+static LinkedList	tcaches;
+
+/*
+ * Incremented by jemalloc_free_dirty_pages() to ask every thread to flush its
+ * cache, which each thread does at its next GC pass.  Written under
+ * arenas_lock.
+ */
+static volatile unsigned tcache_epoch;
+#endif
+
 /*******************************/
 /*
  * Runtime configuration options.
@@ -1350,6 +1459,17 @@ static bool	opt_sysv = false;
 static bool	opt_xmalloc = false;
 #endif
 static int	opt_narenas_lshift = 0;
+#ifdef MALLOC_TCACHE
+static bool	opt_tcache = true;
+#endif
+#ifdef MALLOC_HUGEPAGES
+/*
+ * Advise the kernel to back chunks with transparent huge pages.  Off by
+ * default, as huge pages can increase RSS; adjacent chunk mappings merge, so
+ * the 2 MiB-aligned ranges they cover can use huge pages.
+ */
+static bool	opt_hugepages = false;
+#endif
 
 #ifdef MALLOC_UTRACE
 typedef struct {
@@ -1445,6 +1565,11 @@ static void	*huge_malloc(size_t size, bool zero);
 static void	*huge_palloc(size_t size, size_t alignment, bool zero);
 static void	*huge_ralloc(void *ptr, size_t size, size_t oldsize);
 static void	huge_dalloc(void *ptr);
+#ifdef MALLOC_TCACHE
+static tcache_t	*tcache_create(void);
+static void	tcache_bin_flush(tcache_t *tcache, unsigned binind, uint32_t n);
+static void	tcache_event_hard(tcache_t *tcache);
+#endif
 static void	malloc_print_stats(void);
 #ifndef MOZ_MEMORY_WINDOWS
 static
@@ -2733,6 +2858,22 @@ chunk_alloc_mmap_slow(size_t size, size_t alignment)
         return (ret);
 }
 
+#ifdef MALLOC_HUGEPAGES
+/*
+ * Advise the kernel to back a new chunk mapping with transparent huge pages.
+ * If the kernel doesn't support them, stop asking, and keep using normal
+ * pages.
+ */
+static void
+pages_hugepage_advise(void *addr, size_t size)
+{
+
+	if (opt_hugepages && madvise(addr, size, MADV_HUGEPAGE) != 0 &&
+	    errno == EINVAL)
+		opt_hugepages = false;
+}
+#endif
+
 static void *
 chunk_alloc_mmap(size_t size, size_t alignment)
 {
@@ -2742,6 +2883,17 @@ chunk_alloc_mmap(size_t size, size_t alignment)
         void *ret;
         size_t offset;
 
+#ifdef MALLOC_HUGEPAGES
+        /*
+         * Align mappings that can hold whole huge pages to the huge page
+         * size, so that none of their huge pages are split by the ends of the
+         * mapping.
+         */
+        if (opt_hugepages && size >= HUGEPAGE_SIZE &&
+            alignment < HUGEPAGE_SIZE)
+                alignment = HUGEPAGE_SIZE;
+#endif
+
         /*
          * Ideally, there would be a way to specify alignment to mmap() (like
          * NetBSD has), but in the absence of such a feature, we have to work
@@ -2761,10 +2913,15 @@ chunk_alloc_mmap(size_t size, size_t alignment)
         offset = ALIGNMENT_ADDR2OFFSET(ret, alignment);
         if (offset != 0) {
                 pages_unmap(ret, size);
-                return (chunk_alloc_mmap_slow(size, alignment));
+                ret = chunk_alloc_mmap_slow(size, alignment);
+                if (ret == NULL)
+                        return (NULL);
         }
 
         assert(ret != NULL);
+#ifdef MALLOC_HUGEPAGES
+        pages_hugepage_advise(ret, size);
+#endif
         return (ret);
 #endif
 }
@@ -4194,12 +4351,164 @@ arena_lock_balance_hard(arena_t *arena)
 }
 #endif
 
+/* Allocate a region from bin, taking the arena lock. */
+static inline void *
+arena_bin_malloc(arena_t *arena, arena_bin_t *bin)
+{
+	void *ret;
+	arena_run_t *run;
+
+#ifdef MALLOC_BALANCE
+	arena_lock_balance(arena);
+#else
+	malloc_spin_lock(&arena->lock);
+#endif
+	if ((run = bin->runcur) != NULL && run->nfree > 0)
+		ret = arena_bin_malloc_easy(arena, bin, run);
+	else
+		ret = arena_bin_malloc_hard(arena, bin);
+
+	if (ret == NULL) {
+		malloc_spin_unlock(&arena->lock);
+		return (NULL);
+	}
+
+#ifdef MALLOC_STATS
+	bin->stats.nrequests++;
+	arena->stats.nmalloc_small++;
+	arena->stats.allocated_small += bin->reg_size;
+#endif
+	malloc_spin_unlock(&arena->lock);
+
+	return (ret);
+}
+
+#ifdef MALLOC_TCACHE
+/*
+ * Begin thread cache.
+ */
+
+static inline uint32_t
+tcache_bin_nslots(size_t reg_size)
+{
+	size_t nslots = TCACHE_BIN_BYTES / reg_size;
+
+	if (nslots < TCACHE_BIN_NSLOTS_MIN)
+		return (TCACHE_BIN_NSLOTS_MIN);
+	if (nslots > TCACHE_BIN_NSLOTS_MAX)
+		return (TCACHE_BIN_NSLOTS_MAX);
+	return ((uint32_t)nslots);
+}
+
+/*
+ * Return the calling thread's cache, creating it if necessary, if it can hold
+ * regions from arena.
+ */
+static inline tcache_t *
+tcache_get(arena_t *arena)
+{
+	tcache_t *tcache = tcache_tls;
+
+	if (tcache == NULL) {
+		tcache = tcache_create();
+		if (tcache == NULL)
+			return (NULL);
+	} else if (tcache == TCACHE_DISABLED)
+		return (NULL);
+
+	return (tcache->arena == arena ? tcache : NULL);
+}
+
+static inline void
+tcache_event(tcache_t *tcache)
+{
+
+	if (++tcache->ev_count == TCACHE_GC_INCR)
+		tcache_event_hard(tcache);
+}
+
+/* Fill an empty bin of the cache from its arena.  Returns false on OOM. */
+static bool
+tcache_bin_fill(tcache_t *tcache, unsigned binind)
+{
+	arena_t *arena = tcache->arena;
+	arena_bin_t *bin = &arena->bins[binind];
+	tcache_bin_t *tbin = &tcache->bins[binind];
+	arena_run_t *run;
+	uint32_t i, j, nfill;
+	void *ptr;
+
+	assert(tbin->ncached == 0);
+	nfill = tbin->nslots >> 1;
+
+#ifdef MALLOC_BALANCE
+	arena_lock_balance(arena);
+#else
+	malloc_spin_lock(&arena->lock);
+#endif
+	for (i = 0; i < nfill; i++) {
+		if ((run = bin->runcur) != NULL && run->nfree > 0)
+			ptr = arena_bin_malloc_easy(arena, bin, run);
+		else
+			ptr = arena_bin_malloc_hard(arena, bin);
+		if (ptr == NULL)
+			break;
+		tbin->slots[i] = ptr;
+	}
+#ifdef MALLOC_STATS
+	bin->stats.nrequests += i;
+	arena->stats.nmalloc_small += i;
+	arena->stats.allocated_small += i * bin->reg_size;
+#endif
+	malloc_spin_unlock(&arena->lock);
+
+	if (i == 0)
+		return (false);
+
+	/*
+	 * The arena hands out its lowest free regions first; keep handing them
+	 * out in that order.
+	 */
+	for (j = 0; j < i / 2; j++) {
+		ptr = tbin->slots[j];
+		tbin->slots[j] = tbin->slots[i - 1 - j];
+		tbin->slots[i - 1 - j] = ptr;
+	}
+	tbin->ncached = i;
+
+	return (true);
+}
+
+static inline void *
+tcache_alloc(tcache_t *tcache, unsigned binind)
+{
+	tcache_bin_t *tbin = &tcache->bins[binind];
+	void *ret;
+
+	if (tbin->ncached == 0 && tcache_bin_fill(tcache, binind) == false)
+		return (NULL);
+
+	ret = tbin->slots[--tbin->ncached];
+	if (tbin->ncached < tbin->lowwater)
+		tbin->lowwater = tbin->ncached;
+	tcache_event(tcache);
+
+	return (ret);
+}
+
+/*
+ * End thread cache.
+ */
+#endif
+
 static inline void *
 arena_malloc_small(arena_t *arena, size_t size, bool zero)
 {
 	void *ret;
 	arena_bin_t *bin;
-	arena_run_t *run;
+#ifdef MALLOC_TCACHE
+	tcache_t *tcache;
+#endif
 
 	if (size < small_min) {
 		/* Tiny. */
@@ -4228,27 +4537,14 @@ arena_malloc_small(arena_t *arena, size_t size, bool zero)
 	}
 	RELEASE_ASSERT(size == bin->reg_size);
 
-#ifdef MALLOC_BALANCE
-	arena_lock_balance(arena);
-#else
-	malloc_spin_lock(&arena->lock);
-#endif
-	if ((run = bin->runcur) != NULL && run->nfree > 0)
-		ret = arena_bin_malloc_easy(arena, bin, run);
+#ifdef MALLOC_TCACHE
+	if ((tcache = tcache_get(arena)) != NULL)
+		ret = tcache_alloc(tcache, (unsigned)(bin - arena->bins));
 	else
-		ret = arena_bin_malloc_hard(arena, bin);
-
-	if (ret == NULL) {
-		malloc_spin_unlock(&arena->lock);
-		return (NULL);
-	}
-
-#ifdef MALLOC_STATS
-	bin->stats.nrequests++;
-	arena->stats.nmalloc_small++;
-	arena->stats.allocated_small += size;
 #endif
-	malloc_spin_unlock(&arena->lock);
+		ret = arena_bin_malloc(arena, bin);
+	if (ret == NULL)
+		return (NULL);
 
 	if (zero == false) {
 #ifdef MALLOC_FILL
@@ -4610,11 +4906,7 @@ arena_dalloc_small(arena_t *arena, arena_chunk_t *chunk, void *ptr,
 	bin = run->bin;
 	size = bin->reg_size;
 
-#ifdef MALLOC_FILL
-	if (opt_poison)
-		memset(ptr, 0xe5, size);
-#endif
-
+	/* The caller has already poisoned the region. */
 	arena_run_reg_dalloc(run, bin, ptr, size);
 	run->nfree++;
 
@@ -4685,6 +4977,102 @@ arena_dalloc_small(arena_t *arena, arena_chunk_t *chunk, void *ptr,
 #endif
 }
 
+#ifdef MALLOC_TCACHE
+/*
+ * Begin thread cache.
+ */
+
+/* Return the n least recently cached regions of a bin to the arena. */
+static void
+tcache_bin_flush(tcache_t *tcache, unsigned binind, uint32_t n)
+{
+	arena_t *arena = tcache->arena;
+	tcache_bin_t *tbin = &tcache->bins[binind];
+	uint32_t i;
+
+	assert(n <= tbin->ncached);
+	if (n == 0)
+		return;
+
+	malloc_spin_lock(&arena->lock);
+	for (i = 0; i < n; i++) {
+		void *ptr = tbin->slots[i];
+		arena_chunk_t *chunk = (arena_chunk_t *)CHUNK_ADDR2BASE(ptr);
+		size_t pageind = ((uintptr_t)ptr - (uintptr_t)chunk) >>
+		    pagesize_2pow;
+
+		RELEASE_ASSERT(chunk->arena == arena);
+		arena_dalloc_small(arena, chunk, ptr, &chunk->map[pageind]);
+	}
+	malloc_spin_unlock(&arena->lock);
+
+	tbin->ncached -= n;
+	memmove(tbin->slots, &tbin->slots[n], tbin->ncached * sizeof(void *));
+	if (tbin->lowwater > tbin->ncached)
+		tbin->lowwater = tbin->ncached;
+}
+
+/* Return all of a cache's regions to the arena. */
+static void
+tcache_flush(tcache_t *tcache)
+{
+	unsigned i;
+
+	tcache->epoch = tcache_epoch;
+	for (i = 0; i < ntbins + nqbins + nsbins; i++)
+		tcache_bin_flush(tcache, i, tcache->bins[i].ncached);
+}
+
+static void
+tcache_event_hard(tcache_t *tcache)
+{
+	tcache_bin_t *tbin;
+	unsigned binind;
+
+	tcache->ev_count = 0;
+	if (tcache->epoch != tcache_epoch) {
+		tcache_flush(tcache);
+		return;
+	}
+
+	/*
+	 * The lowwater oldest regions of this bin went unused since the last
+	 * pass over it.  Return most of them, so that idle size classes don't
+	 * keep memory away from the arena.
+	 */
+	binind = tcache->next_gc_bin;
+	tbin = &tcache->bins[binind];
+	if (tbin->lowwater > 0)
+		tcache_bin_flush(tcache, binind,
+		    tbin->lowwater - (tbin->lowwater >> 2));
+	tbin->lowwater = tbin->ncached;
+	tcache->next_gc_bin = (binind + 1) % (ntbins + nqbins + nsbins);
+}
+
+static inline void
+tcache_dalloc(tcache_t *tcache, void *ptr, arena_chunk_map_t *mapelm)
+{
+	arena_run_t *run;
+	tcache_bin_t *tbin;
+	unsigned binind;
+
+	/* The run can't go away while it has an allocated region. */
+	run = (arena_run_t *)(mapelm->bits & ~pagesize_mask);
+	RELEASE_ASSERT(run->magic == ARENA_RUN_MAGIC);
+	binind = (unsigned)(run->bin - tcache->arena->bins);
+	tbin = &tcache->bins[binind];
+
+	if (tbin->ncached == tbin->nslots)
+		tcache_bin_flush(tcache, binind, tbin->nslots >> 1);
+	tbin->slots[tbin->ncached++] = ptr;
+	tcache_event(tcache);
+}
+
+/*
+ * End thread cache.
+ */
+#endif
+
 static void
 arena_dalloc_large(arena_t *arena, arena_chunk_t *chunk, void *ptr)
 {
@@ -4741,6 +5129,24 @@ arena_dalloc(void *ptr, size_t offset)
 	RELEASE_ASSERT((mapelm->bits & CHUNK_MAP_ALLOCATED) != 0);
 	if ((mapelm->bits & CHUNK_MAP_LARGE) == 0) {
 		/* Small allocation. */
+#ifdef MALLOC_TCACHE
+		tcache_t *tcache;
+#endif
+
+#ifdef MALLOC_FILL
+		if (opt_poison) {
+			arena_run_t *run = (arena_run_t *)(mapelm->bits &
+			    ~pagesize_mask);
+			RELEASE_ASSERT(run->magic == ARENA_RUN_MAGIC);
+			memset(ptr, 0xe5, run->bin->reg_size);
+		}
+#endif
+#ifdef MALLOC_TCACHE
+		if ((tcache = tcache_get(arena)) != NULL) {
+			tcache_dalloc(tcache, ptr, mapelm);
+			return;
+		}
+#endif
 		malloc_spin_lock(&arena->lock);
 		arena_dalloc_small(arena, chunk, ptr, mapelm);
 		malloc_spin_unlock(&arena->lock);
@@ -4762,6 +5168,96 @@ idalloc(void *ptr)
 		huge_dalloc(ptr);
 }
 
+#ifdef MALLOC_TCACHE
+/*
+ * Begin thread cache.
+ */
+
+/*
+ * Create the calling thread's cache.  Returns NULL if the thread can't have a
+ * cache, or can't have one yet.
+ */
+static tcache_t *
+tcache_create(void)
+{
+	tcache_t *tcache;
+	arena_t *arena;
+	size_t size;
+	unsigned i, nbins;
+	uint32_t nslots;
+	void **slots;
+
+	if (opt_tcache == false) {
+		tcache_tls = TCACHE_DISABLED;
+		return (NULL);
+	}
+	if (tcache_key_created == false) {
+		/* Still initializing; try again later. */
+		return (NULL);
+	}
+
+	/*
+	 * Allocating the cache and registering it with pthread_setspecific()
+	 * can both recurse into malloc; those allocations bypass the cache.
+	 */
+	tcache_tls = TCACHE_DISABLED;
+
+	arena = choose_arena();
+	nbins = ntbins + nqbins + nsbins;
+	nslots = 0;
+	for (i = 0; i < nbins; i++)
+		nslots += tcache_bin_nslots(arena->bins[i].reg_size);
+	size = sizeof(tcache_t) + (sizeof(tcache_bin_t) * (nbins - 1)) +
+	    (sizeof(void *) * nslots);
+
+	/* Zeroing sets all the counters and bins to empty. */
+	tcache = (tcache_t *)arena_malloc(arena, size, true);
+	if (tcache == NULL)
+		return (NULL);
+	tcache->arena = arena;
+	tcache->epoch = tcache_epoch;
+	slots = (void **)&tcache->bins[nbins];
+	for (i = 0; i < nbins; i++) {
+		tcache->bins[i].nslots =
+		    tcache_bin_nslots(arena->bins[i].reg_size);
+		tcache->bins[i].slots = slots;
+		slots += tcache->bins[i].nslots;
+	}
+
+	if (pthread_setspecific(tcache_key, tcache) != 0) {
+		idalloc(tcache);
+		return (NULL);
+	}
+	malloc_spin_lock(&arenas_lock);
+	LinkedList_InsertHead(&tcaches, &tcache->link);
+	malloc_spin_unlock(&arenas_lock);
+
+	tcache_tls = tcache;
+	return (tcache);
+}
+
+/* Flush and free a thread's cache when the thread exits. */
+static void
+tcache_thread_cleanup(void *arg)
+{
+	tcache_t *tcache = (tcache_t *)arg;
+
+	/* Later frees on this thread go straight to the arena. */
+	tcache_tls = TCACHE_DISABLED;
+	tcache_flush(tcache);
+
+	malloc_spin_lock(&arenas_lock);
+	LinkedList_Remove(&tcache->link);
+	malloc_spin_unlock(&arenas_lock);
+
+	idalloc(tcache);
+}
+
+/*
+ * End thread cache.
+ */
+#endif
+
 static void
 arena_ralloc_large_shrink(arena_t *arena, arena_chunk_t *chunk, void *ptr,
     size_t size, size_t oldsize)
@@ -5421,7 +5917,15 @@ malloc_print_stats(void)
 		    opt_abort ? "A" : "a", "", "");
 #ifdef MALLOC_FILL
 		_malloc_message(opt_poison ? "C" : "c", "", "", "");
+#endif
+#ifdef MALLOC_TCACHE
+		_malloc_message(opt_tcache ? "H" : "h", "", "", "");
+#endif
+#ifdef MALLOC_FILL
 		_malloc_message(opt_junk ? "J" : "j", "", "", "");
+#endif
+#ifdef MALLOC_HUGEPAGES
+		_malloc_message(opt_hugepages ? "L" : "l", "", "", "");
 #endif
 		_malloc_message("P", "", "", "");
 #ifdef MALLOC_UTRACE
@@ -5748,6 +6252,14 @@ MALLOC_OUT:
 					else if ((opt_dirty_max << 1) != 0)
 						opt_dirty_max <<= 1;
 					break;
+#ifdef MALLOC_TCACHE
+				case 'h':
+					opt_tcache = false;
+					break;
+				case 'H':
+					opt_tcache = true;
+					break;
+#endif
 #ifdef MALLOC_FILL
 #ifndef MALLOC_PRODUCTION
 				case 'j':
@@ -5773,6 +6285,14 @@ MALLOC_OUT:
 					    (sizeof(size_t) << 3))
 						opt_chunk_2pow++;
 					break;
+#endif
+#ifdef MALLOC_HUGEPAGES
+				case 'l':
+					opt_hugepages = false;
+					break;
+				case 'L':
+					opt_hugepages = true;
+					break;
 #endif
 				case 'n':
 					opt_narenas_lshift--;
@@ -6058,6 +6578,13 @@ MALLOC_OUT:
 
 	malloc_spin_init(&arenas_lock);
 
+#ifdef MALLOC_TCACHE
+	/* Thread caches are created lazily, once the key exists. */
+	LinkedList_Init(&tcaches);
+	tcache_key_created = (pthread_key_create(&tcache_key,
+	    tcache_thread_cleanup) == 0);
+#endif
+
 #ifdef MALLOC_VALIDATE
 	chunk_rtree = malloc_rtree_new((SIZEOF_PTR << 3) - opt_chunk_2pow);
 	if (chunk_rtree == NULL)
@@ -6558,6 +7085,9 @@ MOZ_JEMALLOC_API void
 jemalloc_stats_impl(jemalloc_stats_t *stats)
 {
 	size_t i, non_arena_mapped, chunk_header_size;
+#ifdef MALLOC_TCACHE
+	LinkedList *elm;
+#endif
 
 	assert(stats != NULL);
 
@@ -6618,6 +7148,7 @@ jemalloc_stats_impl(jemalloc_stats_t *stats)
 	stats->page_cache = 0;
         stats->bookkeeping = 0;
 	stats->bin_unused = 0;
+	stats->thread_cache = 0;
 
 	non_arena_mapped = 0;
 
@@ -6695,6 +7226,29 @@ jemalloc_stats_impl(jemalloc_stats_t *stats)
 		stats->bookkeeping += arena_headers;
 	}
 
+#ifdef MALLOC_TCACHE
+	/*
+	 * Regions in thread caches are allocated as far as the arenas know, but
+	 * are unused.  The counts are read without the caches' threads
+	 * synchronizing, so they may be slightly stale.
+	 */
+	malloc_spin_lock(&arenas_lock);
+	for (elm = tcaches.next; elm != &tcaches; elm = elm->next) {
+		tcache_t *tcache = LinkedList_Get(elm, tcache_t, link);
+		size_t j;
+
+		for (j = 0; j < ntbins + nqbins + nsbins; j++) {
+			stats->thread_cache += tcache->bins[j].ncached *
+			    tcache->arena->bins[j].reg_size;
+		}
+	}
+	malloc_spin_unlock(&arenas_lock);
+
+	assert(stats->allocated >= stats->thread_cache);
+	stats->allocated -= stats->thread_cache;
+	stats->bin_unused += stats->thread_cache;
+#endif
+
 	/* Account for arena chunk headers in bookkeeping rather than waste. */
 	chunk_header_size =
 	    ((stats->mapped / stats->chunksize) * arena_chunk_header_npages) <<
@@ -6840,6 +7394,19 @@ MOZ_JEMALLOC_API void
 jemalloc_free_dirty_pages_impl(void)
 {
 	size_t i;
+#ifdef MALLOC_TCACHE
+	tcache_t *tcache = tcache_tls;
+
+	/*
+	 * Other threads' caches can't be touched from here; ask their threads
+	 * to flush them at their next GC pass.
+	 */
+	malloc_spin_lock(&arenas_lock);
+	tcache_epoch++;
+	malloc_spin_unlock(&arenas_lock);
+	if (tcache != NULL && tcache != TCACHE_DISABLED)
+		tcache_flush(tcache);
+#endif
 	for (i = 0; i < narenas; i++) {
 		arena_t *arena = arenas[i];
 
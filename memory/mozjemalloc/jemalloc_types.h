@@ -82,6 +82,8 @@ typedef struct {
         size_t  bookkeeping;    /* Committed bytes used internally by the
                                    allocator. */
 	size_t bin_unused; /* Bytes committed to a bin but currently unused. */
+	size_t thread_cache; /* Bytes held in thread caches; these are unused,
+				and included in bin_unused. */
 } jemalloc_stats_t;
 
 #ifdef __cplusplus
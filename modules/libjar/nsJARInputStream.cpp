@@ -36,6 +36,21 @@ nsJARInputStream::InitFile(nsJAR *aJar, nsZipItem *item)
 
     // Mark it as closed, in case something fails in initialisation
     mMode = MODE_CLOSED;
+
+    // Copy out the data if the archive has already inflated it
+    if (item->Compression() == DEFLATED) {
+        mPreInflated = aJar->mZip->TakePreInflated(item);
+        if (mPreInflated) {
+            mMode = MODE_COPY;
+            mFd = aJar->mZip->GetFD();
+            mZs.next_in = mPreInflated.get();
+            mZs.avail_in = item->RealSize();
+            mOutSize = item->RealSize();
+            mZs.total_out = 0;
+            return NS_OK;
+        }
+    }
+
     //-- prepare for the compression type
     switch (item->Compression()) {
        case STORED: 
@@ -248,6 +263,7 @@ nsJARInputStream::Close()
     }
     mMode = MODE_CLOSED;
     mFd = nullptr;
+    mPreInflated = nullptr;
     return NS_OK;
 }
 
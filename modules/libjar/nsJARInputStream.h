@@ -11,6 +11,7 @@
 #include "nsJAR.h"
 #include "nsTArray.h"
 #include "mozilla/Attributes.h"
+#include "mozilla/UniquePtr.h"
 
 /*-------------------------------------------------------------------------
  * Class nsJARInputStream declaration. This class defines the type of the
@@ -45,6 +46,7 @@ class nsJARInputStream final : public nsIInputStream
     uint32_t               mInCrc;      // CRC as provided by the zipentry
     uint32_t               mOutCrc;     // CRC as calculated by me
     z_stream               mZs;         // zip data structure
+    mozilla::UniquePtr<uint8_t[]> mPreInflated; // data inflated by nsZipArchive::PreInflate
 
     /* For directory reading */
     RefPtr<nsJAR>          mJar;        // string reference to zipreader
@@ -27,12 +27,14 @@
 #include "nsZipArchive.h"
 #include "nsString.h"
 #include "prenv.h"
+#include "prthread.h"
 #if defined(XP_WIN)
 #include <windows.h>
 #endif
 
 // For placement new used for arena allocations of zip file list
 #include <new>
+#include <algorithm>
 #define ZIP_ARENABLOCKSIZE (1*1024)
 
 #ifdef XP_UNIX
@@ -72,6 +74,11 @@ static const uint32_t kMaxNameLength = PATH_MAX; /* Maximum name length */
 // For synthetic zip entries. Date/time corresponds to 1980-01-01 00:00.
 static const uint16_t kSyntheticTime = 0;
 static const uint16_t kSyntheticDate = (1 + (1 << 5) + (0 << 9));
+// Limits on what PreInflate() keeps in memory: items above the per-item
+// size are left for the requesting thread, and inflation stops once the
+// total is reached.
+static const uint32_t kMaxPreInflateItemSize = 1024 * 1024;
+static const uint32_t kMaxPreInflateSize = 8 * 1024 * 1024;
 
 static uint16_t xtoint(const uint8_t *ii);
 static uint32_t xtolong(const uint8_t *ll);
@@ -428,6 +435,9 @@ nsresult nsZipArchive::Test(const char *aEntryName)
 //---------------------------------------------
 nsresult nsZipArchive::CloseArchive()
 {
+  // The background thread uses the arena-allocated items.
+  CancelPreInflate();
+
   if (mFd) {
     PL_FinishArenaPool(&mArena);
     mFd = nullptr;
@@ -445,6 +455,155 @@ nsresult nsZipArchive::CloseArchive()
   return NS_OK;
 }
 
+//---------------------------------------------
+//  nsZipArchive::PreInflate
+//---------------------------------------------
+namespace {
+
+class LocalOffsetComparator
+{
+public:
+  bool Equals(nsZipItem* aA, nsZipItem* aB) const {
+    return aA->LocalOffset() == aB->LocalOffset();
+  }
+  bool LessThan(nsZipItem* aA, nsZipItem* aB) const {
+    return aA->LocalOffset() < aB->LocalOffset();
+  }
+};
+
+} // anonymous namespace
+
+void nsZipArchive::PreInflate()
+{
+  if (!mFd || !mReadaheadLength) {
+    return;
+  }
+
+  {
+    MutexAutoLock lock(mPreInflateLock);
+    if (mPreInflateRunning || !mPreInflateOrder.IsEmpty()) {
+      return;
+    }
+
+    // The packager puts the entries used during startup first, in the order
+    // they were used, and makes them the readahead area.
+    for (int i = 0; i < ZIP_TABSIZE; i++) {
+      for (nsZipItem* item = mFiles[i]; item; item = item->next) {
+        if (item->isSynthetic || item->Compression() != DEFLATED ||
+            item->LocalOffset() >= mReadaheadLength ||
+            item->RealSize() > kMaxPreInflateItemSize) {
+          continue;
+        }
+        mPreInflateOrder.AppendElement(item);
+      }
+    }
+    mPreInflateOrder.Sort(LocalOffsetComparator());
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < mPreInflateOrder.Length(); i++) {
+      total += mPreInflateOrder[i]->RealSize();
+      if (total > kMaxPreInflateSize) {
+        mPreInflateOrder.TruncateLength(i);
+        break;
+      }
+      mPreInflated.Put(mPreInflateOrder[i], new PreInflatedItem());
+    }
+
+    if (mPreInflateOrder.IsEmpty()) {
+      return;
+    }
+    mPreInflateRunning = true;
+  }
+
+  // The thread holds a reference until it is done.
+  AddRef();
+  PRThread* thread = PR_CreateThread(PR_USER_THREAD, PreInflateThreadFunc,
+                                     this, PR_PRIORITY_LOW, PR_GLOBAL_THREAD,
+                                     PR_UNJOINABLE_THREAD, 0);
+  if (!thread) {
+    {
+      MutexAutoLock lock(mPreInflateLock);
+      mPreInflateRunning = false;
+      mPreInflated.Clear();
+      mPreInflateOrder.Clear();
+    }
+    Release();
+  }
+}
+
+/* static */ void nsZipArchive::PreInflateThreadFunc(void *aArchive)
+{
+  PR_SetCurrentThreadName("ZipPreInflate");
+
+  // Adopt the reference taken by PreInflate().
+  RefPtr<nsZipArchive> archive =
+    dont_AddRef(static_cast<nsZipArchive*>(aArchive));
+  archive->RunPreInflate();
+}
+
+void nsZipArchive::RunPreInflate()
+{
+  for (uint32_t i = 0; ; i++) {
+    nsZipItem* item;
+    {
+      MutexAutoLock lock(mPreInflateLock);
+      if (mPreInflateCanceled || i >= mPreInflateOrder.Length()) {
+        break;
+      }
+      item = mPreInflateOrder[i];
+      // Skip items that have been requested in the meantime.
+      if (!mPreInflated.Get(item)) {
+        continue;
+      }
+    }
+
+    uint32_t size = item->RealSize();
+    UniquePtr<uint8_t[]> data = MakeUniqueFallible<uint8_t[]>(size);
+    if (!data) {
+      break;
+    }
+
+    uint32_t len = 0;
+    nsZipCursor cursor(item, this, data.get(), size, true);
+    if (!cursor.Read(&len) || len != size) {
+      // Leave corrupted items to the requesting thread, which reports them.
+      continue;
+    }
+
+    MutexAutoLock lock(mPreInflateLock);
+    PreInflatedItem* entry = mPreInflated.Get(item);
+    if (entry) {
+      entry->mData = Move(data);
+    }
+  }
+
+  MutexAutoLock lock(mPreInflateLock);
+  mPreInflateRunning = false;
+  mPreInflateCondVar.NotifyAll();
+}
+
+void nsZipArchive::CancelPreInflate()
+{
+  MutexAutoLock lock(mPreInflateLock);
+  mPreInflateCanceled = true;
+  while (mPreInflateRunning) {
+    mPreInflateCondVar.Wait();
+  }
+  mPreInflated.Clear();
+  mPreInflateOrder.Clear();
+}
+
+UniquePtr<uint8_t[]> nsZipArchive::TakePreInflated(nsZipItem* aItem)
+{
+  MutexAutoLock lock(mPreInflateLock);
+  nsAutoPtr<PreInflatedItem> entry;
+  mPreInflated.RemoveAndForget(aItem, entry);
+  if (!entry) {
+    return nullptr;
+  }
+  return Move(entry->mData);
+}
+
 //---------------------------------------------
 // nsZipArchive::GetItem
 //---------------------------------------------
@@ -687,6 +846,7 @@ MOZ_WIN_MEM_TRY_BEGIN
   if (mFd->mLen > ZIPCENTRAL_SIZE && xtolong(startp + centralOffset) == CENTRALSIG) {
     // Success means optimized jar layout from bug 559961 is in effect
     uint32_t readaheadLength = xtolong(startp);
+    mReadaheadLength = std::min(readaheadLength, mFd->mLen);
     if (readaheadLength) {
 #if defined(XP_UNIX)
       madvise(const_cast<uint8_t*>(startp), readaheadLength, MADV_WILLNEED);
@@ -953,6 +1113,11 @@ nsZipArchive::nsZipArchive()
   , mCommentPtr(nullptr)
   , mCommentLen(0)
   , mBuiltSynthetics(false)
+  , mReadaheadLength(0)
+  , mPreInflateLock("nsZipArchive.mPreInflateLock")
+  , mPreInflateCondVar(mPreInflateLock, "nsZipArchive.mPreInflateCondVar")
+  , mPreInflateRunning(false)
+  , mPreInflateCanceled(false)
 {
   zipLog.AddRef();
 
@@ -1271,6 +1436,12 @@ nsZipItemPtr_base::nsZipItemPtr_base(nsZipArchive *aZip,
   uint32_t size = 0;
   if (item->Compression() == DEFLATED) {
     size = item->RealSize();
+    mAutoBuf = aZip->TakePreInflated(item);
+    if (mAutoBuf) {
+      mReturnBuf = mAutoBuf.get();
+      mReadlen = size;
+      return;
+    }
     mAutoBuf = MakeUniqueFallible<uint8_t[]>(size);
     if (!mAutoBuf) {
       return;
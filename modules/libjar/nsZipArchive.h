@@ -15,10 +15,15 @@
 #include "zlib.h"
 #include "zipstruct.h"
 #include "nsAutoPtr.h"
+#include "nsClassHashtable.h"
+#include "nsHashKeys.h"
 #include "nsIFile.h"
 #include "nsISupportsImpl.h" // For mozilla::ThreadSafeAutoRefCnt
+#include "nsTArray.h"
+#include "mozilla/CondVar.h"
 #include "mozilla/FileUtils.h"
 #include "mozilla/FileLocation.h"
+#include "mozilla/Mutex.h"
 #include "mozilla/UniquePtr.h"
 
 #ifdef HAVE_SEH_EXCEPTIONS
@@ -199,6 +204,27 @@ public:
 
   bool GetComment(nsACString &aComment);
 
+  /**
+   * PreInflate
+   *
+   * Starts inflating the deflated items that lie in the readahead area of
+   * an optimized jar -- the entries the packager recorded as used during
+   * startup, in the order they were used -- on a background thread, so
+   * the reads that follow find them already inflated. Does nothing if the
+   * archive has no readahead area. Call at most once.
+   */
+  void PreInflate();
+
+  /**
+   * TakePreInflated
+   *
+   * @param   aItem       Pointer to nsZipItem
+   * @return  the inflated and CRC-checked data of aItem (RealSize() bytes)
+   *          if PreInflate() has got to it, otherwise null; in that case
+   *          the background thread skips the item from now on.
+   */
+  mozilla::UniquePtr<uint8_t[]> TakePreInflated(nsZipItem* aItem);
+
   /**
    * Gets the amount of memory taken up by the archive's mapping.
    * @return the size
@@ -231,12 +257,31 @@ private:
   // file URI, for logging
   nsCString mURI;
 
+  // Length of the readahead area of an optimized jar, or 0
+  uint32_t      mReadaheadLength;
+
+  // PreInflate() state. An item waiting to be inflated has an entry without
+  // data; TakePreInflated removes entries.
+  struct PreInflatedItem {
+    mozilla::UniquePtr<uint8_t[]> mData;
+  };
+  mozilla::Mutex    mPreInflateLock;
+  mozilla::CondVar  mPreInflateCondVar;
+  nsClassHashtable<nsPtrHashKey<nsZipItem>, PreInflatedItem> mPreInflated;
+  nsTArray<nsZipItem*> mPreInflateOrder;
+  bool              mPreInflateRunning;
+  bool              mPreInflateCanceled;
+
 private:
   //--- private methods ---
   nsZipItem*        CreateZipItem();
   nsresult          BuildFileList(PRFileDesc *aFd = nullptr);
   nsresult          BuildSynthetics();
 
+  static void       PreInflateThreadFunc(void *aArchive);
+  void              RunPreInflate();
+  void              CancelPreInflate();
+
   nsZipArchive& operator=(const nsZipArchive& rhs) = delete;
   nsZipArchive(const nsZipArchive& rhs) = delete;
 };
@@ -6,10 +6,12 @@
 
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/dom/ContentChild.h"
+#include "mozilla/ipc/SharedMemoryBasic.h"
 
 #include "mozilla/ArrayUtils.h"
 #include "mozilla/Attributes.h"
 #include "mozilla/HashFunctions.h"
+#include "mozilla/StaticPtr.h"
 #include "mozilla/UniquePtrExtensions.h"
 
 #include "nsXULAppAPI.h"
@@ -226,6 +228,12 @@ static nsTArray<nsAutoPtr<CacheData> >* gCacheData = nullptr;
 static nsRefPtrHashtable<ValueObserverHashKey,
                          ValueObserver>* gObserverTable = nullptr;
 
+// The last snapshot handed out by GetPreferencesSnapshot, and the
+// pref_GetGeneration() it was built at.
+static StaticRefPtr<ipc::SharedMemoryBasic> gSnapshot;
+static uint32_t gSnapshotSize = 0;
+static uint32_t gSnapshotGeneration = 0;
+
 #ifdef DEBUG
 static bool
 HaveExistingCacheFor(void* aPtr)
@@ -515,6 +523,8 @@ Preferences::~Preferences()
   delete gCacheData;
   gCacheData = nullptr;
 
+  gSnapshot = nullptr;
+
   NS_RELEASE(sRootBranch);
   NS_RELEASE(sDefaultRootBranch);
 
@@ -554,11 +564,23 @@ Preferences::Init()
   PREF_SetDirtyCallback(&DirtyCallback);
   PREF_Init();
 
-  rv = pref_InitInitialObjects();
-  NS_ENSURE_SUCCESS(rv, rv);
-
   using mozilla::dom::ContentChild;
   if (XRE_IsContentProcess()) {
+    // The parent's snapshot already holds every default it loaded, so
+    // there is no need to parse the default pref files again here.
+    ipc::SharedMemoryBasic::Handle handle = ipc::SharedMemoryBasic::NULLHandle();
+    uint32_t size = 0;
+    ContentChild::GetSingleton()->SendReadPrefsSnapshot(&handle, &size);
+    RefPtr<ipc::SharedMemoryBasic> shmem = new ipc::SharedMemoryBasic();
+    if (size && shmem->IsHandleValid(handle) && shmem->SetHandle(handle) &&
+        shmem->Map(size) && pref_SetSnapshot(shmem, size)) {
+      return NS_OK;
+    }
+    NS_WARNING("Couldn't map the preferences snapshot");
+
+    rv = pref_InitInitialObjects();
+    NS_ENSURE_SUCCESS(rv, rv);
+
     InfallibleTArray<PrefSetting> prefs;
     ContentChild::GetSingleton()->SendReadPrefsArray(&prefs);
 
@@ -569,6 +591,9 @@ Preferences::Init()
     return NS_OK;
   }
 
+  rv = pref_InitInitialObjects();
+  NS_ENSURE_SUCCESS(rv, rv);
+
   nsXPIDLCString lockFileName;
   /*
    * The following is a small hack which will allow us to only load the library
@@ -767,6 +792,8 @@ Preferences::GetPreference(PrefSetting* aPref)
 void
 Preferences::GetPreferences(InfallibleTArray<PrefSetting>* aPrefs)
 {
+  pref_MaterializeSnapshot();
+
   aPrefs->SetCapacity(gHashTable->Capacity());
   for (auto iter = gHashTable->Iter(); !iter.Done(); iter.Next()) {
     auto entry = static_cast<PrefHashEntry*>(iter.Get());
@@ -780,6 +807,33 @@ Preferences::GetPreferences(InfallibleTArray<PrefSetting>* aPrefs)
   }
 }
 
+already_AddRefed<ipc::SharedMemoryBasic>
+Preferences::GetPreferencesSnapshot(uint32_t* aSize)
+{
+  MOZ_ASSERT(XRE_IsParentProcess());
+
+  if (!gSnapshot || gSnapshotGeneration != pref_GetGeneration()) {
+    gSnapshot = nullptr;
+
+    nsTArray<uint8_t> image;
+    pref_BuildSnapshot(&image);
+
+    RefPtr<ipc::SharedMemoryBasic> shmem = new ipc::SharedMemoryBasic();
+    if (!shmem->Create(image.Length()) || !shmem->Map(image.Length())) {
+      return nullptr;
+    }
+    memcpy(shmem->memory(), image.Elements(), image.Length());
+
+    gSnapshot = shmem;
+    gSnapshotSize = image.Length();
+    gSnapshotGeneration = pref_GetGeneration();
+  }
+
+  *aSize = gSnapshotSize;
+  RefPtr<ipc::SharedMemoryBasic> snapshot = gSnapshot.get();
+  return snapshot.forget();
+}
+
 NS_IMETHODIMP
 Preferences::GetBranch(const char *aPrefRoot, nsIPrefBranch **_retval)
 {
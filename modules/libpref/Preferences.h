@@ -34,6 +34,10 @@ namespace dom {
 class PrefSetting;
 } // namespace dom
 
+namespace ipc {
+class SharedMemoryBasic;
+} // namespace ipc
+
 class Preferences final : public nsIPrefService,
                           public nsIObserver,
                           public nsIPrefBranchInternal,
@@ -366,6 +370,11 @@ public:
   static void GetPreference(PrefSetting* aPref);
   static void SetPreference(const PrefSetting& aPref);
 
+  // Returns a read-only image of every preference for a content process to
+  // map, rebuilding it only if a preference changed since the last call.
+  static already_AddRefed<mozilla::ipc::SharedMemoryBasic>
+  GetPreferencesSnapshot(uint32_t* aSize);
+
   static int64_t SizeOfIncludingThisAndOtherStuff(mozilla::MallocSizeOf aMallocSizeOf);
 
   static void DirtyCallback();
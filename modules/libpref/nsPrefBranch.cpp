@@ -576,6 +576,7 @@ NS_IMETHODIMP nsPrefBranch::GetChildList(const char *aStartingAt, uint32_t *aCou
 
   const char* parent = getPrefName(aStartingAt);
   size_t parentLen = strlen(parent);
+  pref_MaterializeSnapshot();
   for (auto iter = gHashTable->Iter(); !iter.Done(); iter.Next()) {
     auto entry = static_cast<PrefHashEntry*>(iter.Get());
     if (strncmp(entry->key, parent, parentLen) == 0) {
@@ -29,6 +29,8 @@
 #include "prprf.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/dom/PContent.h"
+#include "mozilla/ipc/SharedMemoryBasic.h"
+#include "mozilla/StaticPtr.h"
 #include "nsQuickSort.h"
 #include "nsString.h"
 #include "nsPrintfCString.h"
@@ -75,6 +77,16 @@ static bool         gIsAnyPrefLocked = false;
 // These are only used during the call to pref_DoCallback
 static bool         gCallbacksInProgress = false;
 static bool         gShouldCleanupDeadNodes = false;
+// Bumped on every change to gHashTable, so a snapshot built from it can
+// tell when it has gone stale.
+static uint32_t     gPrefGeneration = 0;
+
+// Read-only image of the parent's preferences (content processes only).
+// gHashTable acts as an overlay on top of it: lookups that miss the table
+// copy the entry over from the image, and updates from the parent are
+// applied to the table.
+static StaticRefPtr<mozilla::ipc::SharedMemoryBasic> gSnapshotShmem;
+static const char*  gSnapshotData = nullptr;
 
 
 static PLDHashTableOps     pref_HashTableOps = {
@@ -193,6 +205,8 @@ void PREF_Cleanup()
 /* Frees up all the objects except the callback list. */
 void PREF_CleanupPrefs()
 {
+    gSnapshotShmem = nullptr;
+    gSnapshotData = nullptr;
     if (gHashTable) {
         delete gHashTable;
         gHashTable = nullptr;
@@ -582,6 +596,9 @@ PREF_DeleteBranch(const char *branch_name)
     if (!gHashTable)
         return NS_ERROR_NOT_INITIALIZED;
 
+    pref_MaterializeSnapshot();
+    gPrefGeneration++;
+
     /* The following check insures that if the branch name already has a "."
      * at the end, we don't end up with a "..". This fixes an incompatibility
      * between nsIPref, which needs the period added, and nsIPrefBranch which
@@ -624,8 +641,14 @@ PREF_ClearUserPref(const char *pref_name)
         pref->prefFlags.SetHasUserValue(false);
 
         if (!pref->prefFlags.HasDefault()) {
+            // Copy in the rest of the snapshot first, or a later lookup
+            // would find the removed pref there again.
+            if (pref_MaterializeSnapshot()) {
+                pref = pref_HashTableLookup(pref_name);
+            }
             gHashTable->RemoveEntry(pref);
         }
+        gPrefGeneration++;
 
         pref_DoCallback(pref_name);
         MakeDirtyCallback();
@@ -643,6 +666,9 @@ PREF_ClearAllUserPrefs()
     if (!gHashTable)
         return NS_ERROR_NOT_INITIALIZED;
 
+    pref_MaterializeSnapshot();
+    gPrefGeneration++;
+
     std::vector<std::string> prefStrings;
     for (auto iter = gHashTable->Iter(); !iter.Done(); iter.Next()) {
         auto pref = static_cast<PrefHashEntry*>(iter.Get());
@@ -674,6 +700,7 @@ nsresult PREF_LockPref(const char *key, bool lockit)
     if (!pref)
         return NS_ERROR_UNEXPECTED;
 
+    gPrefGeneration++;
     if (lockit) {
         if (!pref->prefFlags.IsLocked()) {
             pref->prefFlags.SetLocked(true);
@@ -737,13 +764,292 @@ static PrefTypeFlags pref_SetValue(PrefValue* existingValue, PrefTypeFlags flags
     return flags;
 }
 
+/*
+ * Preference snapshots
+ *
+ * The image is a PrefSnapshotHeader, |count| PrefSnapshotEntry records
+ * sorted by name, and then a pool of NUL-terminated strings that the
+ * entries refer to by their offset from the start of the image.
+ */
+#define PREF_SNAPSHOT_MAGIC 0x50524546 // 'PREF'
+
+struct PrefSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t count;
+};
+
+struct PrefSnapshotEntry
+{
+    enum {
+        HAS_DEFAULT = 1,
+        HAS_USER_VALUE = 2,
+        STICKY_DEFAULT = 4,
+    };
+
+    uint32_t key;           // offset of the name
+    uint16_t type;          // PrefType
+    uint16_t flags;
+    uint32_t defaultPref;   // int or bool value, or offset of the string
+    uint32_t userPref;
+};
+
+static const PrefSnapshotEntry*
+pref_SnapshotEntries()
+{
+    return reinterpret_cast<const PrefSnapshotEntry*>(
+        gSnapshotData + sizeof(PrefSnapshotHeader));
+}
+
+static uint32_t
+pref_SnapshotCount()
+{
+    return reinterpret_cast<const PrefSnapshotHeader*>(gSnapshotData)->count;
+}
+
+static const PrefSnapshotEntry*
+pref_SnapshotSearch(const char *key)
+{
+    const PrefSnapshotEntry* entries = pref_SnapshotEntries();
+    size_t low = 0;
+    size_t high = pref_SnapshotCount();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int cmp = strcmp(gSnapshotData + entries[mid].key, key);
+        if (cmp == 0) {
+            return &entries[mid];
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+static PrefValue
+pref_SnapshotValue(PrefType type, uint32_t value)
+{
+    PrefValue result;
+    switch (type) {
+      case PrefType::String:
+        result.stringVal = const_cast<char*>(gSnapshotData + value);
+        break;
+      case PrefType::Int:
+        result.intVal = static_cast<int32_t>(value);
+        break;
+      default:
+        result.boolVal = !!value;
+        break;
+    }
+    return result;
+}
+
+static PrefHashEntry*
+pref_CopyFromSnapshot(const PrefSnapshotEntry* aEntry)
+{
+    const char* key = gSnapshotData + aEntry->key;
+    auto pref = static_cast<PrefHashEntry*>(gHashTable->Add(key, fallible));
+    if (!pref)
+        return nullptr;
+
+    // already in the overlay, which always wins
+    if (pref->key)
+        return pref;
+
+    PrefType type = static_cast<PrefType>(aEntry->type);
+    pref->prefFlags.Reset().SetPrefType(type);
+    pref->key = ArenaStrDup(key, &gPrefNameArena);
+    memset(&pref->defaultPref, 0, sizeof(pref->defaultPref));
+    memset(&pref->userPref, 0, sizeof(pref->userPref));
+
+    if (aEntry->flags & PrefSnapshotEntry::HAS_DEFAULT) {
+        pref->prefFlags =
+            pref_SetValue(&pref->defaultPref, pref->prefFlags,
+                          pref_SnapshotValue(type, aEntry->defaultPref),
+                          type).SetHasDefault(true);
+        if (aEntry->flags & PrefSnapshotEntry::STICKY_DEFAULT) {
+            pref->prefFlags.SetHasStickyDefault(true);
+        }
+    }
+    if (aEntry->flags & PrefSnapshotEntry::HAS_USER_VALUE) {
+        pref->prefFlags =
+            pref_SetValue(&pref->userPref, pref->prefFlags,
+                          pref_SnapshotValue(type, aEntry->userPref),
+                          type).SetHasUserValue(true);
+    }
+    return pref;
+}
+
+static int
+pref_CompareEntryKeys(const void *v1, const void *v2, void *unused)
+{
+    auto e1 = *static_cast<PrefHashEntry* const*>(v1);
+    auto e2 = *static_cast<PrefHashEntry* const*>(v2);
+    return strcmp(e1->key, e2->key);
+}
+
+static uint32_t
+pref_AppendSnapshotValue(PrefType type, const PrefValue& value,
+                         uint32_t poolStart, nsACString& pool)
+{
+    switch (type) {
+      case PrefType::String: {
+        uint32_t offset = poolStart + pool.Length();
+        pool.Append(value.stringVal);
+        pool.Append('\0');
+        return offset;
+      }
+      case PrefType::Int:
+        return static_cast<uint32_t>(value.intVal);
+      default:
+        return value.boolVal ? 1 : 0;
+    }
+}
+
+void
+pref_BuildSnapshot(nsTArray<uint8_t>* aImage)
+{
+    MOZ_ASSERT(gHashTable && !gSnapshotData);
+
+    nsTArray<PrefHashEntry*> prefs(gHashTable->EntryCount());
+    for (auto iter = gHashTable->Iter(); !iter.Done(); iter.Next()) {
+        auto pref = static_cast<PrefHashEntry*>(iter.Get());
+        if (pref->prefFlags.IsTypeValid() &&
+            (pref->prefFlags.HasDefault() || pref->prefFlags.HasUserValue())) {
+            prefs.AppendElement(pref);
+        }
+    }
+    NS_QuickSort(prefs.Elements(), prefs.Length(), sizeof(PrefHashEntry*),
+                 pref_CompareEntryKeys, nullptr);
+
+    uint32_t poolStart = sizeof(PrefSnapshotHeader) +
+                         prefs.Length() * sizeof(PrefSnapshotEntry);
+    nsTArray<PrefSnapshotEntry> entries(prefs.Length());
+    nsAutoCString pool;
+    for (PrefHashEntry* pref : prefs) {
+        PrefType type = pref->prefFlags.GetPrefType();
+        PrefSnapshotEntry* entry = entries.AppendElement();
+        entry->key = poolStart + pool.Length();
+        pool.Append(pref->key);
+        pool.Append('\0');
+        entry->type = static_cast<uint16_t>(type);
+        entry->flags = 0;
+        entry->defaultPref = 0;
+        entry->userPref = 0;
+        if (pref->prefFlags.HasDefault()) {
+            entry->flags |= PrefSnapshotEntry::HAS_DEFAULT;
+            if (pref->prefFlags.HasStickyDefault()) {
+                entry->flags |= PrefSnapshotEntry::STICKY_DEFAULT;
+            }
+            entry->defaultPref =
+                pref_AppendSnapshotValue(type, pref->defaultPref, poolStart, pool);
+        }
+        if (pref->prefFlags.HasUserValue()) {
+            entry->flags |= PrefSnapshotEntry::HAS_USER_VALUE;
+            entry->userPref =
+                pref_AppendSnapshotValue(type, pref->userPref, poolStart, pool);
+        }
+    }
+
+    PrefSnapshotHeader header = { PREF_SNAPSHOT_MAGIC,
+                                  static_cast<uint32_t>(entries.Length()) };
+    aImage->SetCapacity(poolStart + pool.Length());
+    aImage->AppendElements(reinterpret_cast<const uint8_t*>(&header),
+                           sizeof(header));
+    aImage->AppendElements(reinterpret_cast<const uint8_t*>(entries.Elements()),
+                           entries.Length() * sizeof(PrefSnapshotEntry));
+    aImage->AppendElements(reinterpret_cast<const uint8_t*>(pool.get()),
+                           pool.Length());
+}
+
+bool
+pref_SetSnapshot(mozilla::ipc::SharedMemoryBasic* aShmem, uint32_t aSize)
+{
+    MOZ_ASSERT(!gSnapshotData);
+
+    const char* data = static_cast<const char*>(aShmem->memory());
+    if (aSize < sizeof(PrefSnapshotHeader))
+        return false;
+
+    auto header = reinterpret_cast<const PrefSnapshotHeader*>(data);
+    if (header->magic != PREF_SNAPSHOT_MAGIC ||
+        header->count > (aSize - sizeof(PrefSnapshotHeader)) /
+                        sizeof(PrefSnapshotEntry)) {
+        return false;
+    }
+    uint32_t poolStart = sizeof(PrefSnapshotHeader) +
+                         header->count * sizeof(PrefSnapshotEntry);
+    if (header->count && (poolStart == aSize || data[aSize - 1] != '\0')) {
+        return false;
+    }
+
+    // Every string must start inside the pool; the pool ends with a NUL,
+    // so none of them can run past the end of the image.
+    auto entries = reinterpret_cast<const PrefSnapshotEntry*>(
+        data + sizeof(PrefSnapshotHeader));
+    for (uint32_t i = 0; i < header->count; ++i) {
+        const PrefSnapshotEntry& entry = entries[i];
+        PrefType type = static_cast<PrefType>(entry.type);
+        if (type != PrefType::String && type != PrefType::Int &&
+            type != PrefType::Bool) {
+            return false;
+        }
+        if (entry.key < poolStart || entry.key >= aSize) {
+            return false;
+        }
+        if (type == PrefType::String &&
+            (((entry.flags & PrefSnapshotEntry::HAS_DEFAULT) &&
+              (entry.defaultPref < poolStart || entry.defaultPref >= aSize)) ||
+             ((entry.flags & PrefSnapshotEntry::HAS_USER_VALUE) &&
+              (entry.userPref < poolStart || entry.userPref >= aSize)))) {
+            return false;
+        }
+    }
+
+    gSnapshotShmem = aShmem;
+    gSnapshotData = data;
+    return true;
+}
+
+bool
+pref_MaterializeSnapshot()
+{
+    if (!gSnapshotData)
+        return false;
+
+    const PrefSnapshotEntry* entries = pref_SnapshotEntries();
+    uint32_t count = pref_SnapshotCount();
+    for (uint32_t i = 0; i < count; ++i) {
+        pref_CopyFromSnapshot(&entries[i]);
+    }
+
+    gSnapshotShmem = nullptr;
+    gSnapshotData = nullptr;
+    return true;
+}
+
+uint32_t
+pref_GetGeneration()
+{
+    return gPrefGeneration;
+}
+
 PrefHashEntry* pref_HashTableLookup(const char *key)
 {
 #ifndef MOZ_B2G
     MOZ_ASSERT(NS_IsMainThread());
 #endif
 
-    return static_cast<PrefHashEntry*>(gHashTable->Search(key));
+    auto pref = static_cast<PrefHashEntry*>(gHashTable->Search(key));
+    if (!pref && gSnapshotData) {
+        const PrefSnapshotEntry* entry = pref_SnapshotSearch(key);
+        if (entry) {
+            pref = pref_CopyFromSnapshot(entry);
+        }
+    }
+    return pref;
 }
 
 nsresult pref_HashPref(const char *key, PrefValue value, PrefType type, uint32_t flags)
@@ -755,6 +1061,11 @@ nsresult pref_HashPref(const char *key, PrefValue value, PrefType type, uint32_t
     if (!gHashTable)
         return NS_ERROR_OUT_OF_MEMORY;
 
+    // Pick up the parent's values before changing them.
+    if (gSnapshotData) {
+        pref_HashTableLookup(key);
+    }
+
     auto pref = static_cast<PrefHashEntry*>(gHashTable->Add(key, fallible));
     if (!pref)
         return NS_ERROR_OUT_OF_MEMORY;
@@ -772,6 +1083,8 @@ nsresult pref_HashPref(const char *key, PrefValue value, PrefType type, uint32_t
         return NS_ERROR_UNEXPECTED;
     }
 
+    gPrefGeneration++;
+
     bool valueChanged = false;
     if (flags & kPrefSetDefault) {
         if (!pref->prefFlags.IsLocked()) {
@@ -10,6 +10,7 @@
 
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/UniquePtr.h"
+#include "nsTArray.h"
 
 extern PLDHashTable* gHashTable;
 
@@ -17,6 +18,9 @@ namespace mozilla {
 namespace dom {
 class PrefSetting;
 } // namespace dom
+namespace ipc {
+class SharedMemoryBasic;
+} // namespace ipc
 } // namespace mozilla
 
 mozilla::UniquePtr<char*[]>
@@ -34,6 +38,25 @@ pref_EntryHasAdvisablySizedValues(PrefHashEntry* aHashEntry);
 void pref_GetPrefFromEntry(PrefHashEntry *aHashEntry,
                            mozilla::dom::PrefSetting* aPref);
 
+// Serializes every preference into the read-only image that content
+// processes map at startup.
+void
+pref_BuildSnapshot(nsTArray<uint8_t>* aImage);
+
+// Makes the mapped image the fallback for lookups that miss gHashTable.
+// Returns false, and leaves the table alone, if the image is malformed.
+bool
+pref_SetSnapshot(mozilla::ipc::SharedMemoryBasic* aShmem, uint32_t aSize);
+
+// Copies what is left of the image into gHashTable and unmaps it, for code
+// that enumerates or removes entries.  Returns false if there was no image.
+bool
+pref_MaterializeSnapshot();
+
+// Changes whenever gHashTable does.
+uint32_t
+pref_GetGeneration();
+
 size_t
 pref_SizeOfPrivateData(mozilla::MallocSizeOf aMallocSizeOf);
 
@@ -24,6 +24,7 @@ struct SocketInfo
 struct HalfOpenSockets
 {
     bool speculative;
+    bool fromPredictor;
 };
 
 struct DNSCacheEntries
@@ -52,6 +53,8 @@ struct HttpRetParams
     nsTArray<HttpConnInfo>   idle;
     nsTArray<HalfOpenSockets> halfOpens;
     uint32_t  counter;
+    uint32_t  preconnectsUsed;
+    uint32_t  preconnectsUnused;
     uint16_t  port;
     bool      spdy;
     bool      ssl;
@@ -0,0 +1,409 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim:set ts=2 sw=2 sts=2 et cindent: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "nsSocketTransportService2.h"
+#include "NativePoller.h"
+#include "mozilla/Assertions.h"
+#include "mozilla/Logging.h"
+#include "prerror.h"
+#include "prio.h"
+#include "private/pprio.h"
+
+#include <algorithm>
+
+#if defined(NATIVE_POLLER_EPOLL) || defined(NATIVE_POLLER_KQUEUE)
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+namespace mozilla {
+namespace net {
+
+// These mirror NSPR's private _PR_POLL_*_SYS_* flags: they record whether
+// the PR_POLL_READ/PR_POLL_WRITE interest of the top layer was mapped to a
+// read or a write on the bottom socket by the layer's poll method.
+static const int16_t kReadSysRead   = 0x1;
+static const int16_t kReadSysWrite  = 0x2;
+static const int16_t kWriteSysRead  = 0x4;
+static const int16_t kWriteSysWrite = 0x8;
+
+// Events registered with and reported by the kernel.
+static const int16_t kSysRead   = 0x1;
+static const int16_t kSysWrite  = 0x2;
+static const int16_t kSysExcept = 0x4;
+static const int16_t kSysError  = 0x8;
+static const int16_t kSysHangup = 0x10;
+
+static int16_t
+TranslateEvents(int16_t aSysMap, int16_t aEvents)
+{
+  int16_t outFlags = 0;
+  if (aEvents & kSysRead) {
+    if (aSysMap & kReadSysRead) {
+      outFlags |= PR_POLL_READ;
+    }
+    if (aSysMap & kWriteSysRead) {
+      outFlags |= PR_POLL_WRITE;
+    }
+  }
+  if (aEvents & kSysWrite) {
+    if (aSysMap & kReadSysWrite) {
+      outFlags |= PR_POLL_READ;
+    }
+    if (aSysMap & kWriteSysWrite) {
+      outFlags |= PR_POLL_WRITE;
+    }
+  }
+  if (aEvents & kSysExcept) {
+    outFlags |= PR_POLL_EXCEPT;
+  }
+  if (aEvents & kSysError) {
+    outFlags |= PR_POLL_ERR;
+  }
+  if (aEvents & kSysHangup) {
+    outFlags |= PR_POLL_HUP;
+  }
+  return outFlags;
+}
+
+NativePoller::NativePoller()
+  : mPollFD(-1)
+  , mRound(0)
+{
+  MOZ_ASSERT(PR_GetCurrentThread() == gSocketThread);
+
+#if defined(NATIVE_POLLER_EPOLL)
+  mPollFD = epoll_create1(EPOLL_CLOEXEC);
+#elif defined(NATIVE_POLLER_KQUEUE)
+  mPollFD = kqueue();
+#endif
+
+  SOCKET_LOG(("NativePoller::NativePoller [this=%p fd=%d]\n", this, mPollFD));
+}
+
+NativePoller::~NativePoller()
+{
+#if defined(NATIVE_POLLER_EPOLL) || defined(NATIVE_POLLER_KQUEUE)
+  if (mPollFD >= 0) {
+    close(mPollFD);
+  }
+#endif
+}
+
+bool
+NativePoller::Register(int32_t aOsfd, Registration *aReg, int16_t aEvents)
+{
+#if defined(NATIVE_POLLER_EPOLL)
+  struct epoll_event ev;
+  ev.events = 0;
+  if (aEvents & kSysRead) {
+    ev.events |= EPOLLIN;
+  }
+  if (aEvents & kSysWrite) {
+    ev.events |= EPOLLOUT;
+  }
+  if (aEvents & kSysExcept) {
+    ev.events |= EPOLLPRI;
+  }
+  ev.data.u64 = 0;
+  ev.data.fd = aOsfd;
+
+  // A registration we believe in may have been dropped by the kernel when
+  // the descriptor was closed, and one we do not know about may still be
+  // there if the descriptor number was reused; retry with the other op.
+  int op = aReg->mEvents >= 0 ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  int rv = epoll_ctl(mPollFD, op, aOsfd, &ev);
+  if (rv < 0 && op == EPOLL_CTL_MOD && errno == ENOENT) {
+    rv = epoll_ctl(mPollFD, EPOLL_CTL_ADD, aOsfd, &ev);
+  } else if (rv < 0 && op == EPOLL_CTL_ADD && errno == EEXIST) {
+    rv = epoll_ctl(mPollFD, EPOLL_CTL_MOD, aOsfd, &ev);
+  }
+  if (rv < 0) {
+    SOCKET_LOG(("  epoll_ctl failed [fd=%d errno=%d]\n", aOsfd, errno));
+    return false;
+  }
+#elif defined(NATIVE_POLLER_KQUEUE)
+  // kqueue has no counterpart of POLLPRI; like poll() on a socket, read
+  // readiness covers out-of-band data there.
+  int16_t registered = aReg->mEvents >= 0 ? aReg->mEvents : 0;
+  bool unknown = aReg->mEvents < 0;
+  static const struct {
+    int16_t mEvent;
+    int16_t mFilter;
+  } kFilters[] = { { kSysRead, EVFILT_READ }, { kSysWrite, EVFILT_WRITE } };
+
+  for (const auto& filter : kFilters) {
+    bool want = aEvents & filter.mEvent;
+    bool have = registered & filter.mEvent;
+    if (want == have && !(unknown && !want)) {
+      continue;
+    }
+    struct kevent change;
+    EV_SET(&change, aOsfd, filter.mFilter, want ? EV_ADD : EV_DELETE,
+           0, 0, nullptr);
+    if (kevent(mPollFD, &change, 1, nullptr, 0, nullptr) < 0 &&
+        (want || errno != ENOENT)) {
+      SOCKET_LOG(("  kevent failed [fd=%d errno=%d]\n", aOsfd, errno));
+      return false;
+    }
+  }
+#else
+  MOZ_CRASH("NativePoller used without a backend");
+#endif
+
+  aReg->mEvents = aEvents;
+  return true;
+}
+
+void
+NativePoller::Unregister(int32_t aOsfd, Registration *aReg)
+{
+  // Errors are expected here when the descriptor is already closed, in
+  // which case the kernel has dropped the registration on its own.
+#if defined(NATIVE_POLLER_EPOLL)
+  struct epoll_event ev;
+  epoll_ctl(mPollFD, EPOLL_CTL_DEL, aOsfd, &ev);
+#elif defined(NATIVE_POLLER_KQUEUE)
+  if (aReg->mEvents < 0 || (aReg->mEvents & kSysRead)) {
+    struct kevent change;
+    EV_SET(&change, aOsfd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+    kevent(mPollFD, &change, 1, nullptr, 0, nullptr);
+  }
+  if (aReg->mEvents < 0 || (aReg->mEvents & kSysWrite)) {
+    struct kevent change;
+    EV_SET(&change, aOsfd, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+    kevent(mPollFD, &change, 1, nullptr, 0, nullptr);
+  }
+#endif
+}
+
+void
+NativePoller::Remove(PRFileDesc *aFD)
+{
+  MOZ_ASSERT(PR_GetCurrentThread() == gSocketThread);
+
+  if (!aFD) {
+    return;
+  }
+
+  PROsfd osfd = PR_FileDesc2NativeHandle(aFD);
+  if (osfd < 0) {
+    return;
+  }
+
+  Registration *reg = mRegistrations.Get(osfd);
+  if (reg && reg->mFD == aFD) {
+    Unregister(osfd, reg);
+    mRegistrations.Remove(osfd);
+  }
+}
+
+int32_t
+NativePoller::Poll(PRPollDesc *aPollList, uint32_t aCount,
+                   PRIntervalTime aTimeout)
+{
+  MOZ_ASSERT(PR_GetCurrentThread() == gSocketThread);
+  MOZ_ASSERT(Valid());
+
+  ++mRound;
+  int32_t ready = 0;
+  uint32_t registered = 0;
+
+  for (uint32_t i = 0; i < aCount; ++i) {
+    PRPollDesc &desc = aPollList[i];
+    desc.out_flags = 0;
+
+    if (!desc.fd || !desc.in_flags) {
+      continue;
+    }
+
+    // Let the layers report data they have buffered, exactly as PR_Poll
+    // does.
+    int16_t inFlagsRead = 0, inFlagsWrite = 0;
+    int16_t outFlagsRead = 0, outFlagsWrite = 0;
+    if (desc.in_flags & PR_POLL_READ) {
+      inFlagsRead = (desc.fd->methods->poll)(
+        desc.fd, desc.in_flags & ~PR_POLL_WRITE, &outFlagsRead);
+    }
+    if (desc.in_flags & PR_POLL_WRITE) {
+      inFlagsWrite = (desc.fd->methods->poll)(
+        desc.fd, desc.in_flags & ~PR_POLL_READ, &outFlagsWrite);
+    }
+    if ((inFlagsRead & outFlagsRead) || (inFlagsWrite & outFlagsWrite)) {
+      desc.out_flags = outFlagsRead | outFlagsWrite;
+      ++ready;
+      continue;
+    }
+
+    // Once something is ready we return without waiting, so there is no
+    // point in touching the kernel registrations.
+    if (ready) {
+      continue;
+    }
+
+    PROsfd osfd = PR_FileDesc2NativeHandle(desc.fd);
+    if (osfd < 0) {
+      desc.out_flags = PR_POLL_NVAL;
+      ++ready;
+      continue;
+    }
+
+    int16_t sysMap = 0;
+    int16_t events = 0;
+    if (inFlagsRead & PR_POLL_READ) {
+      sysMap |= kReadSysRead;
+      events |= kSysRead;
+    }
+    if (inFlagsRead & PR_POLL_WRITE) {
+      sysMap |= kReadSysWrite;
+      events |= kSysWrite;
+    }
+    if (inFlagsWrite & PR_POLL_READ) {
+      sysMap |= kWriteSysRead;
+      events |= kSysRead;
+    }
+    if (inFlagsWrite & PR_POLL_WRITE) {
+      sysMap |= kWriteSysWrite;
+      events |= kSysWrite;
+    }
+    if (desc.in_flags & PR_POLL_EXCEPT) {
+      events |= kSysExcept;
+    }
+
+    Registration *reg = mRegistrations.LookupOrAdd(osfd);
+    if (reg->mFD != desc.fd) {
+      // New socket, or a new socket reusing the descriptor number of one
+      // that was not removed; we cannot trust what the kernel holds.
+      reg->mFD = desc.fd;
+      reg->mEvents = -1;
+    }
+    if (reg->mEvents != events && !Register(osfd, reg, events)) {
+      mRegistrations.Remove(osfd);
+      desc.out_flags = PR_POLL_NVAL;
+      ++ready;
+      continue;
+    }
+    reg->mIndex = i;
+    reg->mRound = mRound;
+    reg->mSysMap = sysMap;
+    ++registered;
+  }
+
+  if (ready) {
+    return ready;
+  }
+
+  // Drop registrations of sockets that left the poll list without being
+  // removed, so the kernel does not keep waking us up for them.
+  if (mRegistrations.Count() > registered) {
+    for (auto iter = mRegistrations.Iter(); !iter.Done(); iter.Next()) {
+      Registration *reg = iter.UserData();
+      if (reg->mRound != mRound) {
+        Unregister(iter.Key(), reg);
+        iter.Remove();
+      }
+    }
+  }
+
+  return Wait(aPollList, aTimeout);
+}
+
+int32_t
+NativePoller::Wait(PRPollDesc *aPollList, PRIntervalTime aTimeout)
+{
+#if defined(NATIVE_POLLER_EPOLL) || defined(NATIVE_POLLER_KQUEUE)
+  // kqueue reports reading and writing as separate events.
+  uint32_t maxEvents = std::max(mRegistrations.Count(), 1u);
+#if defined(NATIVE_POLLER_KQUEUE)
+  maxEvents *= 2;
+#endif
+  mEvents.SetLength(maxEvents);
+
+#if defined(NATIVE_POLLER_EPOLL)
+  int msecs = -1;
+  if (aTimeout != PR_INTERVAL_NO_TIMEOUT) {
+    msecs = PR_IntervalToMilliseconds(aTimeout);
+  }
+  int n = epoll_wait(mPollFD, mEvents.Elements(), maxEvents, msecs);
+#else
+  struct timespec ts;
+  struct timespec *tsp = nullptr;
+  if (aTimeout != PR_INTERVAL_NO_TIMEOUT) {
+    uint32_t usecs = PR_IntervalToMicroseconds(aTimeout);
+    ts.tv_sec = usecs / PR_USEC_PER_SEC;
+    ts.tv_nsec = (usecs % PR_USEC_PER_SEC) * PR_NSEC_PER_USEC;
+    tsp = &ts;
+  }
+  int n = kevent(mPollFD, nullptr, 0, mEvents.Elements(), maxEvents, tsp);
+#endif
+
+  if (n < 0) {
+    if (errno == EINTR) {
+      // The caller treats this as a timeout and polls again.
+      return 0;
+    }
+    PR_SetError(PR_UNKNOWN_ERROR, errno);
+    return -1;
+  }
+
+  int32_t ready = 0;
+  for (int i = 0; i < n; ++i) {
+    int16_t events = 0;
+#if defined(NATIVE_POLLER_EPOLL)
+    const struct epoll_event &ev = mEvents[i];
+    int32_t osfd = ev.data.fd;
+    if (ev.events & EPOLLIN) {
+      events |= kSysRead;
+    }
+    if (ev.events & EPOLLOUT) {
+      events |= kSysWrite;
+    }
+    if (ev.events & EPOLLPRI) {
+      events |= kSysExcept;
+    }
+    if (ev.events & EPOLLERR) {
+      events |= kSysError;
+    }
+    if (ev.events & EPOLLHUP) {
+      events |= kSysHangup;
+    }
+#else
+    const struct kevent &ev = mEvents[i];
+    int32_t osfd = static_cast<int32_t>(ev.ident);
+    if (ev.flags & EV_ERROR) {
+      events |= kSysError;
+    } else {
+      events |= ev.filter == EVFILT_WRITE ? kSysWrite : kSysRead;
+      if ((ev.flags & EV_EOF) && ev.fflags) {
+        events |= kSysError;
+      }
+    }
+#endif
+
+    // Events for descriptors that are not part of this round's poll list
+    // are stale; drop them.
+    Registration *reg = mRegistrations.Get(osfd);
+    if (!reg || reg->mRound != mRound) {
+      continue;
+    }
+
+    PRPollDesc &desc = aPollList[reg->mIndex];
+    int16_t outFlags = TranslateEvents(reg->mSysMap, events);
+    if (outFlags && !desc.out_flags) {
+      ++ready;
+    }
+    desc.out_flags |= outFlags;
+  }
+
+  return ready;
+#else
+  MOZ_CRASH("NativePoller used without a backend");
+  return -1;
+#endif
+}
+
+} // namespace net
+} // namespace mozilla
@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim:set ts=2 sw=2 sts=2 et cindent: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NativePoller_h__
+#define NativePoller_h__
+
+#include "nsClassHashtable.h"
+#include "nsHashKeys.h"
+#include "nsTArray.h"
+#include "prio.h"
+
+#if defined(XP_LINUX)
+#define NATIVE_POLLER_EPOLL 1
+#include <sys/epoll.h>
+#elif defined(XP_DARWIN) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+      defined(__OpenBSD__) || defined(__DragonFly__)
+#define NATIVE_POLLER_KQUEUE 1
+#include <sys/types.h>
+#include <sys/event.h>
+#endif
+
+namespace mozilla {
+namespace net {
+
+// A drop-in replacement for PR_Poll that keeps the sockets registered with
+// the kernel (epoll on Linux, kqueue on macOS and the BSDs) between calls,
+// so a wait costs O(ready) rather than O(registered) in the kernel.  The
+// kernel registration of a socket is only touched when the events it is
+// polled for change.
+//
+// The caller passes the full poll list on every call, exactly as it would
+// to PR_Poll; layered (e.g. SSL) poll methods are still consulted for each
+// entry so buffered data is reported without waiting.  Sockets must be
+// removed with Remove() before their file descriptor is closed.
+//
+// socket thread only
+class NativePoller
+{
+public:
+  NativePoller();
+  ~NativePoller();
+
+  bool Valid() { return mPollFD >= 0; }
+
+  // Same contract as PR_Poll.
+  int32_t Poll(PRPollDesc *aPollList, uint32_t aCount, PRIntervalTime aTimeout);
+
+  // Drops the kernel registration of aFD, if any.
+  void Remove(PRFileDesc *aFD);
+
+private:
+  struct Registration
+  {
+    PRFileDesc *mFD;
+    uint32_t    mIndex;   // index into the poll list of the current round
+    uint32_t    mRound;   // round mIndex was set in
+    int16_t     mEvents;  // POLLIN/POLLOUT/POLLPRI registered with the kernel
+    int16_t     mSysMap;  // _PR_POLL_*_SYS_* mapping of the current round
+  };
+
+  bool Register(int32_t aOsfd, Registration *aReg, int16_t aEvents);
+  void Unregister(int32_t aOsfd, Registration *aReg);
+  int32_t Wait(PRPollDesc *aPollList, PRIntervalTime aTimeout);
+
+  int32_t  mPollFD;
+  uint32_t mRound;
+  nsClassHashtable<nsUint32HashKey, Registration> mRegistrations;
+
+#if defined(NATIVE_POLLER_EPOLL)
+  nsTArray<struct epoll_event> mEvents;
+#elif defined(NATIVE_POLLER_KQUEUE)
+  nsTArray<struct kevent> mEvents;
+#endif
+};
+
+} // namespace net
+} // namespace mozilla
+
+#endif
@@ -351,6 +351,7 @@ Predictor::Predictor()
   ,mMaxResourcesPerEntry(PREDICTOR_MAX_RESOURCES_DEFAULT)
   ,mStartupCount(1)
   ,mMaxURILength(PREDICTOR_MAX_URI_LENGTH_DEFAULT)
+  ,mExpectedConnections(1)
   ,mDoingTests(false)
 {
   MOZ_ASSERT(!sSelf, "multiple Predictor instances!");
@@ -523,6 +524,13 @@ Predictor::GetAllow1918(bool *allow1918)
   return NS_OK;
 }
 
+NS_IMETHODIMP
+Predictor::GetExpectedConnections(uint32_t *expectedConnections)
+{
+  *expectedConnections = mExpectedConnections;
+  return NS_OK;
+}
+
 // Predictor::nsIInterfaceRequestor
 
 NS_IMETHODIMP
@@ -1354,19 +1362,43 @@ Predictor::RunPredictions(nsIURI *referrer, nsINetworkPredictorVerifier *verifie
     }
   }
 
+  // Group the preconnects by origin: each origin gets one speculative
+  // connect, sized by how many of its subresources we expect to load, and
+  // the connection manager decides how many connections that really needs.
+  nsTArray<nsCString> originKeys;
+  nsTArray<nsCOMPtr<nsIURI>> originURIs;
+  nsTArray<uint32_t> originDemand;
   len = preconnects.Length();
   for (i = 0; i < len; ++i) {
-    PREDICTOR_LOG(("    doing preconnect"));
     nsCOMPtr<nsIURI> uri = preconnects[i];
     ++totalPredictions;
     ++totalPreconnects;
-    mSpeculativeService->SpeculativeConnect(uri, this);
     predicted = true;
     if (verifier) {
       PREDICTOR_LOG(("    sending preconnect verification"));
       verifier->OnPredictPreconnect(uri);
     }
+
+    nsAutoCString prePath;
+    uri->GetPrePath(prePath);
+    size_t index = originKeys.IndexOf(prePath);
+    if (index == originKeys.NoIndex) {
+      originKeys.AppendElement(prePath);
+      originURIs.AppendElement(uri);
+      originDemand.AppendElement(1);
+    } else {
+      ++originDemand[index];
+    }
+  }
+
+  len = originURIs.Length();
+  for (i = 0; i < len; ++i) {
+    PREDICTOR_LOG(("    doing preconnect %s demand=%u",
+                   originKeys[i].get(), originDemand[i]));
+    mExpectedConnections = originDemand[i];
+    mSpeculativeService->SpeculativeConnect(originURIs[i], this);
   }
+  mExpectedConnections = 1;
 
   len = preresolves.Length();
   nsCOMPtr<nsIThread> mainThread = do_GetMainThread();
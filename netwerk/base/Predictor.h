@@ -469,6 +469,11 @@ private:
   nsTArray<nsCOMPtr<nsIURI>> mPreconnects;
   nsTArray<nsCOMPtr<nsIURI>> mPreresolves;
 
+  // Number of predicted subresources for the origin we are currently
+  // speculatively connecting to; handed to the connection manager through
+  // nsISpeculativeConnectionOverrider.
+  uint32_t mExpectedConnections;
+
   bool mDoingTests;
 
   static Predictor *sSelf;
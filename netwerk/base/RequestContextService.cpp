@@ -14,6 +14,8 @@
 #include "mozilla/Atomics.h"
 #include "mozilla/Services.h"
 
+#include "mozilla/net/NeckoChild.h"
+#include "mozilla/net/NeckoCommon.h"
 #include "mozilla/net/PSpdyPush.h"
 
 namespace mozilla {
@@ -35,12 +37,16 @@ private:
   Atomic<uint32_t>       mBlockingTransactionCount;
   nsAutoPtr<SpdyPushCache> mSpdyCache;
   nsCString mUserAgentOverride;
+  // Set on the main thread, read by the connection manager on the socket
+  // thread.
+  Atomic<bool>           mInBackground;
 };
 
 NS_IMPL_ISUPPORTS(RequestContext, nsIRequestContext)
 
 RequestContext::RequestContext(const nsID& aID)
   : mBlockingTransactionCount(0)
+  , mInBackground(false)
 {
   mID = aID;
   mID.ToProvidedString(mCID);
@@ -110,6 +116,32 @@ RequestContext::SetUserAgentOverride(const nsACString& aUserAgentOverride)
   return NS_OK;
 }
 
+NS_IMETHODIMP
+RequestContext::GetInBackground(bool *aInBackground)
+{
+  NS_ENSURE_ARG_POINTER(aInBackground);
+  *aInBackground = mInBackground;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+RequestContext::SetInBackground(bool aInBackground)
+{
+  if (mInBackground == aInBackground) {
+    return NS_OK;
+  }
+  mInBackground = aInBackground;
+
+  // The transactions run in the parent, which has its own context object
+  // for this ID.
+  if (IsNeckoChild() && gNeckoChild) {
+    MOZ_ASSERT(NS_IsMainThread());
+    gNeckoChild->SendSetRequestContextInBackground(nsDependentCString(mCID),
+                                                   aInBackground);
+  }
+  return NS_OK;
+}
+
 
 //nsIRequestContextService
 RequestContextService *RequestContextService::sSelf = nullptr;
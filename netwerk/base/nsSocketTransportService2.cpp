@@ -5,6 +5,7 @@
 
 #include "nsSocketTransportService2.h"
 #include "nsSocketTransport2.h"
+#include "NativePoller.h"
 #include "NetworkActivityMonitor.h"
 #include "mozilla/Preferences.h"
 #include "nsIOService.h"
@@ -53,6 +54,7 @@ Atomic<PRThread*, Relaxed> gSocketThread;
 #define MAX_TIME_BETWEEN_TWO_POLLS "network.sts.max_time_for_events_between_two_polls"
 #define TELEMETRY_PREF "toolkit.telemetry.enabled"
 #define MAX_TIME_FOR_PR_CLOSE_DURING_SHUTDOWN "network.sts.max_time_for_pr_close_during_shutdown"
+#define NATIVE_POLL_PREF "network.sts.native_poll"
 
 #define REPAIR_POLLABLE_EVENT_TIME 10
 
@@ -76,6 +78,7 @@ nsSocketTransportService::nsSocketTransportService()
     , mIdleCount(0)
     , mSentBytesCount(0)
     , mReceivedBytesCount(0)
+    , mNativePollerFailed(false)
     , mSendBufferSize(0)
     , mKeepaliveIdleTimeS(600)
     , mKeepaliveRetryIntervalS(1)
@@ -85,6 +88,7 @@ nsSocketTransportService::nsSocketTransportService()
     , mMaxTimePerPollIter(100)
     , mTelemetryEnabledPref(false)
     , mMaxTimeForPrClosePref(PR_SecondsToInterval(5))
+    , mNativePollPref(true)
     , mSleepPhase(false)
     , mProbedMaxCount(false)
 #if defined(XP_WIN)
@@ -236,6 +240,10 @@ nsSocketTransportService::DetachSocket(SocketContext *listHead, SocketContext *s
     MOZ_ASSERT((listHead == mActiveList) || (listHead == mIdleList),
                "DetachSocket invalid head");
 
+    // the handler may close the fd, so stop watching it first
+    if (mNativePoller && listHead == mActiveList)
+        mNativePoller->Remove(sock->mFD);
+
     // inform the handler that this socket is going away
     sock->mHandler->OnSocketDetached(sock->mFD);
     mSentBytesCount += sock->mHandler->ByteCountSent();
@@ -365,8 +373,11 @@ nsSocketTransportService::MoveToIdleList(SocketContext *sock)
     nsresult rv = AddToIdleList(sock);
     if (NS_FAILED(rv))
         DetachSocket(mActiveList, sock);
-    else
+    else {
+        if (mNativePoller)
+            mNativePoller->Remove(sock->mFD);
         RemoveFromPollList(sock);
+    }
 }
 
 void
@@ -451,6 +462,8 @@ nsSocketTransportService::Poll(uint32_t *interval,
     PRIntervalTime pollTimeout;
     *pollDuration = 0;
 
+    UpdateNativePoller();
+
     // If there are pending events for this thread then
     // DoPollIteration() should service the network without blocking.
     bool pendingEvents = false;
@@ -482,7 +495,11 @@ nsSocketTransportService::Poll(uint32_t *interval,
 
     SOCKET_LOG(("    timeout = %i milliseconds\n",
          PR_IntervalToMilliseconds(pollTimeout)));
-    int32_t rv = PR_Poll(pollList, pollCount, pollTimeout);
+    int32_t rv;
+    if (mNativePoller)
+        rv = mNativePoller->Poll(pollList, pollCount, pollTimeout);
+    else
+        rv = PR_Poll(pollList, pollCount, pollTimeout);
 
     PRIntervalTime passedInterval = PR_IntervalNow() - ts;
 
@@ -497,6 +514,32 @@ nsSocketTransportService::Poll(uint32_t *interval,
     return rv;
 }
 
+void
+nsSocketTransportService::UpdateNativePoller()
+{
+    MOZ_ASSERT(PR_GetCurrentThread() == gSocketThread, "wrong thread");
+
+    if (mNativePollPref == !!mNativePoller)
+        return;
+
+    if (mNativePoller) {
+        SOCKET_LOG(("  switching to PR_Poll\n"));
+        mNativePoller = nullptr;
+        return;
+    }
+
+    // don't keep retrying on platforms without a backend
+    if (mNativePollerFailed)
+        return;
+
+    mNativePoller = MakeUnique<NativePoller>();
+    if (!mNativePoller->Valid()) {
+        SOCKET_LOG(("  native poller unavailable, using PR_Poll\n"));
+        mNativePoller = nullptr;
+        mNativePollerFailed = true;
+    }
+}
+
 //-----------------------------------------------------------------------------
 // xpcom api
 
@@ -544,6 +587,7 @@ nsSocketTransportService::Init()
         tmpPrefService->AddObserver(MAX_TIME_BETWEEN_TWO_POLLS, this, false);
         tmpPrefService->AddObserver(TELEMETRY_PREF, this, false);
         tmpPrefService->AddObserver(MAX_TIME_FOR_PR_CLOSE_DURING_SHUTDOWN, this, false);
+        tmpPrefService->AddObserver(NATIVE_POLL_PREF, this, false);
     }
     UpdatePrefs();
 
@@ -994,6 +1038,7 @@ nsSocketTransportService::Run()
 
     // detach all sockets, including locals
     Reset(false);
+    mNativePoller = nullptr;
 
     // Final pass over the event queue. This makes sure that events posted by
     // socket detach handlers get processed.
@@ -1175,6 +1220,8 @@ nsSocketTransportService::DoPollIteration(TimeDuration *pollDuration)
                 // new pollable event.  If that fails, we fall back
                 // on "busy wait".
                 NS_WARNING("Trying to repair mPollableEvent");
+                if (mNativePoller)
+                    mNativePoller->Remove(mPollList[0].fd);
                 mPollableEvent.reset(new PollableEvent());
                 if (!mPollableEvent->Valid()) {
                     mPollableEvent = nullptr;
@@ -1271,6 +1318,13 @@ nsSocketTransportService::UpdatePrefs()
         if (NS_SUCCEEDED(rv) && maxTimeForPrClosePref >=0) {
             mMaxTimeForPrClosePref = PR_MillisecondsToInterval(maxTimeForPrClosePref);
         }
+
+        bool nativePollPref = false;
+        rv = tmpPrefService->GetBoolPref(NATIVE_POLL_PREF,
+                                         &nativePollPref);
+        if (NS_SUCCEEDED(rv)) {
+            mNativePollPref = nativePollPref;
+        }
     }
 
     return NS_OK;
@@ -33,6 +33,8 @@ class nsIPrefBranch;
 namespace mozilla {
 namespace net {
 
+class NativePoller;
+
 //
 // set MOZ_LOG=nsSocketTransport:5
 //
@@ -205,6 +207,13 @@ private:
 
     PRPollDesc *mPollList;                        /* mListSize + 1 entries */
 
+    // waits on mPollList with epoll/kqueue instead of PR_Poll when
+    // mNativePollPref is set and the platform has a backend.  sockets must
+    // be removed from it before their fd can be closed.
+    UniquePtr<NativePoller> mNativePoller;
+    bool                    mNativePollerFailed;
+    void                    UpdateNativePoller();
+
     PRIntervalTime PollTimeout();            // computes ideal poll timeout
     nsresult       DoPollIteration(TimeDuration *pollDuration);
                                              // perfoms a single poll iteration
@@ -238,6 +247,7 @@ private:
     Atomic<int32_t, Relaxed>        mMaxTimePerPollIter;
     Atomic<bool, Relaxed>           mTelemetryEnabledPref;
     Atomic<PRIntervalTime, Relaxed> mMaxTimeForPrClosePref;
+    Atomic<bool, Relaxed>           mNativePollPref;
 
     // Between a computer going to sleep and waking up the PR_*** telemetry
     // will be corrupted - so do not record it.
@@ -19,6 +19,7 @@
 #include "nsAutoPtr.h"
 #include "nsIURLParser.h"
 #include "nsNetCID.h"
+#include "mozilla/HashFunctions.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/ipc/URIUtils.h"
 #include <algorithm>
@@ -26,6 +27,7 @@
 #include "nsContentUtils.h"
 #include "prprf.h"
 #include "nsReadableUtils.h"
+#include "nsThreadUtils.h"
 
 using mozilla::dom::EncodingUtils;
 using namespace mozilla::ipc;
@@ -55,6 +57,24 @@ static LazyLogModule gStandardURLLog("nsStandardURL");
 
 //----------------------------------------------------------------------------
 
+// SetSpec remembers the result of parsing the last few specs seen on the main
+// thread, so that parsing the same URL again (image loads, link hovering,
+// history lookups) only costs a copy of the members.  Entries are keyed on
+// the filtered spec plus everything Init() sets up; only specs whose parse
+// cannot depend on IDN or ref-encoding prefs are stored, and the cache is
+// dropped whenever one of our own prefs changes.
+struct SpecCacheEntry
+{
+    nsCString             mSpec;
+    RefPtr<nsStandardURL> mURL;
+};
+
+static const uint32_t kSpecCacheSize = 64;
+static const uint32_t kSpecCacheMaxSpecLength = 2048;
+static SpecCacheEntry *gSpecCache = nullptr;
+
+//----------------------------------------------------------------------------
+
 #define ENSURE_MUTABLE() \
   PR_BEGIN_MACRO \
     if (!mMutable) { \
@@ -335,6 +355,7 @@ void
 nsStandardURL::ShutdownGlobalObjects()
 {
     NS_IF_RELEASE(gIDN);
+    ClearSpecCache();
 
 #ifdef DEBUG_DUMP_URLS_AT_SHUTDOWN
     if (gInitialized) {
@@ -1133,6 +1154,53 @@ nsStandardURL::PrefsChanged(nsIPrefBranch *prefs, const char *pref)
     }
 #undef PREF_CHANGED
 #undef GOT_PREF
+
+    // cached parse results may have been escaped under the old settings
+    ClearSpecCache();
+}
+
+bool
+nsStandardURL::CopyFromSpecCache(const nsACString &spec, uint32_t hash)
+{
+    if (!gSpecCache)
+        return false;
+
+    SpecCacheEntry &entry = gSpecCache[hash % kSpecCacheSize];
+    nsStandardURL *cached = entry.mURL;
+    if (!cached ||
+        cached->mURLType != mURLType ||
+        cached->mDefaultPort != mDefaultPort ||
+        cached->mSupportsFileURL != mSupportsFileURL ||
+        cached->mParser != mParser ||
+        !cached->mOriginCharset.Equals(mOriginCharset) ||
+        !entry.mSpec.Equals(spec)) {
+        return false;
+    }
+
+    Clear();
+    CopyMembers(cached, eHonorRef, EmptyCString());
+    return true;
+}
+
+void
+nsStandardURL::StoreInSpecCache(const nsACString &spec, uint32_t hash)
+{
+    if (!gSpecCache)
+        gSpecCache = new SpecCacheEntry[kSpecCacheSize];
+
+    RefPtr<nsStandardURL> url = new nsStandardURL(mSupportsFileURL, false);
+    url->CopyMembers(this, eHonorRef, EmptyCString());
+
+    SpecCacheEntry &entry = gSpecCache[hash % kSpecCacheSize];
+    entry.mSpec = spec;
+    entry.mURL = url.forget();
+}
+
+/* static */ void
+nsStandardURL::ClearSpecCache()
+{
+    delete [] gSpecCache;
+    gSpecCache = nullptr;
 }
 
 #define SHIFT_FROM(name, what)                    \
@@ -1442,6 +1510,26 @@ nsStandardURL::SetSpec(const nsACString &input)
         return NS_ERROR_MALFORMED_URI;
     }
 
+    // Hosts in ACE form and refs are normalized according to prefs we don't
+    // observe, and non-ASCII specs go through the charset encoders, so only
+    // cache plain ASCII specs without either.  Backslashes are rewritten in
+    // place below, which would change the key.
+    bool cacheable = NS_IsMainThread() &&
+                     filteredURI.Length() <= kSpecCacheMaxSpecLength &&
+                     IsASCII(filteredURI) &&
+                     filteredURI.FindChar('#') == kNotFound &&
+                     filteredURI.FindChar('\\') == kNotFound &&
+                     filteredURI.Find("xn--", true) == kNotFound;
+    uint32_t hash = 0;
+    if (cacheable) {
+        hash = AddToHash(HashString(filteredURI.get(), filteredURI.Length()),
+                         mURLType, mDefaultPort);
+        if (CopyFromSpecCache(filteredURI, hash)) {
+            LOG((" spec      = %s (cached)\n", mSpec.get()));
+            return NS_OK;
+        }
+    }
+
     // Make a backup of the curent URL
     nsStandardURL prevURL(false,false);
     prevURL.CopyMembers(this, eHonorRef, EmptyCString());
@@ -1489,6 +1577,10 @@ nsStandardURL::SetSpec(const nsACString &input)
         return rv;
     }
 
+    if (cacheable) {
+        StoreInSpecCache(filteredURI, hash);
+    }
+
     if (LOG_ENABLED()) {
         LOG((" spec      = %s\n", mSpec.get()));
         LOG((" port      = %d\n", mPort));
@@ -251,6 +251,11 @@ private:
 
     static void PrefsChanged(nsIPrefBranch *prefs, const char *pref);
 
+    // main thread cache of recently parsed specs, see SetSpec
+    bool CopyFromSpecCache(const nsACString &spec, uint32_t hash);
+    void StoreInSpecCache(const nsACString &spec, uint32_t hash);
+    static void ClearSpecCache();
+
     void FindHostLimit(nsACString::const_iterator& aStart,
                        nsACString::const_iterator& aEnd);
 
@@ -1297,6 +1297,10 @@ NS_IMETHODIMP CacheEntry::SetPredictedDataSize(int64_t aPredictedDataSize)
     return NS_ERROR_FILE_TOO_BIG;
   }
 
+  if (mFile) {
+    mFile->SetPredictedDataSize(mPredictedDataSize);
+  }
+
   return NS_OK;
 }
 
@@ -195,6 +195,7 @@ CacheFile::CacheFile()
   , mStatus(NS_OK)
   , mDataSize(-1)
   , mAltDataOffset(-1)
+  , mPredictedDataSize(-1)
   , mKill(false)
   , mOutput(nullptr)
 {
@@ -1410,6 +1411,11 @@ CacheFile::GetChunkLocked(uint32_t aIndex, ECallerType aCaller,
       chunk->InitNew();
       mMetadata->SetHash(aIndex, chunk->Hash());
 
+      if (mPredictedDataSize > off) {
+        chunk->SetExpectedDataSize(static_cast<uint32_t>(
+          std::min<int64_t>(mPredictedDataSize - off, kChunkSize)));
+      }
+
       if (HaveChunkListeners(aIndex)) {
         rv = NotifyChunkListeners(aIndex, NS_OK, chunk);
         NS_ENSURE_SUCCESS(rv, rv);
@@ -2082,6 +2088,13 @@ CacheFile::NotifyListenersAboutOutputRemoval()
   }
 }
 
+void
+CacheFile::SetPredictedDataSize(int64_t aSize)
+{
+  CacheFileAutoLock lock(this);
+  mPredictedDataSize = aSize;
+}
+
 bool
 CacheFile::DataSize(int64_t* aSize)
 {
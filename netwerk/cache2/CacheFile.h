@@ -92,6 +92,9 @@ public:
   nsresult   ThrowMemoryCachedData();
 
   nsresult GetAltDataSize(int64_t *aSize);
+  // Size of the data given by the consumer (e.g. from Content-Length), used to
+  // size buffers of new chunks.
+  void SetPredictedDataSize(int64_t aSize);
 
   // metadata forwarders
   nsresult GetElement(const char *aKey, char **_retval);
@@ -208,6 +211,7 @@ private:
                                  // contains size of the original data, i.e.
                                  // offset where alternative data starts.
                                  // Otherwise it is -1.
+  int64_t        mPredictedDataSize; // -1 when unknown
   nsCString      mKey;
 
   RefPtr<CacheFileHandle>      mHandle;
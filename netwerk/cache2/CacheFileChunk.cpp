@@ -11,8 +11,6 @@
 namespace mozilla {
 namespace net {
 
-#define kMinBufSize        512
-
 CacheFileChunkBuffer::CacheFileChunkBuffer(CacheFileChunk *aChunk)
   : mChunk(aChunk)
   , mBuf(nullptr)
@@ -26,7 +24,7 @@ CacheFileChunkBuffer::CacheFileChunkBuffer(CacheFileChunk *aChunk)
 CacheFileChunkBuffer::~CacheFileChunkBuffer()
 {
   if (mBuf) {
-    CacheFileUtils::FreeBuffer(mBuf);
+    CacheStorageService::RecycleChunkBuffer(mBuf, mBufSize);
     mBuf = nullptr;
     mChunk->BuffersAllocationChanged(mBufSize, 0);
     mBufSize = 0;
@@ -102,11 +100,16 @@ CacheFileChunkBuffer::EnsureBufSize(uint32_t aBufSize)
     return NS_ERROR_OUT_OF_MEMORY;
   }
 
-  char *newBuf = static_cast<char *>(realloc(mBuf, aBufSize));
+  char *newBuf = CacheStorageService::AllocChunkBuffer(aBufSize);
   if (!newBuf) {
     return NS_ERROR_OUT_OF_MEMORY;
   }
 
+  if (mBuf) {
+    memcpy(newBuf, mBuf, mBufSize);
+    CacheStorageService::RecycleChunkBuffer(mBuf, mBufSize);
+  }
+
   mChunk->BuffersAllocationChanged(mBufSize, aBufSize);
   mBuf = newBuf;
   mBufSize = aBufSize;
@@ -332,6 +335,7 @@ CacheFileChunk::CacheFileChunk(CacheFile *aFile, uint32_t aIndex,
   , mIsDirty(false)
   , mDiscardedChunk(false)
   , mBuffersSize(0)
+  , mExpectedDataSize(0)
   , mLimitAllocation(!aFile->mOpenAsMemoryOnly && aInitByWriter)
   , mIsPriority(aFile->mPriority)
   , mExpectedHash(0)
@@ -833,7 +837,15 @@ CacheFileChunk::GetWriteHandle(uint32_t aEnsuredBufSize)
       mBuf = newBuf;
     }
   } else {
-    rv = mBuf->EnsureBufSize(aEnsuredBufSize);
+    rv = NS_ERROR_NOT_AVAILABLE;
+    if (mExpectedDataSize > aEnsuredBufSize && !mBuf->Buf()) {
+      // Allocate the whole expected size at once. Fall back to the requested
+      // size when the limit doesn't allow it.
+      rv = mBuf->EnsureBufSize(mExpectedDataSize);
+    }
+    if (NS_FAILED(rv)) {
+      rv = mBuf->EnsureBufSize(aEnsuredBufSize);
+    }
   }
 
   if (NS_FAILED(rv)) {
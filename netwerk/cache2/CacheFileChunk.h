@@ -16,6 +16,7 @@ namespace mozilla {
 namespace net {
 
 #define kChunkSize        (256 * 1024)
+#define kMinBufSize       512
 #define kEmptyChunkHash   0x1826
 
 class CacheFileChunk;
@@ -144,6 +145,9 @@ public:
   CacheFileChunk(CacheFile *aFile, uint32_t aIndex, bool aInitByWriter);
 
   void     InitNew();
+  // Size the data of a new chunk is expected to reach. The first buffer is
+  // allocated with this size instead of being grown by the writes.
+  void     SetExpectedDataSize(uint32_t aSize) { mExpectedDataSize = aSize; }
   nsresult Read(CacheFileHandle *aHandle, uint32_t aLen,
                 CacheHash::Hash16_t aHash,
                 CacheFileChunkListener *aCallback);
@@ -216,6 +220,7 @@ private:
   bool mDiscardedChunk : 1;
 
   uint32_t   mBuffersSize;
+  uint32_t   mExpectedDataSize; // 0 when unknown
   bool const mLimitAllocation : 1; // Whether this chunk respects limit for disk
                                    // chunks memory usage.
   bool const mIsPriority : 1;
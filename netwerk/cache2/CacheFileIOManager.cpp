@@ -24,6 +24,7 @@
 #include "mozilla/Telemetry.h"
 #include "mozilla/DebugOnly.h"
 #include "mozilla/Services.h"
+#include "mozilla/StaticMutex.h"
 #include "nsDirectoryServiceUtils.h"
 #include "nsAppDirectoryServiceDefs.h"
 #include "private/pprio.h"
@@ -696,6 +697,10 @@ protected:
   nsCOMPtr<CacheFileIOListener> mCallback;
 };
 
+// Adjacent writes to the same file that are waiting in the queue are performed
+// as a single write by the first of them.  This limits the size of such write.
+static const int32_t kMaxCoalescedWriteSize = 1024 * 1024;
+
 class WriteEvent : public Runnable {
 public:
   WriteEvent(CacheFileHandle *aHandle, int64_t aOffset, const char *aBuf,
@@ -707,6 +712,7 @@ public:
     , mCount(aCount)
     , mValidate(aValidate)
     , mTruncate(aTruncate)
+    , mCoalesced(false)
     , mCallback(aCallback)
   {
     MOZ_COUNT_CTOR(WriteEvent);
@@ -717,13 +723,136 @@ protected:
   {
     MOZ_COUNT_DTOR(WriteEvent);
 
+    {
+      StaticMutexAutoLock lock(sLock);
+      mHandle->mPendingWrites.RemoveElement(this);
+    }
+
     if (!mCallback && mBuf) {
       free(const_cast<char *>(mBuf));
     }
   }
 
 public:
+  // Dispatches the event to the IO thread and makes it available for
+  // coalescing with the write posted before it.
+  nsresult Dispatch(CacheIOThread *aIOThread)
+  {
+    StaticMutexAutoLock lock(sLock);
+
+    nsresult rv = aIOThread->Dispatch(this, CacheIOThread::WRITE);
+    if (NS_SUCCEEDED(rv)) {
+      mHandle->mPendingWrites.AppendElement(this);
+    }
+    return rv;
+  }
+
+  // Any other operation posted for the handle must execute after all writes
+  // posted before it and before all writes posted after it, so no write
+  // pending at this point may take over later writes.
+  static void StopCoalescing(CacheFileHandle *aHandle)
+  {
+    StaticMutexAutoLock lock(sLock);
+    aHandle->mPendingWrites.Clear();
+  }
+
   NS_IMETHOD Run() override
+  {
+    nsTArray<RefPtr<WriteEvent>> batch;
+    {
+      StaticMutexAutoLock lock(sLock);
+      if (mCoalesced) {
+        // Already performed by a write posted before this one.
+        return NS_OK;
+      }
+      TakeAdjacentWrites(batch);
+    }
+
+    if (batch.IsEmpty()) {
+      nsresult rv = Perform(mBuf, mCount, mValidate, mTruncate,
+                            !mCallback);
+      Notify(rv);
+      return NS_OK;
+    }
+
+    batch.InsertElementAt(0, this);
+
+    WriteEvent *last = batch.LastElement();
+    int32_t count = 0;
+    bool needDoom = false;
+    for (uint32_t i = 0; i < batch.Length(); ++i) {
+      count += batch[i]->mCount;
+      needDoom |= !batch[i]->mCallback;
+    }
+
+    nsresult rv;
+    char *buf = static_cast<char *>(malloc(count));
+    if (buf) {
+      char *pos = buf;
+      for (uint32_t i = 0; i < batch.Length(); ++i) {
+        memcpy(pos, batch[i]->mBuf, batch[i]->mCount);
+        pos += batch[i]->mCount;
+      }
+
+      rv = Perform(buf, count, last->mValidate, last->mTruncate, needDoom);
+      free(buf);
+    } else {
+      // Just write the buffers one by one.
+      rv = NS_OK;
+      for (uint32_t i = 0; i < batch.Length() && NS_SUCCEEDED(rv); ++i) {
+        WriteEvent *ev = batch[i];
+        rv = ev->Perform(ev->mBuf, ev->mCount, ev->mValidate, ev->mTruncate,
+                         needDoom);
+      }
+    }
+
+    Telemetry::Accumulate(Telemetry::HTTP_CACHE_IO_WRITES_COALESCED,
+                          batch.Length());
+
+    for (uint32_t i = 0; i < batch.Length(); ++i) {
+      batch[i]->Notify(rv);
+    }
+
+    return NS_OK;
+  }
+
+protected:
+  // Moves the writes directly following this one in the handle's queue and
+  // continuing where the previous one ends to aBatch.
+  void TakeAdjacentWrites(nsTArray<RefPtr<WriteEvent>> &aBatch)
+  {
+    sLock.AssertCurrentThreadOwns();
+
+    nsTArray<WriteEvent *> &pending = mHandle->mPendingWrites;
+    size_t index = pending.IndexOf(this);
+    if (index == pending.NoIndex) {
+      return;
+    }
+
+    WriteEvent *prev = this;
+    int32_t total = mCount;
+    size_t end = index + 1;
+    for (; end < pending.Length(); ++end) {
+      WriteEvent *ev = pending[end];
+      if (prev->mTruncate ||
+          (prev->mCallback && prev->mCallback->IsKilled()) ||
+          (ev->mCallback && ev->mCallback->IsKilled()) ||
+          ev->mOffset != prev->mOffset + prev->mCount ||
+          ev->mCount > kMaxCoalescedWriteSize - total) {
+        break;
+      }
+
+      ev->mCoalesced = true;
+      aBatch.AppendElement(ev);
+      total += ev->mCount;
+      prev = ev;
+    }
+
+    pending.RemoveElementsAt(index, end - index);
+  }
+
+  nsresult Perform(const char *aBuf, int32_t aCount, bool aValidate,
+                   bool aTruncate, bool aDoomOnFailure)
   {
     nsresult rv;
 
@@ -737,32 +866,43 @@ public:
         : NS_ERROR_NOT_INITIALIZED;
     } else {
       rv = CacheFileIOManager::gInstance->WriteInternal(
-          mHandle, mOffset, mBuf, mCount, mValidate, mTruncate);
-      if (NS_FAILED(rv) && !mCallback) {
+          mHandle, mOffset, aBuf, aCount, aValidate, aTruncate);
+      if (NS_FAILED(rv) && aDoomOnFailure) {
         // No listener is going to handle the error, doom the file
         CacheFileIOManager::gInstance->DoomFileInternal(mHandle);
       }
     }
+
+    return rv;
+  }
+
+  void Notify(nsresult aResult)
+  {
     if (mCallback) {
-      mCallback->OnDataWritten(mHandle, mBuf, rv);
+      mCallback->OnDataWritten(mHandle, mBuf, aResult);
     } else {
       free(const_cast<char *>(mBuf));
       mBuf = nullptr;
     }
-
-    return NS_OK;
   }
 
-protected:
+  static StaticMutex            sLock;
+
   RefPtr<CacheFileHandle>       mHandle;
   int64_t                       mOffset;
   const char                   *mBuf;
   int32_t                       mCount;
   bool                          mValidate : 1;
   bool                          mTruncate : 1;
+  // Set when this write has been performed by an earlier write, protected by
+  // sLock.  Not a bitfield, so that it doesn't share a byte with the flags
+  // above.
+  bool                          mCoalesced;
   nsCOMPtr<CacheFileIOListener> mCallback;
 };
 
+StaticMutex WriteEvent::sLock;
+
 class DoomFileEvent : public Runnable {
 public:
   DoomFileEvent(CacheFileHandle *aHandle,
@@ -1926,7 +2066,7 @@ CacheFileIOManager::Write(CacheFileHandle *aHandle, int64_t aOffset,
 
   RefPtr<WriteEvent> ev = new WriteEvent(aHandle, aOffset, aBuf, aCount,
                                            aValidate, aTruncate, aCallback);
-  rv = ioMan->mIOThread->Dispatch(ev, CacheIOThread::WRITE);
+  rv = ev->Dispatch(ioMan->mIOThread);
   NS_ENSURE_SUCCESS(rv, rv);
 
   return NS_OK;
@@ -2287,6 +2427,8 @@ CacheFileIOManager::ReleaseNSPRHandle(CacheFileHandle *aHandle)
     return NS_ERROR_NOT_INITIALIZED;
   }
 
+  WriteEvent::StopCoalescing(aHandle);
+
   RefPtr<ReleaseNSPRHandleEvent> ev = new ReleaseNSPRHandleEvent(aHandle);
   rv = ioMan->mIOThread->Dispatch(ev, CacheIOThread::CLOSE);
   NS_ENSURE_SUCCESS(rv, rv);
@@ -2367,6 +2509,8 @@ CacheFileIOManager::TruncateSeekSetEOF(CacheFileHandle *aHandle,
     return NS_ERROR_NOT_INITIALIZED;
   }
 
+  WriteEvent::StopCoalescing(aHandle);
+
   RefPtr<TruncateSeekSetEOFEvent> ev = new TruncateSeekSetEOFEvent(
                                            aHandle, aTruncatePos, aEOFPos,
                                            aCallback);
@@ -2597,6 +2741,8 @@ CacheFileIOManager::RenameFile(CacheFileHandle *aHandle,
     return NS_ERROR_UNEXPECTED;
   }
 
+  WriteEvent::StopCoalescing(aHandle);
+
   RefPtr<RenameFileEvent> ev = new RenameFileEvent(aHandle, aNewName,
                                                      aCallback);
   rv = ioMan->mIOThread->Dispatch(ev, CacheIOThread::WRITE);
@@ -31,6 +31,7 @@ namespace net {
 
 class CacheFile;
 class CacheFileIOListener;
+class WriteEvent;
 
 #ifdef DEBUG_HANDLES
 class CacheFileHandlesEntry;
@@ -78,6 +79,7 @@ private:
   friend class CacheFileIOManager;
   friend class CacheFileHandles;
   friend class ReleaseNSPRHandleEvent;
+  friend class WriteEvent;
 
   virtual ~CacheFileHandle();
 
@@ -125,6 +127,10 @@ private:
   int64_t              mFileSize;
   PRFileDesc          *mFD;  // if null then the file doesn't exists on the disk
   nsCString            mKey;
+  // Writes dispatched to the IO thread that haven't run yet, in the order they
+  // were posted.  Adjacent ones are performed together, see WriteEvent.
+  // Protected by WriteEvent::sLock.
+  nsTArray<WriteEvent *> mPendingWrites;
 };
 
 class CacheFileHandles {
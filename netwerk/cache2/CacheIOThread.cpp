@@ -26,6 +26,7 @@ public:
   typedef CacheIOThread::EventQueue::size_type size_type;
   static size_type mMinLengthToReport[CacheIOThread::LAST_LEVEL];
   static void Report(uint32_t aLevel, size_type aLength);
+  static void ReportWait(uint32_t aLevel, TimeStamp const& aQueueStart);
 };
 
 static CacheIOTelemetry::size_type const kGranularity = 30;
@@ -65,6 +66,30 @@ void CacheIOTelemetry::Report(uint32_t aLevel, CacheIOTelemetry::size_type aLeng
   Telemetry::Accumulate(telemetryID[aLevel], aLength - 1); // counted from 0
 }
 
+// static
+void CacheIOTelemetry::ReportWait(uint32_t aLevel, TimeStamp const& aQueueStart)
+{
+  if (aQueueStart.IsNull()) {
+    return;
+  }
+
+  static char const* const levelName[] = {
+    "OPEN_PRIORITY",
+    "READ_PRIORITY",
+    "OPEN",
+    "READ",
+    "MANAGEMENT",
+    "WRITE",
+    "INDEX",
+    "EVICT"
+  };
+
+  uint32_t waitMs = static_cast<uint32_t>(
+    (TimeStamp::Now() - aQueueStart).ToMilliseconds());
+  Telemetry::Accumulate(Telemetry::HTTP_CACHE_IO_QUEUE_WAIT_MS,
+                        nsDependentCString(levelName[aLevel]), waitMs);
+}
+
 } // anon
 
 namespace detail {
@@ -303,8 +328,12 @@ nsresult CacheIOThread::DispatchAfterPendingOpens(nsIRunnable* aRunnable)
 
   // Move everything from later executed OPEN level to the OPEN_PRIORITY level
   // where we post the (eviction) runnable.
+  if (mEventQueue[OPEN_PRIORITY].IsEmpty()) {
+    mQueueStart[OPEN_PRIORITY] = mQueueStart[OPEN];
+  }
   mEventQueue[OPEN_PRIORITY].AppendElements(mEventQueue[OPEN]);
   mEventQueue[OPEN].Clear();
+  mQueueStart[OPEN] = TimeStamp();
 
   return DispatchInternal(do_AddRef(aRunnable), OPEN_PRIORITY);
 }
@@ -319,6 +348,9 @@ nsresult CacheIOThread::DispatchInternal(already_AddRefed<nsIRunnable> aRunnable
 
   mMonitor.AssertCurrentThreadOwns();
 
+  if (mEventQueue[aLevel].IsEmpty()) {
+    mQueueStart[aLevel] = TimeStamp::Now();
+  }
   mEventQueue[aLevel].AppendElement(runnable.forget());
   if (mLowestLevelWaiting > aLevel)
     mLowestLevelWaiting = aLevel;
@@ -504,6 +536,8 @@ void CacheIOThread::LoopOneLevel(uint32_t aLevel)
   EventQueue events;
   events.SwapElements(mEventQueue[aLevel]);
   EventQueue::size_type length = events.Length();
+  TimeStamp queueStart = mQueueStart[aLevel];
+  mQueueStart[aLevel] = TimeStamp();
 
   mCurrentlyExecutingLevel = aLevel;
 
@@ -525,6 +559,7 @@ void CacheIOThread::LoopOneLevel(uint32_t aLevel)
       if (reportTelementry) {
         reportTelementry = false;
         CacheIOTelemetry::Report(aLevel, length);
+        CacheIOTelemetry::ReportWait(aLevel, queueStart);
       }
 
       // Drop any previous flagging, only an event on the current level may set
@@ -547,8 +582,11 @@ void CacheIOThread::LoopOneLevel(uint32_t aLevel)
     }
   }
 
-  if (returnEvents)
+  if (returnEvents) {
     mEventQueue[aLevel].InsertElementsAt(0, events.Elements() + index, length - index);
+    // The returned events are older than anything posted in the meantime.
+    mQueueStart[aLevel] = queueStart;
+  }
 }
 
 bool CacheIOThread::EventsPending(uint32_t aLastLevel)
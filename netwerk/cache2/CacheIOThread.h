@@ -14,6 +14,7 @@
 #include "mozilla/DebugOnly.h"
 #include "mozilla/Atomics.h"
 #include "mozilla/UniquePtr.h"
+#include "mozilla/TimeStamp.h"
 
 class nsIRunnable;
 
@@ -119,6 +120,8 @@ private:
   uint32_t mCurrentlyExecutingLevel;
 
   EventQueue mEventQueue[LAST_LEVEL];
+  // When the oldest event of each queue has been posted, for telemetry
+  TimeStamp mQueueStart[LAST_LEVEL];
   // Raised when nsIEventTarget.Dispatch() is called on this thread
   Atomic<bool, Relaxed> mHasXPCOMEvents;
   // See YieldAndRerun() above
@@ -16,6 +16,7 @@
 #include "nsPrintfCString.h"
 #include "mozilla/DebugOnly.h"
 #include "prinrval.h"
+#include "prio.h"
 #include "nsIFile.h"
 #include "nsITimer.h"
 #include "mozilla/AutoRestore.h"
@@ -27,7 +28,9 @@
 #define kMinUnwrittenChanges   300
 #define kMinDumpInterval       20000 // in milliseconds
 #define kMaxBufSize            16384
-#define kIndexVersion          0x00000001
+#define kIndexVersion          0x00000002
+// Version 1 index files are identical, but their records are not sorted.
+#define kUnsortedIndexVersion  0x00000001
 #define kUpdateIndexStartDelay 50000 // in milliseconds
 
 #define INDEX_NAME      "index"
@@ -57,6 +60,17 @@ public:
   }
 };
 
+class HashComparator
+{
+public:
+  bool Equals(CacheIndexRecord* a, CacheIndexRecord* b) const {
+    return memcmp(&a->mHash, &b->mHash, sizeof(SHA1Sum::Hash)) == 0;
+  }
+  bool LessThan(CacheIndexRecord* a, CacheIndexRecord* b) const {
+    return memcmp(&a->mHash, &b->mHash, sizeof(SHA1Sum::Hash)) < 0;
+  }
+};
+
 } // namespace
 
 /**
@@ -252,6 +266,12 @@ CacheIndex::CacheIndex()
   , mRWBufPos(0)
   , mRWPending(false)
   , mJournalReadSuccessfully(false)
+  , mMappedFD(nullptr)
+  , mMappedFileMap(nullptr)
+  , mMappedData(nullptr)
+  , mMappedSize(0)
+  , mMappedRecords(nullptr)
+  , mMappedCount(0)
   , mFrecencyArraySorted(false)
   , mAsyncGetDiskConsumptionBlocked(false)
 {
@@ -268,6 +288,7 @@ CacheIndex::~CacheIndex()
   MOZ_COUNT_DTOR(CacheIndex);
 
   ReleaseBuffer();
+  UnmapIndex();
 }
 
 // static
@@ -1127,11 +1148,33 @@ CacheIndex::HasEntry(const SHA1Sum::Hash &hash, EntryStatus *_retval, bool *_pin
   }
 
   const CacheIndexEntry *entry = nullptr;
+  // True when the journal and the mapped index file are known to describe the
+  // whole cache, even though the records have not all been parsed yet.
+  bool haveMappedIndex = false;
 
   switch (index->mState) {
     case READING:
     case WRITING:
       entry = index->mPendingUpdates.GetEntry(hash);
+      if (!entry && index->mState == READING && index->mMappedRecords &&
+          index->mJournalReadSuccessfully) {
+        haveMappedIndex = true;
+        entry = index->mTmpJournal.GetEntry(hash);
+        if (!entry) {
+          const CacheIndexRecord *rec = index->FindMappedRecord(hash);
+          if (rec) {
+            // Records in a clean index file are never removed, so the entry
+            // exists.
+            *_retval = EXISTS;
+            if (_pinned) {
+              *_pinned = CacheIndexEntry::IsPinnedOnDisk(rec);
+            }
+            LOG(("CacheIndex::HasEntry() - result is %u (mapped)", *_retval));
+            return NS_OK;
+          }
+          break;
+        }
+      }
       MOZ_FALLTHROUGH;
     case BUILDING:
     case UPDATING:
@@ -1146,7 +1189,8 @@ CacheIndex::HasEntry(const SHA1Sum::Hash &hash, EntryStatus *_retval, bool *_pin
   }
 
   if (!entry) {
-    if (index->mState == READY || index->mState == WRITING) {
+    if (index->mState == READY || index->mState == WRITING ||
+        haveMappedIndex) {
       *_retval = DOES_NOT_EXIST;
     } else {
       *_retval = DO_NOT_KNOW;
@@ -1615,6 +1659,19 @@ CacheIndex::WriteIndexToDisk()
 
   mProcessEntries = mIndexStats.ActiveEntriesCount();
 
+  mSortedRecords.SetCapacity(mProcessEntries);
+  for (auto iter = mIndex.Iter(); !iter.Done(); iter.Next()) {
+    CacheIndexEntry* entry = iter.Get();
+    if (entry->IsRemoved() ||
+        !entry->IsInitialized() ||
+        entry->IsFileEmpty()) {
+      continue;
+    }
+    mSortedRecords.AppendElement(entry->mRec.get());
+  }
+  mSortedRecords.Sort(HashComparator());
+  MOZ_ASSERT(mSortedRecords.Length() == mProcessEntries);
+
   mIndexFileOpener = new FileOpenHelper(this);
   rv = CacheFileIOManager::OpenFile(NS_LITERAL_CSTRING(TEMP_INDEX_NAME),
                                     CacheFileIOManager::SPECIAL_FILE |
@@ -1665,26 +1722,13 @@ CacheIndex::WriteRecords()
   uint32_t hashOffset = mRWBufPos;
 
   char* buf = mRWBuf + mRWBufPos;
-  uint32_t skip = mSkipEntries;
   uint32_t processMax = (mRWBufSize - mRWBufPos) / sizeof(CacheIndexRecord);
   MOZ_ASSERT(processMax != 0 || mProcessEntries == 0); // TODO make sure we can write an empty index
   uint32_t processed = 0;
 #ifdef DEBUG
   bool hasMore = false;
 #endif
-  for (auto iter = mIndex.Iter(); !iter.Done(); iter.Next()) {
-    CacheIndexEntry* entry = iter.Get();
-    if (entry->IsRemoved() ||
-        !entry->IsInitialized() ||
-        entry->IsFileEmpty()) {
-      continue;
-    }
-
-    if (skip) {
-      skip--;
-      continue;
-    }
-
+  for (uint32_t i = mSkipEntries; i < mSortedRecords.Length(); ++i) {
     if (processed == processMax) {
   #ifdef DEBUG
       hasMore = true;
@@ -1692,7 +1736,7 @@ CacheIndex::WriteRecords()
       break;
     }
 
-    entry->WriteToBuf(buf);
+    CacheIndexEntry::WriteToBuf(mSortedRecords[i], buf);
     buf += sizeof(CacheIndexRecord);
     processed++;
   }
@@ -1750,6 +1794,7 @@ CacheIndex::FinishWrite(bool aSucceeded)
   mIndexHandle = nullptr;
   mRWHash = nullptr;
   ReleaseBuffer();
+  mSortedRecords.Clear();
 
   if (aSucceeded) {
     // Opening of the file must not be in progress if writing succeeded.
@@ -2068,8 +2113,6 @@ CacheIndex::StartReadingIndex()
 {
   LOG(("CacheIndex::StartReadingIndex()"));
 
-  nsresult rv;
-
   sLock.AssertCurrentThreadOwns();
 
   MOZ_ASSERT(mIndexHandle);
@@ -2090,6 +2133,33 @@ CacheIndex::StartReadingIndex()
   }
 
   AllocBuffer();
+
+  if (mJournalHandle) {
+    MapIndex();
+    if (mMappedRecords) {
+      // Read the journal first. Once it is read, HasEntry() can answer from
+      // the journal and the mapped index while the records are being parsed.
+      StartReadingJournal();
+      return;
+    }
+  }
+
+  StartReadingRecords();
+}
+
+void
+CacheIndex::StartReadingRecords()
+{
+  LOG(("CacheIndex::StartReadingRecords()"));
+
+  nsresult rv;
+
+  sLock.AssertCurrentThreadOwns();
+
+  MOZ_ASSERT(mIndexHandle);
+  MOZ_ASSERT(!mIndexOnDiskIsValid);
+  MOZ_ASSERT(!mRWPending);
+
   mSkipEntries = 0;
   mRWHash = new CacheHash();
 
@@ -2098,14 +2168,118 @@ CacheIndex::StartReadingIndex()
 
   rv = CacheFileIOManager::Read(mIndexHandle, 0, mRWBuf, mRWBufPos, this);
   if (NS_FAILED(rv)) {
-    LOG(("CacheIndex::StartReadingIndex() - CacheFileIOManager::Read() failed "
-         "synchronously [rv=0x%08x]", rv));
+    LOG(("CacheIndex::StartReadingRecords() - CacheFileIOManager::Read() "
+         "failed synchronously [rv=0x%08x]", rv));
     FinishRead(false);
   } else {
     mRWPending = true;
   }
 }
 
+void
+CacheIndex::MapIndex()
+{
+  LOG(("CacheIndex::MapIndex()"));
+
+  nsresult rv;
+
+  sLock.AssertCurrentThreadOwns();
+
+  MOZ_ASSERT(!mMappedData);
+
+  // StartReadingIndex() has already checked that the size is sane.
+  int64_t fileSize = mIndexHandle->FileSize();
+  if (fileSize > UINT32_MAX) {
+    return;
+  }
+
+  nsCOMPtr<nsIFile> file;
+  rv = GetFile(NS_LITERAL_CSTRING(INDEX_NAME), getter_AddRefs(file));
+  if (NS_FAILED(rv)) {
+    return;
+  }
+
+  rv = file->OpenNSPRFileDesc(PR_RDONLY, 0600, &mMappedFD);
+  if (NS_FAILED(rv)) {
+    LOG(("CacheIndex::MapIndex() - Cannot open index file [rv=0x%08x]", rv));
+    mMappedFD = nullptr;
+    return;
+  }
+
+  mMappedSize = static_cast<uint32_t>(fileSize);
+  mMappedFileMap = PR_CreateFileMap(mMappedFD, mMappedSize, PR_PROT_READONLY);
+  if (mMappedFileMap) {
+    mMappedData = PR_MemMap(mMappedFileMap, 0, mMappedSize);
+  }
+  if (!mMappedData) {
+    LOG(("CacheIndex::MapIndex() - Cannot map index file"));
+    UnmapIndex();
+    return;
+  }
+
+  // Only a clean index written in the order of hashes can be searched.
+  const CacheIndexHeader *hdr =
+    static_cast<const CacheIndexHeader *>(mMappedData);
+  if (NetworkEndian::readUint32(&hdr->mVersion) != kIndexVersion ||
+      NetworkEndian::readUint32(&hdr->mIsDirty)) {
+    UnmapIndex();
+    return;
+  }
+
+  mMappedRecords = reinterpret_cast<const CacheIndexRecord *>(
+                     static_cast<const char *>(mMappedData) +
+                     sizeof(CacheIndexHeader));
+  mMappedCount = (mMappedSize - sizeof(CacheIndexHeader) -
+                  sizeof(CacheHash::Hash32_t)) / sizeof(CacheIndexRecord);
+
+  LOG(("CacheIndex::MapIndex() - Index mapped [records=%u]", mMappedCount));
+}
+
+void
+CacheIndex::UnmapIndex()
+{
+  if (mMappedData) {
+    PR_MemUnmap(mMappedData, mMappedSize);
+    mMappedData = nullptr;
+  }
+  if (mMappedFileMap) {
+    PR_CloseFileMap(mMappedFileMap);
+    mMappedFileMap = nullptr;
+  }
+  if (mMappedFD) {
+    PR_Close(mMappedFD);
+    mMappedFD = nullptr;
+  }
+
+  mMappedSize = 0;
+  mMappedRecords = nullptr;
+  mMappedCount = 0;
+}
+
+const CacheIndexRecord*
+CacheIndex::FindMappedRecord(const SHA1Sum::Hash &aHash)
+{
+  sLock.AssertCurrentThreadOwns();
+
+  uint32_t low = 0;
+  uint32_t high = mMappedCount;
+
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    int cmp = memcmp(&mMappedRecords[mid].mHash, &aHash, sizeof(SHA1Sum::Hash));
+    if (cmp == 0) {
+      return &mMappedRecords[mid];
+    }
+    if (cmp < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return nullptr;
+}
+
 void
 CacheIndex::ParseRecords()
 {
@@ -2126,7 +2300,8 @@ CacheIndex::ParseRecords()
                               moz_xmalloc(sizeof(CacheIndexHeader)));
     memcpy(hdr, mRWBuf, sizeof(CacheIndexHeader));
 
-    if (NetworkEndian::readUint32(&hdr->mVersion) != kIndexVersion) {
+    uint32_t version = NetworkEndian::readUint32(&hdr->mVersion);
+    if (version != kIndexVersion && version != kUnsortedIndexVersion) {
       free(hdr);
       FinishRead(false);
       return;
@@ -2209,7 +2384,12 @@ CacheIndex::ParseRecords()
     }
 
     mIndexOnDiskIsValid = true;
-    mJournalReadSuccessfully = false;
+
+    if (mJournalReadSuccessfully) {
+      // The journal was read before the index, see StartReadingIndex().
+      FinishRead(true);
+      return;
+    }
 
     if (mJournalHandle) {
       StartReadingJournal();
@@ -2248,7 +2428,7 @@ CacheIndex::StartReadingJournal()
   sLock.AssertCurrentThreadOwns();
 
   MOZ_ASSERT(mJournalHandle);
-  MOZ_ASSERT(mIndexOnDiskIsValid);
+  MOZ_ASSERT(mIndexOnDiskIsValid || mMappedRecords);
   MOZ_ASSERT(mTmpJournal.Count() == 0);
   MOZ_ASSERT(mJournalHandle->FileSize() >= 0);
   MOZ_ASSERT(!mRWPending);
@@ -2337,7 +2517,11 @@ CacheIndex::ParseJournal()
     }
 
     mJournalReadSuccessfully = true;
-    FinishRead(true);
+    if (mIndexOnDiskIsValid) {
+      FinishRead(true);
+    } else {
+      StartReadingRecords();
+    }
     return;
   }
 
@@ -2432,6 +2616,14 @@ CacheIndex::FinishRead(bool aSucceeded)
 
   MOZ_ASSERT((!aSucceeded && mState == SHUTDOWN) || mState == READING);
 
+  UnmapIndex();
+
+  if (!aSucceeded && !mIndexOnDiskIsValid) {
+    // A journal read before the index is useless without the index.
+    mJournalReadSuccessfully = false;
+    mTmpJournal.Clear();
+  }
+
   MOZ_ASSERT(
     // -> rebuild
     (!aSucceeded && !mIndexOnDiskIsValid && !mJournalReadSuccessfully) ||
@@ -3507,10 +3699,10 @@ CacheIndex::OnDataRead(CacheFileHandle *aHandle, char *aBuf, nsresult aResult)
       if (NS_FAILED(aResult)) {
         FinishRead(false);
       } else {
-        if (!mIndexOnDiskIsValid) {
-          ParseRecords();
-        } else {
+        if (aHandle == mJournalHandle) {
           ParseJournal();
+        } else {
+          ParseRecords();
         }
       }
       break;
@@ -3628,6 +3820,7 @@ CacheIndex::SizeOfExcludingThisInternal(mozilla::MallocSizeOf mallocSizeOf) cons
   // mFrecencyArray items are reported by mIndex/mPendingUpdates
   n += mFrecencyArray.ShallowSizeOfExcludingThis(mallocSizeOf);
   n += mDiskConsumptionObservers.ShallowSizeOfExcludingThis(mallocSizeOf);
+  n += mSortedRecords.ShallowSizeOfExcludingThis(mallocSizeOf);
 
   return n;
 }
@@ -223,14 +223,20 @@ public:
   {
     return aRec->mFlags & kPinnedMask;
   }
+  // Same as above for a record in network byte order, as stored on disk.
+  static bool IsPinnedOnDisk(const CacheIndexRecord *aRec)
+  {
+    return !!(NetworkEndian::readUint32(&aRec->mFlags) & kPinnedMask);
+  }
   bool     IsFileEmpty() const { return GetFileSize() == 0; }
 
-  void WriteToBuf(void *aBuf)
+  void WriteToBuf(void *aBuf) { WriteToBuf(mRec, aBuf); }
+  static void WriteToBuf(const CacheIndexRecord *aRec, void *aBuf)
   {
     CacheIndexRecord *dst = reinterpret_cast<CacheIndexRecord *>(aBuf);
 
     // Copy the whole record to the buffer.
-    memcpy(aBuf, mRec, sizeof(CacheIndexRecord));
+    memcpy(aBuf, aRec, sizeof(CacheIndexRecord));
 
     // Dirty and fresh flags should never go to disk, since they make sense only
     // during current session.
@@ -758,7 +764,8 @@ private:
   // Starts writing of index file.
   void WriteIndexToDisk();
   // Serializes part of mIndex hashtable to the write buffer a writes the buffer
-  // to the file.
+  // to the file. Records are written in the order of their hashes, so that the
+  // file can be searched without parsing it (see MapIndex()).
   void WriteRecords();
   // Finalizes writing process.
   void FinishWrite(bool aSucceeded);
@@ -813,12 +820,25 @@ private:
   // initial test to ensure that we start update process on the next startup if
   // FF crashes during parsing of the index.
   //
+  // When the index file is clean and its records are sorted, the file is
+  // mapped into memory and the journal is read before the records are parsed.
+  // Once the journal is read, the journal and the mapped records together
+  // answer HasEntry() lookups, so lookups don't have to wait for all records
+  // to be parsed.
+  //
   // Initiates reading index from disk.
   void ReadIndexFromDisk();
   // Starts reading data from index file.
   void StartReadingIndex();
+  // Starts reading records from the beginning of the index file.
+  void StartReadingRecords();
   // Parses data read from index file.
   void ParseRecords();
+  // Maps the index file into memory if it is clean and sorted.
+  void MapIndex();
+  void UnmapIndex();
+  // Binary searches the mapped index file for the given hash.
+  const CacheIndexRecord* FindMappedRecord(const SHA1Sum::Hash &aHash);
   // Starts reading data from journal file.
   void StartReadingJournal();
   // Parses data read from journal file.
@@ -1001,6 +1021,18 @@ private:
   // Reading of journal succeeded if true.
   bool                      mJournalReadSuccessfully;
 
+  // Records of mIndex in the order they are written to the index file. Filled
+  // when writing starts; mIndex doesn't change until writing finishes.
+  nsTArray<CacheIndexRecord *> mSortedRecords;
+
+  // The index file mapped by MapIndex() while it is being read.
+  PRFileDesc               *mMappedFD;
+  PRFileMap                *mMappedFileMap;
+  void                     *mMappedData;
+  uint32_t                  mMappedSize;
+  const CacheIndexRecord   *mMappedRecords;
+  uint32_t                  mMappedCount;
+
   // Handle used for writing and reading index file.
   RefPtr<CacheFileHandle> mIndexHandle;
   // Handle used for reading journal file.
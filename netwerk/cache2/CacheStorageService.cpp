@@ -13,6 +13,7 @@
 #include "CacheStorage.h"
 #include "AppCacheStorage.h"
 #include "CacheEntry.h"
+#include "CacheFileChunk.h"
 #include "CacheFileUtils.h"
 
 #include "OldWrappers.h"
@@ -32,6 +33,8 @@
 #include "mozilla/TimeStamp.h"
 #include "mozilla/DebugOnly.h"
 #include "mozilla/Services.h"
+#include "mozilla/MathAlgorithms.h"
+#include "mozilla/StaticMutex.h"
 
 namespace mozilla {
 namespace net {
@@ -144,6 +147,8 @@ void CacheStorageService::Shutdown()
 
   mShutdown = true;
 
+  PurgeChunkBuffers();
+
   nsCOMPtr<nsIRunnable> event =
     NewRunnableMethod(this, &CacheStorageService::ShutdownBackground);
   Dispatch(event);
@@ -183,6 +188,82 @@ void CacheStorageService::ShutdownBackground()
   LOG(("CacheStorageService::ShutdownBackground - done"));
 }
 
+// Chunk buffer pool
+
+namespace {
+
+// Sizes of the pooled buffers are powers of two from kMinBufSize to kChunkSize.
+uint32_t const kChunkBufferClasses = 10;
+static_assert(kMinBufSize << (kChunkBufferClasses - 1) == kChunkSize,
+              "Chunk buffer size classes don't cover all buffer sizes");
+uint32_t const kMaxPooledChunkBuffers = 16;
+
+StaticMutex sChunkBufferPoolLock;
+char* sChunkBufferPool[kChunkBufferClasses][kMaxPooledChunkBuffers];
+uint32_t sChunkBufferPoolCount[kChunkBufferClasses];
+uint32_t sChunkBufferPoolSize;
+
+uint32_t ChunkBufferClass(uint32_t aSize)
+{
+  MOZ_ASSERT(IsPowerOfTwo(aSize));
+  MOZ_ASSERT(aSize >= kMinBufSize && aSize <= kChunkSize);
+  return FloorLog2(aSize / kMinBufSize);
+}
+
+} // namespace
+
+// static
+char* CacheStorageService::AllocChunkBuffer(uint32_t aSize)
+{
+  uint32_t sizeClass = ChunkBufferClass(aSize);
+
+  {
+    StaticMutexAutoLock lock(sChunkBufferPoolLock);
+    uint32_t& count = sChunkBufferPoolCount[sizeClass];
+    if (count) {
+      sChunkBufferPoolSize -= aSize;
+      return sChunkBufferPool[sizeClass][--count];
+    }
+  }
+
+  return static_cast<char*>(malloc(aSize));
+}
+
+// static
+void CacheStorageService::RecycleChunkBuffer(char* aBuf, uint32_t aSize)
+{
+  if (!CacheObserver::ShuttingDown()) {
+    uint32_t sizeClass = ChunkBufferClass(aSize);
+
+    StaticMutexAutoLock lock(sChunkBufferPoolLock);
+    uint32_t& count = sChunkBufferPoolCount[sizeClass];
+    if (count < kMaxPooledChunkBuffers &&
+        sChunkBufferPoolSize + aSize <=
+          CacheObserver::MaxDiskChunksMemoryUsage(false) / 4) {
+      sChunkBufferPool[sizeClass][count++] = aBuf;
+      sChunkBufferPoolSize += aSize;
+      return;
+    }
+  }
+
+  CacheFileUtils::FreeBuffer(aBuf);
+}
+
+// static
+void CacheStorageService::PurgeChunkBuffers()
+{
+  LOG(("CacheStorageService::PurgeChunkBuffers"));
+
+  StaticMutexAutoLock lock(sChunkBufferPoolLock);
+  for (uint32_t i = 0; i < kChunkBufferClasses; ++i) {
+    for (uint32_t j = 0; j < sChunkBufferPoolCount[i]; ++j) {
+      free(sChunkBufferPool[i][j]);
+    }
+    sChunkBufferPoolCount[i] = 0;
+  }
+  sChunkBufferPoolSize = 0;
+}
+
 // Internal management methods
 
 namespace {
@@ -881,6 +962,7 @@ NS_IMETHODIMP CacheStorageService::PurgeFromMemoryRunnable::Run()
     // TODO not all flags apply to both pools
     mService->Pool(true).PurgeAll(mWhat);
     mService->Pool(false).PurgeAll(mWhat);
+    PurgeChunkBuffers();
     mService = nullptr;
   }
 
@@ -2150,6 +2232,21 @@ CacheStorageService::CollectReports(nsIHandleReportCallback* aHandleReport,
     CacheIndex::SizeOfIncludingThis(MallocSizeOf),
     "Memory used by the cache index.");
 
+  {
+    StaticMutexAutoLock lock(sChunkBufferPoolLock);
+    size_t size = 0;
+    for (uint32_t i = 0; i < kChunkBufferClasses; ++i) {
+      for (uint32_t j = 0; j < sChunkBufferPoolCount[i]; ++j) {
+        size += MallocSizeOf(sChunkBufferPool[i][j]);
+      }
+    }
+
+    MOZ_COLLECT_REPORT(
+      "explicit/network/cache2/chunk-buffer-pool", KIND_HEAP, UNITS_BYTES,
+      size,
+      "Memory used by unused cache chunk buffers kept for reuse.");
+  }
+
   MutexAutoLock lock(mLock);
 
   // Report the service instance, this doesn't report entries, done lower
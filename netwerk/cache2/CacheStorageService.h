@@ -93,6 +93,14 @@ public:
   already_AddRefed<nsIEventTarget> Thread() const;
   mozilla::Mutex& Lock() { return mLock; }
 
+  // Buffers of CacheFileChunkBuffer are taken from and returned to a pool of
+  // unused buffers grouped by size.  aSize must be a power of two between
+  // kMinBufSize and kChunkSize.  The pool is limited to a part of the memory
+  // disk chunks may use and it is emptied on memory pressure and shutdown.
+  static char* AllocChunkBuffer(uint32_t aSize);
+  static void RecycleChunkBuffer(char* aBuf, uint32_t aSize);
+  static void PurgeChunkBuffers();
+
   // Tracks entries that may be forced valid in a pruned hashtable.
   nsDataHashtable<nsCStringHashKey, TimeStamp> mForcedValidEntries;
   void ForcedValidEntriesPrune(TimeStamp &now);
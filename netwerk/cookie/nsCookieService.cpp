@@ -112,6 +112,11 @@ static const uint32_t kMaxCookiesPerHost  = 150;
 static const uint32_t kMaxBytesPerCookie  = 4096;
 static const uint32_t kMaxBytesPerPath    = 1024;
 
+// how long cookie DB writes are held back so they can share a transaction
+static const uint32_t kFlushDelayMs       = 500;
+// how many hosts per base domain nsCookieEntry::GetHostCache() remembers
+static const uint32_t kMaxHostCaches      = 8;
+
 // pref string constants
 static const char kPrefCookieBehavior[]     = "network.cookie.cookieBehavior";
 static const char kPrefMaxNumberOfCookies[] = "network.cookie.maxNumber";
@@ -607,6 +612,16 @@ nsCookieEntry::SizeOfExcludingThis(MallocSizeOf aMallocSizeOf) const
     amount += mCookies[i]->SizeOfIncludingThis(aMallocSizeOf);
   }
 
+  amount += mHostCaches.ShallowSizeOfExcludingThis(aMallocSizeOf);
+  for (uint32_t i = 0; i < mHostCaches.Length(); ++i) {
+    const nsCookieHostCache& cache = mHostCaches[i];
+    amount += cache.mHost.SizeOfExcludingThisIfUnshared(aMallocSizeOf);
+    amount += cache.mCookies.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    amount += cache.mHeaderPath.SizeOfExcludingThisIfUnshared(aMallocSizeOf);
+    amount += cache.mHeader.SizeOfExcludingThisIfUnshared(aMallocSizeOf);
+    amount += cache.mHeaderCookies.ShallowSizeOfExcludingThis(aMallocSizeOf);
+  }
+
   return amount;
 }
 
@@ -1590,7 +1605,9 @@ nsCookieService::CloseDBStates()
   if (!mDefaultDBState)
     return;
 
-  // Cleanup cached statements before we can close anything.
+  // Write out anything still pending, then cleanup cached statements before
+  // we can close anything.
+  FlushPendingWrites(mDefaultDBState);
   CleanupCachedStatements();
 
   if (mDefaultDBState->dbConn) {
@@ -1614,11 +1631,109 @@ nsCookieService::CloseDBStates()
 void
 nsCookieService::CleanupCachedStatements()
 {
+  // Unflushed writes hold the statements too. Callers that still want them
+  // on disk must call FlushPendingWrites() first.
+  if (mDefaultDBState->flushTimer) {
+    mDefaultDBState->flushTimer->Cancel();
+    mDefaultDBState->flushTimer = nullptr;
+  }
+  mDefaultDBState->pendingWrites.Clear();
+
   mDefaultDBState->stmtInsert = nullptr;
   mDefaultDBState->stmtDelete = nullptr;
   mDefaultDBState->stmtUpdate = nullptr;
 }
 
+// Returns the params array a write through aStmt should be bound into. Writes
+// are queued in order, and consecutive ones through the same statement share
+// one array; the queue is flushed kFlushDelayMs after the first write.
+mozIStorageBindingParamsArray*
+nsCookieService::PendingParamsFor(DBState* aDBState,
+                                  mozIStorageAsyncStatement* aStmt,
+                                  mozIStorageStatementCallback* aListener)
+{
+  NS_ASSERTION(aDBState->dbConn, "no DB connection to write to");
+
+  nsTArray<DBState::PendingWrite>& writes = aDBState->pendingWrites;
+  if (writes.IsEmpty() || writes.LastElement().stmt != aStmt) {
+    DBState::PendingWrite* write = writes.AppendElement();
+    write->stmt = aStmt;
+    write->listener = aListener;
+    aStmt->NewBindingParamsArray(getter_AddRefs(write->paramsArray));
+  }
+
+  if (!aDBState->flushTimer) {
+    aDBState->flushTimer = do_CreateInstance(NS_TIMER_CONTRACTID);
+    if (!aDBState->flushTimer ||
+        NS_FAILED(aDBState->flushTimer->InitWithFuncCallback(
+          FlushTimerCallback, aDBState, kFlushDelayMs,
+          nsITimer::TYPE_ONE_SHOT))) {
+      COOKIE_LOGSTRING(LogLevel::Warning,
+        ("PendingParamsFor(): couldn't start the flush timer"));
+    }
+  }
+
+  return writes.LastElement().paramsArray;
+}
+
+// static
+void
+nsCookieService::FlushTimerCallback(nsITimer* aTimer, void* aClosure)
+{
+  DBState* dbState = static_cast<DBState*>(aClosure);
+  dbState->flushTimer = nullptr;
+  if (gCookieService) {
+    gCookieService->FlushPendingWrites(dbState);
+  }
+}
+
+void
+nsCookieService::FlushPendingWrites(DBState* aDBState)
+{
+  if (aDBState->flushTimer) {
+    aDBState->flushTimer->Cancel();
+    aDBState->flushTimer = nullptr;
+  }
+
+  nsTArray<DBState::PendingWrite> writes;
+  writes.SwapElements(aDBState->pendingWrites);
+  if (writes.IsEmpty() || !aDBState->dbConn) {
+    return;
+  }
+
+  // Async statements run in order on the connection's thread, so wrapping
+  // the batch in BEGIN/COMMIT makes it a single transaction.
+  nsCOMPtr<mozIStoragePendingStatement> handle;
+  bool transaction = writes.Length() > 1;
+  if (transaction) {
+    DebugOnly<nsresult> rv = aDBState->dbConn->ExecuteSimpleSQLAsync(
+      NS_LITERAL_CSTRING("BEGIN"), nullptr, getter_AddRefs(handle));
+    NS_ASSERT_SUCCESS(rv);
+  }
+
+  for (uint32_t i = 0; i < writes.Length(); ++i) {
+    DBState::PendingWrite& write = writes[i];
+    uint32_t length = 0;
+    if (write.paramsArray) {
+      write.paramsArray->GetLength(&length);
+    }
+    if (!length) {
+      continue;
+    }
+
+    DebugOnly<nsresult> rv = write.stmt->BindParameters(write.paramsArray);
+    NS_ASSERT_SUCCESS(rv);
+    rv = write.stmt->ExecuteAsync(write.listener, getter_AddRefs(handle));
+    NS_ASSERT_SUCCESS(rv);
+  }
+
+  if (transaction) {
+    DebugOnly<nsresult> rv = aDBState->dbConn->ExecuteSimpleSQLAsync(
+      NS_LITERAL_CSTRING("COMMIT"), nullptr, getter_AddRefs(handle));
+    NS_ASSERT_SUCCESS(rv);
+  }
+}
+
 // Null out the listeners, and the database connection itself. This
 // will not null out the statements, cancel a pending read or
 // asynchronously close the connection -- these must be done
@@ -2223,6 +2338,9 @@ nsCookieService::RemoveAll()
       CancelAsyncRead(true);
     }
 
+    // Keep earlier writes ahead of the delete.
+    FlushPendingWrites(mDefaultDBState);
+
     nsCOMPtr<mozIStorageAsyncStatement> stmt;
     nsresult rv = mDefaultDBState->dbConn->CreateAsyncStatement(NS_LITERAL_CSTRING(
       "DELETE FROM moz_cookies"), getter_AddRefs(stmt));
@@ -3009,6 +3127,7 @@ nsCookieService::ImportCookies(nsIFile *aCookieFile)
     uint32_t length;
     paramsArray->GetLength(&length);
     if (length) {
+      FlushPendingWrites(mDefaultDBState);
       rv = mDefaultDBState->stmtInsert->BindParameters(paramsArray);
       NS_ASSERT_SUCCESS(rv);
       nsCOMPtr<mozIStoragePendingStatement> handle;
@@ -3067,6 +3186,35 @@ DomainMatches(nsCookie* aCookie, const nsACString& aHost) {
       (aCookie->IsDomain() && StringEndsWith(aHost, aCookie->Host()));
 }
 
+nsCookieHostCache*
+nsCookieEntry::GetHostCache(const nsACString& aHost)
+{
+  for (uint32_t i = 0; i < mHostCaches.Length(); ++i) {
+    if (mHostCaches[i].mHost == aHost) {
+      return &mHostCaches[i];
+    }
+  }
+
+  if (mHostCaches.Length() >= kMaxHostCaches) {
+    mHostCaches.RemoveElementAt(0);
+  }
+
+  nsCookieHostCache* cache = mHostCaches.AppendElement();
+  cache->mHost = aHost;
+  for (IndexType i = 0; i < mCookies.Length(); ++i) {
+    // check the host, since the base domain lookup is conservative.
+    if (DomainMatches(mCookies[i], aHost)) {
+      cache->mCookies.AppendElement(mCookies[i]);
+    }
+  }
+
+  // cookies are sent in order of path length; longest to shortest.
+  // this is required per RFC2109.  if cookies match in length,
+  // then sort by creation time (see bug 236772).
+  cache->mCookies.Sort(CompareCookiesForSending());
+  return cache;
+}
+
 static bool
 PathMatches(nsCookie* aCookie, const nsACString& aPath) {
   // calculate cookie path length, excluding trailing '/'
@@ -3173,53 +3321,93 @@ nsCookieService::GetCookieStringInternal(nsIURI *aHostURI,
   if (!entry)
     return;
 
-  // iterate the cookies!
-  const nsCookieEntry::ArrayType &cookies = entry->GetCookies();
-  for (nsCookieEntry::IndexType i = 0; i < cookies.Length(); ++i) {
-    cookie = cookies[i];
+  // the cookies matching this host, already sorted for sending.
+  nsCookieHostCache* cache = entry->GetHostCache(hostFromURI);
+
+  // reuse the last header built for this host if it was for the same kind
+  // of request and none of its cookies has expired since.
+  if (cache->mHasHeader &&
+      cache->mHeaderSecure == isSecure &&
+      cache->mHeaderHttpBound == aHttpBound &&
+      cache->mHeaderExpiry > currentTime &&
+      cache->mHeaderPath == pathFromURI) {
+    foundCookieList.AppendElements(cache->mHeaderCookies);
+    aCookieString = cache->mHeader;
+  } else {
+    int64_t earliestExpiry = INT64_MAX;
+    for (uint32_t i = 0; i < cache->mCookies.Length(); ++i) {
+      cookie = cache->mCookies[i];
 
-    // check the host, since the base domain lookup is conservative.
-    if (!DomainMatches(cookie, hostFromURI))
-      continue;
+      // if the cookie is secure and the host scheme isn't, we can't send it
+      if (cookie->IsSecure() && !isSecure)
+        continue;
 
-    // if the cookie is secure and the host scheme isn't, we can't send it
-    if (cookie->IsSecure() && !isSecure)
-      continue;
+      // if the cookie is httpOnly and it's not going directly to the HTTP
+      // connection, don't send it
+      if (cookie->IsHttpOnly() && !aHttpBound)
+        continue;
 
-    // if the cookie is httpOnly and it's not going directly to the HTTP
-    // connection, don't send it
-    if (cookie->IsHttpOnly() && !aHttpBound)
-      continue;
+      // if the nsIURI path doesn't match the cookie path, don't send it back
+      if (!PathMatches(cookie, pathFromURI))
+        continue;
 
-    // if the nsIURI path doesn't match the cookie path, don't send it back
-    if (!PathMatches(cookie, pathFromURI))
-      continue;
+      // check if the cookie has expired
+      if (cookie->Expiry() <= currentTime) {
+        continue;
+      }
 
-    // check if the cookie has expired
-    if (cookie->Expiry() <= currentTime) {
-      continue;
-    }
+      foundCookieList.AppendElement(cookie);
+      if (cookie->Expiry() < earliestExpiry) {
+        earliestExpiry = cookie->Expiry();
+      }
 
-    // all checks passed - add to list and check if lastAccessed stamp needs updating
-    foundCookieList.AppendElement(cookie);
-    if (cookie->IsStale()) {
-      stale = true;
+      // check if we have anything to write
+      if (!cookie->Name().IsEmpty() || !cookie->Value().IsEmpty()) {
+        // if we've already added a cookie to the return list, append a "; "
+        // so that subsequent cookies are delimited in the final list.
+        if (!aCookieString.IsEmpty()) {
+          aCookieString.AppendLiteral("; ");
+        }
+
+        if (!cookie->Name().IsEmpty()) {
+          // we have a name and value - write both
+          aCookieString += cookie->Name() + NS_LITERAL_CSTRING("=") + cookie->Value();
+        } else {
+          // just write value
+          aCookieString += cookie->Value();
+        }
+      }
     }
+
+    cache->mHasHeader = true;
+    cache->mHeaderSecure = isSecure;
+    cache->mHeaderHttpBound = aHttpBound;
+    cache->mHeaderExpiry = earliestExpiry;
+    cache->mHeaderPath = pathFromURI;
+    cache->mHeader = aCookieString;
+    cache->mHeaderCookies = foundCookieList;
   }
 
   int32_t count = foundCookieList.Length();
   if (count == 0)
     return;
 
+  for (int32_t i = 0; i < count; ++i) {
+    if (foundCookieList[i]->IsStale()) {
+      stale = true;
+      break;
+    }
+  }
+
   // update lastAccessed timestamps. we only do this if the timestamp is stale
   // by a certain amount, to avoid thrashing the db during pageload.
   if (stale) {
-    // Create an array of parameters to bind to our update statement. Batching
-    // is OK here since we're updating cookies with no interleaved operations.
+    // Batching is OK here since we're updating cookies with no interleaved
+    // operations; the updates are written out with the next flush.
     nsCOMPtr<mozIStorageBindingParamsArray> paramsArray;
-    mozIStorageAsyncStatement* stmt = mDBState->stmtUpdate;
     if (mDBState->dbConn) {
-      stmt->NewBindingParamsArray(getter_AddRefs(paramsArray));
+      paramsArray = PendingParamsFor(mDBState, mDBState->stmtUpdate,
+                                     mDBState->updateListener);
     }
 
     for (int32_t i = 0; i < count; ++i) {
@@ -3229,45 +3417,6 @@ nsCookieService::GetCookieStringInternal(nsIURI *aHostURI,
         UpdateCookieInList(cookie, currentTimeInUsec, paramsArray);
       }
     }
-    // Update the database now if necessary.
-    if (paramsArray) {
-      uint32_t length;
-      paramsArray->GetLength(&length);
-      if (length) {
-        DebugOnly<nsresult> rv = stmt->BindParameters(paramsArray);
-        NS_ASSERT_SUCCESS(rv);
-        nsCOMPtr<mozIStoragePendingStatement> handle;
-        rv = stmt->ExecuteAsync(mDBState->updateListener,
-          getter_AddRefs(handle));
-        NS_ASSERT_SUCCESS(rv);
-      }
-    }
-  }
-
-  // return cookies in order of path length; longest to shortest.
-  // this is required per RFC2109.  if cookies match in length,
-  // then sort by creation time (see bug 236772).
-  foundCookieList.Sort(CompareCookiesForSending());
-
-  for (int32_t i = 0; i < count; ++i) {
-    cookie = foundCookieList.ElementAt(i);
-
-    // check if we have anything to write
-    if (!cookie->Name().IsEmpty() || !cookie->Value().IsEmpty()) {
-      // if we've already added a cookie to the return list, append a "; " so
-      // that subsequent cookies are delimited in the final list.
-      if (!aCookieString.IsEmpty()) {
-        aCookieString.AppendLiteral("; ");
-      }
-
-      if (!cookie->Name().IsEmpty()) {
-        // we have a name and value - write both
-        aCookieString += cookie->Name() + NS_LITERAL_CSTRING("=") + cookie->Value();
-      } else {
-        // just write value
-        aCookieString += cookie->Value();
-      }
-    }
   }
 
   if (!aCookieString.IsEmpty())
@@ -4277,10 +4426,10 @@ nsCookieService::PurgeCookies(int64_t aCurrentTimeInUsec)
 
   // Create a params array to batch the removals. This is OK here because
   // all the removals are in order, and there are no interleaved additions.
-  mozIStorageAsyncStatement *stmt = mDBState->stmtDelete;
   nsCOMPtr<mozIStorageBindingParamsArray> paramsArray;
   if (mDBState->dbConn) {
-    stmt->NewBindingParamsArray(getter_AddRefs(paramsArray));
+    paramsArray = PendingParamsFor(mDBState, mDBState->stmtDelete,
+                                   mDBState->removeListener);
   }
 
   int64_t currentTime = aCurrentTimeInUsec / PR_USEC_PER_SEC;
@@ -4346,19 +4495,6 @@ nsCookieService::PurgeCookies(int64_t aCurrentTimeInUsec)
     RemoveCookieFromList(purgeList[i], paramsArray);
   }
 
-  // Update the database if we have entries to purge.
-  if (paramsArray) {
-    uint32_t length;
-    paramsArray->GetLength(&length);
-    if (length) {
-      DebugOnly<nsresult> rv = stmt->BindParameters(paramsArray);
-      NS_ASSERT_SUCCESS(rv);
-      nsCOMPtr<mozIStoragePendingStatement> handle;
-      rv = stmt->ExecuteAsync(mDBState->removeListener, getter_AddRefs(handle));
-      NS_ASSERT_SUCCESS(rv);
-    }
-  }
-
   // reset the oldest time indicator
   mDBState->cookieOldestTime = oldestTime;
 
@@ -4776,10 +4912,10 @@ nsCookieService::RemoveCookieFromList(const nsListIter              &aIter,
   if (!aIter.Cookie()->IsSession() && mDBState->dbConn) {
     // Use the asynchronous binding methods to ensure that we do not acquire
     // the database lock.
-    mozIStorageAsyncStatement *stmt = mDBState->stmtDelete;
     nsCOMPtr<mozIStorageBindingParamsArray> paramsArray(aParamsArray);
     if (!paramsArray) {
-      stmt->NewBindingParamsArray(getter_AddRefs(paramsArray));
+      paramsArray = PendingParamsFor(mDBState, mDBState->stmtDelete,
+                                     mDBState->removeListener);
     }
 
     nsCOMPtr<mozIStorageBindingParams> params;
@@ -4800,17 +4936,9 @@ nsCookieService::RemoveCookieFromList(const nsListIter              &aIter,
 
     rv = paramsArray->AddParams(params);
     NS_ASSERT_SUCCESS(rv);
-
-    // If we weren't given a params array, we'll need to remove it ourselves.
-    if (!aParamsArray) {
-      rv = stmt->BindParameters(paramsArray);
-      NS_ASSERT_SUCCESS(rv);
-      nsCOMPtr<mozIStoragePendingStatement> handle;
-      rv = stmt->ExecuteAsync(mDBState->removeListener, getter_AddRefs(handle));
-      NS_ASSERT_SUCCESS(rv);
-    }
   }
 
+  aIter.entry->InvalidateHostCaches();
   if (aIter.entry->GetCookies().Length() == 1) {
     // we're removing the last element in the array - so just remove the entry
     // from the hash. note that the entryclass' dtor will take care of
@@ -4917,6 +5045,7 @@ nsCookieService::AddCookieToList(const nsCookieKey             &aKey,
   NS_ASSERTION(entry, "can't insert element into a null entry!");
 
   entry->GetCookies().AppendElement(aCookie);
+  entry->InvalidateHostCaches();
   ++aDBState->cookieCount;
 
   // keep track of the oldest cookie, for when it comes time to purge
@@ -4924,22 +5053,15 @@ nsCookieService::AddCookieToList(const nsCookieKey             &aKey,
 
   // if it's a non-session cookie and hasn't just been read from the db, write it out.
   if (aWriteToDB && !aCookie->IsSession() && aDBState->dbConn) {
-    mozIStorageAsyncStatement *stmt = aDBState->stmtInsert;
+    // If we were supplied an array to store parameters, someone up the
+    // stack will execute it; otherwise the write is queued for the next
+    // flush.
     nsCOMPtr<mozIStorageBindingParamsArray> paramsArray(aParamsArray);
     if (!paramsArray) {
-      stmt->NewBindingParamsArray(getter_AddRefs(paramsArray));
+      paramsArray = PendingParamsFor(aDBState, aDBState->stmtInsert,
+                                     aDBState->insertListener);
     }
     bindCookieParameters(paramsArray, aKey, aCookie);
-
-    // If we were supplied an array to store parameters, we shouldn't call
-    // executeAsync - someone up the stack will do this for us.
-    if (!aParamsArray) {
-      DebugOnly<nsresult> rv = stmt->BindParameters(paramsArray);
-      NS_ASSERT_SUCCESS(rv);
-      nsCOMPtr<mozIStoragePendingStatement> handle;
-      rv = stmt->ExecuteAsync(mDBState->insertListener, getter_AddRefs(handle));
-      NS_ASSERT_SUCCESS(rv);
-    }
   }
 }
 
@@ -20,6 +20,7 @@
 #include "nsTHashtable.h"
 #include "mozIStorageStatement.h"
 #include "mozIStorageAsyncStatement.h"
+#include "mozIStorageBindingParamsArray.h"
 #include "mozIStoragePendingStatement.h"
 #include "mozIStorageConnection.h"
 #include "mozIStorageRow.h"
@@ -28,6 +29,7 @@
 #include "mozIStorageFunction.h"
 #include "nsIVariant.h"
 #include "nsIFile.h"
+#include "nsITimer.h"
 #include "mozilla/BasePrincipal.h"
 
 #include "mozilla/MemoryReporting.h"
@@ -114,6 +116,33 @@ public:
   NeckoOriginAttributes mOriginAttributes;
 };
 
+// The cookies of an nsCookieEntry that domain-match one host, in the order
+// they are sent in a Cookie header, plus the last header built from them.
+// The cookies are not owned: the cache is dropped whenever the entry's
+// cookie list changes.
+struct nsCookieHostCache
+{
+  nsCookieHostCache()
+    : mHeaderSecure(false)
+    , mHeaderHttpBound(false)
+    , mHeaderExpiry(0)
+    , mHasHeader(false)
+  {}
+
+  nsCString           mHost;
+  nsTArray<nsCookie*> mCookies;
+
+  // the cookies included in mHeader, and the request they were picked for.
+  // mHeaderExpiry is the earliest expiry among them.
+  nsCString           mHeaderPath;
+  bool                mHeaderSecure;
+  bool                mHeaderHttpBound;
+  int64_t             mHeaderExpiry;
+  bool                mHasHeader;
+  nsCString           mHeader;
+  nsTArray<nsCookie*> mHeaderCookies;
+};
+
 // Inherit from nsCookieKey so this can be stored in nsTHashTable
 // TODO: why aren't we using nsClassHashTable<nsCookieKey, ArrayType>?
 class nsCookieEntry : public nsCookieKey
@@ -122,6 +151,7 @@ class nsCookieEntry : public nsCookieKey
     // Hash methods
     typedef nsTArray< RefPtr<nsCookie> > ArrayType;
     typedef ArrayType::index_type IndexType;
+    typedef nsTArray<nsCookieHostCache> HostCacheArray;
 
     explicit nsCookieEntry(KeyTypePointer aKey)
      : nsCookieKey(aKey)
@@ -139,10 +169,16 @@ class nsCookieEntry : public nsCookieKey
 
     inline ArrayType& GetCookies() { return mCookies; }
 
+    // Returns the cache for aHost, building it if needed. Anything that
+    // adds or removes cookies must call InvalidateHostCaches().
+    nsCookieHostCache* GetHostCache(const nsACString& aHost);
+    inline void InvalidateHostCaches() { mHostCaches.Clear(); }
+
     size_t SizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf) const;
 
   private:
     ArrayType mCookies;
+    HostCacheArray mHostCaches;
 };
 
 // encapsulates a (key, nsCookie) tuple for temporary storage purposes.
@@ -190,6 +226,18 @@ public:
   nsCOMPtr<mozIStorageAsyncStatement> stmtUpdate;
   CorruptFlag                     corruptFlag;
 
+  // Writes waiting to be flushed to dbConn, in the order they were made.
+  // Consecutive writes through the same statement share a params array.
+  // They are all executed in one transaction when flushTimer fires.
+  struct PendingWrite
+  {
+    nsCOMPtr<mozIStorageAsyncStatement>     stmt;
+    nsCOMPtr<mozIStorageBindingParamsArray> paramsArray;
+    nsCOMPtr<mozIStorageStatementCallback>  listener;
+  };
+  nsTArray<PendingWrite>          pendingWrites;
+  nsCOMPtr<nsITimer>              flushTimer;
+
   // Various parts representing asynchronous read state. These are useful
   // while the background read is taking place.
   nsCOMPtr<mozIStorageConnection>       syncConn;
@@ -279,6 +327,9 @@ class nsCookieService final : public nsICookieService
     nsresult                      CreateTableForSchemaVersion5();
     void                          CloseDBStates();
     void                          CleanupCachedStatements();
+    mozIStorageBindingParamsArray* PendingParamsFor(DBState* aDBState, mozIStorageAsyncStatement* aStmt, mozIStorageStatementCallback* aListener);
+    void                          FlushPendingWrites(DBState* aDBState);
+    static void                   FlushTimerCallback(nsITimer* aTimer, void* aClosure);
     void                          CleanupDefaultDBConnection();
     void                          HandleDBClosed(DBState* aDBState);
     void                          HandleCorruptDB(DBState* aDBState);
@@ -14,7 +14,9 @@
 #include "mozilla/StaticPtr.h"
 #include "MainThreadUtils.h"
 #include "mozilla/DebugOnly.h"
+#include "mozilla/Unused.h"
 #include "mozilla/net/DNS.h"
+#include "nsString.h"
 #include <algorithm>
 #include "prerror.h"
 
@@ -31,6 +33,20 @@
 #include <windns.h>
 #endif
 
+#if RESQUERY_AVAILABLE
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <arpa/nameser.h>
+#include <resolv.h>
+#endif
+
+#if ASYNC_GETADDRINFO_AVAILABLE
+#include <netdb.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#endif
+
 namespace mozilla {
 namespace net {
 
@@ -244,6 +260,126 @@ _GetTTLData_Windows(const char* aHost, uint16_t* aResult, uint16_t aAddressFamil
 }
 #endif
 
+#if RESQUERY_AVAILABLE
+//////////////////////////
+// RES_QUERY TTL LOOKUP //
+//////////////////////////
+
+// If successful, returns in aResult a TTL value that is smaller or equal with
+// the one already there, taken from the answer records of a res_nquery for
+// aRequestType.
+static MOZ_ALWAYS_INLINE nsresult
+_GetMinTTLForRequestType_ResQuery(const char* aHost, int aRequestType,
+                                  unsigned int* aResult)
+{
+  MOZ_ASSERT(aHost);
+  MOZ_ASSERT(aResult);
+
+  // Each thread needs its own resolver state.
+  struct __res_state state;
+  memset(&state, 0, sizeof(state));
+  if (res_ninit(&state) != 0) {
+    LOG_WARNING("res_ninit failed.\n");
+    return NS_ERROR_UNEXPECTED;
+  }
+
+  unsigned char answer[NS_PACKETSZ * 4];
+  int length = res_nquery(&state, aHost, ns_c_in, aRequestType, answer,
+                          sizeof(answer));
+  res_nclose(&state);
+  if (length < 0) {
+    LOG("No DNS records found for %s. aRequestType = %X\n",
+        aHost, aRequestType);
+    return NS_ERROR_FAILURE;
+  }
+
+  ns_msg message;
+  if (ns_initparse(answer, length, &message) < 0) {
+    LOG_WARNING("Could not parse DNS response for %s.\n", aHost);
+    return NS_ERROR_UNEXPECTED;
+  }
+
+  bool found = false;
+  for (int i = 0; i < ns_msg_count(message, ns_s_an); i++) {
+    ns_rr record;
+    if (ns_parserr(&message, ns_s_an, i, &record) < 0) {
+      break;
+    }
+
+    if (ns_rr_type(record) == aRequestType) {
+      *aResult = std::min<unsigned int>(*aResult, ns_rr_ttl(record));
+      found = true;
+    } else {
+      LOG("Received unexpected record type %u in response for %s.\n",
+          ns_rr_type(record), aHost);
+    }
+  }
+
+  return found ? NS_OK : NS_ERROR_FAILURE;
+}
+
+static MOZ_ALWAYS_INLINE nsresult
+_GetTTLData_ResQuery(const char* aHost, uint16_t* aResult,
+                     uint16_t aAddressFamily)
+{
+  MOZ_ASSERT(aHost);
+  MOZ_ASSERT(aResult);
+  if (aAddressFamily != PR_AF_UNSPEC &&
+      aAddressFamily != PR_AF_INET &&
+      aAddressFamily != PR_AF_INET6) {
+    return NS_ERROR_UNEXPECTED;
+  }
+
+  // As on Windows, ask for A and/or AAAA records rather than ANY.
+  unsigned int ttl = -1;
+  if (aAddressFamily == PR_AF_UNSPEC || aAddressFamily == PR_AF_INET) {
+    _GetMinTTLForRequestType_ResQuery(aHost, ns_t_a, &ttl);
+  }
+  if (aAddressFamily == PR_AF_UNSPEC || aAddressFamily == PR_AF_INET6) {
+    _GetMinTTLForRequestType_ResQuery(aHost, ns_t_aaaa, &ttl);
+  }
+
+  if (ttl == (unsigned int) -1) {
+    LOG("No useable TTL found.");
+    return NS_ERROR_FAILURE;
+  }
+
+  *aResult = std::min<unsigned int>(ttl, AddrInfo::NO_TTL_DATA - 1);
+  return NS_OK;
+}
+#endif
+
+#if TTL_AVAILABLE
+// Sets the TTL of a successful lookup, looked up by its canonical name if it
+// has one.
+static void
+_SetTTLData(const char* aHost, uint16_t aAddressFamily, AddrInfo* aAddrInfo)
+{
+  // Figure out the canonical name, or if that fails, just use the host name
+  // we have.
+  const char *name = nullptr;
+  if (aAddrInfo->mCanonicalName) {
+    name = aAddrInfo->mCanonicalName;
+  } else {
+    name = aHost;
+  }
+
+  LOG("Getting TTL for %s (cname = %s).", aHost, name);
+  uint16_t ttl = 0;
+#if DNSQUERY_AVAILABLE
+  nsresult ttlRv = _GetTTLData_Windows(name, &ttl, aAddressFamily);
+#else
+  nsresult ttlRv = _GetTTLData_ResQuery(name, &ttl, aAddressFamily);
+#endif
+  if (NS_SUCCEEDED(ttlRv)) {
+    aAddrInfo->ttl = ttl;
+    LOG("Got TTL %u for %s (name = %s).", ttl, aHost, name);
+  } else {
+    LOG_WARNING("Could not get TTL for %s (cname = %s).", aHost, name);
+  }
+}
+#endif
+
 ////////////////////////////////////
 // PORTABLE RUNTIME IMPLEMENTATION//
 ////////////////////////////////////
@@ -295,6 +431,157 @@ _GetAddrInfo_Portable(const char* aCanonHost, uint16_t aAddressFamily,
   return NS_OK;
 }
 
+#if ASYNC_GETADDRINFO_AVAILABLE
+/////////////////////////////////
+// GETADDRINFO_A IMPLEMENTATION//
+/////////////////////////////////
+
+// A lookup submitted to getaddrinfo_a. glibc keeps pointers to the request,
+// hints and host name until the lookup completes, so they live here.
+struct AsyncGetAddrInfo
+{
+  struct gaicb mRequest;
+  struct addrinfo mHints;
+  struct sigevent mEvent;
+  nsCString mHost;
+  uint16_t mAddressFamily;
+  uint16_t mFlags;
+  bool mGetTtl;
+  GetAddrInfoCallback mCallback;
+  void* mClosure;
+};
+
+static AddrInfo*
+_AddrInfoFromAddrinfo(const char* aHost, const struct addrinfo* aList,
+                      bool aFilterNameCollision)
+{
+  const uint32_t nameCollisionAddr = htonl(0x7f003535); // 127.0.53.53
+
+  nsAutoPtr<AddrInfo> ai(new AddrInfo(aHost, aList ? aList->ai_canonname
+                                                   : nullptr));
+  for (const struct addrinfo* cur = aList; cur; cur = cur->ai_next) {
+    PRNetAddr prAddr;
+    memset(&prAddr, 0, sizeof(prAddr));
+    if (cur->ai_family == AF_INET) {
+      const struct sockaddr_in* sin =
+        reinterpret_cast<const struct sockaddr_in*>(cur->ai_addr);
+      if (aFilterNameCollision && sin->sin_addr.s_addr == nameCollisionAddr) {
+        continue;
+      }
+      prAddr.inet.family = PR_AF_INET;
+      prAddr.inet.port = sin->sin_port;
+      prAddr.inet.ip = sin->sin_addr.s_addr;
+    } else if (cur->ai_family == AF_INET6) {
+      const struct sockaddr_in6* sin6 =
+        reinterpret_cast<const struct sockaddr_in6*>(cur->ai_addr);
+      prAddr.ipv6.family = PR_AF_INET6;
+      prAddr.ipv6.port = sin6->sin6_port;
+      prAddr.ipv6.flowinfo = sin6->sin6_flowinfo;
+      memcpy(&prAddr.ipv6.ip, &sin6->sin6_addr, sizeof(prAddr.ipv6.ip));
+      prAddr.ipv6.scope_id = sin6->sin6_scope_id;
+    } else {
+      continue;
+    }
+    ai->AddAddress(new NetAddrElement(&prAddr));
+  }
+
+  return ai.forget();
+}
+
+static void
+_GetAddrInfoAsyncComplete(union sigval aValue)
+{
+  nsAutoPtr<AsyncGetAddrInfo> lookup(
+    static_cast<AsyncGetAddrInfo*>(aValue.sival_ptr));
+
+  AddrInfo* ai = nullptr;
+  nsresult rv = NS_ERROR_UNKNOWN_HOST;
+
+  int err = gai_error(&lookup->mRequest);
+  if (err == 0) {
+    bool filterNameCollision =
+      !(lookup->mFlags & nsHostResolver::RES_ALLOW_NAME_COLLISION);
+    ai = _AddrInfoFromAddrinfo(lookup->mHost.get(), lookup->mRequest.ar_result,
+                               filterNameCollision);
+    freeaddrinfo(lookup->mRequest.ar_result);
+    if (ai->mAddresses.isEmpty()) {
+      delete ai;
+      ai = nullptr;
+    } else {
+      rv = NS_OK;
+    }
+  } else {
+    LOG("getaddrinfo_a failed for %s: %s.", lookup->mHost.get(),
+        gai_strerror(err));
+  }
+
+#if TTL_AVAILABLE
+  if (ai && lookup->mGetTtl) {
+    _SetTTLData(lookup->mHost.get(), lookup->mAddressFamily, ai);
+  }
+#endif
+
+  lookup->mCallback(rv, ai, lookup->mClosure);
+}
+
+nsresult
+GetAddrInfoAsync(const char* aHost, uint16_t aAddressFamily, uint16_t aFlags,
+                 bool aGetTtl, GetAddrInfoCallback aCallback, void* aClosure)
+{
+  if (NS_WARN_IF(!aHost) || NS_WARN_IF(!aCallback)) {
+    return NS_ERROR_NULL_POINTER;
+  }
+
+  nsAutoPtr<AsyncGetAddrInfo> lookup(new AsyncGetAddrInfo());
+  lookup->mHost = aHost;
+  lookup->mAddressFamily = aAddressFamily;
+  lookup->mFlags = aFlags;
+  lookup->mGetTtl = aGetTtl;
+  lookup->mCallback = aCallback;
+  lookup->mClosure = aClosure;
+
+  // Mirror the flags _GetAddrInfo_Portable passes to PR_GetAddrInfoByName.
+  memset(&lookup->mHints, 0, sizeof(lookup->mHints));
+  switch (aAddressFamily) {
+    case PR_AF_INET:
+      lookup->mHints.ai_family = AF_INET;
+      break;
+    case PR_AF_INET6:
+      lookup->mHints.ai_family = AF_INET6;
+      break;
+    default:
+      lookup->mHints.ai_family = AF_UNSPEC;
+      break;
+  }
+  lookup->mHints.ai_socktype = SOCK_STREAM;
+  lookup->mHints.ai_flags = AI_ADDRCONFIG;
+  if ((aFlags & nsHostResolver::RES_CANON_NAME) || aGetTtl) {
+    lookup->mHints.ai_flags |= AI_CANONNAME;
+  }
+
+  memset(&lookup->mRequest, 0, sizeof(lookup->mRequest));
+  lookup->mRequest.ar_name = lookup->mHost.get();
+  lookup->mRequest.ar_request = &lookup->mHints;
+
+  memset(&lookup->mEvent, 0, sizeof(lookup->mEvent));
+  lookup->mEvent.sigev_notify = SIGEV_THREAD;
+  lookup->mEvent.sigev_notify_function = _GetAddrInfoAsyncComplete;
+  lookup->mEvent.sigev_value.sival_ptr = lookup.get();
+
+  struct gaicb* requests[] = { &lookup->mRequest };
+  int err = getaddrinfo_a(GAI_NOWAIT, requests, 1, &lookup->mEvent);
+  if (err != 0) {
+    LOG_WARNING("getaddrinfo_a could not start a lookup for %s: %s.", aHost,
+                gai_strerror(err));
+    return NS_ERROR_FAILURE;
+  }
+
+  // The completion function owns the lookup from here on.
+  Unused << lookup.forget();
+  return NS_OK;
+}
+#endif
+
 //////////////////////////////////////
 // COMMON/PLATFORM INDEPENDENT CODE //
 //////////////////////////////////////
@@ -328,7 +615,7 @@ GetAddrInfo(const char* aHost, uint16_t aAddressFamily, uint16_t aFlags,
     return NS_ERROR_NULL_POINTER;
   }
 
-#if DNSQUERY_AVAILABLE
+#if TTL_AVAILABLE
   // The GetTTLData needs the canonical name to function properly
   if (aGetTtl) {
     aFlags |= nsHostResolver::RES_CANON_NAME;
@@ -339,26 +626,9 @@ GetAddrInfo(const char* aHost, uint16_t aAddressFamily, uint16_t aFlags,
   nsresult rv = _GetAddrInfo_Portable(aHost, aAddressFamily, aFlags,
                                       aNetworkInterface, aAddrInfo);
 
-#if DNSQUERY_AVAILABLE
+#if TTL_AVAILABLE
   if (aGetTtl && NS_SUCCEEDED(rv)) {
-    // Figure out the canonical name, or if that fails, just use the host name
-    // we have.
-    const char *name = nullptr;
-    if (*aAddrInfo != nullptr && (*aAddrInfo)->mCanonicalName) {
-      name = (*aAddrInfo)->mCanonicalName;
-    } else {
-      name = aHost;
-    }
-
-    LOG("Getting TTL for %s (cname = %s).", aHost, name);
-    uint16_t ttl = 0;
-    nsresult ttlRv = _GetTTLData_Windows(name, &ttl, aAddressFamily);
-    if (NS_SUCCEEDED(ttlRv)) {
-      (*aAddrInfo)->ttl = ttl;
-      LOG("Got TTL %u for %s (name = %s).", ttl, aHost, name);
-    } else {
-      LOG_WARNING("Could not get TTL for %s (cname = %s).", aHost, name);
-    }
+    _SetTTLData(aHost, aAddressFamily, *aAddrInfo);
   }
 #endif
 
@@ -12,12 +12,24 @@
 
 #if defined(XP_WIN)
 #define DNSQUERY_AVAILABLE 1
+#define RESQUERY_AVAILABLE 0
+#define TTL_AVAILABLE 1
+#elif defined(XP_LINUX) && defined(__GLIBC__) && defined(HAVE_RES_NINIT)
+#define DNSQUERY_AVAILABLE 0
+#define RESQUERY_AVAILABLE 1
 #define TTL_AVAILABLE 1
 #else
 #define DNSQUERY_AVAILABLE 0
+#define RESQUERY_AVAILABLE 0
 #define TTL_AVAILABLE 0
 #endif
 
+#if defined(XP_LINUX) && defined(__GLIBC__)
+#define ASYNC_GETADDRINFO_AVAILABLE 1
+#else
+#define ASYNC_GETADDRINFO_AVAILABLE 0
+#endif
+
 namespace mozilla {
 namespace net {
 
@@ -42,6 +54,25 @@ nsresult
 GetAddrInfo(const char* aHost, uint16_t aAddressFamily, uint16_t aFlags,
             const char* aNetworkInterface, AddrInfo** aAddrInfo, bool aGetTtl);
 
+#if ASYNC_GETADDRINFO_AVAILABLE
+typedef void (*GetAddrInfoCallback)(nsresult aStatus, AddrInfo* aAddrInfo,
+                                    void* aClosure);
+
+/**
+ * Start looking up a host by name without blocking the calling thread. The
+ * arguments are the same as for GetAddrInfo, except that the result is passed
+ * to aCallback, which takes ownership of it and is called on a thread owned by
+ * the system resolver.
+ *
+ * @return An error if the lookup could not be started, in which case
+ *     aCallback will not be called and the caller should fall back to
+ *     GetAddrInfo.
+ */
+nsresult
+GetAddrInfoAsync(const char* aHost, uint16_t aAddressFamily, uint16_t aFlags,
+                 bool aGetTtl, GetAddrInfoCallback aCallback, void* aClosure);
+#endif
+
 /**
  * Initialize the GetAddrInfo module.
  *
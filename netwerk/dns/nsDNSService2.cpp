@@ -32,6 +32,8 @@
 #include "nsProxyRelease.h"
 #include "nsIObserverService.h"
 #include "nsINetworkLinkService.h"
+#include "nsAppDirectoryServiceDefs.h"
+#include "nsDirectoryServiceUtils.h"
 
 #include "mozilla/Attributes.h"
 #include "mozilla/net/NeckoCommon.h"
@@ -52,6 +54,9 @@ static const char kPrefBlockDotOnion[]       = "network.dns.blockDotOnion";
 static const char kPrefDnsLocalDomains[]     = "network.dns.localDomains";
 static const char kPrefDnsOfflineLocalhost[] = "network.dns.offline-localhost";
 static const char kPrefDnsNotifyResolution[] = "network.dns.notifyResolution";
+static const char kPrefDnsDiskCache[]        = "network.dns.disk-cache";
+
+static const char kDnsCacheFileName[]        = "dnscache.bin";
 
 //-----------------------------------------------------------------------------
 
@@ -542,6 +547,7 @@ nsDNSService::Init()
     bool     blockDotOnion    = true;
     int      proxyType        = nsIProtocolProxyService::PROXYCONFIG_DIRECT;
     bool     notifyResolution = false;
+    bool     diskCache        = true;
 
     nsAdoptingCString ipv4OnlyDomains;
     nsAdoptingCString localDomains;
@@ -568,6 +574,7 @@ nsDNSService::Init()
         // If a manual proxy is in use, disable prefetch implicitly
         prefs->GetIntPref("network.proxy.type", &proxyType);
         prefs->GetBoolPref(kPrefDnsNotifyResolution, &notifyResolution);
+        prefs->GetBoolPref(kPrefDnsDiskCache, &diskCache);
 
         if (mFirstTime) {
             mFirstTime = false;
@@ -583,6 +590,7 @@ nsDNSService::Init()
             prefs->AddObserver(kPrefDisablePrefetch, this, false);
             prefs->AddObserver(kPrefBlockDotOnion, this, false);
             prefs->AddObserver(kPrefDnsNotifyResolution, this, false);
+            prefs->AddObserver(kPrefDnsDiskCache, this, false);
 
             // Monitor these to see if there is a change in proxy configuration
             // If a manual proxy is in use, disable prefetch implicitly
@@ -606,6 +614,23 @@ nsDNSService::Init()
                                          defaultCacheLifetime,
                                          defaultGracePeriod,
                                          getter_AddRefs(res));
+
+    // Seed the cache with the records persisted by the last session. Records
+    // that have outlived their TTL are served while they are refreshed, so
+    // startup navigations and predictor preconnects don't wait on the network.
+    nsCOMPtr<nsIFile> cacheFile;
+    if (NS_SUCCEEDED(rv) && diskCache &&
+        NS_SUCCEEDED(NS_GetSpecialDirectory(NS_APP_USER_PROFILE_50_DIR,
+                                            getter_AddRefs(cacheFile))) &&
+        NS_SUCCEEDED(cacheFile->AppendNative(nsDependentCString(kDnsCacheFileName)))) {
+        bool exists = false;
+        if (NS_SUCCEEDED(cacheFile->Exists(&exists)) && exists) {
+            res->LoadPersistedRecords(cacheFile);
+        }
+    } else {
+        cacheFile = nullptr;
+    }
+
     if (NS_SUCCEEDED(rv)) {
         // now, set all of our member variables while holding the lock
         MutexAutoLock lock(mLock);
@@ -629,6 +654,7 @@ nsDNSService::Init()
             }
         }
         mNotifyResolution = notifyResolution;
+        mCacheFile = cacheFile;
     }
 
     RegisterWeakMemoryReporter(this);
@@ -642,12 +668,17 @@ nsDNSService::Shutdown()
     UnregisterWeakMemoryReporter(this);
 
     RefPtr<nsHostResolver> res;
+    nsCOMPtr<nsIFile> cacheFile;
     {
         MutexAutoLock lock(mLock);
         res = mResolver;
         mResolver = nullptr;
+        cacheFile.swap(mCacheFile);
     }
     if (res) {
+        if (cacheFile) {
+            res->PersistRecords(cacheFile);
+        }
         res->Shutdown();
     }
 
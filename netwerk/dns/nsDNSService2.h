@@ -11,6 +11,7 @@
 #include "nsIIDNService.h"
 #include "nsIMemoryReporter.h"
 #include "nsIObserver.h"
+#include "nsIFile.h"
 #include "nsHostResolver.h"
 #include "nsAutoPtr.h"
 #include "nsString.h"
@@ -67,6 +68,10 @@ private:
     bool                                      mNotifyResolution;
     bool                                      mOfflineLocalhost;
     nsTHashtable<nsCStringHashKey>            mLocalDomains;
+
+    // mCacheFile is where the resolver's cache is persisted across sessions.
+    // It is null if the disk cache is disabled or there is no profile.
+    nsCOMPtr<nsIFile>                         mCacheFile;
 };
 
 #endif //nsDNSService2_h__
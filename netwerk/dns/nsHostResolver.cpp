@@ -13,13 +13,16 @@
 #endif
 
 #include <stdlib.h>
+#include <algorithm>
 #include <ctime>
 #include "nsHostResolver.h"
 #include "nsError.h"
 #include "nsISupportsBase.h"
 #include "nsISupportsUtils.h"
 #include "nsAutoPtr.h"
+#include "nsIFile.h"
 #include "nsPrintfCString.h"
+#include "prio.h"
 #include "prthread.h"
 #include "prerror.h"
 #include "prtime.h"
@@ -34,7 +37,9 @@
 #include "mozilla/TimeStamp.h"
 #include "mozilla/Telemetry.h"
 #include "mozilla/DebugOnly.h"
+#include "mozilla/EndianUtils.h"
 #include "mozilla/Preferences.h"
+#include "mozilla/Unused.h"
 
 using namespace mozilla;
 using namespace mozilla::net;
@@ -495,6 +500,13 @@ static const PLDHashTableOps gHostDB_ops =
 
 //----------------------------------------------------------------------------
 
+#if ASYNC_GETADDRINFO_AVAILABLE
+// When set, lookups are handed to getaddrinfo_a instead of waiting for one of
+// the MAX_RESOLVER_THREADS pool threads, which remain the fallback.
+static const char kPrefAsyncLookup[] = "network.dns.async-getaddrinfo";
+static bool sAsyncLookupEnabled = false;
+#endif
+
 #if TTL_AVAILABLE
 static const char kPrefGetTtl[] = "network.dns.get-ttl";
 static bool sGetTtlEnabled = false;
@@ -555,6 +567,16 @@ nsHostResolver::Init()
 
     mShutdown = false;
 
+#if ASYNC_GETADDRINFO_AVAILABLE
+    {
+        static bool sAsyncLookupPrefCached = false;
+        if (!sAsyncLookupPrefCached) {
+            sAsyncLookupPrefCached = true;
+            Preferences::AddBoolVarCache(&sAsyncLookupEnabled, kPrefAsyncLookup);
+        }
+    }
+#endif
+
 #if TTL_AVAILABLE
     // The preferences probably haven't been loaded from the disk yet, so we
     // need to register a callback that will set up the experiment once they
@@ -1037,7 +1059,6 @@ nsHostResolver::ConditionallyCreateThread(nsHostRecord *rec)
 nsresult
 nsHostResolver::IssueLookup(nsHostRecord *rec)
 {
-    nsresult rv = NS_OK;
     NS_ASSERTION(!rec->resolving, "record is already being resolved");
 
     // Add rec to one of the pending queues, possibly removing it from mEvictionQ.
@@ -1049,7 +1070,23 @@ nsHostResolver::IssueLookup(nsHostRecord *rec)
         PR_REMOVE_LINK(rec);
         mEvictionQSize--;
     }
-    
+
+    rec->resolving = true;
+
+#if ASYNC_GETADDRINFO_AVAILABLE
+    if (sAsyncLookupEnabled && NS_SUCCEEDED(IssueAsyncLookup(rec))) {
+        return NS_OK;
+    }
+#endif
+
+    return QueueLookup(rec);
+}
+
+nsresult
+nsHostResolver::QueueLookup(nsHostRecord *rec)
+{
+    nsresult rv = NS_OK;
+
     switch (nsHostRecord::GetPriority(rec->flags)) {
         case nsHostRecord::DNS_PRIORITY_HIGH:
             PR_APPEND_LINK(rec, &mHighQ);
@@ -1064,8 +1101,7 @@ nsHostResolver::IssueLookup(nsHostRecord *rec)
             break;
     }
     mPendingCount++;
-    
-    rec->resolving = true;
+
     rec->onQueue = true;
 
     rv = ConditionallyCreateThread(rec);
@@ -1434,6 +1470,116 @@ nsHostResolver::SizeOfIncludingThis(MallocSizeOf mallocSizeOf) const
     return n;
 }
 
+void
+nsHostResolver::AccumulateLookupTelemetry(nsHostRecord *rec, nsresult status,
+                                          const TimeStamp &startTime,
+                                          bool getTtl)
+{
+    // obtain lock to check shutdown and manage inter-module telemetry
+    MutexAutoLock lock(mLock);
+
+    if (mShutdown)
+        return;
+
+    TimeDuration elapsed = TimeStamp::Now() - startTime;
+    uint32_t millis = static_cast<uint32_t>(elapsed.ToMilliseconds());
+
+    if (NS_SUCCEEDED(status)) {
+        Telemetry::ID histogramID;
+        if (!rec->addr_info_gencnt) {
+            // Time for initial lookup.
+            histogramID = Telemetry::DNS_LOOKUP_TIME;
+        } else if (!getTtl) {
+            // Time for renewal; categorized by expiration strategy.
+            histogramID = Telemetry::DNS_RENEWAL_TIME;
+        } else {
+            // Time to get TTL; categorized by expiration strategy.
+            histogramID = Telemetry::DNS_RENEWAL_TIME_FOR_TTL;
+        }
+        Telemetry::Accumulate(histogramID, millis);
+    } else {
+        Telemetry::Accumulate(Telemetry::DNS_FAILED_LOOKUP_TIME, millis);
+    }
+}
+
+#if ASYNC_GETADDRINFO_AVAILABLE
+struct nsHostResolver::AsyncLookup
+{
+    AsyncLookup(nsHostResolver *aResolver, nsHostRecord *aRec, bool aGetTtl)
+        : mResolver(aResolver)
+        , mRec(aRec)
+        , mStartTime(TimeStamp::Now())
+        , mGetTtl(aGetTtl)
+    {}
+
+    RefPtr<nsHostResolver> mResolver;
+    nsHostRecord *mRec; // owning reference, released by OnLookupComplete
+    TimeStamp mStartTime;
+    bool mGetTtl;
+};
+
+nsresult
+nsHostResolver::IssueAsyncLookup(nsHostRecord *rec)
+{
+    mLock.AssertCurrentThreadOwns();
+
+    // Like the pool threads, only fetch the TTL for lookups that are not
+    // high priority.
+    bool getTtl = false;
+#if TTL_AVAILABLE
+    rec->mGetTtl = sGetTtlEnabled && !IsHighPriority(rec->flags);
+    getTtl = rec->mGetTtl;
+#endif
+
+    nsAutoPtr<AsyncLookup> lookup(new AsyncLookup(this, rec, getTtl));
+    nsresult rv = GetAddrInfoAsync(rec->host, rec->af, rec->flags, getTtl,
+                                   OnAsyncLookupComplete, lookup.get());
+    if (NS_FAILED(rv)) {
+        LOG(("  Asynchronous lookup for host [%s%s%s] failed to start, "
+             "using the thread pool.\n", LOG_HOST(rec->host, rec->netInterface)));
+        return rv;
+    }
+
+    LOG(("  Started asynchronous lookup for host [%s%s%s].\n",
+         LOG_HOST(rec->host, rec->netInterface)));
+    Unused << lookup.forget();
+    return NS_OK;
+}
+
+/* static */ void
+nsHostResolver::OnAsyncLookupComplete(nsresult status, AddrInfo *ai,
+                                      void *closure)
+{
+    nsAutoPtr<AsyncLookup> lookup(static_cast<AsyncLookup *>(closure));
+    nsHostResolver *resolver = lookup->mResolver;
+    nsHostRecord *rec = lookup->mRec;
+
+    resolver->AccumulateLookupTelemetry(rec, status, lookup->mStartTime,
+                                        lookup->mGetTtl);
+
+    LOG(("Asynchronous lookup completed for host [%s%s%s]: %s.\n",
+         LOG_HOST(rec->host, rec->netInterface),
+         ai ? "success" : "failure: unknown host"));
+
+    if (LOOKUP_RESOLVEAGAIN != resolver->OnLookupComplete(rec, status, ai)) {
+        return;
+    }
+
+    // We still own rec. Start the lookup over, on the thread pool if it
+    // cannot be done asynchronously, unless we are shutting down.
+    {
+        MutexAutoLock lock(resolver->mLock);
+        if (!resolver->mShutdown) {
+            if (NS_FAILED(resolver->IssueAsyncLookup(rec))) {
+                resolver->QueueLookup(rec);
+            }
+            return;
+        }
+    }
+    resolver->OnLookupComplete(rec, NS_ERROR_ABORT, nullptr);
+}
+#endif
+
 void
 nsHostResolver::ThreadFunc(void *arg)
 {
@@ -1469,31 +1615,7 @@ nsHostResolver::ThreadFunc(void *arg)
         }
 #endif
 
-        {   // obtain lock to check shutdown and manage inter-module telemetry
-            MutexAutoLock lock(resolver->mLock);
-
-            if (!resolver->mShutdown) {
-                TimeDuration elapsed = TimeStamp::Now() - startTime;
-                uint32_t millis = static_cast<uint32_t>(elapsed.ToMilliseconds());
-
-                if (NS_SUCCEEDED(status)) {
-                    Telemetry::ID histogramID;
-                    if (!rec->addr_info_gencnt) {
-                        // Time for initial lookup.
-                        histogramID = Telemetry::DNS_LOOKUP_TIME;
-                    } else if (!getTtl) {
-                        // Time for renewal; categorized by expiration strategy.
-                        histogramID = Telemetry::DNS_RENEWAL_TIME;
-                    } else {
-                        // Time to get TTL; categorized by expiration strategy.
-                        histogramID = Telemetry::DNS_RENEWAL_TIME_FOR_TTL;
-                    }
-                    Telemetry::Accumulate(histogramID, millis);
-                } else {
-                    Telemetry::Accumulate(Telemetry::DNS_FAILED_LOOKUP_TIME, millis);
-                }
-            }
-        }
+        resolver->AccumulateLookupTelemetry(rec, status, startTime, getTtl);
 
         // OnLookupComplete may release "rec", long before we lose it.
         LOG(("DNS lookup thread - lookup completed for host [%s%s%s]: %s.\n",
@@ -1579,3 +1701,351 @@ nsHostResolver::GetDNSCacheEntries(nsTArray<DNSCacheEntries> *args)
         args->AppendElement(info);
     }
 }
+
+//----------------------------------------------------------------------------
+// Persisted cache
+//
+// The file is a header followed by the positive records and then the
+// negative records, all little-endian:
+//
+//   uint32 magic, uint32 version, uint32 positive count, uint32 negative count
+//
+// and for each record:
+//
+//   uint64 expiration (PRTime), uint16 flags, uint16 af, uint16 host length,
+//   uint16 address count, host bytes, then for each address a uint16 family
+//   followed by 16 bytes of address.
+//
+// The expiration of a positive record is the end of its TTL, not the end of
+// its grace period, so that a restored record can be revalidated as soon as
+// it is used.
+
+static const uint32_t kPersistedCacheMagic = 0x43534e44;   // 'DNSC'
+static const uint32_t kPersistedCacheVersion = 1;
+static const uint32_t kPersistedCacheHeaderSize = 16;
+static const uint32_t kPersistedRecordHeaderSize = 16;
+static const uint32_t kPersistedAddrSize = 18;
+
+// Positive records that expired less than this long ago are restored stale,
+// to be served while they are refreshed.
+static const unsigned int kPersistedMaxStaleness = 24 * 60 * 60;
+// The grace period given to restored stale records.
+static const unsigned int kPersistedStaleGrace = 300;
+
+static void
+AppendUint16(nsTArray<uint8_t> &aBuf, uint16_t aValue)
+{
+    uint8_t *p = aBuf.AppendElements(sizeof(aValue));
+    LittleEndian::writeUint16(p, aValue);
+}
+
+static void
+AppendUint32(nsTArray<uint8_t> &aBuf, uint32_t aValue)
+{
+    uint8_t *p = aBuf.AppendElements(sizeof(aValue));
+    LittleEndian::writeUint32(p, aValue);
+}
+
+static void
+AppendUint64(nsTArray<uint8_t> &aBuf, uint64_t aValue)
+{
+    uint8_t *p = aBuf.AppendElements(sizeof(aValue));
+    LittleEndian::writeUint64(p, aValue);
+}
+
+static PRTime
+TimeStampToPRTime(const TimeStamp &aTime, const TimeStamp &aNow, PRTime aNowWall)
+{
+    return aNowWall + PRTime((aTime - aNow).ToMicroseconds());
+}
+
+static bool
+AppendPersistedRecord(nsTArray<uint8_t> &aBuf, nsHostRecord *aRec,
+                      PRTime aExpiration)
+{
+    size_t hostLen = strlen(aRec->host);
+    if (hostLen > UINT16_MAX) {
+        return false;
+    }
+
+    size_t start = aBuf.Length();
+    AppendUint64(aBuf, aExpiration);
+    AppendUint16(aBuf, aRec->flags);
+    AppendUint16(aBuf, aRec->af);
+    AppendUint16(aBuf, hostLen);
+    AppendUint16(aBuf, 0);
+    aBuf.AppendElements(reinterpret_cast<const uint8_t *>(aRec->host), hostLen);
+
+    if (aRec->negative) {
+        return true;
+    }
+
+    MutexAutoLock lock(aRec->addr_info_lock);
+    if (!aRec->addr_info) {
+        aBuf.SetLength(start);
+        return false;
+    }
+
+    uint16_t count = 0;
+    for (NetAddrElement *elem = aRec->addr_info->mAddresses.getFirst();
+         elem && count < UINT16_MAX; elem = elem->getNext()) {
+        const NetAddr &addr = elem->mAddress;
+        uint8_t ip[16] = { 0 };
+        if (addr.raw.family == AF_INET) {
+            memcpy(ip, &addr.inet.ip, sizeof(addr.inet.ip));
+        } else if (addr.raw.family == AF_INET6) {
+            memcpy(ip, &addr.inet6.ip, sizeof(addr.inet6.ip));
+        } else {
+            continue;
+        }
+        AppendUint16(aBuf, addr.raw.family == AF_INET ? PR_AF_INET : PR_AF_INET6);
+        aBuf.AppendElements(ip, sizeof(ip));
+        count++;
+    }
+
+    if (!count) {
+        aBuf.SetLength(start);
+        return false;
+    }
+
+    LittleEndian::writeUint16(aBuf.Elements() + start + 14, count);
+    return true;
+}
+
+nsresult
+nsHostResolver::PersistRecords(nsIFile *aFile)
+{
+    nsTArray<uint8_t> positive, negative;
+    uint32_t positiveCount = 0, negativeCount = 0;
+
+    {
+        MutexAutoLock lock(mLock);
+
+        TimeStamp now = TimeStamp::NowLoRes();
+        PRTime nowWall = PR_Now();
+
+        for (auto iter = mDB.Iter(); !iter.Done(); iter.Next()) {
+            auto entry = static_cast<nsHostDBEnt *>(iter.Get());
+            nsHostRecord *rec = entry->rec;
+
+            // Only persist resolved host names that were looked up through
+            // the default interface.
+            if (!rec || !rec->host || rec->addr || rec->mDoomed ||
+                rec->mValidEnd.IsNull() ||
+                (rec->netInterface && rec->netInterface[0] != '\0')) {
+                continue;
+            }
+
+            if (rec->negative) {
+                if (rec->mValidEnd <= now) {
+                    continue;
+                }
+                PRTime expiration = TimeStampToPRTime(rec->mValidEnd, now, nowWall);
+                if (AppendPersistedRecord(negative, rec, expiration)) {
+                    negativeCount++;
+                }
+            } else {
+                PRTime expiration = TimeStampToPRTime(rec->mGraceStart, now, nowWall);
+                if (AppendPersistedRecord(positive, rec, expiration)) {
+                    positiveCount++;
+                }
+            }
+        }
+    }
+
+    nsTArray<uint8_t> buf;
+    AppendUint32(buf, kPersistedCacheMagic);
+    AppendUint32(buf, kPersistedCacheVersion);
+    AppendUint32(buf, positiveCount);
+    AppendUint32(buf, negativeCount);
+    buf.AppendElements(positive);
+    buf.AppendElements(negative);
+
+    PRFileDesc *fd;
+    nsresult rv = aFile->OpenNSPRFileDesc(PR_WRONLY | PR_CREATE_FILE | PR_TRUNCATE,
+                                          00600, &fd);
+    if (NS_FAILED(rv)) {
+        return rv;
+    }
+
+    int32_t written = PR_Write(fd, buf.Elements(), buf.Length());
+    PR_Close(fd);
+    if (written < 0 || uint32_t(written) != buf.Length()) {
+        aFile->Remove(false);
+        return NS_ERROR_FAILURE;
+    }
+
+    LOG(("Persisted %u positive and %u negative DNS cache records.\n",
+         positiveCount, negativeCount));
+    return NS_OK;
+}
+
+bool
+nsHostResolver::RestorePersistedRecord(const char *aHost, uint16_t aFlags,
+                                       uint16_t aAf, PRTime aExpiration,
+                                       AddrInfo *aAddrInfo, PRTime aNowWall,
+                                       const TimeStamp &aNow)
+{
+    mLock.AssertCurrentThreadOwns();
+
+    // Ownership of aAddrInfo passes to us.
+    nsAutoPtr<AddrInfo> addrInfo(aAddrInfo);
+
+    unsigned int valid, grace;
+    int64_t remaining = (aExpiration - aNowWall) / PR_USEC_PER_SEC;
+    if (!addrInfo) {
+        if (remaining <= 0) {
+            return false;
+        }
+        valid = std::min<int64_t>(remaining, NEGATIVE_RECORD_LIFETIME);
+        grace = 0;
+    } else if (remaining > 0) {
+        valid = std::min<int64_t>(remaining, UINT32_MAX / 2);
+        grace = mDefaultGracePeriod;
+    } else if (-remaining < kPersistedMaxStaleness) {
+        valid = 0;
+        grace = kPersistedStaleGrace;
+    } else {
+        return false;
+    }
+
+    nsHostKey key = { aHost, aFlags, aAf, "" };
+    auto he = static_cast<nsHostDBEnt *>(mDB.Add(&key, fallible));
+    if (!he) {
+        return false;
+    }
+
+    nsHostRecord *rec = he->rec;
+    // A lookup made before the file was read takes precedence.
+    if (rec->addr_info || rec->addr || rec->negative || rec->resolving ||
+        !PR_CLIST_IS_EMPTY(rec)) {
+        return false;
+    }
+
+    {
+        MutexAutoLock lock(rec->addr_info_lock);
+        rec->addr_info = addrInfo.forget();
+        rec->addr_info_gencnt++;
+    }
+    rec->negative = !rec->addr_info;
+    rec->SetExpiration(aNow, valid, grace);
+
+    PR_APPEND_LINK(rec, &mEvictionQ);
+    NS_ADDREF(rec);
+    mEvictionQSize++;
+    return true;
+}
+
+nsresult
+nsHostResolver::LoadPersistedRecords(nsIFile *aFile)
+{
+    PRFileDesc *fd;
+    nsresult rv = aFile->OpenNSPRFileDesc(PR_RDONLY, 00600, &fd);
+    if (NS_FAILED(rv)) {
+        return rv;
+    }
+
+    PRFileInfo64 info;
+    if (PR_GetOpenFileInfo64(fd, &info) != PR_SUCCESS ||
+        info.size < kPersistedCacheHeaderSize || info.size > UINT32_MAX) {
+        PR_Close(fd);
+        return NS_ERROR_FILE_CORRUPTED;
+    }
+
+    uint32_t size = uint32_t(info.size);
+    PRFileMap *map = PR_CreateFileMap(fd, size, PR_PROT_READONLY);
+    if (!map) {
+        PR_Close(fd);
+        return NS_ERROR_FAILURE;
+    }
+
+    const uint8_t *data = static_cast<const uint8_t *>(PR_MemMap(map, 0, size));
+    if (!data) {
+        PR_CloseFileMap(map);
+        PR_Close(fd);
+        return NS_ERROR_FAILURE;
+    }
+
+    rv = NS_OK;
+    uint32_t restored = 0;
+    if (LittleEndian::readUint32(data) != kPersistedCacheMagic ||
+        LittleEndian::readUint32(data + 4) != kPersistedCacheVersion) {
+        rv = NS_ERROR_FILE_CORRUPTED;
+    } else {
+        uint32_t positiveCount = LittleEndian::readUint32(data + 8);
+        uint32_t negativeCount = LittleEndian::readUint32(data + 12);
+        uint64_t total = uint64_t(positiveCount) + negativeCount;
+        uint32_t offset = kPersistedCacheHeaderSize;
+
+        MutexAutoLock lock(mLock);
+
+        TimeStamp now = TimeStamp::NowLoRes();
+        PRTime nowWall = PR_Now();
+
+        for (uint64_t i = 0; i < total && !mShutdown; i++) {
+            if (size - offset < kPersistedRecordHeaderSize) {
+                rv = NS_ERROR_FILE_CORRUPTED;
+                break;
+            }
+            const uint8_t *p = data + offset;
+            PRTime expiration = PRTime(LittleEndian::readUint64(p));
+            uint16_t flags = LittleEndian::readUint16(p + 8);
+            uint16_t af = LittleEndian::readUint16(p + 10);
+            uint16_t hostLen = LittleEndian::readUint16(p + 12);
+            uint16_t addrCount = LittleEndian::readUint16(p + 14);
+            offset += kPersistedRecordHeaderSize;
+
+            uint32_t bodySize = hostLen + uint32_t(addrCount) * kPersistedAddrSize;
+            if (size - offset < bodySize) {
+                rv = NS_ERROR_FILE_CORRUPTED;
+                break;
+            }
+            nsAutoCString host(reinterpret_cast<const char *>(data + offset),
+                               hostLen);
+            p = data + offset + hostLen;
+            offset += bodySize;
+
+            bool negative = i >= positiveCount;
+            if (host.IsEmpty() || negative != !addrCount ||
+                mEvictionQSize >= mMaxCacheEntries) {
+                continue;
+            }
+
+            AddrInfo *addrInfo = nullptr;
+            if (!negative) {
+                addrInfo = new AddrInfo(host.get(), nullptr);
+                for (uint16_t j = 0; j < addrCount; j++, p += kPersistedAddrSize) {
+                    PRNetAddr prAddr;
+                    memset(&prAddr, 0, sizeof(prAddr));
+                    uint16_t family = LittleEndian::readUint16(p);
+                    if (family == PR_AF_INET) {
+                        prAddr.inet.family = PR_AF_INET;
+                        memcpy(&prAddr.inet.ip, p + 2, sizeof(prAddr.inet.ip));
+                    } else if (family == PR_AF_INET6) {
+                        prAddr.ipv6.family = PR_AF_INET6;
+                        memcpy(&prAddr.ipv6.ip, p + 2, sizeof(prAddr.ipv6.ip));
+                    } else {
+                        continue;
+                    }
+                    addrInfo->AddAddress(new NetAddrElement(&prAddr));
+                }
+                if (addrInfo->mAddresses.isEmpty()) {
+                    delete addrInfo;
+                    continue;
+                }
+            }
+
+            if (RestorePersistedRecord(host.get(), flags, af, expiration,
+                                       addrInfo, nowWall, now)) {
+                restored++;
+            }
+        }
+    }
+
+    PR_MemUnmap(const_cast<uint8_t *>(data), size);
+    PR_CloseFileMap(map);
+    PR_Close(fd);
+
+    LOG(("Restored %u DNS cache records from disk.\n", restored));
+    return rv;
+}
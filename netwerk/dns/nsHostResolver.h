@@ -24,6 +24,7 @@
 
 class nsHostResolver;
 class nsHostRecord;
+class nsIFile;
 class nsResolveHostCallback;
 
 #define MAX_RESOLVER_THREADS_FOR_ANY_PRIORITY  3
@@ -298,6 +299,21 @@ public:
      */
     void FlushCache();
 
+    /**
+     * Write the cache's positive and negative records to aFile, along with
+     * their remaining lifetimes, so that LoadPersistedRecords can restore them
+     * in a later session.
+     */
+    nsresult PersistRecords(nsIFile *aFile);
+
+    /**
+     * Restore records written by PersistRecords. Positive records whose
+     * lifetime has run out are restored in their grace period, so they are
+     * served immediately while a lookup refreshes them. Negative records are
+     * only restored for what is left of their short lifetime.
+     */
+    nsresult LoadPersistedRecords(nsIFile *aFile);
+
 private:
    explicit nsHostResolver(uint32_t maxCacheEntries,
                            uint32_t defaultCacheEntryLifetime,
@@ -306,6 +322,7 @@ private:
 
     nsresult Init();
     nsresult IssueLookup(nsHostRecord *);
+    nsresult QueueLookup(nsHostRecord *);
     bool     GetHostToLookup(nsHostRecord **m);
 
     enum LookupStatus {
@@ -324,10 +341,39 @@ private:
      */
     nsresult ConditionallyRefreshRecord(nsHostRecord *rec, const char *host);
 
+    /**
+     * Adds a record read by LoadPersistedRecords to the cache and the eviction
+     * queue. Takes ownership of aAddrInfo, which is null for negative records.
+     * Returns false if the record was dropped.
+     */
+    bool RestorePersistedRecord(const char *aHost, uint16_t aFlags,
+                                uint16_t aAf, PRTime aExpiration,
+                                mozilla::net::AddrInfo *aAddrInfo,
+                                PRTime aNowWall,
+                                const mozilla::TimeStamp &aNow);
+
     static void  MoveQueue(nsHostRecord *aRec, PRCList &aDestQ);
     
     static void ThreadFunc(void *);
 
+    void AccumulateLookupTelemetry(nsHostRecord *rec, nsresult status,
+                                   const mozilla::TimeStamp &startTime,
+                                   bool getTtl);
+
+#if ASYNC_GETADDRINFO_AVAILABLE
+    struct AsyncLookup;
+
+    /**
+     * Resolves rec through the system's asynchronous resolver rather than
+     * the thread pool. Must be called with mLock held, with rec marked as
+     * resolving and an owning reference to it that is handed to the lookup.
+     */
+    nsresult IssueAsyncLookup(nsHostRecord *rec);
+    static void OnAsyncLookupComplete(nsresult status,
+                                      mozilla::net::AddrInfo *ai,
+                                      void *closure);
+#endif
+
     enum {
         METHOD_HIT = 1,
         METHOD_RENEWAL = 2,
@@ -967,5 +967,26 @@ NeckoParent::RecvRemoveRequestContext(const nsCString& rcid)
   return true;
 }
 
+bool
+NeckoParent::RecvSetRequestContextInBackground(const nsCString& rcid,
+                                               const bool& inBackground)
+{
+  nsCOMPtr<nsIRequestContextService> rcsvc =
+    do_GetService("@mozilla.org/network/request-context-service;1");
+  if (!rcsvc) {
+    return true;
+  }
+
+  nsID id;
+  id.Parse(rcid.BeginReading());
+  nsCOMPtr<nsIRequestContext> rc;
+  rcsvc->GetRequestContext(id, getter_AddRefs(rc));
+  if (rc) {
+    rc->SetInBackground(inBackground);
+  }
+
+  return true;
+}
+
 } // namespace net
 } // namespace mozilla
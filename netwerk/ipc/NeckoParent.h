@@ -236,6 +236,8 @@ protected:
   virtual bool RecvPredReset() override;
 
   virtual bool RecvRemoveRequestContext(const nsCString& rcid) override;
+  virtual bool RecvSetRequestContextInBackground(const nsCString& rcid,
+                                                 const bool& inBackground) override;
 
 private:
   RefPtr<OfflineObserver> mObserver;
@@ -1068,6 +1068,13 @@ AltSvcOverride::GetAllow1918(bool *allow)
   return NS_OK;
 }
 
+NS_IMETHODIMP
+AltSvcOverride::GetExpectedConnections(uint32_t *expectedConnections)
+{
+  *expectedConnections = 1;
+  return NS_OK;
+}
+
 NS_IMPL_ISUPPORTS(AltSvcOverride, nsIInterfaceRequestor, nsISpeculativeConnectionOverrider)
 
 } // namespace net
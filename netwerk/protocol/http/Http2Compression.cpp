@@ -659,172 +659,88 @@ Http2Decompressor::CopyStringFromInput(uint32_t bytes, nsACString &val)
 }
 
 nsresult
-Http2Decompressor::DecodeFinalHuffmanCharacter(const HuffmanIncomingTable *table,
-                                               uint8_t &c, uint8_t &bitsLeft)
+Http2Decompressor::CopyHuffmanStringFromInput(uint32_t bytes, nsACString &val)
 {
-  uint8_t mask = (1 << bitsLeft) - 1;
-  uint8_t idx = mData[mOffset - 1] & mask;
-  idx <<= (8 - bitsLeft);
-  // Don't update bitsLeft yet, because we need to check that value against the
-  // number of bits used by our encoding later on. We'll update when we are sure
-  // how many bits we've actually used.
-
-  if (table->IndexHasANextTable(idx)) {
-    // Can't chain to another table when we're all out of bits in the encoding
-    LOG(("DecodeFinalHuffmanCharacter trying to chain when we're out of bits"));
-    return NS_ERROR_FAILURE;
-  }
-
-  const HuffmanIncomingEntry *entry = table->Entry(idx);
-
-  if (bitsLeft < entry->mPrefixLen) {
-    // We don't have enough bits to actually make a match, this is some sort of
-    // invalid coding
-    LOG(("DecodeFinalHuffmanCharacter does't have enough bits to match"));
-    return NS_ERROR_FAILURE;
-  }
-
-  // This is a character!
-  if (entry->mValue == 256) {
-    // EOS
-    LOG(("DecodeFinalHuffmanCharacter actually decoded an EOS"));
+  if (mOffset + bytes > mDataLen) {
+    LOG(("CopyHuffmanStringFromInput not enough data"));
     return NS_ERROR_FAILURE;
   }
-  c = static_cast<uint8_t>(entry->mValue & 0xFF);
-  bitsLeft -= entry->mPrefixLen;
 
-  return NS_OK;
-}
-
-uint8_t
-Http2Decompressor::ExtractByte(uint8_t bitsLeft, uint32_t &bytesConsumed)
-{
-  uint8_t rv;
-
-  if (bitsLeft) {
-    // Need to extract bitsLeft bits from the previous byte, and 8 - bitsLeft
-    // bits from the current byte
-    uint8_t mask = (1 << bitsLeft) - 1;
-    rv = (mData[mOffset - 1] & mask) << (8 - bitsLeft);
-    rv |= (mData[mOffset] & ~mask) >> bitsLeft;
-  } else {
-    rv = mData[mOffset];
+  // The shortest code is 5 bits long, which bounds the decoded length. Decode
+  // straight into |val| rather than appending a character at a time.
+  uint64_t maxLength = (uint64_t(bytes) * 8) / 5;
+  if (maxLength > UINT32_MAX || !val.SetLength(maxLength, fallible)) {
+    return NS_ERROR_OUT_OF_MEMORY;
   }
+  char *out = val.BeginWriting();
+  uint32_t length = 0;
 
-  // We always update these here, under the assumption that all 8 bits we got
-  // here will be used. These may be re-adjusted later in the case that we don't
-  // use up all 8 bits of the byte.
-  ++mOffset;
-  ++bytesConsumed;
+  const uint8_t *in = mData + mOffset;
+  const uint8_t *end = in + bytes;
 
-  return rv;
-}
-
-nsresult
-Http2Decompressor::DecodeHuffmanCharacter(const HuffmanIncomingTable *table,
-                                          uint8_t &c, uint32_t &bytesConsumed,
-                                          uint8_t &bitsLeft)
-{
-  uint8_t idx = ExtractByte(bitsLeft, bytesConsumed);
-
-  if (table->IndexHasANextTable(idx)) {
-    if (bytesConsumed >= mDataLen) {
-      if (!bitsLeft || (bytesConsumed > mDataLen)) {
-        // TODO - does this get me into trouble in the new world?
-        // No info left in input to try to consume, we're done
-        LOG(("DecodeHuffmanCharacter all out of bits to consume, can't chain"));
-        return NS_ERROR_FAILURE;
-      }
+  // The input is consumed through a 64 bit accumulator, most significant bit
+  // first. The tables are indexed a byte at a time; codes longer than 8 bits
+  // chain through further tables, and the longest code is 30 bits, so an
+  // accumulator holding at least 32 bits always has enough to decode the
+  // next character.
+  uint64_t accum = 0;
+  uint32_t accumBits = 0;
 
-      // We might get lucky here!
-      return DecodeFinalHuffmanCharacter(table->NextTable(idx), c, bitsLeft);
+  while (true) {
+    while (accumBits <= 56 && in < end) {
+      accum |= uint64_t(*in++) << (56 - accumBits);
+      accumBits += 8;
     }
-
-    // We're sorry, Mario, but your princess is in another castle
-    return DecodeHuffmanCharacter(table->NextTable(idx), c, bytesConsumed, bitsLeft);
-  }
-
-  const HuffmanIncomingEntry *entry = table->Entry(idx);
-  if (entry->mValue == 256) {
-    LOG(("DecodeHuffmanCharacter found an actual EOS"));
-    return NS_ERROR_FAILURE;
-  }
-  c = static_cast<uint8_t>(entry->mValue & 0xFF);
-
-  // Need to adjust bitsLeft (and possibly other values) because we may not have
-  // consumed all of the bits of the byte we extracted.
-  if (entry->mPrefixLen <= bitsLeft) {
-    bitsLeft -= entry->mPrefixLen;
-    --mOffset;
-    --bytesConsumed;
-  } else {
-    bitsLeft = 8 - (entry->mPrefixLen - bitsLeft);
-  }
-  MOZ_ASSERT(bitsLeft < 8);
-
-  return NS_OK;
-}
-
-nsresult
-Http2Decompressor::CopyHuffmanStringFromInput(uint32_t bytes, nsACString &val)
-{
-  if (mOffset + bytes > mDataLen) {
-    LOG(("CopyHuffmanStringFromInput not enough data"));
-    return NS_ERROR_FAILURE;
-  }
-
-  uint32_t bytesRead = 0;
-  uint8_t bitsLeft = 0;
-  nsAutoCString buf;
-  nsresult rv;
-  uint8_t c;
-
-  while (bytesRead < bytes) {
-    uint32_t bytesConsumed = 0;
-    rv = DecodeHuffmanCharacter(&HuffmanIncomingRoot, c, bytesConsumed,
-                                bitsLeft);
-    if (NS_FAILED(rv)) {
-      LOG(("CopyHuffmanStringFromInput failed to decode a character"));
-      return rv;
+    if (!accumBits) {
+      break;
     }
 
-    bytesRead += bytesConsumed;
-    buf.Append(c);
-  }
+    const HuffmanIncomingTable *table = &HuffmanIncomingRoot;
+    uint32_t bitsUsed = 0;
+    uint8_t idx = static_cast<uint8_t>(accum >> 56);
+    while (table->IndexHasANextTable(idx)) {
+      table = table->NextTable(idx);
+      bitsUsed += 8;
+      idx = static_cast<uint8_t>(accum >> (56 - bitsUsed));
+    }
 
-  if (bytesRead > bytes) {
-    LOG(("CopyHuffmanStringFromInput read more bytes than was allowed!"));
-    return NS_ERROR_FAILURE;
-  }
+    const HuffmanIncomingEntry *entry = table->Entry(idx);
+    bitsUsed += entry->mPrefixLen;
+    if (bitsUsed > accumBits) {
+      // The rest of the input is too short to hold a code, so it has to be
+      // padding. That is checked below.
+      break;
+    }
 
-  if (bitsLeft) {
-    // The shortest valid code is 4 bits, so we know there can be at most one
-    // character left that our loop didn't decode. Check to see if that's the
-    // case, and if so, add it to our output.
-    rv = DecodeFinalHuffmanCharacter(&HuffmanIncomingRoot, c, bitsLeft);
-    if (NS_SUCCEEDED(rv)) {
-      buf.Append(c);
+    if (entry->mValue == 256) {
+      LOG(("CopyHuffmanStringFromInput found an actual EOS"));
+      return NS_ERROR_FAILURE;
     }
+
+    MOZ_ASSERT(length < maxLength);
+    out[length++] = static_cast<char>(entry->mValue & 0xFF);
+    accum <<= bitsUsed;
+    accumBits -= bitsUsed;
   }
 
-  if (bitsLeft > 7) {
+  if (accumBits > 7) {
     LOG(("CopyHuffmanStringFromInput more than 7 bits of padding"));
     return NS_ERROR_FAILURE;
   }
 
-  if (bitsLeft) {
+  if (accumBits) {
     // Any bits left at this point must belong to the EOS symbol, so make sure
     // they make sense (ie, are all ones)
-    uint8_t mask = (1 << bitsLeft) - 1;
-    uint8_t bits = mData[mOffset - 1] & mask;
-    if (bits != mask) {
+    uint64_t mask = (uint64_t(1) << accumBits) - 1;
+    if ((accum >> (64 - accumBits)) != mask) {
       LOG(("CopyHuffmanStringFromInput ran out of data but found possible "
            "non-EOS symbol"));
       return NS_ERROR_FAILURE;
     }
   }
 
-  val = buf;
+  val.SetLength(length);
+  mOffset += bytes;
   LOG(("CopyHuffmanStringFromInput decoded a full string!"));
   return NS_OK;
 }
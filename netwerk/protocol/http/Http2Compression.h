@@ -18,8 +18,6 @@
 namespace mozilla {
 namespace net {
 
-struct HuffmanIncomingTable;
-
 void Http2CompressionCleanup();
 
 class nvPair
@@ -130,12 +128,7 @@ private:
 
   nsresult CopyHeaderString(uint32_t index, nsACString &name);
   nsresult CopyStringFromInput(uint32_t index, nsACString &val);
-  uint8_t ExtractByte(uint8_t bitsLeft, uint32_t &bytesConsumed);
   nsresult CopyHuffmanStringFromInput(uint32_t index, nsACString &val);
-  nsresult DecodeHuffmanCharacter(const HuffmanIncomingTable *table, uint8_t &c,
-                                  uint32_t &bytesConsumed, uint8_t &bitsLeft);
-  nsresult DecodeFinalHuffmanCharacter(const HuffmanIncomingTable *table,
-                                       uint8_t &c, uint8_t &bitsLeft);
 
   nsCString mHeaderStatus;
   nsCString mHeaderHost;
@@ -138,6 +138,12 @@ public:
   const static uint32_t kQueueTailRoom    =  4096;
   const static uint32_t kQueueReserved    =  1024;
 
+  // DATA payloads at least this large are written to the network straight
+  // from the stream's buffer instead of being copied into the output queue
+  // behind their frame header. Smaller ones are coalesced with the header
+  // so that they go out in a single TLS record.
+  const static uint32_t kDirectWriteMinimum = 8192;
+
   const static uint32_t kMaxStreamID = 0x7800000;
 
   // This is a sentinel for a deleted stream. It is not a valid
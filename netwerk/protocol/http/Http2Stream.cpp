@@ -897,8 +897,14 @@ Http2Stream::TransmitFrame(const char *buf,
     }
 
     // If there is already data buffered, just add to that to form
-    // a single TLS Application Data Record - otherwise skip the memcpy
-    if (mSession->AmountOfOutputBuffered()) {
+    // a single TLS Application Data Record - otherwise skip the memcpy.
+    // Large payloads skip the memcpy regardless: OnReadSegment writes out the
+    // queued frame header (along with any control frames queued with it) and
+    // then the payload directly from |buf|, copying only what the socket
+    // does not accept. The TLS layer does not support writev, so this costs
+    // a separate record for the header, which is small next to the copy.
+    if (mTxStreamFrameSize < Http2Session::kDirectWriteMinimum &&
+        mSession->AmountOfOutputBuffered()) {
       rv = mSession->BufferOutput(buf, mTxStreamFrameSize,
                                   &transmittedCount);
     } else {
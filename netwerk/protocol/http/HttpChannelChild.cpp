@@ -37,6 +37,7 @@
 #include "nsContentSecurityManager.h"
 #include "nsIDeprecationWarner.h"
 #include "nsICompressConvStats.h"
+#include "nsIThreadRetargetableStreamListener.h"
 #include "nsStreamUtils.h"
 
 #ifdef OS_POSIX
@@ -236,6 +237,7 @@ NS_INTERFACE_MAP_BEGIN(HttpChannelChild)
   NS_INTERFACE_MAP_ENTRY(nsIHttpChannelChild)
   NS_INTERFACE_MAP_ENTRY_CONDITIONAL(nsIAssociatedContentSecurity, GetAssociatedContentSecurity())
   NS_INTERFACE_MAP_ENTRY(nsIDivertableChannel)
+  NS_INTERFACE_MAP_ENTRY(nsIThreadRetargetableRequest)
 NS_INTERFACE_MAP_END_INHERITING(HttpBaseChannel)
 
 //-----------------------------------------------------------------------------
@@ -632,6 +634,67 @@ HttpChannelChild::RecvOnTransportAndData(const nsresult& channelStatus,
   return true;
 }
 
+// Creates the stream OnDataAvailable reads from. The stream shares the
+// string's refcounted buffer, so listeners which keep the data around (like
+// imagelib's SourceBuffer) can do so without copying it.
+static nsresult
+NewDataInputStream(nsIInputStream** aStream, const nsCString& aData,
+                   uint32_t aCount)
+{
+  if (aData.Length() == aCount) {
+    return NS_NewCStringInputStream(aStream, aData);
+  }
+  return NS_NewByteInputStream(aStream, aData.get(), aCount,
+                               NS_ASSIGNMENT_DEPEND);
+}
+
+// Delivers OnDataAvailable on the thread set by RetargetDeliveryTo.
+class DataAvailableEvent : public Runnable
+{
+ public:
+  DataAvailableEvent(HttpChannelChild* child,
+                     nsIStreamListener* listener,
+                     nsISupports* context,
+                     const nsCString& data,
+                     const uint64_t& offset,
+                     const uint32_t& count)
+  : mChild(child)
+  , mListener(listener)
+  , mContext(context)
+  , mData(data)
+  , mOffset(offset)
+  , mCount(count) {}
+
+  NS_IMETHOD Run() override
+  {
+    LOG(("HttpChannelChild DataAvailableEvent [this=%p]\n", mChild.get()));
+    if (mChild->mCanceled) {
+      return NS_OK;
+    }
+
+    nsCOMPtr<nsIInputStream> stringStream;
+    nsresult rv = NewDataInputStream(getter_AddRefs(stringStream), mData,
+                                     mCount);
+    if (NS_SUCCEEDED(rv)) {
+      rv = mListener->OnDataAvailable(mChild, mContext, stringStream, mOffset,
+                                      mCount);
+      stringStream->Close();
+    }
+    if (NS_FAILED(rv)) {
+      mChild->CancelOnMainThread(rv);
+    }
+    return NS_OK;
+  }
+
+ private:
+  RefPtr<HttpChannelChild> mChild;
+  nsCOMPtr<nsIStreamListener> mListener;
+  nsCOMPtr<nsISupports> mContext;
+  nsCString mData;
+  uint64_t mOffset;
+  uint32_t mCount;
+};
+
 class MaybeDivertOnDataHttpEvent : public ChannelEvent
 {
  public:
@@ -709,6 +772,19 @@ HttpChannelChild::OnTransportAndData(const nsresult& channelStatus,
   DoOnStatus(this, transportStatus);
   DoOnProgress(this, progress, progressMax);
 
+  if (mODATarget) {
+    // The event keeps its own reference to the data, which shares the
+    // string buffer rather than copying it.
+    nsCOMPtr<nsIRunnable> event =
+      new DataAvailableEvent(this, mListener, mListenerContext, data, offset,
+                             count);
+    nsresult rv = mODATarget->Dispatch(event.forget(), NS_DISPATCH_NORMAL);
+    if (NS_FAILED(rv)) {
+      Cancel(rv);
+    }
+    return;
+  }
+
   // OnDataAvailable
   //
   // NOTE: the OnDataAvailable contract requires the client to read all the data
@@ -717,8 +793,7 @@ HttpChannelChild::OnTransportAndData(const nsresult& channelStatus,
   // support only reading part of the data, allowing later calls to read the
   // rest.
   nsCOMPtr<nsIInputStream> stringStream;
-  nsresult rv = NS_NewByteInputStream(getter_AddRefs(stringStream), data.get(),
-                                      count, NS_ASSIGNMENT_DEPEND);
+  nsresult rv = NewDataInputStream(getter_AddRefs(stringStream), data, count);
   if (NS_FAILED(rv)) {
     Cancel(rv);
     return;
@@ -728,6 +803,19 @@ HttpChannelChild::OnTransportAndData(const nsresult& channelStatus,
   stringStream->Close();
 }
 
+void
+HttpChannelChild::CancelOnMainThread(nsresult aStatus)
+{
+  if (NS_IsMainThread()) {
+    Cancel(aStatus);
+    return;
+  }
+
+  NS_DispatchToMainThread(
+    NewRunnableMethod<nsresult>(this, &HttpChannelChild::CancelOnMainThread,
+                                aStatus));
+}
+
 void
 HttpChannelChild::DoOnStatus(nsIRequest* aRequest, nsresult status)
 {
@@ -830,6 +918,46 @@ HttpChannelChild::RecvOnStopRequest(const nsresult& channelStatus,
   return true;
 }
 
+// Dispatched to the retarget thread behind the data already sent there, and
+// from there back to the main thread to let OnStopRequest proceed.
+class ODATargetDrainedEvent : public Runnable
+{
+ public:
+  ODATargetDrainedEvent(HttpChannelChild* child,
+                        const nsresult& channelStatus,
+                        const ResourceTimingStruct& timing)
+  : mChild(child)
+  , mChannelStatus(channelStatus)
+  , mTiming(timing) {}
+
+  NS_IMETHOD Run() override
+  {
+    if (!NS_IsMainThread()) {
+      return NS_DispatchToMainThread(this);
+    }
+    mChild->ODATargetDrained(mChannelStatus, mTiming);
+    return NS_OK;
+  }
+
+ private:
+  RefPtr<HttpChannelChild> mChild;
+  nsresult mChannelStatus;
+  ResourceTimingStruct mTiming;
+};
+
+void
+HttpChannelChild::ODATargetDrained(const nsresult& aChannelStatus,
+                                   const ResourceTimingStruct& aTiming)
+{
+  LOG(("HttpChannelChild::ODATargetDrained [this=%p]\n", this));
+
+  nsTArray<UniquePtr<ChannelEvent>> events;
+  events.AppendElement(MakeUnique<StopRequestEvent>(this, aChannelStatus,
+                                                    aTiming));
+  mEventQ->PrependEvents(events);
+  mEventQ->Resume();
+}
+
 class MaybeDivertOnStopHttpEvent : public ChannelEvent
 {
  public:
@@ -877,6 +1005,22 @@ HttpChannelChild::OnStopRequest(const nsresult& channelStatus,
     return;
   }
 
+  if (mODATarget) {
+    // OnDataAvailable calls may still be pending on the retarget thread and
+    // have to reach the listener first.  Hold the event queue until that
+    // thread has run everything dispatched to it; ODATargetDrained then
+    // replays OnStopRequest from the queue.
+    nsCOMPtr<nsIEventTarget> target = mODATarget.forget();
+    mEventQ->Suspend();
+    nsCOMPtr<nsIRunnable> event =
+      new ODATargetDrainedEvent(this, channelStatus, timing);
+    if (NS_SUCCEEDED(target->Dispatch(event.forget(), NS_DISPATCH_NORMAL))) {
+      return;
+    }
+    // The target thread is gone and so is any data still queued for it.
+    mEventQ->Resume();
+  }
+
   if (mUnknownDecoderInvolved) {
    LOG(("UnknownDecoder is involved queue OnStopRequest call. [this=%p]",
         this));
@@ -2534,6 +2678,11 @@ HttpChannelChild::DivertToParent(ChannelDiverterChild **aChild)
   MOZ_RELEASE_ASSERT(gNeckoChild);
   MOZ_RELEASE_ASSERT(!mDivertingToParent);
 
+  // Data may already be on its way to the retarget thread.
+  if (mODATarget) {
+    return NS_ERROR_NOT_AVAILABLE;
+  }
+
   nsresult rv = NS_OK;
 
   // If the channel was intercepted, then we likely do not have an IPC actor
@@ -2606,6 +2755,40 @@ HttpChannelChild::GetDivertingToParent(bool* aDiverting)
   return NS_OK;
 }
 
+//-----------------------------------------------------------------------------
+// HttpChannelChild::nsIThreadRetargetableRequest
+//-----------------------------------------------------------------------------
+
+NS_IMETHODIMP
+HttpChannelChild::RetargetDeliveryTo(nsIEventTarget* aNewTarget)
+{
+  LOG(("HttpChannelChild::RetargetDeliveryTo [this=%p, target=%p]\n",
+       this, aNewTarget));
+  MOZ_ASSERT(NS_IsMainThread(), "Should be called on main thread only");
+
+  NS_ENSURE_ARG(aNewTarget);
+  if (aNewTarget == NS_GetCurrentThread()) {
+    NS_WARNING("Retargeting delivery to same thread");
+    return NS_OK;
+  }
+
+  // Diverted, intercepted and sniffed loads feed the listener from elsewhere.
+  if (mODATarget || mDivertingToParent || mUnknownDecoderInvolved ||
+      mSynthesizedResponse || !mListener || !mIsPending) {
+    return NS_ERROR_NOT_AVAILABLE;
+  }
+
+  nsCOMPtr<nsIThreadRetargetableStreamListener> retargetableListener =
+    do_QueryInterface(mListener);
+  if (!retargetableListener ||
+      NS_FAILED(retargetableListener->CheckListenerChain())) {
+    return NS_ERROR_NO_INTERFACE;
+  }
+
+  mODATarget = aNewTarget;
+  return NS_OK;
+}
+
 
 void
 HttpChannelChild::ResetInterception()
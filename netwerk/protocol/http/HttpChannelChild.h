@@ -29,6 +29,7 @@
 #include "nsIChildChannel.h"
 #include "nsIHttpChannelChild.h"
 #include "nsIDivertableChannel.h"
+#include "nsIThreadRetargetableRequest.h"
 #include "mozilla/net/DNS.h"
 
 class nsInputStreamPump;
@@ -51,6 +52,7 @@ class HttpChannelChild final : public PHttpChannelChild
                              , public nsIChildChannel
                              , public nsIHttpChannelChild
                              , public nsIDivertableChannel
+                             , public nsIThreadRetargetableRequest
 {
   virtual ~HttpChannelChild();
 public:
@@ -64,6 +66,7 @@ public:
   NS_DECL_NSICHILDCHANNEL
   NS_DECL_NSIHTTPCHANNELCHILD
   NS_DECL_NSIDIVERTABLECHANNEL
+  NS_DECL_NSITHREADRETARGETABLEREQUEST
 
   HttpChannelChild();
 
@@ -169,6 +172,14 @@ private:
   void DoPreOnStopRequest(nsresult aStatus);
   void DoOnStopRequest(nsIRequest* aRequest, nsresult aChannelStatus, nsISupports* aContext);
 
+  // Cancel() needs the main thread; used when OnDataAvailable fails on the
+  // retarget thread.
+  void CancelOnMainThread(nsresult aStatus);
+  // Called once the retarget thread has delivered all data dispatched to it;
+  // puts the postponed OnStopRequest back at the head of the event queue.
+  void ODATargetDrained(const nsresult& aChannelStatus,
+                        const ResourceTimingStruct& aTiming);
+
   bool ShouldInterceptURI(nsIURI* aURI, bool& aShouldUpgrade);
 
   // Discard the prior interception and continue with the original network request.
@@ -219,6 +230,10 @@ private:
   // diverting callbacks to parent.
   bool mSuspendSent;
 
+  // Set by RetargetDeliveryTo: OnDataAvailable is dispatched to this thread,
+  // while status, progress and OnStopRequest stay on the main thread.
+  nsCOMPtr<nsIEventTarget> mODATarget;
+
   // Set if a response was synthesized, indicating that any forthcoming redirects
   // should be intercepted.
   bool mSynthesizedResponse;
@@ -307,6 +322,8 @@ private:
   friend class StartRequestEvent;
   friend class StopRequestEvent;
   friend class TransportAndDataEvent;
+  friend class DataAvailableEvent;
+  friend class ODATargetDrainedEvent;
   friend class MaybeDivertOnDataHttpEvent;
   friend class MaybeDivertOnStopHttpEvent;
   friend class ProgressEvent;
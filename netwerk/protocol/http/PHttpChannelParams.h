@@ -92,87 +92,85 @@ struct ParamTraits<mozilla::net::nsHttpAtom>
 };
 
 template<>
-struct ParamTraits<mozilla::net::nsHttpHeaderArray::nsEntry>
+struct ParamTraits<mozilla::net::nsHttpHeaderArray>
 {
-  typedef mozilla::net::nsHttpHeaderArray::nsEntry paramType;
+  typedef mozilla::net::nsHttpHeaderArray paramType;
+  typedef mozilla::net::nsHttpHeaderArray::nsEntry entryType;
 
   static void Write(Message* aMsg, const paramType& aParam)
   {
-    WriteParam(aMsg, aParam.header);
-    WriteParam(aMsg, aParam.value);
-    switch (aParam.variety) {
-      case mozilla::net::nsHttpHeaderArray::eVarietyUnknown:
-        WriteParam(aMsg, (uint8_t)0);
-        break;
-      case mozilla::net::nsHttpHeaderArray::eVarietyRequestOverride:
-        WriteParam(aMsg, (uint8_t)1);
-        break;
-      case mozilla::net::nsHttpHeaderArray::eVarietyRequestDefault:
-        WriteParam(aMsg, (uint8_t)2);
-        break;
-      case mozilla::net::nsHttpHeaderArray::eVarietyResponseNetOriginalAndResponse:
-        WriteParam(aMsg, (uint8_t)3);
-        break;
-      case mozilla::net::nsHttpHeaderArray::eVarietyResponseNetOriginal:
-        WriteParam(aMsg, (uint8_t)4);
-        break;
-      case mozilla::net::nsHttpHeaderArray::eVarietyResponse:
-        WriteParam(aMsg, (uint8_t)5);
+    uint32_t count = aParam.Count();
+    WriteParam(aMsg, count);
+    for (uint32_t i = 0; i < count; ++i) {
+      const entryType& entry = aParam.mStorage->mHeaders[i];
+      WriteParam(aMsg, entry.header);
+      const nsACString& value = entry.Value();
+      WriteParam(aMsg, value);
+      switch (entry.variety) {
+        case mozilla::net::nsHttpHeaderArray::eVarietyUnknown:
+          WriteParam(aMsg, (uint8_t)0);
+          break;
+        case mozilla::net::nsHttpHeaderArray::eVarietyRequestOverride:
+          WriteParam(aMsg, (uint8_t)1);
+          break;
+        case mozilla::net::nsHttpHeaderArray::eVarietyRequestDefault:
+          WriteParam(aMsg, (uint8_t)2);
+          break;
+        case mozilla::net::nsHttpHeaderArray::eVarietyResponseNetOriginalAndResponse:
+          WriteParam(aMsg, (uint8_t)3);
+          break;
+        case mozilla::net::nsHttpHeaderArray::eVarietyResponseNetOriginal:
+          WriteParam(aMsg, (uint8_t)4);
+          break;
+        case mozilla::net::nsHttpHeaderArray::eVarietyResponse:
+          WriteParam(aMsg, (uint8_t)5);
+      }
     }
   }
 
   static bool Read(const Message* aMsg, PickleIterator* aIter, paramType* aResult)
   {
-    uint8_t variety;
-    if (!ReadParam(aMsg, aIter, &aResult->header) ||
-        !ReadParam(aMsg, aIter, &aResult->value)  ||
-        !ReadParam(aMsg, aIter, &variety))
+    uint32_t count;
+    if (!ReadParam(aMsg, aIter, &count))
       return false;
 
-    switch (variety) {
-      case 0:
-        aResult->variety = mozilla::net::nsHttpHeaderArray::eVarietyUnknown;
-        break;
-      case 1:
-        aResult->variety = mozilla::net::nsHttpHeaderArray::eVarietyRequestOverride;
-        break;
-      case 2:
-        aResult->variety = mozilla::net::nsHttpHeaderArray::eVarietyRequestDefault;
-        break;
-      case 3:
-        aResult->variety = mozilla::net::nsHttpHeaderArray::eVarietyResponseNetOriginalAndResponse;
-        break;
-      case 4:
-        aResult->variety = mozilla::net::nsHttpHeaderArray::eVarietyResponseNetOriginal;
-        break;
-      case 5:
-        aResult->variety = mozilla::net::nsHttpHeaderArray::eVarietyResponse;
-        break;
-      default:
+    aResult->Clear();
+    for (uint32_t i = 0; i < count; ++i) {
+      mozilla::net::nsHttpAtom header;
+      nsCString value;
+      uint8_t variety;
+      if (!ReadParam(aMsg, aIter, &header) ||
+          !ReadParam(aMsg, aIter, &value)  ||
+          !ReadParam(aMsg, aIter, &variety))
         return false;
-    }
-
-    return true;
-  }
-};
-
 
-template<>
-struct ParamTraits<mozilla::net::nsHttpHeaderArray>
-{
-  typedef mozilla::net::nsHttpHeaderArray paramType;
-
-  static void Write(Message* aMsg, const paramType& aParam)
-  {
-    paramType& p = const_cast<paramType&>(aParam);
-
-    WriteParam(aMsg, p.mHeaders);
-  }
-
-  static bool Read(const Message* aMsg, PickleIterator* aIter, paramType* aResult)
-  {
-    if (!ReadParam(aMsg, aIter, &aResult->mHeaders))
-      return false;
+      mozilla::net::nsHttpHeaderArray::HeaderVariety result;
+      switch (variety) {
+        case 0:
+          result = mozilla::net::nsHttpHeaderArray::eVarietyUnknown;
+          break;
+        case 1:
+          result = mozilla::net::nsHttpHeaderArray::eVarietyRequestOverride;
+          break;
+        case 2:
+          result = mozilla::net::nsHttpHeaderArray::eVarietyRequestDefault;
+          break;
+        case 3:
+          result = mozilla::net::nsHttpHeaderArray::eVarietyResponseNetOriginalAndResponse;
+          break;
+        case 4:
+          result = mozilla::net::nsHttpHeaderArray::eVarietyResponseNetOriginal;
+          break;
+        case 5:
+          result = mozilla::net::nsHttpHeaderArray::eVarietyResponse;
+          break;
+        default:
+          return false;
+      }
+
+      if (NS_FAILED(aResult->SetHeader_internal(header, value, result)))
+        return false;
+    }
 
     return true;
   }
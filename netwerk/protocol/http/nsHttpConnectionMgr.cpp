@@ -29,6 +29,7 @@
 #include "nsIDNSRecord.h"
 #include "nsITransport.h"
 #include "nsInterfaceRequestorAgg.h"
+#include "nsIClassOfService.h"
 #include "nsIRequestContext.h"
 #include "nsISocketTransportService.h"
 #include <algorithm>
@@ -88,6 +89,12 @@ nsHttpConnectionMgr::nsHttpConnectionMgr()
     , mPruningNoTraffic(false)
     , mTimeoutTickArmed(false)
     , mTimeoutTickNext(1)
+    , mThrottleTickBytes(0)
+    , mThrottleTickForegroundBytes(0)
+    , mThrottleCapacity(0)
+    , mThrottling(false)
+    , mThrottleAllowance(0)
+    , mThrottleIdleTicks(0)
 {
     LOG(("Creating nsHttpConnectionMgr @%p\n", this));
 }
@@ -97,6 +104,8 @@ nsHttpConnectionMgr::~nsHttpConnectionMgr()
     LOG(("Destroying nsHttpConnectionMgr @%p\n", this));
     if (mTimeoutTick)
         mTimeoutTick->Cancel();
+    if (mThrottleTicker)
+        mThrottleTicker->Cancel();
 }
 
 nsresult
@@ -311,6 +320,8 @@ nsHttpConnectionMgr::Observe(nsISupports *subject,
         }
         else if (timer == mTimeoutTick) {
             TimeoutTick();
+        } else if (timer == mThrottleTicker) {
+            ThrottleTick();
         } else if (timer == mTrafficTimer) {
             PruneNoTraffic();
         }
@@ -395,6 +406,10 @@ public: // intentional!
     bool mIsFromPredictor;
     bool mAllow1918;
 
+    // further transactions for when the overrider expects the host to need
+    // more than one connection
+    nsTArray<RefPtr<NullHttpTransaction>> mExtraTrans;
+
 private:
     virtual ~SpeculativeConnectArgs() {}
     NS_DECL_OWNINGTHREAD
@@ -443,6 +458,16 @@ nsHttpConnectionMgr::SpeculativeConnect(nsHttpConnectionInfo *ci,
         args->mIgnoreIdle = overrider->GetIgnoreIdle();
         args->mIsFromPredictor = overrider->GetIsFromPredictor();
         args->mAllow1918 = overrider->GetAllow1918();
+
+        // Each connection needs its own transaction to drive the handshake.
+        // Build them here rather than on the socket thread; unneeded ones
+        // are simply released.
+        uint32_t expected = std::min(overrider->GetExpectedConnections(),
+                                     args->mParallelSpeculativeConnectLimit);
+        for (uint32_t i = 1; !nullTransaction && i < expected; ++i) {
+            args->mExtraTrans.AppendElement(
+                new NullHttpTransaction(ci, wrappedCallbacks, caps));
+        }
     }
 
     return PostEvent(&nsHttpConnectionMgr::OnMsgSpeculativeConnect, 0, args);
@@ -1190,6 +1215,7 @@ nsHttpConnectionMgr::MakeNewConnection(nsConnectionEntry *ent,
             if (ent->mHalfOpens[i]->IsFromPredictor()) {
               Telemetry::AutoCounter<Telemetry::PREDICTOR_TOTAL_PRECONNECTS_USED> totalPreconnectsUsed;
               ++totalPreconnectsUsed;
+              ++ent->mPreconnectsUsed;
             }
 
             // return OK because we have essentially opened a new connection
@@ -2185,6 +2211,12 @@ nsHttpConnectionMgr::OnMsgShutdown(int32_t, ARefBase *param)
       mTrafficTimer->Cancel();
       mTrafficTimer = nullptr;
     }
+    if (mThrottleTicker) {
+      mThrottleTicker->Cancel();
+      mThrottleTicker = nullptr;
+    }
+    mThrottledTransactions.Clear();
+    mThrottling = false;
 
     // signal shutdown complete
     nsCOMPtr<nsIRunnable> runnable =
@@ -2746,6 +2778,144 @@ nsHttpConnectionMgr::ActivateTimeoutTick()
     mTimeoutTick->Init(this, 1000, nsITimer::TYPE_REPEATING_SLACK);
 }
 
+// Length of a bandwidth scheduling period.
+static const uint32_t kThrottleTickMs = 100;
+// Share of the estimated capacity background work may use on top of what
+// foreground transactions read; the rest is headroom for the foreground to
+// ramp up into.
+static const double kThrottleUsableCapacity = 0.8;
+// Per-tick decay of the capacity estimate.
+static const double kThrottleCapacityDecay = 0.995;
+// Ticks without any reads after which the ticker stops.
+static const uint32_t kThrottleIdleTicks = 10;
+
+bool
+nsHttpConnectionMgr::IsBackgroundTransaction(nsHttpTransaction *aTrans)
+{
+    nsIRequestContext *rc = aTrans->RequestContext();
+    bool inBackground = false;
+    if (rc && NS_SUCCEEDED(rc->GetInBackground(&inBackground)) && inBackground) {
+        return true;
+    }
+
+    uint32_t cos = aTrans->ClassOfService();
+    if (cos & (nsIClassOfService::Leader | nsIClassOfService::Unblocked)) {
+        return false;
+    }
+    return cos & (nsIClassOfService::Background | nsIClassOfService::Speculative);
+}
+
+bool
+nsHttpConnectionMgr::ShouldThrottle(nsHttpTransaction *aTrans)
+{
+    MOZ_ASSERT(PR_GetCurrentThread() == gSocketThread);
+
+    if (!mThrottling || mThrottleAllowance > 0 ||
+        !IsBackgroundTransaction(aTrans)) {
+        return false;
+    }
+
+    LOG(("nsHttpConnectionMgr::ShouldThrottle throttling trans=%p\n", aTrans));
+    if (!mThrottledTransactions.Contains(aTrans)) {
+        mThrottledTransactions.AppendElement(aTrans);
+    }
+    return true;
+}
+
+void
+nsHttpConnectionMgr::ThrottleTransactionRead(nsHttpTransaction *aTrans,
+                                             uint32_t aBytes)
+{
+    MOZ_ASSERT(PR_GetCurrentThread() == gSocketThread);
+
+    if (!aBytes) {
+        return;
+    }
+
+    mThrottleTickBytes += aBytes;
+    if (IsBackgroundTransaction(aTrans)) {
+        mThrottleAllowance -= std::min<uint64_t>(aBytes, mThrottleAllowance);
+    } else {
+        mThrottleTickForegroundBytes += aBytes;
+    }
+    EnsureThrottleTicker();
+}
+
+void
+nsHttpConnectionMgr::EnsureThrottleTicker()
+{
+    mThrottleIdleTicks = 0;
+    if (mThrottleTicker) {
+        return;
+    }
+
+    mThrottleTicker = do_CreateInstance(NS_TIMER_CONTRACTID);
+    if (!mThrottleTicker) {
+        NS_WARNING("failed to create timer for bandwidth scheduling");
+        return;
+    }
+    mThrottleTicker->SetTarget(mSocketThreadTarget);
+    mThrottleTicker->Init(this, kThrottleTickMs, nsITimer::TYPE_REPEATING_SLACK);
+}
+
+void
+nsHttpConnectionMgr::StopThrottling()
+{
+    mThrottling = false;
+
+    nsTArray<RefPtr<nsHttpTransaction>> throttled;
+    throttled.SwapElements(mThrottledTransactions);
+    for (uint32_t i = 0; i < throttled.Length(); ++i) {
+        throttled[i]->ResumeReading();
+    }
+}
+
+void
+nsHttpConnectionMgr::ThrottleTick()
+{
+    MOZ_ASSERT(PR_GetCurrentThread() == gSocketThread);
+
+    double tickBytes = double(mThrottleTickBytes);
+    mThrottleCapacity = std::max(tickBytes,
+                                 mThrottleCapacity * kThrottleCapacityDecay);
+
+    // Background work is only held back while the foreground is actually
+    // loading something; it then gets whatever the foreground did not use of
+    // the usable capacity, and at least its configured share.
+    if (gHttpHandler->ThrottleEnabled() && mThrottleTickForegroundBytes) {
+        double usable = mThrottleCapacity * kThrottleUsableCapacity -
+                        double(mThrottleTickForegroundBytes);
+        double share = mThrottleCapacity *
+                       gHttpHandler->ThrottleBackgroundShare() / 100.0;
+        mThrottleAllowance = uint64_t(std::max(usable, share));
+        mThrottling = true;
+
+        LOG(("nsHttpConnectionMgr::ThrottleTick capacity=%.0f foreground=%" PRIu64
+             " allowance=%" PRIu64 "\n", mThrottleCapacity,
+             mThrottleTickForegroundBytes, mThrottleAllowance));
+
+        // Throttled transactions read again with the new allowance.
+        nsTArray<RefPtr<nsHttpTransaction>> throttled;
+        throttled.SwapElements(mThrottledTransactions);
+        for (uint32_t i = 0; i < throttled.Length(); ++i) {
+            throttled[i]->ResumeReading();
+        }
+    } else if (mThrottling) {
+        LOG(("nsHttpConnectionMgr::ThrottleTick foreground idle, "
+             "releasing %u transactions\n", mThrottledTransactions.Length()));
+        StopThrottling();
+    }
+
+    if (!mThrottleTickBytes && mThrottledTransactions.IsEmpty() &&
+        ++mThrottleIdleTicks >= kThrottleIdleTicks) {
+        mThrottleTicker->Cancel();
+        mThrottleTicker = nullptr;
+    }
+
+    mThrottleTickBytes = 0;
+    mThrottleTickForegroundBytes = 0;
+}
+
 void
 nsHttpConnectionMgr::TimeoutTick()
 {
@@ -2913,16 +3083,35 @@ nsHttpConnectionMgr::OnMsgSpeculativeConnect(int32_t, ARefBase *param)
         allow1918 = args->mAllow1918;
     }
 
+    // A host that speaks HTTP/2 (directly or through a coalesced preferred
+    // entry) multiplexes everything over one connection, so only ever warm
+    // one; otherwise open as many as the caller expects to be needed.
+    uint32_t expected = 1 + args->mExtraTrans.Length();
+    if (ent->mUsingSpdy) {
+        expected = 1;
+    }
+
     bool keepAlive = args->mTrans->Caps() & NS_HTTP_ALLOW_KEEPALIVE;
-    if (mNumHalfOpenConns < parallelSpeculativeConnectLimit &&
-        ((ignoreIdle && (ent->mIdleConns.Length() < parallelSpeculativeConnectLimit)) ||
-         !ent->mIdleConns.Length()) &&
-        !(keepAlive && RestrictConnections(ent)) &&
-        !AtActiveConnectionLimit(ent, args->mTrans->Caps())) {
-        CreateTransport(ent, args->mTrans, args->mTrans->Caps(), true, isFromPredictor, allow1918);
-    } else {
-        LOG(("OnMsgSpeculativeConnect Transport "
-             "not created due to existing connection count\n"));
+    for (uint32_t i = 0; i < expected; ++i) {
+        // Connections that are idle or still speculative already cover
+        // part of the expected demand.
+        if (i > 0 &&
+            ent->mIdleConns.Length() + ent->SpeculativeHalfOpens() >= expected) {
+            break;
+        }
+        if (mNumHalfOpenConns < parallelSpeculativeConnectLimit &&
+            ((ignoreIdle && (ent->mIdleConns.Length() < parallelSpeculativeConnectLimit)) ||
+             !ent->mIdleConns.Length()) &&
+            !(keepAlive && RestrictConnections(ent)) &&
+            !AtActiveConnectionLimit(ent, args->mTrans->Caps())) {
+            NullHttpTransaction *trans = i ? args->mExtraTrans[i - 1].get()
+                                           : args->mTrans.get();
+            CreateTransport(ent, trans, trans->Caps(), true, isFromPredictor, allow1918);
+        } else {
+            LOG(("OnMsgSpeculativeConnect Transport "
+                 "not created due to existing connection count\n"));
+            break;
+        }
     }
 }
 
@@ -3555,6 +3744,8 @@ nsConnectionEntry::nsConnectionEntry(nsHttpConnectionInfo *ci)
     , mPreferIPv4(false)
     , mPreferIPv6(false)
     , mUsedForConnection(false)
+    , mPreconnectsUsed(0)
+    , mPreconnectsUnused(0)
 {
     MOZ_COUNT_CTOR(nsConnectionEntry);
     if (gHttpHandler->GetPipelineAggressive()) {
@@ -3845,8 +4036,11 @@ nsHttpConnectionMgr::GetConnectionData(nsTArray<HttpRetParams> *aArg)
         for (uint32_t i = 0; i < ent->mHalfOpens.Length(); i++) {
             HalfOpenSockets hSocket;
             hSocket.speculative = ent->mHalfOpens[i]->IsSpeculative();
+            hSocket.fromPredictor = ent->mHalfOpens[i]->IsFromPredictor();
             data.halfOpens.AppendElement(hSocket);
         }
+        data.preconnectsUsed = ent->mPreconnectsUsed;
+        data.preconnectsUnused = ent->mPreconnectsUnused;
         data.spdy = ent->mUsingSpdy;
         data.ssl = ent->mConnInfo->EndToEndSSL();
         aArg->AppendElement(data);
@@ -3876,6 +4070,18 @@ nsConnectionEntry::UnconnectedHalfOpens()
     return unconnectedHalfOpens;
 }
 
+uint32_t
+nsHttpConnectionMgr::
+nsConnectionEntry::SpeculativeHalfOpens()
+{
+    uint32_t speculativeHalfOpens = 0;
+    for (uint32_t i = 0; i < mHalfOpens.Length(); ++i) {
+        if (mHalfOpens[i]->IsSpeculative())
+            ++speculativeHalfOpens;
+    }
+    return speculativeHalfOpens;
+}
+
 void
 nsHttpConnectionMgr::
 nsConnectionEntry::RemoveHalfOpen(nsHalfOpenSocket *halfOpen)
@@ -3891,6 +4097,7 @@ nsConnectionEntry::RemoveHalfOpen(nsHalfOpenSocket *halfOpen)
             if (halfOpen->IsFromPredictor()) {
                 Telemetry::AutoCounter<Telemetry::PREDICTOR_TOTAL_PRECONNECTS_UNUSED> totalPreconnectsUnused;
                 ++totalPreconnectsUnused;
+                ++mPreconnectsUnused;
             }
         }
 
@@ -258,6 +258,18 @@ public:
     // public, so that the SPDY/http2 seesions can activate
     void ActivateTimeoutTick();
 
+    // Adaptive bandwidth scheduling (socket thread only). While transactions
+    // of the page the user is looking at are reading, background work
+    // (background tabs, nsIClassOfService::Background and Speculative loads)
+    // is limited to what the foreground leaves of the measured link capacity,
+    // but never less than a small share of it.
+
+    // Returns true if aTrans should stop reading for now. It will be woken
+    // with nsHttpTransaction::ResumeReading() on a later tick.
+    bool ShouldThrottle(nsHttpTransaction *aTrans);
+    // Accounts aBytes read from the network by aTrans.
+    void ThrottleTransactionRead(nsHttpTransaction *aTrans, uint32_t aBytes);
+
 private:
     virtual ~nsHttpConnectionMgr();
 
@@ -304,6 +316,10 @@ private:
         // connection complete
         uint32_t UnconnectedHalfOpens();
 
+        // calculate the number of half open sockets that are still speculative,
+        // i.e. not yet claimed by a transaction
+        uint32_t SpeculativeHalfOpens();
+
         // Remove a particular half open socket from the mHalfOpens array
         void RemoveHalfOpen(nsHalfOpenSocket *);
 
@@ -385,6 +401,12 @@ private:
         // True if this connection entry has initiated a socket
         bool mUsedForConnection : 1;
 
+        // Predictor preconnects that were claimed by a transaction, and
+        // those that were closed without being used. Reported through the
+        // dashboard.
+        uint32_t mPreconnectsUsed;
+        uint32_t mPreconnectsUnused;
+
         // Set the IP family preference flags according the connected family
         void RecordIPFamilyPreference(uint16_t family);
         // Resets all flags to their default values
@@ -624,6 +646,27 @@ private:
     // Read Timeout Tick handlers
     void TimeoutTick();
 
+    // Bandwidth scheduling, see ShouldThrottle()
+    bool IsBackgroundTransaction(nsHttpTransaction *aTrans);
+    void EnsureThrottleTicker();
+    void ThrottleTick();
+    void StopThrottling();
+
+    // Runs every kThrottleTickMs while transactions are reading.
+    nsCOMPtr<nsITimer> mThrottleTicker;
+    // Bytes read by all transactions and by foreground ones this tick.
+    uint64_t mThrottleTickBytes;
+    uint64_t mThrottleTickForegroundBytes;
+    // Estimated link capacity in bytes per tick: the best tick seen,
+    // decaying slowly so that a slower network is picked up.
+    double mThrottleCapacity;
+    // Whether background transactions are being limited, and how many bytes
+    // they may still read this tick.
+    bool mThrottling;
+    uint64_t mThrottleAllowance;
+    uint32_t mThrottleIdleTicks;
+    nsTArray<RefPtr<nsHttpTransaction>> mThrottledTransactions;
+
     // For diagnostics
     void OnMsgPrintDiagnostics(int32_t, ARefBase *);
 
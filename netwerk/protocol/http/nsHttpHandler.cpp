@@ -233,6 +233,8 @@ nsHttpHandler::nsHttpHandler()
     , mRequestTokenBucketMinParallelism(6)
     , mRequestTokenBucketHz(100)
     , mRequestTokenBucketBurst(32)
+    , mThrottleEnabled(true)
+    , mThrottleBackgroundShare(10)
     , mCriticalRequestPrioritization(true)
     , mTCPKeepaliveShortLivedEnabled(false)
     , mTCPKeepaliveShortLivedTimeS(60)
@@ -1619,6 +1621,19 @@ nsHttpHandler::PrefsChanged(nsIPrefBranch *prefs, const char *pref)
         MakeNewRequestTokenBucket();
     }
 
+    if (PREF_CHANGED(HTTP_PREF("throttle.enabled"))) {
+        rv = prefs->GetBoolPref(HTTP_PREF("throttle.enabled"), &cVar);
+        if (NS_SUCCEEDED(rv)) {
+            mThrottleEnabled = cVar;
+        }
+    }
+    if (PREF_CHANGED(HTTP_PREF("throttle.background-share"))) {
+        rv = prefs->GetIntPref(HTTP_PREF("throttle.background-share"), &val);
+        if (NS_SUCCEEDED(rv)) {
+            mThrottleBackgroundShare = static_cast<uint32_t>(clamped(val, 1, 100));
+        }
+    }
+
     // Keepalive values for initial and idle connections.
     if (PREF_CHANGED(HTTP_PREF("tcp_keepalive.short_lived_connections"))) {
         rv = prefs->GetBoolPref(
@@ -132,6 +132,8 @@ public:
     uint16_t       RequestTokenBucketMinParallelism() { return mRequestTokenBucketMinParallelism; }
     uint32_t       RequestTokenBucketHz() { return mRequestTokenBucketHz; }
     uint32_t       RequestTokenBucketBurst() {return mRequestTokenBucketBurst; }
+    bool           ThrottleEnabled() { return mThrottleEnabled; }
+    uint32_t       ThrottleBackgroundShare() { return mThrottleBackgroundShare; }
 
     bool           PromptTempRedirect()      { return mPromptTempRedirect; }
 
@@ -554,6 +556,11 @@ private:
     uint32_t       mRequestTokenBucketHz;  // EventTokenBucket HZ
     uint32_t       mRequestTokenBucketBurst; // EventTokenBucket Burst
 
+    // Adaptive bandwidth scheduling in nsHttpConnectionMgr: while the link is
+    // saturated, background work is held to this percentage of its capacity.
+    bool           mThrottleEnabled;
+    uint32_t       mThrottleBackgroundShare;
+
     // Whether or not to block requests for non head js/css items (e.g. media)
     // while those elements load.
     bool           mCriticalRequestPrioritization;
@@ -12,6 +12,8 @@
 #include "nsIHttpHeaderVisitor.h"
 #include "nsHttpHandler.h"
 
+#include <algorithm>
+
 namespace mozilla {
 namespace net {
 
@@ -42,7 +44,7 @@ nsHttpHeaderArray::SetHeader(nsHttpAtom header,
                 MOZ_ASSERT(variety == eVarietyResponse);
                 entry->variety = eVarietyResponseNetOriginal;
             } else {
-                mHeaders.RemoveElementAt(index);
+                RemoveEntryAt(index);
             }
         }
         return NS_OK;
@@ -61,7 +63,9 @@ nsHttpHeaderArray::SetHeader(nsHttpAtom header,
             entry->variety = eVarietyResponseNetOriginal;
             return SetHeader_internal(header, value, variety);
         } else {
-            entry->value = value;
+            if (!mStorage->StoreValue(entry, value)) {
+                return NS_ERROR_OUT_OF_MEMORY;
+            }
             entry->variety = variety;
         }
     }
@@ -74,13 +78,18 @@ nsHttpHeaderArray::SetHeader_internal(nsHttpAtom header,
                                       const nsACString &value,
                                       nsHttpHeaderArray::HeaderVariety variety)
 {
-    nsEntry *entry =  mHeaders.AppendElement();
+    Storage *storage = EnsureStorage();
+    nsEntry *entry = storage->mHeaders.AppendElement();
     if (!entry) {
         return NS_ERROR_OUT_OF_MEMORY;
     }
     entry->header = header;
-    entry->value = value;
     entry->variety = variety;
+    if (!storage->StoreValue(entry, value)) {
+        storage->mHeaders.RemoveElementAt(storage->mHeaders.Length() - 1);
+        return NS_ERROR_OUT_OF_MEMORY;
+    }
+    storage->AddToIndex(storage->mHeaders.Length() - 1);
     return NS_OK;
 }
 
@@ -97,7 +106,8 @@ nsHttpHeaderArray::SetEmptyHeader(nsHttpAtom header, HeaderVariety variety)
 
     if (entry &&
         entry->variety != eVarietyResponseNetOriginalAndResponse) {
-        entry->value.Truncate();
+        entry->value = "";
+        entry->valueLength = 0;
         return NS_OK;
     } else if (entry) {
         MOZ_ASSERT(variety == eVarietyResponse);
@@ -154,7 +164,7 @@ nsHttpHeaderArray::SetHeaderFromNet(nsHttpAtom header,
     } else {
         // Multiple instances of non-mergeable header received from network
         // - ignore if same value
-        if (!entry->value.Equals(value)) {
+        if (!entry->Value().Equals(value)) {
             if (IsSuspectDuplicateHeader(header)) {
                 // reply may be corrupt/hacked (ex: CLRF injection attacks)
                 return NS_ERROR_CORRUPTED_CONTENT;
@@ -186,22 +196,21 @@ nsHttpHeaderArray::SetResponseHeaderFromCache(nsHttpAtom header,
         return SetHeader_internal(header, value,
                                   eVarietyResponseNetOriginal);
     } else {
-        nsTArray<nsEntry>::index_type index = 0;
-        do {
-            index = mHeaders.IndexOf(header, index, nsEntry::MatchHeader());
-            if (index != mHeaders.NoIndex) {
-                nsEntry &entry = mHeaders[index];
-                if (value.Equals(entry.value)) {
-                    MOZ_ASSERT((entry.variety == eVarietyResponseNetOriginal) ||
-                               (entry.variety == eVarietyResponseNetOriginalAndResponse),
-                               "This array must contain only eVarietyResponseNetOriginal"
-                               " and eVarietyResponseNetOriginalAndRespons headers!");
-                    entry.variety = eVarietyResponseNetOriginalAndResponse;
-                    return NS_OK;
-                }
-                index++;
+        Unshare();
+        uint32_t index = FirstEntry(header);
+        while (index != UINT32_MAX) {
+            nsEntry &entry = mStorage->mHeaders[index];
+            if (value.Equals(entry.Value())) {
+                MOZ_ASSERT((entry.variety == eVarietyResponseNetOriginal) ||
+                           (entry.variety == eVarietyResponseNetOriginalAndResponse),
+                           "This array must contain only eVarietyResponseNetOriginal"
+                           " and eVarietyResponseNetOriginalAndRespons headers!");
+                entry.variety = eVarietyResponseNetOriginalAndResponse;
+                return NS_OK;
             }
-        } while (index != mHeaders.NoIndex);
+            index = mStorage->mHeaders.IndexOf(header, index + 1,
+                                               nsEntry::MatchHeader());
+        }
         // If we are here, we have not found an entry so add a new one.
         return SetHeader_internal(header, value, eVarietyResponse);
     }
@@ -216,7 +225,7 @@ nsHttpHeaderArray::ClearHeader(nsHttpAtom header)
         if (entry->variety == eVarietyResponseNetOriginalAndResponse) {
             entry->variety = eVarietyResponseNetOriginal;
         } else {
-            mHeaders.RemoveElementAt(index);
+            RemoveEntryAt(index);
         }
     }
 }
@@ -226,7 +235,7 @@ nsHttpHeaderArray::PeekHeader(nsHttpAtom header) const
 {
     const nsEntry *entry = nullptr;
     LookupEntry(header, &entry);
-    return entry ? entry->value.get() : nullptr;
+    return entry ? entry->value : nullptr;
 }
 
 nsresult
@@ -236,7 +245,7 @@ nsHttpHeaderArray::GetHeader(nsHttpAtom header, nsACString &result) const
     LookupEntry(header, &entry);
     if (!entry)
         return NS_ERROR_NOT_AVAILABLE;
-    result = entry->value;
+    result = entry->Value();
     return NS_OK;
 }
 
@@ -245,24 +254,24 @@ nsHttpHeaderArray::GetOriginalHeader(nsHttpAtom aHeader,
                                      nsIHttpHeaderVisitor *aVisitor)
 {
     NS_ENSURE_ARG_POINTER(aVisitor);
-    uint32_t index = 0;
+    uint32_t index = FirstEntry(aHeader);
     nsresult rv = NS_ERROR_NOT_AVAILABLE;
     while (true) {
-        index = mHeaders.IndexOf(aHeader, index, nsEntry::MatchHeader());
         if (index != UINT32_MAX) {
-            const nsEntry &entry = mHeaders[index];
+            const nsEntry &entry = mStorage->mHeaders[index];
 
             MOZ_ASSERT((entry.variety == eVarietyResponseNetOriginalAndResponse) ||
                        (entry.variety == eVarietyResponseNetOriginal) ||
                        (entry.variety == eVarietyResponse),
                        "This must be a response header.");
-            index++;
+            index = mStorage->mHeaders.IndexOf(aHeader, index + 1,
+                                               nsEntry::MatchHeader());
             if (entry.variety == eVarietyResponse) {
                 continue;
             }
             rv = NS_OK;
             if (NS_FAILED(aVisitor->VisitHeader(nsDependentCString(entry.header),
-                                                entry.value))) {
+                                                entry.Value()))) {
                 break;
             }
         } else {
@@ -288,9 +297,12 @@ nsHttpHeaderArray::VisitHeaders(nsIHttpHeaderVisitor *visitor, nsHttpHeaderArray
     NS_ENSURE_ARG_POINTER(visitor);
     nsresult rv;
 
-    uint32_t i, count = mHeaders.Length();
+    // The visitor may modify the headers, which must not move the entries
+    // being visited; hold on to them.
+    RefPtr<Storage> storage = mStorage;
+    uint32_t i, count = Count();
     for (i = 0; i < count; ++i) {
-        const nsEntry &entry = mHeaders[i];
+        const nsEntry &entry = storage->mHeaders[i];
         if (filter == eFilterSkipDefault && entry.variety == eVarietyRequestDefault) {
             continue;
         } else if (filter == eFilterResponse && entry.variety == eVarietyResponseNetOriginal) {
@@ -299,7 +311,7 @@ nsHttpHeaderArray::VisitHeaders(nsIHttpHeaderVisitor *visitor, nsHttpHeaderArray
             continue;
         }
         rv = visitor->VisitHeader(
-            nsDependentCString(entry.header), entry.value);
+            nsDependentCString(entry.header), entry.Value());
         if NS_FAILED(rv) {
             return rv;
         }
@@ -368,9 +380,9 @@ void
 nsHttpHeaderArray::Flatten(nsACString &buf, bool pruneProxyHeaders,
                            bool pruneTransients)
 {
-    uint32_t i, count = mHeaders.Length();
+    uint32_t i, count = Count();
     for (i = 0; i < count; ++i) {
-        const nsEntry &entry = mHeaders[i];
+        const nsEntry &entry = mStorage->mHeaders[i];
         // Skip original header.
         if (entry.variety == eVarietyResponseNetOriginal) {
             continue;
@@ -382,7 +394,7 @@ nsHttpHeaderArray::Flatten(nsACString &buf, bool pruneProxyHeaders,
             continue;
         }
         if (pruneTransients &&
-            (entry.value.IsEmpty() ||
+            (!entry.valueLength ||
              entry.header == nsHttp::Connection ||
              entry.header == nsHttp::Proxy_Connection ||
              entry.header == nsHttp::Keep_Alive ||
@@ -399,7 +411,7 @@ nsHttpHeaderArray::Flatten(nsACString &buf, bool pruneProxyHeaders,
 
         buf.Append(entry.header);
         buf.AppendLiteral(": ");
-        buf.Append(entry.value);
+        buf.Append(entry.value, entry.valueLength);
         buf.AppendLiteral("\r\n");
     }
 }
@@ -407,9 +419,9 @@ nsHttpHeaderArray::Flatten(nsACString &buf, bool pruneProxyHeaders,
 void
 nsHttpHeaderArray::FlattenOriginalHeader(nsACString &buf)
 {
-    uint32_t i, count = mHeaders.Length();
+    uint32_t i, count = Count();
     for (i = 0; i < count; ++i) {
-        const nsEntry &entry = mHeaders[i];
+        const nsEntry &entry = mStorage->mHeaders[i];
         // Skip changed header.
         if (entry.variety == eVarietyResponse) {
             continue;
@@ -417,7 +429,7 @@ nsHttpHeaderArray::FlattenOriginalHeader(nsACString &buf)
 
         buf.Append(entry.header);
         buf.AppendLiteral(": ");
-        buf.Append(entry.value);
+        buf.Append(entry.value, entry.valueLength);
         buf.AppendLiteral("\r\n");
     }
 }
@@ -425,16 +437,158 @@ nsHttpHeaderArray::FlattenOriginalHeader(nsACString &buf)
 const char *
 nsHttpHeaderArray::PeekHeaderAt(uint32_t index, nsHttpAtom &header) const
 {
-    const nsEntry &entry = mHeaders[index];
+    const nsEntry &entry = mStorage->mHeaders[index];
 
     header = entry.header;
-    return entry.value.get();
+    return entry.value;
 }
 
 void
 nsHttpHeaderArray::Clear()
 {
-    mHeaders.Clear();
+    mStorage = nullptr;
+}
+
+bool
+nsHttpHeaderArray::operator==(const nsHttpHeaderArray& aOther) const
+{
+    if (mStorage == aOther.mStorage) {
+        return true;
+    }
+    if (Count() != aOther.Count()) {
+        return false;
+    }
+    for (uint32_t i = 0; i < Count(); ++i) {
+        if (!(mStorage->mHeaders[i] == aOther.mStorage->mHeaders[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// nsHttpHeaderArray <private>
+//-----------------------------------------------------------------------------
+
+// Size of the first arena chunk; later chunks double up to the maximum.
+// Most response heads fit into the first one or two.
+static const uint32_t kMinChunkSize = 512;
+static const uint32_t kMaxChunkSize = 8192;
+
+nsHttpHeaderArray::Storage::Storage()
+    : mChunkSize(0)
+    , mChunkUsed(0)
+{
+    memset(mIndex, kIndexEmpty, sizeof(mIndex));
+}
+
+already_AddRefed<nsHttpHeaderArray::Storage>
+nsHttpHeaderArray::Storage::Clone() const
+{
+    RefPtr<Storage> clone = new Storage();
+
+    // Copy the live values into a single chunk, leaving behind whatever
+    // replaced or removed values this Storage still holds.
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < mHeaders.Length(); ++i) {
+        size += mHeaders[i].valueLength + 1;
+    }
+    clone->mChunkSize = std::max(size, kMinChunkSize);
+    clone->mChunks.AppendElement(MakeUnique<char[]>(clone->mChunkSize));
+
+    clone->mHeaders = mHeaders;
+    for (uint32_t i = 0; i < clone->mHeaders.Length(); ++i) {
+        nsEntry &entry = clone->mHeaders[i];
+        char *value = clone->mChunks[0].get() + clone->mChunkUsed;
+        memcpy(value, entry.value, entry.valueLength);
+        value[entry.valueLength] = '\0';
+        entry.value = value;
+        clone->mChunkUsed += entry.valueLength + 1;
+    }
+    memcpy(clone->mIndex, mIndex, sizeof(mIndex));
+    return clone.forget();
+}
+
+bool
+nsHttpHeaderArray::Storage::StoreValue(nsEntry *aEntry,
+                                       const nsACString &aValue)
+{
+    uint32_t length = aValue.Length();
+    if (!length) {
+        aEntry->value = "";
+        aEntry->valueLength = 0;
+        return true;
+    }
+
+    if (mChunks.IsEmpty() || mChunkSize - mChunkUsed < length + 1) {
+        uint32_t size = mChunks.IsEmpty() ? kMinChunkSize
+                                          : std::min(mChunkSize * 2, kMaxChunkSize);
+        size = std::max(size, length + 1);
+        UniquePtr<char[]> chunk(new (fallible) char[size]);
+        if (!chunk) {
+            return false;
+        }
+        mChunks.AppendElement(Move(chunk));
+        mChunkSize = size;
+        mChunkUsed = 0;
+    }
+
+    char *value = mChunks.LastElement().get() + mChunkUsed;
+    memcpy(value, aValue.BeginReading(), length);
+    value[length] = '\0';
+    mChunkUsed += length + 1;
+
+    aEntry->value = value;
+    aEntry->valueLength = length;
+    return true;
+}
+
+void
+nsHttpHeaderArray::Storage::AddToIndex(uint32_t aIndex)
+{
+    uint8_t &slot = mIndex[IndexSlot(mHeaders[aIndex].header)];
+    if (slot == kIndexEmpty) {
+        slot = aIndex + 1 < kIndexCollision ? aIndex + 1 : kIndexCollision;
+    } else if (slot != kIndexCollision &&
+               mHeaders[slot - 1].header != mHeaders[aIndex].header) {
+        slot = kIndexCollision;
+    }
+}
+
+void
+nsHttpHeaderArray::Storage::RebuildIndex()
+{
+    memset(mIndex, kIndexEmpty, sizeof(mIndex));
+    for (uint32_t i = 0; i < mHeaders.Length(); ++i) {
+        AddToIndex(i);
+    }
+}
+
+nsHttpHeaderArray::Storage *
+nsHttpHeaderArray::EnsureStorage()
+{
+    if (!mStorage) {
+        mStorage = new Storage();
+    } else {
+        Unshare();
+    }
+    return mStorage;
+}
+
+void
+nsHttpHeaderArray::Unshare()
+{
+    if (mStorage && mStorage->IsShared()) {
+        mStorage = mStorage->Clone();
+    }
+}
+
+void
+nsHttpHeaderArray::RemoveEntryAt(uint32_t index)
+{
+    Storage *storage = EnsureStorage();
+    storage->mHeaders.RemoveElementAt(index);
+    storage->RebuildIndex();
 }
 
 } // namespace net
@@ -10,6 +10,9 @@
 #include "nsHttp.h"
 #include "nsTArray.h"
 #include "nsString.h"
+#include "nsISupportsImpl.h"
+#include "mozilla/RefPtr.h"
+#include "mozilla/UniquePtr.h"
 
 class nsIHttpHeaderVisitor;
 
@@ -103,19 +106,26 @@ public:
     void Flatten(nsACString &, bool pruneProxyHeaders, bool pruneTransients);
     void FlattenOriginalHeader(nsACString &);
 
-    uint32_t Count() const { return mHeaders.Length(); }
+    uint32_t Count() const { return mStorage ? mStorage->mHeaders.Length() : 0; }
 
     const char *PeekHeaderAt(uint32_t i, nsHttpAtom &header) const;
 
     void Clear();
 
-    // Must be copy-constructable and assignable
+    // Values point into the arena of the array that owns the entry; they
+    // are null terminated.
     struct nsEntry
     {
         nsHttpAtom header;
-        nsCString value;
+        const char *value = "";
+        uint32_t valueLength = 0;
         HeaderVariety variety = eVarietyUnknown;
 
+        nsDependentCSubstring Value() const
+        {
+            return nsDependentCSubstring(value, valueLength);
+        }
+
         struct MatchHeader {
           bool Equals(const nsEntry &aEntry, const nsHttpAtom &aHeader) const {
             return aEntry.header == aHeader;
@@ -124,20 +134,71 @@ public:
 
         bool operator==(const nsEntry& aOther) const
         {
-            return header == aOther.header && value == aOther.value;
+            return header == aOther.header && Value().Equals(aOther.Value());
         }
     };
 
-    bool operator==(const nsHttpHeaderArray& aOther) const
+    bool operator==(const nsHttpHeaderArray& aOther) const;
+
+private:
+    // The entries and all header values live in a Storage that copies of the
+    // array share until one of them is modified. Values are appended to a
+    // list of arena chunks that are never moved, so a value returned by
+    // PeekHeader stays valid until the array is cleared or assigned to, like
+    // it did when each value was its own string. Chunks are compacted when
+    // a shared Storage is copied.
+    //
+    // A small direct-mapped index over the header atoms answers most lookups
+    // (in particular for absent headers) without scanning the entries.
+    static const uint32_t kIndexSize = 32;
+    static const uint8_t kIndexEmpty = 0;
+    static const uint8_t kIndexCollision = 0xFF;
+
+    struct Storage final
     {
-        return mHeaders == aOther.mHeaders;
+        NS_INLINE_DECL_THREADSAFE_REFCOUNTING(Storage)
+
+        Storage();
+        bool IsShared() const { return mRefCnt > 1; }
+        already_AddRefed<Storage> Clone() const;
+
+        // Copies aValue into the arena and points aEntry at it.
+        bool StoreValue(nsEntry *aEntry, const nsACString &aValue);
+        void AddToIndex(uint32_t aIndex);
+        void RebuildIndex();
+
+        nsTArray<nsEntry> mHeaders;
+        nsTArray<UniquePtr<char[]>> mChunks;
+        uint32_t mChunkSize;
+        uint32_t mChunkUsed;
+        // 0 if no entry's atom maps to the slot, kIndexCollision if entries
+        // with different atoms do, otherwise one more than the index of the
+        // first entry with the slot's atom.
+        uint8_t mIndex[kIndexSize];
+
+    private:
+        ~Storage() {}
+    };
+
+    static uint32_t IndexSlot(nsHttpAtom header)
+    {
+        return (uint32_t(uintptr_t(header.get())) * 0x9E3779B9U) >> 27;
     }
 
-private:
+    // Returns the index of the first entry for header, or UINT32_MAX if
+    // there is none.
+    uint32_t FirstEntry(nsHttpAtom header) const;
+
+    // Makes sure the Storage exists and is not shared before it is modified.
+    Storage *EnsureStorage();
+    // Same, but leaves an array without Storage alone.
+    void Unshare();
+
     // LookupEntry function will never return eVarietyResponseNetOriginal.
     // It will ignore original headers from the network.
     int32_t LookupEntry(nsHttpAtom header, const nsEntry **) const;
     int32_t LookupEntry(nsHttpAtom header, nsEntry **);
+    void RemoveEntryAt(uint32_t index);
     nsresult MergeHeader(nsHttpAtom header, nsEntry *entry,
                          const nsACString &value, HeaderVariety variety);
     nsresult SetHeader_internal(nsHttpAtom header, const nsACString &value,
@@ -154,8 +215,8 @@ private:
     // injection)
     bool    IsSuspectDuplicateHeader(nsHttpAtom header);
 
-    // All members must be copy-constructable and assignable
-    nsTArray<nsEntry> mHeaders;
+    // Copying the array shares the Storage.
+    RefPtr<Storage> mStorage;
 
     friend struct IPC::ParamTraits<nsHttpHeaderArray>;
     friend class nsHttpRequestHead;
@@ -166,19 +227,34 @@ private:
 // nsHttpHeaderArray <private>: inline functions
 //-----------------------------------------------------------------------------
 
+inline uint32_t
+nsHttpHeaderArray::FirstEntry(nsHttpAtom header) const
+{
+    if (!mStorage) {
+        return UINT32_MAX;
+    }
+
+    uint8_t slot = mStorage->mIndex[IndexSlot(header)];
+    if (slot == kIndexEmpty) {
+        return UINT32_MAX;
+    }
+    if (slot == kIndexCollision) {
+        return mStorage->mHeaders.IndexOf(header, 0, nsEntry::MatchHeader());
+    }
+    return mStorage->mHeaders[slot - 1].header == header ? slot - 1 : UINT32_MAX;
+}
+
 inline int32_t
 nsHttpHeaderArray::LookupEntry(nsHttpAtom header, const nsEntry **entry) const
 {
-    uint32_t index = 0;
+    uint32_t index = FirstEntry(header);
     while (index != UINT32_MAX) {
-        index = mHeaders.IndexOf(header, index, nsEntry::MatchHeader());
-        if (index != UINT32_MAX) {
-            if ((&mHeaders[index])->variety != eVarietyResponseNetOriginal) {
-                *entry = &mHeaders[index];
-                return index;
-            }
-            index++;
+        if ((&mStorage->mHeaders[index])->variety != eVarietyResponseNetOriginal) {
+            *entry = &mStorage->mHeaders[index];
+            return index;
         }
+        index = mStorage->mHeaders.IndexOf(header, index + 1,
+                                           nsEntry::MatchHeader());
     }
 
     return index;
@@ -187,17 +263,11 @@ nsHttpHeaderArray::LookupEntry(nsHttpAtom header, const nsEntry **entry) const
 inline int32_t
 nsHttpHeaderArray::LookupEntry(nsHttpAtom header, nsEntry **entry)
 {
-    uint32_t index = 0;
-    while (index != UINT32_MAX) {
-        index = mHeaders.IndexOf(header, index, nsEntry::MatchHeader());
-        if (index != UINT32_MAX) {
-            if ((&mHeaders[index])->variety != eVarietyResponseNetOriginal) {
-                *entry = &mHeaders[index];
-                return index;
-            }
-            index++;
-        }
-    }
+    Unshare();
+    const nsEntry *constEntry = nullptr;
+    int32_t index =
+        const_cast<const nsHttpHeaderArray*>(this)->LookupEntry(header, &constEntry);
+    *entry = const_cast<nsEntry*>(constEntry);
     return index;
 }
 
@@ -236,7 +306,7 @@ nsHttpHeaderArray::MergeHeader(nsHttpAtom header,
     if (value.IsEmpty())
         return NS_OK;   // merge of empty header = no-op
 
-    nsCString newValue = entry->value;
+    nsAutoCString newValue(entry->Value());
     if (!newValue.IsEmpty()) {
         // Append the new value to the existing value
         if (header == nsHttp::Set_Cookie ||
@@ -262,7 +332,9 @@ nsHttpHeaderArray::MergeHeader(nsHttpAtom header,
             return rv;
         }
     } else {
-        entry->value = newValue;
+        if (!mStorage->StoreValue(entry, newValue)) {
+            return NS_ERROR_OUT_OF_MEMORY;
+        }
         entry->variety = variety;
     }
     return NS_OK;
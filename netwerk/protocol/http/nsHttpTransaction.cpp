@@ -829,6 +829,13 @@ nsHttpTransaction::WriteSegments(nsAHttpSegmentWriter *writer,
         return NS_SUCCEEDED(mStatus) ? NS_BASE_STREAM_CLOSED : mStatus;
     }
 
+    // background work yields to the foreground page; the connection manager
+    // calls ResumeReading() once there is bandwidth for it again.
+    if (mHaveAllHeaders && gHttpHandler->ConnMgr()->ShouldThrottle(this)) {
+        reentrantFlag = false;
+        return NS_BASE_STREAM_WOULD_BLOCK;
+    }
+
     mWriter = writer;
 
 #ifdef WIN32 // bug 1153929
@@ -842,10 +849,14 @@ nsHttpTransaction::WriteSegments(nsAHttpSegmentWriter *writer,
         return NS_ERROR_UNEXPECTED;
     }
 
+    int64_t transferSize = mTransferSize;
     nsresult rv = mPipeOut->WriteSegments(WritePipeSegment, this, count, countWritten);
 
     mWriter = nullptr;
 
+    gHttpHandler->ConnMgr()->ThrottleTransactionRead(
+        this, uint32_t(mTransferSize - transferSize));
+
     if (mForceRestart) {
         // The forceRestart condition was dealt with on the stack, but it did not
         // clear the flag because nsPipe in the writesegment stack clears out
@@ -2252,6 +2263,24 @@ nsHttpTransaction::OnOutputStreamReady(nsIAsyncOutputStream *out)
     return NS_OK;
 }
 
+void
+nsHttpTransaction::ResumeReading()
+{
+    MOZ_ASSERT(PR_GetCurrentThread() == gSocketThread);
+
+    // a pipe wait resumes reading on its own
+    if (mTransactionDone || mWaitingOnPipeOut || !mConnection) {
+        return;
+    }
+
+    LOG(("nsHttpTransaction::ResumeReading %p", this));
+    mConnection->TransactionHasDataToRecv(this);
+    nsresult rv = mConnection->ResumeRecv();
+    if (NS_FAILED(rv)) {
+        LOG(("nsHttpTransaction::ResumeReading %p ResumeRecv failed", this));
+    }
+}
+
 // nsHttpTransaction::RestartVerifier
 
 static bool
@@ -147,6 +147,10 @@ public:
     uint32_t InitialRwin() const { return mInitialRwin; };
     bool ChannelPipeFull() { return mWaitingOnPipeOut; }
 
+    // Called by the connection manager to continue a transaction whose
+    // WriteSegments was refused by bandwidth scheduling.
+    void ResumeReading();
+
     // Locked methods to get and set timing info
     const TimingStruct Timings();
     void SetDomainLookupStart(mozilla::TimeStamp timeStamp, bool onlyIfNull = false);
@@ -10,6 +10,7 @@
 
 #include "mozilla/Atomics.h"
 #include "mozilla/Attributes.h"
+#include "mozilla/CheckedInt.h"
 #include "mozilla/EndianUtils.h"
 #include "mozilla/MathAlgorithms.h"
 #include "mozilla/net/WebSocketEventService.h"
@@ -828,8 +829,10 @@ public:
       mResetDeflater = false;
     }
 
-    mDeflater.avail_out = kBufferLen;
-    mDeflater.next_out = mBuffer;
+    uint32_t written = _retval.Length();
+    if (!ReserveOutput(mDeflater, _retval, written)) {
+      return NS_ERROR_OUT_OF_MEMORY;
+    }
     mDeflater.avail_in = dataLen;
     mDeflater.next_in = data;
 
@@ -838,28 +841,31 @@ public:
 
       if (zerr != Z_OK) {
         mResetDeflater = true;
+        _retval.SetLength(written);
         return NS_ERROR_UNEXPECTED;
       }
 
-      uint32_t deflated = kBufferLen - mDeflater.avail_out;
-      if (deflated > 0) {
-        _retval.Append(reinterpret_cast<char *>(mBuffer), deflated);
-      }
+      written = _retval.Length() - mDeflater.avail_out;
 
-      mDeflater.avail_out = kBufferLen;
-      mDeflater.next_out = mBuffer;
+      if (mDeflater.avail_out == 0) {
+        // There was not enough space in the buffer
+        if (!ReserveOutput(mDeflater, _retval, written)) {
+          mResetDeflater = true;
+          _retval.SetLength(written);
+          return NS_ERROR_OUT_OF_MEMORY;
+        }
+        continue;
+      }
 
       if (mDeflater.avail_in > 0) {
         continue; // There is still some data to deflate
       }
 
-      if (deflated == kBufferLen) {
-        continue; // There was not enough space in the buffer
-      }
-
       break;
     }
 
+    _retval.SetLength(written);
+
     if (_retval.Length() < 4) {
       MOZ_ASSERT(false, "Expected trailing not found in deflated data!");
       mResetDeflater = true;
@@ -878,8 +884,11 @@ public:
     Bytef trailingData[] = { 0x00, 0x00, 0xFF, 0xFF };
     bool trailingDataUsed = false;
 
-    mInflater.avail_out = kBufferLen;
-    mInflater.next_out = mBuffer;
+    uint32_t written = _retval.Length();
+    if (!ReserveOutput(mInflater, _retval, written)) {
+      _retval.SetLength(written);
+      return NS_ERROR_OUT_OF_MEMORY;
+    }
     mInflater.avail_in = dataLen;
     mInflater.next_in = data;
 
@@ -898,26 +907,28 @@ public:
         mInflater.avail_in = saveAvailIn;
         mInflater.next_out = saveNextOut;
         mInflater.avail_out = saveAvailOut;
-      } else if (zerr != Z_OK && zerr != Z_BUF_ERROR) {
-        return NS_ERROR_INVALID_CONTENT_ENCODING;
       }
 
-      uint32_t inflated = kBufferLen - mInflater.avail_out;
-      if (inflated > 0) {
-        _retval.Append(reinterpret_cast<char *>(mBuffer), inflated);
+      written = _retval.Length() - mInflater.avail_out;
+
+      if (zerr != Z_OK && zerr != Z_BUF_ERROR && zerr != Z_STREAM_END) {
+        _retval.SetLength(written);
+        return NS_ERROR_INVALID_CONTENT_ENCODING;
       }
 
-      mInflater.avail_out = kBufferLen;
-      mInflater.next_out = mBuffer;
+      if (mInflater.avail_out == 0) {
+        // There was not enough space in the buffer
+        if (!ReserveOutput(mInflater, _retval, written)) {
+          _retval.SetLength(written);
+          return NS_ERROR_OUT_OF_MEMORY;
+        }
+        continue;
+      }
 
       if (mInflater.avail_in > 0) {
         continue; // There is still some data to inflate
       }
 
-      if (inflated == kBufferLen) {
-        continue; // There was not enough space in the buffer
-      }
-
       if (!trailingDataUsed) {
         trailingDataUsed = true;
         mInflater.avail_in = sizeof(trailingData);
@@ -925,6 +936,7 @@ public:
         continue;
       }
 
+      _retval.SetLength(written);
       return NS_OK;
     }
   }
@@ -937,7 +949,26 @@ private:
   z_stream              mDeflater;
   z_stream              mInflater;
   const static uint32_t kBufferLen = 4096;
-  uint8_t               mBuffer[kBufferLen];
+
+  // (De)compressed data is written straight into the message buffer rather
+  // than through a scratch buffer. Make room for more output after the first
+  // |aUsed| bytes of |aBuffer|, growing it geometrically, and point the
+  // output of |aStream| at that room.
+  static bool ReserveOutput(z_stream &aStream, nsACString &aBuffer,
+                            uint32_t aUsed)
+  {
+    CheckedUint32 newLength = aUsed;
+    newLength += aUsed > kBufferLen ? aUsed : kBufferLen;
+    if (!newLength.isValid() ||
+        !aBuffer.SetLength(newLength.value(), fallible)) {
+      return false;
+    }
+
+    aStream.next_out = reinterpret_cast<Bytef *>(aBuffer.BeginWriting()) +
+                       aUsed;
+    aStream.avail_out = newLength.value() - aUsed;
+    return true;
+  }
 };
 
 //-----------------------------------------------------------------------------
@@ -8,6 +8,7 @@
 #define	__nsHTTPCompressConv__h__	1
 
 #include "nsIStreamConverter.h"
+#include "nsIThreadRetargetableStreamListener.h"
 #include "nsICompressConvStats.h"
 #include "nsCOMPtr.h"
 #include "nsAutoPtr.h"
@@ -77,6 +78,7 @@ public:
 class nsHTTPCompressConv
   : public nsIStreamConverter
   , public nsICompressConvStats
+  , public nsIThreadRetargetableStreamListener
 {
   public:
   // nsISupports methods
@@ -84,6 +86,7 @@ class nsHTTPCompressConv
     NS_DECL_NSIREQUESTOBSERVER
     NS_DECL_NSISTREAMLISTENER
     NS_DECL_NSICOMPRESSCONVSTATS
+    NS_DECL_NSITHREADRETARGETABLESTREAMLISTENER
 
   // nsIStreamConverter methods
     NS_DECL_NSISTREAMCONVERTER
@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+#include "gtest/MozGTestBench.h" // For MOZ_GTEST_BENCH
+
+#include "Http2Compression.h"
+#include "nsString.h"
+
+using namespace mozilla::net;
+
+// Response header blocks of the kind that make HPACK decoding show up in
+// profiles: long cookies, content security policies and cache metadata.
+static const char* kHeaderCorpus[] = {
+  "HTTP/1.1 200 OK\r\n"
+  "cache-control: private, max-age=0, no-cache, no-store, must-revalidate\r\n"
+  "content-encoding: gzip\r\n"
+  "content-type: text/html; charset=utf-8\r\n"
+  "date: Tue, 14 Mar 2017 18:02:11 GMT\r\n"
+  "expires: Mon, 01 Jan 1990 00:00:00 GMT\r\n"
+  "set-cookie: SID=NwTWr3nd4Gpk0YS0qz6kmNSjXyZ1rpG8qjvW8BRzbQwNzU2zlKAkAu4w1xz0YMN8x1zpVQ.; expires=Thu, 14-Mar-2019 18:02:11 GMT; path=/; domain=.example.com; Secure; HttpOnly\r\n"
+  "set-cookie: NID=98=JqAhO0iXkK2fQvL7Tg_FHmSa3nV0yEgD0pUjLfR9KkLh8x7sMu2mWbZo5NcYdE4Pq1Ri6TsVg3HjBl0OaWt9XeCzUy2FvKn8Rp; expires=Wed, 13-Sep-2017 18:02:11 GMT; path=/; domain=.example.com; HttpOnly\r\n"
+  "strict-transport-security: max-age=31536000; includeSubDomains; preload\r\n"
+  "x-content-type-options: nosniff\r\n"
+  "x-frame-options: SAMEORIGIN\r\n"
+  "x-xss-protection: 1; mode=block\r\n"
+  "\r\n",
+
+  "HTTP/1.1 200 OK\r\n"
+  "content-security-policy: default-src 'self'; script-src 'self' 'unsafe-inline' 'unsafe-eval' https://ssl.google-analytics.com https://www.google.com https://www.gstatic.com https://apis.example.net; style-src 'self' 'unsafe-inline' https://fonts.googleapis.com; img-src 'self' data: https://*.example.com https://ssl.google-analytics.com; font-src 'self' https://fonts.gstatic.com; connect-src 'self' https://api.example.com wss://push.example.com; frame-ancestors 'none'; report-uri https://csp.example.com/report\r\n"
+  "content-type: application/javascript\r\n"
+  "etag: \"5a1f2c7b-3d4e1\"\r\n"
+  "last-modified: Wed, 29 Nov 2017 21:41:15 GMT\r\n"
+  "vary: Accept-Encoding, Origin\r\n"
+  "access-control-allow-origin: https://www.example.com\r\n"
+  "timing-allow-origin: *\r\n"
+  "\r\n",
+
+  "HTTP/1.1 302 Found\r\n"
+  "location: https://accounts.example.com/ServiceLogin?service=mail&passive=true&rm=false&continue=https%3A%2F%2Fmail.example.com%2Fmail%2F&ss=1&scc=1&ltmpl=default&ltmplcache=2&emr=1&osid=1\r\n"
+  "content-length: 0\r\n"
+  "alt-svc: quic=\":443\"; ma=2592000; v=\"37,36,35\"\r\n"
+  "\r\n",
+};
+
+// Encodes each corpus entry with a fresh compressor so that every string is
+// emitted as a Huffman coded literal rather than a table reference.
+static void
+EncodeCorpus(nsTArray<nsCString>& aEncoded)
+{
+  for (const char* headers : kHeaderCorpus) {
+    Http2Compressor compressor;
+    nsAutoCString encoded;
+    ASSERT_EQ(compressor.EncodeHeaderBlock(nsDependentCString(headers),
+                                           NS_LITERAL_CSTRING("GET"),
+                                           NS_LITERAL_CSTRING("/"),
+                                           NS_LITERAL_CSTRING("www.example.com"),
+                                           NS_LITERAL_CSTRING("https"),
+                                           false, encoded),
+              NS_OK);
+    aEncoded.AppendElement(encoded);
+  }
+}
+
+TEST(TestHttp2Compression, HuffmanRoundTrip) {
+  nsTArray<nsCString> encoded;
+  EncodeCorpus(encoded);
+  ASSERT_EQ(encoded.Length(), mozilla::ArrayLength(kHeaderCorpus));
+
+  for (size_t i = 0; i < encoded.Length(); i++) {
+    Http2Decompressor decompressor;
+    nsAutoCString decoded;
+    // Decoding as a push accepts the request pseudo-headers the compressor
+    // emits, and drops them from the output.
+    ASSERT_EQ(decompressor.DecodeHeaderBlock(
+                reinterpret_cast<const uint8_t*>(encoded[i].get()),
+                encoded[i].Length(), decoded, true),
+              NS_OK);
+
+    nsDependentCString expected(kHeaderCorpus[i]);
+    int32_t start = expected.Find("\r\n") + 2;
+    ASSERT_TRUE(decoded.Equals(Substring(expected, start,
+                                         expected.Length() - start - 2)));
+  }
+}
+
+TEST(TestHttp2Compression, HuffmanBadPadding) {
+  // A literal header without indexing, with a one byte Huffman coded name
+  // and value. 0x00 decodes as '0' followed by three zero padding bits, which
+  // is invalid; 0xff is eight bits of padding, which is also invalid.
+  const uint8_t zeroPadding[] = { 0x00, 0x81, 0x1f, 0x81, 0x00 };
+  const uint8_t longPadding[] = { 0x00, 0x81, 0x1f, 0x81, 0xff };
+
+  Http2Decompressor decompressor;
+  nsAutoCString decoded;
+  ASSERT_NE(decompressor.DecodeHeaderBlock(zeroPadding, sizeof(zeroPadding),
+                                           decoded, true),
+            NS_OK);
+  ASSERT_NE(decompressor.DecodeHeaderBlock(longPadding, sizeof(longPadding),
+                                           decoded, true),
+            NS_OK);
+}
+
+#define COUNT 2000
+
+MOZ_GTEST_BENCH(TestHttp2Compression, DecodePerf, [] {
+  nsTArray<nsCString> encoded;
+  EncodeCorpus(encoded);
+
+  nsAutoCString decoded;
+  for (int i = COUNT; i; --i) {
+    for (const nsCString& block : encoded) {
+      Http2Decompressor decompressor;
+      decompressor.DecodeHeaderBlock(
+        reinterpret_cast<const uint8_t*>(block.get()), block.Length(),
+        decoded, true);
+    }
+  }
+});
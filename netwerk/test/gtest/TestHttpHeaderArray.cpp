@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+
+#include "mozilla/ArrayUtils.h"
+#include "nsHttpHeaderArray.h"
+#include "nsPrintfCString.h"
+#include "nsString.h"
+
+using namespace mozilla::net;
+
+// More atoms than index slots, so that some of them share a slot.
+static const nsHttpAtom* kAtoms[] = {
+  &nsHttp::Accept, &nsHttp::Accept_Encoding, &nsHttp::Accept_Language,
+  &nsHttp::Accept_Ranges, &nsHttp::Age, &nsHttp::Allow,
+  &nsHttp::Alternate_Service, &nsHttp::Authorization, &nsHttp::Cache_Control,
+  &nsHttp::Connection, &nsHttp::Content_Disposition,
+  &nsHttp::Content_Encoding, &nsHttp::Content_Language,
+  &nsHttp::Content_Length, &nsHttp::Content_Location, &nsHttp::Content_MD5,
+  &nsHttp::Content_Range, &nsHttp::Content_Type, &nsHttp::Cookie,
+  &nsHttp::Date, &nsHttp::ETag, &nsHttp::Expires, &nsHttp::From,
+  &nsHttp::Host, &nsHttp::If_Match, &nsHttp::If_Modified_Since,
+  &nsHttp::If_None_Match, &nsHttp::If_Range, &nsHttp::If_Unmodified_Since,
+  &nsHttp::Keep_Alive, &nsHttp::Last_Modified, &nsHttp::Location,
+  &nsHttp::Max_Forwards, &nsHttp::Link, &nsHttp::Pragma,
+  &nsHttp::Proxy_Authenticate, &nsHttp::Proxy_Authorization,
+  &nsHttp::Range, &nsHttp::Referer, &nsHttp::Server, &nsHttp::Set_Cookie,
+  &nsHttp::Trailer, &nsHttp::Transfer_Encoding, &nsHttp::Upgrade,
+  &nsHttp::User_Agent, &nsHttp::Vary, &nsHttp::Prefer,
+  &nsHttp::WWW_Authenticate, &nsHttp::Warning,
+};
+
+static const uint32_t kAtomCount = mozilla::ArrayLength(kAtoms);
+
+static void
+FillHeaders(nsHttpHeaderArray& aHeaders)
+{
+  for (uint32_t i = 0; i < kAtomCount; ++i) {
+    nsPrintfCString value("value-%u", i);
+    ASSERT_EQ(NS_OK, aHeaders.SetHeader(*kAtoms[i], value, false,
+                                        nsHttpHeaderArray::eVarietyResponse));
+  }
+}
+
+TEST(TestHttpHeaderArray, Lookup)
+{
+  nsHttpHeaderArray headers;
+  ASSERT_FALSE(headers.HasHeader(nsHttp::Accept));
+  ASSERT_EQ(nullptr, headers.PeekHeader(nsHttp::Accept));
+
+  FillHeaders(headers);
+  ASSERT_EQ(kAtomCount, headers.Count());
+  for (uint32_t i = 0; i < kAtomCount; ++i) {
+    ASSERT_STREQ(nsPrintfCString("value-%u", i).get(),
+                 headers.PeekHeader(*kAtoms[i]));
+  }
+  ASSERT_FALSE(headers.HasHeader(nsHttp::X_Content_Type_Options));
+
+  // Removing entries shifts the ones behind them.
+  for (uint32_t i = 0; i < kAtomCount; i += 2) {
+    headers.ClearHeader(*kAtoms[i]);
+  }
+  for (uint32_t i = 0; i < kAtomCount; ++i) {
+    if (i % 2) {
+      ASSERT_STREQ(nsPrintfCString("value-%u", i).get(),
+                   headers.PeekHeader(*kAtoms[i]));
+    } else {
+      ASSERT_FALSE(headers.HasHeader(*kAtoms[i]));
+    }
+  }
+}
+
+TEST(TestHttpHeaderArray, Merge)
+{
+  nsHttpHeaderArray headers;
+  headers.SetHeader(nsHttp::Vary, NS_LITERAL_CSTRING("Accept"), true,
+                    nsHttpHeaderArray::eVarietyResponse);
+  headers.SetHeader(nsHttp::Vary, NS_LITERAL_CSTRING("Origin"), true,
+                    nsHttpHeaderArray::eVarietyResponse);
+  headers.SetHeader(nsHttp::Set_Cookie, NS_LITERAL_CSTRING("a=1"), true,
+                    nsHttpHeaderArray::eVarietyResponse);
+  headers.SetHeader(nsHttp::Set_Cookie, NS_LITERAL_CSTRING("b=2"), true,
+                    nsHttpHeaderArray::eVarietyResponse);
+
+  ASSERT_STREQ("Accept, Origin", headers.PeekHeader(nsHttp::Vary));
+  ASSERT_STREQ("a=1\nb=2", headers.PeekHeader(nsHttp::Set_Cookie));
+  ASSERT_TRUE(headers.HasHeaderValue(nsHttp::Vary, "Origin"));
+
+  headers.SetEmptyHeader(nsHttp::Vary, nsHttpHeaderArray::eVarietyResponse);
+  ASSERT_TRUE(headers.HasHeader(nsHttp::Vary));
+  ASSERT_STREQ("", headers.PeekHeader(nsHttp::Vary));
+
+  nsAutoCString flat;
+  headers.Flatten(flat, false, false);
+  ASSERT_TRUE(flat.EqualsLiteral("Vary: \r\nSet-Cookie: a=1\nb=2\r\n"));
+}
+
+TEST(TestHttpHeaderArray, CopyOnWrite)
+{
+  nsHttpHeaderArray headers;
+  FillHeaders(headers);
+
+  nsHttpHeaderArray copy(headers);
+  ASSERT_TRUE(copy == headers);
+  ASSERT_EQ(headers.PeekHeader(nsHttp::Host), copy.PeekHeader(nsHttp::Host));
+
+  // A value peeked before a modification stays valid.
+  const char* host = copy.PeekHeader(nsHttp::Host);
+  copy.SetHeader(nsHttp::Host, NS_LITERAL_CSTRING("example.com"), false,
+                 nsHttpHeaderArray::eVarietyResponse);
+  copy.ClearHeader(nsHttp::Accept);
+  ASSERT_FALSE(copy == headers);
+  ASSERT_STREQ("example.com", copy.PeekHeader(nsHttp::Host));
+  ASSERT_FALSE(copy.HasHeader(nsHttp::Accept));
+
+  // The original is not affected.
+  ASSERT_EQ(host, headers.PeekHeader(nsHttp::Host));
+  ASSERT_STREQ("value-0", headers.PeekHeader(nsHttp::Accept));
+  ASSERT_EQ(kAtomCount, headers.Count());
+  ASSERT_EQ(kAtomCount - 1, copy.Count());
+
+  headers.Clear();
+  ASSERT_EQ(0u, headers.Count());
+  ASSERT_STREQ("example.com", copy.PeekHeader(nsHttp::Host));
+}
@@ -450,6 +450,7 @@ nsHtml5Tokenizer::stateLoop(int32_t state, char16_t c, int32_t pos, char16_t* bu
               silentLineFeed();
             }
             default: {
+              pos = FindSpecialChar(buf, pos + 1, endPos, '<') - 1;
               continue;
             }
           }
@@ -796,6 +797,7 @@ nsHtml5Tokenizer::stateLoop(int32_t state, char16_t c, int32_t pos, char16_t* bu
             }
             default: {
               appendStrBuf(c);
+              pos = AppendAttributeValueRun(buf, pos, endPos, '\"');
               continue;
             }
           }
@@ -1430,6 +1432,7 @@ nsHtml5Tokenizer::stateLoop(int32_t state, char16_t c, int32_t pos, char16_t* bu
             }
             default: {
               appendStrBuf(c);
+              pos = AppendAttributeValueRun(buf, pos, endPos, '\'');
               continue;
             }
           }
@@ -1934,6 +1937,7 @@ nsHtml5Tokenizer::stateLoop(int32_t state, char16_t c, int32_t pos, char16_t* bu
               silentLineFeed();
             }
             default: {
+              pos = FindSpecialChar(buf, pos + 1, endPos, '<') - 1;
               continue;
             }
           }
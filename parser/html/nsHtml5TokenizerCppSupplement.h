@@ -3,6 +3,34 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "mozilla/Likely.h"
+#include "mozilla/SSE.h"
+
+#ifdef MOZILLA_MAY_SUPPORT_SSE2
+namespace mozilla {
+  namespace SSE2 {
+    int32_t Html5FindSpecialChar(const char16_t* aBuf, int32_t aPos,
+                                 int32_t aEnd, char16_t aDelimiter);
+  } // namespace SSE2
+} // namespace mozilla
+#endif
+
+int32_t
+nsHtml5Tokenizer::FindSpecialChar(char16_t* aBuf, int32_t aPos, int32_t aEnd,
+                                  char16_t aDelimiter)
+{
+#ifdef MOZILLA_MAY_SUPPORT_SSE2
+  if (mozilla::supports_sse2()) {
+    return mozilla::SSE2::Html5FindSpecialChar(aBuf, aPos, aEnd, aDelimiter);
+  }
+#endif
+  for (int32_t i = aPos; i < aEnd; i++) {
+    char16_t c = aBuf[i];
+    if (c == '&' || c == aDelimiter || c == '\r' || c == '\n' || c == '\0') {
+      return i;
+    }
+  }
+  return aEnd;
+}
 
 bool
 nsHtml5Tokenizer::EnsureBufferSpace(int32_t aLength)
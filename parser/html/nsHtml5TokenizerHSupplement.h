@@ -17,6 +17,28 @@ inline nsHtml5HtmlAttributes* GetAttributes()
  */
 bool EnsureBufferSpace(int32_t aLength);
 
+/**
+ * Returns the position of the first '&', '\r', '\n', NUL or aDelimiter at
+ * or after aPos in aBuf, or aEnd if there is none. This lets the data, RCDATA
+ * and quoted attribute value states skip over runs of characters that need no
+ * handling instead of going around the state loop for each of them.
+ */
+static int32_t FindSpecialChar(char16_t* aBuf, int32_t aPos, int32_t aEnd,
+                               char16_t aDelimiter);
+
+/**
+ * Appends the characters after aPos that need no handling in an attribute
+ * value quoted with aQuote to strBuf, and returns the position of the last
+ * one (aPos if there are none).
+ */
+inline int32_t AppendAttributeValueRun(char16_t* aBuf, int32_t aPos,
+                                       int32_t aEnd, char16_t aQuote)
+{
+  int32_t runEnd = FindSpecialChar(aBuf, aPos + 1, aEnd, aQuote);
+  appendStrBuf(aBuf, aPos + 1, runEnd - aPos - 1);
+  return runEnd - 1;
+}
+
 nsAutoPtr<nsHtml5Highlighter> mViewSource;
 
 /**
@@ -0,0 +1,52 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// This file should only be compiled if you're on x86 or x86_64.  Additionally,
+// you'll need to compile this file with -msse2 if you're using gcc.
+
+#include <emmintrin.h>
+#include "nscore.h"
+#include "mozilla/MathAlgorithms.h"
+
+namespace mozilla {
+namespace SSE2 {
+
+int32_t
+Html5FindSpecialChar(const char16_t* aBuf, int32_t aPos, int32_t aEnd,
+                     char16_t aDelimiter)
+{
+  const __m128i amp = _mm_set1_epi16('&');
+  const __m128i cr = _mm_set1_epi16('\r');
+  const __m128i lf = _mm_set1_epi16('\n');
+  const __m128i nul = _mm_setzero_si128();
+  const __m128i delimiter = _mm_set1_epi16(aDelimiter);
+
+  int32_t i = aPos;
+  for (; i + 8 <= aEnd; i += 8) {
+    __m128i chars =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(aBuf + i));
+    __m128i special =
+      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(chars, amp),
+                                _mm_cmpeq_epi16(chars, delimiter)),
+                   _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(chars, cr),
+                                             _mm_cmpeq_epi16(chars, lf)),
+                                _mm_cmpeq_epi16(chars, nul)));
+    int mask = _mm_movemask_epi8(special);
+    if (mask) {
+      // Each matching char16_t sets two bits of the mask.
+      return i + CountTrailingZeroes32(mask) / 2;
+    }
+  }
+
+  for (; i < aEnd; i++) {
+    char16_t c = aBuf[i];
+    if (c == '&' || c == aDelimiter || c == '\r' || c == '\n' || c == '\0') {
+      return i;
+    }
+  }
+  return aEnd;
+}
+
+} // namespace SSE2
+} // namespace mozilla
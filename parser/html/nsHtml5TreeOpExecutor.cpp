@@ -4,6 +4,8 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
+
 #include "mozilla/DebugOnly.h"
 #include "mozilla/Likely.h"
 #include "mozilla/dom/nsCSPService.h"
@@ -32,6 +34,7 @@
 #include "mozilla/Preferences.h"
 #include "nsIHTMLDocument.h"
 #include "nsIViewSourceChannel.h"
+#include "nsRefreshDriver.h"
 #include "xpcpublic.h"
 
 using namespace mozilla;
@@ -334,6 +337,30 @@ class nsHtml5FlushLoopGuard
     }
 };
 
+// How often deadline-driven flushes check the clock, in microseconds.
+static const double kFlushClockCheckIntervalUs = 500.0;
+
+// Returns how many tree ops to perform between clock checks when an op takes
+// aMicrosecondsPerOp on average.
+static uint32_t
+OpsBetweenClockChecks(double aMicrosecondsPerOp)
+{
+  if (aMicrosecondsPerOp <= 0.0) {
+    return 16;
+  }
+  double ops = kFlushClockCheckIntervalUs / aMicrosecondsPerOp;
+  return uint32_t(std::max(1.0, std::min(ops, 1024.0)));
+}
+
+TimeStamp
+nsHtml5TreeOpExecutor::GetFlushDeadline()
+{
+  TimeStamp latest =
+    TimeStamp::Now() + TimeDuration::FromMilliseconds(sMaxFlushSliceMs);
+  TimeStamp deadline = nsRefreshDriver::GetIdleDeadlineHint(latest);
+  return deadline < latest ? deadline : latest;
+}
+
 /**
  * The purpose of the loop here is to avoid returning to the main event loop
  */
@@ -355,6 +382,17 @@ nsHtml5TreeOpExecutor::RunFlushLoop()
   // Remember the entry time
   (void) nsContentSink::WillParseImpl();
 
+  // With html5.flushloop.deadline, yield when the refresh driver wants the
+  // main thread back instead of when nsContentSink's time budget runs out.
+  // The clock is only checked between batches of ops sized from the measured
+  // cost of an op, and we stop early if the next batch would overrun.
+  const bool useDeadline = sDeadlineFlush && !mRunsToCompletion &&
+                           mDocument && mDocument->GetShell();
+  TimeStamp deadline;
+  if (useDeadline) {
+    deadline = GetFlushDeadline();
+  }
+
   for (;;) {
     if (!mParser) {
       // Parse has terminated.
@@ -437,6 +475,13 @@ nsHtml5TreeOpExecutor::RunFlushLoop()
 
     uint32_t numberOfOpsToFlush = mOpQueue.Length();
 
+    uint32_t opsInBatch = OpsBetweenClockChecks(mMicrosecondsPerOp);
+    uint32_t opsLeftInBatch = opsInBatch;
+    TimeStamp batchStart;
+    if (useDeadline) {
+      batchStart = TimeStamp::Now();
+    }
+
     const nsHtml5TreeOperation* first = mOpQueue.Elements();
     const nsHtml5TreeOperation* last = first + numberOfOpsToFlush - 1;
     for (nsHtml5TreeOperation* iter = const_cast<nsHtml5TreeOperation*>(first);;) {
@@ -455,8 +500,25 @@ nsHtml5TreeOpExecutor::RunFlushLoop()
       // Be sure not to check the deadline if the last op was just performed.
       if (MOZ_UNLIKELY(iter == last)) {
         break;
-      } else if (MOZ_UNLIKELY(nsContentSink::DidProcessATokenImpl() == 
-                 NS_ERROR_HTMLPARSER_INTERRUPTED)) {
+      }
+      bool interrupted = false;
+      if (useDeadline) {
+        if (--opsLeftInBatch == 0) {
+          TimeStamp now = TimeStamp::Now();
+          double cost = (now - batchStart).ToMicroseconds() / opsInBatch;
+          mMicrosecondsPerOp = mMicrosecondsPerOp > 0.0 ?
+            (3.0 * mMicrosecondsPerOp + cost) / 4.0 : cost;
+          opsInBatch = opsLeftInBatch =
+            OpsBetweenClockChecks(mMicrosecondsPerOp);
+          batchStart = now;
+          interrupted = now + TimeDuration::FromMicroseconds(
+                                mMicrosecondsPerOp * opsInBatch) > deadline;
+        }
+      } else {
+        interrupted = nsContentSink::DidProcessATokenImpl() ==
+                      NS_ERROR_HTMLPARSER_INTERRUPTED;
+      }
+      if (MOZ_UNLIKELY(interrupted)) {
         mOpQueue.RemoveElementsAt(0, (iter - first) + 1);
         
         EndDocUpdate();
@@ -490,8 +552,9 @@ nsHtml5TreeOpExecutor::RunFlushLoop()
       
       // Always check the clock in nsContentSink right after a script
       StopDeflecting();
-      if (nsContentSink::DidProcessATokenImpl() == 
-          NS_ERROR_HTMLPARSER_INTERRUPTED) {
+      if (useDeadline ? TimeStamp::Now() >= deadline :
+                        nsContentSink::DidProcessATokenImpl() ==
+                          NS_ERROR_HTMLPARSER_INTERRUPTED) {
         #ifdef DEBUG_NS_HTML5_TREE_OP_EXECUTOR_FLUSH
           printf("REFLUSH SCHEDULED (after script): %d\n", 
             ++sTimesFlushLoopInterrupted);
@@ -838,6 +901,10 @@ nsHtml5TreeOpExecutor::InitializeStatics()
 {
   mozilla::Preferences::AddBoolVarCache(&sExternalViewSource,
                                         "view_source.editor.external");
+  mozilla::Preferences::AddBoolVarCache(&sDeadlineFlush,
+                                        "html5.flushloop.deadline");
+  mozilla::Preferences::AddUintVarCache(&sMaxFlushSliceMs,
+                                        "html5.flushloop.max_slice_ms", 50);
 }
 
 bool
@@ -1083,3 +1150,5 @@ uint32_t nsHtml5TreeOpExecutor::sLongestTimeOffTheEventLoop = 0;
 uint32_t nsHtml5TreeOpExecutor::sTimesFlushLoopInterrupted = 0;
 #endif
 bool nsHtml5TreeOpExecutor::sExternalViewSource = false;
+bool nsHtml5TreeOpExecutor::sDeadlineFlush = false;
+uint32_t nsHtml5TreeOpExecutor::sMaxFlushSliceMs = 50;
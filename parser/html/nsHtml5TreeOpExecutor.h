@@ -21,6 +21,7 @@
 #include "nsTHashtable.h"
 #include "nsHashKeys.h"
 #include "mozilla/LinkedList.h"
+#include "mozilla/TimeStamp.h"
 #include "nsHtml5DocumentBuilder.h"
 #include "mozilla/net/ReferrerPolicy.h"
 
@@ -43,6 +44,8 @@ class nsHtml5TreeOpExecutor final : public nsHtml5DocumentBuilder,
 
   private:
     static bool        sExternalViewSource;
+    static bool        sDeadlineFlush;
+    static uint32_t    sMaxFlushSliceMs;
 #ifdef DEBUG_NS_HTML5_TREE_OP_EXECUTOR_FLUSH
     static uint32_t    sAppendBatchMaxSize;
     static uint32_t    sAppendBatchSlotsExamined;
@@ -91,6 +94,12 @@ class nsHtml5TreeOpExecutor final : public nsHtml5DocumentBuilder,
      */
     bool                          mAlreadyComplainedAboutCharset;
 
+    /**
+     * How long performing a tree op takes on average, in microseconds, as
+     * measured by deadline-driven flushes. Zero until it has been measured.
+     */
+    double                        mMicrosecondsPerOp;
+
   public:
 
     nsHtml5TreeOpExecutor();
@@ -177,6 +186,13 @@ class nsHtml5TreeOpExecutor final : public nsHtml5DocumentBuilder,
                   
     void RunFlushLoop();
 
+    /**
+     * Returns when the flush that is about to start should yield to the event
+     * loop: the end of the main thread's idle period as estimated by the
+     * refresh driver, but no later than html5.flushloop.max_slice_ms from now.
+     */
+    mozilla::TimeStamp GetFlushDeadline();
+
     nsresult FlushDocumentWrite();
 
     void MaybeSuspend();
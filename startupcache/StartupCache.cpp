@@ -7,6 +7,8 @@
 #include "prio.h"
 #include "PLDHashTable.h"
 #include "nsXPCOMStrings.h"
+#include "mozilla/Compression.h"
+#include "mozilla/FileUtils.h"
 #include "mozilla/IOInterposer.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/scache/StartupCache.h"
@@ -26,8 +28,6 @@
 #include "nsIStringStream.h"
 #include "nsISupports.h"
 #include "nsITimer.h"
-#include "nsIZipWriter.h"
-#include "nsIZipReader.h"
 #include "nsWeakReference.h"
 #include "nsZipArchive.h"
 #include "mozilla/Omnijar.h"
@@ -36,6 +36,7 @@
 #include "nsThreadUtils.h"
 #include "nsXULAppAPI.h"
 #include "nsIProtocolHandler.h"
+#include "zlib.h"
 
 #ifdef IS_BIG_ENDIAN
 #define SC_ENDIAN "big"
@@ -52,6 +53,33 @@
 namespace mozilla {
 namespace scache {
 
+/*
+ * Cache file format. Integers are in native byte order; the file name
+ * already encodes word size and endianness.
+ *
+ *   data      each entry's data, compressed on its own with LZ4
+ *   index     for each entry: uint16_t key length, the key, then
+ *             uint32_t offset, compressed size, size and CRC-32 of the
+ *             uncompressed data (CacheIndexEntry)
+ *   trailer   CacheFileTrailer
+ *
+ * Only the index is read when the file is loaded; entries are decompressed
+ * from the mapping when they are asked for. New entries are appended by
+ * writing their data over the old index and trailer, followed by an index
+ * of all entries and a new trailer, so existing data is never rewritten.
+ */
+static const char kCacheFileMagic[8] = { 'S', 'C', 'a', 'c', 'h', 'e', '0', '1' };
+
+struct CacheFileTrailer
+{
+  uint32_t indexOffset;
+  uint32_t indexLength;
+  uint32_t indexChecksum;   // CRC-32 of the index
+  uint32_t entryCount;
+  PRTime creationTime;      // when the file was first written, for telemetry
+  char magic[sizeof(kCacheFileMagic)];
+};
+
 MOZ_DEFINE_MALLOC_SIZE_OF(StartupCacheMallocSizeOf)
 
 NS_IMETHODIMP
@@ -118,7 +146,8 @@ enum StartupCache::TelemetrifyAge StartupCache::gPostFlushAgeAction = StartupCac
 NS_IMPL_ISUPPORTS(StartupCache, nsIMemoryReporter)
 
 StartupCache::StartupCache()
-  : mArchive(nullptr), mStartupWriteInitiated(false), mWriteThread(nullptr)
+  : mCacheMap(nullptr), mCacheData(nullptr), mCacheSize(0), mAppendOffset(0)
+  , mCreationTime(0), mStartupWriteInitiated(false), mWriteThread(nullptr)
 { }
 
 StartupCache::~StartupCache()
@@ -136,9 +165,10 @@ StartupCache::~StartupCache()
   // it on the main thread and block the shutdown we simply wont update
   // the startup cache. Always do this if the file doesn't exist since
   // we use it part of the package step.
-  if (!mArchive) {
+  if (!mCacheData) {
     WriteToDisk();
   }
+  CloseCacheFile();
 
   UnregisterWeakMemoryReporter(this);
 }
@@ -235,40 +265,150 @@ StartupCache::LoadArchive(enum TelemetrifyAge flag)
     return NS_ERROR_FAILURE;
 
   bool exists;
-  mArchive = nullptr;
+  CloseCacheFile();
   nsresult rv = mFile->Exists(&exists);
   if (NS_FAILED(rv) || !exists)
     return NS_ERROR_FILE_NOT_FOUND;
-  
-  mArchive = new nsZipArchive();
-  rv = mArchive->OpenArchive(mFile);
-  if (NS_FAILED(rv) || flag == IGNORE_AGE)
+
+  AutoFDClose fd;
+  rv = mFile->OpenNSPRFileDesc(PR_RDONLY, 0000, &fd.rwget());
+  if (NS_FAILED(rv))
     return rv;
 
-  nsCString comment;
-  if (!mArchive->GetComment(comment)) {
+  int64_t size = PR_Available64(fd);
+  if (size >= INT32_MAX)
+    return NS_ERROR_FILE_TOO_BIG;
+  if (size < int64_t(sizeof(CacheFileTrailer)))
+    return NS_ERROR_FILE_CORRUPTED;
+
+  // The mapping stays valid after the descriptor is closed.
+  mCacheMap = PR_CreateFileMap(fd, size, PR_PROT_READONLY);
+  if (!mCacheMap)
+    return NS_ERROR_FAILURE;
+  mCacheData = static_cast<const uint8_t*>(PR_MemMap(mCacheMap, 0, uint32_t(size)));
+  if (!mCacheData) {
+    CloseCacheFile();
+    return NS_ERROR_FAILURE;
+  }
+  mCacheSize = uint32_t(size);
+
+  rv = ParseCacheFile();
+  if (NS_FAILED(rv)) {
+    CloseCacheFile();
     return rv;
   }
 
-  const char *data;
-  size_t len = NS_CStringGetData(comment, &data);
-  PRTime creationStamp;
-  // We might not have a comment if the startup cache file was created
-  // before we started recording creation times in the comment.
-  if (len == sizeof(creationStamp)) {
-    memcpy(&creationStamp, data, len);
-    PRTime current = PR_Now();
-    int64_t diff = current - creationStamp;
+  if (flag == IGNORE_AGE)
+    return NS_OK;
+
+  PRTime current = PR_Now();
+  int64_t diff = current - mCreationTime;
 
-    // We can't use AccumulateTimeDelta here because we have no way of
-    // reifying a TimeStamp from creationStamp.
-    int64_t usec_per_hour = PR_USEC_PER_SEC * int64_t(3600);
-    int64_t hour_diff = (diff + usec_per_hour - 1) / usec_per_hour;
-    mozilla::Telemetry::Accumulate(Telemetry::STARTUP_CACHE_AGE_HOURS,
-                                   hour_diff);
+  // We can't use AccumulateTimeDelta here because we have no way of
+  // reifying a TimeStamp from the creation time.
+  int64_t usec_per_hour = PR_USEC_PER_SEC * int64_t(3600);
+  int64_t hour_diff = (diff + usec_per_hour - 1) / usec_per_hour;
+  mozilla::Telemetry::Accumulate(Telemetry::STARTUP_CACHE_AGE_HOURS,
+                                 hour_diff);
+
+  return NS_OK;
+}
+
+/**
+ * Reads the trailer and index of the mapped cache file into mIndex.
+ */
+nsresult
+StartupCache::ParseCacheFile()
+{
+  CacheFileTrailer trailer;
+  memcpy(&trailer, mCacheData + mCacheSize - sizeof(trailer), sizeof(trailer));
+  if (memcmp(trailer.magic, kCacheFileMagic, sizeof(kCacheFileMagic)) ||
+      trailer.indexOffset > mCacheSize - sizeof(trailer) ||
+      trailer.indexLength != mCacheSize - sizeof(trailer) - trailer.indexOffset) {
+    return NS_ERROR_FILE_CORRUPTED;
   }
 
-  return rv;
+  const uint8_t* index = mCacheData + trailer.indexOffset;
+  if (crc32(0L, index, trailer.indexLength) != trailer.indexChecksum) {
+    return NS_ERROR_FILE_CORRUPTED;
+  }
+
+  const uint8_t* cur = index;
+  const uint8_t* end = index + trailer.indexLength;
+  for (uint32_t i = 0; i < trailer.entryCount; i++) {
+    uint16_t keyLength;
+    if (size_t(end - cur) < sizeof(keyLength))
+      return NS_ERROR_FILE_CORRUPTED;
+    memcpy(&keyLength, cur, sizeof(keyLength));
+    cur += sizeof(keyLength);
+
+    CacheIndexEntry entry;
+    if (size_t(end - cur) < keyLength + sizeof(entry))
+      return NS_ERROR_FILE_CORRUPTED;
+    nsDependentCSubstring key(reinterpret_cast<const char*>(cur), keyLength);
+    cur += keyLength;
+    memcpy(&entry, cur, sizeof(entry));
+    cur += sizeof(entry);
+
+    if (entry.offset > trailer.indexOffset ||
+        entry.compressedSize > trailer.indexOffset - entry.offset) {
+      return NS_ERROR_FILE_CORRUPTED;
+    }
+    mIndex.Put(key, new CacheIndexEntry(entry));
+  }
+  if (cur != end)
+    return NS_ERROR_FILE_CORRUPTED;
+
+  mAppendOffset = trailer.indexOffset;
+  mCreationTime = trailer.creationTime;
+  return NS_OK;
+}
+
+void
+StartupCache::CloseCacheFile()
+{
+  if (mCacheData) {
+    PR_MemUnmap(const_cast<uint8_t*>(mCacheData), mCacheSize);
+    mCacheData = nullptr;
+  }
+  if (mCacheMap) {
+    PR_CloseFileMap(mCacheMap);
+    mCacheMap = nullptr;
+  }
+  mCacheSize = 0;
+  mAppendOffset = 0;
+  mIndex.Clear();
+}
+
+nsresult
+StartupCache::GetBufferFromCacheFile(const char* id, UniquePtr<char[]>* outbuf,
+                                     uint32_t* length)
+{
+  if (!mCacheData)
+    return NS_ERROR_NOT_AVAILABLE;
+
+  CacheIndexEntry* entry = mIndex.Get(nsDependentCString(id));
+  if (!entry)
+    return NS_ERROR_NOT_AVAILABLE;
+
+  auto data = MakeUniqueFallible<char[]>(entry->size);
+  if (!data)
+    return NS_ERROR_OUT_OF_MEMORY;
+
+  size_t decompressed;
+  const char* source = reinterpret_cast<const char*>(mCacheData + entry->offset);
+  if (!Compression::LZ4::decompress(source, entry->compressedSize, data.get(),
+                                    entry->size, &decompressed) ||
+      decompressed != entry->size ||
+      crc32(0L, reinterpret_cast<const Bytef*>(data.get()), entry->size) !=
+        entry->checksum) {
+    NS_WARNING("Corrupted entry in disk StartupCache.");
+    return NS_ERROR_FILE_CORRUPTED;
+  }
+
+  *outbuf = Move(data);
+  *length = entry->size;
+  return NS_OK;
 }
 
 namespace {
@@ -313,7 +453,7 @@ StartupCache::GetBuffer(const char* id, UniquePtr<char[]>* outbuf, uint32_t* len
     }
   }
 
-  nsresult rv = GetBufferFromZipArchive(mArchive, true, id, outbuf, length);
+  nsresult rv = GetBufferFromCacheFile(id, outbuf, length);
   if (NS_SUCCEEDED(rv))
     return rv;
 
@@ -351,12 +491,7 @@ StartupCache::PutBuffer(const char* id, const char* inbuf, uint32_t len)
     return NS_OK;
   }
 
-#ifdef DEBUG
-  if (mArchive) {
-    nsZipItem* zipItem = mArchive->GetItem(id);
-    NS_ASSERTION(zipItem == nullptr, "Existing entry in disk StartupCache.");
-  }
-#endif
+  NS_ASSERTION(!mIndex.Get(idStr), "Existing entry in disk StartupCache.");
 
   entry = new CacheEntry(Move(data), len);
   mTable.Put(idStr, entry);
@@ -367,7 +502,7 @@ StartupCache::PutBuffer(const char* id, const char* inbuf, uint32_t len)
 size_t
 StartupCache::SizeOfMapping()
 {
-    return mArchive ? mArchive->SizeOfMapping() : 0;
+    return mCacheData ? mCacheSize : 0;
 }
 
 size_t
@@ -385,42 +520,21 @@ StartupCache::HeapSizeOfIncludingThis(mozilla::MallocSizeOf aMallocSizeOf) const
 
     n += mPendingWrites.ShallowSizeOfExcludingThis(aMallocSizeOf);
 
+    n += mIndex.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    for (auto iter = mIndex.ConstIter(); !iter.Done(); iter.Next()) {
+        n += iter.Key().SizeOfExcludingThisIfUnshared(aMallocSizeOf);
+        n += aMallocSizeOf(iter.Data());
+    }
+
     return n;
 }
 
-struct CacheWriteHolder
+static bool
+WriteAll(PRFileDesc* fd, const void* buf, uint32_t len)
 {
-  nsCOMPtr<nsIZipWriter> writer;
-  nsCOMPtr<nsIStringInputStream> stream;
-  PRTime time;
-};
-
-static void
-CacheCloseHelper(const nsACString& key, const CacheEntry* data,
-                 const CacheWriteHolder* holder)
-{
-  MOZ_ASSERT(data); // assert key was found in mTable.
-
-  nsresult rv;
-  nsIStringInputStream* stream = holder->stream;
-  nsIZipWriter* writer = holder->writer;
-
-  stream->ShareData(data->data.get(), data->size);
-
-#ifdef DEBUG
-  bool hasEntry;
-  rv = writer->HasEntry(key, &hasEntry);
-  NS_ASSERTION(NS_SUCCEEDED(rv) && hasEntry == false, 
-               "Existing entry in disk StartupCache.");
-#endif
-  rv = writer->AddEntryStream(key, holder->time, true, stream, false);
-
-  if (NS_FAILED(rv)) {
-    NS_WARNING("cache entry deleted but not written to disk.");
-  }
+  return PR_Write(fd, buf, len) == int32_t(len);
 }
 
-
 /** 
  * WriteToDisk writes the cache out to disk. Callers of WriteToDisk need to call WaitOnWriteThread
  * to make sure there isn't a write happening on another thread
@@ -434,48 +548,90 @@ StartupCache::WriteToDisk()
   if (mTable.Count() == 0)
     return;
 
-  nsCOMPtr<nsIZipWriter> zipW = do_CreateInstance("@mozilla.org/zipwriter;1");
-  if (!zipW)
-    return;
-
-  rv = zipW->Open(mFile, PR_RDWR | PR_CREATE_FILE);
+  // Entries go after those already in a valid file, otherwise the file is
+  // started over. We keep the index, but the mapping has to go before the
+  // file is written to, so Windows doesn't choke.
+  bool append = !!mCacheData;
+  uint32_t offset = append ? mAppendOffset : 0;
+  PRTime creationTime = append ? mCreationTime : PR_Now();
+  nsClassHashtable<nsCStringHashKey, CacheIndexEntry> index;
+  index.SwapElements(mIndex);
+  CloseCacheFile();
+
+  AutoFDClose fd;
+  int32_t flags = PR_WRONLY | PR_CREATE_FILE | (append ? 0 : PR_TRUNCATE);
+  rv = mFile->OpenNSPRFileDesc(flags, 0644, &fd.rwget());
   if (NS_FAILED(rv)) {
-    NS_WARNING("could not open zipfile for write");
+    NS_WARNING("could not open startup cache file for write");
     return;
-  } 
-
-  // If we didn't have an mArchive member, that means that we failed to
-  // open the startup cache for reading.  Therefore, we need to record
-  // the time of creation in a zipfile comment; this will be useful for
-  // Telemetry statistics.
-  PRTime now = PR_Now();
-  if (!mArchive) {
-    nsCString comment;
-    comment.Assign((char *)&now, sizeof(now));
-    zipW->SetComment(comment);
   }
-
-  nsCOMPtr<nsIStringInputStream> stream 
-    = do_CreateInstance("@mozilla.org/io/string-input-stream;1", &rv);
-  if (NS_FAILED(rv)) {
-    NS_WARNING("Couldn't create string input stream.");
+  if (PR_Seek64(fd, offset, PR_SEEK_SET) != int64_t(offset)) {
+    NS_WARNING("could not seek in startup cache file");
     return;
   }
 
-  CacheWriteHolder holder;
-  holder.stream = stream;
-  holder.writer = zipW;
-  holder.time = now;
-
+  UniquePtr<char[]> compressed;
+  size_t compressedCapacity = 0;
   for (auto key = mPendingWrites.begin(); key != mPendingWrites.end(); key++) {
-    CacheCloseHelper(*key, mTable.Get(*key), &holder);
+    CacheEntry* data = mTable.Get(*key);
+    MOZ_ASSERT(data); // assert key was found in mTable.
+    if (key->Length() > UINT16_MAX) {
+      NS_WARNING("StartupCache key too long, not written to disk.");
+      continue;
+    }
+
+    size_t maxSize = Compression::LZ4::maxCompressedSize(data->size);
+    if (maxSize > compressedCapacity) {
+      compressed = MakeUniqueFallible<char[]>(maxSize);
+      if (!compressed) {
+        return;
+      }
+      compressedCapacity = maxSize;
+    }
+
+    CacheIndexEntry* entry = new CacheIndexEntry();
+    entry->offset = offset;
+    entry->compressedSize =
+      Compression::LZ4::compress(data->data.get(), data->size, compressed.get());
+    entry->size = data->size;
+    entry->checksum = crc32(0L, reinterpret_cast<const Bytef*>(data->data.get()),
+                            data->size);
+    index.Put(*key, entry);
+
+    if (!WriteAll(fd, compressed.get(), entry->compressedSize)) {
+      NS_WARNING("cache entry deleted but not written to disk.");
+      return;
+    }
+    offset += entry->compressedSize;
   }
   mPendingWrites.Clear();
   mTable.Clear();
 
-  // Close the archive so Windows doesn't choke.
-  mArchive = nullptr;
-  zipW->Close();
+  nsAutoCString indexData;
+  for (auto iter = index.ConstIter(); !iter.Done(); iter.Next()) {
+    uint16_t keyLength = iter.Key().Length();
+    indexData.Append(reinterpret_cast<const char*>(&keyLength), sizeof(keyLength));
+    indexData.Append(iter.Key());
+    indexData.Append(reinterpret_cast<const char*>(iter.Data()),
+                     sizeof(CacheIndexEntry));
+  }
+
+  CacheFileTrailer trailer;
+  trailer.indexOffset = offset;
+  trailer.indexLength = indexData.Length();
+  trailer.indexChecksum =
+    crc32(0L, reinterpret_cast<const Bytef*>(indexData.get()), indexData.Length());
+  trailer.entryCount = index.Count();
+  trailer.creationTime = creationTime;
+  memcpy(trailer.magic, kCacheFileMagic, sizeof(kCacheFileMagic));
+
+  // The file only ever grows, so nothing of the old trailer is left behind.
+  if (!WriteAll(fd, indexData.get(), indexData.Length()) ||
+      !WriteAll(fd, &trailer, sizeof(trailer))) {
+    NS_WARNING("could not write startup cache index");
+    return;
+  }
+  fd.dispose();
 
   // We succesfully wrote the archive to disk; mark the disk file as trusted
   gIgnoreDiskCache = false;
@@ -492,7 +648,7 @@ StartupCache::InvalidateCache()
   WaitOnWriteThread();
   mPendingWrites.Clear();
   mTable.Clear();
-  mArchive = nullptr;
+  CloseCacheFile();
   nsresult rv = mFile->Remove(false);
   if (NS_FAILED(rv) && rv != NS_ERROR_FILE_TARGET_DOES_NOT_EXIST &&
       rv != NS_ERROR_FILE_NOT_FOUND) {
@@ -17,6 +17,7 @@
 #include "nsIObserver.h"
 #include "nsIOutputStream.h"
 #include "nsIFile.h"
+#include "prio.h"
 #include "mozilla/Attributes.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/StaticPtr.h"
@@ -91,6 +92,15 @@ struct CacheEntry
   }
 };
 
+// Where an entry of the cache file is; see StartupCache.cpp for the format.
+struct CacheIndexEntry
+{
+  uint32_t offset;          // of the compressed data in the file
+  uint32_t compressedSize;
+  uint32_t size;            // uncompressed
+  uint32_t checksum;        // CRC-32 of the uncompressed data
+};
+
 // We don't want to refcount StartupCache, and ObserverService wants to
 // refcount its listeners, so we'll let it refcount this instead.
 class StartupCacheListener final : public nsIObserver
@@ -151,6 +161,10 @@ private:
   static enum TelemetrifyAge gPostFlushAgeAction;
 
   nsresult LoadArchive(enum TelemetrifyAge flag);
+  nsresult ParseCacheFile();
+  void CloseCacheFile();
+  nsresult GetBufferFromCacheFile(const char* id, UniquePtr<char[]>* outbuf,
+                                  uint32_t* length);
   nsresult Init();
   void WriteToDisk();
   nsresult ResetStartupWriteTimer();
@@ -162,9 +176,18 @@ private:
 
   nsClassHashtable<nsCStringHashKey, CacheEntry> mTable;
   nsTArray<nsCString> mPendingWrites;
-  RefPtr<nsZipArchive> mArchive;
   nsCOMPtr<nsIFile> mFile;
 
+  // The cache file as loaded by LoadArchive: its mapping and its index.
+  // mCacheData is null if there is no usable file.
+  PRFileMap* mCacheMap;
+  const uint8_t* mCacheData;
+  uint32_t mCacheSize;
+  // Where the index starts, which is where new entries get appended.
+  uint32_t mAppendOffset;
+  PRTime mCreationTime;
+  nsClassHashtable<nsCStringHashKey, CacheIndexEntry> mIndex;
+
   nsCOMPtr<nsIObserverService> mObserverService;
   RefPtr<StartupCacheListener> mListener;
   nsCOMPtr<nsITimer> mTimer;
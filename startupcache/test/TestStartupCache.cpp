@@ -113,6 +113,44 @@ TestStartupWriteRead() {
   return NS_OK;
 }
 
+nsresult
+TestIncrementalWrite() {
+  nsresult rv;
+  nsCOMPtr<nsIStartupCache> sc
+    = do_GetService("@mozilla.org/startupcache/cache;1", &rv);
+  sc->InvalidateCache();
+
+  const char* buf1 = "BeardBook launch plan";
+  const char* id1 = "id1";
+  const char* buf2 = "BeardBook launch plan, revised";
+  const char* id2 = "id2";
+  UniquePtr<char[]> outbuf;
+  uint32_t len;
+
+  rv = sc->PutBuffer(id1, buf1, strlen(buf1) + 1);
+  NS_ENSURE_SUCCESS(rv, rv);
+  rv = sc->ResetStartupWriteTimer();
+  rv = WaitForStartupTimer();
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  // The second write appends to the file written by the first one.
+  rv = sc->PutBuffer(id2, buf2, strlen(buf2) + 1);
+  NS_ENSURE_SUCCESS(rv, rv);
+  rv = sc->ResetStartupWriteTimer();
+  rv = WaitForStartupTimer();
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  rv = sc->GetBuffer(id1, &outbuf, &len);
+  NS_ENSURE_SUCCESS(rv, rv);
+  NS_ENSURE_STR_MATCH(buf1, outbuf.get(), "read of entry before append");
+
+  rv = sc->GetBuffer(id2, &outbuf, &len);
+  NS_ENSURE_SUCCESS(rv, rv);
+  NS_ENSURE_STR_MATCH(buf2, outbuf.get(), "read of appended entry");
+
+  return NS_OK;
+}
+
 nsresult
 TestWriteInvalidateRead() {
   nsresult rv;
@@ -460,6 +498,8 @@ int main(int argc, char** argv)
     sc->RecordAgesAlways();
   if (NS_FAILED(TestStartupWriteRead()))
     rv = 1;
+  if (NS_FAILED(TestIncrementalWrite()))
+    rv = 1;
   if (NS_FAILED(TestWriteInvalidateRead()))
     rv = 1;
   if (NS_FAILED(TestWriteObject()))
@@ -8,7 +8,9 @@
 
 #include "nsProxyRelease.h"
 
+#include "mozStorageAsyncStatement.h"
 #include "mozStorageBindingParamsArray.h"
+#include "mozStorageConnection.h"
 #include "mozStorageStatementData.h"
 #include "mozStorageAsyncStatementExecution.h"
 
@@ -45,7 +47,7 @@ public:
   NS_IMETHOD Run() override
   {
     if (mStatement->mAsyncStatement) {
-      sqlite3_finalize(mStatement->mAsyncStatement);
+      (void)mConnection->releaseCachedStatement(mStatement->mAsyncStatement);
       mStatement->mAsyncStatement = nullptr;
     }
 
@@ -90,7 +92,7 @@ public:
 
   NS_IMETHOD Run() override
   {
-    (void)::sqlite3_finalize(mAsyncStatement);
+    (void)mConnection->releaseCachedStatement(mAsyncStatement);
     mAsyncStatement = nullptr;
 
     nsCOMPtr<nsIThread> target(mConnection->threadOpenedOn);
@@ -188,11 +190,27 @@ StorageBaseStatementInternal::ExecuteAsync(
   StatementData data;
   nsresult rv = getAsynchronousStatementData(data);
   NS_ENSURE_SUCCESS(rv, rv);
+
+  // A busy connection with a reader pool hands asynchronous SELECTs to one of
+  // its readers, binding our parameters to the reader's statement.
+  RefPtr<Connection> connection = mDBConnection;
+  sqlite3 *nativeConnection = mNativeConnection;
+  nsCOMPtr<mozIStorageAsyncStatement> asyncStatement = do_QueryInterface(this);
+  if (asyncStatement) {
+    RefPtr<AsyncStatement> readerStatement = mDBConnection->readerStatementFor(
+      static_cast<AsyncStatement *>(asyncStatement.get()));
+    if (readerStatement) {
+      RefPtr<BindingParamsArray> params = static_cast<BindingParamsArray *>(data);
+      data = StatementData(nullptr, params.forget(), readerStatement);
+      connection = readerStatement->getOwner();
+      nativeConnection = readerStatement->mNativeConnection;
+    }
+  }
   NS_ENSURE_TRUE(stmts.AppendElement(data), NS_ERROR_OUT_OF_MEMORY);
 
   // Dispatch to the background
-  return AsyncExecuteStatements::execute(stmts, mDBConnection,
-                                         mNativeConnection, aCallback, _stmt);
+  return AsyncExecuteStatements::execute(stmts, connection,
+                                         nativeConnection, aCallback, _stmt);
 }
 
 NS_IMETHODIMP
@@ -13,6 +13,7 @@
 #include "mozilla/dom/quota/QuotaManager.h"
 #include "mozilla/dom/quota/QuotaObject.h"
 #include "mozilla/IOInterposer.h"
+#include "mozilla/ThreadLocal.h"
 
 // The last VFS version for which this file has been updated.
 #define LAST_KNOWN_VFS_VERSION 3
@@ -37,6 +38,8 @@ using namespace mozilla::dom::quota;
 
 struct Histograms {
   const char *name;
+  // key of this database class in the MOZ_SQLITE_*_LATENCY_MS histograms
+  const char *key;
   const Telemetry::ID readB;
   const Telemetry::ID writeB;
   const Telemetry::ID readMS;
@@ -44,8 +47,9 @@ struct Histograms {
   const Telemetry::ID syncMS;
 };
 
-#define SQLITE_TELEMETRY(FILENAME, HGRAM) \
+#define SQLITE_TELEMETRY(FILENAME, KEY, HGRAM) \
   { FILENAME, \
+    KEY, \
     Telemetry::MOZ_SQLITE_ ## HGRAM ## _READ_B, \
     Telemetry::MOZ_SQLITE_ ## HGRAM ## _WRITE_B, \
     Telemetry::MOZ_SQLITE_ ## HGRAM ## _READ_MS, \
@@ -54,13 +58,23 @@ struct Histograms {
   }
 
 Histograms gHistograms[] = {
-  SQLITE_TELEMETRY("places.sqlite", PLACES),
-  SQLITE_TELEMETRY("cookies.sqlite", COOKIES),
-  SQLITE_TELEMETRY("webappsstore.sqlite", WEBAPPS),
-  SQLITE_TELEMETRY(nullptr, OTHER)
+  SQLITE_TELEMETRY("places.sqlite", "places", PLACES),
+  SQLITE_TELEMETRY("cookies.sqlite", "cookies", COOKIES),
+  SQLITE_TELEMETRY("webappsstore.sqlite", "webapps", WEBAPPS),
+  SQLITE_TELEMETRY(nullptr, "other", OTHER)
 };
 #undef SQLITE_TELEMETRY
 
+/**
+ * Bytes read and written and syncs performed through this VFS by the current
+ * thread, so that callers can tell how much IO a statement caused.  They wrap
+ * around, so only differences between two readings are meaningful.
+ */
+MOZ_THREAD_LOCAL(uint32_t) sThreadReadBytes;
+MOZ_THREAD_LOCAL(uint32_t) sThreadWriteBytes;
+MOZ_THREAD_LOCAL(uint32_t) sThreadSyncs;
+bool sThreadIOCountersInitialized = false;
+
 /** RAII class for measuring how long io takes on/off main thread
  */
 class IOThreadAutoTimer {
@@ -82,7 +96,9 @@ public:
     IOInterposeObserver::Operation aOp = IOInterposeObserver::OpNone)
     : start(TimeStamp::Now()),
       id(aId),
-      op(aOp)
+      op(aOp),
+      latencyId(Telemetry::HistogramCount),
+      latencyKey(nullptr)
   {
   }
 
@@ -95,7 +111,28 @@ public:
   explicit IOThreadAutoTimer(IOInterposeObserver::Operation aOp)
     : start(TimeStamp::Now()),
       id(Telemetry::HistogramCount),
-      op(aOp)
+      op(aOp),
+      latencyId(Telemetry::HistogramCount),
+      latencyKey(nullptr)
+  {
+  }
+
+  /**
+   * This constructor additionally records the duration of the operation in
+   * a keyed latency histogram, under the key of the file's database class.
+   *
+   * @param aLatencyId takes a keyed telemetry histogram id.
+   *
+   * @param aLatencyKey the key to record the duration under.
+   */
+  IOThreadAutoTimer(Telemetry::ID aId, Telemetry::ID aLatencyId,
+                    const char *aLatencyKey,
+                    IOInterposeObserver::Operation aOp)
+    : start(TimeStamp::Now()),
+      id(aId),
+      op(aOp),
+      latencyId(aLatencyId),
+      latencyKey(aLatencyKey)
   {
   }
 
@@ -107,6 +144,10 @@ public:
       Telemetry::AccumulateTimeDelta(static_cast<Telemetry::ID>(id + mainThread),
                                      start, end);
     }
+    if (latencyKey) {
+      Telemetry::Accumulate(latencyId, nsDependentCString(latencyKey),
+                            static_cast<uint32_t>((end - start).ToMilliseconds()));
+    }
     // We don't report SQLite I/O on Windows because we have a comprehensive
     // mechanism for intercepting I/O on that platform that captures a superset
     // of the data captured here.
@@ -128,6 +169,8 @@ private:
   const TimeStamp start;
   const Telemetry::ID id;
   IOInterposeObserver::Operation op;
+  const Telemetry::ID latencyId;
+  const char *latencyKey;
 };
 
 struct telemetry_file {
@@ -369,12 +412,16 @@ int
 xRead(sqlite3_file *pFile, void *zBuf, int iAmt, sqlite_int64 iOfst)
 {
   telemetry_file *p = (telemetry_file *)pFile;
-  IOThreadAutoTimer ioTimer(p->histograms->readMS, IOInterposeObserver::OpRead);
+  IOThreadAutoTimer ioTimer(p->histograms->readMS,
+                            Telemetry::MOZ_SQLITE_READ_LATENCY_MS,
+                            p->histograms->key, IOInterposeObserver::OpRead);
   int rc;
   rc = p->pReal->pMethods->xRead(p->pReal, zBuf, iAmt, iOfst);
   // sqlite likes to read from empty files, this is normal, ignore it.
   if (rc != SQLITE_IOERR_SHORT_READ)
     Telemetry::Accumulate(p->histograms->readB, rc == SQLITE_OK ? iAmt : 0);
+  if (rc == SQLITE_OK && sThreadIOCountersInitialized)
+    sThreadReadBytes.set(sThreadReadBytes.get() + iAmt);
   return rc;
 }
 
@@ -398,7 +445,9 @@ int
 xWrite(sqlite3_file *pFile, const void *zBuf, int iAmt, sqlite_int64 iOfst)
 {
   telemetry_file *p = (telemetry_file *)pFile;
-  IOThreadAutoTimer ioTimer(p->histograms->writeMS, IOInterposeObserver::OpWrite);
+  IOThreadAutoTimer ioTimer(p->histograms->writeMS,
+                            Telemetry::MOZ_SQLITE_WRITE_LATENCY_MS,
+                            p->histograms->key, IOInterposeObserver::OpWrite);
   int rc;
   if (p->quotaObject) {
     MOZ_ASSERT(INT64_MAX - iOfst >= iAmt);
@@ -408,6 +457,8 @@ xWrite(sqlite3_file *pFile, const void *zBuf, int iAmt, sqlite_int64 iOfst)
   }
   rc = p->pReal->pMethods->xWrite(p->pReal, zBuf, iAmt, iOfst);
   Telemetry::Accumulate(p->histograms->writeB, rc == SQLITE_OK ? iAmt : 0);
+  if (rc == SQLITE_OK && sThreadIOCountersInitialized)
+    sThreadWriteBytes.set(sThreadWriteBytes.get() + iAmt);
   if (p->quotaObject && rc != SQLITE_OK) {
     NS_WARNING("xWrite failed on a quota-controlled file, attempting to "
                "update its current size...");
@@ -425,10 +476,11 @@ xWrite(sqlite3_file *pFile, const void *zBuf, int iAmt, sqlite_int64 iOfst)
 int
 xTruncate(sqlite3_file *pFile, sqlite_int64 size)
 {
-  IOThreadAutoTimer ioTimer(Telemetry::MOZ_SQLITE_TRUNCATE_MS);
   telemetry_file *p = (telemetry_file *)pFile;
+  IOThreadAutoTimer ioTimer(Telemetry::HistogramCount,
+                            Telemetry::MOZ_SQLITE_TRUNCATE_LATENCY_MS,
+                            p->histograms->key, IOInterposeObserver::OpNone);
   int rc;
-  Telemetry::AutoTimer<Telemetry::MOZ_SQLITE_TRUNCATE_MS> timer;
   if (p->quotaObject) {
     if (p->fileChunkSize > 0) {
       // Round up to the smallest multiple of the chunk size that will hold all
@@ -467,7 +519,11 @@ int
 xSync(sqlite3_file *pFile, int flags)
 {
   telemetry_file *p = (telemetry_file *)pFile;
-  IOThreadAutoTimer ioTimer(p->histograms->syncMS, IOInterposeObserver::OpFSync);
+  IOThreadAutoTimer ioTimer(p->histograms->syncMS,
+                            Telemetry::MOZ_SQLITE_SYNC_LATENCY_MS,
+                            p->histograms->key, IOInterposeObserver::OpFSync);
+  if (sThreadIOCountersInitialized)
+    sThreadSyncs.set(sThreadSyncs.get() + 1);
   return p->pReal->pMethods->xSync(p->pReal, flags);
 }
 
@@ -852,6 +908,10 @@ sqlite3_vfs* ConstructTelemetryVFS()
     return nullptr;
   }
 
+  sThreadIOCountersInitialized = sThreadReadBytes.init() &&
+                                 sThreadWriteBytes.init() &&
+                                 sThreadSyncs.init();
+
   sqlite3_vfs *tvfs = new ::sqlite3_vfs;
   memset(tvfs, 0, sizeof(::sqlite3_vfs));
   // If the VFS version is higher than the last known one, you should update
@@ -898,5 +958,22 @@ GetQuotaObjectForFile(sqlite3_file *pFile)
   return result.forget();
 }
 
+void
+GetThreadIOCounters(uint32_t *aReadBytes, uint32_t *aWriteBytes,
+                    uint32_t *aSyncs)
+{
+  MOZ_ASSERT(aReadBytes);
+  MOZ_ASSERT(aWriteBytes);
+  MOZ_ASSERT(aSyncs);
+
+  if (!sThreadIOCountersInitialized) {
+    *aReadBytes = *aWriteBytes = *aSyncs = 0;
+    return;
+  }
+  *aReadBytes = sThreadReadBytes.get();
+  *aWriteBytes = sThreadWriteBytes.get();
+  *aSyncs = sThreadSyncs.get();
+}
+
 } // namespace storage
 } // namespace mozilla
@@ -4,12 +4,15 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include "mozilla/ArrayUtils.h"
 #include "mozilla/DebugOnly.h"
 
 #include "VacuumManager.h"
 
 #include "mozilla/Services.h"
 #include "mozilla/Preferences.h"
+#include "mozilla/Telemetry.h"
+#include "mozilla/TimeStamp.h"
 #include "nsIObserverService.h"
 #include "nsIFile.h"
 #include "nsThreadUtils.h"
@@ -21,9 +24,14 @@
 #include "mozIStorageAsyncStatement.h"
 #include "mozIStoragePendingStatement.h"
 #include "mozIStorageError.h"
+#include "mozIStorageResultSet.h"
+#include "mozIStorageRow.h"
 #include "mozStorageHelper.h"
+#include "nsIVariant.h"
 #include "nsXULAppAPI.h"
 
+#include <algorithm>
+
 #define OBSERVER_TOPIC_IDLE_DAILY "idle-daily"
 #define OBSERVER_TOPIC_XPCOM_SHUTDOWN "xpcom-shutdown"
 
@@ -39,6 +47,17 @@
 // Time between subsequent vacuum calls for a certain database.
 #define VACUUM_INTERVAL_SECONDS 30 * 86400 // 30 days.
 
+// This preferences root will contain, for each database using incremental
+// vacuum, whether it has already been switched to incremental auto_vacuum.
+// The database filename is used as a key.
+#define PREF_VACUUM_INCREMENTAL_BRANCH "storage.vacuum.incremental."
+
+// Maximum time spent releasing free pages of a database on each idle-daily.
+#define INCREMENTAL_VACUUM_BUDGET_MS 2000
+
+// Amount of free pages released by each slice of an incremental vacuum.
+#define INCREMENTAL_VACUUM_SLICE_BYTES 1048576 // 1 MiB
+
 extern mozilla::LazyLogModule gStorageLog;
 
 namespace mozilla {
@@ -109,13 +128,55 @@ public:
 
   explicit Vacuumer(mozIStorageVacuumParticipant *aParticipant);
 
+  /**
+   * Starts vacuuming the database, if it needs it.
+   *
+   * @return true if a full vacuum was started.  Incremental vacuums are cheap
+   *         enough that they don't count.
+   */
   bool execute();
   nsresult notifyCompletion(bool aSucceeded);
 
 private:
+  /**
+   * Reads the state of the free list of a database that was switched to
+   * incremental auto_vacuum, to decide whether to release free pages.
+   */
+  bool executeIncremental();
+
+  /**
+   * Releases the next slice of free pages.
+   */
+  nsresult executeSlice();
+
+  void incrementalProbeCompleted();
+  void sliceCompleted(bool aSucceeded);
+
+  nsCString incrementalPrefName();
+
+  enum Phase {
+    // A full VACUUM.
+    FULL,
+    // Reading the state of the free list.
+    INCREMENTAL_PROBE,
+    // Releasing free pages with PRAGMA incremental_vacuum.
+    INCREMENTAL_SLICE
+  };
+
   nsCOMPtr<mozIStorageVacuumParticipant> mParticipant;
   nsCString mDBFilename;
   nsCOMPtr<mozIStorageConnection> mDBConn;
+  Phase mPhase;
+  // Whether the participant wants incremental vacuums.
+  bool mIncremental;
+  int32_t mIncrementalThreshold;
+  // State of the database, as read by the last INCREMENTAL_PROBE or
+  // INCREMENTAL_SLICE.
+  int32_t mAutoVacuum;
+  int32_t mPageSize;
+  int64_t mFreePages;
+  int64_t mInitialFreePages;
+  TimeStamp mSlicesStart;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -123,9 +184,25 @@ private:
 
 Vacuumer::Vacuumer(mozIStorageVacuumParticipant *aParticipant)
   : mParticipant(aParticipant)
+  , mPhase(FULL)
+  , mIncremental(false)
+  , mIncrementalThreshold(0)
+  , mAutoVacuum(0)
+  , mPageSize(0)
+  , mFreePages(0)
+  , mInitialFreePages(0)
 {
 }
 
+nsCString
+Vacuumer::incrementalPrefName()
+{
+  MOZ_ASSERT(!mDBFilename.IsEmpty(), "Database filename cannot be empty");
+  nsAutoCString prefName(PREF_VACUUM_INCREMENTAL_BRANCH);
+  prefName += mDBFilename;
+  return prefName;
+}
+
 bool
 Vacuumer::execute()
 {
@@ -165,6 +242,24 @@ Vacuumer::execute()
   mDBFilename = NS_ConvertUTF16toUTF8(databaseFilename);
   MOZ_ASSERT(!mDBFilename.IsEmpty(), "Database filename cannot be empty");
 
+  // Participants implemented before incremental vacuums existed may not
+  // implement these.
+  if (NS_FAILED(mParticipant->GetUseIncrementalVacuum(&mIncremental))) {
+    mIncremental = false;
+  }
+  if (mIncremental &&
+      NS_FAILED(mParticipant->GetIncrementalVacuumThreshold(
+                  &mIncrementalThreshold))) {
+    mIncrementalThreshold = 0;
+  }
+
+  // Once the database is using incremental auto_vacuum, just release its
+  // free pages.
+  if (mIncremental && Preferences::GetBool(incrementalPrefName().get())) {
+    (void)executeIncremental();
+    return false;
+  }
+
   // Check interval from last vacuum.
   int32_t now = static_cast<int32_t>(PR_Now() / PR_USEC_PER_SEC);
   int32_t lastVacuum;
@@ -209,17 +304,157 @@ Vacuumer::execute()
   rv = pageSizeStmt->ExecuteAsync(callback, getter_AddRefs(ps));
   NS_ENSURE_SUCCESS(rv, false);
 
+  // Changing auto_vacuum only takes effect through a VACUUM.
+  if (mIncremental) {
+    nsCOMPtr<mozIStorageAsyncStatement> autoVacuumStmt;
+    rv = mDBConn->CreateAsyncStatement(NS_LITERAL_CSTRING(
+      MOZ_STORAGE_UNIQUIFY_QUERY_STR "PRAGMA auto_vacuum = INCREMENTAL"
+    ), getter_AddRefs(autoVacuumStmt));
+    NS_ENSURE_SUCCESS(rv, false);
+    rv = autoVacuumStmt->ExecuteAsync(callback, getter_AddRefs(ps));
+    NS_ENSURE_SUCCESS(rv, false);
+  }
+
   nsCOMPtr<mozIStorageAsyncStatement> stmt;
   rv = mDBConn->CreateAsyncStatement(NS_LITERAL_CSTRING(
     "VACUUM"
   ), getter_AddRefs(stmt));
   NS_ENSURE_SUCCESS(rv, false);
+  mPhase = FULL;
   rv = stmt->ExecuteAsync(this, getter_AddRefs(ps));
   NS_ENSURE_SUCCESS(rv, false);
 
   return true;
 }
 
+bool
+Vacuumer::executeIncremental()
+{
+  MOZ_ASSERT(NS_IsMainThread(), "Must be running on the main thread!");
+
+  nsCOMPtr<mozIStorageAsyncStatement> autoVacuumStmt;
+  nsresult rv = mDBConn->CreateAsyncStatement(NS_LITERAL_CSTRING(
+    MOZ_STORAGE_UNIQUIFY_QUERY_STR "PRAGMA auto_vacuum"
+  ), getter_AddRefs(autoVacuumStmt));
+  NS_ENSURE_SUCCESS(rv, false);
+  nsCOMPtr<mozIStorageAsyncStatement> pageSizeStmt;
+  rv = mDBConn->CreateAsyncStatement(NS_LITERAL_CSTRING(
+    MOZ_STORAGE_UNIQUIFY_QUERY_STR "PRAGMA page_size"
+  ), getter_AddRefs(pageSizeStmt));
+  NS_ENSURE_SUCCESS(rv, false);
+  nsCOMPtr<mozIStorageAsyncStatement> freelistStmt;
+  rv = mDBConn->CreateAsyncStatement(NS_LITERAL_CSTRING(
+    MOZ_STORAGE_UNIQUIFY_QUERY_STR "PRAGMA freelist_count"
+  ), getter_AddRefs(freelistStmt));
+  NS_ENSURE_SUCCESS(rv, false);
+
+  mozIStorageBaseStatement *stmts[] = {
+    autoVacuumStmt,
+    pageSizeStmt,
+    freelistStmt
+  };
+  mPhase = INCREMENTAL_PROBE;
+  nsCOMPtr<mozIStoragePendingStatement> ps;
+  rv = mDBConn->ExecuteAsync(stmts, ArrayLength(stmts), this,
+                             getter_AddRefs(ps));
+  NS_ENSURE_SUCCESS(rv, false);
+
+  return true;
+}
+
+nsresult
+Vacuumer::executeSlice()
+{
+  MOZ_ASSERT(mPageSize > 0);
+
+  nsAutoCString sliceQuery(MOZ_STORAGE_UNIQUIFY_QUERY_STR
+                           "PRAGMA incremental_vacuum(");
+  sliceQuery.AppendInt(std::max(INCREMENTAL_VACUUM_SLICE_BYTES / mPageSize, 1));
+  sliceQuery.Append(')');
+  nsCOMPtr<mozIStorageAsyncStatement> sliceStmt;
+  nsresult rv = mDBConn->CreateAsyncStatement(sliceQuery,
+                                              getter_AddRefs(sliceStmt));
+  NS_ENSURE_SUCCESS(rv, rv);
+  nsCOMPtr<mozIStorageAsyncStatement> freelistStmt;
+  rv = mDBConn->CreateAsyncStatement(NS_LITERAL_CSTRING(
+    MOZ_STORAGE_UNIQUIFY_QUERY_STR "PRAGMA freelist_count"
+  ), getter_AddRefs(freelistStmt));
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  mozIStorageBaseStatement *stmts[] = {
+    sliceStmt,
+    freelistStmt
+  };
+  mPhase = INCREMENTAL_SLICE;
+  nsCOMPtr<mozIStoragePendingStatement> ps;
+  rv = mDBConn->ExecuteAsync(stmts, ArrayLength(stmts), this,
+                             getter_AddRefs(ps));
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  return NS_OK;
+}
+
+void
+Vacuumer::incrementalProbeCompleted()
+{
+  if (mAutoVacuum != 2 /* INCREMENTAL */) {
+    // The database was replaced or its auto_vacuum was changed, so it has to
+    // be switched again by the next full vacuum.
+    (void)Preferences::ClearUser(incrementalPrefName().get());
+    return;
+  }
+
+  if (mPageSize <= 0 || mFreePages == 0 ||
+      mFreePages * mPageSize <= mIncrementalThreshold) {
+    return;
+  }
+
+  bool vacuumGranted = false;
+  nsresult rv = mParticipant->OnBeginVacuum(&vacuumGranted);
+  if (NS_FAILED(rv) || !vacuumGranted) {
+    return;
+  }
+
+  nsCOMPtr<nsIObserverService> os = mozilla::services::GetObserverService();
+  if (os) {
+    rv = os->NotifyObservers(nullptr, OBSERVER_TOPIC_HEAVY_IO,
+                             OBSERVER_DATA_VACUUM_BEGIN.get());
+    MOZ_ASSERT(NS_SUCCEEDED(rv), "Should be able to notify");
+  }
+
+  mInitialFreePages = mFreePages;
+  mSlicesStart = TimeStamp::Now();
+  rv = executeSlice();
+  if (NS_FAILED(rv)) {
+    sliceCompleted(false);
+  }
+}
+
+void
+Vacuumer::sliceCompleted(bool aSucceeded)
+{
+  TimeDuration elapsed = TimeStamp::Now() - mSlicesStart;
+  if (aSucceeded && mFreePages > 0 &&
+      elapsed.ToMilliseconds() < INCREMENTAL_VACUUM_BUDGET_MS &&
+      NS_SUCCEEDED(executeSlice())) {
+    return;
+  }
+
+  // Whatever was released so far stays released, so an interrupted
+  // incremental vacuum just continues on the next idle-daily.
+  int64_t reclaimedBytes =
+    std::max<int64_t>(mInitialFreePages - mFreePages, 0) * mPageSize;
+  Telemetry::Accumulate(Telemetry::MOZ_STORAGE_VACUUM_RECLAIMED_KB, mDBFilename,
+                        static_cast<uint32_t>(reclaimedBytes / 1024));
+  MOZ_LOG(gStorageLog, LogLevel::Debug,
+          ("Incremental vacuum of '%s' released %lld bytes in %.0fms, %lld "
+           "free pages left", mDBFilename.get(),
+           static_cast<long long>(reclaimedBytes), elapsed.ToMilliseconds(),
+           static_cast<long long>(mFreePages)));
+
+  notifyCompletion(aSucceeded);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //// mozIStorageStatementCallback
 
@@ -261,13 +496,45 @@ Vacuumer::HandleError(mozIStorageError *aError)
 NS_IMETHODIMP
 Vacuumer::HandleResult(mozIStorageResultSet *aResultSet)
 {
-  NS_NOTREACHED("Got a resultset from a vacuum?");
+  if (mPhase == FULL) {
+    NS_NOTREACHED("Got a resultset from a vacuum?");
+    return NS_OK;
+  }
+
+  // Each of the pragmas read by incremental vacuums returns a single value in
+  // a column named after it.
+  nsCOMPtr<mozIStorageRow> row;
+  while (NS_SUCCEEDED(aResultSet->GetNextRow(getter_AddRefs(row))) && row) {
+    nsCOMPtr<nsIVariant> value;
+    if (NS_SUCCEEDED(row->GetResultByName(NS_LITERAL_CSTRING("freelist_count"),
+                                          getter_AddRefs(value)))) {
+      (void)value->GetAsInt64(&mFreePages);
+    } else if (NS_SUCCEEDED(row->GetResultByName(
+                 NS_LITERAL_CSTRING("auto_vacuum"), getter_AddRefs(value)))) {
+      (void)value->GetAsInt32(&mAutoVacuum);
+    } else if (NS_SUCCEEDED(row->GetResultByName(
+                 NS_LITERAL_CSTRING("page_size"), getter_AddRefs(value)))) {
+      (void)value->GetAsInt32(&mPageSize);
+    }
+  }
   return NS_OK;
 }
 
 NS_IMETHODIMP
 Vacuumer::HandleCompletion(uint16_t aReason)
 {
+  if (mPhase == INCREMENTAL_PROBE) {
+    if (aReason == REASON_FINISHED) {
+      incrementalProbeCompleted();
+    }
+    return NS_OK;
+  }
+
+  if (mPhase == INCREMENTAL_SLICE) {
+    sliceCompleted(aReason == REASON_FINISHED);
+    return NS_OK;
+  }
+
   if (aReason == REASON_FINISHED) {
     // Update last vacuum time.
     int32_t now = static_cast<int32_t>(PR_Now() / PR_USEC_PER_SEC);
@@ -276,6 +543,12 @@ Vacuumer::HandleCompletion(uint16_t aReason)
     prefName += mDBFilename;
     DebugOnly<nsresult> rv = Preferences::SetInt(prefName.get(), now);
     MOZ_ASSERT(NS_SUCCEEDED(rv), "Should be able to set a preference"); 
+
+    // The vacuum switched the database to incremental auto_vacuum.
+    if (mIncremental) {
+      rv = Preferences::SetBool(incrementalPrefName().get(), true);
+      MOZ_ASSERT(NS_SUCCEEDED(rv), "Should be able to set a preference");
+    }
   }
 
   notifyCompletion(aReason == REASON_FINISHED);
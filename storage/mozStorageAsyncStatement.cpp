@@ -265,8 +265,9 @@ AsyncStatement::getAsyncStatement(sqlite3_stmt **_stmt)
 #endif
 
   if (!mAsyncStatement) {
-    int rc = mDBConnection->prepareStatement(mNativeConnection, mSQLString,
-                                             &mAsyncStatement);
+    int rc = mDBConnection->prepareCachedStatement(mNativeConnection,
+                                                   mSQLString,
+                                                   &mAsyncStatement);
     if (rc != SQLITE_OK) {
       MOZ_LOG(gStorageLog, LogLevel::Error,
              ("Sqlite statement prepare error: %d '%s'", rc,
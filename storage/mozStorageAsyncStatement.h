@@ -62,6 +62,11 @@ public:
     return mParamsArray.forget();
   }
 
+  /**
+   * The SQL string this statement was created with.
+   */
+  const nsCString &getSQLString() const { return mSQLString; }
+
 
 private:
   ~AsyncStatement();
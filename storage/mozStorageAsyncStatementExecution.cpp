@@ -4,6 +4,8 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
+
 #include "nsAutoPtr.h"
 
 #include "sqlite3.h"
@@ -39,6 +41,18 @@ namespace storage {
 #define MAX_MILLISECONDS_BETWEEN_RESULTS 75
 #define MAX_ROWS_PER_RESULT 15
 
+/**
+ * MAX_ROWS_PER_RESULT is only the initial batch size.  While the callback
+ * handles a result set in less than FAST_RESULT_HANDLING_MILLISECONDS the batch
+ * size doubles, up to MAX_ROWS_PER_RESULT_LIMIT, so large queries post far
+ * fewer events to the calling thread.  It halves again when handling a result
+ * set takes longer than SLOW_RESULT_HANDLING_MILLISECONDS, which would start
+ * to cause noticeable jank.
+ */
+#define MAX_ROWS_PER_RESULT_LIMIT 1920
+#define FAST_RESULT_HANDLING_MILLISECONDS 4
+#define SLOW_RESULT_HANDLING_MILLISECONDS 16
+
 ////////////////////////////////////////////////////////////////////////////////
 //// Local Classes
 
@@ -72,7 +86,9 @@ public:
       // from under us.
       nsCOMPtr<mozIStorageStatementCallback> callback = mCallback;
 
+      TimeStamp start = TimeStamp::Now();
       (void)callback->HandleResult(mResults);
+      mEventStatus->resultsHandled(TimeStamp::Now() - start);
     }
 
     return NS_OK;
@@ -185,8 +201,12 @@ AsyncExecuteStatements::execute(StatementDataArray &aStatements,
     return NS_ERROR_NOT_AVAILABLE;
   }
 
+  aConnection->asyncExecutionStarted();
   nsresult rv = target->Dispatch(event, NS_DISPATCH_NORMAL);
-  NS_ENSURE_SUCCESS(rv, rv);
+  if (NS_FAILED(rv)) {
+    aConnection->asyncExecutionFinished();
+    return rv;
+  }
 
   // Return it as the pending statement object and track it.
   event.forget(_stmt);
@@ -204,6 +224,8 @@ AsyncExecuteStatements::AsyncExecuteStatements(StatementDataArray &aStatements,
 , mCallingThread(::do_GetCurrentThread())
 , mMaxWait(TimeDuration::FromMilliseconds(MAX_MILLISECONDS_BETWEEN_RESULTS))
 , mIntervalStart(TimeStamp::Now())
+, mMaxRowsPerResult(MAX_ROWS_PER_RESULT)
+, mResultHandlingHint(0)
 , mState(PENDING)
 , mCancelRequested(false)
 , mMutex(aConnection->sharedAsyncExecutionMutex)
@@ -285,6 +307,9 @@ AsyncExecuteStatements::executeAndProcessStatement(sqlite3_stmt *aStatement,
 {
   mMutex.AssertNotCurrentThreadOwns();
 
+  // Rows of the previous statement have other columns.
+  mColumnNames = nullptr;
+
   // Execute our statement
   bool hasResults;
   do {
@@ -387,6 +412,17 @@ AsyncExecuteStatements::executeStatement(sqlite3_stmt *aStatement)
   }
 }
 
+void
+AsyncExecuteStatements::resultsHandled(const TimeDuration &aDuration)
+{
+  // A single slow result set outweighs any number of fast ones.
+  if (aDuration.ToMilliseconds() > SLOW_RESULT_HANDLING_MILLISECONDS) {
+    mResultHandlingHint = -1;
+  } else if (aDuration.ToMilliseconds() < FAST_RESULT_HANDLING_MILLISECONDS) {
+    mResultHandlingHint.compareExchange(0, 1);
+  }
+}
+
 nsresult
 AsyncExecuteStatements::buildAndNotifyResults(sqlite3_stmt *aStatement)
 {
@@ -395,13 +431,16 @@ AsyncExecuteStatements::buildAndNotifyResults(sqlite3_stmt *aStatement)
 
   // Build result object if we need it.
   if (!mResultSet)
-    mResultSet = new ResultSet();
+    mResultSet = new ResultSet(mMaxRowsPerResult);
   NS_ENSURE_TRUE(mResultSet, NS_ERROR_OUT_OF_MEMORY);
 
   RefPtr<Row> row(new Row());
   NS_ENSURE_TRUE(row, NS_ERROR_OUT_OF_MEMORY);
 
-  nsresult rv = row->initialize(aStatement);
+  if (!mColumnNames)
+    mColumnNames = new RowColumnNames(aStatement);
+
+  nsresult rv = row->initialize(aStatement, mColumnNames);
   NS_ENSURE_SUCCESS(rv, rv);
 
   rv = mResultSet->add(row);
@@ -412,7 +451,17 @@ AsyncExecuteStatements::buildAndNotifyResults(sqlite3_stmt *aStatement)
   // calling thread about it.
   TimeStamp now = TimeStamp::Now();
   TimeDuration delta = now - mIntervalStart;
-  if (mResultSet->rows() >= MAX_ROWS_PER_RESULT || delta > mMaxWait) {
+  if (uint32_t(mResultSet->rows()) >= mMaxRowsPerResult || delta > mMaxWait) {
+    // Follow how fast the callback handled the previous result sets.
+    int32_t hint = mResultHandlingHint.exchange(0);
+    if (hint > 0) {
+      mMaxRowsPerResult = std::min<uint32_t>(mMaxRowsPerResult * 2,
+                                             MAX_ROWS_PER_RESULT_LIMIT);
+    } else if (hint < 0) {
+      mMaxRowsPerResult = std::max<uint32_t>(mMaxRowsPerResult / 2,
+                                             MAX_ROWS_PER_RESULT);
+    }
+
     // Notify the caller
     rv = notifyResults();
     if (NS_FAILED(rv))
@@ -462,6 +511,8 @@ AsyncExecuteStatements::notifyComplete()
     mHasTransaction = false;
   }
 
+  mConnection->asyncExecutionFinished();
+
   // Always generate a completion notification; it is what guarantees that our
   // destruction does not happen here on the async thread.
   RefPtr<CompletionNotifier> completionEvent =
@@ -10,6 +10,7 @@
 #include "nscore.h"
 #include "nsTArray.h"
 #include "nsAutoPtr.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/Mutex.h"
 #include "mozilla/TimeStamp.h"
 #include "mozilla/Attributes.h"
@@ -27,6 +28,7 @@ namespace storage {
 
 class Connection;
 class ResultSet;
+class RowColumnNames;
 class StatementData;
 
 class AsyncExecuteStatements final : public nsIRunnable
@@ -82,6 +84,16 @@ public:
    */
   bool shouldNotify();
 
+  /**
+   * Called on the calling thread once the callback has handled a result set,
+   * so that the size of the following ones can follow how fast the caller
+   * consumes them.
+   *
+   * @param aDuration
+   *        How long the callback took to handle the result set.
+   */
+  void resultsHandled(const TimeDuration &aDuration);
+
 private:
   AsyncExecuteStatements(StatementDataArray &aStatements,
                          Connection *aConnection,
@@ -201,6 +213,26 @@ private:
    */
   TimeStamp mIntervalStart;
 
+  /**
+   * The number of rows we batch into a result set.  Starts at
+   * MAX_ROWS_PER_RESULT, grows while the callback handles result sets quickly
+   * and shrinks back when it does not.  Only used on the background thread.
+   */
+  uint32_t mMaxRowsPerResult;
+
+  /**
+   * Positive when the callback handled the result sets notified since the
+   * last batch quickly, negative when it was slow.  Written on the calling
+   * thread and consumed on the background thread.
+   */
+  Atomic<int32_t> mResultHandlingHint;
+
+  /**
+   * The column names of the statement being executed, shared by all the rows
+   * built from it.  Only used on the background thread.
+   */
+  RefPtr<RowColumnNames> mColumnNames;
+
   /**
    * Indicates our state of execution.
    */
@@ -13,6 +13,7 @@
 #include "nsThreadUtils.h"
 #include "nsIFile.h"
 #include "nsIFileURL.h"
+#include "nsPrintfCString.h"
 #include "mozilla/Telemetry.h"
 #include "mozilla/Mutex.h"
 #include "mozilla/CondVar.h"
@@ -72,6 +73,11 @@ namespace storage {
 
 using mozilla::dom::quota::QuotaObject;
 
+// Implemented in TelemetryVFS.cpp
+void
+GetThreadIOCounters(uint32_t *aReadBytes, uint32_t *aWriteBytes,
+                    uint32_t *aSyncs);
+
 namespace {
 
 int
@@ -339,6 +345,89 @@ WaitForUnlockNotify(sqlite3* aDatabase)
   return srv;
 }
 
+/**
+ * What a statement did up to some point of its execution: the IO performed by
+ * the thread running it and the plan counters of the statement.
+ */
+struct StatementCounters
+{
+  explicit StatementCounters(sqlite3_stmt *aStatement)
+  {
+    GetThreadIOCounters(&readBytes, &writeBytes, &syncs);
+    fullScanSteps = aStatement ?
+      ::sqlite3_stmt_status(aStatement, SQLITE_STMTSTATUS_FULLSCAN_STEP, 0) : 0;
+    sorts = aStatement ?
+      ::sqlite3_stmt_status(aStatement, SQLITE_STMTSTATUS_SORT, 0) : 0;
+    autoIndexes = aStatement ?
+      ::sqlite3_stmt_status(aStatement, SQLITE_STMTSTATUS_AUTOINDEX, 0) : 0;
+  }
+
+  uint32_t readBytes;
+  uint32_t writeBytes;
+  uint32_t syncs;
+  int fullScanSteps;
+  int sorts;
+  int autoIndexes;
+};
+
+/**
+ * Reports a statement that ran longer than the slow SQL threshold of the
+ * current thread to Telemetry, along with the IO it performed.  When the
+ * profiler is running, it also adds a marker with the SQL, the IO and a
+ * summary of the plan: how many full scan steps, sorts and automatic indexes
+ * the statement needed.
+ *
+ * @param aSQL
+ *        The SQL of the statement.
+ * @param aStatement
+ *        The statement, or null if aSQL was run through sqlite3_exec.
+ * @param aFilename
+ *        The filename reported to Telemetry for the connection.
+ * @param aStartTime
+ *        When the statement started executing.
+ * @param aStartCounters
+ *        The counters when the statement started executing.
+ */
+void
+MaybeReportSlowStatement(const char *aSQL,
+                         sqlite3_stmt *aStatement,
+                         const nsCString &aFilename,
+                         const TimeStamp &aStartTime,
+                         const StatementCounters &aStartCounters)
+{
+  TimeDuration duration = TimeStamp::Now() - aStartTime;
+  const uint32_t threshold =
+    NS_IsMainThread() ? Telemetry::kSlowSQLThresholdForMainThread
+                      : Telemetry::kSlowSQLThresholdForHelperThreads;
+  if (duration.ToMilliseconds() < threshold) {
+    return;
+  }
+
+  nsDependentCString statementString(aSQL);
+  Telemetry::RecordSlowSQLStatement(statementString, aFilename,
+                                    duration.ToMilliseconds());
+
+  StatementCounters counters(aStatement);
+  uint32_t readBytes = counters.readBytes - aStartCounters.readBytes;
+  uint32_t writeBytes = counters.writeBytes - aStartCounters.writeBytes;
+  Telemetry::Accumulate(Telemetry::MOZ_STORAGE_SLOW_STATEMENT_READ_KB,
+                        readBytes / 1024);
+  Telemetry::Accumulate(Telemetry::MOZ_STORAGE_SLOW_STATEMENT_WRITE_KB,
+                        writeBytes / 1024);
+
+  if (profiler_is_active()) {
+    nsPrintfCString marker(
+      "Slow SQL on %s: %.0fms, read %u B, wrote %u B, %u syncs, "
+      "%d full scan steps, %d sorts, %d automatic indexes: %s",
+      aFilename.get(), duration.ToMilliseconds(), readBytes, writeBytes,
+      counters.syncs - aStartCounters.syncs,
+      counters.fullScanSteps - aStartCounters.fullScanSteps,
+      counters.sorts - aStartCounters.sorts,
+      counters.autoIndexes - aStartCounters.autoIndexes, aSQL);
+    PROFILER_MARKER(marker.get());
+  }
+}
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -465,6 +554,87 @@ private:
   nsCOMPtr<mozIStorageCompletionCallback> mCallback;
 };
 
+/**
+ * An event used to initialize a reader of the reader pool of a connection.
+ *
+ * Must be executed on the reader's async execution thread.
+ */
+class AsyncInitializeReader final: public Runnable
+{
+public:
+  AsyncInitializeReader(Connection* aConnection,
+                        Connection* aReader)
+    : mConnection(aConnection)
+    , mReader(aReader)
+  {
+    MOZ_ASSERT(NS_IsMainThread());
+  }
+
+  NS_IMETHOD Run() override {
+    MOZ_ASSERT (NS_GetCurrentThread() == mReader->getAsyncExecutionTarget());
+
+    nsresult rv = mConnection->initializeClone(mReader, true);
+    bool usable = NS_SUCCEEDED(rv) && usesWAL();
+
+    nsCOMPtr<nsIRunnable> event =
+      NewRunnableMethod<RefPtr<Connection>, bool>(
+        mConnection, &Connection::readerInitialized, mReader, usable);
+    return NS_DispatchToMainThread(event);
+  }
+
+private:
+  // Readers of a database in another journal mode would lock writers out.
+  bool usesWAL() {
+    nsCOMPtr<mozIStorageStatement> stmt;
+    nsresult rv = mReader->CreateStatement(
+      NS_LITERAL_CSTRING("PRAGMA journal_mode"), getter_AddRefs(stmt));
+    bool hasResult = false;
+    if (NS_FAILED(rv) || NS_FAILED(stmt->ExecuteStep(&hasResult)) ||
+        !hasResult) {
+      return false;
+    }
+    nsAutoCString journalMode;
+    rv = stmt->GetUTF8String(0, journalMode);
+    return NS_SUCCEEDED(rv) && journalMode.EqualsLiteral("wal");
+  }
+
+  ~AsyncInitializeReader() {
+    nsCOMPtr<nsIThread> thread;
+    DebugOnly<nsresult> rv = NS_GetMainThread(getter_AddRefs(thread));
+    MOZ_ASSERT(NS_SUCCEEDED(rv));
+
+    // Handle ambiguous nsISupports inheritance.
+    NS_ProxyRelease(thread, mConnection.forget());
+    NS_ProxyRelease(thread, mReader.forget());
+  }
+
+  RefPtr<Connection> mConnection;
+  RefPtr<Connection> mReader;
+};
+
+/**
+ * Whether aSQL is a SELECT statement, which can run on a read-only
+ * connection.
+ */
+bool
+isSelectStatement(const nsCString &aSQL)
+{
+  const char *start = aSQL.BeginReading();
+  const char *end = aSQL.EndReading();
+  while (start < end && (*start == ' ' || *start == '\t' ||
+                         *start == '\n' || *start == '\r')) {
+    ++start;
+  }
+  return StringBeginsWith(Substring(start, end), NS_LITERAL_CSTRING("SELECT"),
+                          nsCaseInsensitiveCStringComparator());
+}
+
+// The number of distinct statements each reader keeps prepared.
+const uint32_t kMaxReaderStatements = 64;
+
+// The number of idle prepared statements a connection keeps for reuse.
+const uint32_t kMaxCachedStatements = 32;
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -489,6 +659,12 @@ Connection::Connection(Service *aService,
 , mIgnoreLockingMode(aIgnoreLockingMode)
 , mStorageService(aService)
 , mAsyncOnly(aAsyncOnly)
+, mPendingAsyncExecutions(0)
+, mReaderPoolEnabled(false)
+, mStatementCacheMutex("Connection::mStatementCacheMutex")
+, mStatementCacheClosed(false)
+, mStatementCacheHits(0)
+, mStatementCacheMisses(0)
 {
   MOZ_ASSERT(!mIgnoreLockingMode || mFlags & SQLITE_OPEN_READONLY,
              "Can't ignore locking for a non-readonly connection!");
@@ -958,6 +1134,8 @@ Connection::internalClose(sqlite3 *aNativeConnection)
   if (!aNativeConnection)
     return NS_OK;
 
+  clearStatementCache();
+
   int srv = sqlite3_close(aNativeConnection);
 
   if (srv == SQLITE_BUSY) {
@@ -1029,6 +1207,7 @@ Connection::stepStatement(sqlite3 *aNativeConnection, sqlite3_stmt *aStatement)
   MOZ_ASSERT(aStatement);
   bool checkedMainThread = false;
   TimeStamp startTime = TimeStamp::Now();
+  StatementCounters startCounters(aStatement);
 
   // The connection may have been closed if the executing statement has been
   // created and cached after a call to asyncClose() but before the actual
@@ -1059,15 +1238,8 @@ Connection::stepStatement(sqlite3 *aNativeConnection, sqlite3_stmt *aStatement)
   }
 
   // Report very slow SQL statements to Telemetry
-  TimeDuration duration = TimeStamp::Now() - startTime;
-  const uint32_t threshold =
-    NS_IsMainThread() ? Telemetry::kSlowSQLThresholdForMainThread
-                      : Telemetry::kSlowSQLThresholdForHelperThreads;
-  if (duration.ToMilliseconds() >= threshold) {
-    nsDependentCString statementString(::sqlite3_sql(aStatement));
-    Telemetry::RecordSlowSQLStatement(statementString, mTelemetryFilename,
-                                      duration.ToMilliseconds());
-  }
+  MaybeReportSlowStatement(::sqlite3_sql(aStatement), aStatement,
+                           mTelemetryFilename, startTime, startCounters);
 
   (void)::sqlite3_extended_result_codes(aNativeConnection, 0);
   // Drop off the extended result bits of the result code.
@@ -1133,6 +1305,75 @@ Connection::prepareStatement(sqlite3 *aNativeConnection, const nsCString &aSQL,
   return rc;
 }
 
+int
+Connection::prepareCachedStatement(sqlite3 *aNativeConnection,
+                                   const nsCString &aSQL,
+                                   sqlite3_stmt **_stmt)
+{
+  if (aNativeConnection == mDBConn) {
+    MutexAutoLock lockedScope(mStatementCacheMutex);
+    for (size_t i = mCachedStatements.Length(); i > 0; --i) {
+      sqlite3_stmt *stmt = mCachedStatements[i - 1];
+      if (aSQL.Equals(::sqlite3_sql(stmt))) {
+        mCachedStatements.RemoveElementAt(i - 1);
+        ++mStatementCacheHits;
+        *_stmt = stmt;
+        return SQLITE_OK;
+      }
+    }
+    ++mStatementCacheMisses;
+  }
+
+  return prepareStatement(aNativeConnection, aSQL, _stmt);
+}
+
+int
+Connection::releaseCachedStatement(sqlite3_stmt *aStatement)
+{
+  sqlite3_stmt *evicted = aStatement;
+  if (::sqlite3_db_handle(aStatement) == mDBConn) {
+    // The statement is still ours alone, so reset it before taking the cache
+    // mutex; sqlite3_reset takes the SQLite connection mutex.
+    (void)::sqlite3_reset(aStatement);
+    (void)::sqlite3_clear_bindings(aStatement);
+
+    MutexAutoLock lockedScope(mStatementCacheMutex);
+    if (!mStatementCacheClosed) {
+      mCachedStatements.AppendElement(aStatement);
+      evicted = nullptr;
+      if (mCachedStatements.Length() > kMaxCachedStatements) {
+        evicted = mCachedStatements[0];
+        mCachedStatements.RemoveElementAt(0);
+      }
+    }
+  }
+
+  return evicted ? ::sqlite3_finalize(evicted) : SQLITE_OK;
+}
+
+void
+Connection::getStatementCacheCounts(uint64_t *aHits, uint64_t *aMisses)
+{
+  MutexAutoLock lockedScope(mStatementCacheMutex);
+  *aHits = mStatementCacheHits;
+  *aMisses = mStatementCacheMisses;
+}
+
+void
+Connection::clearStatementCache()
+{
+  nsTArray<sqlite3_stmt *> statements;
+  {
+    MutexAutoLock lockedScope(mStatementCacheMutex);
+    mStatementCacheClosed = true;
+    statements.SwapElements(mCachedStatements);
+  }
+
+  for (uint32_t i = 0; i < statements.Length(); ++i) {
+    (void)::sqlite3_finalize(statements[i]);
+  }
+}
+
 
 int
 Connection::executeSql(sqlite3 *aNativeConnection, const char *aSqlString)
@@ -1141,19 +1382,13 @@ Connection::executeSql(sqlite3 *aNativeConnection, const char *aSqlString)
     return SQLITE_MISUSE;
 
   TimeStamp startTime = TimeStamp::Now();
+  StatementCounters startCounters(nullptr);
   int srv = ::sqlite3_exec(aNativeConnection, aSqlString, nullptr, nullptr,
                            nullptr);
 
   // Report very slow SQL statements to Telemetry
-  TimeDuration duration = TimeStamp::Now() - startTime;
-  const uint32_t threshold =
-    NS_IsMainThread() ? Telemetry::kSlowSQLThresholdForMainThread
-                      : Telemetry::kSlowSQLThresholdForHelperThreads;
-  if (duration.ToMilliseconds() >= threshold) {
-    nsDependentCString statementString(aSqlString);
-    Telemetry::RecordSlowSQLStatement(statementString, mTelemetryFilename,
-                                      duration.ToMilliseconds());
-  }
+  MaybeReportSlowStatement(aSqlString, nullptr, mTelemetryFilename, startTime,
+                           startCounters);
 
   return srv;
 }
@@ -1183,6 +1418,8 @@ Connection::Close()
   if (!mDBConn)
     return NS_ERROR_NOT_INITIALIZED;
 
+  closeReaders();
+
   { // Make sure we have not executed any asynchronous statements.
     // If this fails, the mDBConn will be left open, resulting in a leak.
     // Ideally we'd schedule some code to destroy the mDBConn once all its
@@ -1254,6 +1491,8 @@ Connection::AsyncClose(mozIStorageCompletionCallback *aCallback)
   //   whereas we're still correct and safe without the special-case.
   nsIEventTarget *asyncThread = getAsyncExecutionTarget();
 
+  closeReaders();
+
   // Create our callback event if we were given a callback.  This will
   // eventually be dispatched in all cases, even if we fall back to Close() and
   // the database wasn't open and we return an error.  The rationale is that
@@ -1433,6 +1672,111 @@ Connection::initializeClone(Connection* aClone, bool aReadOnly)
   return NS_OK;
 }
 
+NS_IMETHODIMP
+Connection::EnableReaderPool(uint32_t aReaderCount)
+{
+  if (!NS_IsMainThread()) {
+    return NS_ERROR_NOT_SAME_THREAD;
+  }
+  if (!mDBConn)
+    return NS_ERROR_NOT_INITIALIZED;
+  if (!mDatabaseFile || (mFlags & SQLITE_OPEN_READONLY) || mReaderPoolEnabled)
+    return NS_ERROR_UNEXPECTED;
+
+  mReaderPoolEnabled = true;
+
+  // Turn off SQLITE_OPEN_READWRITE and SQLITE_OPEN_CREATE, and set
+  // SQLITE_OPEN_READONLY.
+  int flags = (~(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE) & mFlags) |
+              SQLITE_OPEN_READONLY;
+  for (uint32_t i = 0; i < aReaderCount; ++i) {
+    RefPtr<Connection> reader = new Connection(mStorageService, flags, true);
+    nsCOMPtr<nsIEventTarget> target = reader->getAsyncExecutionTarget();
+    if (!target) {
+      return NS_ERROR_UNEXPECTED;
+    }
+    RefPtr<AsyncInitializeReader> initEvent =
+      new AsyncInitializeReader(this, reader);
+    nsresult rv = target->Dispatch(initEvent, NS_DISPATCH_NORMAL);
+    NS_ENSURE_SUCCESS(rv, rv);
+  }
+  return NS_OK;
+}
+
+void
+Connection::readerInitialized(Connection *aReader, bool aUsable)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!aUsable || !connectionReady()) {
+    if (!aUsable) {
+      MOZ_LOG(gStorageLog, LogLevel::Debug,
+              ("Not using a reader pool for '%s'", getFilename().get()));
+    }
+    (void)aReader->AsyncClose(nullptr);
+    return;
+  }
+
+  UniquePtr<Reader> reader = MakeUnique<Reader>();
+  reader->connection = aReader;
+  mReaders.AppendElement(Move(reader));
+}
+
+already_AddRefed<AsyncStatement>
+Connection::readerStatementFor(AsyncStatement *aStatement)
+{
+  // Nothing is gained while this connection is idle, and running here keeps
+  // statements in the order they were executed in.
+  if (mReaders.IsEmpty() || !NS_IsMainThread() ||
+      mPendingAsyncExecutions == 0 ||
+      !isSelectStatement(aStatement->getSQLString())) {
+    return nullptr;
+  }
+
+  Reader *reader = mReaders[0].get();
+  for (uint32_t i = 1; i < mReaders.Length(); ++i) {
+    if (mReaders[i]->connection->mPendingAsyncExecutions <
+        reader->connection->mPendingAsyncExecutions) {
+      reader = mReaders[i].get();
+    }
+  }
+
+  const nsCString &sql = aStatement->getSQLString();
+  nsCOMPtr<mozIStorageAsyncStatement> stmt;
+  if (!reader->statements.Get(sql, getter_AddRefs(stmt))) {
+    nsresult rv = reader->connection->CreateAsyncStatement(sql,
+                                                           getter_AddRefs(stmt));
+    if (NS_FAILED(rv)) {
+      return nullptr;
+    }
+    if (reader->statements.Count() < kMaxReaderStatements) {
+      reader->statements.Put(sql, stmt);
+    }
+  }
+
+  RefPtr<AsyncStatement> readerStatement = static_cast<AsyncStatement *>(
+    stmt.get());
+  return readerStatement.forget();
+}
+
+void
+Connection::closeReaders()
+{
+  if (mReaders.IsEmpty()) {
+    return;
+  }
+  MOZ_ASSERT(NS_IsMainThread());
+
+  for (uint32_t i = 0; i < mReaders.Length(); ++i) {
+    Reader *reader = mReaders[i].get();
+    for (auto iter = reader->statements.Iter(); !iter.Done(); iter.Next()) {
+      (void)iter.Data()->Finalize();
+    }
+    (void)reader->connection->AsyncClose(nullptr);
+  }
+  mReaders.Clear();
+}
+
 NS_IMETHODIMP
 Connection::Clone(bool aReadOnly,
                   mozIStorageConnection **_connection)
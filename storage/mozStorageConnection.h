@@ -15,6 +15,9 @@
 #include "nsIInterfaceRequestor.h"
 
 #include "nsDataHashtable.h"
+#include "nsInterfaceHashtable.h"
+#include "mozilla/Atomics.h"
+#include "mozilla/UniquePtr.h"
 #include "mozIStorageProgressHandler.h"
 #include "SQLiteMutex.h"
 #include "mozIStorageConnection.h"
@@ -31,10 +34,13 @@ class nsIFile;
 class nsIFileURL;
 class nsIEventTarget;
 class nsIThread;
+class mozIStorageAsyncStatement;
 
 namespace mozilla {
 namespace storage {
 
+class AsyncStatement;
+
 class Connection final : public mozIStorageConnection
                        , public nsIInterfaceRequestor
 {
@@ -198,6 +204,30 @@ public:
   int prepareStatement(sqlite3* aNativeConnection,
                        const nsCString &aSQL, sqlite3_stmt **_stmt);
 
+  /**
+   * Like prepareStatement, but reuses an idle prepared statement for the same
+   * SQL string from the statement cache if there is one.  Statements obtained
+   * this way must be given back with releaseCachedStatement instead of being
+   * finalized.
+   */
+  int prepareCachedStatement(sqlite3* aNativeConnection,
+                             const nsCString &aSQL, sqlite3_stmt **_stmt);
+
+  /**
+   * Resets aStatement and keeps it in the statement cache for reuse, evicting
+   * the least recently released statement if the cache is full.  Finalizes
+   * aStatement instead once the connection is closing.
+   *
+   * @return the result from sqlite3_finalize, or SQLITE_OK.
+   */
+  int releaseCachedStatement(sqlite3_stmt* aStatement);
+
+  /**
+   * The number of prepareCachedStatement calls that reused a cached statement
+   * and that had to prepare a new one.
+   */
+  void getStatementCacheCounts(uint64_t *aHits, uint64_t *aMisses);
+
   /**
    * Performs a sqlite3_step on aStatement, while properly handling SQLITE_LOCKED
    * when not on the main thread by waiting until we are notified.
@@ -236,10 +266,37 @@ public:
 
   nsresult initializeClone(Connection *aClone, bool aReadOnly);
 
+  /**
+   * Called by AsyncExecuteStatements when an execution is dispatched to and
+   * finished on the async thread.  Used to tell busy connections apart.
+   */
+  void asyncExecutionStarted() { ++mPendingAsyncExecutions; }
+  void asyncExecutionFinished() { --mPendingAsyncExecutions; }
+
+  /**
+   * Returns the statement of a reader that aStatement should run on instead
+   * of this connection, or null if it should run here.
+   *
+   * @see mozIStorageAsyncConnection::enableReaderPool.
+   */
+  already_AddRefed<AsyncStatement> readerStatementFor(AsyncStatement *aStatement);
+
+  /**
+   * Adds a reader once it has been initialized, or drops it if that failed.
+   * Called on the main thread.
+   */
+  void readerInitialized(Connection *aReader, bool aUsable);
+
 private:
   ~Connection();
   nsresult initializeInternal();
 
+  /**
+   * Finalizes the statements in the statement cache and stops caching
+   * released statements.  Called right before the connection is closed.
+   */
+  void clearStatementCache();
+
   /**
    * Sets the database into a closed state so no further actions can be
    * performed.
@@ -286,6 +343,11 @@ private:
 
   bool findFunctionByInstance(nsISupports *aInstance);
 
+  /**
+   * Closes and drops the readers of the reader pool.
+   */
+  void closeReaders();
+
   static int sProgressHelper(void *aArg);
   // Generic progress handler
   // Dispatch call to registered progress handler,
@@ -379,6 +441,44 @@ private:
    * and it can be cast to |mozIStorageConnection|.
    */
   const bool mAsyncOnly;
+
+  /**
+   * Number of statement executions dispatched to the async thread that have
+   * not completed yet.
+   */
+  Atomic<uint32_t> mPendingAsyncExecutions;
+
+  /**
+   * A read-only clone of the reader pool and the statements prepared on it
+   * for SQL routed from this connection.
+   */
+  struct Reader
+  {
+    RefPtr<Connection> connection;
+    nsInterfaceHashtable<nsCStringHashKey, mozIStorageAsyncStatement> statements;
+  };
+
+  /**
+   * The readers that are ready for use, and whether enableReaderPool has been
+   * called.  Main thread only.
+   */
+  nsTArray<UniquePtr<Reader>> mReaders;
+  bool mReaderPoolEnabled;
+
+  /**
+   * Protects the statement cache, which statements can be released to from
+   * both the opener thread and the async thread.
+   */
+  Mutex mStatementCacheMutex;
+
+  /**
+   * Idle prepared statements, least recently released first.  Protected by
+   * mStatementCacheMutex, like the members that follow.
+   */
+  nsTArray<sqlite3_stmt *> mCachedStatements;
+  bool mStatementCacheClosed;
+  uint64_t mStatementCacheHits;
+  uint64_t mStatementCacheMisses;
 };
 
 
@@ -13,9 +13,10 @@ namespace storage {
 ////////////////////////////////////////////////////////////////////////////////
 //// ResultSet
 
-ResultSet::ResultSet()
+ResultSet::ResultSet(uint32_t aCapacity)
 : mCurrentIndex(0)
 {
+  mData.SetCapacity(aCapacity);
 }
 
 ResultSet::~ResultSet()
@@ -21,7 +21,11 @@ public:
   NS_DECL_THREADSAFE_ISUPPORTS
   NS_DECL_MOZISTORAGERESULTSET
 
-  ResultSet();
+  /**
+   * @param aCapacity
+   *        The number of rows this result set is expected to hold.
+   */
+  explicit ResultSet(uint32_t aCapacity);
 
   /**
    * Adds a tuple to this result set.
@@ -11,12 +11,35 @@
 #include "nsCOMArray.h"
 #include "nsDataHashtable.h"
 #include "mozilla/Attributes.h"
+#include "mozilla/RefPtr.h"
 class nsIVariant;
 struct sqlite3_stmt;
 
 namespace mozilla {
 namespace storage {
 
+/**
+ * Maps the column names of a statement to their indexes.  Built once per
+ * statement and shared by all of the rows that are read from it.
+ */
+class RowColumnNames final
+{
+public:
+  NS_INLINE_DECL_THREADSAFE_REFCOUNTING(RowColumnNames)
+
+  explicit RowColumnNames(sqlite3_stmt *aStatement);
+
+  bool get(const nsACString &aName, uint32_t *_index) const
+  {
+    return mNames.Get(aName, _index);
+  }
+
+private:
+  ~RowColumnNames() {}
+
+  nsDataHashtable<nsCStringHashKey, uint32_t> mNames;
+};
+
 class Row final : public mozIStorageRow
 {
 public:
@@ -32,8 +55,12 @@ public:
    *
    * @param aStatement
    *        The sqlite statement to pull results from.
+   * @param aColumnNames
+   *        The column names of aStatement, if the caller already has them.
+   *        They are looked up from aStatement otherwise.
    */
-  nsresult initialize(sqlite3_stmt *aStatement);
+  nsresult initialize(sqlite3_stmt *aStatement,
+                      RowColumnNames *aColumnNames = nullptr);
 
 private:
   ~Row() {}
@@ -51,7 +78,7 @@ private:
   /**
    * Maps a given name to a column index.
    */
-  nsDataHashtable<nsCStringHashKey, uint32_t> mNameHashtable;
+  RefPtr<RowColumnNames> mColumnNames;
 };
 
 } // namespace storage
@@ -164,6 +164,27 @@ Service::CollectReports(nsIHandleReportCallback *aHandleReport,
       ReportConn(aHandleReport, aData, conn, pathHead,
                  NS_LITERAL_CSTRING("schema"), schemaDesc,
                  SQLITE_DBSTATUS_SCHEMA_USED, &totalConnSize);
+
+      uint64_t hits, misses;
+      conn->getStatementCacheCounts(&hits, &misses);
+      nsCString countsHead("storage-statement-cache/");
+      countsHead.Append(conn->getFilename());
+      aHandleReport->Callback(EmptyCString(), countsHead + NS_LITERAL_CSTRING("/hits"),
+                              nsIMemoryReporter::KIND_OTHER,
+                              nsIMemoryReporter::UNITS_COUNT_CUMULATIVE,
+                              int64_t(hits),
+                              NS_LITERAL_CSTRING("Statements created on connections to "
+                                                 "this database that reused a cached "
+                                                 "prepared statement."),
+                              aData);
+      aHandleReport->Callback(EmptyCString(), countsHead + NS_LITERAL_CSTRING("/misses"),
+                              nsIMemoryReporter::KIND_OTHER,
+                              nsIMemoryReporter::UNITS_COUNT_CUMULATIVE,
+                              int64_t(misses),
+                              NS_LITERAL_CSTRING("Statements created on connections to "
+                                                 "this database that had to be "
+                                                 "prepared."),
+                              aData);
     }
 
 #ifdef MOZ_DMD
@@ -126,9 +126,9 @@ Statement::initialize(Connection *aDBConnection,
   MOZ_ASSERT(!mDBStatement, "Statement already initialized!");
   MOZ_ASSERT(aNativeConnection, "No native connection given!");
 
-  int srv = aDBConnection->prepareStatement(aNativeConnection,
-                                            PromiseFlatCString(aSQLStatement),
-                                            &mDBStatement);
+  int srv = aDBConnection->prepareCachedStatement(aNativeConnection,
+                                                  PromiseFlatCString(aSQLStatement),
+                                                  &mDBStatement);
   if (srv != SQLITE_OK) {
       MOZ_LOG(gStorageLog, LogLevel::Error,
              ("Sqlite statement prepare error: %d '%s'", srv,
@@ -270,8 +270,8 @@ Statement::getAsyncStatement(sqlite3_stmt **_stmt)
   // If we do not yet have a cached async statement, clone our statement now.
   if (!mAsyncStatement) {
     nsDependentCString sql(::sqlite3_sql(mDBStatement));
-    int rc = mDBConnection->prepareStatement(mNativeConnection, sql,
-                                             &mAsyncStatement);
+    int rc = mDBConnection->prepareCachedStatement(mNativeConnection, sql,
+                                                   &mAsyncStatement);
     if (rc != SQLITE_OK) {
       *_stmt = nullptr;
       return rc;
@@ -369,7 +369,7 @@ Statement::internalFinalize(bool aDestructing)
     //
     MOZ_LOG(gStorageLog, LogLevel::Debug, ("Finalizing statement '%s' during garbage-collection",
                                         ::sqlite3_sql(mDBStatement)));
-    srv = ::sqlite3_finalize(mDBStatement);
+    srv = mDBConnection->releaseCachedStatement(mDBStatement);
   }
 #ifdef DEBUG
   else {
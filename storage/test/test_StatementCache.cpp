@@ -143,6 +143,41 @@ test_FinalizeAsyncStatements()
   do_check_success(db->AsyncClose(nullptr));
 }
 
+/**
+ * Tests that a statement the connection reuses from its own cache of finalized
+ * statements starts out reset and without the previous bindings.
+ */
+void
+test_ConnectionReusesFinalizedStatements()
+{
+  nsCOMPtr<mozIStorageConnection> db(getMemoryDatabase());
+  NS_NAMED_LITERAL_CSTRING(sql, "SELECT :value");
+
+  for (int32_t i = 0; i < 3; i++) {
+    nsCOMPtr<mozIStorageStatement> stmt;
+    do_check_success(db->CreateStatement(sql, getter_AddRefs(stmt)));
+
+    // The value bound by the previous iteration is gone.
+    bool hasResult;
+    do_check_success(stmt->ExecuteStep(&hasResult));
+    do_check_true(hasResult);
+    bool isNull;
+    do_check_success(stmt->GetIsNull(0, &isNull));
+    do_check_true(isNull);
+    do_check_success(stmt->Reset());
+
+    // Leave the statement stepped with a binding when finalizing it.
+    do_check_success(stmt->BindInt32ByName(NS_LITERAL_CSTRING("value"), i));
+    do_check_success(stmt->ExecuteStep(&hasResult));
+    do_check_true(hasResult);
+    do_check_eq(i, stmt->AsInt32(0));
+    do_check_success(stmt->Finalize());
+  }
+
+  // The cached statements do not keep the connection from closing.
+  do_check_success(db->Close());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //// Test Harness Stuff
 
@@ -155,6 +190,7 @@ void (*gTests[])(void) = {
   test_GetCachedAsyncStatement<StringWrapper>,
   test_FinalizeAsyncStatements<const char []>,
   test_FinalizeAsyncStatements<StringWrapper>,
+  test_ConnectionReusesFinalizedStatements,
 };
 
 const char *file = __FILE__;
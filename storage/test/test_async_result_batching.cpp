@@ -0,0 +1,105 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: sw=2 ts=2 et lcs=trail\:.,tab\:>~ :
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "storage_test_harness.h"
+
+#include "mozIStorageResultSet.h"
+#include "mozIStorageRow.h"
+#include "nsIVariant.h"
+
+/**
+ * This file tests that large asynchronous queries are delivered completely
+ * and in order, with their column names, while the size of the result sets
+ * adapts to the callback.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+//// Helpers
+
+/**
+ * Checks that the rows it is notified about count up from 1, and records how
+ * many result sets they came in.
+ */
+class RowCounter : public AsyncStatementSpinner
+{
+public:
+  NS_DECL_ASYNCSTATEMENTSPINNER
+
+  RowCounter()
+  : rows(0)
+  , resultSets(0)
+  , inOrder(true)
+  {
+  }
+
+  int64_t rows;
+  uint32_t resultSets;
+  bool inOrder;
+};
+
+NS_IMETHODIMP
+RowCounter::HandleResult(mozIStorageResultSet *aResultSet)
+{
+  resultSets++;
+  nsCOMPtr<mozIStorageRow> row;
+  while (NS_SUCCEEDED(aResultSet->GetNextRow(getter_AddRefs(row))) && row) {
+    nsCOMPtr<nsIVariant> value;
+    int64_t byName = 0;
+    if (NS_FAILED(row->GetResultByName(NS_LITERAL_CSTRING("n"),
+                                       getter_AddRefs(value))) ||
+        NS_FAILED(value->GetAsInt64(&byName))) {
+      inOrder = false;
+    }
+    int64_t byIndex = 0;
+    (void)row->GetInt64(0, &byIndex);
+    if (byIndex != ++rows || byName != byIndex) {
+      inOrder = false;
+    }
+  }
+  return NS_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// Tests
+
+void
+test_LargeResultIsBatched()
+{
+  const int64_t kRows = 50000;
+
+  nsCOMPtr<mozIStorageConnection> db(getMemoryDatabase());
+
+  nsCOMPtr<mozIStorageAsyncStatement> stmt;
+  db->CreateAsyncStatement(NS_LITERAL_CSTRING(
+    "WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq "
+                              "WHERE n < :count) "
+    "SELECT n FROM seq"
+  ), getter_AddRefs(stmt));
+  stmt->BindInt64ByName(NS_LITERAL_CSTRING("count"), kRows);
+
+  RefPtr<RowCounter> counter(new RowCounter());
+  nsCOMPtr<mozIStoragePendingStatement> pending;
+  (void)stmt->ExecuteAsync(counter, getter_AddRefs(pending));
+  counter->SpinUntilCompleted();
+
+  do_check_true(counter->completionReason ==
+                mozIStorageStatementCallback::REASON_FINISHED);
+  do_check_true(counter->rows == kRows);
+  do_check_true(counter->inOrder);
+  do_check_true(counter->resultSets > 0);
+
+  stmt->Finalize();
+  blocking_async_close(db);
+}
+
+void (*gTests[])(void) = {
+  test_LargeResultIsBatched,
+};
+
+const char *file = __FILE__;
+#define TEST_NAME "async result batching"
+#define TEST_FILE file
+#include "storage_test_harness_tail.h"
@@ -0,0 +1,202 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: sw=2 ts=2 et lcs=trail\:.,tab\:>~ :
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "storage_test_harness.h"
+
+#include "mozIStorageResultSet.h"
+#include "mozIStorageRow.h"
+#include "prinrval.h"
+
+/**
+ * This file tests that asynchronous SELECT statements are run on the reader
+ * connections of a connection that has its reader pool enabled.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+//// Helpers
+
+/**
+ * Records the first column of the last row returned by a statement and
+ * whether it has completed.
+ */
+class ResultRecorder : public mozIStorageStatementCallback
+{
+public:
+  NS_DECL_ISUPPORTS
+  NS_DECL_MOZISTORAGESTATEMENTCALLBACK
+
+  ResultRecorder()
+  : completed(false)
+  , completionReason(0)
+  {
+  }
+
+  /**
+   * Spins the current thread until the statement completes or aTimeout
+   * elapses.
+   */
+  void SpinUntilCompleted(PRIntervalTime aTimeout)
+  {
+    nsCOMPtr<nsIThread> thread(::do_GetCurrentThread());
+    PRIntervalTime start = PR_IntervalNow();
+    while (!completed && PR_IntervalNow() - start < aTimeout) {
+      if (!NS_ProcessNextEvent(thread, false)) {
+        PR_Sleep(PR_MillisecondsToInterval(1));
+      }
+    }
+  }
+
+  nsCString name;
+  volatile bool completed;
+  uint16_t completionReason;
+
+private:
+  ~ResultRecorder() {}
+};
+
+NS_IMPL_ISUPPORTS(ResultRecorder, mozIStorageStatementCallback)
+
+NS_IMETHODIMP
+ResultRecorder::HandleResult(mozIStorageResultSet *aResultSet)
+{
+  nsCOMPtr<mozIStorageRow> row;
+  while (NS_SUCCEEDED(aResultSet->GetNextRow(getter_AddRefs(row))) && row) {
+    (void)row->GetUTF8String(0, name);
+  }
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+ResultRecorder::HandleError(mozIStorageError *aError)
+{
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+ResultRecorder::HandleCompletion(uint16_t aReason)
+{
+  completionReason = aReason;
+  completed = true;
+  return NS_OK;
+}
+
+/**
+ * Processes events on the current thread for aDuration, so that the reader
+ * connections get a chance to finish opening.
+ */
+void
+spin_for(PRIntervalTime aDuration)
+{
+  nsCOMPtr<nsIThread> thread(::do_GetCurrentThread());
+  PRIntervalTime start = PR_IntervalNow();
+  while (PR_IntervalNow() - start < aDuration) {
+    if (!NS_ProcessNextEvent(thread, false)) {
+      PR_Sleep(PR_MillisecondsToInterval(1));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//// Tests
+
+void
+test_MemoryDatabaseRejected()
+{
+  nsCOMPtr<mozIStorageConnection> db(getMemoryDatabase());
+  do_check_eq(NS_ERROR_UNEXPECTED, db->EnableReaderPool(2));
+  blocking_async_close(db);
+}
+
+void
+test_SelectRunsWhileWriterIsBusy()
+{
+  nsCOMPtr<mozIStorageConnection> db(getDatabase());
+  do_check_success(db->ExecuteSimpleSQL(
+    NS_LITERAL_CSTRING("PRAGMA journal_mode = WAL")));
+  do_check_success(db->ExecuteSimpleSQL(
+    NS_LITERAL_CSTRING("DROP TABLE IF EXISTS reader_pool")));
+  do_check_success(db->ExecuteSimpleSQL(
+    NS_LITERAL_CSTRING("CREATE TABLE reader_pool (id INTEGER PRIMARY KEY, "
+                       "name TEXT)")));
+  do_check_success(db->ExecuteSimpleSQL(
+    NS_LITERAL_CSTRING("INSERT INTO reader_pool (id, name) "
+                       "VALUES (1, 'one'), (2, 'two')")));
+
+  do_check_success(db->EnableReaderPool(2));
+  do_check_eq(NS_ERROR_UNEXPECTED, db->EnableReaderPool(2));
+  spin_for(PR_SecondsToInterval(1));
+
+  // -- wedge the writer's async thread and give it a pending statement, so it
+  //    is busy until we unwedge it
+  nsCOMPtr<nsIThread> target(get_conn_async_thread(db));
+  do_check_true(target);
+  RefPtr<ThreadWedger> wedger(new ThreadWedger(target));
+
+  nsCOMPtr<mozIStorageAsyncStatement> insert;
+  db->CreateAsyncStatement(
+    NS_LITERAL_CSTRING("INSERT INTO reader_pool (id, name) VALUES (3, 'three')"),
+    getter_AddRefs(insert)
+  );
+  RefPtr<ResultRecorder> insertRecorder(new ResultRecorder());
+  nsCOMPtr<mozIStoragePendingStatement> pending;
+  (void)insert->ExecuteAsync(insertRecorder, getter_AddRefs(pending));
+
+  // -- a SELECT bound by name completes without waiting on the writer
+  nsCOMPtr<mozIStorageAsyncStatement> select;
+  db->CreateAsyncStatement(
+    NS_LITERAL_CSTRING("SELECT name FROM reader_pool WHERE id = :id"),
+    getter_AddRefs(select)
+  );
+  select->BindInt32ByName(NS_LITERAL_CSTRING("id"), 2);
+  RefPtr<ResultRecorder> selectRecorder(new ResultRecorder());
+  (void)select->ExecuteAsync(selectRecorder, getter_AddRefs(pending));
+  selectRecorder->SpinUntilCompleted(PR_SecondsToInterval(5));
+  do_check_true(selectRecorder->completed);
+  do_check_true(selectRecorder->completionReason ==
+                mozIStorageStatementCallback::REASON_FINISHED);
+  do_check_true(selectRecorder->name.EqualsLiteral("two"));
+  do_check_false(insertRecorder->completed);
+
+  // -- so does one bound by index, and it does not see the pending insert
+  nsCOMPtr<mozIStorageAsyncStatement> count;
+  db->CreateAsyncStatement(
+    NS_LITERAL_CSTRING("SELECT COUNT(*) FROM reader_pool WHERE id >= ?"),
+    getter_AddRefs(count)
+  );
+  count->BindInt32ByIndex(0, 1);
+  RefPtr<ResultRecorder> countRecorder(new ResultRecorder());
+  (void)count->ExecuteAsync(countRecorder, getter_AddRefs(pending));
+  countRecorder->SpinUntilCompleted(PR_SecondsToInterval(5));
+  do_check_true(countRecorder->completed);
+  do_check_true(countRecorder->name.EqualsLiteral("2"));
+
+  // -- unwedge the writer; the insert completes and is visible afterwards
+  wedger->unwedge();
+  insertRecorder->SpinUntilCompleted(PR_SecondsToInterval(5));
+  do_check_true(insertRecorder->completed);
+
+  count->BindInt32ByIndex(0, 1);
+  countRecorder = new ResultRecorder();
+  (void)count->ExecuteAsync(countRecorder, getter_AddRefs(pending));
+  countRecorder->SpinUntilCompleted(PR_SecondsToInterval(5));
+  do_check_true(countRecorder->name.EqualsLiteral("3"));
+
+  // -- cleanup
+  insert->Finalize();
+  select->Finalize();
+  count->Finalize();
+  blocking_async_close(db);
+}
+
+void (*gTests[])(void) = {
+  test_MemoryDatabaseRejected,
+  test_SelectRunsWhileWriterIsBusy,
+};
+
+const char *file = __FILE__;
+#define TEST_NAME "reader pool"
+#define TEST_FILE file
+#include "storage_test_harness_tail.h"
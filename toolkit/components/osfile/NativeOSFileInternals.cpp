@@ -35,12 +35,14 @@
 #include "jsfriendapi.h"
 #include "js/Utility.h"
 #include "xpcpublic.h"
+#include "nsJSUtils.h"
 
 #include <algorithm>
 #if defined(XP_UNIX)
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
 #endif // defined (XP_UNIX)
@@ -137,11 +139,13 @@ private:
 #define OS_ERROR_INVAL EINVAL
 #define OS_ERROR_TOO_LARGE EFBIG
 #define OS_ERROR_RACE EIO
+#define OS_ERROR_EXISTS EEXIST
 #elif defined(XP_WIN)
 #define OS_ERROR_NOMEM ERROR_NOT_ENOUGH_MEMORY
 #define OS_ERROR_INVAL ERROR_BAD_ARGUMENTS
 #define OS_ERROR_TOO_LARGE ERROR_FILE_TOO_LARGE
 #define OS_ERROR_RACE ERROR_SHARING_VIOLATION
+#define OS_ERROR_EXISTS ERROR_FILE_EXISTS
 #else
 #error "We do not have platform-specific constants for this platform"
 #endif
@@ -385,6 +389,40 @@ TypedArrayResult::GetCacheableResult(JSContext* cx, JS::MutableHandle<JS::Value>
   return NS_OK;
 }
 
+/**
+ * Return a result as a number.
+ */
+class NumberResult final : public AbstractResult
+{
+public:
+  explicit NumberResult(TimeStamp aStartDate)
+    : AbstractResult(aStartDate)
+    , mContents(0)
+  {
+  }
+
+  void Init(TimeStamp aDispatchDate,
+            TimeDuration aExecutionDuration,
+            double aContents) {
+    AbstractResult::Init(aDispatchDate, aExecutionDuration);
+    mContents = aContents;
+  }
+
+protected:
+  nsresult GetCacheableResult(JSContext* cx, JS::MutableHandleValue aResult) override;
+
+private:
+  double mContents;
+};
+
+nsresult
+NumberResult::GetCacheableResult(JSContext* cx, JS::MutableHandleValue aResult)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  aResult.setNumber(mContents);
+  return NS_OK;
+}
+
 //////// Callback events
 
 /**
@@ -852,6 +890,240 @@ protected:
   RefPtr<StringResult> mResult;
 };
 
+/**
+ * An event implementing writing a buffer to a file, possibly through a
+ * temporary file that is then renamed over the destination.
+ */
+class DoWriteAtomicEvent final : public AbstractDoEvent {
+public:
+  /**
+   * @param aBuffer The data to write. Ownership is transferred to the event.
+   */
+  DoWriteAtomicEvent(const nsAString& aPath,
+                     const nsAString& aTmpPath,
+                     ArrayBufferContents aBuffer,
+                     const bool aNoOverwrite,
+                     const bool aFlush,
+                     nsMainThreadPtrHandle<nsINativeOSFileSuccessCallback>& aOnSuccess,
+                     nsMainThreadPtrHandle<nsINativeOSFileErrorCallback>& aOnError)
+    : AbstractDoEvent(aOnSuccess, aOnError)
+    , mPath(aPath)
+    , mTmpPath(aTmpPath)
+    , mBuffer(aBuffer)
+    , mNoOverwrite(aNoOverwrite)
+    , mFlush(aFlush)
+    , mResult(new NumberResult(TimeStamp::Now()))
+  {
+    MOZ_ASSERT(NS_IsMainThread());
+  }
+
+  ~DoWriteAtomicEvent() {
+    // If Run() has bailed out, we may need to cleanup mResult, which is
+    // main-thread only data
+    if (!mResult) {
+      return;
+    }
+    NS_ReleaseOnMainThread(mResult.forget());
+  }
+
+  NS_IMETHOD Run() override {
+    MOZ_ASSERT(!NS_IsMainThread());
+    TimeStamp dispatchDate = TimeStamp::Now();
+
+    nsresult rv = Write();
+    if (NS_FAILED(rv)) {
+      // Error reporting is handled by Write();
+      return NS_OK;
+    }
+
+    mResult->Init(dispatchDate, TimeStamp::Now() - dispatchDate,
+                  double(mBuffer.get().nbytes));
+    Succeed(mResult.forget());
+    return NS_OK;
+  }
+
+ private:
+  /**
+   * Write synchronously.
+   *
+   * Must be called off the main thread.
+   */
+  nsresult Write()
+  {
+    MOZ_ASSERT(!NS_IsMainThread());
+
+    if (mNoOverwrite) {
+#if defined(XP_WIN)
+      if (::GetFileAttributesW(mPath.get()) != INVALID_FILE_ATTRIBUTES) {
+#else
+      if (access(NS_ConvertUTF16toUTF8(mPath).get(), F_OK) == 0) {
+#endif // defined(XP_WIN)
+        Fail(NS_LITERAL_CSTRING("noOverwrite"), nullptr, OS_ERROR_EXISTS);
+        return NS_ERROR_FAILURE;
+      }
+    }
+
+    const nsString& destination = mTmpPath.IsEmpty() ? mPath : mTmpPath;
+
+    ScopedPRFileDesc file;
+#if defined(XP_WIN)
+    // See AbstractReadEvent::Read() for why we don't use PR_OpenFile here.
+    HANDLE handle =
+      ::CreateFileW(destination.get(),
+                    GENERIC_WRITE,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    /*Security attributes*/nullptr,
+                    CREATE_ALWAYS,
+                    FILE_ATTRIBUTE_NORMAL,
+                    /*Template file*/ nullptr);
+
+    if (handle == INVALID_HANDLE_VALUE) {
+      Fail(NS_LITERAL_CSTRING("open"), nullptr, ::GetLastError());
+      return NS_ERROR_FAILURE;
+    }
+
+    file = PR_ImportFile((PROsfd)handle);
+    if (!file) {
+      // |file| is closed by PR_ImportFile
+      Fail(NS_LITERAL_CSTRING("ImportFile"), nullptr, PR_GetOSError());
+      return NS_ERROR_FAILURE;
+    }
+
+#else
+    NS_ConvertUTF16toUTF8 path(destination);
+    file = PR_OpenFile(path.get(), PR_WRONLY | PR_CREATE_FILE | PR_TRUNCATE,
+                       0644);
+    if (!file) {
+      Fail(NS_LITERAL_CSTRING("open"), nullptr, PR_GetOSError());
+      return NS_ERROR_FAILURE;
+    }
+
+#endif // defined(XP_WIN)
+
+    const ArrayBufferContents& contents = mBuffer.get();
+    uint64_t total_written = 0;
+    while (total_written < contents.nbytes) {
+      int32_t just_written =
+        PR_Write(file, contents.data + total_written,
+                 std::min(uint64_t(PR_INT32_MAX),
+                          contents.nbytes - total_written));
+      if (just_written == -1) {
+        Fail(NS_LITERAL_CSTRING("write"), nullptr, PR_GetOSError());
+        return NS_ERROR_FAILURE;
+      }
+      total_written += just_written;
+    }
+
+    if (mFlush && PR_Sync(file) != PR_SUCCESS) {
+      Fail(NS_LITERAL_CSTRING("flush"), nullptr, PR_GetOSError());
+      return NS_ERROR_FAILURE;
+    }
+
+    // Close the file before renaming it, as Windows doesn't let us
+    // replace a file that is still open.
+    if (PR_Close(file.forget()) != PR_SUCCESS) {
+      Fail(NS_LITERAL_CSTRING("close"), nullptr, PR_GetOSError());
+      return NS_ERROR_FAILURE;
+    }
+
+    if (mTmpPath.IsEmpty()) {
+      return NS_OK;
+    }
+
+#if defined(XP_WIN)
+    if (!::MoveFileExW(mTmpPath.get(), mPath.get(),
+                       MOVEFILE_REPLACE_EXISTING)) {
+      Fail(NS_LITERAL_CSTRING("move"), nullptr, ::GetLastError());
+      return NS_ERROR_FAILURE;
+    }
+#else
+    if (rename(path.get(), NS_ConvertUTF16toUTF8(mPath).get()) == -1) {
+      Fail(NS_LITERAL_CSTRING("move"), nullptr, errno);
+      return NS_ERROR_FAILURE;
+    }
+#endif // defined(XP_WIN)
+
+    return NS_OK;
+  }
+
+ private:
+  const nsString mPath;
+  const nsString mTmpPath;
+  ScopedArrayBufferContents mBuffer;
+  const bool mNoOverwrite;
+  const bool mFlush;
+  RefPtr<NumberResult> mResult;
+};
+
+/**
+ * Copy the data to write from a string (encoded as UTF-8), an
+ * ArrayBuffer or an ArrayBufferView.
+ */
+nsresult
+CopyBufferToWrite(JSContext* cx, JS::HandleValue aBuffer,
+                  ScopedArrayBufferContents& aContents)
+{
+  if (aBuffer.isString()) {
+    nsAutoJSString string;
+    if (!string.init(cx, aBuffer)) {
+      return NS_ERROR_FAILURE;
+    }
+    NS_ConvertUTF16toUTF8 utf8(string);
+    if (utf8.IsEmpty()) {
+      return NS_OK;
+    }
+    if (!aContents.Allocate(utf8.Length())) {
+      return NS_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(aContents.rwget().data, utf8.get(), utf8.Length());
+    return NS_OK;
+  }
+
+  if (!aBuffer.isObject()) {
+    return NS_ERROR_INVALID_ARG;
+  }
+
+  JSObject* obj = js::CheckedUnwrap(&aBuffer.toObject());
+  if (!obj) {
+    return NS_ERROR_INVALID_ARG;
+  }
+
+  uint32_t length;
+  bool isSharedMemory;
+  uint8_t* data;
+  if (JS_IsArrayBufferViewObject(obj)) {
+    js::GetArrayBufferViewLengthAndData(obj, &length, &isSharedMemory, &data);
+  } else if (JS_IsArrayBufferObject(obj)) {
+    js::GetArrayBufferLengthAndData(obj, &length, &isSharedMemory, &data);
+  } else {
+    return NS_ERROR_INVALID_ARG;
+  }
+
+  if (length == 0) {
+    return NS_OK;
+  }
+  if (!aContents.Allocate(length)) {
+    return NS_ERROR_OUT_OF_MEMORY;
+  }
+  memcpy(aContents.rwget().data, data, length);
+  return NS_OK;
+}
+
+/**
+ * Read an optional boolean field from an options object.
+ */
+bool
+GetBooleanOption(JSContext* cx, JS::HandleObject aOptions, const char* aName,
+                 bool* aValue)
+{
+  JS::Rooted<JS::Value> value(cx);
+  if (!JS_GetProperty(cx, aOptions, aName, &value)) {
+    return false;
+  }
+  *aValue = JS::ToBoolean(value);
+  return true;
+}
+
 } // namespace
 
 // The OS.File service
@@ -912,5 +1184,61 @@ NativeOSFileInternalsService::Read(const nsAString& aPath,
   return target->Dispatch(event, NS_DISPATCH_NORMAL);
 }
 
-} // namespace mozilla
+NS_IMETHODIMP
+NativeOSFileInternalsService::WriteAtomic(const nsAString& aPath,
+                                          JS::HandleValue aBuffer,
+                                          JS::HandleValue aOptions,
+                                          nsINativeOSFileSuccessCallback *aOnSuccess,
+                                          nsINativeOSFileErrorCallback *aOnError,
+                                          JSContext* cx)
+{
+  // Extract options
+  nsAutoJSString tmpPath;
+  bool noOverwrite = false;
+  bool flush = false;
+
+  if (aOptions.isObject()) {
+    JS::Rooted<JSObject*> options(cx, &aOptions.toObject());
+
+    JS::Rooted<JS::Value> tmpPathValue(cx);
+    if (!JS_GetProperty(cx, options, "tmpPath", &tmpPathValue)) {
+      return NS_ERROR_INVALID_ARG;
+    }
+    if (!tmpPathValue.isNullOrUndefined() && !tmpPath.init(cx, tmpPathValue)) {
+      return NS_ERROR_INVALID_ARG;
+    }
+
+    if (!GetBooleanOption(cx, options, "noOverwrite", &noOverwrite) ||
+        !GetBooleanOption(cx, options, "flush", &flush)) {
+      return NS_ERROR_INVALID_ARG;
+    }
+  }
+
+  ScopedArrayBufferContents buffer;
+  nsresult rv = CopyBufferToWrite(cx, aBuffer, buffer);
+  if (NS_FAILED(rv)) {
+    return rv;
+  }
+
+  // Prepare the off main thread event and dispatch it
+  nsCOMPtr<nsINativeOSFileSuccessCallback> onSuccess(aOnSuccess);
+  nsMainThreadPtrHandle<nsINativeOSFileSuccessCallback> onSuccessHandle(
+    new nsMainThreadPtrHolder<nsINativeOSFileSuccessCallback>(onSuccess));
+  nsCOMPtr<nsINativeOSFileErrorCallback> onError(aOnError);
+  nsMainThreadPtrHandle<nsINativeOSFileErrorCallback> onErrorHandle(
+    new nsMainThreadPtrHolder<nsINativeOSFileErrorCallback>(onError));
+
+  RefPtr<AbstractDoEvent> event =
+    new DoWriteAtomicEvent(aPath, tmpPath, buffer.forget(),
+                           noOverwrite, flush,
+                           onSuccessHandle, onErrorHandle);
+
+  nsCOMPtr<nsIEventTarget> target = do_GetService(NS_STREAMTRANSPORTSERVICE_CONTRACTID, &rv);
+
+  if (NS_FAILED(rv)) {
+    return rv;
+  }
+  return target->Dispatch(event, NS_DISPATCH_NORMAL);
+}
 
+} // namespace mozilla
@@ -126,6 +126,10 @@ using namespace mozilla::places;
 // Initial length of the recent events cache.
 #define RECENT_EVENTS_INITIAL_CACHE_LENGTH 64
 
+// Maximum number of pages whose invalid frecency is recalculated by a single
+// statement.
+#define FIX_INVALID_FRECENCIES_CHUNK_SIZE 500
+
 // Observed topics.
 #ifdef MOZ_XUL
 #define TOPIC_AUTOCOMPLETE_FEEDBACK_INCOMING "autocomplete-will-enter-text"
@@ -279,6 +283,7 @@ nsNavHistory::nsNavHistory()
   , mLastCachedEndOfDay(0)
   , mCanNotify(true)
   , mCacheObservers("history-observers")
+  , mFixInvalidFrecenciesChunks(0)
 {
   NS_ASSERTION(!gHistoryService,
                "Attempting to create two instances of the service!");
@@ -2849,6 +2854,23 @@ nsNavHistory::GetExpectedDatabasePageSize(int32_t* _expectedPageSize)
 }
 
 
+NS_IMETHODIMP
+nsNavHistory::GetUseIncrementalVacuum(bool* _useIncrementalVacuum)
+{
+  *_useIncrementalVacuum = true;
+  return NS_OK;
+}
+
+
+NS_IMETHODIMP
+nsNavHistory::GetIncrementalVacuumThreshold(int32_t* _threshold)
+{
+  // Releasing less than this is not worth the IO.
+  *_threshold = 4 * 1024 * 1024;
+  return NS_OK;
+}
+
+
 NS_IMETHODIMP
 nsNavHistory::OnBeginVacuum(bool* _vacuumGranted)
 {
@@ -4388,25 +4410,40 @@ nsNavHistory::UpdateFrecency(int64_t aPlaceId)
 
 namespace {
 
-class FixInvalidFrecenciesCallback : public AsyncStatementCallbackNotifier
+class FixInvalidFrecenciesCallback : public AsyncStatementTelemetryTimer
 {
 public:
   FixInvalidFrecenciesCallback()
-    : AsyncStatementCallbackNotifier(TOPIC_FRECENCY_UPDATED)
+    : AsyncStatementTelemetryTimer(Telemetry::PLACES_FRECENCY_RECALC_CHUNK_TIME_MS)
+    , mLastId(0)
   {
   }
 
-  NS_IMETHOD HandleCompletion(uint16_t aReason)
+  NS_IMETHOD HandleResult(mozIStorageResultSet* aResultSet)
   {
-    nsresult rv = AsyncStatementCallbackNotifier::HandleCompletion(aReason);
+    nsCOMPtr<mozIStorageRow> row;
+    nsresult rv = aResultSet->GetNextRow(getter_AddRefs(row));
     NS_ENSURE_SUCCESS(rv, rv);
-    if (aReason == REASON_FINISHED) {
-      nsNavHistory *navHistory = nsNavHistory::GetHistoryService();
-      NS_ENSURE_STATE(navHistory);
-      navHistory->NotifyManyFrecenciesChanged();
+    if (row) {
+      // Null if no page with an invalid frecency was left.
+      rv = row->GetInt64(0, &mLastId);
+      NS_ENSURE_SUCCESS(rv, rv);
     }
     return NS_OK;
   }
+
+  NS_IMETHOD HandleCompletion(uint16_t aReason)
+  {
+    (void)AsyncStatementTelemetryTimer::HandleCompletion(aReason);
+    nsNavHistory *navHistory = nsNavHistory::GetHistoryService();
+    NS_ENSURE_STATE(navHistory);
+    navHistory->OnInvalidFrecenciesChunkFixed(
+      aReason == REASON_FINISHED ? mLastId : 0);
+    return aReason == REASON_FINISHED ? NS_OK : NS_ERROR_UNEXPECTED;
+  }
+
+private:
+  int64_t mLastId;
 };
 
 } // namespace
@@ -4414,21 +4451,89 @@ public:
 nsresult
 nsNavHistory::FixInvalidFrecencies()
 {
-  nsCOMPtr<mozIStorageAsyncStatement> stmt = mDB->GetAsyncStatement(
+  if (mFixInvalidFrecenciesChunks > 0) {
+    return NS_OK;
+  }
+
+  return FixInvalidFrecenciesAfter(0);
+}
+
+nsresult
+nsNavHistory::FixInvalidFrecenciesAfter(int64_t aLastId)
+{
+  // Recalculating every invalid frecency in one statement can keep the
+  // database busy for a long time on large histories, so only do a chunk of
+  // pages at a time.  Walk them in id order, since a recalculated frecency can
+  // still be negative.  The first statement finds the last page of the chunk,
+  // from which the next chunk starts.
+  nsCOMPtr<mozIStorageAsyncStatement> lastIdStmt = mDB->GetAsyncStatement(
+    "SELECT MAX(id) FROM ("
+      "SELECT id FROM moz_places "
+      "WHERE id > :last_id AND frecency < 0 "
+      "ORDER BY id "
+      "LIMIT :chunk_size"
+    ")"
+  );
+  NS_ENSURE_STATE(lastIdStmt);
+  nsresult rv = lastIdStmt->BindInt64ByName(NS_LITERAL_CSTRING("last_id"),
+                                            aLastId);
+  NS_ENSURE_SUCCESS(rv, rv);
+  rv = lastIdStmt->BindInt32ByName(NS_LITERAL_CSTRING("chunk_size"),
+                                   FIX_INVALID_FRECENCIES_CHUNK_SIZE);
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  nsCOMPtr<mozIStorageAsyncStatement> fixStmt = mDB->GetAsyncStatement(
     "UPDATE moz_places "
     "SET frecency = CALCULATE_FRECENCY(id) "
-    "WHERE frecency < 0"
+    "WHERE id IN ("
+      "SELECT id FROM moz_places "
+      "WHERE id > :last_id AND frecency < 0 "
+      "ORDER BY id "
+      "LIMIT :chunk_size"
+    ")"
   );
-  NS_ENSURE_STATE(stmt);
+  NS_ENSURE_STATE(fixStmt);
+  rv = fixStmt->BindInt64ByName(NS_LITERAL_CSTRING("last_id"), aLastId);
+  NS_ENSURE_SUCCESS(rv, rv);
+  rv = fixStmt->BindInt32ByName(NS_LITERAL_CSTRING("chunk_size"),
+                                FIX_INVALID_FRECENCIES_CHUNK_SIZE);
+  NS_ENSURE_SUCCESS(rv, rv);
 
+  mozIStorageBaseStatement *stmts[] = {
+    lastIdStmt.get(),
+    fixStmt.get()
+  };
   RefPtr<FixInvalidFrecenciesCallback> callback =
     new FixInvalidFrecenciesCallback();
   nsCOMPtr<mozIStoragePendingStatement> ps;
-  (void)stmt->ExecuteAsync(callback, getter_AddRefs(ps));
+  rv = mDB->MainConn()->ExecuteAsync(stmts, ArrayLength(stmts), callback,
+                                     getter_AddRefs(ps));
+  NS_ENSURE_SUCCESS(rv, rv);
 
+  ++mFixInvalidFrecenciesChunks;
   return NS_OK;
 }
 
+void
+nsNavHistory::OnInvalidFrecenciesChunkFixed(int64_t aLastId)
+{
+  MOZ_ASSERT(mFixInvalidFrecenciesChunks > 0);
+
+  if (aLastId > 0 && NS_SUCCEEDED(FixInvalidFrecenciesAfter(aLastId))) {
+    return;
+  }
+
+  Telemetry::Accumulate(Telemetry::PLACES_FRECENCY_RECALC_CHUNKS,
+                        mFixInvalidFrecenciesChunks);
+  mFixInvalidFrecenciesChunks = 0;
+
+  nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+  if (obs) {
+    (void)obs->NotifyObservers(nullptr, TOPIC_FRECENCY_UPDATED, nullptr);
+  }
+  NotifyManyFrecenciesChanged();
+}
+
 
 #ifdef MOZ_XUL
 
@@ -167,9 +167,23 @@ public:
    *  * After a "clear private data"
    *  * After removing visits
    *  * After migrating from older versions
+   *
+   * Pages are recalculated asynchronously in chunks, so that each chunk only
+   * holds the database for a short time.  Calling this while a previous call
+   * is still working through its chunks does nothing.
    */
   nsresult FixInvalidFrecencies();
 
+  /**
+   * Called when a chunk of invalid frecencies has been recalculated.
+   *
+   * @param aLastId
+   *        Id of the last page in the chunk, or 0 if there was nothing left to
+   *        recalculate or the chunk failed.  Unless it is 0 the next chunk is
+   *        started, otherwise observers are notified.
+   */
+  void OnInvalidFrecenciesChunkFixed(int64_t aLastId);
+
   /**
    * Invalidate the frecencies of a list of places, so they will be recalculated
    * at the first idle-daily notification.
@@ -500,6 +514,12 @@ protected:
    */
   nsresult DecayFrecency();
 
+  /**
+   * Recalculates the next chunk of invalid frecencies, for pages with an id
+   * greater than aLastId.
+   */
+  nsresult FixInvalidFrecenciesAfter(int64_t aLastId);
+
   nsresult RemovePagesInternal(const nsCString& aPlaceIdsQueryString);
   nsresult CleanupPlacesOnVisitsDelete(const nsCString& aPlaceIdsQueryString);
 
@@ -638,6 +658,10 @@ protected:
   // Used to enable and disable the observer notifications
   bool mCanNotify;
   nsCategoryCache<nsINavHistoryObserver> mCacheObservers;
+
+  // Number of chunks recalculated so far by the running
+  // FixInvalidFrecencies(), or 0 if none is running.
+  uint32_t mFixInvalidFrecenciesChunks;
 };
 
 
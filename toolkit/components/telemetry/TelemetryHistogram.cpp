@@ -17,6 +17,7 @@
 #include "mozilla/dom/ContentChild.h"
 #include "mozilla/dom/ToJSValue.h"
 #include "mozilla/Atomics.h"
+#include "mozilla/Mutex.h"
 #include "mozilla/StartupTimeline.h"
 #include "mozilla/StaticMutex.h"
 #include "mozilla/StaticPtr.h"
@@ -27,6 +28,8 @@
 
 #include "base/histogram.h"
 
+#include "prthread.h"
+
 using base::Histogram;
 using base::StatisticsRecorder;
 using base::BooleanHistogram;
@@ -163,6 +166,26 @@ typedef nsBaseHashtableET<nsCStringHashKey, AddonHistogramMapType *>
 
 typedef AutoHashtable<AddonEntryType> AddonMapType;
 
+// Off-main-thread accumulations in the parent process are appended to a
+// buffer owned by the accumulating thread, so that busy threads don't fight
+// over |gTelemetryHistogramMutex| for every sample.  The buffer is merged
+// into the histograms when it fills up, when its thread exits, and before
+// anything reads the histograms.  Its lock is only ever contended while the
+// buffer is being merged.
+struct ThreadAccumulationBuffer
+{
+  static const uint32_t kLength = 256;
+
+  ThreadAccumulationBuffer()
+    : mLock("ThreadAccumulationBuffer::mLock")
+    , mLength(0)
+  {}
+
+  mozilla::OffTheBooksMutex mLock;
+  uint32_t mLength;
+  Accumulation mEntries[kLength];
+};
+
 } // namespace
 
 
@@ -200,6 +223,14 @@ mozilla::Atomic<bool, mozilla::Relaxed> gIPCTimerArming(false);
 StaticAutoPtr<nsTArray<Accumulation>> gAccumulations;
 StaticAutoPtr<nsTArray<KeyedAccumulation>> gKeyedAccumulations;
 
+// Per-thread accumulation buffers, see ThreadAccumulationBuffer.  The list
+// is protected by |gTelemetryHistogramMutex|; each buffer is owned by its
+// thread and deleted when that thread exits.
+mozilla::Atomic<bool> gThreadAccumulationEnabled(false);
+unsigned gThreadAccumulationIndex;
+bool gThreadAccumulationIndexValid = false;
+StaticAutoPtr<nsTArray<ThreadAccumulationBuffer*>> gThreadAccumulationBuffers;
+
 // Has XPCOM started shutting down?
 mozilla::Atomic<bool, mozilla::Relaxed>  gShuttingDown(false);
 
@@ -1436,6 +1467,82 @@ internal_Accumulate(KeyedHistogram& aKeyed,
   }
 }
 
+// Merges |aBuffer| into the histograms and empties it.  The caller must
+// hold |gTelemetryHistogramMutex|, which is always taken before a buffer's
+// own lock.
+void
+internal_DrainThreadAccumulationBuffer(ThreadAccumulationBuffer& aBuffer)
+{
+  mozilla::OffTheBooksMutexAutoLock lock(aBuffer.mLock);
+  for (uint32_t i = 0; i < aBuffer.mLength; ++i) {
+    internal_Accumulate(aBuffer.mEntries[i].mId, aBuffer.mEntries[i].mSample);
+  }
+  aBuffer.mLength = 0;
+}
+
+// The caller must hold |gTelemetryHistogramMutex|.
+void
+internal_DrainAllThreadAccumulationBuffers()
+{
+  if (!gThreadAccumulationBuffers) {
+    return;
+  }
+  for (ThreadAccumulationBuffer* buffer : *gThreadAccumulationBuffers) {
+    internal_DrainThreadAccumulationBuffer(*buffer);
+  }
+}
+
+// Thread-private destructor for a thread's accumulation buffer.
+void
+internal_ReleaseThreadAccumulationBuffer(void* aBuffer)
+{
+  auto buffer = static_cast<ThreadAccumulationBuffer*>(aBuffer);
+  {
+    StaticMutexAutoLock locker(gTelemetryHistogramMutex);
+    gThreadAccumulationBuffers->RemoveElement(buffer);
+    internal_DrainThreadAccumulationBuffer(*buffer);
+  }
+  delete buffer;
+}
+
+// Appends the sample to the current thread's accumulation buffer.  Returns
+// false if the sample wasn't buffered and the caller has to accumulate it
+// under |gTelemetryHistogramMutex| itself.  Must be called without holding
+// |gTelemetryHistogramMutex|.
+bool
+internal_BufferThreadAccumulation(mozilla::Telemetry::ID aId, uint32_t aSample)
+{
+  if (!gThreadAccumulationEnabled || NS_IsMainThread()) {
+    return false;
+  }
+
+  auto buffer = static_cast<ThreadAccumulationBuffer*>(
+    PR_GetThreadPrivate(gThreadAccumulationIndex));
+  if (!buffer) {
+    buffer = new ThreadAccumulationBuffer();
+    if (PR_SetThreadPrivate(gThreadAccumulationIndex, buffer) != PR_SUCCESS) {
+      delete buffer;
+      return false;
+    }
+    StaticMutexAutoLock locker(gTelemetryHistogramMutex);
+    gThreadAccumulationBuffers->AppendElement(buffer);
+  }
+
+  {
+    mozilla::OffTheBooksMutexAutoLock lock(buffer->mLock);
+    if (buffer->mLength < ThreadAccumulationBuffer::kLength) {
+      buffer->mEntries[buffer->mLength++] = Accumulation{aId, aSample};
+      return true;
+    }
+  }
+
+  // The buffer is full.  Drain it and accumulate this sample directly.
+  StaticMutexAutoLock locker(gTelemetryHistogramMutex);
+  internal_DrainThreadAccumulationBuffer(*buffer);
+  internal_Accumulate(aId, aSample);
+  return true;
+}
+
 void
 internal_AccumulateChild(mozilla::Telemetry::ID aId, uint32_t aSample)
 {
@@ -1565,6 +1672,11 @@ internal_JSHistogram_Snapshot(JSContext *cx, unsigned argc, JS::Value *vp)
     return false;
   }
 
+  {
+    StaticMutexAutoLock locker(gTelemetryHistogramMutex);
+    internal_DrainAllThreadAccumulationBuffers();
+  }
+
   Histogram *h = static_cast<Histogram*>(JS_GetPrivate(obj));
   JS::Rooted<JSObject*> snapshot(cx, JS_NewPlainObject(cx));
   if (!snapshot)
@@ -1606,6 +1718,12 @@ internal_JSHistogram_Clear(JSContext *cx, unsigned argc, JS::Value *vp)
   }
 #endif
 
+  {
+    // Don't let samples recorded before the clear land after it.
+    StaticMutexAutoLock locker(gTelemetryHistogramMutex);
+    internal_DrainAllThreadAccumulationBuffers();
+  }
+
   Histogram *h = static_cast<Histogram*>(JS_GetPrivate(obj));
   MOZ_ASSERT(h);
   if (h) {
@@ -1991,6 +2109,20 @@ void TelemetryHistogram::InitializeGlobalState(bool canRecordBase,
   gCanRecordBase = canRecordBase;
   gCanRecordExtended = canRecordExtended;
 
+  // Child processes already batch their accumulations for IPC.
+  if (XRE_IsParentProcess()) {
+    if (!gThreadAccumulationIndexValid) {
+      gThreadAccumulationIndexValid =
+        PR_NewThreadPrivateIndex(&gThreadAccumulationIndex,
+                                 internal_ReleaseThreadAccumulationBuffer)
+          == PR_SUCCESS;
+    }
+    if (!gThreadAccumulationBuffers) {
+      gThreadAccumulationBuffers = new nsTArray<ThreadAccumulationBuffer*>();
+    }
+    gThreadAccumulationEnabled = gThreadAccumulationIndexValid;
+  }
+
   // gHistogramMap should have been pre-sized correctly at the
   // declaration point further up in this file.
 
@@ -2057,6 +2189,10 @@ void TelemetryHistogram::InitializeGlobalState(bool canRecordBase,
 void TelemetryHistogram::DeInitializeGlobalState()
 {
   StaticMutexAutoLock locker(gTelemetryHistogramMutex);
+  // The buffers stay registered until their threads exit, so that a later
+  // InitializeGlobalState can pick them up again.
+  gThreadAccumulationEnabled = false;
+  internal_DrainAllThreadAccumulationBuffers();
   gCanRecordBase = false;
   gCanRecordExtended = false;
   gHistogramMap.Clear();
@@ -2148,6 +2284,9 @@ void
 TelemetryHistogram::Accumulate(mozilla::Telemetry::ID aHistogram,
                                uint32_t aSample)
 {
+  if (internal_BufferThreadAccumulation(aHistogram, aSample)) {
+    return;
+  }
   StaticMutexAutoLock locker(gTelemetryHistogramMutex);
   internal_Accumulate(aHistogram, aSample);
 }
@@ -2315,6 +2454,11 @@ TelemetryHistogram::CreateHistogramSnapshots(JSContext *cx,
                                              bool subsession,
                                              bool clearSubsession)
 {
+  {
+    StaticMutexAutoLock locker(gTelemetryHistogramMutex);
+    internal_DrainAllThreadAccumulationBuffers();
+  }
+
   // Runs without protection from |gTelemetryHistogramMutex|
   JS::Rooted<JSObject*> root_obj(cx, JS_NewPlainObject(cx));
   if (!root_obj)
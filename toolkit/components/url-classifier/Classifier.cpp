@@ -454,23 +454,40 @@ Classifier::Check(const nsACString& aSpec,
     }
   }
 
-  // Now check each lookup fragment against the entries in the DB.
-  for (uint32_t i = 0; i < fragments.Length(); i++) {
-    Completion lookupHash;
-    lookupHash.FromPlaintext(fragments[i], mCryptoHash);
+  uint32_t fragmentCount = fragments.Length();
+  nsTArray<Completion> lookupHashes;
+  for (uint32_t i = 0; i < fragmentCount; i++) {
+    Completion* lookupHash = lookupHashes.AppendElement();
+    lookupHash->FromPlaintext(fragments[i], mCryptoHash);
 
     if (LOG_ENABLED()) {
       nsAutoCString checking;
-      lookupHash.ToHexString(checking);
+      lookupHash->ToHexString(checking);
       LOG(("Checking fragment %s, hash %s (%X)", fragments[i].get(),
-           checking.get(), lookupHash.ToUint32()));
+           checking.get(), lookupHash->ToUint32()));
     }
+  }
 
-    for (uint32_t i = 0; i < cacheArray.Length(); i++) {
-      LookupCache *cache = cacheArray[i];
-      bool has, complete;
-      rv = cache->Has(lookupHash, &has, &complete);
-      NS_ENSURE_SUCCESS(rv, rv);
+  // Probe every table with all the fragments at once. The results are
+  // indexed by [table * fragmentCount + fragment].
+  nsTArray<bool> hasResults;
+  nsTArray<bool> completeResults;
+  for (uint32_t i = 0; i < cacheArray.Length(); i++) {
+    nsTArray<bool> has, complete;
+    rv = cacheArray[i]->HasMany(lookupHashes, has, complete);
+    NS_ENSURE_SUCCESS(rv, rv);
+    hasResults.AppendElements(has);
+    completeResults.AppendElements(complete);
+  }
+
+  // Now check each lookup fragment against the entries in the DB.
+  for (uint32_t i = 0; i < fragmentCount; i++) {
+    const Completion& lookupHash = lookupHashes[i];
+
+    for (uint32_t j = 0; j < cacheArray.Length(); j++) {
+      LookupCache *cache = cacheArray[j];
+      bool has = hasResults[j * fragmentCount + i];
+      bool complete = completeResults[j * fragmentCount + i];
       if (has) {
         LookupResult *result = aResults.AppendElement();
         if (!result)
@@ -221,6 +221,38 @@ LookupCache::Has(const Completion& aCompletion,
   return NS_OK;
 }
 
+nsresult
+LookupCache::HasMany(const nsTArray<Completion>& aCompletions,
+                     nsTArray<bool>& aHas, nsTArray<bool>& aComplete)
+{
+  uint32_t count = aCompletions.Length();
+
+  AutoTArray<uint32_t, 8> prefixes;
+  for (uint32_t i = 0; i < count; i++) {
+    prefixes.AppendElement(aCompletions[i].ToUint32());
+  }
+
+  aHas.SetLength(count);
+  aComplete.SetLength(count);
+  nsresult rv = mPrefixSet->ContainsMany(prefixes.Elements(), count,
+                                         aHas.Elements());
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  for (uint32_t i = 0; i < count; i++) {
+    LOG(("Probe in %s: %X, found %d", mTableName.get(), prefixes[i], aHas[i]));
+
+    aComplete[i] =
+      (mGetHashCache.BinaryIndexOf(aCompletions[i]) != nsTArray<Completion>::NoIndex) ||
+      (mUpdateCompletions.BinaryIndexOf(aCompletions[i]) != nsTArray<Completion>::NoIndex);
+    if (aComplete[i]) {
+      LOG(("Complete in %s", mTableName.get()));
+      aHas[i] = true;
+    }
+  }
+
+  return NS_OK;
+}
+
 nsresult
 LookupCache::WriteFile()
 {
@@ -120,6 +120,10 @@ public:
   nsresult WriteFile();
   nsresult Has(const Completion& aCompletion,
                bool* aHas, bool* aComplete);
+  // Same as Has() for each of aCompletions, probing the PrefixSet for all of
+  // them in one batch. aHas and aComplete get one entry per completion.
+  nsresult HasMany(const nsTArray<Completion>& aCompletions,
+                   nsTArray<bool>& aHas, nsTArray<bool>& aComplete);
   bool IsPrimed();
 
 private:
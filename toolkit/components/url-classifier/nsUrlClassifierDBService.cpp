@@ -124,6 +124,11 @@ LazyLogModule gUrlClassifierDbServiceLog("UrlClassifierDbService");
 #define CONFIRM_AGE_PREF        "urlclassifier.max-complete-age"
 #define CONFIRM_AGE_DEFAULT_SEC (45 * 60)
 
+// Trade memory for lookup speed in the prefix sets, see
+// nsUrlClassifierPrefixSet::SetUncompressed().
+#define PREFIXSET_UNCOMPRESSED_PREF    "urlclassifier.prefixset.uncompressed"
+#define PREFIXSET_UNCOMPRESSED_DEFAULT false
+
 class nsUrlClassifierDBServiceWorker;
 
 // Singleton instance.
@@ -1255,6 +1260,9 @@ nsUrlClassifierDBService::Init()
     GETHASH_NOISE_DEFAULT);
   gFreshnessGuarantee = Preferences::GetInt(CONFIRM_AGE_PREF,
     CONFIRM_AGE_DEFAULT_SEC);
+  nsUrlClassifierPrefixSet::SetUncompressed(
+    Preferences::GetBool(PREFIXSET_UNCOMPRESSED_PREF,
+                         PREFIXSET_UNCOMPRESSED_DEFAULT));
   ReadTablesFromPrefs();
 
   // Force PSM loading on main thread
@@ -1316,6 +1324,7 @@ nsUrlClassifierDBService::Init()
   Preferences::AddStrongObserver(this, CHECK_BLOCKED_PREF);
   Preferences::AddStrongObserver(this, GETHASH_NOISE_PREF);
   Preferences::AddStrongObserver(this, CONFIRM_AGE_PREF);
+  Preferences::AddStrongObserver(this, PREFIXSET_UNCOMPRESSED_PREF);
   Preferences::AddStrongObserver(this, PHISH_TABLE_PREF);
   Preferences::AddStrongObserver(this, MALWARE_TABLE_PREF);
   Preferences::AddStrongObserver(this, TRACKING_TABLE_PREF);
@@ -1722,6 +1731,11 @@ nsUrlClassifierDBService::Observe(nsISupports *aSubject, const char *aTopic,
     } else if (NS_LITERAL_STRING(CONFIRM_AGE_PREF).Equals(aData)) {
       gFreshnessGuarantee = Preferences::GetInt(CONFIRM_AGE_PREF,
         CONFIRM_AGE_DEFAULT_SEC);
+    } else if (NS_LITERAL_STRING(PREFIXSET_UNCOMPRESSED_PREF).Equals(aData)) {
+      // Takes effect as tables are next loaded or updated.
+      nsUrlClassifierPrefixSet::SetUncompressed(
+        Preferences::GetBool(PREFIXSET_UNCOMPRESSED_PREF,
+                             PREFIXSET_UNCOMPRESSED_DEFAULT));
     }
   } else if (!strcmp(aTopic, "profile-before-change") ||
              !strcmp(aTopic, "xpcom-shutdown-threads")) {
@@ -1760,6 +1774,7 @@ nsUrlClassifierDBService::Shutdown()
     prefs->RemoveObserver(DOWNLOAD_ALLOW_TABLE_PREF, this);
     prefs->RemoveObserver(DISALLOW_COMPLETION_TABLE_PREF, this);
     prefs->RemoveObserver(CONFIRM_AGE_PREF, this);
+    prefs->RemoveObserver(PREFIXSET_UNCOMPRESSED_PREF, this);
   }
 
   DebugOnly<nsresult> rv;
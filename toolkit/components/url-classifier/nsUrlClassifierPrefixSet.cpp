@@ -39,8 +39,11 @@ NS_IMPL_ISUPPORTS(
 // Definition required due to std::max<>()
 const uint32_t nsUrlClassifierPrefixSet::MAX_BUFFER_SIZE;
 
+Atomic<bool> nsUrlClassifierPrefixSet::sUncompressed(false);
+
 nsUrlClassifierPrefixSet::nsUrlClassifierPrefixSet()
   : mLock("nsUrlClassifierPrefixSet.mLock")
+  , mUncompressed(false)
   , mTotalPrefixes(0)
   , mMemoryReportPath()
 {
@@ -73,12 +76,17 @@ nsUrlClassifierPrefixSet::SetPrefixes(const uint32_t* aArray, uint32_t aLength)
   nsresult rv = NS_OK;
 
   if (aLength <= 0) {
-    if (mIndexPrefixes.Length() > 0) {
+    if (mTotalPrefixes > 0) {
       LOG(("Clearing PrefixSet"));
       mIndexDeltas.Clear();
       mIndexPrefixes.Clear();
+      mPrefixes.Clear();
+      mBlockStarts.Clear();
+      mUncompressed = false;
       mTotalPrefixes = 0;
     }
+  } else if (sUncompressed) {
+    rv = MakeUncompressedPrefixSet(aArray, aLength);
   } else {
     rv = MakePrefixSet(aArray, aLength);
   }
@@ -86,30 +94,27 @@ nsUrlClassifierPrefixSet::SetPrefixes(const uint32_t* aArray, uint32_t aLength)
   return rv;
 }
 
-nsresult
-nsUrlClassifierPrefixSet::MakePrefixSet(const uint32_t* aPrefixes, uint32_t aLength)
+/* static */ void
+nsUrlClassifierPrefixSet::SetUncompressed(bool aUncompressed)
 {
-  mLock.AssertCurrentThreadOwns();
+  sUncompressed = aUncompressed;
+}
 
-  if (aLength == 0) {
-    return NS_OK;
-  }
+/* static */ void
+nsUrlClassifierPrefixSet::CompressPrefixes(const uint32_t* aPrefixes,
+                                           uint32_t aLength,
+                                           nsTArray<uint32_t>& aIndexPrefixes,
+                                           nsTArray<nsTArray<uint16_t> >& aIndexDeltas)
+{
+  MOZ_ASSERT(aLength > 0);
 
-#ifdef DEBUG
-  for (uint32_t i = 1; i < aLength; i++) {
-    MOZ_ASSERT(aPrefixes[i] >= aPrefixes[i-1]);
-  }
-#endif
+  aIndexPrefixes.Clear();
+  aIndexDeltas.Clear();
 
-  mIndexPrefixes.Clear();
-  mIndexDeltas.Clear();
-  mTotalPrefixes = aLength;
-
-  mIndexPrefixes.AppendElement(aPrefixes[0]);
-  mIndexDeltas.AppendElement();
+  aIndexPrefixes.AppendElement(aPrefixes[0]);
+  aIndexDeltas.AppendElement();
 
   uint32_t numOfDeltas = 0;
-  uint32_t totalDeltas = 0;
   uint32_t previousItem = aPrefixes[0];
   for (uint32_t i = 1; i < aLength; i++) {
     if ((numOfDeltas >= DELTAS_LIMIT) ||
@@ -117,35 +122,122 @@ nsUrlClassifierPrefixSet::MakePrefixSet(const uint32_t* aPrefixes, uint32_t aLen
       // Compact the previous element.
       // Note there is always at least one element when we get here,
       // because we created the first element before the loop.
-      mIndexDeltas.LastElement().Compact();
-      mIndexDeltas.AppendElement();
-      mIndexPrefixes.AppendElement(aPrefixes[i]);
+      aIndexDeltas.LastElement().Compact();
+      aIndexDeltas.AppendElement();
+      aIndexPrefixes.AppendElement(aPrefixes[i]);
       numOfDeltas = 0;
     } else {
       uint16_t delta = aPrefixes[i] - previousItem;
-      mIndexDeltas.LastElement().AppendElement(delta);
+      aIndexDeltas.LastElement().AppendElement(delta);
       numOfDeltas++;
-      totalDeltas++;
     }
     previousItem = aPrefixes[i];
   }
 
-  mIndexDeltas.LastElement().Compact();
-  mIndexDeltas.Compact();
-  mIndexPrefixes.Compact();
+  aIndexDeltas.LastElement().Compact();
+  aIndexDeltas.Compact();
+  aIndexPrefixes.Compact();
+}
+
+nsresult
+nsUrlClassifierPrefixSet::MakePrefixSet(const uint32_t* aPrefixes, uint32_t aLength)
+{
+  mLock.AssertCurrentThreadOwns();
+
+  if (aLength == 0) {
+    return NS_OK;
+  }
+
+#ifdef DEBUG
+  for (uint32_t i = 1; i < aLength; i++) {
+    MOZ_ASSERT(aPrefixes[i] >= aPrefixes[i-1]);
+  }
+#endif
+
+  mPrefixes.Clear();
+  mBlockStarts.Clear();
+  mUncompressed = false;
+  mTotalPrefixes = aLength;
+
+  CompressPrefixes(aPrefixes, aLength, mIndexPrefixes, mIndexDeltas);
 
   LOG(("Total number of indices: %d", aLength));
-  LOG(("Total number of deltas: %d", totalDeltas));
+  LOG(("Total number of deltas: %d", aLength - mIndexPrefixes.Length()));
   LOG(("Total number of delta chunks: %d", mIndexDeltas.Length()));
 
   return NS_OK;
 }
 
+nsresult
+nsUrlClassifierPrefixSet::MakeUncompressedPrefixSet(const uint32_t* aPrefixes,
+                                                    uint32_t aLength)
+{
+  mLock.AssertCurrentThreadOwns();
+
+  if (aLength == 0) {
+    return NS_OK;
+  }
+
+#ifdef DEBUG
+  for (uint32_t i = 1; i < aLength; i++) {
+    MOZ_ASSERT(aPrefixes[i] >= aPrefixes[i-1]);
+  }
+#endif
+
+  uint32_t numBlocks = (aLength + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  nsTArray<uint32_t> prefixes;
+  nsTArray<uint32_t> blockStarts;
+  if (!prefixes.SetCapacity(numBlocks * BLOCK_SIZE, fallible) ||
+      !blockStarts.SetCapacity(numBlocks, fallible)) {
+    return NS_ERROR_OUT_OF_MEMORY;
+  }
+
+  prefixes.AppendElements(aPrefixes, aLength);
+  // Pad the last block so lookups can always compare a full block.
+  while (prefixes.Length() < numBlocks * BLOCK_SIZE) {
+    prefixes.AppendElement(aPrefixes[aLength - 1]);
+  }
+  for (uint32_t i = 0; i < numBlocks; i++) {
+    blockStarts.AppendElement(prefixes[i * BLOCK_SIZE]);
+  }
+
+  mIndexPrefixes.Clear();
+  mIndexDeltas.Clear();
+  mPrefixes.SwapElements(prefixes);
+  mBlockStarts.SwapElements(blockStarts);
+  mUncompressed = true;
+  mTotalPrefixes = aLength;
+
+  LOG(("Total number of prefixes: %d", aLength));
+  LOG(("Total number of blocks: %d", numBlocks));
+
+  return NS_OK;
+}
+
 nsresult
 nsUrlClassifierPrefixSet::GetPrefixesNative(FallibleTArray<uint32_t>& outArray)
 {
   MutexAutoLock lock(mLock);
 
+  return GetPrefixesInternal(outArray);
+}
+
+nsresult
+nsUrlClassifierPrefixSet::GetPrefixesInternal(FallibleTArray<uint32_t>& outArray)
+{
+  mLock.AssertCurrentThreadOwns();
+
+  if (mUncompressed) {
+    if (!outArray.SetLength(mTotalPrefixes, fallible)) {
+      return NS_ERROR_OUT_OF_MEMORY;
+    }
+    // Leave out the padding of the last block.
+    memcpy(outArray.Elements(), mPrefixes.Elements(),
+           mTotalPrefixes * sizeof(uint32_t));
+    return NS_OK;
+  }
+
   if (!outArray.SetLength(mTotalPrefixes, fallible)) {
     return NS_ERROR_OUT_OF_MEMORY;
   }
@@ -222,10 +314,60 @@ nsUrlClassifierPrefixSet::Contains(uint32_t aPrefix, bool* aFound)
 {
   MutexAutoLock lock(mLock);
 
-  *aFound = false;
+  *aFound = ContainsInternal(aPrefix);
+  return NS_OK;
+}
+
+nsresult
+nsUrlClassifierPrefixSet::ContainsMany(const uint32_t* aPrefixes,
+                                       uint32_t aLength,
+                                       bool* aFound)
+{
+  MutexAutoLock lock(mLock);
+
+  for (uint32_t i = 0; i < aLength; i++) {
+    aFound[i] = ContainsInternal(aPrefixes[i]);
+  }
+  return NS_OK;
+}
+
+bool
+nsUrlClassifierPrefixSet::ContainsUncompressed(uint32_t aPrefix)
+{
+  mLock.AssertCurrentThreadOwns();
+
+  if (mBlockStarts.IsEmpty() || aPrefix < mBlockStarts[0]) {
+    return false;
+  }
+
+  // The only block that can hold aPrefix is the last one starting at or
+  // below it. Blocks are always full, so the comparison loop has a fixed
+  // trip count and no early exit, which lets the compiler vectorize it.
+  const uint32_t* blockStart =
+    std::upper_bound(mBlockStarts.Elements(),
+                     mBlockStarts.Elements() + mBlockStarts.Length(),
+                     aPrefix) - 1;
+  const uint32_t* block =
+    mPrefixes.Elements() + (blockStart - mBlockStarts.Elements()) * BLOCK_SIZE;
+
+  uint32_t matches = 0;
+  for (uint32_t i = 0; i < BLOCK_SIZE; i++) {
+    matches |= (block[i] == aPrefix);
+  }
+  return matches != 0;
+}
+
+bool
+nsUrlClassifierPrefixSet::ContainsInternal(uint32_t aPrefix)
+{
+  mLock.AssertCurrentThreadOwns();
+
+  if (mUncompressed) {
+    return ContainsUncompressed(aPrefix);
+  }
 
   if (mIndexPrefixes.Length() == 0) {
-    return NS_OK;
+    return false;
   }
 
   uint32_t target = aPrefix;
@@ -235,7 +377,7 @@ nsUrlClassifierPrefixSet::Contains(uint32_t aPrefix, bool* aFound)
   // that is less than the target.
   //
   if (target < mIndexPrefixes[0]) {
-    return NS_OK;
+    return false;
   }
 
   // |binsearch| does not necessarily return the correct index (when the
@@ -259,11 +401,7 @@ nsUrlClassifierPrefixSet::Contains(uint32_t aPrefix, bool* aFound)
     deltaIndex++;
   }
 
-  if (diff == 0) {
-    *aFound = true;
-  }
-
-  return NS_OK;
+  return diff == 0;
 }
 
 MOZ_DEFINE_MALLOC_SIZE_OF(UrlClassifierMallocSizeOf)
@@ -298,6 +436,8 @@ nsUrlClassifierPrefixSet::SizeOfIncludingThis(mozilla::MallocSizeOf aMallocSizeO
     n += mIndexDeltas[i].ShallowSizeOfExcludingThis(aMallocSizeOf);
   }
   n += mIndexPrefixes.ShallowSizeOfExcludingThis(aMallocSizeOf);
+  n += mPrefixes.ShallowSizeOfExcludingThis(aMallocSizeOf);
+  n += mBlockStarts.ShallowSizeOfExcludingThis(aMallocSizeOf);
   return n;
 }
 
@@ -306,7 +446,7 @@ nsUrlClassifierPrefixSet::IsEmpty(bool * aEmpty)
 {
   MutexAutoLock lock(mLock);
 
-  *aEmpty = (mIndexPrefixes.Length() == 0);
+  *aEmpty = (mTotalPrefixes == 0);
   return NS_OK;
 }
 
@@ -366,6 +506,10 @@ nsUrlClassifierPrefixSet::LoadFromFile(nsIFile* aFile)
       return NS_ERROR_FILE_CORRUPTED;
     }
 
+    mPrefixes.Clear();
+    mBlockStarts.Clear();
+    mUncompressed = false;
+
     nsTArray<uint32_t> indexStarts;
     indexStarts.SetLength(indexSize);
     mIndexPrefixes.SetLength(indexSize);
@@ -406,6 +550,15 @@ nsUrlClassifierPrefixSet::LoadFromFile(nsIFile* aFile)
   }
 
   MOZ_ASSERT(mIndexPrefixes.Length() == mIndexDeltas.Length());
+
+  if (sUncompressed) {
+    FallibleTArray<uint32_t> prefixes;
+    rv = GetPrefixesInternal(prefixes);
+    NS_ENSURE_SUCCESS(rv, rv);
+    rv = MakeUncompressedPrefixSet(prefixes.Elements(), prefixes.Length());
+    NS_ENSURE_SUCCESS(rv, rv);
+  }
+
   LOG(("Loading PrefixSet successful"));
 
   return NS_OK;
@@ -416,6 +569,18 @@ nsUrlClassifierPrefixSet::StoreToFile(nsIFile* aFile)
 {
   MutexAutoLock lock(mLock);
 
+  // The file always holds the delta-compressed layout.
+  nsTArray<uint32_t> compressedPrefixes;
+  nsTArray<nsTArray<uint16_t> > compressedDeltas;
+  if (mUncompressed) {
+    CompressPrefixes(mPrefixes.Elements(), mTotalPrefixes,
+                     compressedPrefixes, compressedDeltas);
+  }
+  const nsTArray<uint32_t>& indexPrefixes =
+    mUncompressed ? compressedPrefixes : mIndexPrefixes;
+  const nsTArray<nsTArray<uint16_t> >& indexDeltas =
+    mUncompressed ? compressedDeltas : mIndexDeltas;
+
   nsCOMPtr<nsIOutputStream> localOutFile;
   nsresult rv = NS_NewLocalFileOutputStream(getter_AddRefs(localOutFile), aFile,
                                             PR_WRONLY | PR_TRUNCATE | PR_CREATE_FILE);
@@ -428,8 +593,8 @@ nsUrlClassifierPrefixSet::StoreToFile(nsIFile* aFile)
     nsCOMPtr<nsIFileOutputStream> fos(do_QueryInterface(localOutFile));
     Telemetry::AutoTimer<Telemetry::URLCLASSIFIER_PS_FALLOCATE_TIME> timer;
     fileSize = 4 * sizeof(uint32_t);
-    uint32_t deltas = mTotalPrefixes - mIndexPrefixes.Length();
-    fileSize += 2 * mIndexPrefixes.Length() * sizeof(uint32_t);
+    uint32_t deltas = mTotalPrefixes - indexPrefixes.Length();
+    fileSize += 2 * indexPrefixes.Length() * sizeof(uint32_t);
     fileSize += deltas * sizeof(uint16_t);
 
     // Ignore failure, the preallocation is a hint and we write out the entire
@@ -448,11 +613,11 @@ nsUrlClassifierPrefixSet::StoreToFile(nsIFile* aFile)
   NS_ENSURE_SUCCESS(rv, rv);
   NS_ENSURE_TRUE(written == writelen, NS_ERROR_FAILURE);
 
-  uint32_t indexSize = mIndexPrefixes.Length();
-  uint32_t indexDeltaSize = mIndexDeltas.Length();
+  uint32_t indexSize = indexPrefixes.Length();
+  uint32_t indexDeltaSize = indexDeltas.Length();
   uint32_t totalDeltas = 0;
 
-  // Store the shape of mIndexDeltas by noting at which "count" of total
+  // Store the shape of indexDeltas by noting at which "count" of total
   // indexes a new subarray starts. This is slightly cumbersome but keeps
   // file format compatibility.
   // If we ever update the format, we can gain space by storing the delta
@@ -461,7 +626,7 @@ nsUrlClassifierPrefixSet::StoreToFile(nsIFile* aFile)
   indexStarts.AppendElement(0);
 
   for (uint32_t i = 0; i < indexDeltaSize; i++) {
-    uint32_t deltaLength = mIndexDeltas[i].Length();
+    uint32_t deltaLength = indexDeltas[i].Length();
     totalDeltas += deltaLength;
     indexStarts.AppendElement(totalDeltas);
   }
@@ -475,7 +640,7 @@ nsUrlClassifierPrefixSet::StoreToFile(nsIFile* aFile)
   NS_ENSURE_TRUE(written == writelen, NS_ERROR_FAILURE);
 
   writelen = indexSize * sizeof(uint32_t);
-  rv = out->Write(reinterpret_cast<char*>(mIndexPrefixes.Elements()), writelen, &written);
+  rv = out->Write(reinterpret_cast<const char*>(indexPrefixes.Elements()), writelen, &written);
   NS_ENSURE_SUCCESS(rv, rv);
   NS_ENSURE_TRUE(written == writelen, NS_ERROR_FAILURE);
 
@@ -485,8 +650,8 @@ nsUrlClassifierPrefixSet::StoreToFile(nsIFile* aFile)
 
   if (totalDeltas > 0) {
     for (uint32_t i = 0; i < indexDeltaSize; i++) {
-      writelen = mIndexDeltas[i].Length() * sizeof(uint16_t);
-      rv = out->Write(reinterpret_cast<char*>(mIndexDeltas[i].Elements()), writelen, &written);
+      writelen = indexDeltas[i].Length() * sizeof(uint16_t);
+      rv = out->Write(reinterpret_cast<const char*>(indexDeltas[i].Elements()), writelen, &written);
       NS_ENSURE_SUCCESS(rv, rv);
       NS_ENSURE_TRUE(written == writelen, NS_ERROR_FAILURE);
     }
@@ -15,6 +15,7 @@
 #include "nsIUrlClassifierPrefixSet.h"
 #include "nsTArray.h"
 #include "nsToolkitCompsCID.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/FileUtils.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/Mutex.h"
@@ -36,6 +37,17 @@ public:
 
   nsresult GetPrefixesNative(FallibleTArray<uint32_t>& outArray);
 
+  // Looks up aLength prefixes at once, taking the lock a single time.
+  // aFound must have room for aLength entries.
+  nsresult ContainsMany(const uint32_t* aPrefixes, uint32_t aLength,
+                        bool* aFound);
+
+  // Selects how prefix sets store their prefixes from their next
+  // SetPrefixes() or LoadFromFile() on: delta-compressed (the default, about
+  // half the memory) or as plain blocks of 32-bit values (faster lookups).
+  // The on-disk format is the same either way.
+  static void SetUncompressed(bool aUncompressed);
+
   size_t SizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf);
 
   NS_DECL_THREADSAFE_ISUPPORTS
@@ -48,9 +60,20 @@ private:
   static const uint32_t DELTAS_LIMIT = 120;
   static const uint32_t MAX_INDEX_DIFF = (1 << 16);
   static const uint32_t PREFIXSET_VERSION_MAGIC = 1;
+  // Prefixes per block in the uncompressed layout: one 64-byte cache line.
+  static const uint32_t BLOCK_SIZE = 16;
+
+  static mozilla::Atomic<bool> sUncompressed;
 
+  static void CompressPrefixes(const uint32_t* aPrefixes, uint32_t aLength,
+                               nsTArray<uint32_t>& aIndexPrefixes,
+                               nsTArray<nsTArray<uint16_t> >& aIndexDeltas);
   nsresult MakePrefixSet(const uint32_t* aArray, uint32_t aLength);
+  nsresult MakeUncompressedPrefixSet(const uint32_t* aArray, uint32_t aLength);
+  nsresult GetPrefixesInternal(FallibleTArray<uint32_t>& outArray);
   uint32_t BinSearch(uint32_t start, uint32_t end, uint32_t target);
+  bool ContainsInternal(uint32_t aPrefix);
+  bool ContainsUncompressed(uint32_t aPrefix);
 
   // Lock to prevent races between the url-classifier thread (which does most
   // of the operations) and the main thread (which does memory reporting).
@@ -65,6 +88,13 @@ private:
   // prefix from mIndexPrefix. Then every "delta" corresponds
   // to a prefix in the PrefixSet.
   nsTArray<nsTArray<uint16_t> > mIndexDeltas;
+  // In the uncompressed layout the two arrays above are empty. Instead,
+  // mPrefixes holds every prefix, sorted, in blocks of BLOCK_SIZE (the last
+  // block is padded by repeating the largest prefix) and mBlockStarts holds
+  // the first prefix of each block.
+  nsTArray<uint32_t> mPrefixes;
+  nsTArray<uint32_t> mBlockStarts;
+  bool mUncompressed;
   // how many prefixes we have.
   uint32_t mTotalPrefixes;
 
@@ -0,0 +1,97 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <set>
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "nsUrlClassifierPrefixSet.h"
+
+// Builds a prefix set from a random sorted array of prefixes, with some
+// duplicates and some large gaps, and checks that lookups agree with it.
+static void
+TestPrefixSetLookups(bool aUncompressed)
+{
+  nsUrlClassifierPrefixSet::SetUncompressed(aUncompressed);
+
+  std::set<uint32_t> expected;
+  nsTArray<uint32_t> prefixes;
+  srand(1234);
+  for (uint32_t i = 0; i < 5000; i++) {
+    uint32_t prefix = (uint32_t(rand()) << 16) ^ uint32_t(rand());
+    if (i % 100 == 0) {
+      // Cluster some prefixes so they get delta-encoded.
+      prefix &= 0xffff0fff;
+    }
+    prefixes.AppendElement(prefix);
+    if (i % 50 == 0) {
+      prefixes.AppendElement(prefix);
+    }
+    expected.insert(prefix);
+  }
+  prefixes.Sort();
+
+  RefPtr<nsUrlClassifierPrefixSet> set = new nsUrlClassifierPrefixSet();
+  ASSERT_EQ(set->Init(NS_LITERAL_CSTRING("test")), NS_OK);
+  ASSERT_EQ(set->SetPrefixes(prefixes.Elements(), prefixes.Length()), NS_OK);
+
+  bool empty;
+  ASSERT_EQ(set->IsEmpty(&empty), NS_OK);
+  ASSERT_FALSE(empty);
+
+  for (uint32_t i = 0; i < prefixes.Length(); i++) {
+    bool found;
+    ASSERT_EQ(set->Contains(prefixes[i], &found), NS_OK);
+    ASSERT_TRUE(found);
+  }
+
+  nsTArray<uint32_t> probes;
+  for (uint32_t i = 0; i < 5000; i++) {
+    probes.AppendElement((uint32_t(rand()) << 16) ^ uint32_t(rand()));
+  }
+  probes.AppendElement(0);
+  probes.AppendElement(UINT32_MAX);
+  probes.AppendElement(prefixes[0]);
+  probes.AppendElement(prefixes[prefixes.Length() - 1]);
+
+  nsTArray<bool> found;
+  found.SetLength(probes.Length());
+  ASSERT_EQ(set->ContainsMany(probes.Elements(), probes.Length(),
+                              found.Elements()), NS_OK);
+  for (uint32_t i = 0; i < probes.Length(); i++) {
+    bool expectedFound = expected.count(probes[i]) != 0;
+    ASSERT_EQ(found[i], expectedFound);
+    bool single;
+    ASSERT_EQ(set->Contains(probes[i], &single), NS_OK);
+    ASSERT_EQ(single, expectedFound);
+  }
+
+  FallibleTArray<uint32_t> stored;
+  ASSERT_EQ(set->GetPrefixesNative(stored), NS_OK);
+  ASSERT_EQ(stored.Length(), prefixes.Length());
+  for (uint32_t i = 0; i < prefixes.Length(); i++) {
+    ASSERT_EQ(stored[i], prefixes[i]);
+  }
+
+  ASSERT_EQ(set->SetPrefixes(nullptr, 0), NS_OK);
+  ASSERT_EQ(set->IsEmpty(&empty), NS_OK);
+  ASSERT_TRUE(empty);
+  bool single;
+  ASSERT_EQ(set->Contains(prefixes[0], &single), NS_OK);
+  ASSERT_FALSE(single);
+
+  nsUrlClassifierPrefixSet::SetUncompressed(false);
+}
+
+TEST(UrlClassifierPrefixSet, Compressed)
+{
+  TestPrefixSetLookups(false);
+}
+
+TEST(UrlClassifierPrefixSet, Uncompressed)
+{
+  TestPrefixSetLookups(true);
+}
@@ -35,7 +35,12 @@ public:
 
 protected:
   char* processDynamicTag(int readPos, int* tagsConsumed, char* tagBuff);
-  int FindLastSampleOfThread(int aThreadId);
+  uint32_t ReadStack(int aStackPos, JSContext* aContext,
+                     UniqueStacks& aUniqueStacks, char* aTagBuff);
+  // Returns the position of the 'T' entry that starts the last sample of the
+  // thread, or -1.  With aNeedStack, samples without a full stack (because
+  // they duplicate an earlier one) are skipped.
+  int FindLastSampleOfThread(int aThreadId, bool aNeedStack);
 
 public:
   // Circular buffer 'Keep One Slot Open' implementation for simplicity
@@ -656,6 +656,83 @@ static void WriteSample(SpliceableJSONWriter& aWriter, ProfileSample& aSample)
   }
 }
 
+uint32_t ProfileBuffer::ReadStack(int aStackPos, JSContext* aContext,
+                                  UniqueStacks& aUniqueStacks, char* aTagBuff)
+{
+  // Seek forward through the entire sample, looking for frames
+  // this is an easier approach to reason about than adding more
+  // control variables and cases to the loop that goes through the buffer once
+
+  UniqueStacks::Stack stack =
+    aUniqueStacks.BeginStack(UniqueStacks::OnStackFrameKey("(root)"));
+
+  int framePos = (aStackPos + 1) % mEntrySize;
+  ProfileEntry frame = mEntries[framePos];
+  while (framePos != mWritePos && frame.mTagName != 's' && frame.mTagName != 'T') {
+    int incBy = 1;
+    frame = mEntries[framePos];
+
+    // Read ahead to the next tag, if it's a 'd' tag process it now
+    const char* tagStringData = frame.mTagData;
+    int readAheadPos = (framePos + 1) % mEntrySize;
+    // Make sure the string is always null terminated if it fills up
+    // DYNAMIC_MAX_STRING-2
+    aTagBuff[DYNAMIC_MAX_STRING-1] = '\0';
+
+    if (readAheadPos != mWritePos && mEntries[readAheadPos].mTagName == 'd') {
+      tagStringData = processDynamicTag(framePos, &incBy, aTagBuff);
+    }
+
+    // Write one frame. It can have either
+    // 1. only location - 'l' containing a memory address
+    // 2. location and line number - 'c' followed by 'd's,
+    // an optional 'n' and an optional 'y'
+    // 3. a JIT return address - 'j' containing native code address
+    if (frame.mTagName == 'l') {
+      // Bug 753041
+      // We need a double cast here to tell GCC that we don't want to sign
+      // extend 32-bit addresses starting with 0xFXXXXXX.
+      unsigned long long pc = (unsigned long long)(uintptr_t)frame.mTagPtr;
+      snprintf(aTagBuff, DYNAMIC_MAX_STRING, "%#llx", pc);
+      stack.AppendFrame(UniqueStacks::OnStackFrameKey(aTagBuff));
+    } else if (frame.mTagName == 'c') {
+      UniqueStacks::OnStackFrameKey frameKey(tagStringData);
+      readAheadPos = (framePos + incBy) % mEntrySize;
+      if (readAheadPos != mWritePos &&
+          mEntries[readAheadPos].mTagName == 'n') {
+        frameKey.mLine = Some((unsigned) mEntries[readAheadPos].mTagInt);
+        incBy++;
+      }
+      readAheadPos = (framePos + incBy) % mEntrySize;
+      if (readAheadPos != mWritePos &&
+          mEntries[readAheadPos].mTagName == 'y') {
+        frameKey.mCategory = Some((unsigned) mEntries[readAheadPos].mTagInt);
+        incBy++;
+      }
+      stack.AppendFrame(frameKey);
+#ifndef SPS_STANDALONE
+    } else if (frame.mTagName == 'J') {
+      // A JIT frame may expand to multiple frames due to inlining.
+      void* pc = frame.mTagPtr;
+      unsigned depth = aUniqueStacks.LookupJITFrameDepth(pc);
+      if (depth == 0) {
+        StreamJSFramesOp framesOp(pc, stack);
+        JS::ForEachProfiledFrame(aContext, pc, framesOp);
+        aUniqueStacks.AddJITFrameDepth(pc, framesOp.depth());
+      } else {
+        for (unsigned i = 0; i < depth; i++) {
+          UniqueStacks::OnStackFrameKey inlineFrameKey(pc, i);
+          stack.AppendFrame(inlineFrameKey);
+        }
+      }
+#endif
+    }
+    framePos = (framePos + incBy) % mEntrySize;
+  }
+
+  return stack.GetOrAddIndex();
+}
+
 void ProfileBuffer::StreamSamplesToJSON(SpliceableJSONWriter& aWriter, int aThreadId,
                                         double aSinceTime, JSContext* aContext,
                                         UniqueStacks& aUniqueStacks)
@@ -666,6 +743,12 @@ void ProfileBuffer::StreamSamplesToJSON(SpliceableJSONWriter& aWriter, int aThre
   Maybe<double> currentTime;
   UniquePtr<char[]> tagBuff = MakeUnique<char[]>(DYNAMIC_MAX_STRING);
 
+  // The last full stack of this thread, which 'D' samples refer to.  It is
+  // tracked even outside of the requested time range, and only read when a
+  // sample needs it.
+  int lastStackPos = -1;
+  Maybe<uint32_t> lastStack;
+
   while (readPos != mWritePos) {
     ProfileEntry entry = mEntries[readPos];
     if (entry.mTagName == 'T') {
@@ -679,6 +762,10 @@ void ProfileBuffer::StreamSamplesToJSON(SpliceableJSONWriter& aWriter, int aThre
         }
       }
     }
+    if (currentThreadID == aThreadId && entry.mTagName == 's') {
+      lastStackPos = readPos;
+      lastStack.reset();
+    }
     if (currentThreadID == aThreadId && (currentTime.isNothing() || *currentTime >= aSinceTime)) {
       switch (entry.mTagName) {
       case 'r':
@@ -707,88 +794,27 @@ void ProfileBuffer::StreamSamplesToJSON(SpliceableJSONWriter& aWriter, int aThre
         }
         break;
       case 's':
+      case 'D':
         {
           // end the previous sample if there was one
           if (sample.isSome()) {
             WriteSample(aWriter, *sample);
             sample.reset();
           }
-          // begin the next sample
-          sample.emplace();
-          sample->mTime = currentTime;
 
-          // Seek forward through the entire sample, looking for frames
-          // this is an easier approach to reason about than adding more
-          // control variables and cases to the loop that goes through the buffer once
-
-          UniqueStacks::Stack stack =
-            aUniqueStacks.BeginStack(UniqueStacks::OnStackFrameKey("(root)"));
-
-          int framePos = (readPos + 1) % mEntrySize;
-          ProfileEntry frame = mEntries[framePos];
-          while (framePos != mWritePos && frame.mTagName != 's' && frame.mTagName != 'T') {
-            int incBy = 1;
-            frame = mEntries[framePos];
-
-            // Read ahead to the next tag, if it's a 'd' tag process it now
-            const char* tagStringData = frame.mTagData;
-            int readAheadPos = (framePos + 1) % mEntrySize;
-            // Make sure the string is always null terminated if it fills up
-            // DYNAMIC_MAX_STRING-2
-            tagBuff[DYNAMIC_MAX_STRING-1] = '\0';
-
-            if (readAheadPos != mWritePos && mEntries[readAheadPos].mTagName == 'd') {
-              tagStringData = processDynamicTag(framePos, &incBy, tagBuff.get());
-            }
-
-            // Write one frame. It can have either
-            // 1. only location - 'l' containing a memory address
-            // 2. location and line number - 'c' followed by 'd's,
-            // an optional 'n' and an optional 'y'
-            // 3. a JIT return address - 'j' containing native code address
-            if (frame.mTagName == 'l') {
-              // Bug 753041
-              // We need a double cast here to tell GCC that we don't want to sign
-              // extend 32-bit addresses starting with 0xFXXXXXX.
-              unsigned long long pc = (unsigned long long)(uintptr_t)frame.mTagPtr;
-              snprintf(tagBuff.get(), DYNAMIC_MAX_STRING, "%#llx", pc);
-              stack.AppendFrame(UniqueStacks::OnStackFrameKey(tagBuff.get()));
-            } else if (frame.mTagName == 'c') {
-              UniqueStacks::OnStackFrameKey frameKey(tagStringData);
-              readAheadPos = (framePos + incBy) % mEntrySize;
-              if (readAheadPos != mWritePos &&
-                  mEntries[readAheadPos].mTagName == 'n') {
-                frameKey.mLine = Some((unsigned) mEntries[readAheadPos].mTagInt);
-                incBy++;
-              }
-              readAheadPos = (framePos + incBy) % mEntrySize;
-              if (readAheadPos != mWritePos &&
-                  mEntries[readAheadPos].mTagName == 'y') {
-                frameKey.mCategory = Some((unsigned) mEntries[readAheadPos].mTagInt);
-                incBy++;
-              }
-              stack.AppendFrame(frameKey);
-#ifndef SPS_STANDALONE
-            } else if (frame.mTagName == 'J') {
-              // A JIT frame may expand to multiple frames due to inlining.
-              void* pc = frame.mTagPtr;
-              unsigned depth = aUniqueStacks.LookupJITFrameDepth(pc);
-              if (depth == 0) {
-                StreamJSFramesOp framesOp(pc, stack);
-                JS::ForEachProfiledFrame(aContext, pc, framesOp);
-                aUniqueStacks.AddJITFrameDepth(pc, framesOp.depth());
-              } else {
-                for (unsigned i = 0; i < depth; i++) {
-                  UniqueStacks::OnStackFrameKey inlineFrameKey(pc, i);
-                  stack.AppendFrame(inlineFrameKey);
-                }
-              }
-#endif
-            }
-            framePos = (framePos + incBy) % mEntrySize;
+          // A 'D' sample whose stack has been overwritten is dropped.
+          if (lastStackPos == -1) {
+            break;
+          }
+          if (lastStack.isNothing()) {
+            lastStack = Some(ReadStack(lastStackPos, aContext, aUniqueStacks,
+                                       tagBuff.get()));
           }
 
-          sample->mStack = stack.GetOrAddIndex();
+          // begin the next sample
+          sample.emplace();
+          sample->mTime = currentTime;
+          sample->mStack = *lastStack;
           break;
         }
       }
@@ -819,16 +845,22 @@ void ProfileBuffer::StreamMarkersToJSON(SpliceableJSONWriter& aWriter, int aThre
   }
 }
 
-int ProfileBuffer::FindLastSampleOfThread(int aThreadId)
+int ProfileBuffer::FindLastSampleOfThread(int aThreadId, bool aNeedStack)
 {
   // We search backwards from mWritePos-1 to mReadPos.
   // Adding mEntrySize makes the result of the modulus positive.
+  bool sawStack = false;
   for (int readPos  = (mWritePos + mEntrySize - 1) % mEntrySize;
            readPos !=  (mReadPos + mEntrySize - 1) % mEntrySize;
            readPos  =   (readPos + mEntrySize - 1) % mEntrySize) {
     ProfileEntry entry = mEntries[readPos];
-    if (entry.mTagName == 'T' && entry.mTagInt == aThreadId) {
-      return readPos;
+    if (entry.mTagName == 's') {
+      sawStack = true;
+    } else if (entry.mTagName == 'T') {
+      if (entry.mTagInt == aThreadId && (sawStack || !aNeedStack)) {
+        return readPos;
+      }
+      sawStack = false;
     }
   }
 
@@ -837,17 +869,34 @@ int ProfileBuffer::FindLastSampleOfThread(int aThreadId)
 
 void ProfileBuffer::DuplicateLastSample(int aThreadId)
 {
-  int lastSampleStartPos = FindLastSampleOfThread(aThreadId);
+  int lastSampleStartPos = FindLastSampleOfThread(aThreadId, false);
   if (lastSampleStartPos == -1) {
     return;
   }
 
   MOZ_ASSERT(mEntries[lastSampleStartPos].mTagName == 'T');
 
-  addTag(mEntries[lastSampleStartPos]);
+  // A sleeping thread keeps getting sampled with the same stack, so rather
+  // than copying the stack again we write a 'D' entry that refers back to
+  // the last full stack of the thread.  That stack must not be about to be
+  // overwritten, so once it's more than half the buffer behind us we make a
+  // full copy instead, which the following duplicates then refer to.
+  int lastStackStartPos = FindLastSampleOfThread(aThreadId, true);
+  if (lastStackStartPos == -1) {
+    return;
+  }
+  int distance = (mWritePos - lastStackStartPos + mEntrySize) % mEntrySize;
+  bool copyStack = distance > mEntrySize / 2;
+  int copyFromPos = copyStack ? lastStackStartPos : lastSampleStartPos;
+
+  addTag(mEntries[copyFromPos]);
+  if (!copyStack) {
+    addTag(ProfileEntry('t', (mozilla::TimeStamp::Now() - sStartTime).ToMilliseconds()));
+    addTag(ProfileEntry('D', 0));
+  }
 
   // Go through the whole entry and duplicate it, until we find the next one.
-  for (int readPos = (lastSampleStartPos + 1) % mEntrySize;
+  for (int readPos = (copyFromPos + 1) % mEntrySize;
        readPos != mWritePos;
        readPos = (readPos + 1) % mEntrySize) {
     switch (mEntries[readPos].mTagName) {
@@ -856,15 +905,26 @@ void ProfileBuffer::DuplicateLastSample(int aThreadId)
         return;
       case 't':
         // Copy with new time
-        addTag(ProfileEntry('t', (mozilla::TimeStamp::Now() - sStartTime).ToMilliseconds()));
+        if (copyStack) {
+          addTag(ProfileEntry('t', (mozilla::TimeStamp::Now() - sStartTime).ToMilliseconds()));
+        }
         break;
       case 'm':
         // Don't copy markers
         break;
+      case 'r':
+      case 'p':
+      case 'R':
+      case 'U':
+      case 'f':
+        addTag(mEntries[readPos]);
+        break;
       // Copy anything else we don't know about
       // L, B, S, c, s, d, l, f, h, r, t, p
       default:
-        addTag(mEntries[readPos]);
+        if (copyStack) {
+          addTag(mEntries[readPos]);
+        }
         break;
     }
   }
@@ -154,6 +154,46 @@ IOMarkerPayload::StreamPayload(SpliceableJSONWriter& aWriter, UniqueStacks& aUni
   }
 }
 
+GCMajorMarkerPayload::GCMajorMarkerPayload(const mozilla::TimeStamp& aStartTime,
+                                           const mozilla::TimeStamp& aEndTime,
+                                           const char* aTimings)
+  : ProfilerMarkerPayload(aStartTime, aEndTime)
+{
+  mTimings = aTimings ? strdup(aTimings) : nullptr;
+}
+
+GCMajorMarkerPayload::~GCMajorMarkerPayload()
+{
+  free(mTimings);
+}
+
+void
+GCMajorMarkerPayload::StreamPayload(SpliceableJSONWriter& aWriter,
+                                    UniqueStacks& aUniqueStacks)
+{
+  streamCommonProps("GCMajor", aWriter, aUniqueStacks);
+  if (mTimings) {
+    aWriter.StringProperty("timings", mTimings);
+  }
+}
+
+GCMinorMarkerPayload::GCMinorMarkerPayload(const mozilla::TimeStamp& aStartTime,
+                                           const mozilla::TimeStamp& aEndTime,
+                                           const char* aReason)
+  : ProfilerMarkerPayload(aStartTime, aEndTime)
+  , mReason(aReason)
+{
+  MOZ_ASSERT(aReason);
+}
+
+void
+GCMinorMarkerPayload::StreamPayload(SpliceableJSONWriter& aWriter,
+                                    UniqueStacks& aUniqueStacks)
+{
+  streamCommonProps("GCMinor", aWriter, aUniqueStacks);
+  aWriter.StringProperty("reason", mReason);
+}
+
 void
 ProfilerJSEventMarker(const char *event)
 {
@@ -86,6 +86,41 @@ private:
   TracingMetadata mMetaData;
 };
 
+/**
+ * A major GC, from the start of its first slice to the end of its last one.
+ * aTimings is the GC's JSON description (see JS::GCDescription::formatJSON),
+ * with the time spent in each phase and by the helper threads.
+ */
+class GCMajorMarkerPayload : public ProfilerMarkerPayload
+{
+public:
+  GCMajorMarkerPayload(const mozilla::TimeStamp& aStartTime,
+                       const mozilla::TimeStamp& aEndTime,
+                       const char* aTimings);
+  ~GCMajorMarkerPayload();
+
+  virtual void StreamPayload(SpliceableJSONWriter& aWriter,
+                             UniqueStacks& aUniqueStacks) override;
+
+private:
+  char* mTimings;
+};
+
+class GCMinorMarkerPayload : public ProfilerMarkerPayload
+{
+public:
+  // aReason must be a static string.
+  GCMinorMarkerPayload(const mozilla::TimeStamp& aStartTime,
+                       const mozilla::TimeStamp& aEndTime,
+                       const char* aReason);
+
+  virtual void StreamPayload(SpliceableJSONWriter& aWriter,
+                             UniqueStacks& aUniqueStacks) override;
+
+private:
+  const char* mReason;
+};
+
 
 #ifndef SPS_STANDALONE
 #include "gfxASurface.h"
@@ -74,6 +74,10 @@
 #include "mozilla/dom/ScriptSettings.h"
 #include "jsprf.h"
 #include "js/Debug.h"
+#include "GeckoProfiler.h"
+#ifdef MOZ_ENABLE_PROFILER_SPS
+#include "ProfilerMarkers.h"
+#endif
 #include "nsContentUtils.h"
 #include "nsCycleCollectionNoteRootCallback.h"
 #include "nsCycleCollectionParticipant.h"
@@ -818,6 +822,22 @@ CycleCollectedJSContext::GCSliceCallback(JSContext* aContext,
   CycleCollectedJSContext* self = CycleCollectedJSContext::Get();
   MOZ_ASSERT(self->Context() == aContext);
 
+#ifdef MOZ_ENABLE_PROFILER_SPS
+  if (aProgress == JS::GC_CYCLE_BEGIN) {
+    self->mGCCycleStart = profiler_is_active() ? TimeStamp::Now() : TimeStamp();
+  } else if (aProgress == JS::GC_CYCLE_END && !self->mGCCycleStart.IsNull()) {
+    if (profiler_is_active()) {
+      nsString json;
+      json.Adopt(aDesc.formatJSON(aContext, PR_Now()));
+      PROFILER_MARKER_PAYLOAD("GCMajor",
+                              new GCMajorMarkerPayload(self->mGCCycleStart,
+                                                       TimeStamp::Now(),
+                                                       NS_ConvertUTF16toUTF8(json).get()));
+    }
+    self->mGCCycleStart = TimeStamp();
+  }
+#endif
+
   if (aProgress == JS::GC_CYCLE_END) {
     JS::gcreason::Reason reason = aDesc.reason_;
     Unused <<
@@ -896,6 +916,21 @@ CycleCollectedJSContext::GCNurseryCollectionCallback(JSContext* aContext,
     timelines->AddMarkerForAllObservedDocShells(abstractMarker);
   }
 
+#ifdef MOZ_ENABLE_PROFILER_SPS
+  if (aProgress == JS::GCNurseryProgress::GC_NURSERY_COLLECTION_START) {
+    self->mNurseryCollectionStart =
+      profiler_is_active() ? TimeStamp::Now() : TimeStamp();
+  } else if (!self->mNurseryCollectionStart.IsNull()) {
+    if (profiler_is_active()) {
+      PROFILER_MARKER_PAYLOAD("GCMinor",
+                              new GCMinorMarkerPayload(self->mNurseryCollectionStart,
+                                                       TimeStamp::Now(),
+                                                       JS::gcreason::ExplainReason(aReason)));
+    }
+    self->mNurseryCollectionStart = TimeStamp();
+  }
+#endif
+
   if (self->mPrevGCNurseryCollectionCallback) {
     self->mPrevGCNurseryCollectionCallback(aContext, aProgress, aReason);
   }
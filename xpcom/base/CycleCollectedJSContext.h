@@ -13,6 +13,7 @@
 #include "mozilla/mozalloc.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/SegmentedVector.h"
+#include "mozilla/TimeStamp.h"
 #include "jsapi.h"
 #include "jsfriendapi.h"
 
@@ -436,6 +437,11 @@ private:
   JS::GCSliceCallback mPrevGCSliceCallback;
   JS::GCNurseryCollectionCallback mPrevGCNurseryCollectionCallback;
 
+  // Start times of the current major and minor GC, for profiler markers.
+  // Null when the profiler wasn't active when the GC started.
+  TimeStamp mGCCycleStart;
+  TimeStamp mNurseryCollectionStart;
+
   nsDataHashtable<nsPtrHashKey<void>, nsScriptObjectTracer*> mJSHolders;
 
   typedef nsDataHashtable<nsFuncPtrHashKey<DeferredFinalizeFunction>, void*>
@@ -0,0 +1,140 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/MemoryPressureCoordinator.h"
+
+#include "mozilla/Assertions.h"
+#include "mozilla/Logging.h"
+#include "mozilla/Preferences.h"
+#include "mozilla/SizePrintfMacros.h"
+#include "mozilla/StaticPtr.h"
+#include "nsTArray.h"
+#include "nsThreadUtils.h"
+
+namespace mozilla {
+namespace MemoryPressureCoordinator {
+
+static LazyLogModule sMemoryPressureLog("MemoryPressure");
+
+static StaticAutoPtr<nsTArray<MemoryReclaimer*>> sReclaimers;
+
+namespace {
+
+struct ReclaimCandidate
+{
+  MemoryReclaimer* mReclaimer;
+  uint32_t mCost;
+  size_t mReclaimable;
+};
+
+struct CheapestFirst
+{
+  bool Equals(const ReclaimCandidate& aA, const ReclaimCandidate& aB) const
+  {
+    return aA.mCost == aB.mCost && aA.mReclaimable == aB.mReclaimable;
+  }
+
+  // Among equally cheap reclaimers, ask the one holding the most first.
+  bool LessThan(const ReclaimCandidate& aA, const ReclaimCandidate& aB) const
+  {
+    if (aA.mCost != aB.mCost) {
+      return aA.mCost < aB.mCost;
+    }
+    return aA.mReclaimable > aB.mReclaimable;
+  }
+};
+
+} // anonymous namespace
+
+bool
+IsEnabled()
+{
+  return Preferences::GetBool("memory.pressure.coordinated", false);
+}
+
+void
+RegisterReclaimer(MemoryReclaimer* aReclaimer)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  if (!sReclaimers) {
+    sReclaimers = new nsTArray<MemoryReclaimer*>();
+  }
+  MOZ_ASSERT(!sReclaimers->Contains(aReclaimer));
+  sReclaimers->AppendElement(aReclaimer);
+}
+
+void
+UnregisterReclaimer(MemoryReclaimer* aReclaimer)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  if (!sReclaimers) {
+    return;
+  }
+  sReclaimers->RemoveElement(aReclaimer);
+  if (sReclaimers->IsEmpty()) {
+    sReclaimers = nullptr;
+  }
+}
+
+size_t
+Reclaim(size_t aTargetBytes)
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  if (!sReclaimers || aTargetBytes == 0) {
+    return 0;
+  }
+
+  // Sample every reclaimer up front so that the ordering doesn't change
+  // under us as earlier reclaimers free memory.
+  nsTArray<ReclaimCandidate> candidates(sReclaimers->Length());
+  for (MemoryReclaimer* reclaimer : *sReclaimers) {
+    size_t reclaimable = reclaimer->ReclaimableBytes();
+    if (reclaimable > 0) {
+      candidates.AppendElement(
+        ReclaimCandidate { reclaimer, reclaimer->RebuildCost(), reclaimable });
+    }
+  }
+  candidates.Sort(CheapestFirst());
+
+  size_t freed = 0;
+  for (const ReclaimCandidate& candidate : candidates) {
+    if (freed >= aTargetBytes) {
+      break;
+    }
+    size_t freedHere = candidate.mReclaimer->Reclaim(aTargetBytes - freed);
+    MOZ_LOG(sMemoryPressureLog, LogLevel::Debug,
+            ("Reclaimed %" PRIuSIZE " of %" PRIuSIZE " bytes from %s "
+             "(rebuild cost %u)",
+             freedHere, candidate.mReclaimable,
+             candidate.mReclaimer->ReclaimerName(), candidate.mCost));
+    freed += freedHere;
+  }
+
+  MOZ_LOG(sMemoryPressureLog, LogLevel::Info,
+          ("Reclaimed %" PRIuSIZE " bytes (target %" PRIuSIZE ")",
+           freed, aTargetBytes));
+  return freed;
+}
+
+size_t
+ReclaimForMemoryPressure(MemoryPressureState aState)
+{
+  switch (aState) {
+    case MemPressure_New:
+      return Reclaim(SIZE_MAX);
+    case MemPressure_Ongoing: {
+      uint32_t targetKB =
+        Preferences::GetUint("memory.pressure.ongoing_reclaim_kb", 16 * 1024);
+      return Reclaim(size_t(targetKB) * 1024);
+    }
+    case MemPressure_None:
+      break;
+  }
+  return 0;
+}
+
+} // namespace MemoryPressureCoordinator
+} // namespace mozilla
@@ -0,0 +1,72 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef mozilla_MemoryPressureCoordinator_h
+#define mozilla_MemoryPressureCoordinator_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nsMemoryPressure.h"
+
+namespace mozilla {
+
+// A cache that can give memory back on request.  Caches that register a
+// reclaimer with the MemoryPressureCoordinator are asked to free memory,
+// cheapest to rebuild first, until the coordinator's target is met, instead
+// of each one reacting to "memory-pressure" on its own.
+class MemoryReclaimer
+{
+public:
+  // Rough rebuild costs, for use as RebuildCost() values.  Reclaimers with a
+  // lower cost are asked to free memory first.
+  static const uint32_t kRebuildCostCheap = 10;      // e.g. redundant copies
+  static const uint32_t kRebuildCostRecompute = 50;  // e.g. decoded images
+  static const uint32_t kRebuildCostRefetch = 100;   // e.g. network data
+
+  // A short, static name for logging.
+  virtual const char* ReclaimerName() = 0;
+
+  // The number of bytes Reclaim() could currently free.
+  virtual size_t ReclaimableBytes() = 0;
+
+  // The relative cost of rebuilding what Reclaim() frees.
+  virtual uint32_t RebuildCost() = 0;
+
+  // Free at least |aBytes| bytes if possible, and return the number of bytes
+  // actually freed.  Must not register or unregister reclaimers.
+  virtual size_t Reclaim(size_t aBytes) = 0;
+
+protected:
+  virtual ~MemoryReclaimer() {}
+};
+
+namespace MemoryPressureCoordinator {
+
+// Whether coordinated reclamation is enabled ("memory.pressure.coordinated").
+// Caches should only register reclaimers if it is, and keep their own
+// all-or-nothing "memory-pressure" handling otherwise.
+bool IsEnabled();
+
+// Registration and reclamation are main-thread only.  A reclaimer must be
+// unregistered before it is destroyed.
+void RegisterReclaimer(MemoryReclaimer* aReclaimer);
+void UnregisterReclaimer(MemoryReclaimer* aReclaimer);
+
+// Ask registered reclaimers, cheapest first, to free memory until
+// |aTargetBytes| bytes have been freed or none are left to ask.  Returns the
+// number of bytes freed.
+size_t Reclaim(size_t aTargetBytes);
+
+// Reclaim memory for a memory pressure event.  A new memory pressure event
+// frees everything that can be freed; an ongoing one frees at most
+// "memory.pressure.ongoing_reclaim_kb" kilobytes.
+size_t ReclaimForMemoryPressure(MemoryPressureState aState);
+
+} // namespace MemoryPressureCoordinator
+} // namespace mozilla
+
+#endif // mozilla_MemoryPressureCoordinator_h
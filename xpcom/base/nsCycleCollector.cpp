@@ -153,6 +153,7 @@
 #include "base/process_util.h"
 
 #include "mozilla/ArrayUtils.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/AutoRestore.h"
 #include "mozilla/CycleCollectedJSContext.h"
 #include "mozilla/DebugOnly.h"
@@ -160,13 +161,16 @@
 /* This must occur *after* base/process_util.h to avoid typedefs conflicts. */
 #include "mozilla/LinkedList.h"
 #include "mozilla/MemoryReporting.h"
+#include "mozilla/Monitor.h"
 #include "mozilla/SegmentedVector.h"
+#include "mozilla/SharedThreadPool.h"
 
 #include "nsCycleCollectionParticipant.h"
 #include "nsCycleCollectionNoteRootCallback.h"
 #include "nsDeque.h"
 #include "nsCycleCollector.h"
 #include "nsThreadUtils.h"
+#include "nsXPCOMPrivate.h"
 #include "nsXULAppAPI.h"
 #include "prenv.h"
 #include "nsPrintfCString.h"
@@ -233,6 +237,9 @@ using namespace mozilla;
 // MOZ_CC_LOG_DIRECTORY: The directory in which logs are placed (such as
 // logs from MOZ_CC_LOG_ALL and MOZ_CC_LOG_SHUTDOWN, or other uses
 // of nsICycleCollectorListener)
+//
+// MOZ_CC_PARALLEL_SCAN: If defined, the main thread collector splits the
+// refcount checking of large graphs across helper threads.
 
 // Various parameters of this collector can be tuned using environment
 // variables.
@@ -244,12 +251,14 @@ struct nsCycleCollectorParams
   bool mAllTracesAll;
   bool mAllTracesShutdown;
   bool mLogThisThread;
+  bool mParallelScan;
 
   nsCycleCollectorParams() :
     mLogAll(PR_GetEnv("MOZ_CC_LOG_ALL") != nullptr),
     mLogShutdown(PR_GetEnv("MOZ_CC_LOG_SHUTDOWN") != nullptr),
     mAllTracesAll(false),
-    mAllTracesShutdown(false)
+    mAllTracesShutdown(false),
+    mParallelScan(PR_GetEnv("MOZ_CC_PARALLEL_SCAN") != nullptr)
   {
     const char* logThreadEnv = PR_GetEnv("MOZ_CC_LOG_THREAD");
     bool threadLogging = true;
@@ -774,6 +783,25 @@ public:
     PtrInfo*& mLast;
   };
 
+  // The nodes of a single block, for passes that can process each block
+  // independently.
+  struct BlockRange
+  {
+    PtrInfo* mBegin;
+    PtrInfo* mEnd;
+  };
+
+  void GetBlockRanges(nsTArray<BlockRange>& aRanges) const
+  {
+    for (NodeBlock* b = mBlocks; b; b = b->mNext) {
+      // Only the last block can be partially filled.
+      PtrInfo* end = b->mNext ? b->mEntries + NodeBlockSize : mLast;
+      if (end != b->mEntries) {
+        aRanges.AppendElement(BlockRange { b->mEntries, end });
+      }
+    }
+  }
+
   size_t SizeOfExcludingThis(MallocSizeOf aMallocSizeOf) const
   {
     // We don't measure the things pointed to by mEntries[] because those
@@ -3117,15 +3145,16 @@ nsCycleCollector::ScanIncrementalRoots()
   }
 }
 
-// Mark nodes white and make sure their refcounts are ok.
-// No nodes are marked black during this pass to ensure that refcount
-// checking is run on all nodes not marked black by ScanIncrementalRoots.
-void
-nsCycleCollector::ScanWhiteNodes(bool aFullySynchGraphBuild)
+// Mark nodes white and make sure their refcounts are ok, for the nodes in
+// [aBegin, aEnd). Returns the number of nodes marked white. This can run off
+// the main thread, so rather than crashing on a node with more internal
+// references than its refcount, it stops and returns that node in aBadNode.
+static uint32_t
+ScanWhiteNodesInRange(PtrInfo* aBegin, PtrInfo* aEnd,
+                      bool aFullySynchGraphBuild, PtrInfo** aBadNode)
 {
-  NodePool::Enumerator nodeEnum(mGraph.mNodes);
-  while (!nodeEnum.IsDone()) {
-    PtrInfo* pi = nodeEnum.GetNext();
+  uint32_t whiteNodeCount = 0;
+  for (PtrInfo* pi = aBegin; pi != aEnd; ++pi) {
     if (pi->mColor == black) {
       // Incremental roots can be in a nonsensical state, so don't
       // check them. This will miss checking nodes that are merely
@@ -3145,24 +3174,167 @@ nsCycleCollector::ScanWhiteNodes(bool aFullySynchGraphBuild)
 
     if (pi->mInternalRefs == pi->mRefCount || pi->IsGrayJS()) {
       pi->mColor = white;
-      ++mWhiteNodeCount;
+      ++whiteNodeCount;
       continue;
     }
 
     if (pi->mInternalRefs > pi->mRefCount) {
+      *aBadNode = pi;
+      break;
+    }
+
+    // This node will get marked black in the next pass.
+  }
+  return whiteNodeCount;
+}
+
+static void
+CrashOnExcessInternalRefs(PtrInfo* aPi)
+{
 #ifdef MOZ_CRASHREPORTER
-      const char* piName = "Unknown";
-      if (pi->mParticipant) {
-        piName = pi->mParticipant->ClassName();
-      }
-      nsPrintfCString msg("More references to an object than its refcount, for class %s", piName);
-      CrashReporter::AnnotateCrashReport(NS_LITERAL_CSTRING("CycleCollector"), msg);
+  const char* piName = "Unknown";
+  if (aPi->mParticipant) {
+    piName = aPi->mParticipant->ClassName();
+  }
+  nsPrintfCString msg("More references to an object than its refcount, for class %s", piName);
+  CrashReporter::AnnotateCrashReport(NS_LITERAL_CSTRING("CycleCollector"), msg);
 #endif
-      MOZ_CRASH();
+  MOZ_CRASH();
+}
+
+// The state shared by the threads of a parallel ScanWhiteNodes. The main
+// thread and the helpers claim blocks until none are left, so the main thread
+// finishes the scan by itself if the helpers are slow to start, or never do.
+class ParallelWhiteScan
+{
+public:
+  // Graphs smaller than this many blocks aren't worth waking helpers for.
+  static const size_t kMinBlocks = 4;
+  static const uint32_t kMaxHelpers = 3;
+
+  ParallelWhiteScan(const nsTArray<NodePool::BlockRange>& aRanges,
+                    bool aFullySynchGraphBuild)
+    : mMonitor("ParallelWhiteScan")
+    , mRanges(aRanges)
+    , mFullySynchGraphBuild(aFullySynchGraphBuild)
+    , mNextRange(0)
+    , mWhiteNodeCount(0)
+    , mBadNode(nullptr)
+    , mPendingHelpers(0)
+  {
+  }
+
+  // Returns false, having scanned nothing, if no helper threads are available.
+  bool Run(PtrInfo** aBadNode, uint32_t* aWhiteNodeCount)
+  {
+    MOZ_ASSERT(NS_IsMainThread());
+    RefPtr<SharedThreadPool> pool =
+      SharedThreadPool::Get(NS_LITERAL_CSTRING("CC Scan"), kMaxHelpers);
+    if (!pool) {
+      return false;
     }
 
-    // This node will get marked black in the next pass.
+    size_t helpers = mRanges.Length() - 1;
+    if (helpers > kMaxHelpers) {
+      helpers = kMaxHelpers;
+    }
+    for (size_t i = 0; i < helpers; ++i) {
+      {
+        MonitorAutoLock lock(mMonitor);
+        ++mPendingHelpers;
+      }
+      nsCOMPtr<nsIRunnable> r = NS_NewRunnableFunction([this] () {
+        ScanRanges();
+        HelperFinished();
+      });
+      if (NS_FAILED(pool->Dispatch(r.forget(), NS_DISPATCH_NORMAL))) {
+        HelperFinished();
+      }
+    }
+
+    ScanRanges();
+
+    MonitorAutoLock lock(mMonitor);
+    while (mPendingHelpers) {
+      lock.Wait();
+    }
+    *aBadNode = mBadNode;
+    *aWhiteNodeCount = mWhiteNodeCount;
+    return true;
+  }
+
+private:
+  void ScanRanges()
+  {
+    uint32_t whiteNodeCount = 0;
+    PtrInfo* badNode = nullptr;
+    size_t i;
+    while (!badNode && (i = mNextRange++) < mRanges.Length()) {
+      whiteNodeCount += ScanWhiteNodesInRange(mRanges[i].mBegin,
+                                              mRanges[i].mEnd,
+                                              mFullySynchGraphBuild,
+                                              &badNode);
+    }
+
+    MonitorAutoLock lock(mMonitor);
+    mWhiteNodeCount += whiteNodeCount;
+    if (badNode && !mBadNode) {
+      mBadNode = badNode;
+    }
+  }
+
+  void HelperFinished()
+  {
+    MonitorAutoLock lock(mMonitor);
+    if (--mPendingHelpers == 0) {
+      lock.Notify();
+    }
+  }
+
+  Monitor mMonitor;
+  const nsTArray<NodePool::BlockRange>& mRanges;
+  const bool mFullySynchGraphBuild;
+  Atomic<size_t> mNextRange;
+
+  // The following are protected by mMonitor.
+  uint32_t mWhiteNodeCount;
+  PtrInfo* mBadNode;
+  uint32_t mPendingHelpers;
+};
+
+// Mark nodes white and make sure their refcounts are ok.
+// No nodes are marked black during this pass to ensure that refcount
+// checking is run on all nodes not marked black by ScanIncrementalRoots.
+void
+nsCycleCollector::ScanWhiteNodes(bool aFullySynchGraphBuild)
+{
+  nsTArray<NodePool::BlockRange> ranges;
+  mGraph.mNodes.GetBlockRanges(ranges);
+
+  // Each node is checked and colored independently of the others, so large
+  // graphs can be split by block across helper threads. Helper threads aren't
+  // available once XPCOM's threads have been shut down.
+  PtrInfo* badNode = nullptr;
+  uint32_t whiteNodeCount = 0;
+  bool scanned = false;
+  if (mParams.mParallelScan && NS_IsMainThread() &&
+      ranges.Length() >= ParallelWhiteScan::kMinBlocks &&
+      !gXPCOMThreadsShutDown) {
+    ParallelWhiteScan scan(ranges, aFullySynchGraphBuild);
+    scanned = scan.Run(&badNode, &whiteNodeCount);
+  }
+
+  if (!scanned) {
+    for (size_t i = 0; i < ranges.Length() && !badNode; ++i) {
+      whiteNodeCount += ScanWhiteNodesInRange(ranges[i].mBegin, ranges[i].mEnd,
+                                              aFullySynchGraphBuild, &badNode);
+    }
+  }
+
+  if (badNode) {
+    CrashOnExcessInternalRefs(badNode);
   }
+  mWhiteNodeCount += whiteNodeCount;
 }
 
 // Any remaining grey nodes that haven't already been deleted must be alive,
@@ -72,15 +72,11 @@ GetProcSelfStatmField(int aField, int64_t* aN)
   return NS_ERROR_FAILURE;
 }
 
+// Sums the sizes on all the lines of /proc/self/smaps whose field name starts
+// with aField.
 static MOZ_MUST_USE nsresult
-GetProcSelfSmapsPrivate(int64_t* aN)
+SumProcSelfSmapsField(const char* aField, int64_t* aN)
 {
-  // You might be tempted to calculate USS by subtracting the "shared" value
-  // from the "resident" value in /proc/<pid>/statm. But at least on Linux,
-  // statm's "shared" value actually counts pages backed by files, which has
-  // little to do with whether the pages are actually shared. /proc/self/smaps
-  // on the other hand appears to give us the correct information.
-
   FILE* f = fopen("/proc/self/smaps", "r");
   if (NS_WARN_IF(!f)) {
     return NS_ERROR_UNEXPECTED;
@@ -103,17 +99,20 @@ GetProcSelfSmapsPrivate(int64_t* aN)
     char* end = buffer + bytes;
     char* ptr = buffer;
     end[carryOver] = '\0';
-    // We are looking for lines like "Private_{Clean,Dirty}: 4 kB".
-    while ((ptr = strstr(ptr, "Private"))) {
+    // We are looking for lines like "<aField>: 4 kB".
+    while ((ptr = strstr(ptr, aField))) {
       if (ptr >= end) {
         break;
       }
-      ptr += sizeof("Private_Xxxxx:");
-      amount += strtol(ptr, nullptr, 10);
+      ptr = strchr(ptr, ':');
+      if (!ptr) {
+        break;
+      }
+      amount += strtol(ptr + 1, &ptr, 10);
     }
     if (bytes < readSize) {
       // We do not expect any match within the end of the buffer.
-      MOZ_ASSERT(!strstr(end, "Private"));
+      MOZ_ASSERT(!strstr(end, aField));
       break;
     }
     // Carry the end of the buffer over to the beginning.
@@ -149,7 +148,20 @@ ResidentFastDistinguishedAmount(int64_t* aN)
 static MOZ_MUST_USE nsresult
 ResidentUniqueDistinguishedAmount(int64_t* aN)
 {
-  return GetProcSelfSmapsPrivate(aN);
+  // You might be tempted to calculate USS by subtracting the "shared" value
+  // from the "resident" value in /proc/<pid>/statm. But at least on Linux,
+  // statm's "shared" value actually counts pages backed by files, which has
+  // little to do with whether the pages are actually shared. /proc/self/smaps
+  // on the other hand appears to give us the correct information, in its
+  // "Private_{Clean,Dirty}" lines.
+  return SumProcSelfSmapsField("Private", aN);
+}
+
+#define HAVE_RESIDENT_HUGE_PAGES_REPORTER 1
+static MOZ_MUST_USE nsresult
+ResidentHugePagesAmount(int64_t* aN)
+{
+  return SumProcSelfSmapsField("AnonHugePages", aN);
 }
 
 #ifdef HAVE_MALLINFO
@@ -1107,6 +1119,32 @@ NS_IMPL_ISUPPORTS(ResidentUniqueReporter, nsIMemoryReporter)
 
 #endif // HAVE_RESIDENT_UNIQUE_REPORTER
 
+#ifdef HAVE_RESIDENT_HUGE_PAGES_REPORTER
+class ResidentHugePagesReporter final : public nsIMemoryReporter
+{
+  ~ResidentHugePagesReporter() {}
+
+public:
+  NS_DECL_ISUPPORTS
+
+  NS_IMETHOD CollectReports(nsIHandleReportCallback* aHandleReport,
+                            nsISupports* aData, bool aAnonymize) override
+  {
+    int64_t amount = 0;
+    if (NS_SUCCEEDED(ResidentHugePagesAmount(&amount))) {
+      MOZ_COLLECT_REPORT(
+        "resident-huge-pages", KIND_OTHER, UNITS_BYTES, amount,
+"Memory mapped by the process that is backed by transparent huge pages. The "
+"heap allocator (with MALLOC_OPTIONS=L) and the JS heap (with "
+"JS_GC_HUGE_PAGES set) can ask for huge pages, which reduce TLB misses.");
+    }
+    return NS_OK;
+  }
+};
+NS_IMPL_ISUPPORTS(ResidentHugePagesReporter, nsIMemoryReporter)
+
+#endif // HAVE_RESIDENT_HUGE_PAGES_REPORTER
+
 #ifdef HAVE_SYSTEM_HEAP_REPORTER
 
 class SystemHeapReporter final : public nsIMemoryReporter
@@ -1543,6 +1581,10 @@ nsMemoryReporterManager::Init()
   RegisterStrongReporter(new ResidentUniqueReporter());
 #endif
 
+#ifdef HAVE_RESIDENT_HUGE_PAGES_REPORTER
+  RegisterStrongReporter(new ResidentHugePagesReporter());
+#endif
+
 #ifdef HAVE_PAGE_FAULT_REPORTERS
   RegisterStrongReporter(new PageFaultsSoftReporter());
   RegisterStrongReporter(new PageFaultsHardReporter());
@@ -1794,24 +1836,104 @@ nsMemoryReporterManager::GetReportsForThisProcessExtended(
   mPendingReportersState = new PendingReportersState(
       aFinishReporting, aFinishReportingData, aDMDFile);
 
+  // By default every reporter gets its own main thread event, and they all
+  // run back-to-back.  With a slice budget, reporters are instead run in
+  // slices of at most (roughly) that many milliseconds, and only one slice is
+  // queued at a time, so that other main thread events (e.g. user input) can
+  // run in between when reports are gathered periodically.
+  uint32_t sliceBudgetMS =
+    Preferences::GetUint("memory.report_slice_budget_ms", 0);
+
   {
     mozilla::MutexAutoLock autoLock(mMutex);
 
-    for (auto iter = mStrongReporters->Iter(); !iter.Done(); iter.Next()) {
-      DispatchReporter(iter.Key(), iter.Data(),
-                       aHandleReport, aHandleReportData, aAnonymize);
-    }
+    if (sliceBudgetMS > 0) {
+      PendingReportersState* s = mPendingReportersState;
+      s->mSliceBudget = TimeDuration::FromMilliseconds(sliceBudgetMS);
+      s->mHandleReport = aHandleReport;
+      s->mHandleReportData = aHandleReportData;
+      s->mAnonymize = aAnonymize;
+
+      for (auto iter = mStrongReporters->Iter(); !iter.Done(); iter.Next()) {
+        PendingReportersState::SlicedReporter* entry =
+          s->mSlicedReporters.AppendElement();
+        entry->mReporter = iter.Key();
+        entry->mIsAsync = iter.Data();
+      }
+
+      for (auto iter = mWeakReporters->Iter(); !iter.Done(); iter.Next()) {
+        PendingReportersState::SlicedReporter* entry =
+          s->mSlicedReporters.AppendElement();
+        entry->mReporter = iter.Key();
+        entry->mIsAsync = iter.Data();
+      }
+    } else {
+      for (auto iter = mStrongReporters->Iter(); !iter.Done(); iter.Next()) {
+        DispatchReporter(iter.Key(), iter.Data(),
+                         aHandleReport, aHandleReportData, aAnonymize);
+      }
 
-    for (auto iter = mWeakReporters->Iter(); !iter.Done(); iter.Next()) {
-      nsCOMPtr<nsIMemoryReporter> reporter = iter.Key();
-      DispatchReporter(reporter, iter.Data(),
-                       aHandleReport, aHandleReportData, aAnonymize);
+      for (auto iter = mWeakReporters->Iter(); !iter.Done(); iter.Next()) {
+        nsCOMPtr<nsIMemoryReporter> reporter = iter.Key();
+        DispatchReporter(reporter, iter.Data(),
+                         aHandleReport, aHandleReportData, aAnonymize);
+      }
     }
   }
 
+  if (!mPendingReportersState->mSlicedReporters.IsEmpty()) {
+    // Every reporter counts as pending from the start, so that the report
+    // can't be finished by an async reporter before later slices have run.
+    mPendingReportersState->mReportsPending +=
+      mPendingReportersState->mSlicedReporters.Length();
+
+    RefPtr<nsMemoryReporterManager> self = this;
+    NS_DispatchToMainThread(NS_NewRunnableFunction(
+      [self] () { self->RunReporterSlice(); }));
+  }
+
   return NS_OK;
 }
 
+void
+nsMemoryReporterManager::RunReporterSlice()
+{
+  PendingReportersState* s = mPendingReportersState;
+  MOZ_ASSERT(s);
+
+  TimeStamp sliceStart = TimeStamp::Now();
+  TimeDuration budget = s->mSliceBudget;
+  nsCOMPtr<nsIHandleReportCallback> handleReport = s->mHandleReport;
+  nsCOMPtr<nsISupports> handleReportData = s->mHandleReportData;
+  bool anonymize = s->mAnonymize;
+
+  while (true) {
+    MOZ_ASSERT(s->mNextSlicedReporter < s->mSlicedReporters.Length());
+    PendingReportersState::SlicedReporter& entry =
+      s->mSlicedReporters[s->mNextSlicedReporter++];
+    nsCOMPtr<nsIMemoryReporter> reporter = entry.mReporter.forget();
+    bool isAsync = entry.mIsAsync;
+    bool isLast = s->mNextSlicedReporter == s->mSlicedReporters.Length();
+
+    reporter->CollectReports(handleReport, handleReportData, anonymize);
+    if (!isAsync) {
+      // This may finish the report and delete |s|.
+      EndReport();
+    }
+
+    if (isLast) {
+      return;
+    }
+
+    if (TimeStamp::Now() - sliceStart >= budget) {
+      RefPtr<nsMemoryReporterManager> self = this;
+      NS_DispatchToMainThread(NS_NewRunnableFunction(
+        [self] () { self->RunReporterSlice(); }));
+      return;
+    }
+  }
+}
+
 NS_IMETHODIMP
 nsMemoryReporterManager::EndReport()
 {
@@ -8,10 +8,12 @@
 #define nsMemoryReporterManager_h__
 
 #include "mozilla/Mutex.h"
+#include "mozilla/TimeStamp.h"
 #include "nsHashKeys.h"
 #include "nsIMemoryReporter.h"
 #include "nsITimer.h"
 #include "nsServiceManagerUtils.h"
+#include "nsTArray.h"
 #include "nsTHashtable.h"
 
 namespace mozilla {
@@ -195,6 +197,7 @@ private:
                         nsIHandleReportCallback* aHandleReport,
                         nsISupports* aHandleReportData,
                         bool aAnonymize);
+  void RunReporterSlice();
 
   static void TimeoutCallback(nsITimer* aTimer, void* aData);
   // Note: this timeout needs to be long enough to allow for the
@@ -256,6 +259,21 @@ private:
     // File handle to write a DMD report to if requested.
     FILE* mDMDFile;
 
+    // When reporters are run in time-budgeted slices (see
+    // "memory.report_slice_budget_ms"), the reporters still to be run and
+    // the arguments to run them with.  Empty otherwise.
+    struct SlicedReporter
+    {
+      nsCOMPtr<nsIMemoryReporter> mReporter;
+      bool mIsAsync;
+    };
+    nsTArray<SlicedReporter> mSlicedReporters;
+    size_t mNextSlicedReporter;
+    mozilla::TimeDuration mSliceBudget;
+    nsCOMPtr<nsIHandleReportCallback> mHandleReport;
+    nsCOMPtr<nsISupports> mHandleReportData;
+    bool mAnonymize;
+
     PendingReportersState(nsIFinishReportingCallback* aFinishReporting,
                         nsISupports* aFinishReportingData,
                         FILE* aDMDFile)
@@ -263,6 +281,8 @@ private:
       , mFinishReporting(aFinishReporting)
       , mFinishReportingData(aFinishReportingData)
       , mDMDFile(aDMDFile)
+      , mNextSlicedReporter(0)
+      , mAnonymize(false)
     {
     }
   };
@@ -99,6 +99,9 @@ Omnijar::InitOne(nsIFile* aPath, Type aType)
     }
   }
 
+  // Get the entries needed during startup inflated ahead of their first use.
+  zipReader->PreInflate();
+
   CleanUpOne(aType);
   sReader[aType] = zipReader;
   sOuterReader[aType] = outerReader;
@@ -9,6 +9,7 @@
 #include "mozilla/AbstractThread.h"
 #include "mozilla/Atomics.h"
 #include "mozilla/Poison.h"
+#include "mozilla/BackgroundScheduler.h"
 #include "mozilla/SharedThreadPool.h"
 #include "mozilla/XPCOM.h"
 #include "nsXULAppAPI.h"
@@ -715,7 +716,9 @@ NS_InitXPCOM2(nsIServiceManager** aResult,
   // to the directory service.
   nsDirectoryService::gService->RegisterCategoryProviders();
 
-  // Init SharedThreadPool (which needs the service manager).
+  // Init SharedThreadPool (which needs the service manager), and the
+  // scheduler it can run on.
+  BackgroundScheduler::InitStatics();
   SharedThreadPool::InitStatics();
 
   // Force layout to spin up so that nsContentUtils is available for cx stack
@@ -907,6 +910,10 @@ ShutdownXPCOM(nsIServiceManager* aServMgr)
     gXPCOMThreadsShutDown = true;
     NS_ProcessPendingEvents(thread);
 
+    // The SharedThreadPools, and so the pools on the scheduler's workers,
+    // were shut down by the notification above.
+    BackgroundScheduler::Shutdown();
+
     // Shutdown the timer thread and all timers that might still be alive before
     // shutting down the component manager
     nsTimerImpl::Shutdown();
@@ -69,6 +69,8 @@
 #include "nsArrayEnumerator.h"
 #include "nsStringEnumerator.h"
 #include "mozilla/FileUtils.h"
+#include "mozilla/HashFunctions.h"
+#include "mozilla/MathAlgorithms.h"
 #include "mozilla/UniquePtr.h"
 #include "nsDataHashtable.h"
 
@@ -284,6 +286,7 @@ nsComponentManagerImpl::nsComponentManagerImpl()
   : mFactories(CONTRACTID_HASHTABLE_INITIAL_LENGTH)
   , mContractIDs(CONTRACTID_HASHTABLE_INITIAL_LENGTH)
   , mLock("nsComponentManagerImpl.mLock")
+  , mStaticContractsMask(0)
   , mStatus(NOT_INITIALIZED)
 {
 }
@@ -356,6 +359,8 @@ nsComponentManagerImpl::Init()
     RegisterModule((*sStaticModules)[i], nullptr);
   }
 
+  BuildStaticContractIndex();
+
   bool loadChromeManifests = (XRE_GetProcessType() != GeckoProcessType_GPU);
   if (loadChromeManifests) {
     // The overall order in which chrome.manifests are expected to be treated
@@ -432,6 +437,98 @@ nsComponentManagerImpl::Init()
   return NS_OK;
 }
 
+void
+nsComponentManagerImpl::BuildStaticContractIndex()
+{
+  SafeMutexAutoLock lock(mLock);
+  MOZ_ASSERT(!mStaticContracts);
+
+  // Only the static modules have been registered so far.
+  uint32_t count = mContractIDs.Count();
+  if (!count) {
+    return;
+  }
+
+  // Keep the load factor at or below one half, so probe sequences are short.
+  uint32_t capacity = RoundUpPow2(count * 2);
+  mStaticContracts = MakeUnique<StaticContract[]>(capacity);
+  mStaticContractsMask = capacity - 1;
+
+  for (auto iter = mContractIDs.Iter(); !iter.Done(); iter.Next()) {
+    // The keys of mContractIDs live until Shutdown(), which also clears the
+    // index.
+    const nsCString& contractID = iter.Key();
+    uint32_t i = HashString(contractID.BeginReading(), contractID.Length()) &
+                 mStaticContractsMask;
+    while (mStaticContracts[i].mContractID) {
+      i = (i + 1) & mStaticContractsMask;
+    }
+    mStaticContracts[i].mContractID = contractID.BeginReading();
+    mStaticContracts[i].mContractIDLength = contractID.Length();
+    mStaticContracts[i].mEntry = iter.Data();
+  }
+}
+
+nsComponentManagerImpl::StaticContract*
+nsComponentManagerImpl::FindStaticContract(const char* aContractID,
+                                           uint32_t aContractIDLen)
+{
+  if (!mStaticContracts) {
+    return nullptr;
+  }
+
+  uint32_t i = HashString(aContractID, aContractIDLen) & mStaticContractsMask;
+  for (; mStaticContracts[i].mContractID; i = (i + 1) & mStaticContractsMask) {
+    StaticContract& contract = mStaticContracts[i];
+    if (contract.mContractIDLength == aContractIDLen &&
+        !memcmp(contract.mContractID, aContractID, aContractIDLen)) {
+      return &contract;
+    }
+  }
+  return nullptr;
+}
+
+nsComponentManagerImpl::StaticContract*
+nsComponentManagerImpl::LookupStaticContract(const char* aContractID,
+                                             uint32_t aContractIDLen)
+{
+  // The index itself is immutable once built, so only the atomic fields of
+  // its entries need care here.
+  StaticContract* contract =
+    FindStaticContract(aContractID, aContractIDLen);
+  if (!contract || contract->mOverridden) {
+    return nullptr;
+  }
+  return contract;
+}
+
+void
+nsComponentManagerImpl::NoteContractIDMappedLocked(const char* aContractID,
+                                                   nsFactoryEntry* aEntry)
+{
+  mLock.AssertCurrentThreadOwns();
+
+  StaticContract* contract =
+    FindStaticContract(aContractID, strlen(aContractID));
+  if (contract && contract->mEntry != aEntry) {
+    contract->mOverridden = true;
+    contract->mService = nullptr;
+  }
+}
+
+void
+nsComponentManagerImpl::PublishStaticServiceLocked(const char* aContractID,
+                                                   nsFactoryEntry* aEntry)
+{
+  mLock.AssertCurrentThreadOwns();
+
+  StaticContract* contract =
+    LookupStaticContract(aContractID, strlen(aContractID));
+  if (contract && contract->mEntry == aEntry) {
+    contract->mService = aEntry->mServiceObject.get();
+  }
+}
+
 static bool
 ProcessSelectorMatches(Module::ProcessSelector aSelector)
 {
@@ -568,6 +665,7 @@ nsComponentManagerImpl::RegisterContractIDLocked(
     return;
   }
 
+  NoteContractIDMappedLocked(aEntry->contractid, f);
   mContractIDs.Put(nsDependentCString(aEntry->contractid), f);
 }
 
@@ -781,6 +879,7 @@ nsComponentManagerImpl::ManifestContract(ManifestProcessingContext& aCx,
     return;
   }
 
+  NoteContractIDMappedLocked(contract, f);
   mContractIDs.Put(nsDependentCString(contract), f);
 }
 
@@ -874,6 +973,8 @@ nsresult nsComponentManagerImpl::Shutdown(void)
   UnregisterWeakMemoryReporter(this);
 
   // Release all cached factories
+  mStaticContracts = nullptr;
+  mStaticContractsMask = 0;
   mContractIDs.Clear();
   mFactories.Clear(); // XXX release the objects, don't just clear
   mLoaderMap.Clear();
@@ -931,6 +1032,11 @@ nsFactoryEntry*
 nsComponentManagerImpl::GetFactoryEntry(const char* aContractID,
                                         uint32_t aContractIDLen)
 {
+  if (StaticContract* contract =
+        LookupStaticContract(aContractID, aContractIDLen)) {
+    return contract->mEntry;
+  }
+
   SafeMutexAutoLock lock(mLock);
   return mContractIDs.Get(nsDependentCString(aContractID, aContractIDLen));
 }
@@ -1194,6 +1300,10 @@ nsComponentManagerImpl::FreeServices()
     return NS_ERROR_FAILURE;
   }
 
+  for (uint32_t i = 0; mStaticContracts && i <= mStaticContractsMask; ++i) {
+    mStaticContracts[i].mService = nullptr;
+  }
+
   for (auto iter = mFactories.Iter(); !iter.Done(); iter.Next()) {
     nsFactoryEntry* entry = iter.UserData();
     entry->mFactory = nullptr;
@@ -1421,11 +1531,7 @@ nsComponentManagerImpl::IsServiceInstantiatedByContractID(
   }
 
   nsresult rv = NS_ERROR_SERVICE_NOT_AVAILABLE;
-  nsFactoryEntry* entry;
-  {
-    SafeMutexAutoLock lock(mLock);
-    entry = mContractIDs.Get(nsDependentCString(aContractID));
-  }
+  nsFactoryEntry* entry = GetFactoryEntry(aContractID, strlen(aContractID));
 
   if (entry && entry->mServiceObject) {
     nsCOMPtr<nsISupports> service;
@@ -1455,6 +1561,15 @@ nsComponentManagerImpl::GetServiceByContractID(const char* aContractID,
     return NS_ERROR_UNEXPECTED;
   }
 
+  // Services registered by the static modules can be found without taking
+  // mLock once they've been created.
+  if (StaticContract* contract =
+        LookupStaticContract(aContractID, strlen(aContractID))) {
+    if (nsISupports* service = contract->mService) {
+      return service->QueryInterface(aIID, aResult);
+    }
+  }
+
   // `service` must be released after the lock is released, so it must be
   // declared before the lock in this C++ block.
   nsCOMPtr<nsISupports> service;
@@ -1472,6 +1587,7 @@ nsComponentManagerImpl::GetServiceByContractID(const char* aContractID,
     // and deadlock, e.g. bug 282743.
     // `entry` is valid until XPCOM shutdown, so we can safely use it after
     // exiting the lock.
+    PublishStaticServiceLocked(aContractID, entry);
     lock.Unlock();
     return entry->mServiceObject->QueryInterface(aIID, aResult);
   }
@@ -1545,6 +1661,7 @@ nsComponentManagerImpl::GetServiceByContractID(const char* aContractID,
   NS_ASSERTION(!entry->mServiceObject, "Created two instances of a service!");
 
   entry->mServiceObject = service.forget();
+  PublishStaticServiceLocked(aContractID, entry);
 
   lock.Unlock();
 
@@ -1591,6 +1708,7 @@ nsComponentManagerImpl::RegisterFactory(const nsCID& aClass,
       return NS_ERROR_FACTORY_NOT_REGISTERED;
     }
 
+    NoteContractIDMappedLocked(aContractID, oldf);
     mContractIDs.Put(nsDependentCString(aContractID), oldf);
     return NS_OK;
   }
@@ -1604,6 +1722,7 @@ nsComponentManagerImpl::RegisterFactory(const nsCID& aClass,
   }
 
   if (aContractID) {
+    NoteContractIDMappedLocked(aContractID, f);
     mContractIDs.Put(nsDependentCString(aContractID), f);
   }
 
@@ -1630,6 +1749,12 @@ nsComponentManagerImpl::UnregisterFactory(const nsCID& aClass,
 
     mFactories.Remove(aClass);
 
+    for (uint32_t i = 0; mStaticContracts && i <= mStaticContractsMask; ++i) {
+      if (mStaticContracts[i].mEntry == f) {
+        mStaticContracts[i].mService = nullptr;
+      }
+    }
+
     // This might leave a stale contractid -> factory mapping in
     // place, so null out the factory entry (see
     // nsFactoryEntry::GetFactory)
@@ -1789,6 +1914,7 @@ nsComponentManagerImpl::SizeOfIncludingThis(mozilla::MallocSizeOf aMallocSizeOf)
   }
 
   n += mContractIDs.ShallowSizeOfExcludingThis(aMallocSizeOf);
+  n += aMallocSizeOf(mStaticContracts.get());
   for (auto iter = mContractIDs.ConstIter(); !iter.Done(); iter.Next()) {
     // We don't measure the nsFactoryEntry data because it's owned by
     // mFactories (which is measured above).
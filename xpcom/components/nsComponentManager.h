@@ -20,6 +20,7 @@
 #include "mozilla/Module.h"
 #include "mozilla/ModuleLoader.h"
 #include "mozilla/Mutex.h"
+#include "mozilla/UniquePtr.h"
 #include "nsXULAppAPI.h"
 #include "nsNativeModuleLoader.h"
 #include "nsIFactory.h"
@@ -173,6 +174,36 @@ public:
 
   SafeMutex mLock;
 
+  // A read-only index of the contract IDs registered by the static modules,
+  // built once those have been registered at startup. Looking contract IDs up
+  // here doesn't need mLock, and the services they map to can be found
+  // without it once they've been created. Contract IDs that are later mapped
+  // to another factory are marked as overridden, and are then looked up in
+  // mContractIDs as usual.
+  struct StaticContract
+  {
+    const char* mContractID;
+    uint32_t mContractIDLength;
+    nsFactoryEntry* mEntry;
+    mozilla::Atomic<bool> mOverridden;
+    // Not a strong reference: mEntry->mServiceObject owns the service.
+    mozilla::Atomic<nsISupports*, mozilla::ReleaseAcquire> mService;
+  };
+  mozilla::UniquePtr<StaticContract[]> mStaticContracts;
+  uint32_t mStaticContractsMask;
+
+  void BuildStaticContractIndex();
+  StaticContract* FindStaticContract(const char* aContractID,
+                                     uint32_t aContractIDLen);
+  // Returns null if the contract ID isn't in the index, or was overridden.
+  StaticContract* LookupStaticContract(const char* aContractID,
+                                       uint32_t aContractIDLen);
+  // Mutex held
+  void NoteContractIDMappedLocked(const char* aContractID,
+                                  nsFactoryEntry* aEntry);
+  void PublishStaticServiceLocked(const char* aContractID,
+                                  nsFactoryEntry* aEntry);
+
   static void InitializeStaticModules();
   static void InitializeModuleLocations();
 
@@ -9,6 +9,7 @@
 #include "mozilla/HashFunctions.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/Mutex.h"
+#include "mozilla/PodOperations.h"
 #include "mozilla/DebugOnly.h"
 #include "mozilla/Unused.h"
 
@@ -38,8 +39,10 @@
 //   atoms ignore all AddRef/Release calls, which ensures they stay alive until
 //   |gAtomTable| itself is destroyed whereupon they are explicitly deleted.
 //
-//   Note that gAtomTable is used on multiple threads, and callers must
-//   acquire gAtomTableLock before touching it.
+//   Note that gAtomTable is used on multiple threads. It is split into
+//   sub-tables by hash, and callers must acquire a sub-table's lock before
+//   touching it. The main thread also keeps a small cache of StaticAtoms it
+//   has recently looked up, which it checks without locking anything.
 
 using namespace mozilla;
 
@@ -272,10 +275,14 @@ DynamicAtom::TransmuteToStatic(nsStringBuffer* aStringBuffer)
 /**
  * The shared hash table for atom lookups.
  *
- * Callers must hold gAtomTableLock before manipulating the table.
+ * Atoms are spread across kNumAtomSubTables sub-tables by the low bits of
+ * their hash, so threads atomizing different strings rarely contend. Callers
+ * must hold a sub-table's lock before manipulating it.
  */
-static PLDHashTable* gAtomTable;
-static Mutex* gAtomTableLock;
+static const uint32_t kNumAtomSubTables = 32;
+
+struct AtomSubTable;
+static AtomSubTable* gAtomTable;
 
 struct AtomTableKey
 {
@@ -345,25 +352,30 @@ AtomTableGetHash(const void* aKey)
 }
 
 static bool
-AtomTableMatchKey(const PLDHashEntryHdr* aEntry, const void* aKey)
+AtomMatchesKey(nsIAtom* aAtom, const AtomTableKey* aKey)
 {
-  const AtomTableEntry* he = static_cast<const AtomTableEntry*>(aEntry);
-  const AtomTableKey* k = static_cast<const AtomTableKey*>(aKey);
-
-  if (k->mUTF8String) {
+  if (aKey->mUTF8String) {
     return
-      CompareUTF8toUTF16(nsDependentCSubstring(k->mUTF8String,
-                                               k->mUTF8String + k->mLength),
-                         nsDependentAtomString(he->mAtom)) == 0;
+      CompareUTF8toUTF16(nsDependentCSubstring(aKey->mUTF8String,
+                                               aKey->mUTF8String + aKey->mLength),
+                         nsDependentAtomString(aAtom)) == 0;
   }
 
-  uint32_t length = he->mAtom->GetLength();
-  if (length != k->mLength) {
+  uint32_t length = aAtom->GetLength();
+  if (length != aKey->mLength) {
     return false;
   }
 
-  return memcmp(he->mAtom->GetUTF16String(),
-                k->mUTF16String, length * sizeof(char16_t)) == 0;
+  return memcmp(aAtom->GetUTF16String(),
+                aKey->mUTF16String, length * sizeof(char16_t)) == 0;
+}
+
+static bool
+AtomTableMatchKey(const PLDHashEntryHdr* aEntry, const void* aKey)
+{
+  const AtomTableEntry* he = static_cast<const AtomTableEntry*>(aEntry);
+  const AtomTableKey* k = static_cast<const AtomTableKey*>(aKey);
+  return AtomMatchesKey(he->mAtom, k);
 }
 
 static void
@@ -394,26 +406,88 @@ static const PLDHashTableOps AtomTableOps = {
   AtomTableInitEntry
 };
 
+// The atom table very quickly gets 10,000+ entries in it (or even 100,000+).
+// But choosing the best initial length has some subtleties: we add ~2700
+// static atoms to the table at start-up, and then we start adding and removing
+// dynamic atoms. If we make the table too big to start with, when the first
+// dynamic atom gets removed the load factor will be < 25% and so we will
+// shrink it to 4096 entries.
+//
+// By choosing an initial length of 4096, we get an initial capacity of 8192.
+// That's the biggest initial capacity that will let us be > 25% full when the
+// first dynamic atom is removed (when the count is ~2700), thus avoiding any
+// shrinking. Each sub-table gets its share of that.
+#define ATOM_HASHTABLE_INITIAL_LENGTH  4096
+
+struct AtomSubTable
+{
+  AtomSubTable()
+    : mLock("Atom Sub-Table Lock")
+    , mTable(&AtomTableOps, sizeof(AtomTableEntry),
+             ATOM_HASHTABLE_INITIAL_LENGTH / kNumAtomSubTables)
+  {
+  }
+
+  Mutex mLock;
+  PLDHashTable mTable;
+};
+
+static inline AtomSubTable&
+GetAtomSubTable(uint32_t aHash)
+{
+  return gAtomTable[aHash & (kNumAtomSubTables - 1)];
+}
+
+// Recently atomized StaticAtoms on the main thread, indexed by hash. Only
+// StaticAtoms are cached, because they live as long as the atom table does,
+// so a hit can be returned without taking any lock.
+static const uint32_t kRecentAtomCacheSize = 31;
+static nsIAtom* sRecentAtomCache[kRecentAtomCacheSize];
+
+static inline nsIAtom*
+GetRecentAtom(const AtomTableKey& aKey)
+{
+  if (!NS_IsMainThread()) {
+    return nullptr;
+  }
+  nsIAtom* atom = sRecentAtomCache[aKey.mHash % kRecentAtomCacheSize];
+  if (atom && atom->hash() == aKey.mHash && AtomMatchesKey(atom, &aKey)) {
+    return atom;
+  }
+  return nullptr;
+}
+
+static inline void
+AddRecentAtom(nsIAtom* aAtom)
+{
+  if (aAtom->IsStaticAtom() && NS_IsMainThread()) {
+    sRecentAtomCache[aAtom->hash() % kRecentAtomCacheSize] = aAtom;
+  }
+}
+
 //----------------------------------------------------------------------
 
 void
 DynamicAtom::GCAtomTable()
 {
-  MutexAutoLock lock(*gAtomTableLock);
   uint32_t removedCount = 0; // Use a non-atomic temporary for cheaper increments.
-  for (auto i = gAtomTable->Iter(); !i.Done(); i.Next()) {
-    auto entry = static_cast<AtomTableEntry*>(i.Get());
-    if (!entry->mAtom->IsStaticAtom()) {
-      auto atom = static_cast<DynamicAtom*>(entry->mAtom);
-      if (atom->mRefCnt == 0) {
-        i.Remove();
-        delete atom;
-        ++removedCount;
+  for (uint32_t t = 0; t < kNumAtomSubTables; ++t) {
+    AtomSubTable& table = gAtomTable[t];
+    MutexAutoLock lock(table.mLock);
+    for (auto i = table.mTable.Iter(); !i.Done(); i.Next()) {
+      auto entry = static_cast<AtomTableEntry*>(i.Get());
+      if (!entry->mAtom->IsStaticAtom()) {
+        auto atom = static_cast<DynamicAtom*>(entry->mAtom);
+        if (atom->mRefCnt == 0) {
+          i.Remove();
+          delete atom;
+          ++removedCount;
+        }
       }
     }
   }
 
-  // During the course of this function, the atom table is locked. This means
+  // An atom's sub-table is locked while it is looked at. This means
   // that, barring refcounting bugs in consumers, an atom can never go from
   // refcount == 0 to refcount != 0 during a GC. However, an atom _can_ go from
   // refcount != 0 to refcount == 0 if a Release() occurs in parallel with GC.
@@ -511,26 +585,11 @@ static StaticAtomTable* gStaticAtomTable = nullptr;
  */
 static bool gStaticAtomTableSealed = false;
 
-// The atom table very quickly gets 10,000+ entries in it (or even 100,000+).
-// But choosing the best initial length has some subtleties: we add ~2700
-// static atoms to the table at start-up, and then we start adding and removing
-// dynamic atoms. If we make the table too big to start with, when the first
-// dynamic atom gets removed the load factor will be < 25% and so we will
-// shrink it to 4096 entries.
-//
-// By choosing an initial length of 4096, we get an initial capacity of 8192.
-// That's the biggest initial capacity that will let us be > 25% full when the
-// first dynamic atom is removed (when the count is ~2700), thus avoiding any
-// shrinking.
-#define ATOM_HASHTABLE_INITIAL_LENGTH  4096
-
 void
 NS_InitAtomTable()
 {
   MOZ_ASSERT(!gAtomTable);
-  gAtomTable = new PLDHashTable(&AtomTableOps, sizeof(AtomTableEntry),
-                                ATOM_HASHTABLE_INITIAL_LENGTH);
-  gAtomTableLock = new Mutex("Atom Table Lock");
+  gAtomTable = new AtomSubTable[kNumAtomSubTables];
 }
 
 void
@@ -549,21 +608,24 @@ NS_ShutdownAtomTable()
   // XXXbholley: it would be good to assert gAtomTable->EntryCount() == 0
   // here, but that currently fails. Probably just a few things that need
   // to be fixed up.
-  delete gAtomTable;
+  PodArrayZero(sRecentAtomCache);
+  delete[] gAtomTable;
   gAtomTable = nullptr;
-  delete gAtomTableLock;
-  gAtomTableLock = nullptr;
 }
 
 void
 NS_SizeOfAtomTablesIncludingThis(MallocSizeOf aMallocSizeOf,
                                  size_t* aMain, size_t* aStatic)
 {
-  MutexAutoLock lock(*gAtomTableLock);
-  *aMain = gAtomTable->ShallowSizeOfIncludingThis(aMallocSizeOf);
-  for (auto iter = gAtomTable->Iter(); !iter.Done(); iter.Next()) {
-    auto entry = static_cast<AtomTableEntry*>(iter.Get());
-    *aMain += entry->mAtom->SizeOfIncludingThis(aMallocSizeOf);
+  *aMain = aMallocSizeOf(gAtomTable);
+  for (uint32_t t = 0; t < kNumAtomSubTables; ++t) {
+    AtomSubTable& table = gAtomTable[t];
+    MutexAutoLock lock(table.mLock);
+    *aMain += table.mTable.ShallowSizeOfExcludingThis(aMallocSizeOf);
+    for (auto iter = table.mTable.Iter(); !iter.Done(); iter.Next()) {
+      auto entry = static_cast<AtomTableEntry*>(iter.Get());
+      *aMain += entry->mAtom->SizeOfIncludingThis(aMallocSizeOf);
+    }
   }
 
   // The atoms pointed to by gStaticAtomTable are also pointed to by gAtomTable,
@@ -574,27 +636,18 @@ NS_SizeOfAtomTablesIncludingThis(MallocSizeOf aMallocSizeOf,
 }
 
 static inline AtomTableEntry*
-GetAtomHashEntry(const char* aString, uint32_t aLength, uint32_t* aHashOut)
-{
-  gAtomTableLock->AssertCurrentThreadOwns();
-  AtomTableKey key(aString, aLength, aHashOut);
-  // This is an infallible add.
-  return static_cast<AtomTableEntry*>(gAtomTable->Add(&key));
-}
-
-static inline AtomTableEntry*
-GetAtomHashEntry(const char16_t* aString, uint32_t aLength, uint32_t* aHashOut)
+GetAtomHashEntry(AtomSubTable& aTable, const AtomTableKey& aKey)
 {
-  gAtomTableLock->AssertCurrentThreadOwns();
-  AtomTableKey key(aString, aLength, aHashOut);
+  aTable.mLock.AssertCurrentThreadOwns();
   // This is an infallible add.
-  return static_cast<AtomTableEntry*>(gAtomTable->Add(&key));
+  return static_cast<AtomTableEntry*>(aTable.mTable.Add(&aKey));
 }
 
 void
 RegisterStaticAtoms(const nsStaticAtom* aAtoms, uint32_t aAtomCount)
 {
-  MutexAutoLock lock(*gAtomTableLock);
+  // Static atoms are only registered during startup, before other threads
+  // atomize anything, so gStaticAtomTable itself needs no lock.
   if (!gStaticAtomTable && !gStaticAtomTableSealed) {
     gStaticAtomTable = new StaticAtomTable();
   }
@@ -608,9 +661,11 @@ RegisterStaticAtoms(const nsStaticAtom* aAtoms, uint32_t aAtomCount)
     uint32_t stringLen = stringBuffer->StorageSize() / sizeof(char16_t) - 1;
 
     uint32_t hash;
-    AtomTableEntry* he =
-      GetAtomHashEntry(static_cast<char16_t*>(stringBuffer->Data()),
-                       stringLen, &hash);
+    AtomTableKey key(static_cast<char16_t*>(stringBuffer->Data()), stringLen,
+                     &hash);
+    AtomSubTable& table = GetAtomSubTable(hash);
+    MutexAutoLock lock(table.mLock);
+    AtomTableEntry* he = GetAtomHashEntry(table, key);
 
     nsIAtom* atom = he->mAtom;
     if (atom) {
@@ -644,14 +699,19 @@ NS_Atomize(const char* aUTF8String)
 already_AddRefed<nsIAtom>
 NS_Atomize(const nsACString& aUTF8String)
 {
-  MutexAutoLock lock(*gAtomTableLock);
   uint32_t hash;
-  AtomTableEntry* he = GetAtomHashEntry(aUTF8String.Data(),
-                                        aUTF8String.Length(),
-                                        &hash);
+  AtomTableKey key(aUTF8String.Data(), aUTF8String.Length(), &hash);
+  if (nsIAtom* recent = GetRecentAtom(key)) {
+    return do_AddRef(recent);
+  }
+
+  AtomSubTable& table = GetAtomSubTable(hash);
+  MutexAutoLock lock(table.mLock);
+  AtomTableEntry* he = GetAtomHashEntry(table, key);
 
   if (he->mAtom) {
     nsCOMPtr<nsIAtom> atom = he->mAtom;
+    AddRecentAtom(atom);
 
     return atom.forget();
   }
@@ -677,14 +737,19 @@ NS_Atomize(const char16_t* aUTF16String)
 already_AddRefed<nsIAtom>
 NS_Atomize(const nsAString& aUTF16String)
 {
-  MutexAutoLock lock(*gAtomTableLock);
   uint32_t hash;
-  AtomTableEntry* he = GetAtomHashEntry(aUTF16String.Data(),
-                                        aUTF16String.Length(),
-                                        &hash);
+  AtomTableKey key(aUTF16String.Data(), aUTF16String.Length(), &hash);
+  if (nsIAtom* recent = GetRecentAtom(key)) {
+    return do_AddRef(recent);
+  }
+
+  AtomSubTable& table = GetAtomSubTable(hash);
+  MutexAutoLock lock(table.mLock);
+  AtomTableEntry* he = GetAtomHashEntry(table, key);
 
   if (he->mAtom) {
     nsCOMPtr<nsIAtom> atom = he->mAtom;
+    AddRecentAtom(atom);
 
     return atom.forget();
   }
@@ -699,8 +764,12 @@ nsrefcnt
 NS_GetNumberOfAtoms(void)
 {
   DynamicAtom::GCAtomTable(); // Trigger a GC so that we return a deterministic result.
-  MutexAutoLock lock(*gAtomTableLock);
-  return gAtomTable->EntryCount();
+  nsrefcnt count = 0;
+  for (uint32_t t = 0; t < kNumAtomSubTables; ++t) {
+    MutexAutoLock lock(gAtomTable[t].mLock);
+    count += gAtomTable[t].mTable.EntryCount();
+  }
+  return count;
 }
 
 nsIAtom*
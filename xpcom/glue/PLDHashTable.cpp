@@ -16,6 +16,11 @@
 #include "mozilla/Likely.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/ChaosMode.h"
+#include "mozilla/SSE.h"
+
+#ifdef MOZILLA_PRESUME_SSE2
+#include <emmintrin.h>
+#endif
 
 using namespace mozilla;
 
@@ -123,8 +128,13 @@ PLDHashTable::StubOps()
 }
 
 static bool
-SizeOfEntryStore(uint32_t aCapacity, uint32_t aEntrySize, uint32_t* aNbytes)
+SizeOfEntryStore(uint32_t aCapacity, uint32_t aEntrySize, uint8_t aFlags,
+                 uint32_t* aNbytes)
 {
+  // GroupProbing tables have a control byte per entry after the entries.
+  if (aFlags & PLDHashTable::GroupProbing) {
+    aEntrySize++;
+  }
   uint64_t nbytes64 = uint64_t(aCapacity) * uint64_t(aEntrySize);
   *aNbytes = aCapacity * aEntrySize;
   return uint64_t(*aNbytes) == nbytes64;   // returns false on overflow
@@ -151,20 +161,29 @@ MinLoad(uint32_t aCapacity)
   return aCapacity >> 2;                // == aCapacity * 0.25
 }
 
+static inline uint32_t
+MinCapacity(uint8_t aFlags)
+{
+  if (aFlags & PLDHashTable::GroupProbing) {
+    return PLDHashTable::kGroupSize;
+  }
+  return PLDHashTable::kMinCapacity;
+}
+
 // Compute the minimum capacity (and the Log2 of that capacity) for a table
 // containing |aLength| elements while respecting the following contraints:
 // - table must be at most 75% full;
 // - capacity must be a power of two;
-// - capacity cannot be too small.
+// - capacity cannot be smaller than |aMinCapacity|.
 static inline void
-BestCapacity(uint32_t aLength, uint32_t* aCapacityOut,
+BestCapacity(uint32_t aLength, uint32_t aMinCapacity, uint32_t* aCapacityOut,
              uint32_t* aLog2CapacityOut)
 {
   // Compute the smallest capacity allowing |aLength| elements to be inserted
   // without rehashing.
   uint32_t capacity = (aLength * 4 + (3 - 1)) / 3; // == ceil(aLength * 4 / 3)
-  if (capacity < PLDHashTable::kMinCapacity) {
-    capacity = PLDHashTable::kMinCapacity;
+  if (capacity < aMinCapacity) {
+    capacity = aMinCapacity;
   }
 
   // Round up capacity to next power-of-two.
@@ -177,17 +196,18 @@ BestCapacity(uint32_t aLength, uint32_t* aCapacityOut,
 }
 
 /* static */ MOZ_ALWAYS_INLINE uint32_t
-PLDHashTable::HashShift(uint32_t aEntrySize, uint32_t aLength)
+PLDHashTable::HashShift(uint32_t aEntrySize, uint32_t aLength,
+                        uint8_t aFlags)
 {
   if (aLength > kMaxInitialLength) {
     MOZ_CRASH("Initial length is too large");
   }
 
   uint32_t capacity, log2;
-  BestCapacity(aLength, &capacity, &log2);
+  BestCapacity(aLength, MinCapacity(aFlags), &capacity, &log2);
 
   uint32_t nbytes;
-  if (!SizeOfEntryStore(capacity, aEntrySize, &nbytes)) {
+  if (!SizeOfEntryStore(capacity, aEntrySize, aFlags, &nbytes)) {
     MOZ_CRASH("Initial entry store size is too large");
   }
 
@@ -196,9 +216,10 @@ PLDHashTable::HashShift(uint32_t aEntrySize, uint32_t aLength)
 }
 
 PLDHashTable::PLDHashTable(const PLDHashTableOps* aOps, uint32_t aEntrySize,
-                           uint32_t aLength)
+                           uint32_t aLength, uint8_t aFlags)
   : mOps(aOps)
-  , mHashShift(HashShift(aEntrySize, aLength))
+  , mHashShift(HashShift(aEntrySize, aLength, aFlags))
+  , mFlags(aFlags)
   , mEntrySize(aEntrySize)
   , mEntryCount(0)
   , mRemovedCount(0)
@@ -219,12 +240,13 @@ PLDHashTable::operator=(PLDHashTable&& aOther)
   // Destruct |this|.
   this->~PLDHashTable();
 
-  // |mOps| and |mEntrySize| are const so we can't assign them. Instead, we
-  // require that they are equal. The justification for this is that they're
-  // conceptually part of the type -- indeed, if PLDHashTable was a templated
-  // type like nsTHashtable, they *would* be part of the type -- so it only
-  // makes sense to assign in cases where they match.
+  // |mOps|, |mFlags| and |mEntrySize| are const so we can't assign them.
+  // Instead, we require that they are equal. The justification for this is
+  // that they're conceptually part of the type -- indeed, if PLDHashTable was
+  // a templated type like nsTHashtable, they *would* be part of the type -- so
+  // it only makes sense to assign in cases where they match.
   MOZ_RELEASE_ASSERT(mOps == aOther.mOps);
+  MOZ_RELEASE_ASSERT(mFlags == aOther.mFlags);
   MOZ_RELEASE_ASSERT(mEntrySize == aOther.mEntrySize);
 
   // Move non-const pieces over.
@@ -316,9 +338,10 @@ PLDHashTable::ClearAndPrepareForLength(uint32_t aLength)
   // Get these values before the destructor clobbers them.
   const PLDHashTableOps* ops = mOps;
   uint32_t entrySize = mEntrySize;
+  uint8_t flags = mFlags;
 
   this->~PLDHashTable();
-  new (KnownNotNull, this) PLDHashTable(ops, entrySize, aLength);
+  new (KnownNotNull, this) PLDHashTable(ops, entrySize, aLength, flags);
 }
 
 void
@@ -440,6 +463,116 @@ PLDHashTable::FindFreeEntry(PLDHashNumber aKeyHash)
   // NOTREACHED
 }
 
+// With GroupProbing, each entry has a control byte: kControlFree,
+// kControlRemoved, or for live entries a tag made from the key hash with the
+// high bit set. Probing visits aligned groups of kGroupSize control bytes, in
+// triangular-number steps (which visit every group, because the number of
+// groups is a power of two), and stops at the first group with a free entry.
+//
+// A removed entry can be marked free rather than removed if its group still
+// has a free entry: no probe has ever moved past such a group.
+static const uint8_t kControlFree = 0;
+static const uint8_t kControlRemoved = 1;
+
+static MOZ_ALWAYS_INLINE uint8_t
+ControlTag(PLDHashNumber aKeyHash)
+{
+  // The high bits of the key hash pick the first group, so take the tag from
+  // a remix of the whole hash rather than from them.
+  return uint8_t((aKeyHash * 0x85EBCA6BU) >> 25) | 0x80;
+}
+
+// Returns a bitmask of the control bytes in the group at |aGroup| that are
+// equal to |aControl|.
+static MOZ_ALWAYS_INLINE uint32_t
+MatchGroup(const uint8_t* aGroup, uint8_t aControl)
+{
+#ifdef MOZILLA_PRESUME_SSE2
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aGroup));
+  __m128i control = _mm_set1_epi8(char(aControl));
+  return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(group, control)));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < 16; ++i) {
+    mask |= uint32_t(aGroup[i] == aControl) << i;
+  }
+  return mask;
+#endif
+}
+
+// Like SearchTable(), but for GroupProbing tables.
+template <PLDHashTable::SearchReason Reason>
+PLDHashEntryHdr* NS_FASTCALL
+PLDHashTable::SearchGroups(const void* aKey, PLDHashNumber aKeyHash,
+                           uint32_t* aIndexOut)
+{
+  MOZ_ASSERT(mEntryStore.Get());
+
+  const uint8_t* control = ControlBytes();
+  uint32_t groupMask = (CapacityFromHashShift() - 1) & ~(kGroupSize - 1);
+  uint32_t group = Hash1(aKeyHash) & groupMask;
+  uint8_t tag = ControlTag(aKeyHash);
+  PLDHashMatchEntry matchEntry = mOps->matchEntry;
+
+  // The first removed entry seen, so Add() can recycle it. (Only used if
+  // Reason==ForAdd.)
+  uint32_t firstRemoved = UINT32_MAX;
+
+  for (uint32_t step = kGroupSize; ; step += kGroupSize) {
+    for (uint32_t matches = MatchGroup(control + group, tag); matches;
+         matches &= matches - 1) {
+      uint32_t index = group + CountTrailingZeroes32(matches);
+      PLDHashEntryHdr* entry = AddressEntry(index);
+      if (entry->mKeyHash == aKeyHash && matchEntry(entry, aKey)) {
+        *aIndexOut = index;
+        return entry;
+      }
+    }
+
+    if (Reason == ForAdd && firstRemoved == UINT32_MAX) {
+      uint32_t removed = MatchGroup(control + group, kControlRemoved);
+      if (removed) {
+        firstRemoved = group + CountTrailingZeroes32(removed);
+      }
+    }
+
+    uint32_t freeMask = MatchGroup(control + group, kControlFree);
+    if (freeMask) {
+      if (Reason == ForAdd) {
+        *aIndexOut = firstRemoved != UINT32_MAX
+                   ? firstRemoved
+                   : group + CountTrailingZeroes32(freeMask);
+        return AddressEntry(*aIndexOut);
+      }
+      return nullptr;
+    }
+
+    group = (group + step) & groupMask;
+  }
+
+  // NOTREACHED
+  return nullptr;
+}
+
+// Like FindFreeEntry(), but for GroupProbing tables.
+uint32_t
+PLDHashTable::FindFreeIndexInGroups(PLDHashNumber aKeyHash)
+{
+  MOZ_ASSERT(mEntryStore.Get());
+
+  const uint8_t* control = ControlBytes();
+  uint32_t groupMask = (CapacityFromHashShift() - 1) & ~(kGroupSize - 1);
+  uint32_t group = Hash1(aKeyHash) & groupMask;
+
+  for (uint32_t step = kGroupSize; ; step += kGroupSize) {
+    uint32_t freeMask = MatchGroup(control + group, kControlFree);
+    if (freeMask) {
+      return group + CountTrailingZeroes32(freeMask);
+    }
+    group = (group + step) & groupMask;
+  }
+}
+
 bool
 PLDHashTable::ChangeTable(int32_t aDeltaLog2)
 {
@@ -454,7 +587,7 @@ PLDHashTable::ChangeTable(int32_t aDeltaLog2)
   }
 
   uint32_t nbytes;
-  if (!SizeOfEntryStore(newCapacity, mEntrySize, &nbytes)) {
+  if (!SizeOfEntryStore(newCapacity, mEntrySize, mFlags, &nbytes)) {
     return false;   // overflowed
   }
 
@@ -481,7 +614,14 @@ PLDHashTable::ChangeTable(int32_t aDeltaLog2)
     PLDHashEntryHdr* oldEntry = (PLDHashEntryHdr*)oldEntryAddr;
     if (EntryIsLive(oldEntry)) {
       oldEntry->mKeyHash &= ~kCollisionFlag;
-      PLDHashEntryHdr* newEntry = FindFreeEntry(oldEntry->mKeyHash);
+      PLDHashEntryHdr* newEntry;
+      if (UsesGroupProbing()) {
+        uint32_t index = FindFreeIndexInGroups(oldEntry->mKeyHash);
+        ControlBytes()[index] = ControlTag(oldEntry->mKeyHash);
+        newEntry = AddressEntry(index);
+      } else {
+        newEntry = FindFreeEntry(oldEntry->mKeyHash);
+      }
       NS_ASSERTION(EntryIsFree(newEntry), "EntryIsFree(newEntry)");
       moveEntry(this, oldEntry, newEntry);
       newEntry->mKeyHash = oldEntry->mKeyHash;
@@ -510,6 +650,21 @@ PLDHashTable::ComputeKeyHash(const void* aKey)
   return keyHash;
 }
 
+MOZ_ALWAYS_INLINE PLDHashEntryHdr*
+PLDHashTable::SearchForKey(const void* aKey)
+{
+  if (!mEntryStore.Get()) {
+    return nullptr;
+  }
+
+  PLDHashNumber keyHash = ComputeKeyHash(aKey);
+  if (UsesGroupProbing()) {
+    uint32_t index;
+    return SearchGroups<ForSearchOrRemove>(aKey, keyHash, &index);
+  }
+  return SearchTable<ForSearchOrRemove>(aKey, keyHash);
+}
+
 PLDHashEntryHdr*
 PLDHashTable::Search(const void* aKey)
 {
@@ -517,11 +672,7 @@ PLDHashTable::Search(const void* aKey)
   AutoReadOp op(mChecker);
 #endif
 
-  PLDHashEntryHdr* entry = mEntryStore.Get()
-                         ? SearchTable<ForSearchOrRemove>(aKey,
-                                                          ComputeKeyHash(aKey))
-                         : nullptr;
-  return entry;
+  return SearchForKey(aKey);
 }
 
 PLDHashEntryHdr*
@@ -536,7 +687,7 @@ PLDHashTable::Add(const void* aKey, const mozilla::fallible_t&)
     uint32_t nbytes;
     // We already checked this in the constructor, so it must still be true.
     MOZ_RELEASE_ASSERT(SizeOfEntryStore(CapacityFromHashShift(), mEntrySize,
-                                        &nbytes));
+                                        mFlags, &nbytes));
     mEntryStore.Set((char*)malloc(nbytes));
     if (!mEntryStore.Get()) {
       return nullptr;
@@ -568,17 +719,28 @@ PLDHashTable::Add(const void* aKey, const mozilla::fallible_t&)
   // Look for entry after possibly growing, so we don't have to add it,
   // then skip it while growing the table and re-add it after.
   PLDHashNumber keyHash = ComputeKeyHash(aKey);
-  PLDHashEntryHdr* entry = SearchTable<ForAdd>(aKey, keyHash);
+  PLDHashEntryHdr* entry;
+  uint32_t index;
+  if (UsesGroupProbing()) {
+    entry = SearchGroups<ForAdd>(aKey, keyHash, &index);
+  } else {
+    entry = SearchTable<ForAdd>(aKey, keyHash);
+  }
   if (!EntryIsLive(entry)) {
     // Initialize the entry, indicating that it's no longer free.
     if (EntryIsRemoved(entry)) {
       mRemovedCount--;
-      keyHash |= kCollisionFlag;
+      if (!UsesGroupProbing()) {
+        keyHash |= kCollisionFlag;
+      }
     }
     if (mOps->initEntry) {
       mOps->initEntry(entry, aKey);
     }
     entry->mKeyHash = keyHash;
+    if (UsesGroupProbing()) {
+      ControlBytes()[index] = ControlTag(keyHash);
+    }
     mEntryCount++;
   }
 
@@ -593,7 +755,8 @@ PLDHashTable::Add(const void* aKey)
     if (!mEntryStore.Get()) {
       // We OOM'd while allocating the initial entry storage.
       uint32_t nbytes;
-      (void) SizeOfEntryStore(CapacityFromHashShift(), mEntrySize, &nbytes);
+      (void) SizeOfEntryStore(CapacityFromHashShift(), mEntrySize, mFlags,
+                              &nbytes);
       NS_ABORT_OOM(nbytes);
     } else {
       // We failed to resize the existing entry storage, either due to OOM or
@@ -613,10 +776,7 @@ PLDHashTable::Remove(const void* aKey)
   AutoWriteOp op(mChecker);
 #endif
 
-  PLDHashEntryHdr* entry = mEntryStore.Get()
-                         ? SearchTable<ForSearchOrRemove>(aKey,
-                                                          ComputeKeyHash(aKey))
-                         : nullptr;
+  PLDHashEntryHdr* entry = SearchForKey(aKey);
   if (entry) {
     RawRemove(entry);
     ShrinkIfAppropriate();
@@ -649,7 +809,19 @@ PLDHashTable::RawRemove(PLDHashEntryHdr* aEntry)
   // Load keyHash first in case clearEntry() goofs it.
   PLDHashNumber keyHash = aEntry->mKeyHash;
   mOps->clearEntry(this, aEntry);
-  if (keyHash & kCollisionFlag) {
+  if (UsesGroupProbing()) {
+    uint32_t index =
+      (reinterpret_cast<char*>(aEntry) - mEntryStore.Get()) / mEntrySize;
+    uint8_t* control = ControlBytes();
+    if (MatchGroup(control + (index & ~(kGroupSize - 1)), kControlFree)) {
+      control[index] = kControlFree;
+      MarkEntryFree(aEntry);
+    } else {
+      control[index] = kControlRemoved;
+      MarkEntryRemoved(aEntry);
+      mRemovedCount++;
+    }
+  } else if (keyHash & kCollisionFlag) {
     MarkEntryRemoved(aEntry);
     mRemovedCount++;
   } else {
@@ -665,10 +837,11 @@ void
 PLDHashTable::ShrinkIfAppropriate()
 {
   uint32_t capacity = Capacity();
+  uint32_t minCapacity = MinCapacity(mFlags);
   if (mRemovedCount >= capacity >> 2 ||
-      (capacity > kMinCapacity && mEntryCount <= MinLoad(capacity))) {
+      (capacity > minCapacity && mEntryCount <= MinLoad(capacity))) {
     uint32_t log2;
-    BestCapacity(mEntryCount, &capacity, &log2);
+    BestCapacity(mEntryCount, minCapacity, &capacity, &log2);
 
     int32_t deltaLog2 = log2 - (kHashBits - mHashShift);
     MOZ_ASSERT(deltaLog2 <= 0);
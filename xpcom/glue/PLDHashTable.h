@@ -204,8 +204,21 @@ private:
 // and use it after an add or remove operation, unless you sample Generation()
 // before adding or removing, and compare the sample after, dereferencing the
 // entry pointer only if Generation() has not changed.
+//
+// A table can instead be created with the GroupProbing flag. It then keeps a
+// byte per entry in a separate control array, holding a few bits of each live
+// entry's hash, and probes that array a group of 16 entries at a time (with
+// SSE2 where available). Entries are only touched when their control byte
+// matches, which helps tables whose lookups often miss or whose entries are
+// large. It costs one extra byte per entry.
 class PLDHashTable
 {
+public:
+  enum Flags : uint8_t
+  {
+    GroupProbing = 1 << 0,
+  };
+
 private:
   // This class maintains the invariant that every time the entry store is
   // changed, the generation is updated.
@@ -239,6 +252,7 @@ private:
 
   const PLDHashTableOps* const mOps;  // Virtual operations; see below.
   int16_t             mHashShift;     // Multiplicative hash shift.
+  const uint8_t       mFlags;         // Flags passed to the constructor.
   const uint32_t      mEntrySize;     // Number of bytes in an entry.
   uint32_t            mEntryCount;    // Number of entries in table.
   uint32_t            mRemovedCount;  // Removed entry sentinels in table.
@@ -259,6 +273,10 @@ public:
 
   static const uint32_t kMinCapacity = 8;
 
+  // The number of control bytes probed at once with GroupProbing, which is
+  // also the minimum capacity of such tables.
+  static const uint32_t kGroupSize = 16;
+
   // Making this half of kMaxCapacity ensures it'll fit. Nobody should need an
   // initial length anywhere nearly this large, anyway.
   static const uint32_t kMaxInitialLength = kMaxCapacity / 2;
@@ -275,12 +293,13 @@ public:
   //
   // This will crash if |aEntrySize| and/or |aLength| are too large.
   PLDHashTable(const PLDHashTableOps* aOps, uint32_t aEntrySize,
-               uint32_t aLength = kDefaultInitialLength);
+               uint32_t aLength = kDefaultInitialLength, uint8_t aFlags = 0);
 
   PLDHashTable(PLDHashTable&& aOther)
-      // These two fields are |const|. Initialize them here because the
+      // These three fields are |const|. Initialize them here because the
       // move assignment operator cannot modify them.
     : mOps(aOther.mOps)
+    , mFlags(aOther.mFlags)
     , mEntrySize(aOther.mEntrySize)
       // Initialize this field because it is required for a safe call to the
       // destructor, which the move assignment operator does.
@@ -495,7 +514,8 @@ private:
   static const uint32_t kHashBits = 32;
   static const uint32_t kGoldenRatio = 0x9E3779B9U;
 
-  static uint32_t HashShift(uint32_t aEntrySize, uint32_t aLength);
+  static uint32_t HashShift(uint32_t aEntrySize, uint32_t aLength,
+                            uint8_t aFlags);
 
   static const PLDHashNumber kCollisionFlag = 1;
 
@@ -544,6 +564,26 @@ private:
 
   PLDHashEntryHdr* FindFreeEntry(PLDHashNumber aKeyHash);
 
+  bool UsesGroupProbing() const { return mFlags & GroupProbing; }
+
+  // The control bytes follow the entries in the entry store.
+  uint8_t* ControlBytes()
+  {
+    return reinterpret_cast<uint8_t*>(mEntryStore.Get()) +
+           CapacityFromHashShift() * mEntrySize;
+  }
+
+  // The GroupProbing equivalents of SearchTable() and FindFreeEntry(). They
+  // also return the index of the entry, for updating its control byte.
+  template <SearchReason Reason>
+  PLDHashEntryHdr* NS_FASTCALL
+    SearchGroups(const void* aKey, PLDHashNumber aKeyHash,
+                 uint32_t* aIndexOut);
+
+  uint32_t FindFreeIndexInGroups(PLDHashNumber aKeyHash);
+
+  PLDHashEntryHdr* SearchForKey(const void* aKey);
+
   bool ChangeTable(int aDeltaLog2);
 
   void ShrinkIfAppropriate();
@@ -0,0 +1,177 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef nsCopyOnWriteArray_h___
+#define nsCopyOnWriteArray_h___
+
+#include "mozilla/MemoryReporting.h"
+#include "mozilla/Move.h"
+#include "mozilla/RefPtr.h"
+#include "nsISupportsImpl.h"
+#include "nsTArray.h"
+
+/**
+ * An nsTArray whose copies share their elements until one of them is
+ * modified. Copying an nsCopyOnWriteArray only takes a reference to the
+ * shared storage; the elements are copied when EnsureMutable() is called on
+ * an array whose storage is shared. This suits large, read-mostly arrays that
+ * are handed around by value. Empty arrays don't allocate any storage.
+ *
+ * The elements are read through the const nsTArray returned by Array() (or
+ * the forwarding accessors below), and modified through the nsTArray returned
+ * by EnsureMutable(). The storage's refcount is threadsafe, so copies may be
+ * passed to other threads, but as with nsTArray a single array mustn't be
+ * used on several threads at once.
+ *
+ * @see nsTArray
+ */
+template<class E>
+class nsCopyOnWriteArray
+{
+public:
+  typedef nsTArray<E> array_type;
+  typedef typename array_type::elem_type elem_type;
+  typedef typename array_type::index_type index_type;
+  typedef typename array_type::size_type size_type;
+  typedef typename array_type::const_iterator const_iterator;
+
+  nsCopyOnWriteArray() {}
+
+  explicit nsCopyOnWriteArray(array_type&& aArray)
+  {
+    Assign(mozilla::Move(aArray));
+  }
+
+  explicit nsCopyOnWriteArray(const array_type& aArray)
+    : mStorage(aArray.IsEmpty() ? nullptr : new Storage(aArray))
+  {
+  }
+
+  // Copies share storage with the original.
+  nsCopyOnWriteArray(const nsCopyOnWriteArray& aOther) = default;
+  nsCopyOnWriteArray& operator=(const nsCopyOnWriteArray& aOther) = default;
+
+  const array_type& Array() const
+  {
+    return mStorage ? mStorage->mArray : mEmptyArray;
+  }
+  operator const array_type&() const { return Array(); }
+
+  size_type Length() const { return Array().Length(); }
+  bool IsEmpty() const { return Array().IsEmpty(); }
+  const elem_type* Elements() const { return Array().Elements(); }
+
+  const elem_type& ElementAt(index_type aIndex) const
+  {
+    return Array().ElementAt(aIndex);
+  }
+
+  const elem_type& operator[](index_type aIndex) const
+  {
+    return ElementAt(aIndex);
+  }
+
+  template<class Item>
+  bool Contains(const Item& aItem) const { return Array().Contains(aItem); }
+
+  template<class Item>
+  index_type IndexOf(const Item& aItem) const { return Array().IndexOf(aItem); }
+
+  const_iterator begin() const { return Array().begin(); }
+  const_iterator end() const { return Array().end(); }
+
+  // Whether other nsCopyOnWriteArrays share this array's storage.
+  bool IsShared() const { return mStorage && mStorage->IsShared(); }
+
+  // Copies that share storage compare equal without comparing elements.
+  bool operator==(const nsCopyOnWriteArray& aOther) const
+  {
+    return mStorage == aOther.mStorage || Array() == aOther.Array();
+  }
+  bool operator!=(const nsCopyOnWriteArray& aOther) const
+  {
+    return !operator==(aOther);
+  }
+
+  // Returns the array for modification, copying its elements first if the
+  // storage is shared. The result must not be used after this
+  // nsCopyOnWriteArray has been copied, as the copy would see the changes.
+  array_type& EnsureMutable()
+  {
+    if (!mStorage) {
+      mStorage = new Storage();
+    } else if (mStorage->IsShared()) {
+      mStorage = new Storage(Array());
+    }
+    return mStorage->mArray;
+  }
+
+  // Replaces the elements without copying the old ones, even if they're
+  // shared.
+  void Assign(array_type&& aArray)
+  {
+    if (aArray.IsEmpty()) {
+      Clear();
+    } else if (!mStorage || mStorage->IsShared()) {
+      mStorage = new Storage(mozilla::Move(aArray));
+    } else {
+      mStorage->mArray = mozilla::Move(aArray);
+    }
+  }
+
+  void Clear() { mStorage = nullptr; }
+
+  // As with nsStringBuffer, shared storage isn't counted by
+  // ShallowSizeOfExcludingThisIfUnshared(), so that it isn't counted once per
+  // copy. The owner that should be charged for shared storage can use
+  // ShallowSizeOfExcludingThisEvenIfShared() instead.
+  size_t
+  ShallowSizeOfExcludingThisIfUnshared(mozilla::MallocSizeOf aMallocSizeOf) const
+  {
+    if (IsShared()) {
+      return 0;
+    }
+    return ShallowSizeOfExcludingThisEvenIfShared(aMallocSizeOf);
+  }
+
+  size_t
+  ShallowSizeOfExcludingThisEvenIfShared(mozilla::MallocSizeOf aMallocSizeOf) const
+  {
+    if (!mStorage) {
+      return 0;
+    }
+    return aMallocSizeOf(mStorage.get()) +
+           Array().ShallowSizeOfExcludingThis(aMallocSizeOf);
+  }
+
+private:
+  struct Storage
+  {
+    NS_INLINE_DECL_THREADSAFE_REFCOUNTING(Storage)
+
+    Storage() {}
+    explicit Storage(array_type&& aArray) : mArray(mozilla::Move(aArray)) {}
+    explicit Storage(const array_type& aArray) : mArray(aArray) {}
+
+    // Only meaningful to an owner of the storage: with a single reference,
+    // no other thread can take another one.
+    bool IsShared() const { return mRefCnt > 1; }
+
+    array_type mArray;
+
+  private:
+    ~Storage() {}
+  };
+
+  // Null while the array is empty.
+  RefPtr<Storage> mStorage;
+
+  // Returned by Array() while there is no storage. It never holds elements,
+  // so it doesn't allocate either.
+  array_type mEmptyArray;
+};
+
+#endif // nsCopyOnWriteArray_h___
@@ -51,6 +51,15 @@ CancelableRunnable::Cancel()
   return NS_OK;
 }
 
+NS_IMPL_ISUPPORTS_INHERITED(IdleRunnable, CancelableRunnable,
+                            nsIIdleRunnable)
+
+void
+IdleRunnable::SetDeadline(TimeStamp aDeadline)
+{
+  mDeadline = aDeadline;
+}
+
 #endif  // XPCOM_GLUE_AVOID_NSPR
 
 //-----------------------------------------------------------------------------
@@ -165,6 +174,28 @@ NS_DispatchToCurrentThread(already_AddRefed<nsIRunnable>&& aEvent)
   return rv;
 }
 
+#ifdef MOZILLA_INTERNAL_API
+nsresult
+NS_IdleDispatchToCurrentThread(already_AddRefed<nsIRunnable>&& aEvent)
+{
+  nsCOMPtr<nsIRunnable> event(aEvent);
+  nsThread* thread = nsThreadManager::get().GetCurrentThread();
+  if (!thread) {
+    return NS_ERROR_UNEXPECTED;
+  }
+  // To keep us from leaking the runnable if dispatch method fails,
+  // we grab the reference on failures and release it.
+  nsIRunnable* temp = event.get();
+  nsresult rv = thread->IdleDispatch(event.forget());
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    // IdleDispatch() leaked the reference to the event, but we are on the
+    // same thread as the dispatch target, so it's safe to release it here.
+    NS_RELEASE(temp);
+  }
+  return rv;
+}
+#endif
+
 // It is common to call NS_DispatchToCurrentThread with a newly
 // allocated runnable with a refcount of zero. To keep us from leaking
 // the runnable if the dispatch method fails, we take a death grip.
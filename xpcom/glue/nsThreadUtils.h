@@ -14,6 +14,7 @@
 #include "nsIThread.h"
 #include "nsIRunnable.h"
 #include "nsICancelableRunnable.h"
+#include "nsIIdleRunnable.h"
 #include "nsStringGlue.h"
 #include "nsCOMPtr.h"
 #include "nsAutoPtr.h"
@@ -112,6 +113,22 @@ extern nsresult NS_DispatchToCurrentThread(nsIRunnable* aEvent);
 extern nsresult
 NS_DispatchToCurrentThread(already_AddRefed<nsIRunnable>&& aEvent);
 
+#ifdef MOZILLA_INTERNAL_API
+/**
+ * Dispatch the given event to the idle queue of the current thread, so that
+ * it runs once the thread has nothing else to do.  See
+ * nsThread::IdleDispatch.
+ *
+ * @param aEvent
+ *   The event to dispatch.
+ *
+ * @returns NS_ERROR_INVALID_ARG
+ *   If event is null.
+ */
+extern nsresult
+NS_IdleDispatchToCurrentThread(already_AddRefed<nsIRunnable>&& aEvent);
+#endif
+
 /**
  * Dispatch the given event to the main thread.
  *
@@ -258,6 +275,30 @@ private:
   CancelableRunnable& operator=(const CancelableRunnable&&) = delete;
 };
 
+// This class is designed to be a base class for runnables that are dispatched
+// with NS_IdleDispatchToCurrentThread and want to know how long they may run.
+class IdleRunnable : public CancelableRunnable,
+                     public nsIIdleRunnable
+{
+public:
+  NS_DECL_ISUPPORTS_INHERITED
+  // nsIIdleRunnable
+  virtual void SetDeadline(TimeStamp aDeadline) override;
+
+  IdleRunnable() {}
+
+protected:
+  virtual ~IdleRunnable() {}
+
+  // The time by which the runnable should have finished, or null if it
+  // hasn't been told one.
+  TimeStamp mDeadline;
+private:
+  IdleRunnable(const IdleRunnable&) = delete;
+  IdleRunnable& operator=(const IdleRunnable&) = delete;
+  IdleRunnable& operator=(const IdleRunnable&&) = delete;
+};
+
 namespace detail {
 
 // An event that can be used to call a C++11 functions or function objects,
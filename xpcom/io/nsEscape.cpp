@@ -8,6 +8,8 @@
 
 #include "mozilla/ArrayUtils.h"
 #include "mozilla/BinarySearch.h"
+#include "mozilla/SSE.h"
+#include "nsEscapeImpl.h"
 #include "nsTArray.h"
 #include "nsCRT.h"
 #include "plstr.h"
@@ -365,6 +367,29 @@ static uint16_t dontNeedEscape(uint16_t aChar, uint32_t aFlags)
     (EscapeChars[(uint32_t)aChar]  & aFlags) : 0;
 }
 
+/**
+ * Returns the length of a leading run of characters that dontNeedEscape()
+ * accepts for every URL part, or 0 when no vectorized scan is available.
+ * Only worth calling for runs of at least 16 characters.
+ */
+static inline size_t
+SafeURLCharsLength(const unsigned char* aBegin, const unsigned char* aEnd)
+{
+#ifdef MOZILLA_MAY_SUPPORT_SSE2
+  if (mozilla::supports_sse2()) {
+    return mozilla::SSE2::SafeURLCharsLength(
+      reinterpret_cast<const char*>(aBegin),
+      reinterpret_cast<const char*>(aEnd));
+  }
+#endif
+  return 0;
+}
+static inline size_t
+SafeURLCharsLength(const char16_t* aBegin, const char16_t* aEnd)
+{
+  return 0;
+}
+
 //----------------------------------------------------------------------------------------
 
 /**
@@ -405,8 +430,32 @@ T_EscapeURL(const typename T::char_type* aPart, size_t aPartLen,
   typename T::char_type tempBuffer[100];
   unsigned int tempBufferPos = 0;
 
+  // Letters, digits and !$&()*+,-_~ are copied verbatim whenever any part
+  // bit is set (or graphic ASCII is ignored), so long runs of them can be
+  // skipped without going through the per-character checks below.
+  bool skipSafeRuns = (aFlags & esc_Minimal) || ignoreAscii;
+
   bool previousIsNonASCII = false;
   for (size_t i = 0; i < aPartLen; ++i) {
+    if (skipSafeRuns && aPartLen - i >= 16) {
+      size_t run = SafeURLCharsLength(src, src + (aPartLen - i));
+      if (run) {
+        if (writing) {
+          if (!aResult.Append(tempBuffer, tempBufferPos, fallible) ||
+              !aResult.Append(aPart + i, run, fallible)) {
+            return NS_ERROR_OUT_OF_MEMORY;
+          }
+          tempBufferPos = 0;
+        }
+        src += run;
+        i += run;
+        previousIsNonASCII = false;
+        if (i == aPartLen) {
+          break;
+        }
+      }
+    }
+
     unsigned_char_type c = *src++;
 
     // if the char has not to be escaped or whatever follows % is
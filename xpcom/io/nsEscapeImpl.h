@@ -0,0 +1,25 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef nsEscapeImpl_h__
+#define nsEscapeImpl_h__
+
+#include <stddef.h>
+
+namespace mozilla {
+namespace SSE2 {
+
+/**
+ * Returns the length of the leading run of [aBegin, aEnd) made only of
+ * characters that no URL part ever escapes: ASCII letters, digits and
+ * !$&()*+,-_~.
+ */
+size_t SafeURLCharsLength(const char* aBegin, const char* aEnd);
+
+} // namespace SSE2
+} // namespace mozilla
+
+#endif
@@ -0,0 +1,59 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <emmintrin.h>
+
+#include "mozilla/MathAlgorithms.h"
+#include "nsEscapeImpl.h"
+
+namespace mozilla {
+namespace SSE2 {
+
+// Lanes of aX in [aLow, aHigh]. SSE2 only has signed byte compares, so the
+// range is shifted to start at -128 and tested with a single compare.
+static inline __m128i
+InRange(__m128i aX, char aLow, char aHigh)
+{
+  __m128i shifted = _mm_add_epi8(aX, _mm_set1_epi8(char(0x80 - aLow)));
+  return _mm_cmplt_epi8(shifted,
+                        _mm_set1_epi8(char(0x80 + (aHigh - aLow) + 1)));
+}
+
+static inline __m128i
+Equals(__m128i aX, char aChar)
+{
+  return _mm_cmpeq_epi8(aX, _mm_set1_epi8(aChar));
+}
+
+size_t
+SafeURLCharsLength(const char* aBegin, const char* aEnd)
+{
+  const char* p = aBegin;
+  while (aEnd - p >= 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+    // OR-ing in 0x20 folds 'A'-'Z' onto 'a'-'z' and maps nothing else there.
+    __m128i safe = InRange(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+    safe = _mm_or_si128(safe, InRange(x, '0', '9'));
+    safe = _mm_or_si128(safe, InRange(x, '(', '-'));
+    safe = _mm_or_si128(safe, Equals(x, '!'));
+    safe = _mm_or_si128(safe, Equals(x, '$'));
+    safe = _mm_or_si128(safe, Equals(x, '&'));
+    safe = _mm_or_si128(safe, Equals(x, '_'));
+    safe = _mm_or_si128(safe, Equals(x, '~'));
+
+    uint32_t unsafe = ~uint32_t(_mm_movemask_epi8(safe)) & 0xffff;
+    if (unsafe) {
+      return (p - aBegin) + CountTrailingZeroes32(unsafe);
+    }
+    p += 16;
+  }
+  // The tail is left to the caller's scalar loop.
+  return p - aBegin;
+}
+
+} // namespace SSE2
+} // namespace mozilla
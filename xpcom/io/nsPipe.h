@@ -17,8 +17,27 @@
   {0x91,0x18,0xb3,0xae,0x97,0xa7,0xc7,0x58}  \
 }
 
+class nsIInputStream;
+class nsIOutputStream;
+
 // Generic factory constructor for the nsPipe class
 nsresult
 nsPipeConstructor(nsISupports* outer, REFNSIID iid, void** result);
 
+// Returns true if aSource is a pipe input stream and aSink a pipe output
+// stream, so NS_MovePipeSegments may be able to move data between them.
+bool
+NS_CanMovePipeSegments(nsIInputStream* aSource, nsIOutputStream* aSink);
+
+// Moves complete, unread segments from the pipe behind aSource into the pipe
+// behind aSink by handing over the segment buffers instead of copying their
+// contents.  This only happens while aSource is the only reader of its pipe,
+// both pipes use the same segment size and aSink's current segment is full;
+// the caller must be the only writer of aSink.  Moves whole segments up to
+// aMaxCount bytes, but at least one if possible, and returns the number of
+// bytes moved.  Whatever is left (e.g. a partial segment) has to be copied.
+uint32_t
+NS_MovePipeSegments(nsIInputStream* aSource, nsIOutputStream* aSink,
+                    uint32_t aMaxCount);
+
 #endif  // !defined(nsPipe_h__)
@@ -23,6 +23,8 @@
 #include "nsMemory.h"
 #include "nsIAsyncInputStream.h"
 #include "nsIAsyncOutputStream.h"
+#include "nsPipe.h"
+#include "nsQueryObject.h"
 
 using namespace mozilla;
 
@@ -38,6 +40,14 @@ static LazyLogModule sPipeLog("nsPipe");
 #define DEFAULT_SEGMENT_SIZE  4096
 #define DEFAULT_SEGMENT_COUNT 16
 
+// IIDs to recognize pipe ends in NS_MovePipeSegments; not exposed to XPIDL.
+#define NS_PIPEINPUTSTREAM_IID \
+{ 0x7c8a2b10, 0xbad7, 0x4155, \
+  { 0x96, 0x04, 0x36, 0xba, 0xe5, 0xee, 0xb4, 0x81 } }
+#define NS_PIPEOUTPUTSTREAM_IID \
+{ 0xbb17c39c, 0xbe50, 0x4f3e, \
+  { 0xb7, 0xa0, 0x48, 0xa9, 0xe1, 0x92, 0x14, 0x27 } }
+
 class nsPipe;
 class nsPipeEvents;
 class nsPipeInputStream;
@@ -148,6 +158,7 @@ class nsPipeInputStream final
   , public nsIBufferedInputStream
 {
 public:
+  NS_DECLARE_STATIC_IID_ACCESSOR(NS_PIPEINPUTSTREAM_IID)
   NS_DECL_THREADSAFE_ISUPPORTS
   NS_DECL_NSIINPUTSTREAM
   NS_DECL_NSIASYNCINPUTSTREAM
@@ -210,6 +221,11 @@ public:
   // A version of Status() that doesn't acquire the monitor.
   nsresult Status(const ReentrantMonitorAutoEnter& ev) const;
 
+  // Detaches the next segment of the pipe if it can be handed to another
+  // pipe without copying; see NS_MovePipeSegments.  The caller owns the
+  // returned buffer.
+  char* TakeSegment(uint32_t aSegmentSize);
+
 private:
   virtual ~nsPipeInputStream();
 
@@ -244,6 +260,7 @@ public:
   // of the entire pipe.  this macro is just convenience since it does not
   // declare a mRefCount variable; however, don't let the name fool you...
   // we are not inheriting from nsPipe ;-)
+  NS_DECLARE_STATIC_IID_ACCESSOR(NS_PIPEOUTPUTSTREAM_IID)
   NS_DECL_ISUPPORTS_INHERITED
 
   NS_DECL_NSIOUTPUTSTREAM
@@ -275,6 +292,12 @@ public:
   MonitorAction OnOutputWritable(nsPipeEvents&);
   MonitorAction OnOutputException(nsresult, nsPipeEvents&);
 
+  // Appends a full segment taken from another pipe with TakeSegment; see
+  // NS_MovePipeSegments.  Takes ownership of aSegment on success.
+  uint32_t SegmentSize();
+  bool CanAdoptSegment(uint32_t aSegmentSize);
+  nsresult AdoptSegment(char* aSegment, uint32_t aSegmentSize);
+
 private:
   nsPipe*                         mPipe;
 
@@ -332,6 +355,11 @@ private:
   nsresult GetWriteSegment(char*& aSegment, uint32_t& aSegmentLen);
   void     AdvanceWriteCursor(uint32_t aCount);
 
+  // segment hand-over between pipes, see NS_MovePipeSegments
+  char*    TakeReadSegment(nsPipeReadState& aReadState, uint32_t aSegmentSize);
+  bool     CanAdoptWriteSegment(uint32_t aSegmentSize);
+  nsresult AdoptWriteSegment(char* aSegment, uint32_t aSegmentSize);
+
   void     OnInputStreamException(nsPipeInputStream* aStream, nsresult aReason);
   void     OnPipeException(nsresult aReason, bool aOutputOnly = false);
 
@@ -374,6 +402,9 @@ private:
   bool                mInited;
 };
 
+NS_DEFINE_STATIC_IID_ACCESSOR(nsPipeInputStream, NS_PIPEINPUTSTREAM_IID)
+NS_DEFINE_STATIC_IID_ACCESSOR(nsPipeOutputStream, NS_PIPEOUTPUTSTREAM_IID)
+
 //-----------------------------------------------------------------------------
 
 // RAII class representing an active read segment.  When it goes out of scope
@@ -897,6 +928,86 @@ nsPipe::AdvanceWriteCursor(uint32_t aBytesWritten)
   }
 }
 
+char*
+nsPipe::TakeReadSegment(nsPipeReadState& aReadState, uint32_t aSegmentSize)
+{
+  nsPipeEvents events;
+  char* segment;
+  {
+    ReentrantMonitorAutoEnter mon(mReentrantMonitor);
+
+    // Only hand over a segment no one else can still read from: it must be
+    // complete (the writer has moved on to a later segment), entirely
+    // unread, and this must be the pipe's only input stream.
+    if (mInputList.Length() != 1 ||
+        &mInputList[0]->ReadState() != &aReadState ||
+        aReadState.mActiveRead || aReadState.mSegment != 0 ||
+        mWriteSegment < 1 || mBuffer.GetSegmentSize() != aSegmentSize ||
+        aReadState.mReadCursor != mBuffer.GetSegment(0)) {
+      return nullptr;
+    }
+    MOZ_ASSERT(aReadState.mReadLimit == aReadState.mReadCursor + aSegmentSize);
+    MOZ_ASSERT(aReadState.mAvailable >= aSegmentSize);
+
+    LOG(("III taking first segment\n"));
+    segment = mBuffer.TakeFirstSegment();
+    mWriteSegment -= 1;
+    aReadState.mAvailable -= aSegmentSize;
+
+    // advance read cursor and limit to the next segment, which exists since
+    // the writer had moved past the one we took
+    aReadState.mReadCursor = mBuffer.GetSegment(0);
+    if (mWriteSegment == 0) {
+      aReadState.mReadLimit = mWriteCursor;
+    } else {
+      aReadState.mReadLimit = aReadState.mReadCursor + aSegmentSize;
+    }
+
+    if (mOutput.OnOutputWritable(events) == NotifyMonitor) {
+      mon.NotifyAll();
+    }
+  }
+  return segment;
+}
+
+bool
+nsPipe::CanAdoptWriteSegment(uint32_t aSegmentSize)
+{
+  ReentrantMonitorAutoEnter mon(mReentrantMonitor);
+  return NS_SUCCEEDED(mStatus) &&
+         mBuffer.GetSegmentSize() == aSegmentSize &&
+         mWriteCursor == mWriteLimit &&
+         mBuffer.GetSize() < mBuffer.GetMaxSize();
+}
+
+nsresult
+nsPipe::AdoptWriteSegment(char* aSegment, uint32_t aSegmentSize)
+{
+  {
+    ReentrantMonitorAutoEnter mon(mReentrantMonitor);
+
+    if (NS_FAILED(mStatus)) {
+      return mStatus;
+    }
+    if (mBuffer.GetSegmentSize() != aSegmentSize ||
+        mWriteCursor != mWriteLimit ||
+        !mBuffer.AppendSegment(aSegment)) {
+      return NS_BASE_STREAM_WOULD_BLOCK;
+    }
+    LOG(("OOO adopted segment\n"));
+    mWriteCursor = aSegment;
+    mWriteLimit = mWriteCursor + aSegmentSize;
+    ++mWriteSegment;
+
+    // make sure read cursor is initialized
+    SetAllNullReadCursors();
+  }
+
+  // publish the segment to the readers as if it had just been written
+  AdvanceWriteCursor(aSegmentSize);
+  return NS_OK;
+}
+
 void
 nsPipe::OnInputStreamException(nsPipeInputStream* aStream, nsresult aReason)
 {
@@ -1136,6 +1247,7 @@ NS_INTERFACE_TABLE_HEAD(nsPipeInputStream)
     NS_INTERFACE_TABLE_ENTRY(nsPipeInputStream, nsICloneableInputStream)
     NS_INTERFACE_TABLE_ENTRY(nsPipeInputStream, nsIBufferedInputStream)
     NS_INTERFACE_TABLE_ENTRY(nsPipeInputStream, nsIClassInfo)
+    NS_INTERFACE_TABLE_ENTRY(nsPipeInputStream, nsPipeInputStream)
     NS_INTERFACE_TABLE_ENTRY_AMBIGUOUS(nsPipeInputStream, nsIInputStream,
                                        nsIAsyncInputStream)
     NS_INTERFACE_TABLE_ENTRY_AMBIGUOUS(nsPipeInputStream, nsISupports,
@@ -1344,6 +1456,20 @@ nsPipeInputStream::ReadSegments(nsWriteSegmentFun aWriter,
   return rv;
 }
 
+char*
+nsPipeInputStream::TakeSegment(uint32_t aSegmentSize)
+{
+  if (NS_FAILED(Status())) {
+    return nullptr;
+  }
+
+  char* segment = mPipe->TakeReadSegment(mReadState, aSegmentSize);
+  if (segment) {
+    mLogicalOffset += aSegmentSize;
+  }
+  return segment;
+}
+
 NS_IMETHODIMP
 nsPipeInputStream::Read(char* aToBuf, uint32_t aBufLen, uint32_t* aReadCount)
 {
@@ -1558,7 +1684,8 @@ nsPipeInputStream::~nsPipeInputStream()
 NS_IMPL_QUERY_INTERFACE(nsPipeOutputStream,
                         nsIOutputStream,
                         nsIAsyncOutputStream,
-                        nsIClassInfo)
+                        nsIClassInfo,
+                        nsPipeOutputStream)
 
 NS_IMPL_CI_INTERFACE_GETTER(nsPipeOutputStream,
                             nsIOutputStream,
@@ -1747,6 +1874,28 @@ nsReadFromRawBuffer(nsIOutputStream* aOutStr,
   return NS_OK;
 }
 
+uint32_t
+nsPipeOutputStream::SegmentSize()
+{
+  return mPipe->mBuffer.GetSegmentSize();
+}
+
+bool
+nsPipeOutputStream::CanAdoptSegment(uint32_t aSegmentSize)
+{
+  return mPipe->CanAdoptWriteSegment(aSegmentSize);
+}
+
+nsresult
+nsPipeOutputStream::AdoptSegment(char* aSegment, uint32_t aSegmentSize)
+{
+  nsresult rv = mPipe->AdoptWriteSegment(aSegment, aSegmentSize);
+  if (NS_SUCCEEDED(rv)) {
+    mLogicalOffset += aSegmentSize;
+  }
+  return rv;
+}
+
 NS_IMETHODIMP
 nsPipeOutputStream::Write(const char* aFromBuf,
                           uint32_t aBufLen,
@@ -1902,3 +2051,49 @@ nsPipeConstructor(nsISupports* aOuter, REFNSIID aIID, void** aResult)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+
+bool
+NS_CanMovePipeSegments(nsIInputStream* aSource, nsIOutputStream* aSink)
+{
+  RefPtr<nsPipeInputStream> source = do_QueryObject(aSource);
+  RefPtr<nsPipeOutputStream> sink = do_QueryObject(aSink);
+  return source && sink;
+}
+
+uint32_t
+NS_MovePipeSegments(nsIInputStream* aSource, nsIOutputStream* aSink,
+                    uint32_t aMaxCount)
+{
+  RefPtr<nsPipeInputStream> source = do_QueryObject(aSource);
+  RefPtr<nsPipeOutputStream> sink = do_QueryObject(aSink);
+  if (!source || !sink) {
+    return 0;
+  }
+
+  uint32_t segmentSize = sink->SegmentSize();
+  uint32_t moved = 0;
+  // Move at least one segment even if it is larger than aMaxCount, so small
+  // chunk sizes do not disable the hand-over altogether.
+  while (moved == 0 ||
+         (moved < aMaxCount && aMaxCount - moved >= segmentSize)) {
+    if (!sink->CanAdoptSegment(segmentSize)) {
+      break;
+    }
+    char* segment = source->TakeSegment(segmentSize);
+    if (!segment) {
+      break;
+    }
+    nsresult rv = sink->AdoptSegment(segment, segmentSize);
+    if (NS_FAILED(rv)) {
+      // The sink was closed since CanAdoptSegment; its data is discarded
+      // anyway, and the failure is reported by the next write.
+      MOZ_ASSERT(rv != NS_BASE_STREAM_WOULD_BLOCK,
+                 "someone else is writing to the sink");
+      free(segment);
+      moved += segmentSize;
+      break;
+    }
+    moved += segmentSize;
+  }
+  return moved;
+}
@@ -30,11 +30,29 @@ nsSegmentedBuffer::AppendNewSegment()
     return nullptr;
   }
 
+  char* seg = (char*)malloc(mSegmentSize);
+  if (!seg) {
+    return nullptr;
+  }
+  if (!AppendSegment(seg)) {
+    free(seg);
+    return nullptr;
+  }
+  return seg;
+}
+
+bool
+nsSegmentedBuffer::AppendSegment(char* aSegment)
+{
+  if (GetSize() >= mMaxSize) {
+    return false;
+  }
+
   if (!mSegmentArray) {
     uint32_t bytes = mSegmentArrayCount * sizeof(char*);
     mSegmentArray = (char**)moz_xmalloc(bytes);
     if (!mSegmentArray) {
-      return nullptr;
+      return false;
     }
     memset(mSegmentArray, 0, bytes);
   }
@@ -44,7 +62,7 @@ nsSegmentedBuffer::AppendNewSegment()
     uint32_t bytes = newArraySize * sizeof(char*);
     char** newSegArray = (char**)moz_xrealloc(mSegmentArray, bytes);
     if (!newSegArray) {
-      return nullptr;
+      return false;
     }
     mSegmentArray = newSegArray;
     // copy wrapped content to new extension
@@ -64,13 +82,9 @@ nsSegmentedBuffer::AppendNewSegment()
     mSegmentArrayCount = newArraySize;
   }
 
-  char* seg = (char*)malloc(mSegmentSize);
-  if (!seg) {
-    return nullptr;
-  }
-  mSegmentArray[mLastSegmentIndex] = seg;
+  mSegmentArray[mLastSegmentIndex] = aSegment;
   mLastSegmentIndex = ModSegArraySize(mLastSegmentIndex + 1);
-  return seg;
+  return true;
 }
 
 bool
@@ -89,6 +103,21 @@ nsSegmentedBuffer::DeleteFirstSegment()
   }
 }
 
+char*
+nsSegmentedBuffer::TakeFirstSegment()
+{
+  char* seg = mSegmentArray[mFirstSegmentIndex];
+  NS_ASSERTION(seg != nullptr, "taking bad segment");
+  mSegmentArray[mFirstSegmentIndex] = nullptr;
+  int32_t last = ModSegArraySize(mLastSegmentIndex - 1);
+  if (mFirstSegmentIndex == last) {
+    mLastSegmentIndex = last;
+  } else {
+    mFirstSegmentIndex = ModSegArraySize(mFirstSegmentIndex + 1);
+  }
+  return seg;
+}
+
 bool
 nsSegmentedBuffer::DeleteLastSegment()
 {
@@ -32,6 +32,16 @@ public:
 
   char* AppendNewSegment();   // pushes at end
 
+  // Pushes a segment allocated elsewhere with malloc() and exactly
+  // GetSegmentSize() bytes long; the buffer takes ownership of it.
+  // Returns false, leaving the segment with the caller, if the buffer is
+  // full.
+  bool AppendSegment(char* aSegment);
+
+  // Pops the first segment without freeing it; the caller takes ownership
+  // and must free() it.
+  char* TakeFirstSegment();
+
   // returns true if no more segments remain:
   bool DeleteFirstSegment();  // pops from beginning
 
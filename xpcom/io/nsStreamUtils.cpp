@@ -10,6 +10,7 @@
 #include "nsAutoPtr.h"
 #include "nsCOMPtr.h"
 #include "nsIPipe.h"
+#include "nsPipe.h"
 #include "nsICloneableInputStream.h"
 #include "nsIEventTarget.h"
 #include "nsICancelableRunnable.h"
@@ -251,6 +252,7 @@ public:
     , mCloseSource(true)
     , mCloseSink(true)
     , mCanceled(false)
+    , mMovePipeSegments(false)
     , mCancelStatus(NS_OK)
   {
   }
@@ -278,6 +280,7 @@ public:
 
     mAsyncSource = do_QueryInterface(mSource);
     mAsyncSink = do_QueryInterface(mSink);
+    mMovePipeSegments = NS_CanMovePipeSegments(mSource, mSink);
 
     return PostContinuationEvent();
   }
@@ -316,7 +319,15 @@ public:
       //       because we have consumed all of our data.
       bool copyFailed = false;
       if (!canceled) {
-        uint32_t n = DoCopy(&sourceCondition, &sinkCondition);
+        // Between two pipes, full segments are handed over rather than
+        // copied; only the remainder goes through DoCopy.
+        uint32_t n = 0;
+        if (mMovePipeSegments) {
+          n = NS_MovePipeSegments(mSource, mSink, mChunkSize);
+        }
+        if (n == 0) {
+          n = DoCopy(&sourceCondition, &sinkCondition);
+        }
         if (n > 0 && mProgressCallback) {
           mProgressCallback(mClosure, n);
         }
@@ -499,6 +510,7 @@ protected:
   bool                           mCloseSource;
   bool                           mCloseSink;
   bool                           mCanceled;
+  bool                           mMovePipeSegments;
   nsresult                       mCancelStatus;
 
   // virtual since subclasses call superclass Release()
@@ -13,6 +13,9 @@
 #include "nscore.h"
 #include "mozilla/Assertions.h"
 #include "mozilla/SSE.h"
+#if defined(MOZILLA_INTERNAL_API) && defined(BUILD_ARM_NEON)
+#include "mozilla/arm.h"
+#endif
 
 #include "nsCharTraits.h"
 
@@ -49,6 +52,87 @@ public:
   }
 };
 
+#ifdef MOZILLA_INTERNAL_API
+namespace mozilla {
+#ifdef MOZILLA_MAY_SUPPORT_SSE2
+namespace SSE2 {
+uint32_t ConvertASCIIPrefix(const char* aSource, uint32_t aLength,
+                            char16_t* aDest);
+uint32_t ConvertASCIIPrefix(const char16_t* aSource, uint32_t aLength,
+                            char* aDest);
+uint32_t ASCIIPrefixLength(const char* aSource, uint32_t aLength);
+uint32_t ASCIIPrefixLength(const char16_t* aSource, uint32_t aLength);
+} // namespace SSE2
+#endif
+#ifdef BUILD_ARM_NEON
+namespace NEON {
+uint32_t ConvertASCIIPrefix(const char* aSource, uint32_t aLength,
+                            char16_t* aDest);
+uint32_t ConvertASCIIPrefix(const char16_t* aSource, uint32_t aLength,
+                            char* aDest);
+uint32_t ASCIIPrefixLength(const char* aSource, uint32_t aLength);
+uint32_t ASCIIPrefixLength(const char16_t* aSource, uint32_t aLength);
+} // namespace NEON
+#endif
+} // namespace mozilla
+#endif // MOZILLA_INTERNAL_API
+
+/**
+ * Bulk handling of runs of ASCII for the UTF-8 sinks below. Convert() copies
+ * the ASCII prefix of aSource to aDest, and Length() measures it, 16 code
+ * units at a time. Both return the number of code units they handled, which
+ * stops short of the first 16 holding a non-ASCII unit, so the caller must
+ * handle the rest of the string itself. Without SIMD they handle nothing.
+ */
+class ASCIIPrefix
+{
+public:
+  template<typename SrcT, typename DestT>
+  static uint32_t Convert(const SrcT* aSource, uint32_t aLength, DestT* aDest)
+  {
+#ifdef MOZILLA_INTERNAL_API
+    if (aLength < kMinLength) {
+      return 0;
+    }
+#ifdef MOZILLA_MAY_SUPPORT_SSE2
+    if (mozilla::supports_sse2()) {
+      return mozilla::SSE2::ConvertASCIIPrefix(aSource, aLength, aDest);
+    }
+#endif
+#ifdef BUILD_ARM_NEON
+    if (mozilla::supports_neon()) {
+      return mozilla::NEON::ConvertASCIIPrefix(aSource, aLength, aDest);
+    }
+#endif
+#endif // MOZILLA_INTERNAL_API
+    return 0;
+  }
+
+  template<typename SrcT>
+  static uint32_t Length(const SrcT* aSource, uint32_t aLength)
+  {
+#ifdef MOZILLA_INTERNAL_API
+    if (aLength < kMinLength) {
+      return 0;
+    }
+#ifdef MOZILLA_MAY_SUPPORT_SSE2
+    if (mozilla::supports_sse2()) {
+      return mozilla::SSE2::ASCIIPrefixLength(aSource, aLength);
+    }
+#endif
+#ifdef BUILD_ARM_NEON
+    if (mozilla::supports_neon()) {
+      return mozilla::NEON::ASCIIPrefixLength(aSource, aLength);
+    }
+#endif
+#endif // MOZILLA_INTERNAL_API
+    return 0;
+  }
+
+private:
+  static const uint32_t kMinLength = 16;
+};
+
 /**
  * Extract the next UCS-4 character from the buffer and return it.  The
  * pointer passed in is advanced to the start of the next character in the
@@ -306,6 +390,9 @@ public:
     const value_type* p = aStart;
     const value_type* end = aStart + aN;
     buffer_type* out = mBuffer;
+    uint32_t ascii = ASCIIPrefix::Convert(p, aN, out);
+    p += ascii;
+    out += ascii;
     for (; p != end /* && *p */;) {
       bool err;
       uint32_t ucs4 = UTF8CharEnumerator::NextChar(&p, end, &err);
@@ -322,6 +409,13 @@ public:
       } else {
         *out++ = ucs4;
       }
+
+      // Copy any run of ASCII that follows a non-ASCII character in bulk.
+      if (ucs4 >= 0x80 && p != end && UTF8traits::isASCII(*p)) {
+        ascii = ASCIIPrefix::Convert(p, end - p, out);
+        p += ascii;
+        out += ascii;
+      }
     }
     mBuffer = out;
   }
@@ -367,10 +461,16 @@ public:
     // be spread across fragments
     const value_type* p = aStart;
     const value_type* end = aStart + aN;
+    uint32_t ascii = ASCIIPrefix::Length(p, aN);
+    p += ascii;
+    mLength += ascii;
     for (; p < end /* && *p */; ++mLength) {
       if (UTF8traits::isASCII(*p)) {
         p += 1;
-      } else if (UTF8traits::is2byte(*p)) {
+        continue;
+      }
+
+      if (UTF8traits::is2byte(*p)) {
         p += 2;
       } else if (UTF8traits::is3byte(*p)) {
         p += 3;
@@ -425,6 +525,13 @@ public:
         ++mLength; // to account for the decrement below
         break;
       }
+
+      // Measure any run of ASCII that follows a non-ASCII character in bulk.
+      if (p < end && UTF8traits::isASCII(*p)) {
+        ascii = ASCIIPrefix::Length(p, end - p);
+        p += ascii;
+        mLength += ascii;
+      }
     }
     if (p != end) {
       NS_ERROR("Not a UTF-8 string. This code should only be used for converting from known UTF-8 strings.");
@@ -467,7 +574,9 @@ public:
   {
     buffer_type* out = mBuffer; // gcc isn't smart enough to do this!
 
-    for (const value_type* p = aStart, *end = aStart + aN; p < end; ++p) {
+    uint32_t ascii = ASCIIPrefix::Convert(aStart, aN, out);
+    out += ascii;
+    for (const value_type* p = aStart + ascii, *end = aStart + aN; p < end; ++p) {
       value_type c = *p;
       if (!(c & 0xFF80)) { // U+0000 - U+007F
         *out++ = (char)c;
@@ -536,6 +645,13 @@ public:
         // DC00- DFFF - Low Surrogate
         NS_WARNING("got a low Surrogate but no high surrogate");
       }
+
+      // Copy any run of ASCII that follows a non-ASCII character in bulk.
+      if ((c & 0xFF80) && end - p > 1 && !(p[1] & 0xFF80)) {
+        ascii = ASCIIPrefix::Convert(p + 1, end - p - 1, out);
+        p += ascii;
+        out += ascii;
+      }
     }
 
     mBuffer = out;
@@ -574,7 +690,9 @@ public:
   void write(const value_type* aStart, uint32_t aN)
   {
     // Assume UCS2 surrogate pairs won't be spread across fragments.
-    for (const value_type* p = aStart, *end = aStart + aN; p < end; ++p) {
+    uint32_t ascii = ASCIIPrefix::Length(aStart, aN);
+    mSize += ascii;
+    for (const value_type* p = aStart + ascii, *end = aStart + aN; p < end; ++p) {
       value_type c = *p;
       if (!(c & 0xFF80)) { // U+0000 - U+007F
         mSize += 1;
@@ -622,6 +740,13 @@ public:
 
         NS_WARNING("got a low Surrogate but no high surrogate");
       }
+
+      // Measure any run of ASCII that follows a non-ASCII character in bulk.
+      if ((c & 0xFF80) && end - p > 1 && !(p[1] & 0xFF80)) {
+        ascii = ASCIIPrefix::Length(p + 1, end - p - 1);
+        p += ascii;
+        mSize += ascii;
+      }
     }
   }
 
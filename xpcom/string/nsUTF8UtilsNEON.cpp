@@ -0,0 +1,91 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "nscore.h"
+#include <arm_neon.h>
+#include <nsUTF8Utils.h>
+
+namespace mozilla {
+namespace NEON {
+
+static inline bool
+IsASCII(uint8x16_t aBytes)
+{
+  uint8x8_t folded = vorr_u8(vget_low_u8(aBytes), vget_high_u8(aBytes));
+  return !(vget_lane_u64(vreinterpret_u64_u8(folded), 0) &
+           UINT64_C(0x8080808080808080));
+}
+
+static inline bool
+IsASCII(uint16x8_t aUnits1, uint16x8_t aUnits2)
+{
+  uint16x8_t nonASCII = vandq_u16(vorrq_u16(aUnits1, aUnits2),
+                                  vdupq_n_u16(0xff80));
+  uint16x4_t folded = vorr_u16(vget_low_u16(nonASCII), vget_high_u16(nonASCII));
+  return !vget_lane_u64(vreinterpret_u64_u16(folded), 0);
+}
+
+uint32_t
+ConvertASCIIPrefix(const char* aSource, uint32_t aLength, char16_t* aDest)
+{
+  uint32_t i = 0;
+  for (; aLength - i > 15; i += 16) {
+    uint8x16_t source = vld1q_u8(reinterpret_cast<const uint8_t*>(aSource + i));
+    if (!IsASCII(source)) {
+      break;
+    }
+    vst1q_u16(reinterpret_cast<uint16_t*>(aDest + i),
+              vmovl_u8(vget_low_u8(source)));
+    vst1q_u16(reinterpret_cast<uint16_t*>(aDest + i + 8),
+              vmovl_u8(vget_high_u8(source)));
+  }
+  return i;
+}
+
+uint32_t
+ConvertASCIIPrefix(const char16_t* aSource, uint32_t aLength, char* aDest)
+{
+  uint32_t i = 0;
+  for (; aLength - i > 15; i += 16) {
+    uint16x8_t source1 = vld1q_u16(reinterpret_cast<const uint16_t*>(aSource + i));
+    uint16x8_t source2 = vld1q_u16(reinterpret_cast<const uint16_t*>(aSource + i + 8));
+    if (!IsASCII(source1, source2)) {
+      break;
+    }
+    vst1q_u8(reinterpret_cast<uint8_t*>(aDest + i),
+             vcombine_u8(vmovn_u16(source1), vmovn_u16(source2)));
+  }
+  return i;
+}
+
+uint32_t
+ASCIIPrefixLength(const char* aSource, uint32_t aLength)
+{
+  uint32_t i = 0;
+  for (; aLength - i > 15; i += 16) {
+    if (!IsASCII(vld1q_u8(reinterpret_cast<const uint8_t*>(aSource + i)))) {
+      break;
+    }
+  }
+  return i;
+}
+
+uint32_t
+ASCIIPrefixLength(const char16_t* aSource, uint32_t aLength)
+{
+  uint32_t i = 0;
+  for (; aLength - i > 15; i += 16) {
+    uint16x8_t source1 = vld1q_u16(reinterpret_cast<const uint16_t*>(aSource + i));
+    uint16x8_t source2 = vld1q_u16(reinterpret_cast<const uint16_t*>(aSource + i + 8));
+    if (!IsASCII(source1, source2)) {
+      break;
+    }
+  }
+  return i;
+}
+
+} // namespace NEON
+} // namespace mozilla
@@ -103,3 +103,78 @@ LossyConvertEncoding8to16::write_sse2(const char* aSource,
 
   mDestination += i;
 }
+
+namespace mozilla {
+namespace SSE2 {
+
+uint32_t
+ConvertASCIIPrefix(const char* aSource, uint32_t aLength, char16_t* aDest)
+{
+  __m128i zero = _mm_setzero_si128();
+  uint32_t i = 0;
+  for (; aLength - i > 15; i += 16) {
+    __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSource + i));
+    if (_mm_movemask_epi8(source)) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i),
+                     _mm_unpacklo_epi8(source, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i + 8),
+                     _mm_unpackhi_epi8(source, zero));
+  }
+  return i;
+}
+
+uint32_t
+ConvertASCIIPrefix(const char16_t* aSource, uint32_t aLength, char* aDest)
+{
+  __m128i nonASCIIMask = _mm_set1_epi16(static_cast<int16_t>(0xff80));
+  __m128i zero = _mm_setzero_si128();
+  uint32_t i = 0;
+  for (; aLength - i > 15; i += 16) {
+    __m128i source1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSource + i));
+    __m128i source2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSource + i + 8));
+    __m128i nonASCII = _mm_and_si128(_mm_or_si128(source1, source2), nonASCIIMask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonASCII, zero)) != 0xffff) {
+      break;
+    }
+    // Every unit is below 0x80, so the saturating pack just drops the high
+    // bytes.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i),
+                     _mm_packus_epi16(source1, source2));
+  }
+  return i;
+}
+
+uint32_t
+ASCIIPrefixLength(const char* aSource, uint32_t aLength)
+{
+  uint32_t i = 0;
+  for (; aLength - i > 15; i += 16) {
+    __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSource + i));
+    if (_mm_movemask_epi8(source)) {
+      break;
+    }
+  }
+  return i;
+}
+
+uint32_t
+ASCIIPrefixLength(const char16_t* aSource, uint32_t aLength)
+{
+  __m128i nonASCIIMask = _mm_set1_epi16(static_cast<int16_t>(0xff80));
+  __m128i zero = _mm_setzero_si128();
+  uint32_t i = 0;
+  for (; aLength - i > 15; i += 16) {
+    __m128i source1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSource + i));
+    __m128i source2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSource + i + 8));
+    __m128i nonASCII = _mm_and_si128(_mm_or_si128(source1, source2), nonASCIIMask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonASCII, zero)) != 0xffff) {
+      break;
+    }
+  }
+  return i;
+}
+
+} // namespace SSE2
+} // namespace mozilla
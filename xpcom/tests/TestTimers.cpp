@@ -171,6 +171,88 @@ TestTimerWithStoppedTarget()
   return NS_OK;
 }
 
+struct OrderingTestState
+{
+  explicit OrderingTestState(ReentrantMonitor* aMonitor)
+    : mMonitor(aMonitor)
+  {
+  }
+
+  ReentrantMonitor* mMonitor;
+  std::vector<size_t> mFired;
+};
+
+struct OrderingTestClosure
+{
+  OrderingTestState* mState;
+  size_t mIndex;
+};
+
+static void
+OrderingTestCallback(nsITimer* aTimer, void* aClosure)
+{
+  OrderingTestClosure* closure = static_cast<OrderingTestClosure*>(aClosure);
+  ReentrantMonitorAutoEnter mon(*closure->mState->mMonitor);
+  closure->mState->mFired.push_back(closure->mIndex);
+  mon.Notify();
+}
+
+// Timers with the same delay must fire in the order they were armed, even
+// when others are canceled or re-armed in between.
+nsresult
+TestTimerOrdering()
+{
+  AutoCreateAndDestroyReentrantMonitor newMon;
+  NS_ENSURE_TRUE(newMon, NS_ERROR_OUT_OF_MEMORY);
+
+  AutoTestThread testThread;
+  NS_ENSURE_TRUE(testThread, NS_ERROR_OUT_OF_MEMORY);
+
+  static const size_t kNumTimers = 300;
+  OrderingTestState state(newMon);
+  OrderingTestClosure closures[kNumTimers];
+  nsCOMPtr<nsITimer> timers[kNumTimers];
+
+  nsresult rv;
+  for (size_t i = 0; i < kNumTimers; ++i) {
+    closures[i].mState = &state;
+    closures[i].mIndex = i;
+    timers[i] = do_CreateInstance(NS_TIMER_CONTRACTID, &rv);
+    NS_ENSURE_SUCCESS(rv, rv);
+    rv = timers[i]->SetTarget(static_cast<nsIEventTarget*>(testThread));
+    NS_ENSURE_SUCCESS(rv, rv);
+    rv = timers[i]->InitWithFuncCallback(OrderingTestCallback, &closures[i],
+                                         200, nsITimer::TYPE_ONE_SHOT);
+    NS_ENSURE_SUCCESS(rv, rv);
+  }
+
+  // Cancel every third timer, and re-arm every fifth, which moves it behind
+  // all of the others.
+  std::vector<size_t> expected;
+  std::vector<size_t> rearmed;
+  for (size_t i = 0; i < kNumTimers; ++i) {
+    if (i % 3 == 0) {
+      timers[i]->Cancel();
+    } else if (i % 5 == 0) {
+      rv = timers[i]->InitWithFuncCallback(OrderingTestCallback, &closures[i],
+                                           200, nsITimer::TYPE_ONE_SHOT);
+      NS_ENSURE_SUCCESS(rv, rv);
+      rearmed.push_back(i);
+    } else {
+      expected.push_back(i);
+    }
+  }
+  expected.insert(expected.end(), rearmed.begin(), rearmed.end());
+
+  ReentrantMonitorAutoEnter mon(*newMon);
+  while (state.mFired.size() < expected.size()) {
+    mon.Wait();
+  }
+  NS_ENSURE_TRUE(state.mFired == expected, NS_ERROR_FAILURE);
+
+  return NS_OK;
+}
+
 #define FUZZ_MAX_TIMEOUT 9
 class FuzzTestThreadState final : public nsITimerCallback {
   public:
@@ -478,6 +560,7 @@ int main(int argc, char** argv)
   static TestFuncPtr testsToRun[] = {
     TestTargetedTimers,
     TestTimerWithStoppedTarget,
+    TestTimerOrdering,
     FuzzTestTimers
   };
   static uint32_t testCount = sizeof(testsToRun) / sizeof(testsToRun[0]);
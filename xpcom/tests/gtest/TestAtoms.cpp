@@ -6,11 +6,13 @@
 
 #include "mozilla/ArrayUtils.h"
 
+#include "nsCOMArray.h"
 #include "nsIAtom.h"
 #include "nsString.h"
 #include "UTFStrings.h"
 #include "nsIServiceManager.h"
 #include "nsStaticAtom.h"
+#include "nsThreadUtils.h"
 
 #include "gtest/gtest.h"
 
@@ -176,4 +178,42 @@ TEST(Atoms, Table)
   EXPECT_EQ(thirdDynamic, sAtom3);
 }
 
+
+TEST(Atoms, ConcurrentAtomize)
+{
+  // Several threads atomizing the same strings must all get the same atoms.
+  static const uint32_t kThreads = 4;
+  static const uint32_t kAtoms = 500;
+
+  nsCOMArray<nsIAtom> expected;
+  for (uint32_t i = 0; i < kAtoms; ++i) {
+    nsAutoString str;
+    str.AppendLiteral("concurrent-atom-");
+    str.AppendInt(i);
+    nsCOMPtr<nsIAtom> atom = NS_Atomize(str);
+    expected.AppendObject(atom);
+  }
+
+  nsCOMArray<nsIThread> threads;
+  for (uint32_t t = 0; t < kThreads; ++t) {
+    nsCOMPtr<nsIThread> thread;
+    nsresult rv = NS_NewThread(getter_AddRefs(thread),
+      NS_NewRunnableFunction([&expected] () {
+        for (uint32_t i = 0; i < kAtoms; ++i) {
+          nsAutoString str;
+          str.AppendLiteral("concurrent-atom-");
+          str.AppendInt(i);
+          nsCOMPtr<nsIAtom> atom = NS_Atomize(str);
+          EXPECT_EQ(expected[i], atom.get());
+        }
+      }));
+    ASSERT_TRUE(NS_SUCCEEDED(rv));
+    threads.AppendObject(thread);
+  }
+
+  for (int32_t t = 0; t < threads.Count(); ++t) {
+    threads[t]->Shutdown();
+  }
+}
+
 }
@@ -38,3 +38,24 @@ TEST(EscapeURL, FallibleEscape)
   const char* const kExpected = "data:,Hello%2C%20World!%C4%9F";
   EXPECT_STREQ(escaped.BeginReading(), kExpected);
 }
+
+TEST(EscapeURL, SafeRuns)
+{
+  // Long runs of characters that are never escaped are skipped in bulk; make
+  // sure the characters around them still go through the usual rules.
+  nsCString toEscape("abcdefghijklmnopqrstuvwxyz0123456789 |\xC4\x9F|"
+                     "ABCDEFGHIJKLMNOPQRSTUVWXYZ_~-!$&()*+,%41");
+  nsCString escaped;
+  nsresult rv = NS_EscapeURL(toEscape, esc_Query, escaped, fallible);
+  EXPECT_EQ(rv, NS_OK);
+  const char* const kExpected =
+    "abcdefghijklmnopqrstuvwxyz0123456789%20|%C4%9F%7C"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ_~-!$&()*+,%41";
+  EXPECT_STREQ(escaped.BeginReading(), kExpected);
+
+  // Nothing to escape: the result shares the input's buffer.
+  nsCString safe("abcdefghijklmnopqrstuvwxyz0123456789abcdefghij");
+  rv = NS_EscapeURL(safe, esc_Query, escaped, fallible);
+  EXPECT_EQ(rv, NS_OK);
+  EXPECT_EQ(safe.BeginReading(), escaped.BeginReading());
+}
@@ -5,7 +5,11 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "PLDHashTable.h"
+#include "mozilla/UniquePtr.h"
+#include "nsString.h"
+#include "nsTArray.h"
 #include "gtest/gtest.h"
+#include "gtest/MozGTestBench.h" // For MOZ_GTEST_BENCH
 
 // This test mostly focuses on edge cases. But more coverage of normal
 // operations wouldn't be a bad thing.
@@ -330,6 +334,141 @@ TEST(PLDHashTableTest, Iterator)
   ASSERT_EQ(t.Capacity(), unsigned(PLDHashTable::kMinCapacity));
 }
 
+TEST(PLDHashTableTest, GroupProbing)
+{
+  PLDHashTable t(&trivialOps, sizeof(PLDHashEntryStub),
+                 PLDHashTable::kDefaultInitialLength,
+                 PLDHashTable::GroupProbing);
+
+  // Keys that are multiples of 8, like heap pointers, and enough of them to
+  // grow the table several times.
+  const size_t kKeys = 5000;
+  for (size_t i = 1; i <= kKeys; i++) {
+    ASSERT_TRUE(t.Add((const void*)(i * 8)));
+  }
+  ASSERT_EQ(t.EntryCount(), kKeys);
+
+  // Remove every third key, then make sure exactly the rest are found.
+  for (size_t i = 3; i <= kKeys; i += 3) {
+    t.Remove((const void*)(i * 8));
+  }
+  for (size_t i = 1; i <= kKeys; i++) {
+    ASSERT_EQ(!!t.Search((const void*)(i * 8)), i % 3 != 0);
+  }
+  ASSERT_FALSE(t.Search((const void*)(kKeys * 8 + 8)));
+
+  // Adding an existing key returns the existing entry.
+  PLDHashEntryHdr* entry = t.Search((const void*)8);
+  ASSERT_EQ(t.Add((const void*)8), entry);
+
+  size_t count = 0;
+  for (auto iter = t.Iter(); !iter.Done(); iter.Next()) {
+    auto stub = static_cast<PLDHashEntryStub*>(iter.Get());
+    ASSERT_NE(size_t(stub->key) / 8 % 3, 0u);
+    if (size_t(stub->key) / 8 % 2 == 0) {
+      iter.Remove();
+    }
+    count++;
+  }
+  ASSERT_EQ(count, kKeys - kKeys / 3);
+
+  // Re-adding removed keys recycles their entries.
+  for (size_t i = 1; i <= kKeys; i++) {
+    ASSERT_TRUE(t.Add((const void*)(i * 8)));
+  }
+  ASSERT_EQ(t.EntryCount(), kKeys);
+
+  t.ClearAndPrepareForLength(100);
+  ASSERT_EQ(t.EntryCount(), 0u);
+  ASSERT_FALSE(t.Search((const void*)8));
+}
+
+static const PLDHashTableOps pointerOps = {
+  PLDHashTable::HashVoidPtrKeyStub,
+  PLDHashTable::MatchEntryStub,
+  PLDHashTable::MoveEntryStub,
+  PLDHashTable::ClearEntryStub,
+  TrivialInitEntry
+};
+
+static const PLDHashTableOps stringOps = {
+  PLDHashTable::HashStringKey,
+  PLDHashTable::MatchStringKey,
+  PLDHashTable::MoveEntryStub,
+  PLDHashTable::ClearEntryStub,
+  TrivialInitEntry
+};
+
+// Looks up every one of |aKeys| in a table holding half of them, with or
+// without GroupProbing.
+static void
+LookupKeys(const PLDHashTableOps* aOps, const nsTArray<const void*>& aKeys,
+           uint8_t aFlags)
+{
+  static const uint32_t kRounds = 20;
+
+  PLDHashTable t(aOps, sizeof(PLDHashEntryStub),
+                 PLDHashTable::kDefaultInitialLength, aFlags);
+  for (size_t i = 0; i < aKeys.Length(); i += 2) {
+    t.Add(aKeys[i]);
+  }
+
+  size_t found = 0;
+  for (uint32_t round = 0; round < kRounds; round++) {
+    for (const void* key : aKeys) {
+      found += !!t.Search(key);
+    }
+  }
+  ASSERT_EQ(found, kRounds * ((aKeys.Length() + 1) / 2));
+}
+
+static const size_t kBenchKeys = 100000;
+
+// Heap pointers, as used by the cycle collector's graph and many
+// nsPtrHashKey tables.
+static void
+LookupPointerKeys(uint8_t aFlags)
+{
+  nsTArray<mozilla::UniquePtr<uint64_t>> allocations;
+  nsTArray<const void*> pointers;
+  for (size_t i = 0; i < kBenchKeys; i++) {
+    allocations.AppendElement(mozilla::MakeUnique<uint64_t>(i));
+    pointers.AppendElement(allocations.LastElement().get());
+  }
+  LookupKeys(&pointerOps, pointers, aFlags);
+}
+
+// Short, similar strings, like atoms and pref names.
+static void
+LookupStringKeys(uint8_t aFlags)
+{
+  nsTArray<nsCString> strings;
+  nsTArray<const void*> stringKeys;
+  strings.SetCapacity(kBenchKeys);
+  for (size_t i = 0; i < kBenchKeys; i++) {
+    nsCString* str = strings.AppendElement();
+    str->AppendPrintf("browser.pref.name%u", unsigned(i));
+    stringKeys.AppendElement(str->get());
+  }
+  LookupKeys(&stringOps, stringKeys, aFlags);
+}
+
+MOZ_GTEST_BENCH(PLDHashTableTest, PointerLookups, [] {
+  LookupPointerKeys(0);
+});
+
+MOZ_GTEST_BENCH(PLDHashTableTest, PointerLookupsGroupProbing, [] {
+  LookupPointerKeys(PLDHashTable::GroupProbing);
+});
+
+MOZ_GTEST_BENCH(PLDHashTableTest, StringLookups, [] {
+  LookupStringKeys(0);
+});
+
+MOZ_GTEST_BENCH(PLDHashTableTest, StringLookupsGroupProbing, [] {
+  LookupStringKeys(PLDHashTable::GroupProbing);
+});
+
 // This test involves resizing a table repeatedly up to 512 MiB in size. On
 // 32-bit platforms (Win32, Android) it sometimes OOMs, causing the test to
 // fail. (See bug 931062 and bug 1267227.) Therefore, we only run it on 64-bit
@@ -701,6 +701,57 @@ TEST(Pipes, Write_AsyncWait)
   ASSERT_TRUE(cb->Called());
 }
 
+namespace {
+
+void
+CopyDone(void* aClosure, nsresult aStatus)
+{
+  *static_cast<bool*>(aClosure) = true;
+}
+
+} // namespace
+
+TEST(Pipes, AsyncCopy_PipeToPipe)
+{
+  nsCOMPtr<nsIAsyncInputStream> sourceReader;
+  nsCOMPtr<nsIAsyncOutputStream> sourceWriter;
+  nsCOMPtr<nsIAsyncInputStream> sinkReader;
+  nsCOMPtr<nsIAsyncOutputStream> sinkWriter;
+
+  const uint32_t segmentSize = 1024;
+  const uint32_t numSegments = 8;
+
+  nsresult rv = NS_NewPipe2(getter_AddRefs(sourceReader),
+                            getter_AddRefs(sourceWriter),
+                            true, true,  // non-blocking - reader, writer
+                            segmentSize, numSegments);
+  ASSERT_TRUE(NS_SUCCEEDED(rv));
+
+  rv = NS_NewPipe2(getter_AddRefs(sinkReader), getter_AddRefs(sinkWriter),
+                   true, true,  // non-blocking - reader, writer
+                   segmentSize, numSegments);
+  ASSERT_TRUE(NS_SUCCEEDED(rv));
+
+  // Several full segments, which are handed over between the pipes, and a
+  // partial one, which has to be copied.
+  nsTArray<char> inputData;
+  testing::CreateData(segmentSize * 5 + segmentSize / 2, inputData);
+  testing::WriteAllAndClose(sourceWriter, inputData);
+
+  nsCOMPtr<nsIThread> thread = do_GetCurrentThread();
+  bool done = false;
+  rv = NS_AsyncCopy(sourceReader, sinkWriter, thread,
+                    NS_ASYNCCOPY_VIA_READSEGMENTS, segmentSize * 2,
+                    CopyDone, &done);
+  ASSERT_TRUE(NS_SUCCEEDED(rv));
+
+  while (!done) {
+    NS_ProcessNextEvent(thread, true);
+  }
+
+  testing::ConsumeAndValidateStream(sinkReader, inputData);
+}
+
 TEST(Pipes, Write_AsyncWait_Clone)
 {
   nsCOMPtr<nsIAsyncInputStream> reader;
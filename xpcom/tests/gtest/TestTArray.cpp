@@ -4,6 +4,7 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include "nsCopyOnWriteArray.h"
 #include "nsTArray.h"
 #include "gtest/gtest.h"
 
@@ -203,4 +204,62 @@ TEST(TArray, CopyOverlappingBackwards)
   }
 }
 
+TEST(TArray, CopyOnWrite)
+{
+  const nsTArray<int>& dummy = DummyArray();
+  nsCopyOnWriteArray<int> array(dummy);
+  ASSERT_EQ(array.Array(), dummy);
+  ASSERT_FALSE(array.IsShared());
+
+  nsCopyOnWriteArray<int> copy(array);
+  ASSERT_TRUE(array.IsShared());
+  ASSERT_TRUE(copy.IsShared());
+  ASSERT_EQ(array.Elements(), copy.Elements());
+
+  copy.EnsureMutable().AppendElement(42);
+  ASSERT_FALSE(array.IsShared());
+  ASSERT_FALSE(copy.IsShared());
+  ASSERT_NE(array.Elements(), copy.Elements());
+  ASSERT_EQ(array.Array(), dummy);
+  ASSERT_EQ(copy.Length(), dummy.Length() + 1);
+  ASSERT_EQ(copy[copy.Length() - 1], 42);
+
+  // Unshared arrays are modified in place.
+  const int* elements = array.Elements();
+  array.EnsureMutable()[0] = 7;
+  ASSERT_EQ(array.Elements(), elements);
+  ASSERT_EQ(array[0], 7);
+  ASSERT_EQ(copy[0], dummy[0]);
+
+  copy = array;
+  ASSERT_TRUE(copy == array);
+  copy.Clear();
+  ASSERT_TRUE(copy.IsEmpty());
+  ASSERT_FALSE(array.IsShared());
+  ASSERT_EQ(array.Length(), dummy.Length());
+  ASSERT_TRUE(copy != array);
+}
+
+static size_t
+CountBlock(const void*)
+{
+  return 1;
+}
+
+TEST(TArray, CopyOnWriteSizeOf)
+{
+  // Empty arrays have no storage.
+  nsCopyOnWriteArray<int> array;
+  ASSERT_EQ(array.ShallowSizeOfExcludingThisEvenIfShared(CountBlock), 0u);
+
+  array.Assign(nsTArray<int>(DummyArray()));
+  ASSERT_EQ(array.ShallowSizeOfExcludingThisIfUnshared(CountBlock), 2u);
+
+  // Shared storage is only counted by the owner that asks for it.
+  nsCopyOnWriteArray<int> copy(array);
+  ASSERT_EQ(array.ShallowSizeOfExcludingThisIfUnshared(CountBlock), 0u);
+  ASSERT_EQ(copy.ShallowSizeOfExcludingThisIfUnshared(CountBlock), 0u);
+  ASSERT_EQ(array.ShallowSizeOfExcludingThisEvenIfShared(CountBlock), 2u);
+}
+
 } // namespace TestTArray
@@ -0,0 +1,152 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "nsCOMPtr.h"
+#include "nsIThread.h"
+#include "nsTArray.h"
+#include "nsThreadUtils.h"
+#include "mozilla/Monitor.h"
+#include "gtest/gtest.h"
+#include "gtest/MozGTestBench.h" // For MOZ_GTEST_BENCH
+
+using namespace mozilla;
+
+namespace {
+
+// Runs on the consumer thread, and checks that each producer's events arrive
+// in the order they were dispatched.
+class DispatchState
+{
+public:
+  DispatchState(uint32_t aProducers, uint32_t aEventsPerProducer)
+    : mMonitor("DispatchState.mMonitor")
+    , mRemaining(aProducers * aEventsPerProducer)
+    , mOutOfOrder(0)
+  {
+    mNextSequence.SetLength(aProducers);
+    for (uint32_t& sequence : mNextSequence) {
+      sequence = 0;
+    }
+  }
+
+  void Received(uint32_t aProducer, uint32_t aSequence)
+  {
+    if (mNextSequence[aProducer] != aSequence) {
+      ++mOutOfOrder;
+    }
+    mNextSequence[aProducer] = aSequence + 1;
+    if (--mRemaining == 0) {
+      MonitorAutoLock lock(mMonitor);
+      lock.Notify();
+    }
+  }
+
+  void WaitForAll()
+  {
+    MonitorAutoLock lock(mMonitor);
+    while (mRemaining) {
+      lock.Wait();
+    }
+  }
+
+  uint32_t OutOfOrder() const { return mOutOfOrder; }
+
+private:
+  Monitor mMonitor;
+  // mNextSequence and mOutOfOrder are only touched on the consumer thread
+  // until mRemaining reaches zero.
+  nsTArray<uint32_t> mNextSequence;
+  Atomic<uint32_t> mRemaining;
+  uint32_t mOutOfOrder;
+};
+
+class SequencedEvent final : public Runnable
+{
+public:
+  SequencedEvent(DispatchState* aState, uint32_t aProducer,
+                 uint32_t aSequence)
+    : mState(aState)
+    , mProducer(aProducer)
+    , mSequence(aSequence)
+  {
+  }
+
+  NS_IMETHOD Run() override
+  {
+    mState->Received(mProducer, mSequence);
+    return NS_OK;
+  }
+
+private:
+  DispatchState* mState;
+  uint32_t mProducer;
+  uint32_t mSequence;
+};
+
+} // namespace
+
+static void
+DispatchFromThreads(uint32_t aProducers, uint32_t aEventsPerProducer)
+{
+  nsCOMPtr<nsIThread> consumer;
+  ASSERT_TRUE(NS_SUCCEEDED(NS_NewThread(getter_AddRefs(consumer))));
+
+  nsTArray<nsCOMPtr<nsIThread>> producers;
+  for (uint32_t i = 0; i < aProducers; ++i) {
+    nsCOMPtr<nsIThread> producer;
+    ASSERT_TRUE(NS_SUCCEEDED(NS_NewThread(getter_AddRefs(producer))));
+    producers.AppendElement(producer);
+  }
+
+  DispatchState state(aProducers, aEventsPerProducer);
+
+  for (uint32_t i = 0; i < aProducers; ++i) {
+    nsIThread* target = consumer;
+    DispatchState* statePtr = &state;
+    producers[i]->Dispatch(NS_NewRunnableFunction([=]() {
+      for (uint32_t sequence = 0; sequence < aEventsPerProducer; ++sequence) {
+        nsCOMPtr<nsIRunnable> event =
+          new SequencedEvent(statePtr, i, sequence);
+        target->Dispatch(event.forget(), NS_DISPATCH_NORMAL);
+      }
+    }), NS_DISPATCH_NORMAL);
+  }
+
+  state.WaitForAll();
+  EXPECT_EQ(0u, state.OutOfOrder());
+
+  for (nsIThread* producer : producers) {
+    producer->Shutdown();
+  }
+  consumer->Shutdown();
+}
+
+TEST(ThreadDispatch, OneProducer)
+{
+  DispatchFromThreads(1, 10000);
+}
+
+TEST(ThreadDispatch, FourProducers)
+{
+  DispatchFromThreads(4, 5000);
+}
+
+TEST(ThreadDispatch, SixteenProducers)
+{
+  DispatchFromThreads(16, 1000);
+}
+
+MOZ_GTEST_BENCH(ThreadDispatch, OneProducerPerf, [] {
+  DispatchFromThreads(1, 100000);
+});
+
+MOZ_GTEST_BENCH(ThreadDispatch, FourProducersPerf, [] {
+  DispatchFromThreads(4, 50000);
+});
+
+MOZ_GTEST_BENCH(ThreadDispatch, SixteenProducersPerf, [] {
+  DispatchFromThreads(16, 10000);
+});
@@ -14,6 +14,7 @@
 #include "nsIRunnable.h"
 #include "nsThreadUtils.h"
 #include "mozilla/Atomics.h"
+#include "mozilla/BackgroundScheduler.h"
 #include "mozilla/Monitor.h"
 #include "gtest/gtest.h"
 
@@ -122,3 +123,75 @@ TEST(ThreadPool, Parallelism)
 
   pool->Shutdown();
 }
+
+TEST(ThreadPool, BackgroundSchedulerSerial)
+{
+  // A pool limited to one task at a time runs its tasks in order, one after
+  // another.
+  nsCOMPtr<nsIThreadPool> pool =
+    BackgroundScheduler::CreatePool(NS_LITERAL_CSTRING("TestSerial"), 1);
+
+  const int kTasks = 1000;
+  Atomic<int> running(0);
+  Atomic<int> next(0);
+  for (int i = 0; i < kTasks; ++i) {
+    pool->Dispatch(NS_NewRunnableFunction([&running, &next, i, pool] () {
+      EXPECT_EQ(++running, 1);
+      EXPECT_EQ(int(next), i);
+      bool onPool = false;
+      pool->IsOnCurrentThread(&onPool);
+      EXPECT_TRUE(onPool);
+      ++next;
+      --running;
+    }), NS_DISPATCH_NORMAL);
+  }
+
+  pool->Shutdown();
+  EXPECT_EQ(int(next), kTasks);
+
+  bool onPool = true;
+  pool->IsOnCurrentThread(&onPool);
+  EXPECT_FALSE(onPool);
+}
+
+TEST(ThreadPool, BackgroundSchedulerParallel)
+{
+  // Tasks of two pools, and the tasks they dispatch in turn, all run, with no
+  // more than each pool's limit running at once.
+  const uint32_t kLimit = 2;
+  nsCOMPtr<nsIThreadPool> pools[] = {
+    BackgroundScheduler::CreatePool(NS_LITERAL_CSTRING("TestHigh"), kLimit,
+                                    BackgroundScheduler::PRIORITY_HIGH),
+    BackgroundScheduler::CreatePool(NS_LITERAL_CSTRING("TestLow"), kLimit,
+                                    BackgroundScheduler::PRIORITY_LOW),
+  };
+
+  const int kTasks = 500;
+  Atomic<int> done(0);
+  Atomic<uint32_t> running[2];
+  for (int i = 0; i < kTasks; ++i) {
+    for (int p = 0; p < 2; ++p) {
+      nsCOMPtr<nsIThreadPool> pool = pools[p];
+      Atomic<uint32_t>& count = running[p];
+      pool->Dispatch(NS_NewRunnableFunction([pool, &count, &done] () {
+        EXPECT_LE(++count, kLimit);
+        --count;
+        // Dispatched from a worker, so this lands on its own deque.
+        pool->Dispatch(NS_NewRunnableFunction([&done] () { ++done; }),
+                       NS_DISPATCH_NORMAL);
+      }), NS_DISPATCH_NORMAL);
+    }
+  }
+
+  // The first round of tasks can't shut down their own pools, so wait for
+  // them to dispatch the second round before shutting the pools down.
+  while (done < 2 * kTasks) {
+    PR_Sleep(PR_MillisecondsToInterval(1));
+  }
+  pools[0]->Shutdown();
+  pools[1]->Shutdown();
+  EXPECT_EQ(int(done), 2 * kTasks);
+
+  nsCOMPtr<nsIRunnable> late = new Runnable();
+  EXPECT_TRUE(NS_FAILED(pools[0]->Dispatch(late, NS_DISPATCH_NORMAL)));
+}
@@ -188,4 +188,37 @@ TEST(UTF, NonASCII16)
   NonASCII16_helper(512);
 }
 
+/**
+ * This tests conversion of long strings that alternate between runs of ASCII
+ * and non-ASCII characters, in both directions, so that the bulk ASCII paths
+ * are entered and left at many offsets.
+ */
+TEST(UTF, MixedRuns)
+{
+  static const char16_t kNonASCII16[][3] = {
+    { 0xE9 }, { 0x4E2D }, { 0xD83D, 0xDE00 }
+  };
+  static const char* const kNonASCII8[] = {
+    "\xC3\xA9", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80"
+  };
+
+  for (size_t k = 0; k < ArrayLength(kNonASCII8); ++k) {
+    for (size_t run = 0; run < 40; ++run) {
+      nsString str16;
+      nsCString str8;
+      for (size_t rep = 0; rep < 4; ++rep) {
+        for (size_t i = 0; i < run; ++i) {
+          str16.Append(char16_t('a' + i % 26));
+          str8.Append(char('a' + i % 26));
+        }
+        str16.Append(kNonASCII16[k]);
+        str8.Append(kNonASCII8[k]);
+      }
+
+      EXPECT_TRUE(NS_ConvertUTF16toUTF8(str16).Equals(str8));
+      EXPECT_TRUE(NS_ConvertUTF8toUTF16(str8).Equals(str16));
+    }
+  }
+}
+
 } // namespace TestUTF
@@ -5,6 +5,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "mozilla/ArrayUtils.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/BackgroundHangMonitor.h"
 #include "mozilla/LinkedList.h"
 #include "mozilla/Monitor.h"
@@ -84,6 +85,12 @@ public:
   Monitor mLock;
   // Current time as seen by hang monitors
   PRIntervalTime mIntervalNow;
+  // How long the monitor thread waits between checks; PR_INTERVAL_NO_TIMEOUT
+  // when no monitored thread is active.
+  Atomic<PRIntervalTime> mWaitTime;
+  // Set by threads that stopped waiting, so that the monitor thread rescans
+  // them on its next periodic wakeup.
+  Atomic<bool> mRecheckNeeded;
   // List of BackgroundHangThread instances associated with each thread
   LinkedList<BackgroundHangThread> mHangThreads;
 
@@ -205,6 +212,8 @@ BackgroundHangManager::BackgroundHangManager()
   : mShutdown(false)
   , mLock("BackgroundHangManager")
   , mIntervalNow(0)
+  , mWaitTime(PR_INTERVAL_NO_WAIT)
+  , mRecheckNeeded(false)
 {
   // Lock so we don't race against the new monitor thread
   MonitorAutoLock autoLock(mLock);
@@ -248,6 +257,12 @@ BackgroundHangManager::RunMonitorThread()
   while (!mShutdown) {
 
     PR_ClearInterrupt();
+    /* Threads check mWaitTime after setting mRecheckNeeded, so either we see
+       their request here or they see how long we are going to wait. */
+    mWaitTime = waitTime;
+    if (waitTime == PR_INTERVAL_NO_TIMEOUT && mRecheckNeeded) {
+      waitTime = PR_INTERVAL_NO_WAIT;
+    }
     nsresult rv = autoLock.Wait(waitTime);
 
     PRIntervalTime newTime = PR_IntervalNow();
@@ -267,14 +282,16 @@ BackgroundHangManager::RunMonitorThread()
        keep the current waitTime and skip iterating through hang monitors. */
     if (MOZ_LIKELY(systemInterval < recheckTimeout &&
                    systemInterval >= waitTime &&
-                   rv == NS_OK)) {
+                   rv == NS_OK && !mRecheckNeeded)) {
       recheckTimeout -= systemInterval;
       continue;
     }
+    mRecheckNeeded = false;
 
     /* We are in one of the following scenarios,
      - Hang or permahang recheck timeout
      - Thread added/removed
+     - Thread became active
      - Thread wait or hang ended
        In all cases, we want to go through our list of hang
        monitors and update waitTime and recheckTimeout. */
@@ -460,9 +477,14 @@ BackgroundHangThread::NotifyActivity()
   if (mWaiting) {
     mInterval = intervalNow;
     mWaiting = false;
-    /* We have to wake up the manager thread because when all threads
-       are waiting, the manager thread waits indefinitely as well. */
-    mManager->Wakeup();
+    /* The manager thread picks us up on its next periodic wakeup. We only
+       have to wake it up if that could come too late to catch a hang of
+       ours, in particular when all threads were waiting, because then the
+       manager thread waits indefinitely as well. */
+    mManager->mRecheckNeeded = true;
+    if (mManager->mWaitTime > mTimeout / 4) {
+      mManager->Wakeup();
+    }
   } else {
     PRIntervalTime duration = intervalNow - mInterval;
     mStats.mActivity.Add(duration);
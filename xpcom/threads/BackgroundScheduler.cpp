@@ -0,0 +1,645 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mozilla/BackgroundScheduler.h"
+
+#include <algorithm>
+#include <deque>
+#include "mozilla/Atomics.h"
+#include "mozilla/CondVar.h"
+#include "mozilla/Logging.h"
+#include "mozilla/Mutex.h"
+#include "mozilla/StaticPtr.h"
+#include "mozilla/ThreadLocal.h"
+#include "mozilla/UniquePtr.h"
+#include "nsCOMArray.h"
+#include "nsThreadManager.h"
+#include "nsThreadSyncDispatch.h"
+#include "nsThreadUtils.h"
+#include "prsystem.h"
+#ifdef XP_WIN
+#include <objbase.h>
+#endif
+
+namespace mozilla {
+
+static LazyLogModule sSchedulerLog("BackgroundScheduler");
+#ifdef LOG
+#undef LOG
+#endif
+#define LOG(args) MOZ_LOG(sSchedulerLog, mozilla::LogLevel::Debug, args)
+
+typedef BackgroundScheduler::Priority Priority;
+
+// Worker threads use the same stack size as SharedThreadPool's threads, as
+// they run the same tasks.
+#if defined(MOZ_ASAN)
+static const uint32_t kWorkerStackSize = nsIThreadManager::DEFAULT_STACK_SIZE;
+#elif defined(XP_WIN) || defined(XP_MACOSX) || defined(LINUX)
+static const uint32_t kWorkerStackSize = 256 * 1024;
+#else
+static const uint32_t kWorkerStackSize = nsIThreadManager::DEFAULT_STACK_SIZE;
+#endif
+
+static const uint32_t kMinWorkers = 2;
+static const uint32_t kMaxWorkers = 16;
+
+class SchedulerPool final : public nsIThreadPool
+{
+public:
+  NS_DECL_THREADSAFE_ISUPPORTS
+  NS_DECL_NSIEVENTTARGET
+  NS_DECL_NSITHREADPOOL
+  using nsIEventTarget::Dispatch;
+
+  SchedulerPool(const nsACString& aName, uint32_t aThreadLimit,
+                Priority aPriority)
+    : mMutex("SchedulerPool::mMutex")
+    , mPriority(aPriority)
+    , mThreadLimit(aThreadLimit)
+    , mIdleThreadLimit(aThreadLimit)
+    , mIdleThreadTimeout(UINT32_MAX)
+    , mStackSize(kWorkerStackSize)
+    , mRunning(0)
+    , mShutdown(false)
+    , mName(aName)
+  {
+  }
+
+  // Called on a worker after one of this pool's tasks has run.
+  void TaskCompleted();
+
+private:
+  ~SchedulerPool() {}
+
+  nsresult PutEvent(already_AddRefed<nsIRunnable> aEvent);
+
+  // Hands pending tasks to the scheduler while fewer than mThreadLimit are
+  // running.
+  void SubmitPendingTasks();
+
+  Mutex mMutex;
+  const Priority mPriority;
+  uint32_t mThreadLimit;
+  uint32_t mIdleThreadLimit;
+  uint32_t mIdleThreadTimeout;
+  uint32_t mStackSize;
+  // Tasks handed to the scheduler that haven't completed yet.
+  uint32_t mRunning;
+  // Tasks waiting for mRunning to drop below mThreadLimit.
+  std::deque<nsCOMPtr<nsIRunnable>> mPending;
+  bool mShutdown;
+  // The thread in Shutdown(), woken when the last task completes.
+  nsCOMPtr<nsIThread> mShutdownThread;
+  nsCString mName;
+};
+
+struct SchedulerTask
+{
+  RefPtr<SchedulerPool> mPool;
+  nsCOMPtr<nsIRunnable> mEvent;
+};
+
+// A deque of tasks per priority. Its owner pushes and pops at the back, and
+// other workers steal from the front.
+class TaskDeques
+{
+public:
+  TaskDeques()
+    : mMutex("TaskDeques::mMutex")
+    , mCount(0)
+  {
+  }
+
+  void PushBack(SchedulerTask&& aTask, Priority aPriority)
+  {
+    MutexAutoLock lock(mMutex);
+    mLanes[aPriority].push_back(Move(aTask));
+    ++mCount;
+  }
+
+  bool Pop(Priority aPriority, bool aFromBack, SchedulerTask& aTask)
+  {
+    // Skip the lock for empty deques, which most are most of the time.
+    if (!mCount) {
+      return false;
+    }
+    MutexAutoLock lock(mMutex);
+    std::deque<SchedulerTask>& lane = mLanes[aPriority];
+    if (lane.empty()) {
+      return false;
+    }
+    if (aFromBack) {
+      aTask = Move(lane.back());
+      lane.pop_back();
+    } else {
+      aTask = Move(lane.front());
+      lane.pop_front();
+    }
+    --mCount;
+    return true;
+  }
+
+private:
+  Mutex mMutex;
+  std::deque<SchedulerTask> mLanes[BackgroundScheduler::PRIORITY_COUNT];
+  Atomic<uint32_t> mCount;
+};
+
+class Scheduler
+{
+public:
+  Scheduler()
+    : mWorkerCount(std::min(std::max(uint32_t(PR_GetNumberOfProcessors()),
+                                     kMinWorkers), kMaxWorkers))
+    , mDeques(MakeUnique<TaskDeques[]>(mWorkerCount))
+    , mIdleLock("Scheduler::mIdleLock")
+    , mIdleCondVar(mIdleLock, "Scheduler::mIdleCondVar")
+    , mQueued(0)
+    , mSleepers(0)
+    , mStarted(false)
+    , mShutdown(false)
+  {
+  }
+
+  uint32_t WorkerCount() const { return mWorkerCount; }
+
+  // Returns false if the scheduler has been shut down.
+  bool Submit(SchedulerTask&& aTask, Priority aPriority);
+
+  void RunWorker(uint32_t aIndex);
+
+  void Shutdown();
+
+  // The pool whose task is running on the current thread, if any.
+  static MOZ_THREAD_LOCAL(SchedulerPool*) sCurrentPool;
+  // The deques of the worker running on the current thread, if any.
+  static MOZ_THREAD_LOCAL(TaskDeques*) sLocalDeques;
+
+private:
+  void StartWorkers();
+  bool FindTask(uint32_t aIndex, SchedulerTask& aTask);
+
+  const uint32_t mWorkerCount;
+  UniquePtr<TaskDeques[]> mDeques;
+  // Tasks dispatched from threads that aren't workers.
+  TaskDeques mInjected;
+
+  // Guards sleeping and waking workers, and starting and stopping them.
+  Mutex mIdleLock;
+  CondVar mIdleCondVar;
+  // The number of tasks in all deques. It's incremented before a task is
+  // pushed, and a worker only sleeps after seeing it at zero with mSleepers
+  // incremented, so a submitter that sees no sleepers can't strand a task.
+  Atomic<uint32_t> mQueued;
+  Atomic<uint32_t> mSleepers;
+  Atomic<bool> mStarted;
+  Atomic<bool> mShutdown;
+  nsCOMArray<nsIThread> mThreads;
+  nsThreadPoolNaming mThreadNaming;
+};
+
+MOZ_THREAD_LOCAL(SchedulerPool*) Scheduler::sCurrentPool;
+MOZ_THREAD_LOCAL(TaskDeques*) Scheduler::sLocalDeques;
+
+// Created at startup and kept until exit, so that pools outliving Shutdown()
+// find it shut down rather than gone.
+static StaticAutoPtr<Scheduler> sScheduler;
+
+class SchedulerWorker final : public Runnable
+{
+public:
+  explicit SchedulerWorker(uint32_t aIndex) : mIndex(aIndex) {}
+
+  NS_IMETHOD Run() override
+  {
+    sScheduler->RunWorker(mIndex);
+    return NS_OK;
+  }
+
+private:
+  const uint32_t mIndex;
+};
+
+void
+Scheduler::StartWorkers()
+{
+  mIdleLock.AssertCurrentThreadOwns();
+  MOZ_ASSERT(!mStarted);
+
+  for (uint32_t i = 0; i < mWorkerCount; ++i) {
+    nsCOMPtr<nsIThread> thread;
+    nsresult rv = nsThreadManager::get().NewThread(0, kWorkerStackSize,
+                                                   getter_AddRefs(thread));
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      // The other workers steal this worker's share of the tasks; nothing is
+      // ever pushed to its deque, as that only happens on the worker itself.
+      continue;
+    }
+    nsCOMPtr<nsIRunnable> worker = new SchedulerWorker(i);
+    thread->Dispatch(worker.forget(), NS_DISPATCH_NORMAL);
+    mThreads.AppendObject(thread);
+  }
+  LOG(("BackgroundScheduler started %d workers", mThreads.Count()));
+  mStarted = true;
+}
+
+bool
+Scheduler::Submit(SchedulerTask&& aTask, Priority aPriority)
+{
+  if (!mStarted) {
+    MutexAutoLock lock(mIdleLock);
+    if (!mStarted && !mShutdown) {
+      StartWorkers();
+    }
+  }
+  if (mShutdown) {
+    return false;
+  }
+
+  ++mQueued;
+  TaskDeques* local = sLocalDeques.get();
+  if (local) {
+    local->PushBack(Move(aTask), aPriority);
+  } else {
+    mInjected.PushBack(Move(aTask), aPriority);
+  }
+
+  if (mSleepers) {
+    MutexAutoLock lock(mIdleLock);
+    mIdleCondVar.Notify();
+  }
+  return true;
+}
+
+bool
+Scheduler::FindTask(uint32_t aIndex, SchedulerTask& aTask)
+{
+  for (uint32_t p = 0; p < BackgroundScheduler::PRIORITY_COUNT; ++p) {
+    Priority priority = Priority(p);
+    if (mDeques[aIndex].Pop(priority, true, aTask) ||
+        mInjected.Pop(priority, false, aTask)) {
+      --mQueued;
+      return true;
+    }
+    for (uint32_t i = 1; i < mWorkerCount; ++i) {
+      uint32_t victim = (aIndex + i) % mWorkerCount;
+      if (mDeques[victim].Pop(priority, false, aTask)) {
+        --mQueued;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void
+Scheduler::RunWorker(uint32_t aIndex)
+{
+  mThreadNaming.SetThreadPoolName(NS_LITERAL_CSTRING("BgScheduler"));
+#ifdef XP_WIN
+  // Match SharedThreadPool's threads, which have MSCOM initialized in the
+  // multithreaded apartment.
+  HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+  sLocalDeques.set(&mDeques[aIndex]);
+
+  SchedulerTask task;
+  while (true) {
+    if (FindTask(aIndex, task)) {
+      sCurrentPool.set(task.mPool);
+      task.mEvent->Run();
+      sCurrentPool.set(nullptr);
+      // Release the event before the pool learns that it has completed.
+      task.mEvent = nullptr;
+      task.mPool->TaskCompleted();
+      task.mPool = nullptr;
+      continue;
+    }
+
+    MutexAutoLock lock(mIdleLock);
+    ++mSleepers;
+    if (!mQueued && !mShutdown) {
+      mIdleCondVar.Wait();
+    }
+    --mSleepers;
+    if (!mQueued && mShutdown) {
+      break;
+    }
+  }
+
+  sLocalDeques.set(nullptr);
+#ifdef XP_WIN
+  if (SUCCEEDED(hr)) {
+    CoUninitialize();
+  }
+#endif
+}
+
+void
+Scheduler::Shutdown()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+
+  nsCOMArray<nsIThread> threads;
+  {
+    MutexAutoLock lock(mIdleLock);
+    mShutdown = true;
+    mIdleCondVar.NotifyAll();
+    threads.AppendObjects(mThreads);
+    mThreads.Clear();
+  }
+
+  // Shut the workers down outside the lock, as they need it to exit.
+  for (int32_t i = 0; i < threads.Count(); ++i) {
+    threads[i]->Shutdown();
+  }
+}
+
+NS_IMPL_ISUPPORTS(SchedulerPool, nsIThreadPool, nsIEventTarget)
+
+nsresult
+SchedulerPool::PutEvent(already_AddRefed<nsIRunnable> aEvent)
+{
+  nsCOMPtr<nsIRunnable> event(aEvent);
+  {
+    MutexAutoLock lock(mMutex);
+    if (NS_WARN_IF(mShutdown)) {
+      return NS_ERROR_NOT_AVAILABLE;
+    }
+    if (mRunning >= mThreadLimit || !mPending.empty()) {
+      mPending.push_back(event.forget());
+      return NS_OK;
+    }
+    ++mRunning;
+  }
+
+  if (!sScheduler->Submit(SchedulerTask{ this, event.forget() }, mPriority)) {
+    MutexAutoLock lock(mMutex);
+    --mRunning;
+    return NS_ERROR_NOT_AVAILABLE;
+  }
+  return NS_OK;
+}
+
+void
+SchedulerPool::SubmitPendingTasks()
+{
+  while (true) {
+    nsCOMPtr<nsIRunnable> event;
+    {
+      MutexAutoLock lock(mMutex);
+      if (mPending.empty() || mRunning >= mThreadLimit) {
+        return;
+      }
+      event = mPending.front().forget();
+      mPending.pop_front();
+      ++mRunning;
+    }
+    if (!sScheduler->Submit(SchedulerTask{ this, event.forget() },
+                            mPriority)) {
+      // Only possible during shutdown; nothing can run these any more.
+      MutexAutoLock lock(mMutex);
+      --mRunning;
+      mPending.clear();
+      return;
+    }
+  }
+}
+
+void
+SchedulerPool::TaskCompleted()
+{
+  nsCOMPtr<nsIThread> shutdownThread;
+  {
+    MutexAutoLock lock(mMutex);
+    --mRunning;
+    if (mShutdown && !mRunning && mPending.empty()) {
+      shutdownThread = mShutdownThread;
+    }
+  }
+
+  SubmitPendingTasks();
+
+  if (shutdownThread) {
+    // Wake up Shutdown(), which spins the event loop until we're idle.
+    shutdownThread->Dispatch(NS_NewRunnableFunction([] () {}),
+                             NS_DISPATCH_NORMAL);
+  }
+}
+
+NS_IMETHODIMP
+SchedulerPool::DispatchFromScript(nsIRunnable* aEvent, uint32_t aFlags)
+{
+  nsCOMPtr<nsIRunnable> event(aEvent);
+  return Dispatch(event.forget(), aFlags);
+}
+
+NS_IMETHODIMP
+SchedulerPool::Dispatch(already_AddRefed<nsIRunnable> aEvent, uint32_t aFlags)
+{
+  if (aFlags & DISPATCH_SYNC) {
+    nsCOMPtr<nsIThread> thread;
+    nsThreadManager::get().GetCurrentThread(getter_AddRefs(thread));
+    if (NS_WARN_IF(!thread)) {
+      return NS_ERROR_NOT_AVAILABLE;
+    }
+
+    RefPtr<nsThreadSyncDispatch> wrapper =
+      new nsThreadSyncDispatch(thread, Move(aEvent));
+    nsresult rv = PutEvent(do_AddRef(wrapper));
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      return rv;
+    }
+
+    while (wrapper->IsPending()) {
+      NS_ProcessNextEvent(thread);
+    }
+    return NS_OK;
+  }
+
+  NS_ASSERTION(aFlags == NS_DISPATCH_NORMAL ||
+               aFlags == NS_DISPATCH_AT_END, "unexpected dispatch flags");
+  return PutEvent(Move(aEvent));
+}
+
+NS_IMETHODIMP
+SchedulerPool::DelayedDispatch(already_AddRefed<nsIRunnable>, uint32_t)
+{
+  return NS_ERROR_NOT_IMPLEMENTED;
+}
+
+NS_IMETHODIMP
+SchedulerPool::IsOnCurrentThread(bool* aResult)
+{
+  *aResult = Scheduler::sCurrentPool.get() == this;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::Shutdown()
+{
+  MOZ_ASSERT(Scheduler::sCurrentPool.get() != this,
+             "Can't shut a pool down from one of its own tasks");
+
+  nsCOMPtr<nsIThread> thread;
+  nsThreadManager::get().GetCurrentThread(getter_AddRefs(thread));
+  {
+    MutexAutoLock lock(mMutex);
+    mShutdown = true;
+    mShutdownThread = thread;
+  }
+
+  // Let the queued tasks run, as nsThreadPool does.
+  while (true) {
+    {
+      MutexAutoLock lock(mMutex);
+      if (!mRunning && mPending.empty()) {
+        mShutdownThread = nullptr;
+        break;
+      }
+    }
+    NS_ProcessNextEvent(thread, true);
+  }
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::GetThreadLimit(uint32_t* aValue)
+{
+  MutexAutoLock lock(mMutex);
+  *aValue = mThreadLimit;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::SetThreadLimit(uint32_t aValue)
+{
+  {
+    MutexAutoLock lock(mMutex);
+    mThreadLimit = aValue;
+    if (mIdleThreadLimit > mThreadLimit) {
+      mIdleThreadLimit = mThreadLimit;
+    }
+  }
+  SubmitPendingTasks();
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::GetIdleThreadLimit(uint32_t* aValue)
+{
+  MutexAutoLock lock(mMutex);
+  *aValue = mIdleThreadLimit;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::SetIdleThreadLimit(uint32_t aValue)
+{
+  MutexAutoLock lock(mMutex);
+  mIdleThreadLimit = std::min(aValue, mThreadLimit);
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::GetIdleThreadTimeout(uint32_t* aValue)
+{
+  MutexAutoLock lock(mMutex);
+  *aValue = mIdleThreadTimeout;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::SetIdleThreadTimeout(uint32_t aValue)
+{
+  MutexAutoLock lock(mMutex);
+  mIdleThreadTimeout = aValue;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::GetThreadStackSize(uint32_t* aValue)
+{
+  MutexAutoLock lock(mMutex);
+  *aValue = mStackSize;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::SetThreadStackSize(uint32_t aValue)
+{
+  // Tasks run on the scheduler's workers, whatever their pool asks for.
+  MutexAutoLock lock(mMutex);
+  mStackSize = aValue;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::GetListener(nsIThreadPoolListener** aListener)
+{
+  *aListener = nullptr;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+SchedulerPool::SetListener(nsIThreadPoolListener* aListener)
+{
+  // The workers don't belong to any one pool, so there are no thread
+  // creation or shutdown events to report.
+  return NS_ERROR_NOT_IMPLEMENTED;
+}
+
+NS_IMETHODIMP
+SchedulerPool::SetName(const nsACString& aName)
+{
+  MutexAutoLock lock(mMutex);
+  mName = aName;
+  return NS_OK;
+}
+
+/* static */ already_AddRefed<nsIThreadPool>
+BackgroundScheduler::CreatePool(const nsACString& aName, uint32_t aThreadLimit,
+                                Priority aPriority)
+{
+  MOZ_ASSERT(sScheduler);
+  MOZ_ASSERT(aPriority < PRIORITY_COUNT);
+  nsCOMPtr<nsIThreadPool> pool =
+    new SchedulerPool(aName, aThreadLimit, aPriority);
+  return pool.forget();
+}
+
+/* static */ uint32_t
+BackgroundScheduler::WorkerCount()
+{
+  MOZ_ASSERT(sScheduler);
+  return sScheduler->WorkerCount();
+}
+
+/* static */ void
+BackgroundScheduler::InitStatics()
+{
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(!sScheduler);
+  if (!Scheduler::sCurrentPool.init()) {
+    MOZ_CRASH("Could not init BackgroundScheduler::sCurrentPool");
+  }
+  if (!Scheduler::sLocalDeques.init()) {
+    MOZ_CRASH("Could not init BackgroundScheduler::sLocalDeques");
+  }
+  sScheduler = new Scheduler();
+}
+
+/* static */ void
+BackgroundScheduler::Shutdown()
+{
+  // Minimal XPCOM doesn't create the scheduler.
+  if (sScheduler) {
+    sScheduler->Shutdown();
+  }
+}
+
+} // namespace mozilla
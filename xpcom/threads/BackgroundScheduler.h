@@ -0,0 +1,66 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BackgroundScheduler_h_
+#define BackgroundScheduler_h_
+
+#include "mozilla/AlreadyAddRefed.h"
+#include "nsIThreadPool.h"
+#include "nsStringFwd.h"
+
+namespace mozilla {
+
+// A process-wide set of worker threads, one per core, shared by any number of
+// logical thread pools. Subsystems that would otherwise each create their own
+// threads can instead register as clients by creating a pool here, so the
+// process doesn't run many more busy threads than it has cores.
+//
+// Each worker has its own deque of tasks. Tasks dispatched from a worker go
+// to the back of its deque, and the worker takes its next task from there,
+// while it's still warm in the cache. Tasks dispatched from other threads go
+// to a shared queue. An idle worker takes from the shared queue, and then
+// steals from the front of the other workers' deques. Every deque has a lane
+// per Priority, and higher priority lanes are always searched first.
+//
+// The pools returned by CreatePool() implement nsIThreadPool, so TaskQueue
+// and SharedThreadPool can be layered on them unchanged. A pool's thread limit
+// is the number of its tasks that may run at once, so a pool with a limit of
+// 1 runs its tasks serially, in dispatch order. Pool tasks run on whichever
+// worker is free, and shouldn't block for long, as that takes a core away
+// from every other client. The stack size, idle limits and listener of these
+// pools are ignored, as the workers belong to the scheduler.
+class BackgroundScheduler
+{
+public:
+  enum Priority : uint32_t
+  {
+    PRIORITY_HIGH,
+    PRIORITY_NORMAL,
+    PRIORITY_LOW,
+    PRIORITY_COUNT
+  };
+
+  // Creates a logical pool that runs up to aThreadLimit of its tasks at once
+  // on the scheduler's workers. Can be called on any thread.
+  static already_AddRefed<nsIThreadPool>
+  CreatePool(const nsACString& aName, uint32_t aThreadLimit,
+             Priority aPriority = PRIORITY_NORMAL);
+
+  // The number of worker threads, which are started on the first dispatch.
+  static uint32_t WorkerCount();
+
+  // Called once at startup, on the main thread.
+  static void InitStatics();
+
+  // Waits for the queued tasks to run and joins the workers. Called on the
+  // main thread at xpcom-shutdown-threads, after the pools have been shut
+  // down. Pools can't dispatch after this.
+  static void Shutdown();
+};
+
+} // namespace mozilla
+
+#endif // BackgroundScheduler_h_
@@ -0,0 +1,48 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef mozilla_IdlePeriod_h
+#define mozilla_IdlePeriod_h
+
+#include "mozilla/TimeStamp.h"
+#include "nsISupportsImpl.h"
+
+namespace mozilla {
+
+/**
+ * An IdlePeriod tells a thread how long it can spend running idle runnables
+ * (see nsThread::IdleDispatch) once it has no other events to process.
+ *
+ * The base class has no idea of what else the thread has to do, and lets idle
+ * runnables run whenever the thread's event queue is empty.  Subclasses
+ * registered with nsThread::RegisterIdlePeriod can do better, for example
+ * the main thread's one knows when the next refresh driver tick is due.
+ */
+class IdlePeriod
+{
+public:
+  NS_INLINE_DECL_REFCOUNTING(IdlePeriod)
+
+  IdlePeriod() {}
+
+  /**
+   * Returns an estimate of when the current idle period ends.  A time in the
+   * past means that the thread isn't idle, and a null TimeStamp that the idle
+   * period has no known end.  Only called on the thread that this is
+   * registered with.
+   */
+  virtual TimeStamp GetIdlePeriodHint()
+  {
+    return TimeStamp();
+  }
+
+protected:
+  virtual ~IdlePeriod() {}
+};
+
+} // namespace mozilla
+
+#endif // mozilla_IdlePeriod_h
@@ -170,6 +170,7 @@ protected:
     , mMutex("MozPromise Mutex")
     , mHaveRequest(false)
     , mIsCompletionPromise(aIsCompletionPromise)
+    , mUseSynchronousTaskDispatch(false)
   {
     PROMISE_LOG("%s creating MozPromise (%p)", mCreationSite, this);
   }
@@ -294,45 +295,65 @@ protected:
   /*
    * A ThenValue tracks a single consumer waiting on the promise. When a consumer
    * invokes promise->Then(...), a ThenValue is created. Once the Promise is
-   * resolved or rejected, a {Resolve,Reject}Runnable is dispatched, which
-   * invokes the resolve/reject method and then deletes the ThenValue.
+   * resolved or rejected, the ThenValue's ResolveOrRejectRunnable is
+   * dispatched, which invokes the resolve/reject method. The ThenValue is
+   * deleted once the runnable and any Request holders have released it.
    */
   class ThenValueBase : public Request
   {
   public:
-    class ResolveOrRejectRunnable : public Runnable
+    // The runnable that delivers the promise's value to the response target.
+    // A ThenValue is dispatched at most once, so rather than allocating a
+    // runnable for each resolution we embed one in the ThenValue, sharing its
+    // refcount. The promise is held alive by mDispatchedPromise until the
+    // runnable runs.
+    class ResolveOrRejectRunnable final : public nsIRunnable
     {
     public:
-      ResolveOrRejectRunnable(ThenValueBase* aThenValue, MozPromise* aPromise)
-        : mThenValue(aThenValue)
-        , mPromise(aPromise)
+      explicit ResolveOrRejectRunnable(ThenValueBase* aThenValue)
+        : mThenValue(aThenValue) {}
+
+      NS_IMETHOD QueryInterface(REFNSIID aIID, void** aInstancePtr) override
       {
-        MOZ_DIAGNOSTIC_ASSERT(!mPromise->IsPending());
+        if (aIID.Equals(NS_GET_IID(nsIRunnable)) ||
+            aIID.Equals(NS_GET_IID(nsISupports))) {
+          *aInstancePtr = static_cast<nsIRunnable*>(this);
+          AddRef();
+          return NS_OK;
+        }
+        *aInstancePtr = nullptr;
+        return NS_NOINTERFACE;
       }
 
-      ~ResolveOrRejectRunnable()
+      NS_IMETHOD_(MozExternalRefCountType) AddRef() override
       {
-        if (mThenValue) {
-          mThenValue->AssertIsDead();
-        }
+        return mThenValue->AddRef();
+      }
+
+      NS_IMETHOD_(MozExternalRefCountType) Release() override
+      {
+        return mThenValue->Release();
       }
 
       NS_IMETHOD Run() override
       {
         PROMISE_LOG("ResolveOrRejectRunnable::Run() [this=%p]", this);
-        mThenValue->DoResolveOrReject(mPromise->Value());
-        mThenValue = nullptr;
-        mPromise = nullptr;
+        RefPtr<MozPromise> promise = mThenValue->mDispatchedPromise.forget();
+        MOZ_DIAGNOSTIC_ASSERT(promise);
+        mThenValue->DoResolveOrReject(promise->Value());
         return NS_OK;
       }
 
     private:
-      RefPtr<ThenValueBase> mThenValue;
-      RefPtr<MozPromise> mPromise;
+      // Not a strong reference: this object is a member of *mThenValue.
+      ThenValueBase* const mThenValue;
     };
 
     explicit ThenValueBase(AbstractThread* aResponseTarget, const char* aCallSite)
-      : mResponseTarget(aResponseTarget), mCallSite(aCallSite) {}
+      : mResponseTarget(aResponseTarget)
+      , mCallSite(aCallSite)
+      , mRunnable(this)
+    {}
 
     MozPromise* CompletionPromise() override
     {
@@ -365,9 +386,10 @@ protected:
     {
       aPromise->mMutex.AssertCurrentThreadOwns();
       MOZ_ASSERT(!aPromise->IsPending());
+      MOZ_DIAGNOSTIC_ASSERT(!mDispatchedPromise && !Request::mComplete);
 
-      RefPtr<Runnable> runnable =
-        static_cast<Runnable*>(new (typename ThenValueBase::ResolveOrRejectRunnable)(this, aPromise));
+      mDispatchedPromise = aPromise;
+      nsCOMPtr<nsIRunnable> runnable = &mRunnable;
       PROMISE_LOG("%s Then() call made from %s [Runnable=%p, Promise=%p, ThenValue=%p]",
                   aPromise->mValue.IsResolve() ? "Resolving" : "Rejecting", ThenValueBase::mCallSite,
                   runnable.get(), aPromise, this);
@@ -379,6 +401,23 @@ protected:
       mResponseTarget->Dispatch(runnable.forget(), AbstractThread::DontAssertDispatchSuccess);
     }
 
+    bool IsResponseTargetCurrentThread() const
+    {
+      return mResponseTarget->IsCurrentThreadIn();
+    }
+
+    // Runs the callback on the current thread instead of dispatching it. Only
+    // used by MozPromise::Private in synchronous task dispatch mode, after the
+    // promise lock has been released.
+    void ResolveOrRejectSynchronously(MozPromise* aPromise)
+    {
+      MOZ_ASSERT(IsResponseTargetCurrentThread());
+      PROMISE_LOG("%s Then() call made from %s synchronously [Promise=%p, ThenValue=%p]",
+                  aPromise->Value().IsResolve() ? "Resolving" : "Rejecting",
+                  ThenValueBase::mCallSite, aPromise, this);
+      DoResolveOrReject(aPromise->Value());
+    }
+
     virtual void Disconnect() override
     {
       MOZ_ASSERT(ThenValueBase::mResponseTarget->IsCurrentThreadIn());
@@ -393,6 +432,15 @@ protected:
     }
 
   protected:
+    virtual ~ThenValueBase()
+    {
+      // Our runnable was dispatched and dropped without running, which happens
+      // when the response target has shut down.
+      if (mDispatchedPromise) {
+        ThenValueBase::AssertIsDead();
+      }
+    }
+
     virtual already_AddRefed<MozPromise> DoResolveOrRejectInternal(const ResolveOrRejectValue& aValue) = 0;
 
     void DoResolveOrReject(const ResolveOrRejectValue& aValue)
@@ -432,6 +480,10 @@ protected:
     RefPtr<MozPromise> mCompletionPromise;
 
     const char* mCallSite;
+
+    // Set while our runnable is in flight.
+    RefPtr<MozPromise> mDispatchedPromise;
+    ResolveOrRejectRunnable mRunnable;
   };
 
   /*
@@ -660,11 +712,22 @@ protected:
     return mValue;
   }
 
-  void DispatchAll()
+  typedef AutoTArray<RefPtr<ThenValueBase>, 2> SynchronousThenValues;
+
+  // Dispatches the pending ThenValues and forwards our value to the chained
+  // promises. In synchronous task dispatch mode, the ThenValues that target
+  // the current thread are appended to aSynchronous instead, for the caller to
+  // run once it has released the lock.
+  void DispatchAll(SynchronousThenValues& aSynchronous)
   {
     mMutex.AssertCurrentThreadOwns();
     for (size_t i = 0; i < mThenValues.Length(); ++i) {
-      mThenValues[i]->Dispatch(this);
+      if (mUseSynchronousTaskDispatch &&
+          mThenValues[i]->IsResponseTargetCurrentThread()) {
+        aSynchronous.AppendElement(Move(mThenValues[i]));
+      } else {
+        mThenValues[i]->Dispatch(this);
+      }
     }
     mThenValues.Clear();
 
@@ -704,6 +767,7 @@ protected:
   nsTArray<RefPtr<Private>> mChainedPromises;
   bool mHaveRequest;
   const bool mIsCompletionPromise;
+  bool mUseSynchronousTaskDispatch;
 };
 
 template<typename ResolveValueT, typename RejectValueT, bool IsExclusive>
@@ -717,31 +781,83 @@ public:
   template<typename ResolveValueT_>
   void Resolve(ResolveValueT_&& aResolveValue, const char* aResolveSite)
   {
-    MutexAutoLock lock(mMutex);
-    MOZ_ASSERT(IsPending());
-    PROMISE_LOG("%s resolving MozPromise (%p created at %s)", aResolveSite, this, mCreationSite);
-    mValue.SetResolve(Forward<ResolveValueT_>(aResolveValue));
-    DispatchAll();
+    SynchronousThenValues synchronous;
+    {
+      MutexAutoLock lock(mMutex);
+      MOZ_ASSERT(IsPending());
+      PROMISE_LOG("%s resolving MozPromise (%p created at %s)", aResolveSite, this, mCreationSite);
+      mValue.SetResolve(Forward<ResolveValueT_>(aResolveValue));
+      DispatchAll(synchronous);
+    }
+    RunSynchronously(synchronous);
   }
 
   template<typename RejectValueT_>
   void Reject(RejectValueT_&& aRejectValue, const char* aRejectSite)
   {
-    MutexAutoLock lock(mMutex);
-    MOZ_ASSERT(IsPending());
-    PROMISE_LOG("%s rejecting MozPromise (%p created at %s)", aRejectSite, this, mCreationSite);
-    mValue.SetReject(Forward<RejectValueT_>(aRejectValue));
-    DispatchAll();
+    SynchronousThenValues synchronous;
+    {
+      MutexAutoLock lock(mMutex);
+      MOZ_ASSERT(IsPending());
+      PROMISE_LOG("%s rejecting MozPromise (%p created at %s)", aRejectSite, this, mCreationSite);
+      mValue.SetReject(Forward<RejectValueT_>(aRejectValue));
+      DispatchAll(synchronous);
+    }
+    RunSynchronously(synchronous);
   }
 
   template<typename ResolveOrRejectValue_>
   void ResolveOrReject(ResolveOrRejectValue_&& aValue, const char* aSite)
+  {
+    SynchronousThenValues synchronous;
+    {
+      MutexAutoLock lock(mMutex);
+      MOZ_ASSERT(IsPending());
+      PROMISE_LOG("%s resolveOrRejecting MozPromise (%p created at %s)", aSite, this, mCreationSite);
+      mValue = Forward<ResolveOrRejectValue_>(aValue);
+      DispatchAll(synchronous);
+    }
+    RunSynchronously(synchronous);
+  }
+
+  // Opts this promise into synchronous task dispatch. When the promise is
+  // resolved or rejected, the callbacks of the Then() calls whose response
+  // thread is the resolving thread are invoked directly, before Resolve()
+  // returns, instead of being dispatched through the event loop. The
+  // guarantees are:
+  //
+  //   - The callbacks run in the order the Then() calls were made, after the
+  //     callbacks targeting other threads have been dispatched and the value
+  //     has been forwarded to any chained promises.
+  //   - They run with the promise lock released, so they may call Then() on
+  //     this promise again. Such a Then() dispatches, as usual.
+  //   - Then() calls made after resolution always dispatch, so a callback
+  //     never runs within the Then() call that attached it.
+  //
+  // This saves an event loop round trip (and, with a TaskQueue, the tail
+  // dispatch) when the resolver and the consumer share a thread, but callers
+  // of Resolve() must be prepared for callbacks to run re-entrantly. Must be
+  // called before the promise is resolved or rejected.
+  void UseSynchronousTaskDispatch(const char* aSite)
   {
     MutexAutoLock lock(mMutex);
     MOZ_ASSERT(IsPending());
-    PROMISE_LOG("%s resolveOrRejecting MozPromise (%p created at %s)", aSite, this, mCreationSite);
-    mValue = Forward<ResolveOrRejectValue_>(aValue);
-    DispatchAll();
+    PROMISE_LOG("%s UseSynchronousTaskDispatch MozPromise (%p created at %s)",
+                aSite, this, mCreationSite);
+    mUseSynchronousTaskDispatch = true;
+  }
+
+private:
+  void RunSynchronously(SynchronousThenValues& aSynchronous)
+  {
+    if (aSynchronous.IsEmpty()) {
+      return;
+    }
+    // A callback may drop the last external reference to us.
+    RefPtr<Private> kungFuDeathGrip = this;
+    for (size_t i = 0; i < aSynchronous.Length(); ++i) {
+      aSynchronous[i]->ResolveOrRejectSynchronously(this);
+    }
   }
 };
 
@@ -5,7 +5,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "mozilla/SharedThreadPool.h"
+#include "mozilla/BackgroundScheduler.h"
 #include "mozilla/Monitor.h"
+#include "mozilla/Preferences.h"
 #include "mozilla/ReentrantMonitor.h"
 #include "mozilla/Services.h"
 #include "mozilla/StaticPtr.h"
@@ -27,6 +29,10 @@ static StaticAutoPtr<ReentrantMonitor> sMonitor;
 // Modified only on the main thread.
 static StaticAutoPtr<nsDataHashtable<nsCStringHashKey, SharedThreadPool*>> sPools;
 
+// Whether new pools run their tasks on the BackgroundScheduler's workers
+// rather than on threads of their own.
+static bool sUseBackgroundScheduler = false;
+
 static already_AddRefed<nsIThreadPool>
 CreateThreadPool(const nsCString& aName);
 
@@ -62,6 +68,9 @@ SharedThreadPool::InitStatics()
   nsCOMPtr<nsIObserverService> obsService = mozilla::services::GetObserverService();
   nsCOMPtr<nsIObserver> obs = new SharedThreadPoolShutdownObserver();
   obsService->AddObserver(obs, "xpcom-shutdown-threads", false);
+  Preferences::AddBoolVarCache(&sUseBackgroundScheduler,
+                               "threads.shared_pools.use_background_scheduler",
+                               false);
 }
 
 /* static */
@@ -201,6 +210,12 @@ SharedThreadPool::EnsureThreadLimitIsAtLeast(uint32_t aLimit)
 static already_AddRefed<nsIThreadPool>
 CreateThreadPool(const nsCString& aName)
 {
+  if (sUseBackgroundScheduler) {
+    // The scheduler's workers already have MSCOM initialized on Windows. The
+    // thread limit is set by our caller.
+    return BackgroundScheduler::CreatePool(aName, 4);
+  }
+
   nsresult rv;
   nsCOMPtr<nsIThreadPool> pool = do_CreateInstance(NS_THREADPOOL_CONTRACTID, &rv);
   NS_ENSURE_SUCCESS(rv, nullptr);
@@ -18,6 +18,8 @@
 #include "mozilla/ArrayUtils.h"
 #include "mozilla/BinarySearch.h"
 
+#include <algorithm>
+
 #include <math.h>
 
 using namespace mozilla;
@@ -35,7 +37,8 @@ TimerThread::TimerThread() :
   mShutdown(false),
   mWaiting(false),
   mNotified(false),
-  mSleeping(false)
+  mSleeping(false),
+  mNextSequence(0)
 {
 }
 
@@ -367,7 +370,10 @@ TimerThread::Shutdown()
     // might potentially call some code reentering the same lock
     // that leads to unexpected behavior or deadlock.
     // See bug 422472.
-    timers.AppendElements(mTimers);
+    for (const Entry& entry : mTimers) {
+      entry.mTimer->mTimerThreadIndex = -1;
+      timers.AppendElement(entry.mTimer);
+    }
     mTimers.Clear();
   }
 
@@ -449,7 +455,7 @@ TimerThread::Run()
       nsTimerImpl* timer = nullptr;
 
       if (!mTimers.IsEmpty()) {
-        timer = mTimers[0];
+        timer = mTimers[0].mTimer;
 
         if (now >= timer->mTimeout || forceRunThisTimer) {
     next:
@@ -504,7 +510,7 @@ TimerThread::Run()
       }
 
       if (!mTimers.IsEmpty()) {
-        timer = mTimers[0];
+        timer = mTimers[0].mTimer;
 
         TimeStamp timeout = timer->mTimeout;
 
@@ -612,14 +618,23 @@ TimerThread::AddTimerInternal(nsTimerImpl* aTimer)
     return -1;
   }
 
-  TimeStamp now = TimeStamp::Now();
+  // A timer can be re-added while it's still waiting to fire, for example if
+  // a repeating timer re-arms itself as it is re-initialized on another
+  // thread. Keep only the newest entry.
+  RemoveTimerInternal(aTimer);
 
-  TimerAdditionComparator c(now, aTimer);
-  nsTimerImpl** insertSlot = mTimers.InsertElementSorted(aTimer, c);
+  // Overdue timers fire in the order they were added, so an overdue timer
+  // goes behind those that are already waiting.
+  TimeStamp now = TimeStamp::Now();
+  TimeStamp timeout = aTimer->mTimeout > now ? aTimer->mTimeout : now;
 
-  if (!insertSlot) {
+  size_t index = mTimers.Length();
+  if (!mTimers.AppendElement(Entry(aTimer, timeout, mNextSequence++),
+                             mozilla::fallible)) {
     return -1;
   }
+  aTimer->mTimerThreadIndex = index;
+  index = SiftUp(index);
 
   NS_ADDREF(aTimer);
 
@@ -629,21 +644,97 @@ TimerThread::AddTimerInternal(nsTimerImpl* aTimer)
   aTimer->GetTLSTraceInfo();
 #endif
 
-  return insertSlot - mTimers.Elements();
+  return index;
 }
 
 bool
 TimerThread::RemoveTimerInternal(nsTimerImpl* aTimer)
 {
   mMonitor.AssertCurrentThreadOwns();
-  if (!mTimers.RemoveElement(aTimer)) {
+  if (aTimer->mTimerThreadIndex < 0) {
     return false;
   }
 
+  MOZ_ASSERT(mTimers[aTimer->mTimerThreadIndex].mTimer == aTimer);
+  RemoveEntryAt(aTimer->mTimerThreadIndex);
   ReleaseTimerInternal(aTimer);
   return true;
 }
 
+static const size_t kTimerHeapArity = 4;
+
+void
+TimerThread::SetEntry(size_t aIndex, const Entry& aEntry)
+{
+  mTimers[aIndex] = aEntry;
+  aEntry.mTimer->mTimerThreadIndex = aIndex;
+}
+
+size_t
+TimerThread::SiftUp(size_t aIndex)
+{
+  Entry entry = mTimers[aIndex];
+  while (aIndex > 0) {
+    size_t parent = (aIndex - 1) / kTimerHeapArity;
+    if (!(entry < mTimers[parent])) {
+      break;
+    }
+    SetEntry(aIndex, mTimers[parent]);
+    aIndex = parent;
+  }
+  SetEntry(aIndex, entry);
+  return aIndex;
+}
+
+void
+TimerThread::SiftDown(size_t aIndex)
+{
+  Entry entry = mTimers[aIndex];
+  size_t length = mTimers.Length();
+  for (;;) {
+    size_t child = aIndex * kTimerHeapArity + 1;
+    if (child >= length) {
+      break;
+    }
+    size_t end = std::min(child + kTimerHeapArity, length);
+    size_t earliest = child;
+    for (++child; child < end; ++child) {
+      if (mTimers[child] < mTimers[earliest]) {
+        earliest = child;
+      }
+    }
+    if (!(mTimers[earliest] < entry)) {
+      break;
+    }
+    SetEntry(aIndex, mTimers[earliest]);
+    aIndex = earliest;
+  }
+  SetEntry(aIndex, entry);
+}
+
+void
+TimerThread::RemoveEntryAt(size_t aIndex)
+{
+  mTimers[aIndex].mTimer->mTimerThreadIndex = -1;
+
+  size_t last = mTimers.Length() - 1;
+  if (aIndex != last) {
+    // Move the last entry into the hole, then wherever it belongs.
+    SetEntry(aIndex, mTimers[last]);
+  }
+  mTimers.RemoveElementAt(last);
+  if (aIndex == last) {
+    return;
+  }
+
+  if (aIndex > 0 &&
+      mTimers[aIndex] < mTimers[(aIndex - 1) / kTimerHeapArity]) {
+    SiftUp(aIndex);
+  } else {
+    SiftDown(aIndex);
+  }
+}
+
 void
 TimerThread::ReleaseTimerInternal(nsTimerImpl* aTimer)
 {
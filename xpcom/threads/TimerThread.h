@@ -62,7 +62,7 @@ private:
 
   // These two internal helper methods must be called while mMonitor is held.
   // AddTimerInternal returns the position where the timer was added in the
-  // list, or -1 if it failed.
+  // heap, so 0 if it is now the next to fire, or -1 if it failed.
   int32_t AddTimerInternal(nsTimerImpl* aTimer);
   bool    RemoveTimerInternal(nsTimerImpl* aTimer);
   void    ReleaseTimerInternal(nsTimerImpl* aTimer);
@@ -77,39 +77,40 @@ private:
   bool mNotified;
   bool mSleeping;
 
-  nsTArray<nsTimerImpl*> mTimers;
-};
-
-struct TimerAdditionComparator
-{
-  TimerAdditionComparator(const mozilla::TimeStamp& aNow,
-                          nsTimerImpl* aTimerToInsert) :
-    now(aNow)
-#ifdef DEBUG
-    , timerToInsert(aTimerToInsert)
-#endif
+  // A timer's place in mTimers. Timers fire in order of mTimeout, and in the
+  // order they were added for equal timeouts. A timer added when it is
+  // already overdue fires after the timers that were overdue before it.
+  struct Entry
   {
-  }
-
-  bool LessThan(nsTimerImpl* aFromArray, nsTimerImpl* aNewTimer) const
-  {
-    MOZ_ASSERT(aNewTimer == timerToInsert, "Unexpected timer ordering");
-
-    // Skip any overdue timers.
-    return aFromArray->mTimeout <= now ||
-           aFromArray->mTimeout <= aNewTimer->mTimeout;
-  }
-
-  bool Equals(nsTimerImpl* aFromArray, nsTimerImpl* aNewTimer) const
-  {
-    return false;
-  }
-
-private:
-  const mozilla::TimeStamp& now;
-#ifdef DEBUG
-  const nsTimerImpl* const timerToInsert;
-#endif
+    Entry(nsTimerImpl* aTimer, const TimeStamp& aTimeout, uint64_t aSequence)
+      : mTimer(aTimer)
+      , mTimeout(aTimeout)
+      , mSequence(aSequence)
+    {
+    }
+
+    bool operator<(const Entry& aOther) const
+    {
+      return mTimeout < aOther.mTimeout ||
+             (mTimeout == aOther.mTimeout && mSequence < aOther.mSequence);
+    }
+
+    nsTimerImpl* mTimer;
+    // The later of the timer's mTimeout and the time it was added.
+    TimeStamp mTimeout;
+    uint64_t mSequence;
+  };
+
+  // mTimers is a 4-ary min-heap, so adding a timer is O(log n) and each timer
+  // knows its position in nsTimerImpl::mTimerThreadIndex, so removing one is
+  // O(log n) without searching for it.
+  void SetEntry(size_t aIndex, const Entry& aEntry);
+  size_t SiftUp(size_t aIndex);
+  void SiftDown(size_t aIndex);
+  void RemoveEntryAt(size_t aIndex);
+
+  nsTArray<Entry> mTimers;
+  uint64_t mNextSequence;
 };
 
 #endif /* TimerThread_h___ */
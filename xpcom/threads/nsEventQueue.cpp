@@ -20,12 +20,15 @@ static LazyLogModule sEventQueueLog("nsEventQueue");
 #define LOG(args) MOZ_LOG(sEventQueueLog, mozilla::LogLevel::Debug, args)
 
 nsEventQueue::nsEventQueue(Mutex& aLock)
-  : mHead(nullptr)
-  , mTail(nullptr)
-  , mOffsetHead(0)
-  , mOffsetTail(0)
+  : mLock(aLock)
+  , mNewest(&mStub)
+  , mOldest(&mStub)
+  , mWaiters(0)
+  , mCount(0)
   , mEventsAvailable(aLock, "[nsEventQueue.mEventsAvailable]")
 {
+  mStub.mNext = nullptr;
+  mStub.mEvent = nullptr;
 }
 
 nsEventQueue::~nsEventQueue()
@@ -35,44 +38,101 @@ nsEventQueue::~nsEventQueue()
   NS_ASSERTION(IsEmpty(),
                "Non-empty event queue being destroyed; events being leaked.");
 
-  if (mHead) {
-    FreePage(mHead);
+  while (Node* node = Pop()) {
+    delete node;
   }
 }
 
+void
+nsEventQueue::Push(Node* aNode)
+{
+  aNode->mNext = nullptr;
+  Node* prev = mNewest.exchange(aNode);
+  // Until this store, consumers can't see aNode, or anything pushed after it.
+  prev->mNext = aNode;
+}
+
+nsEventQueue::Node*
+nsEventQueue::Pop()
+{
+  Node* oldest = mOldest;
+  Node* next = oldest->mNext;
+  if (oldest == &mStub) {
+    if (!next) {
+      return nullptr;
+    }
+    mOldest = next;
+    oldest = next;
+    next = next->mNext;
+  }
+  if (next) {
+    mOldest = next;
+    return oldest;
+  }
+
+  // oldest is the only node we can see.  If a producer is part way through
+  // pushing after it, wait for it to finish.
+  if (oldest != mNewest) {
+    return nullptr;
+  }
+
+  // Otherwise put the stub behind it so that it can be unlinked.
+  Push(&mStub);
+  next = oldest->mNext;
+  if (next) {
+    mOldest = next;
+    return oldest;
+  }
+  return nullptr;
+}
+
 bool
 nsEventQueue::GetEvent(bool aMayWait, nsIRunnable** aResult,
                        MutexAutoLock& aProofOfLock)
 {
-  while (IsEmpty()) {
-    if (!aMayWait) {
-      if (aResult) {
-        *aResult = nullptr;
+  if (!aResult) {
+    while (IsEmpty()) {
+      if (!aMayWait) {
+        return false;
       }
-      return false;
+      ++mWaiters;
+      if (IsEmpty()) {
+        LOG(("EVENTQ(%p): wait begin\n", this));
+        mEventsAvailable.Wait();
+        LOG(("EVENTQ(%p): wait end\n", this));
+      }
+      --mWaiters;
     }
-    LOG(("EVENTQ(%p): wait begin\n", this));
-    mEventsAvailable.Wait();
-    LOG(("EVENTQ(%p): wait end\n", this));
+    return true;
   }
 
-  if (aResult) {
-    MOZ_ASSERT(mOffsetHead < EVENTS_PER_PAGE);
-    MOZ_ASSERT_IF(mHead == mTail, mOffsetHead <= mOffsetTail);
-    *aResult = mHead->mEvents[mOffsetHead++];
-
-    MOZ_ASSERT(*aResult);
-    MOZ_ASSERT(mOffsetHead <= EVENTS_PER_PAGE);
-
-    // Check if mHead points to empty Page
-    if (mOffsetHead == EVENTS_PER_PAGE) {
-      Page* dead = mHead;
-      mHead = mHead->mNext;
-      FreePage(dead);
-      mOffsetHead = 0;
+  Node* node;
+  while (!(node = Pop())) {
+    if (!aMayWait) {
+      *aResult = nullptr;
+      return false;
+    }
+    // Producers only notify when they see a waiter, so look again after
+    // announcing ourselves in case one pushed just before.  Either way it
+    // can't notify until we release the lock by waiting.
+    ++mWaiters;
+    node = Pop();
+    if (!node) {
+      LOG(("EVENTQ(%p): wait begin\n", this));
+      mEventsAvailable.Wait();
+      LOG(("EVENTQ(%p): wait end\n", this));
+    }
+    --mWaiters;
+    if (node) {
+      break;
     }
   }
 
+  *aResult = node->mEvent;
+  MOZ_ASSERT(*aResult);
+  delete node;
+  --mCount;
+
   return true;
 }
 
@@ -80,30 +140,28 @@ void
 nsEventQueue::PutEvent(already_AddRefed<nsIRunnable>&& aRunnable,
                        MutexAutoLock& aProofOfLock)
 {
-  if (!mHead) {
-    mHead = NewPage();
-    MOZ_ASSERT(mHead);
-
-    mTail = mHead;
-    mOffsetHead = 0;
-    mOffsetTail = 0;
-  } else if (mOffsetTail == EVENTS_PER_PAGE) {
-    Page* page = NewPage();
-    MOZ_ASSERT(page);
-
-    mTail->mNext = page;
-    mTail = page;
-    mOffsetTail = 0;
-  }
-
-  nsIRunnable*& queueLocation = mTail->mEvents[mOffsetTail];
-  MOZ_ASSERT(!queueLocation);
-  queueLocation = aRunnable.take();
-  ++mOffsetTail;
+  Node* node = new Node();
+  node->mEvent = aRunnable.take();
+  ++mCount;
+  Push(node);
   LOG(("EVENTQ(%p): notify\n", this));
   mEventsAvailable.Notify();
 }
 
+void
+nsEventQueue::PutEventWithoutLock(already_AddRefed<nsIRunnable>&& aRunnable)
+{
+  Node* node = new Node();
+  node->mEvent = aRunnable.take();
+  ++mCount;
+  Push(node);
+  if (mWaiters) {
+    MutexAutoLock lock(mLock);
+    LOG(("EVENTQ(%p): notify\n", this));
+    mEventsAvailable.Notify();
+  }
+}
+
 void
 nsEventQueue::PutEvent(nsIRunnable* aRunnable, MutexAutoLock& aProofOfLock)
 {
@@ -114,33 +172,5 @@ nsEventQueue::PutEvent(nsIRunnable* aRunnable, MutexAutoLock& aProofOfLock)
 size_t
 nsEventQueue::Count(MutexAutoLock& aProofOfLock)
 {
-  // It is obvious count is 0 when the queue is empty.
-  if (!mHead) {
-    return 0;
-  }
-
-  /* How we count the number of events in the queue:
-   * 1. Let pageCount(x, y) denote the number of pages excluding the tail page
-   *    where x is the index of head page and y is the index of the tail page.
-   * 2. Then we have pageCount(x, y) = y - x.
-   *
-   * Ex: pageCount(0, 0) = 0 where both head and tail pages point to page 0.
-   *     pageCount(0, 1) = 1 where head points to page 0 and tail points page 1.
-   *
-   * 3. number of events = (EVENTS_PER_PAGE * pageCount(x, y))
-   *      - (empty slots in head page) + (non-empty slots in tail page)
-   *      = (EVENTS_PER_PAGE * pageCount(x, y)) - mOffsetHead + mOffsetTail
-   */
-
-  int count = -mOffsetHead;
-
-  // Compute (EVENTS_PER_PAGE * pageCount(x, y))
-  for (Page* page = mHead; page != mTail; page = page->mNext) {
-    count += EVENTS_PER_PAGE;
-  }
-
-  count += mOffsetTail;
-  MOZ_ASSERT(count >= 0);
-
-  return count;
+  return mCount;
 }
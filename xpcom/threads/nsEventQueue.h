@@ -8,6 +8,7 @@
 #define nsEventQueue_h__
 
 #include <stdlib.h>
+#include "mozilla/Atomics.h"
 #include "mozilla/CondVar.h"
 #include "mozilla/Mutex.h"
 #include "nsIRunnable.h"
@@ -17,6 +18,11 @@
 class nsThreadPool;
 
 // A threadsafe FIFO event queue...
+//
+// Events are kept in a linked multi-producer, single-consumer queue (Dmitry
+// Vyukov's intrusive MPSC queue), so adding an event needs no lock.  Taking
+// one out does: the lock serializes consumers, and lets them wait on
+// mEventsAvailable while the queue is empty.
 class nsEventQueue
 {
 public:
@@ -32,12 +38,19 @@ public:
   void PutEvent(already_AddRefed<nsIRunnable>&& aEvent,
                 MutexAutoLock& aProofOfLock);
 
+  // The same, for callers that don't hold the lock.  The lock is only taken
+  // if a consumer is waiting for an event and needs waking up.
+  void PutEventWithoutLock(already_AddRefed<nsIRunnable>&& aEvent);
+
   // This method gets an event from the event queue.  If mayWait is true, then
   // the method will block the calling thread until an event is available.  If
   // the event is null, then the method returns immediately indicating whether
   // or not an event is pending.  When the resulting event is non-null, the
   // caller is responsible for releasing the event object.  This method does
   // not alter the reference count of the resulting event.
+  //
+  // Without aMayWait, this can briefly report an event as pending but not
+  // return it, while the thread adding it is still linking it in.
   bool GetEvent(bool aMayWait, nsIRunnable** aEvent,
                 MutexAutoLock& aProofOfLock);
 
@@ -56,42 +69,37 @@ public:
   size_t Count(MutexAutoLock&);
 
 private:
-  bool IsEmpty()
-  {
-    return !mHead || (mHead == mTail && mOffsetHead == mOffsetTail);
-  }
-
-  enum
-  {
-    EVENTS_PER_PAGE = 255
-  };
-
-  // Page objects are linked together to form a simple deque.
-
-  struct Page
+  struct Node
   {
-    struct Page* mNext;
-    nsIRunnable* mEvents[EVENTS_PER_PAGE];
+    mozilla::Atomic<Node*> mNext;
+    nsIRunnable* mEvent;
   };
 
-  static_assert((sizeof(Page) & (sizeof(Page) - 1)) == 0,
-                "sizeof(Page) should be a power of two to avoid heap slop.");
+  // Links aNode in as the newest node.  Any thread can call this.
+  void Push(Node* aNode);
+  // Unlinks the oldest node, or returns null if the queue is empty or the
+  // oldest node's successor is still being linked in.  Only called with the
+  // lock held.
+  Node* Pop();
 
-  static Page* NewPage()
+  bool IsEmpty()
   {
-    return static_cast<Page*>(moz_xcalloc(1, sizeof(Page)));
+    return mOldest == &mStub && !mStub.mNext;
   }
 
-  static void FreePage(Page* aPage)
-  {
-    free(aPage);
-  }
+  mozilla::Mutex& mLock;
 
-  Page* mHead;
-  Page* mTail;
+  // mStub is in the queue whenever it would otherwise be empty, so there is
+  // always a node to link new ones to.
+  Node mStub;
+  // The end that events are added to.
+  mozilla::Atomic<Node*> mNewest;
+  // The end that events are taken from.  Protected by mLock.
+  Node* mOldest;
 
-  uint16_t mOffsetHead;  // offset into mHead where next item is removed
-  uint16_t mOffsetTail;  // offset into mTail where next item is added
+  // The number of consumers waiting in GetEvent.
+  mozilla::Atomic<uint32_t> mWaiters;
+  mozilla::Atomic<size_t> mCount;
   mozilla::CondVar mEventsAvailable;
 
   // These methods are made available to nsThreadPool as a hack, since
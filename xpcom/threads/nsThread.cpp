@@ -26,6 +26,7 @@
 #include "nsIObserverService.h"
 #include "mozilla/HangMonitor.h"
 #include "mozilla/IOInterposer.h"
+#include "mozilla/MemoryPressureCoordinator.h"
 #include "mozilla/ipc/MessageChannel.h"
 #include "mozilla/ipc/BackgroundChild.h"
 #include "mozilla/Services.h"
@@ -35,6 +36,7 @@
 #include "mozilla/Unused.h"
 #include "mozilla/dom/ScriptSettings.h"
 #include "nsThreadSyncDispatch.h"
+#include "nsIIdleRunnable.h"
 #include "LeakRefPtr.h"
 
 #ifdef MOZ_CRASHREPORTER
@@ -487,11 +489,23 @@ nsThread::ThreadFunc(void* aArg)
           // that no PutEvent can occur between testing that the event queue is
           // empty and setting mEventsAreDoomed!
           self->mEventsAreDoomed = true;
-          break;
+
+          // PutEvent adds events for mEventsRoot without mLock, so one might
+          // have checked mEventsAreDoomed before we set it. Wait for those to
+          // finish, and go round again if any of them added an event.
+          while (self->mLockFreePutEvents) {
+            self->mLockFreePutEventsDone.Wait();
+          }
+          if (!self->mEvents->HasPendingEvent(lock)) {
+            break;
+          }
+          self->mEventsAreDoomed = false;
         }
       }
       NS_ProcessPendingEvents(self);
     }
+
+    self->ClearIdleEvents();
   }
 
   mozilla::IOInterposer::UnregisterCurrentThread();
@@ -594,6 +608,8 @@ nsThread::nsThread(MainThreadFlag aMainThread, uint32_t aStackSize)
   , mScriptObserver(nullptr)
   , mEvents(WrapNotNull(&mEventsRoot))
   , mEventsRoot(mLock)
+  , mIdleEvents(mLock)
+  , mIdlePeriod(new IdlePeriod())
   , mPriority(PRIORITY_NORMAL)
   , mThread(nullptr)
   , mNestedEventLoopDepth(0)
@@ -601,6 +617,9 @@ nsThread::nsThread(MainThreadFlag aMainThread, uint32_t aStackSize)
   , mShutdownContext(nullptr)
   , mShutdownRequired(false)
   , mEventsAreDoomed(false)
+  , mLockFreePutEvents(0)
+  , mLockFreePutEventsDone(mLock, "nsThread.mLockFreePutEventsDone")
+  , mHasObserver(false)
   , mIsMainThread(aMainThread)
   , mCanInvokeJS(false)
 {
@@ -680,6 +699,38 @@ nsThread::PutEvent(already_AddRefed<nsIRunnable> aEvent, nsNestedEventTarget* aT
   LeakRefPtr<nsIRunnable> event(Move(aEvent));
   nsCOMPtr<nsIThreadObserver> obs;
 
+  if (!aTarget) {
+    // mEventsRoot is always there and is safe to add to from any thread, so
+    // only take mLock when there's an observer to read.  As below, get the
+    // observer before the event can run.
+    if (mHasObserver) {
+      MutexAutoLock lock(mLock);
+      obs = mObserver;
+    }
+
+    // The thread doesn't stop taking events while mLockFreePutEvents is
+    // non-zero.  Once it has doomed its events, it waits for the count to
+    // drop to zero, so the last of us to leave has to wake it.
+    ++mLockFreePutEvents;
+    bool doomed = mEventsAreDoomed;
+    if (!doomed) {
+      mEventsRoot.PutEventWithoutLock(event.take());
+    }
+    if (--mLockFreePutEvents == 0 && mEventsAreDoomed) {
+      MutexAutoLock lock(mLock);
+      mLockFreePutEventsDone.Notify();
+    }
+    if (doomed) {
+      NS_WARNING("An event was posted to a thread that will never run it (rejected)");
+      return NS_ERROR_UNEXPECTED;
+    }
+
+    if (obs) {
+      obs->OnDispatchedEvent(this);
+    }
+    return NS_OK;
+  }
+
   {
     MutexAutoLock lock(mLock);
     nsChainedEventQueue* queue = aTarget ? aTarget->mQueue : &mEventsRoot;
@@ -763,6 +814,65 @@ nsThread::DispatchInternal(already_AddRefed<nsIRunnable> aEvent, uint32_t aFlags
 //-----------------------------------------------------------------------------
 // nsIEventTarget
 
+nsresult
+nsThread::IdleDispatch(already_AddRefed<nsIRunnable> aEvent)
+{
+  // We want to leak the reference when we fail to dispatch it, so that
+  // we won't release the event in a wrong thread.
+  LeakRefPtr<nsIRunnable> event(Move(aEvent));
+
+  if (NS_WARN_IF(!event)) {
+    return NS_ERROR_INVALID_ARG;
+  }
+
+  if (NS_WARN_IF(PR_GetCurrentThread() != mThread)) {
+    return NS_ERROR_NOT_SAME_THREAD;
+  }
+
+  bool needWakeUp;
+  {
+    MutexAutoLock lock(mLock);
+    if (mEventsAreDoomed) {
+      NS_WARNING("An idle event was posted to a thread that will never run it (rejected)");
+      return NS_ERROR_UNEXPECTED;
+    }
+    mIdleEvents.PutEvent(event.take(), lock);
+    needWakeUp = !mEvents->HasPendingEvent(lock);
+  }
+
+  // Idle events don't notify the thread observer, so an event loop that only
+  // runs while there are pending events might never look at them.  Post an
+  // empty event to get the thread back into ProcessNextEvent.
+  if (needWakeUp) {
+    nsCOMPtr<nsIRunnable> wakeUp = new Runnable();
+    return PutEvent(wakeUp.forget(), nullptr);
+  }
+  return NS_OK;
+}
+
+void
+nsThread::RegisterIdlePeriod(already_AddRefed<IdlePeriod> aIdlePeriod)
+{
+  MOZ_ASSERT(PR_GetCurrentThread() == mThread);
+  mIdlePeriod = aIdlePeriod;
+  MOZ_ASSERT(mIdlePeriod);
+}
+
+void
+nsThread::ClearIdleEvents()
+{
+  MOZ_ASSERT(PR_GetCurrentThread() == mThread);
+
+  nsCOMPtr<nsIRunnable> event;
+  MutexAutoLock lock(mLock);
+  while (mIdleEvents.GetEvent(false, getter_AddRefs(event), lock)) {
+    // Release the event without holding the lock, its destructor might want
+    // to dispatch something.
+    MutexAutoUnlock unlock(mLock);
+    event = nullptr;
+  }
+}
+
 NS_IMETHODIMP
 nsThread::DispatchFromScript(nsIRunnable* aEvent, uint32_t aFlags)
 {
@@ -1012,6 +1122,55 @@ void canary_alarm_handler(int signum)
     }                                                                          \
   PR_END_MACRO
 
+void
+nsThread::GetEvent(bool aWait, nsIRunnable** aEvent,
+                   MutexAutoLock& aProofOfLock)
+{
+  // Idle events have lower priority than all normal events, so only look at
+  // them if there are no normal events pending.  Never wait for an idle event
+  // though: a normal event may come in at any time, and the idle period may
+  // have ended by then.
+  mEvents->GetEvent(false, aEvent, aProofOfLock);
+  if (!*aEvent) {
+    GetIdleEvent(aEvent, aProofOfLock);
+  }
+  if (!*aEvent && aWait) {
+    mEvents->GetEvent(true, aEvent, aProofOfLock);
+  }
+}
+
+void
+nsThread::GetIdleEvent(nsIRunnable** aEvent, MutexAutoLock& aProofOfLock)
+{
+  MOZ_ASSERT(!*aEvent);
+
+  if (!mIdleEvents.HasPendingEvent(aProofOfLock)) {
+    return;
+  }
+
+  TimeStamp deadline;
+  {
+    // The idle period may look at all kinds of things that want to take locks
+    // of their own.
+    MutexAutoUnlock unlock(mLock);
+    deadline = mIdlePeriod->GetIdlePeriodHint();
+  }
+
+  // A normal event may have come in while the lock was dropped.
+  if (mEvents->HasPendingEvent(aProofOfLock) ||
+      (!deadline.IsNull() && deadline <= TimeStamp::Now())) {
+    return;
+  }
+
+  mIdleEvents.GetEvent(false, aEvent, aProofOfLock);
+  if (*aEvent && !deadline.IsNull()) {
+    nsCOMPtr<nsIIdleRunnable> idleEvent = do_QueryInterface(*aEvent);
+    if (idleEvent) {
+      idleEvent->SetDeadline(deadline);
+    }
+  }
+}
+
 NS_IMETHODIMP
 nsThread::ProcessNextEvent(bool aMayWait, bool* aResult)
 {
@@ -1069,7 +1228,7 @@ nsThread::ProcessNextEvent(bool aMayWait, bool* aResult)
     nsCOMPtr<nsIRunnable> event;
     {
       MutexAutoLock lock(mLock);
-      mEvents->GetEvent(reallyWait, getter_AddRefs(event), lock);
+      GetEvent(reallyWait, getter_AddRefs(event), lock);
     }
 
     *aResult = (event.get() != nullptr);
@@ -1175,6 +1334,7 @@ nsThread::SetObserver(nsIThreadObserver* aObs)
 
   MutexAutoLock lock(mLock);
   mObserver = aObs;
+  mHasObserver = !!aObs;
   return NS_OK;
 }
 
@@ -1309,6 +1469,10 @@ nsThread::DoMainThreadSpecificProcessing(bool aReallyWait)
   if (!ShuttingDown()) {
     MemoryPressureState mpPending = NS_GetPendingMemoryPressure();
     if (mpPending != MemPressure_None) {
+      // Let caches that registered with the coordinator give memory back,
+      // cheapest to rebuild first, before everything else reacts.
+      MemoryPressureCoordinator::ReclaimForMemoryPressure(mpPending);
+
       nsCOMPtr<nsIObserverService> os = services::GetObserverService();
 
       // Use no-forward to prevent the notifications from being transferred to
@@ -7,6 +7,7 @@
 #ifndef nsThread_h__
 #define nsThread_h__
 
+#include "mozilla/CondVar.h"
 #include "mozilla/Mutex.h"
 #include "nsIThreadInternal.h"
 #include "nsISupportsPriority.h"
@@ -15,6 +16,7 @@
 #include "nsString.h"
 #include "nsTObserverArray.h"
 #include "mozilla/Attributes.h"
+#include "mozilla/IdlePeriod.h"
 #include "mozilla/NotNull.h"
 #include "nsAutoPtr.h"
 #include "mozilla/AlreadyAddRefed.h"
@@ -81,6 +83,21 @@ public:
 
   void WaitForAllAsynchronousShutdowns();
 
+  // Queue aEvent to run on this thread once it has nothing else to do, and
+  // only while the thread's idle period (see mozilla::IdlePeriod) hasn't
+  // ended.  Idle events run in the order they were dispatched, after all
+  // pending normal events.  Must be called on this thread.  If aEvent
+  // implements nsIIdleRunnable, it is told the deadline before it runs.
+  nsresult IdleDispatch(already_AddRefed<nsIRunnable> aEvent);
+
+  // Replace the idle period used to decide when idle events may run.  Must be
+  // called on this thread.
+  void RegisterIdlePeriod(already_AddRefed<mozilla::IdlePeriod> aIdlePeriod);
+
+  // Drop the idle events that haven't run yet.  Called when the thread shuts
+  // down, since idle events are never worth waiting for.
+  void ClearIdleEvents();
+
 #ifdef MOZ_CRASHREPORTER
   enum class ShouldSaveMemoryReport
   {
@@ -127,6 +144,12 @@ protected:
   nsresult DispatchInternal(already_AddRefed<nsIRunnable> aEvent,
                             uint32_t aFlags, nsNestedEventTarget* aTarget);
 
+  // Get the next event to run: a normal event if there is one, else an idle
+  // event if the idle period allows, else wait for a normal event if aWait.
+  void GetEvent(bool aWait, nsIRunnable** aEvent,
+                mozilla::MutexAutoLock& aProofOfLock);
+  void GetIdleEvent(nsIRunnable** aEvent, mozilla::MutexAutoLock& aProofOfLock);
+
   struct nsThreadShutdownContext* ShutdownInternal(bool aSync);
 
   // Wrapper for nsEventQueue that supports chaining.
@@ -156,6 +179,11 @@ protected:
       mQueue.PutEvent(mozilla::Move(aEvent), aProofOfLock);
     }
 
+    void PutEventWithoutLock(already_AddRefed<nsIRunnable> aEvent)
+    {
+      mQueue.PutEventWithoutLock(mozilla::Move(aEvent));
+    }
+
     bool HasPendingEvent(mozilla::MutexAutoLock& aProofOfLock)
     {
       return mQueue.HasPendingEvent(aProofOfLock);
@@ -197,6 +225,8 @@ protected:
   // another thread).  This means that we can avoid holding the lock while
   // using mObserver and mEvents on the thread itself.  When calling PutEvent
   // on mEvents, we have to hold the lock to synchronize with PopEventQueue.
+  // Events for mEventsRoot are the exception: they are added without the
+  // lock, see PutEvent.
   mozilla::Mutex mLock;
 
   nsCOMPtr<nsIThreadObserver> mObserver;
@@ -208,6 +238,12 @@ protected:
   NotNull<nsChainedEventQueue*> mEvents;  // never null
   nsChainedEventQueue mEventsRoot;
 
+  // Only modified on the thread itself, but protected by mLock like mEvents
+  // since nsEventQueue wants proof of it.
+  nsEventQueue mIdleEvents;
+  // Only accessed on the thread itself.
+  RefPtr<mozilla::IdlePeriod> mIdlePeriod;
+
   int32_t   mPriority;
   PRThread* mThread;
   uint32_t  mNestedEventLoopDepth;
@@ -220,7 +256,15 @@ protected:
 
   bool mShutdownRequired;
   // Set to true when events posted to this thread will never run.
-  bool mEventsAreDoomed;
+  mozilla::Atomic<bool> mEventsAreDoomed;
+  // The number of PutEvent calls adding to mEventsRoot without mLock that
+  // have checked mEventsAreDoomed but may not have added their event yet.
+  mozilla::Atomic<uint32_t> mLockFreePutEvents;
+  // Notified under mLock when mLockFreePutEvents drops to zero after
+  // mEventsAreDoomed has been set.
+  mozilla::CondVar mLockFreePutEventsDone;
+  // Whether mObserver is set, so PutEvent knows whether it needs mLock.
+  mozilla::Atomic<bool> mHasObserver;
   MainThreadFlag mIsMainThread;
 
   // Set to true if this thread creates a JSRuntime.
@@ -170,9 +170,10 @@ nsThreadManager::Shutdown()
     mThreadsByPRThread.Clear();
   }
 
-  // Normally thread shutdown clears the observer for the thread, but since the
-  // main thread is special we do it manually here after we're sure all events
-  // have been processed.
+  // Normally thread shutdown clears the observer and the idle events for the
+  // thread, but since the main thread is special we do it manually here after
+  // we're sure all events have been processed.
+  mMainThread->ClearIdleEvents();
   mMainThread->SetObserver(nullptr);
   mMainThread->ClearObservers();
 
@@ -141,6 +141,7 @@ nsTimerImpl::nsTimerImpl(nsITimer* aTimer) :
   mCallbackType(CallbackType::Unknown),
   mGeneration(0),
   mDelay(0),
+  mTimerThreadIndex(-1),
   mITimer(aTimer)
 {
   MOZ_COUNT_CTOR(nsTimerImpl);
@@ -160,6 +160,10 @@ public:
   uint32_t              mDelay;
   TimeStamp             mTimeout;
 
+  // The timer's position in TimerThread::mTimers, or -1 if it isn't there.
+  // Only accessed while holding the TimerThread's monitor.
+  int32_t               mTimerThreadIndex;
+
 #ifdef MOZ_TASK_TRACER
   mozilla::tasktracer::TracedTaskCommon mTracedTask;
 #endif
@@ -179,7 +183,6 @@ public:
 
   friend class TimerThread;
   friend class nsTimerEvent;
-  friend struct TimerAdditionComparator;
 
   NS_DECL_THREADSAFE_ISUPPORTS
   NS_FORWARD_SAFE_NSITIMER(mImpl);